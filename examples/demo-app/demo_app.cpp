@@ -18,7 +18,11 @@
 #include "polyscope/volume_grid.h"
 #include "polyscope/volume_mesh.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <random>
+#include <sstream>
 #include <unordered_set>
 #include <utility>
 
@@ -29,6 +33,7 @@
 #include "simple_dot_mesh_parser.h"
 #include "surface_mesh_io.h"
 
+#include "glm/gtc/constants.hpp"
 #include "glm/gtx/string_cast.hpp"
 
 #include "stb_image.h"
@@ -819,12 +824,179 @@ void callback() {
   ImGui::PopItemWidth();
 }
 
+// == Benchmark mode: generated scenes, a fixed camera orbit, and frame time statistics
+
+// Each structure type gets roughly `size` elements (points, faces, curve nodes, grid nodes, or tets). The random
+// generator is seeded, so every run renders the same scene.
+void generateBenchmarkScene(size_t size, const std::vector<std::string>& types) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+  for (const std::string& type : types) {
+    if (type == "points") {
+      std::vector<glm::vec3> points(size);
+      std::vector<float> values(size);
+      for (size_t i = 0; i < size; i++) {
+        points[i] = glm::vec3{unit(rng), unit(rng), unit(rng)} - 0.5f;
+        values[i] = points[i].x;
+      }
+      polyscope::PointCloud* psCloud = polyscope::registerPointCloud("benchmark points", points);
+      psCloud->addScalarQuantity("x", values)->setEnabled(true);
+
+    } else if (type == "mesh") {
+      // a torus of n x n quads, each split in two triangles
+      size_t n = std::max<size_t>(3, static_cast<size_t>(std::sqrt(size / 2.)));
+      std::vector<glm::vec3> vertices;
+      std::vector<float> values;
+      std::vector<std::array<size_t, 3>> faces;
+      for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+          float u = 2.f * glm::pi<float>() * i / n;
+          float v = 2.f * glm::pi<float>() * j / n;
+          vertices.push_back(glm::vec3{(1.f + 0.3f * std::cos(v)) * std::cos(u), 0.3f * std::sin(v),
+                                       (1.f + 0.3f * std::cos(v)) * std::sin(u)});
+          values.push_back(std::sin(5.f * u) * std::cos(3.f * v));
+          size_t a = i * n + j;
+          size_t b = ((i + 1) % n) * n + j;
+          size_t c = ((i + 1) % n) * n + (j + 1) % n;
+          size_t d = i * n + (j + 1) % n;
+          faces.push_back({{a, b, c}});
+          faces.push_back({{a, c, d}});
+        }
+      }
+      polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("benchmark mesh", vertices, faces);
+      psMesh->addVertexScalarQuantity("wave", values)->setEnabled(true);
+
+    } else if (type == "curves") {
+      // a random walk
+      std::vector<glm::vec3> nodes(size);
+      glm::vec3 p{0.f, 0.f, 0.f};
+      for (size_t i = 0; i < size; i++) {
+        p += 0.02f * (glm::vec3{unit(rng), unit(rng), unit(rng)} - 0.5f);
+        nodes[i] = p;
+      }
+      polyscope::registerCurveNetworkLine("benchmark curves", nodes);
+
+    } else if (type == "grid") {
+      uint32_t n = std::max<uint32_t>(2, static_cast<uint32_t>(std::cbrt(static_cast<double>(size))));
+      polyscope::VolumeGrid* psGrid =
+          polyscope::registerVolumeGrid("benchmark grid", {n, n, n}, glm::vec3{-1.f, -1.f, -1.f}, glm::vec3{1.f, 1.f, 1.f});
+      std::vector<float> values(static_cast<size_t>(n) * n * n);
+      for (size_t i = 0; i < values.size(); i++) {
+        values[i] = unit(rng);
+      }
+      psGrid->addNodeScalarQuantity("noise", values)->setEnabled(true);
+
+    } else if (type == "tets") {
+      // a lattice of cubes, each split in 6 tets
+      size_t n = std::max<size_t>(1, static_cast<size_t>(std::cbrt(size / 6.)));
+      auto ind = [&](size_t i, size_t j, size_t k) { return (i * (n + 1) + j) * (n + 1) + k; };
+      std::vector<glm::vec3> vertices;
+      for (size_t i = 0; i <= n; i++) {
+        for (size_t j = 0; j <= n; j++) {
+          for (size_t k = 0; k <= n; k++) {
+            vertices.push_back(glm::vec3(i, j, k) / static_cast<float>(n) - 0.5f);
+          }
+        }
+      }
+      std::vector<std::array<size_t, 4>> tets;
+      for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+          for (size_t k = 0; k < n; k++) {
+            size_t c[8] = {ind(i, j, k),         ind(i + 1, j, k),     ind(i + 1, j + 1, k),     ind(i, j + 1, k),
+                           ind(i, j, k + 1),     ind(i + 1, j, k + 1), ind(i + 1, j + 1, k + 1), ind(i, j + 1, k + 1)};
+            tets.push_back({{c[0], c[1], c[2], c[6]}});
+            tets.push_back({{c[0], c[2], c[3], c[6]}});
+            tets.push_back({{c[0], c[3], c[7], c[6]}});
+            tets.push_back({{c[0], c[7], c[4], c[6]}});
+            tets.push_back({{c[0], c[4], c[5], c[6]}});
+            tets.push_back({{c[0], c[5], c[1], c[6]}});
+          }
+        }
+      }
+      polyscope::registerTetMesh("benchmark tets", vertices, tets);
+
+    } else {
+      polyscope::exception("unrecognized benchmark structure type " + type +
+                           ", expected points, mesh, curves, grid or tets");
+    }
+  }
+}
+
+nlohmann::json frameTimeSummary(std::vector<double> times) {
+  if (times.empty()) return nullptr;
+  std::sort(times.begin(), times.end());
+  double sum = 0.;
+  for (double t : times) sum += t;
+  auto percentile = [&](double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p * times.size()));
+    return times[std::min(std::max<size_t>(rank, 1), times.size()) - 1];
+  };
+  return {{"mean", sum / times.size()}, {"p50", percentile(0.5)}, {"p99", percentile(0.99)}};
+}
+
+// Orbit the camera around the scene once over the measured frames, after some warm-up frames which absorb shader
+// compiles and uploads. Times come from the frame statistics, see polyscope/frame_stats.h.
+void runBenchmark(size_t nFrames, size_t nWarmupFrames) {
+  polyscope::options::enableVSync = false;
+  polyscope::options::maxFPS = -1;
+  polyscope::options::collectFrameStats = true;
+
+  glm::vec3 center = polyscope::state::center();
+  float radius = 2.f * polyscope::state::lengthScale;
+  auto setOrbitCamera = [&](size_t iFrame) {
+    float angle = 2.f * glm::pi<float>() * iFrame / std::max<size_t>(nFrames, 1);
+    glm::vec3 eye = center + radius * glm::vec3{std::cos(angle), 0.4f, std::sin(angle)};
+    polyscope::view::lookAt(eye, center);
+  };
+
+  for (size_t i = 0; i < nWarmupFrames; i++) {
+    setOrbitCamera(0);
+    polyscope::frameTick();
+  }
+
+  // GPU times arrive a few frames late, so keep ticking until all the measured frames have reported
+  uint64_t lastSeen = polyscope::getFrameStats().frameIndex;
+  std::vector<double> cpuMs, gpuMs;
+  double drawCalls = 0.;
+  for (size_t iTick = 0; cpuMs.size() < nFrames && iTick < nFrames + 16; iTick++) {
+    setOrbitCamera(iTick);
+    polyscope::frameTick();
+    polyscope::FrameStats stats = polyscope::getFrameStats();
+    if (stats.frameIndex == lastSeen) continue;
+    lastSeen = stats.frameIndex;
+    cpuMs.push_back(stats.cpuMs);
+    if (stats.gpuMs >= 0.) gpuMs.push_back(stats.gpuMs);
+    drawCalls += stats.drawCalls;
+  }
+
+  nlohmann::json result = {
+      {"frames", cpuMs.size()},
+      {"warmupFrames", nWarmupFrames},
+      {"cpuMs", frameTimeSummary(cpuMs)},
+      {"gpuMs", frameTimeSummary(gpuMs)}, // null without timer queries
+      {"meanDrawCalls", cpuMs.empty() ? 0. : drawCalls / cpuMs.size()},
+  };
+  std::cout << result.dump(2) << std::endl;
+}
+
 int main(int argc, char** argv) {
   // Configure the argument parser
   args::ArgumentParser parser("A simple demo of Polyscope.\nBy "
                               "Nick Sharp (nmwsharp@gmail.com)",
                               "");
   args::PositionalList<std::string> files(parser, "files", "One or more files to visualize");
+  args::Flag benchmark(parser, "benchmark",
+                       "Render a fixed camera orbit over a generated scene (and any files) and print frame times as JSON",
+                       {"benchmark"});
+  args::ValueFlag<size_t> benchmarkFrames(parser, "frames", "Number of measured benchmark frames", {"benchmark-frames"},
+                                          300);
+  args::ValueFlag<size_t> benchmarkSize(parser, "size", "Elements in each generated benchmark structure",
+                                        {"benchmark-size"}, 100000);
+  args::ValueFlag<std::string> benchmarkTypes(parser, "types",
+                                              "Comma-separated structure types to generate for the benchmark, from "
+                                              "points, mesh, curves, grid, tets",
+                                              {"benchmark-types"}, "points,mesh,curves,grid,tets");
 
   // Parse args
   try {
@@ -847,6 +1019,12 @@ int main(int argc, char** argv) {
   polyscope::options::verbosity = 100;
   polyscope::options::enableRenderErrorChecks = true;
 
+  if (benchmark) {
+    // keep the output to the JSON report
+    polyscope::options::verbosity = 0;
+    polyscope::options::enableRenderErrorChecks = false;
+  }
+
   // Initialize polyscope
   polyscope::init();
 
@@ -854,6 +1032,18 @@ int main(int argc, char** argv) {
     processFile(s);
   }
 
+  if (benchmark) {
+    std::vector<std::string> types;
+    std::stringstream typeStream(args::get(benchmarkTypes));
+    std::string type;
+    while (std::getline(typeStream, type, ',')) {
+      if (!type.empty()) types.push_back(type);
+    }
+    generateBenchmarkScene(args::get(benchmarkSize), types);
+    runBenchmark(args::get(benchmarkFrames), 30);
+    return 0;
+  }
+
   // Create a point cloud
   for (int j = 0; j < 1; j++) {
     std::vector<glm::vec3> points;
@@ -0,0 +1,25 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+namespace polyscope {
+
+// The quality governor behind options::adaptiveQuality.
+//
+// Camera interaction (dragging, zooming, keyboard navigation) is reported with markCameraInteraction(). While it lasts,
+// the governor watches the frame time and steps through reduced quality levels as needed to hold
+// options::adaptiveQualityTargetFrameMs. The first level drops SSAA and limits Pretty transparency to a single peel,
+// the following ones also render the scene at a fraction of the window resolution, which the lighting transform
+// upsamples. The display, GUI and pick buffer keep their full resolution throughout. Once the camera has been still for
+// options::adaptiveQualityRestoreDelay, full quality is restored and the scene is redrawn.
+//
+// The governor stays at full quality while a recording is in progress.
+
+void markCameraInteraction(); // called by the view whenever the user moves the camera
+void updateAdaptiveQuality(); // called by the main loop once per frame, before the scene is drawn
+
+bool adaptiveQualityIsReduced();
+int getAdaptiveQualityLevel();      // 0 when at full quality
+int adaptiveQualityRenderPasses();  // depth peeling passes to use for the scene this frame
+
+} // namespace polyscope
@@ -36,9 +36,26 @@ struct FIELD_MAG<glm::vec3> {
 };
 
 
+// Min and max of the finite entries of data, computed in parallel for large inputs. Returns (inf, -inf) if there are
+// no finite entries.
+template <typename T>
+std::pair<typename FIELD_MAG<T>::type, typename FIELD_MAG<T>::type> finiteMinMax(const T* data, size_t count);
+
+// Largest length of the finite vectors in data (glm::vec2 or glm::vec3), computed in parallel for large inputs. Only
+// squared lengths are compared, with one square root at the end. Returns 0 if there are no finite vectors.
+template <typename V>
+float finiteMaxLength(const V* data, size_t count);
+
+// Turn the output of finiteMinMax() in to a usable range, widening constant or near-constant data.
+template <typename S>
+std::pair<S, S> robustRange(std::pair<S, S> finiteRange, S rangeEPS = 1e-12);
+
 template <typename T>
 std::pair<typename FIELD_MAG<T>::type, typename FIELD_MAG<T>::type>
 robustMinMax(const std::vector<T>& data, typename FIELD_MAG<T>::type rangeEPS = 1e-12);
+template <typename T>
+std::pair<typename FIELD_MAG<T>::type, typename FIELD_MAG<T>::type>
+robustMinMax(const T* data, size_t count, typename FIELD_MAG<T>::type rangeEPS = 1e-12);
 
 
 // Map data in to the range [0,1]
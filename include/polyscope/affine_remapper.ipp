@@ -4,6 +4,10 @@
 
 #include "glm/glm.hpp"
 
+#include "polyscope/parallel.h"
+
+#include <limits>
+
 namespace polyscope {
 
 inline std::string defaultColorMap(DataType type) {
@@ -59,33 +63,68 @@ glm::vec3 FIELD_ZERO() {
 template <typename T>
 std::pair<typename FIELD_MAG<T>::type, typename FIELD_MAG<T>::type> robustMinMax(const std::vector<T>& data,
                                                                                  typename FIELD_MAG<T>::type rangeEPS) {
+  return robustMinMax(data.data(), data.size(), rangeEPS);
+}
 
-  if (data.size() == 0) {
-    return std::make_pair(-1.0, 1.0);
-  }
+template <typename T>
+std::pair<typename FIELD_MAG<T>::type, typename FIELD_MAG<T>::type> finiteMinMax(const T* data, size_t count) {
+  typedef typename FIELD_MAG<T>::type S;
+  const S inf = std::numeric_limits<S>::infinity();
+  const S maxFinite = std::numeric_limits<S>::max();
+
+  auto chunkMinMax = [&](size_t begin, size_t end) {
+    S minVal = inf;
+    S maxVal = -inf;
+    // keep the loop body branch-free so the compiler can vectorize it; NaN fails the comparison, so it is skipped
+    // along with +-inf
+    for (size_t i = begin; i < end; i++) {
+      S x = FIELD_BIGNESS(data[i]);
+      bool isFinite = std::abs(x) <= maxFinite;
+      minVal = (isFinite && x < minVal) ? x : minVal;
+      maxVal = (isFinite && x > maxVal) ? x : maxVal;
+    }
+    return std::make_pair(minVal, maxVal);
+  };
+  auto combine = [](std::pair<S, S> a, std::pair<S, S> b) {
+    return std::make_pair(std::min(a.first, b.first), std::max(a.second, b.second));
+  };
+  return parallelReduce(0, count, std::make_pair(inf, -inf), chunkMinMax, combine, 1 << 16);
+}
 
-  // Compute max and min of data for mapping
-  typename FIELD_MAG<T>::type minVal = std::numeric_limits<typename FIELD_MAG<T>::type>::infinity();
-  typename FIELD_MAG<T>::type maxVal = -std::numeric_limits<typename FIELD_MAG<T>::type>::infinity();
-  bool anyFinite = false;
-  for (const T& x : data) {
-    if (std::isfinite(FIELD_BIGNESS(x))) {
-      minVal = std::min(minVal, FIELD_BIGNESS(x));
-      maxVal = std::max(maxVal, FIELD_BIGNESS(x));
-      anyFinite = true;
+template <typename V>
+float finiteMaxLength(const V* data, size_t count) {
+  const float maxFinite = std::numeric_limits<float>::max();
+
+  auto chunkMaxLength2 = [&](size_t begin, size_t end) {
+    float maxLength2 = 0.f;
+    // branch-free as in finiteMinMax(), NaN and inf fail the comparison and are skipped
+    for (size_t i = begin; i < end; i++) {
+      float length2 = glm::dot(data[i], data[i]);
+      maxLength2 = (length2 <= maxFinite && length2 > maxLength2) ? length2 : maxLength2;
     }
-  }
-  if (!anyFinite) {
+    return maxLength2;
+  };
+  auto combine = [](float a, float b) { return std::max(a, b); };
+  float maxLength2 = parallelReduce(0, count, 0.f, chunkMaxLength2, combine, 1 << 16);
+  return std::sqrt(maxLength2);
+}
+
+template <typename S>
+std::pair<S, S> robustRange(std::pair<S, S> finiteRange, S rangeEPS) {
+
+  S minVal = finiteRange.first;
+  S maxVal = finiteRange.second;
+  if (!(minVal <= maxVal)) { // no finite values
     return std::make_pair(-1.0, 1.0);
   }
-  typename FIELD_MAG<T>::type maxMag = std::max(std::abs(minVal), std::abs(maxVal));
+  S maxMag = std::max(std::abs(minVal), std::abs(maxVal));
 
   // Hack to do less ugly things when constants (or near-constant) are passed in
   if (maxMag < rangeEPS) {
     maxVal = rangeEPS;
     minVal = -rangeEPS;
   } else if ((maxVal - minVal) / maxMag < rangeEPS) {
-    typename FIELD_MAG<T>::type mid = (minVal + maxVal) / 2.0;
+    S mid = (minVal + maxVal) / 2.0;
     maxVal = mid + maxMag * rangeEPS;
     minVal = mid - maxMag * rangeEPS;
   }
@@ -93,6 +132,12 @@ std::pair<typename FIELD_MAG<T>::type, typename FIELD_MAG<T>::type> robustMinMax
   return std::make_pair(minVal, maxVal);
 }
 
+template <typename T>
+std::pair<typename FIELD_MAG<T>::type, typename FIELD_MAG<T>::type>
+robustMinMax(const T* data, size_t count, typename FIELD_MAG<T>::type rangeEPS) {
+  return robustRange(finiteMinMax(data, count), rangeEPS);
+}
+
 template <typename T>
 AffineRemapper<T>::AffineRemapper(T offset_, typename FIELD_MAG<T>::type scale_)
     : offset(offset_), scale(scale){
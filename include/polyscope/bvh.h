@@ -0,0 +1,76 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace polyscope {
+
+// A bounding volume hierarchy over generic primitives, which are only described by their axis-aligned bounding boxes.
+// Used to ray cast against structures on the CPU, see Structure::rayCastPick().
+//
+// The hierarchy is built top-down with the binned surface area heuristic. The upper levels are split on the calling
+// thread, and the subtrees below them are then built in parallel.
+class BVH {
+public:
+  struct Box {
+    glm::vec3 min;
+    glm::vec3 max;
+  };
+
+  // (Re)build the hierarchy over primitives with the given bounding boxes
+  void build(const std::vector<Box>& primBoxes);
+
+  // Update the boxes of the hierarchy after the primitives moved, keeping its topology. The number of primitives must
+  // be the same as in the last build(). Much cheaper than a rebuild, but queries get slower if the primitives moved
+  // far relative to each other.
+  void refit(const std::vector<Box>& primBoxes);
+
+  void clear();
+  bool isBuilt() const;
+  size_t nPrimitives() const;
+  size_t getMemoryBytes() const; // held by the nodes and primitive order
+
+  // Visit the primitives whose boxes are hit by the ray start + t * dir for t in [0, tMax], nearer boxes first.
+  // intersectPrim(iPrim, tMax) should test the primitive itself, and if it is hit closer than tMax lower tMax to the hit
+  // and return true, such that farther boxes get skipped. Returns true if any primitive was hit.
+  // All boxes are grown by boxPadding, e.g. the radius of points which the hierarchy was built over.
+  bool rayCast(glm::vec3 start, glm::vec3 dir, float& tMax,
+               const std::function<bool(size_t iPrim, float& tMax)>& intersectPrim, float boxPadding = 0.) const;
+
+private:
+  struct Node {
+    Box box;
+    uint32_t first; // interior nodes: index of the left child, the right child follows it. leaves: into primOrder
+    uint32_t count; // number of primitives for leaves, 0 for interior nodes
+  };
+
+  // Children are always stored after their parent, so iterating backwards visits children before parents
+  std::vector<Node> nodes;
+  std::vector<uint32_t> primOrder;
+
+  // Split the primitives in [start, end) of primOrder, appending the subtree to `out` with its root at `rootInd`.
+  // Ranges with more than `deferSize` primitives are not split below the root but recorded in `deferred`, so they can
+  // be built separately.
+  struct DeferredRange {
+    uint32_t nodeInd;
+    uint32_t start;
+    uint32_t end;
+  };
+  void buildRange(const std::vector<Box>& primBoxes, const std::vector<glm::vec3>& centroids,
+                  std::vector<Node>& out, uint32_t rootInd, uint32_t start, uint32_t end, size_t deferSize,
+                  std::vector<DeferredRange>& deferred);
+};
+
+// Ray intersection helpers, for rays start + t * dir. Each returns true and sets t if the ray hits (with t >= 0).
+bool rayTriangleIntersection(glm::vec3 start, glm::vec3 dir, glm::vec3 pA, glm::vec3 pB, glm::vec3 pC, float& t,
+                             glm::vec3& barycoords);
+bool raySphereIntersection(glm::vec3 start, glm::vec3 dir, glm::vec3 center, float radius, float& t);
+bool rayCylinderIntersection(glm::vec3 start, glm::vec3 dir, glm::vec3 pA, glm::vec3 pB, float radius, float& t);
+
+} // namespace polyscope
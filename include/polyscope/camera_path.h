@@ -0,0 +1,51 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/camera_parameters.h"
+
+#include "glm/gtc/quaternion.hpp"
+
+#include <string>
+#include <vector>
+
+namespace polyscope {
+
+// A camera path through a sequence of keyframes, e.g. for benchmark flythroughs or offline renders of an animation.
+// Positions and the field of view follow a Catmull-Rom spline through the keyframes, orientations a spherical spline
+// (squad). Unlike view::startFlightTo(), which animates in wall-clock time, a path is evaluated at explicit times, so a
+// frame index at a fixed frame rate gives the same view on every run, however long each frame takes.
+class CameraPath {
+public:
+  // Keyframes must be added in order of strictly increasing time, in seconds from the start of the path
+  void addKeyframe(float time, const CameraParameters& camera);
+  void clear();
+
+  size_t getKeyframeCount() const;
+  float getDuration() const; // from the first to the last keyframe
+
+  // The camera at a time along the path, which is clamped to the keyframes
+  CameraParameters evaluate(float time) const;
+
+  // Frames are framesPerSecond apart, starting at the first keyframe and ending at the last
+  size_t getFrameCount(float framesPerSecond) const;
+  CameraParameters evaluateFrame(size_t frameIndex, float framesPerSecond) const;
+
+private:
+  struct Keyframe {
+    float time;
+    glm::vec3 position;
+    glm::quat rotation; // of the world to eye transform
+    float fovVerticalDegrees;
+    float aspectRatioWidthOverHeight;
+  };
+  std::vector<Keyframe> keyframes;
+};
+
+// Render each frame of a path to an image file, named with the prefix, the frame index padded to 6 digits, and the
+// extension (e.g. "frame_000042.png"). The frames go through renderBatch(), so they are rendered back to back without
+// the GUI, and reading back and encoding the images overlaps with rendering the next ones.
+void renderCameraPath(const CameraPath& path, float framesPerSecond, std::string filenamePrefix = "frame_",
+                      std::string extension = ".png", bool transparentBG = true);
+
+} // namespace polyscope
@@ -44,6 +44,7 @@ public:
   virtual void drawDelayed() override;
   virtual void drawPick() override;
   virtual void updateObjectSpaceBounds() override;
+  virtual bool allowFrustumCulling() override; // the bounds are just the camera position, not the drawn frame
   virtual std::string typeName() override;
   virtual void refresh() override;
 
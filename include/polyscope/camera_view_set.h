@@ -0,0 +1,141 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/camera_parameters.h"
+#include "polyscope/persistent_value.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/render/managed_buffer.h"
+#include "polyscope/scaled_value.h"
+#include "polyscope/structure.h"
+
+#include <vector>
+
+namespace polyscope {
+
+// Forward declare structure
+class CameraViewSet;
+
+// Many cameras drawn as one structure, e.g. the thousands of poses of a photogrammetry reconstruction. Each camera is
+// drawn as the same wireframe as a CameraView, but the frusta of all cameras go through a single instanced draw (one
+// instance per wireframe edge, see RAYCAST_CYLINDER_INSTANCED) and a single draw of their nodes, rather than two
+// programs and draw calls per camera. Each camera can still be picked, and the view can be set to look through it.
+class CameraViewSet : public QuantityStructure<CameraViewSet> {
+public:
+  // === Member functions ===
+
+  // Construct a new camera set structure
+  CameraViewSet(std::string name, const std::vector<CameraParameters>& params);
+
+  // === Overrides
+
+  // Build the imgui display
+  virtual void buildCustomUI() override;
+  virtual void buildCustomOptionsUI() override;
+  virtual void buildPickUI(size_t localPickID) override;
+
+  // Standard structure overrides
+  virtual void draw() override;
+  virtual void drawDelayed() override;
+  virtual void drawPick() override;
+  virtual void updateObjectSpaceBounds() override;
+  virtual bool allowFrustumCulling() override; // the bounds are just the camera positions, not the drawn frames
+  virtual std::string typeName() override;
+  virtual void refresh() override;
+
+  // === Geometry members
+  // The wireframes of all cameras, derived from the camera parameters and the widget focal length. Each camera has
+  // nodesPerCamera consecutive nodes and edgesPerCamera consecutive edges.
+  render::ManagedBuffer<glm::vec3> nodePositions;
+  render::ManagedBuffer<glm::vec3> edgeTailPositions;
+  render::ManagedBuffer<glm::vec3> edgeTipPositions;
+
+  static const size_t nodesPerCamera = 8;
+  static const size_t edgesPerCamera = 11;
+
+  size_t nCameras() const;
+
+  // === Mutate
+
+  // Replace the cameras, the number of cameras may change
+  void updateCameraParameters(const std::vector<CameraParameters>& newParams);
+
+  CameraParameters getCameraParameters(size_t iCamera) const;
+
+  // Misc data
+  static const std::string structureTypeName;
+
+  // Update the current viewer to look through one of the cameras
+  void setViewToCamera(size_t iCamera, bool withFlight = false);
+
+  // === Get/set visualization parameters
+
+  // Set focal length of the camera widgets. This only effects how the cameras are rendered in the 3D view, it has
+  // nothing to do with the actual data stored or camera transforms.
+  CameraViewSet* setWidgetFocalLength(float newVal, bool isRelative = true);
+  float getWidgetFocalLength();
+
+  // Set the thickness of the wireframe used to draw the cameras (in relative units)
+  CameraViewSet* setWidgetThickness(float newVal);
+  float getWidgetThickness();
+
+  // Color of the widgets
+  CameraViewSet* setWidgetColor(glm::vec3 val);
+  glm::vec3 getWidgetColor();
+
+private:
+  // The actual camera data being visualized
+  std::vector<CameraParameters> params;
+
+  // Storage for the managed buffers above. You should generally interact with this directly through them.
+  std::vector<glm::vec3> nodePositionsData;
+  std::vector<glm::vec3> edgeTailPositionsData;
+  std::vector<glm::vec3> edgeTipPositionsData;
+
+  // === Visualization parameters
+  PersistentValue<ScaledValue<float>> widgetFocalLength;
+  PersistentValue<float> widgetThickness;
+  PersistentValue<glm::vec3> widgetColor;
+
+  // Drawing related things
+  // if nullptr, prepare() (resp. preparePick()) needs to be called
+  std::shared_ptr<render::ShaderProgram> nodeProgram, edgeProgram;
+  std::shared_ptr<render::ShaderProgram> nodePickProgram, edgePickProgram;
+
+  // === Helpers
+  // Do setup work related to drawing, including allocating openGL data
+  void prepare();
+  void preparePick();
+  void geometryChanged();
+  void computeWidgetGeometry(); // fill the geometry buffers from the camera parameters
+  void setWidgetUniforms(render::ShaderProgram& nodeP, render::ShaderProgram& edgeP);
+  std::vector<std::string> addCameraViewSetNodeRules(std::vector<std::string> initRules);
+  std::vector<std::string> addCameraViewSetEdgeRules(std::vector<std::string> initRules);
+  void fillNodeGeometryBuffers(render::ShaderProgram& p);
+  void fillEdgeGeometryBuffers(render::ShaderProgram& p);
+
+  float widgetFocalLengthUpper = -777;
+  const std::string material = "flat";
+
+  // track the length scale which was used to generate the camera geometry, in case it needs to be regenerated
+  float preparedLengthScale = -1.;
+
+  // == Picking related things
+  // Each camera gets one pick index, camera i is at pickStart + i
+  size_t pickStart = INVALID_IND;
+};
+
+
+// Shorthand to add a camera set to Polyscope
+CameraViewSet* registerCameraViewSet(std::string name, const std::vector<CameraParameters>& params);
+
+// Shorthand to get a camera set from polyscope
+inline CameraViewSet* getCameraViewSet(std::string name = "");
+inline bool hasCameraViewSet(std::string name = "");
+inline void removeCameraViewSet(std::string name = "", bool errorIfAbsent = false);
+
+
+} // namespace polyscope
+
+#include "polyscope/camera_view_set.ipp"
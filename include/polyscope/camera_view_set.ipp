@@ -0,0 +1,25 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+
+namespace polyscope {
+
+inline CameraViewSet* registerCameraViewSet(std::string name, const std::vector<CameraParameters>& params) {
+  CameraViewSet* s = new CameraViewSet(name, params);
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+// Shorthand to get a camera set from polyscope
+inline CameraViewSet* getCameraViewSet(std::string name) {
+  return dynamic_cast<CameraViewSet*>(getStructure(CameraViewSet::structureTypeName, name));
+}
+inline bool hasCameraViewSet(std::string name) { return hasStructure(CameraViewSet::structureTypeName, name); }
+inline void removeCameraViewSet(std::string name, bool errorIfAbsent) {
+  removeStructure(CameraViewSet::structureTypeName, name, errorIfAbsent);
+}
+
+
+} // namespace polyscope
@@ -25,6 +25,15 @@ public:
 
   render::ManagedBuffer<glm::vec4> colors;
 
+  // Upload new pixels straight to the image texture, e.g. the frames of a live camera feed. `pixels` holds tightly
+  // packed rows in the same order as the image data, with nChannels (3 for RGB, 4 for RGBA) components of the given
+  // type per pixel. 8- and 16-bit components are read as [0,1] values. The uploads are staged so they do not stall
+  // rendering, and the float copy in `colors` is only read back from the device if it is needed.
+  void updatePixels(const void* pixels, int nChannels, PixelComponentType componentType);
+  // Same, for the w x h rectangle of pixels starting at (x, y)
+  void updatePixelsRect(const void* pixels, int nChannels, PixelComponentType componentType, size_t x, size_t y,
+                        size_t w, size_t h);
+
   // == Setters and getters
 
   ColorImageQuantity* setEnabled(bool newEnabled) override;
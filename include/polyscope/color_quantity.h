@@ -15,7 +15,7 @@ namespace polyscope {
 template <typename QuantityT>
 class ColorQuantity {
 public:
-  ColorQuantity(QuantityT& parent, const std::vector<glm::vec3>& colors);
+  ColorQuantity(QuantityT& parent, std::vector<glm::vec3> colors);
 
   // Build the ImGUI UIs for scalars
   void buildColorUI();
@@ -26,8 +26,10 @@ public:
   // Set uniforms in rendering programs for scalars
   void setColorUniforms(render::ShaderProgram& p);
 
+  // Replace the colors, reusing the render buffers and programs
   template <class V>
   void updateData(const V& newColors);
+  void updateData(const glm::vec3* newColors, size_t count); // copied straight into the existing host buffer
 
   // === Members
   QuantityT& quantity;
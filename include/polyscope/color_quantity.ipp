@@ -3,8 +3,9 @@
 namespace polyscope {
 
 template <typename QuantityT>
-ColorQuantity<QuantityT>::ColorQuantity(QuantityT& quantity_, const std::vector<glm::vec3>& colors_)
-    : quantity(quantity_), colors(&quantity, quantity.uniquePrefix() + "colors", colorsData), colorsData(colors_) {}
+ColorQuantity<QuantityT>::ColorQuantity(QuantityT& quantity_, std::vector<glm::vec3> colors_)
+    : quantity(quantity_), colors(&quantity, quantity.uniquePrefix() + "colors", colorsData),
+      colorsData(std::move(colors_)) {}
 
 template <typename QuantityT>
 void ColorQuantity<QuantityT>::buildColorUI() {}
@@ -26,5 +27,16 @@ void ColorQuantity<QuantityT>::updateData(const V& newColors) {
   colors.markHostBufferUpdated();
 }
 
+template <typename QuantityT>
+void ColorQuantity<QuantityT>::updateData(const glm::vec3* newColors, size_t count) {
+  if (count != colors.size()) {
+    exception("color quantity " + quantity.name + " updated with " + std::to_string(count) + " colors, but has " +
+              std::to_string(colors.size()));
+  }
+  colors.ensureHostBufferAllocated();
+  std::copy(newColors, newColors + count, colors.data.begin());
+  colors.markHostBufferUpdated();
+}
+
 
 } // namespace polyscope
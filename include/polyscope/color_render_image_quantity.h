@@ -23,6 +23,7 @@ public:
   virtual void buildCustomUI() override;
 
   virtual void refresh() override;
+  virtual bool getCompositeLayer(RenderImageCompositeLayer& layer) override;
 
   virtual std::string niceName() override;
 
@@ -31,6 +32,12 @@ public:
   template <typename T1, typename T2, typename T3>
   void updateBuffers(const T1& depthData, const T2& normalData, const T3& colorsData);
 
+  // Device-side colors, as for the depths and normals in RenderImageQuantityBase. Colors have 3 or 4 channels, and the
+  // buffer holds dimX * dimY 3-float colors.
+  void setExternalColorTexture(uint32_t glTextureName, TextureFormat format = TextureFormat::RGBA32F);
+  void updateColorsFromDeviceBuffer(uint32_t glBufferName);
+  virtual void markDeviceDataUpdated() override;
+
   // == Setters and getters
 
 
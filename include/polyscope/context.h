@@ -15,6 +15,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -54,6 +55,21 @@ struct Context {
   bool initialized = false;
   std::string backend = "";
   std::map<std::string, std::map<std::string, std::unique_ptr<Structure>>> structures;
+  // Flat registry of the structures above, which own them. Slots are indexed by StructureHandle, generations start at 1
+  // such that no valid handle is 0. The draw list holds the enabled structures in the order of `structures`, and is
+  // only rebuilt after one is registered, removed, enabled or disabled.
+  std::vector<Structure*> structureSlots; // nullptr if free
+  std::vector<uint32_t> structureSlotGenerations;
+  std::vector<uint32_t> freeStructureSlots;
+  std::unordered_multimap<std::string, Structure*> structuresByName;
+  std::vector<Structure*> structureDrawList;
+  bool structureDrawListValid = false;
+  // Nesting depth of beginStructureBatch(), and whether the extents need to be recomputed when the batch ends
+  int structureBatchDepth = 0;
+  bool structureExtentsStale = false;
+  // Groups cache their enabled state, which is valid as long as this generation does not change. Declared before the
+  // groups, which bump it on destruction.
+  uint64_t groupEnabledGeneration = 1;
   std::map<std::string, std::unique_ptr<Group>> groups;
   float lengthScale = 1.;
   std::tuple<glm::vec3, glm::vec3> boundingBox =
@@ -90,6 +106,7 @@ struct Context {
   glm::mat4x4 viewMat;
   double fov = view::defaultFov;
   ProjectionMode projectionMode = ProjectionMode::Perspective;
+  glm::vec2 projectionJitter{0., 0.};
   bool midflight = false;
   float flightStartTime = -1;
   float flightEndTime = -1;
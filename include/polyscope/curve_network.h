@@ -43,6 +43,9 @@ public:
   // Construct a new curve network structure
   CurveNetwork(std::string name, std::vector<glm::vec3> nodes, std::vector<std::array<size_t, 2>> edges);
 
+  // Construct from polylines of consecutive nodes, see registerCurveNetworkPolylines()
+  CurveNetwork(std::string name, std::vector<glm::vec3> nodes, std::vector<uint32_t> polylineOffsets);
+
   // === Overloads
 
   // Build the imgui display
@@ -51,13 +54,18 @@ public:
   virtual void buildPickUI(size_t localPickID) override;
 
   virtual void draw() override;
+  virtual void prepareDraw() override;
   virtual void drawDelayed() override;
   virtual void drawPick() override;
 
   virtual void updateObjectSpaceBounds() override;
+  virtual float getDrawBoundsPadding() override;
   virtual std::string typeName() override;
 
   virtual void refresh() override;
+  virtual void refreshShaderPrograms() override;
+  virtual bool supportsRayCastPicking() override;
+  virtual bool rayCastPick(glm::dvec3 rayStart, glm::vec3 rayDir, float& tHit, size_t& localPickInd) override;
 
   // === Geometry members
 
@@ -70,6 +78,12 @@ public:
 
   // internally-computed geometry
   render::ManagedBuffer<glm::vec3> edgeCenters;
+  render::ManagedBuffer<float> keyframeInds; // the index of each node, for reading keyframe textures
+
+  // With polyline storage the cylinder programs draw line strips over the nodes, rather than one point per edge
+  render::ManagedBuffer<uint32_t> stripInds;         // the nodes of each polyline, separated by restart indices
+  render::ManagedBuffer<uint32_t> stripNextNodeInds; // N, the next node along its polyline (or itself, for the last)
+  render::ManagedBuffer<uint32_t> stripNodeEdgeInds; // N, the edge leaving each node (or entering it, for the last)
 
   // === Quantities
 
@@ -109,6 +123,12 @@ public:
   size_t nNodes() { return nodePositions.size(); }
   size_t nEdges() { return edgeTailInds.size(); }
 
+  // Polyline i holds the nodes polylineOffsets[i] through polylineOffsets[i+1]-1. Empty unless the network was
+  // registered with registerCurveNetworkPolylines().
+  std::vector<uint32_t> polylineOffsets;
+  bool hasPolylineStorage() { return !polylineOffsets.empty(); }
+  size_t nPolylines() { return hasPolylineStorage() ? polylineOffsets.size() - 1 : 0; }
+
 
   // Misc data
   static const std::string structureTypeName;
@@ -120,13 +140,42 @@ public:
   void fillNodeGeometryBuffers(render::ShaderProgram& program);
   std::vector<std::string> addCurveNetworkNodeRules(std::vector<std::string> initRules);
   std::vector<std::string> addCurveNetworkEdgeRules(std::vector<std::string> initRules);
+  std::string getNodeShaderName(); // for the current render mode
+  std::string getEdgeShaderName();
+
+  // Attribute buffers for the edge programs, from per-node or per-edge data. The cylinder programs of polyline storage
+  // run over the nodes rather than the edges, these give the layout that the current edge program expects.
+  bool usesStripRendering();
+  template <class T>
+  std::shared_ptr<render::AttributeBuffer> getEdgeTailAttributeBuffer(render::ManagedBuffer<T>& nodeData);
+  template <class T>
+  std::shared_ptr<render::AttributeBuffer> getEdgeTipAttributeBuffer(render::ManagedBuffer<T>& nodeData);
+  template <class T>
+  std::shared_ptr<render::AttributeBuffer> getEdgeAttributeBuffer(render::ManagedBuffer<T>& edgeData);
 
   // === Mutate
   template <class V>
   void updateNodePositions(const V& newPositions);
+
+  // Like updateNodePositions(), but may be called from any thread. The positions are converted on the calling thread
+  // and swapped in by the render thread at the next sync point, see stageUpdate().
+  template <class V>
+  void stageNodePositions(const V& newPositions);
   template <class V>
   void updateNodePositions2D(const V& newPositions);
 
+  // Positions of every node in each entry of `frames`, for playing back a time-varying network. All frames are uploaded
+  // once and blended on the GPU, see Structure::setKeyframeTime(). The host positions in `nodePositions` are unchanged.
+  template <class V>
+  void setNodePositionKeyframes(const std::vector<V>& frames);
+
+  // Replace the nodes and edges, which may have any counts, e.g. for a simulation whose strands grow and split. The
+  // network keeps its buffers, shaders and pick indices, reallocating only when it outgrows them. Quantities keep
+  // their old sizes: re-add (which replaces them) or remove any that are drawn, before the network is next drawn. Not
+  // allowed for polyline networks or with position keyframes.
+  template <class P, class E>
+  void replaceNodesAndEdges(const P& newNodes, const E& newEdges);
+
   // === Get/set visualization parameters
 
   // set the base color of the points
@@ -150,6 +199,16 @@ public:
   CurveNetwork* setMaterial(std::string name);
   std::string getMaterial();
 
+  // Draw edges as raycast cylinders from a geometry shader (the default), or as instanced boxes expanded in the vertex
+  // shader, which is much faster for networks with many edges. In the instanced mode nodes are drawn as point sprites.
+  CurveNetwork* setRenderMode(CurveNetworkRenderMode newVal);
+  CurveNetworkRenderMode getRenderMode();
+
+  // In the instanced render mode, edges whose projected radius is less than this many pixels are drawn as lines one
+  // pixel wide, rather than as cylinders too thin to hit pixel centers. 0 disables this. Default: 0.5.
+  CurveNetwork* setLineLODPixelRadius(float pixels);
+  float getLineLODPixelRadius();
+
 
 private:
   // Storage for the managed buffers above. You should generally interact with these through the managed buffers, not
@@ -158,13 +217,20 @@ private:
   std::vector<uint32_t> edgeTailIndsData;
   std::vector<uint32_t> edgeTipIndsData;
   std::vector<glm::vec3> edgeCentersData;
+  std::vector<float> keyframeIndsData;
+  std::vector<uint32_t> stripIndsData;
+  std::vector<uint32_t> stripNextNodeIndsData;
+  std::vector<uint32_t> stripNodeEdgeIndsData;
 
   void computeEdgeCenters();
+  void computeKeyframeInds();
 
   // === Visualization parameters
   PersistentValue<glm::vec3> color;
   PersistentValue<ScaledValue<float>> radius;
   PersistentValue<std::string> material;
+  PersistentValue<std::string> renderMode;
+  PersistentValue<float> lineLODPixelRadius;
 
   // Drawing related things
   // if nullptr, prepare() (resp. preparePick()) needs to be called
@@ -172,12 +238,19 @@ private:
   std::shared_ptr<render::ShaderProgram> nodeProgram;
   std::shared_ptr<render::ShaderProgram> edgePickProgram;
   std::shared_ptr<render::ShaderProgram> nodePickProgram;
+  bool pickColorsNeedUpdate = false; // the pick programs exist, but the element counts have changed
+  size_t pickRangeStart = 0;         // our range of pick indices, may be larger than the network
+  size_t pickRangeCapacity = 0;
 
   // === Helpers
 
   // Do setup work related to drawing, including allocating openGL data
   void prepare();
+  void setCurveNetworkProgramUniforms(); // all uniforms of `edgeProgram` and `nodeProgram`
   void preparePick();
+  void fillPickColors(); // (re)request pick indices if needed, and fill the pick programs' colors
+  void setEdgeIndsData(const std::vector<std::array<size_t, 2>>& edges, size_t nNodesNew); // validates, sets degrees
+  void replaceNodesAndEdgesImpl(const std::vector<glm::vec3>& nodes, const std::vector<std::array<size_t, 2>>& edges);
 
   void recomputeGeometryIfPopulated();
   float computeRadiusMultiplierUniform();
@@ -223,6 +296,14 @@ CurveNetwork* registerCurveNetworkSegments(std::string name, const P& points);
 template <class P>
 CurveNetwork* registerCurveNetworkSegments2D(std::string name, const P& points);
 
+// Shorthand to add a curve network made of polylines, such as streamlines. The nodes of each polyline are consecutive:
+// polyline i holds the nodes polylineOffsets[i] through polylineOffsets[i+1]-1, so polylineOffsets begins with 0 and
+// ends with the number of nodes. Each polyline needs at least two nodes. The edges are implicit, and the cylinders are
+// drawn as line strips over the nodes, rather than duplicating the position of each interior node for both its edges.
+template <class P>
+CurveNetwork* registerCurveNetworkPolylines(std::string name, const P& nodes,
+                                            const std::vector<uint32_t>& polylineOffsets);
+
 // Shorthand to add a curve network, automatically constructing the connectivity of a loop
 template <class P>
 CurveNetwork* registerCurveNetworkLoop(std::string name, const P& points);
@@ -126,6 +126,19 @@ CurveNetwork* registerCurveNetworkSegments2D(std::string name, const P& nodes) {
   return s;
 }
 
+template <class P>
+CurveNetwork* registerCurveNetworkPolylines(std::string name, const P& nodes,
+                                            const std::vector<uint32_t>& polylineOffsets) {
+  checkInitialized();
+
+  CurveNetwork* s = new CurveNetwork(name, standardizeVectorArray<glm::vec3, 3>(nodes), polylineOffsets);
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
 // Shorthand to add curve from a loop of points
 template <class P>
 CurveNetwork* registerCurveNetworkLoop(std::string name, const P& nodes) {
@@ -167,14 +180,70 @@ CurveNetwork* registerCurveNetworkLoop2D(std::string name, const P& nodes) {
 }
 
 
+template <class T>
+std::shared_ptr<render::AttributeBuffer> CurveNetwork::getEdgeTailAttributeBuffer(render::ManagedBuffer<T>& nodeData) {
+  if (usesStripRendering()) {
+    return nodeData.getRenderAttributeBuffer();
+  }
+  return nodeData.getIndexedRenderAttributeBuffer(edgeTailInds);
+}
+
+template <class T>
+std::shared_ptr<render::AttributeBuffer> CurveNetwork::getEdgeTipAttributeBuffer(render::ManagedBuffer<T>& nodeData) {
+  if (usesStripRendering()) {
+    return nodeData.getIndexedRenderAttributeBuffer(stripNextNodeInds);
+  }
+  return nodeData.getIndexedRenderAttributeBuffer(edgeTipInds);
+}
+
+template <class T>
+std::shared_ptr<render::AttributeBuffer> CurveNetwork::getEdgeAttributeBuffer(render::ManagedBuffer<T>& edgeData) {
+  if (usesStripRendering()) {
+    return edgeData.getIndexedRenderAttributeBuffer(stripNodeEdgeInds);
+  }
+  return edgeData.getRenderAttributeBuffer();
+}
+
 template <class V>
 void CurveNetwork::updateNodePositions(const V& newPositions) {
   validateSize(newPositions, nNodes(), "newPositions");
   nodePositions.data = standardizeVectorArray<glm::vec3, 3>(newPositions);
   nodePositions.markHostBufferUpdated();
   recomputeGeometryIfPopulated();
+  pickBVHNeedsRefit = true;
+  refitObjectSpaceBounds(nodePositions.data);
+}
+
+
+template <class V>
+void CurveNetwork::stageNodePositions(const V& newPositions) {
+  std::vector<glm::vec3> staged = acquireStagingBuffer<glm::vec3>();
+  adaptorF_convertArrayOfVectorToStdVector<glm::vec3, 3, V>(newPositions, staged);
+  stageUpdate<glm::vec3>(uniquePrefix() + "nodePositions", getWeakHandle<CurveNetwork>(this), std::move(staged),
+                         [this](std::vector<glm::vec3>& data) {
+                           validateSize(data, nNodes(), "staged node positions");
+                           nodePositions.data.swap(data);
+                           nodePositions.markHostBufferUpdated();
+                           recomputeGeometryIfPopulated();
+                           pickBVHNeedsRefit = true;
+                           refitObjectSpaceBounds(nodePositions.data);
+                         });
+}
+
+template <class V>
+void CurveNetwork::setNodePositionKeyframes(const std::vector<V>& frames) {
+  std::vector<std::vector<glm::vec3>> frames3D;
+  for (const V& frame : frames) {
+    frames3D.push_back(standardizeVectorArray<glm::vec3, 3>(frame));
+  }
+  setPositionKeyframeData(frames3D, nNodes());
 }
 
+template <class P, class E>
+void CurveNetwork::replaceNodesAndEdges(const P& newNodes, const E& newEdges) {
+  replaceNodesAndEdgesImpl(standardizeVectorArray<glm::vec3, 3>(newNodes),
+                           standardizeVectorArray<std::array<size_t, 2>, 2>(newEdges));
+}
 
 template <class V>
 void CurveNetwork::updateNodePositions2D(const V& newPositions2D) {
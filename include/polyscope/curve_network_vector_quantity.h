@@ -17,6 +17,9 @@ class CurveNetworkVectorQuantity : public CurveNetworkQuantity {
 public:
   CurveNetworkVectorQuantity(std::string name, CurveNetwork& network_);
 
+  // vectors may extend arbitrarily far beyond the mesh
+  virtual bool drawsWithinStructureBounds() override;
+
   // === Option accessors
 
 protected:
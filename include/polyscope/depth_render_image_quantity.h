@@ -20,6 +20,7 @@ public:
   virtual void buildCustomUI() override;
 
   virtual void refresh() override;
+  virtual bool getCompositeLayer(RenderImageCompositeLayer& layer) override;
 
   virtual std::string niceName() override;
 
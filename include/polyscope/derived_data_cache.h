@@ -0,0 +1,87 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "polyscope/mapped_file.h"
+
+namespace polyscope {
+
+// An opt-in disk cache for data which is expensive to derive from a structure's inputs, e.g. the edge indexing of a
+// surface mesh, the interior faces and tet decomposition of a volume mesh, or the isosurface of a volume grid, so that
+// reopening the same dataset in a later session skips that work. Enabled by options::derivedDataCacheDirectory.
+//
+// Entries are keyed on a kind (naming what was derived, e.g. "VolumeMesh.tets") and a ContentHash of everything it
+// was derived from. Data which changes gets a new key, and stale entries are simply never looked up again.
+
+// A 64-bit hash of some arrays and values, for keying cache entries on their contents. Not cryptographic.
+class ContentHash {
+public:
+  ContentHash& addBytes(const void* data, size_t nBytes);
+
+  // The size of a vector is included, so e.g. ([a], [b, c]) and ([a, b], [c]) hash differently
+  template <typename T>
+  ContentHash& add(const std::vector<T>& vec) {
+    static_assert(std::is_trivially_copyable<T>::value, "only for plain data");
+    uint64_t count = vec.size();
+    addBytes(&count, sizeof(count));
+    if (!vec.empty()) addBytes(vec.data(), vec.size() * sizeof(T));
+    return *this;
+  }
+
+  template <typename T>
+  ContentHash& addValue(const T& val) {
+    static_assert(std::is_trivially_copyable<T>::value, "only for plain data");
+    return addBytes(&val, sizeof(T));
+  }
+
+  uint64_t get() const;
+
+private:
+  uint64_t state = 0x243f6a8885a308d3ull;
+  uint64_t totalBytes = 0;
+};
+
+// True if options::derivedDataCacheDirectory is set
+bool derivedDataCacheEnabled();
+
+namespace detail {
+// The entry's payload, or null on a miss. The payload points in to the returned mapping.
+std::unique_ptr<MappedFile> mapDerivedData(const std::string& kind, uint64_t inputHash, size_t elementBytes,
+                                           size_t& count, const unsigned char*& payload);
+void writeDerivedData(const std::string& kind, uint64_t inputHash, size_t elementBytes, const void* data,
+                      size_t count);
+} // namespace detail
+
+// Fill `data` from the cache entry of a kind and input hash, returning false (and leaving `data` unchanged) if there
+// is none, or if the cache is disabled.
+template <typename T>
+bool loadDerivedData(const std::string& kind, uint64_t inputHash, std::vector<T>& data) {
+  static_assert(std::is_trivially_copyable<T>::value, "only for plain data");
+  if (!derivedDataCacheEnabled()) return false;
+  size_t count = 0;
+  const unsigned char* payload = nullptr;
+  std::unique_ptr<MappedFile> file = detail::mapDerivedData(kind, inputHash, sizeof(T), count, payload);
+  if (!file) return false;
+  data.resize(count);
+  if (count > 0) std::memcpy(data.data(), payload, count * sizeof(T));
+  return true;
+}
+
+// Store `data` as the cache entry of a kind and input hash. Does nothing if the cache is disabled. Failing to write
+// the entry is not an error, it will just be derived again next time.
+template <typename T>
+void storeDerivedData(const std::string& kind, uint64_t inputHash, const std::vector<T>& data) {
+  static_assert(std::is_trivially_copyable<T>::value, "only for plain data");
+  if (!derivedDataCacheEnabled()) return;
+  detail::writeDerivedData(kind, inputHash, sizeof(T), data.empty() ? nullptr : data.data(), data.size());
+}
+
+} // namespace polyscope
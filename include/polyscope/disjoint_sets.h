@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <vector>
 
@@ -53,4 +54,24 @@ private:
   std::vector<bool> marked;
 };
 
+// A disjoint set which may be merged from many threads at once, without locks. Sets are linked by index (the larger
+// root goes under the smaller one) rather than by rank, so the representative of each set is its smallest element.
+// find() and merge() may be called concurrently, but the result of find() is only stable once all merges are done.
+class ConcurrentDisjointSets {
+public:
+  // Constructor
+  ConcurrentDisjointSets(size_t n_);
+
+  // Find parent of element x
+  size_t find(size_t x);
+
+  // Union by index
+  void merge(size_t x, size_t y);
+
+private:
+  // Member variables
+  size_t n;
+  std::vector<std::atomic<size_t>> parent;
+};
+
 } // namespace polyscope
@@ -0,0 +1,65 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/render/engine.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace polyscope {
+
+// A selected/unselected bit for each element of a structure (e.g. the points of a point cloud, the faces of a mesh),
+// drawn by tinting the selected elements. The bits are packed into a texture which the shaders read by element index,
+// so changing the selection uploads only the texels which changed, rather than a whole color buffer. Get one from the
+// structure, e.g. PointCloud::getPointSelection().
+class ElementSelection {
+public:
+  ElementSelection(size_t nElements = 0);
+
+  // Change the number of elements, any new ones are unselected
+  void resize(size_t newSize);
+  size_t size() const { return nElements; }
+
+  // Select, unselect, or flip the elements [begin, begin + count)
+  void set(size_t begin, size_t count);
+  void clear(size_t begin, size_t count);
+  void toggle(size_t begin, size_t count);
+
+  // Select, unselect, or flip a list of elements
+  void set(const std::vector<size_t>& inds);
+  void clear(const std::vector<size_t>& inds);
+  void toggle(const std::vector<size_t>& inds);
+
+  void clearAll();
+  bool isSelected(size_t ind) const;
+  size_t nSelected() const;
+  std::vector<size_t> getSelected() const; // indices of the selected elements, in order
+
+  // The color selected elements are tinted towards
+  void setColor(glm::vec3 newColor);
+  glm::vec3 getColor() const { return color; }
+
+  // The texture the shaders read, with any changes since the last call uploaded. Bits are packed 24 to an R32F texel
+  // (the integers a float holds exactly), in rows of textureWidth texels.
+  render::TextureBuffer* getTexture();
+  static const size_t bitsPerTexel = 24;
+  static const size_t textureWidth = 4096;
+
+private:
+  size_t nElements;
+  std::vector<uint32_t> words; // bitsPerTexel bits each
+  glm::vec3 color{1.f, 0.6f, 0.1f};
+
+  std::shared_ptr<render::TextureBuffer> texture;
+  size_t dirtyBegin = 0; // words not yet uploaded to the texture
+  size_t dirtyEnd = 0;
+
+  enum class Op { Set, Clear, Toggle };
+  void applyRange(size_t begin, size_t count, Op op);
+  void applyList(const std::vector<size_t>& inds, Op op);
+  void markDirty(size_t wordBegin, size_t wordEnd);
+};
+
+} // namespace polyscope
@@ -17,6 +17,7 @@
 #include "polyscope/color_image_quantity.h"
 #include "polyscope/floating_quantity.h"
 #include "polyscope/scalar_image_quantity.h"
+#include "polyscope/tiled_image_quantity.h"
 
 #include <vector>
 
@@ -29,6 +30,7 @@ class FloatingQuantityStructure;
 class Quantity;
 class ScalarImageQuantity;
 class ColorImageQuantity;
+class TiledImageQuantity;
 
 
 class FloatingQuantityStructure : public QuantityStructure<FloatingQuantityStructure> {
@@ -81,6 +83,17 @@ template <class T>
 ColorImageQuantity* addColorAlphaImageQuantity(std::string name, size_t dimX, size_t dimY, const T& values_rgba,
                                                ImageOrigin imageOrigin);
 
+ScalarImageQuantity* addScalarImageQuantityFromPixels(std::string name, size_t dimX, size_t dimY, const void* pixels,
+                                                      PixelComponentType componentType, ImageOrigin imageOrigin,
+                                                      DataType type = DataType::STANDARD);
+
+ColorImageQuantity* addColorImageQuantityFromPixels(std::string name, size_t dimX, size_t dimY, const void* pixels,
+                                                    int nChannels, PixelComponentType componentType,
+                                                    ImageOrigin imageOrigin);
+
+TiledImageQuantity* addTiledImageQuantity(std::string name, size_t dimX, size_t dimY, TiledImageLoader loader,
+                                          size_t tileSize = 256, ImageOrigin imageOrigin = ImageOrigin::UpperLeft);
+
 
 template <class T1, class T2>
 DepthRenderImageQuantity* addDepthRenderImageQuantity(std::string name, size_t dimX, size_t dimY, const T1& depthData,
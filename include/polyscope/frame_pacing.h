@@ -0,0 +1,44 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+
+namespace polyscope {
+
+// The frame pacer behind options::maxFPS.
+//
+// Frame starts are scheduled on a grid of deadlines one period apart, so the rate does not drift with the time spent
+// waiting. A frame which runs more than a period late moves the grid rather than being followed by a burst of
+// catch-up frames. Waiting sleeps on a high-resolution timer until shortly before the deadline and yields for the
+// rest. The margin follows how far recent sleeps overshot, so it stays small where timers are precise.
+//
+// With vsync, swapping the buffers already paces the loop to the display, so if the display refresh period is at least
+// the target period the pacer does not wait on its own grid. With options::latePollEvents it instead delays the start
+// of each frame, and with it polling for input, until just enough time is left to finish the frame before the next
+// vertical blank, which is extrapolated from the time the last swap returned. The time a frame takes is predicted from
+// the recent frames.
+
+// The distribution of achieved frame times (between the starts of consecutive main loop iterations) over the recent
+// frames
+struct FrameTimeDistribution {
+  size_t nFrames = 0; // 0 if nothing has been measured yet
+  double meanMs = 0.;
+  double stdDevMs = 0.;
+  double minMs = 0.;
+  double medianMs = 0.;
+  double p95Ms = 0.;
+  double p99Ms = 0.;
+  double maxMs = 0.;
+};
+FrameTimeDistribution getFrameTimeDistribution();
+
+double getPredictedFrameWorkMs(); // the time frames are expected to take to process, up to swapping the buffers
+double getDisplayPeriodMs();      // the time between vertical blanks with vsync enabled, -1 otherwise or if unknown
+
+// Called by the main loop
+void waitForNextFrame();   // before each iteration of the loop in show()
+void markFrameWorkEnd();   // just before the buffers are swapped
+void markFramePresented(); // just after the buffers are swapped
+
+} // namespace polyscope
@@ -0,0 +1,89 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "polyscope/frame_pacing.h"
+
+namespace polyscope {
+
+class Structure;
+
+// Time spent in one part of a frame. Sections can contain others, e.g. a depth peeling pass contains the draws of the
+// structures in that pass. A section which runs several times in a frame, like a structure drawn in each peeling pass,
+// accumulates its times.
+struct FrameSectionStats {
+  std::string name;
+  double cpuMs = 0.;
+  double gpuMs = -1.; // -1 if the backend has no timer queries
+};
+
+struct FrameStats {
+  uint64_t frameIndex = 0; // counts the frames drawn, 0 if nothing has been measured yet
+  double cpuMs = 0.;
+  double gpuMs = -1.; // -1 if the backend has no timer queries
+  size_t drawCalls = 0;
+  size_t trianglesSubmitted = 0;
+  size_t stateChanges = 0;        // render state changes and texture binds issued to the backend
+  size_t stateChangesSkipped = 0; // ... and ones skipped because the state was already set
+  std::vector<FrameSectionStats> sections; // in the order they first ran in the frame
+
+  // Achieved frame times over the recent frames of the main loop, see frame_pacing.h. Kept up to date even while
+  // options::collectFrameStats is not set.
+  FrameTimeDistribution frameTimes;
+};
+
+// Statistics of the most recent frame whose timings are complete. GPU times arrive a few frames after the frame is
+// drawn, so this lags slightly behind. Only collected while options::collectFrameStats is set.
+FrameStats getFrameStats();
+
+// Delimit a frame, called by the main loop
+void beginFrameStats();
+void endFrameStats();
+
+// Times the enclosing scope as a section of the current frame, does nothing if no frame is being measured
+class FrameStatsSection {
+public:
+  explicit FrameStatsSection(const std::string& name);
+  FrameStatsSection(Structure& structure, const char* what); // named after the structure
+  ~FrameStatsSection();
+
+  FrameStatsSection(const FrameStatsSection&) = delete;
+  FrameStatsSection& operator=(const FrameStatsSection&) = delete;
+
+private:
+  void begin(const std::string& name);
+
+  int64_t sectionInd = -1;
+  std::chrono::steady_clock::time_point cpuStart;
+  uint64_t gpuStartTicket = 0;
+};
+
+// Time spent in each phase of polyscope::init(), in the order they ran. Work which is deferred until it is first needed
+// (e.g. the GUI fonts, prepared for the first frame with a GUI) is appended once it has run. There are no GPU times.
+// Printed at the end of init() if options::verbosity > 2.
+std::vector<FrameSectionStats> getStartupStats();
+
+// Forget the phases of a previous init(), called at its start
+void resetStartupStats();
+
+// Times the enclosing scope as a phase of startup
+class StartupPhase {
+public:
+  explicit StartupPhase(const std::string& name);
+  ~StartupPhase();
+
+  StartupPhase(const StartupPhase&) = delete;
+  StartupPhase& operator=(const StartupPhase&) = delete;
+
+private:
+  std::string name;
+  std::chrono::steady_clock::time_point start;
+};
+
+} // namespace polyscope
@@ -64,6 +64,10 @@ protected:
   PersistentValue<bool> showChildDetails;
   PersistentValue<bool> hideDescendantsFromStructureLists;
 
+  // isEnabled() of the group, valid while the global group generation matches
+  int enabledCache = -2;
+  uint64_t enabledCacheGeneration = 0;
+
   // helpers
   void cullExpiredChildren(); // remove any child
 };
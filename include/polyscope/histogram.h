@@ -10,7 +10,11 @@
 
 namespace polyscope {
 
-// A histogram that shows up in ImGUI
+// Shared render targets of histograms, see histogram.cpp
+class HistogramAtlas;
+
+// A histogram that shows up in ImGUI. Histograms are drawn in to slots of shared atlas textures, rather than each in
+// to a texture of its own, and only when their curve, colormap or range changed since they were last drawn.
 class Histogram {
 public:
   Histogram();                           // must call buildHistogram() with data after
@@ -18,7 +22,22 @@ public:
 
   ~Histogram();
 
+  // no copy, the histogram owns a slot of the atlas
+  Histogram(const Histogram&) = delete;
+  Histogram& operator=(const Histogram&) = delete;
+
   void buildHistogram(const std::vector<float>& values);
+  void buildHistogram(const float* values, size_t count);
+  // As above, reusing the finite min/max of the values if the caller already has it (see finiteMinMax())
+  void buildHistogram(const float* values, size_t count, std::pair<double, double> finiteRange);
+  // As above, from values which were already counted in getBinCount() equal bins spanning robustRange(finiteRange),
+  // e.g. on the device (see Engine::computeHistogramOnDevice())
+  void buildHistogramFromCounts(const std::vector<double>& binCounts, std::pair<double, double> finiteRange);
+  size_t getBinCount() const { return rawHistBinCount; }
+
+  // Move `count` values from their old to their new bins, e.g. after a subset of the data changed, without a rebuild.
+  // Returns false, changing nothing, if a new value falls outside the histogram's range; rebuild it in that case.
+  bool updateCounts(const float* oldValues, const float* newValues, size_t count);
   void updateColormap(const std::string& newColormap);
 
   // Width = -1 means set automatically
@@ -30,27 +49,40 @@ private:
   // = Helpers
 
   // Manage the actual histogram
-  void fillBuffers();
+  void fillBuffers(render::ShaderProgram& program);
+  void buildCurve(const std::vector<double>& binCounts); // over dataRange
+  size_t binIndex(float value) const;                    // rawHistBinCount if it belongs in no bin
   size_t rawHistBinCount = 51;
 
+  std::vector<double> counts; // per bin, as given to buildCurve()
+
   std::vector<float> rawHistCurveY;
   std::vector<std::array<float, 2>> rawHistCurveX;
   std::pair<double, double> dataRange;
 
-  // Render to texture
-  void renderToTexture();
-  void prepare();
+  // Render to the atlas slot
+  friend class HistogramAtlas;
+  bool needsRender() const;
+  void render(render::ShaderProgram& program); // with the atlas framebuffer bound to the slot
 
-  unsigned int texDim = 600;
-  std::shared_ptr<render::TextureBuffer> texture = nullptr;
-  std::shared_ptr<render::FrameBuffer> framebuffer = nullptr;
-  std::shared_ptr<render::ShaderProgram> program = nullptr;
+  std::shared_ptr<HistogramAtlas> atlas; // null until first shown
+  size_t atlasPage = 0;
+  size_t atlasSlot = 0;
+  bool renderQueued = false;
   std::string colormap = "viridis";
+  bool curveChanged = true; // the slot is only redrawn when the curve, colormap or its range changed
+  std::pair<double, double> renderedColormapRange;
+  std::string renderedColormap;
 
   // A few parameters which control appearance
   float bottomBarHeight = 0.35;
   float bottomBarGap = 0.1;
 };
 
+// Draw the histograms shown since the last call whose curve, colormap or range changed. Called once per frame after the
+// GUI is built (the GUI only records the textures to draw), so the changed histograms are drawn together rather than
+// each switching render targets in the middle of building the GUI.
+void renderPendingHistograms();
+
 
 }; // namespace polyscope
@@ -0,0 +1,42 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/types.h"
+
+#include <string>
+#include <vector>
+
+namespace polyscope {
+
+// Image encoders used to write screenshots, see saveImage(). All of them take 8-bit pixels with 1 (gray), 2 (gray,
+// alpha), 3 (RGB) or 4 (RGBA) channels, with rows given bottom to top as read back from OpenGL, and return the bytes of
+// the encoded file.
+
+// The format an image would be written in: `format` itself, or if that is ImageFormat::Auto, the format picked by the
+// extension of `filename` (.png, .qoi, .tga, .ppm, .jpg/.jpeg), falling back on a fast PNG.
+ImageFormat resolveImageFormat(const std::string& filename, ImageFormat format = ImageFormat::Auto);
+
+// Whether images in the format keep the alpha channel
+bool imageFormatHasAlpha(ImageFormat format);
+
+// PNG compressed for speed, in the style of fpng: every row uses the "up" filter, and horizontal strips of rows are
+// deflated in parallel with a greedy single-probe LZ77 search and the fixed Huffman codes. Files are larger than
+// from a thorough encoder (like ImageFormat::PNG), but encoding is many times faster.
+std::vector<unsigned char> encodeImageFastPNG(const unsigned char* buffer, int w, int h, int channels);
+
+// The "Quite OK Image" format (https://qoiformat.org), lossless and very fast to encode and decode. Gray images are
+// stored as RGB(A).
+std::vector<unsigned char> encodeImageQOI(const unsigned char* buffer, int w, int h, int channels);
+
+// Uncompressed TGA. Gray-alpha images are stored as RGBA.
+std::vector<unsigned char> encodeImageTGA(const unsigned char* buffer, int w, int h, int channels);
+
+// Uncompressed binary PPM (or PGM for gray images), the alpha channel is dropped
+std::vector<unsigned char> encodeImagePPM(const unsigned char* buffer, int w, int h, int channels);
+
+// JPEG at the given quality in [1, 100], with libjpeg-turbo if Polyscope was built with it (see
+// POLYSCOPE_IMAGE_TURBOJPEG in CMake), otherwise with stb. The alpha channel is dropped.
+std::vector<unsigned char> encodeImageJPEG(const unsigned char* buffer, int w, int h, int channels, int quality);
+
+} // namespace polyscope
@@ -15,3 +15,4 @@
 #include "polyscope/raw_color_render_image_quantity.h"
 #include "polyscope/scalar_image_quantity.h"
 #include "polyscope/scalar_render_image_quantity.h"
+#include "polyscope/tiled_image_quantity.h"
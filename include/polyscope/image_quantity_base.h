@@ -65,6 +65,7 @@ protected:
   virtual void renderIntermediate();
 
   bool parentIsCameraView();
+  void checkPixelRect(size_t x, size_t y, size_t w, size_t h); // throws if it is not within the image
   void buildImageUI();
   void buildImageOptionsUI();
 };
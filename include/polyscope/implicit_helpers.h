@@ -11,11 +11,13 @@
 #include "polyscope/raw_color_alpha_render_image_quantity.h"
 #include "polyscope/raw_color_render_image_quantity.h"
 #include "polyscope/scalar_render_image_quantity.h"
+#include "polyscope/scratch_buffer.h"
 #include "polyscope/scaled_value.h"
 #include "polyscope/structure.h"
 #include "polyscope/utilities.h"
 
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -75,12 +77,50 @@ struct ImplicitRenderOpts {
 
   // The maximum number of steps to take
   size_t nMaxSteps = 1024;
+
+  // = Options for evaluating the implicit functions
+
+  // By default each batch of queries is passed to the function in a single call, on the calling thread. If
+  // batchTileSize > 0, batches are instead split in to tiles of at most this many queries, which are evaluated in
+  // parallel on batchThreads threads (0 means use options::numThreads). The functions must then be safe to call
+  // concurrently from several threads.
+  size_t batchTileSize = 0;
+  size_t batchThreads = 0;
+
+  // = Options for computing normals (only computed for pixels which hit the surface)
+
+  // How normals are estimated when no gradient function is given. FiniteDifference evaluates the function 4 more times
+  // around each hit point. ScreenSpace instead differences the hit positions of neighboring pixels, which costs no
+  // function evaluations but is faceted and less accurate at silhouettes. Progressive renders always use
+  // FiniteDifference, since they trace pixels tile by tile.
+  ImplicitNormalMode normalMode = ImplicitNormalMode::FiniteDifference;
+
+  // If set, normals are computed from this gradient of the implicit function, which is called like the batch color
+  // functions below: void(float* in_pos_ptr, float* out_grad_ptr, size_t N), writing 3N values.
+  std::function<void(const float*, float*, size_t)> gradientFuncBatch;
+
+  // = Options for progressive rendering, see renderImplicitSurfaceProgressive()
+
+  // The first pass traces a single ray for each block of this many pixels (in each dimension)
+  int progressiveCoarseFactor = 8;
+
+  // The image is then refined in square tiles of this many pixels
+  int progressiveTileSize = 32;
+
+  // Roughly how long to spend refining tiles each frame, in milliseconds (at least one tile is traced per frame)
+  float progressiveFrameBudgetMs = 10.;
 };
 
 // Populate the custom-filled entries of opts according to the policy above.
 template <class S>
 void resolveImplicitRenderOpts(QuantityStructure<S>* parent, ImplicitRenderOpts& opts);
 
+// Evaluate a batch function at nQueries positions (3 floats each), which writes outDim floats per query to out. The
+// queries are split in to tiles according to opts.batchTileSize and opts.batchThreads.
+template <class Func>
+void evaluateImplicitBatch(Func&& func, float* queryPos, float* out, size_t nQueries, size_t outDim,
+                           const ImplicitRenderOpts& opts);
+
 // === Depth/geometry/shape only render functions
 
 // Renders an implicit surface by shooting a ray for each pixel and querying the implicit function along the ray.
@@ -116,6 +156,59 @@ template <class Func>
 DepthRenderImageQuantity* renderImplicitSurfaceBatch(std::string name, Func&& func, ImplicitRenderMode mode,
                                                      ImplicitRenderOpts opts = ImplicitRenderOpts());
 
+// === Progressive render functions
+
+// Like renderImplicitSurface(), but returns right away with a coarse image which traces one ray for each block of
+// opts.progressiveCoarseFactor pixels. The image is then refined tile by tile over the following frames, within a
+// per-frame time budget, until it is exactly what renderImplicitSurface() would have produced.
+//
+// The function is copied and kept until the render has converged, so anything it references must stay alive until
+// then. Removing the quantity (or replacing it by rendering again with the same name) stops the refinement.
+
+template <class Func, class S>
+DepthRenderImageQuantity* renderImplicitSurfaceProgressive(QuantityStructure<S>* parent, std::string name, Func&& func,
+                                                           ImplicitRenderMode mode,
+                                                           ImplicitRenderOpts opts = ImplicitRenderOpts());
+template <class Func>
+DepthRenderImageQuantity* renderImplicitSurfaceProgressive(std::string name, Func&& func, ImplicitRenderMode mode,
+                                                           ImplicitRenderOpts opts = ImplicitRenderOpts());
+template <class Func, class S>
+DepthRenderImageQuantity* renderImplicitSurfaceProgressiveBatch(QuantityStructure<S>* parent, std::string name,
+                                                                Func&& func, ImplicitRenderMode mode,
+                                                                ImplicitRenderOpts opts = ImplicitRenderOpts());
+template <class Func>
+DepthRenderImageQuantity* renderImplicitSurfaceProgressiveBatch(std::string name, Func&& func,
+                                                                ImplicitRenderMode mode,
+                                                                ImplicitRenderOpts opts = ImplicitRenderOpts());
+
+// Are any progressive renders still being refined?
+bool progressiveImplicitRendersPending();
+
+// Refine each progressive render by one frame's worth of tiles, called once per frame by the main loop
+void processProgressiveImplicitRenders();
+
+// The state of one in-progress progressive render (internal, see renderImplicitSurfaceProgressive())
+struct ProgressiveImplicitRender {
+  DepthRenderImageQuantity* quantity = nullptr;
+  std::function<bool()> quantityIsAlive; // false once the quantity (or its structure) is removed or replaced
+  std::function<void(float*, float*, size_t)> func;
+  ImplicitRenderMode mode;
+  ImplicitRenderOpts opts; // resolved, with all scaled values converted to absolute
+  std::vector<glm::vec3> rayDirs;
+  std::vector<float> depths;
+  std::vector<glm::vec3> normals;
+  size_t nextTile = 0;
+};
+void initializeProgressiveImplicitRender(ProgressiveImplicitRender& render); // traces the coarse pass
+void addProgressiveImplicitRender(ProgressiveImplicitRender render);
+
+// Estimate view-space normals for a full image from the hit positions of neighboring pixels, as used by
+// ImplicitNormalMode::ScreenSpace (misses have infinite depth and get a zero normal)
+std::vector<glm::vec3> computeScreenSpaceImplicitNormals(const std::vector<float>& depths,
+                                                         const std::vector<glm::vec3>& positions,
+                                                         const std::vector<glm::vec3>& rayDirs,
+                                                         const ImplicitRenderOpts& opts);
+
 // === Colored surface render functions
 
 // Like the implicit surface renderers above, but additionally take a color
@@ -7,6 +7,7 @@
 #include "polyscope/floating_quantity_structure.h"
 #include "polyscope/implicit_helpers.h"
 #include "polyscope/messages.h"
+#include "polyscope/parallel.h"
 #include "polyscope/view.h"
 
 #include <tuple>
@@ -63,9 +64,23 @@ void resolveImplicitRenderOpts(QuantityStructure<S>* parent, ImplicitRenderOpts&
             "global floating structure to use the current view");
 }
 
+template <class Func>
+void evaluateImplicitBatch(Func&& func, float* queryPos, float* out, size_t nQueries, size_t outDim,
+                           const ImplicitRenderOpts& opts) {
+  if (opts.batchTileSize == 0 || nQueries <= opts.batchTileSize) {
+    func(queryPos, out, nQueries);
+    return;
+  }
+
+  parallelForTiles(0, nQueries, opts.batchTileSize, opts.batchThreads, [&](size_t tileBegin, size_t tileEnd) {
+    func(queryPos + 3 * tileBegin, out + outDim * tileBegin, tileEnd - tileBegin);
+  });
+}
+
 template <class Func>
 std::tuple<std::vector<float>, std::vector<glm::vec3>, std::vector<glm::vec3>>
-renderImplicitSurfaceTracer(Func&& func, ImplicitRenderMode mode, ImplicitRenderOpts opts, bool withNormals = true) {
+renderImplicitSurfaceTracerRays(Func&& func, ImplicitRenderMode mode, const ImplicitRenderOpts& opts,
+                                const std::vector<glm::vec3>& rayDirs, bool withNormals = true) {
 
   // Read out option values
   const float missDist = opts.missDist.asAbsolute();
@@ -74,106 +89,93 @@ renderImplicitSurfaceTracer(Func&& func, ImplicitRenderMode mode, ImplicitRender
   const float stepSize = opts.stepSize.asAbsolute(); // used for fixed step only
   const size_t nMaxSteps = opts.nMaxSteps;
   const float normalSampleEps = opts.normalSampleEps;
-  const int subsampleFactor = opts.subsampleFactor;
 
 
-  CameraParameters& params = opts.cameraParameters;
+  const CameraParameters& params = opts.cameraParameters;
   glm::vec3 cameraLoc = params.getPosition();
   glm::mat4x4 viewMat = params.getViewMat();
-  size_t dimX = opts.dimX;
-  size_t dimY = opts.dimY;
-  size_t nPix = dimX * dimY;
+  size_t nPix = rayDirs.size();
+  if (nPix == 0) {
+    return std::tuple<std::vector<float>, std::vector<glm::vec3>, std::vector<glm::vec3>>{};
+  }
 
-  // Generate rays corresponding to each pixel
-  // (this is a working set which will be shrunk as computation proceeds)
-  std::vector<glm::vec3> rayRoots(nPix);
-  std::vector<size_t> rayInds(nPix); // index of the ray
-  for (size_t iY = 0; iY < dimY; iY++) {
-    for (size_t iX = 0; iX < dimX; iX++) {
-      size_t ind = iY * dimX + iX;
-      rayRoots[ind] = cameraLoc;
-      rayInds[ind] = ind;
-    }
+  // The rays which are still marching, compacted every step. The depth, the next query position, and the latest
+  // function value of each active ray are stored in the same order. Positions are packed as x,y,z triples, so they can
+  // be passed straight to the function.
+  ScratchVector<size_t> activeRays(nPix);
+  ScratchVector<float> activeDepth(nPix, 0.);
+  ScratchVector<float> queryPos(3 * nPix);
+  ScratchVector<float> currVals(nPix);
+  for (size_t iP = 0; iP < nPix; iP++) {
+    activeRays[iP] = iP;
+    queryPos[3 * iP + 0] = cameraLoc.x;
+    queryPos[3 * iP + 1] = cameraLoc.y;
+    queryPos[3 * iP + 2] = cameraLoc.z;
   }
-  std::vector<glm::vec3> rayDirs = params.generateCameraRays(dimX, dimY, ImageOrigin::UpperLeft);
 
   // Sample the first value at each ray (to check for sign changes)
-  std::vector<float> currVals(nPix);
-  func(&rayRoots.front().x, &currVals.front(), rayRoots.size());
+  evaluateImplicitBatch(func, &queryPos[0], &currVals[0], nPix, 1, opts);
 
-  std::vector<bool> initSigns(nPix);
+  ScratchVector<char> initSigns(nPix);
   for (size_t iP = 0; iP < nPix; iP++) {
     initSigns[iP] = std::signbit(currVals[iP]);
   }
 
-  // Write output data here
-
   // March along the ray to compute depth
-  std::vector<float> rayDepth(nPix, 0.); // working data, gets shrunk and repacked
-  std::vector<glm::vec3> currPos(nPix);
   std::vector<float> rayDepthOut(nPix, -1.);                        // output values
   std::vector<glm::vec3> rayPosOut(nPix, glm::vec3{0.f, 0.f, 0.f}); // output values
-  size_t iFinished = 0;
-  for (size_t iStep = 0; (iStep < nMaxSteps) && (iFinished < nPix); iStep++) {
+  size_t nActive = nPix;
+  for (size_t iStep = 0; (iStep < nMaxSteps) && (nActive > 0); iStep++) {
 
     // Check for convergence & write/compact
     size_t iPack = 0;
-    for (size_t iP = 0; iP < rayDepth.size(); iP++) {
+    for (size_t iA = 0; iA < nActive; iA++) {
+      size_t iRay = activeRays[iA];
+      float depth = activeDepth[iA];
+      float val = currVals[iA];
 
       // Check for termination
-      bool missTerminated = rayDepth[iP] > missDist;
+      bool missTerminated = depth > missDist;
       bool terminated =
-          missTerminated || (std::abs(currVals[iP]) < hitDist) || (std::signbit(currVals[iP]) != initSigns[iP]);
+          missTerminated || (std::abs(val) < hitDist) || (std::signbit(val) != static_cast<bool>(initSigns[iRay]));
 
       if (terminated) {
         // Write to the output buffer
-        size_t outInd = rayInds[iP];
-        glm::vec3 finalPos = rayRoots[iP] + rayDepth[iP] * rayDirs[iP];
-        float outDepth = missTerminated ? -1.f : rayDepth[iP];
-        rayDepthOut[outInd] = outDepth;
-        rayPosOut[outInd] = finalPos;
-
-        iFinished++;
-
-      } else {
-        // Take a step
-        float rayStepSize = -1.;
-        if (mode == ImplicitRenderMode::SphereMarch) {
-          rayStepSize = std::abs(currVals[iP]) * stepFactor;
-        } else if (mode == ImplicitRenderMode::FixedStep) {
-          rayStepSize = stepSize;
-        }
-
-        float newDepth = rayDepth[iP] + rayStepSize;
-        glm::vec3 newPos = rayRoots[iP] + newDepth * rayDirs[iP];
+        rayDepthOut[iRay] = missTerminated ? -1.f : depth;
+        rayPosOut[iRay] = cameraLoc + depth * rayDirs[iRay];
+        continue;
+      }
 
-        // Write to the compacted array
-        rayRoots[iPack] = rayRoots[iP];
-        rayDirs[iPack] = rayDirs[iP];
-        rayInds[iPack] = rayInds[iP];
-        rayDepth[iPack] = newDepth;
-        currPos[iPack] = newPos;
-        iPack++;
+      // Take a step
+      float rayStepSize = -1.;
+      if (mode == ImplicitRenderMode::SphereMarch) {
+        rayStepSize = std::abs(val) * stepFactor;
+      } else if (mode == ImplicitRenderMode::FixedStep) {
+        rayStepSize = stepSize;
       }
-    }
 
-    // "Trim" the working arrays to size
-    rayRoots.resize(iPack);
-    rayDirs.resize(iPack);
-    rayInds.resize(iPack);
-    rayDepth.resize(iPack);
-    currPos.resize(iPack);
-    currVals.resize(iPack);
+      float newDepth = depth + rayStepSize;
+      glm::vec3 newPos = cameraLoc + newDepth * rayDirs[iRay];
+
+      // Write to the compacted arrays (iPack <= iA, so this never clobbers rays yet to be visited)
+      activeRays[iPack] = iRay;
+      activeDepth[iPack] = newDepth;
+      queryPos[3 * iPack + 0] = newPos.x;
+      queryPos[3 * iPack + 1] = newPos.y;
+      queryPos[3 * iPack + 2] = newPos.z;
+      iPack++;
+    }
+    nActive = iPack;
 
     // Evaluate the remaining rays
-    if (iPack > 0) {
-      func(&currPos.front().x, &currVals.front(), currPos.size());
+    if (nActive > 0) {
+      evaluateImplicitBatch(func, &queryPos[0], &currVals[0], nActive, 1, opts);
     }
   }
 
   // == Compute normals
-  // Uses finite differences on the vertices of a tetrahedron
-  // (see https://iquilezles.org/articles/normalsSDF/)
+  // Only for rays which hit the surface. Uses the gradient function if one was given, otherwise finite differences on
+  // the vertices of a tetrahedron (see https://iquilezles.org/articles/normalsSDF/)
 
   std::vector<glm::vec3> normalOut;
 
@@ -181,54 +183,93 @@ renderImplicitSurfaceTracer(Func&& func, ImplicitRenderMode mode, ImplicitRender
 
     normalOut = std::vector<glm::vec3>(nPix, glm::vec3{0.f, 0.f, 0.f});
 
-    std::array<glm::vec3, 4> tetVerts({
-        glm::vec3{1.f, -1.f, -1.f},
-        glm::vec3{-1.f, -1.f, 1.f},
-        glm::vec3{-1.f, 1.f, -1.f},
-        glm::vec3{1.f, 1.f, 1.f},
-    });
-
-    currPos.resize(nPix);
-    currVals.resize(nPix);
-    for (size_t iV = 0; iV < 4; iV++) {
-      glm::vec3 vertVec = tetVerts[iV];
-
-      // Set up the evaluation points for each pixel
-      for (size_t iP = 0; iP < nPix; iP++) {
-        float f = rayDepthOut[iP] * normalSampleEps;
-        currPos[iP] = rayPosOut[iP] + f * vertVec;
+    ScratchVector<size_t> hitRays;
+    for (size_t iP = 0; iP < nPix; iP++) {
+      if (rayDepthOut[iP] >= 0.) {
+        hitRays->push_back(iP);
+      }
+    }
+    size_t nHit = hitRays->size();
+    ScratchVector<glm::vec3> hitGrad(nHit, glm::vec3{0.f, 0.f, 0.f});
+
+    if (nHit > 0 && opts.gradientFuncBatch) {
+
+      ScratchVector<glm::vec3> hitPos(nHit);
+      for (size_t iH = 0; iH < nHit; iH++) {
+        hitPos[iH] = rayPosOut[hitRays[iH]];
       }
+      evaluateImplicitBatch(opts.gradientFuncBatch, &hitPos[0].x, &hitGrad[0].x, nHit, 3, opts);
+
+    } else if (nHit > 0) {
+
+      std::array<glm::vec3, 4> tetVerts({
+          glm::vec3{1.f, -1.f, -1.f},
+          glm::vec3{-1.f, -1.f, 1.f},
+          glm::vec3{-1.f, 1.f, -1.f},
+          glm::vec3{1.f, 1.f, 1.f},
+      });
+
+      ScratchVector<glm::vec3> samplePos(nHit);
+      for (size_t iV = 0; iV < 4; iV++) {
+        glm::vec3 vertVec = tetVerts[iV];
+
+        // Set up the evaluation points for each hit
+        for (size_t iH = 0; iH < nHit; iH++) {
+          size_t iRay = hitRays[iH];
+          float f = rayDepthOut[iRay] * normalSampleEps;
+          samplePos[iH] = rayPosOut[iRay] + f * vertVec;
+        }
 
-      // Evaluate the function at each sample point
-      func(&currPos.front().x, &currVals.front(), currPos.size());
+        // Evaluate the function at each sample point
+        evaluateImplicitBatch(func, &samplePos[0].x, &currVals[0], nHit, 1, opts);
 
-      // Accumulate the result
-      for (size_t iP = 0; iP < nPix; iP++) {
-        normalOut[iP] += vertVec * currVals[iP];
+        // Accumulate the result
+        for (size_t iH = 0; iH < nHit; iH++) {
+          hitGrad[iH] += vertVec * currVals[iH];
+        }
       }
     }
 
     // Normalize the normal vectors and transform to view space
     glm::mat3x3 viewMat3(viewMat);
-    for (size_t iP = 0; iP < nPix; iP++) {
-      normalOut[iP] = viewMat3 * glm::normalize(normalOut[iP]);
+    for (size_t iH = 0; iH < nHit; iH++) {
+      normalOut[hitRays[iH]] = viewMat3 * glm::normalize(hitGrad[iH]);
     }
   }
 
-  // Handle not-converged rays
+  // Handle not-converged rays (their normals were never written, and are already zero)
   for (size_t iP = 0; iP < nPix; iP++) {
     bool didConverge = rayDepthOut[iP] >= 0.;
     if (!didConverge) {
       rayDepthOut[iP] = std::numeric_limits<float>::infinity();
-      if (withNormals) {
-        normalOut[iP] = glm::vec3{0.f, 0.f, 0.f};
-      }
     }
   }
 
 
-  return std::tuple<std::vector<float>, std::vector<glm::vec3>, std::vector<glm::vec3>>{rayDepthOut, rayPosOut,
-                                                                                        normalOut};
+  return std::tuple<std::vector<float>, std::vector<glm::vec3>, std::vector<glm::vec3>>{
+      std::move(rayDepthOut), std::move(rayPosOut), std::move(normalOut)};
+}
+
+template <class Func>
+std::tuple<std::vector<float>, std::vector<glm::vec3>, std::vector<glm::vec3>>
+renderImplicitSurfaceTracer(Func&& func, ImplicitRenderMode mode, ImplicitRenderOpts opts, bool withNormals = true) {
+
+  // Generate rays corresponding to each pixel
+  std::vector<glm::vec3> rayDirs =
+      opts.cameraParameters.generateCameraRays(opts.dimX, opts.dimY, ImageOrigin::UpperLeft);
+
+  // Screen space normals need the whole image, so they are computed after tracing (a gradient function takes priority)
+  bool screenSpaceNormals =
+      withNormals && opts.normalMode == ImplicitNormalMode::ScreenSpace && !opts.gradientFuncBatch;
+
+  std::tuple<std::vector<float>, std::vector<glm::vec3>, std::vector<glm::vec3>> result =
+      renderImplicitSurfaceTracerRays(func, mode, opts, rayDirs, withNormals && !screenSpaceNormals);
+
+  if (screenSpaceNormals) {
+    std::get<2>(result) = computeScreenSpaceImplicitNormals(std::get<0>(result), std::get<1>(result), rayDirs, opts);
+  }
+
+  return result;
 }
 
 // =======================================================
@@ -288,6 +329,70 @@ DepthRenderImageQuantity* renderImplicitSurfaceBatch(QuantityStructure<S>* paren
                                                  ImageOrigin::UpperLeft);
 }
 
+// =======================================================
+// === Progressive render functions
+// =======================================================
+
+template <class Func>
+DepthRenderImageQuantity* renderImplicitSurfaceProgressive(std::string name, Func&& func, ImplicitRenderMode mode,
+                                                           ImplicitRenderOpts opts) {
+  return renderImplicitSurfaceProgressive(getGlobalFloatingQuantityStructure(), name, func, mode, opts);
+}
+
+template <class Func>
+DepthRenderImageQuantity* renderImplicitSurfaceProgressiveBatch(std::string name, Func&& func,
+                                                                ImplicitRenderMode mode, ImplicitRenderOpts opts) {
+  return renderImplicitSurfaceProgressiveBatch(getGlobalFloatingQuantityStructure(), name, func, mode, opts);
+}
+
+template <class Func, class S>
+DepthRenderImageQuantity* renderImplicitSurfaceProgressive(QuantityStructure<S>* parent, std::string name, Func&& func,
+                                                           ImplicitRenderMode mode, ImplicitRenderOpts opts) {
+
+  // Bootstrap on the batch version
+  // (the function is captured by value, since it gets used on later frames)
+  typename std::decay<Func>::type funcCopy = func;
+  auto batchFunc = [funcCopy](const float* pos_ptr, float* result_ptr, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      glm::vec3 pos{
+          pos_ptr[3 * i + 0],
+          pos_ptr[3 * i + 1],
+          pos_ptr[3 * i + 2],
+      };
+      result_ptr[i] = static_cast<float>(funcCopy(pos));
+    }
+  };
+
+  return renderImplicitSurfaceProgressiveBatch(parent, name, batchFunc, mode, opts);
+}
+
+template <class Func, class S>
+DepthRenderImageQuantity* renderImplicitSurfaceProgressiveBatch(QuantityStructure<S>* parent, std::string name,
+                                                                Func&& func, ImplicitRenderMode mode,
+                                                                ImplicitRenderOpts opts) {
+
+  resolveImplicitRenderOpts(parent, opts);
+
+  ProgressiveImplicitRender render;
+  render.func = func;
+  render.mode = mode;
+  render.opts = opts;
+  initializeProgressiveImplicitRender(render);
+
+  // here, we bypass the conversion adaptor since we have explicitly filled matching types
+  DepthRenderImageQuantity* q = parent->addDepthRenderImageQuantityImpl(name, opts.dimX, opts.dimY, render.depths,
+                                                                        render.normals, ImageOrigin::UpperLeft);
+
+  WeakHandle<QuantityStructure<S>> parentHandle = parent->template getWeakHandle<QuantityStructure<S>>(parent);
+  render.quantity = q;
+  render.quantityIsAlive = [parentHandle, name, q]() {
+    return parentHandle.isValid() && parentHandle.get().getFloatingQuantity(name) == q;
+  };
+  addProgressiveImplicitRender(std::move(render));
+
+  return q;
+}
+
 // =======================================================
 // === Colored surface render functions
 // =======================================================
@@ -358,7 +463,7 @@ ColorRenderImageQuantity* renderImplicitSurfaceColorBatch(QuantityStructure<S>*
 
   // Batch evaluate the color function
   std::vector<glm::vec3> colorOut(rayPosOut.size());
-  funcColor(&rayPosOut.front().x, &colorOut.front().x, rayPosOut.size());
+  evaluateImplicitBatch(funcColor, &rayPosOut.front().x, &colorOut.front().x, rayPosOut.size(), 3, opts);
 
   // Set colors for miss rays to 0
   for (size_t iP = 0; iP < rayPosOut.size(); iP++) {
@@ -444,7 +549,7 @@ ScalarRenderImageQuantity* renderImplicitSurfaceScalarBatch(QuantityStructure<S>
 
   // Batch evaluate the color function
   std::vector<float> scalarOut(rayPosOut.size());
-  funcScalar(&rayPosOut.front().x, &scalarOut.front(), rayPosOut.size());
+  evaluateImplicitBatch(funcScalar, &rayPosOut.front().x, &scalarOut.front(), rayPosOut.size(), 1, opts);
 
   // Set scalars for miss rays to NaN
   const float nan = std::numeric_limits<float>::quiet_NaN();
@@ -534,7 +639,7 @@ RawColorRenderImageQuantity* renderImplicitSurfaceRawColorBatch(QuantityStructur
 
   // Batch evaluate the color function
   std::vector<glm::vec3> colorOut(rayPosOut.size());
-  funcColor(&rayPosOut.front().x, &colorOut.front().x, rayPosOut.size());
+  evaluateImplicitBatch(funcColor, &rayPosOut.front().x, &colorOut.front().x, rayPosOut.size(), 3, opts);
 
   // Set colors for miss rays to 0
   for (size_t iP = 0; iP < rayPosOut.size(); iP++) {
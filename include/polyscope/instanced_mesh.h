@@ -0,0 +1,164 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/color_management.h"
+#include "polyscope/persistent_value.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/render/managed_buffer.h"
+#include "polyscope/scaled_value.h"
+#include "polyscope/simple_triangle_mesh.h"
+#include "polyscope/structure.h"
+
+#include <utility>
+#include <vector>
+
+namespace polyscope {
+
+// Forward declare instanced mesh
+class InstancedMesh;
+
+// One triangle mesh drawn at many poses with a single instanced draw call. The mesh data is stored (and uploaded) only
+// once, each instance just adds a transform and optionally a color or a scalar value.
+class InstancedMesh : public QuantityStructure<InstancedMesh> {
+public:
+  // === Member functions ===
+
+  // Construct a new instanced mesh structure
+  InstancedMesh(std::string name, std::vector<glm::vec3> vertices, std::vector<glm::uvec3> faces,
+                std::vector<glm::mat4> transforms);
+
+  // === Overrides
+
+  // Build the imgui display
+  virtual void buildCustomUI() override;
+  virtual void buildCustomOptionsUI() override;
+  virtual void buildPickUI(size_t localPickID) override;
+
+  // Standard structure overrides
+  virtual void draw() override;
+  virtual void drawDelayed() override;
+  virtual void drawPick() override;
+  virtual void updateObjectSpaceBounds() override;
+  virtual std::string typeName() override;
+  virtual void refresh() override;
+
+  // === Geometry members
+  render::ManagedBuffer<glm::vec3> vertices;
+  render::ManagedBuffer<glm::uvec3> faces;
+
+  // The vertex positions of each face corner, which is what is actually drawn for each instance
+  render::ManagedBuffer<glm::vec3> cornerPositions;
+
+  // === Per-instance data
+  // Each transform is stored as its 4 columns
+  render::ManagedBuffer<glm::vec4> instanceTransforms;
+  render::ManagedBuffer<glm::vec3> instanceColors;
+  render::ManagedBuffer<float> instanceValues;
+
+  size_t nInstances();
+  size_t nFaces();
+
+  // The instance and the face of the instance for a pick index of this structure
+  std::pair<size_t, size_t> pickIndexToInstanceFace(size_t localPickID);
+
+  // === Mutate
+
+  // Replace the transforms, the number of instances may change
+  void updateInstanceTransforms(const std::vector<glm::mat4>& newTransforms);
+
+  // Color each instance by a color or by a (colormapped) scalar value, one per instance
+  template <class T>
+  void setInstanceColors(const T& colors);
+  template <class T>
+  void setInstanceScalars(const T& values);
+  void clearInstanceColors(); // go back to a single color for all instances
+
+  // Misc data
+  static const std::string structureTypeName;
+
+  // === Get/set visualization parameters
+
+  // set the base color of the surface
+  InstancedMesh* setSurfaceColor(glm::vec3 newVal);
+  glm::vec3 getSurfaceColor();
+
+  // Material
+  InstancedMesh* setMaterial(std::string name);
+  std::string getMaterial();
+
+  // Color map used for per-instance scalars
+  InstancedMesh* setColorMap(std::string name);
+  std::string getColorMap();
+
+  // Backface color
+  InstancedMesh* setBackFaceColor(glm::vec3 val);
+  glm::vec3 getBackFaceColor();
+
+  // Backface policy
+  InstancedMesh* setBackFacePolicy(BackFacePolicy newPolicy);
+  BackFacePolicy getBackFacePolicy();
+
+  // Rendering helpers
+  void setInstancedMeshUniforms(render::ShaderProgram& p, bool withSurfaceShade = true);
+  void setInstancedMeshProgramGeometryAttributes(render::ShaderProgram& p);
+  std::vector<std::string> addInstancedMeshRules(std::vector<std::string> initRules, bool withSurfaceShade = true);
+
+private:
+  // Storage for the managed buffers above. You should generally interact with this directly through them.
+  std::vector<glm::vec3> verticesData;
+  std::vector<glm::uvec3> facesData;
+  std::vector<glm::vec3> cornerPositionsData;
+  std::vector<glm::vec4> instanceTransformsData;
+  std::vector<glm::vec3> instanceColorsData;
+  std::vector<float> instanceValuesData;
+
+  // How instances are colored, depending on which per-instance data was set
+  enum class InstanceColoring { Uniform = 0, Color, Scalar };
+  InstanceColoring instanceColoring = InstanceColoring::Uniform;
+  std::pair<double, double> instanceValueRange{0., 1.};
+
+  // === Visualization parameters
+  PersistentValue<glm::vec3> surfaceColor;
+  PersistentValue<std::string> material;
+  PersistentValue<std::string> cMap;
+  PersistentValue<BackFacePolicy> backFacePolicy;
+  PersistentValue<glm::vec3> backFaceColor;
+
+  // Drawing related things
+  // if nullptr, prepare() (resp. preparePick()) needs to be called
+  std::shared_ptr<render::ShaderProgram> program;
+  std::shared_ptr<render::ShaderProgram> pickProgram;
+
+  // === Helpers
+  // Do setup work related to drawing, including allocating openGL data
+  void ensureRenderProgramPrepared();
+  void ensurePickProgramPrepared();
+  void setInstanceColorsImpl(std::vector<glm::vec3> colors);
+  void setInstanceScalarsImpl(std::vector<float> values);
+
+  // == Picking related things
+  // Each face of each instance gets a pick index, instance i face f is at pickStart + i * nFaces() + f
+  size_t pickStart;
+};
+
+
+// Shorthand to add an instanced mesh to polyscope
+template <class V, class F>
+InstancedMesh* registerInstancedMesh(std::string name, const V& vertices, const F& faces,
+                                     const std::vector<glm::mat4>& transforms);
+
+// Instance the geometry of an existing simple triangle mesh (which is copied once)
+InstancedMesh* registerInstancedMesh(std::string name, SimpleTriangleMesh& source,
+                                     const std::vector<glm::mat4>& transforms);
+
+// Shorthand to get an instanced mesh from polyscope
+inline InstancedMesh* getInstancedMesh(std::string name = "");
+inline bool hasInstancedMesh(std::string name = "");
+inline void removeInstancedMesh(std::string name = "", bool errorIfAbsent = false);
+
+
+} // namespace polyscope
+
+#include "polyscope/instanced_mesh.ipp"
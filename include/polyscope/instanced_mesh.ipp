@@ -0,0 +1,47 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/utilities.h"
+
+#include <stdexcept>
+
+namespace polyscope {
+
+// Shorthand to add an instanced mesh to polyscope
+template <class V, class F>
+InstancedMesh* registerInstancedMesh(std::string name, const V& vertexPositions, const F& faceIndices,
+                                     const std::vector<glm::mat4>& transforms) {
+  checkInitialized();
+
+  InstancedMesh* s = new InstancedMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions),
+                                       standardizeVectorArray<glm::uvec3, 3>(faceIndices), transforms);
+
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+
+  return s;
+}
+
+template <class T>
+void InstancedMesh::setInstanceColors(const T& colors) {
+  validateSize(colors, nInstances(), "instance colors");
+  setInstanceColorsImpl(standardizeVectorArray<glm::vec3, 3>(colors));
+}
+
+template <class T>
+void InstancedMesh::setInstanceScalars(const T& values) {
+  validateSize(values, nInstances(), "instance scalars");
+  setInstanceScalarsImpl(standardizeArray<float, T>(values));
+}
+
+// Shorthand to get an instanced mesh from polyscope
+inline InstancedMesh* getInstancedMesh(std::string name) {
+  return dynamic_cast<InstancedMesh*>(getStructure(InstancedMesh::structureTypeName, name));
+}
+inline bool hasInstancedMesh(std::string name) { return hasStructure(InstancedMesh::structureTypeName, name); }
+inline void removeInstancedMesh(std::string name, bool errorIfAbsent) {
+  removeStructure(InstancedMesh::structureTypeName, name, errorIfAbsent);
+}
+
+} // namespace polyscope
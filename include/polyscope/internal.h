@@ -26,5 +26,22 @@ extern bool& pointCloudEfficiencyWarningReported;
 // global members
 extern FloatingQuantityStructure*& globalFloatingQuantityStructure;
 
+// Mark the list of enabled structures which are drawn each frame as out of date, e.g. after a structure is enabled
+void invalidateStructureDrawList();
+
+// Mark the cached enabled state of all groups as out of date, e.g. after the group hierarchy changes. Implied by
+// invalidateStructureDrawList().
+void invalidateGroupEnabledState();
+
+// Render the scene from the current view and light it in to the display buffer, without the rest of the per-frame work
+// of draw(). The display is cleared to black at `backgroundAlpha` first, 1 gives an opaque image.
+void renderSceneToDisplay(float backgroundAlpha = 0.);
+
+// Make show() stop waiting while idle (see options::idleWhenUnchanged), e.g. because an update was queued. Any thread.
+void wakeIdleMainLoop();
+
+// Set up stb's global image writing options, before any thread encodes images. Main thread only.
+void configureImageWriting();
+
 } // namespace internal
 } // namespace polyscope
@@ -0,0 +1,23 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace polyscope {
+
+// Deduplicate a list of keys (for instance sorted vertex index tuples identifying the edges or faces of a mesh) and
+// assign each distinct key an index. Indices are numbered in order of first appearance in the input, which matches
+// what a sequential pass with a hash map would produce.
+//
+// This is sort-based rather than hash-based: it needs a small constant amount of memory per key and runs in
+// parallel. K must be copyable and support operator< and operator==.
+//
+// On return, keyUniqueInd[i] holds the index of keys[i]. Returns the number of distinct keys.
+template <typename K>
+size_t indexUniqueKeys(const std::vector<K>& keys, std::vector<size_t>& keyUniqueInd);
+
+} // namespace polyscope
+
+#include "polyscope/key_indexing.ipp"
@@ -0,0 +1,95 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/parallel.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace polyscope {
+
+template <typename K>
+size_t indexUniqueKeys(const std::vector<K>& keys, std::vector<size_t>& keyUniqueInd) {
+
+  size_t N = keys.size();
+  keyUniqueInd.resize(N);
+  if (N == 0) return 0;
+
+  // Sort (key, position) pairs. Ties are broken by position, so the first entry of each run of equal keys is the
+  // earliest occurrence of that key.
+  std::vector<std::pair<K, size_t>> entries(N);
+  size_t nChunks = parallelChunkCount(N);
+  std::vector<size_t> chunkBounds(nChunks + 1);
+  parallelForChunks(0, N, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      entries[i] = std::make_pair(keys[i], i);
+    }
+    std::sort(entries.begin() + begin, entries.begin() + end);
+    chunkBounds[iChunk] = begin;
+    if (iChunk + 1 == nChunks) chunkBounds[nChunks] = end;
+  });
+
+  // Merge the sorted chunks pairwise until a single run remains
+  while (chunkBounds.size() > 2) {
+    size_t nRuns = chunkBounds.size() - 1;
+    size_t nMerges = nRuns / 2;
+    parallelForChunks(0, nMerges, nMerges, [&](size_t, size_t begin, size_t end) {
+      for (size_t iM = begin; iM < end; iM++) {
+        std::inplace_merge(entries.begin() + chunkBounds[2 * iM], entries.begin() + chunkBounds[2 * iM + 1],
+                           entries.begin() + chunkBounds[2 * iM + 2]);
+      }
+    });
+    std::vector<size_t> newBounds;
+    for (size_t i = 0; i < chunkBounds.size(); i += 2) newBounds.push_back(chunkBounds[i]);
+    if (newBounds.back() != N) newBounds.push_back(N);
+    chunkBounds = newBounds;
+  }
+
+  // For each position, find the position of the first occurrence of its key
+  std::vector<size_t> firstOccurrence(N);
+  parallelForChunks(0, N, nChunks, [&](size_t, size_t begin, size_t end) {
+    // walk back to the start of the run which contains the first entry of this chunk (runs are short for mesh
+    // elements, so this is cheap)
+    size_t runStart = begin;
+    while (runStart > 0 && entries[runStart - 1].first == entries[begin].first) runStart--;
+    size_t leader = entries[runStart].second;
+    for (size_t s = begin; s < end; s++) {
+      if (s > runStart && !(entries[s - 1].first == entries[s].first)) {
+        runStart = s;
+        leader = entries[s].second;
+      }
+      firstOccurrence[entries[s].second] = leader;
+    }
+  });
+
+  // Number the first occurrences in input order, with a chunked prefix sum
+  std::vector<size_t> chunkCounts(nChunks + 1, 0);
+  parallelForChunks(0, N, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+    size_t count = 0;
+    for (size_t i = begin; i < end; i++) {
+      if (firstOccurrence[i] == i) count++;
+    }
+    chunkCounts[iChunk + 1] = count;
+  });
+  for (size_t iChunk = 0; iChunk < nChunks; iChunk++) {
+    chunkCounts[iChunk + 1] += chunkCounts[iChunk];
+  }
+  parallelForChunks(0, N, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+    size_t ind = chunkCounts[iChunk];
+    for (size_t i = begin; i < end; i++) {
+      if (firstOccurrence[i] == i) keyUniqueInd[i] = ind++;
+    }
+  });
+
+  // All other occurrences take the index of the first one
+  parallelFor(0, N, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (firstOccurrence[i] != i) keyUniqueInd[i] = keyUniqueInd[firstOccurrence[i]];
+    }
+  });
+
+  return chunkCounts[nChunks];
+}
+
+} // namespace polyscope
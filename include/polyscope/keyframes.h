@@ -0,0 +1,56 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/render/engine.h"
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace polyscope {
+
+// Frames of per-element data (positions or scalars) for playing back time-varying structures.
+//
+// All frames are uploaded once, to a 3D texture with one frame per layer. Programs fetch the two frames around the
+// structure's keyframe time in the vertex shader and blend them (see Structure::setKeyframeTime()), so playback only
+// changes uniforms. The host copy of the frames is released once the texture has been created.
+class KeyframeSeries {
+public:
+  KeyframeSeries(std::string name, const std::vector<std::vector<glm::vec3>>& frames);
+  KeyframeSeries(std::string name, const std::vector<std::vector<float>>& frames);
+
+  const std::string name;
+
+  size_t nFrames() const { return nFrames_; }
+  size_t nElements() const { return nElements_; }
+
+  // The texture holding all of the frames, created on first use
+  std::shared_ptr<render::TextureBuffer> getTexture();
+
+  // Over all frames, computed on construction. For positions, the bounding box; for scalars, the finite range.
+  std::tuple<glm::vec3, glm::vec3> boundingBox() const { return boundingBox_; }
+  std::pair<double, double> dataRange() const { return dataRange_; }
+
+private:
+  size_t nFrames_;
+  size_t nElements_;
+  size_t nComponents; // floats per element, 3 for positions, 1 for scalars
+  std::tuple<glm::vec3, glm::vec3> boundingBox_;
+  std::pair<double, double> dataRange_;
+
+  std::vector<float> data; // frame-major, padded to whole rows of the texture
+  std::shared_ptr<render::TextureBuffer> texture;
+
+  void packFrame(size_t iFrame, const float* frameData, size_t frameSize);
+};
+
+// The frames to blend for a time measured in frames, clamped to [0, nFrames-1], and the weight of the second one
+void keyframeInterval(float time, size_t nFrames, int& frameA, int& frameB, float& weight);
+
+// Append a keyframe rule, preceded by the shared declarations it needs if they are not in the list yet. Rules which
+// read the per-element keyframe index attribute `a_keyframeInd` also pull in its declaration.
+void addKeyframeRule(std::vector<std::string>& rules, std::string rule, bool withIndex = true);
+
+} // namespace polyscope
@@ -0,0 +1,31 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace polyscope {
+
+// A read-only memory mapping of a whole file, unmapped when destroyed. Views in to the file can hold a shared_ptr to
+// it as their lifetime token (see ManagedBuffer::setExternalView()). On platforms without mmap the file is read in to
+// memory instead.
+class MappedFile {
+public:
+  explicit MappedFile(const std::string& filename);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const unsigned char* data = nullptr;
+  size_t size = 0;
+
+private:
+#ifdef _WIN32
+  std::vector<unsigned char> contents;
+#endif
+};
+
+} // namespace polyscope
@@ -0,0 +1,55 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace polyscope {
+
+// Extract the isosurface at `isoval` from a scalar field on a regular grid of nx * ny * nz nodes, as a triangle mesh.
+//
+// Follows the conventions of MC::marching_cube() from the MarchingCubeCpp dependency, and produces the same
+// triangles: the value at node (x, y, z) is field[(x * ny + y) * nz + z], and vertex positions are in the same
+// (x, y, z) index coordinates. Vertices are shared between adjacent triangles, no normals are computed.
+//
+// The grid is split into slabs along x which are processed in parallel, vertices on the seams between slabs are
+// deduplicated.
+void marchingCubes(const float* field, float isoval, uint32_t nx, uint32_t ny, uint32_t nz,
+                   std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices);
+
+// Keeps the slabs of an extraction, so that after part of the field changes only the slabs touching the changed node
+// planes are extracted again, e.g. for VolumeGridNodeScalarQuantity::updateNodeScalarRegion().
+class MarchingCubesSlabCache {
+public:
+  // Same as marchingCubes(). All slabs are extracted again if the level or the dimensions changed.
+  void extract(const float* field, float isoval, uint32_t nx, uint32_t ny, uint32_t nz,
+               std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices);
+
+  // Mark everything as changed, or only the node planes [xBegin, xEnd)
+  void invalidate();
+  void invalidateNodePlanes(uint32_t xBegin, uint32_t xEnd);
+
+  // The number of slabs the last extract() had to process
+  size_t getLastExtractedSlabCount() const;
+
+  struct Slab {
+    uint32_t xBegin; // the cells [xBegin, xEnd) along x
+    uint32_t xEnd;
+    bool valid = false;
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices; // local vertex indices, or a key for a vertex on the seam with the previous slab
+    std::vector<uint32_t> topSeam; // local vertex index for each y/z edge of the last node plane, by seam edge key
+  };
+
+private:
+  std::vector<Slab> slabs;
+  glm::uvec3 dim{0, 0, 0};
+  float isoval = 0.;
+  size_t lastExtractedSlabCount = 0;
+};
+
+} // namespace polyscope
@@ -0,0 +1,37 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "glm/vec3.hpp"
+
+#include <array>
+#include <vector>
+
+namespace polyscope {
+
+// Render the scene from a set of related cameras at once, e.g. the six faces of a cubemap for a dome projection, or the
+// two eyes of a stereo pair for a headset preview. The per-frame work of draw() (lazy updates, callbacks, the GUI, ...)
+// is not repeated for each view, only the scene is rendered again, and reading back each image overlaps with rendering
+// the next ones. The current view is restored afterwards.
+//
+// Images are RGBA at 1 byte each, in the same layout as screenshotToBuffer().
+
+// The faces in the order +X, -X, +Y, -Y, +Z, -Z. Each is the image of a 90 degree camera at `center` looking along the
+// axis, with the up directions of the OpenGL cubemap convention (-Y for the X and Z faces, +Z for +Y, -Z for -Y).
+struct CubemapImages {
+  int faceSize = 0;
+  std::array<std::vector<unsigned char>, 6> faces;
+};
+CubemapImages renderCubemap(glm::vec3 center, int faceSize, bool transparentBG = true);
+
+// Two eyes offset from the current view along its right direction, with parallel axes. The frusta are shifted so that
+// points at the convergence distance appear at the same place in both images. The images have the size of the buffer.
+struct StereoImages {
+  int width = 0;
+  int height = 0;
+  std::vector<unsigned char> left;
+  std::vector<unsigned char> right;
+};
+StereoImages renderStereoPair(float eyeSeparation, float convergenceDistance, bool transparentBG = true);
+
+} // namespace polyscope
@@ -35,6 +35,17 @@ extern int maxFPS;
 // NOTE: some platforms may ignore the setting.
 extern bool enableVSync;
 
+// With vsync, wait to poll for input and draw each frame until just enough time is left to finish it before the next
+// vertical blank, rather than right after the previous one, which shortens the delay from input to display. The time
+// a frame takes is predicted from the recent frames, see frame_pacing.h. (default: false)
+extern bool latePollEvents;
+
+// When nothing has changed for a few frames, have show() block until there is input, a redraw is requested (from any
+// thread), or an update is queued, rather than building the GUI and polling for input every frame. It still wakes a
+// few times a second. Never idles while a user callback is set, since it expects to be called every frame, nor while a
+// camera flight, background callback, recording or remote session is running. (default: false)
+extern bool idleWhenUnchanged;
+
 // Read preferences (window size, etc) from startup file, write to same file on exit (default: true)
 extern bool usePrefsFile;
 
@@ -68,6 +79,12 @@ extern GroundPlaneHeightMode groundPlaneHeightMode;
 extern bool groundPlaneEnabled; // deprecated, but kept and respected for compatability. use groundPlaneMode.
 extern ScaledValue<float> groundPlaneHeightFactor;
 extern float groundPlaneHeight;
+
+// How the reflection of GroundPlaneMode::TileReflection is generated. Mirror renders the scene mirrored at half
+// resolution. ReducedMirror renders it at a quarter resolution and blurs it. ScreenSpace does not render the scene
+// again, but traces the reflection in a copy of the scene color and depth, so only what is on screen is reflected.
+// Default: Mirror.
+extern GroundReflectionMode groundReflectionMode;
 extern int shadowBlurIters;
 extern float shadowDarkness;
 
@@ -75,16 +92,40 @@ extern bool screenshotTransparency;     // controls whether screenshots taken by
                                         // transparent background
 extern std::string screenshotExtension; // sets the extension used for automatically-numbered screenshots (e.g. by
                                         // clicking the GUI button)
+extern ImageFormat screenshotFormat;    // the encoder for all screenshots, Auto picks it by file extension (.png uses a
+                                        // fast PNG encoder, ImageFormat::PNG compresses better but is much slower)
 
 // === Rendering parameters
 
 // SSAA scaling in pixel multiples
 extern int ssaaFactor;
 
+// Temporal anti-aliasing, an alternative to SSAA at roughly 1x cost per frame. Each scene render is shifted by a
+// sub-pixel jitter and blended with the reprojected result of previous frames. While the scene is still, renders
+// continue until the given number of jitter positions has been accumulated. Default: false, 16.
+extern bool temporalAntiAliasing;
+extern int temporalAntiAliasingSamples;
+
+// Fast approximate anti-aliasing of edges, applied as part of the pass which tonemaps the scene on to the screen rather
+// than as a pass of its own. Only used while the scene is rendered at the screen resolution (no SSAA). Default: false.
+extern bool fxaa;
+
+// Keep the memory used by full resolution render targets down, which matters for large displays with SSAA. The buffers
+// of transparency modes and temporal anti-aliasing are released as soon as the feature is turned off (rather than kept
+// for turning it back on), and the final scene buffer shares storage with the scene buffer unless depth peeling needs
+// both. Default: false.
+extern bool renderTargetBudget;
+
 // Transparency settings for the renderer
 extern TransparencyMode transparencyMode;
 extern int transparencyRenderPasses;
 
+// Draw the opaque structures twice per frame: first to depth only, then shaded against that depth, so each pixel is
+// lit (ray-primitive intersection aside) only by the surface which ends up visible. Pays off with heavy overdraw, e.g.
+// dense point clouds and curve networks drawn as spheres and cylinders. Only used by the single pass render modes (not
+// depth peeling or weighted transparency). Default: false.
+extern bool depthPrepass;
+
 // === Advanced ImGui configuration
 
 // If false, Polyscope will not create any ImGui UIs at all, but will still set up ImGui and invoke its render steps
@@ -120,6 +161,102 @@ extern std::function<void()> configureImGuiStyleCallback;
 extern std::function<std::tuple<ImFontAtlas*, ImFont*, ImFont*>()> prepareImGuiFontsCallback;
 
 
+// === Performance options
+
+// Number of threads used for parallel loops when processing large inputs, such as building mesh connectivity. The
+// calling thread counts as one, the rest are kept in a pool (see tasks.h, which can also hand the work to the host
+// application's thread pool). If <= 0 (the default), the number of hardware threads reported by the system is used.
+// Set to 1 to disable threading.
+extern int numThreads;
+
+// Skip drawing structures whose bounding boxes are entirely outside the view, or entirely on the sliced away side of an
+// active slice plane. Culling is conservative, structures which might draw outside their bounds (e.g. with vector
+// quantities enabled) are always drawn. Default: true.
+extern bool frustumCulling;
+// Answer pick::pickAtScreenCoords() by casting a ray against the structures on the CPU, rather than rendering the pick
+// buffer. Each structure builds a BVH over its elements the first time it is ray cast, which is refit when its positions
+// are updated. Falls back to the pick buffer if some enabled structure does not supportsRayCastPicking(), or if a slice
+// plane is active. Default: false.
+extern bool rayCastPicking;
+// Single pixel pick queries (pick::pickAtBufferCoords(), and the asynchronous hover picks) only render a tile of this
+// many pixels around the queried pixel to the pick buffer, rather than the whole buffer. The tile is reused by later
+// queries inside it while the scene is unchanged. Set to 0 to always render the whole buffer. Default: 32.
+extern int pickRegionOfInterestSize;
+// Keep a CPU copy of the scene depth buffer, downloaded asynchronously each time the scene is rendered, so that
+// view::screenCoordsToWorldPosition() (e.g. when zooming to the cursor) does not stall on the GPU. Only every n'th
+// pixel in each direction is kept. While no download is available, queries read the GPU directly. Default: true, 2.
+extern bool sceneDepthCache;
+extern int sceneDepthCacheStride;
+// Also skip structures (and surface mesh chunks) whose bounding boxes are entirely behind the depth of the previously
+// rendered frame, tested against a max-depth pyramid built from the scene depth cache, which is then kept at full
+// resolution. Only applies while the camera has not moved since that frame and without transparency. When a culled box
+// turns out to be visible in the depth of the frame it was culled from (e.g. because its occluder moved), the scene is
+// redrawn, so hidden geometry can appear a frame late. Requires sceneDepthCache. Default: false.
+extern bool occlusionCulling;
+
+// Draw vector quantities as instanced boxes expanded in the vertex shader, rather than with a geometry shader. This is
+// typically faster for dense vector fields, and allows them to be decimated with setVectorMinPixelSpacing(). Takes
+// effect as vector quantities are next drawn. Default: false.
+extern bool instancedVectors;
+
+// Pack the static per-vertex attributes of each program (positions, normals, barycentric coordinates, etc) in to one
+// interleaved buffer when it is first drawn, so the vertex fetch reads a single stream rather than one per attribute.
+// Helps on bandwidth-limited (e.g. integrated) GPUs, at the cost of a second copy of those attributes in GPU memory. A
+// program whose attributes are written after they were packed goes back to reading them separately. Only the OpenGL
+// backend interleaves. Default: false.
+extern bool interleaveVertexAttributes;
+// Place small, static attribute buffers (up to 64 KB) in ranges of a few large shared GPU buffers, rather than creating
+// a buffer object for each. With many small structures this saves a great deal of per-buffer driver overhead. Only
+// affects buffers allocated after it is changed. Only the OpenGL backend suballocates. Default: true.
+extern bool suballocateSmallBuffers;
+
+// Draw the enabled, opaque render images (depth, color, and scalar) which share a material together, in one
+// fullscreen pass per three images which keeps the nearest image at each pixel, rather than in a depth-tested pass
+// each. Default: true.
+extern bool compositeRenderImages;
+
+// If non-empty, linked shader program binaries are saved in this (existing) directory and reused by later runs, which
+// skips most of the shader compilation at startup. Entries are keyed on the program source and the GL driver, so stale
+// entries are simply ignored. Only effective if the driver supports program binaries. Default: "" (disabled).
+// The program variants requested are also recorded there, and polyscope::init() compiles them up front (from the
+// binaries, where possible), see render::Engine::prewarmShaderVariantTable(). Must be set before init().
+extern std::string shaderCacheDirectory;
+
+// If non-empty, data which is expensive to derive from the inputs of a structure (the edge indexing of surface meshes,
+// the interior faces and tets of volume meshes, isosurfaces of volume grids) is saved in this (existing) directory and
+// reused by later runs on the same data, see derived_data_cache.h. Entries are keyed on a hash of the input data, so
+// stale entries are simply ignored; the directory is never cleaned up automatically. Default: "" (disabled).
+extern std::string derivedDataCacheDirectory;
+
+// The GPU the headless EGL backend renders with, on machines with several. Either the index of a device listed by
+// listEGLDevices(), its UUID, or its PCI bus ID (e.g. "2", "5f1d0c2a-...", or "0000:3b:00.0"). Requires
+// EGL_EXT_device_enumeration. Default: "" (EGL's default display). Must be set before init().
+extern std::string eglDevice;
+
+// Compile shader programs in the background where the driver supports it (GL_KHR_parallel_shader_compile), rather than
+// stalling the frame which first needs them. Anything drawn with a program which is still compiling is skipped until
+// it is ready, including in screenshots, see render::Engine::shaderCompilesPending(). Default: false.
+extern bool asyncShaderCompilation;
+
+// While the camera is being moved, render the scene at reduced quality if needed to keep frames within the target time:
+// first without SSAA and with a single transparency peel, then at decreasing fractions of the window resolution. Full
+// quality is restored once the camera has been still for the restore delay, in seconds. See adaptive_quality.h.
+// Default: false, 33ms, 0.25s.
+extern bool adaptiveQuality;
+extern float adaptiveQualityTargetFrameMs;
+extern float adaptiveQualityRestoreDelay;
+
+// Scalar histograms are rebuilt lazily after their values change, at most once per period (in seconds) while they are
+// shown, and from an evenly strided sample of at most histogramMaxSamples values. Updates to a subset of the values
+// which stay in the histogram's range adjust the bins directly instead. Default: 0.25s, 2^20.
+extern float histogramRebuildPeriod;
+extern size_t histogramMaxSamples;
+
+// Keep the persistent settings (colors, enabled quantities, etc) of removed structures, such that a structure which is
+// registered again with the same name gets them back. Sessions which register and remove many differently-named
+// structures can set this to false, to forget the settings on removal so their cache does not grow. Default: true.
+extern bool rememberRemovedStructureSettings;
+
 // === Debug options
 
 // Enables optional error checks in the rendering system
@@ -128,5 +265,8 @@ extern bool enableRenderErrorChecks;
 // Render the pick buffer to screen rather than the regular scene
 extern bool debugDrawPickBuffer;
 
+// Time each part of the frame on the CPU and GPU (with timer queries), see getFrameStats(). Default: false.
+extern bool collectFrameStats;
+
 } // namespace options
 } // namespace polyscope
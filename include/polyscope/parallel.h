@@ -0,0 +1,59 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace polyscope {
+
+// Simple fork-join helpers for data-parallel loops over large arrays. Work is split into contiguous chunks, which are
+// run as jobs on the shared worker pool (see tasks.h), and the call returns once all chunks are done. Any exception
+// thrown by the work function is rethrown on the calling thread. Loops may be nested.
+//
+// These are only worthwhile for large inputs; small ranges are processed on the calling thread.
+
+// The number of threads to use for parallel loops, as controlled by options::numThreads. Always >= 1.
+size_t getNumThreads();
+
+// The number of chunks parallelFor() would split [0, count) into, given that each chunk should hold at least
+// minChunkSize items. Always >= 1.
+size_t parallelChunkCount(size_t count, size_t minChunkSize = 4096);
+
+// Split [start, end) into exactly nChunks contiguous chunks, and invoke func(iChunk, chunkBegin, chunkEnd) for each
+// in parallel. Chunks are a deterministic function of the range and nChunks, which lets callers store per-chunk
+// results and combine them afterwards (e.g. for a prefix sum).
+void parallelForChunks(size_t start, size_t end, size_t nChunks,
+                       const std::function<void(size_t iChunk, size_t chunkBegin, size_t chunkEnd)>& func);
+
+// Invoke func(chunkBegin, chunkEnd) over contiguous chunks covering [start, end), in parallel.
+void parallelFor(size_t start, size_t end, const std::function<void(size_t chunkBegin, size_t chunkEnd)>& func,
+                 size_t minChunkSize = 4096);
+
+// Split [start, end) in to tiles of at most tileSize items, and invoke func(tileBegin, tileEnd) for each tile on
+// nThreads threads (0 means getNumThreads()). Each thread takes the next unprocessed tile when it finishes one, which
+// balances the load when some tiles are much more expensive than others. Tiles are not processed in order.
+void parallelForTiles(size_t start, size_t end, size_t tileSize, size_t nThreads,
+                      const std::function<void(size_t tileBegin, size_t tileEnd)>& func);
+
+// Reduce [start, end) to a single value: chunkFunc(chunkBegin, chunkEnd) reduces each chunk, and the chunk values are
+// folded in chunk order with combine(accumulated, chunkValue), starting from init. The chunks only depend on the range
+// and the thread count, so e.g. a floating point sum is reproducible from run to run.
+template <typename T, typename ChunkFunc, typename CombineFunc>
+T parallelReduce(size_t start, size_t end, T init, ChunkFunc chunkFunc, CombineFunc combine,
+                 size_t minChunkSize = 4096) {
+  if (end <= start) return init;
+  size_t nChunks = parallelChunkCount(end - start, minChunkSize);
+  std::vector<T> chunkValues(nChunks, init);
+  parallelForChunks(start, end, nChunks, [&](size_t iChunk, size_t chunkBegin, size_t chunkEnd) {
+    chunkValues[iChunk] = chunkFunc(chunkBegin, chunkEnd);
+  });
+  T result = init;
+  for (const T& val : chunkValues) {
+    result = combine(result, val);
+  }
+  return result;
+}
+
+} // namespace polyscope
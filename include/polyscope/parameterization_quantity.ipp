@@ -209,6 +209,7 @@ void ParameterizationQuantity<QuantityT>::setParameterizationUniforms(render::Sh
     break;
   case ParamVizStyle::CHECKER_ISLANDS:
     p.setUniform("u_modDarkness", getAltDarkness());
+    p.setUniform("u_colormapRow", render::engine->getColorMapAtlasRow(cMap.get()));
     break;
   case ParamVizStyle::GRID:
     p.setUniform("u_gridLineColor", getGridColors().first);
@@ -218,6 +219,7 @@ void ParameterizationQuantity<QuantityT>::setParameterizationUniforms(render::Sh
   case ParamVizStyle::LOCAL_RAD:
     p.setUniform("u_angle", localRot);
     p.setUniform("u_modDarkness", getAltDarkness());
+    p.setUniform("u_colormapRow", render::engine->getColorMapAtlasRow(cMap.get()));
     break;
   }
 }
@@ -299,8 +301,7 @@ double ParameterizationQuantity<QuantityT>::getCheckerSize() {
 template <typename QuantityT>
 QuantityT* ParameterizationQuantity<QuantityT>::setColorMap(std::string name) {
   cMap = name;
-  quantity.refresh();
-  requestRedraw();
+  requestRedraw(); // the color map row is set with the other uniforms
   return &quantity;
 }
 template <typename QuantityT>
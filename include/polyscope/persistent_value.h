@@ -11,8 +11,11 @@
 #include "polyscope/render/materials.h"
 
 #include <iostream>
+#include <set>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace polyscope {
 
@@ -28,32 +31,151 @@ namespace polyscope {
 
 
 namespace detail {
-// Simple wrapper class holding the cache for persistent values
+// The global cache for persistent values of one type. Names are interned: each name gets a slot when the first value
+// with that name is created, and values keep their slot index, so they never hash their name again after construction.
+// Slots count the values holding them, such that the slot of a name which was cleared can be reused once no value
+// holds it.
 template <typename T>
 class PersistentCache {
 public:
-  std::unordered_map<std::string, T> cache;
+  // Get the slot for a name, creating it if needed, and count one more value holding it
+  size_t acquireSlot(const std::string& name) {
+    size_t slot;
+    auto it = slotIndex.find(name);
+    if (it != slotIndex.end()) {
+      slot = it->second;
+    } else {
+      if (freeSlots.empty()) {
+        slot = slots.size();
+        slots.emplace_back();
+      } else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+      }
+      slots[slot].name = name;
+      slotIndex.emplace(name, slot);
+    }
+    slots[slot].nHolders++;
+    return slot;
+  }
+
+  void releaseSlot(size_t slot) {
+    slots[slot].nHolders--;
+    if (slots[slot].nHolders == 0 && !slots[slot].hasValue) freeSlot(slot);
+  }
+
+  bool hasValue(size_t slot) const { return slots[slot].hasValue; }
+  const T& getValue(size_t slot) const { return slots[slot].value; }
+  const std::string& getName(size_t slot) const { return slots[slot].name; }
+  void setValue(size_t slot, const T& value) {
+    slots[slot].value = value;
+    slots[slot].hasValue = true;
+  }
+  void clearValue(size_t slot) {
+    slots[slot].value = T();
+    slots[slot].hasValue = false;
+  }
+
+  // Set a value by name, without holding the slot (e.g. when loading a scene file)
+  void setValue(const std::string& name, const T& value) {
+    size_t slot = acquireSlot(name);
+    setValue(slot, value);
+    releaseSlot(slot);
+  }
+
+  // Call f(name, value) for each name which has a cached value
+  template <typename F>
+  void forEachValue(F&& f) const {
+    for (const Slot& s : slots) {
+      if (s.hasValue) f(s.name, s.value);
+    }
+  }
+
+  // Forget the cached values of all names which start with the prefix
+  void clearPrefix(const std::string& prefix) {
+    std::vector<size_t> unheld;
+    for (const std::pair<const std::string, size_t>& entry : slotIndex) {
+      if (entry.first.compare(0, prefix.size(), prefix) != 0) continue;
+      clearValue(entry.second);
+      if (slots[entry.second].nHolders == 0) unheld.push_back(entry.second);
+    }
+    for (size_t slot : unheld) freeSlot(slot);
+  }
+
+  // Forget the cached values of all names which start with any of the prefixes. Costs one lookup per name and distinct
+  // prefix length, rather than one pass over all names per prefix.
+  void clearPrefixes(const std::unordered_set<std::string>& prefixes) {
+    std::set<size_t> prefixLengths;
+    for (const std::string& prefix : prefixes) prefixLengths.insert(prefix.size());
+    std::vector<size_t> unheld;
+    for (const std::pair<const std::string, size_t>& entry : slotIndex) {
+      bool matches = false;
+      for (size_t len : prefixLengths) {
+        if (len > entry.first.size()) break;
+        if (prefixes.find(entry.first.substr(0, len)) != prefixes.end()) {
+          matches = true;
+          break;
+        }
+      }
+      if (!matches) continue;
+      clearValue(entry.second);
+      if (slots[entry.second].nHolders == 0) unheld.push_back(entry.second);
+    }
+    for (size_t slot : unheld) freeSlot(slot);
+  }
+
+  // The cached value of a name, or nullptr if there is none. Does not create a slot.
+  const T* findValue(const std::string& name) const {
+    auto it = slotIndex.find(name);
+    if (it == slotIndex.end() || !slots[it->second].hasValue) return nullptr;
+    return &slots[it->second].value;
+  }
+
+  size_t nNames() const { return slotIndex.size(); }
+
+protected:
+  struct Slot {
+    std::string name;
+    T value = T();
+    bool hasValue = false;
+    size_t nHolders = 0;
+  };
+  std::vector<Slot> slots;
+  std::unordered_map<std::string, size_t> slotIndex;
+  std::vector<size_t> freeSlots;
+
+  void freeSlot(size_t slot) {
+    slotIndex.erase(slots[slot].name);
+    slots[slot].name.clear();
+    freeSlots.push_back(slot);
+  }
 };
 // Helper to get the global cache for a particular type of persistent value
 template <typename T>
 PersistentCache<T>& getPersistentCacheRef();
+
+// Forget the cached values of every type whose names start with the prefix, e.g. a Structure::uniquePrefix()
+void clearPersistentCaches(const std::string& prefix);
+void clearPersistentCaches(const std::unordered_set<std::string>& prefixes);
 } // namespace detail
 
 template <typename T>
 class PersistentValue {
 public:
   // Basic constructor, used on initial creation
-  PersistentValue(const std::string& name_, T value_) : name(name_), value(value_) {
-    if (detail::getPersistentCacheRef<T>().cache.find(name) != detail::getPersistentCacheRef<T>().cache.end()) {
-      value = detail::getPersistentCacheRef<T>().cache[name];
+  PersistentValue(const std::string& name_, T value_)
+      : slot(detail::getPersistentCacheRef<T>().acquireSlot(name_)), value(value_) {
+    detail::PersistentCache<T>& cache = detail::getPersistentCacheRef<T>();
+    if (cache.hasValue(slot)) {
+      value = cache.getValue(slot);
       holdsDefaultValue_ = false;
     } else {
       // Update cache value
-      detail::getPersistentCacheRef<T>().cache[name] = value;
+      cache.setValue(slot, value);
     }
   }
 
-  ~PersistentValue() {}
+  ~PersistentValue() { detail::getPersistentCacheRef<T>().releaseSlot(slot); }
 
   // Don't want copy or move constructors, only operators
   PersistentValue(const PersistentValue&) = delete;
@@ -90,14 +212,14 @@ public:
 
   // clears any cached value, but does not change the current value of the variable
   void clearCache() {
-    detail::getPersistentCacheRef<T>().cache.erase(name);
+    detail::getPersistentCacheRef<T>().clearValue(slot);
     holdsDefaultValue_ = true;
   }
 
   // Explicit setter, which takes care of storing in cache
   void set(T value_) {
     value = value_;
-    detail::getPersistentCacheRef<T>().cache[name] = value;
+    detail::getPersistentCacheRef<T>().setValue(slot, value);
     holdsDefaultValue_ = false;
   }
 
@@ -106,19 +228,20 @@ public:
   void setPassive(T value_) {
     if (holdsDefaultValue_) {
       value = value_;
-      detail::getPersistentCacheRef<T>().cache[name] = value;
+      detail::getPersistentCacheRef<T>().setValue(slot, value);
     }
   }
 
   bool holdsDefaultValue() const { return holdsDefaultValue_; }
+  const std::string& getName() const { return detail::getPersistentCacheRef<T>().getName(slot); }
 
   // Make all template variants friends, so conversion can access private members
   template <typename>
   friend class PersistentValue;
 
 protected:
-  // the name of the value
-  const std::string name;
+  // the name of the value, interned in the cache
+  const size_t slot;
 
   // the value
   T value;
@@ -130,18 +253,18 @@ protected:
 
 // clang-format off
 namespace detail {
-extern PersistentCache<double> persistentCache_double;
-extern PersistentCache<float> persistentCache_float;
-extern PersistentCache<bool> persistentCache_bool;
-extern PersistentCache<std::string> persistentCache_string;
-extern PersistentCache<glm::vec3> persistentCache_glmvec3;
-extern PersistentCache<glm::mat4> persistentCache_glmmat4;
-extern PersistentCache<ScaledValue<double>> persistentCache_scaleddouble;
-extern PersistentCache<ScaledValue<float>> persistentCache_scaledfloat;
-extern PersistentCache<std::vector<std::string>> persistentCache_vectorstring;
-extern PersistentCache<ParamVizStyle> persistentCache_paramVizStyle;
-extern PersistentCache<BackFacePolicy> persistentCache_BackFacePolicy;
-extern PersistentCache<MeshShadeStyle> persistentCache_MeshNormalType;
+extern PersistentCache<double>& persistentCache_double;
+extern PersistentCache<float>& persistentCache_float;
+extern PersistentCache<bool>& persistentCache_bool;
+extern PersistentCache<std::string>& persistentCache_string;
+extern PersistentCache<glm::vec3>& persistentCache_glmvec3;
+extern PersistentCache<glm::mat4>& persistentCache_glmmat4;
+extern PersistentCache<ScaledValue<double>>& persistentCache_scaleddouble;
+extern PersistentCache<ScaledValue<float>>& persistentCache_scaledfloat;
+extern PersistentCache<std::vector<std::string>>& persistentCache_vectorstring;
+extern PersistentCache<ParamVizStyle>& persistentCache_paramVizStyle;
+extern PersistentCache<BackFacePolicy>& persistentCache_BackFacePolicy;
+extern PersistentCache<MeshShadeStyle>& persistentCache_MeshNormalType;
 
 template<> inline PersistentCache<double>&                   getPersistentCacheRef<double>()                   { return persistentCache_double; }
 template<> inline PersistentCache<float>&                    getPersistentCacheRef<float>()                    { return persistentCache_float; }
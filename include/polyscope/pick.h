@@ -6,6 +6,7 @@
 
 #include <cstdint>
 #include <utility>
+#include <vector>
 
 namespace polyscope {
 namespace pick {
@@ -16,6 +17,13 @@ namespace pick {
 // Request 'count' contiguous indices for drawing a pick buffer. The return value is the start of the range.
 size_t requestPickBufferRange(Structure* requestingStructure, size_t count);
 
+// Give back the range held by a structure (if any), so it can be reused by later requests. Each structure holds at most
+// one range, requesting a new one releases the old one automatically.
+void releasePickBufferRange(Structure* structure);
+
+// Give back the ranges held by all structures at once, e.g. when they are all being removed
+void releaseAllPickBufferRanges();
+
 
 // == Main query
 // Get the structure which was clicked on (nullptr if none), and the pick ID in local indices for that structure (such
@@ -25,6 +33,49 @@ std::pair<Structure*, size_t> pickAtBufferCoords(int xPos, int yPos);     // tak
 std::pair<Structure*, size_t> evaluatePickQuery(int xPos, int yPos);      // old, badly named. takes buffer coordinates.
 
 
+// == Batched queries
+// Answer many queries with a single render of the pick pass, returning one result per query in the same order as the
+// input. Queries outside the buffer give {nullptr, 0}.
+std::vector<std::pair<Structure*, size_t>> pickAtBufferCoordsBatch(const std::vector<glm::ivec2>& bufferCoords);
+// Every pixel in the w x h rectangle whose top left corner is at buffer coordinates (x0, y0), row-major starting from
+// that corner. The rectangle is read back from the GPU in one call.
+std::vector<std::pair<Structure*, size_t>> pickRegion(int x0, int y0, int w, int h);
+
+
+// == Region selection
+// Every element drawn in a region of the buffer, each listed once, ordered by global pick index (so grouped by
+// structure). The pick pass is rendered once for the bounding rectangle of the region and read back in one call, and
+// the distinct indices are gathered in a single sweep over the pixels. The rectangle takes its top left corner and
+// size in buffer coordinates, the lasso a closed polygon in buffer coordinates (pixels whose centers are inside it, by
+// the even-odd rule).
+// With includeOccluded, the region is also rendered keeping the farthest fragment of each pixel, and with depth
+// testing off. This adds elements hidden behind the nearest ones, e.g. the far side of a closed mesh, though elements
+// which are neither the nearest, the farthest, nor the last drawn at any pixel are still missed.
+std::vector<std::pair<Structure*, size_t>> pickElementsInRect(int x0, int y0, int w, int h,
+                                                              bool includeOccluded = false);
+std::vector<std::pair<Structure*, size_t>> pickElementsInLasso(const std::vector<glm::vec2>& polygon,
+                                                               bool includeOccluded = false);
+
+
+// == Asynchronous query
+// Like the queries above, but without waiting on the GPU. The pick pass is rendered at most once per frame, and the
+// result becomes available on a later frame. Only the most recent request is kept, which makes it suitable for e.g.
+// requesting a hover pick every frame.
+void requestPickAtScreenCoordsAsync(glm::vec2 screenCoords);
+void requestPickAtBufferCoordsAsync(int xPos, int yPos);
+bool pollAsyncPickResult(std::pair<Structure*, size_t>& result); // true if a new result arrived since the last poll
+void processAsyncPickRequests(); // called once per frame by the main loop to issue and resolve async picks
+
+
+// The pick buffer is cached between queries, and only re-rendered when the scene changes (see getSceneGeneration()).
+// If you modify rendered data in a way which bypasses Polyscope's setters, call this to force a re-render.
+void invalidatePickBuffer();
+
+// Draw the pick pass to a color framebuffer, with each index shown as its packed color (see indToVec()). Used for
+// options::debugDrawPickBuffer, since the pick buffer itself holds integers which cannot be blitted to a color buffer.
+void drawPickBufferDebug(render::FrameBuffer* target);
+
+
 // == Stateful picking: track and update a current selection
 
 // Get/Set the "selected" item, if there is one (output has same meaning as evaluatePickQuery());
@@ -47,6 +98,9 @@ size_t localIndexToGlobal(std::pair<Structure*, size_t> localPick);
 inline glm::vec3 indToVec(uint64_t globalInd);
 inline uint64_t vecToInd(glm::vec3 vec);
 
+// Assemble an index from the two 32-bit words of the integer pick buffer, as written by the pick shaders
+inline uint64_t uint2ToInd(uint32_t low, uint32_t high);
+
 } // namespace pick
 } // namespace polyscope
 
@@ -48,5 +48,9 @@ inline uint64_t vecToInd(glm::vec3 vec) {
   return ind;
 }
 
+inline uint64_t uint2ToInd(uint32_t low, uint32_t high) {
+  return (static_cast<uint64_t>(high) << 32) | static_cast<uint64_t>(low);
+}
+
 } // namespace pick
 } // namespace polyscope
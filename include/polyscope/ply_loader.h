@@ -0,0 +1,34 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/point_cloud.h"
+#include "polyscope/surface_mesh.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace polyscope {
+
+// The contents of a PLY file, in the flat layout that SurfaceMesh stores its faces in. Faces are empty for files
+// without a face element, colors are empty for files without red/green/blue vertex properties.
+struct PLYMesh {
+  std::vector<glm::vec3> vertexPositions;
+  std::vector<glm::vec3> vertexColors;   // in [0,1]
+  std::vector<uint32_t> faceIndsEntries; // the vertex indices of all faces, concatenated
+  std::vector<uint32_t> faceIndsStart;   // face i is [faceIndsStart[i], faceIndsStart[i+1]) in faceIndsEntries
+};
+
+// Load a binary (little or big endian) PLY file. The file is memory-mapped and the vertex and face elements are
+// decoded on multiple threads, directly in to the flat face arrays, without building up a nested face list first.
+// Other elements and properties are skipped. ASCII PLY files are not supported, load those with a general purpose PLY
+// reader instead.
+PLYMesh loadPLY(std::string filename);
+
+// Load a PLY file with loadPLY() and register it as a surface mesh / a point cloud. Vertex colors, if present, are
+// added as a color quantity called "color".
+SurfaceMesh* registerSurfaceMeshPLY(std::string name, std::string filename);
+PointCloud* registerPointCloudPLY(std::string name, std::string filename);
+
+} // namespace polyscope
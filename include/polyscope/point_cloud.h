@@ -4,6 +4,7 @@
 
 #include "polyscope/affine_remapper.h"
 #include "polyscope/color_management.h"
+#include "polyscope/element_selection.h"
 #include "polyscope/persistent_value.h"
 #include "polyscope/point_cloud_quantity.h"
 #include "polyscope/polyscope.h"
@@ -18,6 +19,9 @@
 #include "polyscope/point_cloud_scalar_quantity.h"
 #include "polyscope/point_cloud_vector_quantity.h"
 
+#include <array>
+#include <future>
+#include <tuple>
 #include <vector>
 
 namespace polyscope {
@@ -53,14 +57,24 @@ public:
 
   // Standard structure overrides
   virtual void draw() override;
+  virtual void prepareDraw() override;
   virtual void drawDelayed() override;
   virtual void drawPick() override;
   virtual void updateObjectSpaceBounds() override;
+  virtual float getDrawBoundsPadding() override;
   virtual std::string typeName() override;
   virtual void refresh() override;
+  virtual bool supportsRayCastPicking() override;
+  virtual bool rayCastPick(glm::dvec3 rayStart, glm::vec3 rayDir, float& tHit, size_t& localPickInd) override;
+  virtual bool drawsSortedTransparency() override;
 
   // === Geometry members
   render::ManagedBuffer<glm::vec3> points;
+  render::ManagedBuffer<uint32_t> lodPointOrder; // multi-resolution order of the points, see setLODPointBudget()
+  render::ManagedBuffer<uint32_t> spatialPointOrder; // Morton order of the points, see setSpatialDrawOrder()
+  render::ManagedBuffer<uint32_t> depthPointOrder;   // back to front order of the points, see setTransparencySorting()
+  render::ManagedBuffer<uint32_t> voxelPreviewOrder; // voxel representatives, then all points by voxel, see below
+  render::ManagedBuffer<float> keyframeInds;     // the index of each point, for reading keyframe textures
 
   // === Quantities
 
@@ -68,6 +82,24 @@ public:
   template <class T>
   PointCloudScalarQuantity* addScalarQuantity(std::string name, const T& values, DataType type = DataType::STANDARD);
 
+  // The overloads taking a std::vector of the stored type by rvalue (here and below) move it in to the quantity rather
+  // than copying it, e.g. `cloud->addScalarQuantity("dist", std::move(distances))`.
+  PointCloudScalarQuantity* addScalarQuantity(std::string name, std::vector<float>&& values,
+                                              DataType type = DataType::STANDARD);
+
+  // Like addScalarQuantity(), but the values are read in place from `count` floats of externally-owned memory rather
+  // than copied. The memory must stay valid for as long as the quantity exists (or until it is updated); holding
+  // `lifetimeToken` is one way to ensure that, it is kept alive by the quantity.
+  PointCloudScalarQuantity* addScalarQuantityView(std::string name, const float* values, size_t count,
+                                                  std::shared_ptr<void> lifetimeToken = nullptr,
+                                                  DataType type = DataType::STANDARD);
+
+  // A scalar which varies over time, with a value for every point in each entry of `frames`. It is played back on the
+  // GPU along with the keyframes of the cloud, see Structure::setKeyframeTime().
+  template <class T>
+  PointCloudScalarQuantity* addScalarKeyframes(std::string name, const std::vector<T>& frames,
+                                               DataType type = DataType::STANDARD);
+
   // Parameterization
   template <class T>
   PointCloudParameterizationQuantity* addParameterizationQuantity(std::string name, const T& values,
@@ -79,11 +111,14 @@ public:
   // Colors
   template <class T>
   PointCloudColorQuantity* addColorQuantity(std::string name, const T& values);
+  PointCloudColorQuantity* addColorQuantity(std::string name, std::vector<glm::vec3>&& values);
 
   // Vectors
   template <class T>
   PointCloudVectorQuantity* addVectorQuantity(std::string name, const T& vectors,
                                               VectorType vectorType = VectorType::STANDARD);
+  PointCloudVectorQuantity* addVectorQuantity(std::string name, std::vector<glm::vec3>&& vectors,
+                                              VectorType vectorType = VectorType::STANDARD);
   template <class T>
   PointCloudVectorQuantity* addVectorQuantity2D(std::string name, const T& vectors,
                                                 VectorType vectorType = VectorType::STANDARD);
@@ -91,13 +126,45 @@ public:
   // === Mutate
   template <class V>
   void updatePointPositions(const V& newPositions);
+
+  // Set the positions of the points [begin, begin + newPositions.size()). Only those are uploaded, and the bounds are
+  // only rescanned if they may need to shrink.
+  template <class V>
+  void updatePointPositionsSubset(size_t begin, const V& newPositions);
+
+  // Like updatePointPositions(), but may be called from any thread. The positions are converted on the calling thread
+  // and swapped in by the render thread at the next sync point, see stageUpdate().
+  template <class V>
+  void stagePointPositions(const V& newPositions);
   template <class V>
   void updatePointPositions2D(const V& newPositions);
 
+  // Positions of every point in each entry of `frames`, for playing back a time-varying cloud. All frames are uploaded
+  // once and blended on the GPU, see Structure::setKeyframeTime(). The host positions in `points` are unchanged.
+  template <class V>
+  void setPointPositionKeyframes(const std::vector<V>& frames);
+
+  // === Incremental loading, see beginPointCloud()
+  // Add points to the end of the cloud. Only the new points are uploaded, and the bounds are widened to cover them.
+  // Quantities must be grown alongside, e.g. with PointCloudScalarQuantity::appendValues(), so that every quantity
+  // has one value per point by the next time the cloud is drawn.
+  template <class V>
+  void appendPoints(const V& newPoints);
+  void reservePoints(size_t count); // room for `count` points in total, so that appending does not reallocate
+  void finalizePoints();            // call once all points are added, recomputes the exact bounds and LOD order
+
+  // Replace the points with `newPoints`, which may have any count, e.g. for a simulation whose particles come and go.
+  // The cloud keeps its buffers, shaders and pick indices, reallocating only when it outgrows them. Quantities keep
+  // their old size: re-add (which replaces them) or remove any that are drawn, before the cloud is next drawn. Not
+  // allowed with position keyframes.
+  template <class V>
+  void replacePoints(const V& newPoints);
+
   // === Set point size from a scalar quantity
   // effect is multiplicative with pointRadius
   // negative values are always clamped to 0
   // if autoScale==true, values are rescaled such that the largest has size 1
+  // switching from one radius quantity to another only re-binds the new values, the programs are not rebuilt
   void setPointRadiusQuantity(PointCloudScalarQuantity* quantity, bool autoScale = true);
   void setPointRadiusQuantity(std::string name, bool autoScale = true);
   void clearPointRadiusQuantity();
@@ -105,6 +172,7 @@ public:
   // === Set transparency alpha from a scalar quantity
   // effect is multiplicative with other transparency values
   // values are clamped to [0,1]
+  // as for the radius, switching from one transparency quantity to another does not rebuild the programs
   void setTransparencyQuantity(PointCloudScalarQuantity* quantity);
   void setTransparencyQuantity(std::string name);
   void clearTransparencyQuantity();
@@ -140,10 +208,57 @@ public:
   PointCloud* setMaterial(std::string name);
   std::string getMaterial();
 
+  // Level of detail: draw at most this many points each frame, taken from a multi-resolution ordering so that the
+  // drawn points are spread evenly over the cloud. Fewer are drawn when the cloud covers few pixels on screen, and the
+  // drawn points are enlarged to cover about the same area. 0 (the default) always draws every point.
+  PointCloud* setLODPointBudget(size_t newBudget);
+  size_t getLODPointBudget();
+  size_t nLODPointsDrawn(); // as of the most recent draw
+
+  // Spatial draw order: draw the points sorted along a Morton curve through the cloud rather than in the order they
+  // were given (e.g. scan order), so that consecutive points land close together on screen. The order is computed from
+  // the positions on first use. Off by default. Only the draw order changes, quantities and picking still use the
+  // input order. Has no effect with a level of detail budget, whose order is already spatial.
+  PointCloud* setSpatialDrawOrder(bool newVal);
+  bool getSpatialDrawOrder();
+
+  // Transparency sorting: under weighted blended transparency, draw this cloud (while it is transparent) back to front
+  // in a single pass blended over the scene, rather than accumulating it with the other transparent structures. The
+  // points are sorted by depth on a background thread, and re-sorted whenever the view changes; while a sort runs the
+  // previous order is drawn, which is close for a slowly moving camera. Gives correct compositing among the points for
+  // the cost of a CPU sort, but only against opaque geometry: other transparent structures are blended before the cloud
+  // regardless of depth. Off by default. Has no effect in other transparency modes, with a level of detail budget, or
+  // with position keyframes.
+  PointCloud* setTransparencySorting(bool newVal);
+  bool getTransparencySorting();
+
+  // Voxel preview: bin the points in to a grid of cubes of side `newSize` (in the cloud's object space), and draw only
+  // the point nearest to the mean of each cube, for an interactive view of a huge cloud. Where the camera gets close
+  // enough that the cubes cover more than getVoxelPreviewRefinePixels() pixels each, every point in them is drawn
+  // instead, a block of nearby cubes at a time. The grid is built in parallel on first use, and again when the points
+  // are finalized or replaced. The preview is a subset of the same points, so quantities, picking and selection apply
+  // to it unchanged. 0 (the default) draws every point. Takes precedence over the level of detail budget.
+  PointCloud* setVoxelPreviewSize(float newSize);
+  float getVoxelPreviewSize();
+  PointCloud* setVoxelPreviewRefinePixels(float newVal);
+  float getVoxelPreviewRefinePixels();
+  size_t nVoxelPreviewVoxels();      // occupied cubes of the grid
+  size_t nVoxelPreviewPointsDrawn(); // as of the most recent draw
+
+  // Selection: points can be marked as selected, which tints them (and the quantities drawn on them) towards the
+  // selection color. The selection is created on first use and follows the number of points. Changing which points
+  // are selected only uploads the changed bits, see ElementSelection.
+  ElementSelection& getPointSelection();
+  bool hasPointSelection();
+  void removePointSelection();
+
   // Rendering helpers used by quantities
   void setPointCloudUniforms(render::ShaderProgram& p);
   void setPointProgramGeometryAttributes(render::ShaderProgram& p);
-  std::vector<std::string> addPointCloudRules(std::vector<std::string> initRules, bool withPointCloud = true);
+  void rebindPointProgramGeometryAttributes(); // on all existing programs, after the radius or transparency source swaps
+  void drawPointProgram(render::ShaderProgram& p); // draw p, restricted to the level-of-detail subset if enabled
+  std::vector<std::string> addPointCloudRules(std::vector<std::string> initRules, bool withPointCloud = true,
+                                              bool withShade = true);
   std::string getShaderNameForRenderMode();
 
   // === ~DANGER~ experimental/unsupported functions
@@ -152,31 +267,78 @@ public:
 private:
   // Storage for the managed buffers above. You should generally interact with this directly through them.
   std::vector<glm::vec3> pointsData;
+  std::vector<uint32_t> lodPointOrderData;
+  std::vector<uint32_t> spatialPointOrderData;
+  std::vector<uint32_t> depthPointOrderData;
+  std::vector<uint32_t> voxelPreviewOrderData;
+  std::vector<float> keyframeIndsData;
 
   // === Visualization parameters
   PersistentValue<std::string> pointRenderMode;
   PersistentValue<glm::vec3> pointColor;
   PersistentValue<ScaledValue<float>> pointRadius;
   PersistentValue<std::string> material;
+  PersistentValue<bool> transparencySorting;
+
+  // Level of detail
+  size_t lodPointBudget = 0;
+  size_t lodDrawCount = 0;   // leading entries of lodPointOrder drawn this frame
+  float lodRadiusScale = 1.; // enlarges the points to make up for the ones not drawn
+  void computeLODPointOrder();
+  void computeSpatialPointOrder();
+  bool spatialDrawOrder = false;
+
+  // Voxel preview. The cubes are grouped in blocks of consecutive cubes along the grid's Morton order, each block is
+  // drawn either as its representatives or as all of its points.
+  float voxelPreviewSize = 0.;
+  float voxelPreviewRefinePixels = 16.;
+  struct VoxelPreviewBlock {
+    size_t cellBegin, cellEnd;
+    std::tuple<glm::vec3, glm::vec3> bounds; // of all of the points in the cubes
+  };
+  std::vector<uint32_t> voxelPreviewCellStart; // the points of cube i start at nVoxels + voxelPreviewCellStart[i]
+  std::vector<VoxelPreviewBlock> voxelPreviewBlocks;
+  std::vector<std::array<size_t, 2>> voxelPreviewRanges; // of voxelPreviewOrder, drawn this frame
+  size_t voxelPreviewDrawCount = 0;
+  void computeVoxelPreviewOrder();
+  void updateVoxelPreviewRanges();
+
+  std::unique_ptr<ElementSelection> pointSelection;
+
+  // Transparency sorting
+  std::future<std::vector<uint32_t>> depthSort; // the background sort, if one is running
+  glm::mat4 depthSortView;                       // the view the running sort is for
+  glm::mat4 depthOrderView;                      // the view depthPointOrder is sorted for
+  void updateDepthPointOrder();                  // install a finished sort, start the next one if the view changed
+  void computeKeyframeInds();
+  void updateLODDrawCount();
+
+  // Incremental loading
+  void widenObjectSpaceBounds(const std::vector<glm::vec3>& newPoints);
+  void pointsReplaced(); // after replacePoints() sets the data
 
   // Drawing related things
   // if nullptr, prepare() (resp. preparePick()) needs to be called
   std::shared_ptr<render::ShaderProgram> program;
   std::shared_ptr<render::ShaderProgram> pickProgram;
+  size_t pickProgramCount = 0;  // the number of points pickProgram has colors for
+  size_t pickRangeStart = 0;    // our range of pick indices, may be larger than the cloud
+  size_t pickRangeCapacity = 0;
 
   // === Helpers
   // Do setup work related to drawing, including allocating openGL data
   void ensureRenderProgramPrepared();
   void ensurePickProgramPrepared();
+  void setPointCloudProgramUniforms(); // all uniforms of `program`
 
   // === Quantity adder implementations
-  PointCloudScalarQuantity* addScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
+  PointCloudScalarQuantity* addScalarQuantityImpl(std::string name, std::vector<float> data, DataType type);
   PointCloudParameterizationQuantity*
   addParameterizationQuantityImpl(std::string name, const std::vector<glm::vec2>& param, ParamCoordsType type);
   PointCloudParameterizationQuantity*
   addLocalParameterizationQuantityImpl(std::string name, const std::vector<glm::vec2>& param, ParamCoordsType type);
-  PointCloudColorQuantity* addColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors);
-  PointCloudVectorQuantity* addVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors,
+  PointCloudColorQuantity* addColorQuantityImpl(std::string name, std::vector<glm::vec3> colors);
+  PointCloudVectorQuantity* addVectorQuantityImpl(std::string name, std::vector<glm::vec3> vectors,
                                                   VectorType vectorType);
 
   // Manage varying point size
@@ -197,9 +359,15 @@ private:
 // Shorthand to add a point cloud to polyscope
 template <class T>
 PointCloud* registerPointCloud(std::string name, const T& points);
+PointCloud* registerPointCloud(std::string name, std::vector<glm::vec3>&& points); // moves the points in, no copy
 template <class T>
 PointCloud* registerPointCloud2D(std::string name, const T& points);
 
+// Register an empty point cloud to be filled in chunks with PointCloud::appendPoints(), e.g. while the points are read
+// from disk, then PointCloud::finalizePoints(). Room is reserved for `expectedCount` points. The cloud is drawn as it
+// grows, so it becomes visible while loading continues.
+PointCloud* beginPointCloud(std::string name, size_t expectedCount = 0);
+
 // Shorthand to get a point cloud from polyscope
 inline PointCloud* getPointCloud(std::string name = "");
 inline bool hasPointCloud(std::string name = "");
@@ -25,7 +25,7 @@ PointCloud* registerPointCloud2D(std::string name, const T& points) {
   for (auto& v : points3D) {
     v.z = 0.;
   }
-  PointCloud* s = new PointCloud(name, points3D);
+  PointCloud* s = new PointCloud(name, std::move(points3D));
   bool success = registerStructure(s);
   if (!success) {
     safeDelete(s);
@@ -38,6 +38,50 @@ void PointCloud::updatePointPositions(const V& newPositions) {
   validateSize(newPositions, nPoints(), "point cloud updated positions " + name);
   points.data = standardizeVectorArray<glm::vec3, 3>(newPositions);
   points.markHostBufferUpdated();
+  pickBVHNeedsRefit = true;
+  refitObjectSpaceBounds(points.data);
+}
+
+template <class V>
+void PointCloud::updatePointPositionsSubset(size_t begin, const V& newPositions) {
+  std::vector<glm::vec3> newData = standardizeVectorArray<glm::vec3, 3>(newPositions);
+  if (begin + newData.size() > nPoints()) {
+    exception("point cloud [" + name + "] position subset [" + std::to_string(begin) + ", " +
+              std::to_string(begin + newData.size()) + ") is out of range, there are " + std::to_string(nPoints()) +
+              " points");
+  }
+  points.ensureHostBufferPopulated();
+
+  // If a point being moved lies on the bounding box, the box may need to shrink, which takes a rescan of all points.
+  // Otherwise it only needs to grow to cover the new positions.
+  std::tuple<glm::vec3, glm::vec3> oldBounds = computePointBounds(points.data.data() + begin, newData.size());
+  bool mayShrink = options::automaticallyComputeSceneExtents &&
+                   (glm::any(glm::equal(std::get<0>(oldBounds), std::get<0>(objectSpaceBoundingBox))) ||
+                    glm::any(glm::equal(std::get<1>(oldBounds), std::get<1>(objectSpaceBoundingBox))));
+
+  std::copy(newData.begin(), newData.end(), points.data.begin() + begin);
+  points.markHostBufferRangeUpdated(begin, newData.size());
+  pickBVHNeedsRefit = true;
+
+  if (mayShrink) {
+    refitObjectSpaceBounds(points.data);
+  } else {
+    refitObjectSpaceBounds(computePointBounds(newData.data(), newData.size()), false);
+  }
+}
+
+template <class V>
+void PointCloud::stagePointPositions(const V& newPositions) {
+  std::vector<glm::vec3> staged = acquireStagingBuffer<glm::vec3>();
+  adaptorF_convertArrayOfVectorToStdVector<glm::vec3, 3, V>(newPositions, staged);
+  stageUpdate<glm::vec3>(uniquePrefix() + "points", getWeakHandle<PointCloud>(this), std::move(staged),
+                         [this](std::vector<glm::vec3>& data) {
+                           validateSize(data, nPoints(), "point cloud staged positions " + name);
+                           points.data.swap(data);
+                           points.markHostBufferUpdated();
+                           pickBVHNeedsRefit = true;
+                           refitObjectSpaceBounds(points.data);
+                         });
 }
 
 template <class V>
@@ -53,6 +97,37 @@ void PointCloud::updatePointPositions2D(const V& newPositions2D) {
 }
 
 
+template <class V>
+void PointCloud::appendPoints(const V& newPoints) {
+  if (hasPositionKeyframes()) {
+    exception("Cannot append points to point cloud [" + name + "], it has position keyframes");
+  }
+  std::vector<glm::vec3> newPoints3D = standardizeVectorArray<glm::vec3, 3>(newPoints);
+  widenObjectSpaceBounds(newPoints3D);
+  points.appendData(newPoints3D);
+  keyframeInds.recomputeIfPopulated();
+}
+
+template <class V>
+void PointCloud::replacePoints(const V& newPoints) {
+  if (hasPositionKeyframes()) {
+    exception("Cannot replace points of point cloud [" + name + "], it has position keyframes");
+  }
+  std::vector<glm::vec3> newPoints3D = standardizeVectorArray<glm::vec3, 3>(newPoints);
+  points.data.assign(newPoints3D.begin(), newPoints3D.end()); // keeps the capacity of the host buffer
+  pointsReplaced();
+}
+
+template <class V>
+void PointCloud::setPointPositionKeyframes(const std::vector<V>& frames) {
+  std::vector<std::vector<glm::vec3>> frames3D;
+  for (const V& frame : frames) {
+    frames3D.push_back(standardizeVectorArray<glm::vec3, 3>(frame));
+  }
+  setPositionKeyframeData(frames3D, nPoints());
+}
+
+
 // Shorthand to get a point cloud from polyscope
 inline PointCloud* getPointCloud(std::string name) {
   return dynamic_cast<PointCloud*>(getStructure(PointCloud::structureTypeName, name));
@@ -80,6 +155,23 @@ PointCloudScalarQuantity* PointCloud::addScalarQuantity(std::string name, const
   return addScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
 }
 
+template <class T>
+PointCloudScalarQuantity* PointCloud::addScalarKeyframes(std::string name, const std::vector<T>& frames,
+                                                         DataType type) {
+  if (frames.empty()) {
+    exception("point cloud scalar keyframes " + name + " must have at least one frame");
+  }
+  std::vector<std::vector<float>> framesData;
+  for (const T& frame : frames) {
+    validateSize(frame, nPoints(), "point cloud scalar keyframes " + name);
+    framesData.push_back(standardizeArray<float, T>(frame));
+  }
+
+  PointCloudScalarQuantity* q = addScalarQuantityImpl(name, framesData[0], type);
+  q->setValueKeyframes(framesData);
+  return q;
+}
+
 
 template <class T>
 PointCloudParameterizationQuantity* PointCloud::addParameterizationQuantity(std::string name, const T& param,
@@ -109,7 +201,7 @@ PointCloudVectorQuantity* PointCloud::addVectorQuantity2D(std::string name, cons
     v.z = 0.;
   }
 
-  return addVectorQuantityImpl(name, vectors3D, vectorType);
+  return addVectorQuantityImpl(name, std::move(vectors3D), vectorType);
 }
 
 
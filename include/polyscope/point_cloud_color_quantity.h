@@ -14,12 +14,13 @@ namespace polyscope {
 
 class PointCloudColorQuantity : public PointCloudQuantity, public ColorQuantity<PointCloudColorQuantity> {
 public:
-  PointCloudColorQuantity(std::string name, const std::vector<glm::vec3>& values, PointCloud& pointCloud_);
+  PointCloudColorQuantity(std::string name, std::vector<glm::vec3> values, PointCloud& pointCloud_);
 
   virtual void draw() override;
 
   virtual void buildPickUI(size_t ind) override;
   virtual void refresh() override;
+  virtual void rebindPointProgramGeometryAttributes() override;
 
   virtual std::string niceName() override;
 
@@ -20,6 +20,7 @@ public:
   virtual void buildCustomUI() override;
   virtual void buildPickUI(size_t ind) override;
   virtual void refresh() override;
+  virtual void rebindPointProgramGeometryAttributes() override;
   virtual std::string niceName() override;
 
 
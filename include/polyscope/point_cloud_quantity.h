@@ -18,6 +18,10 @@ public:
 
   // Build GUI info about a point
   virtual void buildInfoGUI(size_t pointInd);
+
+  // Re-bind the point cloud's geometry attributes on any programs this quantity has created, after the buffers they
+  // come from have been swapped, see PointCloud::rebindPointProgramGeometryAttributes()
+  virtual void rebindPointProgramGeometryAttributes();
 };
 
 
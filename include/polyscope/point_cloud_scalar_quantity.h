@@ -15,14 +15,14 @@ namespace polyscope {
 class PointCloudScalarQuantity : public PointCloudQuantity, public ScalarQuantity<PointCloudScalarQuantity> {
 
 public:
-  PointCloudScalarQuantity(std::string name, const std::vector<float>& values, PointCloud& pointCloud_,
-                           DataType dataType);
+  PointCloudScalarQuantity(std::string name, std::vector<float> values, PointCloud& pointCloud_, DataType dataType);
 
   virtual void draw() override;
   virtual void buildCustomUI() override;
 
   virtual void buildPickUI(size_t ind) override;
   virtual void refresh() override;
+  virtual void rebindPointProgramGeometryAttributes() override;
 
   virtual std::string niceName() override;
 
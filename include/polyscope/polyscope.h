@@ -11,14 +11,19 @@
 #include "imgui.h"
 
 #include "polyscope/context.h"
+#include "polyscope/frame_stats.h"
 #include "polyscope/group.h"
 #include "polyscope/internal.h"
 #include "polyscope/messages.h"
+#include "polyscope/multiview.h"
 #include "polyscope/options.h"
+#include "polyscope/recorder.h"
+#include "polyscope/remote.h"
 #include "polyscope/screenshot.h"
 #include "polyscope/slice_plane.h"
 #include "polyscope/structure.h"
 #include "polyscope/transformation_gizmo.h"
+#include "polyscope/update_queue.h"
 #include "polyscope/utilities.h"
 #include "polyscope/weak_handle.h"
 #include "polyscope/widget.h"
@@ -40,6 +45,11 @@ class Widget;
 // The backend string sets which rendering backend to use. If "", a reasonable default backend will be chosen.
 void init(std::string backend = "");
 
+// The GPUs the headless EGL backend can render with, see options::eglDevice. One line per device, starting with its
+// index, followed by whichever of its name, UUID and PCI bus ID the driver reports. Empty if the EGL backend is not
+// built or cannot enumerate devices. May be called before init().
+std::vector<std::string> listEGLDevices();
+
 // Check that polyscope has been initialized. If not, an exception is thrown to prevent further problems.
 void checkInitialized();
 
@@ -120,6 +130,10 @@ extern Context globalContext;
 // only using a single structure.
 Structure* getStructure(std::string type, std::string name = "");
 
+// Look up a structure by its handle (see Structure::getHandle()) in constant time. Returns nullptr if the structure has
+// been removed.
+Structure* getStructure(StructureHandle handle);
+
 // True if such a structure exists
 bool hasStructure(std::string type, std::string name = "");
 
@@ -134,6 +148,12 @@ void removeAllStructures();
 // Recompute the global state::lengthScale, boundingBox, and center by looping over registered structures
 void updateStructureExtents();
 
+// Registering or removing a structure recomputes the scene extents, which loops over all structures. When registering
+// or removing many structures at once, wrap them in a batch to do that only once, when the batch ends. Batches may be
+// nested, the deferred work happens when the outermost one ends.
+void beginStructureBatch();
+void endStructureBatch();
+
 // Group management
 Group* createGroup(std::string name);
 Group* getGroup(std::string name);
@@ -145,6 +165,10 @@ void removeAllGroups();
 // quantities
 void refresh();
 
+// Regenerates only the shader programs of all structures and quantities, keeping derived data such as normals or
+// isosurfaces. Used when global shader rules change, e.g. the transparency mode or the first slice plane being added.
+void refreshShaderPrograms();
+
 // === Handle draw flow, interrupts, and popups
 
 // Main draw call, which handles all 3D rendering & UI management.
@@ -157,6 +181,10 @@ void requestRedraw();
 // Has a redraw been requested for the next frame?
 bool redrawRequested();
 
+// A counter which is incremented by every call to requestRedraw(), i.e. whenever the scene, the view, or any rendered
+// data changes. Can be used to tell whether data derived from the rendered scene is still valid.
+uint64_t getSceneGeneration();
+
 // Managed a stack of of contexts to draw the UI. Usually contains one entry, which causes the main GUI to be drawn, but
 // in general the top callback will be called instead. Primarily exists to manage the ImGUI context, so callbacks can
 // create other contexts and circumvent the main draw loop. This is used internally to implement messages, element
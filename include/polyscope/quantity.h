@@ -44,12 +44,17 @@ public:
 
   // Re-perform any setup work for the quantity, including regenerating shader programs.
   virtual void refresh();
+  virtual void refreshShaderPrograms(); // only regenerate the programs, by default it is refresh()
 
   // A decorated name for the quantity that will be used in headers. For instance, for surface scalar named "value" we
   // return "value (scalar)"
   virtual std::string niceName();
   std::string uniquePrefix();
 
+  // Is everything this quantity draws contained in the parent's padded bounding box? If not, the parent structure is
+  // never frustum-culled while the quantity is enabled.
+  virtual bool drawsWithinStructureBounds();
+
   // === Member variables ===
   Structure& parent;      // the parent structure with which this quantity is associated
   const std::string name; // a name for this quantity, which must be unique amongst quantities on `parent`
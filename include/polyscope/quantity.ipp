@@ -33,6 +33,7 @@ QuantityS<S>* QuantityS<S>::setEnabled(bool newEnabled) {
   if (newEnabled == enabled.get()) return this;
 
   enabled = newEnabled;
+  parent.markEnabledQuantitiesStale();
 
   // Dominating quantities need to update themselves as their parent's dominating quantity
   if (dominates) {
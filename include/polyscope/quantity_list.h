@@ -0,0 +1,81 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace polyscope {
+
+// The quantities of a structure, owned and stored contiguously in name order, with a hash index from names to their
+// positions on the side. Iteration visits (name, pointer) pairs in the same order as the std::map this replaced, so
+// code written against the map keeps working. Lookups by name take constant time; adding or removing a quantity is
+// linear in the number of quantities, which only happens when the user changes them.
+template <typename T>
+class QuantityList {
+public:
+  typedef std::pair<std::string, std::unique_ptr<T>> Entry;
+  typedef typename std::vector<Entry>::iterator iterator;
+  typedef typename std::vector<Entry>::const_iterator const_iterator;
+
+  iterator begin() { return entries.begin(); }
+  iterator end() { return entries.end(); }
+  const_iterator begin() const { return entries.begin(); }
+  const_iterator end() const { return entries.end(); }
+  size_t size() const { return entries.size(); }
+  bool empty() const { return entries.empty(); }
+
+  // The entry with this name, or end()
+  iterator find(const std::string& name) {
+    auto it = index.find(name);
+    return it == index.end() ? entries.end() : entries.begin() + it->second;
+  }
+
+  // The quantity with this name, or nullptr
+  T* get(const std::string& name) const {
+    auto it = index.find(name);
+    return it == index.end() ? nullptr : entries[it->second].second.get();
+  }
+
+  // The slot for this name, which is added holding nullptr if absent (like std::map::operator[])
+  std::unique_ptr<T>& operator[](const std::string& name) {
+    auto it = index.find(name);
+    if (it != index.end()) return entries[it->second].second;
+
+    size_t pos = std::lower_bound(entries.begin(), entries.end(), name,
+                                  [](const Entry& e, const std::string& n) { return e.first < n; }) -
+                 entries.begin();
+    entries.insert(entries.begin() + pos, Entry(name, std::unique_ptr<T>()));
+    reindexFrom(pos);
+    return entries[pos].second;
+  }
+
+  // Remove (and delete) the quantity with this name, if there is one
+  void erase(const std::string& name) {
+    auto it = index.find(name);
+    if (it == index.end()) return;
+    size_t pos = it->second;
+    index.erase(it);
+    entries.erase(entries.begin() + pos);
+    reindexFrom(pos);
+  }
+
+  void clear() {
+    entries.clear();
+    index.clear();
+  }
+
+private:
+  std::vector<Entry> entries;
+  std::unordered_map<std::string, size_t> index;
+
+  void reindexFrom(size_t pos) {
+    for (size_t i = pos; i < entries.size(); i++) index[entries[i].first] = i;
+  }
+};
+
+} // namespace polyscope
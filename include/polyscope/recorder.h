@@ -0,0 +1,26 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/types.h"
+
+#include <string>
+
+namespace polyscope {
+
+// Record every frame drawn by the main loop to a video, e.g. while a camera flight from view::startFlightTo() plays.
+//
+// While recording, the UI clock which drives flights and other animations advances by exactly 1/fps each frame, so the
+// video plays back at the right speed no matter how long frames take to render. Frames hold the scene without the GUI.
+// They are read back asynchronously into pooled buffers, and converted and written by a background thread.
+//
+// `path` is the output file. For RecordingFormat::FFmpeg, an `ffmpeg` executable must be on the PATH, and it picks
+// the container and codec from the extension of `path`.
+void startRecording(std::string path, float fps = 30., RecordingFormat format = RecordingFormat::Y4M);
+void stopRecording(); // waits until all frames have been written
+bool isRecording();
+
+// Capture the frame which was just drawn, called by the main loop
+void processRecording();
+
+} // namespace polyscope
@@ -0,0 +1,90 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace polyscope {
+
+// Stream the window to a viewer on another machine, e.g. from a headless GPU server using the EGL backend to a browser
+// on a laptop, and take the viewer's mouse and keyboard input in return.
+//
+// Polyscope does not include a network server. The application carries messages between Polyscope and the viewer over
+// a transport of its choice, typically a WebSocket: frames are handed to the `send` callback, and messages from the
+// viewer are passed to receiveRemoteMessage().
+//
+// Frames are captured after the GUI is drawn and split into square tiles. Only the tiles which changed since the
+// previous frame are JPEG-encoded and sent. Encoding happens on a background thread, which is also the thread `send` is
+// called from. The viewer acknowledges every frame it shows, and the time from capturing a frame to its acknowledgment
+// drives the stream: above the target latency the JPEG quality is lowered, and then the resolution, and with headroom
+// they are raised again in the opposite order. A frame is only captured while fewer than `maxFramesInFlight` are
+// unacknowledged, so a slow link drops frames instead of building up a queue.
+//
+// Messages, all integers little-endian:
+//
+//   frame, to the viewer:
+//     "PSRF", u32 frameId, u16 width, u16 height (of the window), u16 encodedWidth, u16 encodedHeight, u16 tileSize,
+//     u16 nTiles, then for each tile: u16 tileX, u16 tileY (counted in tiles from the top left), u32 nBytes, JPEG data
+//   Tiles cover encoded pixels, the last ones in a row or column may be smaller. Tiles missing from a frame are
+//   unchanged from the previous one. The first frame, and the first after the encoded size changes, hold every tile.
+//
+//   input, from the viewer: "PSRI", u8 type (a RemoteInputType), then by type:
+//     FrameAck:    u32 frameId
+//     MouseMove:   f32 x, f32 y (the position in the frame in [0,1], from the top left)
+//     MouseButton: u8 button (0 left, 1 right, 2 middle), u8 down
+//     Scroll:      f32 dx, f32 dy
+//     Key:         u16 key (an ImGuiKey), u8 down
+//     Text:        u32 character (a unicode code point)
+//     Resize:      u16 width, u16 height (the size the viewer would like the window to have)
+
+struct RemoteSessionSettings {
+  double targetLatencyMs = 80.; // from capturing a frame to its acknowledgment
+  int tileSize = 64;
+  int maxFramesInFlight = 2;
+  int minQuality = 30; // JPEG quality, 1-100
+  int maxQuality = 85;
+  float minResolutionScale = 0.25; // of the window size
+};
+
+struct RemoteInputEvent {
+  RemoteInputType type = RemoteInputType::FrameAck;
+  uint32_t value = 0;        // FrameAck: the frame id, MouseButton: the button, Key: the ImGuiKey, Text: the character
+  bool down = false;         // MouseButton, Key
+  float x = 0.f, y = 0.f;    // MouseMove: the position in [0,1] from the top left, Scroll: the offsets
+  int width = 0, height = 0; // Resize
+};
+
+struct RemoteSessionStats {
+  size_t framesSent = 0;
+  size_t framesUnchanged = 0; // captured, but not sent since no tile changed
+  size_t framesSkipped = 0;   // not captured because too many frames were unacknowledged
+  size_t bytesSent = 0;
+  double latencyMs = 0.; // smoothed, from capture to acknowledgment
+  int quality = 0;
+  float resolutionScale = 1.f;
+};
+
+void startRemoteSession(std::function<void(const std::vector<unsigned char>& message)> send,
+                        RemoteSessionSettings settings = RemoteSessionSettings());
+void stopRemoteSession(); // waits until the frames already captured have been sent
+bool isRemoteSessionActive();
+RemoteSessionStats getRemoteSessionStats();
+
+// The next frame holds every tile, e.g. after a viewer (re)connects
+void requestRemoteKeyframe();
+
+// Input from the viewer. Both may be called from any thread, the events are applied at the start of the next frame.
+// receiveRemoteMessage() returns false if the message is malformed.
+bool receiveRemoteMessage(const unsigned char* data, size_t nBytes);
+void pushRemoteInputEvent(const RemoteInputEvent& event);
+
+// Called by the main loop
+void processRemoteInput(); // before the frame's input is processed
+void processRemoteFrame(); // after the frame, including the GUI, has been drawn
+
+} // namespace polyscope
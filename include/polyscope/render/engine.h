@@ -4,6 +4,8 @@
 
 #include <array>
 #include <cstdint>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -37,8 +39,24 @@ enum class DrawMode {
 };
 
 enum class FilterMode { Nearest = 0, Linear };
-enum class TextureFormat { RGB8 = 0, RGBA8, RG16F, RGB16F, RGBA16F, RGBA32F, RGB32F, R32F, R16F, DEPTH24 };
-enum class RenderBufferType { Color, ColorAlpha, Depth, Float4 };
+// The integer formats (RGB8, RGBA8, R8, R16, RGBA16) are normalized: shaders sample them as floats in [0,1]
+enum class TextureFormat {
+  RGB8 = 0,
+  RGBA8,
+  RG16F,
+  RGB16F,
+  RGBA16F,
+  RGBA32F,
+  RGB32F,
+  R32F,
+  R16F,
+  DEPTH24,
+  RGB9E5,
+  R8,
+  R16,
+  RGBA16,
+};
+enum class RenderBufferType { Color, ColorAlpha, Depth, Float4, UInt2 };
 enum class DepthMode { Less, LEqual, LEqualReadOnly, Greater, Disable, PassReadOnly };
 enum class BlendMode { AlphaOver, OverNoWrite, AlphaUnder, Zero, WeightedAdd, Add, Source, Disable };
 enum class RenderDataType {
@@ -55,18 +73,50 @@ enum class RenderDataType {
 };
 
 enum class DeviceBufferType { Attribute, Texture1d, Texture2d, Texture3d };
+enum class BufferUpdateFrequency { Static = 0, Streaming }; // Streaming: contents get replaced ~every frame
+enum class HostResidency { Keep = 0, DropAfterUpload };     // see ManagedBuffer::setHostResidency()
+
+// How float attributes are stored on the device. The compact formats are expanded back to floats by the vertex fetch,
+// so shaders see the same types. They cost precision, and UNorm8 clamps values to [0,1], SNorm16 to [-1,1].
+enum class AttributeStorageFormat { Float32 = 0, Float16, UNorm8, SNorm16 };
+
+// Component type of raw pixels uploaded with TextureBuffer::setDataRect(). The integer types are normalized to [0,1]
+// by the backend as they are uploaded, so e.g. 8-bit camera frames need no conversion on the host.
+enum class PixelComponentType { Float32 = 0, UNorm8, UNorm16 };
 
 int dimension(const TextureFormat& x);
 int sizeInBytes(const TextureFormat& f);
+int sizeInBytes(const PixelComponentType& t);
 std::string modeName(const TransparencyMode& m);
 std::string renderDataTypeName(const RenderDataType& r);
 int sizeInBytes(const RenderDataType& r);
 int renderDataTypeCountCompatbility(const RenderDataType r1, const RenderDataType r2);
+std::string attributeStorageFormatName(const AttributeStorageFormat& f);
+
+// Size of one entry of a float type held in a storage format. Compact 3-vectors are padded to 4 components, which keeps
+// the entries 4-byte aligned.
+int storageSizeInBytes(const RenderDataType& r, const AttributeStorageFormat& f);
+
+// Convert nEntries tightly-packed float entries of type r to the device layout of format f, and back
+void packAttributeData(const RenderDataType& r, const AttributeStorageFormat& f, const float* values, size_t nEntries,
+                       std::vector<unsigned char>& bytesOut);
+void unpackAttributeData(const RenderDataType& r, const AttributeStorageFormat& f, const unsigned char* bytes,
+                         size_t nEntries, float* valuesOut);
 std::string getImageOriginRule(ImageOrigin imageOrigin);
 std::string deviceBufferTypeName(const DeviceBufferType& d);
 
 namespace render {
 
+// Bytes of device memory currently allocated by all buffers of each kind. Sizes are computed from the dimensions and
+// formats of the allocations, drivers may round them up.
+struct DeviceMemoryUsage {
+  size_t attributeBytes = 0;
+  size_t textureBytes = 0;
+  size_t renderBufferBytes = 0;
+  size_t totalBytes() const { return attributeBytes + textureBytes + renderBufferBytes; }
+};
+const DeviceMemoryUsage& getDeviceMemoryUsage();
+
 class AttributeBuffer {
 public:
   AttributeBuffer(RenderDataType dataType_, int arrayCount);
@@ -91,15 +141,61 @@ public:
   virtual void setData(const std::vector<std::array<glm::vec3, 3>>& data) = 0;
   virtual void setData(const std::vector<std::array<glm::vec3, 4>>& data) = 0;
 
+  // Fill the buffer from raw memory holding nElements entries, laid out exactly as this buffer's type and array count
+  // (so e.g. floats, not doubles, for a Float buffer). Used to upload from memory we do not own without a copy.
+  virtual void setDataFromPointer(const void* data, size_t nElements) = 0;
+
+  // Update a sub-range of an already-filled buffer, writing data[dataStart, dataStart+count) to the buffer entries
+  // [bufferStart, bufferStart+count). The buffer is never resized, the range must lie within the current data size.
+  // clang-format off
+  virtual void setDataRange(const std::vector<glm::vec2>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  virtual void setDataRange(const std::vector<glm::vec3>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  virtual void setDataRange(const std::vector<glm::vec4>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  virtual void setDataRange(const std::vector<float>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  virtual void setDataRange(const std::vector<double>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  virtual void setDataRange(const std::vector<int32_t>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  virtual void setDataRange(const std::vector<uint32_t>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  virtual void setDataRange(const std::vector<glm::uvec2>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  virtual void setDataRange(const std::vector<glm::uvec3>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  virtual void setDataRange(const std::vector<glm::uvec4>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  virtual void setDataRange(const std::vector<std::array<glm::vec3, 2>>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  virtual void setDataRange(const std::vector<std::array<glm::vec3, 3>>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  virtual void setDataRange(const std::vector<std::array<glm::vec3, 4>>& data, size_t dataStart, size_t bufferStart, size_t count) = 0;
+  // clang-format on
+
+  // Change the data size to newSize entries, keeping the contents of the entries which remain, so that e.g. appended
+  // entries can be filled with setDataRange() without re-uploading the existing ones. New entries are uninitialized.
+  // The allocation grows geometrically, so repeated appends only occasionally reallocate.
+  virtual void resizePreservingData(size_t newSize) = 0;
+
+  // Allocate room for at least `capacity` entries, without changing the data size
+  virtual void reserve(size_t capacity) = 0;
+
   virtual uint32_t getNativeBufferID() = 0; // used to interop with external things, e.g. ImGui
 
   // == Getters
   RenderDataType getType() const { return dataType; }
   int getArrayCount() const { return arrayCount; }
   int64_t getDataSize() const { return dataSize; }
-  int64_t getDataSizeInBytes() const { return dataSize * sizeInBytes(dataType) * getArrayCount(); }
+  int64_t getDataSizeInBytes() const { return dataSize * getStorageElementBytes(); }
+  size_t getStorageElementBytes() const; // device bytes per element, including all array entries
   uint64_t getUniqueID() const { return uniqueID; }
   bool isSet() const { return setFlag; }
+  size_t getDeviceMemoryBytes() const { return deviceMemoryBytes; } // allocated size, may exceed the data size
+
+  // Changes whenever the contents are written by the backend: filled, updated in a range, resized, or written on the
+  // device. Lets copies of the contents detect that they are stale. Writes through getNativeBufferID() are not seen.
+  uint64_t getContentVersion() const { return contentVersion; }
+
+  // Hint to the backend about how often the contents are replaced, so it can pick an upload strategy which does not
+  // stall on draws that are still using the old contents.
+  void setUpdateFrequency(BufferUpdateFrequency newFreq) { updateFrequency = newFreq; }
+  BufferUpdateFrequency getUpdateFrequency() const { return updateFrequency; }
+
+  // Store the data in a compact format, see AttributeStorageFormat. Only for float types, and must be set before the
+  // buffer is first filled. Values are converted as they are uploaded, and getData_*() returns the converted values.
+  void setStorageFormat(AttributeStorageFormat newFormat);
+  AttributeStorageFormat getStorageFormat() const { return storageFormat; }
 
   // get data at a single index from the buffer
   virtual float getData_float(size_t ind) = 0;
@@ -125,6 +221,11 @@ public:
   virtual std::vector<glm::uvec3> getDataRange_uvec3(size_t ind, size_t count) = 0;
   virtual std::vector<glm::uvec4> getDataRange_uvec4(size_t ind, size_t count) = 0;
 
+  // Start copying the contents back to the host without waiting for the GPU. The getData*() functions then read from
+  // the copy, rather than stalling until the device is done with the buffer, until the contents next change. Backends
+  // which read synchronously anyway may ignore this.
+  virtual void requestDataCopy() {}
+
 protected:
   RenderDataType dataType;
   int arrayCount;
@@ -133,6 +234,13 @@ protected:
                            // this counts # elements of the specified type, s.t. array'd mulitpliers are still just one
   uint64_t bufferSize = 0; // the size of the allocated buffer (which might be larger than the data sixze)
   uint64_t uniqueID;
+  uint64_t contentVersion = 0; // backends increment on every write
+  BufferUpdateFrequency updateFrequency = BufferUpdateFrequency::Static;
+  AttributeStorageFormat storageFormat = AttributeStorageFormat::Float32;
+
+  // Backends call this whenever they (re)allocate the device storage, to keep getDeviceMemoryUsage() up to date
+  void setDeviceMemoryBytes(size_t newBytes);
+  size_t deviceMemoryBytes = 0;
 };
 
 class TextureBuffer {
@@ -169,6 +277,27 @@ public:
   virtual void setData(const std::vector<std::array<glm::vec3, 3>>& data) = 0;
   virtual void setData(const std::vector<std::array<glm::vec3, 4>>& data) = 0;
 
+  // Upload raw pixels to the rectangle [x, x+w) x [y, y+h) of a 2D texture, leaving the rest unchanged. `data` holds h
+  // tightly-packed rows of w pixels, each with nChannels (1-4) components of the given type. The components fill the
+  // texture's channels in order. Missing color channels read as 0 and a missing alpha reads as 1.
+  virtual void setDataRect(const void* data, int nChannels, PixelComponentType componentType, unsigned int x,
+                           unsigned int y, unsigned int w, unsigned int h) = 0;
+
+  // As setDataRect(), for the box [x, x+w) x [y, y+h) x [z, z+d) of a 3D texture. `data` holds d tightly-packed
+  // slices of h rows each.
+  virtual void setDataBox(const void* data, int nChannels, PixelComponentType componentType, unsigned int x,
+                          unsigned int y, unsigned int z, unsigned int w, unsigned int h, unsigned int d) = 0;
+
+  // Fill a whole 2D texture from a buffer which already lives on the device, without a round trip through host
+  // memory. `nativeBufferHandle` is the backend's name for the buffer (an OpenGL buffer object), holding the pixels
+  // laid out as for setDataRect(). Useful for data written on the GPU, e.g. through CUDA/OpenGL interop.
+  virtual void setDataFromDeviceBuffer(uint32_t nativeBufferHandle, int nChannels, PixelComponentType componentType) = 0;
+
+  // Hint to the backend about how often the contents are replaced. With BufferUpdateFrequency::Streaming, uploads are
+  // staged so that they return without waiting for draws which still use the old contents.
+  void setUpdateFrequency(BufferUpdateFrequency newFreq) { updateFrequency = newFreq; }
+  BufferUpdateFrequency getUpdateFrequency() const { return updateFrequency; }
+
   unsigned int getSizeX() const { return sizeX; }
   unsigned int getSizeY() const { return sizeY; }
   unsigned int getSizeZ() const { return sizeZ; }
@@ -177,6 +306,8 @@ public:
   int64_t getSizeInBytes() const { return static_cast<int64_t>(getTotalSize()) * sizeInBytes(format); }
   uint64_t getUniqueID() const { return uniqueID; }
   TextureFormat getFormat() const { return format; }
+  size_t getDeviceMemoryBytes() const { return deviceMemoryBytes; }
+  bool isExternal() const { return external; } // wraps a texture owned elsewhere, see Engine::wrapExternalTexture()
 
   virtual void setFilterMode(FilterMode newMode);
 
@@ -186,6 +317,7 @@ public:
   virtual std::vector<float> getDataScalar() = 0;
   virtual std::vector<glm::vec2> getDataVector2() = 0;
   virtual std::vector<glm::vec3> getDataVector3() = 0;
+  virtual std::vector<glm::vec4> getDataVector4() = 0;
 
   // Set texture data
   // void fillTextureData1D(std::string name, unsigned char* texData, unsigned int length);
@@ -201,13 +333,19 @@ protected:
   TextureFormat format;
   unsigned int sizeX, sizeY, sizeZ;
   uint64_t uniqueID;
+  BufferUpdateFrequency updateFrequency = BufferUpdateFrequency::Static;
+  bool external = false;
+
+  // kept in sync with the dimensions by the constructor and resize(), external textures count as zero
+  void updateDeviceMemoryBytes();
+  size_t deviceMemoryBytes = 0;
 };
 
 class RenderBuffer {
 public:
   // abstract class: use the factory methods from the Engine class
   RenderBuffer(RenderBufferType type_, unsigned int sizeX_, unsigned int sizeY_);
-  virtual ~RenderBuffer(){};
+  virtual ~RenderBuffer();
 
   virtual void resize(unsigned int newX, unsigned int newY);
 
@@ -215,11 +353,16 @@ public:
   unsigned int getSizeX() const { return sizeX; }
   unsigned int getSizeY() const { return sizeY; }
   uint64_t getUniqueID() const { return uniqueID; }
+  size_t getDeviceMemoryBytes() const { return deviceMemoryBytes; }
 
 protected:
   RenderBufferType type;
   unsigned int sizeX, sizeY;
   uint64_t uniqueID;
+
+  // kept in sync with the dimensions by the constructor and resize()
+  void updateDeviceMemoryBytes();
+  size_t deviceMemoryBytes = 0;
 };
 
 
@@ -249,10 +392,17 @@ public:
   virtual void addDepthBuffer(std::shared_ptr<TextureBuffer> textureBuffer) = 0;
 
   virtual void setDrawBuffers() = 0;
+  // The color buffers receive the fragment shader outputs from this location on, outputs at lower locations are
+  // discarded. Set before calling setDrawBuffers().
+  int firstDrawBufferLocation = 0;
 
   // Specify the viewport coordinates
   virtual void setViewport(int startX, int startY, unsigned int sizeX, unsigned int sizeY);
 
+  // Restrict rendering and clearing to a rectangle of the framebuffer, until the scissor is removed
+  void setScissor(int startX, int startY, unsigned int sizeX, unsigned int sizeY);
+  void removeScissor();
+
   // Resizes textures and renderbuffers if different from current size.
   // We will always maintain that all bound color and depth buffers have the same size as the
   // framebuffer size.
@@ -263,10 +413,40 @@ public:
 
   // Query pixel
   virtual std::array<float, 4> readFloat4(int xPos, int yPos) = 0;
+  // Read a float4 rectangle in one call. Returns 4 * width * height values, row-major starting from (xPos, yPos).
+  virtual std::vector<float> readFloat4Region(int xPos, int yPos, int width, int height) = 0;
+  // Same as above, for buffers of type RenderBufferType::UInt2
+  virtual std::array<uint32_t, 2> readUInt2(int xPos, int yPos) = 0;
+  virtual std::vector<uint32_t> readUInt2Region(int xPos, int yPos, int width, int height) = 0;
   virtual float readDepth(int xPos, int yPos) = 0;
+  virtual std::vector<float> readDepthBuffer() = 0; // sizeX * sizeY values, row-major from the bottom left
   virtual void blitTo(FrameBuffer* other) = 0;
   virtual std::vector<unsigned char> readBuffer() = 0;
 
+  // Query pixel asynchronously: start reading a pixel, then poll on later frames until the value is available.
+  // Starting a new read discards any read still in flight. The default implementation reads synchronously, backends
+  // may override this to avoid stalling the pipeline.
+  virtual void requestReadFloat4(int xPos, int yPos);
+  virtual bool pollReadFloat4(std::array<float, 4>& result); // true if a result was written (once per request)
+  virtual bool hasPendingReadFloat4();
+  // Same as above for UInt2 buffers. Float4 and UInt2 reads share the read in flight.
+  virtual void requestReadUInt2(int xPos, int yPos);
+  virtual bool pollReadUInt2(std::array<uint32_t, 2>& result);
+  virtual bool hasPendingReadUInt2();
+
+  // Read the whole buffer asynchronously, in the same layout as readBuffer(). Unlike the pixel reads above, any number
+  // of reads may be in flight, each identified by the ticket from requestReadBuffer(). pollReadBuffer() returns true
+  // and writes the data once it is available (once per request); if `wait` is set it blocks until then. The default
+  // implementation reads synchronously.
+  virtual uint64_t requestReadBuffer();
+  virtual bool pollReadBuffer(uint64_t ticket, std::vector<unsigned char>& result, bool wait = false);
+
+  // Read the depth buffer asynchronously, keeping every stride'th pixel in each direction. The result has
+  // ceil(sizeX / stride) * ceil(sizeY / stride) values, in the layout of readDepthBuffer(). Like the pixel reads, starting
+  // a new read discards any read still in flight. The default implementation reads synchronously.
+  virtual void requestReadDepthBuffer(int stride = 1);
+  virtual bool pollReadDepthBuffer(std::vector<float>& result); // true if a result was written (once per request)
+
   virtual uint32_t getNativeBufferID() = 0;
   uint64_t getUniqueID() const { return uniqueID; }
 
@@ -274,11 +454,33 @@ protected:
   unsigned int sizeX, sizeY;
   uint64_t uniqueID;
 
+  // Used by the default synchronous implementation of requestReadFloat4()
+  bool pendingReadFloat4Valid = false;
+  std::array<float, 4> pendingReadFloat4;
+  bool pendingReadUInt2Valid = false;
+  std::array<uint32_t, 2> pendingReadUInt2;
+
+  // Tickets for requestReadBuffer(), and the results of the default synchronous implementation
+  uint64_t nextReadBufferTicket = 0;
+  std::map<uint64_t, std::vector<unsigned char>> pendingReadBuffers;
+
+  // Used by the default synchronous implementation of requestReadDepthBuffer()
+  bool pendingReadDepthValid = false;
+  std::vector<float> pendingReadDepth;
+
+  // Keep every stride'th value of a w x h depth image in each direction
+  static std::vector<float> subsampleDepth(const float* depth, int w, int h, int stride);
+
   // Viewport
   bool viewportSet = false;
   int viewportX, viewportY;
   unsigned int viewportSizeX, viewportSizeY;
 
+  // Scissor
+  bool scissorSet = false;
+  int scissorX, scissorY;
+  unsigned int scissorSizeX, scissorSizeY;
+
   // Buffers
   int nColorBuffers = 0;
   std::vector<std::shared_ptr<RenderBuffer>> renderBuffersColor, renderBuffersDepth;
@@ -292,12 +494,16 @@ struct ShaderSpecUniform {
   const RenderDataType type;
 };
 struct ShaderSpecAttribute {
-  ShaderSpecAttribute(std::string name_, RenderDataType type_) : name(name_), type(type_), arrayCount(1) {}
+  ShaderSpecAttribute(std::string name_, RenderDataType type_)
+      : name(name_), type(type_), arrayCount(1), perInstance(false) {}
   ShaderSpecAttribute(std::string name_, RenderDataType type_, int arrayCount_)
-      : name(name_), type(type_), arrayCount(arrayCount_) {}
+      : name(name_), type(type_), arrayCount(arrayCount_), perInstance(false) {}
+  ShaderSpecAttribute(std::string name_, RenderDataType type_, int arrayCount_, bool perInstance_)
+      : name(name_), type(type_), arrayCount(arrayCount_), perInstance(perInstance_) {}
   const std::string name;
   const RenderDataType type;
-  const int arrayCount; // number of times this element is repeated in an array
+  const int arrayCount;   // number of times this element is repeated in an array
+  const bool perInstance; // advance once per instance rather than once per vertex (instanced draw modes only)
 };
 struct ShaderSpecTexture {
   const std::string name;
@@ -342,6 +548,44 @@ enum class ShaderReplacementDefaults {
   None                // no defaults applied
 };
 
+// Slice planes are culled against a fixed number of plane uniforms in every scene object program (see
+// SLICE_PLANE_CULL), so that adding and removing planes does not recompile anything.
+constexpr int maxSlicePlanes = 8;
+
+// A program variant to compile ahead of time, see Engine::prewarmShaders()
+struct ShaderProgramRequest {
+  ShaderProgramRequest(std::string programName_, std::vector<std::string> customRules_ = {},
+                       ShaderReplacementDefaults defaults_ = ShaderReplacementDefaults::SceneObject)
+      : programName(programName_), customRules(customRules_), defaults(defaults_) {}
+
+  std::string programName;
+  std::vector<std::string> customRules;
+  ShaderReplacementDefaults defaults;
+};
+
+// A pre-resolved reference to one of a program's uniforms, see ShaderProgram::getUniformHandle(). Only valid for the
+// program which created it.
+struct UniformHandle {
+  int32_t index = -1;
+};
+
+// While a UniformRecording is alive on a thread, setUniform() calls made on that thread do not reach the backend, the
+// values are recorded and sent by the next draw of the program instead. This lets the uniforms of different programs be
+// computed concurrently, see Structure::prepareDraw(). Setting uniforms of the same program from several threads at
+// once is not supported.
+class UniformRecording {
+public:
+  UniformRecording();
+  ~UniformRecording();
+  UniformRecording(const UniformRecording&) = delete;
+  UniformRecording& operator=(const UniformRecording&) = delete;
+
+  static bool isActive(); // on the calling thread
+
+private:
+  bool wasActive;
+};
+
 // Encapsulate a shader program
 class ShaderProgram {
 
@@ -369,6 +613,24 @@ public:
   virtual void setUniform(std::string name, glm::uvec3 val) = 0;
   virtual void setUniform(std::string name, glm::uvec4 val) = 0;
 
+  // Uniforms, via pre-resolved handles. Resolving the name once and setting by handle avoids a lookup on each call.
+  // clang-format off
+  virtual UniformHandle getUniformHandle(std::string name) = 0;
+  virtual void setUniform(UniformHandle handle, int val) = 0;
+  virtual void setUniform(UniformHandle handle, unsigned int val) = 0;
+  virtual void setUniform(UniformHandle handle, float val) = 0;
+  virtual void setUniform(UniformHandle handle, double val) = 0; // WARNING casts down to float
+  virtual void setUniform(UniformHandle handle, float* val) = 0;
+  virtual void setUniform(UniformHandle handle, glm::vec2 val) = 0;
+  virtual void setUniform(UniformHandle handle, glm::vec3 val) = 0;
+  virtual void setUniform(UniformHandle handle, glm::vec4 val) = 0;
+  virtual void setUniform(UniformHandle handle, std::array<float, 3> val) = 0;
+  virtual void setUniform(UniformHandle handle, float x, float y, float z, float w) = 0;
+  virtual void setUniform(UniformHandle handle, glm::uvec2 val) = 0;
+  virtual void setUniform(UniformHandle handle, glm::uvec3 val) = 0;
+  virtual void setUniform(UniformHandle handle, glm::uvec4 val) = 0;
+  // clang-format on
+
   // = Attributes
   // clang-format off
   virtual bool hasAttribute(std::string name) = 0;
@@ -391,7 +653,11 @@ public:
   virtual void setTexture1D(std::string name, unsigned char* texData, unsigned int length) = 0;
   virtual void setTexture2D(std::string name, unsigned char* texData, unsigned int width, unsigned int height,
                             bool withAlpha = true, bool useMipMap = false, bool repeat = false) = 0;
+  // Binds the shared color map atlas (see Engine::getColorMapAtlas()) to a sampler2D texture, and sets the int uniform
+  // selecting the color map's row, which is named for the texture (t_colormap --> u_colormapRow). The row uniform may be
+  // set again later to switch color maps.
   virtual void setTextureFromColormap(std::string name, const std::string& colorMap, bool allowUpdate = false) = 0;
+  static std::string colormapRowUniformName(const std::string& textureName);
   // TODO make this one take a shared pointer and have the same semantics as the attribute version
   virtual void setTextureFromBuffer(std::string name, TextureBuffer* textureBuffer) = 0;
 
@@ -409,11 +675,22 @@ public:
   // Draw!
   virtual void draw() = 0;
 
+  // Draw only some of the primitives. `elementOrder` is a UInt buffer of indices in to the (non-indexed) attribute
+  // arrays, and each range {first, count} draws that run of entries from it. Used to draw a spatially-sorted subset of
+  // a large mesh or point cloud without re-uploading its attributes. For DrawMode::IndexedTriangles, `elementOrder` is
+  // used in place of the program's index buffer, e.g. to draw a simplified triangulation of the same vertices. Only
+  // supported for DrawMode::Triangles, DrawMode::IndexedTriangles and DrawMode::Points.
+  virtual void drawSubset(AttributeBuffer& elementOrder, const std::vector<std::array<size_t, 2>>& ranges) = 0;
+
   virtual void validateData() = 0;
 
   uint64_t getUniqueID() const { return uniqueID; }
+  DrawMode getDrawMode() const { return drawMode; }
 
 protected:
+  // Add a draw of nVertices vertices (times the instance count, if instanced) to the engine's RenderStats
+  void countDrawCall(size_t nVertices);
+
   // What mode does this program draw in?
   DrawMode drawMode;
 
@@ -435,6 +712,27 @@ protected:
   uint32_t instanceCount = INVALID_IND_32;
 };
 
+// Counters gathered while rendering a frame, for profiling and display in the GUI
+struct RenderStats {
+  int transparencyRenderPassesUsed = 0; // depth peeling passes which drew anything, in TransparencyMode::Pretty
+  size_t structuresDrawn = 0;           // enabled structures inside the view frustum
+  size_t structuresCulled = 0;          // enabled structures skipped by frustum culling
+  size_t structuresOccluded = 0;        // ... of which were skipped by occlusion culling
+  size_t drawCalls = 0;                 // draw calls issued by shader programs, reset each frame
+  size_t trianglesSubmitted = 0;        // triangles in the primitives of those draw calls, before any geometry shaders
+  size_t stateChanges = 0;        // render state changes and texture binds issued by the backend, reset each frame
+  size_t stateChangesSkipped = 0; // ... and ones skipped because the state was already set
+  size_t sceneRenders = 0;        // frames which rendered the scene, since startup
+  size_t sceneReuses = 0;         // frames which reused the scene of the previous frame, since startup
+
+  void resetDrawCounts() {
+    drawCalls = 0;
+    trianglesSubmitted = 0;
+    stateChanges = 0;
+    stateChangesSkipped = 0;
+  }
+};
+
 
 class Engine {
 
@@ -456,11 +754,14 @@ public:
 
   virtual void clearSceneBuffer();
   virtual bool bindSceneBuffer();
+  bool bindSceneBufferWeighted();
   virtual void resizeScreenBuffers(); // applies to all buffers tied to display size
   virtual void setScreenBufferViewports();
+  unsigned int scaledSceneBufferSize(unsigned int displaySize); // display pixels to scene buffer pixels
   virtual void
   applyLightingTransform(std::shared_ptr<TextureBuffer>& texture); // tonemap and gamma correct, render to active buffer
   void updateMinDepthTexture();
+  void updatePrepassDepthTexture(); // copy the scene depth after the depth prepass, see setDepthPrepass()
   void renderBackground(); // respects background setting
 
   // Manage render state
@@ -483,6 +784,9 @@ public:
 
   // Manage materials
   void setMaterial(ShaderProgram& program, const std::string& mat);
+  // False if programs built for one material can draw the other just by setMaterialUniforms(), which holds for any two
+  // materials in the shared material texture array. Structures use this to skip rebuilding programs on a change.
+  bool materialChangeNeedsRefresh(const std::string& oldMat, const std::string& newMat);
   std::vector<std::string> addMaterialRules(std::string materialName, std::vector<std::string> initRules);
   void setMaterialUniforms(ShaderProgram& program, const std::string& mat);
 
@@ -499,8 +803,11 @@ public:
   virtual void setWindowResizable(bool newVal) = 0; // whether the user can manually resize by dragging the window frame
   virtual bool getWindowResizable() = 0;
   virtual std::tuple<int, int> getWindowPos() = 0;
+  virtual double getDisplayRefreshRate() { return -1.; } // in Hz, of the display showing the window. -1 if unknown
   virtual bool windowRequestsClose() = 0;
   virtual void pollEvents() = 0;
+  virtual void waitEvents(double timeoutSeconds) { pollEvents(); } // like pollEvents(), but block until there are some
+  virtual void wakeWaitEvents() {}                                 // make a waitEvents() return, from any thread
   virtual bool isKeyPressed(char c) = 0; // for lowercase a-z and 0-9 only
   virtual int getKeyCode(char c) = 0;    // for lowercase a-z and 0-9 only
   virtual std::string getClipboardText() = 0;
@@ -516,7 +823,10 @@ public:
   virtual void ImGuiRender() = 0;
 
   void setImGuiStyle();
-  ImFontAtlas* getImGuiGlobalFontAtlas();
+  ImFontAtlas* getImGuiGlobalFontAtlas(); // prepares the fonts if needed
+
+  // The fonts are only needed to draw the GUI, so preparing them is deferred from initializeImGui() until then
+  void ensureImGuiFontsPrepared();
   virtual void showTextureInImGuiWindow(std::string windowName, TextureBuffer* buffer);
 
 
@@ -544,6 +854,12 @@ public:
                                                                unsigned int sizeY_, unsigned int sizeZ_,
                                                                const float* data) = 0; // 3d
 
+  // Wrap a 2D texture which belongs to someone else, e.g. the output of an external renderer, so it can be drawn
+  // without a copy. `nativeHandle` is the backend's name for it (an OpenGL texture name), and the texture must have the
+  // given format and size. It is never deleted or resized here, so it must outlive the returned buffer.
+  virtual std::shared_ptr<TextureBuffer> wrapExternalTexture(TextureFormat format, unsigned int sizeX_,
+                                                             unsigned int sizeY_, uint32_t nativeHandle) = 0;
+
   // create render buffers
   virtual std::shared_ptr<RenderBuffer> generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
                                                              unsigned int sizeY_) = 0;
@@ -555,31 +871,115 @@ public:
   requestShader(const std::string& programName, const std::vector<std::string>& customRules,
                 ShaderReplacementDefaults defaults = ShaderReplacementDefaults::SceneObject) = 0;
 
+  // Compile these program variants now (e.g. during a loading screen), so that the first requestShader() for each of
+  // them is cheap. With options::asyncShaderCompilation the compiles are only started here, shaderCompilesPending()
+  // reports whether any are still running.
+  virtual void prewarmShaders(const std::vector<ShaderProgramRequest>& programs);
+  virtual bool shaderCompilesPending();
+
+  // The table of program variants requested by earlier runs, recorded in options::shaderCacheDirectory. Prewarming it
+  // (done by polyscope::init()) means the variants a program typically uses are ready before they are first requested,
+  // rather than each being assembled and compiled the first time it is drawn. Entries which use a program or rule that
+  // is not registered (yet) are skipped.
+  std::vector<ShaderProgramRequest> loadShaderVariantTable();
+  void prewarmShaderVariantTable();
+
+  // == Device-side data movement
+
+  // Fill dst[i] = src[indices[i]] entirely on the device, resizing dst as needed. Returns false if the backend cannot
+  // do this for the given buffers, in which case the caller should fall back on a host-side gather.
+  virtual bool gatherAttributeBufferOnDevice(AttributeBuffer& src, AttributeBuffer& indices, AttributeBuffer& dst);
+
+  // Compute the face normals and area-weighted vertex normals of a polygon mesh entirely on the device, from vertex
+  // positions (vec3) which are already uploaded. The connectivity is given as UInt buffers in CSR form: faceStart
+  // [nFaces + 1] holds offsets in to faceVerts [nCorners], and vertexFaceStart [nVertices + 1] holds offsets in to
+  // vertexFaces [nCorners], the faces around each vertex. Either output may be null. Returns false if the backend
+  // cannot do this for the given buffers, in which case the caller should compute the normals on the host.
+  virtual bool computeMeshNormalsOnDevice(AttributeBuffer& positions, AttributeBuffer& faceStart,
+                                          AttributeBuffer& faceVerts, AttributeBuffer& vertexFaceStart,
+                                          AttributeBuffer& vertexFaces, AttributeBuffer* faceNormals,
+                                          AttributeBuffer* vertexNormals);
+
+  // Reductions over scalar data which lives on the device, e.g. after it was written through
+  // ManagedBuffer::beginDeviceWrite(), so that only the small results are read back. The values are a Float attribute
+  // buffer with Float32 storage, or a single-channel texture. Non-finite values are skipped. These return false if the
+  // backend cannot handle the buffer, in which case the caller should compute the results on the host.
+  //
+  // The finite min/max of the values, as finiteMinMax() would give
+  virtual bool computeFiniteRangeOnDevice(AttributeBuffer& values, std::pair<double, double>& range);
+  virtual bool computeFiniteRangeOnDevice(TextureBuffer& values, std::pair<double, double>& range);
+  // The number of values in each of nBins equal bins spanning `range`, values outside it are counted in the end bins
+  virtual bool computeHistogramOnDevice(AttributeBuffer& values, std::pair<double, double> range, size_t nBins,
+                                        std::vector<double>& binCounts);
+  virtual bool computeHistogramOnDevice(TextureBuffer& values, std::pair<double, double> range, size_t nBins,
+                                        std::vector<double>& binCounts);
+
+  // == Limits
+  // The largest size of a 3D texture along any axis. The default is the minimum which OpenGL 3.3 guarantees, backends
+  // report their actual limit.
+  virtual uint32_t getMaxTextureSize3D();
+
+  // == Occlusion queries
+  // Count the samples which pass the depth test between a begin/end pair, e.g. to detect when a render pass draws
+  // nothing. Queries cannot be nested. beginSamplesPassedQuery() returns false if the backend does not support them,
+  // in which case callers should assume that everything drew something.
+  virtual bool beginSamplesPassedQuery();
+  virtual size_t endSamplesPassedQuery(); // waits for the result
+
+  // == Timer queries
+  // Record the time at which the GPU reaches this point in the command stream. The result arrives some frames later,
+  // pollGPUTimestamp() returns false until it is available and then releases the query, discardGPUTimestamp() releases
+  // one whose result is no longer wanted. recordGPUTimestamp() returns 0 if the backend does not support them.
+  virtual uint64_t recordGPUTimestamp();
+  virtual bool pollGPUTimestamp(uint64_t ticket, uint64_t& nanoseconds);
+  virtual void discardGPUTimestamp(uint64_t ticket);
+
+  // == Per-frame uniforms
+  // Camera state which is identical for every program in a render pass is stored once in an engine-owned uniform
+  // block, rather than being set on each program separately. Call before drawing a pass, once the view is final.
+  void updateFrameUniforms();
+  bool frameUniformsAreValid() const { return frameUniformDataValid; }
+
   // === The frame buffers used in the rendering pipeline
   // The size of these buffers is always kept in sync with the screen size
   std::shared_ptr<FrameBuffer> displayBuffer, displayBufferAlt;
   std::shared_ptr<FrameBuffer> sceneBuffer, sceneBufferFinal;
   std::shared_ptr<FrameBuffer> pickFramebuffer;
   std::shared_ptr<FrameBuffer> sceneDepthMinFrame;
+  std::shared_ptr<FrameBuffer> sceneDepthPrepassFrame;
+  std::shared_ptr<FrameBuffer> sceneBufferWeighted; // accumulation targets for weighted blended transparency
+  std::shared_ptr<FrameBuffer> externalTargetBuffer; // around the host texture of renderToExternalTexture(), if any
+  uint32_t externalTargetTextureName = 0;
   FrameBuffer& getDisplayBuffer();
 
   // Main buffers for rendering
   // sceneDepthMin is an optional texture copy of the depth buffe used for some effects
   std::shared_ptr<TextureBuffer> sceneColor, sceneColorFinal, sceneDepth, sceneDepthMin;
+  std::shared_ptr<TextureBuffer> sceneDepthPrepass; // the depth of the opaque scene, written by the depth prepass
+  std::shared_ptr<TextureBuffer> sceneWeightedAccum, sceneWeightedRevealage;
   std::shared_ptr<RenderBuffer> pickColorBuffer, pickDepthBuffer;
   TextureBuffer& getFinalSceneColorTexture();
 
-  // General-use programs used by the engine
+  // General-use programs used by the engine. Each is compiled when first needed, e.g. compositePeel and copyDepth once
+  // depth peeling is used. The texture-draw programs are not used by the engine itself, and are left null.
   std::shared_ptr<ShaderProgram> renderTexturePlain, renderTextureDot3, renderTextureMap3, renderTextureSphereBG;
-  std::shared_ptr<ShaderProgram> compositePeel, mapLight, copyDepth;
+  std::shared_ptr<ShaderProgram> compositePeel, compositeWeighted, mapLight, copyDepth, taaResolve;
 
   // Manage transparency and culling
   void setTransparencyMode(TransparencyMode newMode);
   TransparencyMode getTransparencyMode();
   bool transparencyEnabled();
+
+  // With a depth prepass, the opaque structures are drawn once to depth only (depthPrepassStage = 1), then again with
+  // shading (depthPrepassStage = 2). Each scene program skips its lighting in the first stage, and in the second stage
+  // discards fragments behind the copy of the prepass depth before computing any lighting.
+  void setDepthPrepass(bool newVal);
+  bool getDepthPrepass();
+  bool depthPrepassActive(); // true if the current transparency mode renders with the prepass
+  int depthPrepassStage = 0; // 0 if not in a prepass frame, otherwise as above
   virtual void applyTransparencySettings() = 0;
-  void addSlicePlane(std::string uniquePostfix);
-  void removeSlicePlane(std::string uniquePostfix);
+  void addSlicePlane(); // only the first plane added (or the last removed) changes the programs, see maxSlicePlanes
+  void removeSlicePlane();
   bool slicePlanesEnabled();                     // true if there is at least one slice plane in the scene
   virtual void setFrontFaceCCW(bool newVal) = 0; // true if CCW triangles are considered front-facing; false otherwise
   bool getFrontFaceCCW();
@@ -595,11 +995,35 @@ public:
   void setSSAAFactor(int newVal);
   int getSSAAFactor();
 
+  // Render the scene at this fraction of the SSAA resolution, in (0, 1]. Used by the adaptive quality governor (see
+  // adaptive_quality.h) to render cheaper frames while the camera moves.
+  void setSceneResolutionScale(float newVal);
+  float getSceneResolutionScale();
+  float getSceneBufferScale(); // scene buffer pixels per display pixel, i.e. the SSAA factor times the scale above
+
+  // See options::renderTargetBudget. Buffers which are only needed by some features are allocated when the feature is
+  // first used either way.
+  void setRenderTargetBudget(bool newVal);
+  bool getRenderTargetBudget();
+  void copySceneToFinal(); // after rendering the scene, unless the final scene buffer shares storage with it
+
+  // See options::fxaa
+  void setFXAA(bool newVal);
+  bool getFXAA();
+
+  // Temporal anti-aliasing (see options::temporalAntiAliasing). The history buffers are allocated on first use.
+  void setTemporalAntiAliasing(bool newVal);
+  bool getTemporalAntiAliasing();
+  void beginTemporalAntiAliasingFrame(bool sceneChanged); // sets view::projectionJitter for the coming scene render
+  void resolveTemporalAntiAliasing(); // blend the scene render with the history, the result replaces sceneColorFinal
+  bool temporalAntiAliasingPending(); // true while a still scene has not yet accumulated all jitter positions
+
 
   // == Cached data
 
   // Materials
   std::vector<std::unique_ptr<Material>> materials;
+  std::shared_ptr<TextureBuffer> materialTextureArray; // the images of the built-in matcaps, one per layer
   Material& getMaterial(const std::string& name);
   void loadBlendableMaterial(std::string matName, std::array<std::string, 4> filenames);
   void loadBlendableMaterial(std::string matName, std::string filenameBase, std::string filenameExt);
@@ -610,18 +1034,35 @@ public:
   const ValueColorMap& getColorMap(const std::string& name);
   void loadColorMap(std::string cmapName, std::string filename);
 
+  // All color maps share one 2D texture, with a row for each. Shaders pick a color map with the row uniform set by
+  // ShaderProgram::setTextureFromColormap(), so changing a color map does not need a new texture or program. The atlas
+  // is built on first use, and updated in place when more color maps are loaded.
+  TextureBuffer& getColorMapAtlas();
+  int getColorMapAtlasRow(const std::string& name);
+
   // Helpers
   std::vector<glm::vec3> screenTrianglesCoords(); // two triangles which cover the screen
   std::vector<glm::vec4> distantCubeCoords();     // cube with vertices at infinity
 
   uint64_t getNextUniqueID();
 
+  // == Statistics about the most recently rendered frame
+  RenderStats stats;
+
   // ==  Implementation details and hacks
   bool lightCopy = false; // if true, when applying lighting transform does a copy instead of an alpha blend. Used
                           // internally for alpha in screenshots, but should generally be left as false.
 
   bool useAltDisplayBuffer = false; // if true, push final render results offscreen to the alt buffer instead
 
+  float fixedFrameDeltaTime = 0.f; // if positive, ImGuiNewFrame() advances the UI clock by exactly this much per frame
+                                   // rather than by the elapsed time. Used internally while recording.
+
+  bool weightedTransparencyPass = false; // if true, applyTransparencySettings() configures accumulation into
+                                         // sceneBufferWeighted rather than opaque rendering
+  bool sortedTransparencyPass = false;   // true while drawing the structures which sort their own transparency, see
+                                         // Structure::drawsSortedTransparency()
+
   // Internal windowing and engine details
   ImFontAtlas* globalFontAtlas = nullptr;
   ImFont* regularFont = nullptr;
@@ -633,34 +1074,72 @@ protected:
 
   // Render state
   int ssaaFactor = 1;
-  bool enableFXAA = true;
+  float sceneResolutionScale = 1.;
+  bool enableFXAA = false;
+  bool enableTAA = false;
+  bool renderTargetBudget = false;
   glm::vec4 currViewport; // TODO remove global viewport size. There is no reason for this, and stops us from doing
                           // screenshot renders while minimized.
   float currPixelScale;
   TransparencyMode transparencyMode = TransparencyMode::None;
+  bool depthPrepass = false;
   int slicePlaneCount = 0;
   bool frontFaceCCW = true;
   std::vector<FrameBuffer*> renderFramebufferStack; // supports push/popBindFramebufferForRendering
 
+  // Temporal anti-aliasing state. The two history buffers alternate, taaHistoryIndex holds the latest result.
+  std::shared_ptr<TextureBuffer> taaHistoryColor[2];
+  std::shared_ptr<FrameBuffer> taaHistoryBuffer[2];
+  int taaHistoryIndex = 0;
+  int taaHistorySamples = 0; // renders accumulated in the history since the scene last changed, 0 if it is invalid
+  bool taaSceneChanged = false;
+  unsigned int taaFrameIndex = 0;
+  glm::mat4 taaPrevViewProj;
+  void allocateTemporalAntiAliasingBuffers();
+
+  // Allocate or release the buffers which depend on the enabled features, see setRenderTargetBudget()
+  void updateSceneBufferAllocation();
+
   // Cached lazy seettings for the resolve and relight program
   int currLightingSampleLevel = -1;
   TransparencyMode currLightingTransparencyMode = TransparencyMode::None;
+  bool currLightingFXAA = false;
 
   // Helpers
   void configureImGui();
+  bool imguiFontsPrepared = false;
   void loadDefaultMaterials();
   void loadDefaultMaterial(std::string name);
+  int nMaterialArrayLayers = 0; // layers assigned by loadDefaultMaterial(), materialTextureArray is sized to fit
   std::shared_ptr<TextureBuffer> loadMaterialTexture(float* data, int width, int height);
   void loadDefaultColorMap(std::string name);
   void loadDefaultColorMaps();
-  virtual void createSlicePlaneFliterRule(std::string name) = 0;
+  std::shared_ptr<TextureBuffer> colorMapAtlas;
+  size_t colorMapAtlasRows = 0; // the number of color maps when the atlas was last filled
+
+  // Add a newly compiled variant to the table, if it is not there already. Called by the backend's program cache.
+  void recordShaderVariant(const std::string& programName, const std::vector<std::string>& customRules,
+                           ShaderReplacementDefaults defaults);
+  virtual bool shaderVariantAvailable(const ShaderProgramRequest& request); // all of its program and rules registered
+  std::set<std::string> shaderVariantTableEntries; // recorded lines of the table, loaded once
+  bool shaderVariantTableLoaded = false;
 
   // Manage a unique ID, incremented on lots of operations. Used to distinguish updates to buffers/shaders/etc
   uint64_t uniqueID = 500;
 
+  // Per-frame uniform data, matching the std140 layout of the uniform block the shaders read
+  struct FrameUniformData {
+    glm::mat4 projMatrix;
+    glm::mat4 invProjMatrix;
+  };
+  FrameUniformData frameUniformData;
+  bool frameUniformDataValid = false;
+  virtual void uploadFrameUniforms(); // push frameUniformData to the device, called only when it changes
+
   // Default rule lists (see enum for explanation)
   std::vector<std::string> defaultRules_sceneObject{"GLSL_VERSION", "GLOBAL_FRAGMENT_FILTER"};
-  std::vector<std::string> defaultRules_pick{"GLSL_VERSION", "GLOBAL_FRAGMENT_FILTER", "SHADE_COLOR", "LIGHT_PASSTHRU"};
+  std::vector<std::string> defaultRules_pick{"GLSL_VERSION", "GLOBAL_FRAGMENT_FILTER", "SHADE_COLOR", "LIGHT_PASSTHRU",
+                                             "PICK_OUTPUT_INDEX"};
   std::vector<std::string> defaultRules_process{"GLSL_VERSION"};
 };
 
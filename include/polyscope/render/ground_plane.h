@@ -5,6 +5,7 @@
 #include "polyscope/types.h"
 #include "polyscope/view.h"
 
+#include <cstdint>
 #include <memory>
 
 namespace polyscope {
@@ -58,8 +59,22 @@ private:
   std::array<std::shared_ptr<render::FrameBuffer>, 2> blurFrameBuffers;
   std::shared_ptr<render::ShaderProgram> blurProgram, copyTexProgram;
 
+  // screen-space reflection: copies the scene depth in to sceneAltDepthTexture
+  std::shared_ptr<render::ShaderProgram> copySceneDepthProgram;
+
+  void prepareBlurBuffers();
+
   void populateGroundPlaneGeometry();
   bool groundPlanePrepared = false;
+
+  // The mirror image and the shadow are reused until the scene or the camera changes, see draw()
+  bool altSceneCacheValid = false;
+  uint64_t altSceneCacheGeneration = 0;
+  unsigned int altSceneCacheWidth = 0;
+  unsigned int altSceneCacheHeight = 0;
+  double altSceneCacheGroundHeight = 0.;
+  glm::mat4 altSceneCacheViewMat;
+  glm::mat4 altSceneCacheProjMat;
   // which direction the ground plane faces
   view::UpDir groundPlaneViewCached = view::UpDir::XUp; // not actually valid, must populate first time
 };
@@ -4,6 +4,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -17,6 +18,20 @@ namespace render {
 // forward declaration
 class ManagedBufferRegistry;
 
+// Memory held by managed buffers
+struct MemoryUsage {
+  size_t hostBytes = 0;   // in the host-side `data` vectors (including any spare capacity)
+  size_t deviceBytes = 0; // in render attribute buffers, textures, and indexed views on the device
+  size_t overheadBytes = 0; // in the buffer objects themselves and other per-structure bookkeeping, rather than data
+
+  MemoryUsage& operator+=(const MemoryUsage& other) {
+    hostBytes += other.hostBytes;
+    deviceBytes += other.deviceBytes;
+    overheadBytes += other.overheadBytes;
+    return *this;
+  }
+};
+
 /*
  * This class is a wrapper which sits on top of data buffers in Polyscope, and handles common data-management concerns
  * of:
@@ -64,7 +79,9 @@ public:
 
 
   // The raw underlying buffer which this class wraps that holds the data.
-  // It is assumed that it never changes length (although this class may clear it to empty).
+  // It may change length when it is re-set followed by markHostBufferUpdated(), or via appendData(). The render buffer
+  // keeps its capacity when the data shrinks and at least doubles when it grows, so changing the length every frame
+  // does not reallocate every frame.
   //
   // It is possible that data.size() == 0 if the data is lazily computed and has not been computed yet, or if this
   // host-side buffer is invalidated because it is being updated externally directly on the render device.
@@ -94,7 +111,7 @@ public:
   void setTextureSize(uint32_t sizeX);
   void setTextureSize(uint32_t sizeX, uint32_t sizeY);
   void setTextureSize(uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ);
-  std::array<uint32_t, 3> getTextureSize() const;
+  glm::uvec3 getTextureSize() const;
 
 
   // == Members for indexed data
@@ -107,6 +124,11 @@ public:
   // is lazily computed by computeFunc(), it ensures that that function has been called.
   void ensureHostBufferPopulated();
 
+  // If the data is computed by computeFunc() and has not been yet, compute it. Unlike ensureHostBufferPopulated() this
+  // never reads back from the render buffers, so it may be called off the render thread, as long as the data the
+  // computeFunc() reads is on the host (see Structure::prepareHostData()).
+  void ensureHostBufferComputed();
+
   // Ensure that the `data` member has the proper size. This does _not_ populate the buffer with any particular data,
   // just ensures it is allocated. It is useful for when an external wants to fill the buffer with data.
   void ensureHostBufferAllocated();
@@ -118,6 +140,43 @@ public:
   // reflecting updates to the render buffer.
   void markHostBufferUpdated();
 
+  // Like markHostBufferUpdated(), but only the entries [begin, begin+count) of `data` have changed. Only those entries
+  // (and the corresponding entries of any indexed views) are re-sent to the render buffers. The host buffer must
+  // already be populated, and the size of `data` must not have changed.
+  void markHostBufferRangeUpdated(size_t begin, size_t count);
+
+  // Same as above, for many ranges at once, each given as {begin, count}. The ranges are sorted and merged before
+  // uploading, so overlapping or adjacent ranges result in a single transfer. If the ranges cover most of the buffer,
+  // this falls back on a full update.
+  void markHostBufferRangesUpdated(std::vector<std::array<size_t, 2>> ranges);
+
+  // Like markHostBufferRangeUpdated(), for a 3D texture buffer where the box of entries [origin, origin + extent) of
+  // `data` changed, with `data` indexed x-fastest. Only that box is re-sent to the render texture.
+  void markHostBufferBoxUpdated(glm::uvec3 origin, glm::uvec3 extent);
+
+  // Add entries to the end of the buffer, e.g. while loading data in chunks. The render buffer grows in place and only
+  // the new entries are uploaded. If the host copy has been dropped (see setHostResidency()), the new entries go
+  // straight to the render buffer without restoring it. Only for attribute data which is not computed.
+  void appendData(const std::vector<T>& newValues);
+
+  // Allocate room for `capacity` entries up front, so that appendData() does not need to reallocate until the buffer
+  // grows past it. The host copy is only reserved if it stays resident.
+  void reserve(size_t capacity);
+
+  // Use externally-owned memory holding `count` entries as the source of this buffer's data, without copying it in to
+  // `data`. The render buffers upload directly from this memory. `lifetimeToken` is held for as long as the
+  // view is in use, and can be used to keep the memory alive (it may be null if the caller guarantees that itself).
+  //
+  // Anything which needs the data on the host, e.g. ensureHostBufferPopulated(), copies the view into `data` and
+  // releases the view. From then on the buffer behaves as if the data had been set normally. If the external
+  // memory changes, call setExternalView() again to re-upload it.
+  void setExternalView(const T* viewData, size_t count, std::shared_ptr<void> lifetimeToken);
+  bool hasExternalView() const;
+
+  // The size() values on the host, read from the external view if there is one rather than copying it, otherwise from
+  // the populated `data`. Valid until the buffer changes.
+  const T* getHostDataPointer();
+
   // Get the value at index `i`. It may be dynamically fetched from either the cpu-side `data` member or the render
   // buffer, depending on where the data currently lives.
   // If the data lives only on the device-side render buffer, this function is expensive, so don't call it in a
@@ -126,18 +185,59 @@ public:
   T getValue(size_t indX, size_t indY);              // only valid for 2d texture data
   T getValue(size_t indX, size_t indY, size_t indZ); // only valid for 3d texture data
 
+  // Get the values at many indices, or at the range [begin, begin + count). Unlike calling getValue() in a loop, data
+  // which lives only in the render buffer is read back with a single transfer (spanning the smallest to the largest
+  // index), so these are the way to inspect e.g. a set of picked elements.
+  std::vector<T> getValues(const std::vector<size_t>& inds);
+  std::vector<T> getRange(size_t begin, size_t count);
+
+  // If the data lives only in the render buffer, start copying it back to the host without waiting for the GPU, e.g.
+  // right after the draw which wrote it. Later reads (getValue(), getValues(), ensureHostBufferPopulated(), ...) use
+  // the copy rather than stalling, as long as the contents did not change in the meantime. Does nothing otherwise.
+  void requestHostCopyAsync();
+
   // If computeFunc() has already been called to populate the stored data, call it again to recompute the data, and
   // re-fill the buffer if necessary. This function is only meaningful in the case where `dataGetsComputed = true`.
   void recomputeIfPopulated();
 
   bool hasData(); // true if there is valid data on either the host or device
+  bool isDeviceResident(); // true if the data is mirrored on the device, in the render buffer or an indexed view
+  bool isCanonicalOnDevice(); // true if the data currently lives only in the render buffer, e.g. after it was written
+                              // on the device, so reading it on the host needs a readback
   size_t size();  // size of the data (number of entries)
 
+  // A counter which increases whenever the contents of the buffer are updated via the functions of this class. Useful
+  // for caching values derived from the data.
+  uint64_t getDataVersion() const;
+
   // Is it an attribute, texture1d, texture2d, etc?
   DeviceBufferType getDeviceBufferType();
 
+  // Hint for how often the data gets replaced. Use BufferUpdateFrequency::Streaming for data which is re-set every
+  // frame (e.g. animated positions), which lets the render buffers upload without stalling. Also applies to indexed
+  // views of this buffer.
+  void setUpdateFrequency(BufferUpdateFrequency newFreq);
+  BufferUpdateFrequency getUpdateFrequency() const;
+
+  // Whether the host copy in `data` stays resident once it has been uploaded. With HostResidency::DropAfterUpload,
+  // `data` is freed at the end of the frame after each upload, and ensureHostBufferPopulated() restores it on demand,
+  // by reading back the render buffer or by calling computeFunc(). Code which reads `data` directly must call
+  // ensureHostBufferPopulated() first. The host copy is only dropped if it can be restored exactly: attribute buffers
+  // whose device representation matches T (so not e.g. doubles, which are stored as floats), and computed textures.
+  void setHostResidency(HostResidency newResidency);
+  HostResidency getHostResidency() const;
+
+  // Store the render buffer and indexed views in a compact format, e.g. AttributeStorageFormat::UNorm8 for colors in
+  // [0,1] or SNorm16 for unit normals (see AttributeStorageFormat). Only for float data, and must be set before the
+  // render buffers are created, i.e. before the structure is first drawn.
+  void setDeviceStorageFormat(AttributeStorageFormat newFormat);
+  AttributeStorageFormat getDeviceStorageFormat() const;
+
   std::string summaryString(); // for debugging
 
+  // Bytes held by this buffer, on the host in `data` and on the device in the render buffer and indexed views
+  MemoryUsage getMemoryUsage();
+
   // ========================================================================
   // == Direct access to the GPU (device-side) render attribute buffer
   // ========================================================================
@@ -176,6 +276,10 @@ public:
   // same view will be returned repeatedly at no additional cost.
   std::shared_ptr<render::AttributeBuffer> getIndexedRenderAttributeBuffer(ManagedBuffer<uint32_t>& indices);
 
+  // The cached views are regathered when this buffer's data changes, but not when the index buffer does. After
+  // updating `indices`, call this to regather any views through it.
+  void refreshIndexedViews(ManagedBuffer<uint32_t>& indices);
+
   // ========================================================================
   // == Direct access to the GPU (device-side) render texture buffer
   // ========================================================================
@@ -186,14 +290,73 @@ public:
   std::shared_ptr<render::TextureBuffer> getRenderTextureBuffer();
   void markRenderTextureBufferUpdated();
 
+  // Write raw pixels straight to the rectangle [x, x+w) x [y, y+h) of the render texture of a 2D texture buffer, see
+  // TextureBuffer::setDataRect() for the layout. This skips `data` entirely, so pixels can be given in a compact type
+  // such as 8-bit, and the host copy is invalidated (it is read back from the device if needed again).
+  void setTextureDataRect(const void* pixels, int nChannels, PixelComponentType componentType, uint32_t x, uint32_t y,
+                          uint32_t w, uint32_t h);
+
+  // Store the render texture in a compact format, e.g. TextureFormat::RGBA8 for 8-bit colors, or R16 / R16F for
+  // scalars. The format must have as many channels as T, and must be set before the texture is created. Values are
+  // quantized as they are uploaded, the integer formats hold [0,1] and are sampled as floats by the shaders.
+  void setTextureStorageFormat(TextureFormat newFormat);
+
+  // Fill the render texture of a 2D texture buffer from a buffer which already lives on the device, without going
+  // through `data`, see TextureBuffer::setDataFromDeviceBuffer(). The host copy is invalidated as above.
+  void setTextureDataFromDeviceBuffer(uint32_t nativeBufferHandle, int nChannels, PixelComponentType componentType);
+
+  // Use a texture owned elsewhere as the render texture of a 2D texture buffer, e.g. one from
+  // Engine::wrapExternalTexture() which an external renderer draws to. It must have this buffer's size, and at least as
+  // many channels as T. Call markRenderTextureBufferUpdated() after its contents change. Shader programs holding the
+  // previous render texture need to be rebuilt.
+  void setExternalRenderTexture(std::shared_ptr<render::TextureBuffer> texture);
+
+  // ========================================================================
+  // == Interop with other GPU APIs
+  // ========================================================================
+  //
+  // Lets device code, e.g. a CUDA kernel, write the render buffer in place instead of copying through the host.
+  // beginDeviceWrite() returns the backend's name for the render attribute buffer or texture (an OpenGL buffer object
+  // or texture), creating and filling it if needed. Register that with the other API (e.g.
+  // cudaGraphicsGLRegisterBuffer() or cudaGraphicsGLRegisterImage()), map it, write it, unmap it, and then call
+  // endDeviceWrite(). That marks the render buffer updated, so the host copy is invalidated and only read back if it is
+  // needed (CanonicalDataSource::RenderBuffer).
+  //
+  // An attribute buffer holds size() tightly packed entries of T, with doubles stored as floats, so it must use
+  // AttributeStorageFormat::Float32. Its storage is reallocated when the size changes, so register it again after that.
+  uint32_t beginDeviceWrite();
+  void endDeviceWrite();
+  bool isDeviceWriteActive() const;
+
 
 protected:
   // == Internal members
 
   bool hostBufferIsPopulated; // true if the host buffer contains currently-valid data
+  uint64_t dataVersion = 0;   // see getDataVersion()
 
   std::shared_ptr<render::AttributeBuffer> renderAttributeBuffer;
   std::shared_ptr<render::TextureBuffer> renderTextureBuffer;
+  BufferUpdateFrequency updateFrequency = BufferUpdateFrequency::Static;
+  AttributeStorageFormat deviceStorageFormat = AttributeStorageFormat::Float32;
+  bool deviceWriteActive = false; // between beginDeviceWrite() and endDeviceWrite()
+  size_t reservedCapacity = 0;                                             // see reserve()
+  std::shared_ptr<render::AttributeBuffer> generateDeviceAttributeBuffer(); // applies the settings above
+
+  // See setHostResidency(). Drops are deferred to the end of the frame, so that callers which just populated the host
+  // buffer can still read it.
+  HostResidency hostResidency = HostResidency::Keep;
+  bool hostBufferDropScheduled = false;
+  void scheduleHostBufferDrop();
+  void dropHostBufferIfRestorable();
+
+  // Non-owned memory used as the data source, see setExternalView()
+  bool usingExternalView = false;
+  const T* externalViewData = nullptr;
+  size_t externalViewSize = 0;
+  std::shared_ptr<void> externalViewLifetime;
+  void clearExternalView();
+  void uploadExternalView(render::AttributeBuffer& buffer);
 
   // For storing as textures
 
@@ -202,6 +365,9 @@ protected:
   uint32_t sizeX = 0;
   uint32_t sizeY = 0; // holds 0 if texture dim < 2
   uint32_t sizeZ = 0; // holds 0 if texture dim < 3
+  bool textureStorageFormatIsSet = false;                  // otherwise the default float format for T
+  TextureFormat textureStorageFormat = TextureFormat::R32F; // see setTextureStorageFormat()
+  void generateDeviceTextureBuffer();                       // allocates renderTextureBuffer, without filling it
 
 
   // == Internal representation of indexed views
@@ -211,6 +377,7 @@ protected:
   std::vector<std::tuple<render::ManagedBuffer<uint32_t>*, std::weak_ptr<render::AttributeBuffer>>>
       existingIndexedViews;
   void updateIndexedViews();
+  void updateIndexedViewsRanges(const std::vector<std::array<size_t, 2>>& dirtyRanges); // sorted [begin,end) ranges
   void removeDeletedIndexedViews();
 
   // == Internal helper functions
@@ -220,13 +387,12 @@ protected:
   void checkDeviceBufferTypeIs(DeviceBufferType targetType);
   void checkDeviceBufferTypeIsTexture();
 
-  enum class CanonicalDataSource { HostData = 0, NeedsCompute, RenderBuffer };
+  enum class CanonicalDataSource { HostData = 0, NeedsCompute, RenderBuffer, ExternalView };
   CanonicalDataSource currentCanonicalDataSource();
 
-  // Manage the program which copies indexed data from the renderBuffer to the indexed views
-  void ensureHaveBufferIndexCopyProgram();
-  void invokeBufferIndexCopyProgram();
-  std::shared_ptr<render::ShaderProgram> bufferIndexCopyProgram;
+  // Fill an indexed view buffer from this buffer, directly on the device if the engine supports it, otherwise by
+  // gathering on the host and uploading
+  void populateIndexedView(ManagedBuffer<uint32_t>& indices, render::AttributeBuffer& viewBuffer);
 };
 
 
@@ -243,6 +409,9 @@ public:
   ManagedBuffer<T>& getManagedBuffer(std::string name);
   bool hasManagedBuffer(std::string name);
 
+  MemoryUsage getMemoryUsage(); // summed over all buffers in the map
+  void refreshIndexedViews(ManagedBuffer<uint32_t>& indices); // on all buffers in the map
+
   // internal helper for template things
   static ManagedBufferMap<T>& getManagedBufferMapRef(ManagedBufferRegistry* r);
 
@@ -273,6 +442,13 @@ public:
   template <typename T>
   void addManagedBuffer(ManagedBuffer<T>* buffer);
 
+  // memory held by all of the buffers in the registry, see ManagedBuffer::getMemoryUsage()
+  MemoryUsage getManagedBufferMemoryUsage();
+
+  // regather the indexed views through `indices` of all of the buffers in the registry, see
+  // ManagedBuffer::refreshIndexedViews()
+  void refreshIndexedViews(ManagedBuffer<uint32_t>& indices);
+
   // clang-format off
   ManagedBufferMap<float>        managedBufferMap_float;
   ManagedBufferMap<double>       managedBufferMap_double;
@@ -290,6 +466,10 @@ public:
   // clang-format on
 };
 
+// Free the host copies of buffers with HostResidency::DropAfterUpload which were uploaded this frame, called by the
+// main loop
+void processHostBufferDrops();
+
 } // namespace render
 
 std::string typeName(ManagedBufferType type);
@@ -72,5 +72,22 @@ bool ManagedBufferMap<T>::hasManagedBuffer(std::string name) {
   return false;
 }
 
+template <typename T>
+MemoryUsage ManagedBufferMap<T>::getMemoryUsage() {
+  MemoryUsage usage;
+  usage.overheadBytes = allBuffers.capacity() * sizeof(ManagedBuffer<T>*);
+  for (ManagedBuffer<T>* buff : allBuffers) {
+    usage += buff->getMemoryUsage();
+  }
+  return usage;
+}
+
+template <typename T>
+void ManagedBufferMap<T>::refreshIndexedViews(ManagedBuffer<uint32_t>& indices) {
+  for (ManagedBuffer<T>* buff : allBuffers) {
+    buff->refreshIndexedViews(indices);
+  }
+}
+
 } // namespace render
 } // namespace polyscope
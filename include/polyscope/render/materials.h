@@ -29,13 +29,17 @@ namespace render {
 class TextureBuffer;
 class ShaderProgram;
 
-// Materials have _r, _g, _b, _k textures for blending with arbitrary surface colors.
+// Materials have _r, _g, _b, _k textures for blending with arbitrary surface colors. The built-in matcap materials
+// instead live in layers of the engine's shared material texture array (see Engine::materialTextureArray), so that
+// programs do not depend on which of them is used.
 struct Material {
   std::string name;
   bool supportsRGB = false;
   std::array<std::shared_ptr<TextureBuffer>, 4> textureBuffers;
+  std::array<int, 4> arrayLayers{{-1, -1, -1, -1}}; // layers of the _r, _g, _b, _k images, or -1 if not in the array
   std::vector<std::string> rules;                  // substitution rules to add to shaders
   std::function<void(ShaderProgram&)> setUniforms; // function to set uniforms for shaders
+  std::function<void()> loadTextures;              // if non-null, fills textureBuffers on first use (getMaterial())
 };
 
 // Build an ImGui option picker in a dropdown ui
@@ -38,6 +38,27 @@ public:
   void setData(const std::vector<std::array<glm::vec3, 2>>& data) override;
   void setData(const std::vector<std::array<glm::vec3, 3>>& data) override;
   void setData(const std::vector<std::array<glm::vec3, 4>>& data) override;
+  void setDataFromPointer(const void* data, size_t nElements) override;
+
+  // Update a sub-range of an already-filled buffer
+  // clang-format off
+  void setDataRange(const std::vector<glm::vec2>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<glm::vec3>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<glm::vec4>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<float>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<double>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<int32_t>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<uint32_t>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<glm::uvec2>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<glm::uvec3>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<glm::uvec4>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<std::array<glm::vec3, 2>>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<std::array<glm::vec3, 3>>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<std::array<glm::vec3, 4>>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  // clang-format on
+
+  void resizePreservingData(size_t newSize) override;
+  void reserve(size_t capacity) override;
 
   // get data at a single index from the buffer
   float getData_float(size_t ind) override;
@@ -73,6 +94,10 @@ private:
   // internal implementation helpers
   template <typename T>
   void setData_helper(const std::vector<T>& data);
+  void setDataBytes_helper(const void* bytes, size_t nElements, size_t elementBytes);
+
+  template <typename T>
+  void setDataRange_helper(const std::vector<T>& data, size_t dataStart, size_t bufferStart, size_t count);
 
   template <typename T>
   T getData_helper(size_t ind);
@@ -97,6 +122,12 @@ public:
   GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, unsigned int sizeZ_,
                   const float* data);
 
+  // wrap an existing 2D texture which is owned elsewhere, see Engine::wrapExternalTexture()
+  struct ExternalHandle {
+    uint32_t handle;
+  };
+  GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, ExternalHandle externalHandle);
+
   ~GLTextureBuffer() override;
 
 
@@ -125,6 +156,11 @@ public:
   void setData(const std::vector<std::array<glm::vec3, 2>>& data) override;
   void setData(const std::vector<std::array<glm::vec3, 3>>& data) override;
   void setData(const std::vector<std::array<glm::vec3, 4>>& data) override;
+  void setDataRect(const void* data, int nChannels, PixelComponentType componentType, unsigned int x, unsigned int y,
+                   unsigned int w, unsigned int h) override;
+  void setDataBox(const void* data, int nChannels, PixelComponentType componentType, unsigned int x, unsigned int y,
+                  unsigned int z, unsigned int w, unsigned int h, unsigned int d) override;
+  void setDataFromDeviceBuffer(uint32_t nativeBufferHandle, int nChannels, PixelComponentType componentType) override;
 
   void setFilterMode(FilterMode newMode) override;
   void* getNativeHandle() override;
@@ -133,6 +169,7 @@ public:
   std::vector<float> getDataScalar() override;
   std::vector<glm::vec2> getDataVector2() override;
   std::vector<glm::vec3> getDataVector3() override;
+  std::vector<glm::vec4> getDataVector4() override;
 
   void bind();
 
@@ -178,7 +215,11 @@ public:
   // Query pixels
   std::vector<unsigned char> readBuffer() override;
   std::array<float, 4> readFloat4(int xPos, int yPos) override;
+  std::vector<float> readFloat4Region(int xPos, int yPos, int width, int height) override;
+  std::array<uint32_t, 2> readUInt2(int xPos, int yPos) override;
+  std::vector<uint32_t> readUInt2Region(int xPos, int yPos, int width, int height) override;
   float readDepth(int xPos, int yPos) override;
+  std::vector<float> readDepthBuffer() override;
   void blitTo(FrameBuffer* other) override;
 
   // Getters
@@ -198,6 +239,7 @@ struct GLShaderAttribute {
   std::string name;
   RenderDataType type;
   int arrayCount;
+  bool perInstance; // advanced once per instance, rather than once per vertex
   std::shared_ptr<GLAttributeBuffer> buff; // the buffer that we will actually use
 };
 
@@ -261,6 +303,23 @@ public:
   void setUniform(std::string name, glm::uvec3 val) override;
   void setUniform(std::string name, glm::uvec4 val) override;
 
+  // clang-format off
+  UniformHandle getUniformHandle(std::string name) override;
+  void setUniform(UniformHandle handle, int val) override;
+  void setUniform(UniformHandle handle, unsigned int val) override;
+  void setUniform(UniformHandle handle, float val) override;
+  void setUniform(UniformHandle handle, double val) override; // WARNING casts down to float
+  void setUniform(UniformHandle handle, float* val) override;
+  void setUniform(UniformHandle handle, glm::vec2 val) override;
+  void setUniform(UniformHandle handle, glm::vec3 val) override;
+  void setUniform(UniformHandle handle, glm::vec4 val) override;
+  void setUniform(UniformHandle handle, std::array<float, 3> val) override;
+  void setUniform(UniformHandle handle, float x, float y, float z, float w) override;
+  void setUniform(UniformHandle handle, glm::uvec2 val) override;
+  void setUniform(UniformHandle handle, glm::uvec3 val) override;
+  void setUniform(UniformHandle handle, glm::uvec4 val) override;
+  // clang-format on
+
   // = Attributes
   // clang-format off
   bool hasAttribute(std::string name) override;
@@ -294,6 +353,7 @@ public:
 
   // Draw!
   void draw() override;
+  void drawSubset(AttributeBuffer& elementOrder, const std::vector<std::array<size_t, 2>>& ranges) override;
   void validateData() override;
 
 protected:
@@ -306,6 +366,9 @@ private:
   // Setup routines
   void compileGLProgram(const std::vector<ShaderStageSpecification>& stages);
   void setDataLocations();
+
+  // Uniform lookup
+  GLShaderUniform& resolveUniform(UniformHandle handle, RenderDataType type);
   void bindVAO();
   void createBuffers();
   void ensureBufferExists(GLShaderAttribute& a);
@@ -379,6 +442,8 @@ public:
   std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_,
                                                        unsigned int sizeZ_,
                                                        const float* data) override; // 3d
+  std::shared_ptr<TextureBuffer> wrapExternalTexture(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_,
+                                                     uint32_t nativeHandle) override;
 
   // create render buffers
   std::shared_ptr<RenderBuffer> generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
@@ -404,13 +469,11 @@ public:
   virtual void setFrontFaceCCW(bool newVal) override;
 
 protected:
-  // Helpers
-  virtual void createSlicePlaneFliterRule(std::string name) override;
-
   // Shader program & rule caches
   std::unordered_map<std::string, std::pair<std::vector<ShaderStageSpecification>, DrawMode>> registeredShaderPrograms;
   std::unordered_map<std::string, ShaderReplacementRule> registeredShaderRules;
   void populateDefaultShadersAndRules();
+  bool shaderVariantAvailable(const ShaderProgramRequest& request) override;
 
   std::unordered_map<std::string, std::shared_ptr<GLCompiledProgram>> compiledProgamCache;
   std::string programKeyFromRules(const std::string& programName, const std::vector<std::string>& rules,
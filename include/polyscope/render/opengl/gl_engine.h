@@ -6,6 +6,8 @@
 #include "polyscope/render/engine.h"
 #include "polyscope/utilities.h"
 
+#include <functional>
+#include <map>
 #include <unordered_map>
 
 // Note: DO NOT include this header throughout polyscope, and do not directly make openGL calls. This header should only
@@ -41,13 +43,26 @@ typedef GLint UniformLocation;
 typedef GLint AttributeLocation;
 typedef GLint TextureLocation;
 
+// Small static attribute buffers (see options::suballocateSmallBuffers) do not get a GL buffer object of their own.
+// Their data lives in a range of a large arena buffer shared with other small buffers, which they move out of when
+// they grow too large, or are used in a way that needs a whole buffer.
 class GLAttributeBuffer : public AttributeBuffer {
 public:
   GLAttributeBuffer(RenderDataType dataType_, int arrayCount_);
   virtual ~GLAttributeBuffer();
 
+  // Bind the buffer which holds the data to GL_ARRAY_BUFFER. The data starts at getByteOffset() in it.
   void bind();
-  VertexBufferHandle getHandle() const { return VBOLoc; }
+  VertexBufferHandle getStorageHandle() const { return VBOLoc; }
+  size_t getByteOffset() const { return arenaOffset; }
+
+  // Incremented whenever the data moves to a different buffer or offset, so anything which recorded the location (e.g.
+  // a VAO) knows to bind it again
+  uint64_t getStorageVersion() const { return storageVersion; }
+
+  // A buffer object holding just this data, at offset 0, for uses which need a whole buffer (index buffers, buffer
+  // textures, transform feedback). Moves the data out of its arena if needed.
+  VertexBufferHandle getHandle();
 
   void setData(const std::vector<glm::vec2>& data) override;
   void setData(const std::vector<glm::vec3>& data) override;
@@ -66,6 +81,27 @@ public:
   void setData(const std::vector<std::array<glm::vec3, 2>>& data) override;
   void setData(const std::vector<std::array<glm::vec3, 3>>& data) override;
   void setData(const std::vector<std::array<glm::vec3, 4>>& data) override;
+  void setDataFromPointer(const void* data, size_t nElements) override;
+
+  // Update a sub-range of an already-filled buffer
+  // clang-format off
+  void setDataRange(const std::vector<glm::vec2>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<glm::vec3>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<glm::vec4>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<float>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<double>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<int32_t>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<uint32_t>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<glm::uvec2>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<glm::uvec3>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<glm::uvec4>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<std::array<glm::vec3, 2>>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<std::array<glm::vec3, 3>>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  void setDataRange(const std::vector<std::array<glm::vec3, 4>>& data, size_t dataStart, size_t bufferStart, size_t count) override;
+  // clang-format on
+
+  void resizePreservingData(size_t newSize) override;
+  void reserve(size_t capacity) override;
 
   // get data at a single index from the buffer
   float getData_float(size_t ind) override;
@@ -93,24 +129,58 @@ public:
 
   uint32_t getNativeBufferID() override;
 
+  // Size the buffer to hold nElements entries without filling it, for contents which get written on the device (e.g.
+  // by transform feedback)
+  void allocateForDeviceWrite(size_t nElements);
+
+  void requestDataCopy() override;
+
 protected:
-  VertexBufferHandle VBOLoc;
+  VertexBufferHandle VBOLoc = 0; // the buffer holding the data, an arena if arenaBytes > 0
+  size_t arenaOffset = 0;
+  size_t arenaBytes = 0; // size of the range of the arena which is reserved for this buffer, 0 if not in an arena
+  uint64_t storageVersion = 0;
+  bool wholeBufferUse = false; // getHandle() has been used, keep to a buffer of its own from now on
+
+  // The copy from requestDataCopy(), valid while the content version matches
+  GLuint readbackBuffer = 0;
+  size_t readbackCapacity = 0;
+  size_t readbackBytes = 0;
+  uint64_t readbackContentVersion = 0;
+  GLsync readbackFence = nullptr;
 
 private:
   void checkType(RenderDataType targetType);
   void checkArray(int arrayCount);
   GLenum getTarget();
 
+  // Place the storage for `bytes` bytes in an arena if it is small enough, or in a buffer of its own otherwise. Returns
+  // true if the storage moved. The contents are copied over if preserveData.
+  bool placeStorage(uint64_t bytes, bool preserveData);
+  void moveToOwnBuffer(uint64_t bytes, bool preserveData);
+
 
   // internal implementation helpers
   template <typename T>
   void setData_helper(const std::vector<T>& data);
+  void setDataBytes_helper(const void* bytes, size_t nElements, size_t elementBytes);
+  void reallocatePreservingData(uint64_t newCapacity);
+
+  template <typename T>
+  void setDataRange_helper(const std::vector<T>& data, size_t dataStart, size_t bufferStart, size_t count);
 
   template <typename T>
   T getData_helper(size_t ind);
 
   template <typename T>
   std::vector<T> getDataRange_helper(size_t start, size_t count);
+
+  // Read bytes [byteStart, byteStart + nBytes) of the data from the copy made by requestDataCopy(), waiting for it to
+  // land if needed. Returns false if there is no current copy.
+  bool readFromDataCopy(size_t byteStart, size_t nBytes, void* dst);
+
+  // Read bytes of the data, from the copy if there is a current one, otherwise directly from the buffer
+  void readDataBytes(size_t byteStart, size_t nBytes, void* dst);
 };
 
 class GLTextureBuffer : public TextureBuffer {
@@ -129,6 +199,12 @@ public:
   GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, unsigned int sizeZ_,
                   const float* data);
 
+  // wrap an existing 2D texture which is owned elsewhere, see Engine::wrapExternalTexture()
+  struct ExternalHandle {
+    TextureBufferHandle handle;
+  };
+  GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, ExternalHandle externalHandle);
+
   ~GLTextureBuffer() override;
 
 
@@ -157,6 +233,11 @@ public:
   void setData(const std::vector<std::array<glm::vec3, 2>>& data) override;
   void setData(const std::vector<std::array<glm::vec3, 3>>& data) override;
   void setData(const std::vector<std::array<glm::vec3, 4>>& data) override;
+  void setDataRect(const void* data, int nChannels, PixelComponentType componentType, unsigned int x, unsigned int y,
+                   unsigned int w, unsigned int h) override;
+  void setDataBox(const void* data, int nChannels, PixelComponentType componentType, unsigned int x, unsigned int y,
+                  unsigned int z, unsigned int w, unsigned int h, unsigned int d) override;
+  void setDataFromDeviceBuffer(uint32_t nativeBufferHandle, int nChannels, PixelComponentType componentType) override;
 
   void setFilterMode(FilterMode newMode) override;
   void* getNativeHandle() override;
@@ -165,6 +246,7 @@ public:
   std::vector<float> getDataScalar() override;
   std::vector<glm::vec2> getDataVector2() override;
   std::vector<glm::vec3> getDataVector3() override;
+  std::vector<glm::vec4> getDataVector4() override;
 
   void bind();
   GLenum textureType();
@@ -173,6 +255,13 @@ public:
 
 protected:
   TextureBufferHandle handle;
+
+  // Streaming uploads are copied in to a pixel unpack buffer, which is orphaned on each upload so the copy never waits
+  // on the GPU, and the transfer to the texture happens asynchronously. beginUpload() returns the pointer to pass to
+  // glTexSubImage*(), call endUpload() after.
+  VertexBufferHandle uploadPBO = 0;
+  const void* beginUpload(const void* data, size_t nBytes);
+  void endUpload();
 };
 
 class GLRenderBuffer : public RenderBuffer {
@@ -215,14 +304,53 @@ public:
   // Query pixels
   std::vector<unsigned char> readBuffer() override;
   std::array<float, 4> readFloat4(int xPos, int yPos) override;
+  std::vector<float> readFloat4Region(int xPos, int yPos, int width, int height) override;
+  std::array<uint32_t, 2> readUInt2(int xPos, int yPos) override;
+  std::vector<uint32_t> readUInt2Region(int xPos, int yPos, int width, int height) override;
   float readDepth(int xPos, int yPos) override;
+  std::vector<float> readDepthBuffer() override;
   void blitTo(FrameBuffer* other) override;
 
+  // Asynchronous reads go through a pixel pack buffer, and are complete once the fence is signaled
+  void requestReadFloat4(int xPos, int yPos) override;
+  bool pollReadFloat4(std::array<float, 4>& result) override;
+  bool hasPendingReadFloat4() override;
+  void requestReadUInt2(int xPos, int yPos) override;
+  bool pollReadUInt2(std::array<uint32_t, 2>& result) override;
+  bool hasPendingReadUInt2() override;
+  uint64_t requestReadBuffer() override;
+  bool pollReadBuffer(uint64_t ticket, std::vector<unsigned char>& result, bool wait = false) override;
+  void requestReadDepthBuffer(int stride = 1) override;
+  bool pollReadDepthBuffer(std::vector<float>& result) override;
+
   // Getters
   FrameBufferHandle getHandle() const { return handle; }
   uint32_t getNativeBufferID() override;
 
   FrameBufferHandle handle;
+
+protected:
+  GLuint readPixelBuffer = 0;
+  GLsync readFence = nullptr;
+  void requestReadPixel(int xPos, int yPos, GLenum format, GLenum type);
+  bool pollReadPixel(void* result, size_t nBytes);
+
+  // Whole-buffer reads in flight, and pack buffers from finished reads which can be reused
+  struct PendingBufferRead {
+    GLuint pixelBuffer;
+    GLsync fence;
+    size_t nBytes;
+  };
+  std::map<uint64_t, PendingBufferRead> pendingBufferReads;
+  std::vector<std::pair<GLuint, size_t>> freeReadPixelBuffers; // buffer and its size in bytes
+
+  // The depth read in flight, the full buffer is transferred and subsampled when it is mapped
+  GLuint readDepthPixelBuffer = 0;
+  size_t readDepthPixelBufferBytes = 0;
+  GLsync readDepthFence = nullptr;
+  int readDepthSizeX = 0;
+  int readDepthSizeY = 0;
+  int readDepthStride = 1;
 };
 
 // Classes to keep track of attributes and uniforms
@@ -237,8 +365,10 @@ struct GLShaderAttribute {
   std::string name;
   RenderDataType type;
   int arrayCount;
+  bool perInstance; // advanced once per instance, rather than once per vertex
   AttributeLocation location;              // -1 means "no location", usually because it was optimized out
   std::shared_ptr<GLAttributeBuffer> buff; // the buffer that we will actually use
+  uint64_t boundStorageVersion;            // buff->getStorageVersion() when it was bound in the VAO
 };
 
 struct GLShaderTexture {
@@ -255,7 +385,9 @@ struct GLShaderTexture {
 // This class takes ownership and handles program deletion in its destructor
 class GLCompiledProgram {
 public:
-  GLCompiledProgram(const std::vector<ShaderStageSpecification>& stages, DrawMode dm);
+  // If cacheKey is non-empty and options::shaderCacheDirectory is set, the linked program binary is loaded from / saved
+  // to the on-disk cache under that key, rather than always compiling from source.
+  GLCompiledProgram(const std::vector<ShaderStageSpecification>& stages, DrawMode dm, const std::string& cacheKey = "");
   ~GLCompiledProgram();
 
   ProgramHandle getHandle() const { return programHandle; }
@@ -263,6 +395,18 @@ public:
   std::vector<GLShaderUniform> getUniforms() const { return uniforms; }
   std::vector<GLShaderAttribute> getAttributes() const { return attributes; }
   std::vector<GLShaderTexture> getTextures() const { return textures; }
+  bool getUsesFrameUniforms() const { return usesFrameUniforms; } // reads the engine's per-frame uniform block
+
+  // With options::asyncShaderCompilation the program may still be linking after construction, and the locations above
+  // are not known yet. isReady() checks without blocking and finishes setup once the driver is done, waitUntilReady()
+  // blocks until then.
+  bool isReady();
+  void waitUntilReady();
+
+  // Record the value written to a uniform (indexed as in getUniforms()), returns false if the program already holds
+  // exactly this value. The cache lives here rather than in GLShaderProgram because uniform values belong to the GL
+  // program, which is shared by every GLShaderProgram created from it.
+  bool updateUniformValue(size_t iUniform, const void* valBytes, size_t nBytes);
 
 private:
   ProgramHandle programHandle;
@@ -270,9 +414,24 @@ private:
   std::vector<GLShaderUniform> uniforms;
   std::vector<GLShaderAttribute> attributes;
   std::vector<GLShaderTexture> textures;
-
-  void compileGLProgram(const std::vector<ShaderStageSpecification>& stages);
+  std::vector<std::array<uint32_t, 16>> uniformValues;
+  std::vector<bool> uniformValueValid;
+  bool usesFrameUniforms = false;
+
+  // State of a link which has been started but not finished
+  bool linkPending = false;
+  std::vector<ShaderHandle> pendingShaders;
+  std::vector<std::string> pendingShaderSources; // for error messages
+  std::string pendingCacheIdentity;              // empty if it should not be saved to the disk cache
+
+  void beginCompileGLProgram(const std::vector<ShaderStageSpecification>& stages, bool retrievable);
+  void finishCompileGLProgram();
   void setDataLocations();
+  void applyUniformValues(); // write values which were set while the link was pending
+
+  // On-disk program binary cache, the identity fully describes the program and driver it was built for
+  bool loadCachedGLProgram(const std::string& cacheIdentity);
+  void saveCachedGLProgram(const std::string& cacheIdentity);
 
   void addUniqueAttribute(ShaderSpecAttribute attribute);
   void addUniqueUniform(ShaderSpecUniform uniform);
@@ -304,6 +463,23 @@ public:
   void setUniform(std::string name, glm::uvec3 val) override;
   void setUniform(std::string name, glm::uvec4 val) override;
 
+  // clang-format off
+  UniformHandle getUniformHandle(std::string name) override;
+  void setUniform(UniformHandle handle, int val) override;
+  void setUniform(UniformHandle handle, unsigned int val) override;
+  void setUniform(UniformHandle handle, float val) override;
+  void setUniform(UniformHandle handle, double val) override; // WARNING casts down to float
+  void setUniform(UniformHandle handle, float* val) override;
+  void setUniform(UniformHandle handle, glm::vec2 val) override;
+  void setUniform(UniformHandle handle, glm::vec3 val) override;
+  void setUniform(UniformHandle handle, glm::vec4 val) override;
+  void setUniform(UniformHandle handle, std::array<float, 3> val) override;
+  void setUniform(UniformHandle handle, float x, float y, float z, float w) override;
+  void setUniform(UniformHandle handle, glm::uvec2 val) override;
+  void setUniform(UniformHandle handle, glm::uvec3 val) override;
+  void setUniform(UniformHandle handle, glm::uvec4 val) override;
+  // clang-format on
+
   // = Attributes
   // clang-format off
   bool hasAttribute(std::string name) override;
@@ -338,6 +514,7 @@ public:
 
   // Draw!
   void draw() override;
+  void drawSubset(AttributeBuffer& elementOrder, const std::vector<std::array<size_t, 2>>& ranges) override;
   void validateData() override;
 
 protected:
@@ -354,11 +531,46 @@ private:
   void createBuffers();
   void ensureBufferExists(GLShaderAttribute& a);
   void createBuffer(GLShaderAttribute& a);
-  void assignBufferToVAO(GLShaderAttribute& a);
+  // Point the VAO at the attribute's buffer, or at an entry of an interleaved buffer if sourceVBO is given
+  void assignBufferToVAO(GLShaderAttribute& a, VertexBufferHandle sourceVBO = 0, size_t stride = 0,
+                         size_t offset = 0);
+
+  // Interleaved attributes, see options::interleaveVertexAttributes
+  struct InterleavedAttribute {
+    size_t attributeIndex;
+    std::shared_ptr<GLAttributeBuffer> buff; // the buffer the values were copied from
+    uint64_t contentVersion;                 // ...and its version at the time
+  };
+  void updateAttributeBindings();     // called before each draw, re-binds buffers which moved
+  void updateInterleavedAttributes(); // called before each draw
+  void interleaveAttributes();
+  void releaseInterleavedAttributes();
+  std::vector<InterleavedAttribute> interleavedAttributes;
+  VertexBufferHandle interleavedVBO = 0;
+  bool interleaveAttempted = false;
 
   // Drawing related
   void activateTextures();
 
+  // While the compiled program is still linking, locations hold a placeholder and nothing is drawn. Returns true once
+  // the program is ready, after copying the real locations over.
+  bool ensureProgramReady();
+  bool locationsPending = false;
+
+  // Uniform lookup
+  std::unordered_map<std::string, int32_t> uniformIndices; // name --> index in `uniforms`
+  GLShaderUniform* resolveUniform(UniformHandle handle, RenderDataType type); // null if optimized out
+
+  // Values set under a UniformRecording, sent by the next draw. Returns true if the value was recorded.
+  struct RecordedUniform {
+    int32_t index;
+    size_t nBytes;
+    std::array<uint32_t, 16> value;
+  };
+  std::vector<RecordedUniform> recordedUniforms;
+  bool deferUniformValue(int32_t index, const void* val, size_t nBytes);
+  void applyRecordedUniforms();
+
   // GL pointers for various useful things
   std::shared_ptr<GLCompiledProgram> compiledProgram;
   AttributeHandle vaoHandle;
@@ -381,6 +593,18 @@ public:
   void setColorMask(std::array<bool, 4> mask = {true, true, true, true}) override;
   void setBackfaceCull(bool newVal) override;
 
+  // The render state setters above and texture binds shadow the GL state, and skip changes which would do nothing.
+  // Code which changes that state with direct GL calls (e.g. the ImGui backend) must invalidate the cache afterwards.
+  void invalidateStateCache();
+  void invalidateDepthBlendStateCache();
+
+  // Bind a texture to a texture unit, unless it is bound there already
+  void bindTextureToUnit(uint32_t unit, GLTextureBuffer& texture);
+
+  // Used by GLTextureBuffer to keep the texture binding cache in sync
+  void recordTextureBind(GLenum target, TextureBufferHandle handle); // on the active texture unit
+  void forgetTextureBindings(TextureBufferHandle handle);              // when the texture is deleted
+
 
   // === Factory methods
 
@@ -402,6 +626,8 @@ public:
   std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_,
                                                        unsigned int sizeZ_,
                                                        const float* data) override; // 3d
+  std::shared_ptr<TextureBuffer> wrapExternalTexture(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_,
+                                                     uint32_t nativeHandle) override;
 
   // create render buffers
   std::shared_ptr<RenderBuffer> generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
@@ -413,6 +639,33 @@ public:
   std::shared_ptr<ShaderProgram>
   requestShader(const std::string& programName, const std::vector<std::string>& customRules,
                 ShaderReplacementDefaults defaults = ShaderReplacementDefaults::SceneObject) override;
+  void prewarmShaders(const std::vector<ShaderProgramRequest>& programs) override;
+  bool shaderCompilesPending() override;
+
+  // device-side gather via transform feedback
+  bool gatherAttributeBufferOnDevice(AttributeBuffer& src, AttributeBuffer& indices, AttributeBuffer& dst) override;
+  bool computeMeshNormalsOnDevice(AttributeBuffer& positions, AttributeBuffer& faceStart, AttributeBuffer& faceVerts,
+                                  AttributeBuffer& vertexFaceStart, AttributeBuffer& vertexFaces,
+                                  AttributeBuffer* faceNormals, AttributeBuffer* vertexNormals) override;
+
+  // device-side reductions, by drawing one point per value in to a small float target with blending
+  bool computeFiniteRangeOnDevice(AttributeBuffer& values, std::pair<double, double>& range) override;
+  bool computeFiniteRangeOnDevice(TextureBuffer& values, std::pair<double, double>& range) override;
+  bool computeHistogramOnDevice(AttributeBuffer& values, std::pair<double, double> range, size_t nBins,
+                                std::vector<double>& binCounts) override;
+  bool computeHistogramOnDevice(TextureBuffer& values, std::pair<double, double> range, size_t nBins,
+                                std::vector<double>& binCounts) override;
+
+  uint32_t getMaxTextureSize3D() override;
+
+  // occlusion queries
+  bool beginSamplesPassedQuery() override;
+  size_t endSamplesPassedQuery() override;
+
+  // timer queries
+  uint64_t recordGPUTimestamp() override;
+  bool pollGPUTimestamp(uint64_t ticket, uint64_t& nanoseconds) override;
+  void discardGPUTimestamp(uint64_t ticket) override;
 
   // === Implementation details
 
@@ -427,13 +680,19 @@ public:
   virtual void setFrontFaceCCW(bool newVal) override;
 
 protected:
-  // Helpers
-  virtual void createSlicePlaneFliterRule(std::string name) override;
+  // Resolve the GL entry points which are used when available but are not part of the 3.3 core profile (e.g. program
+  // binaries). Called by the windowing backends once a context is current, with their platform's proc address lookup.
+  void loadOptionalGLFunctions(const std::function<void*(const char*)>& getProcAddress);
+
+  // Per-frame uniform block
+  virtual void uploadFrameUniforms() override;
+  VertexBufferHandle frameUniformBuffer = 0;
 
   // Shader program & rule caches
   std::unordered_map<std::string, std::pair<std::vector<ShaderStageSpecification>, DrawMode>> registeredShaderPrograms;
   std::unordered_map<std::string, ShaderReplacementRule> registeredShaderRules;
   void populateDefaultShadersAndRules();
+  bool shaderVariantAvailable(const ShaderProgramRequest& request) override;
 
   std::unordered_map<std::string, std::shared_ptr<GLCompiledProgram>> compiledProgamCache;
   std::string programKeyFromRules(const std::string& programName, const std::vector<std::string>& rules,
@@ -441,6 +700,48 @@ protected:
   std::shared_ptr<GLCompiledProgram> getCompiledProgram(const std::string& programName,
                                                         const std::vector<std::string>& customRules,
                                                         ShaderReplacementDefaults defaults);
+
+  // Transform feedback programs which copy elements of nWords 32-bit words, used for device-side gathers
+  std::unordered_map<int, ProgramHandle> indexGatherPrograms;
+  ProgramHandle getIndexGatherProgram(int nWords);
+
+  // Transform feedback programs for computeMeshNormalsOnDevice(), and scratch buffers holding the per-face outputs
+  // which are not kept (area-weighted normals, and the face normals themselves if they were not requested)
+  ProgramHandle meshFaceNormalProgram = 0;
+  ProgramHandle meshVertexNormalProgram = 0;
+  void ensureMeshNormalPrograms();
+  VertexBufferHandle meshNormalScratch[2] = {0, 0};
+  size_t meshNormalScratchBytes[2] = {0, 0};
+
+  // Programs for the device-side reductions, keyed by where the values come from: 0 for an attribute buffer, otherwise
+  // the dimension of the texture. runValueReduction() draws the values of exactly one of the sources in to a
+  // targetWidth x 1 RGBA32F target, blending with GL_MAX for the min/max (as max and -min) or adding for histograms.
+  std::unordered_map<int, ProgramHandle> valueReductionPrograms;
+  ProgramHandle getValueReductionProgram(int sourceDim);
+  bool runValueReduction(AttributeBuffer* attributeValues, TextureBuffer* textureValues, bool histogram,
+                         std::pair<double, double> range, size_t targetWidth, std::vector<float>& result);
+
+  // Query object reused by begin/endSamplesPassedQuery(), allocated on first use
+  GLuint samplesPassedQuery = 0;
+
+  // Timestamp queries which have been issued, by ticket, and finished ones which can be reused
+  uint64_t nextTimestampTicket = 1;
+  std::unordered_map<uint64_t, GLuint> pendingTimestampQueries;
+  std::vector<GLuint> freeTimestampQueries;
+
+  // Shadowed render state, see invalidateStateCache()
+  bool depthModeKnown = false;
+  DepthMode currDepthMode = DepthMode::Less;
+  bool blendModeKnown = false;
+  BlendMode currBlendMode = BlendMode::Disable;
+  bool colorMaskKnown = false;
+  std::array<bool, 4> currColorMask = {{true, true, true, true}};
+  bool backfaceCullKnown = false;
+  bool currBackfaceCull = false;
+  bool activeTextureUnitKnown = false;
+  uint32_t activeTextureUnit = 0;
+  std::vector<std::pair<GLenum, TextureBufferHandle>> boundTextures; // by texture unit, {0, 0} if unknown
+  void setActiveTextureUnit(uint32_t unit);
 };
 
 } // namespace backend_openGL3
@@ -73,6 +73,10 @@ protected:
   // Internal windowing and engine details
   EGLDisplay eglDisplay;
   EGLContext eglContext;
+
+  // The GUI is only drawn while it is streamed to a remote viewer, see remote.h
+  bool imguiRendererInitialized = false;
+  bool imguiDrawnThisFrame = false;
 };
 
 } // namespace backend_openGL3
@@ -54,6 +54,8 @@ public:
 
   void makeContextCurrent() override;
   void pollEvents() override;
+  void waitEvents(double timeoutSeconds) override;
+  void wakeWaitEvents() override;
 
   void focusWindow() override;
   void showWindow() override;
@@ -63,6 +65,7 @@ public:
   void setWindowResizable(bool newVal) override;
   bool getWindowResizable() override;
   std::tuple<int, int> getWindowPos() override;
+  double getDisplayRefreshRate() override;
   bool windowRequestsClose() override;
 
   bool isKeyPressed(char c) override; // for lowercase a-z and 0-9 only
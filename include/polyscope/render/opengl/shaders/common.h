@@ -12,6 +12,10 @@ namespace backend_openGL3 {
 
 extern const char* shaderCommonSource;
 
+// Declaration of the per-frame uniform block, which shaders read camera state from (see GLEngine)
+extern const char* shaderFrameUniformBlockName;
+extern const char* shaderFrameUniformBlockSource;
+
 } // namespace backend_openGL3
 } // namespace render
 } // namespace polyscope
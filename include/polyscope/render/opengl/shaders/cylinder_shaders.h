@@ -13,6 +13,14 @@ extern const ShaderStageSpecification FLEX_CYLINDER_VERT_SHADER;
 extern const ShaderStageSpecification FLEX_CYLINDER_GEOM_SHADER;
 extern const ShaderStageSpecification FLEX_CYLINDER_FRAG_SHADER;
 
+// Variant over indexed line strips of the nodes, for curve networks stored as polylines (uses the same fragment shader)
+extern const ShaderStageSpecification FLEX_CYLINDER_STRIP_VERT_SHADER;
+extern const ShaderStageSpecification FLEX_CYLINDER_STRIP_GEOM_SHADER;
+
+// Instanced alternative to the geometry shader, one box-shaped instance per edge, with a thin-line level of detail
+extern const ShaderStageSpecification FLEX_CYLINDER_INSTANCED_VERT_SHADER;
+extern const ShaderStageSpecification FLEX_CYLINDER_INSTANCED_FRAG_SHADER;
+
 // Rules specific to cylinders
 extern const ShaderReplacementRule CYLINDER_PROPAGATE_VALUE;
 extern const ShaderReplacementRule CYLINDER_PROPAGATE_BLEND_VALUE;
@@ -21,6 +29,16 @@ extern const ShaderReplacementRule CYLINDER_PROPAGATE_BLEND_COLOR;
 extern const ShaderReplacementRule CYLINDER_PROPAGATE_PICK;
 extern const ShaderReplacementRule CYLINDER_CULLPOS_FROM_MID;
 extern const ShaderReplacementRule CYLINDER_VARIABLE_SIZE;
+extern const ShaderReplacementRule CYLINDER_KEYFRAME_POSITIONS;
+
+// Variants of the rules above for the instanced shaders
+extern const ShaderReplacementRule CYLINDER_INSTANCED_PROPAGATE_VALUE;
+extern const ShaderReplacementRule CYLINDER_INSTANCED_PROPAGATE_BLEND_VALUE;
+extern const ShaderReplacementRule CYLINDER_INSTANCED_PROPAGATE_COLOR;
+extern const ShaderReplacementRule CYLINDER_INSTANCED_PROPAGATE_BLEND_COLOR;
+extern const ShaderReplacementRule CYLINDER_INSTANCED_PROPAGATE_PICK;
+extern const ShaderReplacementRule CYLINDER_INSTANCED_VARIABLE_SIZE;
+extern const ShaderReplacementRule CYLINDER_INSTANCED_KEYFRAME_POSITIONS;
 
 
 } // namespace backend_openGL3
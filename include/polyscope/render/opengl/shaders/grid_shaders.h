@@ -16,9 +16,19 @@ extern const ShaderStageSpecification FLEX_GRIDCUBE_FRAG_SHADER;
 extern const ShaderStageSpecification FLEX_GRIDCUBE_PLANE_VERT_SHADER;
 extern const ShaderStageSpecification FLEX_GRIDCUBE_PLANE_FRAG_SHADER;
 
+// Raymarches the isosurface of node values stored in a 3D texture
+extern const ShaderStageSpecification FLEX_GRID_ISOSURFACE_VERT_SHADER;
+extern const ShaderStageSpecification FLEX_GRID_ISOSURFACE_FRAG_SHADER;
+
+// Direct volume rendering of values stored in a 3D texture, shares the isosurface vertex shader
+extern const ShaderStageSpecification FLEX_GRID_VOLUME_FRAG_SHADER;
+
 // Rules
 extern const ShaderReplacementRule GRIDCUBE_PROPAGATE_NODE_VALUE;
 extern const ShaderReplacementRule GRIDCUBE_PROPAGATE_CELL_VALUE;
+extern const ShaderReplacementRule GRIDCUBE_PROPAGATE_SPARSE_NODE_VALUE;
+extern const ShaderReplacementRule GRIDCUBE_PROPAGATE_SPARSE_CELL_VALUE;
+extern const ShaderReplacementRule GRIDCUBE_SPARSE_OCCUPANCY;
 extern const ShaderReplacementRule GRIDCUBE_WIREFRAME;
 extern const ShaderReplacementRule GRIDCUBE_CONSTANT_PICK;
 extern const ShaderReplacementRule GRIDCUBE_CULLPOS_FROM_CENTER;
@@ -14,7 +14,7 @@ extern const ShaderStageSpecification GROUND_PLANE_TILE_REFLECT_FRAG_SHADER;
 extern const ShaderStageSpecification GROUND_PLANE_SHADOW_FRAG_SHADER;
 
 // Rules
-// extern const ShaderReplacementRule RULE_NAME;
+extern const ShaderReplacementRule GROUND_REFLECT_SCREEN_SPACE;
 
 } // namespace backend_openGL3
 } // namespace render
@@ -16,13 +16,16 @@ extern const ShaderReplacementRule DOWNSAMPLE_RESOLVE_1;
 extern const ShaderReplacementRule DOWNSAMPLE_RESOLVE_2;
 extern const ShaderReplacementRule DOWNSAMPLE_RESOLVE_3;
 extern const ShaderReplacementRule DOWNSAMPLE_RESOLVE_4;
+extern const ShaderReplacementRule RESOLVE_FXAA;
 
 extern const ShaderReplacementRule INVERSE_TONEMAP;
 
 extern const ShaderReplacementRule TRANSPARENCY_RESOLVE_SIMPLE;
 extern const ShaderReplacementRule TRANSPARENCY_STRUCTURE;
 extern const ShaderReplacementRule TRANSPARENCY_PEEL_STRUCTURE;
+extern const ShaderReplacementRule TRANSPARENCY_WEIGHTED_STRUCTURE;
 extern const ShaderReplacementRule TRANSPARENCY_PEEL_GROUND;
+extern const ShaderReplacementRule DEPTH_PREPASS_STRUCTURE;
 
 } // namespace backend_openGL3
 } // namespace render
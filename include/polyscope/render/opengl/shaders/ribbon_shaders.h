@@ -12,6 +12,7 @@ namespace backend_openGL3 {
 extern const ShaderStageSpecification RIBBON_VERT_SHADER;
 extern const ShaderStageSpecification RIBBON_GEOM_SHADER;
 extern const ShaderStageSpecification RIBBON_FRAG_SHADER;
+extern const ShaderStageSpecification RIBBON_INSTANCED_VERT_SHADER;
 
 // Rules
 // extern const ShaderReplacementRule RULE_NAME;
@@ -13,7 +13,9 @@ namespace backend_openGL3 {
 extern const ShaderReplacementRule GLSL_VERSION;
 extern const ShaderReplacementRule GLOBAL_FRAGMENT_FILTER;
 extern const ShaderReplacementRule LIGHT_MATCAP;
+extern const ShaderReplacementRule LIGHT_MATCAP_ARRAY;
 extern const ShaderReplacementRule LIGHT_PASSTHRU;
+extern const ShaderReplacementRule PICK_OUTPUT_INDEX;
 
 
 // Shading color generation policies (colormapping, etc)
@@ -37,10 +39,16 @@ extern const ShaderReplacementRule GENERATE_VIEW_POS;          // computes viewP
 extern const ShaderReplacementRule PROJ_AND_INV_PROJ_MAT;
 extern const ShaderReplacementRule COMPUTE_SHADE_NORMAL_FROM_POSITION;
 extern const ShaderReplacementRule PREMULTIPLY_LIT_COLOR;
+
+// Keyframes
+extern const ShaderReplacementRule KEYFRAME_COMMON;
+extern const ShaderReplacementRule KEYFRAME_INDEX;
+extern const ShaderReplacementRule KEYFRAME_POSITION;
+extern const ShaderReplacementRule KEYFRAME_VALUE;
 extern const ShaderReplacementRule CULL_POS_FROM_VIEW;
 
-ShaderReplacementRule generateSlicePlaneRule(std::string uniquePostfix);
-ShaderReplacementRule generateVolumeGridSlicePlaneRule(std::string uniquePostfix);
+ShaderReplacementRule generateSlicePlaneRule();
+ShaderReplacementRule generateVolumeGridSlicePlaneRule();
 
 // clang-format on
 
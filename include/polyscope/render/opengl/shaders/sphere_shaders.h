@@ -13,6 +13,8 @@ extern const ShaderStageSpecification FLEX_SPHERE_VERT_SHADER;
 extern const ShaderStageSpecification FLEX_SPHERE_GEOM_SHADER;
 extern const ShaderStageSpecification FLEX_SPHERE_FRAG_SHADER;
 
+extern const ShaderStageSpecification FLEX_SPLAT_VERT_SHADER; // pairs with FLEX_SPHERE_FRAG_SHADER
+
 extern const ShaderStageSpecification FLEX_POINTQUAD_VERT_SHADER;
 extern const ShaderStageSpecification FLEX_POINTQUAD_GEOM_SHADER;
 extern const ShaderStageSpecification FLEX_POINTQUAD_FRAG_SHADER;
@@ -22,10 +24,19 @@ extern const ShaderReplacementRule SPHERE_PROPAGATE_VALUE;
 extern const ShaderReplacementRule SPHERE_PROPAGATE_VALUEALPHA;
 extern const ShaderReplacementRule SPHERE_PROPAGATE_VALUE2;
 extern const ShaderReplacementRule SPHERE_PROPAGATE_COLOR;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_SELECTION;
 extern const ShaderReplacementRule SPHERE_VARIABLE_SIZE;
 extern const ShaderReplacementRule SPHERE_CULLPOS_FROM_CENTER;
 extern const ShaderReplacementRule SPHERE_CULLPOS_FROM_CENTER_QUAD;
 
+// Variants of the rules above for the splat shaders
+extern const ShaderReplacementRule SPLAT_PROPAGATE_VALUE;
+extern const ShaderReplacementRule SPLAT_PROPAGATE_VALUEALPHA;
+extern const ShaderReplacementRule SPLAT_PROPAGATE_VALUE2;
+extern const ShaderReplacementRule SPLAT_PROPAGATE_COLOR;
+extern const ShaderReplacementRule SPLAT_PROPAGATE_SELECTION;
+extern const ShaderReplacementRule SPLAT_VARIABLE_SIZE;
+
 
 } // namespace backend_openGL3
 } // namespace render
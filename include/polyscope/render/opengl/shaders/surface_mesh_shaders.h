@@ -16,6 +16,9 @@ extern const ShaderStageSpecification FLEX_MESH_FRAG_SHADER;
 extern const ShaderStageSpecification SIMPLE_MESH_VERT_SHADER;
 extern const ShaderStageSpecification SIMPLE_MESH_FRAG_SHADER;
 
+// One mesh drawn once per instance, shares the simple mesh fragment shader
+extern const ShaderStageSpecification INSTANCED_MESH_VERT_SHADER;
+
 // Rules specific to meshes
 extern const ShaderReplacementRule MESH_WIREFRAME_FROM_BARY;
 extern const ShaderReplacementRule MESH_WIREFRAME;
@@ -31,10 +34,18 @@ extern const ShaderReplacementRule MESH_PROPAGATE_VALUE2;
 extern const ShaderReplacementRule MESH_PROPAGATE_TCOORD;
 extern const ShaderReplacementRule MESH_PROPAGATE_COLOR;
 extern const ShaderReplacementRule MESH_PROPAGATE_HALFEDGE_VALUE;
+extern const ShaderReplacementRule MESH_FETCH_VALUE;
+extern const ShaderReplacementRule MESH_FETCH_HALFEDGE_VALUE;
+extern const ShaderReplacementRule MESH_FETCH_COLOR;
+extern const ShaderReplacementRule MESH_PROPAGATE_SELECTION;
 extern const ShaderReplacementRule MESH_PROPAGATE_CULLPOS;
+extern const ShaderReplacementRule MESH_KEYFRAME_POSITIONS;
 extern const ShaderReplacementRule MESH_PROPAGATE_PICK;
 extern const ShaderReplacementRule MESH_PROPAGATE_PICK_SIMPLE;
 extern const ShaderReplacementRule MESH_PROPAGATE_TYPE_AND_BASECOLOR2_SHADE;
+extern const ShaderReplacementRule INSTANCED_MESH_PROPAGATE_COLOR;
+extern const ShaderReplacementRule INSTANCED_MESH_PROPAGATE_VALUE;
+extern const ShaderReplacementRule INSTANCED_MESH_PROPAGATE_PICK;
 
 
 } // namespace backend_openGL3
@@ -15,12 +15,16 @@ extern const ShaderStageSpecification SPHEREBG_DRAW_FRAG_SHADER;
 extern const ShaderStageSpecification PLAIN_TEXTURE_DRAW_FRAG_SHADER;
 extern const ShaderStageSpecification PLAIN_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER;
 extern const ShaderStageSpecification PLAIN_RAW_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER;
+extern const ShaderStageSpecification COMPOSITE_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER;
 extern const ShaderStageSpecification DOT3_TEXTURE_DRAW_FRAG_SHADER;
 extern const ShaderStageSpecification MAP3_TEXTURE_DRAW_FRAG_SHADER;
 extern const ShaderStageSpecification COMPOSITE_PEEL;
+extern const ShaderStageSpecification COMPOSITE_WEIGHTED;
+extern const ShaderStageSpecification TAA_RESOLVE;
 extern const ShaderStageSpecification DEPTH_COPY;
 extern const ShaderStageSpecification DEPTH_TO_MASK;
 extern const ShaderStageSpecification BLUR_RGB;
+extern const ShaderStageSpecification BLUR_RGBA;
 
 extern const ShaderStageSpecification SCALAR_TEXTURE_COLORMAP;
 
@@ -42,6 +46,8 @@ extern const ShaderReplacementRule TEXTURE_PROPAGATE_VALUE; // sample a scalar f
 extern const ShaderReplacementRule TEXTURE_PROPAGATE_COLOR; // sample a color from a texture and use it for shading
 extern const ShaderReplacementRule
     TEXTURE_BILLBOARD_FROM_UNIFORMS; // adjust a texture's billboard position via uniforms
+extern const ShaderReplacementRule
+    TEXTURE_TILE_FROM_UNIFORMS; // squeeze the texture quad in to the rectangle u_tileRect, before any billboard
 extern const ShaderReplacementRule SHADE_NORMAL_FROM_TEXTURE;
 extern const ShaderReplacementRule SHADE_NORMAL_FROM_VIEWPOS_VAR;
 
@@ -14,6 +14,10 @@ extern const ShaderStageSpecification FLEX_TANGENT_VECTOR_VERT_SHADER;
 extern const ShaderStageSpecification FLEX_VECTOR_GEOM_SHADER;
 extern const ShaderStageSpecification FLEX_VECTOR_FRAG_SHADER;
 
+// Instanced alternative to the geometry shader, one box-shaped instance per vector
+extern const ShaderStageSpecification FLEX_VECTOR_INSTANCED_VERT_SHADER;
+extern const ShaderStageSpecification FLEX_TANGENT_VECTOR_INSTANCED_VERT_SHADER;
+
 // Rules specific to cylinders
 extern const ShaderReplacementRule VECTOR_PROPAGATE_COLOR;
 extern const ShaderReplacementRule VECTOR_CULLPOS_FROM_TAIL;
@@ -45,20 +45,46 @@ std::shared_ptr<TextureBuffer> generateTextureBuffer(Engine* engine) {
 template <typename T>
 std::shared_ptr<TextureBuffer> generateTextureBuffer(DeviceBufferType D, Engine* engine);
 
-// Get a single data value from a texturebuffer of a templated type
-// (use std::array<T>s to get arraycount repeated attributes)
-// openGL doesn't support this anyway...
-// template <typename T, DeviceBufferType D>
-// T getTextureBufferData(TextureBuffer& buff, size_t indX, size_t indY = 0, size_t indZ = 0);
+// an empty texture of the given dimension D and format, regardless of the data type
+std::shared_ptr<TextureBuffer> generateTextureBuffer(DeviceBufferType D, TextureFormat format, Engine* engine);
 
-// Get a range of data values from a buffer of a templated type
-// (use std::array<T>s to get arraycount repeated attributes)
-template <typename T, DeviceBufferType D>
+// Number of channels of the texture format generateTextureBuffer<T>() uses for T, 0 if T cannot be a texture
+template <typename T>
+int textureChannelCount() {
+  return 0;
+}
+template <>
+inline int textureChannelCount<float>() {
+  return 1;
+}
+template <>
+inline int textureChannelCount<double>() {
+  return 1;
+}
+template <>
+inline int textureChannelCount<glm::vec3>() {
+  return 3;
+}
+template <>
+inline int textureChannelCount<glm::vec4>() {
+  return 4;
+}
+
+// Read back all the data in a texture buffer of a templated type. Only float, double, glm::vec2 and glm::vec4 are
+// supported, other types throw.
+template <typename T>
 std::vector<T> getTextureBufferData(TextureBuffer& buff) {
-  // TODO write these specializations
   exception("bad call"); // default implementation, should be specialized to use
   return std::vector<T>();
 }
+template <>
+std::vector<float> getTextureBufferData<float>(TextureBuffer& buff);
+template <>
+std::vector<double> getTextureBufferData<double>(TextureBuffer& buff);
+template <>
+std::vector<glm::vec2> getTextureBufferData<glm::vec2>(TextureBuffer& buff);
+template <>
+std::vector<glm::vec4> getTextureBufferData<glm::vec4>(TextureBuffer& buff);
 
 
 } // namespace render
@@ -19,6 +19,21 @@
 
 namespace polyscope {
 
+// One render image drawn as a layer of a composited pass, see drawCompositedRenderImages()
+struct RenderImageCompositeLayer {
+  enum class ColorMode { Texture = 0, Constant, ColorMap };
+
+  render::TextureBuffer* depth = nullptr;
+  render::TextureBuffer* normal = nullptr; // null if the image has no normals
+  render::TextureBuffer* color = nullptr;  // colors, or scalars to colormap; null for a constant color
+  ColorMode colorMode = ColorMode::Texture;
+  glm::vec3 baseColor{0., 0., 0.};
+  float rangeLow = 0.;
+  float rangeHigh = 1.;
+  int colormapRow = 0;
+  bool flipY = false;
+};
+
 class RenderImageQuantityBase : public FloatingQuantity, public FullscreenArtist {
 
 public:
@@ -38,8 +53,29 @@ public:
 
   void updateBaseBuffers(const std::vector<float>& newDepthData, const std::vector<glm::vec3>& newNormalData);
 
+  // == Device-side data
+  // For renders which already live on the GPU, e.g. from an external path tracer, these skip the round trip through
+  // host memory. With CUDA, register the OpenGL objects with cudaGraphicsGLRegisterImage() or
+  // cudaGraphicsGLRegisterBuffer() and write to them from a kernel.
+
+  // Draw straight from OpenGL textures of dimX x dimY (zero-copy). They are used in place, so they must outlive this
+  // quantity, or be replaced first. Depth has 1 channel, normals have 3 or 4. Call markDeviceDataUpdated() after
+  // writing new contents.
+  void setExternalDepthTexture(uint32_t glTextureName, TextureFormat format = TextureFormat::R32F);
+  void setExternalNormalTexture(uint32_t glTextureName, TextureFormat format = TextureFormat::RGBA32F);
+
+  // Copy from OpenGL buffer objects, on the device: dimX * dimY floats of depth, or of 3-float normals
+  void updateDepthsFromDeviceBuffer(uint32_t glBufferName);
+  void updateNormalsFromDeviceBuffer(uint32_t glBufferName);
+
+  virtual void markDeviceDataUpdated();
+
   virtual void disableFullscreenDrawing() override;
 
+  // Fill the layer this image contributes to a composited pass. Returns false if the image must be drawn in a pass of
+  // its own, e.g. because it is transparent.
+  virtual bool getCompositeLayer(RenderImageCompositeLayer& layer);
+
   // == Setters and getters
 
   virtual RenderImageQuantityBase* setEnabled(bool newEnabled) override;
@@ -73,10 +109,22 @@ protected:
   PersistentValue<float> transparency;
   PersistentValue<bool> allowFullscreenCompositing;
 
+  // Compositing
+  bool drawnComposited = false; // this frame, the image was drawn as part of a composited pass
+  std::shared_ptr<render::ShaderProgram> compositeProgram; // used when this image is the first layer of a pass
+  void drawComposite(const std::vector<RenderImageCompositeLayer>& layers);
+  friend void drawCompositedRenderImages();
+
   // Helpers
   void prepareGeometryBuffers();
   void addOptionsPopupEntries();
+  bool getBaseCompositeLayer(RenderImageCompositeLayer& layer);
 };
 
+// Draw all enabled, opaque render images which share a material in one fullscreen pass (per few images), which picks
+// the nearest image at each pixel, rather than one depth-tested pass per image. The images drawn this way skip their
+// own pass in drawDelayed(). Called before the delayed drawing of the structures. See options::compositeRenderImages.
+void drawCompositedRenderImages();
+
 
 } // namespace polyscope
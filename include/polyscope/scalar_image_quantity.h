@@ -23,6 +23,14 @@ public:
 
   virtual std::string niceName() override;
 
+  // Upload new values straight to the image texture, e.g. the frames of a live depth sensor. `pixels` holds tightly
+  // packed rows in the same order as the image data, one component of the given type per pixel. 8- and 16-bit
+  // components are read as [0,1] values. The uploads are staged so they do not stall rendering, and the float copy in
+  // `values` is only read back from the device if it is needed. The data range used for the color map is not updated.
+  void updatePixels(const void* pixels, PixelComponentType componentType);
+  // Same, for the w x h rectangle of pixels starting at (x, y)
+  void updatePixelsRect(const void* pixels, PixelComponentType componentType, size_t x, size_t y, size_t w, size_t h);
+
   // == Setters and getters
 
   virtual ScalarImageQuantity* setEnabled(bool newEnabled) override;
@@ -30,12 +38,14 @@ public:
 protected:
   // rendering internals
   std::shared_ptr<render::TextureBuffer> textureIntermediateRendered;
-  std::shared_ptr<render::ShaderProgram> fullscreenProgram, billboardProgram;
+  // One program draws the image fullscreen, in to the intermediate texture, and as a billboard, where fullscreen is
+  // the billboard spanning clip space. The color map and range are uniforms, so changing them never rebuilds it.
+  std::shared_ptr<render::ShaderProgram> program;
   std::shared_ptr<render::FrameBuffer> framebufferIntermediate;
 
-  void prepareFullscreen();
+  void prepare();
   void prepareIntermediateRender();
-  void prepareBillboard();
+  void setFullscreenUniforms();
 
   virtual void showFullscreen() override;
   virtual void showInImGuiWindow() override;
@@ -4,6 +4,7 @@
 
 #include "polyscope/affine_remapper.h"
 #include "polyscope/histogram.h"
+#include "polyscope/keyframes.h"
 #include "polyscope/persistent_value.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
@@ -18,7 +19,7 @@ namespace polyscope {
 template <typename QuantityT>
 class ScalarQuantity {
 public:
-  ScalarQuantity(QuantityT& quantity, const std::vector<float>& values, DataType dataType);
+  ScalarQuantity(QuantityT& quantity, std::vector<float> values, DataType dataType);
 
   // Build the ImGUI UIs for scalars
   void buildScalarUI();
@@ -29,10 +30,49 @@ public:
 
   // Set uniforms in rendering programs for scalars
   void setScalarUniforms(render::ShaderProgram& p);
+  void setColorMapUniforms(render::ShaderProgram& p); // included above, for programs which only use the color map
 
+  // Replace the values. The data range is kept, and the histogram is rebuilt lazily (see options::histogramRebuildPeriod).
+  // The render buffers and programs are reused, so this is the way to show values which change every frame, e.g. the
+  // state of a solver, rather than adding the quantity again. The colormap range stays fixed, call refreshDataRange()
+  // to fit it to the new values.
   template <class V>
   void updateData(const V& newValues);
 
+  // As above, from `count` contiguous floats, which are copied straight into the existing host buffer
+  void updateData(const float* newValues, size_t count);
+
+  // Replace the values [begin, begin + newValues.size()). While they stay within the data range the histogram is
+  // updated incrementally, and only the changed entries are uploaded.
+  template <class V>
+  void updateDataSubset(size_t begin, const V& newValues);
+
+  // Like updateData(), but may be called from any thread. The values are converted into a pooled vector on the calling
+  // thread and swapped in by the render thread at the next sync point, see stageUpdate().
+  template <class V>
+  void stageData(const V& newValues);
+
+  // Add values to the end, e.g. alongside PointCloud::appendPoints(). The data range (and the map range, unless it has
+  // been set manually) is widened to cover them.
+  template <class V>
+  void appendValues(const V& newValues);
+
+  // Use `count` floats in externally-owned memory as the values, without copying them (see
+  // ManagedBuffer::setExternalView()). The memory must stay valid while `lifetimeToken` is held.
+  void setValuesView(const float* viewData, size_t count, std::shared_ptr<void> lifetimeToken);
+
+  // Recompute the data range and histogram from the current values (the map range follows, unless it was set). When
+  // the values only live on the device, e.g. after values.beginDeviceWrite(), they are reduced there and just the
+  // results are read back. The UI does this itself when it sees values which were updated on the device.
+  void refreshDataRange();
+
+  // Keyframed values, played back on the GPU on the timeline of the parent structure (see
+  // Structure::setKeyframeTime()). The frames are read with the structure's keyframe index, so this only applies to
+  // quantities on the elements which carry the structure's positions (see e.g. PointCloud::addScalarKeyframes()). The
+  // data range is widened to cover all frames, `values` itself is unchanged.
+  void setValueKeyframes(const std::vector<std::vector<float>>& frames);
+  bool hasValueKeyframes() { return valueKeyframes != nullptr; }
+
   // === Members
   QuantityT& quantity;
 
@@ -51,6 +91,7 @@ public:
   std::pair<double, double> getMapRange();
   QuantityT* resetMapRange(); // reset to full range
   std::pair<double, double> getDataRange();
+  DataType getDataType() const { return dataType; }
 
   // Isolines
   QuantityT* setIsolinesEnabled(bool newEnabled);
@@ -67,10 +108,22 @@ protected:
   // === Visualization parameters
 
   // Affine data maps and limits
+  std::pair<double, double> dataFiniteRange; // min/max of the finite values, before robustRange() widening
   std::pair<double, double> dataRange;
+  bool dataRangeComputed = false;
+  void ensureDataRangeComputed();  // computes the ranges above on first use, rather than when the quantity is added
+  void setDefaultsFromDataRange(); // the map range and isoline width, unless they were set
+
+  // Like updateDataSubset(), for values on a dense 3D grid of dimension `dim`, x-fastest (e.g. on a volume grid),
+  // replacing the box [origin, origin + extent). Only the box is uploaded to the value texture.
+  void updateDataBox(glm::uvec3 dim, glm::uvec3 origin, glm::uvec3 extent, const std::vector<float>& newValues);
   PersistentValue<float> vizRangeMin;
   PersistentValue<float> vizRangeMax;
   Histogram hist;
+  bool histogramStale = false;       // rebuilt when next shown, after the values changed
+  double lastHistogramBuild = -1e30; // ImGui time of the last rebuild, for options::histogramRebuildPeriod
+  uint64_t rangeDataVersion = 0;     // values.getDataVersion() when the range was last computed on the device
+  std::unique_ptr<KeyframeSeries> valueKeyframes;
 
   // Parameters
   PersistentValue<std::string> cMap;
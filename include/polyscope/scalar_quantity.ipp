@@ -5,20 +5,37 @@
 namespace polyscope {
 
 template <typename QuantityT>
-ScalarQuantity<QuantityT>::ScalarQuantity(QuantityT& quantity_, const std::vector<float>& values_, DataType dataType_)
-    : quantity(quantity_), values(&quantity, quantity.uniquePrefix() + "values", valuesData), valuesData(values_),
-      dataType(dataType_), dataRange(robustMinMax(values.data, 1e-5)),
+ScalarQuantity<QuantityT>::ScalarQuantity(QuantityT& quantity_, std::vector<float> values_, DataType dataType_)
+    : quantity(quantity_), values(&quantity, quantity.uniquePrefix() + "values", valuesData),
+      valuesData(std::move(values_)), dataType(dataType_), dataFiniteRange(0., 0.), dataRange(0., 0.),
       vizRangeMin(quantity.uniquePrefix() + "vizRangeMin", -777.), // set later,
       vizRangeMax(quantity.uniquePrefix() + "vizRangeMax", -777.), // including clearing cache
       cMap(quantity.uniquePrefix() + "cmap", defaultColorMap(dataType)),
       isolinesEnabled(quantity.uniquePrefix() + "isolinesEnabled", false),
-      isolineWidth(quantity.uniquePrefix() + "isolineWidth",
-                   absoluteValue((dataRange.second - dataRange.first) * 0.02)),
+      isolineWidth(quantity.uniquePrefix() + "isolineWidth", absoluteValue(0.f)), // set with the data range
       isolineDarkness(quantity.uniquePrefix() + "isolineDarkness", 0.7)
 
 {
+  // The data range and histogram are computed when first needed, see ensureDataRangeComputed(), since many quantities
+  // are never shown
   hist.updateColormap(cMap.get());
-  hist.buildHistogram(values.data);
+  histogramStale = true;
+}
+
+template <typename QuantityT>
+void ScalarQuantity<QuantityT>::ensureDataRangeComputed() {
+  if (dataRangeComputed) return;
+  dataRangeComputed = true;
+
+  std::vector<float>& valuesRef = values.getPopulatedHostBufferRef();
+  dataFiniteRange = finiteMinMax(valuesRef.data(), valuesRef.size());
+  dataRange = robustRange(dataFiniteRange, 1e-5);
+  setDefaultsFromDataRange();
+}
+
+template <typename QuantityT>
+void ScalarQuantity<QuantityT>::setDefaultsFromDataRange() {
+  isolineWidth.setPassive(absoluteValue((dataRange.second - dataRange.first) * 0.02));
 
   if (vizRangeMin.holdsDefaultValue()) { // min and max should always have same cache state
     // dynamically compute a viz range from the data min/max
@@ -29,9 +46,10 @@ ScalarQuantity<QuantityT>::ScalarQuantity(QuantityT& quantity_, const std::vecto
 
 template <typename QuantityT>
 void ScalarQuantity<QuantityT>::buildScalarUI() {
+  ensureDataRangeComputed();
 
   if (render::buildColormapSelector(cMap.get())) {
-    quantity.refresh();
+    // the color map is a uniform row of the colormap atlas, no need to rebuild programs
     hist.updateColormap(cMap.get());
     setColorMap(getColorMap());
   }
@@ -69,6 +87,16 @@ void ScalarQuantity<QuantityT>::buildScalarUI() {
 
 
   // Draw the histogram of values
+  bool rebuildDue = ImGui::GetTime() - lastHistogramBuild >= options::histogramRebuildPeriod;
+  if (rebuildDue && values.getDataVersion() != rangeDataVersion && values.isCanonicalOnDevice()) {
+    refreshDataRange(); // written on the device since
+    lastHistogramBuild = ImGui::GetTime();
+  } else if (rebuildDue && histogramStale) {
+    std::vector<float>& valuesRef = values.getPopulatedHostBufferRef();
+    hist.buildHistogram(valuesRef.data(), valuesRef.size(), dataFiniteRange);
+    histogramStale = false;
+    lastHistogramBuild = ImGui::GetTime();
+  }
   hist.colormapRange = std::pair<float, float>(vizRangeMin.get(), vizRangeMax.get());
   float windowWidth = ImGui::GetWindowWidth();
   float histWidth = 0.75 * windowWidth;
@@ -174,23 +202,64 @@ std::vector<std::string> ScalarQuantity<QuantityT>::addScalarRules(std::vector<s
   if (isolinesEnabled.get()) {
     rules.push_back("ISOLINE_STRIPE_VALUECOLOR");
   }
+  if (valueKeyframes) {
+    addKeyframeRule(rules, "KEYFRAME_VALUE");
+  }
   return rules;
 }
 
 
 template <typename QuantityT>
 void ScalarQuantity<QuantityT>::setScalarUniforms(render::ShaderProgram& p) {
+  ensureDataRangeComputed();
   p.setUniform("u_rangeLow", vizRangeMin.get());
   p.setUniform("u_rangeHigh", vizRangeMax.get());
+  setColorMapUniforms(p);
 
   if (isolinesEnabled.get()) {
     p.setUniform("u_modLen", getIsolineWidth());
     p.setUniform("u_modDarkness", getIsolineDarkness());
   }
+
+  // the keyframe uniforms come from the parent structure, the texture only gets attached once
+  if (valueKeyframes && p.hasTexture("t_keyframeValues") && !p.textureIsSet("t_keyframeValues")) {
+    p.setTextureFromBuffer("t_keyframeValues", valueKeyframes->getTexture().get());
+  }
+}
+
+template <typename QuantityT>
+void ScalarQuantity<QuantityT>::setColorMapUniforms(render::ShaderProgram& p) {
+  // the color map is a row of the shared atlas, so changing it does not need a refresh()
+  if (p.hasUniform("u_colormapRow")) {
+    p.setUniform("u_colormapRow", render::engine->getColorMapAtlasRow(cMap.get()));
+  }
+}
+
+template <typename QuantityT>
+void ScalarQuantity<QuantityT>::setValueKeyframes(const std::vector<std::vector<float>>& frames) {
+  for (size_t iFrame = 0; iFrame < frames.size(); iFrame++) {
+    if (frames[iFrame].size() != values.size()) {
+      exception("Scalar quantity [" + quantity.name + "] keyframe " + std::to_string(iFrame) + " has " +
+                std::to_string(frames[iFrame].size()) + " values, but the quantity has " +
+                std::to_string(values.size()));
+    }
+  }
+  quantity.parent.registerKeyframeCount(frames.size());
+  valueKeyframes.reset(new KeyframeSeries(quantity.uniquePrefix() + "valueKeyframes", frames));
+
+  // map the range of all frames
+  ensureDataRangeComputed();
+  std::pair<double, double> frameRange = valueKeyframes->dataRange();
+  dataFiniteRange.first = std::min(dataFiniteRange.first, frameRange.first);
+  dataFiniteRange.second = std::max(dataFiniteRange.second, frameRange.second);
+  dataRange = robustRange(dataFiniteRange, 1e-5);
+  resetMapRange();
+  quantity.refresh();
 }
 
 template <typename QuantityT>
 QuantityT* ScalarQuantity<QuantityT>::resetMapRange() {
+  ensureDataRangeComputed();
   switch (dataType) {
   case DataType::STANDARD:
     vizRangeMin = dataRange.first;
@@ -220,15 +289,147 @@ void ScalarQuantity<QuantityT>::updateData(const V& newValues) {
   validateSize(newValues, values.size(), "scalar quantity " + quantity.name);
   values.data = standardizeArray<float, V>(newValues);
   values.markHostBufferUpdated();
+  histogramStale = true;
 }
 
+template <typename QuantityT>
+void ScalarQuantity<QuantityT>::updateData(const float* newValues, size_t count) {
+  if (count != values.size()) {
+    exception("scalar quantity " + quantity.name + " updated with " + std::to_string(count) + " values, but has " +
+              std::to_string(values.size()));
+  }
+  values.ensureHostBufferAllocated();
+  std::copy(newValues, newValues + count, values.data.begin());
+  values.markHostBufferUpdated();
+  histogramStale = true;
+}
+
+template <typename QuantityT>
+template <class V>
+void ScalarQuantity<QuantityT>::updateDataSubset(size_t begin, const V& newValues) {
+  std::vector<float> newData = standardizeArray<float, V>(newValues);
+  if (begin + newData.size() > values.size()) {
+    exception("scalar quantity " + quantity.name + " subset update [" + std::to_string(begin) + ", " +
+              std::to_string(begin + newData.size()) + ") is past the end of " + std::to_string(values.size()) +
+              " values");
+  }
+  if (newData.empty()) return;
+
+  std::vector<float>& valuesRef = values.getPopulatedHostBufferRef();
+  if (!histogramStale && !hist.updateCounts(&valuesRef[begin], newData.data(), newData.size())) {
+    histogramStale = true; // left the range, needs a rebuild
+  }
+  std::copy(newData.begin(), newData.end(), valuesRef.begin() + begin);
+  values.markHostBufferRangeUpdated(begin, newData.size());
+}
+
+template <typename QuantityT>
+void ScalarQuantity<QuantityT>::updateDataBox(glm::uvec3 dim, glm::uvec3 origin, glm::uvec3 extent,
+                                              const std::vector<float>& newValues) {
+  if (newValues.empty()) return;
+
+  std::vector<float>& valuesRef = values.getPopulatedHostBufferRef();
+  for (uint32_t z = 0; z < extent.z; z++) {
+    for (uint32_t y = 0; y < extent.y; y++) {
+      const float* newRow = &newValues[(static_cast<size_t>(z) * extent.y + y) * extent.x];
+      size_t rowStart = (static_cast<size_t>(origin.z + z) * dim.y + origin.y + y) * dim.x + origin.x;
+      if (!histogramStale && !hist.updateCounts(&valuesRef[rowStart], newRow, extent.x)) {
+        histogramStale = true; // left the range, needs a rebuild
+      }
+      std::copy(newRow, newRow + extent.x, valuesRef.begin() + rowStart);
+    }
+  }
+  values.markHostBufferBoxUpdated(origin, extent);
+}
+
+template <typename QuantityT>
+template <class V>
+void ScalarQuantity<QuantityT>::stageData(const V& newValues) {
+  std::vector<float> staged = acquireStagingBuffer<float>();
+  adaptorF_convertToStdVector<float, V>(newValues, staged);
+  // the buffer lives exactly as long as the quantity
+  stageUpdate<float>(quantity.uniquePrefix() + "values", values.getWeakHandle(&values), std::move(staged),
+                     [this](std::vector<float>& data) {
+                       validateSize(data, values.size(), "scalar quantity staged values " + quantity.name);
+                       values.data.swap(data);
+                       values.markHostBufferUpdated();
+                       histogramStale = true;
+                     });
+}
+
+template <typename QuantityT>
+template <class V>
+void ScalarQuantity<QuantityT>::appendValues(const V& newValues) {
+  std::vector<float> newData = standardizeArray<float, V>(newValues);
+
+  ensureDataRangeComputed(); // over the existing values
+  std::pair<float, float> newRange = finiteMinMax(newData.data(), newData.size());
+  dataFiniteRange.first = std::min(dataFiniteRange.first, static_cast<double>(newRange.first));
+  dataFiniteRange.second = std::max(dataFiniteRange.second, static_cast<double>(newRange.second));
+  dataRange = robustRange(dataFiniteRange, 1e-5);
+
+  values.appendData(newData);
+  histogramStale = true; // rebuilding it here would cost O(n) per chunk
+  if (vizRangeMin.holdsDefaultValue()) {
+    resetMapRange();
+  }
+}
+
+
+template <typename QuantityT>
+void ScalarQuantity<QuantityT>::setValuesView(const float* viewData, size_t count,
+                                              std::shared_ptr<void> lifetimeToken) {
+  values.setExternalView(viewData, count, lifetimeToken);
+
+  // these are normally computed from the values at construction, redo them from the view
+  dataFiniteRange = finiteMinMax(viewData, count);
+  dataRange = robustRange(dataFiniteRange, 1e-5);
+  dataRangeComputed = true;
+  hist.buildHistogram(viewData, count, dataFiniteRange);
+  histogramStale = false;
+  setDefaultsFromDataRange();
+}
+
+template <typename QuantityT>
+void ScalarQuantity<QuantityT>::refreshDataRange() {
+  dataRangeComputed = true;
+
+  // Try the device first, if that is where the values are
+  bool onDevice = false;
+  std::pair<double, double> newFiniteRange;
+  std::vector<double> binCounts;
+  if (values.isCanonicalOnDevice()) {
+    size_t nBins = hist.getBinCount();
+    if (values.getDeviceBufferType() == DeviceBufferType::Attribute) {
+      render::AttributeBuffer& buff = *values.getRenderAttributeBuffer();
+      onDevice = render::engine->computeFiniteRangeOnDevice(buff, newFiniteRange) &&
+                 render::engine->computeHistogramOnDevice(buff, robustRange(newFiniteRange), nBins, binCounts);
+    } else {
+      render::TextureBuffer& buff = *values.getRenderTextureBuffer();
+      onDevice = render::engine->computeFiniteRangeOnDevice(buff, newFiniteRange) &&
+                 render::engine->computeHistogramOnDevice(buff, robustRange(newFiniteRange), nBins, binCounts);
+    }
+  }
+
+  if (onDevice) {
+    dataFiniteRange = newFiniteRange;
+    hist.buildHistogramFromCounts(binCounts, dataFiniteRange);
+  } else {
+    std::vector<float>& valuesRef = values.getPopulatedHostBufferRef();
+    dataFiniteRange = finiteMinMax(valuesRef.data(), valuesRef.size());
+    hist.buildHistogram(valuesRef.data(), valuesRef.size(), dataFiniteRange);
+  }
+  dataRange = robustRange(dataFiniteRange, 1e-5);
+  histogramStale = false;
+  rangeDataVersion = values.getDataVersion();
+  setDefaultsFromDataRange();
+}
 
 template <typename QuantityT>
 QuantityT* ScalarQuantity<QuantityT>::setColorMap(std::string val) {
   cMap = val;
   hist.updateColormap(cMap.get());
-  quantity.refresh();
-  requestRedraw();
+  requestRedraw(); // picked up by setColorMapUniforms()
   return &quantity;
 }
 template <typename QuantityT>
@@ -245,10 +446,12 @@ QuantityT* ScalarQuantity<QuantityT>::setMapRange(std::pair<double, double> val)
 }
 template <typename QuantityT>
 std::pair<double, double> ScalarQuantity<QuantityT>::getMapRange() {
+  ensureDataRangeComputed();
   return std::pair<float, float>(vizRangeMin.get(), vizRangeMax.get());
 }
 template <typename QuantityT>
 std::pair<double, double> ScalarQuantity<QuantityT>::getDataRange() {
+  ensureDataRangeComputed();
   return dataRange;
 }
 
@@ -263,6 +466,7 @@ QuantityT* ScalarQuantity<QuantityT>::setIsolineWidth(double size, bool isRelati
 }
 template <typename QuantityT>
 double ScalarQuantity<QuantityT>::getIsolineWidth() {
+  ensureDataRangeComputed();
   return isolineWidth.get().asAbsolute();
 }
 
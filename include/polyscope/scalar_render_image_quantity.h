@@ -24,6 +24,7 @@ public:
   virtual void buildCustomUI() override;
 
   virtual void refresh() override;
+  virtual bool getCompositeLayer(RenderImageCompositeLayer& layer) override;
 
   virtual std::string niceName() override;
 
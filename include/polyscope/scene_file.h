@@ -0,0 +1,25 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <string>
+
+namespace polyscope {
+
+// A polyscope-native binary scene container, for quickly reloading large scenes without re-parsing their source files.
+//
+// saveScene() writes the registered point clouds and surface meshes, with their buffers laid out exactly as their
+// ManagedBuffers hold them (positions, face indices, scalar and color quantity values), along with the persistent
+// settings of each structure and quantity (enabled state, transform, colors, colormaps, ...). Other structure types
+// and quantity types are skipped with a warning.
+//
+// loadScene() memory-maps the file and registers the stored structures, replacing any with the same names. Scalar
+// values are uploaded directly from the mapping without a host copy, the mapping stays alive while they are in use.
+// Geometry and colors are copied out of the mapping, since the structures need them on the host anyway.
+//
+// The format is specific to this version of polyscope and the machine's endianness, it is meant as a cache rather than
+// an interchange format. Loading a file written by a different version is an error.
+void saveScene(std::string filename);
+void loadScene(std::string filename);
+
+} // namespace polyscope
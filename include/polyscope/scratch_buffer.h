@@ -0,0 +1,45 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace polyscope {
+
+// Temporary vectors for hot paths, e.g. expanding data before it is uploaded, packing it in a compact format, or the
+// working arrays of an algorithm, which would otherwise allocate and free on every call.
+//
+// A ScratchVector<T> borrows an empty vector from a pool of previously used ones, with their capacity, and gives it
+// back when it goes out of scope. Pooled vectors which were not needed during a frame are freed at its end by
+// trimScratchBuffers(), so a one-off large temporary does not stay resident, while the temporaries of a steady frame
+// are never reallocated.
+//
+// Each thread has its own pools. Only the render thread's are trimmed each frame, other threads keep a few vectors of
+// each type.
+template <typename T>
+class ScratchVector {
+public:
+  ScratchVector();
+  explicit ScratchVector(size_t size, const T& value = T()); // resized to `size` copies of `value`
+  ~ScratchVector();
+
+  ScratchVector(const ScratchVector&) = delete;
+  ScratchVector& operator=(const ScratchVector&) = delete;
+
+  std::vector<T>& operator*() { return vec; }
+  std::vector<T>* operator->() { return &vec; }
+  T& operator[](size_t i) { return vec[i]; }
+  const T& operator[](size_t i) const { return vec[i]; }
+
+private:
+  std::vector<T> vec;
+};
+
+// Free the pooled vectors of the calling thread beyond those used at once since the last trim. Called by the main loop
+// at the end of each frame.
+void trimScratchBuffers();
+
+} // namespace polyscope
+
+#include "polyscope/scratch_buffer.ipp"
@@ -0,0 +1,80 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include <algorithm>
+#include <utility>
+
+namespace polyscope {
+
+namespace detail {
+
+class ScratchPoolBase {
+public:
+  virtual ~ScratchPoolBase() = default;
+  virtual void trim() = 0;
+};
+
+// Track the pools of the calling thread, for trimScratchBuffers()
+void registerScratchPool(ScratchPoolBase* pool);
+void unregisterScratchPool(ScratchPoolBase* pool);
+
+// Released scratch vectors of one element type, on one thread
+template <typename T>
+class ScratchPool : public ScratchPoolBase {
+public:
+  static const size_t maxFreeBuffers = 8;
+
+  static ScratchPool& get() {
+    static thread_local ScratchPool pool;
+    return pool;
+  }
+
+  ScratchPool() { registerScratchPool(this); }
+  ~ScratchPool() { unregisterScratchPool(this); }
+
+  void acquire(std::vector<T>& buffer) {
+    nInUse++;
+    peakInUse = std::max(peakInUse, nInUse);
+    if (!freeBuffers.empty()) {
+      buffer.swap(freeBuffers.back());
+      freeBuffers.pop_back();
+    }
+  }
+
+  void release(std::vector<T>& buffer) {
+    nInUse--;
+    buffer.clear();
+    if (buffer.capacity() == 0 || freeBuffers.size() >= maxFreeBuffers) return;
+    freeBuffers.push_back(std::move(buffer));
+  }
+
+  // keep as many vectors as were in use at once since the last trim
+  void trim() override {
+    if (freeBuffers.size() > peakInUse) freeBuffers.resize(peakInUse);
+    peakInUse = nInUse;
+  }
+
+private:
+  std::vector<std::vector<T>> freeBuffers;
+  size_t nInUse = 0;
+  size_t peakInUse = 0;
+};
+
+} // namespace detail
+
+template <typename T>
+ScratchVector<T>::ScratchVector() {
+  detail::ScratchPool<T>::get().acquire(vec);
+}
+
+template <typename T>
+ScratchVector<T>::ScratchVector(size_t size, const T& value) {
+  detail::ScratchPool<T>::get().acquire(vec);
+  vec.assign(size, value);
+}
+
+template <typename T>
+ScratchVector<T>::~ScratchVector() {
+  detail::ScratchPool<T>::get().release(vec);
+}
+
+} // namespace polyscope
@@ -2,21 +2,63 @@
 
 #pragma once
 
+#include "polyscope/camera_parameters.h"
 #include "polyscope/polyscope.h"
 
+#include <string>
+#include <vector>
+
 namespace polyscope {
 
 
 // Take a screenshot from the current view and write to file
 void screenshot(std::string filename, bool transparentBG = true);
 void screenshot(bool transparentBG = true); // automatic file names like `screenshot_000000.png`
-void saveImage(std::string name, unsigned char* buffer, int w, int h, int channels); // helper
 void resetScreenshotIndex();
 
+// Write an image to file, with rows given bottom to top as read back from OpenGL. The format is picked by the extension
+// of `name` unless one is given, see resolveImageFormat(). Screenshots are written in options::screenshotFormat.
+void saveImage(std::string name, unsigned char* buffer, int w, int h, int channels,
+               ImageFormat format = ImageFormat::Auto);
+
+// Like screenshot(), but reading the image back and writing it to file happen in the background, so that taking one
+// every frame (e.g. to record an animation) does not stall rendering. The automatically named version numbers files in
+// sequence like screenshot(). Memory use is bounded, if images are requested faster than they can be written this
+// waits for the oldest ones. flushScreenshots() waits until all pending images have been written.
+void screenshotAsync(std::string filename, bool transparentBG = true);
+void screenshotAsync(bool transparentBG = true);
+void flushScreenshots();
+void processAsyncScreenshots(); // advances pending images, called once per frame by the main loop
+
 // Take a screenshot from the current view and return it as a buffer
 // the dimensions are view::bufferWidth and view::bufferHeight , with entries RGBA at 1 byte each.
 std::vector<unsigned char> screenshotToBuffer(bool transparentBG = true);
 
+// Render the current view in to a texture owned by the host application, e.g. to show Polyscope inside a widget of a
+// Qt/GL application. Unlike screenshotToBuffer() the image never leaves the GPU: it is copied straight in to the
+// texture, scaling if the sizes differ (set the window size to the texture size, see view::setWindowSize(), for a 1:1
+// copy). `glTextureName` must be an RGBA8 2D texture of size width x height, in Polyscope's GL context or one sharing
+// objects with it. The GUI is not drawn. Only for the OpenGL backends.
+void renderToExternalTexture(uint32_t glTextureName, int width, int height, bool transparentBG = true);
+
+// One image of a batch render
+struct BatchRenderView {
+  CameraParameters camera;
+  std::string filename;
+};
+
+// Render the scene from each view and save it to the corresponding file, e.g. for producing many thumbnails headlessly.
+// Unlike calling screenshot() in a loop, the GUI is not drawn, reading back each image overlaps with rendering the
+// next ones, and images are encoded on worker threads. The current view is restored afterwards.
+void renderBatch(const std::vector<BatchRenderView>& views, bool transparentBG = true);
+
+// Render this worker's share of a batch which is spread over `shardCount` processes, e.g. one per GPU on a render node,
+// each initialized with options::eglDevice set to std::to_string(shardIndex % listEGLDevices().size()). Worker
+// `shardIndex` renders every shardCount-th view starting at its index, so shards get equal numbers of views whatever
+// their order, and each process only needs the full list of views.
+void renderBatchShard(const std::vector<BatchRenderView>& views, size_t shardIndex, size_t shardCount,
+                      bool transparentBG = true);
+
 namespace state {
 
 // The current screenshot index for automatically numbered screenshots
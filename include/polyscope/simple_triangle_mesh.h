@@ -8,8 +8,13 @@
 #include "polyscope/render/engine.h"
 #include "polyscope/render/managed_buffer.h"
 #include "polyscope/scaled_value.h"
+#include "polyscope/simple_triangle_mesh_quantity.h"
+#include "polyscope/standardize_data_array.h"
 #include "polyscope/structure.h"
 
+#include "polyscope/simple_triangle_mesh_color_quantity.h"
+#include "polyscope/simple_triangle_mesh_scalar_quantity.h"
+
 #include <vector>
 
 namespace polyscope {
@@ -18,11 +23,13 @@ namespace polyscope {
 class SimpleTriangleMesh;
 
 // Forward declare quantity types
+class SimpleTriangleMeshVertexScalarQuantity;
+class SimpleTriangleMeshVertexColorQuantity;
 
-// template <> // Specialize the quantity type
-// struct QuantityTypeHelper<SimpleTriangleMesh> {
-//   typedef SimpleTriangleMeshQuantity type;
-// };
+template <> // Specialize the quantity type
+struct QuantityTypeHelper<SimpleTriangleMesh> {
+  typedef SimpleTriangleMeshQuantity type;
+};
 
 class SimpleTriangleMesh : public QuantityStructure<SimpleTriangleMesh> {
 public:
@@ -50,8 +57,21 @@ public:
   render::ManagedBuffer<glm::vec3> vertices;
   render::ManagedBuffer<glm::uvec3> faces;
 
+  // The vertex positions normalized to the bounding box and stored as 16-bit values on the device, drawn instead of
+  // `vertices` when compact positions are enabled (see setCompactVertexPositions()). Computed lazily from `vertices`.
+  render::ManagedBuffer<glm::vec3> compactVertices;
+
   // === Quantities
 
+  // Scalars
+  template <class T>
+  SimpleTriangleMeshVertexScalarQuantity* addVertexScalarQuantity(std::string name, const T& values,
+                                                                  DataType type = DataType::STANDARD);
+
+  // Colors
+  template <class T>
+  SimpleTriangleMeshVertexColorQuantity* addVertexColorQuantity(std::string name, const T& values);
+
   // === Mutate
 
   template <class V>
@@ -81,6 +101,11 @@ public:
   SimpleTriangleMesh* setBackFacePolicy(BackFacePolicy newPolicy);
   BackFacePolicy getBackFacePolicy();
 
+  // Store the positions on the device as 16-bit values relative to the bounding box, rather than as 32-bit floats.
+  // Halves the device memory of the positions, at a precision of 1/65535 of the bounding box extent.
+  SimpleTriangleMesh* setCompactVertexPositions(bool newVal);
+  bool getCompactVertexPositions();
+
   // Rendering helpers used by quantities
   void setSimpleTriangleMeshUniforms(render::ShaderProgram& p, bool withSurfaceShade = true);
   void setSimpleTriangleMeshProgramGeometryAttributes(render::ShaderProgram& p);
@@ -93,12 +118,18 @@ private:
   // Storage for the managed buffers above. You should generally interact with this directly through them.
   std::vector<glm::vec3> verticesData;
   std::vector<glm::uvec3> facesData;
+  std::vector<glm::vec3> compactVerticesData;
+
+  // The box which compactVertices are normalized to, as of the last time they were computed
+  glm::vec3 compactVertexCenter{0., 0., 0.};
+  glm::vec3 compactVertexHalfExtent{1., 1., 1.};
 
   // === Visualization parameters
   PersistentValue<glm::vec3> surfaceColor;
   PersistentValue<std::string> material;
   PersistentValue<BackFacePolicy> backFacePolicy;
   PersistentValue<glm::vec3> backFaceColor;
+  PersistentValue<bool> compactVertexPositions;
 
   // Drawing related things
   // if nullptr, prepare() (resp. preparePick()) needs to be called
@@ -110,8 +141,13 @@ private:
   void ensureRenderProgramPrepared();
   void ensurePickProgramPrepared();
   void setPickUniforms(render::ShaderProgram& p);
+  void computeCompactVertices();
 
   // === Quantity adder implementations
+  SimpleTriangleMeshVertexScalarQuantity* addVertexScalarQuantityImpl(std::string name, const std::vector<float>& data,
+                                                                      DataType type);
+  SimpleTriangleMeshVertexColorQuantity* addVertexColorQuantityImpl(std::string name,
+                                                                    const std::vector<glm::vec3>& colors);
 
   // == Picking related things
   size_t pickStart;
@@ -28,6 +28,7 @@ void SimpleTriangleMesh::updateVertices(const V& newPositions) {
   validateSize(newPositions, vertices.size(), "newPositions");
   vertices.data = standardizeVectorArray<glm::vec3, 3>(newPositions);
   vertices.markHostBufferUpdated();
+  compactVertices.recomputeIfPopulated();
 }
 
 template <class V, class F>
@@ -38,6 +39,21 @@ void SimpleTriangleMesh::update(const V& newPositions, const F& newFaces) {
 
   faces.data = standardizeVectorArray<glm::uvec3, 3>(newFaces);
   faces.markHostBufferUpdated();
+
+  compactVertices.recomputeIfPopulated();
+}
+
+template <class T>
+SimpleTriangleMeshVertexScalarQuantity* SimpleTriangleMesh::addVertexScalarQuantity(std::string name, const T& data,
+                                                                                    DataType type) {
+  validateSize(data, vertices.size(), "simple triangle mesh vertex scalar quantity " + name);
+  return addVertexScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
+}
+
+template <class T>
+SimpleTriangleMeshVertexColorQuantity* SimpleTriangleMesh::addVertexColorQuantity(std::string name, const T& colors) {
+  validateSize(colors, vertices.size(), "simple triangle mesh vertex color quantity " + name);
+  return addVertexColorQuantityImpl(name, standardizeVectorArray<glm::vec3, 3>(colors));
 }
 
 // Shorthand to get a mesh from polyscope
@@ -0,0 +1,32 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/color_quantity.h"
+#include "polyscope/simple_triangle_mesh.h"
+#include "polyscope/simple_triangle_mesh_quantity.h"
+
+#include <vector>
+
+namespace polyscope {
+
+// A color per vertex, interpolated across the faces
+class SimpleTriangleMeshVertexColorQuantity : public SimpleTriangleMeshQuantity,
+                                              public ColorQuantity<SimpleTriangleMeshVertexColorQuantity> {
+public:
+  SimpleTriangleMeshVertexColorQuantity(std::string name, const std::vector<glm::vec3>& values,
+                                        SimpleTriangleMesh& mesh_);
+
+  virtual void draw() override;
+  virtual void refresh() override;
+
+  virtual std::string niceName() override;
+
+protected:
+  void createProgram();
+
+  std::shared_ptr<render::ShaderProgram> program;
+};
+
+
+} // namespace polyscope
@@ -0,0 +1,21 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/quantity.h"
+#include "polyscope/structure.h"
+
+namespace polyscope {
+
+// Forward delcare simple triangle mesh
+class SimpleTriangleMesh;
+
+// Extend Quantity<SimpleTriangleMesh> to add a few extra functions
+class SimpleTriangleMeshQuantity : public QuantityS<SimpleTriangleMesh> {
+public:
+  SimpleTriangleMeshQuantity(std::string name, SimpleTriangleMesh& parentStructure, bool dominates = false);
+  virtual ~SimpleTriangleMeshQuantity(){};
+};
+
+
+} // namespace polyscope
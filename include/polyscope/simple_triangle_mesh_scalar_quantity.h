@@ -0,0 +1,37 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/affine_remapper.h"
+#include "polyscope/histogram.h"
+#include "polyscope/render/color_maps.h"
+#include "polyscope/scalar_quantity.h"
+#include "polyscope/simple_triangle_mesh.h"
+#include "polyscope/simple_triangle_mesh_quantity.h"
+
+#include <vector>
+
+namespace polyscope {
+
+// A scalar value per vertex, interpolated across the faces
+class SimpleTriangleMeshVertexScalarQuantity : public SimpleTriangleMeshQuantity,
+                                               public ScalarQuantity<SimpleTriangleMeshVertexScalarQuantity> {
+
+public:
+  SimpleTriangleMeshVertexScalarQuantity(std::string name, const std::vector<float>& values, SimpleTriangleMesh& mesh_,
+                                         DataType dataType);
+
+  virtual void draw() override;
+  virtual void buildCustomUI() override;
+  virtual void refresh() override;
+
+  virtual std::string niceName() override;
+
+protected:
+  void createProgram();
+
+  std::shared_ptr<render::ShaderProgram> program;
+};
+
+
+} // namespace polyscope
@@ -62,6 +62,11 @@ public:
   glm::mat4 getTransform();
   void setTransform(glm::mat4 newTransform);
 
+  // The plane in world coordinates. Points on the negative side of the normal are sliced away. When the plane is not
+  // active these are placeholders which never slice anything.
+  glm::vec3 getCenter();
+  glm::vec3 getNormal();
+
   void setColor(glm::vec3 newVal);
   glm::vec3 getColor();
 
@@ -104,13 +109,14 @@ protected:
   void setSliceAttributes(render::ShaderProgram& p);
   void createVolumeSliceProgram();
   void prepare();
-  glm::vec3 getCenter();
-  glm::vec3 getNormal();
   void updateWidgetEnabled();
 };
 
-SlicePlane* addSceneSlicePlane(bool initiallyVisible = false);
+SlicePlane* addSceneSlicePlane(bool initiallyVisible = false); // at most render::maxSlicePlanes
 void removeLastSceneSlicePlane();
+
+// Give the slice plane uniforms of a program which no plane is using values which cull nothing
+void setUnusedSlicePlaneUniforms(render::ShaderProgram& p);
 void buildSlicePlaneGUI();
 
 // flag to open the slice plane menu after adding a slice plane
@@ -3,8 +3,10 @@
 #pragma once
 
 #include "polyscope/messages.h"
+#include "polyscope/parallel.h"
 #include "polyscope/utilities.h"
 
+#include <cstring>
 #include <type_traits>
 #include <vector>
 
@@ -223,6 +225,78 @@ size_t adaptorF_size(const T& inputData) {
   return adaptorF_sizeImpl(PreferenceT<4>{}, inputData);
 }
 
+// The size of an array if the size adaptor above can get it, or 0 otherwise. Used as a hint to presize outputs.
+template <class T,
+  /* condition: one of the size adaptors above applies */
+  typename C1 = decltype(adaptorF_sizeImpl(PreferenceT<4>{}, std::declval<T>()))>
+
+size_t adaptorF_sizeHintImpl(PreferenceT<1>, const T& inputData) {
+  return adaptorF_size(inputData);
+}
+
+template <class T>
+size_t adaptorF_sizeHintImpl(PreferenceT<0>, const T& inputData) {
+  return 0;
+}
+
+template <class T>
+size_t adaptorF_sizeHint(const T& inputData) {
+  return adaptorF_sizeHintImpl(PreferenceT<1>{}, inputData);
+}
+
+// Whether the size adaptor above applies to T, in which case adaptorF_sizeHint() is the exact size
+template <class T, class C = void>
+struct AdaptorHasSize : std::false_type {};
+template <class T>
+struct AdaptorHasSize<T, decltype((void)adaptorF_sizeImpl(PreferenceT<4>{}, std::declval<T>()))> : std::true_type {};
+
+
+// =================================================
+// ============ contiguous data helpers
+// =================================================
+
+// Helpers for the fast paths of the adaptors below, which read types exposing their storage through .data() (like
+// std::vector or Eigen matrices) straight from memory rather than element-by-element through an access operator.
+
+// The distance between consecutive entries of a .data() array, from .innerStride() if there is one (Eigen maps and
+// blocks), and 1 otherwise
+template <class T, 
+  /* condition: has .innerStride() method which returns something that can be cast to size_t */
+  typename C1 = typename std::enable_if<std::is_same<decltype((size_t)(std::declval<T>()).innerStride()), size_t>::value>::type>
+
+size_t adaptorF_innerStrideImpl(PreferenceT<1>, const T& inputData) {
+  return inputData.innerStride();
+}
+
+template <class T>
+size_t adaptorF_innerStrideImpl(PreferenceT<0>, const T& inputData) {
+  return 1;
+}
+
+template <class T>
+size_t adaptorF_innerStride(const T& inputData) {
+  return adaptorF_innerStrideImpl(PreferenceT<1>{}, inputData);
+}
+
+// Copy and convert `count` scalars, each `stride` entries apart in the input. The contiguous case is kept as a plain
+// loop of its own, which compilers vectorize for the usual float/double and integer conversions.
+template <class S, class P>
+void copyStridedScalars(const P* dataIn, size_t count, size_t stride, S* dataOut) {
+  if (stride == 1) {
+    if (std::is_same<S, P>::value) {
+      if (count > 0) std::memcpy(static_cast<void*>(dataOut), static_cast<const void*>(dataIn), count * sizeof(S));
+      return;
+    }
+    for (size_t i = 0; i < count; i++) {
+      dataOut[i] = static_cast<S>(dataIn[i]);
+    }
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    dataOut[i] = static_cast<S>(dataIn[i * stride]);
+  }
+}
+
 
 // =================================================
 // ============ array access adapator
@@ -242,6 +316,7 @@ size_t adaptorF_size(const T& inputData) {
 //
 // The following hierarchy of strategies will be attempted, with decreasing precedence:
 // - user-defined adaptorF_custom_convertToStdVector()
+// - bracket access to arithmetic data which is also exposed through .data(), copied directly from memory
 // - bracket access
 // - callable (parenthesis) access
 // - iterable (begin() and end())
@@ -259,7 +334,7 @@ template <class T, class S,
   /* condition: user defined function exists and returns something that can be bracket-indexed to get an S */
   typename C1 = typename std::enable_if< std::is_same<decltype((S)adaptorF_custom_convertToStdVector(std::declval<T>())[0]), S>::value>::type>
 
-void adaptorF_convertToStdVectorImpl(PreferenceT<5>, const T& inputData, std::vector<S>& out) {
+void adaptorF_convertToStdVectorImpl(PreferenceT<6>, const T& inputData, std::vector<S>& out) {
   auto userVec = adaptorF_custom_convertToStdVector(inputData);
 
   // If the user-provided function returns something else, try to convert it to a std::vector<S>.
@@ -274,6 +349,22 @@ void adaptorF_convertToStdVectorImpl(PreferenceT<5>, const T& inputData, std::ve
   }
 }
 
+// Next: bracket access to arithmetic values also exposed through .data() (std::vector, std::array, Eigen vectors), read
+// straight from memory
+template <class T, class S,
+  /* helper type: the scalar type stored in the input */
+  typename C_PTR = typename std::remove_cv<typename std::remove_pointer<decltype((std::declval<T>()).data())>::type>::type,
+  /* condition: input can be bracket-indexed to get an S */
+  typename C1 = typename std::enable_if<std::is_same<decltype((S)(std::declval<T>())[(size_t)0]), S>::value>::type,
+  /* condition: both the stored and the output types are arithmetic */
+  typename C2 = typename std::enable_if<std::is_arithmetic<C_PTR>::value && std::is_arithmetic<S>::value>::type>
+
+void adaptorF_convertToStdVectorImpl(PreferenceT<5>, const T& inputData, std::vector<S>& dataOut) {
+  size_t dataSize = adaptorF_size(inputData);
+  dataOut.resize(dataSize);
+  copyStridedScalars<S, C_PTR>(inputData.data(), dataSize, adaptorF_innerStride(inputData), dataOut.data());
+}
+
 // Next: any bracket access operator
 template <class T, class S,
   /* condition: input can be bracket-indexed to get an S */
@@ -352,7 +443,7 @@ void adaptorF_convertToStdVectorImpl(PreferenceT<0>, const T& inputData, std::ve
 // General version, which will attempt to substitute in to the variants above
 template <class S, class T>
 void adaptorF_convertToStdVector(const T& inputData, std::vector<S>& dataOut) {
-  adaptorF_convertToStdVectorImpl<T, S>(PreferenceT<5>{}, inputData, dataOut);
+  adaptorF_convertToStdVectorImpl<T, S>(PreferenceT<6>{}, inputData, dataOut);
 }
 
 
@@ -575,13 +666,16 @@ S adaptorF_accessVector3Value(const T& inVal) {
 //
 // The result is a function
 //   template <class O, unsigned int D, class T>
-//   inline std::vector<O> adaptorF_convertArrayOfVectorToStdVector(const T& inputData);
-// which converts the input to a std::vector<O>.
+//   inline void adaptorF_convertArrayOfVectorToStdVector(const T& inputData, std::vector<O>& dataOut);
+// which converts the input to a std::vector<O>. The output is resized to fit, so a vector reused across calls (e.g. a
+// pooled staging buffer, see acquireStagingBuffer()) keeps its storage.
 //
 //
 // The following hierarchy of strategies will be attempted, with decreasing precedence:
 //   - any user defined function
 //          std::vector<std::array<F, D>> adaptorF_custom_convertArrayOfVectorToStdVector(const YOUR_TYPE& inputData);
+//   - contiguous .data() storage of the output type itself (like std::vector<glm::vec3> to glm::vec3), copied at once
+//   - dense callable access with strided .data() storage (Eigen matrices, either row- or column-major), read from memory
 //   - dense callable (parenthesis) access (like T(i,j))
 //   - double bracket access (like T[i][j])
 //   - outer type bracket accessbile, inner anything convertible to Vector2/3
@@ -604,7 +698,7 @@ template <
     typename C1 = typename std::enable_if<std::is_same< 
                                           decltype((typename InnerType<O>::type)(adaptorF_custom_convertArrayOfVectorToStdVector(std::declval<T>()))[0][0]), 
                                           typename InnerType<O>::type>::value>::type>
-std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<9>, const T& inputData) {
+void adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<11>, const T& inputData, std::vector<O>& dataOut) {
 
   // should be std::vector<std::array<SCALAR,D>>
   auto userArr = adaptorF_custom_convertArrayOfVectorToStdVector(inputData);
@@ -612,13 +706,89 @@ std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<9>, cons
   // This results in an extra copy, which isn't reallllly necessary.
 
   size_t dataSize = userArr.size();
-  std::vector<O> dataOut(dataSize);
+  dataOut.resize(dataSize);
   for (size_t i = 0; i < dataSize; i++) {
     for (size_t j = 0; j < D; j++) {
       dataOut[i][j] = userArr[i][j];
     }
   }
-  return dataOut;
+}
+
+// Next: contiguous storage of the output type itself
+template <class O, unsigned int D, class T,
+    /* helper type: the type stored in the input */
+    typename C_PTR = typename std::remove_cv<typename std::remove_pointer<decltype((std::declval<T>()).data())>::type>::type,
+    /* condition: input stores values of the output type, which can be copied as bytes */
+    typename C1 = typename std::enable_if<std::is_same<C_PTR, O>::value && std::is_trivially_copyable<O>::value>::type>
+
+void adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<10>, const T& inputData, std::vector<O>& dataOut) {
+  size_t dataSize = adaptorF_size(inputData);
+  dataOut.resize(dataSize);
+  if (dataSize > 0) {
+    std::memcpy(static_cast<void*>(dataOut.data()), static_cast<const void*>(inputData.data()), dataSize * sizeof(O));
+  }
+}
+
+// Next: dense callable access to a strided .data() array, like an Eigen matrix (or map, or block). The entry (i,j) is at
+// i * outerStride() + j * innerStride() for row-major storage, and the other way around for column-major storage.
+template <class O, unsigned int D, class T,
+    /* helper type: inner type of output O */
+    typename C_RES = typename InnerType<O>::type,
+    /* helper type: the scalar type stored in the input */
+    typename C_PTR = typename std::remove_cv<typename std::remove_pointer<decltype((std::declval<T>()).data())>::type>::type,
+    /* condition: input can be called with two integer arguments to get something that can be cast to the inner type of O */
+    typename C1 = typename std::enable_if<std::is_same<decltype((C_RES)(std::declval<T>())((size_t)0, (size_t)0)), C_RES>::value>::type,
+    /* condition: the input has strides, a column count, and a storage order */
+    typename C2 = typename std::enable_if<std::is_same<decltype((size_t)(std::declval<T>()).innerStride()), size_t>::value &&
+                                          std::is_same<decltype((size_t)(std::declval<T>()).outerStride()), size_t>::value &&
+                                          std::is_same<decltype((size_t)(std::declval<T>()).cols()), size_t>::value &&
+                                          std::is_same<decltype((bool)T::IsRowMajor), bool>::value>::type,
+    /* condition: both the stored and the output scalar types are arithmetic */
+    typename C3 = typename std::enable_if<std::is_arithmetic<C_PTR>::value && std::is_arithmetic<C_RES>::value>::type>
+
+void adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<9>, const T& inputData, std::vector<O>& dataOut) {
+  size_t dataSize = adaptorF_size(inputData);
+  dataOut.resize(dataSize);
+  if (dataSize == 0) return;
+
+  // Other shapes take the element access below, as in the generic callable case
+  if (static_cast<size_t>(inputData.cols()) != D) {
+    for (size_t i = 0; i < dataSize; i++) {
+      for (size_t j = 0; j < D; j++) {
+        dataOut[i][j] = inputData(i, j);
+      }
+    }
+    return;
+  }
+
+  const C_PTR* dataPtr = inputData.data();
+  size_t rowStride = T::IsRowMajor ? inputData.outerStride() : inputData.innerStride();
+  size_t colStride = T::IsRowMajor ? inputData.innerStride() : inputData.outerStride();
+
+  // Packed rows of the output scalar type are exactly the output layout
+  bool outputPacked = sizeof(O) == D * sizeof(C_RES) && std::is_trivially_copyable<O>::value;
+  if (outputPacked && std::is_same<C_PTR, C_RES>::value && colStride == 1 && rowStride == D) {
+    std::memcpy(static_cast<void*>(dataOut.data()), static_cast<const void*>(dataPtr), dataSize * sizeof(O));
+    return;
+  }
+
+  // Otherwise walk the storage in order: along each column for column-major storage, along each row for row-major
+  parallelFor(0, dataSize, [&](size_t begin, size_t end) {
+    if (T::IsRowMajor) {
+      for (size_t i = begin; i < end; i++) {
+        for (size_t j = 0; j < D; j++) {
+          dataOut[i][j] = static_cast<C_RES>(dataPtr[i * rowStride + j * colStride]);
+        }
+      }
+    } else {
+      for (size_t j = 0; j < D; j++) {
+        const C_PTR* colPtr = dataPtr + j * colStride;
+        for (size_t i = begin; i < end; i++) {
+          dataOut[i][j] = static_cast<C_RES>(colPtr[i * rowStride]);
+        }
+      }
+    }
+  });
 }
 
 // Next: any dense callable (parenthesis) access operator
@@ -628,15 +798,16 @@ template <class O, unsigned int D, class T,
                                           decltype((typename InnerType<O>::type)(std::declval<T>())((size_t)0, (size_t)0)),
                                           typename InnerType<O>::type>::value>::type>
 
-std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<8>, const T& inputData) {
+void adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<8>, const T& inputData, std::vector<O>& dataOut) {
   size_t dataSize = adaptorF_size(inputData);
-  std::vector<O> dataOut(dataSize);
-  for (size_t i = 0; i < dataSize; i++) {
-    for (size_t j = 0; j < D; j++) {
-      dataOut[i][j] = inputData(i, j);
+  dataOut.resize(dataSize);
+  parallelFor(0, dataSize, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      for (size_t j = 0; j < D; j++) {
+        dataOut[i][j] = inputData(i, j);
+      }
     }
-  }
-  return dataOut;
+  });
 }
 
 
@@ -647,15 +818,16 @@ template <class O, unsigned int D, class T,
                                           decltype((typename InnerType<O>::type)(std::declval<T>())[(size_t)0][(size_t)0]),
                                           typename InnerType<O>::type>::value>::type>
 
-std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<7>, const T& inputData) {
+void adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<7>, const T& inputData, std::vector<O>& dataOut) {
   size_t dataSize = adaptorF_size(inputData);
-  std::vector<O> dataOut(dataSize);
-  for (size_t i = 0; i < dataSize; i++) {
-    for (size_t j = 0; j < D; j++) {
-      dataOut[i][j] = inputData[i][j];
+  dataOut.resize(dataSize);
+  parallelFor(0, dataSize, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      for (size_t j = 0; j < D; j++) {
+        dataOut[i][j] = inputData[i][j];
+      }
     }
-  }
-  return dataOut;
+  });
 }
 
 
@@ -672,15 +844,14 @@ template <class O, unsigned int D, class T,
     /* condition: the inner_scalar that comes from the vector3 unpack must match the requested inner type */
     typename C2 = typename std::enable_if<std::is_same<C_INNER_SCALAR, C_RES>::value>::type>
 
-std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<6>, const T& inputData) {
+void adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<6>, const T& inputData, std::vector<O>& dataOut) {
   size_t dataSize = adaptorF_size(inputData);
-  std::vector<O> dataOut(dataSize);
+  dataOut.resize(dataSize);
   for (size_t i = 0; i < dataSize; i++) {
     dataOut[i][0] = adaptorF_accessVector3Value<C_RES, 0>(inputData[i]);
     dataOut[i][1] = adaptorF_accessVector3Value<C_RES, 1>(inputData[i]);
     dataOut[i][2] = adaptorF_accessVector3Value<C_RES, 2>(inputData[i]);
   }
-  return dataOut;
 }
 
 // Next: bracketed array of anything adaptable to vector2
@@ -696,14 +867,13 @@ template <class O, unsigned int D, class T,
     /* condition: the inner_scalar that comes from the vector2 unpack must match the requested inner type */
     typename C2 = typename std::enable_if<std::is_same<C_INNER_SCALAR, C_RES>::value>::type>
 
-std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<5>, const T& inputData) {
+void adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<5>, const T& inputData, std::vector<O>& dataOut) {
   size_t dataSize = adaptorF_size(inputData);
-  std::vector<O> dataOut(dataSize);
+  dataOut.resize(dataSize);
   for (size_t i = 0; i < dataSize; i++) {
     dataOut[i][0] = adaptorF_accessVector2Value<C_RES, 0>(inputData[i]);
     dataOut[i][1] = adaptorF_accessVector2Value<C_RES, 1>(inputData[i]);
   }
-  return dataOut;
 }
 
 
@@ -724,9 +894,9 @@ template <class O, unsigned int D, class T,
     /* condition: the type that comes from begin() must match the one from end() */
     typename C3 = typename std::enable_if<std::is_same<C_INNER, C_INNER_END>::value>::type>
 
-std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<4>, const T& inputData) {
+void adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<4>, const T& inputData, std::vector<O>& dataOut) {
   size_t dataSize = adaptorF_size(inputData);
-  std::vector<O> dataOut(dataSize);
+  dataOut.resize(dataSize);
   size_t i = 0;
   for (auto v : inputData) {
     dataOut[i][0] = adaptorF_accessVector3Value<C_RES, 0>(v);
@@ -734,7 +904,6 @@ std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<4>, cons
     dataOut[i][2] = adaptorF_accessVector3Value<C_RES, 2>(v);
     i++;
   }
-  return dataOut;
 }
 
 // Next: iterable array of anything adaptable to vector2
@@ -754,16 +923,15 @@ template <class O, unsigned int D, class T,
     /* condition: the type that comes from begin() must match the one from end() */
     typename C3 = typename std::enable_if<std::is_same<C_INNER, C_INNER_END>::value>::type>
 
-std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<3>, const T& inputData) {
+void adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<3>, const T& inputData, std::vector<O>& dataOut) {
   size_t dataSize = adaptorF_size(inputData);
-  std::vector<O> dataOut(dataSize);
+  dataOut.resize(dataSize);
   size_t i = 0;
   for (auto v : inputData) {
     dataOut[i][0] = adaptorF_accessVector2Value<C_RES, 0>(v);
     dataOut[i][1] = adaptorF_accessVector2Value<C_RES, 1>(v);
     i++;
   }
-  return dataOut;
 }
 
 
@@ -774,9 +942,9 @@ template <class O, unsigned int D, class T, typename C_RES = typename InnerType<
     typename C1 = typename std::enable_if<std::is_same<decltype((C_RES)(*std::begin(std::declval<T>()))[0]), C_RES>::value &&
                                           std::is_same<decltype((C_RES)(*std::end(std::declval<T>()))[0]), C_RES>::value>::type>
 
-std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<2>, const T& inputData) {
+void adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<2>, const T& inputData, std::vector<O>& dataOut) {
   size_t dataSize = adaptorF_size(inputData);
-  std::vector<O> dataOut(dataSize);
+  dataOut.resize(dataSize);
   size_t i = 0;
   for (auto v : inputData) {
     for (size_t j = 0; j < D; j++) {
@@ -784,7 +952,6 @@ std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<2>, cons
     }
     i++;
   }
-  return dataOut;
 }
 
 // Next: tuple {data_ptr, size} (size is number of vector entries, so ptr should point to D*size valid scalar entries)
@@ -795,12 +962,12 @@ template <class O, unsigned int D, class T,
     typename C_COUNT = decltype(static_cast<size_t>(std::get<1>(std::declval<T>())))
   >
 
-std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<1>, const T& inputData) {
+void adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<1>, const T& inputData, std::vector<O>& dataOut) {
 
   size_t dataSize = adaptorF_size(inputData);
   auto* dataPtr = std::get<0>(inputData);
 
-  std::vector<O> dataOut(dataSize);
+  dataOut.resize(dataSize);
 
   for (size_t i = 0; i < dataSize; i++) {
     for (size_t j = 0; j < D; j++) {
@@ -808,7 +975,6 @@ std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<1>, cons
     }
   }
 
-  return dataOut;
 }
 
 
@@ -817,18 +983,17 @@ std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<1>, cons
 // We use this to print a slightly less scary error message.
 #ifndef POLYSCOPE_NO_STANDARDIZE_FALLTHROUGH
 template <class O, unsigned int D, class T>
-std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<0>, const T& inputData) {
+void adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<0>, const T& inputData, std::vector<O>& dataOut) {
   static_assert(WillBeFalseT<T>::value,
                 "could not resolve valid adaptor for accessing array-of-vectors-like input data");
-  return std::vector<O>();
 }
 #endif
 
 
 // General version, which will attempt to substitute in to the variants above
 template <class O, unsigned int D, class T>
-std::vector<O> adaptorF_convertArrayOfVectorToStdVector(const T& inputData) {
-  return adaptorF_convertArrayOfVectorToStdVectorImpl<O, D, T>(PreferenceT<9>{}, inputData);
+void adaptorF_convertArrayOfVectorToStdVector(const T& inputData, std::vector<O>& dataOut) {
+  adaptorF_convertArrayOfVectorToStdVectorImpl<O, D, T>(PreferenceT<11>{}, inputData, dataOut);
 }
 
 
@@ -857,6 +1022,62 @@ std::vector<O> adaptorF_convertArrayOfVectorToStdVector(const T& inputData) {
 //   - a tuple of {data pointer (e.g. float*), length (int), width (int)}. ptr should pointer to length*width buffer such s [x0 y0 z0 x1 y1 z1 ...]
 
 
+// Flatten a random-access outer array, whose i'th inner array is getInner(i), to the {entries, starts} output. When the
+// inner arrays report their sizes this is done in parallel, in two passes: the sizes are counted and prefix-summed in
+// to the starts, then each inner array is converted in to its place. Otherwise the inner arrays are appended in order.
+template <class S, class I, class T_INNER, class F>
+void adaptorF_flattenNestedArray(size_t outerSize, const F& getInner, std::vector<S>& dataOut, std::vector<I>& dataStartOut) {
+  dataStartOut.resize(outerSize+1);
+  dataStartOut[0] = 0;
+
+  if (!AdaptorHasSize<T_INNER>::value) {
+    std::vector<S> tempVec;
+    for (size_t i = 0; i < outerSize; i++) {
+      adaptorF_convertToStdVector<S>(getInner(i), tempVec);
+      dataOut.insert(dataOut.end(), tempVec.begin(), tempVec.end());
+      dataStartOut[i+1] = dataOut.size();
+    }
+    return;
+  }
+
+  // Count, and sum within each chunk
+  size_t nChunks = parallelChunkCount(outerSize);
+  std::vector<size_t> chunkTotals(nChunks, 0);
+  parallelForChunks(0, outerSize, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+    size_t total = 0;
+    for (size_t i = begin; i < end; i++) {
+      total += adaptorF_sizeHint(getInner(i));
+      dataStartOut[i+1] = total;
+    }
+    chunkTotals[iChunk] = total;
+  });
+
+  // Offset each chunk by the chunks before it
+  std::vector<size_t> chunkOffsets(nChunks, 0);
+  for (size_t iChunk = 1; iChunk < nChunks; iChunk++) {
+    chunkOffsets[iChunk] = chunkOffsets[iChunk-1] + chunkTotals[iChunk-1];
+  }
+  parallelForChunks(0, outerSize, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+    if (chunkOffsets[iChunk] == 0) return;
+    for (size_t i = begin; i < end; i++) {
+      dataStartOut[i+1] += chunkOffsets[iChunk];
+    }
+  });
+
+  // Fill
+  dataOut.resize(dataStartOut[outerSize]);
+  parallelFor(0, outerSize, [&](size_t begin, size_t end) {
+    std::vector<S> tempVec;
+    for (size_t i = begin; i < end; i++) {
+      adaptorF_convertToStdVector<S>(getInner(i), tempVec);
+      if (tempVec.size() != static_cast<size_t>(dataStartOut[i+1] - dataStartOut[i])) {
+        exception("inner array size changed while converting nested array");
+      }
+      std::copy(tempVec.begin(), tempVec.end(), dataOut.begin() + dataStartOut[i]);
+    }
+  });
+}
+
 // Note: this dummy function is defined so the non-dependent name adaptorF_custom_convertArrayOfVectorToStdVector will
 // always resolve to something; some compilers will throw an error if the name doesn't resolve.
 inline void adaptorF_custom_convertNestedArrayToStdVector(void* dont_use) {
@@ -919,12 +1140,14 @@ adaptorF_convertNestedArrayToStdVectorImpl(PreferenceT<5>, const T& inputData) {
 
   dataStartOut[0] = 0;
 
-  for (size_t i = 0; i < outerSize; i++) {
-    for (size_t j = 0; j < innerSize; j++) {
-      dataOut[innerSize * i + j] = inputData(i, j);
+  parallelFor(0, outerSize, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      for (size_t j = 0; j < innerSize; j++) {
+        dataOut[innerSize * i + j] = inputData(i, j);
+      }
+      dataStartOut[i+1] = innerSize * (i + 1);
     }
-    dataStartOut[i+1] = innerSize * (i + 1);
-  }
+  });
 
   return outTuple;
 }
@@ -945,17 +1168,8 @@ adaptorF_convertNestedArrayToStdVectorImpl(PreferenceT<4>, const T& inputData) {
   std::tuple<std::vector<S>, std::vector<I>> outTuple;
   std::vector<S>& dataOut = std::get<0>(outTuple);
   std::vector<I>& dataStartOut = std::get<1>(outTuple);
-  dataStartOut.resize(outerSize+1);
-
-  std::vector<S> tempVec;
-
-  for (size_t i = 0; i < outerSize; i++) {
-    adaptorF_convertToStdVector<S>(inputData[i], tempVec);
-    for(auto& s : tempVec) {
-      dataOut.push_back(s);
-    }
-    dataStartOut[i+1] = dataOut.size();
-  }
+  adaptorF_flattenNestedArray<S, I, T_INNER>(outerSize, [&](size_t i) -> decltype(inputData[i]) { return inputData[i]; },
+                                             dataOut, dataStartOut);
 
   return outTuple;
 }
@@ -976,17 +1190,8 @@ adaptorF_convertNestedArrayToStdVectorImpl(PreferenceT<3>, const T& inputData) {
   std::tuple<std::vector<S>, std::vector<I>> outTuple;
   std::vector<S>& dataOut = std::get<0>(outTuple);
   std::vector<I>& dataStartOut = std::get<1>(outTuple);
-  dataStartOut.resize(outerSize+1);
-  
-  std::vector<S> tempVec;
-
-  for (size_t i = 0; i < outerSize; i++) {
-    adaptorF_convertToStdVector<S>(inputData(i), tempVec);
-    for(auto& s : tempVec) {
-      dataOut.push_back(s);
-    }
-    dataStartOut[i+1] = dataOut.size();
-  }
+  adaptorF_flattenNestedArray<S, I, T_INNER>(outerSize, [&](size_t i) -> decltype(inputData(i)) { return inputData(i); },
+                                             dataOut, dataStartOut);
 
   return outTuple;
 }
@@ -1014,14 +1219,19 @@ adaptorF_convertNestedArrayToStdVectorImpl(PreferenceT<2>, const T& inputData) {
   std::vector<I>& dataStartOut = std::get<1>(outTuple);
   dataStartOut.resize(outerSize+1);
 
+  // presize the output when the inner arrays report their size, so it is not grown one entry at a time
+  size_t totalSize = 0;
+  for (const auto& n : inputData) {
+    totalSize += adaptorF_sizeHint(n);
+  }
+  dataOut.reserve(totalSize);
+
   std::vector<S> tempVec;
 
   size_t i = 0;
   for (const auto& n : inputData) {
     adaptorF_convertToStdVector<S>(n, tempVec);
-    for(auto& s : tempVec) {
-      dataOut.push_back(s);
-    }
+    dataOut.insert(dataOut.end(), tempVec.begin(), tempVec.end());
     dataStartOut[i+1] = dataOut.size();
     i++;
   }
@@ -1180,7 +1390,22 @@ std::vector<D> standardizeArray(const T& inputData) {
 // class T: input array type
 template <class O, unsigned int D, class T>
 std::vector<O> standardizeVectorArray(const T& inputData) {
-  return adaptorF_convertArrayOfVectorToStdVector<O, D, T>(inputData);
+  std::vector<O> out;
+  adaptorF_convertArrayOfVectorToStdVector<O, D, T>(inputData, out);
+  return out;
+}
+
+// Convert an array of 3D positions to floats relative to `origin`, for a structure with that position origin (see
+// Structure::setPositionOrigin()). The positions are read and offset in double precision, so only the small relative
+// coordinates get rounded.
+template <class T>
+std::vector<glm::vec3> standardizePositionsRelativeTo(const T& inputData, glm::dvec3 origin) {
+  std::vector<glm::dvec3> positions = standardizeVectorArray<glm::dvec3, 3>(inputData);
+  std::vector<glm::vec3> out(positions.size());
+  for (size_t i = 0; i < positions.size(); i++) {
+    out[i] = glm::vec3(positions[i] - origin);
+  }
+  return out;
 }
 
 // Convert a nested array where the inner types have variable length.
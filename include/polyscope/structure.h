@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -9,7 +11,10 @@
 
 #include "glm/glm.hpp"
 
+#include "polyscope/bvh.h"
+#include "polyscope/keyframes.h"
 #include "polyscope/persistent_value.h"
+#include "polyscope/quantity_list.h"
 #include "polyscope/render/engine.h"
 #include "polyscope/transformation_gizmo.h"
 #include "polyscope/weak_handle.h"
@@ -44,6 +49,18 @@ public:
   virtual void drawDelayed() = 0;
   virtual void drawPick() = 0;
 
+  // Optionally set the uniforms of the structure's own programs ahead of draw(), see drawStructures(). This is called
+  // concurrently for different structures, under a render::UniformRecording, so it must not otherwise touch the render
+  // backend. Structures which do it set drawPrepared, which the following draw() consumes.
+  virtual void prepareDraw();
+
+  // Optionally compute the derived data (normals, element centers, index orders, ...) which the structure's programs
+  // will upload when they are next prepared, so that it can be done for many structures at once before the first draw.
+  // prepareHostData() is called concurrently for different structures, only if hasPendingHostData(), so it must not
+  // touch the render backend or read back render buffers.
+  virtual bool hasPendingHostData();
+  virtual void prepareHostData();
+
   // == Add rendering rules
   std::vector<std::string> addStructureRules(std::vector<std::string> initRules);
 
@@ -68,9 +85,35 @@ public:
   float lengthScale();                            // get characteristic length
   virtual bool hasExtents();                      // bounding box and length scale are only meaningful if true
 
+  // = Frustum culling
+  // Structures which are certainly outside the current view, entirely sliced away by the slice planes, or hidden behind
+  // the previous frame (see options::occlusionCulling) get skipped when drawing. Culling is conservative, the bounding
+  // box is padded by getDrawBoundsPadding() and structures which disallow culling are always drawn.
+  bool isInViewFrustum();             // true unless the structure can be skipped for the current view
+  bool isOccluded();                  // true if the structure is skipped because it is hidden behind the previous frame
+  virtual bool allowFrustumCulling(); // false if the structure may draw outside its padded bounding box
+
+  // Approximate number of pixels covered by the projected bounding box in the current viewport, useful for choosing a
+  // level of detail. If the box reaches behind the camera, this is the whole viewport.
+  double screenPixelArea();
+  double objectSpaceBoxPixelArea(const std::tuple<glm::vec3, glm::vec3>& box); // the same, for part of the structure
+
+  // = CPU picking
+  // Intersect the world space ray start + t * dir with the structure on the CPU, as an alternative to rendering the pick
+  // buffer (see options::rayCastPicking). The start is in double precision, see setPositionOrigin(). If it hits closer than tHit, sets tHit and the local pick index drawPick()
+  // would give there, and returns true. Only valid if supportsRayCastPicking(), which is false unless overridden, and
+  // may also be false while the structure draws something the CPU version cannot reproduce (e.g. keyframes).
+  virtual bool supportsRayCastPicking();
+  virtual bool rayCastPick(glm::dvec3 rayStart, glm::vec3 rayDir, float& tHit, size_t& localPickInd);
+
   // = Basic state
   virtual std::string typeName() = 0;
 
+  // = Memory
+  // Bytes held by the managed buffers of the structure and all of its quantities, on the host and on the device, and
+  // the overhead of the structure's own bookkeeping
+  virtual render::MemoryUsage getMemoryUsage();
+
   // = Scene transform
   glm::mat4 getModelView();
   void centerBoundingBox();
@@ -82,15 +125,39 @@ public:
   glm::mat4x4 getTransform();
   glm::vec3 getPosition();
 
+  // = Large coordinates
+  // A double precision origin which the stored positions of the structure are relative to, e.g. for geospatial data
+  // with coordinates around 1e6 stored as floats (see standardizePositionsRelativeTo()). The origin is applied before
+  // the transform, and the model-view matrix is composed in double precision on the CPU, so the GPU only sees small
+  // camera-relative coordinates. Picking and the CPU culling tests go through the same matrices.
+  void setPositionOrigin(glm::dvec3 newOrigin);
+  glm::dvec3 getPositionOrigin();
+  glm::dmat4 getModelMatrix(); // object space (relative to the origin) to world space, in double precision
+
+  // The gizmo to interactively edit the transform
+  void setTransformGizmoEnabled(bool newVal);
+  bool getTransformGizmoEnabled();
+  TransformationGizmo& getTransformGizmo(); // created if needed
+
   void setStructureUniforms(render::ShaderProgram& p);
   bool wantsCullPosition();
 
   // Re-perform any setup work, including refreshing all quantities
   virtual void refresh();
 
+  // Called when one of the structure's quantities is enabled or disabled, see QuantityStructure::getEnabledQuantities()
+  virtual void markEnabledQuantitiesStale();
+
+  // Only regenerate the shader programs, see polyscope::refreshShaderPrograms(). Structures which derive data in
+  // refresh() override this to keep it, by default it is refresh().
+  virtual void refreshShaderPrograms();
+
   // Get rid of it (invalidates the object and all pointers, etc!)
   void remove();
 
+  // A stable handle for getStructure(StructureHandle), assigned on registration
+  StructureHandle getHandle() const { return handle; }
+
   // Selection tools
   virtual Structure* setEnabled(bool newEnabled);
   bool isEnabled();
@@ -104,27 +171,68 @@ public:
   Structure* setTransparency(float newVal); // also enables transparency if <1 and transparency is not enabled
   float getTransparency();
 
+  // True if the structure blends its transparent fragments sorted back to front itself, rather than being accumulated
+  // with the others under weighted blended transparency. Such structures are drawn once more after the weighted
+  // composite, over the opaque scene. See PointCloud::setTransparencySorting().
+  virtual bool drawsSortedTransparency();
+
   Structure* setCullWholeElements(bool newVal);
   bool getCullWholeElements();
 
   Structure* setIgnoreSlicePlane(std::string name, bool newValue);
   bool getIgnoreSlicePlane(std::string name);
 
+  // = Keyframe playback
+  // Keyframed data (see e.g. PointCloud::setPointPositionKeyframes()) is drawn at this time, which is measured in
+  // frames and blends linearly between them. While playing, the time advances at the playback speed and loops.
+  Structure* setKeyframeTime(float newTime);
+  float getKeyframeTime();
+  Structure* setKeyframesPlaying(bool newVal);
+  bool getKeyframesPlaying();
+  Structure* setKeyframePlaybackSpeed(float framesPerSecond);
+  float getKeyframePlaybackSpeed();
+  size_t nKeyframes(); // 0 if the structure has no keyframed data
+  bool hasPositionKeyframes();
+  void clearPositionKeyframes();
+
+  // All keyframed data of a structure shares one timeline, so it must all have the same number of frames
+  void registerKeyframeCount(size_t nFrames);
+  void updateKeyframePlayback(); // advance the time while playing, called once per frame
+
 protected:
   // = State
+  StructureHandle handle = INVALID_STRUCTURE_HANDLE; // set by the registry, see polyscope.cpp
+  friend bool registerStructure(Structure* structure, bool replaceIfPresent);
+  friend void removeStructure(std::string type, std::string name, bool errorIfAbsent);
   PersistentValue<bool> enabled;
   PersistentValue<glm::mat4> objectTransform; // rigid transform
+  glm::dvec3 positionOrigin{0., 0., 0.};       // see setPositionOrigin()
 
   // 0 for transparent, 1 for opaque, only has effect if engine transparency is set
   PersistentValue<float> transparency;
 
-  // Widget that wraps the transform
-  TransformationGizmo transformGizmo;
+  // Widget that wraps the transform. Created on first use, most structures never show it.
+  std::unique_ptr<TransformationGizmo> transformGizmo;
+
+  bool drawPrepared = false; // see prepareDraw()
 
   PersistentValue<bool> cullWholeElements;
 
   PersistentValue<std::vector<std::string>> ignoredSlicePlaneNames;
 
+  // Keyframed positions of the elements of the structure, if any, and the timeline of all keyframed data
+  std::unique_ptr<KeyframeSeries> positionKeyframes;
+  size_t keyframeCount = 0;
+  float keyframeTime = 0.;
+  bool keyframesPlaying = false;
+  float keyframePlaybackSpeed = 24.;
+  std::chrono::steady_clock::time_point lastKeyframeUpdate;
+
+  // Set the position keyframes, for a structure with nElements positions, and rebuild the programs to use them
+  void setPositionKeyframeData(const std::vector<std::vector<glm::vec3>>& frames, size_t nElements);
+  void includeKeyframesInBounds(); // widen the object space bounding box to cover all frames
+  void buildKeyframeUI();
+
   // Manage the bounding box & length scale
   // (this is defined _before_ the object transform is applied. To get the scale/bounding box after transforms, use the
   // boundingBox() and lengthScale() member function)
@@ -132,6 +240,50 @@ protected:
   std::tuple<glm::vec3, glm::vec3> objectSpaceBoundingBox;
   float objectSpaceLengthScale;
   virtual void updateObjectSpaceBounds() = 0;
+
+  // Helpers for structures defined by a set of positions. The bounds are computed with a parallel reduction, which
+  // skips non-finite coordinates.
+  static std::tuple<glm::vec3, glm::vec3> computePointBounds(const glm::vec3* points, size_t count);
+  void setObjectSpaceBoundsFromPoints(const std::vector<glm::vec3>& points); // exact box and length scale
+
+  // Keep the object space bounding box covering the positions after they are updated, given the bounds of the updated
+  // positions. The box grows to cover them. If `coversAll`, they are the bounds of every position, and the box is
+  // also shrunk to them when the scene extents are computed automatically. The length scale is left as it is, so
+  // relative sizes do not drift while geometry moves.
+  void refitObjectSpaceBounds(std::tuple<glm::vec3, glm::vec3> updatedBounds, bool coversAll);
+  void refitObjectSpaceBounds(const std::vector<glm::vec3>& points); // all positions were updated
+
+  // How far drawn geometry may extend beyond the object space bounds, in world units (e.g. a point radius)
+  virtual float getDrawBoundsPadding();
+
+  // Test an object-space box against the current view frustum, after padding it by `padding` world units. Used for
+  // the structure as a whole, but can also be applied to parts of a structure.
+  bool objectSpaceBoxInViewFrustum(const std::tuple<glm::vec3, glm::vec3>& box, float padding);
+
+  // True if an object-space box, padded by `padding` world units, lies entirely on the sliced away side of some active
+  // slice plane which this structure does not ignore. Anything drawn inside it would be discarded by the fragment test.
+  bool objectSpaceBoxSlicedAway(const std::tuple<glm::vec3, glm::vec3>& box, float padding);
+
+  // True if an object-space box, padded by `padding` world units, is entirely behind the depth of the previously rendered
+  // frame, see options::occlusionCulling.
+  bool objectSpaceBoxOccluded(const std::tuple<glm::vec3, glm::vec3>& box, float padding);
+
+  // Axis-aligned bounds in view space of an object-space box, padded by `padding` world units
+  void objectSpaceBoxToViewSpace(const std::tuple<glm::vec3, glm::vec3>& box, float padding, glm::vec3& viewMin,
+                                 glm::vec3& viewMax);
+
+  // Acceleration structure for rayCastPick(), over object space primitives. Created and built on first use, structures
+  // set the refit flag when their positions change.
+  std::unique_ptr<BVH> pickBVH;
+  bool pickBVHNeedsRefit = false;
+
+  // Build pickBVH over nPrims primitives if it is missing or has a different count, or refit it if flagged.
+  // computeBoxes(boxes) fills the nPrims boxes, and is only called if they are needed.
+  void ensurePickBVH(size_t nPrims, const std::function<void(std::vector<BVH::Box>&)>& computeBoxes);
+
+  // Bring a world space ray to object space, returning the start. The direction is not normalized, so ray parameters
+  // agree between the two.
+  glm::vec3 worldRayToObjectSpace(glm::dvec3 rayStart, glm::vec3& rayDir);
 };
 
 
@@ -156,6 +308,13 @@ class ColorRenderImageQuantity;
 class ScalarRenderImageQuantity;
 class RawColorRenderImageQuantity;
 class RawColorAlphaRenderImageQuantity;
+class TiledImageQuantity;
+
+// Produces a tile of a TiledImageQuantity, called on a background thread. Writes the w x h pixels at (x, y) of the
+// given pyramid level (level 0 is full resolution, each level above halves it, rounding up) to `pixelsRGBA`, as tightly
+// packed rows of 8-bit RGBA in the image's row order. Exceptions are reported as warnings and the tile is skipped.
+using TiledImageLoader =
+    std::function<void(size_t level, size_t x, size_t y, size_t w, size_t h, unsigned char* pixelsRGBA)>;
 
 // Helper used to define quantity types
 template <typename T>
@@ -177,9 +336,12 @@ public:
 
   virtual void buildQuantitiesUI() override;
   virtual void buildStructureOptionsUI() override;
+  virtual bool allowFrustumCulling() override;
+  virtual render::MemoryUsage getMemoryUsage() override;
 
   // Re-perform any setup work, including refreshing all quantities
   virtual void refresh() override;
+  void refreshQuantityShaderPrograms(); // for subclasses which override refreshShaderPrograms()
 
   // = Manage quantities
 
@@ -199,14 +361,20 @@ public:
 
   void setAllQuantitiesEnabled(bool newEnabled);
 
+  // The enabled quantities, in the same order as the lists below. Drawing iterates these, rather than every quantity.
+  // They are gathered again after a quantity is added, removed, enabled or disabled.
+  const std::vector<QuantityType*>& getEnabledQuantities();
+  const std::vector<FloatingQuantity*>& getEnabledFloatingQuantities();
+  virtual void markEnabledQuantitiesStale() override;
+
   // = Quantities
-  std::map<std::string, std::unique_ptr<QuantityType>> quantities;
+  QuantityList<QuantityType> quantities;
   QuantityS<S>* dominantQuantity = nullptr; // If non-null, a special quantity of which only one can be drawn for
                                             // the structure. Handles common case of a surface color, e.g. color of
                                             // a mesh or point cloud. The dominant quantity must always be enabled.
 
   // floating quantities are tracked separately from normal quantities, though names should still be unique etc
-  std::map<std::string, std::unique_ptr<FloatingQuantity>> floatingQuantities;
+  QuantityList<FloatingQuantity> floatingQuantities;
 
   // === Floating Quantities
   template <class T>
@@ -222,6 +390,21 @@ public:
   ColorImageQuantity* addColorAlphaImageQuantity(std::string name, size_t dimX, size_t dimY, const T& values_rgba,
                                                  ImageOrigin imageOrigin = ImageOrigin::UpperLeft);
 
+  // Add images from raw, tightly packed pixels (see ColorImageQuantity::updatePixels()), e.g. 8-bit camera frames.
+  // These are stored on the device at the precision they are given in (R8/RGBA8 for UNorm8, R16/RGBA16 for UNorm16),
+  // reading as [0,1] values, and no float copy is kept on the host.
+  ScalarImageQuantity* addScalarImageQuantityFromPixels(std::string name, size_t dimX, size_t dimY,
+                                                        const void* pixels, PixelComponentType componentType,
+                                                        ImageOrigin imageOrigin = ImageOrigin::UpperLeft,
+                                                        DataType type = DataType::STANDARD);
+  ColorImageQuantity* addColorImageQuantityFromPixels(std::string name, size_t dimX, size_t dimY, const void* pixels,
+                                                      int nChannels, PixelComponentType componentType,
+                                                      ImageOrigin imageOrigin = ImageOrigin::UpperLeft);
+
+  // A color image which is loaded in tiles as they come in to view, see TiledImageQuantity
+  TiledImageQuantity* addTiledImageQuantity(std::string name, size_t dimX, size_t dimY, TiledImageLoader loader,
+                                            size_t tileSize = 256, ImageOrigin imageOrigin = ImageOrigin::UpperLeft);
+
   template <class T1, class T2>
   DepthRenderImageQuantity* addDepthRenderImageQuantity(std::string name, size_t dimX, size_t dimY, const T1& depthData,
                                                         const T2& normalData,
@@ -284,6 +467,10 @@ public:
                                                                             ImageOrigin imageOrigin);
 
 protected:
+  std::vector<QuantityType*> enabledQuantities;
+  std::vector<FloatingQuantity*> enabledFloatingQuantities;
+  bool enabledQuantitiesStale = true;
+  void ensureEnabledQuantitiesCurrent();
 };
 
 
@@ -22,8 +22,8 @@ template <typename S>
 void QuantityStructure<S>::checkForQuantityWithNameAndDeleteOrError(std::string name, bool allowReplacement) {
 
   // Look for an existing quantity with this name
-  bool quantityExists = quantities.find(name) != quantities.end();
-  bool floatingQuantityExists = floatingQuantities.find(name) != floatingQuantities.end();
+  bool quantityExists = quantities.get(name) != nullptr;
+  bool floatingQuantityExists = floatingQuantities.get(name) != nullptr;
 
   // if it already exists and we cannot replace, throw an error
   if (!allowReplacement && (quantityExists || floatingQuantityExists)) {
@@ -46,6 +46,7 @@ void QuantityStructure<S>::addQuantity(QuantityType* q, bool allowReplacement) {
 
   // Add the new quantity
   quantities[q->name] = std::unique_ptr<QuantityType>(q);
+  markEnabledQuantitiesStale();
 }
 
 template <typename S>
@@ -56,22 +57,17 @@ void QuantityStructure<S>::addQuantity(FloatingQuantity* q, bool allowReplacemen
 
   // Add the new quantity
   floatingQuantities[q->name] = std::unique_ptr<FloatingQuantity>(q);
+  markEnabledQuantitiesStale();
 }
 
 template <typename S>
 typename QuantityStructure<S>::QuantityType* QuantityStructure<S>::getQuantity(std::string name) {
-  if (quantities.find(name) == quantities.end()) {
-    return nullptr;
-  }
-  return quantities[name].get();
+  return quantities.get(name);
 }
 
 template <typename S>
 FloatingQuantity* QuantityStructure<S>::getFloatingQuantity(std::string name) {
-  if (floatingQuantities.find(name) == floatingQuantities.end()) {
-    return nullptr;
-  }
-  return floatingQuantities[name].get();
+  return floatingQuantities.get(name);
 }
 
 template <typename S>
@@ -85,12 +81,46 @@ void QuantityStructure<S>::refresh() {
   requestRedraw();
 }
 
+template <typename S>
+void QuantityStructure<S>::refreshQuantityShaderPrograms() {
+  for (auto& qp : quantities) {
+    qp.second->refreshShaderPrograms();
+  }
+  for (auto& qp : floatingQuantities) {
+    qp.second->refreshShaderPrograms();
+  }
+  requestRedraw();
+}
+
+template <typename S>
+bool QuantityStructure<S>::allowFrustumCulling() {
+  if (!Structure::allowFrustumCulling()) return false;
+  for (QuantityType* q : getEnabledQuantities()) {
+    if (!q->drawsWithinStructureBounds()) return false;
+  }
+  // floating quantities (images, etc) are not tied to bounds
+  return getEnabledFloatingQuantities().empty();
+}
+
+template <typename S>
+render::MemoryUsage QuantityStructure<S>::getMemoryUsage() {
+  render::MemoryUsage usage = Structure::getMemoryUsage();
+  for (auto& qp : quantities) {
+    usage += qp.second->getManagedBufferMemoryUsage();
+  }
+  for (auto& qp : floatingQuantities) {
+    usage += qp.second->getManagedBufferMemoryUsage();
+  }
+  return usage;
+}
+
 template <typename S>
 void QuantityStructure<S>::removeQuantity(std::string name, bool errorIfAbsent) {
 
   // Look for an existing quantity with this name
-  bool quantityExists = quantities.find(name) != quantities.end();
-  bool floatingQuantityExists = floatingQuantities.find(name) != floatingQuantities.end();
+  QuantityType* q = quantities.get(name);
+  bool quantityExists = q != nullptr;
+  bool floatingQuantityExists = floatingQuantities.get(name) != nullptr;
 
   if (errorIfAbsent && !(quantityExists || floatingQuantityExists)) {
     exception("No quantity named " + name + " added to structure " + name);
@@ -100,8 +130,7 @@ void QuantityStructure<S>::removeQuantity(std::string name, bool errorIfAbsent)
   // delete standard quantities
   if (quantityExists) {
     // If this is the active quantity, clear it
-    QuantityType& q = *quantities[name];
-    if (dominantQuantity == &q) {
+    if (dominantQuantity == q) {
       clearDominantQuantity();
     }
 
@@ -113,6 +142,8 @@ void QuantityStructure<S>::removeQuantity(std::string name, bool errorIfAbsent)
   if (floatingQuantityExists) {
     floatingQuantities.erase(name);
   }
+
+  markEnabledQuantitiesStale();
 }
 
 template <typename S>
@@ -163,14 +194,57 @@ void QuantityStructure<S>::setAllQuantitiesEnabled(bool newEnabled) {
 
 
 template <typename S>
-void QuantityStructure<S>::buildQuantitiesUI() {
-  // Build the quantities
+void QuantityStructure<S>::markEnabledQuantitiesStale() {
+  enabledQuantitiesStale = true;
+}
+
+template <typename S>
+void QuantityStructure<S>::ensureEnabledQuantitiesCurrent() {
+  if (!enabledQuantitiesStale) return;
+  enabledQuantities.clear();
   for (auto& x : quantities) {
-    x.second->buildUI();
+    if (x.second->isEnabled()) enabledQuantities.push_back(x.second.get());
   }
+  enabledFloatingQuantities.clear();
   for (auto& x : floatingQuantities) {
-    x.second->buildUI();
+    if (x.second->isEnabled()) enabledFloatingQuantities.push_back(x.second.get());
   }
+  enabledQuantitiesStale = false;
+}
+
+template <typename S>
+const std::vector<typename QuantityStructure<S>::QuantityType*>& QuantityStructure<S>::getEnabledQuantities() {
+  ensureEnabledQuantitiesCurrent();
+  return enabledQuantities;
+}
+
+template <typename S>
+const std::vector<FloatingQuantity*>& QuantityStructure<S>::getEnabledFloatingQuantities() {
+  ensureEnabledQuantitiesCurrent();
+  return enabledFloatingQuantities;
+}
+
+template <typename S>
+void QuantityStructure<S>::buildQuantitiesUI() {
+  // Build the quantities
+  if (quantities.size() + floatingQuantities.size() <= 8) {
+    for (auto& x : quantities) {
+      x.second->buildUI();
+    }
+    for (auto& x : floatingQuantities) {
+      x.second->buildUI();
+    }
+    return;
+  }
+
+  // Long lists only build the rows in view
+  std::vector<Quantity*> rows;
+  rows.reserve(quantities.size() + floatingQuantities.size());
+  for (auto& x : quantities) rows.push_back(x.second.get());
+  for (auto& x : floatingQuantities) rows.push_back(x.second.get());
+  ImGuiClippedTreeList(
+      rows.size(), [&](size_t i) { return ImGuiTreeNodeIsOpen(rows[i]->niceName().c_str()); },
+      [&](size_t i) { rows[i]->buildUI(); });
 }
 
 template <typename S>
@@ -318,6 +392,15 @@ ScalarImageQuantity* createScalarImageQuantity(Structure& parent, std::string na
                                                DataType dataType);
 ColorImageQuantity* createColorImageQuantity(Structure& parent, std::string name, size_t dimX, size_t dimY,
                                              const std::vector<glm::vec4>& data, ImageOrigin imageOrigin);
+ScalarImageQuantity* createScalarImageQuantityFromPixels(Structure& parent, std::string name, size_t dimX,
+                                                         size_t dimY, const void* pixels,
+                                                         PixelComponentType componentType, ImageOrigin imageOrigin,
+                                                         DataType dataType);
+ColorImageQuantity* createColorImageQuantityFromPixels(Structure& parent, std::string name, size_t dimX, size_t dimY,
+                                                       const void* pixels, int nChannels,
+                                                       PixelComponentType componentType, ImageOrigin imageOrigin);
+TiledImageQuantity* createTiledImageQuantity(Structure& parent, std::string name, size_t dimX, size_t dimY,
+                                             TiledImageLoader loader, size_t tileSize, ImageOrigin imageOrigin);
 DepthRenderImageQuantity* createDepthRenderImage(Structure& parent, std::string name, size_t dimX, size_t dimY,
                                                  const std::vector<float>& depthData,
                                                  const std::vector<glm::vec3>& normalData, ImageOrigin imageOrigin);
@@ -365,6 +448,40 @@ ColorImageQuantity* QuantityStructure<S>::addColorImageQuantityImpl(std::string
   return q;
 }
 
+template <typename S>
+ScalarImageQuantity* QuantityStructure<S>::addScalarImageQuantityFromPixels(std::string name, size_t dimX, size_t dimY,
+                                                                            const void* pixels,
+                                                                            PixelComponentType componentType,
+                                                                            ImageOrigin imageOrigin, DataType type) {
+  checkForQuantityWithNameAndDeleteOrError(name);
+  ScalarImageQuantity* q =
+      createScalarImageQuantityFromPixels(*this, name, dimX, dimY, pixels, componentType, imageOrigin, type);
+  addQuantity(q);
+  return q;
+}
+
+template <typename S>
+ColorImageQuantity* QuantityStructure<S>::addColorImageQuantityFromPixels(std::string name, size_t dimX, size_t dimY,
+                                                                          const void* pixels, int nChannels,
+                                                                          PixelComponentType componentType,
+                                                                          ImageOrigin imageOrigin) {
+  checkForQuantityWithNameAndDeleteOrError(name);
+  ColorImageQuantity* q =
+      createColorImageQuantityFromPixels(*this, name, dimX, dimY, pixels, nChannels, componentType, imageOrigin);
+  addQuantity(q);
+  return q;
+}
+
+template <typename S>
+TiledImageQuantity* QuantityStructure<S>::addTiledImageQuantity(std::string name, size_t dimX, size_t dimY,
+                                                                TiledImageLoader loader, size_t tileSize,
+                                                                ImageOrigin imageOrigin) {
+  checkForQuantityWithNameAndDeleteOrError(name);
+  TiledImageQuantity* q = createTiledImageQuantity(*this, name, dimX, dimY, loader, tileSize, imageOrigin);
+  addQuantity(q);
+  return q;
+}
+
 template <typename S>
 DepthRenderImageQuantity* QuantityStructure<S>::addDepthRenderImageQuantityImpl(
     std::string name, size_t dimX, size_t dimY, const std::vector<float>& depthData,
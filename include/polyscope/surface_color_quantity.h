@@ -16,7 +16,7 @@ class SurfaceParameterizationQuantity;
 class SurfaceColorQuantity : public SurfaceMeshQuantity, public ColorQuantity<SurfaceColorQuantity> {
 public:
   SurfaceColorQuantity(std::string name, SurfaceMesh& mesh_, std::string definedOn,
-                       const std::vector<glm::vec3>& colorValues);
+                       std::vector<glm::vec3> colorValues);
 
   virtual void draw() override;
   virtual std::string niceName() override;
@@ -27,6 +27,10 @@ protected:
   const std::string definedOn;
   std::shared_ptr<render::ShaderProgram> program;
 
+  // Face colors drawn with MESH_FETCH_COLOR, see SurfaceMesh::generateElementTexture()
+  std::shared_ptr<render::TextureBuffer> elementTexture;
+  uint64_t elementTextureDataVersion = 0;
+
   // Helpers
   virtual void createProgram() = 0;
 };
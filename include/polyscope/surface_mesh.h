@@ -2,12 +2,15 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <future>
 #include <memory>
 #include <vector>
 
 #include "polyscope/affine_remapper.h"
 #include "polyscope/color_management.h"
+#include "polyscope/element_selection.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 #include "polyscope/render/managed_buffer.h"
@@ -64,13 +67,15 @@ public:
   SurfaceMesh(std::string name);
 
   // From flattened list
-  SurfaceMesh(std::string name, const std::vector<glm::vec3>& vertexPositions,
-              const std::vector<uint32_t>& faceIndsEntries, const std::vector<uint32_t>& faceIndsStart);
+  SurfaceMesh(std::string name, std::vector<glm::vec3> vertexPositions, std::vector<uint32_t> faceIndsEntries,
+              std::vector<uint32_t> faceIndsStart);
 
   // Construct from a nested face list
-  SurfaceMesh(std::string name, const std::vector<glm::vec3>& vertexPositions,
+  SurfaceMesh(std::string name, std::vector<glm::vec3> vertexPositions,
               const std::vector<std::vector<size_t>>& faceIndices);
 
+  ~SurfaceMesh();
+
 
   // Build the imgui display
   virtual void buildCustomUI() override;
@@ -79,11 +84,17 @@ public:
 
   // Render the the structure on screen
   virtual void draw() override;
+  virtual void prepareDraw() override;
+  virtual bool hasPendingHostData() override;
+  virtual void prepareHostData() override;
   virtual void drawDelayed() override;
   virtual void drawPick() override;
   virtual void updateObjectSpaceBounds() override;
   virtual std::string typeName() override;
   virtual void refresh() override;
+  virtual void refreshShaderPrograms() override;
+  virtual bool supportsRayCastPicking() override;
+  virtual bool rayCastPick(glm::dvec3 rayStart, glm::vec3 rayDir, float& tHit, size_t& localPickInd) override;
 
   // Mesh connectivity
   // (end users probably should not mess with theses)
@@ -107,8 +118,12 @@ public:
   render::ManagedBuffer<uint32_t> triangleAllCornerInds;   // on triangulated mesh, all 3 [3 * 3 * nTriFace]
 
   // internal triangle data for rendering
-  render::ManagedBuffer<glm::vec3> baryCoord;  // on the split, triangulated mesh [3 * nTriFace]
-  render::ManagedBuffer<glm::vec3> edgeIsReal; // on the split, triangulated mesh [3 * nTriFace]
+  render::ManagedBuffer<glm::vec3> edgeIsReal; // on the split, triangulated mesh [3 * nTriFace], host only, see
+                                               // generateEdgeMaskTexture()
+  render::ManagedBuffer<uint32_t> chunkCornerOrder; // triangulated corners in spatially sorted order [3 * nTriFace]
+  render::ManagedBuffer<uint32_t> cacheOrderedVertexInds; // triangleVertexInds, triangles in cache order [3 * nTriFace]
+  render::ManagedBuffer<float> keyframeInds;              // the index of each vertex, for reading keyframe textures
+  render::ManagedBuffer<uint32_t> lodTriangleVertexInds; // the simplified triangulations, one level after the other
 
   // other internally-computed geometry
   render::ManagedBuffer<glm::vec3> faceNormals;
@@ -162,6 +177,27 @@ public:
 
   // clang-format on
 
+  // Overloads which take ownership of an std::vector rather than copying it, see PointCloud::addScalarQuantity()
+  SurfaceVertexScalarQuantity* addVertexScalarQuantity(std::string name, std::vector<float>&& data,
+                                                       DataType type = DataType::STANDARD);
+  SurfaceFaceScalarQuantity* addFaceScalarQuantity(std::string name, std::vector<float>&& data,
+                                                   DataType type = DataType::STANDARD);
+  SurfaceVertexColorQuantity* addVertexColorQuantity(std::string name, std::vector<glm::vec3>&& colors);
+  SurfaceFaceColorQuantity* addFaceColorQuantity(std::string name, std::vector<glm::vec3>&& colors);
+  SurfaceVertexVectorQuantity* addVertexVectorQuantity(std::string name, std::vector<glm::vec3>&& vectors,
+                                                       VectorType vectorType = VectorType::STANDARD);
+  SurfaceFaceVectorQuantity* addFaceVectorQuantity(std::string name, std::vector<glm::vec3>&& vectors,
+                                                   VectorType vectorType = VectorType::STANDARD);
+
+  // Like addVertexScalarQuantity() and addFaceScalarQuantity(), but the values are read in place from `count` floats
+  // of externally-owned memory rather than copied, see PointCloud::addScalarQuantityView()
+  SurfaceVertexScalarQuantity* addVertexScalarQuantityView(std::string name, const float* values, size_t count,
+                                                           std::shared_ptr<void> lifetimeToken = nullptr,
+                                                           DataType type = DataType::STANDARD);
+  SurfaceFaceScalarQuantity* addFaceScalarQuantityView(std::string name, const float* values, size_t count,
+                                                       std::shared_ptr<void> lifetimeToken = nullptr,
+                                                       DataType type = DataType::STANDARD);
+
   // special quantity-related methods
   SurfaceParameterizationQuantity* getParameterization(std::string name);
 
@@ -174,9 +210,26 @@ public:
   // NOTE: these DO NOT automatically recompute der
   template <class V>
   void updateVertexPositions(const V& newPositions);
+
+  // Like updateVertexPositions(), but may be called from any thread. The positions are converted on the calling thread
+  // and swapped in by the render thread at the next sync point, see stageUpdate().
+  template <class V>
+  void stageVertexPositions(const V& newPositions);
   template <class V>
   void updateVertexPositions2D(const V& newPositions2D);
 
+  // Positions of every vertex in each entry of `frames`, for playing back an animated mesh. All frames are uploaded
+  // once and blended on the GPU, see Structure::setKeyframeTime(). The host positions in `vertexPositions` are
+  // unchanged. While keyframes are set, the mesh is shaded with flat normals computed from the blended positions.
+  template <class V>
+  void setVertexPositionKeyframes(const std::vector<V>& frames);
+
+  // A vertex scalar which varies over time, with a value for every vertex in each entry of `frames`, played back along
+  // with the position keyframes.
+  template <class T>
+  SurfaceVertexScalarQuantity* addVertexScalarKeyframes(std::string name, const std::vector<T>& frames,
+                                                        DataType type = DataType::STANDARD);
+
   // === Set transparency alpha from a scalar quantity
   // effect is multiplicative with other transparency values
   // values are clamped to [0,1]
@@ -249,6 +302,13 @@ public:
   // (note that this may not match the halfedge perm that the user specifies)
   std::vector<size_t> twinHalfedge; // for halfedge i, the index of a twin halfedge
 
+  // = Vertex-face adjacency
+  // The faces around each vertex in CSR form, one entry per corner, in face order. Lets per-vertex geometry be gathered
+  // in parallel rather than scattered from the faces. Call ensureHaveVertexFaceAdjacency() to be sure it is populated.
+  void ensureHaveVertexFaceAdjacency();
+  std::vector<uint32_t> vertexFaceAdjStart;   // [nVertices + 1]
+  std::vector<uint32_t> vertexFaceAdjEntries; // [nCorners], the face of each corner at the vertex
+
   static const std::string structureTypeName;
 
   // === Getters and setters for visualization settings
@@ -282,6 +342,42 @@ public:
   SurfaceMesh* setShadeStyle(MeshShadeStyle newStyle);
   MeshShadeStyle getShadeStyle();
 
+  // Chunked drawing: split the triangulation into spatially coherent chunks of (at most) this many triangles, each
+  // with its own bounding box, and skip chunks outside the view frustum, entirely sliced away by the slice planes, or
+  // hidden behind the previous frame (see options::occlusionCulling) when drawing. With BackFacePolicy::Cull, chunks whose faces all point away from the camera (judged from a cone bounding
+  // their normals) are skipped too. 0 (the default) draws the whole mesh at once. Only the order in which triangles are drawn changes,
+  // quantities and picking work as usual.
+  SurfaceMesh* setChunkSize(size_t trianglesPerChunk);
+  size_t getChunkSize();
+  size_t nChunks();
+  size_t nVisibleChunks(); // as of the most recent draw
+
+  // Vertex cache ordering: when drawing with the index buffer (see canDrawIndexed()), draw the triangles in an order
+  // which reuses recently transformed vertices, computed once on first use. Off by default. Like chunking, only the
+  // draw order changes, the triangulation used by quantities and picking keeps the input face order.
+  SurfaceMesh* setVertexCacheOrder(bool newVal);
+  bool getVertexCacheOrder();
+
+  // Level of detail: simplify the mesh on a background thread in to a chain of ever coarser triangulations of the same
+  // vertices (see clusterSimplifyTriangles()), and each frame draw the coarsest level whose simplification error
+  // projects to at most getLODPixelError() pixels, so close-ups fall back on the full mesh. Off by default. Only applies
+  // when drawing with the index buffer (see canDrawIndexed()); vertex quantities are simplified along with the mesh,
+  // picking and all other quantities use the full mesh. The chain is rebuilt when the vertex positions change.
+  SurfaceMesh* setLODEnabled(bool newVal);
+  bool getLODEnabled();
+  SurfaceMesh* setLODPixelError(float newVal);
+  float getLODPixelError();
+  size_t nLODLevels();       // simplified levels available so far, not counting the full mesh
+  size_t getLODLevelDrawn(); // as of the most recent draw, 0 is the full mesh
+  void waitForLODBuild();    // block until the background build (if any) is done, and take its result
+
+  // Selection: faces can be marked as selected, which tints them (and the quantities drawn on them) towards the
+  // selection color. The selection is created on first use. Changing which faces are selected only uploads the changed
+  // bits, see ElementSelection. While there is a selection the mesh is drawn per corner, see canDrawIndexed().
+  ElementSelection& getFaceSelection();
+  bool hasFaceSelection();
+  void removeFaceSelection();
+
   // == Rendering helpers used by quantities
 
   // void fillGeometryBuffers(render::ShaderProgram& p);
@@ -290,6 +386,35 @@ public:
   void setMeshGeometryAttributes(render::ShaderProgram& p);
   void setMeshPickAttributes(render::ShaderProgram& p);
   void setSurfaceMeshUniforms(render::ShaderProgram& p);
+  void drawMeshProgram(render::ShaderProgram& p); // draw p, restricted to the visible chunks if the mesh is chunked
+
+  // Programs which only read per-vertex data can draw with the triangle index buffer (DrawMode::IndexedTriangles),
+  // storing one attribute entry per vertex rather than one per triangle corner. That is possible unless the mesh
+  // itself needs per-corner data (flat normals, wireframe, whole-element culling, transparency, a face selection) or is
+  // chunked. Such
+  // programs request getVertexMeshProgramName(), and get their per-vertex buffers from getVertexAttributeBuffer().
+  bool canDrawIndexed();
+  std::string getVertexMeshProgramName(); // "INDEXED_MESH" if canDrawIndexed(), otherwise "MESH"
+  template <typename T>
+  std::shared_ptr<render::AttributeBuffer> getVertexAttributeBuffer(render::ShaderProgram& p,
+                                                                    render::ManagedBuffer<T>& vertexData);
+
+  // Per-element data (faces, edges, halfedges) can be read by the shader from a texture with one texel per element,
+  // indexed by the element of each triangle corner (the MESH_FETCH_* rules), so it is uploaded once at its own size
+  // rather than expanded to every corner. generateElementTexture() returns null if there are too many elements, then
+  // the data is expanded with getIndexedRenderAttributeBuffer() as usual.
+  static std::shared_ptr<render::TextureBuffer> generateElementTexture(const std::vector<float>& data);
+  static std::shared_ptr<render::TextureBuffer> generateElementTexture(const std::vector<glm::vec3>& data);
+  static std::shared_ptr<render::TextureBuffer> generateElementTexture(const float* data, size_t nElements);
+  static void updateElementTexture(render::TextureBuffer& texture, const std::vector<float>& data);
+  static void updateElementTexture(render::TextureBuffer& texture, const std::vector<glm::vec3>& data);
+  static void updateElementTexture(render::TextureBuffer& texture, const float* data, size_t nElements);
+
+  // The wireframe (MESH_WIREFRAME_FROM_BARY) reads which edges of each drawn triangle are real, rather than internal
+  // to a triangulated polygon, from a 3-bit mask per triangle packed 8 triangles to a texel, fetched by the triangle of
+  // each vertex. The barycentric coordinates come from the corner of each vertex, so neither is stored per corner.
+  // Takes the per-corner edgeIsReal data. If there are too many triangles, every edge is drawn.
+  static std::shared_ptr<render::TextureBuffer> generateEdgeMaskTexture(const std::vector<glm::vec3>& edgeIsReal);
 
 
   // === ~DANGER~ experimental/unsupported functions
@@ -320,8 +445,11 @@ private:
   std::vector<uint32_t> triangleAllCornerIndsData;   // index of the corresponding original corner
 
   // internal triangle data for rendering, defined per corner of the triangulated mesh
-  std::vector<glm::vec3> baryCoordData;  // always triangulated
   std::vector<glm::vec3> edgeIsRealData; // always triangulated
+  std::vector<uint32_t> chunkCornerOrderData;
+  std::vector<uint32_t> cacheOrderedVertexIndsData;
+  std::vector<float> keyframeIndsData;
+  std::vector<uint32_t> lodTriangleVertexIndsData;
 
   // other internally-computed geometry
   std::vector<glm::vec3> faceNormalsData;
@@ -353,8 +481,53 @@ private:
   PersistentValue<glm::vec3> backFaceColor;
   PersistentValue<MeshShadeStyle> shadeStyle;
 
+  // Chunked drawing
+  struct TriangleChunk {
+    std::tuple<glm::vec3, glm::vec3> objectSpaceBoundingBox;
+    glm::vec3 boundingSphereCenter;
+    float boundingSphereRadius;
+    bool hasNormalCone;       // false if the face normals spread too far for the chunk to ever be backfacing
+    glm::vec3 normalConeAxis; // all face normals are within the cone around this axis...
+    float normalConeCutoff;   // ...whose half-angle has this sine
+    size_t triangleStart; // range of triangles in chunkCornerOrder
+    size_t triangleCount;
+  };
+  size_t trianglesPerChunk = 0;
+  std::vector<TriangleChunk> chunks;
+  std::vector<std::array<size_t, 2>> visibleChunkRanges; // {first, count} corners of chunkCornerOrder to draw
+  size_t nVisibleChunksCount = 0;
+  void updateVisibleChunks();
+
+  bool vertexCacheOrder = false;
+
+  // Level of detail
+  struct LODLevel {
+    size_t cornerStart; // range of lodTriangleVertexInds
+    size_t cornerCount;
+    float cellSize; // of the clustering grid, in object space
+  };
+  struct LODChain {
+    std::vector<uint32_t> triangleVertexInds;
+    std::vector<LODLevel> levels;
+  };
+  bool lodEnabled = false;
+  bool lodChainStale = false; // the vertex positions changed since the last build started
+  float lodPixelError = 1.;
+  std::vector<LODLevel> lodLevels;
+  size_t lodLevelDrawn = 0;
+  std::future<LODChain> lodBuild;                     // the background build, if one is running
+  std::shared_ptr<std::atomic<bool>> lodBuildCancel; // set to abandon it
+  void startLODBuild(); // (re)start the background build from the current data
+  void cancelLODBuild();
+  void installLODChain(bool waitForBuild);
+  void updateLODLevel();
+  static LODChain computeLODChain(const std::vector<glm::vec3>& positions,
+                                  const std::vector<uint32_t>& triangleVertexInds,
+                                  std::shared_ptr<std::atomic<bool>> cancel);
+
   // Do setup work related to drawing, including allocating openGL data
   void prepare();
+  void setSurfaceMeshProgramUniforms(); // all uniforms of `program`
   void preparePick();
 
 
@@ -363,6 +536,12 @@ private:
   void computeTriangleAllEdgeInds();
   void computeTriangleAllHalfedgeInds();
   void computeTriangleAllCornerInds();
+  void computeChunkCornerOrder();
+  void computeCacheOrderedVertexInds();
+  void computeKeyframeInds();
+  void computeChunkBounds();
+  bool chunkIsBackfacing(const TriangleChunk& chunk, bool perspective, glm::vec3 objectSpaceEye,
+                         glm::vec3 objectSpaceLookDir, bool flipFacing);
   void computeFaceNormals();
   void computeFaceCenters();
   void computeFaceAreas();
@@ -373,6 +552,30 @@ private:
   void computeDefaultFaceTangentBasisY();
   void countEdges();
 
+  // The derived geometry buffers are all filled by one parallel pass over the faces (plus one over the vertices for
+  // vertex quantities), so that requesting several of them reads the vertex positions once
+  struct GeometryBufferSet {
+    bool faceNormals = false;
+    bool faceCenters = false;
+    bool faceAreas = false;
+    bool vertexNormals = false;
+    bool vertexAreas = false;
+    bool faceTangentBasis = false; // both X and Y
+  };
+  void computeGeometryBuffers(GeometryBufferSet set);
+
+  // When the face/vertex normals are being drawn, recompute them directly on the device from the uploaded positions,
+  // so the host copy is only filled if someone reads it. Returns the buffers it handled, the rest are up to the host.
+  GeometryBufferSet recomputeNormalsOnDevice();
+  std::shared_ptr<render::AttributeBuffer> deviceFaceStart; // connectivity for the above, uploaded on first use
+  std::shared_ptr<render::AttributeBuffer> deviceFaceVerts;
+  std::shared_ptr<render::AttributeBuffer> deviceVertexFaceStart;
+  std::shared_ptr<render::AttributeBuffer> deviceVertexFaces;
+
+  // Number the edges of a triangle mesh in canonical order, writing the index of each halfedge's edge. Returns the
+  // number of edges. Throws with the given context message if the mesh has non-triangular faces.
+  size_t computeHalfedgeEdgeIndexing(std::vector<size_t>& halfedgeEdgeInd, std::string errorContext);
+
   // Picking-related
   // Order of indexing: vertexPositions, faces, edges, halfedges
   // Within each set, uses the implicit ordering from the mesh data structure
@@ -395,6 +598,8 @@ private:
 
   std::shared_ptr<render::ShaderProgram> program;
   std::shared_ptr<render::ShaderProgram> pickProgram;
+  std::shared_ptr<render::TextureBuffer> edgeMaskTexture; // generated from edgeIsReal when first drawn
+  std::unique_ptr<ElementSelection> faceSelection;
 
 
   // === Helper functions
@@ -409,11 +614,11 @@ private:
 
   // === Quantity adders
 
-  SurfaceVertexColorQuantity* addVertexColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors);
-  SurfaceFaceColorQuantity* addFaceColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors);
+  SurfaceVertexColorQuantity* addVertexColorQuantityImpl(std::string name, std::vector<glm::vec3> colors);
+  SurfaceFaceColorQuantity* addFaceColorQuantityImpl(std::string name, std::vector<glm::vec3> colors);
   SurfaceTextureColorQuantity* addTextureColorQuantityImpl(std::string name, SurfaceParameterizationQuantity& param, size_t dimX, size_t dimY, const std::vector<glm::vec3>& colors, ImageOrigin imageOrigin);
-  SurfaceVertexScalarQuantity* addVertexScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
-  SurfaceFaceScalarQuantity* addFaceScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
+  SurfaceVertexScalarQuantity* addVertexScalarQuantityImpl(std::string name, std::vector<float> data, DataType type);
+  SurfaceFaceScalarQuantity* addFaceScalarQuantityImpl(std::string name, std::vector<float> data, DataType type);
   SurfaceEdgeScalarQuantity* addEdgeScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
   SurfaceHalfedgeScalarQuantity* addHalfedgeScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
   SurfaceCornerScalarQuantity* addCornerScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
@@ -423,8 +628,10 @@ private:
   SurfaceCornerParameterizationQuantity* addParameterizationQuantityImpl(std::string name, const std::vector<glm::vec2>& coords, ParamCoordsType type);
   SurfaceVertexParameterizationQuantity* addVertexParameterizationQuantityImpl(std::string name, const std::vector<glm::vec2>& coords, ParamCoordsType type);
   SurfaceVertexParameterizationQuantity* addLocalParameterizationQuantityImpl(std::string name, const std::vector<glm::vec2>& coords, ParamCoordsType type);
-  SurfaceVertexVectorQuantity* addVertexVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors, VectorType vectorType);
-  SurfaceFaceVectorQuantity* addFaceVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors, VectorType vectorType);
+  SurfaceVertexVectorQuantity* addVertexVectorQuantityImpl(std::string name, std::vector<glm::vec3> vectors,
+                                                           VectorType vectorType);
+  SurfaceFaceVectorQuantity* addFaceVectorQuantityImpl(std::string name, std::vector<glm::vec3> vectors,
+                                                       VectorType vectorType);
   SurfaceFaceTangentVectorQuantity* addFaceTangentVectorQuantityImpl(std::string name, const std::vector<glm::vec2>& vectors, const std::vector<glm::vec3>& basisX, const std::vector<glm::vec3>& basisY, int nSym, VectorType vectorType);
   SurfaceVertexTangentVectorQuantity* addVertexTangentVectorQuantityImpl(std::string name, const std::vector<glm::vec2>& vectors, const std::vector<glm::vec3>& basisX, const std::vector<glm::vec3>& basisY, int nSym, VectorType vectorType);
   SurfaceOneFormTangentVectorQuantity* addOneFormTangentVectorQuantityImpl(std::string name, const std::vector<float>& data, const std::vector<char>& orientations);
@@ -437,9 +644,26 @@ private:
 // Register functions
 template <class V, class F>
 SurfaceMesh* registerSurfaceMesh(std::string name, const V& vertexPositions, const F& faceIndices);
+template <class F> // moves the vertex positions in, no copy
+SurfaceMesh* registerSurfaceMesh(std::string name, std::vector<glm::vec3>&& vertexPositions, const F& faceIndices);
 template <class V, class F>
 SurfaceMesh* registerSurfaceMesh2D(std::string name, const V& vertexPositions, const F& faceIndices);
 
+// register a mesh from compressed (CSR) face arrays: face i has the vertices faceIndices[faceOffsets[i]] through
+// faceIndices[faceOffsets[i+1]-1], so faceOffsets holds one more entry than there are faces. This is the layout the
+// mesh stores internally, so no nested face list is built or walked.
+template <class V>
+SurfaceMesh* registerSurfaceMeshCSR(std::string name, const V& vertexPositions,
+                                    const std::vector<uint32_t>& faceOffsets, const std::vector<uint32_t>& faceIndices);
+template <class V>
+SurfaceMesh* registerSurfaceMeshCSR(std::string name, const V& vertexPositions,
+                                    const std::vector<uint64_t>& faceOffsets, const std::vector<uint64_t>& faceIndices);
+
+// register a mesh which is drawn in chunks of (at most) trianglesPerChunk triangles, see SurfaceMesh::setChunkSize()
+template <class V, class F>
+SurfaceMesh* registerSurfaceMesh(std::string name, const V& vertexPositions, const F& faceIndices,
+                                 size_t trianglesPerChunk);
+
 // register functions that also set perms
 // these are kept mainly for backward compatability, prefer setting perms after registering
 template <class V, class F, class P>
@@ -3,13 +3,25 @@
 
 #include "polyscope/utilities.h"
 
+#include <limits>
 #include <stdexcept>
 
 namespace polyscope {
 
+template <typename T>
+std::shared_ptr<render::AttributeBuffer> SurfaceMesh::getVertexAttributeBuffer(render::ShaderProgram& p,
+                                                                               render::ManagedBuffer<T>& vertexData) {
+  if (p.getDrawMode() == DrawMode::IndexedTriangles) return vertexData.getRenderAttributeBuffer();
+  return vertexData.getIndexedRenderAttributeBuffer(triangleVertexInds);
+}
+
 // Shorthand to add a mesh to polyscope
 template <class V, class F>
 SurfaceMesh* registerSurfaceMesh(std::string name, const V& vertexPositions, const F& faceIndices) {
+  return registerSurfaceMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions), faceIndices);
+}
+template <class F>
+SurfaceMesh* registerSurfaceMesh(std::string name, std::vector<glm::vec3>&& vertexPositions, const F& faceIndices) {
   checkInitialized();
 
   std::tuple<std::vector<uint32_t>, std::vector<uint32_t>> nestedListTup =
@@ -19,7 +31,7 @@ SurfaceMesh* registerSurfaceMesh(std::string name, const V& vertexPositions, con
   std::vector<uint32_t>& faceIndsStart = std::get<1>(nestedListTup);
 
   SurfaceMesh* s =
-      new SurfaceMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions), faceIndsEntries, faceIndsStart);
+      new SurfaceMesh(name, std::move(vertexPositions), std::move(faceIndsEntries), std::move(faceIndsStart));
 
   bool success = registerStructure(s);
   if (!success) {
@@ -37,7 +49,85 @@ SurfaceMesh* registerSurfaceMesh2D(std::string name, const V& vertexPositions, c
     v.z = 0.;
   }
 
-  return registerSurfaceMesh(name, positions3D, faceIndices);
+  return registerSurfaceMesh(name, std::move(positions3D), faceIndices);
+}
+
+// Check that CSR face offsets start at 0, never decrease, and end at the number of face indices
+template <class T>
+void validateFaceOffsets(const std::string& name, const std::vector<T>& faceOffsets, size_t nFaceIndices) {
+  if (faceOffsets.empty() || faceOffsets[0] != 0) {
+    exception("SurfaceMesh " + name + " face offsets must begin with 0");
+  }
+  for (size_t iF = 0; iF + 1 < faceOffsets.size(); iF++) {
+    if (faceOffsets[iF + 1] < faceOffsets[iF]) {
+      exception("SurfaceMesh " + name + " face offsets decrease at face " + std::to_string(iF));
+    }
+  }
+  if (faceOffsets.back() != nFaceIndices) {
+    exception("SurfaceMesh " + name + " face offsets end at " + std::to_string(faceOffsets.back()) +
+              " but there are " + std::to_string(nFaceIndices) + " face indices");
+  }
+}
+
+template <class V>
+SurfaceMesh* registerSurfaceMeshCSR(std::string name, const V& vertexPositions,
+                                    const std::vector<uint32_t>& faceOffsets,
+                                    const std::vector<uint32_t>& faceIndices) {
+  checkInitialized();
+  validateFaceOffsets(name, faceOffsets, faceIndices.size());
+
+  SurfaceMesh* s =
+      new SurfaceMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions), faceIndices, faceOffsets);
+
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+
+  return s;
+}
+
+template <class V>
+SurfaceMesh* registerSurfaceMeshCSR(std::string name, const V& vertexPositions,
+                                    const std::vector<uint64_t>& faceOffsets,
+                                    const std::vector<uint64_t>& faceIndices) {
+  checkInitialized();
+  validateFaceOffsets(name, faceOffsets, faceIndices.size());
+
+  // the mesh stores 32-bit indices
+  const uint64_t maxInd = std::numeric_limits<uint32_t>::max();
+  if (faceIndices.size() > maxInd) {
+    exception("SurfaceMesh " + name + " has too many face indices for 32-bit offsets");
+  }
+  std::vector<uint32_t> faceOffsets32(faceOffsets.begin(), faceOffsets.end());
+  std::vector<uint32_t> faceIndices32(faceIndices.size());
+  for (size_t i = 0; i < faceIndices.size(); i++) {
+    if (faceIndices[i] > maxInd) {
+      exception("SurfaceMesh " + name + " has face vertex index " + std::to_string(faceIndices[i]) +
+                " which does not fit in 32 bits");
+    }
+    faceIndices32[i] = static_cast<uint32_t>(faceIndices[i]);
+  }
+
+  SurfaceMesh* s = new SurfaceMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions),
+                                   std::move(faceIndices32), std::move(faceOffsets32));
+
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+
+  return s;
+}
+
+template <class V, class F>
+SurfaceMesh* registerSurfaceMesh(std::string name, const V& vertexPositions, const F& faceIndices,
+                                 size_t trianglesPerChunk) {
+  SurfaceMesh* mesh = registerSurfaceMesh(name, vertexPositions, faceIndices);
+  if (mesh) {
+    mesh->setChunkSize(trianglesPerChunk);
+  }
+  return mesh;
 }
 
 template <class V, class F, class P>
@@ -66,9 +156,37 @@ void SurfaceMesh::updateVertexPositions(const V& newPositions) {
   vertexPositions.data = standardizeVectorArray<glm::vec3, 3>(newPositions);
   vertexPositions.markHostBufferUpdated();
   recomputeGeometryIfPopulated();
+  lodChainStale = lodEnabled;
+  pickBVHNeedsRefit = true;
+  refitObjectSpaceBounds(vertexPositions.data);
 }
 
 
+template <class V>
+void SurfaceMesh::stageVertexPositions(const V& newPositions) {
+  std::vector<glm::vec3> staged = acquireStagingBuffer<glm::vec3>();
+  adaptorF_convertArrayOfVectorToStdVector<glm::vec3, 3, V>(newPositions, staged);
+  stageUpdate<glm::vec3>(uniquePrefix() + "vertexPositions", getWeakHandle<SurfaceMesh>(this), std::move(staged),
+                         [this](std::vector<glm::vec3>& data) {
+                           validateSize(data, vertexDataSize, "staged vertex positions");
+                           vertexPositions.data.swap(data);
+                           vertexPositions.markHostBufferUpdated();
+                           recomputeGeometryIfPopulated();
+                           lodChainStale = lodEnabled;
+                           pickBVHNeedsRefit = true;
+                           refitObjectSpaceBounds(vertexPositions.data);
+                         });
+}
+
+template <class V>
+void SurfaceMesh::setVertexPositionKeyframes(const std::vector<V>& frames) {
+  std::vector<std::vector<glm::vec3>> frames3D;
+  for (const V& frame : frames) {
+    frames3D.push_back(standardizeVectorArray<glm::vec3, 3>(frame));
+  }
+  setPositionKeyframeData(frames3D, nVertices());
+}
+
 template <class V>
 void SurfaceMesh::updateVertexPositions2D(const V& newPositions2D) {
   validateSize(newPositions2D, vertexDataSize, "newPositions2D");
@@ -299,6 +417,23 @@ SurfaceVertexScalarQuantity* SurfaceMesh::addVertexScalarQuantity(std::string na
   return addVertexScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
 }
 
+template <class T>
+SurfaceVertexScalarQuantity* SurfaceMesh::addVertexScalarKeyframes(std::string name, const std::vector<T>& frames,
+                                                                   DataType type) {
+  if (frames.empty()) {
+    exception("vertex scalar keyframes " + name + " must have at least one frame");
+  }
+  std::vector<std::vector<float>> framesData;
+  for (const T& frame : frames) {
+    validateSize(frame, vertexDataSize, "vertex scalar keyframes " + name);
+    framesData.push_back(standardizeArray<float, T>(frame));
+  }
+
+  SurfaceVertexScalarQuantity* q = addVertexScalarQuantityImpl(name, framesData[0], type);
+  q->setValueKeyframes(framesData);
+  return q;
+}
+
 template <class T>
 SurfaceFaceScalarQuantity* SurfaceMesh::addFaceScalarQuantity(std::string name, const T& data, DataType type) {
   validateSize(data, faceDataSize, "face scalar quantity " + name);
@@ -39,6 +39,11 @@ public:
   template <typename V>
   void setIslandLabels(const V& newIslandLabels);
 
+  // Label the islands from the parameterization itself, as the connected components of faces which are joined across
+  // edges where the coordinates agree on both sides. Edges which are boundary or nonmanifold separate islands, as in
+  // createCurveNetworkFromSeams(). Runs in parallel, and replaces any labels previously set.
+  void computeIslandLabels();
+
   CurveNetwork* createCurveNetworkFromSeams(std::string structureName = "");
 
 protected:
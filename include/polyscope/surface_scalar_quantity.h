@@ -11,16 +11,19 @@
 #include "polyscope/scalar_quantity.h"
 #include "polyscope/surface_mesh.h"
 
+#include <array>
+
 namespace polyscope {
 
 // forward declarations
 class SurfaceMeshQuantity;
 class SurfaceMesh;
+class CurveNetwork;
 class SurfaceParameterizationQuantity;
 
 class SurfaceScalarQuantity : public SurfaceMeshQuantity, public ScalarQuantity<SurfaceScalarQuantity> {
 public:
-  SurfaceScalarQuantity(std::string name, SurfaceMesh& mesh_, std::string definedOn, const std::vector<float>& values_,
+  SurfaceScalarQuantity(std::string name, SurfaceMesh& mesh_, std::string definedOn, std::vector<float> values_,
                         DataType dataType);
 
   virtual void draw() override;
@@ -35,6 +38,10 @@ public:
 protected:
   std::shared_ptr<render::ShaderProgram> program;
 
+  // Face, edge, and halfedge values drawn with the MESH_FETCH_* rules, see SurfaceMesh::generateElementTexture()
+  std::shared_ptr<render::TextureBuffer> elementTexture;
+  uint64_t elementTextureDataVersion = 0;
+
   // Helpers
   virtual void createProgram() = 0;
 };
@@ -45,14 +52,31 @@ protected:
 
 class SurfaceVertexScalarQuantity : public SurfaceScalarQuantity {
 public:
-  SurfaceVertexScalarQuantity(std::string name, const std::vector<float>& values_, SurfaceMesh& mesh_,
+  SurfaceVertexScalarQuantity(std::string name, std::vector<float> values_, SurfaceMesh& mesh_,
                               DataType dataType_ = DataType::STANDARD);
 
   virtual void createProgram() override;
 
   virtual std::shared_ptr<render::AttributeBuffer> getAttributeBuffer() override;
+  virtual void buildScalarOptionsUI() override;
 
   void buildVertexInfoGUI(size_t vInd) override;
+
+  // Level set curves of the values, linearly interpolated along the edges of the mesh's triangulation. A node is shared
+  // by the segments on either side of an edge, so each contour comes out connected.
+  struct Isolines {
+    std::vector<glm::vec3> nodes;
+    std::vector<float> nodeLevels; // the level each node lies on
+    std::vector<std::array<size_t, 2>> edges;
+  };
+
+  // Extract the isolines at each of the levels. Triangles are processed in parallel, each chunk collecting its segments
+  // separately, and the crossings of shared edges are then deduplicated. Triangles with non-finite values are skipped.
+  static Isolines extractIsolines(SurfaceMesh& mesh, const std::vector<float>& vertexValues,
+                                  const std::vector<float>& levels);
+
+  // Register the isolines at the given levels as a curve network, with a node scalar quantity "level"
+  CurveNetwork* createCurveNetworkFromIsolines(const std::vector<float>& levels, std::string structureName = "");
 };
 
 
@@ -62,7 +86,7 @@ public:
 
 class SurfaceFaceScalarQuantity : public SurfaceScalarQuantity {
 public:
-  SurfaceFaceScalarQuantity(std::string name, const std::vector<float>& values_, SurfaceMesh& mesh_,
+  SurfaceFaceScalarQuantity(std::string name, std::vector<float> values_, SurfaceMesh& mesh_,
                             DataType dataType_ = DataType::STANDARD);
 
   virtual void createProgram() override;
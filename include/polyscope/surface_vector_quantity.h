@@ -3,7 +3,9 @@
 #pragma once
 
 #include "polyscope/affine_remapper.h"
+#include "polyscope/persistent_value.h"
 #include "polyscope/render/engine.h"
+#include "polyscope/scaled_value.h"
 #include "polyscope/surface_mesh.h"
 #include "polyscope/vector_quantity.h"
 
@@ -21,12 +23,71 @@ class SurfaceVectorQuantity : public SurfaceMeshQuantity {
 public:
   SurfaceVectorQuantity(std::string name, SurfaceMesh& mesh_, MeshElement definedOn_);
 
+  // vectors may extend arbitrarily far beyond the mesh
+  virtual bool drawsWithinStructureBounds() override;
+  virtual void refresh() override;
+
   // === Members
 
+  // Streamlines of a field, traced across the triangles of a mesh. Each line is stored with its first and last point
+  // repeated, so every segment has a point before and after it.
+  struct Streamlines {
+    std::vector<glm::vec3> points;
+    std::vector<glm::vec3> normals;     // the surface normal at each point
+    std::vector<float> segmentStarts;   // for each segment, the index in points of its first point
+  };
+
+  // Trace streamlines of a field which is constant on each triangle of the mesh's triangulation (triangleDirections,
+  // projected to the triangle), from the centers of nSeeds triangles spread over the mesh, in both directions. A line
+  // stops at the boundary, where the field turns back on itself, or after maxLength. For symmetric fields (nSym > 1),
+  // each triangle follows the rotation of its direction closest to the previous one. Lines are traced in parallel.
+  static Streamlines traceStreamlines(SurfaceMesh& mesh, const std::vector<glm::vec3>& triangleDirections, int nSym,
+                                      size_t nSeeds, float maxLength);
+
   // === Option accessors
 
+  // Draw streamlines of the field as ribbons over the surface
+  SurfaceVectorQuantity* setRibbonEnabled(bool newVal);
+  bool isRibbonEnabled();
+
+  // Half width of the ribbons
+  SurfaceVectorQuantity* setRibbonWidth(double newVal, bool isRelative = true);
+  double getRibbonWidth();
+
+  // Number of streamlines traced
+  SurfaceVectorQuantity* setRibbonCount(size_t newVal);
+  size_t getRibbonCount();
+
 protected:
   MeshElement definedOn;
+
+  // The field on each triangle of the parent's triangulation, and its symmetry
+  virtual std::vector<glm::vec3> ribbonTriangleDirections() = 0;
+  virtual int ribbonSymmetry();
+  virtual uint64_t ribbonDataVersion() = 0; // the streamlines are traced again when this changes
+
+  // drawn in the color and material of the vectors
+  void drawRibbons(glm::vec3 color, const std::string& material);
+  void buildRibbonUI();
+
+  // averages the vectors at the corners of each triangle, aligning symmetric vectors to the first corner
+  std::vector<glm::vec3> vertexDirectionsToTriangles(const std::vector<glm::vec3>& vertexDirections, int nSym);
+
+private:
+  PersistentValue<bool> ribbonEnabled;
+  PersistentValue<ScaledValue<float>> ribbonWidth;
+  PersistentValue<int> ribbonCount;
+
+  std::shared_ptr<render::ShaderProgram> ribbonProgram;
+  std::string ribbonProgramMaterial;
+  std::shared_ptr<render::TextureBuffer> ribbonPointsTexture, ribbonNormalsTexture;
+  std::vector<float> ribbonSegmentStarts; // see Streamlines
+  uint64_t ribbonTracedDataVersion = 0;
+  uint64_t ribbonTracedPositionsVersion = 0;
+  int ribbonTracedCount = -1;
+
+  void traceRibbons();
+  void createRibbonProgram(const std::string& material);
 };
 
 
@@ -42,6 +103,10 @@ public:
   virtual void refresh() override;
   virtual std::string niceName() override;
   virtual void buildVertexInfoGUI(size_t vInd) override;
+
+protected:
+  virtual std::vector<glm::vec3> ribbonTriangleDirections() override;
+  virtual uint64_t ribbonDataVersion() override;
 };
 
 
@@ -57,6 +122,10 @@ public:
   virtual void refresh() override;
   virtual std::string niceName() override;
   virtual void buildFaceInfoGUI(size_t fInd) override;
+
+protected:
+  virtual std::vector<glm::vec3> ribbonTriangleDirections() override;
+  virtual uint64_t ribbonDataVersion() override;
 };
 
 // ==== Tangent vectors at faces
@@ -73,6 +142,11 @@ public:
   virtual void refresh() override;
   virtual std::string niceName() override;
   void buildFaceInfoGUI(size_t fInd) override;
+
+protected:
+  virtual std::vector<glm::vec3> ribbonTriangleDirections() override;
+  virtual int ribbonSymmetry() override;
+  virtual uint64_t ribbonDataVersion() override;
 };
 
 
@@ -91,6 +165,11 @@ public:
   virtual void refresh() override;
   virtual std::string niceName() override;
   void buildVertexInfoGUI(size_t vInd) override;
+
+protected:
+  virtual std::vector<glm::vec3> ribbonTriangleDirections() override;
+  virtual int ribbonSymmetry() override;
+  virtual uint64_t ribbonDataVersion() override;
 };
 
 
@@ -111,6 +190,10 @@ public:
   std::vector<char> canonicalOrientation;
 
   void buildEdgeInfoGUI(size_t eInd) override;
+
+protected:
+  virtual std::vector<glm::vec3> ribbonTriangleDirections() override;
+  virtual uint64_t ribbonDataVersion() override;
 };
 
 } // namespace polyscope
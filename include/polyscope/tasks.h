@@ -0,0 +1,43 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace polyscope {
+namespace tasks {
+
+// The scheduler behind all of Polyscope's CPU-side parallel work (see parallel.h). It keeps a pool of worker threads
+// alive for the whole session, rather than starting threads for each parallel loop. Each worker has its own queue of
+// jobs, and takes jobs from the other queues when its own is empty. A thread which starts a batch of jobs works on
+// them (and any others) until the batch is done, so nested parallel loops do not block a worker or deadlock.
+//
+// The pool has options::numThreads - 1 workers, since the calling thread takes part. Changes to options::numThreads
+// take effect at the next batch started while no other batch is running.
+
+// Run job(iJob) for each iJob in [0, nJobs), in parallel, and return once all are done. Jobs may start in any order.
+// If jobs throw, the exception of the job with the lowest index is rethrown, after all jobs have finished.
+void runJobs(size_t nJobs, const std::function<void(size_t iJob)>& job);
+
+// A host application with its own thread pool can run Polyscope's jobs there instead, so the two pools do not
+// oversubscribe the machine. The scheduler must run job(iJob) for each iJob in [0, nJobs) and only return once all
+// are done. Jobs never throw out of the scheduler. E.g. with TBB:
+//
+//   polyscope::tasks::setExternalScheduler([](size_t nJobs, const std::function<void(size_t)>& job) {
+//     tbb::parallel_for(size_t(0), nJobs, job);
+//   });
+//
+// Setting a scheduler stops the built-in workers; pass nullptr to go back to them. Must not be called while jobs are
+// running.
+using ExternalScheduler = std::function<void(size_t nJobs, const std::function<void(size_t iJob)>& job)>;
+void setExternalScheduler(ExternalScheduler scheduler);
+
+// Stop the built-in worker threads, e.g. before forking. They are started again when needed.
+void stopWorkers();
+
+// The number of built-in worker threads which are currently running
+size_t nRunningWorkers();
+
+} // namespace tasks
+} // namespace polyscope
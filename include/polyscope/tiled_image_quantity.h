@@ -0,0 +1,143 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/image_quantity_base.h"
+#include "polyscope/persistent_value.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace polyscope {
+
+// A color image which is too large to upload whole, e.g. a gigapixel microscopy or satellite image.
+//
+// The image is a pyramid of levels: level 0 is full resolution, and each level above it halves the resolution
+// (rounding up), up to a level which fits in a single tile. Each level is cut in to tileSize x tileSize tiles. Only the
+// tiles covering the current view are loaded, from the coarsest level which still has at least one image pixel per
+// display pixel. Tiles come from a TiledImageLoader (see structure.h), which runs on a background thread, and are kept
+// as textures in an LRU cache. Until a tile has loaded, the coarser tiles covering it are drawn in its place.
+//
+// The view is a rectangle of the image, which fills the fullscreen display and the ImGui window. In the window, the
+// mouse wheel zooms and dragging pans.
+class TiledImageQuantity : public ImageQuantity {
+
+public:
+  TiledImageQuantity(Structure& parent_, std::string name, size_t dimX, size_t dimY, TiledImageLoader loader,
+                     size_t tileSize, ImageOrigin imageOrigin);
+  ~TiledImageQuantity();
+
+  virtual void buildCustomUI() override;
+
+  virtual void refresh() override;
+
+  virtual std::string niceName() override;
+
+  // == Pyramid
+
+  size_t nLevels() const;
+  size_t levelDimX(size_t level) const;
+  size_t levelDimY(size_t level) const;
+  size_t getTileSize() const;
+
+  // == View
+
+  // The displayed rectangle [x0, x1) x [y0, y1), in full resolution pixels. It may extend past the image.
+  void setViewWindow(double x0, double y0, double x1, double y1);
+  std::array<double, 4> getViewWindow() const;
+  void resetView(); // show the whole image
+
+  // == Tile cache
+
+  // The most tiles kept on the device, each costs 4 * tileSize^2 bytes. Defaults to 256.
+  void setTileCacheSize(size_t nTiles);
+  size_t getTileCacheSize() const;
+  size_t nCachedTiles() const;
+
+  // Block until every tile requested so far has loaded, and upload them. Useful before a screenshot.
+  void waitForPendingTiles();
+
+  // Drop all cached tiles, e.g. after the source image changed
+  void clearTileCache();
+
+  // == Setters and getters
+
+  TiledImageQuantity* setEnabled(bool newEnabled) override;
+
+protected:
+  const TiledImageLoader loader;
+  const size_t tileSize;
+  size_t levelCount;
+  std::array<double, 4> viewWindow;
+
+  // == Tiles
+  // Keys pack (level, tileX, tileY)
+  static uint64_t tileKey(size_t level, size_t tileX, size_t tileY);
+  static void unpackTileKey(uint64_t key, size_t& level, size_t& tileX, size_t& tileY);
+  std::array<size_t, 4> tilePixelRect(size_t level, size_t tileX, size_t tileY) const; // x, y, w, h in the level
+
+  // LRU cache, only touched by the render thread. The list is in order of use, most recent first.
+  struct CachedTile {
+    std::shared_ptr<render::TextureBuffer> texture;
+    std::list<uint64_t>::iterator lruPosition;
+  };
+  std::unordered_map<uint64_t, CachedTile> tileCache;
+  std::list<uint64_t> tileLRU;
+  size_t tileCacheSize = 256;
+  std::unordered_set<uint64_t> failedTiles; // the loader threw, these are not requested again
+  CachedTile* useCachedTile(uint64_t key);  // nullptr if absent, marks it as most recently used
+  void evictTiles();
+
+  // Loading, shared with the loader thread and guarded by the mutex. Requests are taken from the front of the queue,
+  // so the newest requests load first, and requests which have not been repeated for a while fall off the back.
+  struct LoadedTile {
+    uint64_t key;
+    std::vector<unsigned char> pixels;
+    std::string error;   // non-empty if the loader threw
+    uint64_t generation; // loadGeneration when it was requested
+  };
+  std::mutex loadMutex;
+  std::condition_variable loadCond;
+  std::deque<uint64_t> requestQueue;
+  std::unordered_set<uint64_t> requestedTiles; // queued, loading, or loaded but not uploaded yet
+  std::vector<LoadedTile> loadedTiles;
+  size_t nLoading = 0;
+  bool stopLoading = false;
+  uint64_t loadGeneration = 0; // bumped by clearTileCache(), tiles from earlier generations are discarded
+  std::thread loaderThread;
+  void loaderLoop();
+  void requestTiles(const std::vector<uint64_t>& keys); // in increasing order of priority
+  void uploadLoadedTiles(size_t maxUploads);
+
+  // Draw the view to a target of the given size in pixels, with the program's tile rectangle uniform. Tiles which
+  // are missing get requested.
+  void drawTiles(render::ShaderProgram& program, size_t targetW, size_t targetH, const std::array<double, 4>& window);
+
+  // rendering internals
+  std::shared_ptr<render::TextureBuffer> textureIntermediateRendered;
+  std::shared_ptr<render::FrameBuffer> framebufferIntermediate;
+  std::shared_ptr<render::ShaderProgram> fullscreenProgram, billboardProgram;
+  std::shared_ptr<render::ShaderProgram> requestTileProgram(bool billboard);
+  void prepareIntermediateRender();
+
+  virtual void renderIntermediate() override;
+  virtual void showFullscreen() override;
+  virtual void showInImGuiWindow() override;
+  virtual void showInBillboard(glm::vec3 center, glm::vec3 upVec, glm::vec3 rightVec) override;
+};
+
+// A loader for a raw, uncompressed image file: dimY rows of dimX pixels with nChannels (3 or 4) bytes each, without a
+// header. The file is memory mapped, so only the parts under the visible tiles are read. The coarser levels take every
+// 2^level-th pixel rather than averaging, which may alias.
+TiledImageLoader tiledImageLoaderFromRawFile(std::string filename, size_t dimX, size_t dimY, int nChannels);
+
+} // namespace polyscope
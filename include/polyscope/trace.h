@@ -0,0 +1,72 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace polyscope {
+
+// Record timing spans of Polyscope's own work (the main loop, scene rendering, structure draws, shader compiles,
+// buffer uploads, mesh connectivity, marching cubes, screenshot encoding, ...) to see it in the timeline of an
+// application's profiler. Spans are written as Chrome trace event JSON, which chrome://tracing and the Perfetto UI
+// (ui.perfetto.dev) open directly, and which can be merged with other traces of the same process.
+//
+// Spans cost a single relaxed atomic load while no trace is being recorded. They are compiled out entirely if
+// Polyscope is built with POLYSCOPE_ENABLE_TRACING=OFF, in which case the functions below record nothing.
+
+void startTrace();  // discards any spans recorded before
+void stopTrace();   // the recorded spans are kept until the next startTrace()
+bool isTracing();
+std::string getTraceJSON();                 // the spans recorded so far
+void writeTraceJSON(std::string filename); // ... written to a file
+size_t getTraceSpanCount();                // recorded so far, about a million at most are kept
+
+namespace detail {
+extern std::atomic<bool> traceEnabled;
+int64_t traceNowMicroseconds();
+void recordTraceSpan(const char* name, const std::string& detail, int64_t startUs);
+} // namespace detail
+
+// Records the enclosing scope as a span, if a trace is being recorded when it begins. The name must outlive the trace
+// (typically a literal), the detail (e.g. the name of a structure) is copied.
+class TraceSpan {
+public:
+  explicit TraceSpan(const char* name_) : name(name_) {
+    if (detail::traceEnabled.load(std::memory_order_relaxed)) startUs = detail::traceNowMicroseconds();
+  }
+  TraceSpan(const char* name_, const std::string& detail_) : name(name_) {
+    if (detail::traceEnabled.load(std::memory_order_relaxed)) {
+      spanDetail = detail_;
+      startUs = detail::traceNowMicroseconds();
+    }
+  }
+  ~TraceSpan() {
+    if (startUs >= 0) detail::recordTraceSpan(name, spanDetail, startUs);
+  }
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+  const char* name;
+  std::string spanDetail;
+  int64_t startUs = -1;
+};
+
+} // namespace polyscope
+
+#define POLYSCOPE_TRACE_CONCAT_IMPL(a, b) a##b
+#define POLYSCOPE_TRACE_CONCAT(a, b) POLYSCOPE_TRACE_CONCAT_IMPL(a, b)
+
+// POLYSCOPE_TRACE_SPAN("name") or POLYSCOPE_TRACE_SPAN("name", detailString) traces the rest of the enclosing scope
+#ifdef POLYSCOPE_ENABLE_TRACING
+#define POLYSCOPE_TRACE_SPAN(...)                                                                                      \
+  ::polyscope::TraceSpan POLYSCOPE_TRACE_CONCAT(polyscopeTraceSpan_, __LINE__)(__VA_ARGS__)
+#else
+#define POLYSCOPE_TRACE_SPAN(...)                                                                                      \
+  do {                                                                                                                 \
+  } while (false)
+#endif
@@ -53,6 +53,7 @@ protected:
   int selectedDim = -1; // must be {0,1,2} if selectedType == Rotation/Translation
   TransformHandle selectedType = TransformHandle::None;
   bool currentlyDragging = false;
+  bool transformChangedInDrag = false; // the scene extents are updated when the drag ends
   glm::vec3 dragPrevVec{1., 0.,
                         0.}; // the normal vector from the previous frame of the drag OR previous translation center
 
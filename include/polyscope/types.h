@@ -4,6 +4,8 @@
 
 // Various types / enums / forward declarations which are broadly useful
 
+#include <cstdint>
+
 namespace polyscope {
 
 enum class NavigateStyle { Turntable = 0, Free, Planar, Arcball, None, FirstPerson };
@@ -11,19 +13,25 @@ enum class UpDir { XUp = 0, YUp, ZUp, NegXUp, NegYUp, NegZUp };
 enum class FrontDir { XFront = 0, YFront, ZFront, NegXFront, NegYFront, NegZFront };
 enum class BackgroundView { None = 0 };
 enum class ProjectionMode { Perspective = 0, Orthographic };
-enum class TransparencyMode { None = 0, Simple, Pretty };
+enum class TransparencyMode { None = 0, Simple, Pretty, WeightedBlended };
 enum class GroundPlaneMode { None, Tile, TileReflection, ShadowOnly };
+enum class GroundReflectionMode { Mirror, ReducedMirror, ScreenSpace };
 enum class GroundPlaneHeightMode { Automatic = 0, Manual };
 enum class BackFacePolicy { Identical, Different, Custom, Cull };
 
-enum class PointRenderMode { Sphere = 0, Quad };
+enum class PointRenderMode { Sphere = 0, Quad, Splat };
+enum class CurveNetworkRenderMode { Cylinder = 0, Instanced };
 enum class MeshElement { VERTEX = 0, FACE, EDGE, HALFEDGE, CORNER };
 enum class MeshShadeStyle { Smooth = 0, Flat, TriFlat };
 enum class VolumeMeshElement { VERTEX = 0, EDGE, FACE, CELL };
 enum class VolumeCellType { TET = 0, HEX };
 
 enum class ImplicitRenderMode { SphereMarch, FixedStep };
+enum class ImplicitNormalMode { FiniteDifference, ScreenSpace };
 enum class ImageOrigin { LowerLeft, UpperLeft };
+enum class RecordingFormat { Y4M, Raw, FFmpeg };
+enum class ImageFormat { Auto = 0, PNG, FastPNG, QOI, TGA, PPM, JPEG }; // Auto picks by file extension
+enum class RemoteInputType { FrameAck = 0, MouseMove, MouseButton, Scroll, Key, Text, Resize };
 
 enum class ParamCoordsType { UNIT = 0, WORLD }; // UNIT -> [0,1], WORLD -> length-valued
 enum class ParamVizStyle {
@@ -58,5 +66,11 @@ enum class ManagedBufferType {
 // MAGNITUDE: [0, inf], zero is special (ie, length of a vector)
 enum class DataType { STANDARD = 0, SYMMETRIC, MAGNITUDE };
 
+// A stable integer handle for a registered structure, see getStructure(StructureHandle). The low 32 bits are the
+// structure's slot in the registry and the high 32 bits are the slot's generation, so a handle to a removed structure
+// never refers to a later structure in the same slot.
+typedef uint64_t StructureHandle;
+const StructureHandle INVALID_STRUCTURE_HANDLE = 0;
+
 
 }; // namespace polyscope
@@ -0,0 +1,73 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/weak_handle.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace polyscope {
+
+// Keep the display at full frame rate while heavy user work (e.g. stepping a solver) runs on another thread.
+//
+// The windowing system and the graphics context belong to the thread which called init(), so rendering stays there.
+// Instead, heavy work runs on a background thread, started with startBackgroundCallback(). That thread must not touch
+// structures directly. It hands changes to the render thread with queueUpdate(), as functions which the main loop runs
+// once per frame at a fixed sync point: after input events are polled and before the user callback and drawing. Any
+// buffers they change are uploaded by the render thread while drawing that frame, as usual.
+//
+// Updates queued with a key replace any update with the same key which has not run yet. A background thread which
+// captures a snapshot of its data in each keyed update therefore never falls behind: only its latest snapshot gets
+// applied, however many frames it produces between two drawn frames.
+//
+// Updates may be queued from any thread, including the render thread itself.
+void queueUpdate(std::function<void()> update);
+void queueUpdate(std::string key, std::function<void()> update);
+
+// Block until every update queued so far has run. Called on the render thread, runs them immediately.
+void waitForQueuedUpdates();
+
+// Call `work` repeatedly on a background thread until stopBackgroundCallback(), at least once. An exception thrown by
+// `work` stops the thread, and is raised on the render thread at the next sync point.
+void startBackgroundCallback(std::function<void()> work);
+void stopBackgroundCallback(); // waits for the current call of `work` to return, then runs any remaining updates
+bool isBackgroundCallbackRunning();
+
+// Run the queued updates, called by the main loop at the sync point
+void processQueuedUpdates();
+bool hasQueuedUpdates();
+
+// == Staged data
+// Worker threads produce new data for a structure or quantity into host vectors, and stage it with stageUpdate(). At
+// the sync point `apply` receives the vector on the render thread, and typically swaps it into a ManagedBuffer, so the
+// main loop only pays for the swap and the upload. Vectors are pooled: whatever `apply` leaves in the vector (e.g. the
+// previous data of the buffer), and data replaced by a later stageUpdate() with the same key, goes back to the pool for
+// acquireStagingBuffer(). A worker streaming results faster than the display refreshes thus only ever costs the latest
+// copy of the data, without allocating for each result.
+//
+// `owner` is a handle to what the data belongs to (e.g. the structure, or the ManagedBuffer itself); the update is
+// dropped if it has been deleted by then.
+// Structures offer wrappers, e.g. PointCloud::stagePointPositions() or ScalarQuantity::stageData().
+
+// An empty vector, with the capacity of a previously released staging vector if there is one
+template <typename T>
+std::vector<T> acquireStagingBuffer();
+template <typename T>
+void releaseStagingBuffer(std::vector<T>&& buffer);
+
+// Free the vectors held by the pools, which are otherwise kept for reuse. Called by stopBackgroundCallback() and at
+// shutdown; call it after streaming from threads of your own, so the pools do not pin copies of large data.
+void releaseStagingPools();
+
+template <typename T>
+void stageUpdate(std::string key, GenericWeakHandle owner, std::vector<T>&& data,
+                 std::function<void(std::vector<T>&)> apply);
+
+} // namespace polyscope
+
+#include "polyscope/update_queue.ipp"
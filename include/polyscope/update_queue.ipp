@@ -0,0 +1,75 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+namespace polyscope {
+
+namespace detail {
+
+// Pools register a function to empty themselves the first time they keep a vector, see releaseStagingPools()
+void registerStagingPool(void (*clearPool)());
+
+// Released staging vectors of one element type. Only a few are kept, a worker rarely has more in flight.
+template <typename T>
+struct StagingPool {
+  static const size_t maxFreeBuffers = 4;
+  static std::mutex mutex;
+  static std::vector<std::vector<T>> freeBuffers;
+  static bool registered;
+
+  static void clear() {
+    std::vector<std::vector<T>> released;
+    std::lock_guard<std::mutex> lock(mutex);
+    released.swap(freeBuffers);
+  }
+};
+
+template <typename T>
+std::mutex StagingPool<T>::mutex;
+template <typename T>
+std::vector<std::vector<T>> StagingPool<T>::freeBuffers;
+template <typename T>
+bool StagingPool<T>::registered = false;
+
+} // namespace detail
+
+template <typename T>
+std::vector<T> acquireStagingBuffer() {
+  std::vector<T> buffer;
+  std::lock_guard<std::mutex> lock(detail::StagingPool<T>::mutex);
+  if (!detail::StagingPool<T>::freeBuffers.empty()) {
+    buffer.swap(detail::StagingPool<T>::freeBuffers.back());
+    detail::StagingPool<T>::freeBuffers.pop_back();
+  }
+  return buffer;
+}
+
+template <typename T>
+void releaseStagingBuffer(std::vector<T>&& buffer) {
+  buffer.clear();
+  if (buffer.capacity() == 0) return;
+  std::lock_guard<std::mutex> lock(detail::StagingPool<T>::mutex);
+  if (detail::StagingPool<T>::freeBuffers.size() < detail::StagingPool<T>::maxFreeBuffers) {
+    detail::StagingPool<T>::freeBuffers.push_back(std::move(buffer));
+    if (!detail::StagingPool<T>::registered) {
+      detail::registerStagingPool(&detail::StagingPool<T>::clear);
+      detail::StagingPool<T>::registered = true;
+    }
+  }
+}
+
+template <typename T>
+void stageUpdate(std::string key, GenericWeakHandle owner, std::vector<T>&& data,
+                 std::function<void(std::vector<T>&)> apply) {
+
+  // the data goes back to the pool when the update is released, whether it ran or was replaced
+  std::shared_ptr<std::vector<T>> staged(new std::vector<T>(std::move(data)), [](std::vector<T>* buffer) {
+    releaseStagingBuffer(std::move(*buffer));
+    delete buffer;
+  });
+
+  queueUpdate(key, [owner, staged, apply]() {
+    if (!owner.isValid()) return;
+    apply(*staged);
+  });
+}
+
+} // namespace polyscope
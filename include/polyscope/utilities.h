@@ -6,6 +6,7 @@
 #include <complex>
 #include <cstdint>
 #include <cstdio>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -121,20 +122,76 @@ std::vector<T> applyPermutation(const std::vector<T>& input, const std::vector<s
   return result;
 }
 
-// Same as applyPermutation() above, but on 32-bit indices, and we gave it a more accurate name
+// Same as applyPermutation() above, but on 32-bit indices, and we gave it a more accurate name. Writes to `result`,
+// which keeps its capacity, e.g. a ScratchVector.
 template <typename T>
-std::vector<T> gather(const std::vector<T>& input, const std::vector<uint32_t>& perm) {
-  // TODO figure out if there's a copy to be avoided here
+void gather(const std::vector<T>& input, const std::vector<uint32_t>& perm, std::vector<T>& result) {
   if (perm.size() == 0) {
-    return input;
+    result = input;
+    return;
   }
-  std::vector<T> result(perm.size());
+  result.resize(perm.size());
   for (size_t i = 0; i < perm.size(); i++) {
     result[i] = input[perm[i]];
   }
+}
+
+template <typename T>
+std::vector<T> gather(const std::vector<T>& input, const std::vector<uint32_t>& perm) {
+  std::vector<T> result;
+  gather(input, perm, result);
   return result;
 }
 
+// === Spatial orderings
+
+// The order which sorts the given points along a Morton (z-order) curve through their bounding box, as indices in to
+// `points`. Consecutive runs of the result are spatially coherent, for any run length.
+std::vector<uint32_t> mortonOrder(const std::vector<glm::vec3>& points);
+
+// A multi-resolution order of the given points, as indices in to `points`: every prefix of the result is a roughly
+// uniform subsample of the points. Built by visiting the Morton order in bit-reversed sequence.
+std::vector<uint32_t> multiResolutionOrder(const std::vector<glm::vec3>& points);
+
+// The order which sorts the given points from farthest to nearest along the view direction of `modelView` (points in
+// front of the camera have negative view space z), as indices in to `points`. For blending transparent points back to
+// front. Depths are quantized to 30 bits over the range of the points, ties are kept in index order.
+std::vector<uint32_t> backToFrontOrder(const std::vector<glm::vec3>& points, const glm::mat4& modelView);
+
+// === Vertex cache orderings
+
+// An order of the triangles of an indexed triangle list which reuses recently transformed vertices, as indices in to
+// the triangles (triangle i is triangleVertexInds[3*i, 3*i+3)). Greedy, after Forsyth's "Linear-Speed Vertex Cache
+// Optimisation", scoring vertices against a 32-entry LRU cache.
+std::vector<uint32_t> vertexCacheTriangleOrder(const std::vector<uint32_t>& triangleVertexInds, size_t nVertices);
+
+// The average number of vertices transformed per triangle when drawing an indexed triangle list, simulating a FIFO
+// post-transform cache with `cacheSize` entries. 3 means no reuse at all, large regular meshes can approach 0.5.
+float averageCacheMissRatio(const std::vector<uint32_t>& triangleVertexInds, size_t cacheSize = 32);
+
+// === Mesh simplification
+
+// Simplify an indexed triangle list by vertex clustering. The vertices used by the triangles are binned in to a grid
+// of cubes of side cellSize, each cell is represented by its vertex nearest to the mean of the cell, and every
+// triangle is re-pointed at the representatives of its vertices. Triangles which collapse, and duplicates, are
+// dropped. The result indexes the same `positions`, so per-vertex data carries over to it unchanged.
+std::vector<uint32_t> clusterSimplifyTriangles(const std::vector<glm::vec3>& positions,
+                                               const std::vector<uint32_t>& triangleVertexInds, float cellSize);
+
+// === Point downsampling
+
+// Points binned in to a grid of cubes, see voxelGridDownsample()
+struct VoxelGrid {
+  std::vector<uint32_t> cellRepresentative; // for each occupied cell, its point nearest to the mean of the cell
+  std::vector<uint32_t> cellPointStart;     // the points of cell i are cellPoints[cellPointStart[i], cellPointStart[i+1])
+  std::vector<uint32_t> cellPoints;         // every point, as indices in to `points`, grouped by cell
+};
+
+// Bin the points in to a grid of cubes of side cellSize, in parallel. The occupied cells are ordered along a Morton
+// curve through the grid (21 bits per axis, cells beyond that are merged at the far side), so consecutive runs of cells
+// are spatially coherent. Non-finite points are binned with the first cell of the grid.
+VoxelGrid voxelGridDownsample(const std::vector<glm::vec3>& points, float cellSize);
+
 
 // === Random number generation
 extern std::random_device util_random_device;
@@ -171,6 +228,15 @@ inline double randomNormal(double mean = 0.0, double stddev = 1.0) {
 // Displays a little helper icon which shows the text on hover
 void ImGuiHelperMarker(const char* text);
 
+// True if the tree node with this label (in the current ID scope) was left open. Nodes which have never been shown
+// report false.
+bool ImGuiTreeNodeIsOpen(const char* label);
+
+// Build a long list of items which each show one tree node, via build(i). Open nodes are built normally, while runs of
+// closed nodes (which all have the same height) go through an ImGuiListClipper, so only the ones in view get built.
+void ImGuiClippedTreeList(size_t count, const std::function<bool(size_t)>& isOpen,
+                          const std::function<void(size_t)>& build);
+
 // === Math utilities
 const double PI = 3.14159265358979323;
 
@@ -25,6 +25,7 @@ template <typename QuantityT>
 class VectorQuantityBase {
 public:
   VectorQuantityBase(QuantityT& parent, VectorType vectorType);
+  virtual ~VectorQuantityBase() = default;
 
   // Build the ImGUI UIs for vectors
   void buildVectorUI();
@@ -59,6 +60,12 @@ public:
   QuantityT* setMaterial(std::string name);
   std::string getMaterial();
 
+  // Decimate dense vector fields, drawing at most about one vector per this many pixels (squared) of the structure's
+  // screen-space bounds. The vectors kept are a stable pseudo-random subset. 0 (the default) draws every vector. Only
+  // applies when options::instancedVectors is set.
+  QuantityT* setVectorMinPixelSpacing(double pixels);
+  double getVectorMinPixelSpacing();
+
 
 protected:
   const VectorType vectorType;
@@ -68,11 +75,21 @@ protected:
   PersistentValue<ScaledValue<float>> vectorRadius;
   PersistentValue<glm::vec3> vectorColor;
   PersistentValue<std::string> material;
+  PersistentValue<float> vectorMinPixelSpacing;
 
+  // Computed from the data when first needed, and again after the data is updated, unless it has been set manually
   float vectorLengthRange = -1.;
   bool vectorLengthRangeManuallySet = false;
+  bool vectorLengthRangeStale = true;
+  void ensureVectorLengthRange();
+  virtual void updateMaxLength() = 0;
 
   std::shared_ptr<render::ShaderProgram> vectorProgram;
+  bool vectorProgramInstanced = false; // was vectorProgram created for the instanced path?
+
+  // Helpers for the instanced path
+  void setInstancedDrawData(size_t nVectors); // instance count and decimation
+  std::vector<glm::vec3> instanceBoxCorners(); // the shared per-vertex geometry, a triangle strip over a box
 };
 
 // ================================================
@@ -84,16 +101,19 @@ protected:
 template <typename QuantityT>
 class VectorQuantity : public VectorQuantityBase<QuantityT> {
 public:
-  VectorQuantity(QuantityT& parent, const std::vector<glm::vec3>& vectors,
+  VectorQuantity(QuantityT& parent, std::vector<glm::vec3> vectors,
                  render::ManagedBuffer<glm::vec3>& vectorRoots, VectorType vectorType);
 
   void drawVectors();
   void refreshVectors();
 
+  // Replace the vectors, reusing the render buffers and programs. The length range is recomputed when next drawn,
+  // unless it was set with setVectorLengthRange().
   template <class V>
   void updateData(const V& newVectors);
   template <class V>
   void updateData2D(const V& newVectors);
+  void updateData(const glm::vec3* newVectors, size_t count); // copied straight into the existing host buffer
 
   // === Members
 
@@ -113,7 +133,7 @@ public:
 protected:
   // helpers
   void createProgram();
-  void updateMaxLength();
+  virtual void updateMaxLength() override;
 
   std::vector<glm::vec3> vectorsData;
 };
@@ -135,8 +155,10 @@ public:
   void drawVectors();
   void refreshVectors();
 
+  // Replace the vectors, as VectorQuantity::updateData()
   template <class V>
   void updateData(const V& newVectors);
+  void updateData(const glm::vec2* newVectors, size_t count);
 
   // === Members
 
@@ -156,7 +178,7 @@ public:
 protected:
   // helpers
   void createProgram();
-  void updateMaxLength();
+  virtual void updateMaxLength() override;
 
   std::vector<glm::vec2> tangentVectorsData;
   std::vector<glm::vec3> tangentBasisXData;
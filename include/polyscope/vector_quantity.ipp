@@ -16,7 +16,8 @@ VectorQuantityBase<QuantityT>::VectorQuantityBase(QuantityT& quantity_, VectorTy
                        vectorType == VectorType::AMBIENT ? absoluteValue(1.0) : relativeValue(0.02)),
       vectorRadius(quantity.uniquePrefix() + "vectorRadius", relativeValue(0.0025)),
       vectorColor(quantity.uniquePrefix() + "vectorColor", getNextUniqueColor()),
-      material(quantity.uniquePrefix() + "material", "clay") {}
+      material(quantity.uniquePrefix() + "material", "clay"),
+      vectorMinPixelSpacing(quantity.uniquePrefix() + "vectorMinPixelSpacing", 0.) {}
 
 template <typename QuantityT>
 void VectorQuantityBase<QuantityT>::buildVectorUI() {
@@ -52,6 +53,13 @@ void VectorQuantityBase<QuantityT>::buildVectorUI() {
     requestRedraw();
   }
 
+  if (options::instancedVectors) {
+    if (ImGui::SliderFloat("Min Spacing (px)", &vectorMinPixelSpacing.get(), 0.0, 20.0, "%.1f")) {
+      vectorMinPixelSpacing.manuallyChanged();
+      requestRedraw();
+    }
+  }
+
   //{ // Draw max and min magnitude
   // ImGui::TextUnformatted(mapper.printBounds().c_str());
   //}
@@ -78,9 +86,17 @@ QuantityT* VectorQuantityBase<QuantityT>::setVectorLengthRange(double newLength)
 }
 template <typename QuantityT>
 double VectorQuantityBase<QuantityT>::getVectorLengthRange() {
+  ensureVectorLengthRange();
   return vectorLengthRange;
 }
 
+template <typename QuantityT>
+void VectorQuantityBase<QuantityT>::ensureVectorLengthRange() {
+  if (vectorLengthRangeManuallySet || !vectorLengthRangeStale) return;
+  updateMaxLength();
+  vectorLengthRangeStale = false;
+}
+
 template <typename QuantityT>
 QuantityT* VectorQuantityBase<QuantityT>::setVectorRadius(double val, bool isRelative) {
   vectorRadius = ScaledValue<double>(val, isRelative);
@@ -115,22 +131,55 @@ std::string VectorQuantityBase<QuantityT>::getMaterial() {
   return material.get();
 }
 
+template <typename QuantityT>
+QuantityT* VectorQuantityBase<QuantityT>::setVectorMinPixelSpacing(double pixels) {
+  vectorMinPixelSpacing = pixels;
+  requestRedraw();
+  return &quantity;
+}
+template <typename QuantityT>
+double VectorQuantityBase<QuantityT>::getVectorMinPixelSpacing() {
+  return vectorMinPixelSpacing.get();
+}
+
+template <typename QuantityT>
+void VectorQuantityBase<QuantityT>::setInstancedDrawData(size_t nVectors) {
+  vectorProgram->setInstanceCount(static_cast<uint32_t>(nVectors));
+
+  float keepFraction = 1.;
+  float spacing = vectorMinPixelSpacing.get();
+  if (spacing > 0. && nVectors > 0) {
+    double maxVectors = quantity.parent.screenPixelArea() / (spacing * spacing);
+    keepFraction = static_cast<float>(std::min(1., maxVectors / nVectors));
+  }
+  vectorProgram->setUniform("u_keepFraction", keepFraction);
+}
+
+template <typename QuantityT>
+std::vector<glm::vec3> VectorQuantityBase<QuantityT>::instanceBoxCorners() {
+  // (x, y) across the vector, (z) from tail to tip. Same strip order the geometry shader emits.
+  const int stripCorners[14] = {6, 7, 4, 5, 1, 7, 3, 6, 2, 4, 0, 1, 2, 3};
+  std::vector<glm::vec3> corners;
+  for (int c : stripCorners) {
+    corners.emplace_back((c & 1) ? 1. : -1., (c & 2) ? 1. : -1., (c & 4) ? 1. : 0.);
+  }
+  return corners;
+}
+
 // ================================================
 // === (3D) Vector Quantity
 // ================================================
 
 template <typename QuantityT>
-VectorQuantity<QuantityT>::VectorQuantity(QuantityT& quantity_, const std::vector<glm::vec3>& vectors_,
+VectorQuantity<QuantityT>::VectorQuantity(QuantityT& quantity_, std::vector<glm::vec3> vectors_,
                                           render::ManagedBuffer<glm::vec3>& vectorRoots_, VectorType vectorType_)
     : VectorQuantityBase<QuantityT>(quantity_, vectorType_),
       vectors(&quantity_, quantity_.uniquePrefix() + "#values", vectorsData), vectorRoots(vectorRoots_),
-      vectorsData(vectors_) {
-  this->updateMaxLength();
-}
+      vectorsData(std::move(vectors_)) {}
 
 template <typename QuantityT>
 void VectorQuantity<QuantityT>::drawVectors() {
-  if (!this->vectorProgram) {
+  if (!this->vectorProgram || this->vectorProgramInstanced != options::instancedVectors) {
     createProgram();
   }
 
@@ -143,6 +192,7 @@ void VectorQuantity<QuantityT>::drawVectors() {
   if (this->vectorType == VectorType::AMBIENT) {
     this->vectorProgram->setUniform("u_lengthMult", 1.0);
   } else {
+    this->ensureVectorLengthRange();
     this->vectorProgram->setUniform("u_lengthMult",
                                     this->vectorLengthMult.get().asAbsolute() / this->vectorLengthRange);
   }
@@ -152,6 +202,10 @@ void VectorQuantity<QuantityT>::drawVectors() {
   this->vectorProgram->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
   this->vectorProgram->setUniform("u_viewport", render::engine->getCurrentViewport());
 
+  if (this->vectorProgramInstanced) {
+    this->setInstancedDrawData(vectors.size());
+  }
+
   this->vectorProgram->draw();
 }
 
@@ -165,9 +219,10 @@ void VectorQuantity<QuantityT>::createProgram() {
 
 
   // Create the vectorProgram to draw this quantity
+  this->vectorProgramInstanced = options::instancedVectors;
   // clang-format off
   this->vectorProgram = render::engine->requestShader(
-      "RAYCAST_VECTOR",
+      this->vectorProgramInstanced ? "RAYCAST_VECTOR_INSTANCED" : "RAYCAST_VECTOR",
       render::engine->addMaterialRules(this->material.get(), 
         rules
       )
@@ -176,20 +231,17 @@ void VectorQuantity<QuantityT>::createProgram() {
 
   this->vectorProgram->setAttribute("a_vector", vectors.getRenderAttributeBuffer());
   this->vectorProgram->setAttribute("a_position", vectorRoots.getRenderAttributeBuffer());
+  if (this->vectorProgramInstanced) {
+    this->vectorProgram->setAttribute("a_boxCorner", this->instanceBoxCorners());
+  }
 
   render::engine->setMaterial(*(this->vectorProgram), this->material.get());
 }
 
 template <typename QuantityT>
 void VectorQuantity<QuantityT>::updateMaxLength() {
-  if (this->vectorLengthRangeManuallySet) return; // do nothing if it has already been set manually
-
   vectors.ensureHostBufferPopulated();
-  float maxLength = 0.;
-  for (const glm::vec3& vec : vectors.data) {
-    maxLength = std::max(maxLength, glm::length(vec));
-  }
-  this->vectorLengthRange = maxLength;
+  this->vectorLengthRange = finiteMaxLength(vectors.data.data(), vectors.data.size());
 }
 
 template <typename QuantityT>
@@ -203,7 +255,7 @@ void VectorQuantity<QuantityT>::updateData(const T& newVectors) {
   validateSize(newVectors, this->vectors.size(), "vector quantity " + this->quantity.name);
   this->vectors.data = standardizeVectorArray<glm::vec3, 3>(newVectors);
   this->vectors.markHostBufferUpdated();
-  this->updateMaxLength();
+  this->vectorLengthRangeStale = true;
 }
 
 template <typename QuantityT>
@@ -215,7 +267,19 @@ void VectorQuantity<QuantityT>::updateData2D(const T& newVectors) {
     v.z = 0.;
   }
   this->vectors.markHostBufferUpdated();
-  this->updateMaxLength();
+  this->vectorLengthRangeStale = true;
+}
+
+template <typename QuantityT>
+void VectorQuantity<QuantityT>::updateData(const glm::vec3* newVectors, size_t count) {
+  if (count != this->vectors.size()) {
+    exception("vector quantity " + this->quantity.name + " updated with " + std::to_string(count) +
+              " vectors, but has " + std::to_string(this->vectors.size()));
+  }
+  this->vectors.ensureHostBufferAllocated();
+  std::copy(newVectors, newVectors + count, this->vectors.data.begin());
+  this->vectors.markHostBufferUpdated();
+  this->vectorLengthRangeStale = true;
 }
 
 // ================================================
@@ -235,13 +299,11 @@ TangentVectorQuantity<QuantityT>::TangentVectorQuantity(QuantityT& quantity_,
       tangentBasisX(&quantity_, quantity_.uniquePrefix() + "#basisX", tangentBasisXData),
       tangentBasisY(&quantity_, quantity_.uniquePrefix() + "#basisY", tangentBasisYData), vectorRoots(vectorRoots_),
       tangentVectorsData(tangentVectors_), tangentBasisXData(tangentBasisX_), tangentBasisYData(tangentBasisY_),
-      nSym(nSym_) {
-  this->updateMaxLength();
-}
+      nSym(nSym_) {}
 
 template <typename QuantityT>
 void TangentVectorQuantity<QuantityT>::drawVectors() {
-  if (!this->vectorProgram) {
+  if (!this->vectorProgram || this->vectorProgramInstanced != options::instancedVectors) {
     createProgram();
   }
 
@@ -259,6 +321,7 @@ void TangentVectorQuantity<QuantityT>::drawVectors() {
     if (this->vectorType == VectorType::AMBIENT) {
       this->vectorProgram->setUniform("u_lengthMult", 1.0);
     } else {
+      this->ensureVectorLengthRange();
       this->vectorProgram->setUniform("u_lengthMult",
                                       this->vectorLengthMult.get().asAbsolute() / this->vectorLengthRange);
     }
@@ -268,6 +331,10 @@ void TangentVectorQuantity<QuantityT>::drawVectors() {
     this->vectorProgram->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
     this->vectorProgram->setUniform("u_viewport", render::engine->getCurrentViewport());
 
+    if (this->vectorProgramInstanced) {
+      this->setInstancedDrawData(tangentVectors.size());
+    }
+
     this->vectorProgram->draw();
   }
 }
@@ -281,9 +348,10 @@ void TangentVectorQuantity<QuantityT>::createProgram() {
   }
 
   // Create the vectorProgram to draw this quantity
+  this->vectorProgramInstanced = options::instancedVectors;
   // clang-format off
   this->vectorProgram = render::engine->requestShader(
-      "RAYCAST_TANGENT_VECTOR",
+      this->vectorProgramInstanced ? "RAYCAST_TANGENT_VECTOR_INSTANCED" : "RAYCAST_TANGENT_VECTOR",
       render::engine->addMaterialRules(this->material.get(), 
         rules
       )
@@ -294,20 +362,17 @@ void TangentVectorQuantity<QuantityT>::createProgram() {
   this->vectorProgram->setAttribute("a_basisVectorX", tangentBasisX.getRenderAttributeBuffer());
   this->vectorProgram->setAttribute("a_basisVectorY", tangentBasisY.getRenderAttributeBuffer());
   this->vectorProgram->setAttribute("a_position", vectorRoots.getRenderAttributeBuffer());
+  if (this->vectorProgramInstanced) {
+    this->vectorProgram->setAttribute("a_boxCorner", this->instanceBoxCorners());
+  }
 
   render::engine->setMaterial(*(this->vectorProgram), this->material.get());
 }
 
 template <typename QuantityT>
 void TangentVectorQuantity<QuantityT>::updateMaxLength() {
-  if (this->vectorLengthRangeManuallySet) return; // do nothing if it has already been set manually
-
   tangentVectors.ensureHostBufferPopulated();
-  float maxLength = 0.;
-  for (const glm::vec2& vec : tangentVectors.data) {
-    maxLength = std::max(maxLength, glm::length(vec));
-  }
-  this->vectorLengthRange = maxLength;
+  this->vectorLengthRange = finiteMaxLength(tangentVectors.data.data(), tangentVectors.data.size());
 }
 
 template <typename QuantityT>
@@ -321,7 +386,19 @@ void TangentVectorQuantity<QuantityT>::updateData(const T& newVectors) {
   validateSize(newVectors, this->tangentVectors.size(), "tangent vector quantity " + this->quantity.name);
   this->tangentVectors.data = standardizeVectorArray<glm::vec2, 2>(newVectors);
   this->tangentVectors.markHostBufferUpdated();
-  this->updateMaxLength();
+  this->vectorLengthRangeStale = true;
+}
+
+template <typename QuantityT>
+void TangentVectorQuantity<QuantityT>::updateData(const glm::vec2* newVectors, size_t count) {
+  if (count != this->tangentVectors.size()) {
+    exception("tangent vector quantity " + this->quantity.name + " updated with " + std::to_string(count) +
+              " vectors, but has " + std::to_string(this->tangentVectors.size()));
+  }
+  this->tangentVectors.ensureHostBufferAllocated();
+  std::copy(newVectors, newVectors + count, this->tangentVectors.data.begin());
+  this->tangentVectors.markHostBufferUpdated();
+  this->vectorLengthRangeStale = true;
 }
 
 } // namespace polyscope
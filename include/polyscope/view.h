@@ -56,6 +56,7 @@ extern std::array<float, 4>& bgColor;
 extern glm::mat4x4& viewMat;
 extern double& fov; // in the y direction
 extern ProjectionMode& projectionMode;
+extern glm::vec2& projectionJitter; // sub-pixel shift of the projection in NDC, only set while a TAA frame is rendered
 
 // "Flying" view
 extern bool& midflight;
@@ -109,12 +110,14 @@ glm::mat4 getCameraViewMatrix();
 void setCameraViewMatrix(glm::mat4 newMat);
 glm::mat4 getCameraPerspectiveMatrix();
 glm::vec3 getCameraWorldPosition();
+glm::dvec3 getCameraWorldPositionDouble(); // the same, inverting the view matrix in double precision
 void getCameraFrame(glm::vec3& lookDir, glm::vec3& upDir, glm::vec3& rightDir);
 
 // Get world geometry corresponding to a screen pixel (e.g. from a mouse click)
 glm::vec3 screenCoordsToWorldRay(glm::vec2 screenCoords);
 glm::vec3 bufferCoordsToWorldRay(int xPos, int yPos);
-glm::vec3 screenCoordsToWorldPosition(glm::vec2 screenCoords); // queries the depth buffer to get full position
+glm::vec3 screenCoordsToWorldPosition(glm::vec2 screenCoords); // uses the depth of the last rendered frame
+glm::dvec3 screenCoordsToWorldPositionDouble(glm::vec2 screenCoords); // the same, for large coordinates
 
 // Flight-related
 void startFlightTo(const CameraParameters& p, float flightLengthInSeconds = .4);
@@ -128,6 +131,29 @@ void setViewFromJson(std::string jsonData, bool flyTo);
 std::string getCameraJson();
 void setCameraFromJson(std::string jsonData, bool flyTo);
 
+// === Multiple viewports
+
+// Besides the main view, extra viewports show the scene from cameras of their own in regions of the window, e.g. for a
+// quad layout with top, front and side views. Every view draws the same structures with the same GPU buffers and
+// shaders. Regions are {x, y, width, height} as fractions of the window, from its lower left corner. Mouse navigation
+// and picking apply to the view under the mouse.
+void addViewport(std::string name, glm::vec4 region, const CameraParameters& camera,
+                 ProjectionMode mode = ProjectionMode::Perspective);
+void removeViewport(std::string name);
+void removeAllViewports(); // also gives the main view the whole window again
+bool hasViewport(std::string name);
+void setViewportCamera(std::string name, const CameraParameters& camera);
+CameraParameters getViewportCamera(std::string name);
+void setViewportProjectionMode(std::string name, ProjectionMode mode);
+void setViewportRegion(std::string name, glm::vec4 region);
+glm::vec4 getViewportRegion(std::string name);
+void setMainViewportRegion(glm::vec4 region);
+glm::vec4 getMainViewportRegion();
+
+// The main view in the top right quarter of the window, and orthographic "top", "front" and "side" viewports in the
+// others, following the up and front directions
+void setQuadViewLayout();
+
 // Other helpers
 std::string to_string(ProjectionMode mode);
 std::string to_string(NavigateStyle style);
@@ -137,6 +163,21 @@ std::tuple<int, int> screenCoordsToBufferInds(glm::vec2 screenCoords);
 void buildViewGui();
 void updateFlight(); // Note: uses wall-clock time, so should generally be called exactly once at the beginning of each
                      // iteration
+void requestSceneDepthDownload(); // start copying the scene depth to the CPU, called after the scene is rendered
+void processSceneDepthDownload(); // pick up a finished copy if there is one, called once per frame
+
+// Extra viewports. Between beginViewport() and endViewport() the camera of the viewport is the current view, and any
+// navigation is kept with it.
+size_t getViewportCount();
+void beginViewport(size_t iViewport);
+void endViewport();
+int getViewportAtScreenCoords(glm::vec2 screenCoords); // -1 for the main view
+glm::vec4 getCurrentViewportRegion();
+glm::vec4 getCurrentViewportScreenRect(); // in window pixels, {x, y, width, height} from the lower left
+double getCurrentViewportAspect();
+
+// True if a box in view coordinates is entirely behind the CPU copy of the scene depth, see options::occlusionCulling
+bool viewSpaceBoxOccluded(glm::vec3 viewMin, glm::vec3 viewMax);
 
 
 // == Setters, getters, etc
@@ -4,15 +4,19 @@
 
 #include "polyscope/affine_remapper.h"
 #include "polyscope/color_management.h"
+#include "polyscope/implicit_helpers.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 #include "polyscope/standardize_data_array.h"
 #include "polyscope/structure.h"
+#include "polyscope/volume_grid_data_source.h"
 
 #include "polyscope/volume_grid_quantity.h"
 #include "polyscope/volume_grid_scalar_quantity.h"
 
+#include <array>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 
 namespace polyscope {
@@ -32,6 +36,11 @@ public:
   // Construct a new volume grid structure
   VolumeGrid(std::string name, glm::uvec3 gridNodeDim_, glm::vec3 boundMin_, glm::vec3 boundMax_);
 
+  // Construct a sparse volume grid, which only holds data in the listed blocks of sparseBlockSize^3 cells (given by
+  // block index, so block b covers cells [b * sparseBlockSize, (b + 1) * sparseBlockSize)).
+  VolumeGrid(std::string name, glm::uvec3 gridNodeDim_, glm::vec3 boundMin_, glm::vec3 boundMax_,
+             const std::vector<glm::uvec3>& occupiedBlocks_);
+
   // === Overloads
 
   // Standard structure overrides
@@ -41,6 +50,7 @@ public:
   virtual void updateObjectSpaceBounds() override;
   virtual std::string typeName() override;
   virtual void refresh() override;
+  virtual void refreshShaderPrograms() override;
 
   // Build the imgui display
   virtual void buildCustomUI() override;
@@ -71,6 +81,11 @@ public:
   
   template <class Func>
   VolumeGridNodeScalarQuantity* addNodeScalarQuantityFromBatchCallable(std::string name, Func&& func, DataType dataType_ = DataType::STANDARD);
+
+  // Evaluates the function in parallel tiles, as set by opts.batchTileSize and opts.batchThreads (the other options
+  // are unused). The function must then be safe to call concurrently.
+  template <class Func>
+  VolumeGridNodeScalarQuantity* addNodeScalarQuantityFromBatchCallable(std::string name, Func&& func, const ImplicitRenderOpts& opts, DataType dataType_ = DataType::STANDARD);
   
   template <class T>
   VolumeGridCellScalarQuantity* addCellScalarQuantity(std::string name, const T& values, DataType dataType_ = DataType::STANDARD);
@@ -81,6 +96,32 @@ public:
   template <class Func>
   VolumeGridCellScalarQuantity* addCellScalarQuantityFromBatchCallable(std::string name, Func&& func, DataType dataType_ = DataType::STANDARD);
 
+  template <class Func>
+  VolumeGridCellScalarQuantity* addCellScalarQuantityFromBatchCallable(std::string name, Func&& func, const ImplicitRenderOpts& opts, DataType dataType_ = DataType::STANDARD);
+
+  // Values read on demand from a data source rather than held in memory (see volume_grid_data_source.h), for grids
+  // larger than RAM. The grid switches to bricked storage, and only the bricks the slice planes leave are read, also
+  // for isosurfaces. The value range is given, as computing it would read everything. Not supported on sparse grids.
+  VolumeGridNodeScalarQuantity* addNodeScalarQuantityFromSource(std::string name, std::shared_ptr<VolumeGridDataSource> source, std::pair<double, double> valueRange, DataType dataType_ = DataType::STANDARD);
+  VolumeGridCellScalarQuantity* addCellScalarQuantityFromSource(std::string name, std::shared_ptr<VolumeGridDataSource> source, std::pair<double, double> valueRange, DataType dataType_ = DataType::STANDARD);
+
+  // Values kept in their own compact type, e.g. uint8 masks or uint16 CT scans, rather than converted to floats. They
+  // take a quarter or half the memory on the host, and are also stored compactly on the GPU (normalized to [0,1] for
+  // the integer types). Drawn from bricks as for data sources above. T is uint8_t, uint16_t, int16_t or float, half
+  // floats are given as raw bytes with RawValueType::Float16.
+  template <class T>
+  VolumeGridNodeScalarQuantity* addNodeScalarQuantityNative(std::string name, const std::vector<T>& values, DataType dataType_ = DataType::STANDARD);
+  VolumeGridNodeScalarQuantity* addNodeScalarQuantityNative(std::string name, std::vector<unsigned char> bytes, RawValueType valueType, DataType dataType_ = DataType::STANDARD);
+  template <class T>
+  VolumeGridCellScalarQuantity* addCellScalarQuantityNative(std::string name, const std::vector<T>& values, DataType dataType_ = DataType::STANDARD);
+  VolumeGridCellScalarQuantity* addCellScalarQuantityNative(std::string name, std::vector<unsigned char> bytes, RawValueType valueType, DataType dataType_ = DataType::STANDARD);
+
+  // Like addNodeScalarQuantity(), but the values are read in place from `count` floats of externally-owned memory
+  // (x-fastest) rather than copied, see PointCloud::addScalarQuantityView(). Drawn from bricks as for data sources
+  // above, so not supported on sparse grids.
+  VolumeGridNodeScalarQuantity* addNodeScalarQuantityView(std::string name, const float* values, size_t count, std::shared_ptr<void> lifetimeToken = nullptr, DataType dataType_ = DataType::STANDARD);
+  VolumeGridCellScalarQuantity* addCellScalarQuantityView(std::string name, const float* values, size_t count, std::shared_ptr<void> lifetimeToken = nullptr, DataType dataType_ = DataType::STANDARD);
+
   
   // Rendering helpers used by quantities
   // void populateGeometry();
@@ -114,6 +155,47 @@ public:
   glm::vec3 positionOfCellIndex(uint64_t i) const;
   glm::vec3 positionOfCellIndex(glm::uvec3 inds) const;
 
+  // == Sparse grids
+  //
+  // On a sparse grid, quantities store values only for the occupied blocks, so memory scales with the occupied region
+  // rather than the bounding grid. Values are packed block by block, in the order of getOccupiedBlocks(), and x-fastest
+  // within each block. A block holds (sparseBlockSize + 1)^3 node values (nodes on the faces between blocks are
+  // repeated in each block) or sparseBlockSize^3 cell values. Blocks on the upper boundary may extend past the grid,
+  // the values there are unused. Everything outside the occupied blocks is empty, and is not drawn.
+
+  static const uint32_t sparseBlockSize;
+  bool isSparse() const;
+  glm::uvec3 getSparseBlockDim() const; // number of blocks along each axis, occupied or not
+  size_t nOccupiedBlocks() const;
+  const std::vector<glm::uvec3>& getOccupiedBlocks() const;
+  uint64_t nSparseNodes() const; // number of node values in a sparse quantity
+  uint64_t nSparseCells() const; // number of cell values in a sparse quantity
+
+  // Index in to the values of a sparse quantity for the node/cell with the given grid index, or -1 if it is empty
+  int64_t sparseNodeDataIndex(glm::uvec3 inds) const;
+  int64_t sparseCellDataIndex(glm::uvec3 inds) const;
+
+  // Position of the i'th value of a sparse quantity
+  glm::vec3 positionOfSparseNode(uint64_t i) const;
+  glm::vec3 positionOfSparseCell(uint64_t i) const;
+
+  // == Bricked storage
+  //
+  // Gridcubes of quantities on sparse grids are drawn from a pool texture holding one brick (a sparse block) per slot,
+  // and a page table giving the slot of each brick. Dense grids use the same storage when they are larger than the
+  // backend's 3D texture size limit, or when setBrickedStorage(true) is set. Then only the bricks which are not entirely
+  // sliced away by the slice planes are resident in the pool, and bricks are uploaded from the host values as the
+  // slice planes uncover them, so a slice through a grid too large for GPU memory can still be drawn. Volume rendering
+  // and raymarched isosurfaces need the whole grid in one texture, and are not available on bricked grids.
+  bool isBricked() const;
+  VolumeGrid* setBrickedStorage(bool newVal);
+  bool getBrickedStorage();
+
+  // On dense bricked grids, the brick (as a flat index, x-fastest over the bricks) resident in each slot of the pool,
+  // or -1 for a free slot, for the current slice planes. The version is incremented whenever a brick moves in or out.
+  const std::vector<int64_t>& getResidentSlotBricks();
+  uint64_t getBrickResidencyVersion() const;
+
   // force the grid to act as if the specified elements are in use (aka enable them for picking, etc)
   void markNodesAsUsed();
   void markCellsAsUsed();
@@ -147,6 +229,22 @@ private:
   glm::uvec3 gridNodeDim;
   glm::uvec3 gridCellDim;
   glm::vec3 boundMin, boundMax;
+
+  // Sparse blocks
+  bool sparse = false;
+  glm::uvec3 sparseBlockDim{0, 0, 0};
+  std::vector<glm::uvec3> occupiedBlocks;
+  std::vector<int32_t> sparseBlockSlots; // the position of each block in occupiedBlocks, or -1, x-fastest
+  std::shared_ptr<render::TextureBuffer> sparseBlockSlotTexture; // page table: sparse block slots, or resident slots
+  int64_t sparseBlockSlot(glm::uvec3 block) const;
+
+  // Bricked dense grids
+  bool brickedStorage = false;
+  bool exceedsTextureSizeLimit = false;
+  std::vector<int32_t> residentBrickSlots; // the slot of each brick, or -1 if it is not resident, x-fastest
+  std::vector<int64_t> residentSlotBricks; // the inverse
+  uint64_t brickResidencyVersion = 0;
+  void updateResidentBricks(const std::vector<char>& brickNeeded);
  
   // === Storage for managed quantities
   std::vector<glm::vec3> gridPlaneReferencePositionsData;
@@ -162,6 +260,15 @@ private:
 
   // == Compute indices & geometry data
   void computeGridPlaneReferenceGeometry();
+
+  // == Slice plane culling
+  // The cells are grouped in to bricks (the same as the sparse blocks), and each grid plane is clipped to the bricks of
+  // its slab which are not entirely sliced away or empty, so that culled bricks never generate fragments. Rects are
+  // {low1, low2, high1, high2} cell bounds along the two other axes, for each axis and each slab of bricks along it.
+  // Empty if nothing is culled.
+  std::array<std::vector<glm::uvec4>, 3> gridPlaneCullRects;
+  std::vector<float> gridPlaneCullState; // the transform and slice planes the rects were computed for
+  void updateGridPlaneCulling();          // recompute the rects (and geometry) if the slice planes have changed
   
   // Picking-related
   // Order of indexing: vertices, cells
@@ -199,6 +306,11 @@ private:
 VolumeGrid* registerVolumeGrid(std::string name, glm::uvec3 gridNodeDim, glm::vec3 boundMin, glm::vec3 boundMax);
 VolumeGrid* registerVolumeGrid(std::string name, uint64_t gridNodeAxesDim, glm::vec3 boundMin, glm::vec3 boundMax);
 
+// Register a sparse grid, see VolumeGrid::getOccupiedBlocks(). Each block index must be less than
+// ceil((gridNodeDim - 1) / VolumeGrid::sparseBlockSize), and be listed only once.
+VolumeGrid* registerSparseVolumeGrid(std::string name, glm::uvec3 gridNodeDim, glm::vec3 boundMin, glm::vec3 boundMax,
+                                     const std::vector<glm::uvec3>& occupiedBlocks);
+
 // Shorthand to get a point cloud from polyscope
 inline VolumeGrid* getVolumeGrid(std::string name = "");
 inline bool hasVolumeGrid(std::string name = "");
@@ -85,6 +85,53 @@ inline float VolumeGrid::minGridSpacing() const {
   return std::fmin(std::fmin(spacing[0], spacing[1]), spacing[2]);
 }
 
+// Sparse grids
+inline bool VolumeGrid::isSparse() const { return sparse; }
+inline glm::uvec3 VolumeGrid::getSparseBlockDim() const { return sparseBlockDim; }
+inline size_t VolumeGrid::nOccupiedBlocks() const { return occupiedBlocks.size(); }
+inline const std::vector<glm::uvec3>& VolumeGrid::getOccupiedBlocks() const { return occupiedBlocks; }
+
+inline bool VolumeGrid::isBricked() const { return sparse || brickedStorage || exceedsTextureSizeLimit; }
+inline const std::vector<int64_t>& VolumeGrid::getResidentSlotBricks() {
+  updateGridPlaneCulling();
+  return residentSlotBricks;
+}
+inline uint64_t VolumeGrid::getBrickResidencyVersion() const { return brickResidencyVersion; }
+
+inline uint64_t VolumeGrid::nSparseNodes() const {
+  uint64_t blockNodes = sparseBlockSize + 1;
+  return occupiedBlocks.size() * blockNodes * blockNodes * blockNodes;
+}
+
+inline uint64_t VolumeGrid::nSparseCells() const {
+  uint64_t blockCells = sparseBlockSize;
+  return occupiedBlocks.size() * blockCells * blockCells * blockCells;
+}
+
+inline glm::vec3 VolumeGrid::positionOfSparseNode(uint64_t i) const {
+  uint64_t blockNodes = sparseBlockSize + 1;
+  uint64_t perBlock = blockNodes * blockNodes * blockNodes;
+  uint64_t local = i % perBlock;
+  glm::uvec3 localInds{static_cast<uint32_t>(local % blockNodes),
+                       static_cast<uint32_t>((local / blockNodes) % blockNodes),
+                       static_cast<uint32_t>(local / (blockNodes * blockNodes))};
+  glm::uvec3 inds = occupiedBlocks[i / perBlock] * sparseBlockSize + localInds;
+  glm::vec3 tVals = glm::vec3(inds) / glm::vec3(gridNodeDim - 1u);
+  return (1.f - tVals) * boundMin + tVals * boundMax;
+}
+
+inline glm::vec3 VolumeGrid::positionOfSparseCell(uint64_t i) const {
+  uint64_t blockCells = sparseBlockSize;
+  uint64_t perBlock = blockCells * blockCells * blockCells;
+  uint64_t local = i % perBlock;
+  glm::uvec3 localInds{static_cast<uint32_t>(local % blockCells),
+                       static_cast<uint32_t>((local / blockCells) % blockCells),
+                       static_cast<uint32_t>(local / (blockCells * blockCells))};
+  glm::uvec3 inds = occupiedBlocks[i / perBlock] * sparseBlockSize + localInds;
+  glm::vec3 tVals = (glm::vec3(inds) / glm::vec3(gridCellDim));
+  return (1.f - tVals) * boundMin + tVals * boundMax + gridSpacing() / 2.f;
+}
+
 // Shorthand to get a volume grid from polyscope
 inline VolumeGrid* getVolumeGrid(std::string name) {
   return dynamic_cast<VolumeGrid*>(getStructure(VolumeGrid::structureTypeName, name));
@@ -101,7 +148,7 @@ inline void removeVolumeGrid(std::string name, bool errorIfAbsent) {
 
 template <class T>
 VolumeGridNodeScalarQuantity* VolumeGrid::addNodeScalarQuantity(std::string name, const T& values, DataType dataType_) {
-  validateSize(values, nNodes(), "grid node scalar quantity " + name);
+  validateSize(values, isSparse() ? nSparseNodes() : nNodes(), "grid node scalar quantity " + name);
   return addNodeScalarQuantityImpl(name, standardizeArray<float, T>(values), dataType_);
 }
 
@@ -125,26 +172,42 @@ VolumeGridNodeScalarQuantity* VolumeGrid::addNodeScalarQuantityFromCallable(std:
 template <class Func>
 VolumeGridNodeScalarQuantity* VolumeGrid::addNodeScalarQuantityFromBatchCallable(std::string name, Func&& func,
                                                                                  DataType dataType_) {
+  return addNodeScalarQuantityFromBatchCallable(name, func, ImplicitRenderOpts(), dataType_);
+}
+
+template <class Func>
+VolumeGridNodeScalarQuantity* VolumeGrid::addNodeScalarQuantityFromBatchCallable(std::string name, Func&& func,
+                                                                                 const ImplicitRenderOpts& opts,
+                                                                                 DataType dataType_) {
   // Build list of points to query
-  std::vector<float> queries(3 * nNodes());
-  std::vector<float> result(nNodes());
+  size_t nQuery = isSparse() ? nSparseNodes() : nNodes();
+  std::vector<float> queries(3 * nQuery);
+  std::vector<float> result(nQuery);
 
   // Sample to grid
-  for (size_t i = 0; i < nNodes(); i++) {
-    glm::vec3 pos = positionOfNodeIndex(i);
+  for (size_t i = 0; i < nQuery; i++) {
+    glm::vec3 pos = isSparse() ? positionOfSparseNode(i) : positionOfNodeIndex(i);
     queries[3 * i + 0] = pos.x;
     queries[3 * i + 1] = pos.y;
     queries[3 * i + 2] = pos.z;
   }
 
-  func(&queries.front(), &result.front(), static_cast<size_t>(nNodes()));
+  evaluateImplicitBatch(func, queries.data(), result.data(), nQuery, 1, opts);
 
   return addNodeScalarQuantity(name, result, dataType_);
 }
 
+template <class T>
+VolumeGridNodeScalarQuantity* VolumeGrid::addNodeScalarQuantityNative(std::string name, const std::vector<T>& values,
+                                                                      DataType dataType_) {
+  std::vector<unsigned char> bytes(values.size() * sizeof(T));
+  if (!values.empty()) std::memcpy(&bytes.front(), &values.front(), bytes.size());
+  return addNodeScalarQuantityNative(name, std::move(bytes), RawValueTypeOf<T>::value, dataType_);
+}
+
 template <class T>
 VolumeGridCellScalarQuantity* VolumeGrid::addCellScalarQuantity(std::string name, const T& values, DataType dataType_) {
-  validateSize(values, nCells(), "grid cell scalar quantity " + name);
+  validateSize(values, isSparse() ? nSparseCells() : nCells(), "grid cell scalar quantity " + name);
   return addCellScalarQuantityImpl(name, standardizeArray<float, T>(values), dataType_);
 }
 
@@ -168,22 +231,38 @@ VolumeGridCellScalarQuantity* VolumeGrid::addCellScalarQuantityFromCallable(std:
 template <class Func>
 VolumeGridCellScalarQuantity* VolumeGrid::addCellScalarQuantityFromBatchCallable(std::string name, Func&& func,
                                                                                  DataType dataType_) {
+  return addCellScalarQuantityFromBatchCallable(name, func, ImplicitRenderOpts(), dataType_);
+}
+
+template <class Func>
+VolumeGridCellScalarQuantity* VolumeGrid::addCellScalarQuantityFromBatchCallable(std::string name, Func&& func,
+                                                                                 const ImplicitRenderOpts& opts,
+                                                                                 DataType dataType_) {
   // Build list of points to query
-  std::vector<float> queries(3 * nCells());
-  std::vector<float> result(nCells());
+  size_t nQuery = isSparse() ? nSparseCells() : nCells();
+  std::vector<float> queries(3 * nQuery);
+  std::vector<float> result(nQuery);
 
   // Sample to grid
-  for (size_t i = 0; i < nCells(); i++) {
-    glm::vec3 pos = positionOfCellIndex(i);
+  for (size_t i = 0; i < nQuery; i++) {
+    glm::vec3 pos = isSparse() ? positionOfSparseCell(i) : positionOfCellIndex(i);
     queries[3 * i + 0] = pos.x;
     queries[3 * i + 1] = pos.y;
     queries[3 * i + 2] = pos.z;
   }
 
-  func(&queries.front(), &result.front(), static_cast<size_t>(nCells()));
+  evaluateImplicitBatch(func, queries.data(), result.data(), nQuery, 1, opts);
 
   return addCellScalarQuantity(name, result, dataType_);
 }
 
+template <class T>
+VolumeGridCellScalarQuantity* VolumeGrid::addCellScalarQuantityNative(std::string name, const std::vector<T>& values,
+                                                                      DataType dataType_) {
+  std::vector<unsigned char> bytes(values.size() * sizeof(T));
+  if (!values.empty()) std::memcpy(&bytes.front(), &values.front(), bytes.size());
+  return addCellScalarQuantityNative(name, std::move(bytes), RawValueTypeOf<T>::value, dataType_);
+}
+
 
 } // namespace polyscope
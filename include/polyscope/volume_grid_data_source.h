@@ -0,0 +1,149 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace polyscope {
+
+// The types volume values can be stored in. Float16 values are given as their raw bits.
+enum class RawValueType { UInt8 = 0, UInt16, Float32, Int16, Float16 };
+size_t rawValueTypeSize(RawValueType valueType);
+
+template <class T>
+struct RawValueTypeOf;
+template <>
+struct RawValueTypeOf<uint8_t> {
+  static const RawValueType value = RawValueType::UInt8;
+};
+template <>
+struct RawValueTypeOf<uint16_t> {
+  static const RawValueType value = RawValueType::UInt16;
+};
+template <>
+struct RawValueTypeOf<int16_t> {
+  static const RawValueType value = RawValueType::Int16;
+};
+template <>
+struct RawValueTypeOf<float> {
+  static const RawValueType value = RawValueType::Float32;
+};
+
+// The values of a volume grid scalar quantity which are not held in memory, but read on demand, e.g. from a file
+// which is larger than RAM. See VolumeGrid::addNodeScalarQuantityFromSource(). Only the bricks of the grid which the
+// slice planes do not cut away are read, through a least-recently-used cache with a memory budget.
+class VolumeGridDataSource {
+public:
+  virtual ~VolumeGridDataSource() = default;
+
+  // Write the values of the nodes (or cells) [origin, origin + extent) to `out`, x-fastest. Calls are never
+  // concurrent.
+  virtual void readBox(glm::uvec3 origin, glm::uvec3 extent, float* out) = 0;
+
+  // The type the values are stored in. The GPU copy of the bricks is stored in the same precision, see
+  // VolumeGrid::addNodeScalarQuantityNative().
+  virtual RawValueType getValueType() const { return RawValueType::Float32; }
+};
+
+// Values from a user callback with the signature of readBox(), e.g. reading the tiles of a chunked dataset like Zarr
+// or HDF5.
+class CallbackVolumeGridDataSource : public VolumeGridDataSource {
+public:
+  CallbackVolumeGridDataSource(std::function<void(glm::uvec3 origin, glm::uvec3 extent, float* out)> readFunc);
+  virtual void readBox(glm::uvec3 origin, glm::uvec3 extent, float* out) override;
+
+private:
+  std::function<void(glm::uvec3, glm::uvec3, float*)> readFunc;
+};
+
+// Values stored uncompressed in a raw file with dimensions `dim`, x-fastest, after a header of `headerBytes`.
+class RawFileVolumeGridDataSource : public VolumeGridDataSource {
+public:
+  RawFileVolumeGridDataSource(std::string filename, glm::uvec3 dim, RawValueType valueType, size_t headerBytes = 0);
+  virtual void readBox(glm::uvec3 origin, glm::uvec3 extent, float* out) override;
+  virtual RawValueType getValueType() const override;
+
+private:
+  std::string filename;
+  std::ifstream file;
+  glm::uvec3 dim;
+  RawValueType valueType;
+  size_t headerBytes;
+  std::vector<char> rowBuffer;
+};
+
+// Values held in memory in their own type, x-fastest, e.g. uint8 segmentation masks or uint16 CT scans at a quarter or
+// half the memory of floats. Either owns the bytes, or reads in place from externally-owned memory, which must stay
+// valid as long as the source exists; holding `lifetimeToken` is one way to ensure that.
+class ArrayVolumeGridDataSource : public VolumeGridDataSource {
+public:
+  ArrayVolumeGridDataSource(std::vector<unsigned char> bytes, glm::uvec3 dim, RawValueType valueType);
+  ArrayVolumeGridDataSource(const void* viewData, glm::uvec3 dim, RawValueType valueType,
+                            std::shared_ptr<void> lifetimeToken = nullptr);
+  virtual void readBox(glm::uvec3 origin, glm::uvec3 extent, float* out) override;
+  virtual RawValueType getValueType() const override;
+
+  // The min and max of the finite values
+  std::pair<double, double> computeValueRange() const;
+
+private:
+  std::vector<unsigned char> bytes; // empty for views
+  const unsigned char* data;        // the values, in `bytes` or the view
+  size_t nBytes;
+  std::shared_ptr<void> lifetimeToken;
+  glm::uvec3 dim;
+  RawValueType valueType;
+};
+
+// A least-recently-used cache of the bricks of a data source, used by quantities. Bricks are the sparse blocks of the
+// grid (see VolumeGrid::sparseBlockSize), holding slotSize^3 values with the ones past the end of the grid clamped. May
+// be used from several threads.
+class VolumeGridBrickCache {
+public:
+  VolumeGridBrickCache(std::shared_ptr<VolumeGridDataSource> source, glm::uvec3 valueDim, glm::uvec3 brickDim,
+                       uint32_t slotSize);
+
+  // Copy the values of a brick (flat index x-fastest over the bricks) to `out`, reading it if it is not cached
+  void readBrick(int64_t iBrick, float* out);
+  float readValue(glm::uvec3 ind);
+
+  // Cached bricks are evicted, least recently used first, to stay within the budget
+  void setBudget(size_t bytes);
+  size_t getBudget() const;
+  size_t nCachedBricks();
+
+  // The number of bricks read from the source so far, and the values of the bricks currently cached, for histograms
+  uint64_t getReadCount() const;
+  void gatherCachedValues(std::vector<float>& out);
+
+  static const size_t defaultBudget;
+
+private:
+  std::shared_ptr<VolumeGridDataSource> source;
+  glm::uvec3 valueDim;
+  glm::uvec3 brickDim;
+  uint32_t slotSize;
+  size_t budget;
+  uint64_t readCount = 0;
+
+  std::mutex mutex;
+  std::list<int64_t> recentBricks; // most recently used first
+  std::unordered_map<int64_t, std::pair<std::vector<float>, std::list<int64_t>::iterator>> bricks;
+
+  const std::vector<float>& fetchBrick(int64_t iBrick); // must hold the mutex
+  void evictToBudget(size_t keep);
+};
+
+} // namespace polyscope
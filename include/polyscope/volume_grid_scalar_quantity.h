@@ -6,10 +6,12 @@
 
 #include "polyscope/affine_remapper.h"
 #include "polyscope/histogram.h"
+#include "polyscope/marching_cubes.h"
 #include "polyscope/render/color_maps.h"
 #include "polyscope/scalar_quantity.h"
 #include "polyscope/surface_mesh.h"
 #include "polyscope/volume_grid.h"
+#include "polyscope/volume_grid_data_source.h"
 
 namespace polyscope {
 
@@ -23,15 +25,26 @@ public:
   VolumeGridNodeScalarQuantity(std::string name, VolumeGrid& grid_, const std::vector<float>& values_,
                                DataType dataType_);
 
+  // Values read on demand from a data source (see VolumeGrid::addNodeScalarQuantityFromSource())
+  VolumeGridNodeScalarQuantity(std::string name, VolumeGrid& grid_, std::shared_ptr<VolumeGridDataSource> source,
+                               std::pair<double, double> valueRange, DataType dataType_);
+
   virtual void draw() override;
+  virtual void drawDelayed() override;
   virtual void buildCustomUI() override;
   virtual void refresh() override;
+  virtual void refreshShaderPrograms() override; // keeps the isosurface mesh
   virtual void buildNodeInfoGUI(size_t ind) override;
 
   virtual std::string niceName() override;
 
   virtual bool isDrawingGridcubes() override;
 
+  // Replace the values of the nodes [offset, offset + extent), given x-fastest. Only that box is uploaded, and only the
+  // slabs of the isosurface which it touches are extracted again. Not supported on sparse grids or with a data source.
+  template <class V>
+  void updateNodeScalarRegion(glm::uvec3 offset, glm::uvec3 extent, const V& newValues);
+
   // == Getters and setters
 
   // Gridcube viz
@@ -54,25 +67,87 @@ public:
   VolumeGridNodeScalarQuantity* setSlicePlanesAffectIsosurface(bool val);
   bool getSlicePlanesAffectIsosurface();
 
+  // Draw the isosurface by raymarching the node values on the GPU, rather than extracting a mesh on the CPU. Changing
+  // the level is then immediate. registerIsosurfaceAsMesh() still extracts a mesh. Not supported on sparse or bricked
+  // grids.
+  VolumeGridNodeScalarQuantity* setIsosurfaceRaymarched(bool val);
+  bool getIsosurfaceRaymarched();
+
+  // Register the isosurface at the current level as a surface mesh. The mesh which is drawn is reused if it is current,
+  // and its buffers are moved in to the new mesh rather than copied.
   SurfaceMesh* registerIsosurfaceAsMesh(std::string structureName = "");
 
+  // Volume viz
+
+  // Direct volume rendering: the values are integrated along each view ray, colored by the colormap with opacity
+  // ramping up across the colormap range. Values outside the range are transparent. Not supported on sparse or bricked
+  // grids.
+  VolumeGridNodeScalarQuantity* setVolumeVizEnabled(bool val);
+  bool getVolumeVizEnabled();
+
+  // Optical depth across the width of the grid, for values at the top of the range
+  VolumeGridNodeScalarQuantity* setVolumeDensity(float val);
+  float getVolumeDensity();
+
+  // Data source
+
+  bool hasDataSource() const;
+  // The memory budget of the cache of bricks read from the data source
+  VolumeGridNodeScalarQuantity* setDataCacheBudget(size_t bytes);
+  size_t getDataCacheBudget();
+
 protected:
   // Visualize as a grid of cubes
   PersistentValue<bool> gridcubeVizEnabled;
   std::shared_ptr<render::ShaderProgram> gridcubeProgram;
+  std::shared_ptr<render::TextureBuffer> sparseValueTexture; // the values as a pool of blocks, only on bricked grids
+  uint64_t sparseValueTextureDataVersion = 0;
+  std::vector<int64_t> brickPoolSlotBricks; // on dense bricked grids, the brick uploaded to each slot of the pool
+  uint64_t brickPoolResidencyVersion = 0;
   void createGridcubeProgram();
 
+  void updateRegion(glm::uvec3 offset, glm::uvec3 extent, const std::vector<float>& newValues);
+
+  // Values from a data source, with `values` left empty. The histogram only counts the bricks read so far.
+  std::unique_ptr<VolumeGridBrickCache> dataSourceCache;
+  TextureFormat poolFormat = TextureFormat::R32F; // compact for compact source types, texels map to values as
+  float poolValueScale = 1.f;                      // texel * scale + offset
+  float poolValueOffset = 0.f;
+  uint64_t histogramReadCount = 0;
+  void ensureSourceHistogramBuilt();
+
   // Visualize as isosurface
   // TODO
   PersistentValue<bool> isosurfaceVizEnabled;
   PersistentValue<float> isosurfaceLevel;
   PersistentValue<glm::vec3> isosurfaceColor;
   PersistentValue<bool> slicePlanesAffectIsosurface;
+  PersistentValue<bool> isosurfaceRaymarched;
   std::shared_ptr<render::ShaderProgram> isosurfaceProgram;
+  std::shared_ptr<render::ShaderProgram> isosurfaceRaymarchProgram;
+  std::vector<std::string> addIsosurfaceRules(std::vector<std::string> initRules);
   void createIsosurfaceProgram();
+  void createIsosurfaceRaymarchProgram();
+  void drawIsosurfaceRaymarched();
+
+  // The extracted isosurface mesh, shared by drawing and registerIsosurfaceAsMesh() (which takes the buffers). It is
+  // cached for the level and values it was extracted from.
+  bool isosurfaceMeshValid = false;
+  float isosurfaceMeshLevel = 0.;
+  uint64_t isosurfaceMeshDataVersion = 0;
+  uint64_t isosurfaceMeshResidencyVersion = 0; // with a data source, only the resident bricks are extracted
+  std::vector<glm::vec3> isosurfaceMeshVertices;
+  std::vector<uint32_t> isosurfaceMeshIndices;
+  MarchingCubesSlabCache isosurfaceSlabs; // on dense grids, region updates only invalidate the slabs they touch
+  void ensureIsosurfaceMeshExtracted();
 
   // Visualize as raymarched volume
-  // TODO
+  PersistentValue<bool> volumeVizEnabled;
+  PersistentValue<float> volumeDensity;
+  std::shared_ptr<render::ShaderProgram> volumeProgram;
+  std::shared_ptr<render::TextureBuffer> volumeBrickTexture;
+  uint64_t volumeProgramDataVersion = 0;
+  void createVolumeProgram();
 };
 
 
@@ -86,7 +161,12 @@ public:
   VolumeGridCellScalarQuantity(std::string name, VolumeGrid& grid_, const std::vector<float>& values_,
                                DataType dataType_);
 
+  // Values read on demand from a data source (see VolumeGrid::addCellScalarQuantityFromSource())
+  VolumeGridCellScalarQuantity(std::string name, VolumeGrid& grid_, std::shared_ptr<VolumeGridDataSource> source,
+                               std::pair<double, double> valueRange, DataType dataType_);
+
   virtual void draw() override;
+  virtual void drawDelayed() override;
   virtual void buildCustomUI() override;
   virtual void refresh() override;
   virtual void buildCellInfoGUI(size_t ind) override;
@@ -95,6 +175,10 @@ public:
 
   virtual bool isDrawingGridcubes() override;
 
+  // Replace the values of the cells [offset, offset + extent), as for node scalars
+  template <class V>
+  void updateCellScalarRegion(glm::uvec3 offset, glm::uvec3 extent, const V& newValues);
+
   // == Getters and setters
 
   // Gridcube viz
@@ -102,12 +186,60 @@ public:
   VolumeGridCellScalarQuantity* setGridcubeVizEnabled(bool val);
   bool getGridcubeVizEnabled();
 
+  // Volume viz (as for node scalars, interpolating between cell centers)
+
+  VolumeGridCellScalarQuantity* setVolumeVizEnabled(bool val);
+  bool getVolumeVizEnabled();
+
+  VolumeGridCellScalarQuantity* setVolumeDensity(float val);
+  float getVolumeDensity();
+
+  // Data source (as for node scalars)
+
+  bool hasDataSource() const;
+  VolumeGridCellScalarQuantity* setDataCacheBudget(size_t bytes);
+  size_t getDataCacheBudget();
+
 
 protected:
   // Visualize as a grid of cubes
   PersistentValue<bool> gridcubeVizEnabled;
   std::shared_ptr<render::ShaderProgram> gridcubeProgram;
+  std::shared_ptr<render::TextureBuffer> sparseValueTexture; // the values as a pool of blocks, only on bricked grids
+  uint64_t sparseValueTextureDataVersion = 0;
+  std::vector<int64_t> brickPoolSlotBricks; // on dense bricked grids, the brick uploaded to each slot of the pool
+  uint64_t brickPoolResidencyVersion = 0;
   void createGridcubeProgram();
+
+  void updateRegion(glm::uvec3 offset, glm::uvec3 extent, const std::vector<float>& newValues);
+
+  // Values from a data source, with `values` left empty. The histogram only counts the bricks read so far.
+  std::unique_ptr<VolumeGridBrickCache> dataSourceCache;
+  TextureFormat poolFormat = TextureFormat::R32F; // compact for compact source types, texels map to values as
+  float poolValueScale = 1.f;                      // texel * scale + offset
+  float poolValueOffset = 0.f;
+  uint64_t histogramReadCount = 0;
+  void ensureSourceHistogramBuilt();
+
+  // Visualize as raymarched volume
+  PersistentValue<bool> volumeVizEnabled;
+  PersistentValue<float> volumeDensity;
+  std::shared_ptr<render::ShaderProgram> volumeProgram;
+  std::shared_ptr<render::TextureBuffer> volumeBrickTexture;
+  uint64_t volumeProgramDataVersion = 0;
+  void createVolumeProgram();
 };
 
+// === Template implementations
+
+template <class V>
+void VolumeGridNodeScalarQuantity::updateNodeScalarRegion(glm::uvec3 offset, glm::uvec3 extent, const V& newValues) {
+  updateRegion(offset, extent, standardizeArray<float, V>(newValues));
+}
+
+template <class V>
+void VolumeGridCellScalarQuantity::updateCellScalarRegion(glm::uvec3 offset, glm::uvec3 extent, const V& newValues) {
+  updateRegion(offset, extent, standardizeArray<float, V>(newValues));
+}
+
 } // namespace polyscope
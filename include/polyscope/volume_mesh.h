@@ -16,6 +16,8 @@
 
 #include <cstdint>
 #include <memory>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 namespace polyscope {
@@ -56,6 +58,8 @@ public:
 
   // Render the the structure on screen
   virtual void draw() override;
+  virtual bool hasPendingHostData() override;
+  virtual void prepareHostData() override;
   virtual void drawDelayed() override;
   virtual void drawPick() override;
   virtual void updateObjectSpaceBounds() override;
@@ -75,8 +79,8 @@ public:
   render::ManagedBuffer<uint32_t> triangleCellInds;   // on the split, triangulated mesh [3 * nTriFace]
 
   // internal triangle data for rendering
-  render::ManagedBuffer<glm::vec3> baryCoord;  // on the split, triangulated mesh [3 * nTriFace]
-  render::ManagedBuffer<glm::vec3> edgeIsReal; // on the split, triangulated mesh [3 * nTriFace]
+  render::ManagedBuffer<glm::vec3> edgeIsReal; // on the split, triangulated mesh [3 * nTriFace], host only, see
+                                               // SurfaceMesh::generateEdgeMaskTexture()
   render::ManagedBuffer<float> faceType;       // on the split, triangulated mesh [3 * nTriFace]
 
   // other internally-computed geometry
@@ -132,7 +136,7 @@ public:
                                               bool isSlice = false);
 
   // Manage a separate tetrahedral representation used for volumetric visualizations
-  // (for a pure-tet mesh this will be the same as the cells array)
+  // (for a pure-tet mesh these are the cells, but stored in a spatially sorted order, see drawSliceProgram())
   // TODO use a managed buffer for this
   std::vector<std::array<uint32_t, 4>> tets;
   size_t nTets();
@@ -160,6 +164,11 @@ public:
   VolumeMesh* setMaterial(std::string name);
   std::string getMaterial();
 
+  // Only build and draw the exterior faces, so memory and drawing scale with the surface rather than the volume. The
+  // interior faces are built when an active slice plane might expose them, and dropped again when none does.
+  VolumeMesh* setExteriorOnly(bool newVal);
+  bool getExteriorOnly();
+
   // Width of the edges. Scaled such that 1 is a reasonable weight for visible edges, but values  1 can be used for
   // bigger edges. Use 0. to disable.
   VolumeMesh* setEdgeWidth(double newVal);
@@ -172,6 +181,8 @@ public:
   void setVolumeMeshUniforms(render::ShaderProgram& p);
   void fillGeometryBuffers(render::ShaderProgram& p);
   void fillSliceGeometryBuffers(render::ShaderProgram& p);
+  // Draw a program filled with per-tet slice attributes, submitting only the tets which the plane might cut
+  void drawSliceProgram(render::ShaderProgram& p, polyscope::SlicePlane* sp);
   static const std::vector<std::vector<std::array<size_t, 3>>>& cellStencil(VolumeCellType type);
 
   // Slice plane listeners
@@ -195,7 +206,6 @@ private:
   std::vector<uint32_t> triangleCellIndsData;   // to the split, triangulated mesh
 
   // internal triangle data for rendering
-  std::vector<glm::vec3> baryCoordData;
   std::vector<glm::vec3> edgeIsRealData;
   std::vector<float> faceTypeData;
 
@@ -209,6 +219,7 @@ private:
   PersistentValue<glm::vec3> edgeColor;
   PersistentValue<std::string> material;
   PersistentValue<float> edgeWidth;
+  PersistentValue<bool> exteriorOnly;
 
   // Level sets
   // TODO: not currently really supported
@@ -238,16 +249,50 @@ private:
   // Drawing related things
   std::shared_ptr<render::ShaderProgram> program;
   std::shared_ptr<render::ShaderProgram> pickProgram;
+  std::shared_ptr<render::TextureBuffer> edgeMaskTexture; // lazily generated from edgeIsReal, see fillGeometryBuffers()
 
   // Internal members
   size_t nFacesTriangulationCount = 0;
   size_t nFacesCount = 0;
 
+  // The triangle buffers hold the exterior faces first, then the interior ones if triangleBuffersHaveInterior
+  bool triangleBuffersHaveInterior = true;
+  size_t nTrianglesBuilt = 0;
+  bool wantsInteriorFaces();
+  void ensureTriangleBuffersCurrent(); // rebuild if the interior faces are newly needed or no longer needed
+
   // === Helper functions
 
   // Initialization work
   void initializeMeshTriangulation();
 
+  // Prefix sums of the face and face-triangle counts of each cell (nCells() + 1 entries each), so work over faces can
+  // be split by cells
+  void computeCellFaceStarts(std::vector<size_t>& cellFaceStart, std::vector<size_t>& cellTriStart) const;
+
+  // Split hex cell iC into 5 or 6 tets, returns how many
+  size_t computeHexTets(size_t iC, std::array<std::array<uint32_t, 4>, 6>& hexTets) const;
+
+  // The tets are stored in a spatially coherent order, and grouped in to chunks of consecutive tets with bounding
+  // boxes. Slice planes only submit the chunks they cross, re-querying them when the plane moves.
+  struct TetChunk {
+    std::tuple<glm::vec3, glm::vec3> objectSpaceBoundingBox;
+    size_t tetStart;
+    size_t tetCount;
+  };
+  struct SliceTetQuery {
+    bool isValid = false;
+    glm::vec3 sliceVector;
+    float slicePoint;
+    std::vector<std::array<size_t, 2>> tetRanges; // {first, count} tets to draw
+  };
+  static const size_t tetsPerChunk;
+  std::vector<TetChunk> tetChunks; // lazily computed, empty if out of date
+  std::shared_ptr<render::AttributeBuffer> tetDrawOrder; // identity order over the tets, for drawSubset()
+  std::unordered_map<polyscope::SlicePlane*, SliceTetQuery> sliceTetQueries;
+  void computeTetChunks();
+  void invalidateTetChunks();
+
   void fillGeometryBuffersFlat(render::ShaderProgram& p);
 
   // stencils for looping over cells
@@ -90,6 +90,7 @@ void VolumeMesh::updateVertexPositions(const V& newPositions) {
   vertexPositions.data = standardizeVectorArray<glm::vec3, 3>(newPositions);
   vertexPositions.markHostBufferUpdated();
   geometryChanged();
+  refitObjectSpaceBounds(vertexPositions.data);
 }
 
 
@@ -11,6 +11,10 @@
 #include "polyscope/scalar_quantity.h"
 #include "polyscope/volume_mesh.h"
 
+#include <array>
+#include <future>
+#include <memory>
+
 namespace polyscope {
 
 class VolumeMeshScalarQuantity : public VolumeMeshQuantity, public ScalarQuantity<VolumeMeshScalarQuantity> {
@@ -60,11 +64,50 @@ public:
   void buildVertexInfoGUI(size_t vInd) override;
   virtual void refresh() override;
 
+  // The level set surface as a triangle mesh, with the values of the shown quantity at its vertices. Vertices on the
+  // same tet edge are shared.
+  struct LevelSetMesh {
+    std::vector<glm::vec3> vertices;
+    std::vector<float> values;
+    std::vector<uint32_t> indices; // triangles, facing towards increasing field values
+  };
+
+  // Extract the surface where fieldValues == level by marching tets, in parallel. colorValues are interpolated to the
+  // vertices. Tets with non-finite field values are skipped.
+  static LevelSetMesh extractLevelSet(const std::vector<glm::vec3>& positions,
+                                      const std::vector<std::array<uint32_t, 4>>& tets,
+                                      const std::vector<float>& fieldValues, const std::vector<float>& colorValues,
+                                      float level);
+
+  // Draw the level set from a cached triangle mesh rather than slicing every tet in a geometry shader each frame. The
+  // mesh is extracted again on a background thread when the level or the data changes, and the previous one is drawn
+  // until it is done.
+  VolumeMeshVertexScalarQuantity* setLevelSetCached(bool newVal);
+  bool getLevelSetCached();
+
   // TODO make these persistent values
 
   float levelSetValue;
   bool isDrawingLevelSet;
   VolumeMeshVertexScalarQuantity* showQuantity;
+
+protected:
+  PersistentValue<bool> levelSetCached;
+
+  // The inputs of an extraction, copied so that the quantities can change while it runs
+  struct LevelSetSnapshot;
+  std::shared_ptr<const LevelSetSnapshot> levelSetSnapshot; // of the current data
+  std::shared_ptr<const LevelSetSnapshot> levelSetExtractionSnapshot;
+  float levelSetExtractionValue = 0.;
+  std::future<LevelSetMesh> levelSetExtraction; // the background extraction, if one is running
+
+  LevelSetMesh cachedLevelSetMesh;
+  std::shared_ptr<const LevelSetSnapshot> cachedLevelSetSnapshot; // what cachedLevelSetMesh was extracted from
+  float cachedLevelSetValue = 0.;
+  std::shared_ptr<render::ShaderProgram> cachedLevelSetProgram;
+
+  void ensureLevelSetSnapshotCurrent();
+  void drawCachedLevelSet();
 };
 
 
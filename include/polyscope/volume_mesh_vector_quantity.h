@@ -22,6 +22,9 @@ class VolumeMeshVectorQuantity : public VolumeMeshQuantity {
 public:
   VolumeMeshVectorQuantity(std::string name, VolumeMesh& mesh_, VolumeMeshElement definedOn_);
 
+  // vectors may extend arbitrarily far beyond the mesh
+  virtual bool drawsWithinStructureBounds() override;
+
 protected:
   VolumeMeshElement definedOn;
 };
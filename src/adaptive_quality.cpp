@@ -0,0 +1,98 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/adaptive_quality.h"
+
+#include "polyscope/options.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/recorder.h"
+#include "polyscope/render/engine.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace polyscope {
+
+namespace {
+
+// Scene resolution at each reduced level, relative to the window (level 1 is the first entry)
+const float reducedLevelResolution[] = {1., .75, .5, .35};
+const int nReducedLevels = sizeof(reducedLevelResolution) / sizeof(reducedLevelResolution[0]);
+
+// Frames to wait after a level change before judging the frame time again, so the average catches up
+const int framesPerLevelChange = 3;
+
+struct AdaptiveQualityState {
+  int level = 0;
+  int framesAtLevel = 0;
+  bool interactionSeen = false;
+  std::chrono::steady_clock::time_point lastInteraction;
+  bool frameSeen = false;
+  std::chrono::steady_clock::time_point lastFrame;
+  double averageFrameMs = 0.;
+};
+
+AdaptiveQualityState quality;
+
+void setAdaptiveQualityLevel(int newLevel) {
+  // the engine scales its SSAA buffers, so undo the SSAA factor to get the effective resolution
+  float scale = 1.;
+  if (newLevel > 0) {
+    scale = reducedLevelResolution[newLevel - 1] / render::engine->getSSAAFactor();
+  }
+  render::engine->setSceneResolutionScale(scale);
+
+  if (newLevel != quality.level) {
+    quality.level = newLevel;
+    quality.framesAtLevel = 0;
+    requestRedraw();
+  }
+}
+
+} // namespace
+
+void markCameraInteraction() {
+  quality.interactionSeen = true;
+  quality.lastInteraction = std::chrono::steady_clock::now();
+}
+
+void updateAdaptiveQuality() {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (quality.frameSeen) {
+    double frameMs = std::chrono::duration<double, std::milli>(now - quality.lastFrame).count();
+    quality.averageFrameMs = 0.8 * quality.averageFrameMs + 0.2 * frameMs;
+  }
+  quality.frameSeen = true;
+  quality.lastFrame = now;
+  quality.framesAtLevel++;
+
+  bool interacting = options::adaptiveQuality && quality.interactionSeen && !isRecording() &&
+                     std::chrono::duration<float>(now - quality.lastInteraction).count() <
+                         options::adaptiveQualityRestoreDelay;
+
+  if (!interacting) {
+    if (quality.level != 0) setAdaptiveQualityLevel(0);
+    return;
+  }
+
+  // step down while frames are too slow, and back up (but not to full quality) when there is plenty of headroom
+  int newLevel = quality.level;
+  if (quality.framesAtLevel >= framesPerLevelChange) {
+    if (quality.averageFrameMs > options::adaptiveQualityTargetFrameMs) {
+      newLevel = std::min(quality.level + 1, nReducedLevels);
+    } else if (quality.level > 1 && quality.averageFrameMs < 0.5 * options::adaptiveQualityTargetFrameMs) {
+      newLevel = quality.level - 1;
+    }
+  }
+  if (newLevel > 0) setAdaptiveQualityLevel(newLevel); // also follows changes to the SSAA factor
+}
+
+bool adaptiveQualityIsReduced() { return quality.level > 0; }
+
+int getAdaptiveQualityLevel() { return quality.level; }
+
+int adaptiveQualityRenderPasses() {
+  if (adaptiveQualityIsReduced()) return std::min(options::transparencyRenderPasses, 1);
+  return options::transparencyRenderPasses;
+}
+
+} // namespace polyscope
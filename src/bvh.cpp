@@ -0,0 +1,329 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/bvh.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <utility>
+
+namespace polyscope {
+
+namespace {
+
+const uint32_t maxLeafSize = 16; // ranges at most this large may become a leaf if splitting does not pay off
+const uint32_t minLeafSize = 2;  // ranges at most this large always become a leaf
+const size_t nSAHBins = 16;
+
+BVH::Box emptyBox() {
+  float inf = std::numeric_limits<float>::infinity();
+  return BVH::Box{glm::vec3{inf, inf, inf}, glm::vec3{-inf, -inf, -inf}};
+}
+
+void expandBox(BVH::Box& box, const BVH::Box& other) {
+  box.min = glm::min(box.min, other.min);
+  box.max = glm::max(box.max, other.max);
+}
+
+// (half of) the surface area, which is all the heuristic needs
+float boxArea(const BVH::Box& box) {
+  glm::vec3 d = box.max - box.min;
+  if (d.x < 0 || d.y < 0 || d.z < 0) return 0.;
+  return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+} // namespace
+
+void BVH::build(const std::vector<Box>& primBoxes) {
+  clear();
+  size_t nPrims = primBoxes.size();
+  if (nPrims == 0) return;
+  if (nPrims >= std::numeric_limits<uint32_t>::max()) {
+    exception("BVH: too many primitives");
+    return;
+  }
+
+  primOrder.resize(nPrims);
+  std::iota(primOrder.begin(), primOrder.end(), 0);
+
+  std::vector<glm::vec3> centroids(nPrims);
+  parallelFor(0, nPrims, [&](size_t chunkBegin, size_t chunkEnd) {
+    for (size_t i = chunkBegin; i < chunkEnd; i++) {
+      centroids[i] = 0.5f * (primBoxes[i].min + primBoxes[i].max);
+    }
+  });
+
+  // Split the upper levels here, until the ranges are small enough to give each thread several of them
+  size_t nThreads = getNumThreads();
+  size_t deferSize = nThreads > 1 ? std::max<size_t>(nPrims / (4 * nThreads), 4096) : 0;
+  std::vector<DeferredRange> deferred;
+  nodes.push_back(Node{});
+  buildRange(primBoxes, centroids, nodes, 0, 0, static_cast<uint32_t>(nPrims), deferSize, deferred);
+  if (deferred.empty()) return;
+
+  // Build the subtrees in parallel, each into its own array. The ranges of primOrder they reorder are disjoint.
+  std::vector<std::vector<Node>> subtrees(deferred.size());
+  parallelForTiles(0, deferred.size(), 1, 0, [&](size_t tileBegin, size_t tileEnd) {
+    for (size_t i = tileBegin; i < tileEnd; i++) {
+      std::vector<DeferredRange> none;
+      subtrees[i].push_back(Node{});
+      buildRange(primBoxes, centroids, subtrees[i], 0, deferred[i].start, deferred[i].end, 0, none);
+    }
+  });
+
+  // Splice them in, the subtree root replaces the placeholder node and the rest is appended
+  for (size_t i = 0; i < deferred.size(); i++) {
+    std::vector<Node>& sub = subtrees[i];
+    uint32_t offset = static_cast<uint32_t>(nodes.size()) - 1; // subtree node j > 0 lands at offset + j
+    for (Node& n : sub) {
+      if (n.count == 0) n.first += offset;
+    }
+    nodes[deferred[i].nodeInd] = sub[0];
+    nodes.insert(nodes.end(), sub.begin() + 1, sub.end());
+  }
+}
+
+void BVH::buildRange(const std::vector<Box>& primBoxes, const std::vector<glm::vec3>& centroids,
+                     std::vector<Node>& out, uint32_t rootInd, uint32_t start, uint32_t end, size_t deferSize,
+                     std::vector<DeferredRange>& deferred) {
+
+  std::vector<DeferredRange> todo{{rootInd, start, end}};
+  while (!todo.empty()) {
+    DeferredRange task = todo.back();
+    todo.pop_back();
+    uint32_t count = task.end - task.start;
+
+    Box bounds = emptyBox();
+    Box centroidBounds = emptyBox();
+    for (uint32_t i = task.start; i < task.end; i++) {
+      uint32_t iPrim = primOrder[i];
+      expandBox(bounds, primBoxes[iPrim]);
+      expandBox(centroidBounds, Box{centroids[iPrim], centroids[iPrim]});
+    }
+    out[task.nodeInd] = Node{bounds, task.start, count};
+
+    if (count <= minLeafSize) continue;
+    if (count <= deferSize) {
+      deferred.push_back(task);
+      continue;
+    }
+
+    // Bin the centroids along the axis where they are most spread out
+    glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+    if (!(extent[axis] > 0.)) continue; // all centroids coincide, nothing to split
+    float binScale = nSAHBins / extent[axis];
+    float binLow = centroidBounds.min[axis];
+    auto binOf = [&](uint32_t iPrim) {
+      size_t bin = static_cast<size_t>((centroids[iPrim][axis] - binLow) * binScale);
+      return std::min(bin, nSAHBins - 1);
+    };
+
+    std::array<Box, nSAHBins> binBoxes;
+    std::array<uint32_t, nSAHBins> binCounts;
+    binBoxes.fill(emptyBox());
+    binCounts.fill(0);
+    for (uint32_t i = task.start; i < task.end; i++) {
+      uint32_t iPrim = primOrder[i];
+      size_t bin = binOf(iPrim);
+      expandBox(binBoxes[bin], primBoxes[iPrim]);
+      binCounts[bin]++;
+    }
+
+    // Sweep from the right to get the cost of everything above each split, then from the left to find the best one
+    std::array<float, nSAHBins> rightCost;
+    Box accum = emptyBox();
+    uint32_t accumCount = 0;
+    for (size_t b = nSAHBins - 1; b > 0; b--) {
+      expandBox(accum, binBoxes[b]);
+      accumCount += binCounts[b];
+      rightCost[b] = accumCount > 0 ? boxArea(accum) * accumCount : 0.f;
+    }
+    float bestCost = std::numeric_limits<float>::infinity();
+    size_t bestSplit = 0; // bins [0, bestSplit] go left
+    accum = emptyBox();
+    accumCount = 0;
+    for (size_t b = 0; b + 1 < nSAHBins; b++) {
+      expandBox(accum, binBoxes[b]);
+      accumCount += binCounts[b];
+      if (accumCount == 0 || accumCount == count) continue;
+      float cost = boxArea(accum) * accumCount + rightCost[b + 1];
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestSplit = b;
+      }
+    }
+
+    // Compare to the cost of testing every primitive, with a traversal step costing about as much as one test
+    float area = boxArea(bounds);
+    if (count <= maxLeafSize && area > 0. && 1.f + bestCost / area >= count) continue;
+
+    uint32_t* mid = std::partition(&primOrder[task.start], &primOrder[task.start] + count,
+                                   [&](uint32_t iPrim) { return binOf(iPrim) <= bestSplit; });
+    uint32_t split = static_cast<uint32_t>(mid - &primOrder[0]);
+
+    uint32_t left = static_cast<uint32_t>(out.size());
+    out.push_back(Node{});
+    out.push_back(Node{});
+    out[task.nodeInd] = Node{bounds, left, 0};
+    todo.push_back(DeferredRange{left + 1, split, task.end});
+    todo.push_back(DeferredRange{left, task.start, split});
+  }
+}
+
+void BVH::refit(const std::vector<Box>& primBoxes) {
+  if (primBoxes.size() != primOrder.size()) {
+    exception("BVH: refit with " + std::to_string(primBoxes.size()) + " primitives, but it was built with " +
+              std::to_string(primOrder.size()));
+    return;
+  }
+
+  // Leaves are independent, interior nodes then follow bottom-up
+  parallelFor(0, nodes.size(), [&](size_t chunkBegin, size_t chunkEnd) {
+    for (size_t iNode = chunkBegin; iNode < chunkEnd; iNode++) {
+      Node& node = nodes[iNode];
+      if (node.count == 0) continue;
+      node.box = emptyBox();
+      for (uint32_t i = node.first; i < node.first + node.count; i++) {
+        expandBox(node.box, primBoxes[primOrder[i]]);
+      }
+    }
+  });
+  for (size_t iNode = nodes.size(); iNode-- > 0;) {
+    Node& node = nodes[iNode];
+    if (node.count != 0) continue;
+    node.box = nodes[node.first].box;
+    expandBox(node.box, nodes[node.first + 1].box);
+  }
+}
+
+void BVH::clear() {
+  nodes.clear();
+  primOrder.clear();
+}
+
+bool BVH::isBuilt() const { return !nodes.empty(); }
+
+size_t BVH::nPrimitives() const { return primOrder.size(); }
+
+size_t BVH::getMemoryBytes() const { return nodes.capacity() * sizeof(Node) + primOrder.capacity() * sizeof(uint32_t); }
+
+bool BVH::rayCast(glm::vec3 start, glm::vec3 dir, float& tMax,
+                  const std::function<bool(size_t iPrim, float& tMax)>& intersectPrim, float boxPadding) const {
+  if (nodes.empty()) return false;
+
+  glm::vec3 invDir = 1.f / dir;
+
+  // Entry parameter of the ray into a box, or infinity if it misses within [0, tMax]
+  auto boxEntry = [&](const Box& box) {
+    glm::vec3 t0 = (box.min - boxPadding - start) * invDir;
+    glm::vec3 t1 = (box.max + boxPadding - start) * invDir;
+    glm::vec3 tLow = glm::min(t0, t1);
+    glm::vec3 tHigh = glm::max(t0, t1);
+    float tEnter = std::max(std::max(tLow.x, tLow.y), std::max(tLow.z, 0.f));
+    float tExit = std::min(std::min(tHigh.x, tHigh.y), std::min(tHigh.z, tMax));
+    return tEnter <= tExit ? tEnter : std::numeric_limits<float>::infinity();
+  };
+
+  bool hit = false;
+  std::vector<std::pair<uint32_t, float>> stack;
+  stack.reserve(64);
+  float rootEntry = boxEntry(nodes[0].box);
+  if (rootEntry <= tMax) stack.emplace_back(0, rootEntry);
+
+  while (!stack.empty()) {
+    std::pair<uint32_t, float> entry = stack.back();
+    stack.pop_back();
+    if (entry.second > tMax) continue; // a closer hit was found since this was pushed
+
+    const Node& node = nodes[entry.first];
+    if (node.count > 0) {
+      for (uint32_t i = node.first; i < node.first + node.count; i++) {
+        if (intersectPrim(primOrder[i], tMax)) hit = true;
+      }
+      continue;
+    }
+
+    // Push the farther child first, so the nearer one is visited first
+    float tLeft = boxEntry(nodes[node.first].box);
+    float tRight = boxEntry(nodes[node.first + 1].box);
+    std::pair<uint32_t, float> near{node.first, tLeft};
+    std::pair<uint32_t, float> far{node.first + 1, tRight};
+    if (tRight < tLeft) std::swap(near, far);
+    if (far.second <= tMax) stack.push_back(far);
+    if (near.second <= tMax) stack.push_back(near);
+  }
+
+  return hit;
+}
+
+bool rayTriangleIntersection(glm::vec3 start, glm::vec3 dir, glm::vec3 pA, glm::vec3 pB, glm::vec3 pC, float& t,
+                             glm::vec3& barycoords) {
+  // Moller-Trumbore, hits from both sides
+  glm::vec3 eAB = pB - pA;
+  glm::vec3 eAC = pC - pA;
+  glm::vec3 p = glm::cross(dir, eAC);
+  float det = glm::dot(eAB, p);
+  if (det == 0.) return false;
+  float invDet = 1.f / det;
+  glm::vec3 s = start - pA;
+  float u = glm::dot(s, p) * invDet;
+  if (u < 0. || u > 1.) return false;
+  glm::vec3 q = glm::cross(s, eAB);
+  float v = glm::dot(dir, q) * invDet;
+  if (v < 0. || u + v > 1.) return false;
+  float tHit = glm::dot(eAC, q) * invDet;
+  if (!(tHit >= 0.)) return false;
+  t = tHit;
+  barycoords = glm::vec3{1.f - u - v, u, v};
+  return true;
+}
+
+bool raySphereIntersection(glm::vec3 start, glm::vec3 dir, glm::vec3 center, float radius, float& t) {
+  glm::vec3 oc = start - center;
+  float a = glm::dot(dir, dir);
+  float b = glm::dot(oc, dir);
+  float c = glm::dot(oc, oc) - radius * radius;
+  float disc = b * b - a * c;
+  if (a == 0. || disc < 0.) return false;
+  float sq = std::sqrt(disc);
+  float tHit = (-b - sq) / a;
+  if (tHit < 0.) tHit = (-b + sq) / a; // starting inside the sphere
+  if (!(tHit >= 0.)) return false;
+  t = tHit;
+  return true;
+}
+
+bool rayCylinderIntersection(glm::vec3 start, glm::vec3 dir, glm::vec3 pA, glm::vec3 pB, float radius, float& t) {
+  // The open side of the cylinder, the ends are usually covered by spheres
+  glm::vec3 axis = pB - pA;
+  float axisLen2 = glm::dot(axis, axis);
+  if (axisLen2 == 0.) return false;
+  glm::vec3 ao = start - pA;
+  glm::vec3 dPerp = dir - axis * (glm::dot(dir, axis) / axisLen2);
+  glm::vec3 oPerp = ao - axis * (glm::dot(ao, axis) / axisLen2);
+  float a = glm::dot(dPerp, dPerp);
+  float b = glm::dot(oPerp, dPerp);
+  float c = glm::dot(oPerp, oPerp) - radius * radius;
+  float disc = b * b - a * c;
+  if (a == 0. || disc < 0.) return false;
+  float sq = std::sqrt(disc);
+  for (float tHit : {(-b - sq) / a, (-b + sq) / a}) {
+    if (!(tHit >= 0.)) continue;
+    float s = glm::dot(ao + tHit * dir, axis) / axisLen2;
+    if (s < 0. || s > 1.) continue;
+    t = tHit;
+    return true;
+  }
+  return false;
+}
+
+} // namespace polyscope
@@ -0,0 +1,135 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/camera_path.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/screenshot.h"
+
+#include "glm/gtx/quaternion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace polyscope {
+
+namespace {
+
+// Catmull-Rom tangent of a keyframe value, for unevenly spaced keys, one-sided at the ends
+template <typename K, typename F>
+auto catmullRomTangent(const std::vector<K>& keys, size_t i, F value) -> decltype(value(keys[i])) {
+  size_t iPrev = i > 0 ? i - 1 : i;
+  size_t iNext = std::min(i + 1, keys.size() - 1);
+  float dt = keys[iNext].time - keys[iPrev].time;
+  if (!(dt > 0.f)) return value(keys[i]) * 0.f;
+  return (value(keys[iNext]) - value(keys[iPrev])) / dt;
+}
+
+// Cubic Hermite interpolation of a keyframe value over the segment [k0, k1], at s in [0, 1]
+template <typename K, typename F>
+auto hermite(const std::vector<K>& keys, size_t k0, size_t k1, float s, F value) -> decltype(value(keys[k0])) {
+  float h = keys[k1].time - keys[k0].time;
+  float s2 = s * s;
+  float s3 = s2 * s;
+  return (2.f * s3 - 3.f * s2 + 1.f) * value(keys[k0]) + (s3 - 2.f * s2 + s) * h * catmullRomTangent(keys, k0, value) +
+         (-2.f * s3 + 3.f * s2) * value(keys[k1]) + (s3 - s2) * h * catmullRomTangent(keys, k1, value);
+}
+
+} // namespace
+
+void CameraPath::addKeyframe(float time, const CameraParameters& camera) {
+  if (!keyframes.empty() && !(time > keyframes.back().time)) {
+    exception("camera path keyframes must be added in order of increasing time");
+  }
+
+  Keyframe k;
+  k.time = time;
+  k.position = camera.getPosition();
+  k.rotation = glm::normalize(glm::quat_cast(camera.getR()));
+  k.fovVerticalDegrees = camera.getFoVVerticalDegrees();
+  k.aspectRatioWidthOverHeight = camera.getAspectRatioWidthOverHeight();
+
+  // q and -q are the same rotation, take the one nearest the previous keyframe so the spline turns the short way
+  if (!keyframes.empty() && glm::dot(keyframes.back().rotation, k.rotation) < 0.f) {
+    k.rotation = -k.rotation;
+  }
+
+  keyframes.push_back(k);
+}
+
+void CameraPath::clear() { keyframes.clear(); }
+
+size_t CameraPath::getKeyframeCount() const { return keyframes.size(); }
+
+float CameraPath::getDuration() const {
+  if (keyframes.empty()) return 0.f;
+  return keyframes.back().time - keyframes.front().time;
+}
+
+CameraParameters CameraPath::evaluate(float time) const {
+  if (keyframes.empty()) {
+    exception("cannot evaluate a camera path without keyframes");
+  }
+
+  // The segment [k, k+1] containing the time
+  size_t nKeys = keyframes.size();
+  time = glm::clamp(time, keyframes.front().time, keyframes.back().time);
+  size_t k = 0;
+  while (k + 2 < nKeys && time > keyframes[k + 1].time) k++;
+  size_t kNext = std::min(k + 1, nKeys - 1);
+  const Keyframe& k0 = keyframes[k];
+  const Keyframe& k1 = keyframes[kNext];
+
+  float h = k1.time - k0.time;
+  float s = h > 0.f ? (time - k0.time) / h : 0.f;
+
+  glm::vec3 position = hermite(keyframes, k, kNext, s, [](const Keyframe& f) { return f.position; });
+  float fov = hermite(keyframes, k, kNext, s, [](const Keyframe& f) { return f.fovVerticalDegrees; });
+  float aspect = hermite(keyframes, k, kNext, s, [](const Keyframe& f) { return f.aspectRatioWidthOverHeight; });
+
+  // Squad between the keyframe orientations, with the usual inner control points
+  auto control = [&](size_t i) -> glm::quat {
+    if (i == 0 || i + 1 >= nKeys) return keyframes[i].rotation;
+    return glm::intermediate(keyframes[i - 1].rotation, keyframes[i].rotation, keyframes[i + 1].rotation);
+  };
+  glm::quat rotation = glm::normalize(glm::squad(k0.rotation, k1.rotation, control(k), control(kNext), s));
+
+  glm::mat3 R = glm::mat3_cast(rotation);
+  glm::mat4 E(R);
+  E[3] = glm::vec4(-(R * position), 1.f);
+
+  return CameraParameters(CameraIntrinsics::fromFoVDegVerticalAndAspect(fov, aspect), CameraExtrinsics::fromMatrix(E));
+}
+
+size_t CameraPath::getFrameCount(float framesPerSecond) const {
+  if (keyframes.empty()) return 0;
+  if (!(framesPerSecond > 0.f)) {
+    exception("camera path frame rate must be positive");
+  }
+  return static_cast<size_t>(std::floor(getDuration() * framesPerSecond + 1e-3f)) + 1;
+}
+
+CameraParameters CameraPath::evaluateFrame(size_t frameIndex, float framesPerSecond) const {
+  if (!(framesPerSecond > 0.f)) {
+    exception("camera path frame rate must be positive");
+  }
+  // from the index rather than accumulated steps, so that long paths do not drift
+  return evaluate(keyframes.empty() ? 0.f : keyframes.front().time + frameIndex / framesPerSecond);
+}
+
+void renderCameraPath(const CameraPath& path, float framesPerSecond, std::string filenamePrefix,
+                      std::string extension, bool transparentBG) {
+  size_t nFrames = path.getFrameCount(framesPerSecond);
+
+  std::vector<BatchRenderView> views;
+  views.reserve(nFrames);
+  for (size_t i = 0; i < nFrames; i++) {
+    char indexStr[32];
+    std::snprintf(indexStr, sizeof(indexStr), "%06zu", i);
+    views.push_back(BatchRenderView{path.evaluateFrame(i, framesPerSecond), filenamePrefix + indexStr + extension});
+  }
+
+  renderBatch(views, transparentBG);
+}
+
+} // namespace polyscope
@@ -78,11 +78,11 @@ void CameraView::draw() {
   render::engine->applyTransparencySettings();
 
   // Draw the quantities
-  for (auto& x : quantities) {
-    x.second->draw();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->draw();
   }
-  for (auto& x : floatingQuantities) {
-    x.second->draw();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->draw();
   }
 }
 
@@ -91,11 +91,11 @@ void CameraView::drawDelayed() {
     return;
   }
 
-  for (auto& x : quantities) {
-    x.second->drawDelayed();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->drawDelayed();
   }
-  for (auto& x : floatingQuantities) {
-    x.second->drawDelayed();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->drawDelayed();
   }
 }
 
@@ -229,7 +229,6 @@ void CameraView::fillCameraWidgetGeometry(render::ShaderProgram* nodeProgram, re
 
     std::vector<glm::vec3> positions;
     std::vector<glm::vec3> normals;
-    std::vector<glm::vec3> bcoord;
     std::vector<glm::vec3> cullPos;
 
     auto addPolygon = [&](std::vector<glm::vec3> vertices) {
@@ -252,11 +251,6 @@ void CameraView::fillCameraWidgetGeometry(render::ShaderProgram* nodeProgram, re
         normals.push_back(faceN);
         normals.push_back(faceN);
 
-        // Bary coords
-        bcoord.push_back(glm::vec3{1., 0., 0.});
-        bcoord.push_back(glm::vec3{0., 1., 0.});
-        bcoord.push_back(glm::vec3{0., 0., 1.});
-
         // Cull position
         cullPos.push_back(root);
         cullPos.push_back(root);
@@ -278,7 +272,6 @@ void CameraView::fillCameraWidgetGeometry(render::ShaderProgram* nodeProgram, re
       // // this is not actually used, but it only gets optimized out on some platforms, not all
       pickFrameProgram->setAttribute("a_vertexNormals", normals);
     }
-    pickFrameProgram->setAttribute("a_barycoord", bcoord);
 
     size_t nFaces = 7;
     std::vector<glm::vec3> faceColor(3 * nFaces, pickColor);
@@ -393,6 +386,8 @@ void CameraView::updateObjectSpaceBounds() {
   objectSpaceLengthScale = 0.;
 }
 
+bool CameraView::allowFrustumCulling() { return false; }
+
 
 std::string CameraView::typeName() { return structureTypeName; }
 
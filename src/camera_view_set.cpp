@@ -0,0 +1,445 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/camera_view_set.h"
+
+#include "polyscope/parallel.h"
+#include "polyscope/pick.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/view.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace polyscope {
+
+// Initialize statics
+const std::string CameraViewSet::structureTypeName = "Camera View Set";
+const size_t CameraViewSet::nodesPerCamera;
+const size_t CameraViewSet::edgesPerCamera;
+
+namespace {
+
+// The shared per-vertex geometry of the instanced edges, a triangle strip over a box. (x, y) across the edge, (z) from
+// tail to tip.
+// NOTE: duplicated from curve_network.cpp
+std::vector<glm::vec3> cylinderBoxCorners() {
+  const int stripCorners[14] = {6, 7, 4, 5, 1, 7, 3, 6, 2, 4, 0, 1, 2, 3};
+  std::vector<glm::vec3> corners;
+  for (int c : stripCorners) {
+    corners.emplace_back((c & 1) ? 1. : -1., (c & 2) ? 1. : -1., (c & 4) ? 1. : 0.);
+  }
+  return corners;
+}
+
+} // namespace
+
+// Constructor
+CameraViewSet::CameraViewSet(std::string name, const std::vector<CameraParameters>& params_)
+    : QuantityStructure<CameraViewSet>(name, structureTypeName),
+      nodePositions(this, uniquePrefix() + "nodePositions", nodePositionsData),
+      edgeTailPositions(this, uniquePrefix() + "edgeTailPositions", edgeTailPositionsData),
+      edgeTipPositions(this, uniquePrefix() + "edgeTipPositions", edgeTipPositionsData), params(params_),
+      widgetFocalLength(uniquePrefix() + "#widgetFocalLength", relativeValue(0.05)),
+      widgetThickness(uniquePrefix() + "#widgetThickness", 0.02),
+      widgetColor(uniquePrefix() + "#widgetColor", glm::vec3{0., 0., 0.}) {
+
+  computeWidgetGeometry();
+  updateObjectSpaceBounds();
+}
+
+size_t CameraViewSet::nCameras() const { return params.size(); }
+
+void CameraViewSet::draw() {
+  if (!isEnabled() || nCameras() == 0) {
+    return;
+  }
+
+  // Ensure we have prepared buffers
+  if (nodeProgram == nullptr || edgeProgram == nullptr) {
+    prepare();
+  }
+
+  // The frame geometry depends on the scene length scale, regenerate it if the length scale has changed
+  if (preparedLengthScale != state::lengthScale) {
+    computeWidgetGeometry();
+  }
+
+  // Set program uniforms
+  setStructureUniforms(*nodeProgram);
+  setStructureUniforms(*edgeProgram);
+  setWidgetUniforms(*nodeProgram, *edgeProgram);
+  nodeProgram->setUniform("u_baseColor", widgetColor.get());
+  edgeProgram->setUniform("u_baseColor", widgetColor.get());
+  render::engine->setMaterialUniforms(*nodeProgram, material);
+  render::engine->setMaterialUniforms(*edgeProgram, material);
+
+  // Draw the wireframes of all cameras
+  edgeProgram->draw();
+  nodeProgram->draw();
+
+  // Draw the quantities
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->draw();
+  }
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->draw();
+  }
+}
+
+void CameraViewSet::drawDelayed() {
+  if (!isEnabled()) {
+    return;
+  }
+
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->drawDelayed();
+  }
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->drawDelayed();
+  }
+}
+
+void CameraViewSet::drawPick() {
+  if (!isEnabled() || nCameras() == 0) {
+    return;
+  }
+
+  // Ensure we have prepared buffers
+  if (nodePickProgram == nullptr || edgePickProgram == nullptr) {
+    preparePick();
+  }
+
+  if (preparedLengthScale != state::lengthScale) {
+    computeWidgetGeometry();
+  }
+
+  // Set uniforms
+  setStructureUniforms(*nodePickProgram);
+  setStructureUniforms(*edgePickProgram);
+  setWidgetUniforms(*nodePickProgram, *edgePickProgram);
+
+  edgePickProgram->draw();
+  nodePickProgram->draw();
+}
+
+void CameraViewSet::setWidgetUniforms(render::ShaderProgram& nodeP, render::ShaderProgram& edgeP) {
+  glm::mat4 P = view::getCameraPerspectiveMatrix();
+  glm::mat4 Pinv = glm::inverse(P);
+  float radius = getWidgetFocalLength() * getWidgetThickness();
+
+  nodeP.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
+  nodeP.setUniform("u_viewport", render::engine->getCurrentViewport());
+  nodeP.setUniform("u_pointRadius", radius);
+
+  edgeP.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
+  edgeP.setUniform("u_viewport", render::engine->getCurrentViewport());
+  edgeP.setUniform("u_radius", radius);
+  if (edgeP.hasUniform("u_lineLODPixelRadius")) {
+    // distant cameras are drawn as thin lines rather than cylinders too thin to hit any pixels
+    edgeP.setUniform("u_lineLODPixelRadius", 0.5f);
+  }
+}
+
+std::vector<std::string> CameraViewSet::addCameraViewSetNodeRules(std::vector<std::string> initRules) {
+  initRules = addStructureRules(initRules);
+  if (wantsCullPosition()) initRules.push_back("SPHERE_CULLPOS_FROM_CENTER");
+  return initRules;
+}
+
+std::vector<std::string> CameraViewSet::addCameraViewSetEdgeRules(std::vector<std::string> initRules) {
+  initRules = addStructureRules(initRules);
+  if (wantsCullPosition()) initRules.push_back("CYLINDER_CULLPOS_FROM_MID");
+  return initRules;
+}
+
+void CameraViewSet::prepare() {
+  // The nodes are point splats and the edges instanced cylinders, neither needs a geometry shader
+  nodeProgram = render::engine->requestShader(
+      "POINT_SPLAT", render::engine->addMaterialRules(material, addCameraViewSetNodeRules({"SHADE_BASECOLOR"})));
+  edgeProgram = render::engine->requestShader(
+      "RAYCAST_CYLINDER_INSTANCED",
+      render::engine->addMaterialRules(material, addCameraViewSetEdgeRules({"SHADE_BASECOLOR"})));
+
+  render::engine->setMaterial(*nodeProgram, material);
+  render::engine->setMaterial(*edgeProgram, material);
+
+  fillNodeGeometryBuffers(*nodeProgram);
+  fillEdgeGeometryBuffers(*edgeProgram);
+}
+
+void CameraViewSet::preparePick() {
+
+  // Request pick indices, one for each camera
+  pickStart = pick::requestPickBufferRange(this, nCameras());
+
+  { // Nodes, colored by the pick index of their camera
+    nodePickProgram = render::engine->requestShader("POINT_SPLAT", addCameraViewSetNodeRules({"SPLAT_PROPAGATE_COLOR"}),
+                                                    render::ShaderReplacementDefaults::Pick);
+
+    std::vector<glm::vec3> pickColors(nodesPerCamera * nCameras());
+    parallelFor(0, nCameras(), [&](size_t begin, size_t end) {
+      for (size_t iC = begin; iC < end; iC++) {
+        glm::vec3 color = pick::indToVec(pickStart + iC);
+        std::fill(pickColors.begin() + nodesPerCamera * iC, pickColors.begin() + nodesPerCamera * (iC + 1), color);
+      }
+    });
+    nodePickProgram->setAttribute("a_color", pickColors);
+
+    fillNodeGeometryBuffers(*nodePickProgram);
+  }
+
+  { // Edges, likewise. The whole edge picks the camera, so the end and middle colors are the same.
+    edgePickProgram = render::engine->requestShader("RAYCAST_CYLINDER_INSTANCED",
+                                                    addCameraViewSetEdgeRules({"CYLINDER_INSTANCED_PROPAGATE_PICK"}),
+                                                    render::ShaderReplacementDefaults::Pick);
+
+    std::vector<glm::vec3> pickColors(edgesPerCamera * nCameras());
+    parallelFor(0, nCameras(), [&](size_t begin, size_t end) {
+      for (size_t iC = begin; iC < end; iC++) {
+        glm::vec3 color = pick::indToVec(pickStart + iC);
+        std::fill(pickColors.begin() + edgesPerCamera * iC, pickColors.begin() + edgesPerCamera * (iC + 1), color);
+      }
+    });
+    edgePickProgram->setAttribute("a_color_tail", pickColors);
+    edgePickProgram->setAttribute("a_color_tip", pickColors);
+    edgePickProgram->setAttribute("a_color_edge", pickColors);
+
+    fillEdgeGeometryBuffers(*edgePickProgram);
+  }
+}
+
+void CameraViewSet::fillNodeGeometryBuffers(render::ShaderProgram& p) {
+  p.setAttribute("a_position", nodePositions.getRenderAttributeBuffer());
+}
+
+void CameraViewSet::fillEdgeGeometryBuffers(render::ShaderProgram& p) {
+  p.setAttribute("a_position_tail", edgeTailPositions.getRenderAttributeBuffer());
+  p.setAttribute("a_position_tip", edgeTipPositions.getRenderAttributeBuffer());
+  p.setAttribute("a_boxCorner", cylinderBoxCorners());
+  p.setInstanceCount(static_cast<uint32_t>(edgesPerCamera * nCameras()));
+}
+
+void CameraViewSet::computeWidgetGeometry() {
+
+  nodePositions.data.resize(nodesPerCamera * nCameras());
+  edgeTailPositions.data.resize(edgesPerCamera * nCameras());
+  edgeTipPositions.data.resize(edgesPerCamera * nCameras());
+
+  float focalLength = widgetFocalLength.get().asAbsolute();
+
+  parallelFor(0, nCameras(), [&](size_t begin, size_t end) {
+    for (size_t iC = begin; iC < end; iC++) {
+      const CameraParameters& cam = params[iC];
+
+      // Same frame as a CameraView, see CameraView::fillCameraWidgetGeometry()
+      glm::vec3 root = cam.getPosition();
+      glm::vec3 lookDir, upDir, rightDir;
+      std::tie(lookDir, upDir, rightDir) = cam.getCameraFrame();
+
+      glm::vec3 frameCenter = root + lookDir * focalLength;
+      float halfHeight = static_cast<float>(focalLength * std::tan(glm::radians(cam.getFoVVerticalDegrees()) / 2.));
+      glm::vec3 frameUp = upDir * halfHeight;
+      float halfWidth = cam.getAspectRatioWidthOverHeight() * halfHeight;
+      glm::vec3 frameLeft = -glm::cross(lookDir, upDir) * halfWidth;
+
+      glm::vec3 frameUpperLeft = frameCenter + frameUp + frameLeft;
+      glm::vec3 frameUpperRight = frameCenter + frameUp - frameLeft;
+      glm::vec3 frameLowerLeft = frameCenter - frameUp + frameLeft;
+      glm::vec3 frameLowerRight = frameCenter - frameUp - frameLeft;
+      glm::vec3 triangleLeft = frameCenter + 1.2f * frameUp + 0.7f * frameLeft;
+      glm::vec3 triangleRight = frameCenter + 1.2f * frameUp - 0.7f * frameLeft;
+      glm::vec3 triangleTop = frameCenter + 2.f * frameUp;
+
+      glm::vec3* nodes = &nodePositions.data[nodesPerCamera * iC];
+      nodes[0] = root;
+      nodes[1] = frameUpperLeft;
+      nodes[2] = frameUpperRight;
+      nodes[3] = frameLowerLeft;
+      nodes[4] = frameLowerRight;
+      nodes[5] = triangleTop;
+      nodes[6] = triangleLeft;
+      nodes[7] = triangleRight;
+
+      size_t iE = edgesPerCamera * iC;
+      auto addEdge = [&](glm::vec3 a, glm::vec3 b) {
+        edgeTailPositions.data[iE] = a;
+        edgeTipPositions.data[iE] = b;
+        iE++;
+      };
+      addEdge(root, frameUpperLeft);
+      addEdge(root, frameUpperRight);
+      addEdge(root, frameLowerLeft);
+      addEdge(root, frameLowerRight);
+      addEdge(frameUpperLeft, frameUpperRight);
+      addEdge(frameUpperRight, frameLowerRight);
+      addEdge(frameLowerRight, frameLowerLeft);
+      addEdge(frameLowerLeft, frameUpperLeft);
+      addEdge(triangleLeft, triangleRight);
+      addEdge(triangleRight, triangleTop);
+      addEdge(triangleTop, triangleLeft);
+    }
+  });
+
+  nodePositions.markHostBufferUpdated();
+  edgeTailPositions.markHostBufferUpdated();
+  edgeTipPositions.markHostBufferUpdated();
+  preparedLengthScale = state::lengthScale;
+}
+
+void CameraViewSet::updateCameraParameters(const std::vector<CameraParameters>& newParams) {
+  bool countChanged = newParams.size() != params.size();
+  params = newParams;
+
+  if (countChanged) {
+    // the buffers and pick indices are sized by the number of cameras
+    refresh();
+  } else {
+    geometryChanged();
+  }
+  updateObjectSpaceBounds();
+}
+
+void CameraViewSet::geometryChanged() {
+  computeWidgetGeometry(); // the render buffers are updated in place
+  requestRedraw();
+  QuantityStructure<CameraViewSet>::refresh();
+}
+
+CameraParameters CameraViewSet::getCameraParameters(size_t iCamera) const {
+  if (iCamera >= nCameras()) {
+    exception("camera index " + std::to_string(iCamera) + " out of bounds for camera set " + name + " with " +
+              std::to_string(nCameras()) + " cameras");
+  }
+  return params[iCamera];
+}
+
+void CameraViewSet::buildPickUI(size_t localPickID) {
+  size_t iCamera = localPickID;
+  const CameraParameters& cam = params[iCamera];
+
+  ImGui::TextUnformatted(("camera #" + std::to_string(iCamera)).c_str());
+  ImGui::Text("center: %s", to_string(cam.getPosition()).c_str());
+  ImGui::Text("look dir: %s", to_string(cam.getLookDir()).c_str());
+  ImGui::Text("up dir: %s", to_string(cam.getUpDir()).c_str());
+  ImGui::Text("FoV (vert): %0.1f deg   aspect ratio: %.2f", cam.getFoVVerticalDegrees(),
+              cam.getAspectRatioWidthOverHeight());
+  if (ImGui::Button("fly to")) {
+    setViewToCamera(iCamera, true);
+  }
+}
+
+void CameraViewSet::buildCustomUI() {
+  long long int nCamerasL = static_cast<long long int>(nCameras());
+  ImGui::Text("#cameras: %lld", nCamerasL);
+
+  ImGui::SameLine();
+
+  { // colors
+    if (ImGui::ColorEdit3("Color", &widgetColor.get()[0], ImGuiColorEditFlags_NoInputs))
+      setWidgetColor(widgetColor.get());
+  }
+}
+
+void CameraViewSet::buildCustomOptionsUI() {
+
+  ImGui::PushItemWidth(150);
+
+  if (widgetFocalLengthUpper == -777) widgetFocalLengthUpper = 2. * (*widgetFocalLength.get().getValuePtr());
+  if (ImGui::SliderFloat("widget focal length", widgetFocalLength.get().getValuePtr(), 0, widgetFocalLengthUpper,
+                         "%.5f")) {
+    widgetFocalLength.manuallyChanged();
+    geometryChanged();
+  }
+  if (ImGui::IsItemDeactivatedAfterEdit()) {
+    // as for CameraView, the upper bound follows the value on release of the widget
+    widgetFocalLengthUpper = std::fmax(2. * (*widgetFocalLength.get().getValuePtr()), 0.0001);
+  }
+
+  if (ImGui::SliderFloat("widget thickness", &widgetThickness.get(), 0, 0.2, "%.5f")) {
+    widgetThickness.manuallyChanged();
+    requestRedraw();
+  }
+
+  ImGui::PopItemWidth();
+}
+
+void CameraViewSet::updateObjectSpaceBounds() {
+
+  if (nCameras() == 0) {
+    objectSpaceBoundingBox = std::make_tuple(glm::vec3{0., 0., 0.}, glm::vec3{0., 0., 0.});
+    objectSpaceLengthScale = 0.;
+    return;
+  }
+
+  // bounding box of the camera root locations
+  glm::vec3 min = params[0].getPosition();
+  glm::vec3 max = min;
+  for (const CameraParameters& cam : params) {
+    glm::vec3 p = cam.getPosition();
+    min = componentwiseMin(min, p);
+    max = componentwiseMax(max, p);
+  }
+  objectSpaceBoundingBox = std::make_tuple(min, max);
+
+  // unlike a single camera, the spread of the cameras gives a length scale
+  objectSpaceLengthScale = glm::length(max - min);
+}
+
+bool CameraViewSet::allowFrustumCulling() { return false; }
+
+std::string CameraViewSet::typeName() { return structureTypeName; }
+
+void CameraViewSet::refresh() {
+  nodeProgram.reset();
+  edgeProgram.reset();
+  nodePickProgram.reset();
+  edgePickProgram.reset();
+  computeWidgetGeometry();
+  QuantityStructure<CameraViewSet>::refresh(); // call base class version, which refreshes quantities
+}
+
+void CameraViewSet::setViewToCamera(size_t iCamera, bool withFlight) {
+  CameraParameters cam = getCameraParameters(iCamera);
+
+  // Adjust the params to push the view forward by eps so it doesn't clip into the frame, as CameraView does
+  glm::vec3 look, up, right;
+  std::tie(look, up, right) = cam.getCameraFrame();
+  glm::vec3 root = cam.getPosition();
+  root += look * getWidgetFocalLength() * 0.01f;
+
+  CameraParameters adjParams(cam.intrinsics, CameraExtrinsics::fromVectors(root, look, up));
+
+  if (withFlight) {
+    view::startFlightTo(adjParams);
+  } else {
+    view::setViewToCamera(adjParams);
+  }
+}
+
+// === Setters and getters
+
+CameraViewSet* CameraViewSet::setWidgetFocalLength(float newVal, bool isRelative) {
+  widgetFocalLength = ScaledValue<float>(newVal, isRelative);
+  geometryChanged();
+  return this;
+}
+float CameraViewSet::getWidgetFocalLength() { return widgetFocalLength.get().asAbsolute(); }
+
+CameraViewSet* CameraViewSet::setWidgetThickness(float newVal) {
+  widgetThickness = newVal;
+  requestRedraw();
+  return this;
+}
+float CameraViewSet::getWidgetThickness() { return widgetThickness.get(); }
+
+CameraViewSet* CameraViewSet::setWidgetColor(glm::vec3 val) {
+  widgetColor = val;
+  requestRedraw();
+  return this;
+}
+glm::vec3 CameraViewSet::getWidgetColor() { return widgetColor.get(); }
+
+} // namespace polyscope
@@ -38,6 +38,20 @@ void ColorImageQuantity::buildCustomUI() {
 
 std::string ColorImageQuantity::niceName() { return name + " (color image)"; }
 
+void ColorImageQuantity::updatePixels(const void* pixels, int nChannels, PixelComponentType componentType) {
+  updatePixelsRect(pixels, nChannels, componentType, 0, 0, dimX, dimY);
+}
+
+void ColorImageQuantity::updatePixelsRect(const void* pixels, int nChannels, PixelComponentType componentType,
+                                          size_t x, size_t y, size_t w, size_t h) {
+  checkPixelRect(x, y, w, h);
+  if (nChannels != 3 && nChannels != 4) {
+    exception("color image quantity " + name + " pixels must have 3 or 4 channels");
+  }
+  colors.setUpdateFrequency(BufferUpdateFrequency::Streaming);
+  colors.setTextureDataRect(pixels, nChannels, componentType, x, y, w, h);
+}
+
 void ColorImageQuantity::prepareFullscreen() {
 
   // Create the sourceProgram
@@ -155,6 +169,7 @@ ColorImageQuantity* ColorImageQuantity::setEnabled(bool newEnabled) {
     disableAllFullscreenArtists();
   }
   enabled = newEnabled;
+  parent.markEnabledQuantitiesStale();
   requestRedraw();
   return this;
 }
@@ -175,5 +190,28 @@ ColorImageQuantity* createColorImageQuantity(Structure& parent, std::string name
   return new ColorImageQuantity(parent, name, dimX, dimY, data, imageOrigin);
 }
 
+ColorImageQuantity* createColorImageQuantityFromPixels(Structure& parent, std::string name, size_t dimX, size_t dimY,
+                                                       const void* pixels, int nChannels,
+                                                       PixelComponentType componentType, ImageOrigin imageOrigin) {
+  if (nChannels != 3 && nChannels != 4) {
+    exception("color image quantity " + name + " pixels must have 3 or 4 channels");
+  }
+
+  // no float copy is ever made on the host, the pixels go straight to a texture of the matching precision
+  ColorImageQuantity* q = new ColorImageQuantity(parent, name, dimX, dimY, std::vector<glm::vec4>(), imageOrigin);
+  switch (componentType) {
+  case PixelComponentType::Float32:
+    break;
+  case PixelComponentType::UNorm8:
+    q->colors.setTextureStorageFormat(TextureFormat::RGBA8);
+    break;
+  case PixelComponentType::UNorm16:
+    q->colors.setTextureStorageFormat(TextureFormat::RGBA16);
+    break;
+  }
+  q->colors.setTextureDataRect(pixels, nChannels, componentType, 0, 0, dimX, dimY);
+  return q;
+}
+
 
 } // namespace polyscope
@@ -23,7 +23,7 @@ ColorRenderImageQuantity::ColorRenderImageQuantity(Structure& parent_, std::stri
 void ColorRenderImageQuantity::draw() {}
 
 void ColorRenderImageQuantity::drawDelayed() {
-  if (!isEnabled()) return;
+  if (!isEnabled() || drawnComposited) return;
 
   if (!program) prepare();
 
@@ -57,11 +57,32 @@ void ColorRenderImageQuantity::buildCustomUI() {
 }
 
 
+void ColorRenderImageQuantity::setExternalColorTexture(uint32_t glTextureName, TextureFormat format) {
+  colors.setExternalRenderTexture(render::engine->wrapExternalTexture(format, dimX, dimY, glTextureName));
+  refresh();
+}
+
+void ColorRenderImageQuantity::updateColorsFromDeviceBuffer(uint32_t glBufferName) {
+  colors.setTextureDataFromDeviceBuffer(glBufferName, 3, PixelComponentType::Float32);
+}
+
+void ColorRenderImageQuantity::markDeviceDataUpdated() {
+  if (colors.isDeviceResident()) colors.markRenderTextureBufferUpdated();
+  RenderImageQuantityBase::markDeviceDataUpdated();
+}
+
 void ColorRenderImageQuantity::refresh() {
   program = nullptr;
   RenderImageQuantityBase::refresh();
 }
 
+bool ColorRenderImageQuantity::getCompositeLayer(RenderImageCompositeLayer& layer) {
+  if (!getBaseCompositeLayer(layer)) return false;
+  layer.color = colors.getRenderTextureBuffer().get();
+  layer.colorMode = RenderImageCompositeLayer::ColorMode::Texture;
+  return true;
+}
+
 
 void ColorRenderImageQuantity::prepare() {
 
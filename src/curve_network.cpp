@@ -2,6 +2,7 @@
 
 #include "polyscope/curve_network.h"
 
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
@@ -16,6 +17,21 @@ namespace polyscope {
 // Initialize statics
 const std::string CurveNetwork::structureTypeName = "Curve Network";
 
+namespace {
+
+// The shared per-vertex geometry of the instanced edges, a triangle strip over a box. (x, y) across the edge, (z) from
+// tail to tip. Same strip order the geometry shader emits.
+std::vector<glm::vec3> cylinderBoxCorners() {
+  const int stripCorners[14] = {6, 7, 4, 5, 1, 7, 3, 6, 2, 4, 0, 1, 2, 3};
+  std::vector<glm::vec3> corners;
+  for (int c : stripCorners) {
+    corners.emplace_back((c & 1) ? 1. : -1., (c & 2) ? 1. : -1., (c & 4) ? 1. : 0.);
+  }
+  return corners;
+}
+
+} // namespace
+
 // Constructor
 CurveNetwork::CurveNetwork(std::string name, std::vector<glm::vec3> nodes_, std::vector<std::array<size_t, 2>> edges_)
     : // clang-format off
@@ -24,42 +40,65 @@ CurveNetwork::CurveNetwork(std::string name, std::vector<glm::vec3> nodes_, std:
       edgeTailInds(this, uniquePrefix() + "edgeTailInds", edgeTailIndsData),
       edgeTipInds(this, uniquePrefix() + "edgeTipInds", edgeTipIndsData),
       edgeCenters(this, uniquePrefix() + "edgeCenters", edgeCentersData, std::bind(&CurveNetwork::computeEdgeCenters, this)),         
+      keyframeInds(this, uniquePrefix() + "keyframeInds", keyframeIndsData, std::bind(&CurveNetwork::computeKeyframeInds, this)),
+      stripInds(this, uniquePrefix() + "stripInds", stripIndsData),
+      stripNextNodeInds(this, uniquePrefix() + "stripNextNodeInds", stripNextNodeIndsData),
+      stripNodeEdgeInds(this, uniquePrefix() + "stripNodeEdgeInds", stripNodeEdgeIndsData),
       nodePositionsData(std::move(nodes_)), 
       color(uniquePrefix() + "#color", getNextUniqueColor()), 
       radius(uniquePrefix() + "#radius", relativeValue(0.005)),
-      material(uniquePrefix() + "#material", "clay")
+      material(uniquePrefix() + "#material", "clay"),
+      renderMode(uniquePrefix() + "#renderMode", "cylinder"),
+      lineLODPixelRadius(uniquePrefix() + "#lineLODPixelRadius", 0.5)
 // clang-format on
 {
 
-  // Copy interleaved data in to tip and tails buffers below
-  edgeTailIndsData.resize(edges_.size());
-  edgeTipIndsData.resize(edges_.size());
-
-  // Compute node degrees; some quantities want them for visualizations
-  nodeDegrees = std::vector<size_t>(nNodes(), 0);
-
-  size_t maxInd = nodePositions.size();
-  for (size_t iE = 0; iE < edges_.size(); iE++) {
-    auto edge = edges_[iE];
-    size_t nA = std::get<0>(edge);
-    size_t nB = std::get<1>(edge);
+  setEdgeIndsData(edges_, nodePositionsData.size());
+  updateObjectSpaceBounds();
+}
 
-    edgeTailIndsData[iE] = nA;
-    edgeTipIndsData[iE] = nB;
+CurveNetwork::CurveNetwork(std::string name, std::vector<glm::vec3> nodes_, std::vector<uint32_t> polylineOffsets_)
+    : CurveNetwork(name, std::move(nodes_), std::vector<std::array<size_t, 2>>()) {
 
-    // Make sure there are no out of bounds indices
-    if (nA >= maxInd || nB >= maxInd) {
-      exception("CurveNetwork [" + name + "] edge " + std::to_string(iE) + " has bad node indices { " +
-                std::to_string(nA) + " , " + std::to_string(nB) + " } but there are " + std::to_string(maxInd) +
-                " nodes.");
+  size_t N = nNodes();
+  if (polylineOffsets_.empty() || polylineOffsets_.front() != 0 || polylineOffsets_.back() != N) {
+    exception("CurveNetwork [" + name + "] polyline offsets must begin with 0 and end with the number of nodes (" +
+              std::to_string(N) + ")");
+  }
+  polylineOffsets = std::move(polylineOffsets_);
+
+  // Each polyline has one fewer edge than nodes, and its strip is followed by a restart index
+  size_t nPoly = nPolylines();
+  edgeTailIndsData.reserve(N);
+  edgeTipIndsData.reserve(N);
+  stripIndsData.reserve(N + nPoly);
+  stripNextNodeIndsData.resize(N);
+  stripNodeEdgeIndsData.resize(N);
+
+  for (size_t iP = 0; iP < nPoly; iP++) {
+    uint32_t start = polylineOffsets[iP];
+    uint32_t end = polylineOffsets[iP + 1];
+    if (end < start + 2) {
+      exception("CurveNetwork [" + name + "] polyline " + std::to_string(iP) + " has fewer than two nodes");
     }
 
-    // Increment degree
-    nodeDegrees[nA]++;
-    nodeDegrees[nB]++;
+    for (uint32_t iN = start; iN < end; iN++) {
+      stripIndsData.push_back(iN);
+
+      if (iN + 1 < end) {
+        stripNextNodeIndsData[iN] = iN + 1;
+        stripNodeEdgeIndsData[iN] = static_cast<uint32_t>(edgeTailIndsData.size());
+        edgeTailIndsData.push_back(iN);
+        edgeTipIndsData.push_back(iN + 1);
+        nodeDegrees[iN]++;
+        nodeDegrees[iN + 1]++;
+      } else {
+        stripNextNodeIndsData[iN] = iN;
+        stripNodeEdgeIndsData[iN] = static_cast<uint32_t>(edgeTailIndsData.size() - 1);
+      }
+    }
+    stripIndsData.push_back(INVALID_IND_32);
   }
-
-  updateObjectSpaceBounds();
 }
 
 float CurveNetwork::computeRadiusMultiplierUniform() {
@@ -88,12 +127,85 @@ void CurveNetwork::setCurveNetworkNodeUniforms(render::ShaderProgram& p) {
   p.setUniform("u_pointRadius", computeRadiusMultiplierUniform());
 }
 
+void CurveNetwork::setEdgeIndsData(const std::vector<std::array<size_t, 2>>& edges, size_t nNodesNew) {
+
+  // Make sure there are no out of bounds indices
+  for (size_t iE = 0; iE < edges.size(); iE++) {
+    size_t nA = std::get<0>(edges[iE]);
+    size_t nB = std::get<1>(edges[iE]);
+    if (nA >= nNodesNew || nB >= nNodesNew) {
+      exception("CurveNetwork [" + name + "] edge " + std::to_string(iE) + " has bad node indices { " +
+                std::to_string(nA) + " , " + std::to_string(nB) + " } but there are " + std::to_string(nNodesNew) +
+                " nodes.");
+    }
+  }
+
+  // Copy interleaved data in to tip and tails buffers below
+  edgeTailIndsData.resize(edges.size());
+  edgeTipIndsData.resize(edges.size());
+
+  // Compute node degrees; some quantities want them for visualizations
+  nodeDegrees = std::vector<size_t>(nNodesNew, 0);
+
+  for (size_t iE = 0; iE < edges.size(); iE++) {
+    size_t nA = std::get<0>(edges[iE]);
+    size_t nB = std::get<1>(edges[iE]);
+
+    edgeTailIndsData[iE] = nA;
+    edgeTipIndsData[iE] = nB;
+
+    // Increment degree
+    nodeDegrees[nA]++;
+    nodeDegrees[nB]++;
+  }
+}
+
+void CurveNetwork::replaceNodesAndEdgesImpl(const std::vector<glm::vec3>& nodes,
+                                            const std::vector<std::array<size_t, 2>>& edges) {
+  if (hasPolylineStorage()) {
+    exception("Cannot replace nodes and edges of curve network [" + name + "], it was registered as polylines");
+  }
+  if (hasPositionKeyframes()) {
+    exception("Cannot replace nodes and edges of curve network [" + name + "], it has position keyframes");
+  }
+
+  // Indices first, so that updating the positions below regathers the per-edge views through the new ones
+  bool sameNodeCount = nodes.size() == nNodes();
+  setEdgeIndsData(edges, nodes.size());
+  nodePositionsData.assign(nodes.begin(), nodes.end()); // keeps the capacity of the host buffer
+  edgeTailInds.markHostBufferUpdated();
+  edgeTipInds.markHostBufferUpdated();
+  nodePositions.markHostBufferUpdated();
+
+  // With the same nodes, per-node quantities still fit, and are drawn along the new edges
+  if (sameNodeCount) {
+    for (auto& q : quantities) {
+      q.second->refreshIndexedViews(edgeTailInds);
+      q.second->refreshIndexedViews(edgeTipInds);
+    }
+  }
+
+  recomputeGeometryIfPopulated();
+  keyframeInds.recomputeIfPopulated();
+  pickBVHNeedsRefit = true;
+  pickColorsNeedUpdate = true;
+  updateObjectSpaceBounds();
+  updateStructureExtents();
+  requestRedraw();
+}
+
 void CurveNetwork::setCurveNetworkEdgeUniforms(render::ShaderProgram& p) {
   glm::mat4 P = view::getCameraPerspectiveMatrix();
   glm::mat4 Pinv = glm::inverse(P);
   p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
   p.setUniform("u_viewport", render::engine->getCurrentViewport());
   p.setUniform("u_radius", computeRadiusMultiplierUniform());
+  if (p.hasUniform("u_lineLODPixelRadius")) {
+    p.setUniform("u_lineLODPixelRadius", getLineLODPixelRadius());
+  }
+  if (p.hasAttribute("a_boxCorner")) {
+    p.setInstanceCount(static_cast<uint32_t>(nEdges())); // follows replaceNodesAndEdges()
+  }
 }
 
 void CurveNetwork::draw() {
@@ -101,6 +213,9 @@ void CurveNetwork::draw() {
     return;
   }
 
+  bool prepared = drawPrepared;
+  drawPrepared = false;
+
   // If there is no dominant quantity, then this class is responsible for drawing points
   if (dominantQuantity == nullptr) {
 
@@ -110,17 +225,7 @@ void CurveNetwork::draw() {
     }
 
     // Set program uniforms
-    setStructureUniforms(*edgeProgram);
-    setStructureUniforms(*nodeProgram);
-
-    setCurveNetworkEdgeUniforms(*edgeProgram);
-    setCurveNetworkNodeUniforms(*nodeProgram);
-
-    edgeProgram->setUniform("u_baseColor", getColor());
-    nodeProgram->setUniform("u_baseColor", getColor());
-
-    render::engine->setMaterialUniforms(*edgeProgram, getMaterial());
-    render::engine->setMaterialUniforms(*nodeProgram, getMaterial());
+    if (!prepared) setCurveNetworkProgramUniforms();
 
     // Draw the actual curve network
     edgeProgram->draw();
@@ -128,12 +233,35 @@ void CurveNetwork::draw() {
   }
 
   // Draw the quantities
-  for (auto& x : quantities) {
-    x.second->draw();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->draw();
+  }
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->draw();
   }
-  for (auto& x : floatingQuantities) {
-    x.second->draw();
+}
+
+void CurveNetwork::prepareDraw() {
+  if (!isEnabled() || dominantQuantity != nullptr || edgeProgram == nullptr || nodeProgram == nullptr ||
+      positionKeyframes) {
+    return;
   }
+  setCurveNetworkProgramUniforms();
+  drawPrepared = true;
+}
+
+void CurveNetwork::setCurveNetworkProgramUniforms() {
+  setStructureUniforms(*edgeProgram);
+  setStructureUniforms(*nodeProgram);
+
+  setCurveNetworkEdgeUniforms(*edgeProgram);
+  setCurveNetworkNodeUniforms(*nodeProgram);
+
+  edgeProgram->setUniform("u_baseColor", getColor());
+  nodeProgram->setUniform("u_baseColor", getColor());
+
+  render::engine->setMaterialUniforms(*edgeProgram, getMaterial());
+  render::engine->setMaterialUniforms(*nodeProgram, getMaterial());
 }
 
 void CurveNetwork::drawDelayed() {
@@ -141,11 +269,11 @@ void CurveNetwork::drawDelayed() {
     return;
   }
 
-  for (auto& x : quantities) {
-    x.second->drawDelayed();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->drawDelayed();
   }
-  for (auto& x : floatingQuantities) {
-    x.second->drawDelayed();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->drawDelayed();
   }
 }
 
@@ -157,6 +285,8 @@ void CurveNetwork::drawPick() {
   // Ensure we have prepared buffers
   if (edgePickProgram == nullptr || nodePickProgram == nullptr) {
     preparePick();
+  } else if (pickColorsNeedUpdate) {
+    fillPickColors();
   }
 
   // Set uniforms
@@ -179,6 +309,18 @@ std::vector<std::string> CurveNetwork::addCurveNetworkNodeRules(std::vector<std:
   if (wantsCullPosition()) {
     initRules.push_back("SPHERE_CULLPOS_FROM_CENTER");
   }
+  if (hasPositionKeyframes()) {
+    addKeyframeRule(initRules, "KEYFRAME_POSITION");
+  }
+
+  // the point sprites of the instanced mode have no geometry stage, they use the variants of the rules without one
+  if (getRenderMode() == CurveNetworkRenderMode::Instanced) {
+    for (std::string& rule : initRules) {
+      if (rule == "SPHERE_VARIABLE_SIZE" || rule.rfind("SPHERE_PROPAGATE_", 0) == 0) {
+        rule = "SPLAT_" + rule.substr(std::string("SPHERE_").size());
+      }
+    }
+  }
   return initRules;
 }
 std::vector<std::string> CurveNetwork::addCurveNetworkEdgeRules(std::vector<std::string> initRules) {
@@ -192,9 +334,44 @@ std::vector<std::string> CurveNetwork::addCurveNetworkEdgeRules(std::vector<std:
   if (wantsCullPosition()) {
     initRules.push_back("CYLINDER_CULLPOS_FROM_MID");
   }
+
+  // the strips read the nodes directly, the other modes read both endpoints of each edge
+  if (hasPositionKeyframes()) {
+    if (usesStripRendering()) {
+      addKeyframeRule(initRules, "KEYFRAME_POSITION");
+    } else {
+      addKeyframeRule(initRules, "CYLINDER_KEYFRAME_POSITIONS", false);
+    }
+  }
+
+  // likewise for the instanced cylinders, whose values are per-instance attributes
+  if (getRenderMode() == CurveNetworkRenderMode::Instanced) {
+    for (std::string& rule : initRules) {
+      if (rule == "CYLINDER_VARIABLE_SIZE" || rule == "CYLINDER_KEYFRAME_POSITIONS" ||
+          rule.rfind("CYLINDER_PROPAGATE_", 0) == 0) {
+        rule = "CYLINDER_INSTANCED_" + rule.substr(std::string("CYLINDER_").size());
+      }
+    }
+  }
   return initRules;
 }
 
+std::string CurveNetwork::getNodeShaderName() {
+  return getRenderMode() == CurveNetworkRenderMode::Instanced ? "POINT_SPLAT" : "RAYCAST_SPHERE";
+}
+
+std::string CurveNetwork::getEdgeShaderName() {
+  if (getRenderMode() == CurveNetworkRenderMode::Instanced) {
+    return "RAYCAST_CYLINDER_INSTANCED";
+  }
+  return usesStripRendering() ? "RAYCAST_CYLINDER_STRIP" : "RAYCAST_CYLINDER";
+}
+
+// the instanced mode needs an instance per edge, so it expands polylines per edge like any other network
+bool CurveNetwork::usesStripRendering() {
+  return hasPolylineStorage() && getRenderMode() == CurveNetworkRenderMode::Cylinder;
+}
+
 void CurveNetwork::prepare() {
   if (dominantQuantity != nullptr) {
     return;
@@ -203,7 +380,7 @@ void CurveNetwork::prepare() {
   // It no quantity is coloring the network, draw with a default color
 
   // clang-format off
-  nodeProgram = render::engine->requestShader("RAYCAST_SPHERE",  
+  nodeProgram = render::engine->requestShader(getNodeShaderName(),
       render::engine->addMaterialRules(getMaterial(),
         addCurveNetworkNodeRules(
           {"SHADE_BASECOLOR"}
@@ -212,7 +389,7 @@ void CurveNetwork::prepare() {
     );
 
 
-  edgeProgram = render::engine->requestShader("RAYCAST_CYLINDER", 
+  edgeProgram = render::engine->requestShader(getEdgeShaderName(),
       render::engine->addMaterialRules(getMaterial(),
         addCurveNetworkEdgeRules(
           {"SHADE_BASECOLOR"}
@@ -230,6 +407,19 @@ void CurveNetwork::prepare() {
 }
 
 void CurveNetwork::preparePick() {
+  nodePickProgram =
+      render::engine->requestShader(getNodeShaderName(), addCurveNetworkNodeRules({"SPHERE_PROPAGATE_COLOR"}),
+                                    render::ShaderReplacementDefaults::Pick);
+  edgePickProgram =
+      render::engine->requestShader(getEdgeShaderName(), addCurveNetworkEdgeRules({"CYLINDER_PROPAGATE_PICK"}),
+                                    render::ShaderReplacementDefaults::Pick);
+
+  fillPickColors();
+  fillNodeGeometryBuffers(*nodePickProgram);
+  fillEdgeGeometryBuffers(*edgePickProgram);
+}
+
+void CurveNetwork::fillPickColors() {
   edgeTailInds.ensureHostBufferPopulated();
   edgeTipInds.ensureHostBufferPopulated();
 
@@ -238,61 +428,66 @@ void CurveNetwork::preparePick() {
   //   ^                       ^
   //   0                    nNodes()
 
-  // Request pick indices
+  // Request pick indices. The range is kept while the network fits in it, and grown with headroom once the network
+  // has been resized, see replaceNodesAndEdges().
   size_t totalPickElements = nNodes() + nEdges();
-  size_t pickStart = pick::requestPickBufferRange(this, totalPickElements);
-
-  { // Set up node picking program
-    nodePickProgram =
-        render::engine->requestShader("RAYCAST_SPHERE", addCurveNetworkNodeRules({"SPHERE_PROPAGATE_COLOR"}),
-                                      render::ShaderReplacementDefaults::Pick);
+  if (pickRangeCapacity == 0 || totalPickElements > pickRangeCapacity) {
+    size_t capacity = totalPickElements;
+    if (pickRangeCapacity > 0) {
+      capacity = std::max(totalPickElements, pickRangeCapacity + pickRangeCapacity / 2);
+    }
+    pickRangeStart = pick::requestPickBufferRange(this, capacity);
+    pickRangeCapacity = capacity;
+  }
+  size_t pickStart = pickRangeStart;
 
+  { // Node picking colors
     // Fill color buffer with packed point indices
     std::vector<glm::vec3> pickColors;
     pickColors.reserve(nNodes());
     for (size_t i = pickStart; i < pickStart + nNodes(); i++) {
-      glm::vec3 val = pick::indToVec(i);
       pickColors.push_back(pick::indToVec(i));
     }
 
     // Store data in buffers
     nodePickProgram->setAttribute("a_color", pickColors);
-
-    fillNodeGeometryBuffers(*nodePickProgram);
   }
 
-  { // Set up edge picking program
-    edgePickProgram =
-        render::engine->requestShader("RAYCAST_CYLINDER", addCurveNetworkEdgeRules({"CYLINDER_PROPAGATE_PICK"}),
-                                      render::ShaderReplacementDefaults::Pick);
-
+  { // Edge picking colors
     // Fill color buffer with packed node/edge indices
-    std::vector<glm::vec3> edgePickTail(nEdges());
-    std::vector<glm::vec3> edgePickTip(nEdges());
-    std::vector<glm::vec3> edgePickEdge(nEdges());
+    // (line strips over the nodes take the values of the edge leaving each node)
+    bool strip = usesStripRendering();
+    size_t nPickEntries = strip ? nNodes() : nEdges();
+    std::vector<glm::vec3> edgePickTail(nPickEntries);
+    std::vector<glm::vec3> edgePickTip(nPickEntries);
+    std::vector<glm::vec3> edgePickEdge(nPickEntries);
 
     // Fill posiiton and pick index buffers
-    for (size_t iE = 0; iE < nEdges(); iE++) {
-      size_t eTail = edgeTailInds.data[iE];
-      size_t eTip = edgeTipInds.data[iE];
+    for (size_t iEntry = 0; iEntry < nPickEntries; iEntry++) {
+      size_t iE = strip ? stripNodeEdgeIndsData[iEntry] : iEntry;
+      size_t eTail = strip ? iEntry : edgeTailInds.data[iE];
+      size_t eTip = strip ? stripNextNodeIndsData[iEntry] : edgeTipInds.data[iE];
 
       glm::vec3 colorValTail = pick::indToVec(pickStart + eTail);
       glm::vec3 colorValTip = pick::indToVec(pickStart + eTip);
       glm::vec3 colorValEdge = pick::indToVec(pickStart + nNodes() + iE);
-      edgePickTail[iE] = colorValTail;
-      edgePickTip[iE] = colorValTip;
-      edgePickEdge[iE] = colorValEdge;
+      edgePickTail[iEntry] = colorValTail;
+      edgePickTip[iEntry] = colorValTip;
+      edgePickEdge[iEntry] = colorValEdge;
     }
     edgePickProgram->setAttribute("a_color_tail", edgePickTail);
     edgePickProgram->setAttribute("a_color_tip", edgePickTip);
     edgePickProgram->setAttribute("a_color_edge", edgePickEdge);
-
-    fillEdgeGeometryBuffers(*edgePickProgram);
   }
+
+  pickColorsNeedUpdate = false;
 }
 
 void CurveNetwork::fillNodeGeometryBuffers(render::ShaderProgram& program) {
   program.setAttribute("a_position", nodePositions.getRenderAttributeBuffer());
+  if (program.hasAttribute("a_keyframeInd")) {
+    program.setAttribute("a_keyframeInd", keyframeInds.getRenderAttributeBuffer());
+  }
 
   if (nodeRadiusQuantityName != "") {
     CurveNetworkNodeScalarQuantity& nodeRadQ = resolveNodeRadiusQuantity();
@@ -301,13 +496,31 @@ void CurveNetwork::fillNodeGeometryBuffers(render::ShaderProgram& program) {
 }
 
 void CurveNetwork::fillEdgeGeometryBuffers(render::ShaderProgram& program) {
-  program.setAttribute("a_position_tail", nodePositions.getIndexedRenderAttributeBuffer(edgeTailInds));
-  program.setAttribute("a_position_tip", nodePositions.getIndexedRenderAttributeBuffer(edgeTipInds));
+  if (usesStripRendering()) {
+    program.setAttribute("a_position", nodePositions.getRenderAttributeBuffer());
+    program.setIndex(stripInds.getRenderAttributeBuffer());
+    program.setPrimitiveRestartIndex(INVALID_IND_32);
+  } else {
+    program.setAttribute("a_position_tail", nodePositions.getIndexedRenderAttributeBuffer(edgeTailInds));
+    program.setAttribute("a_position_tip", nodePositions.getIndexedRenderAttributeBuffer(edgeTipInds));
+  }
+  if (program.hasAttribute("a_keyframeInd")) {
+    program.setAttribute("a_keyframeInd", keyframeInds.getRenderAttributeBuffer());
+  }
+  if (program.hasAttribute("a_keyframeInd_tail")) {
+    program.setAttribute("a_keyframeInd_tail", getEdgeTailAttributeBuffer(keyframeInds));
+    program.setAttribute("a_keyframeInd_tip", getEdgeTipAttributeBuffer(keyframeInds));
+  }
+
+  if (program.hasAttribute("a_boxCorner")) {
+    program.setAttribute("a_boxCorner", cylinderBoxCorners());
+    program.setInstanceCount(static_cast<uint32_t>(nEdges()));
+  }
 
   if (nodeRadiusQuantityName != "") {
     CurveNetworkNodeScalarQuantity& nodeRadQ = resolveNodeRadiusQuantity();
-    program.setAttribute("a_tailRadius", nodeRadQ.values.getIndexedRenderAttributeBuffer(edgeTailInds));
-    program.setAttribute("a_tipRadius", nodeRadQ.values.getIndexedRenderAttributeBuffer(edgeTipInds));
+    program.setAttribute("a_tailRadius", getEdgeTailAttributeBuffer(nodeRadQ.values));
+    program.setAttribute("a_tipRadius", getEdgeTipAttributeBuffer(nodeRadQ.values));
   }
 }
 
@@ -328,6 +541,14 @@ void CurveNetwork::computeEdgeCenters() {
   edgeCenters.markHostBufferUpdated();
 }
 
+void CurveNetwork::computeKeyframeInds() {
+  keyframeInds.data.resize(nNodes());
+  for (size_t i = 0; i < nNodes(); i++) {
+    keyframeInds.data[i] = static_cast<float>(i);
+  }
+  keyframeInds.markHostBufferUpdated();
+}
+
 void CurveNetwork::refresh() {
   recomputeGeometryIfPopulated();
 
@@ -339,6 +560,14 @@ void CurveNetwork::refresh() {
   QuantityStructure<CurveNetwork>::refresh(); // call base class version, which refreshes quantities
 }
 
+void CurveNetwork::refreshShaderPrograms() {
+  nodeProgram.reset();
+  edgeProgram.reset();
+  nodePickProgram.reset();
+  edgePickProgram.reset();
+  refreshQuantityShaderPrograms();
+}
+
 void CurveNetwork::recomputeGeometryIfPopulated() { edgeCenters.recomputeIfPopulated(); }
 
 void CurveNetwork::buildPickUI(size_t localPickID) {
@@ -429,6 +658,25 @@ void CurveNetwork::buildCustomOptionsUI() {
   }
 
 
+  if (ImGui::BeginMenu("Render Mode")) {
+    for (const CurveNetworkRenderMode& m : {CurveNetworkRenderMode::Cylinder, CurveNetworkRenderMode::Instanced}) {
+      bool selected = (m == getRenderMode());
+      std::string fancyName;
+      switch (m) {
+      case CurveNetworkRenderMode::Cylinder:
+        fancyName = "cylinder";
+        break;
+      case CurveNetworkRenderMode::Instanced:
+        fancyName = "instanced (fast)";
+        break;
+      }
+      if (ImGui::MenuItem(fancyName.c_str(), NULL, selected)) {
+        setRenderMode(m);
+      }
+    }
+    ImGui::EndMenu();
+  }
+
   if (render::buildMaterialOptionsGui(material.get())) {
     material.manuallyChanged();
     setMaterial(material.get()); // trigger the other updates that happen on set()
@@ -437,23 +685,66 @@ void CurveNetwork::buildCustomOptionsUI() {
 
 void CurveNetwork::updateObjectSpaceBounds() {
   nodePositions.ensureHostBufferPopulated();
+  setObjectSpaceBoundsFromPoints(nodePositions.data);
+  includeKeyframesInBounds();
+}
 
-  // bounding box
-  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  for (const glm::vec3& p : nodePositions.data) {
-    min = componentwiseMin(min, p);
-    max = componentwiseMax(max, p);
+float CurveNetwork::getDrawBoundsPadding() {
+  if (nodeRadiusQuantityName != "") {
+    // autoscaled radii are at most the base radius, unless some values are negative
+    if (!nodeRadiusQuantityAutoscale || resolveNodeRadiusQuantity().getDataRange().first < 0.) {
+      return std::numeric_limits<float>::infinity();
+    }
   }
-  objectSpaceBoundingBox = std::make_tuple(min, max);
+  return getRadius();
+}
 
-  // length scale, as twice the radius from the center of the bounding box
-  glm::vec3 center = 0.5f * (min + max);
-  float lengthScale = 0.0;
-  for (const glm::vec3& p : nodePositions.data) {
-    lengthScale = std::max(lengthScale, glm::length2(p - center));
-  }
-  objectSpaceLengthScale = 2 * std::sqrt(lengthScale);
+bool CurveNetwork::supportsRayCastPicking() { return !hasPositionKeyframes() && nodeRadiusQuantityName == ""; }
+
+bool CurveNetwork::rayCastPick(glm::dvec3 worldRayStart, glm::vec3 rayDir, float& tHit, size_t& localPickInd) {
+  nodePositions.ensureHostBufferPopulated();
+  edgeTailInds.ensureHostBufferPopulated();
+  edgeTipInds.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = nodePositions.data;
+  const std::vector<uint32_t>& tails = edgeTailInds.data;
+  const std::vector<uint32_t>& tips = edgeTipInds.data;
+
+  // Primitives are the nodes followed by the edges, like the pick indices
+  size_t nNodePrims = pos.size();
+  ensurePickBVH(nNodePrims + tails.size(), [&](std::vector<BVH::Box>& boxes) {
+    parallelFor(0, boxes.size(), [&](size_t chunkBegin, size_t chunkEnd) {
+      for (size_t i = chunkBegin; i < chunkEnd; i++) {
+        if (i < nNodePrims) {
+          boxes[i] = BVH::Box{pos[i], pos[i]};
+        } else {
+          glm::vec3 pA = pos[tails[i - nNodePrims]];
+          glm::vec3 pB = pos[tips[i - nNodePrims]];
+          boxes[i] = BVH::Box{glm::min(pA, pB), glm::max(pA, pB)};
+        }
+      }
+    });
+  });
+
+  // The hierarchy is over the bare elements, the radius is added at query time so it can change without a refit
+  float radius = getRadius();
+  glm::vec3 rayStart = worldRayToObjectSpace(worldRayStart, rayDir);
+  return pickBVH->rayCast(
+      rayStart, rayDir, tHit,
+      [&](size_t iPrim, float& tMax) {
+        float t;
+        bool hit;
+        if (iPrim < nNodePrims) {
+          hit = raySphereIntersection(rayStart, rayDir, pos[iPrim], radius, t);
+        } else {
+          size_t iE = iPrim - nNodePrims;
+          hit = rayCylinderIntersection(rayStart, rayDir, pos[tails[iE]], pos[tips[iE]], radius, t);
+        }
+        if (!hit || t >= tMax) return false;
+        tMax = t;
+        localPickInd = iPrim;
+        return true;
+      },
+      radius);
 }
 
 CurveNetwork* CurveNetwork::setColor(glm::vec3 newVal) {
@@ -489,13 +780,40 @@ CurveNetwork* CurveNetwork::setRadius(float newVal, bool isRelative) {
 float CurveNetwork::getRadius() { return radius.get().asAbsolute(); }
 
 CurveNetwork* CurveNetwork::setMaterial(std::string m) {
+  bool needsRefresh = render::engine->materialChangeNeedsRefresh(material.get(), m);
   material = m;
-  refresh(); // (serves the purpose of re-initializing everything, though this is a bit overkill)
+  if (needsRefresh) refresh();
   requestRedraw();
   return this;
 }
 std::string CurveNetwork::getMaterial() { return material.get(); }
 
+CurveNetwork* CurveNetwork::setRenderMode(CurveNetworkRenderMode newVal) {
+  switch (newVal) {
+  case CurveNetworkRenderMode::Cylinder:
+    renderMode = "cylinder";
+    break;
+  case CurveNetworkRenderMode::Instanced:
+    renderMode = "instanced";
+    break;
+  }
+  refresh();
+  polyscope::requestRedraw();
+  return this;
+}
+
+CurveNetworkRenderMode CurveNetwork::getRenderMode() {
+  if (renderMode.get() == "instanced") return CurveNetworkRenderMode::Instanced;
+  return CurveNetworkRenderMode::Cylinder;
+}
+
+CurveNetwork* CurveNetwork::setLineLODPixelRadius(float pixels) {
+  lineLODPixelRadius = pixels;
+  polyscope::requestRedraw();
+  return this;
+}
+float CurveNetwork::getLineLODPixelRadius() { return lineLODPixelRadius.get(); }
+
 std::string CurveNetwork::typeName() { return structureTypeName; }
 
 // === Quantities
@@ -45,7 +45,7 @@ void CurveNetworkNodeColorQuantity::createProgram() {
 
   // Create the program to draw this quantity
   // clang-format off
-  nodeProgram = render::engine->requestShader("RAYCAST_SPHERE", 
+  nodeProgram = render::engine->requestShader(parent.getNodeShaderName(),
       render::engine->addMaterialRules(parent.getMaterial(),
         addColorRules(
           parent.addCurveNetworkNodeRules(
@@ -54,7 +54,7 @@ void CurveNetworkNodeColorQuantity::createProgram() {
         )
       )
     );
-  edgeProgram = render::engine->requestShader("RAYCAST_CYLINDER", 
+  edgeProgram = render::engine->requestShader(parent.getEdgeShaderName(),
       render::engine->addMaterialRules(parent.getMaterial(),
         addColorRules(
           parent.addCurveNetworkEdgeRules(
@@ -74,8 +74,8 @@ void CurveNetworkNodeColorQuantity::createProgram() {
   }
 
   { // Fill edge color buffers
-    edgeProgram->setAttribute("a_color_tail", colors.getIndexedRenderAttributeBuffer(parent.edgeTailInds));
-    edgeProgram->setAttribute("a_color_tip", colors.getIndexedRenderAttributeBuffer(parent.edgeTipInds));
+    edgeProgram->setAttribute("a_color_tail", parent.getEdgeTailAttributeBuffer(colors));
+    edgeProgram->setAttribute("a_color_tip", parent.getEdgeTipAttributeBuffer(colors));
   }
 
   render::engine->setMaterial(*nodeProgram, parent.getMaterial());
@@ -115,7 +115,7 @@ CurveNetworkEdgeColorQuantity::CurveNetworkEdgeColorQuantity(std::string name, s
 void CurveNetworkEdgeColorQuantity::createProgram() {
 
   // clang-format off
-  nodeProgram = render::engine->requestShader("RAYCAST_SPHERE", 
+  nodeProgram = render::engine->requestShader(parent.getNodeShaderName(),
       render::engine->addMaterialRules(parent.getMaterial(),
         addColorRules(
           parent.addCurveNetworkNodeRules(
@@ -124,7 +124,7 @@ void CurveNetworkEdgeColorQuantity::createProgram() {
         )
       )
     );
-  edgeProgram = render::engine->requestShader("RAYCAST_CYLINDER", 
+  edgeProgram = render::engine->requestShader(parent.getEdgeShaderName(),
       render::engine->addMaterialRules(parent.getMaterial(),
         addColorRules(
           parent.addCurveNetworkEdgeRules(
@@ -146,7 +146,7 @@ void CurveNetworkEdgeColorQuantity::createProgram() {
   }
 
   { // Fill edge color buffers
-    edgeProgram->setAttribute("a_color", colors.getRenderAttributeBuffer());
+    edgeProgram->setAttribute("a_color", parent.getEdgeAttributeBuffer(colors));
   }
 
   render::engine->setMaterial(*nodeProgram, parent.getMaterial());
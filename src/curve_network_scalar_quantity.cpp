@@ -78,7 +78,7 @@ CurveNetworkNodeScalarQuantity::CurveNetworkNodeScalarQuantity(std::string name,
 void CurveNetworkNodeScalarQuantity::createProgram() {
   // Create the program to draw this quantity
   // clang-format off
-  nodeProgram = render::engine->requestShader("RAYCAST_SPHERE", 
+  nodeProgram = render::engine->requestShader(parent.getNodeShaderName(),
       render::engine->addMaterialRules(parent.getMaterial(),
         addScalarRules(
           parent.addCurveNetworkNodeRules(
@@ -87,7 +87,7 @@ void CurveNetworkNodeScalarQuantity::createProgram() {
         )
       )
     );
-  edgeProgram = render::engine->requestShader("RAYCAST_CYLINDER", 
+  edgeProgram = render::engine->requestShader(parent.getEdgeShaderName(),
       render::engine->addMaterialRules(parent.getMaterial(),
         addScalarRules(
           parent.addCurveNetworkEdgeRules(
@@ -107,8 +107,8 @@ void CurveNetworkNodeScalarQuantity::createProgram() {
   }
 
   { // Fill edge color buffers
-    edgeProgram->setAttribute("a_value_tail", values.getIndexedRenderAttributeBuffer(parent.edgeTailInds));
-    edgeProgram->setAttribute("a_value_tip", values.getIndexedRenderAttributeBuffer(parent.edgeTipInds));
+    edgeProgram->setAttribute("a_value_tail", parent.getEdgeTailAttributeBuffer(values));
+    edgeProgram->setAttribute("a_value_tip", parent.getEdgeTipAttributeBuffer(values));
   }
 
   edgeProgram->setTextureFromColormap("t_colormap", cMap.get());
@@ -139,7 +139,7 @@ void CurveNetworkEdgeScalarQuantity::createProgram() {
   // Create the program to draw this quantity
 
   // clang-format off
-  nodeProgram = render::engine->requestShader("RAYCAST_SPHERE", 
+  nodeProgram = render::engine->requestShader(parent.getNodeShaderName(),
       render::engine->addMaterialRules(parent.getMaterial(),
         addScalarRules(
           parent.addCurveNetworkNodeRules(
@@ -148,7 +148,7 @@ void CurveNetworkEdgeScalarQuantity::createProgram() {
         )
       )
     );
-  edgeProgram = render::engine->requestShader("RAYCAST_CYLINDER", 
+  edgeProgram = render::engine->requestShader(parent.getEdgeShaderName(),
       render::engine->addMaterialRules(parent.getMaterial(),
         addScalarRules(
           parent.addCurveNetworkEdgeRules(
@@ -169,7 +169,7 @@ void CurveNetworkEdgeScalarQuantity::createProgram() {
   }
 
   { // Fill edge color buffers
-    edgeProgram->setAttribute("a_value", values.getRenderAttributeBuffer());
+    edgeProgram->setAttribute("a_value", parent.getEdgeAttributeBuffer(values));
   }
 
   edgeProgram->setTextureFromColormap("t_colormap", cMap.get());
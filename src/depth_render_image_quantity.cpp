@@ -19,7 +19,7 @@ DepthRenderImageQuantity::DepthRenderImageQuantity(Structure& parent_, std::stri
 void DepthRenderImageQuantity::draw() {}
 
 void DepthRenderImageQuantity::drawDelayed() {
-  if (!isEnabled()) return;
+  if (!isEnabled() || drawnComposited) return;
 
   if (!program) prepare();
 
@@ -64,6 +64,13 @@ void DepthRenderImageQuantity::refresh() {
   RenderImageQuantityBase::refresh();
 }
 
+bool DepthRenderImageQuantity::getCompositeLayer(RenderImageCompositeLayer& layer) {
+  if (!getBaseCompositeLayer(layer)) return false;
+  layer.colorMode = RenderImageCompositeLayer::ColorMode::Constant;
+  layer.baseColor = color.get();
+  return true;
+}
+
 
 void DepthRenderImageQuantity::prepare() {
 
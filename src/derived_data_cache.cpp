@@ -0,0 +1,144 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/derived_data_cache.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/options.h"
+#include "polyscope/trace.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace polyscope {
+
+namespace {
+
+const char derivedDataMagic[4] = {'P', 'S', 'D', 'D'};
+const uint32_t derivedDataFormatVersion = 1;
+
+// Header: magic, format version, input hash, element size, element count, then the kind (guards against collisions of
+// the file name)
+struct DerivedDataHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t inputHash;
+  uint64_t elementBytes;
+  uint64_t count;
+  uint64_t kindLen;
+};
+
+std::string derivedDataPath(const std::string& kind, uint64_t inputHash) {
+  std::ostringstream name;
+  name << "polyscope_derived_" << kind << "_" << std::hex << std::setw(16) << std::setfill('0') << inputHash << ".bin";
+
+  std::string dir = options::derivedDataCacheDirectory;
+  if (dir.back() != '/' && dir.back() != '\\') dir += '/';
+  return dir + name.str();
+}
+
+inline uint64_t mixWord(uint64_t state, uint64_t word) {
+  state = (state ^ word) * 0xff51afd7ed558ccdull;
+  return state ^ (state >> 32);
+}
+
+} // namespace
+
+ContentHash& ContentHash::addBytes(const void* data, size_t nBytes) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+  // a word at a time, the inputs are typically large arrays
+  size_t nWords = nBytes / 8;
+  for (size_t i = 0; i < nWords; i++) {
+    uint64_t word;
+    std::memcpy(&word, bytes + 8 * i, 8);
+    state = mixWord(state, word);
+  }
+  if (nBytes % 8 != 0) {
+    uint64_t word = 0;
+    std::memcpy(&word, bytes + 8 * nWords, nBytes % 8);
+    state = mixWord(state, word);
+  }
+
+  totalBytes += nBytes;
+  return *this;
+}
+
+uint64_t ContentHash::get() const {
+  // splitmix64 finalizer
+  uint64_t h = mixWord(state, totalBytes);
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+
+bool derivedDataCacheEnabled() { return !options::derivedDataCacheDirectory.empty(); }
+
+namespace detail {
+
+std::unique_ptr<MappedFile> mapDerivedData(const std::string& kind, uint64_t inputHash, size_t elementBytes,
+                                           size_t& count, const unsigned char*& payload) {
+  POLYSCOPE_TRACE_SPAN("mapDerivedData", kind);
+
+  std::string path = derivedDataPath(kind, inputHash);
+  if (!std::ifstream(path, std::ios::binary)) return nullptr;
+
+  std::unique_ptr<MappedFile> file(new MappedFile(path));
+
+  DerivedDataHeader header;
+  if (file->size < sizeof(header)) return nullptr;
+  std::memcpy(&header, file->data, sizeof(header));
+  size_t payloadStart = sizeof(header) + header.kindLen;
+  if (std::memcmp(header.magic, derivedDataMagic, 4) != 0 || header.version != derivedDataFormatVersion ||
+      header.inputHash != inputHash || header.elementBytes != elementBytes || header.kindLen != kind.size() ||
+      file->size < payloadStart || (file->size - payloadStart) / elementBytes < header.count ||
+      std::memcmp(file->data + sizeof(header), kind.data(), kind.size()) != 0) {
+    if (options::verbosity > 2) info("ignoring mismatched derived data cache entry " + path);
+    return nullptr;
+  }
+
+  count = header.count;
+  payload = file->data + payloadStart;
+  return file;
+}
+
+void writeDerivedData(const std::string& kind, uint64_t inputHash, size_t elementBytes, const void* data,
+                      size_t count) {
+  POLYSCOPE_TRACE_SPAN("writeDerivedData", kind);
+
+  DerivedDataHeader header;
+  std::memcpy(header.magic, derivedDataMagic, 4);
+  header.version = derivedDataFormatVersion;
+  header.inputHash = inputHash;
+  header.elementBytes = elementBytes;
+  header.count = count;
+  header.kindLen = kind.size();
+
+  // Write to a temporary file and move it in place, so a concurrent or interrupted run never sees a partial entry
+  std::string path = derivedDataPath(kind, inputHash);
+  std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream outFile(tmpPath, std::ios::binary | std::ios::trunc);
+    outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    outFile.write(kind.data(), kind.size());
+    if (count > 0) outFile.write(static_cast<const char*>(data), count * elementBytes);
+    if (!outFile) {
+      outFile.close();
+      std::remove(tmpPath.c_str());
+      if (options::verbosity > 2) info("could not write derived data cache entry " + path);
+      return;
+    }
+  }
+  std::remove(path.c_str()); // rename() does not replace existing files on all platforms
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+  }
+}
+
+} // namespace detail
+
+} // namespace polyscope
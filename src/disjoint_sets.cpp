@@ -2,6 +2,10 @@
 
 #include "polyscope/disjoint_sets.h"
 
+#include "polyscope/parallel.h"
+
+#include <utility>
+
 using std::vector;
 
 namespace polyscope {
@@ -86,4 +90,41 @@ void MarkedDisjointSets::merge(size_t x, size_t y) {
   }
 }
 
+// Constructor
+ConcurrentDisjointSets::ConcurrentDisjointSets(size_t n_) : n(n_), parent(n + 1) {
+  parallelFor(0, n + 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      parent[i].store(i, std::memory_order_relaxed);
+    }
+  });
+}
+
+// Find parent of element x
+size_t ConcurrentDisjointSets::find(size_t x) {
+  // Path halving, each step points x at its grandparent. Losing the race to another thread only means the path is
+  // shortened a bit less.
+  while (true) {
+    size_t p = parent[x].load(std::memory_order_relaxed);
+    if (p == x) return x;
+    size_t gp = parent[p].load(std::memory_order_relaxed);
+    if (p != gp) parent[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+    x = gp;
+  }
+}
+
+// Union by index
+void ConcurrentDisjointSets::merge(size_t x, size_t y) {
+  while (true) {
+    x = find(x);
+    y = find(y);
+    if (x == y) return;
+
+    // Link the larger root under the smaller one. This fails if x stopped being a root since find(), in which case
+    // retry from the new roots.
+    if (x < y) std::swap(x, y);
+    size_t expected = x;
+    if (parent[x].compare_exchange_strong(expected, y)) return;
+  }
+}
+
 } // namespace polyscope
@@ -0,0 +1,196 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/element_selection.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/polyscope.h"
+
+#include <algorithm>
+#include <string>
+
+namespace polyscope {
+
+const size_t ElementSelection::bitsPerTexel;
+const size_t ElementSelection::textureWidth;
+
+namespace {
+const uint32_t fullWord = (1u << ElementSelection::bitsPerTexel) - 1;
+}
+
+ElementSelection::ElementSelection(size_t nElements_) : nElements(0) { resize(nElements_); }
+
+void ElementSelection::resize(size_t newSize) {
+  if (newSize == nElements) return;
+  size_t nWords = (newSize + bitsPerTexel - 1) / bitsPerTexel;
+  if (newSize < nElements && newSize % bitsPerTexel != 0) {
+    // drop the bits past the end, so they are not selected if the selection grows again
+    words[newSize / bitsPerTexel] &= (1u << (newSize % bitsPerTexel)) - 1;
+  }
+  nElements = newSize;
+  if (nWords != words.size()) {
+    words.resize(nWords, 0);
+    texture.reset(); // regenerated at the new size
+  }
+  markDirty(0, words.size());
+}
+
+void ElementSelection::markDirty(size_t wordBegin, size_t wordEnd) {
+  if (wordBegin >= wordEnd) return;
+  if (dirtyBegin == dirtyEnd) {
+    dirtyBegin = wordBegin;
+    dirtyEnd = wordEnd;
+  } else {
+    dirtyBegin = std::min(dirtyBegin, wordBegin);
+    dirtyEnd = std::max(dirtyEnd, wordEnd);
+  }
+  requestRedraw();
+}
+
+void ElementSelection::applyRange(size_t begin, size_t count, Op op) {
+  if (begin > nElements || count > nElements - begin) {
+    exception("selection range [" + std::to_string(begin) + ", " + std::to_string(begin + count) +
+              ") is out of bounds for " + std::to_string(nElements) + " elements");
+  }
+  if (count == 0) return;
+
+  size_t end = begin + count;
+  size_t wordBegin = begin / bitsPerTexel;
+  size_t wordEnd = (end - 1) / bitsPerTexel + 1;
+  for (size_t iW = wordBegin; iW < wordEnd; iW++) {
+    // the bits of this word within [begin, end)
+    size_t lo = std::max(begin, iW * bitsPerTexel) - iW * bitsPerTexel;
+    size_t hi = std::min(end, (iW + 1) * bitsPerTexel) - iW * bitsPerTexel;
+    uint32_t mask = (fullWord >> (bitsPerTexel - (hi - lo))) << lo;
+    switch (op) {
+    case Op::Set:
+      words[iW] |= mask;
+      break;
+    case Op::Clear:
+      words[iW] &= ~mask;
+      break;
+    case Op::Toggle:
+      words[iW] ^= mask;
+      break;
+    }
+  }
+  markDirty(wordBegin, wordEnd);
+}
+
+void ElementSelection::applyList(const std::vector<size_t>& inds, Op op) {
+  if (inds.empty()) return;
+  size_t minInd = inds[0];
+  size_t maxInd = inds[0];
+  for (size_t ind : inds) {
+    minInd = std::min(minInd, ind);
+    maxInd = std::max(maxInd, ind);
+  }
+  if (maxInd >= nElements) {
+    exception("selection index " + std::to_string(maxInd) + " is out of bounds for " + std::to_string(nElements) +
+              " elements");
+  }
+
+  for (size_t ind : inds) {
+    uint32_t bit = 1u << (ind % bitsPerTexel);
+    uint32_t& word = words[ind / bitsPerTexel];
+    switch (op) {
+    case Op::Set:
+      word |= bit;
+      break;
+    case Op::Clear:
+      word &= ~bit;
+      break;
+    case Op::Toggle:
+      word ^= bit;
+      break;
+    }
+  }
+  markDirty(minInd / bitsPerTexel, maxInd / bitsPerTexel + 1);
+}
+
+void ElementSelection::set(size_t begin, size_t count) { applyRange(begin, count, Op::Set); }
+void ElementSelection::clear(size_t begin, size_t count) { applyRange(begin, count, Op::Clear); }
+void ElementSelection::toggle(size_t begin, size_t count) { applyRange(begin, count, Op::Toggle); }
+void ElementSelection::set(const std::vector<size_t>& inds) { applyList(inds, Op::Set); }
+void ElementSelection::clear(const std::vector<size_t>& inds) { applyList(inds, Op::Clear); }
+void ElementSelection::toggle(const std::vector<size_t>& inds) { applyList(inds, Op::Toggle); }
+
+void ElementSelection::clearAll() {
+  std::fill(words.begin(), words.end(), 0);
+  markDirty(0, words.size());
+}
+
+bool ElementSelection::isSelected(size_t ind) const {
+  if (ind >= nElements) return false;
+  return (words[ind / bitsPerTexel] >> (ind % bitsPerTexel)) & 1u;
+}
+
+size_t ElementSelection::nSelected() const {
+  size_t n = 0;
+  for (uint32_t w : words) {
+    for (; w != 0; w &= w - 1) n++;
+  }
+  return n;
+}
+
+std::vector<size_t> ElementSelection::getSelected() const {
+  std::vector<size_t> inds;
+  for (size_t iW = 0; iW < words.size(); iW++) {
+    for (uint32_t w = words[iW]; w != 0; w &= w - 1) {
+      size_t iBit = 0;
+      while (!((w >> iBit) & 1u)) iBit++;
+      inds.push_back(iW * bitsPerTexel + iBit);
+    }
+  }
+  return inds;
+}
+
+void ElementSelection::setColor(glm::vec3 newColor) {
+  color = newColor;
+  requestRedraw();
+}
+
+render::TextureBuffer* ElementSelection::getTexture() {
+
+  size_t nWords = std::max<size_t>(words.size(), 1);
+  size_t width = std::min(nWords, textureWidth);
+  size_t height = (nWords + width - 1) / width;
+
+  if (!texture) {
+    std::vector<float> texels(width * height, 0.);
+    for (size_t iW = 0; iW < words.size(); iW++) {
+      texels[iW] = static_cast<float>(words[iW]);
+    }
+    texture = render::engine->generateTextureBuffer(TextureFormat::R32F, static_cast<unsigned int>(width),
+                                                    static_cast<unsigned int>(height), &texels[0]);
+    dirtyBegin = dirtyEnd = 0;
+    return texture.get();
+  }
+
+  if (dirtyBegin == dirtyEnd) return texture.get();
+
+  // Upload the changed words: just their span if it lies in one row, otherwise the whole rows holding them
+  size_t rowBegin = dirtyBegin / width;
+  size_t rowEnd = (dirtyEnd - 1) / width + 1;
+  size_t xBegin = 0;
+  size_t xEnd = width;
+  if (rowEnd == rowBegin + 1) {
+    xBegin = dirtyBegin % width;
+    xEnd = (dirtyEnd - 1) % width + 1;
+  }
+  std::vector<float> texels;
+  texels.reserve((rowEnd - rowBegin) * (xEnd - xBegin));
+  for (size_t iRow = rowBegin; iRow < rowEnd; iRow++) {
+    for (size_t x = xBegin; x < xEnd; x++) {
+      size_t iW = iRow * width + x;
+      texels.push_back(iW < words.size() ? static_cast<float>(words[iW]) : 0.f);
+    }
+  }
+  texture->setDataRect(&texels[0], 1, PixelComponentType::Float32, static_cast<unsigned int>(xBegin),
+                       static_cast<unsigned int>(rowBegin), static_cast<unsigned int>(xEnd - xBegin),
+                       static_cast<unsigned int>(rowEnd - rowBegin));
+  dirtyBegin = dirtyEnd = 0;
+
+  return texture.get();
+}
+
+} // namespace polyscope
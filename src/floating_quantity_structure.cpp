@@ -30,22 +30,22 @@ void FloatingQuantityStructure::buildCustomOptionsUI() {}
 void FloatingQuantityStructure::draw() {
   if (!isEnabled()) return;
 
-  for (auto& qp : quantities) {
-    qp.second->draw();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->draw();
   }
-  for (auto& qp : floatingQuantities) {
-    qp.second->draw();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->draw();
   }
 }
 
 void FloatingQuantityStructure::drawDelayed() {
   if (!isEnabled()) return;
 
-  for (auto& qp : quantities) {
-    qp.second->drawDelayed();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->drawDelayed();
   }
-  for (auto& qp : floatingQuantities) {
-    qp.second->drawDelayed();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->drawDelayed();
   }
 }
 
@@ -113,6 +113,26 @@ void removeAllFloatingQuantities() {
   internal::globalFloatingQuantityStructure->removeAllQuantities();
 }
 
+ScalarImageQuantity* addScalarImageQuantityFromPixels(std::string name, size_t dimX, size_t dimY, const void* pixels,
+                                                      PixelComponentType componentType, ImageOrigin imageOrigin,
+                                                      DataType type) {
+  FloatingQuantityStructure* q = getGlobalFloatingQuantityStructure();
+  return q->addScalarImageQuantityFromPixels(name, dimX, dimY, pixels, componentType, imageOrigin, type);
+}
+
+ColorImageQuantity* addColorImageQuantityFromPixels(std::string name, size_t dimX, size_t dimY, const void* pixels,
+                                                    int nChannels, PixelComponentType componentType,
+                                                    ImageOrigin imageOrigin) {
+  FloatingQuantityStructure* q = getGlobalFloatingQuantityStructure();
+  return q->addColorImageQuantityFromPixels(name, dimX, dimY, pixels, nChannels, componentType, imageOrigin);
+}
+
+TiledImageQuantity* addTiledImageQuantity(std::string name, size_t dimX, size_t dimY, TiledImageLoader loader,
+                                          size_t tileSize, ImageOrigin imageOrigin) {
+  FloatingQuantityStructure* q = getGlobalFloatingQuantityStructure();
+  return q->addTiledImageQuantity(name, dimX, dimY, loader, tileSize, imageOrigin);
+}
+
 // Quantity default methods
 FloatingQuantity::FloatingQuantity(std::string name_, Structure& parent_) : Quantity(name_, parent_) {}
 
@@ -0,0 +1,215 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/frame_pacing.h"
+
+#include "polyscope/options.h"
+#include "polyscope/render/engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+namespace polyscope {
+
+namespace {
+
+typedef std::chrono::steady_clock PacingClock;
+
+// Frames kept for the frame time distribution, and for predicting the time to process a frame
+const size_t frameHistorySize = 240;
+const size_t workHistorySize = 30;
+
+// Bounds on how long before a deadline sleeping stops and yielding takes over
+const double minSleepMarginMs = 0.1;
+const double maxSleepMarginMs = 4.;
+
+// Extra time left before a vertical blank when polling late, on top of the predicted frame time
+const double latePollSafetyMs = 1.;
+
+struct FramePacingState {
+  bool haveDeadline = false;
+  PacingClock::time_point nextDeadline;
+
+  bool frameStarted = false;
+  bool haveFrameStart = false;
+  PacingClock::time_point frameStart;
+  std::deque<double> frameMs; // between the starts of consecutive frames
+  std::deque<double> workMs;
+
+  bool havePresent = false;
+  PacingClock::time_point lastPresent;
+
+  double sleepMarginMs = 1.;
+};
+
+FramePacingState pacing;
+
+double toMs(PacingClock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); }
+
+PacingClock::duration fromMs(double ms) {
+  return std::chrono::duration_cast<PacingClock::duration>(std::chrono::duration<double, std::milli>(ms));
+}
+
+void pushHistory(std::deque<double>& history, double val, size_t maxSize) {
+  history.push_back(val);
+  if (history.size() > maxSize) history.pop_front();
+}
+
+// The value below which a fraction q of the sorted values lie
+double quantile(const std::vector<double>& sorted, double q) {
+  size_t ind = static_cast<size_t>(std::ceil(q * sorted.size()));
+  ind = std::min(std::max<size_t>(ind, 1), sorted.size()) - 1;
+  return sorted[ind];
+}
+
+// Sleep on the most precise timer available. The sleep may still overshoot, see preciseSleepUntil().
+void sleepForMs(double ms) {
+#ifdef _WIN32
+  static HANDLE timer =
+      CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+  if (timer != nullptr) {
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -static_cast<LONGLONG>(ms * 10000.); // relative, in 100ns units
+    if (SetWaitableTimer(timer, &dueTime, 0, nullptr, nullptr, FALSE)) {
+      WaitForSingleObject(timer, INFINITE);
+      return;
+    }
+  }
+#endif
+  std::this_thread::sleep_for(fromMs(ms));
+}
+
+void preciseSleepUntil(PacingClock::time_point target) {
+  while (true) {
+    PacingClock::time_point now = PacingClock::now();
+    if (now >= target) return;
+
+    double remainingMs = toMs(target - now);
+    if (remainingMs > pacing.sleepMarginMs) {
+      double requestedMs = remainingMs - pacing.sleepMarginMs;
+      sleepForMs(requestedMs);
+
+      // grow the margin as soon as a sleep overshoots it, and shrink it slowly while sleeps are precise
+      double overshootMs = toMs(PacingClock::now() - now) - requestedMs;
+      pacing.sleepMarginMs = std::max(1.5 * overshootMs, 0.95 * pacing.sleepMarginMs);
+      pacing.sleepMarginMs = std::min(std::max(pacing.sleepMarginMs, minSleepMarginMs), maxSleepMarginMs);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+} // namespace
+
+FrameTimeDistribution getFrameTimeDistribution() {
+  FrameTimeDistribution dist;
+  if (pacing.frameMs.empty()) return dist;
+
+  std::vector<double> sorted(pacing.frameMs.begin(), pacing.frameMs.end());
+  std::sort(sorted.begin(), sorted.end());
+
+  dist.nFrames = sorted.size();
+  double sum = 0.;
+  for (double ms : sorted) sum += ms;
+  dist.meanMs = sum / sorted.size();
+  double sumSq = 0.;
+  for (double ms : sorted) sumSq += (ms - dist.meanMs) * (ms - dist.meanMs);
+  dist.stdDevMs = std::sqrt(sumSq / sorted.size());
+  dist.minMs = sorted.front();
+  dist.medianMs = quantile(sorted, 0.5);
+  dist.p95Ms = quantile(sorted, 0.95);
+  dist.p99Ms = quantile(sorted, 0.99);
+  dist.maxMs = sorted.back();
+  return dist;
+}
+
+double getPredictedFrameWorkMs() {
+  if (pacing.workMs.empty()) return 0.;
+
+  // plan for the slow end of the recent frames, a frame which misses its vertical blank costs a whole display period
+  std::vector<double> sorted(pacing.workMs.begin(), pacing.workMs.end());
+  std::sort(sorted.begin(), sorted.end());
+  return quantile(sorted, 0.9);
+}
+
+double getDisplayPeriodMs() {
+  if (!options::enableVSync || render::engine == nullptr) return -1.;
+  double refreshRate = render::engine->getDisplayRefreshRate();
+  if (refreshRate <= 0.) return -1.;
+  return 1000. / refreshRate;
+}
+
+void waitForNextFrame() {
+  PacingClock::time_point now = PacingClock::now();
+  PacingClock::time_point target = now;
+  double displayPeriodMs = getDisplayPeriodMs();
+
+  // Frame starts on the grid of deadlines
+  if (options::maxFPS > 0) {
+    double periodMs = 1000. / options::maxFPS;
+    PacingClock::duration period = fromMs(periodMs);
+
+    // Swapping already limits the loop to the display rate, a grid of our own would only beat against it
+    bool displayPaces = displayPeriodMs >= 0.95 * periodMs;
+
+    if (!pacing.haveDeadline || displayPaces || now > pacing.nextDeadline + period) {
+      pacing.nextDeadline = now;
+    }
+    target = pacing.nextDeadline;
+    pacing.nextDeadline += period;
+    pacing.haveDeadline = true;
+  } else {
+    pacing.haveDeadline = false;
+  }
+
+  // Start as late as possible while still presenting at the first vertical blank after the target
+  if (options::latePollEvents && displayPeriodMs > 0. && pacing.havePresent && !pacing.workMs.empty()) {
+    double sinceBlankMs = toMs(target - pacing.lastPresent);
+    if (sinceBlankMs < 4. * displayPeriodMs) { // the phase of older blanks has drifted too far to extrapolate
+      double leadMs = getPredictedFrameWorkMs() + latePollSafetyMs;
+      double nBlanks = std::max(std::ceil((sinceBlankMs + leadMs) / displayPeriodMs), 1.);
+      PacingClock::time_point lateStart = pacing.lastPresent + fromMs(nBlanks * displayPeriodMs - leadMs);
+      target = std::max(target, lateStart);
+    }
+  }
+
+  preciseSleepUntil(target);
+
+  PacingClock::time_point start = PacingClock::now();
+  if (pacing.haveFrameStart) {
+    pushHistory(pacing.frameMs, toMs(start - pacing.frameStart), frameHistorySize);
+  }
+  pacing.frameStart = start;
+  pacing.haveFrameStart = true;
+  pacing.frameStarted = true;
+}
+
+void markFrameWorkEnd() {
+  // frames driven by frameTick() do not wait, and are not measured
+  if (!pacing.frameStarted) return;
+  pacing.frameStarted = false;
+  pushHistory(pacing.workMs, toMs(PacingClock::now() - pacing.frameStart), workHistorySize);
+}
+
+void markFramePresented() {
+  pacing.lastPresent = PacingClock::now();
+  pacing.havePresent = true;
+}
+
+} // namespace polyscope
@@ -0,0 +1,235 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/frame_stats.h"
+
+#include "polyscope/options.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/structure.h"
+
+#include <deque>
+#include <unordered_map>
+
+namespace polyscope {
+
+namespace {
+
+// A pair of GPU timestamps, resolved as their results arrive. Ticket 0 means timer queries are not supported.
+struct GPUInterval {
+  std::array<uint64_t, 2> tickets;
+  std::array<uint64_t, 2> nanoseconds{{0, 0}};
+  std::array<bool, 2> resolved{{false, false}};
+};
+
+struct SectionRecord {
+  std::string name;
+  double cpuMs = 0.;
+  std::vector<GPUInterval> gpuIntervals;
+};
+
+struct FrameRecord {
+  uint64_t frameIndex = 0;
+  double cpuMs = 0.;
+  GPUInterval gpuInterval;
+  size_t drawCalls = 0;
+  size_t trianglesSubmitted = 0;
+  size_t stateChanges = 0;
+  size_t stateChangesSkipped = 0;
+  std::vector<SectionRecord> sections;
+  std::unordered_map<std::string, size_t> sectionInds;
+};
+
+// Frames waiting for GPU results. Results normally arrive within a frame or two, if they fall further behind the
+// oldest frames are dropped rather than stalling.
+const size_t maxPendingFrames = 4;
+
+bool frameActive = false;
+FrameRecord currentFrame;
+std::chrono::steady_clock::time_point currentFrameStart;
+std::deque<FrameRecord> pendingFrames;
+uint64_t frameCount = 0;
+FrameStats latestStats;
+std::vector<FrameSectionStats> startupStats;
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool resolveInterval(GPUInterval& interval) {
+  bool allResolved = true;
+  for (int i = 0; i < 2; i++) {
+    if (interval.tickets[i] == 0 || interval.resolved[i]) continue;
+    interval.resolved[i] = render::engine->pollGPUTimestamp(interval.tickets[i], interval.nanoseconds[i]);
+    allResolved = allResolved && interval.resolved[i];
+  }
+  return allResolved;
+}
+
+void discardInterval(GPUInterval& interval) {
+  for (int i = 0; i < 2; i++) {
+    if (interval.tickets[i] != 0 && !interval.resolved[i]) {
+      render::engine->discardGPUTimestamp(interval.tickets[i]);
+    }
+  }
+}
+
+// -1 if either timestamp is missing
+double intervalMs(const GPUInterval& interval) {
+  if (interval.tickets[0] == 0 || interval.tickets[1] == 0) return -1.;
+  if (interval.nanoseconds[1] < interval.nanoseconds[0]) return 0.;
+  return 1e-6 * static_cast<double>(interval.nanoseconds[1] - interval.nanoseconds[0]);
+}
+
+bool resolveFrame(FrameRecord& frame) {
+  bool allResolved = resolveInterval(frame.gpuInterval);
+  for (SectionRecord& section : frame.sections) {
+    for (GPUInterval& interval : section.gpuIntervals) {
+      allResolved = resolveInterval(interval) && allResolved;
+    }
+  }
+  return allResolved;
+}
+
+void discardFrame(FrameRecord& frame) {
+  discardInterval(frame.gpuInterval);
+  for (SectionRecord& section : frame.sections) {
+    for (GPUInterval& interval : section.gpuIntervals) {
+      discardInterval(interval);
+    }
+  }
+}
+
+void publishFrame(const FrameRecord& frame) {
+  FrameStats stats;
+  stats.frameIndex = frame.frameIndex;
+  stats.cpuMs = frame.cpuMs;
+  stats.gpuMs = intervalMs(frame.gpuInterval);
+  stats.drawCalls = frame.drawCalls;
+  stats.trianglesSubmitted = frame.trianglesSubmitted;
+  stats.stateChanges = frame.stateChanges;
+  stats.stateChangesSkipped = frame.stateChangesSkipped;
+  for (const SectionRecord& section : frame.sections) {
+    FrameSectionStats sectionStats;
+    sectionStats.name = section.name;
+    sectionStats.cpuMs = section.cpuMs;
+    for (const GPUInterval& interval : section.gpuIntervals) {
+      double ms = intervalMs(interval);
+      if (ms < 0.) {
+        sectionStats.gpuMs = -1.;
+        break;
+      }
+      sectionStats.gpuMs = (sectionStats.gpuMs < 0. ? 0. : sectionStats.gpuMs) + ms;
+    }
+    stats.sections.push_back(sectionStats);
+  }
+  latestStats = stats;
+}
+
+void processPendingFrames() {
+  while (!pendingFrames.empty() && resolveFrame(pendingFrames.front())) {
+    publishFrame(pendingFrames.front());
+    pendingFrames.pop_front();
+  }
+}
+
+void discardPendingFrames() {
+  for (FrameRecord& frame : pendingFrames) {
+    discardFrame(frame);
+  }
+  pendingFrames.clear();
+}
+
+} // namespace
+
+FrameStats getFrameStats() {
+  FrameStats stats = latestStats;
+  stats.frameTimes = getFrameTimeDistribution();
+  return stats;
+}
+
+void beginFrameStats() {
+  if (frameActive) {
+    // a nested show() started a frame inside this one, the outer frame cannot be measured meaningfully
+    discardFrame(currentFrame);
+    frameActive = false;
+  }
+  if (!options::collectFrameStats) {
+    discardPendingFrames();
+    return;
+  }
+
+  frameCount++;
+  currentFrame = FrameRecord();
+  currentFrame.frameIndex = frameCount;
+  currentFrame.gpuInterval.tickets[0] = render::engine->recordGPUTimestamp();
+  currentFrameStart = std::chrono::steady_clock::now();
+  frameActive = true;
+}
+
+void endFrameStats() {
+  if (!frameActive) return;
+  frameActive = false;
+
+  currentFrame.gpuInterval.tickets[1] = render::engine->recordGPUTimestamp();
+  currentFrame.cpuMs = millisecondsSince(currentFrameStart);
+  currentFrame.drawCalls = render::engine->stats.drawCalls;
+  currentFrame.trianglesSubmitted = render::engine->stats.trianglesSubmitted;
+  currentFrame.stateChanges = render::engine->stats.stateChanges;
+  currentFrame.stateChangesSkipped = render::engine->stats.stateChangesSkipped;
+  pendingFrames.push_back(std::move(currentFrame));
+
+  if (pendingFrames.size() > maxPendingFrames) {
+    discardFrame(pendingFrames.front());
+    pendingFrames.pop_front();
+  }
+  processPendingFrames();
+}
+
+FrameStatsSection::FrameStatsSection(const std::string& name) {
+  if (frameActive) begin(name);
+}
+
+FrameStatsSection::FrameStatsSection(Structure& structure, const char* what) {
+  if (frameActive) begin(structure.typeName() + ": " + structure.name + " " + what);
+}
+
+void FrameStatsSection::begin(const std::string& name) {
+  auto it = currentFrame.sectionInds.find(name);
+  if (it == currentFrame.sectionInds.end()) {
+    it = currentFrame.sectionInds.emplace(name, currentFrame.sections.size()).first;
+    SectionRecord section;
+    section.name = name;
+    currentFrame.sections.push_back(section);
+  }
+  sectionInd = static_cast<int64_t>(it->second);
+  gpuStartTicket = render::engine->recordGPUTimestamp();
+  cpuStart = std::chrono::steady_clock::now();
+}
+
+FrameStatsSection::~FrameStatsSection() {
+  // the frame may have been abandoned meanwhile by a nested show()
+  if (sectionInd < 0 || !frameActive || static_cast<size_t>(sectionInd) >= currentFrame.sections.size()) {
+    if (gpuStartTicket != 0) render::engine->discardGPUTimestamp(gpuStartTicket);
+    return;
+  }
+
+  SectionRecord& section = currentFrame.sections[sectionInd];
+  section.cpuMs += millisecondsSince(cpuStart);
+  GPUInterval interval;
+  interval.tickets = {{gpuStartTicket, render::engine->recordGPUTimestamp()}};
+  section.gpuIntervals.push_back(interval);
+}
+
+std::vector<FrameSectionStats> getStartupStats() { return startupStats; }
+
+void resetStartupStats() { startupStats.clear(); }
+
+StartupPhase::StartupPhase(const std::string& name_) : name(name_), start(std::chrono::steady_clock::now()) {}
+
+StartupPhase::~StartupPhase() {
+  FrameSectionStats phase;
+  phase.name = name;
+  phase.cpuMs = millisecondsSince(start);
+  startupStats.push_back(phase);
+}
+
+} // namespace polyscope
@@ -32,6 +32,8 @@ Group::Group(std::string name_)
       hideDescendantsFromStructureLists(uniqueName() + "hideDescendantsFromStructureLists", false) {}
 
 Group::~Group() {
+  internal::invalidateGroupEnabledState();
+
   // unparent all children
   for (WeakHandle<Group>& childWeak : childrenGroups) {
     if (childWeak.isValid()) {
@@ -131,11 +133,13 @@ void Group::addChildGroup(Group& newChild) {
   // assign to the new group
   newChild.parentGroup = this->getWeakHandle<Group>(); // we want a weak pointer to the shared ptr
   childrenGroups.push_back(newChild.getWeakHandle<Group>());
+  internal::invalidateGroupEnabledState();
 }
 
 void Group::addChildStructure(Structure& newChild) {
   cullExpiredChildren();
   childrenStructures.push_back(newChild.getWeakHandle<Structure>());
+  internal::invalidateGroupEnabledState();
 }
 
 void Group::removeChildGroup(Group& child) {
@@ -152,6 +156,7 @@ void Group::removeChildGroup(Group& child) {
                                         return false;
                                       }),
                        childrenGroups.end());
+  internal::invalidateGroupEnabledState();
 }
 
 void Group::removeChildStructure(Structure& child) {
@@ -163,6 +168,7 @@ void Group::removeChildStructure(Structure& child) {
                                             return (&sWeak.get() == &child);
                                           }),
                            childrenStructures.end());
+  internal::invalidateGroupEnabledState();
 }
 
 Group* Group::getTopLevelGrandparent() {
@@ -184,6 +190,12 @@ int Group::isEnabled() {
   // (these -2 groups should not have a checkbox in the UI - there's nothing to enable / disable -
   // unless we added a is_enabled state for empty groups, but this could lead to edge cases)
 
+  // The result only changes when some structure is enabled, disabled, registered or removed, or the hierarchy changes.
+  // Caching it means that nested groups (each of which queries its descendants while building the UI) cost O(n) total.
+  if (enabledCacheGeneration == state::globalContext.groupEnabledGeneration) {
+    return enabledCache;
+  }
+
   cullExpiredChildren();
 
   bool any_children_enabled = false;
@@ -237,6 +249,8 @@ int Group::isEnabled() {
   if (!any_children_enabled && !any_children_disabled) {
     result = -2;
   }
+  enabledCache = result;
+  enabledCacheGeneration = state::globalContext.groupEnabledGeneration;
   return result;
 }
 
@@ -3,97 +3,246 @@
 #include "polyscope/histogram.h"
 
 #include "polyscope/affine_remapper.h"
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
+#include "polyscope/scratch_buffer.h"
 
 #include "imgui.h"
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <stdexcept>
 
 namespace polyscope {
 
+namespace {
+// Each histogram is drawn in a slot of slotWidth x slotHeight (the aspect it is shown at), in pages of slotsX x slotsY
+const unsigned int histSlotWidth = 512;
+const unsigned int histSlotHeight = 128;
+const unsigned int histSlotsX = 2;
+const unsigned int histSlotsY = 8;
+} // namespace
+
+class HistogramAtlas {
+public:
+  struct Page {
+    std::shared_ptr<render::TextureBuffer> texture;
+    std::shared_ptr<render::FrameBuffer> framebuffer;
+    std::vector<bool> slotUsed;
+  };
+
+  std::vector<Page> pages;
+  std::vector<Histogram*> queued;
+  std::shared_ptr<render::ShaderProgram> program; // shared by all histograms, the curve is set before each draw
+
+  void allocateSlot(size_t& iPage, size_t& iSlot) {
+    for (iPage = 0; iPage < pages.size(); iPage++) {
+      std::vector<bool>& used = pages[iPage].slotUsed;
+      iSlot = std::find(used.begin(), used.end(), false) - used.begin();
+      if (iSlot < used.size()) {
+        used[iSlot] = true;
+        return;
+      }
+    }
+
+    // all pages are full, add one
+    Page page;
+    page.texture = render::engine->generateTextureBuffer(TextureFormat::RGBA8, histSlotsX * histSlotWidth,
+                                                         histSlotsY * histSlotHeight);
+    page.framebuffer =
+        render::engine->generateFrameBuffer(histSlotsX * histSlotWidth, histSlotsY * histSlotHeight);
+    page.framebuffer->addColorBuffer(page.texture);
+    page.framebuffer->clearColor = {0.0, 0.0, 0.0};
+    page.framebuffer->clearAlpha = 0.2;
+    page.slotUsed.resize(histSlotsX * histSlotsY, false);
+    page.slotUsed[0] = true;
+    pages.push_back(page);
+    iPage = pages.size() - 1;
+    iSlot = 0;
+  }
+
+  void releaseSlot(size_t iPage, size_t iSlot) { pages[iPage].slotUsed[iSlot] = false; }
+
+  void unqueue(Histogram* hist) { queued.erase(std::remove(queued.begin(), queued.end(), hist), queued.end()); }
+
+  void renderQueued() {
+    if (queued.empty()) return;
+
+    if (!program) {
+      program = render::engine->requestShader("HISTOGRAM", {}, render::ShaderReplacementDefaults::Process);
+      program->setTextureFromColormap("t_colormap", "viridis"); // the atlas, each histogram sets its row
+    }
+
+    // by page, so each page is bound for all of its slots in turn
+    std::stable_sort(queued.begin(), queued.end(),
+                     [](const Histogram* a, const Histogram* b) { return a->atlasPage < b->atlasPage; });
+    for (Histogram* hist : queued) {
+      render::FrameBuffer& framebuffer = *pages[hist->atlasPage].framebuffer;
+      int x = (hist->atlasSlot % histSlotsX) * histSlotWidth;
+      int y = (hist->atlasSlot / histSlotsX) * histSlotHeight;
+      framebuffer.setViewport(x, y, histSlotWidth, histSlotHeight);
+      framebuffer.setScissor(x, y, histSlotWidth, histSlotHeight);
+      framebuffer.clear(); // only the slot
+      hist->render(*program);
+      hist->renderQueued = false;
+    }
+    for (Page& page : pages) {
+      page.framebuffer->removeScissor();
+    }
+    queued.clear();
+  }
+};
+
+namespace {
+// Alive as long as some histogram has been shown
+std::weak_ptr<HistogramAtlas> sharedHistogramAtlas;
+} // namespace
+
+void renderPendingHistograms() {
+  std::shared_ptr<HistogramAtlas> atlas = sharedHistogramAtlas.lock();
+  if (atlas) atlas->renderQueued();
+}
+
 Histogram::Histogram() {}
 
 Histogram::Histogram(std::vector<float>& values) { buildHistogram(values); }
 
-Histogram::~Histogram() {}
+Histogram::~Histogram() {
+  if (atlas) {
+    atlas->unqueue(this);
+    atlas->releaseSlot(atlasPage, atlasSlot);
+  }
+}
+
+void Histogram::buildHistogram(const std::vector<float>& values) { buildHistogram(values.data(), values.size()); }
 
-void Histogram::buildHistogram(const std::vector<float>& values) {
+void Histogram::buildHistogram(const float* values, size_t count) {
+  buildHistogram(values, count, finiteMinMax(values, count));
+}
 
-  // Build arrays of values
-  size_t N = values.size();
+void Histogram::buildHistogram(const float* values, size_t count, std::pair<double, double> finiteRange) {
 
   // == Build histogram
-  dataRange = robustMinMax(values);
+  dataRange = robustRange(finiteRange);
   colormapRange = dataRange;
 
-  // Helper to build the four histogram variants
-  auto buildCurve = [&](size_t binCount, std::vector<std::array<float, 2>>& curveX, std::vector<float>& curveY) {
-    // linspace coords
-    double range = dataRange.second - dataRange.first;
-    double inc = range / binCount;
-    std::vector<double> sumBin(binCount, 0.0);
-
-    // count values in buckets
-    for (size_t iData = 0; iData < N; iData++) {
-
-      double iBinf = binCount * (values[iData] - dataRange.first) / range;
-      size_t iBin = std::floor(glm::clamp(iBinf, 0.0, (double)binCount - 1));
-
-      // NaN values and finite values near the bottom of float range lead to craziness, so only increment bins if we got
-      // something reasonable
+  // Large inputs are counted from an evenly strided sample, each sample standing for `stride` values. The curve is
+  // normalized, so this only adds a little noise.
+  size_t stride = 1;
+  if (options::histogramMaxSamples > 0 && count > options::histogramMaxSamples) {
+    stride = (count + options::histogramMaxSamples - 1) / options::histogramMaxSamples;
+  }
+  size_t N = (count + stride - 1) / stride;
+
+  // count values in buckets, with separate bins for each chunk of the data which are summed afterwards
+  size_t binCount = rawHistBinCount;
+  size_t nChunks = parallelChunkCount(N, 1 << 16);
+  ScratchVector<size_t> chunkBins(nChunks * binCount, 0);
+  parallelForChunks(0, N, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+    size_t* bins = &chunkBins[iChunk * binCount];
+    for (size_t iSample = begin; iSample < end; iSample++) {
+      size_t iBin = binIndex(values[iSample * stride]);
       if (iBin < binCount) {
-        sumBin[iBin] += 1.0;
+        bins[iBin]++;
       }
     }
+  });
+  ScratchVector<double> sumBin(binCount, 0.0);
+  for (size_t iChunk = 0; iChunk < nChunks; iChunk++) {
+    for (size_t iBin = 0; iBin < binCount; iBin++) sumBin[iBin] += stride * chunkBins[iChunk * binCount + iBin];
+  }
 
+  buildCurve(*sumBin);
+}
 
-    // build histogram coords
-    curveX = std::vector<std::array<float, 2>>(binCount);
-    curveY = std::vector<float>(binCount);
-    double prevSumU = 0.0;
-    double prevSumW = 0.0;
-    double prevXEnd = dataRange.first;
-    for (size_t iBin = 0; iBin < binCount; iBin++) {
-      // y value
-      curveY[iBin] = sumBin[iBin];
-
-      // x value
-      double xEnd = prevXEnd + inc;
-      curveX[iBin] = {{static_cast<float>(prevXEnd), static_cast<float>(xEnd)}};
-      prevXEnd = xEnd;
-    }
+bool Histogram::updateCounts(const float* oldValues, const float* newValues, size_t count) {
+  if (counts.empty()) return false;
 
-    { // Rescale curves to [0,1] in both dimensions
-      double maxHeight = *std::max_element(curveY.begin(), curveY.end());
-      for (size_t i = 0; i < binCount; i++) {
-        curveX[i][0] = (curveX[i][0] - dataRange.first) / range;
-        curveX[i][1] = (curveX[i][1] - dataRange.first) / range;
-        curveY[i] /= maxHeight;
-      }
-    }
-  };
+  // the bins only stay meaningful while the values stay inside them
+  std::pair<float, float> newRange = finiteMinMax(newValues, count);
+  if (newRange.first < dataRange.first || newRange.second > dataRange.second) return false;
+
+  size_t binCount = counts.size();
+  for (size_t i = 0; i < count; i++) {
+    size_t iOld = binIndex(oldValues[i]);
+    size_t iNew = binIndex(newValues[i]);
+    if (iOld == iNew) continue;
+    if (iOld < binCount) counts[iOld] = std::max(counts[iOld] - 1., 0.); // counts may be estimates, see above
+    if (iNew < binCount) counts[iNew] += 1.;
+  }
 
-  buildCurve(rawHistBinCount, rawHistCurveX, rawHistCurveY);
+  ScratchVector<double> newCounts;
+  *newCounts = counts;
+  buildCurve(*newCounts);
+  return true;
 }
 
+size_t Histogram::binIndex(float value) const {
+  size_t binCount = rawHistBinCount;
+  double binScale = binCount / (dataRange.second - dataRange.first);
+  double iBinf = binScale * (value - dataRange.first);
 
-void Histogram::updateColormap(const std::string& newColormap) {
-  colormap = newColormap;
-  if (program) {
-    program.reset();
+  // NaN values and finite values near the bottom of float range lead to craziness, so only return a bin if we got
+  // something reasonable
+  if (std::isnan(iBinf)) return binCount;
+  return std::floor(glm::clamp(iBinf, 0.0, (double)binCount - 1));
+}
+
+void Histogram::buildHistogramFromCounts(const std::vector<double>& binCounts, std::pair<double, double> finiteRange) {
+  if (binCounts.size() != rawHistBinCount) {
+    exception("histogram given " + std::to_string(binCounts.size()) + " bin counts, expected " +
+              std::to_string(rawHistBinCount));
   }
+  dataRange = robustRange(finiteRange);
+  colormapRange = dataRange;
+  buildCurve(binCounts);
+}
+
+void Histogram::buildCurve(const std::vector<double>& sumBin) {
+  counts = sumBin;
+  curveChanged = true;
+  size_t binCount = sumBin.size();
+  double range = dataRange.second - dataRange.first;
+  double inc = range / binCount;
+
+  // build histogram coords
+  rawHistCurveX.resize(binCount);
+  rawHistCurveY.resize(binCount);
+  double prevXEnd = dataRange.first;
+  for (size_t iBin = 0; iBin < binCount; iBin++) {
+    // y value
+    rawHistCurveY[iBin] = sumBin[iBin];
+
+    // x value
+    double xEnd = prevXEnd + inc;
+    rawHistCurveX[iBin] = {{static_cast<float>(prevXEnd), static_cast<float>(xEnd)}};
+    prevXEnd = xEnd;
+  }
+
+  { // Rescale curves to [0,1] in both dimensions
+    double maxHeight = *std::max_element(rawHistCurveY.begin(), rawHistCurveY.end());
+    for (size_t i = 0; i < binCount; i++) {
+      rawHistCurveX[i][0] = (rawHistCurveX[i][0] - dataRange.first) / range;
+      rawHistCurveX[i][1] = (rawHistCurveX[i][1] - dataRange.first) / range;
+      rawHistCurveY[i] /= maxHeight;
+    }
+  }
+}
+
+
+void Histogram::updateColormap(const std::string& newColormap) {
+  colormap = newColormap; // just a uniform, set when the texture is next drawn
 }
 
-void Histogram::fillBuffers() {
+void Histogram::fillBuffers(render::ShaderProgram& program) {
 
   if (rawHistCurveY.size() == 0) {
     exception("histogram fillBuffers() called before buildHistogram");
   }
 
   // Push to buffer
-  std::vector<glm::vec2> coords;
+  ScratchVector<glm::vec2> coords;
 
   float histHeightStart = bottomBarHeight + bottomBarGap;
 
@@ -109,71 +258,72 @@ void Histogram::fillBuffers() {
     float rightYBot = histHeightStart;
 
     // = Lower triangle (lower left, lower right, upper left)
-    coords.push_back(glm::vec2{leftX, leftYBot});
-    coords.push_back(glm::vec2{rightX, rightYBot});
-    coords.push_back(glm::vec2{leftX, leftYTop});
+    coords->push_back(glm::vec2{leftX, leftYBot});
+    coords->push_back(glm::vec2{rightX, rightYBot});
+    coords->push_back(glm::vec2{leftX, leftYTop});
 
     // = Upper triangle (lower right, upper right, upper left)
-    coords.push_back(glm::vec2{rightX, rightYBot});
-    coords.push_back(glm::vec2{rightX, rightYTop});
-    coords.push_back(glm::vec2{leftX, leftYTop});
+    coords->push_back(glm::vec2{rightX, rightYBot});
+    coords->push_back(glm::vec2{rightX, rightYTop});
+    coords->push_back(glm::vec2{leftX, leftYTop});
   }
 
   // the long skinny bar along the bottom, which always shows regardless of histogram values
-  coords.push_back(glm::vec2{0., 0.});
-  coords.push_back(glm::vec2{1., 0.});
-  coords.push_back(glm::vec2{0., bottomBarHeight});
-  coords.push_back(glm::vec2{1., 0.});
-  coords.push_back(glm::vec2{1., bottomBarHeight});
-  coords.push_back(glm::vec2{0., bottomBarHeight});
+  coords->push_back(glm::vec2{0., 0.});
+  coords->push_back(glm::vec2{1., 0.});
+  coords->push_back(glm::vec2{0., bottomBarHeight});
+  coords->push_back(glm::vec2{1., 0.});
+  coords->push_back(glm::vec2{1., bottomBarHeight});
+  coords->push_back(glm::vec2{0., bottomBarHeight});
 
 
-  program->setAttribute("a_coord", coords);
+  program.setAttribute("a_coord", *coords);
 }
 
-void Histogram::prepare() {
-
-  framebuffer = render::engine->generateFrameBuffer(texDim, texDim);
-  texture = render::engine->generateTextureBuffer(TextureFormat::RGBA8, texDim, texDim);
-  framebuffer->addColorBuffer(texture);
-
-  // Create the program
-  program = render::engine->requestShader("HISTOGRAM", {}, render::ShaderReplacementDefaults::Process);
-
-  program->setTextureFromColormap("t_colormap", colormap, true);
-
-  fillBuffers();
+bool Histogram::needsRender() const {
+  return curveChanged || colormapRange != renderedColormapRange || colormap != renderedColormap;
 }
 
+void Histogram::render(render::ShaderProgram& program) {
 
-void Histogram::renderToTexture() {
-
-  if (!program) {
-    prepare();
-  }
-
-  framebuffer->clearColor = {0.0, 0.0, 0.0};
-  framebuffer->clearAlpha = 0.2;
-  framebuffer->setViewport(0, 0, texDim, texDim);
-  framebuffer->bindForRendering();
-  framebuffer->clear();
+  // the program is shared, so the curve is always set
+  fillBuffers(program);
+  curveChanged = false;
+  renderedColormapRange = colormapRange;
+  renderedColormap = colormap;
 
   // = Set uniforms
 
   // Colormap range (remapped to the 0-1 coords we use)
-  program->setUniform("u_cmapRangeMin", (colormapRange.first - dataRange.first) / (dataRange.second - dataRange.first));
-  program->setUniform("u_cmapRangeMax",
-                      (colormapRange.second - dataRange.first) / (dataRange.second - dataRange.first));
+  program.setUniform("u_cmapRangeMin", (colormapRange.first - dataRange.first) / (dataRange.second - dataRange.first));
+  program.setUniform("u_cmapRangeMax", (colormapRange.second - dataRange.first) / (dataRange.second - dataRange.first));
+  program.setUniform("u_colormapRow", render::engine->getColorMapAtlasRow(colormap));
 
   // Draw
-  program->draw();
+  program.draw();
 }
 
 
 void Histogram::buildUI(float width) {
 
-  // NOTE: I'm surprised this works, since we're drawing in the middle of imgui's processing. Possible source of bugs?
-  renderToTexture();
+  if (!atlas) {
+    atlas = sharedHistogramAtlas.lock();
+    if (!atlas) {
+      atlas = std::make_shared<HistogramAtlas>();
+      sharedHistogramAtlas = atlas;
+    }
+    atlas->allocateSlot(atlasPage, atlasSlot);
+  }
+
+  // The image only gets drawn when ImGui renders, so the slot can be drawn after the GUI is built, see
+  // renderPendingHistograms()
+  if (!renderQueued && needsRender()) {
+    if (rawHistCurveY.size() == 0) {
+      exception("histogram buildUI() called before buildHistogram");
+    }
+    atlas->queued.push_back(this);
+    renderQueued = true;
+  }
 
   // Compute size for image
   float aspect = 4.0;
@@ -184,7 +334,13 @@ void Histogram::buildUI(float width) {
   float h = w / aspect;
 
   // Render image
-  ImGui::Image(texture->getNativeHandle(), ImVec2(w, h), ImVec2(0, 1), ImVec2(1, 0));
+  float pageWidth = histSlotsX * histSlotWidth;
+  float pageHeight = histSlotsY * histSlotHeight;
+  float slotX = (atlasSlot % histSlotsX) * histSlotWidth;
+  float slotY = (atlasSlot / histSlotsX) * histSlotHeight;
+  ImVec2 uvTopLeft(slotX / pageWidth, (slotY + histSlotHeight) / pageHeight);
+  ImVec2 uvBottomRight((slotX + histSlotWidth) / pageWidth, slotY / pageHeight);
+  ImGui::Image(atlas->pages[atlasPage].texture->getNativeHandle(), ImVec2(w, h), uvTopLeft, uvBottomRight);
 
   // Helpful info for drawing annotations below
   ImU32 annoColor = ImGui::ColorConvertFloat4ToU32(ImVec4(254 / 255., 221 / 255., 66 / 255., 1.0));
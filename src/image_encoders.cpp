@@ -0,0 +1,488 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/image_encoders.h"
+
+#include "polyscope/internal.h"
+#include "polyscope/messages.h"
+#include "polyscope/parallel.h"
+
+#include "stb_image_write.h"
+
+#ifdef POLYSCOPE_HAS_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace polyscope {
+
+namespace {
+
+bool hasExtension(std::string str, std::string ext) {
+  std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+  if (str.length() < ext.length()) return false;
+  return str.compare(str.length() - ext.length(), ext.length(), ext) == 0;
+}
+
+// Row j of the image from the top, given rows stored bottom to top
+const unsigned char* rowFromTop(const unsigned char* buffer, int w, int h, int channels, int j) {
+  return buffer + static_cast<size_t>(h - 1 - j) * w * channels;
+}
+
+void putU32BigEndian(std::vector<unsigned char>& out, uint32_t val) {
+  out.insert(out.end(), {static_cast<unsigned char>(val >> 24), static_cast<unsigned char>(val >> 16),
+                         static_cast<unsigned char>(val >> 8), static_cast<unsigned char>(val)});
+}
+
+void putU16LittleEndian(std::vector<unsigned char>& out, uint32_t val) {
+  out.insert(out.end(), {static_cast<unsigned char>(val), static_cast<unsigned char>(val >> 8)});
+}
+
+void appendBytes(void* context, void* data, int size) {
+  std::vector<unsigned char>* out = static_cast<std::vector<unsigned char>*>(context);
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  out->insert(out->end(), bytes, bytes + size);
+}
+
+// === PNG
+
+const std::array<uint32_t, 256>& crcTable() {
+  static const std::array<uint32_t, 256> table = []() {
+    std::array<uint32_t, 256> t;
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+      }
+      t[n] = c;
+    }
+    return t;
+  }();
+  return table;
+}
+
+uint32_t crc32(const unsigned char* data, size_t n, uint32_t crc = 0) {
+  const std::array<uint32_t, 256>& table = crcTable();
+  crc = ~crc;
+  for (size_t i = 0; i < n; i++) {
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+uint32_t adler32(const std::vector<unsigned char>& data) {
+  uint32_t a = 1, b = 0;
+  size_t i = 0;
+  while (i < data.size()) {
+    // 5552 is the most bytes which can be summed before b could overflow
+    size_t blockEnd = std::min(data.size(), i + 5552);
+    for (; i < blockEnd; i++) {
+      a += data[i];
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+void appendPNGChunk(std::vector<unsigned char>& out, const char* type, const unsigned char* data, size_t n) {
+  putU32BigEndian(out, static_cast<uint32_t>(n));
+  size_t crcStart = out.size();
+  out.insert(out.end(), type, type + 4);
+  if (n > 0) out.insert(out.end(), data, data + n);
+  putU32BigEndian(out, crc32(&out[crcStart], n + 4));
+}
+
+// LSB-first bit packing, as deflate expects
+struct BitWriter {
+  std::vector<unsigned char>& out;
+  uint64_t bits = 0;
+  int nBits = 0;
+
+  explicit BitWriter(std::vector<unsigned char>& out_) : out(out_) {}
+
+  void put(uint32_t val, int n) {
+    bits |= static_cast<uint64_t>(val) << nBits;
+    nBits += n;
+    while (nBits >= 8) {
+      out.push_back(static_cast<unsigned char>(bits));
+      bits >>= 8;
+      nBits -= 8;
+    }
+  }
+
+  // Huffman codes are packed starting from their most significant bit
+  void putReversed(uint32_t code, int n) {
+    uint32_t rev = 0;
+    for (int i = 0; i < n; i++) {
+      rev |= ((code >> i) & 1) << (n - 1 - i);
+    }
+    put(rev, n);
+  }
+
+  void alignToByte() {
+    if (nBits > 0) put(0, 8 - nBits);
+  }
+};
+
+const uint16_t lengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t distBase[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                               193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t distExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// A symbol of the fixed literal/length Huffman code
+void putFixedLiteral(BitWriter& bw, uint32_t sym) {
+  if (sym < 144) {
+    bw.putReversed(0x30 + sym, 8);
+  } else if (sym < 256) {
+    bw.putReversed(0x190 + (sym - 144), 9);
+  } else if (sym < 280) {
+    bw.putReversed(sym - 256, 7);
+  } else {
+    bw.putReversed(0xC0 + (sym - 280), 8);
+  }
+}
+
+void putFixedMatch(BitWriter& bw, uint32_t len, uint32_t dist) {
+  int iL = 28;
+  while (lengthBase[iL] > len) iL--;
+  putFixedLiteral(bw, 257 + iL);
+  if (lengthExtra[iL] > 0) bw.put(len - lengthBase[iL], lengthExtra[iL]);
+
+  int iD = 29;
+  while (distBase[iD] > dist) iD--;
+  bw.putReversed(iD, 5);
+  if (distExtra[iD] > 0) bw.put(dist - distBase[iD], distExtra[iD]);
+}
+
+// Deflate data[begin, end) as one fixed-Huffman block. Matches only reach back within the range, so ranges can be
+// compressed independently. Unless this is the final block, it is followed by an empty stored block so that the output
+// ends on a byte boundary and the next range's output can be appended directly (like zlib's Z_SYNC_FLUSH).
+void deflateFixedRange(const std::vector<unsigned char>& data, size_t begin, size_t end, bool isFinal,
+                       std::vector<unsigned char>& out) {
+  const int hashBits = 15;
+  const size_t window = 32768;
+  const uint32_t maxLen = 258;
+  std::vector<int64_t> lastPos(static_cast<size_t>(1) << hashBits, -1);
+
+  BitWriter bw(out);
+  bw.put(isFinal ? 1 : 0, 1);
+  bw.put(1, 2); // fixed Huffman codes
+
+  size_t i = begin;
+  while (i < end) {
+    if (i + 4 <= end) {
+      uint32_t key;
+      std::memcpy(&key, &data[i], 4);
+      uint32_t h = (key * 2654435761u) >> (32 - hashBits);
+      int64_t cand = lastPos[h];
+      lastPos[h] = static_cast<int64_t>(i);
+
+      if (cand >= 0 && i - static_cast<size_t>(cand) <= window && std::memcmp(&data[cand], &data[i], 4) == 0) {
+        uint32_t len = 4;
+        uint32_t maxHere = static_cast<uint32_t>(std::min<size_t>(maxLen, end - i));
+        while (len < maxHere && data[cand + len] == data[i + len]) len++;
+        putFixedMatch(bw, len, static_cast<uint32_t>(i - cand));
+        i += len;
+        continue;
+      }
+    }
+    putFixedLiteral(bw, data[i]);
+    i++;
+  }
+  putFixedLiteral(bw, 256); // end of block
+
+  if (!isFinal) {
+    bw.put(0, 1);
+    bw.put(0, 2); // stored
+    bw.alignToByte();
+    out.insert(out.end(), {0x00, 0x00, 0xFF, 0xFF});
+  } else {
+    bw.alignToByte();
+  }
+}
+
+// === QOI
+
+struct QOIPixel {
+  QOIPixel(unsigned char r_ = 0, unsigned char g_ = 0, unsigned char b_ = 0, unsigned char a_ = 255)
+      : r(r_), g(g_), b(b_), a(a_) {}
+  unsigned char r, g, b, a;
+  bool operator==(const QOIPixel& o) const { return r == o.r && g == o.g && b == o.b && a == o.a; }
+};
+
+QOIPixel readPixel(const unsigned char* p, int channels) {
+  QOIPixel px;
+  if (channels <= 2) {
+    px.r = px.g = px.b = p[0];
+    if (channels == 2) px.a = p[1];
+  } else {
+    px.r = p[0];
+    px.g = p[1];
+    px.b = p[2];
+    if (channels == 4) px.a = p[3];
+  }
+  return px;
+}
+
+void checkChannels(int channels) {
+  if (channels < 1 || channels > 4) {
+    exception("images must have between 1 and 4 channels, got " + std::to_string(channels));
+  }
+}
+
+} // namespace
+
+ImageFormat resolveImageFormat(const std::string& filename, ImageFormat format) {
+  if (format != ImageFormat::Auto) return format;
+  if (hasExtension(filename, ".qoi")) return ImageFormat::QOI;
+  if (hasExtension(filename, ".tga")) return ImageFormat::TGA;
+  if (hasExtension(filename, ".ppm") || hasExtension(filename, ".pgm")) return ImageFormat::PPM;
+  if (hasExtension(filename, ".jpg") || hasExtension(filename, ".jpeg")) return ImageFormat::JPEG;
+  return ImageFormat::FastPNG;
+}
+
+bool imageFormatHasAlpha(ImageFormat format) {
+  switch (format) {
+  case ImageFormat::Auto:
+  case ImageFormat::PNG:
+  case ImageFormat::FastPNG:
+  case ImageFormat::QOI:
+  case ImageFormat::TGA:
+    return true;
+  case ImageFormat::PPM:
+  case ImageFormat::JPEG:
+    return false;
+  }
+  return false;
+}
+
+std::vector<unsigned char> encodeImageFastPNG(const unsigned char* buffer, int w, int h, int channels) {
+  checkChannels(channels);
+  const uint8_t colorTypes[5] = {0, 0, 4, 2, 6};
+  size_t rowBytes = static_cast<size_t>(w) * channels;
+  size_t filteredRowBytes = rowBytes + 1;
+
+  // Filter every row with "up", the difference to the row above it
+  std::vector<unsigned char> filtered(filteredRowBytes * h);
+  parallelFor(0, h, [&](size_t begin, size_t end) {
+    for (size_t j = begin; j < end; j++) {
+      unsigned char* dst = &filtered[j * filteredRowBytes];
+      const unsigned char* row = rowFromTop(buffer, w, h, channels, static_cast<int>(j));
+      dst[0] = 2;
+      if (j == 0) {
+        std::memcpy(dst + 1, row, rowBytes);
+      } else {
+        const unsigned char* above = rowFromTop(buffer, w, h, channels, static_cast<int>(j) - 1);
+        for (size_t i = 0; i < rowBytes; i++) {
+          dst[1 + i] = static_cast<unsigned char>(row[i] - above[i]);
+        }
+      }
+    }
+  }, 64);
+
+  // Deflate strips of rows independently. The strips do not depend on the thread count, so the output is the same
+  // however many threads encode it.
+  const size_t stripBytes = static_cast<size_t>(1) << 20;
+  size_t rowsPerStrip = std::max<size_t>(1, stripBytes / filteredRowBytes);
+  size_t nStrips = std::max<size_t>(1, (h + rowsPerStrip - 1) / rowsPerStrip);
+  std::vector<std::vector<unsigned char>> strips(nStrips);
+  parallelFor(0, nStrips, [&](size_t begin, size_t end) {
+    for (size_t iS = begin; iS < end; iS++) {
+      size_t rowBegin = iS * rowsPerStrip;
+      size_t rowEnd = std::min(static_cast<size_t>(h), rowBegin + rowsPerStrip);
+      strips[iS].reserve((rowEnd - rowBegin) * filteredRowBytes / 2);
+      deflateFixedRange(filtered, rowBegin * filteredRowBytes, rowEnd * filteredRowBytes, iS + 1 == nStrips,
+                        strips[iS]);
+    }
+  }, 1);
+
+  std::vector<unsigned char> zlib = {0x78, 0x01};
+  size_t zlibSize = zlib.size() + 4;
+  for (const std::vector<unsigned char>& s : strips) zlibSize += s.size();
+  zlib.reserve(zlibSize);
+  for (const std::vector<unsigned char>& s : strips) zlib.insert(zlib.end(), s.begin(), s.end());
+  putU32BigEndian(zlib, adler32(filtered));
+
+  std::vector<unsigned char> out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  out.reserve(zlib.size() + 64);
+  std::vector<unsigned char> header;
+  putU32BigEndian(header, static_cast<uint32_t>(w));
+  putU32BigEndian(header, static_cast<uint32_t>(h));
+  header.insert(header.end(), {8, colorTypes[channels], 0, 0, 0}); // 8 bit, deflate, no interlace
+  appendPNGChunk(out, "IHDR", header.data(), header.size());
+
+  const size_t maxChunk = static_cast<size_t>(1) << 30;
+  for (size_t start = 0; start < zlib.size(); start += maxChunk) {
+    appendPNGChunk(out, "IDAT", &zlib[start], std::min(maxChunk, zlib.size() - start));
+  }
+  appendPNGChunk(out, "IEND", nullptr, 0);
+  return out;
+}
+
+std::vector<unsigned char> encodeImageQOI(const unsigned char* buffer, int w, int h, int channels) {
+  checkChannels(channels);
+  bool hasAlpha = channels == 2 || channels == 4;
+
+  std::vector<unsigned char> out = {'q', 'o', 'i', 'f'};
+  out.reserve(static_cast<size_t>(w) * h * (hasAlpha ? 4 : 3) / 2 + 22);
+  putU32BigEndian(out, static_cast<uint32_t>(w));
+  putU32BigEndian(out, static_cast<uint32_t>(h));
+  out.push_back(hasAlpha ? 4 : 3);
+  out.push_back(0); // sRGB with linear alpha
+
+  std::array<QOIPixel, 64> index;
+  index.fill(QOIPixel(0, 0, 0, 0));
+  QOIPixel prev;
+  int run = 0;
+  size_t nPixels = static_cast<size_t>(w) * h;
+  size_t iPixel = 0;
+  for (int j = 0; j < h; j++) {
+    const unsigned char* row = rowFromTop(buffer, w, h, channels, j);
+    for (int i = 0; i < w; i++, iPixel++) {
+      QOIPixel px = readPixel(row + static_cast<size_t>(i) * channels, channels);
+
+      if (px == prev) {
+        run++;
+        if (run == 62 || iPixel + 1 == nPixels) {
+          out.push_back(static_cast<unsigned char>(0xC0 | (run - 1))); // QOI_OP_RUN
+          run = 0;
+        }
+        continue;
+      }
+      if (run > 0) {
+        out.push_back(static_cast<unsigned char>(0xC0 | (run - 1)));
+        run = 0;
+      }
+
+      int hash = (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+      if (index[hash] == px) {
+        out.push_back(static_cast<unsigned char>(hash)); // QOI_OP_INDEX
+      } else {
+        index[hash] = px;
+        if (px.a == prev.a) {
+          int vr = static_cast<signed char>(px.r - prev.r);
+          int vg = static_cast<signed char>(px.g - prev.g);
+          int vb = static_cast<signed char>(px.b - prev.b);
+          int vgr = vr - vg;
+          int vgb = vb - vg;
+          if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+            out.push_back(static_cast<unsigned char>(0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2))); // QOI_OP_DIFF
+          } else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8) {
+            out.push_back(static_cast<unsigned char>(0x80 | (vg + 32))); // QOI_OP_LUMA
+            out.push_back(static_cast<unsigned char>((vgr + 8) << 4 | (vgb + 8)));
+          } else {
+            out.insert(out.end(), {0xFE, px.r, px.g, px.b}); // QOI_OP_RGB
+          }
+        } else {
+          out.insert(out.end(), {0xFF, px.r, px.g, px.b, px.a}); // QOI_OP_RGBA
+        }
+      }
+      prev = px;
+    }
+  }
+
+  out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1}); // end marker
+  return out;
+}
+
+std::vector<unsigned char> encodeImageTGA(const unsigned char* buffer, int w, int h, int channels) {
+  checkChannels(channels);
+  if (w > 0xFFFF || h > 0xFFFF) {
+    exception("TGA images are limited to 65535 pixels on each side");
+  }
+  bool gray = channels == 1;
+  int outChannels = gray ? 1 : (channels == 3 ? 3 : 4);
+
+  std::vector<unsigned char> out = {0, 0, static_cast<unsigned char>(gray ? 3 : 2), 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  out.reserve(18 + static_cast<size_t>(w) * h * outChannels);
+  putU16LittleEndian(out, static_cast<uint32_t>(w));
+  putU16LittleEndian(out, static_cast<uint32_t>(h));
+  out.push_back(static_cast<unsigned char>(8 * outChannels));
+  out.push_back(outChannels == 4 ? 8 : 0); // alpha bits, rows bottom to top like ours
+
+  size_t nPixels = static_cast<size_t>(w) * h;
+  size_t start = out.size();
+  out.resize(start + nPixels * outChannels);
+  unsigned char* dst = &out[start];
+  parallelFor(0, nPixels, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      const unsigned char* p = buffer + i * channels;
+      unsigned char* q = dst + i * outChannels;
+      if (gray) {
+        q[0] = p[0];
+      } else if (channels == 2) {
+        q[0] = q[1] = q[2] = p[0];
+        q[3] = p[1];
+      } else {
+        q[0] = p[2]; // BGR(A)
+        q[1] = p[1];
+        q[2] = p[0];
+        if (channels == 4) q[3] = p[3];
+      }
+    }
+  });
+  return out;
+}
+
+std::vector<unsigned char> encodeImagePPM(const unsigned char* buffer, int w, int h, int channels) {
+  checkChannels(channels);
+  bool gray = channels <= 2;
+  int outChannels = gray ? 1 : 3;
+
+  std::string header = std::string(gray ? "P5" : "P6") + "\n" + std::to_string(w) + " " + std::to_string(h) + "\n255\n";
+  std::vector<unsigned char> out(header.begin(), header.end());
+  size_t start = out.size();
+  out.resize(start + static_cast<size_t>(w) * h * outChannels);
+  parallelFor(0, h, [&](size_t begin, size_t end) {
+    for (size_t j = begin; j < end; j++) {
+      const unsigned char* row = rowFromTop(buffer, w, h, channels, static_cast<int>(j));
+      unsigned char* dst = &out[start + j * w * outChannels];
+      for (int i = 0; i < w; i++) {
+        for (int c = 0; c < outChannels; c++) {
+          dst[i * outChannels + c] = row[i * channels + c];
+        }
+      }
+    }
+  }, 64);
+  return out;
+}
+
+std::vector<unsigned char> encodeImageJPEG(const unsigned char* buffer, int w, int h, int channels, int quality) {
+  checkChannels(channels);
+  quality = std::max(1, std::min(100, quality));
+  std::vector<unsigned char> out;
+
+#ifdef POLYSCOPE_HAS_TURBOJPEG
+  if (channels != 2) {
+    const int pixelFormats[5] = {0, TJPF_GRAY, 0, TJPF_RGB, TJPF_RGBA};
+    tjhandle handle = tjInitCompress();
+    unsigned char* jpeg = nullptr;
+    unsigned long jpegSize = 0;
+    int status = -1;
+    if (handle != nullptr) {
+      status = tjCompress2(handle, buffer, w, w * channels, h, pixelFormats[channels], &jpeg, &jpegSize,
+                           channels == 1 ? TJSAMP_GRAY : TJSAMP_444, quality, TJFLAG_BOTTOMUP | TJFLAG_FASTDCT);
+    }
+    if (status == 0) out.assign(jpeg, jpeg + jpegSize);
+    if (jpeg != nullptr) tjFree(jpeg);
+    if (handle != nullptr) tjDestroy(handle);
+    if (status == 0) return out;
+  }
+#endif
+
+  // stb flips on write, see internal::configureImageWriting()
+  internal::configureImageWriting();
+  stbi_write_jpg_to_func(appendBytes, &out, w, h, channels, buffer, quality);
+  return out;
+}
+
+} // namespace polyscope
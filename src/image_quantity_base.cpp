@@ -60,6 +60,14 @@ void ImageQuantity::disableFullscreenDrawing() {
 
 size_t ImageQuantity::nPix() { return dimX * dimY; }
 
+void ImageQuantity::checkPixelRect(size_t x, size_t y, size_t w, size_t h) {
+  if (x + w > dimX || y + h > dimY) {
+    exception("image quantity " + name + " pixel rectangle [" + std::to_string(x) + "," + std::to_string(x + w) +
+              ") x [" + std::to_string(y) + "," + std::to_string(y + h) + ") is outside the " +
+              std::to_string(dimX) + "x" + std::to_string(dimY) + " image");
+  }
+}
+
 void ImageQuantity::setShowFullscreen(bool newVal) {
   if (newVal && isEnabled()) {
     // if drawing fullscreen, disable anything else which was already drawing fullscreen
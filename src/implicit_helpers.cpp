@@ -0,0 +1,210 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/implicit_helpers.h"
+
+#include "polyscope/parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <tuple>
+#include <vector>
+
+namespace polyscope {
+
+namespace {
+
+// Progressive renders which have not converged yet
+std::vector<ProgressiveImplicitRender> progressiveRenders;
+
+// Trace the rays for some of the pixels of a progressive render
+void traceProgressivePixels(ProgressiveImplicitRender& render, const std::vector<size_t>& pixInds,
+                            std::vector<float>& depthOut, std::vector<glm::vec3>& normalOut) {
+  ScratchVector<glm::vec3> rayDirs(pixInds.size());
+  for (size_t i = 0; i < pixInds.size(); i++) {
+    rayDirs[i] = render.rayDirs[pixInds[i]];
+  }
+
+  std::vector<glm::vec3> posOut;
+  std::tie(depthOut, posOut, normalOut) =
+      renderImplicitSurfaceTracerRays(render.func, render.mode, render.opts, *rayDirs);
+}
+
+size_t progressiveTileSize(const ImplicitRenderOpts& opts) {
+  return static_cast<size_t>(std::max(opts.progressiveTileSize, 1));
+}
+
+size_t progressiveTileCount(const ImplicitRenderOpts& opts) {
+  size_t tileSize = progressiveTileSize(opts);
+  size_t nTilesX = (opts.dimX + tileSize - 1) / tileSize;
+  size_t nTilesY = (opts.dimY + tileSize - 1) / tileSize;
+  return nTilesX * nTilesY;
+}
+
+} // namespace
+
+void initializeProgressiveImplicitRender(ProgressiveImplicitRender& render) {
+
+  // Freeze the scaled values, so all tiles use the same ones even if the scene length scale changes meanwhile
+  ImplicitRenderOpts& opts = render.opts;
+  opts.missDist = ScaledValue<float>::absolute(opts.missDist.asAbsolute());
+  opts.hitDist = ScaledValue<float>::absolute(opts.hitDist.asAbsolute());
+  opts.stepSize = ScaledValue<float>::absolute(opts.stepSize.asAbsolute());
+
+  size_t dimX = opts.dimX;
+  size_t dimY = opts.dimY;
+  render.rayDirs = opts.cameraParameters.generateCameraRays(dimX, dimY, ImageOrigin::UpperLeft);
+  render.nextTile = 0;
+
+  // Trace the center pixel of each coarse block
+  size_t factor = static_cast<size_t>(std::max(opts.progressiveCoarseFactor, 1));
+  size_t coarseX = (dimX + factor - 1) / factor;
+  size_t coarseY = (dimY + factor - 1) / factor;
+  std::vector<size_t> pixInds;
+  pixInds.reserve(coarseX * coarseY);
+  for (size_t cY = 0; cY < coarseY; cY++) {
+    for (size_t cX = 0; cX < coarseX; cX++) {
+      size_t iX = std::min(cX * factor + factor / 2, dimX - 1);
+      size_t iY = std::min(cY * factor + factor / 2, dimY - 1);
+      pixInds.push_back(iY * dimX + iX);
+    }
+  }
+  std::vector<float> coarseDepths;
+  std::vector<glm::vec3> coarseNormals;
+  traceProgressivePixels(render, pixInds, coarseDepths, coarseNormals);
+
+  // Fill each block with its sample
+  render.depths.resize(dimX * dimY);
+  render.normals.resize(dimX * dimY);
+  for (size_t iY = 0; iY < dimY; iY++) {
+    for (size_t iX = 0; iX < dimX; iX++) {
+      size_t iCoarse = (iY / factor) * coarseX + iX / factor;
+      render.depths[iY * dimX + iX] = coarseDepths[iCoarse];
+      render.normals[iY * dimX + iX] = coarseNormals[iCoarse];
+    }
+  }
+}
+
+void addProgressiveImplicitRender(ProgressiveImplicitRender render) {
+
+  // A new quantity at the same address means an earlier render's quantity was replaced
+  progressiveRenders.erase(std::remove_if(progressiveRenders.begin(), progressiveRenders.end(),
+                                          [&](const ProgressiveImplicitRender& r) {
+                                            return r.quantity == render.quantity;
+                                          }),
+                           progressiveRenders.end());
+
+  if (render.nextTile < progressiveTileCount(render.opts)) {
+    progressiveRenders.push_back(std::move(render));
+  }
+}
+
+std::vector<glm::vec3> computeScreenSpaceImplicitNormals(const std::vector<float>& depths,
+                                                         const std::vector<glm::vec3>& positions,
+                                                         const std::vector<glm::vec3>& rayDirs,
+                                                         const ImplicitRenderOpts& opts) {
+
+  size_t dimX = opts.dimX;
+  size_t dimY = opts.dimY;
+  glm::mat3x3 viewMat3(opts.cameraParameters.getViewMat());
+  std::vector<glm::vec3> normals(dimX * dimY, glm::vec3{0.f, 0.f, 0.f});
+
+  auto isHit = [&](size_t iP) { return std::isfinite(depths[iP]); };
+
+  // Of the two neighbors along an axis, difference against the one with the closer depth, so that nearby surfaces
+  // don't bleed in across silhouettes
+  auto neighborDelta = [&](size_t iP, bool hasPrev, size_t iPrev, bool hasNext, size_t iNext, glm::vec3& delta) {
+    hasPrev = hasPrev && isHit(iPrev);
+    hasNext = hasNext && isHit(iNext);
+    if (!hasPrev && !hasNext) return false;
+    bool usePrev =
+        hasPrev && (!hasNext || std::abs(depths[iPrev] - depths[iP]) < std::abs(depths[iNext] - depths[iP]));
+    delta = usePrev ? positions[iP] - positions[iPrev] : positions[iNext] - positions[iP];
+    return true;
+  };
+
+  parallelFor(
+      0, dimY,
+      [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t iY = rowBegin; iY < rowEnd; iY++) {
+          for (size_t iX = 0; iX < dimX; iX++) {
+            size_t iP = iY * dimX + iX;
+            if (!isHit(iP)) continue;
+
+            // Face the camera, unless there are neighbors to difference against
+            glm::vec3 normal = -rayDirs[iP];
+            glm::vec3 deltaX, deltaY;
+            if (neighborDelta(iP, iX > 0, iP - 1, iX + 1 < dimX, iP + 1, deltaX) &&
+                neighborDelta(iP, iY > 0, iP - dimX, iY + 1 < dimY, iP + dimX, deltaY)) {
+              glm::vec3 c = glm::cross(deltaX, deltaY);
+              if (glm::dot(c, c) > 0.f) {
+                normal = glm::dot(c, rayDirs[iP]) > 0.f ? -c : c;
+              }
+            }
+
+            normals[iP] = viewMat3 * glm::normalize(normal);
+          }
+        }
+      },
+      16);
+
+  return normals;
+}
+
+bool progressiveImplicitRendersPending() { return !progressiveRenders.empty(); }
+
+void processProgressiveImplicitRenders() {
+  if (progressiveRenders.empty()) return;
+
+  // Stop refining any quantities that have gone away
+  progressiveRenders.erase(std::remove_if(progressiveRenders.begin(), progressiveRenders.end(),
+                                          [](const ProgressiveImplicitRender& r) { return !r.quantityIsAlive(); }),
+                           progressiveRenders.end());
+
+  // All renders share this frame's time, each one gets at least one tile
+  auto frameStart = std::chrono::steady_clock::now();
+  std::vector<size_t> pixInds;
+  std::vector<float> tileDepths;
+  std::vector<glm::vec3> tileNormals;
+
+  for (ProgressiveImplicitRender& render : progressiveRenders) {
+    const ImplicitRenderOpts& opts = render.opts;
+    size_t dimX = opts.dimX;
+    size_t dimY = opts.dimY;
+    size_t tileSize = progressiveTileSize(opts);
+    size_t nTilesX = (dimX + tileSize - 1) / tileSize;
+    size_t nTiles = progressiveTileCount(opts);
+
+    float elapsedMs = 0.;
+    do {
+      size_t tileX = render.nextTile % nTilesX;
+      size_t tileY = render.nextTile / nTilesX;
+      pixInds.clear();
+      for (size_t iY = tileY * tileSize; iY < std::min((tileY + 1) * tileSize, dimY); iY++) {
+        for (size_t iX = tileX * tileSize; iX < std::min((tileX + 1) * tileSize, dimX); iX++) {
+          pixInds.push_back(iY * dimX + iX);
+        }
+      }
+
+      traceProgressivePixels(render, pixInds, tileDepths, tileNormals);
+      for (size_t i = 0; i < pixInds.size(); i++) {
+        render.depths[pixInds[i]] = tileDepths[i];
+        render.normals[pixInds[i]] = tileNormals[i];
+      }
+      render.nextTile++;
+
+      elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+    } while (render.nextTile < nTiles && elapsedMs < opts.progressiveFrameBudgetMs);
+
+    render.quantity->updateBuffers(render.depths, render.normals);
+  }
+
+  // Forget renders which have converged
+  progressiveRenders.erase(std::remove_if(progressiveRenders.begin(), progressiveRenders.end(),
+                                          [](const ProgressiveImplicitRender& r) {
+                                            return r.nextTile >= progressiveTileCount(r.opts);
+                                          }),
+                           progressiveRenders.end());
+}
+
+} // namespace polyscope
@@ -0,0 +1,481 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/instanced_mesh.h"
+
+#include "polyscope/pick.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace polyscope {
+
+// Initialize statics
+const std::string InstancedMesh::structureTypeName = "Instanced Mesh";
+
+namespace {
+
+std::vector<glm::vec4> transformsToColumns(const std::vector<glm::mat4>& transforms) {
+  std::vector<glm::vec4> columns(4 * transforms.size());
+  for (size_t i = 0; i < transforms.size(); i++) {
+    for (int j = 0; j < 4; j++) {
+      columns[4 * i + j] = transforms[i][j];
+    }
+  }
+  return columns;
+}
+
+std::vector<glm::vec3> expandCornerPositions(const std::vector<glm::vec3>& vertices,
+                                             const std::vector<glm::uvec3>& faces) {
+  std::vector<glm::vec3> corners(3 * faces.size());
+  for (size_t iF = 0; iF < faces.size(); iF++) {
+    for (int j = 0; j < 3; j++) {
+      if (faces[iF][j] >= vertices.size()) {
+        exception("instanced mesh face " + std::to_string(iF) + " has out of bounds vertex index " +
+                  std::to_string(faces[iF][j]));
+      }
+      corners[3 * iF + j] = vertices[faces[iF][j]];
+    }
+  }
+  return corners;
+}
+
+} // namespace
+
+// Constructor
+InstancedMesh::InstancedMesh(std::string name, std::vector<glm::vec3> vertices_, std::vector<glm::uvec3> faces_,
+                             std::vector<glm::mat4> transforms_)
+    : // clang-format off
+      QuantityStructure<InstancedMesh>(name, structureTypeName),
+      vertices(this, uniquePrefix() + "vertices", verticesData),
+      faces(this, uniquePrefix() + "faces", facesData),
+      cornerPositions(this, uniquePrefix() + "cornerPositions", cornerPositionsData),
+      instanceTransforms(this, uniquePrefix() + "instanceTransforms", instanceTransformsData),
+      instanceColors(this, uniquePrefix() + "instanceColors", instanceColorsData),
+      instanceValues(this, uniquePrefix() + "instanceValues", instanceValuesData),
+      verticesData(std::move(vertices_)),
+      facesData(std::move(faces_)),
+      cornerPositionsData(expandCornerPositions(verticesData, facesData)),
+      instanceTransformsData(transformsToColumns(transforms_)),
+      surfaceColor(uniquePrefix() + "surfaceColor", getNextUniqueColor()),
+      material(uniquePrefix() + "material", "clay"),
+      cMap(uniquePrefix() + "cmap", "viridis"),
+      backFacePolicy(uniquePrefix() + "backFacePolicy", BackFacePolicy::Different),
+      backFaceColor(uniquePrefix() + "backFaceColor", glm::vec3(1.f - surfaceColor.get().r, 1.f - surfaceColor.get().g, 1.f - surfaceColor.get().b))
+// clang-format on
+{
+  // the pick shader adds the face index to the low 22-bit component of each instance's pick index
+  if (facesData.size() >= (1ULL << pick::bitsForPickPacking)) {
+    exception("instanced mesh " + name + " has too many faces (" + std::to_string(facesData.size()) +
+              "), instanced meshes support at most " + std::to_string((1ULL << pick::bitsForPickPacking) - 1));
+  }
+
+  cullWholeElements.setPassive(false);
+  updateObjectSpaceBounds();
+}
+
+size_t InstancedMesh::nInstances() { return instanceTransforms.size() / 4; }
+size_t InstancedMesh::nFaces() { return faces.size(); }
+
+std::pair<size_t, size_t> InstancedMesh::pickIndexToInstanceFace(size_t localPickID) {
+  if (nFaces() == 0) return std::make_pair(INVALID_IND, INVALID_IND);
+  return std::make_pair(localPickID / nFaces(), localPickID % nFaces());
+}
+
+void InstancedMesh::buildCustomUI() {
+
+  // Print stats
+  long long int nInstancesL = static_cast<long long int>(nInstances());
+  long long int nFacesL = static_cast<long long int>(nFaces());
+  ImGui::Text("#instances: %lld  #faces: %lld", nInstancesL, nFacesL);
+
+  { // Colors
+    if (instanceColoring == InstanceColoring::Uniform) {
+      if (ImGui::ColorEdit3("Color", &surfaceColor.get()[0], ImGuiColorEditFlags_NoInputs))
+        setSurfaceColor(surfaceColor.get());
+    }
+    if (instanceColoring == InstanceColoring::Scalar) {
+      if (render::buildColormapSelector(cMap.get())) {
+        cMap.manuallyChanged();
+        setColorMap(cMap.get());
+      }
+    }
+  }
+
+  { // Backface color (only visible if policy is selected)
+    if (backFacePolicy.get() == BackFacePolicy::Custom) {
+      if (ImGui::ColorEdit3("Backface Color", &backFaceColor.get()[0], ImGuiColorEditFlags_NoInputs))
+        setBackFaceColor(backFaceColor.get());
+    }
+  }
+}
+
+
+void InstancedMesh::buildCustomOptionsUI() {
+  if (render::buildMaterialOptionsGui(material.get())) {
+    material.manuallyChanged();
+    setMaterial(material.get()); // trigger the other updates that happen on set()
+  }
+
+  // backfaces
+  if (ImGui::BeginMenu("Back Face Policy")) {
+    if (ImGui::MenuItem("identical shading", NULL, backFacePolicy.get() == BackFacePolicy::Identical))
+      setBackFacePolicy(BackFacePolicy::Identical);
+    if (ImGui::MenuItem("different shading", NULL, backFacePolicy.get() == BackFacePolicy::Different))
+      setBackFacePolicy(BackFacePolicy::Different);
+    if (ImGui::MenuItem("custom shading", NULL, backFacePolicy.get() == BackFacePolicy::Custom))
+      setBackFacePolicy(BackFacePolicy::Custom);
+    if (ImGui::MenuItem("cull", NULL, backFacePolicy.get() == BackFacePolicy::Cull))
+      setBackFacePolicy(BackFacePolicy::Cull);
+    ImGui::EndMenu();
+  }
+}
+
+void InstancedMesh::buildPickUI(size_t localPickID) {
+  std::pair<size_t, size_t> instanceFace = pickIndexToInstanceFace(localPickID);
+
+  ImGui::TextUnformatted(("instance #" + std::to_string(instanceFace.first)).c_str());
+  ImGui::TextUnformatted(("face #" + std::to_string(instanceFace.second)).c_str());
+
+  if (instanceColoring == InstanceColoring::Color) {
+    glm::vec3 color = instanceColors.getValue(instanceFace.first);
+    ImGui::ColorEdit3("color", &color[0], ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_NoPicker);
+  }
+  if (instanceColoring == InstanceColoring::Scalar) {
+    ImGui::Text("value: %g", instanceValues.getValue(instanceFace.first));
+  }
+}
+
+void InstancedMesh::draw() {
+  if (!isEnabled() || nInstances() == 0) {
+    return;
+  }
+
+  if (getCullWholeElements()) setCullWholeElements(false); // whole elements not supported
+  render::engine->setBackfaceCull(backFacePolicy.get() == BackFacePolicy::Cull);
+
+  // If there is no dominant quantity, then this class is responsible for drawing the mesh
+  if (dominantQuantity == nullptr) {
+
+    // Ensure we have prepared buffers
+    ensureRenderProgramPrepared();
+
+    // Set program uniforms
+    setStructureUniforms(*program);
+    setInstancedMeshUniforms(*program);
+    render::engine->setMaterialUniforms(*program, material.get());
+    if (instanceColoring == InstanceColoring::Uniform) {
+      program->setUniform("u_baseColor", surfaceColor.get());
+    }
+    if (instanceColoring == InstanceColoring::Scalar) {
+      program->setUniform("u_rangeLow", static_cast<float>(instanceValueRange.first));
+      program->setUniform("u_rangeHigh", static_cast<float>(instanceValueRange.second));
+      // the color map is a row of the shared atlas, so changing it does not need a refresh()
+      program->setUniform("u_colormapRow", render::engine->getColorMapAtlasRow(cMap.get()));
+    }
+
+    // Draw all instances
+    program->draw();
+  }
+
+  // Draw the quantities
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->draw();
+  }
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->draw();
+  }
+}
+
+void InstancedMesh::drawDelayed() {
+  if (!isEnabled()) {
+    return;
+  }
+
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->drawDelayed();
+  }
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->drawDelayed();
+  }
+}
+
+void InstancedMesh::drawPick() {
+  if (!isEnabled() || nInstances() == 0) {
+    return;
+  }
+
+  // Ensure we have prepared buffers
+  ensurePickProgramPrepared();
+
+  if (getCullWholeElements()) setCullWholeElements(false); // whole elements not supported
+  render::engine->setBackfaceCull(backFacePolicy.get() == BackFacePolicy::Cull);
+
+  // Set uniforms
+  setStructureUniforms(*pickProgram);
+  setInstancedMeshUniforms(*pickProgram, false);
+
+  pickProgram->draw();
+}
+
+void InstancedMesh::setInstancedMeshUniforms(render::ShaderProgram& p, bool withSurfaceShade) {
+
+  // for the tri-flat shading
+  glm::mat4 P = view::getCameraPerspectiveMatrix();
+  glm::mat4 Pinv = glm::inverse(P);
+  p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
+  p.setUniform("u_viewport", render::engine->getCurrentViewport());
+
+  if (withSurfaceShade) {
+
+    if (backFacePolicy.get() == BackFacePolicy::Custom) {
+      p.setUniform("u_backfaceColor", getBackFaceColor());
+    }
+  }
+}
+
+void InstancedMesh::ensureRenderProgramPrepared() {
+  // If already prepared, do nothing
+  if (program) return;
+
+  std::vector<std::string> colorRules;
+  switch (instanceColoring) {
+  case InstanceColoring::Uniform:
+    colorRules = {"SHADE_BASECOLOR"};
+    break;
+  case InstanceColoring::Color:
+    colorRules = {"INSTANCED_MESH_PROPAGATE_COLOR", "SHADE_COLOR"};
+    break;
+  case InstanceColoring::Scalar:
+    colorRules = {"INSTANCED_MESH_PROPAGATE_VALUE", "SHADE_COLORMAP_VALUE"};
+    break;
+  }
+  colorRules.push_back("COMPUTE_SHADE_NORMAL_FROM_POSITION");
+  colorRules.push_back("PROJ_AND_INV_PROJ_MAT");
+
+  // clang-format off
+  program = render::engine->requestShader("INSTANCED_MESH",
+    render::engine->addMaterialRules(getMaterial(),
+      addInstancedMeshRules(colorRules)
+    )
+  );
+  // clang-format on
+
+  setInstancedMeshProgramGeometryAttributes(*program);
+  if (instanceColoring == InstanceColoring::Color) {
+    program->setAttribute("a_instanceColor", instanceColors.getRenderAttributeBuffer());
+  }
+  if (instanceColoring == InstanceColoring::Scalar) {
+    program->setAttribute("a_instanceValue", instanceValues.getRenderAttributeBuffer());
+    program->setTextureFromColormap("t_colormap", cMap.get());
+  }
+
+  render::engine->setMaterial(*program, getMaterial());
+}
+
+void InstancedMesh::ensurePickProgramPrepared() {
+
+  // If already prepared, do nothing
+  if (pickProgram) return;
+
+  // clang-format off
+  pickProgram = render::engine->requestShader("INSTANCED_MESH",
+    addInstancedMeshRules(
+      {
+        "INSTANCED_MESH_PROPAGATE_PICK", "COMPUTE_SHADE_NORMAL_FROM_POSITION", "PROJ_AND_INV_PROJ_MAT"
+      }
+    , false), render::ShaderReplacementDefaults::Pick
+  );
+  // clang-format on
+
+  setInstancedMeshProgramGeometryAttributes(*pickProgram);
+
+  // Request pick indices, one for each face of each instance. The shader adds the face index to the start index of
+  // the instance.
+  pickStart = pick::requestPickBufferRange(this, nInstances() * nFaces());
+  std::vector<glm::vec3> instancePickStarts(nInstances());
+  for (size_t i = 0; i < nInstances(); i++) {
+    instancePickStarts[i] = pick::indToVec(pickStart + i * nFaces());
+  }
+  pickProgram->setAttribute("a_instancePickStart", instancePickStarts);
+}
+
+std::vector<std::string> InstancedMesh::addInstancedMeshRules(std::vector<std::string> initRules,
+                                                              bool withSurfaceShade) {
+
+  initRules = addStructureRules(initRules);
+
+  if (withSurfaceShade) {
+    // rules that only get used when we're shading the surface of the mesh
+
+    if (backFacePolicy.get() == BackFacePolicy::Different) {
+      initRules.push_back("MESH_BACKFACE_DARKEN");
+    }
+    if (backFacePolicy.get() == BackFacePolicy::Custom) {
+      initRules.push_back("MESH_BACKFACE_DIFFERENT");
+    }
+  }
+
+  if (backFacePolicy.get() == BackFacePolicy::Identical || backFacePolicy.get() == BackFacePolicy::Different ||
+      backFacePolicy.get() == BackFacePolicy::Custom) {
+    initRules.push_back("MESH_BACKFACE_NORMAL_FLIP");
+  }
+
+  return initRules;
+}
+
+void InstancedMesh::setInstancedMeshProgramGeometryAttributes(render::ShaderProgram& p) {
+  p.setAttribute("a_vertexPositions", cornerPositions.getRenderAttributeBuffer());
+  p.setAttribute("a_instanceTransform", instanceTransforms.getRenderAttributeBuffer());
+  p.setInstanceCount(static_cast<uint32_t>(nInstances()));
+}
+
+void InstancedMesh::updateInstanceTransforms(const std::vector<glm::mat4>& newTransforms) {
+  bool sizeChanged = newTransforms.size() != nInstances();
+
+  instanceTransforms.data = transformsToColumns(newTransforms);
+  instanceTransforms.markHostBufferUpdated();
+
+  if (sizeChanged) {
+    // per-instance colors and values no longer match
+    clearInstanceColors();
+    refresh();
+  }
+  updateObjectSpaceBounds();
+  updateStructureExtents();
+  requestRedraw();
+}
+
+void InstancedMesh::setInstanceColorsImpl(std::vector<glm::vec3> colors) {
+  instanceColors.data = std::move(colors);
+  instanceColors.markHostBufferUpdated();
+  if (instanceColoring != InstanceColoring::Color) {
+    instanceColoring = InstanceColoring::Color;
+    program.reset();
+  }
+  requestRedraw();
+}
+
+void InstancedMesh::setInstanceScalarsImpl(std::vector<float> values) {
+  instanceValues.data = std::move(values);
+  instanceValues.markHostBufferUpdated();
+
+  instanceValueRange = std::make_pair(0., 1.);
+  if (!instanceValues.data.empty()) {
+    auto minmax = std::minmax_element(instanceValues.data.begin(), instanceValues.data.end());
+    instanceValueRange = std::make_pair(*minmax.first, *minmax.second);
+  }
+
+  if (instanceColoring != InstanceColoring::Scalar) {
+    instanceColoring = InstanceColoring::Scalar;
+    program.reset();
+  }
+  requestRedraw();
+}
+
+void InstancedMesh::clearInstanceColors() {
+  if (instanceColoring == InstanceColoring::Uniform) return;
+  instanceColoring = InstanceColoring::Uniform;
+  program.reset();
+  requestRedraw();
+}
+
+void InstancedMesh::refresh() {
+  program.reset();
+  pickProgram.reset();
+  requestRedraw();
+  QuantityStructure<InstancedMesh>::refresh(); // call base class version, which refreshes quantities
+}
+
+void InstancedMesh::updateObjectSpaceBounds() {
+
+  vertices.ensureHostBufferPopulated();
+  instanceTransforms.ensureHostBufferPopulated();
+
+  // bounds of the mesh itself
+  glm::vec3 meshMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  glm::vec3 meshMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (const glm::vec3& p : vertices.data) {
+    meshMin = componentwiseMin(meshMin, p);
+    meshMax = componentwiseMax(meshMax, p);
+  }
+
+  // the instances place the mesh's bounding box, take the bounds of its transformed corners
+  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  if (!vertices.data.empty()) {
+    for (size_t i = 0; i < nInstances(); i++) {
+      const std::vector<glm::vec4>& cols = instanceTransforms.data;
+      glm::mat4 T(cols[4 * i + 0], cols[4 * i + 1], cols[4 * i + 2], cols[4 * i + 3]);
+      for (int c = 0; c < 8; c++) {
+        glm::vec3 corner{(c & 1) ? meshMax.x : meshMin.x, (c & 2) ? meshMax.y : meshMin.y,
+                         (c & 4) ? meshMax.z : meshMin.z};
+        glm::vec4 p = T * glm::vec4(corner, 1.f);
+        glm::vec3 pos = glm::vec3(p) / p.w;
+        min = componentwiseMin(min, pos);
+        max = componentwiseMax(max, pos);
+      }
+    }
+  }
+  objectSpaceBoundingBox = std::make_tuple(min, max);
+
+  // length scale, as the diagonal of the bounding box
+  objectSpaceLengthScale = (nInstances() > 0 && !vertices.data.empty()) ? glm::length(max - min) : 0.f;
+}
+
+std::string InstancedMesh::typeName() { return structureTypeName; }
+
+InstancedMesh* registerInstancedMesh(std::string name, SimpleTriangleMesh& source,
+                                     const std::vector<glm::mat4>& transforms) {
+  source.vertices.ensureHostBufferPopulated();
+  source.faces.ensureHostBufferPopulated();
+  return registerInstancedMesh(name, source.vertices.data, source.faces.data, transforms);
+}
+
+// === Option getters and setters
+
+
+InstancedMesh* InstancedMesh::setSurfaceColor(glm::vec3 val) {
+  surfaceColor = val;
+  requestRedraw();
+  return this;
+}
+glm::vec3 InstancedMesh::getSurfaceColor() { return surfaceColor.get(); }
+
+InstancedMesh* InstancedMesh::setMaterial(std::string m) {
+  bool needsRefresh = render::engine->materialChangeNeedsRefresh(material.get(), m);
+  material = m;
+  if (needsRefresh) refresh();
+  requestRedraw();
+  return this;
+}
+std::string InstancedMesh::getMaterial() { return material.get(); }
+
+InstancedMesh* InstancedMesh::setColorMap(std::string val) {
+  cMap = val;
+  requestRedraw();
+  return this;
+}
+std::string InstancedMesh::getColorMap() { return cMap.get(); }
+
+InstancedMesh* InstancedMesh::setBackFacePolicy(BackFacePolicy newPolicy) {
+  backFacePolicy = newPolicy;
+  refresh();
+  requestRedraw();
+  return this;
+}
+BackFacePolicy InstancedMesh::getBackFacePolicy() { return backFacePolicy.get(); }
+
+InstancedMesh* InstancedMesh::setBackFaceColor(glm::vec3 val) {
+  backFaceColor = val;
+  requestRedraw();
+  return this;
+}
+
+glm::vec3 InstancedMesh::getBackFaceColor() { return backFaceColor.get(); }
+
+
+} // namespace polyscope
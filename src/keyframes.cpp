@@ -0,0 +1,128 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/keyframes.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace polyscope {
+
+namespace {
+
+// Elements are laid out in rows of this many texels, one layer per frame. Widely supported limit for each dimension of
+// a 3D texture.
+const size_t keyframeTextureDim = 2048;
+
+size_t keyframeTextureWidth(size_t nElements) { return std::max<size_t>(std::min(nElements, keyframeTextureDim), 1); }
+
+size_t keyframeTextureHeight(size_t nElements) {
+  size_t width = keyframeTextureWidth(nElements);
+  return std::max<size_t>((nElements + width - 1) / width, 1);
+}
+
+void validateKeyframeSizes(const std::string& name, size_t nFrames, const std::vector<size_t>& frameSizes) {
+  if (nFrames == 0) {
+    exception("keyframes [" + name + "] must have at least one frame");
+  }
+  for (size_t iFrame = 0; iFrame < nFrames; iFrame++) {
+    if (frameSizes[iFrame] != frameSizes[0]) {
+      exception("keyframes [" + name + "] frame " + std::to_string(iFrame) + " has " +
+                std::to_string(frameSizes[iFrame]) + " elements, but frame 0 has " + std::to_string(frameSizes[0]));
+    }
+  }
+  if (nFrames > keyframeTextureDim || keyframeTextureHeight(frameSizes[0]) > keyframeTextureDim) {
+    exception("keyframes [" + name + "] have too many frames or elements to fit in a texture");
+  }
+}
+
+} // namespace
+
+KeyframeSeries::KeyframeSeries(std::string name_, const std::vector<std::vector<glm::vec3>>& frames)
+    : name(name_), nFrames_(frames.size()), nElements_(frames.empty() ? 0 : frames[0].size()), nComponents(3) {
+
+  std::vector<size_t> frameSizes;
+  for (const std::vector<glm::vec3>& frame : frames) frameSizes.push_back(frame.size());
+  validateKeyframeSizes(name, nFrames_, frameSizes);
+
+  glm::vec3 bboxMin{std::numeric_limits<float>::infinity()};
+  glm::vec3 bboxMax{-std::numeric_limits<float>::infinity()};
+  data.resize(nFrames_ * keyframeTextureWidth(nElements_) * keyframeTextureHeight(nElements_) * nComponents, 0.);
+  for (size_t iFrame = 0; iFrame < nFrames_; iFrame++) {
+    for (const glm::vec3& p : frames[iFrame]) {
+      bboxMin = componentwiseMin(bboxMin, p);
+      bboxMax = componentwiseMax(bboxMax, p);
+    }
+    packFrame(iFrame, nElements_ ? &frames[iFrame][0].x : nullptr, nElements_);
+  }
+
+  boundingBox_ = std::make_tuple(bboxMin, bboxMax);
+  dataRange_ = std::make_pair(0., 0.);
+}
+
+KeyframeSeries::KeyframeSeries(std::string name_, const std::vector<std::vector<float>>& frames)
+    : name(name_), nFrames_(frames.size()), nElements_(frames.empty() ? 0 : frames[0].size()), nComponents(1) {
+
+  std::vector<size_t> frameSizes;
+  for (const std::vector<float>& frame : frames) frameSizes.push_back(frame.size());
+  validateKeyframeSizes(name, nFrames_, frameSizes);
+
+  double minVal = std::numeric_limits<double>::infinity();
+  double maxVal = -std::numeric_limits<double>::infinity();
+  data.resize(nFrames_ * keyframeTextureWidth(nElements_) * keyframeTextureHeight(nElements_), 0.);
+  for (size_t iFrame = 0; iFrame < nFrames_; iFrame++) {
+    for (float v : frames[iFrame]) {
+      if (!std::isfinite(v)) continue;
+      minVal = std::min(minVal, static_cast<double>(v));
+      maxVal = std::max(maxVal, static_cast<double>(v));
+    }
+    packFrame(iFrame, nElements_ ? &frames[iFrame][0] : nullptr, nElements_);
+  }
+
+  if (minVal > maxVal) { // no finite values
+    minVal = maxVal = 0.;
+  }
+  boundingBox_ = std::make_tuple(glm::vec3{0., 0., 0.}, glm::vec3{0., 0., 0.});
+  dataRange_ = std::make_pair(minVal, maxVal);
+}
+
+void KeyframeSeries::packFrame(size_t iFrame, const float* frameData, size_t frameSize) {
+  size_t frameFloats = keyframeTextureWidth(nElements_) * keyframeTextureHeight(nElements_) * nComponents;
+  std::copy(frameData, frameData + frameSize * nComponents, data.begin() + iFrame * frameFloats);
+}
+
+std::shared_ptr<render::TextureBuffer> KeyframeSeries::getTexture() {
+  if (!texture) {
+    TextureFormat format = nComponents == 3 ? TextureFormat::RGB32F : TextureFormat::R32F;
+    texture = render::engine->generateTextureBuffer(
+        format, static_cast<unsigned int>(keyframeTextureWidth(nElements_)),
+        static_cast<unsigned int>(keyframeTextureHeight(nElements_)), static_cast<unsigned int>(nFrames_), &data[0]);
+
+    // the frames only live on the device from here on
+    data.clear();
+    data.shrink_to_fit();
+  }
+  return texture;
+}
+
+void keyframeInterval(float time, size_t nFrames, int& frameA, int& frameB, float& weight) {
+  float lastFrame = static_cast<float>(nFrames > 0 ? nFrames - 1 : 0);
+  time = std::isfinite(time) ? std::min(std::max(time, 0.f), lastFrame) : 0.f;
+  frameA = static_cast<int>(std::floor(time));
+  frameB = std::min(frameA + 1, static_cast<int>(lastFrame));
+  weight = time - static_cast<float>(frameA);
+}
+
+void addKeyframeRule(std::vector<std::string>& rules, std::string rule, bool withIndex) {
+  auto addOnce = [&](const std::string& r) {
+    if (std::find(rules.begin(), rules.end(), r) == rules.end()) rules.push_back(r);
+  };
+  addOnce("KEYFRAME_COMMON");
+  if (withIndex) addOnce("KEYFRAME_INDEX");
+  addOnce(rule);
+}
+
+} // namespace polyscope
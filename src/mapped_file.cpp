@@ -0,0 +1,51 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/mapped_file.h"
+
+#include "polyscope/messages.h"
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace polyscope {
+
+MappedFile::MappedFile(const std::string& filename) {
+#ifdef _WIN32
+  // no mmap here, read the whole file instead
+  std::ifstream in(filename, std::ios::binary | std::ios::ate);
+  if (!in) exception("could not open file " + filename);
+  contents.resize(static_cast<size_t>(in.tellg()));
+  in.seekg(0);
+  if (!contents.empty()) in.read(reinterpret_cast<char*>(&contents[0]), contents.size());
+  if (!in) exception("could not read file " + filename);
+  data = contents.empty() ? nullptr : &contents[0];
+  size = contents.size();
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) exception("could not open file " + filename);
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    exception("could not read file " + filename);
+  }
+  void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping stays valid
+  if (mapped == MAP_FAILED) exception("could not map file " + filename);
+  data = static_cast<const unsigned char*>(mapped);
+  size = static_cast<size_t>(st.st_size);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if (data != nullptr) munmap(const_cast<unsigned char*>(data), size);
+#endif
+}
+
+} // namespace polyscope
@@ -1,2 +1,211 @@
 #define MC_IMPLEM_ENABLE
 #include "MarchingCube/MC.h"
+
+#include "polyscope/marching_cubes.h"
+
+#include "polyscope/parallel.h"
+#include "polyscope/trace.h"
+
+#include <algorithm>
+
+namespace polyscope {
+
+namespace {
+
+const uint32_t MC_NO_VERTEX = 0xFFFFFFFF;
+const uint32_t MC_SEAM_FLAG = 0x80000000; // marks a key for a seam vertex, owned by the previous slab
+
+// Seam keys in the indices are MC_SEAM_FLAG | seam edge key
+typedef MarchingCubesSlabCache::Slab MarchingCubesSlab;
+
+// Slabs hold roughly this many cells, independent of the thread count so that they stay fixed between extractions
+const size_t MC_SLAB_CELLS = 1 << 16;
+
+// Process the cells with x in [xBegin, xEnd), which touch the node planes [xBegin, xEnd]. Unless this is the first
+// slab, vertices on the edges of the plane xBegin are left to the previous slab and referenced by key.
+void marchingCubesSlab(const float* field, float isoval, uint32_t ny, uint32_t nz, uint32_t xBegin, uint32_t xEnd,
+                       bool firstSlab, MarchingCubesSlab& slab) {
+
+  const size_t planeSize = static_cast<size_t>(ny) * nz;
+  auto value = [&](uint32_t x, uint32_t y, uint32_t z) {
+    return field[(static_cast<size_t>(x) * ny + y) * nz + z] - isoval;
+  };
+
+  auto edgeVertex = [&](uint32_t x, uint32_t y, uint32_t z, int axis, float va, float vb) -> uint32_t {
+    if ((va < 0.0) == (vb < 0.0)) return MC_NO_VERTEX;
+    glm::vec3 v(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
+    v[axis] += va / (va - vb);
+    slab.vertices.push_back(v);
+    return static_cast<uint32_t>(slab.vertices.size() - 1);
+  };
+
+  // For each node of a plane, the vertices on the edges leaving it along +x, +y, and +z
+  auto fillPlane = [&](std::vector<uint32_t>& plane, uint32_t x) {
+    bool isSeam = x == xBegin && !firstSlab;
+    bool hasXEdges = x < xEnd; // x-edges from the last plane belong to the next slab
+    for (uint32_t y = 0; y < ny; y++) {
+      for (uint32_t z = 0; z < nz; z++) {
+        size_t iNode = static_cast<size_t>(y) * nz + z;
+        float v = value(x, y, z);
+        plane[3 * iNode + 0] = hasXEdges ? edgeVertex(x, y, z, 0, v, value(x + 1, y, z)) : MC_NO_VERTEX;
+        if (isSeam) {
+          plane[3 * iNode + 1] = MC_SEAM_FLAG | static_cast<uint32_t>(2 * iNode + 0);
+          plane[3 * iNode + 2] = MC_SEAM_FLAG | static_cast<uint32_t>(2 * iNode + 1);
+        } else {
+          plane[3 * iNode + 1] = (y + 1 < ny) ? edgeVertex(x, y, z, 1, v, value(x, y + 1, z)) : MC_NO_VERTEX;
+          plane[3 * iNode + 2] = (z + 1 < nz) ? edgeVertex(x, y, z, 2, v, value(x, y, z + 1)) : MC_NO_VERTEX;
+        }
+      }
+    }
+  };
+
+  std::vector<uint32_t> planeCurr(3 * planeSize);
+  std::vector<uint32_t> planeNext(3 * planeSize);
+  fillPlane(planeCurr, xBegin);
+
+  for (uint32_t x = xBegin; x < xEnd; x++) {
+    fillPlane(planeNext, x + 1);
+
+    for (uint32_t y = 0; y + 1 < ny; y++) {
+      for (uint32_t z = 0; z + 1 < nz; z++) {
+
+        // Corner and edge numbering matches MC::marching_cube()
+        float vs[8] = {value(x, y, z),         value(x + 1, y, z),         value(x, y + 1, z),
+                       value(x + 1, y + 1, z), value(x, y, z + 1),         value(x + 1, y, z + 1),
+                       value(x, y + 1, z + 1), value(x + 1, y + 1, z + 1)};
+        int config = 0;
+        for (int i = 0; i < 8; i++) {
+          config |= (vs[i] < 0) << i;
+        }
+        if (config == 0 || config == 255) continue;
+
+        size_t n00 = static_cast<size_t>(y) * nz + z;
+        size_t n10 = n00 + nz;
+        size_t n01 = n00 + 1;
+        size_t n11 = n10 + 1;
+        uint32_t edges[12] = {
+            planeCurr[3 * n00 + 0], planeCurr[3 * n10 + 0], planeCurr[3 * n01 + 0], planeCurr[3 * n11 + 0],
+            planeCurr[3 * n00 + 1], planeNext[3 * n00 + 1], planeCurr[3 * n01 + 1], planeNext[3 * n01 + 1],
+            planeCurr[3 * n00 + 2], planeNext[3 * n00 + 2], planeCurr[3 * n10 + 2], planeNext[3 * n10 + 2],
+        };
+
+        const uint64_t tris = MC::mc_internalMarching_cube_tris[config];
+        const size_t nIndices = 3 * (tris & 0xF);
+        for (size_t i = 0; i < nIndices; i++) {
+          slab.indices.push_back(edges[(tris >> (4 + 4 * i)) & 0xF]);
+        }
+      }
+    }
+
+    std::swap(planeCurr, planeNext);
+  }
+
+  // planeCurr now holds plane xEnd, which the next slab shares
+  slab.topSeam.resize(2 * planeSize);
+  for (size_t iNode = 0; iNode < planeSize; iNode++) {
+    slab.topSeam[2 * iNode + 0] = planeCurr[3 * iNode + 1];
+    slab.topSeam[2 * iNode + 1] = planeCurr[3 * iNode + 2];
+  }
+}
+
+} // namespace
+
+void marchingCubes(const float* field, float isoval, uint32_t nx, uint32_t ny, uint32_t nz,
+                   std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices) {
+  MarchingCubesSlabCache cache;
+  cache.extract(field, isoval, nx, ny, nz, vertices, indices);
+}
+
+void MarchingCubesSlabCache::extract(const float* field, float isoval_, uint32_t nx, uint32_t ny, uint32_t nz,
+                                     std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices) {
+  POLYSCOPE_TRACE_SPAN("marchingCubes");
+
+  vertices.clear();
+  indices.clear();
+  lastExtractedSlabCount = 0;
+  if (nx < 2 || ny < 2 || nz < 2) {
+    slabs.clear();
+    dim = glm::uvec3{0, 0, 0};
+    return;
+  }
+
+  // Split in to slabs of cells along x
+  if (glm::uvec3{nx, ny, nz} != dim || isoval_ != isoval) {
+    dim = glm::uvec3{nx, ny, nz};
+    isoval = isoval_;
+    const size_t planeSize = static_cast<size_t>(ny) * nz;
+    const uint32_t nCellPlanes = nx - 1;
+    uint32_t slabPlanes = static_cast<uint32_t>(std::max<size_t>(MC_SLAB_CELLS / planeSize, 1));
+    if (2 * planeSize >= MC_SEAM_FLAG) slabPlanes = nCellPlanes; // seam keys would not fit, process serially
+    size_t nSlabs = (nCellPlanes + slabPlanes - 1) / slabPlanes;
+    slabs.clear();
+    slabs.resize(nSlabs);
+    for (size_t iSlab = 0; iSlab < nSlabs; iSlab++) {
+      slabs[iSlab].xBegin = static_cast<uint32_t>(iSlab * slabPlanes);
+      slabs[iSlab].xEnd = std::min(slabs[iSlab].xBegin + slabPlanes, nCellPlanes);
+    }
+  }
+  const size_t nSlabs = slabs.size();
+
+  std::vector<size_t> staleSlabs;
+  for (size_t iSlab = 0; iSlab < nSlabs; iSlab++) {
+    if (!slabs[iSlab].valid) staleSlabs.push_back(iSlab);
+  }
+  lastExtractedSlabCount = staleSlabs.size();
+  parallelFor(
+      0, staleSlabs.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          MarchingCubesSlab& slab = slabs[staleSlabs[i]];
+          slab.vertices.clear();
+          slab.indices.clear();
+          marchingCubesSlab(field, isoval, ny, nz, slab.xBegin, slab.xEnd, staleSlabs[i] == 0, slab);
+          slab.valid = true;
+        }
+      },
+      1);
+
+  // Concatenate the slabs, resolving references to seam vertices
+  std::vector<size_t> vertexOffset(nSlabs + 1, 0);
+  std::vector<size_t> indexOffset(nSlabs + 1, 0);
+  for (size_t iSlab = 0; iSlab < nSlabs; iSlab++) {
+    vertexOffset[iSlab + 1] = vertexOffset[iSlab] + slabs[iSlab].vertices.size();
+    indexOffset[iSlab + 1] = indexOffset[iSlab] + slabs[iSlab].indices.size();
+  }
+  vertices.resize(vertexOffset[nSlabs]);
+  indices.resize(indexOffset[nSlabs]);
+
+  parallelFor(
+      0, nSlabs,
+      [&](size_t begin, size_t end) {
+        for (size_t iSlab = begin; iSlab < end; iSlab++) {
+          const MarchingCubesSlab& slab = slabs[iSlab];
+          std::copy(slab.vertices.begin(), slab.vertices.end(), vertices.begin() + vertexOffset[iSlab]);
+          for (size_t i = 0; i < slab.indices.size(); i++) {
+            uint32_t ind = slab.indices[i];
+            if (iSlab > 0 && (ind & MC_SEAM_FLAG)) {
+              ind = static_cast<uint32_t>(vertexOffset[iSlab - 1]) + slabs[iSlab - 1].topSeam[ind & ~MC_SEAM_FLAG];
+            } else {
+              ind += static_cast<uint32_t>(vertexOffset[iSlab]);
+            }
+            indices[indexOffset[iSlab] + i] = ind;
+          }
+        }
+      },
+      1);
+}
+
+void MarchingCubesSlabCache::invalidate() {
+  for (Slab& slab : slabs) slab.valid = false;
+}
+
+void MarchingCubesSlabCache::invalidateNodePlanes(uint32_t xBegin, uint32_t xEnd) {
+  // a slab's cells [slab.xBegin, slab.xEnd) touch the node planes [slab.xBegin, slab.xEnd]
+  for (Slab& slab : slabs) {
+    if (slab.xBegin < xEnd && xBegin <= slab.xEnd) slab.valid = false;
+  }
+}
+
+size_t MarchingCubesSlabCache::getLastExtractedSlabCount() const { return lastExtractedSlabCount; }
+
+} // namespace polyscope
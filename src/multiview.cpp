@@ -0,0 +1,149 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/multiview.h"
+
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/view.h"
+
+#include <cmath>
+#include <limits>
+
+namespace polyscope {
+
+namespace {
+
+struct MultiviewCamera {
+  glm::mat4 viewMat;
+  glm::vec2 shift; // of the projection in NDC
+};
+
+// Render each camera at the given size and read the images back. The rest of the view state is set by the caller.
+std::vector<std::vector<unsigned char>> renderMultiview(const std::vector<MultiviewCamera>& cameras, int width,
+                                                        int height, bool transparentBG) {
+  if (!isInitialized()) {
+    exception("must initialize Polyscope with polyscope::init() before rendering");
+  }
+
+  render::engine->makeContextCurrent();
+  processLazyProperties();
+
+  // Render to the whole of the buffer, at the requested size
+  glm::mat4 initialViewMat = view::viewMat;
+  glm::vec2 initialJitter = view::projectionJitter;
+  glm::vec4 initialRegion = view::getMainViewportRegion();
+  int initialWidth = view::bufferWidth;
+  int initialHeight = view::bufferHeight;
+  bool resized = width != initialWidth || height != initialHeight;
+  if (initialRegion != glm::vec4{0., 0., 1., 1.}) view::setMainViewportRegion(glm::vec4{0., 0., 1., 1.});
+  if (resized) {
+    view::bufferWidth = width;
+    view::bufferHeight = height;
+    render::engine->resizeScreenBuffers();
+    render::engine->setScreenBufferViewports();
+  }
+
+  render::engine->useAltDisplayBuffer = true;
+  if (transparentBG) render::engine->lightCopy = true; // copy directly in to buffer without blending
+
+  // Reads may all be in flight at once, each only waits for its own render
+  std::vector<uint64_t> tickets;
+  for (const MultiviewCamera& c : cameras) {
+    view::viewMat = c.viewMat;
+    view::projectionJitter = c.shift;
+    internal::renderSceneToDisplay();
+    tickets.push_back(render::engine->displayBufferAlt->requestReadBuffer());
+  }
+
+  std::vector<std::vector<unsigned char>> images(cameras.size());
+  for (size_t i = 0; i < cameras.size(); i++) {
+    if (!render::engine->displayBufferAlt->pollReadBuffer(tickets[i], images[i], true)) {
+      warning("failed to read back multiview image");
+      continue;
+    }
+    if (!transparentBG) {
+      for (size_t iPix = 3; iPix < images[i].size(); iPix += 4) {
+        images[i][iPix] = std::numeric_limits<unsigned char>::max();
+      }
+    }
+  }
+
+  render::engine->useAltDisplayBuffer = false;
+  if (transparentBG) render::engine->lightCopy = false;
+
+  view::viewMat = initialViewMat;
+  view::projectionJitter = initialJitter;
+  if (resized) {
+    view::bufferWidth = initialWidth;
+    view::bufferHeight = initialHeight;
+    render::engine->resizeScreenBuffers();
+    render::engine->setScreenBufferViewports();
+  }
+  if (initialRegion != glm::vec4{0., 0., 1., 1.}) view::setMainViewportRegion(initialRegion);
+
+  // the scene buffers hold the last view now
+  requestRedraw();
+
+  return images;
+}
+
+} // namespace
+
+CubemapImages renderCubemap(glm::vec3 center, int faceSize, bool transparentBG) {
+  if (faceSize <= 0) {
+    exception("cubemap face size must be positive");
+  }
+
+  const std::array<glm::vec3, 6> dirs{glm::vec3{1., 0., 0.},  glm::vec3{-1., 0., 0.}, glm::vec3{0., 1., 0.},
+                                      glm::vec3{0., -1., 0.}, glm::vec3{0., 0., 1.},  glm::vec3{0., 0., -1.}};
+  const std::array<glm::vec3, 6> ups{glm::vec3{0., -1., 0.}, glm::vec3{0., -1., 0.}, glm::vec3{0., 0., 1.},
+                                     glm::vec3{0., 0., -1.}, glm::vec3{0., -1., 0.}, glm::vec3{0., -1., 0.}};
+  std::vector<MultiviewCamera> cameras;
+  for (int iFace = 0; iFace < 6; iFace++) {
+    cameras.push_back(MultiviewCamera{glm::lookAt(center, center + dirs[iFace], ups[iFace]), glm::vec2{0., 0.}});
+  }
+
+  double initialFov = view::fov;
+  ProjectionMode initialProjectionMode = view::projectionMode;
+  view::fov = 90.;
+  view::projectionMode = ProjectionMode::Perspective;
+  std::vector<std::vector<unsigned char>> images = renderMultiview(cameras, faceSize, faceSize, transparentBG);
+  view::fov = initialFov;
+  view::projectionMode = initialProjectionMode;
+
+  CubemapImages result;
+  result.faceSize = faceSize;
+  for (int iFace = 0; iFace < 6; iFace++) {
+    result.faces[iFace] = std::move(images[iFace]);
+  }
+  return result;
+}
+
+StereoImages renderStereoPair(float eyeSeparation, float convergenceDistance, bool transparentBG) {
+  if (!(convergenceDistance > 0.)) {
+    exception("stereo convergence distance must be positive");
+  }
+  view::ensureViewValid();
+
+  // Moving the camera by x along its right direction is a translation by -x in view space. A point straight ahead at
+  // the convergence distance then lands at x * P[0][0] / distance in NDC, so the projection is shifted back by as much.
+  float halfSep = 0.5f * eyeSeparation;
+  float p00 = view::getCameraPerspectiveMatrix()[0][0];
+  float shift = halfSep * p00 / convergenceDistance;
+  std::vector<MultiviewCamera> cameras{
+      MultiviewCamera{glm::translate(glm::mat4(1.), glm::vec3{halfSep, 0., 0.}) * view::viewMat, glm::vec2{-shift, 0.}},
+      MultiviewCamera{glm::translate(glm::mat4(1.), glm::vec3{-halfSep, 0., 0.}) * view::viewMat, glm::vec2{shift, 0.}},
+  };
+
+  std::vector<std::vector<unsigned char>> images =
+      renderMultiview(cameras, view::bufferWidth, view::bufferHeight, transparentBG);
+
+  StereoImages result;
+  result.width = view::bufferWidth;
+  result.height = view::bufferHeight;
+  result.left = std::move(images[0]);
+  result.right = std::move(images[1]);
+  return result;
+}
+
+} // namespace polyscope
@@ -11,8 +11,11 @@ int verbosity = 2;
 std::string printPrefix = "[polyscope] ";
 bool errorsThrowExceptions = false;
 bool debugDrawPickBuffer = false;
+bool collectFrameStats = false;
 int maxFPS = 60;
 bool enableVSync = true;
+bool latePollEvents = false;
+bool idleWhenUnchanged = false;
 bool usePrefsFile = true;
 bool initializeWithDefaultStructures = true;
 bool alwaysRedraw = false;
@@ -25,6 +28,7 @@ bool hideWindowAfterShow = true;
 
 bool screenshotTransparency = true;
 std::string screenshotExtension = ".png";
+ImageFormat screenshotFormat = ImageFormat::Auto;
 
 // == Scene options
 
@@ -34,16 +38,22 @@ GroundPlaneMode groundPlaneMode = GroundPlaneMode::TileReflection;
 GroundPlaneHeightMode groundPlaneHeightMode = GroundPlaneHeightMode::Automatic;
 ScaledValue<float> groundPlaneHeightFactor = 0;
 float groundPlaneHeight = 0.;
+GroundReflectionMode groundReflectionMode = GroundReflectionMode::Mirror;
 int shadowBlurIters = 2;
 float shadowDarkness = 0.25;
 
 // Rendering options
 
 int ssaaFactor = 1;
+bool temporalAntiAliasing = false;
+int temporalAntiAliasingSamples = 16;
+bool fxaa = false;
+bool renderTargetBudget = false;
 
 // Transparency
 TransparencyMode transparencyMode = TransparencyMode::None;
 int transparencyRenderPasses = 8;
+bool depthPrepass = false;
 
 // === Advanced ImGui configuration
 
@@ -55,6 +65,29 @@ bool openImGuiWindowForUserCallback = true;
 std::function<void()> configureImGuiStyleCallback = configureImGuiStyle;
 std::function<std::tuple<ImFontAtlas*, ImFont*, ImFont*>()> prepareImGuiFontsCallback = prepareImGuiFonts;
 
+// === Performance options
+
+int numThreads = 0;
+bool frustumCulling = true;
+bool rayCastPicking = false;
+int pickRegionOfInterestSize = 32;
+bool sceneDepthCache = true;
+int sceneDepthCacheStride = 2;
+bool occlusionCulling = false;
+bool instancedVectors = false;
+bool interleaveVertexAttributes = false;
+bool suballocateSmallBuffers = true;
+bool compositeRenderImages = true;
+std::string shaderCacheDirectory = "";
+std::string derivedDataCacheDirectory = "";
+std::string eglDevice = "";
+bool asyncShaderCompilation = false;
+bool adaptiveQuality = false;
+float adaptiveQualityTargetFrameMs = 33.;
+float adaptiveQualityRestoreDelay = 0.25;
+float histogramRebuildPeriod = 0.25;
+size_t histogramMaxSamples = 1 << 20;
+bool rememberRemovedStructureSettings = true;
 
 // enabled by default in debug mode
 #ifndef NDEBUG
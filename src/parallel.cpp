@@ -0,0 +1,72 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/parallel.h"
+
+#include "polyscope/options.h"
+#include "polyscope/tasks.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace polyscope {
+
+size_t getNumThreads() {
+  if (options::numThreads > 0) {
+    return static_cast<size_t>(options::numThreads);
+  }
+  size_t hw = std::thread::hardware_concurrency();
+  return std::max<size_t>(hw, 1);
+}
+
+size_t parallelChunkCount(size_t count, size_t minChunkSize) {
+  minChunkSize = std::max<size_t>(minChunkSize, 1);
+  size_t nChunks = std::min(getNumThreads(), count / minChunkSize);
+  return std::max<size_t>(nChunks, 1);
+}
+
+void parallelForChunks(size_t start, size_t end, size_t nChunks,
+                       const std::function<void(size_t iChunk, size_t chunkBegin, size_t chunkEnd)>& func) {
+
+  if (end <= start) return;
+  size_t count = end - start;
+  nChunks = std::max<size_t>(std::min(nChunks, count), 1);
+
+  auto chunkBound = [&](size_t iChunk) { return start + (count * iChunk) / nChunks; };
+
+  if (nChunks == 1) {
+    func(0, start, end);
+    return;
+  }
+
+  // One job per chunk; an error is reported from the earliest chunk, so the result matches a serial loop
+  tasks::runJobs(nChunks, [&](size_t iChunk) { func(iChunk, chunkBound(iChunk), chunkBound(iChunk + 1)); });
+}
+
+void parallelFor(size_t start, size_t end, const std::function<void(size_t chunkBegin, size_t chunkEnd)>& func,
+                 size_t minChunkSize) {
+  if (end <= start) return;
+  size_t nChunks = parallelChunkCount(end - start, minChunkSize);
+  parallelForChunks(start, end, nChunks, [&](size_t, size_t chunkBegin, size_t chunkEnd) { func(chunkBegin, chunkEnd); });
+}
+
+void parallelForTiles(size_t start, size_t end, size_t tileSize, size_t nThreads,
+                      const std::function<void(size_t tileBegin, size_t tileEnd)>& func) {
+  if (end <= start) return;
+  tileSize = std::max<size_t>(tileSize, 1);
+  size_t nTiles = (end - start + tileSize - 1) / tileSize;
+  if (nThreads == 0) nThreads = getNumThreads();
+  nThreads = std::min(nThreads, nTiles);
+
+  std::atomic<size_t> nextTile{0};
+  parallelForChunks(0, nThreads, nThreads, [&](size_t, size_t, size_t) {
+    while (true) {
+      size_t iTile = nextTile++;
+      if (iTile >= nTiles) return;
+      size_t tileBegin = start + iTile * tileSize;
+      func(tileBegin, std::min(tileBegin + tileSize, end));
+    }
+  });
+}
+
+} // namespace polyscope
@@ -6,20 +6,52 @@
 
 namespace polyscope {
 namespace detail {
-// storage for persistent value global caches
+// storage for persistent value global caches. These are never destroyed, since persistent values release their slots
+// on destruction, which may come after static destruction in other translation units.
 // clang-format off
-PersistentCache<double> persistentCache_double;
-PersistentCache<float> persistentCache_float;
-PersistentCache<bool> persistentCache_bool;
-PersistentCache<std::string> persistentCache_string;
-PersistentCache<glm::vec3> persistentCache_glmvec3;
-PersistentCache<glm::mat4> persistentCache_glmmat4;
-PersistentCache<ScaledValue<double>> persistentCache_scaleddouble;
-PersistentCache<ScaledValue<float>> persistentCache_scaledfloat;
-PersistentCache<std::vector<std::string>> persistentCache_vectorstring;
-PersistentCache<ParamVizStyle> persistentCache_paramVizStyle;
-PersistentCache<BackFacePolicy> persistentCache_BackFacePolicy;
-PersistentCache<MeshShadeStyle> persistentCache_MeshNormalType;
+PersistentCache<double>& persistentCache_double = *new PersistentCache<double>();
+PersistentCache<float>& persistentCache_float = *new PersistentCache<float>();
+PersistentCache<bool>& persistentCache_bool = *new PersistentCache<bool>();
+PersistentCache<std::string>& persistentCache_string = *new PersistentCache<std::string>();
+PersistentCache<glm::vec3>& persistentCache_glmvec3 = *new PersistentCache<glm::vec3>();
+PersistentCache<glm::mat4>& persistentCache_glmmat4 = *new PersistentCache<glm::mat4>();
+PersistentCache<ScaledValue<double>>& persistentCache_scaleddouble = *new PersistentCache<ScaledValue<double>>();
+PersistentCache<ScaledValue<float>>& persistentCache_scaledfloat = *new PersistentCache<ScaledValue<float>>();
+PersistentCache<std::vector<std::string>>& persistentCache_vectorstring = *new PersistentCache<std::vector<std::string>>();
+PersistentCache<ParamVizStyle>& persistentCache_paramVizStyle = *new PersistentCache<ParamVizStyle>();
+PersistentCache<BackFacePolicy>& persistentCache_BackFacePolicy = *new PersistentCache<BackFacePolicy>();
+PersistentCache<MeshShadeStyle>& persistentCache_MeshNormalType = *new PersistentCache<MeshShadeStyle>();
 // clang-format on
+
+void clearPersistentCaches(const std::string& prefix) {
+  persistentCache_double.clearPrefix(prefix);
+  persistentCache_float.clearPrefix(prefix);
+  persistentCache_bool.clearPrefix(prefix);
+  persistentCache_string.clearPrefix(prefix);
+  persistentCache_glmvec3.clearPrefix(prefix);
+  persistentCache_glmmat4.clearPrefix(prefix);
+  persistentCache_scaleddouble.clearPrefix(prefix);
+  persistentCache_scaledfloat.clearPrefix(prefix);
+  persistentCache_vectorstring.clearPrefix(prefix);
+  persistentCache_paramVizStyle.clearPrefix(prefix);
+  persistentCache_BackFacePolicy.clearPrefix(prefix);
+  persistentCache_MeshNormalType.clearPrefix(prefix);
+}
+
+void clearPersistentCaches(const std::unordered_set<std::string>& prefixes) {
+  if (prefixes.empty()) return;
+  persistentCache_double.clearPrefixes(prefixes);
+  persistentCache_float.clearPrefixes(prefixes);
+  persistentCache_bool.clearPrefixes(prefixes);
+  persistentCache_string.clearPrefixes(prefixes);
+  persistentCache_glmvec3.clearPrefixes(prefixes);
+  persistentCache_glmmat4.clearPrefixes(prefixes);
+  persistentCache_scaleddouble.clearPrefixes(prefixes);
+  persistentCache_scaledfloat.clearPrefixes(prefixes);
+  persistentCache_vectorstring.clearPrefixes(prefixes);
+  persistentCache_paramVizStyle.clearPrefixes(prefixes);
+  persistentCache_BackFacePolicy.clearPrefixes(prefixes);
+  persistentCache_MeshNormalType.clearPrefixes(prefixes);
+}
 } // namespace detail
 } // namespace polyscope
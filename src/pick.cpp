@@ -3,10 +3,16 @@
 #include "polyscope/pick.h"
 
 #include "polyscope/polyscope.h"
+#include "polyscope/trace.h"
 
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 
 namespace polyscope {
 namespace pick {
@@ -18,38 +24,162 @@ bool haveSelectionVal = false;
 // The next pick index that a structure can use to identify its elements
 // (get it by calling request pickBufferRange())
 size_t nextPickBufferInd = 1; // 0 reserved for "none"
-                              //
+
 // Track which ranges have been allocated to which structures
-// std::vector<std::tuple<size_t, size_t, Structure*>> structureRanges;
 std::unordered_map<Structure*, std::tuple<size_t, size_t>> structureRanges;
 
+// The same ranges sorted by start index, for binary search lookups in globalIndexToLocal()
+struct PickRange {
+  size_t start;
+  size_t end;
+  Structure* structure;
+};
+std::vector<PickRange> sortedStructureRanges;
+
+// Ranges [start, end) which were released and can be handed out again, sorted by start index and never adjacent
+std::vector<std::pair<size_t, size_t>> freeRanges;
+
+// State for asynchronous picks
+bool asyncPickRequested = false;
+int asyncPickRequestX = 0;
+int asyncPickRequestY = 0;
+bool asyncPickInFlight = false;
+bool asyncPickResultIsNew = false;
+std::pair<Structure*, size_t> asyncPickResult{nullptr, 0};
+
+// The pick buffer is only re-rendered when something which affects it has changed since it was last drawn
+bool pickBufferCacheValid = false;
+uint64_t pickBufferCacheGeneration = 0;
+uint64_t pickBufferCacheFramebufferID = 0;
+int pickBufferCacheWidth = 0;
+int pickBufferCacheHeight = 0;
+glm::mat4 pickBufferCacheViewMat;
+glm::mat4 pickBufferCacheProjMat;
+bool pickBufferCacheFull = false;              // otherwise only pickBufferCacheRect is valid
+glm::ivec4 pickBufferCacheRect{0, -1, 0, -1}; // xMin, xMax, yMin, yMax in buffer coordinates
+DepthMode pickBufferCacheDepthMode = DepthMode::Less;
+
+// The depth test of the pick pass. Region selection also renders it with DepthMode::Greater (keeping the farthest
+// fragment of each pixel) and DepthMode::Disable (keeping the last drawn) to find occluded elements.
+DepthMode pickDepthMode = DepthMode::Less;
+
+// Render all structures to the pick buffer, unless the previous render is still valid. Returns false if the buffer
+// could not be bound. The second version only renders the rectangle [xMin, xMax] x [yMin, yMax] in buffer coordinates,
+// leaving the rest of the buffer stale, and the third the tile of options::pickRegionOfInterestSize around a pixel.
+bool renderPickBuffer();
+bool renderPickBuffer(int xMin, int xMax, int yMin, int yMax);
+bool renderPickBufferAround(int xPos, int yPos);
+
+// Draw all structures in the view frustum with their pick programs, to the bound framebuffer
+void drawStructuresPick();
+
+// Cast a ray through the screen coordinates against all enabled structures on the CPU, see options::rayCastPicking.
+// Returns false if the pick buffer has to be used instead.
+bool rayCastPickAtScreenCoords(glm::vec2 screenCoords, std::pair<Structure*, size_t>& result);
+
 
 // == Set up picking
 size_t requestPickBufferRange(Structure* requestingStructure, size_t count) {
 
-  // Check if we can satisfy the request
-  size_t maxPickInd = std::numeric_limits<size_t>::max();
+  // A structure only holds one range at a time, give back the old one so it can be reused
+  releasePickBufferRange(requestingStructure);
+
+  size_t ret = INVALID_IND;
+
+  // Reuse a released range if one is big enough (first fit)
+  if (count > 0) {
+    for (size_t iFree = 0; iFree < freeRanges.size(); iFree++) {
+      std::pair<size_t, size_t>& freeRange = freeRanges[iFree];
+      if (freeRange.second - freeRange.first >= count) {
+        ret = freeRange.first;
+        freeRange.first += count;
+        if (freeRange.first == freeRange.second) {
+          freeRanges.erase(freeRanges.begin() + iFree);
+        }
+        break;
+      }
+    }
+  }
+
+  // Otherwise, allocate at the end
+  if (ret == INVALID_IND) {
+
+    // Check if we can satisfy the request
+    size_t maxPickInd = std::numeric_limits<size_t>::max();
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wshift-count-overflow"
-  if (bitsForPickPacking < 22) {
-    uint64_t bitMax = 1ULL << (bitsForPickPacking * 3);
-    if (bitMax < maxPickInd) {
-      maxPickInd = bitMax;
+    if (bitsForPickPacking < 22) {
+      uint64_t bitMax = 1ULL << (bitsForPickPacking * 3);
+      if (bitMax < maxPickInd) {
+        maxPickInd = bitMax;
+      }
     }
-  }
 #pragma GCC diagnostic pop
 
-  if (count > maxPickInd || maxPickInd - count < nextPickBufferInd) {
-    exception("Wow, you sure do have a lot of stuff, Polyscope can't even count it all. (Ran out of indices while "
-              "enumerating structure elements for pick buffer.)");
+    if (count > maxPickInd || maxPickInd - count < nextPickBufferInd) {
+      exception("Wow, you sure do have a lot of stuff, Polyscope can't even count it all. (Ran out of indices while "
+                "enumerating structure elements for pick buffer.)");
+    }
+
+    ret = nextPickBufferInd;
+    nextPickBufferInd += count;
   }
 
-  size_t ret = nextPickBufferInd;
-  nextPickBufferInd += count;
-  structureRanges[requestingStructure] = std::make_tuple(ret, nextPickBufferInd);
+  structureRanges[requestingStructure] = std::make_tuple(ret, ret + count);
+  if (count > 0) {
+    PickRange newRange{ret, ret + count, requestingStructure};
+    auto it = std::lower_bound(sortedStructureRanges.begin(), sortedStructureRanges.end(), newRange,
+                               [](const PickRange& a, const PickRange& b) { return a.start < b.start; });
+    sortedStructureRanges.insert(it, newRange);
+  }
   return ret;
 }
 
+void releasePickBufferRange(Structure* structure) {
+
+  auto it = structureRanges.find(structure);
+  if (it == structureRanges.end()) return;
+  size_t start = std::get<0>(it->second);
+  size_t end = std::get<1>(it->second);
+  structureRanges.erase(it);
+  if (start == end) return;
+
+  // indices in the old range may be handed out to someone else, so whatever was drawn with them is stale
+  invalidatePickBuffer();
+
+  auto sortedIt = std::lower_bound(sortedStructureRanges.begin(), sortedStructureRanges.end(), start,
+                                   [](const PickRange& r, size_t val) { return r.start < val; });
+  if (sortedIt != sortedStructureRanges.end() && sortedIt->start == start) {
+    sortedStructureRanges.erase(sortedIt);
+  }
+
+  // Add to the free list, merging with neighbors
+  auto freeIt = std::lower_bound(freeRanges.begin(), freeRanges.end(), std::make_pair(start, end));
+  freeIt = freeRanges.insert(freeIt, std::make_pair(start, end));
+  if (freeIt + 1 != freeRanges.end() && (freeIt + 1)->first == freeIt->second) {
+    freeIt->second = (freeIt + 1)->second;
+    freeRanges.erase(freeIt + 1);
+  }
+  if (freeIt != freeRanges.begin() && (freeIt - 1)->second == freeIt->first) {
+    (freeIt - 1)->second = freeIt->second;
+    freeIt = freeRanges.erase(freeIt) - 1;
+  }
+
+  // A free range at the very end just moves the end back
+  if (freeIt->second == nextPickBufferInd) {
+    nextPickBufferInd = freeIt->first;
+    freeRanges.erase(freeIt);
+  }
+}
+
+void releaseAllPickBufferRanges() {
+  if (!structureRanges.empty()) invalidatePickBuffer();
+  structureRanges.clear();
+  sortedStructureRanges.clear();
+  freeRanges.clear();
+  nextPickBufferInd = 1;
+}
+
 // == Manage stateful picking
 
 void resetSelection() {
@@ -64,6 +194,14 @@ void resetSelectionIfStructure(Structure* s) {
   if (haveSelectionVal && currPickStructure == s) {
     resetSelection();
   }
+  // the structure is going away, so the cached pick buffer is stale as well
+  invalidatePickBuffer();
+
+  // also forget any async result which refers to the structure
+  if (asyncPickResult.first == s) {
+    asyncPickResult = {nullptr, 0};
+    asyncPickResultIsNew = false;
+  }
 }
 
 std::pair<Structure*, size_t> getSelection() {
@@ -88,18 +226,14 @@ void setSelection(std::pair<Structure*, size_t> newPick) {
 
 std::pair<Structure*, size_t> globalIndexToLocal(size_t globalInd) {
 
-  // ONEDAY: this could be asymptotically better if we cared
-
-  // Loop through the ranges that we have allocated to find the one correpsonding to this structure.
-  for (const auto& x : structureRanges) {
-
-    Structure* structure = x.first;
-    size_t rangeStart = std::get<0>(x.second);
-    size_t rangeEnd = std::get<1>(x.second);
+  // Find the last range which starts at or before this index
+  auto it = std::upper_bound(sortedStructureRanges.begin(), sortedStructureRanges.end(), globalInd,
+                             [](size_t val, const PickRange& r) { return val < r.start; });
+  if (it == sortedStructureRanges.begin()) return {nullptr, 0};
+  --it;
 
-    if (globalInd >= rangeStart && globalInd < rangeEnd) {
-      return {structure, globalInd - rangeStart};
-    }
+  if (globalInd < it->end) {
+    return {it->structure, globalInd - it->start};
   }
 
   return {nullptr, 0};
@@ -119,6 +253,11 @@ size_t localIndexToGlobal(std::pair<Structure*, size_t> localPick) {
 }
 
 std::pair<Structure*, size_t> pickAtScreenCoords(glm::vec2 screenCoords) {
+  if (options::rayCastPicking) {
+    std::pair<Structure*, size_t> result;
+    if (rayCastPickAtScreenCoords(screenCoords, result)) return result;
+  }
+
   int xInd, yInd;
   std::tie(xInd, yInd) = view::screenCoordsToBufferInds(screenCoords);
   return pickAtBufferCoords(xInd, yInd);
@@ -135,33 +274,424 @@ std::pair<Structure*, size_t> evaluatePickQuery(int xPos, int yPos) {
     return {nullptr, 0};
   }
 
+  if (xPos == -1 || yPos == -1) {
+    renderPickBuffer();
+    return {nullptr, 0};
+  }
+
+  if (!renderPickBufferAround(xPos, yPos)) return {nullptr, 0};
+
+  // Read from the pick buffer
   render::FrameBuffer* pickFramebuffer = render::engine->pickFramebuffer.get();
+  std::array<uint32_t, 2> result = pickFramebuffer->readUInt2(xPos, view::bufferHeight - yPos);
+  size_t globalInd = pick::uint2ToInd(result[0], result[1]);
 
+  return pick::globalIndexToLocal(globalInd);
+}
+
+void invalidatePickBuffer() { pickBufferCacheValid = false; }
+
+void drawPickBufferDebug(render::FrameBuffer* target) {
   render::engine->setDepthMode(DepthMode::Less);
   render::engine->setBlendMode(BlendMode::Disable);
 
-  pickFramebuffer->resize(view::bufferWidth, view::bufferHeight);
-  pickFramebuffer->setViewport(0, 0, view::bufferWidth, view::bufferHeight);
-  pickFramebuffer->clearColor = glm::vec3{0., 0., 0.};
-  if (!pickFramebuffer->bindForRendering()) return {nullptr, 0};
-  pickFramebuffer->clear();
+  glm::vec3 oldClearColor = target->clearColor;
+  target->clearColor = glm::vec3{0., 0., 0.};
+  if (!target->bindForRendering()) return;
+  target->clear();
+  target->clearColor = oldClearColor;
+
+  drawStructuresPick();
+}
+
+bool rayCastPickAtScreenCoords(glm::vec2 screenCoords, std::pair<Structure*, size_t>& result) {
+
+  // Slice planes cut the drawn geometry in ways the ray casts do not reproduce
+  for (std::unique_ptr<SlicePlane>& plane : state::slicePlanes) {
+    if (plane->getActive()) return false;
+  }
+  for (auto& cat : state::structures) {
+    for (auto& x : cat.second) {
+      if (x.second->isEnabled() && !x.second->supportsRayCastPicking()) return false;
+    }
+  }
+
+  // Build the ray. With an orthographic projection all rays are parallel, starting from the pixel on the near plane.
+  // The start is in double precision, for structures with large coordinates (see Structure::setPositionOrigin()).
+  glm::dvec3 rayStart = view::getCameraWorldPositionDouble();
+  glm::vec3 rayDir = view::screenCoordsToWorldRay(screenCoords);
+  if (view::projectionMode == ProjectionMode::Orthographic) {
+    glm::dvec4 viewport(view::getCurrentViewportScreenRect());
+    glm::dvec3 screenPos3{screenCoords.x, view::windowHeight - screenCoords.y, 0.};
+    rayStart = glm::unProject(screenPos3, glm::dmat4(view::getCameraViewMatrix()),
+                              glm::dmat4(view::getCameraPerspectiveMatrix()), viewport);
+    glm::vec3 upDir, rightDir;
+    view::getCameraFrame(rayDir, upDir, rightDir);
+  }
+
+  result = {nullptr, 0};
+  float tHit = std::numeric_limits<float>::infinity();
+  for (auto& cat : state::structures) {
+    for (auto& x : cat.second) {
+      if (!x.second->isEnabled()) continue;
+      size_t localInd;
+      if (x.second->rayCastPick(rayStart, rayDir, tHit, localInd)) {
+        result = {x.second.get(), localInd};
+      }
+    }
+  }
+  return true;
+}
 
-  // Render pick buffer
+void drawStructuresPick() {
+  POLYSCOPE_TRACE_SPAN("drawStructuresPick");
+  render::engine->updateFrameUniforms();
   for (auto& cat : state::structures) {
     for (auto& x : cat.second) {
+      if (!x.second->isInViewFrustum()) continue;
       x.second->drawPick();
     }
   }
+}
 
-  if (xPos == -1 || yPos == -1) {
-    return {nullptr, 0};
+bool renderPickBuffer() { return renderPickBuffer(0, view::bufferWidth - 1, 0, view::bufferHeight - 1); }
+
+bool renderPickBuffer(int xMin, int xMax, int yMin, int yMax) {
+
+  render::FrameBuffer* pickFramebuffer = render::engine->pickFramebuffer.get();
+
+  xMin = std::max(xMin, 0);
+  xMax = std::min(xMax, view::bufferWidth - 1);
+  yMin = std::max(yMin, 0);
+  yMax = std::min(yMax, view::bufferHeight - 1);
+  bool full = xMin == 0 && xMax == view::bufferWidth - 1 && yMin == 0 && yMax == view::bufferHeight - 1;
+
+  // The scene generation catches data and settings changes, the rest catches anything that moves the camera or
+  // reallocates the buffer without going through requestRedraw()
+  glm::mat4 projMat = view::getCameraPerspectiveMatrix();
+  bool rectCached = pickBufferCacheFull || (xMin >= pickBufferCacheRect[0] && xMax <= pickBufferCacheRect[1] &&
+                                            yMin >= pickBufferCacheRect[2] && yMax <= pickBufferCacheRect[3]);
+  if (pickBufferCacheValid && rectCached && pickBufferCacheGeneration == getSceneGeneration() &&
+      pickBufferCacheFramebufferID == pickFramebuffer->getUniqueID() && pickBufferCacheWidth == view::bufferWidth &&
+      pickBufferCacheHeight == view::bufferHeight && pickBufferCacheViewMat == view::viewMat &&
+      pickBufferCacheProjMat == projMat && pickBufferCacheDepthMode == pickDepthMode) {
+    return true;
   }
+  pickBufferCacheValid = false;
 
-  // Read from the pick buffer
-  std::array<float, 4> result = pickFramebuffer->readFloat4(xPos, view::bufferHeight - yPos);
-  size_t globalInd = pick::vecToInd(glm::vec3{result[0], result[1], result[2]});
+  render::engine->setDepthMode(pickDepthMode);
+  render::engine->setBlendMode(BlendMode::Disable);
 
-  return pick::globalIndexToLocal(globalInd);
+  pickFramebuffer->resize(view::bufferWidth, view::bufferHeight);
+  pickFramebuffer->setViewport(0, 0, view::bufferWidth, view::bufferHeight);
+  pickFramebuffer->clearColor = glm::vec3{0., 0., 0.};
+  pickFramebuffer->clearDepth = pickDepthMode == DepthMode::Greater ? 0. : 1.;
+
+  // Only rasterize the rectangle, buffer row y is framebuffer row (bufferHeight - y) as in evaluatePickQuery()
+  if (!full) {
+    int rowLow = std::max(view::bufferHeight - yMax, 0);
+    int rowHigh = std::min(view::bufferHeight - yMin, view::bufferHeight - 1);
+    pickFramebuffer->setScissor(xMin, rowLow, xMax - xMin + 1, std::max(rowHigh - rowLow + 1, 0));
+  }
+
+  bool bound = pickFramebuffer->bindForRendering();
+  if (bound) {
+    pickFramebuffer->clear();
+    drawStructuresPick();
+  }
+  pickFramebuffer->clearDepth = 1.;
+
+  // Don't leave the scissor test enabled for whatever is rendered next
+  if (!full) {
+    pickFramebuffer->removeScissor();
+    pickFramebuffer->bindForRendering();
+  }
+  if (!bound) return false;
+
+  // Populating pick data for the first time may have requested a redraw (e.g. by allocating pick ranges), so read the
+  // generation after drawing
+  pickBufferCacheValid = true;
+  pickBufferCacheFull = full;
+  pickBufferCacheRect = glm::ivec4{xMin, xMax, yMin, yMax};
+  pickBufferCacheGeneration = getSceneGeneration();
+  pickBufferCacheFramebufferID = pickFramebuffer->getUniqueID();
+  pickBufferCacheWidth = view::bufferWidth;
+  pickBufferCacheHeight = view::bufferHeight;
+  pickBufferCacheViewMat = view::viewMat;
+  pickBufferCacheProjMat = projMat;
+  pickBufferCacheDepthMode = pickDepthMode;
+
+  return true;
+}
+
+bool renderPickBufferAround(int xPos, int yPos) {
+  if (options::pickRegionOfInterestSize <= 0) return renderPickBuffer();
+  int halfSize = options::pickRegionOfInterestSize / 2;
+  return renderPickBuffer(xPos - halfSize, xPos + halfSize, yPos - halfSize, yPos + halfSize);
+}
+
+// == Batched picking
+
+namespace {
+
+// Read the rectangle [xMin, xMax] x [yMin, yMax] of the pick buffer in one call, and decode the global index of each
+// pixel. Takes inclusive buffer coordinates which must lie inside the buffer, output is row-major starting from
+// (xMin, yMin).
+std::vector<size_t> readPickBufferRect(int xMin, int xMax, int yMin, int yMax) {
+
+  int w = xMax - xMin + 1;
+  int h = yMax - yMin + 1;
+  std::vector<size_t> globalInds(static_cast<size_t>(w) * h, 0);
+
+  // buffer row y is read from framebuffer row (bufferHeight - y), as in evaluatePickQuery()
+  int rowLow = view::bufferHeight - yMax;
+  int rowHigh = std::min(view::bufferHeight - yMin, view::bufferHeight - 1);
+  if (rowHigh < rowLow) return globalInds;
+
+  render::FrameBuffer* pickFramebuffer = render::engine->pickFramebuffer.get();
+  std::vector<uint32_t> pixels = pickFramebuffer->readUInt2Region(xMin, rowLow, w, rowHigh - rowLow + 1);
+
+  for (int y = yMin; y <= yMax; y++) {
+    int row = view::bufferHeight - y;
+    if (row > rowHigh) continue;
+    for (int x = xMin; x <= xMax; x++) {
+      const uint32_t* p = &pixels[2 * (static_cast<size_t>(row - rowLow) * w + (x - xMin))];
+      globalInds[static_cast<size_t>(y - yMin) * w + (x - xMin)] = pick::uint2ToInd(p[0], p[1]);
+    }
+  }
+
+  return globalInds;
+}
+
+} // namespace
+
+std::vector<std::pair<Structure*, size_t>> pickAtBufferCoordsBatch(const std::vector<glm::ivec2>& bufferCoords) {
+
+  std::vector<std::pair<Structure*, size_t>> results(bufferCoords.size(), {nullptr, 0});
+
+  // Find the extent of the queries which lie in the buffer
+  auto inBounds = [&](glm::ivec2 c) {
+    return c.x >= 0 && c.x < view::bufferWidth && c.y >= 0 && c.y < view::bufferHeight;
+  };
+  glm::ivec2 lower{view::bufferWidth, view::bufferHeight};
+  glm::ivec2 upper{-1, -1};
+  size_t nInBounds = 0;
+  for (glm::ivec2 c : bufferCoords) {
+    if (!inBounds(c)) continue;
+    lower = glm::min(lower, c);
+    upper = glm::max(upper, c);
+    nInBounds++;
+  }
+  if (nInBounds == 0) return results;
+
+  if (!renderPickBuffer(lower.x, upper.x, lower.y, upper.y)) return results;
+
+  // Read back the bounding rectangle all at once if it is not too much bigger than the number of queries, otherwise
+  // read each pixel individually
+  size_t rectArea = static_cast<size_t>(upper.x - lower.x + 1) * (upper.y - lower.y + 1);
+  if (rectArea <= std::max<size_t>(1 << 16, 64 * nInBounds)) {
+    std::vector<size_t> globalInds = readPickBufferRect(lower.x, upper.x, lower.y, upper.y);
+    size_t rectWidth = upper.x - lower.x + 1;
+    for (size_t i = 0; i < bufferCoords.size(); i++) {
+      glm::ivec2 c = bufferCoords[i];
+      if (!inBounds(c)) continue;
+      results[i] = globalIndexToLocal(globalInds[(c.y - lower.y) * rectWidth + (c.x - lower.x)]);
+    }
+  } else {
+    render::FrameBuffer* pickFramebuffer = render::engine->pickFramebuffer.get();
+    for (size_t i = 0; i < bufferCoords.size(); i++) {
+      glm::ivec2 c = bufferCoords[i];
+      if (!inBounds(c)) continue;
+      std::array<uint32_t, 2> result = pickFramebuffer->readUInt2(c.x, view::bufferHeight - c.y);
+      results[i] = globalIndexToLocal(pick::uint2ToInd(result[0], result[1]));
+    }
+  }
+
+  return results;
+}
+
+std::vector<std::pair<Structure*, size_t>> pickRegion(int x0, int y0, int w, int h) {
+
+  std::vector<std::pair<Structure*, size_t>> results(static_cast<size_t>(std::max(w, 0)) * std::max(h, 0),
+                                                     {nullptr, 0});
+
+  // Clip the region to the buffer
+  int xMin = std::max(x0, 0);
+  int yMin = std::max(y0, 0);
+  int xMax = std::min(x0 + w - 1, view::bufferWidth - 1);
+  int yMax = std::min(y0 + h - 1, view::bufferHeight - 1);
+  if (xMax < xMin || yMax < yMin) return results;
+
+  if (!renderPickBuffer(xMin, xMax, yMin, yMax)) return results;
+
+  std::vector<size_t> globalInds = readPickBufferRect(xMin, xMax, yMin, yMax);
+  size_t rectWidth = xMax - xMin + 1;
+  for (int y = yMin; y <= yMax; y++) {
+    for (int x = xMin; x <= xMax; x++) {
+      size_t globalInd = globalInds[(y - yMin) * rectWidth + (x - xMin)];
+      results[static_cast<size_t>(y - y0) * w + (x - x0)] = globalIndexToLocal(globalInd);
+    }
+  }
+
+  return results;
+}
+
+// == Region selection
+
+namespace {
+
+// The distinct elements drawn in the pixels of the rectangle [xMin, xMax] x [yMin, yMax] (inclusive buffer coordinates
+// inside the buffer), restricted to the pixels flagged in `mask` if it is given (row-major from (xMin, yMin)).
+std::vector<std::pair<Structure*, size_t>> pickElementsInMaskedRect(int xMin, int xMax, int yMin, int yMax,
+                                                                    const std::vector<char>* mask,
+                                                                    bool includeOccluded) {
+
+  // A bit per global pick index, indices past the allocated ranges can only be stale and are skipped
+  std::vector<uint64_t> found;
+  auto collect = [&]() {
+    if (!renderPickBuffer(xMin, xMax, yMin, yMax)) return;
+    found.resize((nextPickBufferInd + 63) / 64, 0); // drawing may have allocated ranges
+    std::vector<size_t> globalInds = readPickBufferRect(xMin, xMax, yMin, yMax);
+    for (size_t i = 0; i < globalInds.size(); i++) {
+      size_t ind = globalInds[i];
+      if (ind == 0 || ind >= nextPickBufferInd) continue;
+      if (mask && !(*mask)[i]) continue;
+      found[ind / 64] |= uint64_t(1) << (ind % 64);
+    }
+  };
+
+  collect();
+  if (includeOccluded) {
+    for (DepthMode mode : {DepthMode::Greater, DepthMode::Disable}) {
+      pickDepthMode = mode;
+      collect();
+    }
+    pickDepthMode = DepthMode::Less;
+  }
+
+  std::vector<std::pair<Structure*, size_t>> results;
+  for (size_t iWord = 0; iWord < found.size(); iWord++) {
+    for (uint64_t bits = found[iWord]; bits != 0; bits &= bits - 1) {
+      size_t iBit = 0;
+      while (!((bits >> iBit) & 1)) iBit++;
+      std::pair<Structure*, size_t> local = globalIndexToLocal(64 * iWord + iBit);
+      if (local.first != nullptr) results.push_back(local);
+    }
+  }
+  return results;
+}
+
+} // namespace
+
+std::vector<std::pair<Structure*, size_t>> pickElementsInRect(int x0, int y0, int w, int h, bool includeOccluded) {
+  int xMin = std::max(x0, 0);
+  int yMin = std::max(y0, 0);
+  int xMax = std::min(x0 + w - 1, view::bufferWidth - 1);
+  int yMax = std::min(y0 + h - 1, view::bufferHeight - 1);
+  if (xMax < xMin || yMax < yMin) return {};
+  return pickElementsInMaskedRect(xMin, xMax, yMin, yMax, nullptr, includeOccluded);
+}
+
+std::vector<std::pair<Structure*, size_t>> pickElementsInLasso(const std::vector<glm::vec2>& polygon,
+                                                               bool includeOccluded) {
+  if (polygon.size() < 3) return {};
+
+  // Bounding rectangle of the pixels, clipped to the buffer
+  glm::vec2 lower = polygon[0];
+  glm::vec2 upper = polygon[0];
+  for (const glm::vec2& p : polygon) {
+    lower = glm::min(lower, p);
+    upper = glm::max(upper, p);
+  }
+  int xMin = std::max(static_cast<int>(std::floor(lower.x)), 0);
+  int yMin = std::max(static_cast<int>(std::floor(lower.y)), 0);
+  int xMax = std::min(static_cast<int>(std::ceil(upper.x)), view::bufferWidth - 1);
+  int yMax = std::min(static_cast<int>(std::ceil(upper.y)), view::bufferHeight - 1);
+  if (xMax < xMin || yMax < yMin) return {};
+
+  // Scanline fill: for each row, sort the crossings of the polygon edges with the line through the pixel centers, and
+  // flag the pixels between alternate crossings
+  int w = xMax - xMin + 1;
+  std::vector<char> mask(static_cast<size_t>(w) * (yMax - yMin + 1), 0);
+  std::vector<float> crossings;
+  for (int y = yMin; y <= yMax; y++) {
+    float yc = y + 0.5f;
+    crossings.clear();
+    for (size_t i = 0; i < polygon.size(); i++) {
+      const glm::vec2& a = polygon[i];
+      const glm::vec2& b = polygon[(i + 1) % polygon.size()];
+      if ((a.y <= yc) == (b.y <= yc)) continue;
+      crossings.push_back(a.x + (yc - a.y) * (b.x - a.x) / (b.y - a.y));
+    }
+    std::sort(crossings.begin(), crossings.end());
+    for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+      // pixels whose centers x + 0.5 lie in [crossings[i], crossings[i+1])
+      int xBegin = std::max(static_cast<int>(std::ceil(crossings[i] - 0.5f)), xMin);
+      int xEnd = std::min(static_cast<int>(std::ceil(crossings[i + 1] - 0.5f)), xMax + 1);
+      for (int x = xBegin; x < xEnd; x++) {
+        mask[static_cast<size_t>(y - yMin) * w + (x - xMin)] = 1;
+      }
+    }
+  }
+
+  return pickElementsInMaskedRect(xMin, xMax, yMin, yMax, &mask, includeOccluded);
+}
+
+// == Asynchronous picking
+
+void requestPickAtScreenCoordsAsync(glm::vec2 screenCoords) {
+  int xInd, yInd;
+  std::tie(xInd, yInd) = view::screenCoordsToBufferInds(screenCoords);
+  requestPickAtBufferCoordsAsync(xInd, yInd);
+}
+
+void requestPickAtBufferCoordsAsync(int xPos, int yPos) {
+  asyncPickRequested = true;
+  asyncPickRequestX = xPos;
+  asyncPickRequestY = yPos;
+}
+
+bool pollAsyncPickResult(std::pair<Structure*, size_t>& result) {
+  if (!asyncPickResultIsNew) return false;
+  result = asyncPickResult;
+  asyncPickResultIsNew = false;
+  return true;
+}
+
+void processAsyncPickRequests() {
+
+  render::FrameBuffer* pickFramebuffer = render::engine->pickFramebuffer.get();
+
+  // Resolve a read issued on a previous frame, if it has finished
+  if (asyncPickInFlight) {
+    std::array<uint32_t, 2> result;
+    if (pickFramebuffer->pollReadUInt2(result)) {
+      size_t globalInd = pick::uint2ToInd(result[0], result[1]);
+      asyncPickResult = pick::globalIndexToLocal(globalInd);
+      asyncPickResultIsNew = true;
+      asyncPickInFlight = false;
+    } else if (!pickFramebuffer->hasPendingReadUInt2()) {
+      asyncPickInFlight = false; // the read failed, drop it
+    } else {
+      return; // still waiting, issue new requests once this one lands
+    }
+  }
+
+  if (!asyncPickRequested) return;
+  asyncPickRequested = false;
+
+  // Requests outside the buffer resolve immediately
+  int xPos = asyncPickRequestX;
+  int yPos = asyncPickRequestY;
+  if (xPos < 0 || xPos >= view::bufferWidth || yPos < 0 || yPos >= view::bufferHeight) {
+    asyncPickResult = {nullptr, 0};
+    asyncPickResultIsNew = true;
+    return;
+  }
+
+  if (!renderPickBufferAround(xPos, yPos)) return;
+  pickFramebuffer->requestReadUInt2(xPos, view::bufferHeight - yPos);
+  asyncPickInFlight = true;
 }
 
 } // namespace pick
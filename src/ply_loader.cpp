@@ -0,0 +1,416 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/ply_loader.h"
+
+#include "polyscope/mapped_file.h"
+#include "polyscope/messages.h"
+#include "polyscope/parallel.h"
+#include "polyscope/polyscope.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+namespace polyscope {
+
+namespace {
+
+enum class PLYType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+struct PLYProperty {
+  std::string name;
+  PLYType type;
+  bool isList = false;
+  PLYType countType; // only for lists
+};
+
+struct PLYElement {
+  std::string name;
+  size_t count = 0;
+  std::vector<PLYProperty> properties;
+
+  bool hasLists() const {
+    for (const PLYProperty& p : properties) {
+      if (p.isList) return true;
+    }
+    return false;
+  }
+};
+
+// Faces are decoded in blocks of this many, the sequential pass records where each block starts in the file
+const size_t plyFaceBlockSize = 16384;
+
+size_t plyTypeSize(PLYType t) {
+  switch (t) {
+  case PLYType::Int8:
+  case PLYType::UInt8:
+    return 1;
+  case PLYType::Int16:
+  case PLYType::UInt16:
+    return 2;
+  case PLYType::Int32:
+  case PLYType::UInt32:
+  case PLYType::Float32:
+    return 4;
+  case PLYType::Float64:
+    return 8;
+  }
+  return 0;
+}
+
+PLYType parsePLYType(const std::string& name, const std::string& filename) {
+  if (name == "char" || name == "int8") return PLYType::Int8;
+  if (name == "uchar" || name == "uint8") return PLYType::UInt8;
+  if (name == "short" || name == "int16") return PLYType::Int16;
+  if (name == "ushort" || name == "uint16") return PLYType::UInt16;
+  if (name == "int" || name == "int32") return PLYType::Int32;
+  if (name == "uint" || name == "uint32") return PLYType::UInt32;
+  if (name == "float" || name == "float32") return PLYType::Float32;
+  if (name == "double" || name == "float64") return PLYType::Float64;
+  exception("PLY file " + filename + " has a property of unknown type '" + name + "'");
+  return PLYType::UInt8;
+}
+
+template <typename T>
+T loadPLYValue(const unsigned char* p, bool swapBytes) {
+  unsigned char bytes[sizeof(T)];
+  std::memcpy(bytes, p, sizeof(T));
+  if (swapBytes) std::reverse(bytes, bytes + sizeof(T));
+  T val;
+  std::memcpy(&val, bytes, sizeof(T));
+  return val;
+}
+
+template <typename T>
+T readPLYScalar(const unsigned char* p, PLYType t, bool swapBytes) {
+  switch (t) {
+  case PLYType::Int8:
+    return static_cast<T>(loadPLYValue<int8_t>(p, swapBytes));
+  case PLYType::UInt8:
+    return static_cast<T>(loadPLYValue<uint8_t>(p, swapBytes));
+  case PLYType::Int16:
+    return static_cast<T>(loadPLYValue<int16_t>(p, swapBytes));
+  case PLYType::UInt16:
+    return static_cast<T>(loadPLYValue<uint16_t>(p, swapBytes));
+  case PLYType::Int32:
+    return static_cast<T>(loadPLYValue<int32_t>(p, swapBytes));
+  case PLYType::UInt32:
+    return static_cast<T>(loadPLYValue<uint32_t>(p, swapBytes));
+  case PLYType::Float32:
+    return static_cast<T>(loadPLYValue<float>(p, swapBytes));
+  case PLYType::Float64:
+    return static_cast<T>(loadPLYValue<double>(p, swapBytes));
+  }
+  return T();
+}
+
+class PLYReader {
+public:
+  PLYReader(std::string filename_) : filename(filename_), file(filename_) {}
+
+  PLYMesh load() {
+    parseHeader();
+
+    PLYMesh mesh;
+    const unsigned char* p = file.data + dataStart;
+    for (const PLYElement& e : elements) {
+      if (e.name == "vertex") {
+        p = readVertices(e, p, mesh);
+      } else if (e.name == "face") {
+        p = readFaces(e, p, mesh);
+      } else {
+        p = skipElement(e, p);
+      }
+    }
+
+    if (mesh.vertexPositions.empty()) exception("PLY file " + filename + " has no vertices");
+    for (uint32_t iV : mesh.faceIndsEntries) {
+      if (iV >= mesh.vertexPositions.size()) fail("a face index is out of range");
+    }
+
+    return mesh;
+  }
+
+private:
+  std::string filename;
+  MappedFile file;
+  size_t dataStart = 0;
+  bool swapBytes = false;
+  std::vector<PLYElement> elements;
+
+  void fail(const std::string& what) const { exception("could not load PLY file " + filename + ": " + what); }
+
+  const unsigned char* end() const { return file.data + file.size; }
+
+  void parseHeader() {
+    const char* text = reinterpret_cast<const char*>(file.data);
+    const char endTag[] = "end_header";
+    const char* tagPos = std::search(text, text + file.size, endTag, endTag + sizeof(endTag) - 1);
+    if (tagPos == text + file.size) fail("no end_header");
+    const char* lineEnd = std::find(tagPos, text + file.size, '\n');
+    if (lineEnd == text + file.size) fail("no data after the header");
+    dataStart = static_cast<size_t>(lineEnd + 1 - text);
+
+    std::istringstream header(std::string(text, tagPos));
+    std::string line;
+    bool first = true;
+    bool haveFormat = false;
+    while (std::getline(header, line)) {
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      std::istringstream words(line);
+      std::string keyword;
+      words >> keyword;
+
+      if (first) {
+        if (keyword != "ply") fail("not a PLY file");
+        first = false;
+      } else if (keyword == "format") {
+        std::string format;
+        words >> format;
+        uint16_t one = 1;
+        bool hostLittleEndian = *reinterpret_cast<unsigned char*>(&one) == 1;
+        if (format == "binary_little_endian") {
+          swapBytes = !hostLittleEndian;
+        } else if (format == "binary_big_endian") {
+          swapBytes = hostLittleEndian;
+        } else {
+          fail("only binary PLY files are supported, not '" + format + "'");
+        }
+        haveFormat = true;
+      } else if (keyword == "element") {
+        PLYElement e;
+        words >> e.name >> e.count;
+        if (!words) fail("malformed element line '" + line + "'");
+        elements.push_back(e);
+      } else if (keyword == "property") {
+        if (elements.empty()) fail("property before any element");
+        PLYProperty prop;
+        std::string typeName;
+        words >> typeName;
+        if (typeName == "list") {
+          std::string countTypeName, itemTypeName;
+          words >> countTypeName >> itemTypeName;
+          prop.isList = true;
+          prop.countType = parsePLYType(countTypeName, filename);
+          prop.type = parsePLYType(itemTypeName, filename);
+        } else {
+          prop.type = parsePLYType(typeName, filename);
+        }
+        words >> prop.name;
+        if (!words) fail("malformed property line '" + line + "'");
+        elements.back().properties.push_back(prop);
+      }
+      // comment and obj_info lines are ignored
+    }
+    if (!haveFormat) fail("no format line");
+  }
+
+  // The size of an element's records, which must not contain lists
+  size_t fixedStride(const PLYElement& e) const {
+    size_t stride = 0;
+    for (const PLYProperty& prop : e.properties) stride += plyTypeSize(prop.type);
+    return stride;
+  }
+
+  // Step past one record of an element with lists
+  const unsigned char* skipRecord(const PLYElement& e, const unsigned char* p) const {
+    for (const PLYProperty& prop : e.properties) {
+      if (prop.isList) {
+        size_t countSize = plyTypeSize(prop.countType);
+        if (static_cast<size_t>(end() - p) < countSize) fail("truncated");
+        int64_t count = readPLYScalar<int64_t>(p, prop.countType, swapBytes);
+        if (count < 0) fail("negative list length");
+        p += countSize;
+        size_t listSize = static_cast<size_t>(count) * plyTypeSize(prop.type);
+        if (static_cast<size_t>(end() - p) < listSize) fail("truncated");
+        p += listSize;
+      } else {
+        size_t size = plyTypeSize(prop.type);
+        if (static_cast<size_t>(end() - p) < size) fail("truncated");
+        p += size;
+      }
+    }
+    return p;
+  }
+
+  const unsigned char* skipElement(const PLYElement& e, const unsigned char* p) const {
+    if (!e.hasLists()) {
+      size_t size = e.count * fixedStride(e);
+      if (static_cast<size_t>(end() - p) < size) fail("truncated");
+      return p + size;
+    }
+    for (size_t i = 0; i < e.count; i++) p = skipRecord(e, p);
+    return p;
+  }
+
+  const unsigned char* readVertices(const PLYElement& e, const unsigned char* p, PLYMesh& mesh) const {
+    if (e.hasLists()) fail("list properties on vertices are not supported");
+
+    // Find the byte offsets of the properties we load
+    const size_t missing = static_cast<size_t>(-1);
+    std::vector<std::string> wanted = {"x", "y", "z", "red", "green", "blue"};
+    std::vector<size_t> offsets(wanted.size(), missing);
+    std::vector<PLYType> types(wanted.size(), PLYType::Float32);
+    size_t offset = 0;
+    for (const PLYProperty& prop : e.properties) {
+      for (size_t i = 0; i < wanted.size(); i++) {
+        if (prop.name == wanted[i]) {
+          offsets[i] = offset;
+          types[i] = prop.type;
+        }
+      }
+      offset += plyTypeSize(prop.type);
+    }
+    size_t stride = offset;
+    if (offsets[0] == missing || offsets[1] == missing || offsets[2] == missing) fail("vertices have no x/y/z");
+    bool hasColors = offsets[3] != missing && offsets[4] != missing && offsets[5] != missing;
+
+    if (static_cast<size_t>(end() - p) < e.count * stride) fail("truncated");
+
+    // Integer colors are 0-255, floating point colors are already in [0,1]
+    float colorScale = 1.f;
+    if (hasColors && types[3] != PLYType::Float32 && types[3] != PLYType::Float64) colorScale = 1.f / 255.f;
+
+    mesh.vertexPositions.resize(e.count);
+    if (hasColors) mesh.vertexColors.resize(e.count);
+    bool swap = swapBytes;
+    parallelFor(0, e.count, [&](size_t begin, size_t chunkEnd) {
+      for (size_t iV = begin; iV < chunkEnd; iV++) {
+        const unsigned char* record = p + iV * stride;
+        glm::vec3& pos = mesh.vertexPositions[iV];
+        for (int c = 0; c < 3; c++) pos[c] = readPLYScalar<float>(record + offsets[c], types[c], swap);
+        if (hasColors) {
+          glm::vec3& color = mesh.vertexColors[iV];
+          for (int c = 0; c < 3; c++) {
+            color[c] = colorScale * readPLYScalar<float>(record + offsets[3 + c], types[3 + c], swap);
+          }
+        }
+      }
+    });
+
+    return p + e.count * stride;
+  }
+
+  const unsigned char* readFaces(const PLYElement& e, const unsigned char* p, PLYMesh& mesh) const {
+    size_t iList = e.properties.size();
+    for (size_t i = 0; i < e.properties.size(); i++) {
+      const PLYProperty& prop = e.properties[i];
+      if (prop.isList && (prop.name == "vertex_indices" || prop.name == "vertex_index")) iList = i;
+    }
+    if (iList == e.properties.size()) fail("faces have no vertex_indices list");
+    const PLYProperty& indProp = e.properties[iList];
+    size_t indSize = plyTypeSize(indProp.type);
+    size_t countSize = plyTypeSize(indProp.countType);
+
+    // Sequential pass: face sizes only need the list lengths, which gives the layout of the flat arrays and where each
+    // block of faces starts in the file
+    size_t nFaces = e.count;
+    size_t nBlocks = (nFaces + plyFaceBlockSize - 1) / plyFaceBlockSize;
+    std::vector<const unsigned char*> blockStarts(nBlocks);
+    mesh.faceIndsStart.resize(nFaces + 1);
+    mesh.faceIndsStart[0] = 0;
+    size_t nEntries = 0;
+    for (size_t iF = 0; iF < nFaces; iF++) {
+      if (iF % plyFaceBlockSize == 0) blockStarts[iF / plyFaceBlockSize] = p;
+      for (size_t i = 0; i < e.properties.size(); i++) {
+        const PLYProperty& prop = e.properties[i];
+        if (!prop.isList) {
+          size_t size = plyTypeSize(prop.type);
+          if (static_cast<size_t>(end() - p) < size) fail("truncated");
+          p += size;
+          continue;
+        }
+        if (static_cast<size_t>(end() - p) < plyTypeSize(prop.countType)) fail("truncated");
+        int64_t count = readPLYScalar<int64_t>(p, prop.countType, swapBytes);
+        if (count < 0) fail("negative list length");
+        p += plyTypeSize(prop.countType);
+        size_t listSize = static_cast<size_t>(count) * plyTypeSize(prop.type);
+        if (static_cast<size_t>(end() - p) < listSize) fail("truncated");
+        p += listSize;
+        if (i == iList) nEntries += static_cast<size_t>(count);
+      }
+      if (nEntries > std::numeric_limits<uint32_t>::max()) fail("too many face indices");
+      mesh.faceIndsStart[iF + 1] = static_cast<uint32_t>(nEntries);
+    }
+
+    // Parallel pass: decode the indices of each block straight in to place
+    mesh.faceIndsEntries.resize(nEntries);
+    bool swap = swapBytes;
+    parallelFor(
+        0, nBlocks,
+        [&](size_t blockBegin, size_t blockEnd) {
+          for (size_t iBlock = blockBegin; iBlock < blockEnd; iBlock++) {
+            const unsigned char* q = blockStarts[iBlock];
+            size_t faceEnd = std::min(nFaces, (iBlock + 1) * plyFaceBlockSize);
+            for (size_t iF = iBlock * plyFaceBlockSize; iF < faceEnd; iF++) {
+              for (size_t i = 0; i < e.properties.size(); i++) {
+                const PLYProperty& prop = e.properties[i];
+                if (i != iList) {
+                  q = prop.isList ? skipRecordList(prop, q) : q + plyTypeSize(prop.type);
+                  continue;
+                }
+                q += countSize;
+                uint32_t* out = &mesh.faceIndsEntries[0] + mesh.faceIndsStart[iF];
+                size_t count = mesh.faceIndsStart[iF + 1] - mesh.faceIndsStart[iF];
+                for (size_t j = 0; j < count; j++) {
+                  int64_t ind = readPLYScalar<int64_t>(q, indProp.type, swap);
+                  out[j] = ind < 0 ? std::numeric_limits<uint32_t>::max() : static_cast<uint32_t>(ind);
+                  q += indSize;
+                }
+              }
+            }
+          }
+        },
+        1);
+
+    return p;
+  }
+
+  // Step past a list property which was already bounds checked in the sequential pass
+  const unsigned char* skipRecordList(const PLYProperty& prop, const unsigned char* q) const {
+    size_t count = static_cast<size_t>(readPLYScalar<int64_t>(q, prop.countType, swapBytes));
+    return q + plyTypeSize(prop.countType) + count * plyTypeSize(prop.type);
+  }
+};
+
+} // namespace
+
+PLYMesh loadPLY(std::string filename) {
+  PLYReader reader(filename);
+  return reader.load();
+}
+
+SurfaceMesh* registerSurfaceMeshPLY(std::string name, std::string filename) {
+  checkInitialized();
+
+  PLYMesh ply = loadPLY(filename);
+  if (ply.faceIndsEntries.empty()) exception("PLY file " + filename + " has no faces");
+
+  SurfaceMesh* s = new SurfaceMesh(name, ply.vertexPositions, ply.faceIndsEntries, ply.faceIndsStart);
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+    return s;
+  }
+  if (!ply.vertexColors.empty()) s->addVertexColorQuantity("color", ply.vertexColors);
+  return s;
+}
+
+PointCloud* registerPointCloudPLY(std::string name, std::string filename) {
+  checkInitialized();
+
+  PLYMesh ply = loadPLY(filename);
+
+  PointCloud* s = new PointCloud(name, std::move(ply.vertexPositions));
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+    return s;
+  }
+  if (!ply.vertexColors.empty()) s->addColorQuantity("color", ply.vertexColors);
+  return s;
+}
+
+} // namespace polyscope
@@ -3,6 +3,7 @@
 #include "polyscope/point_cloud.h"
 
 #include "polyscope/file_helpers.h"
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
@@ -13,8 +14,14 @@
 
 #include "imgui.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <thread>
 
 namespace polyscope {
 
@@ -26,11 +33,17 @@ PointCloud::PointCloud(std::string name, std::vector<glm::vec3> points_)
     : // clang-format off
     QuantityStructure<PointCloud>(name, structureTypeName), 
       points(this, uniquePrefix() + "points", pointsData),
+      lodPointOrder(this, uniquePrefix() + "lodPointOrder", lodPointOrderData, std::bind(&PointCloud::computeLODPointOrder, this)),
+      spatialPointOrder(this, uniquePrefix() + "spatialPointOrder", spatialPointOrderData, std::bind(&PointCloud::computeSpatialPointOrder, this)),
+      depthPointOrder(this, uniquePrefix() + "depthPointOrder", depthPointOrderData),
+      voxelPreviewOrder(this, uniquePrefix() + "voxelPreviewOrder", voxelPreviewOrderData, std::bind(&PointCloud::computeVoxelPreviewOrder, this)),
+      keyframeInds(this, uniquePrefix() + "keyframeInds", keyframeIndsData, std::bind(&PointCloud::computeKeyframeInds, this)),
       pointsData(std::move(points_)), 
       pointRenderMode(uniquePrefix() + "pointRenderMode", "sphere"),
       pointColor(uniquePrefix() + "pointColor", getNextUniqueColor()),
       pointRadius(uniquePrefix() + "pointRadius", relativeValue(0.005)),
-      material(uniquePrefix() + "material", "clay")
+      material(uniquePrefix() + "material", "clay"),
+      transparencySorting(uniquePrefix() + "transparencySorting", false)
 // clang-format on
 {
   cullWholeElements.setPassive(true);
@@ -42,14 +55,14 @@ void PointCloud::setPointCloudUniforms(render::ShaderProgram& p) {
   glm::mat4 P = view::getCameraPerspectiveMatrix();
   glm::mat4 Pinv = glm::inverse(P);
 
-  if (getPointRenderMode() == PointRenderMode::Sphere) {
+  if (getPointRenderMode() == PointRenderMode::Sphere || getPointRenderMode() == PointRenderMode::Splat) {
     p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
     p.setUniform("u_viewport", render::engine->getCurrentViewport());
   }
 
   if (pointRadiusQuantityName != "" && !pointRadiusQuantityAutoscale) {
     // special case: ignore radius uniform
-    p.setUniform("u_pointRadius", 1.);
+    p.setUniform("u_pointRadius", lodRadiusScale);
   } else {
     // common case
 
@@ -59,8 +72,169 @@ void PointCloud::setPointCloudUniforms(render::ShaderProgram& p) {
       scalarQScale = std::max(0., radQ.getDataRange().second);
     }
 
-    p.setUniform("u_pointRadius", pointRadius.get().asAbsolute() / scalarQScale);
+    p.setUniform("u_pointRadius", lodRadiusScale * pointRadius.get().asAbsolute() / scalarQScale);
   }
+
+  if (pointSelection && p.hasTexture("t_selection")) {
+    pointSelection->resize(nPoints()); // points may have been appended or replaced since
+    p.setTextureFromBuffer("t_selection", pointSelection->getTexture());
+    p.setUniform("u_selectionColor", pointSelection->getColor());
+  }
+}
+
+void PointCloud::drawPointProgram(render::ShaderProgram& p) {
+  if (voxelPreviewSize > 0.) {
+    p.drawSubset(*voxelPreviewOrder.getRenderAttributeBuffer(), voxelPreviewRanges);
+    return;
+  }
+
+  if (lodPointBudget == 0) {
+    if (drawsSortedTransparency() && depthPointOrder.data.size() == nPoints()) {
+      std::vector<std::array<size_t, 2>> ranges;
+      if (nPoints() > 0) ranges.push_back({{0, nPoints()}});
+      p.drawSubset(*depthPointOrder.getRenderAttributeBuffer(), ranges);
+      return;
+    }
+
+    // while points are being appended the order may be missing some of them, draw in the input order until then
+    if (spatialDrawOrder) {
+      spatialPointOrder.ensureHostBufferPopulated();
+      if (spatialPointOrder.data.size() == nPoints()) {
+        std::vector<std::array<size_t, 2>> ranges;
+        if (nPoints() > 0) ranges.push_back({{0, nPoints()}});
+        p.drawSubset(*spatialPointOrder.getRenderAttributeBuffer(), ranges);
+        return;
+      }
+    }
+    p.draw();
+    return;
+  }
+
+  std::vector<std::array<size_t, 2>> ranges;
+  if (lodDrawCount > 0) ranges.push_back({{0, lodDrawCount}});
+  p.drawSubset(*lodPointOrder.getRenderAttributeBuffer(), ranges);
+}
+
+void PointCloud::computeLODPointOrder() {
+  points.ensureHostBufferPopulated();
+  lodPointOrder.data = multiResolutionOrder(points.data);
+  lodPointOrder.markHostBufferUpdated();
+}
+
+void PointCloud::computeSpatialPointOrder() {
+  points.ensureHostBufferPopulated();
+  spatialPointOrder.data = mortonOrder(points.data);
+  spatialPointOrder.markHostBufferUpdated();
+}
+
+void PointCloud::computeVoxelPreviewOrder() {
+  points.ensureHostBufferPopulated();
+  VoxelGrid grid = voxelGridDownsample(points.data, voxelPreviewSize);
+  size_t nCells = grid.cellRepresentative.size();
+
+  voxelPreviewOrder.data = std::move(grid.cellRepresentative);
+  voxelPreviewOrder.data.insert(voxelPreviewOrder.data.end(), grid.cellPoints.begin(), grid.cellPoints.end());
+  voxelPreviewCellStart = std::move(grid.cellPointStart);
+
+  // Blocks small enough that refining one draws a few thousand points at most, for typical densities
+  const size_t blockCells = 64;
+  size_t nBlocks = (nCells + blockCells - 1) / blockCells;
+  voxelPreviewBlocks.resize(nBlocks);
+  parallelFor(0, nBlocks, [&](size_t begin, size_t end) {
+    for (size_t iB = begin; iB < end; iB++) {
+      VoxelPreviewBlock& block = voxelPreviewBlocks[iB];
+      block.cellBegin = iB * blockCells;
+      block.cellEnd = std::min(nCells, block.cellBegin + blockCells);
+      glm::vec3 bMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+      glm::vec3 bMax = -bMin;
+      for (size_t i = nCells + voxelPreviewCellStart[block.cellBegin]; i < nCells + voxelPreviewCellStart[block.cellEnd];
+           i++) {
+        glm::vec3 p = points.data[voxelPreviewOrder.data[i]];
+        if (!isFinite(p)) continue;
+        bMin = componentwiseMin(bMin, p);
+        bMax = componentwiseMax(bMax, p);
+      }
+      block.bounds = std::make_tuple(bMin, bMax);
+    }
+  });
+
+  voxelPreviewOrder.markHostBufferUpdated();
+}
+
+void PointCloud::updateVoxelPreviewRanges() {
+  voxelPreviewOrder.ensureHostBufferPopulated();
+  size_t nCells = nVoxelPreviewVoxels();
+  float padding = getDrawBoundsPadding();
+
+  // Each block in view draws either its representatives or all of its points, as one range of the order. Adjacent
+  // blocks drawn the same way have adjacent ranges, which are merged.
+  voxelPreviewRanges.clear();
+  voxelPreviewDrawCount = 0;
+  for (const VoxelPreviewBlock& block : voxelPreviewBlocks) {
+    if (!objectSpaceBoxInViewFrustum(block.bounds, padding)) continue;
+    double pixelsPerCell = objectSpaceBoxPixelArea(block.bounds) / (block.cellEnd - block.cellBegin);
+    std::array<size_t, 2> range;
+    if (pixelsPerCell > voxelPreviewRefinePixels * voxelPreviewRefinePixels) {
+      range = {{nCells + voxelPreviewCellStart[block.cellBegin], nCells + voxelPreviewCellStart[block.cellEnd]}};
+    } else {
+      range = {{block.cellBegin, block.cellEnd}};
+    }
+    if (!voxelPreviewRanges.empty() && voxelPreviewRanges.back()[1] == range[0]) {
+      voxelPreviewRanges.back()[1] = range[1];
+    } else {
+      voxelPreviewRanges.push_back(range);
+    }
+    voxelPreviewDrawCount += range[1] - range[0];
+  }
+}
+
+void PointCloud::updateDepthPointOrder() {
+  glm::mat4 view = getModelView();
+  bool haveOrder = depthPointOrder.data.size() == nPoints();
+  auto installSort = [&]() {
+    depthPointOrder.data = depthSort.get();
+    depthPointOrder.markHostBufferUpdated();
+    depthOrderView = depthSortView;
+    haveOrder = depthPointOrder.data.size() == nPoints();
+  };
+
+  // Take a finished sort, and start the next one if the view moved since. The sort works on its own copy of the
+  // positions, so the cloud can change while it runs.
+  if (depthSort.valid() && depthSort.wait_for(std::chrono::seconds(0)) == std::future_status::ready) installSort();
+  if (!depthSort.valid() && (!haveOrder || depthOrderView != view)) {
+    points.ensureHostBufferPopulated();
+    std::packaged_task<std::vector<uint32_t>()> task(std::bind(&backToFrontOrder, points.data, view));
+    depthSort = task.get_future();
+    depthSortView = view;
+    std::thread(std::move(task)).detach();
+  }
+
+  // There is nothing to draw until the first sort is done, so wait for that one
+  if (!haveOrder && depthSort.valid()) installSort();
+
+  // come back for the result, the idle loop would not otherwise draw another frame
+  if (depthSort.valid()) requestRedraw();
+}
+
+void PointCloud::updateLODDrawCount() {
+  size_t n = nPoints();
+  lodDrawCount = n;
+  lodRadiusScale = 1.;
+  if (voxelPreviewSize > 0.) {
+    updateVoxelPreviewRanges();
+    return;
+  }
+  if (lodPointBudget == 0 || n == 0) return;
+
+  // Beyond about one point per pixel of the cloud's projected bounds, more points add little
+  double pixelArea = screenPixelArea();
+
+  size_t count = std::min(n, lodPointBudget);
+  if (pixelArea < static_cast<double>(count)) count = static_cast<size_t>(pixelArea);
+  count = std::max<size_t>(count, 1);
+
+  lodDrawCount = count;
+  lodRadiusScale = std::sqrt(static_cast<float>(n) / static_cast<float>(count));
 }
 
 void PointCloud::draw() {
@@ -72,11 +246,15 @@ void PointCloud::draw() {
   // (this warning is only printed once, and only if verbosity is high enough)
   if (nPoints() > 500000 && getPointRenderMode() == PointRenderMode::Sphere &&
       !internal::pointCloudEfficiencyWarningReported && options::verbosity > 1) {
-    info("To render large point clouds efficiently, set their render mode to 'quad' instead of 'sphere'. (disable "
-         "these warnings by setting Polyscope's verbosity < 2)");
+    info("To render large point clouds efficiently, set their render mode to 'quad' or 'splat' instead of 'sphere'. "
+         "(disable these warnings by setting Polyscope's verbosity < 2)");
     internal::pointCloudEfficiencyWarningReported = true;
   }
 
+  bool prepared = drawPrepared;
+  drawPrepared = false;
+  if (!prepared) updateLODDrawCount();
+  if (render::engine->sortedTransparencyPass && drawsSortedTransparency()) updateDepthPointOrder();
 
   // If there is no dominant quantity, then this class is responsible for drawing points
   if (dominantQuantity == nullptr) {
@@ -85,34 +263,46 @@ void PointCloud::draw() {
     ensureRenderProgramPrepared();
 
     // Set program uniforms
-    setStructureUniforms(*program);
-    setPointCloudUniforms(*program);
-    render::engine->setMaterialUniforms(*program, material.get());
-    program->setUniform("u_baseColor", pointColor.get());
+    if (!prepared) setPointCloudProgramUniforms();
 
     // Draw the actual point cloud
-    program->draw();
+    drawPointProgram(*program);
   }
 
   // Draw the quantities
-  for (auto& x : quantities) {
-    x.second->draw();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->draw();
   }
-  for (auto& x : floatingQuantities) {
-    x.second->draw();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->draw();
   }
 }
 
+void PointCloud::prepareDraw() {
+  // the voxel preview may need to build its grid, which uploads the order
+  if (!isEnabled() || dominantQuantity != nullptr || !program || positionKeyframes || voxelPreviewSize > 0.) return;
+  updateLODDrawCount();
+  setPointCloudProgramUniforms();
+  drawPrepared = true;
+}
+
+void PointCloud::setPointCloudProgramUniforms() {
+  setStructureUniforms(*program);
+  setPointCloudUniforms(*program);
+  render::engine->setMaterialUniforms(*program, material.get());
+  program->setUniform("u_baseColor", pointColor.get());
+}
+
 void PointCloud::drawDelayed() {
   if (!isEnabled()) {
     return;
   }
 
-  for (auto& x : quantities) {
-    x.second->drawDelayed();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->drawDelayed();
   }
-  for (auto& x : floatingQuantities) {
-    x.second->drawDelayed();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->drawDelayed();
   }
 }
 
@@ -126,9 +316,10 @@ void PointCloud::drawPick() {
 
   // Set uniforms
   setStructureUniforms(*pickProgram);
+  updateLODDrawCount();
   setPointCloudUniforms(*pickProgram);
 
-  pickProgram->draw();
+  drawPointProgram(*pickProgram);
 }
 
 void PointCloud::ensureRenderProgramPrepared() {
@@ -153,30 +344,42 @@ void PointCloud::ensureRenderProgramPrepared() {
 void PointCloud::ensurePickProgramPrepared() {
   ensureRenderProgramPrepared();
 
-  // Request pick indices
   size_t pickCount = nPoints();
-  size_t pickStart = pick::requestPickBufferRange(this, pickCount);
-
-  // Create a new pick program
-  // clang-format off
-  pickProgram = render::engine->requestShader(
-      getShaderNameForRenderMode(), 
-      addPointCloudRules({"SPHERE_PROPAGATE_COLOR"}, true),
-      render::ShaderReplacementDefaults::Pick
-  );
-  // clang-format on
+  if (pickProgram && pickProgramCount == pickCount) return;
+
+  // Request pick indices. The range is kept while the cloud fits in it, and grown with headroom once the cloud has
+  // changed size, so a cloud resized every frame does not request a new range every frame.
+  if (pickRangeCapacity == 0 || pickCount > pickRangeCapacity) {
+    size_t capacity = pickCount;
+    if (pickRangeCapacity > 0) {
+      capacity = std::max(pickCount, pickRangeCapacity + pickRangeCapacity / 2);
+    }
+    pickRangeStart = pick::requestPickBufferRange(this, capacity);
+    pickRangeCapacity = capacity;
+  }
 
-  setPointProgramGeometryAttributes(*pickProgram);
+  if (!pickProgram) {
+    // Create a new pick program
+    // clang-format off
+    pickProgram = render::engine->requestShader(
+        getShaderNameForRenderMode(), 
+        addPointCloudRules({"SPHERE_PROPAGATE_COLOR"}, true, false),
+        render::ShaderReplacementDefaults::Pick
+    );
+    // clang-format on
+
+    setPointProgramGeometryAttributes(*pickProgram);
+  }
 
   // Fill color buffer with packed point indices
-  std::vector<glm::vec3> pickColors;
-  for (size_t i = pickStart; i < pickStart + pickCount; i++) {
-    glm::vec3 val = pick::indToVec(i);
-    pickColors.push_back(pick::indToVec(i));
+  std::vector<glm::vec3> pickColors(pickCount);
+  for (size_t i = 0; i < pickCount; i++) {
+    pickColors[i] = pick::indToVec(pickRangeStart + i);
   }
 
   // Store data in buffers
   pickProgram->setAttribute("a_color", pickColors);
+  pickProgramCount = pickCount;
 }
 
 void PointCloud::setPointProgramGeometryAttributes(render::ShaderProgram& p) {
@@ -189,6 +392,25 @@ void PointCloud::setPointProgramGeometryAttributes(render::ShaderProgram& p) {
     PointCloudScalarQuantity& transparencyQ = resolveTransparencyQuantity();
     p.setAttribute("a_valueAlpha", transparencyQ.values.getRenderAttributeBuffer());
   }
+  if (p.hasAttribute("a_keyframeInd")) {
+    p.setAttribute("a_keyframeInd", keyframeInds.getRenderAttributeBuffer());
+  }
+}
+
+void PointCloud::rebindPointProgramGeometryAttributes() {
+  if (program) setPointProgramGeometryAttributes(*program);
+  if (pickProgram) setPointProgramGeometryAttributes(*pickProgram);
+  for (auto& x : quantities) {
+    x.second->rebindPointProgramGeometryAttributes();
+  }
+}
+
+void PointCloud::computeKeyframeInds() {
+  keyframeInds.data.resize(nPoints());
+  for (size_t i = 0; i < nPoints(); i++) {
+    keyframeInds.data[i] = static_cast<float>(i);
+  }
+  keyframeInds.markHostBufferUpdated();
 }
 
 std::string PointCloud::getShaderNameForRenderMode() {
@@ -196,6 +418,8 @@ std::string PointCloud::getShaderNameForRenderMode() {
     return "RAYCAST_SPHERE";
   else if (getPointRenderMode() == PointRenderMode::Quad)
     return "POINT_QUAD";
+  else if (getPointRenderMode() == PointRenderMode::Splat)
+    return "POINT_SPLAT";
   return "ERROR";
 }
 
@@ -204,14 +428,15 @@ size_t PointCloud::nPoints() { return points.size(); }
 glm::vec3 PointCloud::getPointPosition(size_t iPt) { return points.getValue(iPt); }
 
 
-std::vector<std::string> PointCloud::addPointCloudRules(std::vector<std::string> initRules, bool withPointCloud) {
+std::vector<std::string> PointCloud::addPointCloudRules(std::vector<std::string> initRules, bool withPointCloud,
+                                                        bool withShade) {
   initRules = addStructureRules(initRules);
   if (withPointCloud) {
     if (pointRadiusQuantityName != "") {
       initRules.push_back("SPHERE_VARIABLE_SIZE");
     }
     if (wantsCullPosition()) {
-      if (getPointRenderMode() == PointRenderMode::Sphere)
+      if (getPointRenderMode() == PointRenderMode::Sphere || getPointRenderMode() == PointRenderMode::Splat)
         initRules.push_back("SPHERE_CULLPOS_FROM_CENTER");
       else if (getPointRenderMode() == PointRenderMode::Quad)
         initRules.push_back("SPHERE_CULLPOS_FROM_CENTER_QUAD");
@@ -219,6 +444,21 @@ std::vector<std::string> PointCloud::addPointCloudRules(std::vector<std::string>
     if (transparencyQuantityName != "") {
       initRules.push_back("SPHERE_PROPAGATE_VALUEALPHA");
     }
+    if (withShade && pointSelection) {
+      initRules.push_back("SPHERE_PROPAGATE_SELECTION");
+    }
+  }
+  if (hasPositionKeyframes()) {
+    addKeyframeRule(initRules, "KEYFRAME_POSITION");
+  }
+
+  // the splat program has no geometry stage, so it uses its own variants of the rules which pass values through one
+  if (getPointRenderMode() == PointRenderMode::Splat) {
+    for (std::string& rule : initRules) {
+      if (rule == "SPHERE_VARIABLE_SIZE" || rule.rfind("SPHERE_PROPAGATE_", 0) == 0) {
+        rule = "SPLAT_" + rule.substr(std::string("SPHERE_").size());
+      }
+    }
   }
   return initRules;
 }
@@ -261,6 +501,13 @@ void PointCloud::buildPickUI(size_t localPickID) {
 
 void PointCloud::buildCustomUI() {
   ImGui::Text("# points: %lld", static_cast<long long int>(nPoints()));
+  if (voxelPreviewSize > 0.) {
+    ImGui::SameLine();
+    ImGui::TextDisabled("(drawing %s)", prettyPrintCount(voxelPreviewDrawCount).c_str());
+  } else if (lodPointBudget > 0) {
+    ImGui::SameLine();
+    ImGui::TextDisabled("(drawing %s)", prettyPrintCount(lodDrawCount).c_str());
+  }
   if (ImGui::ColorEdit3("Point color", &pointColor.get()[0], ImGuiColorEditFlags_NoInputs)) {
     setPointColor(getPointColor());
   }
@@ -282,7 +529,7 @@ void PointCloud::buildCustomOptionsUI() {
 
   if (ImGui::BeginMenu("Point Render Mode")) {
 
-    for (const PointRenderMode& m : {PointRenderMode::Sphere, PointRenderMode::Quad}) {
+    for (const PointRenderMode& m : {PointRenderMode::Sphere, PointRenderMode::Quad, PointRenderMode::Splat}) {
       bool selected = (m == getPointRenderMode());
       std::string fancyName;
       switch (m) {
@@ -292,6 +539,9 @@ void PointCloud::buildCustomOptionsUI() {
       case PointRenderMode::Quad:
         fancyName = "quad (fast)";
         break;
+      case PointRenderMode::Splat:
+        fancyName = "splat (fast, small points)";
+        break;
       }
       if (ImGui::MenuItem(fancyName.c_str(), NULL, selected)) {
         setPointRenderMode(m);
@@ -333,33 +583,127 @@ void PointCloud::buildCustomOptionsUI() {
 
     ImGui::EndMenu();
   }
+
+  if (ImGui::MenuItem("Sort Transparent Points", nullptr, transparencySorting.get())) {
+    setTransparencySorting(!transparencySorting.get());
+  }
+
+  if (ImGui::BeginMenu("Voxel Preview")) {
+    float newSize = voxelPreviewSize;
+    ImGui::PushItemWidth(150);
+    if (ImGui::InputFloat("voxel size", &newSize, 0.f, 0.f, "%.5f", ImGuiInputTextFlags_EnterReturnsTrue)) {
+      setVoxelPreviewSize(newSize);
+    }
+    if (ImGui::SliderFloat("refine pixels", &voxelPreviewRefinePixels, 1., 128., "%.0f",
+                           ImGuiSliderFlags_Logarithmic)) {
+      setVoxelPreviewRefinePixels(voxelPreviewRefinePixels);
+    }
+    ImGui::PopItemWidth();
+    if (voxelPreviewSize > 0.) {
+      ImGui::TextDisabled("%s voxels", prettyPrintCount(nVoxelPreviewVoxels()).c_str());
+    }
+    ImGui::EndMenu();
+  }
 }
 
 void PointCloud::updateObjectSpaceBounds() {
   points.ensureHostBufferPopulated();
+  setObjectSpaceBoundsFromPoints(points.data);
+  includeKeyframesInBounds();
+}
 
-  // bounding box
-  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  for (const glm::vec3& p : points.data) {
-    min = componentwiseMin(min, p);
-    max = componentwiseMax(max, p);
-  }
+void PointCloud::widenObjectSpaceBounds(const std::vector<glm::vec3>& newPoints) {
+  if (newPoints.empty()) return;
+
+  std::tuple<glm::vec3, glm::vec3> newBounds = computePointBounds(newPoints.data(), newPoints.size());
+  glm::vec3 min = componentwiseMin(std::get<0>(objectSpaceBoundingBox), std::get<0>(newBounds));
+  glm::vec3 max = componentwiseMax(std::get<1>(objectSpaceBoundingBox), std::get<1>(newBounds));
   objectSpaceBoundingBox = std::make_tuple(min, max);
 
-  // length scale, as twice the radius from the center of the bounding box
-  glm::vec3 center = 0.5f * (min + max);
-  float lengthScale = 0.0;
-  for (const glm::vec3& p : points.data) {
-    lengthScale = std::max(lengthScale, glm::length2(p - center));
+  // the exact length scale needs every point, the bounding box diagonal is a cheap upper bound on it until
+  // finalizePoints()
+  objectSpaceLengthScale = glm::length(max - min);
+
+  updateStructureExtents();
+}
+
+void PointCloud::reservePoints(size_t count) { points.reserve(count); }
+
+void PointCloud::finalizePoints() {
+  updateObjectSpaceBounds();
+  updateStructureExtents();
+  lodPointOrder.recomputeIfPopulated();
+  spatialPointOrder.recomputeIfPopulated();
+  voxelPreviewOrder.recomputeIfPopulated();
+  requestRedraw();
+}
+
+void PointCloud::pointsReplaced() {
+  points.markHostBufferUpdated();
+  pickBVHNeedsRefit = true;
+  finalizePoints();
+  keyframeInds.recomputeIfPopulated();
+}
+
+float PointCloud::getDrawBoundsPadding() {
+  if (pointRadiusQuantityName != "") {
+    // autoscaled radii are at most the base radius, unless some values are negative
+    if (!pointRadiusQuantityAutoscale || resolvePointRadiusQuantity().getDataRange().first < 0.) {
+      return std::numeric_limits<float>::infinity();
+    }
   }
-  objectSpaceLengthScale = 2 * std::sqrt(lengthScale);
+  return lodRadiusScale * pointRadius.get().asAbsolute();
+}
+
+bool PointCloud::supportsRayCastPicking() {
+  return !hasPositionKeyframes() && pointRadiusQuantityName == "" && voxelPreviewSize == 0.;
+}
+
+bool PointCloud::rayCastPick(glm::dvec3 worldRayStart, glm::vec3 rayDir, float& tHit, size_t& localPickInd) {
+  points.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = points.data;
+  ensurePickBVH(pos.size(), [&](std::vector<BVH::Box>& boxes) {
+    parallelFor(0, pos.size(), [&](size_t chunkBegin, size_t chunkEnd) {
+      for (size_t i = chunkBegin; i < chunkEnd; i++) boxes[i] = BVH::Box{pos[i], pos[i]};
+    });
+  });
+
+  // The hierarchy is over the centers, the radius is added at query time so it can change without a refit
+  float radius = getDrawBoundsPadding();
+  glm::vec3 rayStart = worldRayToObjectSpace(worldRayStart, rayDir);
+  return pickBVH->rayCast(
+      rayStart, rayDir, tHit,
+      [&](size_t iPt, float& tMax) {
+        float t;
+        if (!raySphereIntersection(rayStart, rayDir, pos[iPt], radius, t) || t >= tMax) return false;
+        tMax = t;
+        localPickInd = iPt;
+        return true;
+      },
+      radius);
 }
 
 
 std::string PointCloud::typeName() { return structureTypeName; }
 
 
+ElementSelection& PointCloud::getPointSelection() {
+  if (!pointSelection) {
+    pointSelection.reset(new ElementSelection(nPoints()));
+    refresh(); // the programs gain the selection rule
+  }
+  pointSelection->resize(nPoints());
+  return *pointSelection;
+}
+
+bool PointCloud::hasPointSelection() { return pointSelection != nullptr; }
+
+void PointCloud::removePointSelection() {
+  if (!pointSelection) return;
+  pointSelection.reset();
+  refresh();
+}
+
 void PointCloud::refresh() {
   program.reset();
   pickProgram.reset();
@@ -373,12 +717,19 @@ void PointCloud::setPointRadiusQuantity(PointCloudScalarQuantity* quantity, bool
 }
 
 void PointCloud::setPointRadiusQuantity(std::string name, bool autoScale) {
+  bool hadRadiusQuantity = pointRadiusQuantityName != "";
   pointRadiusQuantityName = name;
   pointRadiusQuantityAutoscale = autoScale;
 
   resolvePointRadiusQuantity(); // do it once, just so we fail fast if it doesn't exist
 
-  refresh();
+  if (hadRadiusQuantity) {
+    // the shader rules are the same for any radius quantity, only the attribute needs to change
+    rebindPointProgramGeometryAttributes();
+    requestRedraw();
+  } else {
+    refresh();
+  }
 }
 
 void PointCloud::clearPointRadiusQuantity() {
@@ -391,6 +742,7 @@ void PointCloud::setTransparencyQuantity(PointCloudScalarQuantity* quantity) {
 }
 
 void PointCloud::setTransparencyQuantity(std::string name) {
+  bool hadTransparencyQuantity = transparencyQuantityName != "";
   transparencyQuantityName = name;
   resolveTransparencyQuantity(); // do it once, just so we fail fast if it doesn't exist
 
@@ -399,7 +751,12 @@ void PointCloud::setTransparencyQuantity(std::string name) {
     options::transparencyMode = TransparencyMode::Pretty;
   }
 
-  refresh();
+  if (hadTransparencyQuantity) {
+    rebindPointProgramGeometryAttributes(); // as for the radius, the rules are unchanged
+    requestRedraw();
+  } else {
+    refresh();
+  }
 }
 
 void PointCloud::clearTransparencyQuantity() {
@@ -431,20 +788,51 @@ PointCloudQuantity::PointCloudQuantity(std::string name_, PointCloud& pointCloud
 
 void PointCloudQuantity::buildInfoGUI(size_t pointInd) {}
 
+void PointCloudQuantity::rebindPointProgramGeometryAttributes() {}
+
 // === Quantity adders
 
 
-PointCloudColorQuantity* PointCloud::addColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors) {
+PointCloudColorQuantity* PointCloud::addColorQuantityImpl(std::string name, std::vector<glm::vec3> colors) {
+  checkForQuantityWithNameAndDeleteOrError(name);
+  PointCloudColorQuantity* q = new PointCloudColorQuantity(name, std::move(colors), *this);
+  addQuantity(q);
+  return q;
+}
+
+PointCloudScalarQuantity* PointCloud::addScalarQuantityImpl(std::string name, std::vector<float> data, DataType type) {
   checkForQuantityWithNameAndDeleteOrError(name);
-  PointCloudColorQuantity* q = new PointCloudColorQuantity(name, colors, *this);
+  PointCloudScalarQuantity* q = new PointCloudScalarQuantity(name, std::move(data), *this, type);
   addQuantity(q);
   return q;
 }
 
-PointCloudScalarQuantity* PointCloud::addScalarQuantityImpl(std::string name, const std::vector<float>& data,
-                                                            DataType type) {
+PointCloudScalarQuantity* PointCloud::addScalarQuantity(std::string name, std::vector<float>&& values,
+                                                        DataType type) {
+  validateSize(values, nPoints(), "point cloud scalar quantity " + name);
+  return addScalarQuantityImpl(name, std::move(values), type);
+}
+
+PointCloudColorQuantity* PointCloud::addColorQuantity(std::string name, std::vector<glm::vec3>&& values) {
+  validateSize(values, nPoints(), "point cloud color quantity " + name);
+  return addColorQuantityImpl(name, std::move(values));
+}
+
+PointCloudVectorQuantity* PointCloud::addVectorQuantity(std::string name, std::vector<glm::vec3>&& vectors,
+                                                        VectorType vectorType) {
+  validateSize(vectors, nPoints(), "point cloud vector quantity " + name);
+  return addVectorQuantityImpl(name, std::move(vectors), vectorType);
+}
+
+PointCloudScalarQuantity* PointCloud::addScalarQuantityView(std::string name, const float* values, size_t count,
+                                                            std::shared_ptr<void> lifetimeToken, DataType type) {
+  if (count != nPoints()) {
+    exception("point cloud scalar quantity " + name + " view has size " + std::to_string(count) + ", expected " +
+              std::to_string(nPoints()));
+  }
   checkForQuantityWithNameAndDeleteOrError(name);
-  PointCloudScalarQuantity* q = new PointCloudScalarQuantity(name, data, *this, type);
+  PointCloudScalarQuantity* q = new PointCloudScalarQuantity(name, std::vector<float>(), *this, type);
+  q->setValuesView(values, count, lifetimeToken);
   addQuantity(q);
   return q;
 }
@@ -469,10 +857,10 @@ PointCloud::addLocalParameterizationQuantityImpl(std::string name, const std::ve
   return q;
 }
 
-PointCloudVectorQuantity* PointCloud::addVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors,
+PointCloudVectorQuantity* PointCloud::addVectorQuantityImpl(std::string name, std::vector<glm::vec3> vectors,
                                                             VectorType vectorType) {
   checkForQuantityWithNameAndDeleteOrError(name);
-  PointCloudVectorQuantity* q = new PointCloudVectorQuantity(name, vectors, *this, vectorType);
+  PointCloudVectorQuantity* q = new PointCloudVectorQuantity(name, std::move(vectors), *this, vectorType);
   addQuantity(q);
   return q;
 }
@@ -485,6 +873,9 @@ PointCloud* PointCloud::setPointRenderMode(PointRenderMode newVal) {
   case PointRenderMode::Quad:
     pointRenderMode = "quad";
     break;
+  case PointRenderMode::Splat:
+    pointRenderMode = "splat";
+    break;
   }
   refresh();
   polyscope::requestRedraw();
@@ -496,6 +887,8 @@ PointRenderMode PointCloud::getPointRenderMode() {
     return PointRenderMode::Sphere;
   else if (pointRenderMode.get() == "quad")
     return PointRenderMode::Quad;
+  else if (pointRenderMode.get() == "splat")
+    return PointRenderMode::Splat;
   return PointRenderMode::Sphere; // should never happen
 }
 
@@ -507,8 +900,9 @@ PointCloud* PointCloud::setPointColor(glm::vec3 newVal) {
 glm::vec3 PointCloud::getPointColor() { return pointColor.get(); }
 
 PointCloud* PointCloud::setMaterial(std::string m) {
+  bool needsRefresh = render::engine->materialChangeNeedsRefresh(material.get(), m);
   material = m;
-  refresh();
+  if (needsRefresh) refresh();
   requestRedraw();
   return this;
 }
@@ -521,4 +915,83 @@ PointCloud* PointCloud::setPointRadius(double newVal, bool isRelative) {
 }
 double PointCloud::getPointRadius() { return pointRadius.get().asAbsolute(); }
 
+PointCloud* PointCloud::setLODPointBudget(size_t newBudget) {
+  lodPointBudget = newBudget;
+  polyscope::requestRedraw();
+  return this;
+}
+size_t PointCloud::getLODPointBudget() { return lodPointBudget; }
+size_t PointCloud::nLODPointsDrawn() { return lodDrawCount; }
+
+PointCloud* PointCloud::setSpatialDrawOrder(bool newVal) {
+  spatialDrawOrder = newVal;
+  polyscope::requestRedraw();
+  return this;
+}
+bool PointCloud::getSpatialDrawOrder() { return spatialDrawOrder; }
+
+PointCloud* PointCloud::setTransparencySorting(bool newVal) {
+  transparencySorting = newVal;
+  if (!newVal) {
+    depthSort = std::future<std::vector<uint32_t>>(); // does not wait for the thread, it finishes on its own
+    depthPointOrder.data.clear();
+  }
+  polyscope::requestRedraw();
+  return this;
+}
+bool PointCloud::getTransparencySorting() { return transparencySorting.get(); }
+
+PointCloud* PointCloud::setVoxelPreviewSize(float newSize) {
+  newSize = std::max(newSize, 0.f);
+  if (newSize == voxelPreviewSize) return this;
+  voxelPreviewSize = newSize;
+  voxelPreviewOrder.recomputeIfPopulated(); // rebins, or frees the grid if the preview is off
+  polyscope::requestRedraw();
+  return this;
+}
+float PointCloud::getVoxelPreviewSize() { return voxelPreviewSize; }
+
+PointCloud* PointCloud::setVoxelPreviewRefinePixels(float newVal) {
+  voxelPreviewRefinePixels = newVal;
+  polyscope::requestRedraw();
+  return this;
+}
+float PointCloud::getVoxelPreviewRefinePixels() { return voxelPreviewRefinePixels; }
+
+size_t PointCloud::nVoxelPreviewVoxels() {
+  if (voxelPreviewSize > 0.) voxelPreviewOrder.ensureHostBufferPopulated();
+  return voxelPreviewCellStart.empty() ? 0 : voxelPreviewCellStart.size() - 1;
+}
+size_t PointCloud::nVoxelPreviewPointsDrawn() { return voxelPreviewDrawCount; }
+
+bool PointCloud::drawsSortedTransparency() {
+  return transparencySorting.get() && getTransparency() < 1. &&
+         render::engine->getTransparencyMode() == TransparencyMode::WeightedBlended && lodPointBudget == 0 &&
+         voxelPreviewSize == 0. && !positionKeyframes;
+}
+
+PointCloud* registerPointCloud(std::string name, std::vector<glm::vec3>&& points) {
+  checkInitialized();
+
+  PointCloud* s = new PointCloud(name, std::move(points));
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+PointCloud* beginPointCloud(std::string name, size_t expectedCount) {
+  checkInitialized();
+
+  PointCloud* s = new PointCloud(name, std::vector<glm::vec3>());
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+    return s;
+  }
+  if (expectedCount > 0) s->reservePoints(expectedCount);
+  return s;
+}
+
 } // namespace polyscope
@@ -9,9 +9,9 @@
 namespace polyscope {
 
 
-PointCloudColorQuantity::PointCloudColorQuantity(std::string name, const std::vector<glm::vec3>& values_,
+PointCloudColorQuantity::PointCloudColorQuantity(std::string name, std::vector<glm::vec3> values_,
                                                  PointCloud& pointCloud_)
-    : PointCloudQuantity(name, pointCloud_, true), ColorQuantity(*this, values_) {}
+    : PointCloudQuantity(name, pointCloud_, true), ColorQuantity(*this, std::move(values_)) {}
 
 void PointCloudColorQuantity::draw() {
   if (!isEnabled()) return;
@@ -26,7 +26,7 @@ void PointCloudColorQuantity::draw() {
   setColorUniforms(*pointProgram);
   render::engine->setMaterialUniforms(*pointProgram, parent.getMaterial());
 
-  pointProgram->draw();
+  parent.drawPointProgram(*pointProgram);
 }
 
 std::string PointCloudColorQuantity::niceName() { return name + " (color)"; }
@@ -59,6 +59,10 @@ void PointCloudColorQuantity::refresh() {
   Quantity::refresh();
 }
 
+void PointCloudColorQuantity::rebindPointProgramGeometryAttributes() {
+  if (pointProgram) parent.setPointProgramGeometryAttributes(*pointProgram);
+}
+
 
 void PointCloudColorQuantity::buildPickUI(size_t ind) {
   ImGui::TextUnformatted(name.c_str());
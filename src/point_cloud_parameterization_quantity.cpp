@@ -29,7 +29,7 @@ void PointCloudParameterizationQuantity::draw() {
   parent.setPointCloudUniforms(*program);
   render::engine->setMaterialUniforms(*program, parent.getMaterial());
 
-  program->draw();
+  parent.drawPointProgram(*program);
 }
 
 void PointCloudParameterizationQuantity::createProgram() {
@@ -81,6 +81,10 @@ void PointCloudParameterizationQuantity::refresh() {
   Quantity::refresh();
 }
 
+void PointCloudParameterizationQuantity::rebindPointProgramGeometryAttributes() {
+  if (program) parent.setPointProgramGeometryAttributes(*program);
+}
+
 std::string PointCloudParameterizationQuantity::niceName() { return name + " (parameterization)"; }
 
 void PointCloudParameterizationQuantity::buildPickUI(size_t ind) {
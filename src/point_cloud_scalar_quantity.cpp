@@ -9,9 +9,9 @@
 namespace polyscope {
 
 
-PointCloudScalarQuantity::PointCloudScalarQuantity(std::string name, const std::vector<float>& values_,
+PointCloudScalarQuantity::PointCloudScalarQuantity(std::string name, std::vector<float> values_,
                                                    PointCloud& pointCloud_, DataType dataType_)
-    : PointCloudQuantity(name, pointCloud_, true), ScalarQuantity(*this, values_, dataType_) {}
+    : PointCloudQuantity(name, pointCloud_, true), ScalarQuantity(*this, std::move(values_), dataType_) {}
 
 void PointCloudScalarQuantity::draw() {
   if (!isEnabled()) return;
@@ -27,7 +27,7 @@ void PointCloudScalarQuantity::draw() {
   setScalarUniforms(*pointProgram);
   render::engine->setMaterialUniforms(*pointProgram, parent.getMaterial());
 
-  pointProgram->draw();
+  parent.drawPointProgram(*pointProgram);
 }
 
 
@@ -79,6 +79,10 @@ void PointCloudScalarQuantity::refresh() {
   Quantity::refresh();
 }
 
+void PointCloudScalarQuantity::rebindPointProgramGeometryAttributes() {
+  if (pointProgram) parent.setPointProgramGeometryAttributes(*pointProgram);
+}
+
 void PointCloudScalarQuantity::buildPickUI(size_t ind) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
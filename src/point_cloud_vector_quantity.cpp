@@ -16,7 +16,7 @@ PointCloudVectorQuantity::PointCloudVectorQuantity(std::string name, std::vector
                                                    PointCloud& pointCloud_, VectorType vectorType_)
 
     : PointCloudQuantity(name, pointCloud_),
-      VectorQuantity<PointCloudVectorQuantity>(*this, vectors_, parent.points, vectorType_) {}
+      VectorQuantity<PointCloudVectorQuantity>(*this, std::move(vectors_), parent.points, vectorType_) {}
 
 void PointCloudVectorQuantity::draw() {
   if (!isEnabled()) return;
@@ -30,6 +30,8 @@ void PointCloudVectorQuantity::refresh() {
 
 void PointCloudVectorQuantity::buildCustomUI() { buildVectorUI(); }
 
+bool PointCloudVectorQuantity::drawsWithinStructureBounds() { return false; }
+
 void PointCloudVectorQuantity::buildPickUI(size_t ind) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
@@ -2,16 +2,29 @@
 
 #include "polyscope/polyscope.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
-#include <thread>
 
 #include "imgui.h"
+#include "imgui_internal.h"
 
+#include "polyscope/adaptive_quality.h"
+#include "polyscope/frame_pacing.h"
+#include "polyscope/histogram.h"
+#include "polyscope/implicit_helpers.h"
 #include "polyscope/options.h"
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
 #include "polyscope/render/engine.h"
+#include "polyscope/render_image_quantity_base.h"
+#include "polyscope/scratch_buffer.h"
+#include "polyscope/tasks.h"
+#include "polyscope/trace.h"
 #include "polyscope/view.h"
 
 #include "stb_image.h"
@@ -40,9 +53,18 @@ struct ContextEntry {
 std::vector<ContextEntry> contextStack;
 int frameTickStack = 0;
 
-bool redrawNextFrame = true;
+// atomic, since buffers computed off the render thread (see prepareStructuresHostData()) request redraws
+std::atomic<bool> redrawNextFrame{true};
+std::atomic<uint64_t> sceneGeneration{0};
 bool unshowRequested = false;
 
+// Idling, see options::idleWhenUnchanged
+std::atomic<bool> idleWaiting{false};
+bool lastFrameDrewScene = true;
+int nQuietFrames = 0;
+const int quietFramesBeforeIdle = 3; // e.g. ImGui updates hover states the frame after the input which caused them
+const double idleWakeSeconds = 0.25;
+
 // Some state about imgui windows to stack them
 float imguiStackMargin = 10;
 float lastWindowHeightPolyscope = 200;
@@ -50,8 +72,6 @@ float lastWindowHeightUser = 200;
 float leftWindowsWidth = 305;
 float rightWindowsWidth = 500;
 
-auto lastMainLoopIterTime = std::chrono::steady_clock::now();
-
 const std::string prefsFilename = ".polyscope.ini";
 
 void readPrefsFile() {
@@ -130,8 +150,74 @@ std::map<std::string, std::unique_ptr<Structure>>& getStructureMapCreateIfNeeded
   return state::structures[typeName];
 }
 
+// The enabled structures, in the order of state::structures, rebuilt only when invalidated
+const std::vector<Structure*>& getStructureDrawList() {
+  Context& ctx = state::globalContext;
+  if (!ctx.structureDrawListValid) {
+    ctx.structureDrawList.clear();
+    for (auto& catMap : state::structures) {
+      for (auto& s : catMap.second) {
+        if (s.second->isEnabled()) ctx.structureDrawList.push_back(s.second.get());
+      }
+    }
+    ctx.structureDrawListValid = true;
+  }
+  return ctx.structureDrawList;
+}
+
+StructureHandle addToStructureRegistry(Structure* s) {
+  Context& ctx = state::globalContext;
+  uint32_t slot;
+  if (ctx.freeStructureSlots.empty()) {
+    slot = static_cast<uint32_t>(ctx.structureSlots.size());
+    ctx.structureSlots.push_back(nullptr);
+    ctx.structureSlotGenerations.push_back(1);
+  } else {
+    slot = ctx.freeStructureSlots.back();
+    ctx.freeStructureSlots.pop_back();
+  }
+  ctx.structureSlots[slot] = s;
+  ctx.structuresByName.emplace(s->name, s);
+  internal::invalidateStructureDrawList();
+  return (static_cast<StructureHandle>(ctx.structureSlotGenerations[slot]) << 32) | slot;
+}
+
+void removeFromStructureRegistry(Structure* s) {
+  Context& ctx = state::globalContext;
+  uint32_t slot = static_cast<uint32_t>(s->getHandle() & 0xFFFFFFFF);
+  ctx.structureSlots[slot] = nullptr;
+  ctx.structureSlotGenerations[slot]++; // old handles to this slot are now stale
+  ctx.freeStructureSlots.push_back(slot);
+  auto range = ctx.structuresByName.equal_range(s->name);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == s) {
+      ctx.structuresByName.erase(it);
+      break;
+    }
+  }
+  internal::invalidateStructureDrawList();
+}
+
+// The registered structure of that type and name, or nullptr
+Structure* findStructure(const std::string& type, const std::string& name) {
+  auto range = state::globalContext.structuresByName.equal_range(name);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->typeName() == type) return it->second;
+  }
+  return nullptr;
+}
+
 } // namespace
 
+namespace internal {
+void invalidateStructureDrawList() {
+  state::globalContext.structureDrawListValid = false;
+  invalidateGroupEnabledState();
+}
+
+void invalidateGroupEnabledState() { state::globalContext.groupEnabledGeneration++; }
+} // namespace internal
+
 // === Core global functions
 
 void init(std::string backend) {
@@ -144,17 +230,28 @@ void init(std::string backend) {
   }
 
   state::backend = backend;
+  resetStartupStats();
 
   if (options::usePrefsFile) {
+    StartupPhase phase("prefs file");
     readPrefsFile();
   }
 
   // Initialize the rendering engine
   render::initializeRenderEngine(backend);
 
-  // Initialie ImGUI
-  IMGUI_CHECKVERSION();
-  render::engine->initializeImGui();
+  // Initialie ImGUI. The fonts are prepared later, when the GUI is first drawn.
+  {
+    StartupPhase phase("GUI");
+    IMGUI_CHECKVERSION();
+    render::engine->initializeImGui();
+  }
+
+  // Compile the shader variants earlier runs used, if they were recorded
+  {
+    StartupPhase phase("shader prewarm");
+    render::engine->prewarmShaderVariantTable();
+  }
 
   // Create an initial context based context. Note that calling show() never actually uses this context, because it
   // pushes a new one each time. But using frameTick() may use this context.
@@ -164,6 +261,12 @@ void init(std::string backend) {
 
   state::initialized = true;
   state::doDefaultMouseInteraction = true;
+
+  if (options::verbosity > 2) {
+    for (const FrameSectionStats& phase : getStartupStats()) {
+      info("startup: " + phase.name + " took " + std::to_string(phase.cpuMs) + " ms");
+    }
+  }
 }
 
 void checkInitialized() {
@@ -174,6 +277,32 @@ void checkInitialized() {
 
 bool isInitialized() { return state::initialized; }
 
+namespace {
+// With options::idleWhenUnchanged, block until something happens if the last few frames changed nothing
+void waitWhileIdle() {
+  if (!options::idleWhenUnchanged) return;
+
+  bool busy = lastFrameDrewScene || redrawNextFrame || options::alwaysRedraw || view::midflight ||
+              view::getViewportCount() > 0 || state::userCallback || isBackgroundCallbackRunning() || isRecording() ||
+              isRemoteSessionActive();
+  if (busy) {
+    nQuietFrames = 0;
+    return;
+  }
+  if (nQuietFrames < quietFramesBeforeIdle) {
+    nQuietFrames++;
+    return;
+  }
+
+  POLYSCOPE_TRACE_SPAN("waitWhileIdle");
+  idleWaiting = true;
+  if (!redrawNextFrame && !hasQueuedUpdates()) {
+    render::engine->waitEvents(idleWakeSeconds);
+  }
+  idleWaiting = false;
+}
+} // namespace
+
 void pushContext(std::function<void()> callbackFunction, bool drawDefaultUI) {
 
   // Create a new context and push it on to the stack
@@ -210,17 +339,8 @@ void pushContext(std::function<void()> callbackFunction, bool drawDefaultUI) {
   while (contextStack.size() >= currentContextStackSize) {
 
     // The windowing system will let the main loop busy-loop on some platforms. Make sure that doesn't happen.
-    if (options::maxFPS != -1) {
-      auto currTime = std::chrono::steady_clock::now();
-      long microsecPerLoop = 1000000 / options::maxFPS;
-      microsecPerLoop = (95 * microsecPerLoop) / 100; // give a little slack so we actually hit target fps
-      while (std::chrono::duration_cast<std::chrono::microseconds>(currTime - lastMainLoopIterTime).count() <
-             microsecPerLoop) {
-        std::this_thread::yield();
-        currTime = std::chrono::steady_clock::now();
-      }
-    }
-    lastMainLoopIterTime = std::chrono::steady_clock::now();
+    waitForNextFrame();
+    waitWhileIdle();
 
     mainLoopIteration();
 
@@ -277,18 +397,77 @@ void frameTick() {
   frameTickStack--;
 }
 
-void requestRedraw() { redrawNextFrame = true; }
+void requestRedraw() {
+  redrawNextFrame = true;
+  sceneGeneration++;
+  internal::wakeIdleMainLoop();
+}
+
+namespace internal {
+void wakeIdleMainLoop() {
+  // the main loop sets the flag before checking for work, so either it sees the work, or this sees the flag
+  if (idleWaiting) {
+    render::engine->wakeWaitEvents();
+  }
+}
+} // namespace internal
 bool redrawRequested() { return redrawNextFrame; }
+uint64_t getSceneGeneration() { return sceneGeneration; }
+
+namespace {
+
+// Draw a list of structures. The uniforms are computed first, concurrently across the structures when there are many of
+// them, then the draws are submitted in order on this thread.
+void drawStructureList(const std::vector<Structure*>& toDraw) {
+  parallelFor(
+      0, toDraw.size(),
+      [&](size_t begin, size_t end) {
+        render::UniformRecording recording;
+        for (size_t i = begin; i < end; i++) {
+          toDraw[i]->prepareDraw();
+        }
+      },
+      32);
+
+  for (Structure* s : toDraw) {
+    FrameStatsSection section(*s, "draw");
+    POLYSCOPE_TRACE_SPAN("draw", s->name);
+    s->draw();
+  }
+}
+
+// Compute the derived data of structures which are about to be prepared for drawing, e.g. on the first frame after
+// many meshes were registered, concurrently across the structures. The programs are then compiled and the data uploaded
+// on this thread as before, when each structure is first drawn.
+void prepareStructuresHostData() {
+  std::vector<Structure*> pending;
+  for (Structure* s : getStructureDrawList()) {
+    if (s->hasPendingHostData()) pending.push_back(s);
+  }
+  if (pending.empty()) return;
+
+  POLYSCOPE_TRACE_SPAN("prepareStructuresHostData");
+  parallelFor(
+      0, pending.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          pending[i]->prepareHostData();
+        }
+      },
+      1);
+}
+
+} // namespace
 
 void drawStructures() {
 
   // Draw all off the structures registered with polyscope
 
-  for (auto& catMap : state::structures) {
-    for (auto& s : catMap.second) {
-      s.second->draw();
-    }
+  std::vector<Structure*> toDraw;
+  for (Structure* s : getStructureDrawList()) {
+    if (s->isInViewFrustum()) toDraw.push_back(s);
   }
+  drawStructureList(toDraw);
 
   // Also render any slice plane geometry
   for (std::unique_ptr<SlicePlane>& s : state::slicePlanes) {
@@ -296,28 +475,102 @@ void drawStructures() {
   }
 }
 
+void drawStructuresTransparencyFiltered(bool transparent) {
+
+  // Draw only the structures on one side of the opaque/transparent split, used by the weighted blended transparency
+  // mode which renders the two groups to different buffers.
+
+  std::vector<Structure*> toDraw;
+  for (Structure* s : getStructureDrawList()) {
+    bool isTransparent = s->getTransparency() < 1.;
+    if (transparent && s->drawsSortedTransparency()) continue; // see drawSortedTransparentStructures()
+    if (isTransparent == transparent && s->isInViewFrustum()) toDraw.push_back(s);
+  }
+  drawStructureList(toDraw);
+
+  // Slice plane geometry is always opaque
+  if (!transparent) {
+    for (std::unique_ptr<SlicePlane>& s : state::slicePlanes) {
+      s->drawGeometry();
+    }
+  }
+}
+
+// Draw the transparent structures which sort their own fragments back to front, blended directly over the scene buffer
+// after the weighted composite. They test against the opaque depth but do not write it.
+void drawSortedTransparentStructures() {
+  std::vector<Structure*> toDraw;
+  for (Structure* s : getStructureDrawList()) {
+    if (s->drawsSortedTransparency() && s->isInViewFrustum()) toDraw.push_back(s);
+  }
+  if (toDraw.empty()) return;
+
+  render::engine->setDepthMode(DepthMode::LEqualReadOnly);
+  render::engine->setBlendMode(BlendMode::AlphaOver);
+  render::engine->sortedTransparencyPass = true;
+  drawStructureList(toDraw);
+  render::engine->sortedTransparencyPass = false;
+}
+
+// Draw the opaque structures to depth only, and keep a copy of the depth for the shading pass to test against. Leaves
+// the scene buffer bound and cleared, ready for the shading pass. See Engine::setDepthPrepass().
+void renderDepthPrepass() {
+  FrameStatsSection section("depth prepass");
+
+  render::engine->depthPrepassStage = 1;
+  render::engine->applyTransparencySettings();
+  render::engine->setColorMask({false, false, false, false});
+  std::vector<Structure*> toDraw;
+  for (Structure* s : getStructureDrawList()) {
+    if (s->getTransparency() == 1. && s->isInViewFrustum()) toDraw.push_back(s);
+  }
+  drawStructureList(toDraw);
+  render::engine->setColorMask();
+
+  render::engine->updatePrepassDepthTexture();
+
+  // The shading pass starts from an empty depth buffer, so the surfaces which wrote the prepass depth pass the test
+  render::engine->bindSceneBuffer();
+  render::engine->clearSceneBuffer();
+  render::engine->depthPrepassStage = 2;
+}
+
+void updateCullingStats() {
+  // Record how many enabled structures are culled from the main view. The structures are tested again wherever they are
+  // drawn, since some passes (like the ground plane reflection) draw with a different view.
+  render::RenderStats& stats = render::engine->stats;
+  stats.structuresDrawn = 0;
+  stats.structuresCulled = 0;
+  stats.structuresOccluded = 0;
+  for (Structure* s : getStructureDrawList()) {
+    if (s->isInViewFrustum()) {
+      stats.structuresDrawn++;
+    } else {
+      stats.structuresCulled++;
+      if (s->isOccluded()) stats.structuresOccluded++;
+    }
+  }
+}
+
 void drawStructuresDelayed() {
   // "delayed" drawing allows structures to render things which should be rendered after most of the scene has been
   // drawn
-  for (auto& catMap : state::structures) {
-    for (auto& s : catMap.second) {
-      s.second->drawDelayed();
-    }
+  drawCompositedRenderImages();
+  for (Structure* s : getStructureDrawList()) {
+    if (!s->isInViewFrustum()) continue;
+    FrameStatsSection section(*s, "drawDelayed");
+    s->drawDelayed();
   }
 }
 
 namespace {
 
 float dragDistSinceLastRelease = 0.0;
+int navigatedViewport = -1; // the view under the mouse when the current drag started, see view::addViewport()
 
 void processInputEvents() {
   ImGuiIO& io = ImGui::GetIO();
 
-  // If any mouse button is pressed, trigger a redraw
-  if (ImGui::IsAnyMouseDown()) {
-    requestRedraw();
-  }
-
   bool widgetCapturedMouse = false;
   for (WeakHandle<Widget> wHandle : state::widgets) {
     if (wHandle.isValid()) {
@@ -329,8 +582,23 @@ void processInputEvents() {
     }
   }
 
+  // If any mouse button is pressed in the scene, trigger a redraw. Presses on the GUI only redraw the scene if they
+  // edit something (see draw()), so the cached scene is reused while e.g. a window is dragged or a menu is open.
+  if (ImGui::IsAnyMouseDown() && (!io.WantCaptureMouse || widgetCapturedMouse)) {
+    requestRedraw();
+  }
+
+  // Navigation and picks apply to the view under the mouse, and stay with it for the whole of a drag
+  if (!ImGui::IsAnyMouseDown() || ImGui::IsMouseClicked(0) || ImGui::IsMouseClicked(1)) {
+    navigatedViewport = view::getViewportAtScreenCoords(glm::vec2{io.MousePos.x, io.MousePos.y});
+  }
+  if (navigatedViewport >= static_cast<int>(view::getViewportCount())) navigatedViewport = -1;
+
   // Handle scroll events for 3D view
   if (state::doDefaultMouseInteraction) {
+    if (navigatedViewport >= 0) view::beginViewport(navigatedViewport);
+    glm::vec4 viewRect = view::getCurrentViewportScreenRect();
+
     if (!io.WantCaptureMouse && !widgetCapturedMouse) {
       double xoffset = io.MouseWheelH;
       double yoffset = io.MouseWheel;
@@ -366,7 +634,7 @@ void processInputEvents() {
       bool dragRight = !dragLeft && ImGui::IsMouseDragging(1); // left takes priority, so only one can be true
       if (dragLeft || dragRight) {
 
-        glm::vec2 dragDelta{io.MouseDelta.x / view::windowWidth, -io.MouseDelta.y / view::windowHeight};
+        glm::vec2 dragDelta{io.MouseDelta.x / viewRect.z, -io.MouseDelta.y / viewRect.w};
         dragDistSinceLastRelease += std::abs(dragDelta.x);
         dragDistSinceLastRelease += std::abs(dragDelta.y);
 
@@ -379,8 +647,8 @@ void processInputEvents() {
           view::processZoom(dragDelta.y * 5);
         }
         if (isRotate) {
-          glm::vec2 currPos{io.MousePos.x / view::windowWidth,
-                            (view::windowHeight - io.MousePos.y) / view::windowHeight};
+          glm::vec2 currPos{(io.MousePos.x - viewRect.x) / viewRect.z,
+                            (view::windowHeight - io.MousePos.y - viewRect.y) / viewRect.w};
           currPos = (currPos * 2.0f) - glm::vec2{1.0, 1.0};
           if (std::abs(currPos.x) <= 1.0 && std::abs(currPos.y) <= 1.0) {
             view::processRotate(currPos - 2.0f * dragDelta, currPos);
@@ -413,6 +681,8 @@ void processInputEvents() {
         dragDistSinceLastRelease = 0.0;
       }
     }
+
+    view::endViewport();
   }
 
   // === Key-press inputs
@@ -429,7 +699,10 @@ void renderSlicePlanes() {
 }
 
 void renderScene() {
+  FrameStatsSection sceneSection("render scene");
+  POLYSCOPE_TRACE_SPAN("renderScene");
   processLazyProperties();
+  prepareStructuresHostData();
 
   render::engine->applyTransparencySettings();
 
@@ -441,9 +714,12 @@ void renderScene() {
 
   // If a view has never been set, this will set it to the home view
   view::ensureViewValid();
+  render::engine->updateFrameUniforms();
 
   if (!options::renderScene) return;
 
+  updateCullingStats();
+
   if (render::engine->getTransparencyMode() == TransparencyMode::Pretty) {
     // Special depth peeling case: multiple render passes
     // We will perform several "peeled" rounds of rendering in to the usual scene buffer. After each, we will manually
@@ -460,17 +736,26 @@ void renderScene() {
     render::engine->sceneDepthMinFrame->clear();
 
 
-    for (int iPass = 0; iPass < options::transparencyRenderPasses; iPass++) {
+    render::engine->stats.transparencyRenderPassesUsed = 0;
+    int nPasses = adaptiveQualityRenderPasses();
+    for (int iPass = 0; iPass < nPasses; iPass++) {
+      FrameStatsSection passSection("peel pass " + std::to_string(iPass));
 
       render::engine->bindSceneBuffer();
       render::engine->clearSceneBuffer();
 
+      // Count the samples drawn by this pass. Once a pass peels nothing new, all later passes would be empty too.
+      bool countingSamples = render::engine->beginSamplesPassedQuery();
+
       render::engine->applyTransparencySettings();
       drawStructures();
 
       // Draw ground plane, slicers, etc
       bool isRedraw = iPass > 0;
-      render::engine->groundPlane.draw(isRedraw);
+      {
+        FrameStatsSection groundSection("ground plane");
+        render::engine->groundPlane.draw(isRedraw);
+      }
       if (!isRedraw) {
         // Only on first pass (kinda weird, but works out, and doesn't really matter)
         renderSlicePlanes();
@@ -478,6 +763,11 @@ void renderScene() {
         drawStructuresDelayed();
       }
 
+      if (countingSamples && render::engine->endSamplesPassedQuery() == 0) {
+        break;
+      }
+      render::engine->stats.transparencyRenderPassesUsed++;
+
       // Composite the result of this pass in to the result buffer
       render::engine->sceneBufferFinal->bind();
       render::engine->setDepthMode(DepthMode::Disable);
@@ -489,31 +779,106 @@ void renderScene() {
     }
 
 
+  } else if (render::engine->getTransparencyMode() == TransparencyMode::WeightedBlended) {
+    // Weighted blended transparency: opaque structures are drawn as usual, then all transparent structures are
+    // accumulated in a single order-independent pass and composited over the top.
+
+    // The weighted buffer shares the scene depth buffer, so it must be cleared before any opaque geometry is drawn
+    render::engine->sceneBufferWeighted->clear();
+    render::engine->bindSceneBuffer();
+    render::engine->clearSceneBuffer();
+
+    render::engine->applyTransparencySettings();
+    drawStructuresTransparencyFiltered(false);
+    {
+      FrameStatsSection groundSection("ground plane");
+      render::engine->groundPlane.draw();
+    }
+
+    // Accumulate transparent structures
+    render::engine->bindSceneBufferWeighted();
+    render::engine->weightedTransparencyPass = true;
+    render::engine->applyTransparencySettings();
+    drawStructuresTransparencyFiltered(true);
+    render::engine->weightedTransparencyPass = false;
+
+    // Composite the weighted average over the opaque scene
+    render::engine->bindSceneBuffer();
+    render::engine->setDepthMode(DepthMode::Disable);
+    render::engine->setBlendMode(BlendMode::AlphaOver);
+    render::engine->compositeWeighted->draw();
+    drawSortedTransparentStructures();
+
+    renderSlicePlanes();
+    render::engine->applyTransparencySettings();
+    drawStructuresDelayed();
+
+    render::engine->copySceneToFinal();
+
   } else {
-    // Normal case: single render pass
+    // Normal case: single render pass (after the depth prepass, if enabled)
+
+    if (render::engine->depthPrepassActive()) {
+      renderDepthPrepass();
+    }
 
     render::engine->applyTransparencySettings();
     drawStructures();
+    render::engine->depthPrepassStage = 0;
 
-    render::engine->groundPlane.draw();
+    {
+      FrameStatsSection groundSection("ground plane");
+      render::engine->groundPlane.draw();
+    }
     renderSlicePlanes();
 
     render::engine->applyTransparencySettings();
     drawStructuresDelayed();
 
-    render::engine->sceneBuffer->blitTo(render::engine->sceneBufferFinal.get());
+    render::engine->copySceneToFinal();
   }
 }
 
 void renderSceneToScreen() {
+
+  // Show the current view in its region of the display
+  render::FrameBuffer& display = render::engine->getDisplayBuffer();
+  glm::vec4 region = view::getCurrentViewportRegion();
+  bool fullRegion = region == glm::vec4{0., 0., 1., 1.};
+  if (!fullRegion) {
+    int x0 = static_cast<int>(std::round(region.x * view::bufferWidth));
+    int y0 = static_cast<int>(std::round(region.y * view::bufferHeight));
+    int x1 = static_cast<int>(std::round((region.x + region.z) * view::bufferWidth));
+    int y1 = static_cast<int>(std::round((region.y + region.w) * view::bufferHeight));
+    display.setViewport(x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0));
+  }
+
   render::engine->bindDisplay();
   if (options::debugDrawPickBuffer) {
     // special debug draw
-    pick::evaluatePickQuery(-1, -1); // populate the buffer
-    render::engine->pickFramebuffer->blitTo(render::engine->displayBuffer.get());
+    pick::drawPickBufferDebug(&display);
   } else {
+    FrameStatsSection lightingSection("lighting transform");
     render::engine->applyLightingTransform(render::engine->sceneColorFinal);
   }
+
+  if (!fullRegion) {
+    render::engine->setScreenBufferViewports();
+    render::engine->bindDisplay();
+  }
+}
+
+// The extra viewports share the scene buffers with the main view, so each is rendered and shown in its region of the
+// display in turn, before the main view. The scene buffers then hold the main view as usual, for picking and the CPU
+// copy of the depth.
+void renderExtraViewports() {
+  for (size_t iV = 0; iV < view::getViewportCount(); iV++) {
+    FrameStatsSection viewportSection("viewport " + std::to_string(iV));
+    view::beginViewport(iV);
+    renderScene();
+    renderSceneToScreen();
+    view::endViewport();
+  }
 }
 
 void purgeWidgets() {
@@ -559,6 +924,17 @@ void userGuiEnd() {
 
 } // namespace
 
+namespace internal {
+void renderSceneToDisplay(float backgroundAlpha) {
+  render::engine->bindDisplay();
+  render::engine->setBackgroundColor({0., 0., 0.});
+  render::engine->setBackgroundAlpha(backgroundAlpha);
+  render::engine->clearDisplay();
+  renderScene();
+  renderSceneToScreen();
+}
+} // namespace internal
+
 void buildPolyscopeGui() {
 
   // Create window
@@ -588,6 +964,8 @@ void buildPolyscopeGui() {
     if (ImGui::BeginMenu("file format")) {
       if (ImGui::MenuItem(".png", NULL, options::screenshotExtension == ".png")) options::screenshotExtension = ".png";
       if (ImGui::MenuItem(".jpg", NULL, options::screenshotExtension == ".jpg")) options::screenshotExtension = ".jpg";
+      if (ImGui::MenuItem(".qoi", NULL, options::screenshotExtension == ".qoi")) options::screenshotExtension = ".qoi";
+      if (ImGui::MenuItem(".tga", NULL, options::screenshotExtension == ".tga")) options::screenshotExtension = ".tga";
       ImGui::EndMenu();
     }
 
@@ -649,6 +1027,95 @@ void buildPolyscopeGui() {
     ImGui::PopItemWidth();
     ImGui::SameLine();
     ImGui::Checkbox("vsync", &options::enableVSync);
+    ImGui::SameLine();
+    ImGui::Checkbox("late input poll", &options::latePollEvents);
+    ImGui::Checkbox("idle when unchanged", &options::idleWhenUnchanged);
+    if (ImGui::Checkbox("depth prepass", &options::depthPrepass)) {
+      requestRedraw();
+    }
+
+    if (ImGui::Checkbox("frustum culling", &options::frustumCulling)) {
+      requestRedraw();
+    }
+    ImGui::SameLine();
+    if (ImGui::Checkbox("occlusion culling", &options::occlusionCulling)) {
+      requestRedraw();
+    }
+    ImGui::Text("Structures drawn: %zu  culled: %zu (occluded: %zu)", render::engine->stats.structuresDrawn,
+                render::engine->stats.structuresCulled, render::engine->stats.structuresOccluded);
+
+    ImGui::TreePop();
+  }
+
+  ImGui::SetNextItemOpen(false, ImGuiCond_FirstUseEver);
+  if (ImGui::TreeNode("Frame Stats")) {
+    ImGui::Checkbox("collect", &options::collectFrameStats);
+    const render::RenderStats& engineStats = render::engine->stats;
+    ImGui::Text("Scene rendered in %zu of %zu frames", engineStats.sceneRenders,
+                engineStats.sceneRenders + engineStats.sceneReuses);
+
+    FrameStats stats = getFrameStats();
+    const FrameTimeDistribution& frameTimes = stats.frameTimes;
+    if (frameTimes.nFrames > 0) {
+      ImGui::Text("Frame ms over %zu frames: mean %.2f  std dev %.2f", frameTimes.nFrames, frameTimes.meanMs,
+                  frameTimes.stdDevMs);
+      ImGui::Text("  min %.2f  median %.2f  p95 %.2f  p99 %.2f  max %.2f", frameTimes.minMs, frameTimes.medianMs,
+                  frameTimes.p95Ms, frameTimes.p99Ms, frameTimes.maxMs);
+      ImGui::Text("  predicted frame work %.2f ms", getPredictedFrameWorkMs());
+    }
+    if (options::collectFrameStats && stats.frameIndex > 0) {
+      auto gpuText = [](double ms) -> std::string {
+        if (ms < 0.) return "    -";
+        char buff[32];
+        snprintf(buff, sizeof(buff), "%6.2f", ms);
+        return buff;
+      };
+
+      ImGui::Text("Draw calls: %zu  triangles: %zu", stats.drawCalls, stats.trianglesSubmitted);
+      ImGui::Text("State changes: %zu  skipped: %zu", stats.stateChanges, stats.stateChangesSkipped);
+      ImGui::TextUnformatted("   cpu ms    gpu ms");
+      ImGui::Text("  %6.2f    %s  frame", stats.cpuMs, gpuText(stats.gpuMs).c_str());
+      for (const FrameSectionStats& section : stats.sections) {
+        ImGui::Text("  %6.2f    %s  %s", section.cpuMs, gpuText(section.gpuMs).c_str(), section.name.c_str());
+      }
+    }
+
+    ImGui::TreePop();
+  }
+
+  ImGui::SetNextItemOpen(false, ImGuiCond_FirstUseEver);
+  if (ImGui::TreeNode("Memory")) {
+    const double MB = 1024. * 1024.;
+    const render::DeviceMemoryUsage& device = render::getDeviceMemoryUsage();
+    ImGui::Text("Device total: %.1f MB", device.totalBytes() / MB);
+    ImGui::Text("  attributes %.1f  textures %.1f  render buffers %.1f", device.attributeBytes / MB,
+                device.textureBytes / MB, device.renderBufferBytes / MB);
+
+    // structures holding the most device memory first
+    std::vector<std::pair<render::MemoryUsage, Structure*>> structureUsage;
+    for (auto& catMap : state::structures) {
+      for (auto& s : catMap.second) {
+        structureUsage.emplace_back(s.second->getMemoryUsage(), s.second.get());
+      }
+    }
+    std::sort(structureUsage.begin(), structureUsage.end(),
+              [](const std::pair<render::MemoryUsage, Structure*>& a,
+                 const std::pair<render::MemoryUsage, Structure*>& b) {
+                return a.first.deviceBytes > b.first.deviceBytes;
+              });
+    if (!structureUsage.empty()) {
+      size_t totalOverhead = 0;
+      for (const std::pair<render::MemoryUsage, Structure*>& entry : structureUsage) {
+        totalOverhead += entry.first.overheadBytes;
+      }
+      ImGui::Text("Structure overhead: %.1f MB, %.1f KB per structure", totalOverhead / MB,
+                  totalOverhead / 1024. / structureUsage.size());
+      ImGui::TextUnformatted("  device MB    host MB  overhead KB");
+    }
+    for (const std::pair<render::MemoryUsage, Structure*>& entry : structureUsage) {
+      ImGui::Text("  %9.1f  %9.1f  %11.1f  %s: %s", entry.first.deviceBytes / MB, entry.first.hostBytes / MB,
+                  entry.first.overheadBytes / 1024., entry.second->typeName().c_str(), entry.second->name.c_str());
+    }
 
     ImGui::TreePop();
   }
@@ -661,6 +1128,7 @@ void buildPolyscopeGui() {
     }
     ImGui::Checkbox("Show pick buffer", &options::debugDrawPickBuffer);
     ImGui::Checkbox("Always redraw", &options::alwaysRedraw);
+    ImGui::Checkbox("Adaptive quality", &options::adaptiveQuality);
 
     static bool showDebugTextures = false;
     ImGui::Checkbox("Show debug textures", &showDebugTextures);
@@ -681,11 +1149,16 @@ void buildPolyscopeGui() {
 void buildStructureGui() {
   // Create window
   static bool showStructureWindow = true;
+  static ImGuiTextFilter structureFilter;
 
   ImGui::SetNextWindowPos(ImVec2(imguiStackMargin, lastWindowHeightPolyscope + 2 * imguiStackMargin));
   ImGui::SetNextWindowSize(
       ImVec2(leftWindowsWidth, view::windowHeight - lastWindowHeightPolyscope - 3 * imguiStackMargin));
-  ImGui::Begin("Structures", &showStructureWindow);
+  if (!ImGui::Begin("Structures", &showStructureWindow)) {
+    // collapsed, nothing in it is visible
+    ImGui::End();
+    return;
+  }
 
   // only show groups if there are any
   if (state::groups.size() > 0) {
@@ -704,6 +1177,16 @@ void buildStructureGui() {
     x.second->appendStructuresToSkip(structuresToSkip);
   }
 
+  // only show the name filter when some list is long enough to need it
+  bool anyLongList = false;
+  for (auto& catMapEntry : state::structures) {
+    if (catMapEntry.second.size() > 8) anyLongList = true;
+  }
+  if (anyLongList) {
+    structureFilter.Draw("filter names");
+  } else {
+    structureFilter.Clear();
+  }
 
   for (auto& catMapEntry : state::structures) {
     std::string catName = catMapEntry.first;
@@ -713,30 +1196,66 @@ void buildStructureGui() {
     ImGui::PushID(catName.c_str()); // ensure there are no conflicts with
                                     // identically-named labels
 
+    // Long lists get a summary in the header. The "###" keeps the header's open state when the summary changes.
+    std::string headerLabel = catName + " (" + std::to_string(structureMap.size());
+    if (structureMap.size() > 8) {
+      size_t nEnabled = 0;
+      for (auto& x : structureMap) {
+        if (x.second->isEnabled()) nEnabled++;
+      }
+      headerLabel += ", " + std::to_string(nEnabled) + " enabled";
+    }
+    headerLabel += ")###header";
+
     // Build the structure's UI
-    ImGui::SetNextItemOpen(structureMap.size() > 0, ImGuiCond_FirstUseEver);
-    if (ImGui::CollapsingHeader((catName + " (" + std::to_string(structureMap.size()) + ")").c_str())) {
+    ImGui::SetNextItemOpen(structureMap.size() > 0 && structureMap.size() <= 1000, ImGuiCond_FirstUseEver);
+    if (ImGui::CollapsingHeader(headerLabel.c_str())) {
       // Draw shared GUI elements for all instances of the structure
       if (structureMap.size() > 0) {
         structureMap.begin()->second->buildSharedStructureUI();
       }
 
       int32_t skipCount = 0;
+      int32_t filterCount = 0;
+      std::vector<Structure*> rows;
+      rows.reserve(structureMap.size());
       for (auto& x : structureMap) {
-        ImGui::SetNextItemOpen(structureMap.size() <= 8,
-                               ImGuiCond_FirstUseEver); // closed by default if more than 8
-
         if (structuresToSkip.find(x.second.get()) != structuresToSkip.end()) {
           skipCount++;
           continue;
         }
+        if (!structureFilter.PassFilter(x.first.c_str())) {
+          filterCount++;
+          continue;
+        }
+        rows.push_back(x.second.get());
+      }
 
-        x.second->buildUI();
+      auto buildRow = [&](size_t i) {
+        ImGui::SetNextItemOpen(structureMap.size() <= 8,
+                               ImGuiCond_FirstUseEver); // closed by default if more than 8
+        rows[i]->buildUI();
+      };
+
+      if (structureMap.size() <= 8) {
+        for (size_t i = 0; i < rows.size(); i++) buildRow(i);
+      } else {
+        // long lists only build the rows in view; Structure::buildUI() pushes the name as an ID before its tree node
+        auto rowIsOpen = [&](size_t i) {
+          ImGui::PushID(rows[i]->name.c_str());
+          bool open = ImGuiTreeNodeIsOpen(rows[i]->name.c_str());
+          ImGui::PopID();
+          return open;
+        };
+        ImGuiClippedTreeList(rows.size(), rowIsOpen, buildRow);
       }
 
       if (skipCount > 0) {
         ImGui::Text("  (skipped %d hidden structures)", skipCount);
       }
+      if (filterCount > 0) {
+        ImGui::Text("  (%d structures do not match the filter)", filterCount);
+      }
     }
 
     ImGui::PopID();
@@ -795,6 +1314,8 @@ void buildUserGuiAndInvokeCallback() {
 
 void draw(bool withUI, bool withContextCallback) {
   processLazyProperties();
+  render::engine->stats.resetDrawCounts();
+  beginFrameStats();
 
   // Update buffer and context
   render::engine->makeContextCurrent();
@@ -804,6 +1325,7 @@ void draw(bool withUI, bool withContextCallback) {
   render::engine->clearDisplay();
 
   if (withUI) {
+    render::engine->ensureImGuiFontsPrepared();
     render::engine->ImGuiNewFrame();
 
     processInputEvents();
@@ -844,15 +1366,62 @@ void draw(bool withUI, bool withContextCallback) {
     (contextStack.back().callback)();
   }
 
+  // An item edited in the GUI this frame may have changed the scene, not every option requests a redraw itself
+  if (withUI && ImGui::GetCurrentContext()->ActiveIdHasBeenEditedThisFrame) {
+    requestRedraw();
+  }
+
+  // Draw any histograms which changed in to their atlas slots, before ImGui draws them
+  renderPendingHistograms();
+
   processLazyProperties();
 
+  // Advance any asynchronous pick queries
+  pick::processAsyncPickRequests();
+  view::processSceneDepthDownload();
+
+  // Refine any progressive implicit surface renders
+  processProgressiveImplicitRenders();
+
+  // Advance any structures playing back keyframes
+  for (Structure* s : state::globalContext.structureSlots) {
+    if (s) s->updateKeyframePlayback();
+  }
+
+  // Hand finished screenshot readbacks over to the writer threads
+  processAsyncScreenshots();
+
+  // Free host copies of buffers which only need to live on the device from here on
+  render::processHostBufferDrops();
+
+  // Pick the scene quality for this frame, possibly reduced while the camera moves
+  updateAdaptiveQuality();
+
   // Draw structures in the scene
-  if (redrawNextFrame || options::alwaysRedraw) {
+  // Otherwise the scene from the last frame is reused, only the lighting transform and the GUI are drawn over it
+  // With TAA, a still scene keeps being drawn until the jittered renders have converged
+  // Extra viewports overwrite the scene buffers, so with any of them the main view is always drawn again too
+  renderExtraViewports();
+  bool sceneChanged = redrawNextFrame || options::alwaysRedraw || view::getViewportCount() > 0;
+  if (sceneChanged || render::engine->temporalAntiAliasingPending()) {
+    render::engine->beginTemporalAntiAliasingFrame(sceneChanged);
+    lastFrameDrewScene = true;
     renderScene();
+    render::engine->resolveTemporalAntiAliasing();
+    view::requestSceneDepthDownload();
     redrawNextFrame = false;
+    render::engine->stats.sceneRenders++;
+  } else {
+    lastFrameDrewScene = false;
+    render::engine->stats.sceneReuses++;
   }
   renderSceneToScreen();
 
+  // Grab the frame for any recording in progress, before the GUI is drawn over it
+  if (withUI) {
+    processRecording();
+  }
+
   // Draw the GUI
   if (withUI) {
     // render widgets
@@ -865,12 +1434,21 @@ void draw(bool withUI, bool withContextCallback) {
     }
 
     render::engine->bindDisplay();
+    FrameStatsSection imguiSection("ImGui");
     render::engine->ImGuiRender();
   }
+
+  // Stream the frame to any remote viewer, GUI included
+  if (withUI) {
+    processRemoteFrame();
+  }
+
+  endFrameStats();
 }
 
 
 void mainLoopIteration() {
+  POLYSCOPE_TRACE_SPAN("mainLoopIteration");
 
   processLazyProperties();
 
@@ -879,13 +1457,23 @@ void mainLoopIteration() {
 
   // Process UI events
   render::engine->pollEvents();
+  if (ImGui::GetCurrentContext()->InputEventsQueue.Size > 0) {
+    nQuietFrames = 0;
+  }
+  processRemoteInput();
 
   // Housekeeping
   purgeWidgets();
 
+  // Sync point for changes handed over by other threads
+  processQueuedUpdates();
+
   // Rendering
   draw();
+  markFrameWorkEnd();
   render::engine->swapDisplayBuffers();
+  markFramePresented();
+  trimScratchBuffers();
 }
 
 void show(size_t forFrames) {
@@ -941,6 +1529,14 @@ void shutdown() {
     writePrefsFile();
   }
 
+  stopBackgroundCallback();
+  releaseStagingPools();
+  flushScreenshots();
+  if (isRecording()) {
+    stopRecording();
+  }
+  stopRemoteSession();
+  tasks::stopWorkers();
   render::engine->shutdownImGui();
 }
 
@@ -950,10 +1546,10 @@ bool registerStructure(Structure* s, bool replaceIfPresent) {
   std::map<std::string, std::unique_ptr<Structure>>& sMap = getStructureMapCreateIfNeeded(typeName);
 
   // Check if the structure name is in use
-  bool inUse = sMap.find(s->name) != sMap.end();
+  bool inUse = findStructure(typeName, s->name) != nullptr;
   if (inUse) {
     if (replaceIfPresent) {
-      removeStructure(s->name);
+      removeStructure(typeName, s->name);
     } else {
       exception("Attempted to register structure with name " + s->name +
                 ", but a structure with that name already exists");
@@ -971,6 +1567,7 @@ bool registerStructure(Structure* s, bool replaceIfPresent) {
 
   // Add the new structure
   sMap[s->name] = std::unique_ptr<Structure>(s); // take ownership with a unique pointer
+  s->handle = addToStructureRegistry(s);
   updateStructureExtents();
   requestRedraw();
 
@@ -999,11 +1596,19 @@ Structure* getStructure(std::string type, std::string name) {
   }
 
   // General case
-  if (sMap.find(name) == sMap.end()) {
+  Structure* s = findStructure(type, name);
+  if (s == nullptr) {
     exception("No structure of type " + type + " with name " + name + " registered");
-    return nullptr;
   }
-  return sMap[name].get();
+  return s;
+}
+
+Structure* getStructure(StructureHandle handle) {
+  const Context& ctx = state::globalContext;
+  uint32_t slot = static_cast<uint32_t>(handle & 0xFFFFFFFF);
+  uint32_t generation = static_cast<uint32_t>(handle >> 32);
+  if (slot >= ctx.structureSlots.size() || ctx.structureSlotGenerations[slot] != generation) return nullptr;
+  return ctx.structureSlots[slot];
 }
 
 bool hasStructure(std::string type, std::string name) {
@@ -1021,7 +1626,7 @@ bool hasStructure(std::string type, std::string name) {
     }
     return true;
   }
-  return sMap.find(name) != sMap.end();
+  return findStructure(type, name) != nullptr;
 }
 
 
@@ -1037,7 +1642,8 @@ void removeStructure(std::string type, std::string name, bool errorIfAbsent) {
   std::map<std::string, std::unique_ptr<Structure>>& sMap = state::structures[type];
 
   // Check if structure exists
-  if (sMap.find(name) == sMap.end()) {
+  Structure* s = findStructure(type, name);
+  if (s == nullptr) {
     if (errorIfAbsent) {
       exception("No structure of type " + type + " and name " + name + " registered");
     }
@@ -1045,7 +1651,6 @@ void removeStructure(std::string type, std::string name, bool errorIfAbsent) {
   }
 
   // Structure exists, remove it
-  Structure* s = sMap[name].get();
   if (static_cast<void*>(s) == static_cast<void*>(internal::globalFloatingQuantityStructure)) {
     internal::globalFloatingQuantityStructure = nullptr;
   }
@@ -1054,7 +1659,14 @@ void removeStructure(std::string type, std::string name, bool errorIfAbsent) {
     g.second->removeChildStructure(*s);
   }
   pick::resetSelectionIfStructure(s);
+  pick::releasePickBufferRange(s);
+  std::string settingsPrefix = s->uniquePrefix();
+  removeFromStructureRegistry(s);
   sMap.erase(s->name);
+  if (!options::rememberRemovedStructureSettings) {
+    // after the erase, such that the structure's persistent values have released their slots
+    detail::clearPersistentCaches(settingsPrefix);
+  }
   updateStructureExtents();
   return;
 }
@@ -1067,21 +1679,15 @@ void removeStructure(std::string name, bool errorIfAbsent) {
 
   // Check if we can find exactly one structure matching the name
   Structure* targetStruct = nullptr;
-  for (auto& typeMap : state::structures) {
-    for (auto& entry : typeMap.second) {
-
-      // Found a matching structure
-      if (entry.first == name) {
-        if (targetStruct == nullptr) {
-          targetStruct = entry.second.get();
-        } else {
-          exception(
-              "Cannot use automatic structure remove with empty name unless there is exactly one structure of that "
-              "type registered. Found two structures of different types with that name: " +
-              targetStruct->typeName() + " and " + typeMap.first + ".");
-          return;
-        }
-      }
+  auto range = state::globalContext.structuresByName.equal_range(name);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (targetStruct == nullptr) {
+      targetStruct = it->second;
+    } else {
+      exception("Cannot use automatic structure remove with empty name unless there is exactly one structure of that "
+                "type registered. Found two structures of different types with that name: " +
+                targetStruct->typeName() + " and " + it->second->typeName() + ".");
+      return;
     }
   }
 
@@ -1098,23 +1704,42 @@ void removeStructure(std::string name, bool errorIfAbsent) {
 }
 
 void removeAllStructures() {
+  Context& ctx = state::globalContext;
+
+  // Everything goes at once, so rather than removing the structures one at a time (see removeStructure()), reset all of
+  // the bookkeeping which refers to them in one go. Groups only hold weak handles to structures, which expire as the
+  // structures are destroyed.
+  std::unordered_set<std::string> settingsPrefixes;
+  if (!options::rememberRemovedStructureSettings) {
+    for (auto& typeMap : state::structures) {
+      for (auto& entry : typeMap.second) {
+        settingsPrefixes.insert(entry.second->uniquePrefix());
+      }
+    }
+  }
 
-  for (auto& typeMap : state::structures) {
+  pick::resetSelection();
+  pick::releaseAllPickBufferRanges();
+  internal::globalFloatingQuantityStructure = nullptr;
 
-    // dodge iterator invalidation
-    std::vector<std::string> names;
-    for (auto& entry : typeMap.second) {
-      names.push_back(entry.first);
-    }
+  for (uint32_t slot = 0; slot < ctx.structureSlots.size(); slot++) {
+    if (ctx.structureSlots[slot] == nullptr) continue;
+    ctx.structureSlots[slot] = nullptr;
+    ctx.structureSlotGenerations[slot]++; // old handles to this slot are now stale
+    ctx.freeStructureSlots.push_back(slot);
+  }
+  ctx.structuresByName.clear();
+  internal::invalidateStructureDrawList();
 
-    // remove all
-    for (std::string name : names) {
-      removeStructure(typeMap.first, name);
-    }
+  for (auto& typeMap : state::structures) {
+    typeMap.second.clear();
   }
 
+  // after the structures are destroyed, such that their persistent values have released their slots
+  detail::clearPersistentCaches(settingsPrefixes);
+
+  updateStructureExtents();
   requestRedraw();
-  pick::resetSelection();
 }
 
 
@@ -1178,13 +1803,30 @@ void refresh() {
   requestRedraw();
 }
 
+void refreshShaderPrograms() {
+  render::engine->groundPlane.prepare();
+
+  for (auto& cat : state::structures) {
+    for (auto& x : cat.second) {
+      x.second->refreshShaderPrograms();
+    }
+  }
+
+  requestRedraw();
+}
+
 // Cached versions of lazy properties used for updates
 namespace lazy {
 TransparencyMode transparencyMode = TransparencyMode::None;
 int transparencyRenderPasses = 8;
+bool depthPrepass = false;
 int ssaaFactor = 1;
+bool temporalAntiAliasing = false;
+bool fxaa = false;
+bool renderTargetBudget = false;
 bool groundPlaneEnabled = true;
 GroundPlaneMode groundPlaneMode = GroundPlaneMode::TileReflection;
+GroundReflectionMode groundReflectionMode = GroundReflectionMode::Mirror;
 ScaledValue<float> groundPlaneHeightFactor = 0;
 int shadowBlurIters = 2;
 float shadowDarkness = .4;
@@ -1208,6 +1850,12 @@ void processLazyProperties() {
     render::engine->setTransparencyMode(options::transparencyMode);
   }
 
+  // depth prepass
+  if (lazy::depthPrepass != options::depthPrepass) {
+    lazy::depthPrepass = options::depthPrepass;
+    render::engine->setDepthPrepass(options::depthPrepass);
+  }
+
   // transparency render passes
   if (lazy::transparencyRenderPasses != options::transparencyRenderPasses) {
     lazy::transparencyRenderPasses = options::transparencyRenderPasses;
@@ -1220,14 +1868,34 @@ void processLazyProperties() {
     render::engine->setSSAAFactor(options::ssaaFactor);
   }
 
+  // taa
+  if (lazy::temporalAntiAliasing != options::temporalAntiAliasing) {
+    lazy::temporalAntiAliasing = options::temporalAntiAliasing;
+    render::engine->setTemporalAntiAliasing(options::temporalAntiAliasing);
+  }
+
+  // fxaa
+  if (lazy::fxaa != options::fxaa) {
+    lazy::fxaa = options::fxaa;
+    render::engine->setFXAA(options::fxaa);
+  }
+
+  // render target budget
+  if (lazy::renderTargetBudget != options::renderTargetBudget) {
+    lazy::renderTargetBudget = options::renderTargetBudget;
+    render::engine->setRenderTargetBudget(options::renderTargetBudget);
+  }
+
   // ground plane
-  if (lazy::groundPlaneEnabled != options::groundPlaneEnabled || lazy::groundPlaneMode != options::groundPlaneMode) {
+  if (lazy::groundPlaneEnabled != options::groundPlaneEnabled || lazy::groundPlaneMode != options::groundPlaneMode ||
+      lazy::groundReflectionMode != options::groundReflectionMode) {
     lazy::groundPlaneEnabled = options::groundPlaneEnabled;
     if (!options::groundPlaneEnabled) {
       // if the (depecated) groundPlaneEnabled = false, set mode to None, so we only have one variable to check
       options::groundPlaneMode = GroundPlaneMode::None;
     }
     lazy::groundPlaneMode = options::groundPlaneMode;
+    lazy::groundReflectionMode = options::groundReflectionMode;
     render::engine->groundPlane.prepare();
     requestRedraw();
   }
@@ -1252,6 +1920,11 @@ void updateStructureExtents() {
     return;
   }
 
+  if (state::globalContext.structureBatchDepth > 0) {
+    state::globalContext.structureExtentsStale = true;
+    return;
+  }
+
   // Note: the cost multiple calls to this function scales only with the number of structures, not the size of the data
   // in those structures, because structures internally cache the extents of their data.
 
@@ -1299,6 +1972,21 @@ void updateStructureExtents() {
   requestRedraw();
 }
 
+void beginStructureBatch() { state::globalContext.structureBatchDepth++; }
+
+void endStructureBatch() {
+  Context& ctx = state::globalContext;
+  if (ctx.structureBatchDepth == 0) {
+    exception("endStructureBatch() called without a matching beginStructureBatch()");
+    return;
+  }
+  ctx.structureBatchDepth--;
+  if (ctx.structureBatchDepth == 0 && ctx.structureExtentsStale) {
+    ctx.structureExtentsStale = false;
+    updateStructureExtents();
+  }
+}
+
 namespace state {
 glm::vec3 center() { return 0.5f * (std::get<0>(state::boundingBox) + std::get<1>(state::boundingBox)); }
 } // namespace state
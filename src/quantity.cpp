@@ -33,8 +33,12 @@ bool Quantity::isEnabled() { return enabled.get(); }
 
 void Quantity::refresh() { requestRedraw(); }
 
+void Quantity::refreshShaderPrograms() { refresh(); }
+
 std::string Quantity::niceName() { return name; }
 
 std::string Quantity::uniquePrefix() { return parent.uniquePrefix() + name + "#"; }
 
+bool Quantity::drawsWithinStructureBounds() { return true; }
+
 } // namespace polyscope
@@ -0,0 +1,285 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/recorder.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace polyscope {
+
+namespace {
+
+// Frames are read back asynchronously, a few reads in flight hide the transfer latency. Converted frames wait for the
+// writer thread in a bounded queue, capture blocks when it is full rather than piling up memory.
+const size_t maxRecordingReadsInFlight = 3;
+const size_t maxQueuedRecordingFrames = 8;
+
+struct RecordingState {
+  bool active = false;
+  std::string path;
+  float fps;
+  RecordingFormat format;
+  int width, height;
+  size_t nFrames = 0;
+  bool warnedSizeChange = false;
+
+  // output, written only by the writer thread while recording
+  FILE* out = nullptr;
+  bool outIsPipe = false;
+
+  // reads of the display buffer which have not completed, main thread only
+  std::deque<uint64_t> pendingReads;
+
+  // handoff to the writer thread, guarded by the mutex
+  std::thread writer;
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::deque<std::vector<unsigned char>> queuedFrames;
+  std::vector<std::vector<unsigned char>> freeFrames; // pooled pixel buffers, to avoid an allocation per frame
+  bool finishing = false;
+  bool writeFailed = false;
+};
+
+RecordingState rec;
+
+FILE* openPipe(const std::string& command) {
+#ifdef _WIN32
+  return _popen(command.c_str(), "wb");
+#else
+  return popen(command.c_str(), "w");
+#endif
+}
+
+int closePipe(FILE* f) {
+#ifdef _WIN32
+  return _pclose(f);
+#else
+  return pclose(f);
+#endif
+}
+
+// Write one RGBA frame, as read from the GPU (bottom row first)
+bool writeRecordedFrame(const std::vector<unsigned char>& frame, std::vector<unsigned char>& scratch) {
+  size_t w = rec.width;
+  size_t h = rec.height;
+  if (frame.size() != w * h * 4) return true; // a read failed, skip the frame
+
+  switch (rec.format) {
+  case RecordingFormat::Raw:
+  case RecordingFormat::FFmpeg: {
+    // top row first
+    for (size_t j = 0; j < h; j++) {
+      const unsigned char* row = &frame[(h - 1 - j) * w * 4];
+      if (std::fwrite(row, 1, w * 4, rec.out) != w * 4) return false;
+    }
+    return true;
+  }
+  case RecordingFormat::Y4M: {
+    // Planar YCbCr 4:4:4, BT.601 limited range, top row first
+    scratch.resize(3 * w * h);
+    unsigned char* yPlane = &scratch[0];
+    unsigned char* uPlane = &scratch[w * h];
+    unsigned char* vPlane = &scratch[2 * w * h];
+    for (size_t j = 0; j < h; j++) {
+      const unsigned char* row = &frame[(h - 1 - j) * w * 4];
+      for (size_t i = 0; i < w; i++) {
+        int r = row[4 * i + 0];
+        int g = row[4 * i + 1];
+        int b = row[4 * i + 2];
+        size_t ind = j * w + i;
+        yPlane[ind] = static_cast<unsigned char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        uPlane[ind] = static_cast<unsigned char>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        vPlane[ind] = static_cast<unsigned char>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+      }
+    }
+    if (std::fputs("FRAME\n", rec.out) < 0) return false;
+    return std::fwrite(scratch.data(), 1, scratch.size(), rec.out) == scratch.size();
+  }
+  }
+  return false;
+}
+
+void recordingWriterLoop() {
+  std::vector<unsigned char> scratch;
+  while (true) {
+    std::vector<unsigned char> frame;
+    {
+      std::unique_lock<std::mutex> lock(rec.mutex);
+      rec.cond.wait(lock, [] { return !rec.queuedFrames.empty() || rec.finishing; });
+      if (rec.queuedFrames.empty()) return; // finishing, and everything has been written
+      frame = std::move(rec.queuedFrames.front());
+      rec.queuedFrames.pop_front();
+    }
+    rec.cond.notify_all(); // there is room in the queue now
+
+    bool success = writeRecordedFrame(frame, scratch);
+
+    std::lock_guard<std::mutex> lock(rec.mutex);
+    rec.freeFrames.push_back(std::move(frame));
+    if (!success) rec.writeFailed = true;
+  }
+}
+
+// Hand the oldest completed read to the writer thread. Returns false if it has not completed and wait is false.
+bool finishOldestRecordingRead(bool wait) {
+  if (rec.pendingReads.empty()) return false;
+
+  std::vector<unsigned char> frame;
+  {
+    std::lock_guard<std::mutex> lock(rec.mutex);
+    if (!rec.freeFrames.empty()) {
+      frame = std::move(rec.freeFrames.back());
+      rec.freeFrames.pop_back();
+    }
+  }
+
+  if (!render::engine->displayBuffer->pollReadBuffer(rec.pendingReads.front(), frame, wait)) {
+    if (!wait) {
+      std::lock_guard<std::mutex> lock(rec.mutex);
+      rec.freeFrames.push_back(std::move(frame));
+      return false;
+    }
+    frame.clear(); // the read failed, the writer skips it
+  }
+  rec.pendingReads.pop_front();
+
+  std::unique_lock<std::mutex> lock(rec.mutex);
+  rec.cond.wait(lock, [] { return rec.queuedFrames.size() < maxQueuedRecordingFrames; });
+  rec.queuedFrames.push_back(std::move(frame));
+  lock.unlock();
+  rec.cond.notify_all();
+  return true;
+}
+
+} // namespace
+
+void startRecording(std::string path, float fps, RecordingFormat format) {
+  if (rec.active) {
+    warning("startRecording() called while already recording to " + rec.path + ", stopping that recording");
+    stopRecording();
+  }
+  if (!(fps > 0.f)) {
+    exception("startRecording() fps must be positive");
+  }
+
+  rec.path = path;
+  rec.fps = fps;
+  rec.format = format;
+  rec.width = view::bufferWidth;
+  rec.height = view::bufferHeight;
+  rec.nFrames = 0;
+  rec.warnedSizeChange = false;
+  rec.finishing = false;
+  rec.writeFailed = false;
+
+  // Open the output
+  std::string sizeStr = std::to_string(rec.width) + "x" + std::to_string(rec.height);
+  switch (format) {
+  case RecordingFormat::Y4M:
+  case RecordingFormat::Raw:
+    rec.out = std::fopen(path.c_str(), "wb");
+    rec.outIsPipe = false;
+    break;
+  case RecordingFormat::FFmpeg: {
+    // yuv420p (for player compatibility) needs even dimensions, pad by a pixel if needed
+    std::string command = "ffmpeg -y -loglevel error -f rawvideo -pix_fmt rgba -s " + sizeStr + " -r " +
+                          std::to_string(fps) + " -i - -vf \"pad=ceil(iw/2)*2:ceil(ih/2)*2\" -pix_fmt yuv420p \"" +
+                          path + "\"";
+    rec.out = openPipe(command);
+    rec.outIsPipe = true;
+    break;
+  }
+  }
+  if (rec.out == nullptr) {
+    exception("startRecording() could not open output " + path);
+  }
+
+  if (format == RecordingFormat::Y4M) {
+    // frame rate as a rational, exact for integer and common NTSC rates
+    long fpsNum = std::lround(fps * 1001.);
+    std::string header = "YUV4MPEG2 W" + std::to_string(rec.width) + " H" + std::to_string(rec.height) + " F" +
+                         std::to_string(fpsNum) + ":1001 Ip A1:1 C444\n";
+    std::fputs(header.c_str(), rec.out);
+  }
+
+  rec.writer = std::thread(recordingWriterLoop);
+  rec.active = true;
+
+  // Advance animations by exactly one video frame per drawn frame
+  render::engine->fixedFrameDeltaTime = 1.f / fps;
+  requestRedraw();
+}
+
+void stopRecording() {
+  if (!rec.active) return;
+
+  while (!rec.pendingReads.empty()) {
+    finishOldestRecordingRead(true);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(rec.mutex);
+    rec.finishing = true;
+  }
+  rec.cond.notify_all();
+  rec.writer.join();
+
+  int closeStatus = rec.outIsPipe ? closePipe(rec.out) : std::fclose(rec.out);
+  rec.out = nullptr;
+  rec.active = false;
+  rec.queuedFrames.clear();
+  rec.freeFrames.clear();
+  render::engine->fixedFrameDeltaTime = 0.f;
+
+  if (rec.writeFailed || closeStatus != 0) {
+    warning("recording to " + rec.path + " may be incomplete, writing the output failed");
+  } else if (options::verbosity > 0) {
+    info("recorded " + std::to_string(rec.nFrames) + " frames to " + rec.path);
+  }
+}
+
+bool isRecording() { return rec.active; }
+
+void processRecording() {
+  if (!rec.active) return;
+
+  bool writeFailed;
+  {
+    std::lock_guard<std::mutex> lock(rec.mutex);
+    writeFailed = rec.writeFailed;
+  }
+  if (writeFailed) {
+    stopRecording();
+    return;
+  }
+
+  // The output has a fixed size
+  if (static_cast<int>(view::bufferWidth) != rec.width || static_cast<int>(view::bufferHeight) != rec.height) {
+    if (!rec.warnedSizeChange) {
+      warning("window size changed while recording, frames are skipped until it is restored");
+      rec.warnedSizeChange = true;
+    }
+    return;
+  }
+
+  while (finishOldestRecordingRead(false)) {
+  }
+  if (rec.pendingReads.size() >= maxRecordingReadsInFlight) {
+    finishOldestRecordingRead(true);
+  }
+  rec.pendingReads.push_back(render::engine->displayBuffer->requestReadBuffer());
+  rec.nFrames++;
+
+  requestRedraw(); // every frame is a video frame
+}
+
+} // namespace polyscope
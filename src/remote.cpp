@@ -0,0 +1,582 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/remote.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/parallel.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+
+#include "imgui.h"
+#include "stb_image_write.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace polyscope {
+
+namespace {
+
+typedef std::chrono::steady_clock RemoteClock;
+
+// Unacknowledged frames older than this are taken to be lost, e.g. when the viewer reconnects
+const double remoteAckTimeoutMs = 2000.;
+
+// How often the stream quality may change, and the latency band (relative to the target) within which it does not
+const double remoteAdaptIntervalMs = 250.;
+const double remoteLatencyHigh = 1.25;
+const double remoteLatencyLow = 0.6;
+const float remoteResolutionStep = 0.75f;
+
+struct RemoteCapturedFrame {
+  uint32_t frameId;
+  int width, height;
+  int windowWidth, windowHeight;
+  std::vector<unsigned char> pixels; // RGBA, bottom row first, empty if the read failed
+};
+
+struct RemotePendingRead {
+  uint64_t ticket;
+  uint32_t frameId;
+  int width, height;
+  int windowWidth, windowHeight;
+};
+
+// The previous frame as encoded, which the next one is compared to
+struct RemoteEncoderState {
+  int width = 0, height = 0;
+  std::vector<unsigned char> image; // RGB, bottom row first
+  std::vector<unsigned char> prevImage;
+};
+
+struct RemoteState {
+  bool active = false;
+  RemoteSessionSettings settings;
+  std::function<void(const std::vector<unsigned char>&)> send;
+
+  // main thread only
+  uint32_t nextFrameId = 1;
+  std::deque<RemotePendingRead> pendingReads;
+
+  // shared with the encoder thread and the transport, guarded by the mutex
+  std::thread encoder;
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::deque<RemoteCapturedFrame> queuedFrames;
+  std::vector<std::vector<unsigned char>> freeBuffers; // pooled pixel buffers, to avoid an allocation per frame
+  std::map<uint32_t, RemoteClock::time_point> unackedFrames; // captured, by the time of capture
+  std::deque<RemoteInputEvent> inputEvents;
+  bool finishing = false;
+  bool keyframeRequested = true;
+  bool sendFailed = false;
+  std::string sendError;
+  RemoteClock::time_point lastAdapt;
+  RemoteSessionStats stats;
+};
+
+RemoteState remote;
+
+double toMs(RemoteClock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); }
+
+void putU16(std::vector<unsigned char>& out, uint32_t val) {
+  out.push_back(static_cast<unsigned char>(val & 0xFF));
+  out.push_back(static_cast<unsigned char>((val >> 8) & 0xFF));
+}
+
+void putU32(std::vector<unsigned char>& out, uint32_t val) {
+  putU16(out, val & 0xFFFF);
+  putU16(out, val >> 16);
+}
+
+uint32_t getU16(const unsigned char* data) { return data[0] | (static_cast<uint32_t>(data[1]) << 8); }
+uint32_t getU32(const unsigned char* data) { return getU16(data) | (getU16(data + 2) << 16); }
+float getF32(const unsigned char* data) {
+  uint32_t bits = getU32(data);
+  float val;
+  std::memcpy(&val, &bits, sizeof(val));
+  return val;
+}
+
+void appendBytes(void* context, void* data, int size) {
+  std::vector<unsigned char>* out = static_cast<std::vector<unsigned char>*>(context);
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  out->insert(out->end(), bytes, bytes + size);
+}
+
+// Box filter RGBA pixels down to RGB at the encoded size, both bottom row first
+void downsampleToRGB(const unsigned char* src, int w, int h, unsigned char* dst, int ew, int eh) {
+  parallelFor(
+      0, eh,
+      [&](size_t rowBegin, size_t rowEnd) {
+        for (size_t j = rowBegin; j < rowEnd; j++) {
+          int y0 = static_cast<int>(j * h / eh);
+          int y1 = std::max(static_cast<int>((j + 1) * h / eh), y0 + 1);
+          for (int i = 0; i < ew; i++) {
+            int x0 = static_cast<int>(static_cast<int64_t>(i) * w / ew);
+            int x1 = std::max(static_cast<int>(static_cast<int64_t>(i + 1) * w / ew), x0 + 1);
+            uint32_t sum[3] = {0, 0, 0};
+            for (int y = y0; y < y1; y++) {
+              const unsigned char* row = src + (static_cast<size_t>(y) * w + x0) * 4;
+              for (int x = x0; x < x1; x++, row += 4) {
+                sum[0] += row[0];
+                sum[1] += row[1];
+                sum[2] += row[2];
+              }
+            }
+            uint32_t n = static_cast<uint32_t>((y1 - y0) * (x1 - x0));
+            unsigned char* out = dst + (j * ew + i) * 3;
+            for (int c = 0; c < 3; c++) out[c] = static_cast<unsigned char>((sum[c] + n / 2) / n);
+          }
+        }
+      },
+      64);
+}
+
+// Encode the tiles of a frame which changed since the previous one. Leaves `message` empty if none did.
+void encodeRemoteFrame(const RemoteCapturedFrame& frame, int quality, float scale, bool keyframe, int tileSize,
+                       RemoteEncoderState& enc, std::vector<unsigned char>& message) {
+  message.clear();
+  int w = frame.width;
+  int h = frame.height;
+  if (w <= 0 || h <= 0 || frame.pixels.size() != static_cast<size_t>(w) * h * 4) return; // the read failed
+
+  int ew = std::max(static_cast<int>(std::lround(w * scale)), 1);
+  int eh = std::max(static_cast<int>(std::lround(h * scale)), 1);
+  enc.image.resize(static_cast<size_t>(ew) * eh * 3);
+  if (ew == w && eh == h) {
+    for (size_t i = 0; i < static_cast<size_t>(w) * h; i++) {
+      std::memcpy(&enc.image[3 * i], &frame.pixels[4 * i], 3);
+    }
+  } else {
+    downsampleToRGB(frame.pixels.data(), w, h, enc.image.data(), ew, eh);
+  }
+  bool full = keyframe || ew != enc.width || eh != enc.height;
+
+  // Tiles are counted from the top, the images are stored bottom row first
+  int nTilesX = (ew + tileSize - 1) / tileSize;
+  int nTilesY = (eh + tileSize - 1) / tileSize;
+  std::vector<std::array<int, 2>> changed;
+  for (int ty = 0; ty < nTilesY; ty++) {
+    for (int tx = 0; tx < nTilesX; tx++) {
+      bool tileChanged = full;
+      int x0 = tx * tileSize;
+      size_t rowBytes = 3 * static_cast<size_t>(std::min(tileSize, ew - x0));
+      for (int j = ty * tileSize; !tileChanged && j < std::min((ty + 1) * tileSize, eh); j++) {
+        size_t offset = (static_cast<size_t>(eh - 1 - j) * ew + x0) * 3;
+        tileChanged = std::memcmp(&enc.image[offset], &enc.prevImage[offset], rowBytes) != 0;
+      }
+      if (tileChanged) changed.push_back({{tx, ty}});
+    }
+  }
+
+  enc.width = ew;
+  enc.height = eh;
+  std::swap(enc.image, enc.prevImage);
+  if (changed.empty()) return;
+  const std::vector<unsigned char>& image = enc.prevImage;
+
+  // Encode the tiles in parallel. stb flips on write (see internal::configureImageWriting()), so tiles are also laid out
+  // bottom row first.
+  std::vector<std::vector<unsigned char>> jpegs(changed.size());
+  parallelForTiles(0, changed.size(), 1, 0, [&](size_t begin, size_t end) {
+    std::vector<unsigned char> tile;
+    for (size_t iT = begin; iT < end; iT++) {
+      int x0 = changed[iT][0] * tileSize;
+      int y0 = changed[iT][1] * tileSize;
+      int tw = std::min(tileSize, ew - x0);
+      int th = std::min(tileSize, eh - y0);
+      tile.resize(static_cast<size_t>(tw) * th * 3);
+      for (int k = 0; k < th; k++) {
+        int j = y0 + th - 1 - k; // counted from the top
+        std::memcpy(&tile[static_cast<size_t>(k) * tw * 3], &image[(static_cast<size_t>(eh - 1 - j) * ew + x0) * 3],
+                    static_cast<size_t>(tw) * 3);
+      }
+      stbi_write_jpg_to_func(appendBytes, &jpegs[iT], tw, th, 3, tile.data(), quality);
+    }
+  });
+
+  size_t nBytes = 20;
+  for (const std::vector<unsigned char>& jpeg : jpegs) nBytes += 8 + jpeg.size();
+  message.reserve(nBytes);
+  message.insert(message.end(), {'P', 'S', 'R', 'F'});
+  putU32(message, frame.frameId);
+  putU16(message, frame.windowWidth);
+  putU16(message, frame.windowHeight);
+  putU16(message, ew);
+  putU16(message, eh);
+  putU16(message, tileSize);
+  putU16(message, static_cast<uint32_t>(changed.size()));
+  for (size_t iT = 0; iT < changed.size(); iT++) {
+    putU16(message, changed[iT][0]);
+    putU16(message, changed[iT][1]);
+    putU32(message, static_cast<uint32_t>(jpegs[iT].size()));
+    message.insert(message.end(), jpegs[iT].begin(), jpegs[iT].end());
+  }
+}
+
+void remoteEncoderLoop() {
+  RemoteEncoderState enc;
+  std::vector<unsigned char> message;
+  while (true) {
+    RemoteCapturedFrame frame;
+    int quality;
+    float scale;
+    bool keyframe;
+    {
+      std::unique_lock<std::mutex> lock(remote.mutex);
+      remote.cond.wait(lock, [] { return !remote.queuedFrames.empty() || remote.finishing; });
+      if (remote.queuedFrames.empty()) return; // finishing, and everything has been sent
+      frame = std::move(remote.queuedFrames.front());
+      remote.queuedFrames.pop_front();
+      quality = remote.stats.quality;
+      scale = remote.stats.resolutionScale;
+      keyframe = remote.keyframeRequested;
+      remote.keyframeRequested = false;
+    }
+
+    encodeRemoteFrame(frame, quality, scale, keyframe, remote.settings.tileSize, enc, message);
+
+    bool sent = false;
+    std::string error;
+    if (!message.empty()) {
+      try {
+        remote.send(message);
+        sent = true;
+      } catch (const std::exception& e) {
+        error = e.what();
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(remote.mutex);
+    remote.freeBuffers.push_back(std::move(frame.pixels));
+    if (sent) {
+      remote.stats.framesSent++;
+      remote.stats.bytesSent += message.size();
+    } else {
+      // nothing will acknowledge it
+      remote.unackedFrames.erase(frame.frameId);
+      if (message.empty()) {
+        remote.stats.framesUnchanged++;
+      } else {
+        remote.sendFailed = true;
+        remote.sendError = error;
+        remote.keyframeRequested = true;
+      }
+    }
+  }
+}
+
+// Lower the stream quality when frames take too long to be acknowledged, raise it when there is headroom. Must hold the
+// mutex.
+void adaptRemoteStream() {
+  RemoteClock::time_point now = RemoteClock::now();
+  if (toMs(now - remote.lastAdapt) < remoteAdaptIntervalMs) return;
+
+  const RemoteSessionSettings& settings = remote.settings;
+  RemoteSessionStats& stats = remote.stats;
+  if (stats.latencyMs > remoteLatencyHigh * settings.targetLatencyMs) {
+    if (stats.quality > settings.minQuality) {
+      stats.quality = std::max(stats.quality - 10, settings.minQuality);
+    } else if (stats.resolutionScale > settings.minResolutionScale) {
+      stats.resolutionScale = std::max(stats.resolutionScale * remoteResolutionStep, settings.minResolutionScale);
+    } else {
+      return;
+    }
+  } else if (stats.latencyMs < remoteLatencyLow * settings.targetLatencyMs) {
+    if (stats.resolutionScale < 1.f) {
+      stats.resolutionScale = std::min(stats.resolutionScale / remoteResolutionStep, 1.f);
+    } else if (stats.quality < settings.maxQuality) {
+      stats.quality = std::min(stats.quality + 5, settings.maxQuality);
+    } else {
+      return;
+    }
+  } else {
+    return;
+  }
+  remote.lastAdapt = now;
+}
+
+// Must hold the mutex
+void acknowledgeRemoteFrame(uint32_t frameId) {
+  auto it = remote.unackedFrames.find(frameId);
+  if (it == remote.unackedFrames.end()) return;
+
+  double ms = toMs(RemoteClock::now() - it->second);
+  if (remote.stats.latencyMs == 0.) {
+    remote.stats.latencyMs = ms;
+  } else {
+    remote.stats.latencyMs = 0.8 * remote.stats.latencyMs + 0.2 * ms;
+  }
+
+  // acknowledgments arrive in order, the frames before this one are not going to be acknowledged any more
+  remote.unackedFrames.erase(remote.unackedFrames.begin(), std::next(it));
+  adaptRemoteStream();
+}
+
+// Hand the oldest completed read to the encoder thread. Returns false if it has not completed and wait is false.
+bool finishOldestRemoteRead(bool wait) {
+  if (remote.pendingReads.empty()) return false;
+  const RemotePendingRead& read = remote.pendingReads.front();
+
+  RemoteCapturedFrame frame;
+  {
+    std::lock_guard<std::mutex> lock(remote.mutex);
+    if (!remote.freeBuffers.empty()) {
+      frame.pixels = std::move(remote.freeBuffers.back());
+      remote.freeBuffers.pop_back();
+    }
+  }
+
+  if (!render::engine->displayBuffer->pollReadBuffer(read.ticket, frame.pixels, wait)) {
+    if (!wait) {
+      std::lock_guard<std::mutex> lock(remote.mutex);
+      remote.freeBuffers.push_back(std::move(frame.pixels));
+      return false;
+    }
+    frame.pixels.clear(); // the read failed, the encoder skips it
+  }
+  frame.frameId = read.frameId;
+  frame.width = read.width;
+  frame.height = read.height;
+  frame.windowWidth = read.windowWidth;
+  frame.windowHeight = read.windowHeight;
+  remote.pendingReads.pop_front();
+
+  {
+    std::lock_guard<std::mutex> lock(remote.mutex);
+    remote.queuedFrames.push_back(std::move(frame));
+  }
+  remote.cond.notify_all();
+  return true;
+}
+
+void applyRemoteInputEvent(const RemoteInputEvent& event) {
+  ImGuiIO& io = ImGui::GetIO();
+  switch (event.type) {
+  case RemoteInputType::FrameAck: {
+    std::lock_guard<std::mutex> lock(remote.mutex);
+    acknowledgeRemoteFrame(event.value);
+    break;
+  }
+  case RemoteInputType::MouseMove:
+    io.AddMousePosEvent(event.x * view::windowWidth, event.y * view::windowHeight);
+    break;
+  case RemoteInputType::MouseButton:
+    if (event.value < ImGuiMouseButton_COUNT) io.AddMouseButtonEvent(static_cast<int>(event.value), event.down);
+    break;
+  case RemoteInputType::Scroll:
+    io.AddMouseWheelEvent(event.x, event.y);
+    break;
+  case RemoteInputType::Key:
+    io.AddKeyEvent(static_cast<ImGuiKey>(event.value), event.down);
+    break;
+  case RemoteInputType::Text:
+    io.AddInputCharacter(event.value);
+    break;
+  case RemoteInputType::Resize:
+    if (event.width > 0 && event.height > 0 &&
+        (event.width != view::windowWidth || event.height != view::windowHeight)) {
+      view::setWindowSize(event.width, event.height);
+    }
+    break;
+  }
+}
+
+} // namespace
+
+void startRemoteSession(std::function<void(const std::vector<unsigned char>& message)> send,
+                        RemoteSessionSettings settings) {
+  if (remote.active) {
+    warning("startRemoteSession() called while a session is active, stopping that session");
+    stopRemoteSession();
+  }
+  if (!send) {
+    exception("startRemoteSession() requires a send function");
+  }
+  if (settings.tileSize < 8 || settings.tileSize > 4096 || settings.maxFramesInFlight < 1 ||
+      settings.minQuality < 1 || settings.maxQuality > 100 || settings.minQuality > settings.maxQuality ||
+      !(settings.minResolutionScale > 0.f && settings.minResolutionScale <= 1.f)) {
+    exception("startRemoteSession() invalid settings");
+  }
+  internal::configureImageWriting();
+
+  remote.settings = settings;
+  remote.send = send;
+  remote.pendingReads.clear();
+  remote.queuedFrames.clear();
+  remote.unackedFrames.clear();
+  remote.inputEvents.clear();
+  remote.finishing = false;
+  remote.keyframeRequested = true;
+  remote.sendFailed = false;
+  remote.lastAdapt = RemoteClock::now();
+  remote.stats = RemoteSessionStats();
+  remote.stats.quality = settings.maxQuality;
+
+  remote.encoder = std::thread(remoteEncoderLoop);
+  remote.active = true;
+  requestRedraw();
+}
+
+void stopRemoteSession() {
+  if (!remote.active) return;
+
+  while (!remote.pendingReads.empty()) {
+    finishOldestRemoteRead(true);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(remote.mutex);
+    remote.finishing = true;
+  }
+  remote.cond.notify_all();
+  remote.encoder.join();
+
+  remote.active = false;
+  remote.send = nullptr;
+  remote.freeBuffers.clear();
+}
+
+bool isRemoteSessionActive() { return remote.active; }
+
+RemoteSessionStats getRemoteSessionStats() {
+  std::lock_guard<std::mutex> lock(remote.mutex);
+  return remote.stats;
+}
+
+void requestRemoteKeyframe() {
+  std::lock_guard<std::mutex> lock(remote.mutex);
+  remote.keyframeRequested = true;
+}
+
+bool receiveRemoteMessage(const unsigned char* data, size_t nBytes) {
+  if (nBytes < 5 || std::memcmp(data, "PSRI", 4) != 0) return false;
+
+  RemoteInputEvent event;
+  const unsigned char* payload = data + 5;
+  size_t payloadBytes = nBytes - 5;
+  switch (data[4]) {
+  case static_cast<unsigned char>(RemoteInputType::FrameAck):
+    if (payloadBytes < 4) return false;
+    event.type = RemoteInputType::FrameAck;
+    event.value = getU32(payload);
+    break;
+  case static_cast<unsigned char>(RemoteInputType::MouseMove):
+    if (payloadBytes < 8) return false;
+    event.type = RemoteInputType::MouseMove;
+    event.x = getF32(payload);
+    event.y = getF32(payload + 4);
+    break;
+  case static_cast<unsigned char>(RemoteInputType::MouseButton):
+    if (payloadBytes < 2) return false;
+    event.type = RemoteInputType::MouseButton;
+    event.value = payload[0];
+    event.down = payload[1] != 0;
+    break;
+  case static_cast<unsigned char>(RemoteInputType::Scroll):
+    if (payloadBytes < 8) return false;
+    event.type = RemoteInputType::Scroll;
+    event.x = getF32(payload);
+    event.y = getF32(payload + 4);
+    break;
+  case static_cast<unsigned char>(RemoteInputType::Key):
+    if (payloadBytes < 3) return false;
+    event.type = RemoteInputType::Key;
+    event.value = getU16(payload);
+    event.down = payload[2] != 0;
+    break;
+  case static_cast<unsigned char>(RemoteInputType::Text):
+    if (payloadBytes < 4) return false;
+    event.type = RemoteInputType::Text;
+    event.value = getU32(payload);
+    break;
+  case static_cast<unsigned char>(RemoteInputType::Resize):
+    if (payloadBytes < 4) return false;
+    event.type = RemoteInputType::Resize;
+    event.width = static_cast<int>(getU16(payload));
+    event.height = static_cast<int>(getU16(payload + 2));
+    break;
+  default:
+    return false;
+  }
+
+  pushRemoteInputEvent(event);
+  return true;
+}
+
+void pushRemoteInputEvent(const RemoteInputEvent& event) {
+  std::lock_guard<std::mutex> lock(remote.mutex);
+  remote.inputEvents.push_back(event);
+}
+
+void processRemoteInput() {
+  if (!remote.active) return;
+
+  std::deque<RemoteInputEvent> events;
+  bool sendFailed;
+  std::string sendError;
+  {
+    std::lock_guard<std::mutex> lock(remote.mutex);
+    events.swap(remote.inputEvents);
+    sendFailed = remote.sendFailed;
+    sendError = remote.sendError;
+    remote.sendFailed = false;
+  }
+  if (sendFailed) {
+    warning("sending a remote frame failed: " + sendError);
+  }
+
+  bool hadInput = false;
+  for (const RemoteInputEvent& event : events) {
+    applyRemoteInputEvent(event);
+    if (event.type != RemoteInputType::FrameAck) hadInput = true;
+  }
+  if (hadInput) requestRedraw();
+}
+
+void processRemoteFrame() {
+  if (!remote.active) return;
+
+  while (finishOldestRemoteRead(false)) {
+  }
+
+  uint32_t frameId = remote.nextFrameId;
+  {
+    std::lock_guard<std::mutex> lock(remote.mutex);
+
+    // Frames which are never acknowledged would stall the stream
+    RemoteClock::time_point now = RemoteClock::now();
+    if (!remote.unackedFrames.empty() && toMs(now - remote.unackedFrames.begin()->second) > remoteAckTimeoutMs) {
+      remote.unackedFrames.clear();
+      remote.keyframeRequested = true;
+    }
+
+    if (remote.unackedFrames.size() >= static_cast<size_t>(remote.settings.maxFramesInFlight)) {
+      remote.stats.framesSkipped++;
+      return;
+    }
+    remote.unackedFrames[frameId] = now;
+  }
+  remote.nextFrameId++;
+
+  RemotePendingRead read;
+  read.ticket = render::engine->displayBuffer->requestReadBuffer();
+  read.frameId = frameId;
+  read.width = static_cast<int>(render::engine->displayBuffer->getSizeX());
+  read.height = static_cast<int>(render::engine->displayBuffer->getSizeY());
+  read.windowWidth = view::windowWidth;
+  read.windowHeight = view::windowHeight;
+  remote.pendingReads.push_back(read);
+}
+
+} // namespace polyscope
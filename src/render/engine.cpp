@@ -10,6 +10,13 @@
 #include "imgui.h"
 #include "stb_image.h"
 
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
 namespace polyscope {
 
 int dimension(const TextureFormat& x) {
@@ -25,6 +32,10 @@ int dimension(const TextureFormat& x) {
     case TextureFormat::RGB32F:   return 3;
     case TextureFormat::RGBA32F:  return 4;
     case TextureFormat::DEPTH24:  return 1;
+    case TextureFormat::RGB9E5:   return 3;
+    case TextureFormat::R8:       return 1;
+    case TextureFormat::R16:      return 1;
+    case TextureFormat::RGBA16:   return 4;
   }
   // clang-format on
   exception("bad enum");
@@ -44,6 +55,21 @@ int sizeInBytes(const TextureFormat& f) {
     case TextureFormat::RGB32F:   return 3*4;
     case TextureFormat::RGBA32F:  return 4*4;
     case TextureFormat::DEPTH24:  return 1*3;
+    case TextureFormat::RGB9E5:   return 4;
+    case TextureFormat::R8:       return 1*1;
+    case TextureFormat::R16:      return 1*2;
+    case TextureFormat::RGBA16:   return 4*2;
+  }
+  // clang-format on
+  return -1;
+}
+
+int sizeInBytes(const PixelComponentType& t) {
+  // clang-format off
+  switch (t) {
+    case PixelComponentType::Float32: return 4;
+    case PixelComponentType::UNorm8:  return 1;
+    case PixelComponentType::UNorm16: return 2;
   }
   // clang-format on
   return -1;
@@ -118,6 +144,133 @@ int renderDataTypeCountCompatbility(const RenderDataType r1, const RenderDataTyp
   return 0;
 }
 
+std::string attributeStorageFormatName(const AttributeStorageFormat& f) {
+  switch (f) {
+  case AttributeStorageFormat::Float32:
+    return "Float32";
+  case AttributeStorageFormat::Float16:
+    return "Float16";
+  case AttributeStorageFormat::UNorm8:
+    return "UNorm8";
+  case AttributeStorageFormat::SNorm16:
+    return "SNorm16";
+  }
+  return "";
+}
+
+namespace {
+
+int floatComponentCount(const RenderDataType& r) {
+  switch (r) {
+  case RenderDataType::Float:
+    return 1;
+  case RenderDataType::Vector2Float:
+    return 2;
+  case RenderDataType::Vector3Float:
+    return 3;
+  case RenderDataType::Vector4Float:
+    return 4;
+  default:
+    break;
+  }
+  exception("compact attribute storage formats are only supported for float types, not " + renderDataTypeName(r));
+  return -1;
+}
+
+int storageComponentBytes(const AttributeStorageFormat& f) {
+  switch (f) {
+  case AttributeStorageFormat::Float32:
+    return 4;
+  case AttributeStorageFormat::Float16:
+    return 2;
+  case AttributeStorageFormat::UNorm8:
+    return 1;
+  case AttributeStorageFormat::SNorm16:
+    return 2;
+  }
+  return -1;
+}
+
+int storageComponentCount(const RenderDataType& r, const AttributeStorageFormat& f) {
+  int nComp = floatComponentCount(r);
+  if (f != AttributeStorageFormat::Float32 && nComp == 3) return 4;
+  return nComp;
+}
+
+} // namespace
+
+int storageSizeInBytes(const RenderDataType& r, const AttributeStorageFormat& f) {
+  if (f == AttributeStorageFormat::Float32) return sizeInBytes(r);
+  return storageComponentCount(r, f) * storageComponentBytes(f);
+}
+
+void packAttributeData(const RenderDataType& r, const AttributeStorageFormat& f, const float* values, size_t nEntries,
+                       std::vector<unsigned char>& bytesOut) {
+  size_t nComp = floatComponentCount(r);
+  size_t nStored = storageComponentCount(r, f);
+  size_t compBytes = storageComponentBytes(f);
+  bytesOut.assign(nEntries * nStored * compBytes, 0); // padding components stay zero
+
+  for (size_t iE = 0; iE < nEntries; iE++) {
+    for (size_t iC = 0; iC < nComp; iC++) {
+      float val = values[iE * nComp + iC];
+      unsigned char* dst = &bytesOut[(iE * nStored + iC) * compBytes];
+      switch (f) {
+      case AttributeStorageFormat::Float32:
+        std::memcpy(dst, &val, sizeof(float));
+        break;
+      case AttributeStorageFormat::Float16: {
+        uint16_t packed = glm::packHalf1x16(val);
+        std::memcpy(dst, &packed, sizeof(uint16_t));
+        break;
+      }
+      case AttributeStorageFormat::UNorm8:
+        *dst = glm::packUnorm1x8(val);
+        break;
+      case AttributeStorageFormat::SNorm16: {
+        uint16_t packed = glm::packSnorm1x16(val);
+        std::memcpy(dst, &packed, sizeof(uint16_t));
+        break;
+      }
+      }
+    }
+  }
+}
+
+void unpackAttributeData(const RenderDataType& r, const AttributeStorageFormat& f, const unsigned char* bytes,
+                         size_t nEntries, float* valuesOut) {
+  size_t nComp = floatComponentCount(r);
+  size_t nStored = storageComponentCount(r, f);
+  size_t compBytes = storageComponentBytes(f);
+
+  for (size_t iE = 0; iE < nEntries; iE++) {
+    for (size_t iC = 0; iC < nComp; iC++) {
+      const unsigned char* src = &bytes[(iE * nStored + iC) * compBytes];
+      float& val = valuesOut[iE * nComp + iC];
+      switch (f) {
+      case AttributeStorageFormat::Float32:
+        std::memcpy(&val, src, sizeof(float));
+        break;
+      case AttributeStorageFormat::Float16: {
+        uint16_t packed;
+        std::memcpy(&packed, src, sizeof(uint16_t));
+        val = glm::unpackHalf1x16(packed);
+        break;
+      }
+      case AttributeStorageFormat::UNorm8:
+        val = glm::unpackUnorm1x8(*src);
+        break;
+      case AttributeStorageFormat::SNorm16: {
+        uint16_t packed;
+        std::memcpy(&packed, src, sizeof(uint16_t));
+        val = glm::unpackSnorm1x16(packed);
+        break;
+      }
+      }
+    }
+  }
+}
+
 std::string modeName(const TransparencyMode& m) {
   switch (m) {
   case TransparencyMode::None:
@@ -126,6 +279,8 @@ std::string modeName(const TransparencyMode& m) {
     return "Simple";
   case TransparencyMode::Pretty:
     return "Pretty";
+  case TransparencyMode::WeightedBlended:
+    return "Weighted Blended";
   }
   return "";
 }
@@ -158,10 +313,53 @@ std::string deviceBufferTypeName(const DeviceBufferType& d) {
 
 namespace render {
 
+namespace {
+
+DeviceMemoryUsage deviceMemoryUsage;
+
+// Adjust one of the totals as a buffer's allocation changes from oldBytes to newBytes
+void updateDeviceMemoryTotal(size_t& total, size_t oldBytes, size_t newBytes) { total = total - oldBytes + newBytes; }
+
+size_t renderBufferPixelBytes(RenderBufferType type) {
+  switch (type) {
+  case RenderBufferType::Color:
+    return 3;
+  case RenderBufferType::ColorAlpha:
+    return 4;
+  case RenderBufferType::Depth:
+    return 4;
+  case RenderBufferType::Float4:
+    return 16;
+  case RenderBufferType::UInt2:
+    return 8;
+  }
+  return 0;
+}
+
+} // namespace
+
+const DeviceMemoryUsage& getDeviceMemoryUsage() { return deviceMemoryUsage; }
+
 AttributeBuffer::AttributeBuffer(RenderDataType dataType_, int arrayCount_)
     : dataType(dataType_), arrayCount(arrayCount_), uniqueID(render::engine->getNextUniqueID()) {}
 
-AttributeBuffer::~AttributeBuffer() {}
+AttributeBuffer::~AttributeBuffer() { setDeviceMemoryBytes(0); }
+
+size_t AttributeBuffer::getStorageElementBytes() const {
+  return static_cast<size_t>(storageSizeInBytes(dataType, storageFormat)) * arrayCount;
+}
+
+void AttributeBuffer::setStorageFormat(AttributeStorageFormat newFormat) {
+  if (newFormat == storageFormat) return;
+  if (isSet()) exception("attribute storage format must be set before the buffer is filled");
+  storageSizeInBytes(dataType, newFormat); // throws for non-float types
+  storageFormat = newFormat;
+}
+
+void AttributeBuffer::setDeviceMemoryBytes(size_t newBytes) {
+  updateDeviceMemoryTotal(deviceMemoryUsage.attributeBytes, deviceMemoryBytes, newBytes);
+  deviceMemoryBytes = newBytes;
+}
 
 TextureBuffer::TextureBuffer(int dim_, TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_,
                              unsigned int sizeZ_)
@@ -169,21 +367,36 @@ TextureBuffer::TextureBuffer(int dim_, TextureFormat format_, unsigned int sizeX
       uniqueID(render::engine->getNextUniqueID()) {
   if (sizeX > (1 << 22)) exception("OpenGL error: invalid texture dimensions");
   if (dim > 1 && sizeY > (1 << 22)) exception("OpenGL error: invalid texture dimensions");
+  updateDeviceMemoryBytes();
 }
 
-TextureBuffer::~TextureBuffer() {}
+TextureBuffer::~TextureBuffer() { updateDeviceMemoryTotal(deviceMemoryUsage.textureBytes, deviceMemoryBytes, 0); }
 
 void TextureBuffer::setFilterMode(FilterMode newMode) {}
 
-void TextureBuffer::resize(unsigned int newLen) { sizeX = newLen; }
+void TextureBuffer::resize(unsigned int newLen) {
+  sizeX = newLen;
+  updateDeviceMemoryBytes();
+}
 void TextureBuffer::resize(unsigned int newX, unsigned int newY) {
   sizeX = newX;
   sizeY = newY;
+  updateDeviceMemoryBytes();
 }
 void TextureBuffer::resize(unsigned int newX, unsigned int newY, unsigned int newZ) {
   sizeX = newX;
   sizeY = newY;
   sizeZ = newZ;
+  updateDeviceMemoryBytes();
+}
+
+void TextureBuffer::updateDeviceMemoryBytes() {
+  size_t nTexels = sizeX;
+  if (dim > 1) nTexels *= sizeY;
+  if (dim > 2) nTexels *= sizeZ;
+  size_t newBytes = external ? 0 : nTexels * sizeInBytes(format);
+  updateDeviceMemoryTotal(deviceMemoryUsage.textureBytes, deviceMemoryBytes, newBytes);
+  deviceMemoryBytes = newBytes;
 }
 
 unsigned int TextureBuffer::getTotalSize() const {
@@ -201,13 +414,33 @@ unsigned int TextureBuffer::getTotalSize() const {
 RenderBuffer::RenderBuffer(RenderBufferType type_, unsigned int sizeX_, unsigned int sizeY_)
     : type(type_), sizeX(sizeX_), sizeY(sizeY_), uniqueID(render::engine->getNextUniqueID()) {
   if (sizeX > (1 << 22) || sizeY > (1 << 22)) exception("OpenGL error: invalid renderbuffer dimensions");
+  updateDeviceMemoryBytes();
 }
 
+RenderBuffer::~RenderBuffer() { updateDeviceMemoryTotal(deviceMemoryUsage.renderBufferBytes, deviceMemoryBytes, 0); }
+
 void RenderBuffer::resize(unsigned int newX, unsigned int newY) {
   sizeX = newX;
   sizeY = newY;
+  updateDeviceMemoryBytes();
+}
+
+void RenderBuffer::updateDeviceMemoryBytes() {
+  size_t newBytes = static_cast<size_t>(sizeX) * sizeY * renderBufferPixelBytes(type);
+  updateDeviceMemoryTotal(deviceMemoryUsage.renderBufferBytes, deviceMemoryBytes, newBytes);
+  deviceMemoryBytes = newBytes;
+}
+
+namespace {
+thread_local bool uniformRecordingActive = false;
 }
 
+UniformRecording::UniformRecording() : wasActive(uniformRecordingActive) { uniformRecordingActive = true; }
+
+UniformRecording::~UniformRecording() { uniformRecordingActive = wasActive; }
+
+bool UniformRecording::isActive() { return uniformRecordingActive; }
+
 FrameBuffer::FrameBuffer() : uniqueID(render::engine->getNextUniqueID()) {}
 
 void FrameBuffer::setViewport(int startX, int startY, unsigned int sizeX, unsigned int sizeY) {
@@ -218,6 +451,16 @@ void FrameBuffer::setViewport(int startX, int startY, unsigned int sizeX, unsign
   viewportSet = true;
 }
 
+void FrameBuffer::setScissor(int startX, int startY, unsigned int sizeX, unsigned int sizeY) {
+  scissorX = startX;
+  scissorY = startY;
+  scissorSizeX = sizeX;
+  scissorSizeY = sizeY;
+  scissorSet = true;
+}
+
+void FrameBuffer::removeScissor() { scissorSet = false; }
+
 void FrameBuffer::resize(unsigned int newXSize, unsigned int newYSize) {
   bind();
   for (auto& b : renderBuffersColor) {
@@ -236,6 +479,75 @@ void FrameBuffer::resize(unsigned int newXSize, unsigned int newYSize) {
   sizeY = newYSize;
 }
 
+void FrameBuffer::requestReadFloat4(int xPos, int yPos) {
+  pendingReadFloat4 = readFloat4(xPos, yPos);
+  pendingReadFloat4Valid = true;
+}
+
+bool FrameBuffer::pollReadFloat4(std::array<float, 4>& result) {
+  if (!pendingReadFloat4Valid) return false;
+  result = pendingReadFloat4;
+  pendingReadFloat4Valid = false;
+  return true;
+}
+
+bool FrameBuffer::hasPendingReadFloat4() { return pendingReadFloat4Valid; }
+
+void FrameBuffer::requestReadUInt2(int xPos, int yPos) {
+  pendingReadUInt2 = readUInt2(xPos, yPos);
+  pendingReadUInt2Valid = true;
+}
+
+bool FrameBuffer::pollReadUInt2(std::array<uint32_t, 2>& result) {
+  if (!pendingReadUInt2Valid) return false;
+  result = pendingReadUInt2;
+  pendingReadUInt2Valid = false;
+  return true;
+}
+
+bool FrameBuffer::hasPendingReadUInt2() { return pendingReadUInt2Valid; }
+
+uint64_t FrameBuffer::requestReadBuffer() {
+  uint64_t ticket = nextReadBufferTicket++;
+  pendingReadBuffers[ticket] = readBuffer();
+  return ticket;
+}
+
+bool FrameBuffer::pollReadBuffer(uint64_t ticket, std::vector<unsigned char>& result, bool wait) {
+  auto it = pendingReadBuffers.find(ticket);
+  if (it == pendingReadBuffers.end()) return false;
+  result = std::move(it->second);
+  pendingReadBuffers.erase(it);
+  return true;
+}
+
+void FrameBuffer::requestReadDepthBuffer(int stride) {
+  std::vector<float> depth = readDepthBuffer();
+  pendingReadDepth = subsampleDepth(depth.data(), getSizeX(), getSizeY(), stride);
+  pendingReadDepthValid = true;
+}
+
+bool FrameBuffer::pollReadDepthBuffer(std::vector<float>& result) {
+  if (!pendingReadDepthValid) return false;
+  result = std::move(pendingReadDepth);
+  pendingReadDepthValid = false;
+  return true;
+}
+
+std::vector<float> FrameBuffer::subsampleDepth(const float* depth, int w, int h, int stride) {
+  stride = std::max(stride, 1);
+  if (stride == 1) return std::vector<float>(depth, depth + static_cast<size_t>(w) * h);
+  int wOut = (w + stride - 1) / stride;
+  int hOut = (h + stride - 1) / stride;
+  std::vector<float> result(static_cast<size_t>(wOut) * hOut);
+  for (int y = 0; y < hOut; y++) {
+    for (int x = 0; x < wOut; x++) {
+      result[static_cast<size_t>(y) * wOut + x] = depth[static_cast<size_t>(y * stride) * w + x * stride];
+    }
+  }
+  return result;
+}
+
 void FrameBuffer::verifyBufferSizes() {
   for (auto& b : renderBuffersColor) {
     if (b->getSizeX() != getSizeX() || b->getSizeY() != getSizeY())
@@ -265,11 +577,41 @@ ShaderProgram::ShaderProgram(DrawMode dm) : drawMode(dm), uniqueID(render::engin
     useIndex = true;
   }
 
-  if (dm == DrawMode::IndexedLineStripAdjacency) {
+  if (dm == DrawMode::IndexedLineStrip || dm == DrawMode::IndexedLineStripAdjacency) {
     usePrimitiveRestart = true;
   }
 }
 
+std::string ShaderProgram::colormapRowUniformName(const std::string& textureName) {
+  std::string base = textureName.compare(0, 2, "t_") == 0 ? textureName.substr(2) : textureName;
+  return "u_" + base + "Row";
+}
+
+void ShaderProgram::countDrawCall(size_t nVertices) {
+  size_t nTriangles = 0;
+  switch (drawMode) {
+  case DrawMode::Triangles:
+  case DrawMode::IndexedTriangles:
+    nTriangles = nVertices / 3;
+    break;
+  case DrawMode::TrianglesAdjacency:
+    nTriangles = nVertices / 6;
+    break;
+  case DrawMode::TrianglesInstanced:
+    nTriangles = (nVertices / 3) * instanceCount;
+    break;
+  case DrawMode::TriangleStripInstanced:
+    nTriangles = (nVertices >= 3 ? nVertices - 2 : 0) * instanceCount;
+    break;
+  default:
+    break; // points and lines
+  }
+
+  RenderStats& stats = render::engine->stats;
+  stats.drawCalls++;
+  stats.trianglesSubmitted += nTriangles;
+}
+
 
 Engine::Engine() {}
 Engine::~Engine() {}
@@ -300,7 +642,8 @@ void Engine::buildEngineGui() {
     if (ImGui::TreeNode("Transparency")) {
 
       if (ImGui::BeginCombo("Mode", modeName(transparencyMode).c_str())) {
-        for (TransparencyMode m : {TransparencyMode::None, TransparencyMode::Simple, TransparencyMode::Pretty}) {
+        for (TransparencyMode m : {TransparencyMode::None, TransparencyMode::Simple, TransparencyMode::Pretty,
+                                   TransparencyMode::WeightedBlended}) {
           std::string mName = modeName(m);
           if (ImGui::Selectable(mName.c_str(), transparencyMode == m)) {
             options::transparencyMode = m;
@@ -326,6 +669,12 @@ void Engine::buildEngineGui() {
         if (ImGui::InputInt("Render Passes", &options::transparencyRenderPasses)) {
           requestRedraw();
         }
+        ImGui::Text("Passes used: %d", stats.transparencyRenderPassesUsed);
+        break;
+      }
+      case TransparencyMode::WeightedBlended: {
+        ImGui::TextWrapped("Order-independent transparency in a single pass. Fast and handles overlapping transparent "
+                           "objects well, but blends by an approximate depth weighting.");
         break;
       }
       }
@@ -356,6 +705,12 @@ void Engine::buildEngineGui() {
         options::ssaaFactor = ssaaFactor;
         requestRedraw();
       }
+      if (ImGui::Checkbox("TAA", &options::temporalAntiAliasing)) {
+        requestRedraw();
+      }
+      if (ImGui::Checkbox("FXAA", &options::fxaa)) {
+        requestRedraw();
+      }
       ImGui::TreePop();
     }
 
@@ -458,9 +813,22 @@ void Engine::resizeScreenBuffers() {
   unsigned int height = view::bufferHeight;
   displayBuffer->resize(width, height);
   displayBufferAlt->resize(width, height);
-  sceneBuffer->resize(ssaaFactor * width, ssaaFactor * height);
-  sceneBufferFinal->resize(ssaaFactor * width, ssaaFactor * height);
-  sceneDepthMinFrame->resize(ssaaFactor * width, ssaaFactor * height);
+  unsigned int sceneWidth = scaledSceneBufferSize(width);
+  unsigned int sceneHeight = scaledSceneBufferSize(height);
+  sceneBuffer->resize(sceneWidth, sceneHeight);
+  if (sceneBufferFinal && sceneBufferFinal != sceneBuffer) sceneBufferFinal->resize(sceneWidth, sceneHeight);
+  if (sceneDepthMinFrame) sceneDepthMinFrame->resize(sceneWidth, sceneHeight);
+  if (sceneDepthPrepassFrame) sceneDepthPrepassFrame->resize(sceneWidth, sceneHeight);
+  if (sceneBufferWeighted) sceneBufferWeighted->resize(sceneWidth, sceneHeight);
+  for (int i = 0; i < 2; i++) {
+    if (taaHistoryBuffer[i]) taaHistoryBuffer[i]->resize(sceneWidth, sceneHeight);
+  }
+  taaHistorySamples = 0;
+}
+
+unsigned int Engine::scaledSceneBufferSize(unsigned int displaySize) {
+  if (sceneResolutionScale == 1.) return ssaaFactor * displaySize;
+  return std::max(1u, static_cast<unsigned int>(std::round(getSceneBufferScale() * displaySize)));
 }
 
 void Engine::setScreenBufferViewports() {
@@ -471,13 +839,143 @@ void Engine::setScreenBufferViewports() {
 
   displayBuffer->setViewport(xStart, yStart, sizeX, sizeY);
   displayBufferAlt->setViewport(xStart, yStart, sizeX, sizeY);
-  sceneBuffer->setViewport(ssaaFactor * xStart, ssaaFactor * yStart, ssaaFactor * sizeX, ssaaFactor * sizeY);
-  sceneBufferFinal->setViewport(ssaaFactor * xStart, ssaaFactor * yStart, ssaaFactor * sizeX, ssaaFactor * sizeY);
-  sceneDepthMinFrame->setViewport(ssaaFactor * xStart, ssaaFactor * yStart, ssaaFactor * sizeX, ssaaFactor * sizeY);
+  unsigned int sceneX = scaledSceneBufferSize(xStart);
+  unsigned int sceneY = scaledSceneBufferSize(yStart);
+  unsigned int sceneSizeX = scaledSceneBufferSize(sizeX);
+  unsigned int sceneSizeY = scaledSceneBufferSize(sizeY);
+  sceneBuffer->setViewport(sceneX, sceneY, sceneSizeX, sceneSizeY);
+  if (sceneBufferFinal) sceneBufferFinal->setViewport(sceneX, sceneY, sceneSizeX, sceneSizeY);
+  if (sceneDepthMinFrame) sceneDepthMinFrame->setViewport(sceneX, sceneY, sceneSizeX, sceneSizeY);
+  if (sceneDepthPrepassFrame) sceneDepthPrepassFrame->setViewport(sceneX, sceneY, sceneSizeX, sceneSizeY);
+  if (sceneBufferWeighted) sceneBufferWeighted->setViewport(sceneX, sceneY, sceneSizeX, sceneSizeY);
+  for (int i = 0; i < 2; i++) {
+    if (taaHistoryBuffer[i]) taaHistoryBuffer[i]->setViewport(sceneX, sceneY, sceneSizeX, sceneSizeY);
+  }
+}
+
+void Engine::copySceneToFinal() {
+  if (sceneBufferFinal == sceneBuffer) return;
+  sceneBuffer->blitTo(sceneBufferFinal.get());
+}
+
+void Engine::setRenderTargetBudget(bool newVal) {
+  renderTargetBudget = newVal;
+  updateSceneBufferAllocation();
+  requestRedraw();
+}
+
+bool Engine::getRenderTargetBudget() { return renderTargetBudget; }
+
+void Engine::updateSceneBufferAllocation() {
+  if (!sceneBuffer) return; // before the global buffers are allocated
+
+  unsigned int sceneWidth = scaledSceneBufferSize(view::bufferWidth);
+  unsigned int sceneHeight = scaledSceneBufferSize(view::bufferHeight);
+
+  // Depth peeling keeps the depth of the previous layer
+  bool needDepthMin = transparencyMode == TransparencyMode::Pretty;
+  if (needDepthMin && !sceneDepthMinFrame) {
+    sceneDepthMin = generateTextureBuffer(TextureFormat::DEPTH24, sceneWidth, sceneHeight);
+    sceneDepthMinFrame = generateFrameBuffer(sceneWidth, sceneHeight);
+    sceneDepthMinFrame->addDepthBuffer(sceneDepthMin);
+    sceneDepthMinFrame->clearDepth = 0.0;
+    sceneDepthMinFrame->setViewport(0, 0, sceneWidth, sceneHeight);
+  }
+  if (needDepthMin && !compositePeel) {
+    // clang-format off
+    compositePeel = render::engine->requestShader("COMPOSITE_PEEL", {}, render::ShaderReplacementDefaults::Process);
+    compositePeel->setAttribute("a_position", screenTrianglesCoords());
+    compositePeel->setTextureFromBuffer("t_image", sceneColor.get());
+
+    copyDepth = render::engine->requestShader("DEPTH_COPY", {}, render::ShaderReplacementDefaults::Process);
+    copyDepth->setAttribute("a_position", screenTrianglesCoords());
+    copyDepth->setTextureFromBuffer("t_depth", sceneDepth.get());
+    // clang-format on
+  }
+  if (!needDepthMin && renderTargetBudget) {
+    sceneDepthMinFrame.reset();
+    sceneDepthMin.reset();
+  }
+
+  // The depth prepass keeps a copy of the opaque scene depth, which the shading stage reads
+  if (depthPrepass && !sceneDepthPrepassFrame) {
+    sceneDepthPrepass = generateTextureBuffer(TextureFormat::DEPTH24, sceneWidth, sceneHeight);
+    sceneDepthPrepassFrame = generateFrameBuffer(sceneWidth, sceneHeight);
+    sceneDepthPrepassFrame->addDepthBuffer(sceneDepthPrepass);
+    sceneDepthPrepassFrame->setViewport(0, 0, sceneWidth, sceneHeight);
+  }
+  if (depthPrepass && !copyDepth) {
+    copyDepth = render::engine->requestShader("DEPTH_COPY", {}, render::ShaderReplacementDefaults::Process);
+    copyDepth->setAttribute("a_position", screenTrianglesCoords());
+    copyDepth->setTextureFromBuffer("t_depth", sceneDepth.get());
+  }
+  if (!depthPrepass && renderTargetBudget) {
+    sceneDepthPrepassFrame.reset();
+    sceneDepthPrepass.reset();
+  }
+
+  // Accumulation buffers for weighted blended transparency, which share the depth buffer of the scene buffer
+  bool needWeighted = transparencyMode == TransparencyMode::WeightedBlended;
+  if (needWeighted && !sceneBufferWeighted) {
+    sceneWeightedAccum = generateTextureBuffer(TextureFormat::RGBA16F, sceneWidth, sceneHeight);
+    sceneWeightedRevealage = generateTextureBuffer(TextureFormat::R16F, sceneWidth, sceneHeight);
+    sceneBufferWeighted = generateFrameBuffer(sceneWidth, sceneHeight);
+    sceneBufferWeighted->addColorBuffer(sceneWeightedAccum);
+    sceneBufferWeighted->addColorBuffer(sceneWeightedRevealage);
+    sceneBufferWeighted->addDepthBuffer(sceneDepth);
+    sceneBufferWeighted->setDrawBuffers();
+    sceneBufferWeighted->clearColor = glm::vec3{0., 0., 0.};
+    sceneBufferWeighted->clearAlpha = 0.0;
+    sceneBufferWeighted->setViewport(0, 0, sceneWidth, sceneHeight);
+    if (!compositeWeighted) {
+      // clang-format off
+      compositeWeighted = render::engine->requestShader("COMPOSITE_WEIGHTED", {}, render::ShaderReplacementDefaults::Process);
+      compositeWeighted->setAttribute("a_position", screenTrianglesCoords());
+      // clang-format on
+    }
+    compositeWeighted->setTextureFromBuffer("t_accum", sceneWeightedAccum.get());
+    compositeWeighted->setTextureFromBuffer("t_revealage", sceneWeightedRevealage.get());
+  } else if (!needWeighted && renderTargetBudget) {
+    sceneBufferWeighted.reset();
+    sceneWeightedAccum.reset();
+    sceneWeightedRevealage.reset();
+  }
+
+  // The "final" scene buffer (after resolving) is only a copy of the scene buffer, except that depth peeling composites
+  // its layers in to it. On a budget the two share storage otherwise.
+  bool separateFinal = !renderTargetBudget || transparencyMode == TransparencyMode::Pretty;
+  bool haveSeparateFinal = sceneBufferFinal && sceneBufferFinal != sceneBuffer;
+  if (separateFinal && !haveSeparateFinal) {
+    sceneColorFinal = generateTextureBuffer(TextureFormat::RGBA16F, sceneWidth, sceneHeight);
+    sceneBufferFinal = generateFrameBuffer(sceneWidth, sceneHeight);
+    sceneBufferFinal->addColorBuffer(sceneColorFinal);
+    sceneBufferFinal->setDrawBuffers();
+    sceneBufferFinal->clearColor = glm::vec3{1., 1., 1.};
+    sceneBufferFinal->clearAlpha = 0.0;
+    sceneBufferFinal->setViewport(0, 0, sceneWidth, sceneHeight);
+  } else if (!separateFinal && haveSeparateFinal) {
+    sceneColorFinal = sceneColor;
+    sceneBufferFinal = sceneBuffer;
+  }
+  if (taaResolve) taaResolve->setTextureFromBuffer("t_current", sceneColorFinal.get());
+
+  // The temporal anti-aliasing history
+  if (!enableTAA && renderTargetBudget) {
+    for (int i = 0; i < 2; i++) {
+      taaHistoryBuffer[i].reset();
+      taaHistoryColor[i].reset();
+    }
+    taaHistorySamples = 0;
+  }
+}
+
+bool Engine::bindSceneBufferWeighted() {
+  setCurrentPixelScaling(getSceneBufferScale());
+  return sceneBufferWeighted->bindForRendering();
 }
 
 bool Engine::bindSceneBuffer() {
-  setCurrentPixelScaling(ssaaFactor);
+  setCurrentPixelScaling(getSceneBufferScale());
   return sceneBuffer->bindForRendering();
 }
 
@@ -493,18 +991,28 @@ void Engine::applyLightingTransform(std::shared_ptr<TextureBuffer>& texture) {
   // compute downsampling rate
   float sampleX = texture->getSizeX() / currV[2];
   float sampleY = texture->getSizeY() / currV[3];
-  if (sampleX != sampleY) exception("lighting downsampling should have same aspect");
   int sampleLevel;
+  bool integerRatio = sampleX == sampleY && sampleX == static_cast<int>(sampleX) && sampleX <= 4;
   if (sampleX < 1.) {
+    // a reduced resolution scene (see setSceneResolutionScale()), upsampled. Its size is rounded, so the aspect may
+    // differ slightly.
+    sampleLevel = 1;
+  } else if (!integerRatio && view::getCurrentViewportRegion() != glm::vec4{0., 0., 1., 1.}) {
+    // a whole scene render shown in a region of the window (see view::addViewport()), resampled
     sampleLevel = 1;
   } else {
+    if (sampleX != sampleY) exception("lighting downsampling should have same aspect");
     if (sampleX != static_cast<int>(sampleX)) exception("lighting downsampling should have integer ratio");
     sampleLevel = static_cast<int>(sampleX);
     if (sampleLevel > 4) exception("lighting downsampling only implemented up to 4x");
   }
 
+  // FXAA filters output pixels, it is not needed on top of downsampling
+  bool useFXAA = enableFXAA && sampleLevel == 1;
+
   // == Lazily regnerate the mapper if it doesn't match the current settings
-  if (!mapLight || currLightingSampleLevel != sampleLevel || currLightingTransparencyMode != transparencyMode) {
+  if (!mapLight || currLightingSampleLevel != sampleLevel || currLightingTransparencyMode != transparencyMode ||
+      currLightingFXAA != useFXAA) {
 
     std::string sampleRuleName = "";
     if (sampleLevel == 1) sampleRuleName = "DOWNSAMPLE_RESOLVE_1";
@@ -522,12 +1030,17 @@ void Engine::applyLightingTransform(std::shared_ptr<TextureBuffer>& texture) {
       break;
     case TransparencyMode::Pretty:
       break;
+    case TransparencyMode::WeightedBlended:
+      break;
     }
 
+    if (useFXAA) resolveRules.push_back("RESOLVE_FXAA");
+
     mapLight = render::engine->requestShader("MAP_LIGHT", resolveRules, render::ShaderReplacementDefaults::Process);
     mapLight->setAttribute("a_position", screenTrianglesCoords());
     currLightingSampleLevel = sampleLevel;
     currLightingTransparencyMode = transparencyMode;
+    currLightingFXAA = useFXAA;
   }
 
   mapLight->setUniform("u_bgColor", glm::vec3{view::bgColor[0], view::bgColor[1], view::bgColor[2]});
@@ -551,6 +1064,11 @@ void Engine::setTonemapUniforms(ShaderProgram& p) {
 
 void Engine::setMaterial(ShaderProgram& program, const std::string& mat) {
   const Material& m = getMaterial(mat);
+  if (m.arrayLayers[0] != -1) {
+    program.setTextureFromBuffer("t_matArray", materialTextureArray.get());
+    setMaterialUniforms(program, mat);
+    return;
+  }
   if (m.textureBuffers[0]) program.setTextureFromBuffer("t_mat_r", m.textureBuffers[0].get());
   if (m.textureBuffers[1]) program.setTextureFromBuffer("t_mat_g", m.textureBuffers[1].get());
   if (m.textureBuffers[2]) program.setTextureFromBuffer("t_mat_b", m.textureBuffers[2].get());
@@ -559,11 +1077,26 @@ void Engine::setMaterial(ShaderProgram& program, const std::string& mat) {
 
 void Engine::setMaterialUniforms(ShaderProgram& program, const std::string& mat) {
   const Material& m = getMaterial(mat);
+  if (m.arrayLayers[0] != -1) {
+    // texture coordinates of the layer centers, where the linear filtering of the array does not mix in other layers
+    glm::vec4 layerCoords;
+    for (int i = 0; i < 4; i++) {
+      layerCoords[i] = (m.arrayLayers[i] + 0.5f) / static_cast<float>(materialTextureArray->getSizeZ());
+    }
+    program.setUniform("u_matLayers", layerCoords);
+  }
   if (m.setUniforms) {
     m.setUniforms(program);
   }
 }
 
+bool Engine::materialChangeNeedsRefresh(const std::string& oldMat, const std::string& newMat) {
+  if (oldMat == newMat) return false;
+  const Material& oldM = getMaterial(oldMat);
+  const Material& newM = getMaterial(newMat);
+  return oldM.arrayLayers[0] == -1 || newM.arrayLayers[0] == -1;
+}
+
 void Engine::renderBackground() {
   switch (background) {
   case BackgroundView::None:
@@ -602,9 +1135,16 @@ void Engine::setTransparencyMode(TransparencyMode newMode) {
         defaultRules_sceneObject.end());
     break;
   }
+  case TransparencyMode::WeightedBlended: {
+    defaultRules_sceneObject.erase(std::remove(defaultRules_sceneObject.begin(), defaultRules_sceneObject.end(),
+                                               "TRANSPARENCY_WEIGHTED_STRUCTURE"),
+                                   defaultRules_sceneObject.end());
+    break;
+  }
   }
 
   transparencyMode = newMode;
+  updateSceneBufferAllocation(); // before the programs which use the buffers are regenerated below
 
   // Add a new rule for this setting
   switch (newMode) {
@@ -619,14 +1159,40 @@ void Engine::setTransparencyMode(TransparencyMode newMode) {
     defaultRules_sceneObject.push_back("TRANSPARENCY_PEEL_STRUCTURE");
     break;
   }
+  case TransparencyMode::WeightedBlended: {
+    defaultRules_sceneObject.push_back("TRANSPARENCY_WEIGHTED_STRUCTURE");
+    break;
+  }
   }
 
-  // Regenerate _all_ the things
-  refresh();
+  // Regenerate the programs, which all use the rules above
+  refreshShaderPrograms();
 }
 
 TransparencyMode Engine::getTransparencyMode() { return transparencyMode; }
 
+void Engine::setDepthPrepass(bool newVal) {
+  if (newVal == depthPrepass) return;
+
+  defaultRules_sceneObject.erase(
+      std::remove(defaultRules_sceneObject.begin(), defaultRules_sceneObject.end(), "DEPTH_PREPASS_STRUCTURE"),
+      defaultRules_sceneObject.end());
+  if (newVal) {
+    defaultRules_sceneObject.push_back("DEPTH_PREPASS_STRUCTURE");
+  }
+
+  depthPrepass = newVal;
+  updateSceneBufferAllocation();
+  refreshShaderPrograms();
+}
+
+bool Engine::getDepthPrepass() { return depthPrepass; }
+
+bool Engine::depthPrepassActive() {
+  return depthPrepass && transparencyMode != TransparencyMode::Pretty &&
+         transparencyMode != TransparencyMode::WeightedBlended;
+}
+
 bool Engine::transparencyEnabled() {
   switch (transparencyMode) {
   case TransparencyMode::None:
@@ -635,6 +1201,8 @@ bool Engine::transparencyEnabled() {
     return true;
   case TransparencyMode::Pretty:
     return true;
+  case TransparencyMode::WeightedBlended:
+    return true;
   }
   return false;
 }
@@ -649,6 +1217,136 @@ bool Engine::getFrontFaceCCW() { return frontFaceCCW; }
 
 int Engine::getSSAAFactor() { return ssaaFactor; }
 
+void Engine::setSceneResolutionScale(float newVal) {
+  newVal = std::min(std::max(newVal, 0.05f), 1.f);
+  if (newVal == sceneResolutionScale) return;
+  sceneResolutionScale = newVal;
+  updateWindowSize(true);
+}
+
+float Engine::getSceneResolutionScale() { return sceneResolutionScale; }
+
+float Engine::getSceneBufferScale() { return ssaaFactor * sceneResolutionScale; }
+
+namespace {
+
+// Element i >= 1 of the Halton low-discrepancy sequence in the given base, in [0, 1)
+float haltonSequence(unsigned int i, unsigned int base) {
+  float f = 1.;
+  float r = 0.;
+  while (i > 0) {
+    f /= base;
+    r += f * (i % base);
+    i /= base;
+  }
+  return r;
+}
+
+} // namespace
+
+void Engine::setTemporalAntiAliasing(bool newVal) {
+  enableTAA = newVal;
+  if (enableTAA) allocateTemporalAntiAliasingBuffers();
+  updateSceneBufferAllocation();
+  taaHistorySamples = 0;
+  requestRedraw();
+}
+
+bool Engine::getTemporalAntiAliasing() { return enableTAA; }
+
+void Engine::setFXAA(bool newVal) {
+  enableFXAA = newVal;
+  requestRedraw();
+}
+
+bool Engine::getFXAA() { return enableFXAA; }
+
+void Engine::allocateTemporalAntiAliasingBuffers() {
+  if (taaHistoryBuffer[0]) return;
+
+  unsigned int sceneWidth = scaledSceneBufferSize(view::bufferWidth);
+  unsigned int sceneHeight = scaledSceneBufferSize(view::bufferHeight);
+  for (int i = 0; i < 2; i++) {
+    taaHistoryColor[i] = generateTextureBuffer(TextureFormat::RGBA16F, sceneWidth, sceneHeight);
+    taaHistoryBuffer[i] = generateFrameBuffer(sceneWidth, sceneHeight);
+    taaHistoryBuffer[i]->addColorBuffer(taaHistoryColor[i]);
+    taaHistoryBuffer[i]->setDrawBuffers();
+    taaHistoryBuffer[i]->setViewport(0, 0, sceneWidth, sceneHeight);
+  }
+
+  if (!taaResolve) {
+    taaResolve = requestShader("TAA_RESOLVE", {}, ShaderReplacementDefaults::Process);
+    taaResolve->setAttribute("a_position", screenTrianglesCoords());
+  }
+  taaResolve->setTextureFromBuffer("t_current", sceneColorFinal.get());
+}
+
+void Engine::beginTemporalAntiAliasingFrame(bool sceneChanged) {
+  if (!enableTAA) return;
+
+  taaSceneChanged = sceneChanged;
+  taaFrameIndex++;
+
+  // Cycle through the jitter positions, each a sub-pixel offset from the pixel center
+  unsigned int nSamples = std::max(options::temporalAntiAliasingSamples, 1);
+  unsigned int iSample = taaFrameIndex % nSamples + 1;
+  glm::vec2 offset{haltonSequence(iSample, 2) - 0.5, haltonSequence(iSample, 3) - 0.5};
+  glm::vec2 sceneSize{sceneColorFinal->getSizeX(), sceneColorFinal->getSizeY()};
+  view::projectionJitter = 2.f * offset / sceneSize;
+}
+
+void Engine::resolveTemporalAntiAliasing() {
+  view::projectionJitter = glm::vec2{0., 0.};
+  if (!enableTAA) return;
+
+  // Choose how much of the new render goes in to the result. While the scene is still, every render gets the same
+  // weight, so the result converges to their average. After a change, the history is clamped to the colors around each
+  // pixel of the new render to reject stale content, and blended with a small fixed weight.
+  float blend = 1.;
+  int clampHistory = 0;
+  if (taaHistorySamples == 0) {
+    taaHistorySamples = 1;
+  } else if (taaSceneChanged) {
+    blend = 0.1;
+    clampHistory = 1;
+    taaHistorySamples = 1;
+  } else {
+    taaHistorySamples++;
+    blend = 1. / taaHistorySamples;
+  }
+
+  // Reprojection goes through the depth of the new render. With depth peeling that is the last peeled layer.
+  glm::mat4 viewProj = view::getCameraPerspectiveMatrix() * view::getCameraViewMatrix();
+  glm::mat4 invViewProj = glm::inverse(viewProj);
+  TextureBuffer* depth = transparencyMode == TransparencyMode::Pretty ? sceneDepthMin.get() : sceneDepth.get();
+
+  int iPrev = taaHistoryIndex;
+  int iNext = 1 - taaHistoryIndex;
+  taaResolve->setTextureFromBuffer("t_history", taaHistoryColor[iPrev].get());
+  taaResolve->setTextureFromBuffer("t_depth", depth);
+  taaResolve->setUniform("u_currInvViewProj", glm::value_ptr(invViewProj));
+  taaResolve->setUniform("u_prevViewProj", glm::value_ptr(taaPrevViewProj));
+  taaResolve->setUniform("u_texelSize",
+                         glm::vec2{1. / sceneColorFinal->getSizeX(), 1. / sceneColorFinal->getSizeY()});
+  taaResolve->setUniform("u_blend", blend);
+  taaResolve->setUniform("u_clampHistory", clampHistory);
+
+  taaHistoryBuffer[iNext]->bindForRendering();
+  setBlendMode(BlendMode::Disable);
+  setDepthMode(DepthMode::Disable);
+  taaResolve->draw();
+
+  // The lighting transform, screenshots etc all read the final scene buffer
+  taaHistoryBuffer[iNext]->blitTo(sceneBufferFinal.get());
+
+  taaHistoryIndex = iNext;
+  taaPrevViewProj = viewProj;
+}
+
+bool Engine::temporalAntiAliasingPending() {
+  return enableTAA && taaHistorySamples < options::temporalAntiAliasingSamples;
+}
+
 void Engine::allocateGlobalBuffersAndPrograms() {
 
   // Note: The display frame buffer should be manually wrapped by child classes
@@ -669,24 +1367,8 @@ void Engine::allocateGlobalBuffersAndPrograms() {
     sceneBuffer->clearAlpha = 0.0;
   }
 
-  { // Alternate depth texture used for some effects
-    sceneDepthMin = generateTextureBuffer(TextureFormat::DEPTH24, view::bufferWidth, view::bufferHeight);
-
-    sceneDepthMinFrame = generateFrameBuffer(view::bufferWidth, view::bufferHeight);
-    sceneDepthMinFrame->addDepthBuffer(sceneDepthMin);
-    sceneDepthMinFrame->clearDepth = 0.0;
-  }
-
-  { // "Final" scene buffer (after resolving)
-    sceneColorFinal = generateTextureBuffer(TextureFormat::RGBA16F, view::bufferWidth, view::bufferHeight);
-
-    sceneBufferFinal = generateFrameBuffer(view::bufferWidth, view::bufferHeight);
-    sceneBufferFinal->addColorBuffer(sceneColorFinal);
-    sceneBufferFinal->setDrawBuffers();
-
-    sceneBufferFinal->clearColor = glm::vec3{1., 1., 1.};
-    sceneBufferFinal->clearAlpha = 0.0;
-  }
+  // The depth-min buffer of depth peeling, the accumulation buffers of weighted blended transparency and the final
+  // scene buffer are allocated as needed, see updateSceneBufferAllocation()
 
   { // Alternate display buffer
     std::shared_ptr<RenderBuffer> sceneColorAlt =
@@ -704,48 +1386,169 @@ void Engine::allocateGlobalBuffersAndPrograms() {
   }
 
   { // Pick buffer
-    pickColorBuffer = generateRenderBuffer(RenderBufferType::Float4, view::bufferWidth, view::bufferHeight);
+    pickColorBuffer = generateRenderBuffer(RenderBufferType::UInt2, view::bufferWidth, view::bufferHeight);
     pickDepthBuffer = generateRenderBuffer(RenderBufferType::Depth, view::bufferWidth, view::bufferHeight);
 
     pickFramebuffer = generateFrameBuffer(view::bufferWidth, view::bufferHeight);
     pickFramebuffer->addColorBuffer(pickColorBuffer);
     pickFramebuffer->addDepthBuffer(pickDepthBuffer);
+    pickFramebuffer->firstDrawBufferLocation = 1; // the pick shaders write the integer index to location 1
     pickFramebuffer->setDrawBuffers();
   }
 
   // Make sure all the buffer sizes are up to date
   updateWindowSize(true);
 
-  { // Generate the general-use programs
-    // clang-format off
-    renderTexturePlain = render::engine->requestShader("TEXTURE_DRAW_PLAIN", {}, render::ShaderReplacementDefaults::Process);
-    renderTexturePlain->setAttribute("a_position", screenTrianglesCoords());
+  // The general-use programs of the transparency modes are compiled along with their buffers, as needed, see
+  // updateSceneBufferAllocation()
+  updateSceneBufferAllocation();
 
-    renderTextureDot3 = render::engine->requestShader("TEXTURE_DRAW_DOT3", {}, render::ShaderReplacementDefaults::Process);
-    renderTextureDot3->setAttribute("a_position", screenTrianglesCoords());
+  { // Load defaults
+    loadDefaultMaterials();
+    loadDefaultColorMaps();
+  }
+}
 
-    renderTextureMap3 = render::engine->requestShader("TEXTURE_DRAW_MAP3", {}, render::ShaderReplacementDefaults::Process);
-    renderTextureMap3->setAttribute("a_position", screenTrianglesCoords());
+void Engine::updateFrameUniforms() {
+  glm::mat4 projMat = view::getCameraPerspectiveMatrix();
+  if (frameUniformDataValid && projMat == frameUniformData.projMatrix) return; // nothing changed
 
-    renderTextureSphereBG = render::engine->requestShader("TEXTURE_DRAW_SPHEREBG", {}, render::ShaderReplacementDefaults::Process);
-    renderTextureSphereBG->setAttribute("a_position", distantCubeCoords());
+  frameUniformData.projMatrix = projMat;
+  frameUniformData.invProjMatrix = glm::inverse(projMat);
+  frameUniformDataValid = true;
+  uploadFrameUniforms();
+}
 
-    compositePeel = render::engine->requestShader("COMPOSITE_PEEL", {}, render::ShaderReplacementDefaults::Process);
-    compositePeel->setAttribute("a_position", screenTrianglesCoords());
-    compositePeel->setTextureFromBuffer("t_image", sceneColor.get());
+void Engine::uploadFrameUniforms() {} // backends which use the uniform block override this
 
-    copyDepth = render::engine->requestShader("DEPTH_COPY", {}, render::ShaderReplacementDefaults::Process);
-    copyDepth->setAttribute("a_position", screenTrianglesCoords());
-    copyDepth->setTextureFromBuffer("t_depth", sceneDepth.get());
-    // clang-format on
+bool Engine::gatherAttributeBufferOnDevice(AttributeBuffer& src, AttributeBuffer& indices, AttributeBuffer& dst) {
+  return false; // not supported by default, backends which can do it override this
+}
+
+bool Engine::computeMeshNormalsOnDevice(AttributeBuffer& positions, AttributeBuffer& faceStart,
+                                        AttributeBuffer& faceVerts, AttributeBuffer& vertexFaceStart,
+                                        AttributeBuffer& vertexFaces, AttributeBuffer* faceNormals,
+                                        AttributeBuffer* vertexNormals) {
+  return false; // not supported by default, backends which can do it override this
+}
+
+bool Engine::computeFiniteRangeOnDevice(AttributeBuffer& values, std::pair<double, double>& range) {
+  return false; // not supported by default, backends which can do it override this
+}
+
+bool Engine::computeFiniteRangeOnDevice(TextureBuffer& values, std::pair<double, double>& range) {
+  return false; // not supported by default, backends which can do it override this
+}
+
+bool Engine::computeHistogramOnDevice(AttributeBuffer& values, std::pair<double, double> range, size_t nBins,
+                                      std::vector<double>& binCounts) {
+  return false; // not supported by default, backends which can do it override this
+}
+
+bool Engine::computeHistogramOnDevice(TextureBuffer& values, std::pair<double, double> range, size_t nBins,
+                                      std::vector<double>& binCounts) {
+  return false; // not supported by default, backends which can do it override this
+}
+
+uint32_t Engine::getMaxTextureSize3D() { return 256; }
+
+bool Engine::beginSamplesPassedQuery() {
+  return false; // not supported by default, backends which can do it override this
+}
+
+size_t Engine::endSamplesPassedQuery() { return 0; }
+
+uint64_t Engine::recordGPUTimestamp() {
+  return 0; // not supported by default, backends which can do it override this
+}
+
+bool Engine::pollGPUTimestamp(uint64_t ticket, uint64_t& nanoseconds) { return false; }
+
+void Engine::discardGPUTimestamp(uint64_t ticket) {}
+
+void Engine::prewarmShaders(const std::vector<ShaderProgramRequest>& programs) {
+  for (const ShaderProgramRequest& p : programs) {
+    requestShader(p.programName, p.customRules, p.defaults);
   }
+}
 
-  { // Load defaults
-    loadDefaultMaterials();
-    loadDefaultColorMaps();
+bool Engine::shaderCompilesPending() { return false; }
+
+namespace {
+
+// One variant per line, as tab-separated fields: the defaults, the program name, then each rule
+std::string shaderVariantTablePath() {
+  std::string dir = options::shaderCacheDirectory;
+  if (dir.back() != '/' && dir.back() != '\\') dir += '/';
+  return dir + "polyscope_shader_variants.txt";
+}
+
+std::string shaderVariantTableLine(const std::string& programName, const std::vector<std::string>& customRules,
+                                   ShaderReplacementDefaults defaults) {
+  std::string line = std::to_string(static_cast<int>(defaults)) + "\t" + programName;
+  for (const std::string& rule : customRules) line += "\t" + rule;
+  return line;
+}
+
+} // namespace
+
+std::vector<ShaderProgramRequest> Engine::loadShaderVariantTable() {
+  std::vector<ShaderProgramRequest> variants;
+  if (options::shaderCacheDirectory.empty()) return variants;
+
+  std::ifstream inFile(shaderVariantTablePath());
+  std::string line;
+  while (std::getline(inFile, line)) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+      size_t end = line.find('\t', start);
+      fields.push_back(line.substr(start, end == std::string::npos ? std::string::npos : end - start));
+      if (end == std::string::npos) break;
+      start = end + 1;
+    }
+    if (fields.size() < 2 || fields[0].size() != 1 || fields[0][0] < '0' ||
+        fields[0][0] > '0' + static_cast<int>(ShaderReplacementDefaults::None)) {
+      continue; // not a line we wrote
+    }
+
+    ShaderReplacementDefaults defaults = static_cast<ShaderReplacementDefaults>(fields[0][0] - '0');
+    std::vector<std::string> rules(fields.begin() + 2, fields.end());
+    variants.emplace_back(fields[1], rules, defaults);
+    shaderVariantTableEntries.insert(line);
+  }
+  shaderVariantTableLoaded = true;
+
+  return variants;
+}
+
+void Engine::prewarmShaderVariantTable() {
+  std::vector<ShaderProgramRequest> variants;
+  for (const ShaderProgramRequest& v : loadShaderVariantTable()) {
+    if (shaderVariantAvailable(v)) variants.push_back(v);
   }
+  if (options::verbosity > 2 && !variants.empty()) {
+    info("prewarming " + std::to_string(variants.size()) + " recorded shader variants");
+  }
+  prewarmShaders(variants);
+}
+
+void Engine::recordShaderVariant(const std::string& programName, const std::vector<std::string>& customRules,
+                                 ShaderReplacementDefaults defaults) {
+  if (options::shaderCacheDirectory.empty()) return;
+  if (!shaderVariantTableLoaded) loadShaderVariantTable();
+
+  std::string line = shaderVariantTableLine(programName, customRules, defaults);
+  if (line.find('\n') != std::string::npos) return; // can't be stored, rules are never named like this anyway
+  if (!shaderVariantTableEntries.insert(line).second) return;
+
+  std::ofstream outFile(shaderVariantTablePath(), std::ios::app);
+  outFile << line << "\n";
+  if (!outFile && options::verbosity > 2) info("could not write shader variant table " + shaderVariantTablePath());
 }
 
+bool Engine::shaderVariantAvailable(const ShaderProgramRequest& request) { return true; }
+
 uint64_t Engine::getNextUniqueID() {
   uint64_t thisID = uniqueID;
   uniqueID++;
@@ -765,48 +1568,43 @@ void Engine::popBindFramebufferForRendering() {
   renderFramebufferStack.pop_back();
 }
 
-void Engine::addSlicePlane(std::string uniquePostfix) {
-
-  // NOTE: Unfortunately, the logic here and in slice_plane.cpp depends on the names constructed from the postfix being
-  // identical.
-
-  createSlicePlaneFliterRule(uniquePostfix);
+void Engine::addSlicePlane() {
+  if (slicePlaneCount >= maxSlicePlanes) {
+    exception("at most " + std::to_string(maxSlicePlanes) + " slice planes are supported");
+  }
   slicePlaneCount++;
 
-  // Add rules
-  std::vector<std::string> newRules{"SLICE_PLANE_CULL_" + uniquePostfix,
-                                    "SLICE_PLANE_VOLUMEGRID_CULL_" + uniquePostfix};
+  // The planes are all handled by the same rules and uniforms, so only the first one needs new programs
+  if (slicePlaneCount == 1) {
+    std::vector<std::string> newRules{"SLICE_PLANE_CULL", "SLICE_PLANE_VOLUMEGRID_CULL"};
+    defaultRules_sceneObject.insert(defaultRules_sceneObject.end(), newRules.begin(), newRules.end());
+    defaultRules_pick.insert(defaultRules_pick.end(), newRules.begin(), newRules.end());
 
-  defaultRules_sceneObject.insert(defaultRules_sceneObject.end(), newRules.begin(), newRules.end());
-  defaultRules_pick.insert(defaultRules_pick.end(), newRules.begin(), newRules.end());
-
-  // Regenerate everything
-  polyscope::refresh();
+    // Regenerate the programs, the structures also choose their own rules based on whether planes are present
+    polyscope::refreshShaderPrograms();
+  } else {
+    polyscope::requestRedraw();
+  }
 }
 
-void Engine::removeSlicePlane(std::string uniquePostfix) {
-
+void Engine::removeSlicePlane() {
   slicePlaneCount--;
-  // Remove the (last occurence of the) rules we added
-  std::vector<std::string> newRules{"SLICE_PLANE_CULL_" + uniquePostfix,
-                                    "SLICE_PLANE_VOLUMEGRID_CULL_" + uniquePostfix};
-  auto deleteLast = [&](std::vector<std::string>& vec, std::string target) {
-    for (size_t i = vec.size(); i > 0; i--) {
-      if (vec[i - 1] == target) {
-        vec.erase(vec.begin() + (i - 1));
-        return;
-      }
-    }
-  };
-  for (std::string r : newRules) {
-    deleteLast(defaultRules_sceneObject, r);
-    deleteLast(defaultRules_pick, r);
-  }
 
-  // Don't bother undoing the createRule(), since it doesn't really hurt to leave it around
+  if (slicePlaneCount == 0) {
+    std::vector<std::string> newRules{"SLICE_PLANE_CULL", "SLICE_PLANE_VOLUMEGRID_CULL"};
+    auto deleteRule = [&](std::vector<std::string>& vec, std::string target) {
+      vec.erase(std::remove(vec.begin(), vec.end(), target), vec.end());
+    };
+    for (std::string r : newRules) {
+      deleteRule(defaultRules_sceneObject, r);
+      deleteRule(defaultRules_pick, r);
+    }
 
-  // Regenerate everything
-  polyscope::refresh();
+    // Regenerate the programs, the structures also choose their own rules based on whether planes are present
+    polyscope::refreshShaderPrograms();
+  } else {
+    polyscope::requestRedraw();
+  }
 }
 
 bool Engine::slicePlanesEnabled() { return slicePlaneCount > 0; }
@@ -872,6 +1670,12 @@ void Engine::updateMinDepthTexture() {
   copyDepth->draw();
 }
 
+void Engine::updatePrepassDepthTexture() {
+  setDepthMode(DepthMode::Less); // depth writes must be enabled for the clear
+  sceneDepthPrepassFrame->clear();
+  copyDepth->draw();
+}
+
 
 // Helper (TODO rework to load custom materials)
 void Engine::loadDefaultMaterial(std::string name) {
@@ -931,15 +1735,44 @@ void Engine::loadDefaultMaterial(std::string name) {
   }
   // clang-format on
 
-  for (int i = 0; i < 4; i++) {
-    if (buff[i]) {
+  // The matcaps get layers of the shared material array, so that the programs of all of them are the same. Single-color
+  // materials use the same image for all components, which only needs one layer.
+  if (buff[0]) {
+    newMaterial->rules = {"LIGHT_MATCAP_ARRAY"};
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < i; j++) {
+        if (buff[j] == buff[i]) newMaterial->arrayLayers[i] = newMaterial->arrayLayers[j];
+      }
+      if (newMaterial->arrayLayers[i] == -1) newMaterial->arrayLayers[i] = nMaterialArrayLayers++;
+    }
+  }
+
+  // Decoding the images is the expensive part, and most sessions only use a few of the materials, so defer it to the
+  // first use. The buffers are static data, safe to hold on to.
+  newMaterial->loadTextures = [this, newMaterial, buff, buffSize]() {
+    for (int i = 0; i < 4; i++) {
+      if (!buff[i]) continue;
+
+      // only decode and upload each image once
+      bool isRepeat = false;
+      for (int j = 0; j < i; j++) {
+        if (buff[j] == buff[i]) isRepeat = true;
+      }
+      if (isRepeat) continue;
+
       int width, height, nComp;
       float* data = stbi_loadf_from_memory(buff[i], buffSize[i], &width, &height, &nComp, 3);
       if (!data) exception("failed to load material");
-      newMaterial->textureBuffers[i] = loadMaterialTexture(data, width, height);
+      if (width != static_cast<int>(materialTextureArray->getSizeX()) ||
+          height != static_cast<int>(materialTextureArray->getSizeY())) {
+        stbi_image_free(data);
+        exception("built-in material " + newMaterial->name + " does not match the material array resolution");
+      }
+      materialTextureArray->setDataBox(data, 3, PixelComponentType::Float32, 0, 0, newMaterial->arrayLayers[i], width,
+                                       height, 1);
       stbi_image_free(data);
     }
-  }
+  };
 
   materials.emplace_back(newMaterial);
 }
@@ -988,17 +1821,18 @@ void Engine::loadStaticMaterial(std::string matName, std::string filename) {
   newMaterial->rules = {"LIGHT_MATCAP"};
   materials.emplace_back(newMaterial);
 
-  // Load each of the four components
+  // The same image is used for all four components
+  int width, height, nComp;
+  float* data = stbi_loadf(filename.c_str(), &width, &height, &nComp, 3);
+  if (!data) {
+    polyscope::warning("failed to load material from " + filename);
+    materials.pop_back();
+    return;
+  }
+  std::shared_ptr<TextureBuffer> texture = loadMaterialTexture(data, width, height);
+  stbi_image_free(data);
   for (int i = 0; i < 4; i++) {
-    int width, height, nComp;
-    float* data = stbi_loadf(filename.c_str(), &width, &height, &nComp, 3);
-    if (!data) {
-      polyscope::warning("failed to load material from " + filename);
-      materials.pop_back();
-      return;
-    }
-    newMaterial->textureBuffers[i] = loadMaterialTexture(data, width, height);
-    stbi_image_free(data);
+    newMaterial->textureBuffers[i] = texture;
   }
 }
 
@@ -1010,7 +1844,8 @@ void Engine::loadBlendableMaterial(std::string matName, std::string filenameBase
 }
 
 std::shared_ptr<TextureBuffer> Engine::loadMaterialTexture(float* data, int width, int height) {
-  std::shared_ptr<TextureBuffer> t = engine->generateTextureBuffer(TextureFormat::RGB16F, width, height, data);
+  // shared-exponent storage keeps the HDR range of the matcaps at 4 bytes per texel
+  std::shared_ptr<TextureBuffer> t = engine->generateTextureBuffer(TextureFormat::RGB9E5, width, height, data);
   t->setFilterMode(FilterMode::Linear);
   return t;
 }
@@ -1024,12 +1859,25 @@ void Engine::loadDefaultMaterials() {
   loadDefaultMaterial("ceramic");
   loadDefaultMaterial("jade");
   loadDefaultMaterial("normal");
+
+  // All of the built-in matcaps are 256x256. The layers are filled as each material is first used.
+  const unsigned int materialArrayResolution = 256;
+  materialTextureArray = generateTextureBuffer(TextureFormat::RGB9E5, materialArrayResolution, materialArrayResolution,
+                                               static_cast<unsigned int>(nMaterialArrayLayers));
+  materialTextureArray->setFilterMode(FilterMode::Linear);
 }
 
 
 Material& Engine::getMaterial(const std::string& name) {
   for (std::unique_ptr<Material>& m : materials) {
-    if (name == m->name) return *m;
+    if (name == m->name) {
+      if (m->loadTextures) {
+        std::function<void()> loadTextures = m->loadTextures;
+        m->loadTextures = nullptr;
+        loadTextures();
+      }
+      return *m;
+    }
   }
 
   exception("unrecognized material name: " + name);
@@ -1081,6 +1929,10 @@ void Engine::loadColorMap(std::string cmapName, std::string filename) {
   newMap->name = cmapName;
   newMap->values = vals;
   colorMaps.emplace_back(newMap);
+
+  if (colorMapAtlas) {
+    getColorMapAtlas(); // add the new row for existing programs
+  }
 }
 
 const ValueColorMap& Engine::getColorMap(const std::string& name) {
@@ -1092,19 +1944,75 @@ const ValueColorMap& Engine::getColorMap(const std::string& name) {
   return *colorMaps[0];
 }
 
+TextureBuffer& Engine::getColorMapAtlas() {
+  if (colorMapAtlas && colorMapAtlasRows == colorMaps.size()) {
+    return *colorMapAtlas;
+  }
 
-void Engine::configureImGui() {
+  // Every row gets the length of the longest color map. Shorter ones are resampled such that linear filtering across
+  // the row gives the same colors as it would on a 1D texture of just that color map.
+  size_t width = 1;
+  for (auto& cmap : colorMaps) {
+    width = std::max(width, cmap->values.size());
+  }
+  size_t height = std::max(colorMaps.size(), static_cast<size_t>(1));
+
+  std::vector<glm::vec3> texels(width * height, glm::vec3{0., 0., 0.});
+  for (size_t iRow = 0; iRow < colorMaps.size(); iRow++) {
+    const std::vector<glm::vec3>& vals = colorMaps[iRow]->values;
+    if (vals.empty()) continue;
+    for (size_t iCol = 0; iCol < width; iCol++) {
+      double pos = (iCol + 0.5) / width * vals.size() - 0.5; // in texels of the color map
+      pos = glm::clamp(pos, 0., static_cast<double>(vals.size() - 1));
+      size_t iLower = static_cast<size_t>(pos);
+      size_t iUpper = std::min(iLower + 1, vals.size() - 1);
+      float t = static_cast<float>(pos - iLower);
+      texels[iRow * width + iCol] = (1.f - t) * vals[iLower] + t * vals[iUpper];
+    }
+  }
 
-  if (options::prepareImGuiFontsCallback) {
-    std::tie(globalFontAtlas, regularFont, monoFont) = options::prepareImGuiFontsCallback();
+  if (colorMapAtlas) {
+    // update in place, programs hold on to this texture
+    colorMapAtlas->resize(width, height);
+    colorMapAtlas->setData(texels);
+  } else {
+    colorMapAtlas = generateTextureBuffer(TextureFormat::RGB32F, width, height, &texels.front().x);
+    colorMapAtlas->setFilterMode(FilterMode::Linear);
+  }
+  colorMapAtlasRows = colorMaps.size();
+
+  return *colorMapAtlas;
+}
+
+int Engine::getColorMapAtlasRow(const std::string& name) {
+  for (size_t i = 0; i < colorMaps.size(); i++) {
+    if (name == colorMaps[i]->name) return static_cast<int>(i);
   }
 
+  exception("unrecognized colormap name: " + name);
+  return 0;
+}
+
+
+void Engine::configureImGui() {
+
+  // the fonts are prepared by ensureImGuiFontsPrepared(), once the GUI is first drawn
 
   if (options::configureImGuiStyleCallback) {
     options::configureImGuiStyleCallback();
   }
 }
 
+void Engine::ensureImGuiFontsPrepared() {
+  if (imguiFontsPrepared) return;
+  imguiFontsPrepared = true;
+
+  StartupPhase phase("GUI fonts");
+  if (options::prepareImGuiFontsCallback) {
+    std::tie(globalFontAtlas, regularFont, monoFont) = options::prepareImGuiFontsCallback();
+  }
+}
+
 void Engine::loadDefaultColorMap(std::string name) {
 
   const std::vector<glm::vec3>* buff = nullptr;
@@ -1166,7 +2074,10 @@ void Engine::showTextureInImGuiWindow(std::string windowName, TextureBuffer* buf
   ImGui::End();
 }
 
-ImFontAtlas* Engine::getImGuiGlobalFontAtlas() { return globalFontAtlas; }
+ImFontAtlas* Engine::getImGuiGlobalFontAtlas() {
+  ensureImGuiFontsPrepared();
+  return globalFontAtlas;
+}
 
 } // namespace render
 } // namespace polyscope
@@ -9,11 +9,17 @@
 #include "imgui.h"
 #include "stb_image.h"
 
+#include <algorithm>
+
 namespace polyscope {
 namespace render {
 
 // quick helper function
 namespace {
+
+const int reducedReflectionBlurIters = 2; // for GroundReflectionMode::ReducedMirror
+
+
 std::tuple<int, float> getGroundPlaneAxisAndSign() {
   int iP = 0;
   switch (view::upDir) {
@@ -66,6 +72,17 @@ void GroundPlane::populateGroundPlaneGeometry() {
 }
 
 void GroundPlane::prepare() {
+
+  // Release the buffers of the previous mode, the ones this mode needs are allocated again below
+  sceneAltColorTexture.reset();
+  sceneAltDepthTexture.reset();
+  sceneAltFrameBuffer.reset();
+  for (int i = 0; i < 2; i++) {
+    blurColorTextures[i].reset();
+    blurFrameBuffers[i].reset();
+  }
+  altSceneCacheValid = false;
+
   if (options::groundPlaneMode == GroundPlaneMode::None) {
     return;
   }
@@ -81,6 +98,9 @@ void GroundPlane::prepare() {
         render::engine->requestShader("GROUND_PLANE_TILE", rules, render::ShaderReplacementDefaults::Process);
     break;
   case GroundPlaneMode::TileReflection:
+    if (options::groundReflectionMode == GroundReflectionMode::ScreenSpace) {
+      rules.push_back("GROUND_REFLECT_SCREEN_SPACE");
+    }
     groundPlaneProgram =
         render::engine->requestShader("GROUND_PLANE_TILE_REFLECT", rules, render::ShaderReplacementDefaults::Process);
     break;
@@ -129,25 +149,31 @@ void GroundPlane::prepare() {
 
 
   if (options::groundPlaneMode == GroundPlaneMode::TileReflection) { // Mirrored scene buffer
-    groundPlaneProgram->setTextureFromBuffer("t_mirrorImage", sceneAltColorTexture.get());
+    switch (options::groundReflectionMode) {
+    case GroundReflectionMode::Mirror:
+      groundPlaneProgram->setTextureFromBuffer("t_mirrorImage", sceneAltColorTexture.get());
+      break;
+    case GroundReflectionMode::ReducedMirror:
+      // the mirrored scene is blurred, alpha included since it marks where the reflection is
+      prepareBlurBuffers();
+      blurProgram = render::engine->requestShader("BLUR_RGBA", {}, render::ShaderReplacementDefaults::Process);
+      blurProgram->setAttribute("a_position", render::engine->screenTrianglesCoords());
+      groundPlaneProgram->setTextureFromBuffer("t_mirrorImage", blurColorTextures[0].get());
+      break;
+    case GroundReflectionMode::ScreenSpace:
+      copySceneDepthProgram =
+          render::engine->requestShader("DEPTH_COPY", {}, render::ShaderReplacementDefaults::Process);
+      copySceneDepthProgram->setAttribute("a_position", render::engine->screenTrianglesCoords());
+      groundPlaneProgram->setTextureFromBuffer("t_mirrorImage", sceneAltColorTexture.get());
+      groundPlaneProgram->setTextureFromBuffer("t_mirrorDepth", sceneAltDepthTexture.get());
+      break;
+    }
   }
 
 
   if (options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
     // Blur buffers and program
-    for (int i = 0; i < 2; i++) {
-      blurColorTextures[i] =
-          render::engine->generateTextureBuffer(TextureFormat::RGBA16F, view::bufferWidth, view::bufferHeight);
-      blurColorTextures[i]->setFilterMode(FilterMode::Linear);
-      blurFrameBuffers[i] = render::engine->generateFrameBuffer(view::bufferWidth, view::bufferHeight);
-
-      blurFrameBuffers[i]->addColorBuffer(blurColorTextures[i]);
-      blurFrameBuffers[i]->setDrawBuffers();
-
-      blurFrameBuffers[i]->clearColor = glm::vec3{1., 1., 1.};
-      blurFrameBuffers[i]->clearAlpha = 0.0;
-    }
-
+    prepareBlurBuffers();
     blurProgram = render::engine->requestShader("BLUR_RGB", {}, render::ShaderReplacementDefaults::Process);
     blurProgram->setAttribute("a_position", render::engine->screenTrianglesCoords());
     copyTexProgram = render::engine->requestShader("DEPTH_TO_MASK", {}, render::ShaderReplacementDefaults::Process);
@@ -163,6 +189,22 @@ void GroundPlane::prepare() {
   }
 
   groundPlanePrepared = true;
+  altSceneCacheValid = false;
+}
+
+void GroundPlane::prepareBlurBuffers() {
+  for (int i = 0; i < 2; i++) {
+    blurColorTextures[i] =
+        render::engine->generateTextureBuffer(TextureFormat::RGBA16F, view::bufferWidth, view::bufferHeight);
+    blurColorTextures[i]->setFilterMode(FilterMode::Linear);
+    blurFrameBuffers[i] = render::engine->generateFrameBuffer(view::bufferWidth, view::bufferHeight);
+
+    blurFrameBuffers[i]->addColorBuffer(blurColorTextures[i]);
+    blurFrameBuffers[i]->setDrawBuffers();
+
+    blurFrameBuffers[i]->clearColor = glm::vec3{1., 1., 1.};
+    blurFrameBuffers[i]->clearAlpha = 0.0;
+  }
 }
 
 void GroundPlane::draw(bool isRedraw) {
@@ -212,7 +254,9 @@ void GroundPlane::draw(bool isRedraw) {
   // Viewport
   glm::vec4 viewport = render::engine->getCurrentViewport();
   glm::vec2 viewportDim{viewport[2], viewport[3]};
-  int factor = render::engine->getSSAAFactor();
+  float factor = render::engine->getSceneBufferScale();
+  unsigned int sceneWidth = render::engine->scaledSceneBufferSize(view::bufferWidth);
+  unsigned int sceneHeight = render::engine->scaledSceneBufferSize(view::bufferHeight);
 
   auto setUniforms = [&]() {
     glm::mat4 viewMat = view::getCameraViewMatrix();
@@ -252,14 +296,39 @@ void GroundPlane::draw(bool isRedraw) {
     groundPlaneProgram->setUniform("u_lengthScale", state::lengthScale);
   };
 
+  // The mirror image and the shadow only need to be regenerated when the scene or the camera changed. Like the pick
+  // buffer cache, the scene generation catches data and settings changes, the rest anything that moves the camera
+  // without going through requestRedraw(). The TAA jitter is left out, these effects are blurry anyway.
+  bool altSceneCached = false;
+  if (!isRedraw && (options::groundPlaneMode == GroundPlaneMode::TileReflection ||
+                    options::groundPlaneMode == GroundPlaneMode::ShadowOnly)) {
+    glm::vec2 jitter = view::projectionJitter;
+    view::projectionJitter = glm::vec2{0., 0.};
+    glm::mat4 cacheProjMat = view::getCameraPerspectiveMatrix();
+    view::projectionJitter = jitter;
+
+    altSceneCached = altSceneCacheValid && altSceneCacheGeneration == getSceneGeneration() &&
+                     altSceneCacheWidth == sceneWidth && altSceneCacheHeight == sceneHeight &&
+                     altSceneCacheGroundHeight == groundHeight && altSceneCacheViewMat == view::viewMat &&
+                     altSceneCacheProjMat == cacheProjMat;
+
+    altSceneCacheValid = true;
+    altSceneCacheGeneration = getSceneGeneration();
+    altSceneCacheWidth = sceneWidth;
+    altSceneCacheHeight = sceneHeight;
+    altSceneCacheGroundHeight = groundHeight;
+    altSceneCacheViewMat = view::viewMat;
+    altSceneCacheProjMat = cacheProjMat;
+  }
+
   /*
   // For all effects which will use the alternate scene buffers, prepare them
   if (options::groundPlaneMode == GroundPlaneMode::TileReflection ||
       options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
 
 
-    sceneAltFrameBuffer->resize(factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
-    sceneAltFrameBuffer->setViewport(0, 0, factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
+    sceneAltFrameBuffer->resize(sceneWidth / 2, sceneHeight / 2);
+    sceneAltFrameBuffer->setViewport(0, 0, sceneWidth / 2, sceneHeight / 2);
     render::engine->setCurrentPixelScaling(factor / 2.);
 
     sceneAltFrameBuffer->bindForRendering();
@@ -269,15 +338,22 @@ void GroundPlane::draw(bool isRedraw) {
   */
 
   // Render the scene to implement the mirror effect
-  if (!isRedraw && options::groundPlaneMode == GroundPlaneMode::TileReflection) {
+  bool mirrorRender = options::groundPlaneMode == GroundPlaneMode::TileReflection &&
+                      options::groundReflectionMode != GroundReflectionMode::ScreenSpace;
+  if (!isRedraw && !altSceneCached && mirrorRender) {
 
     // Prepare the alternate scene buffers
-    // (use a texture 1/4 the area of the view buffer, it's supposed to be blurry anyway and this saves perf)
+    // (use a texture 1/4 the area of the view buffer, it's supposed to be blurry anyway and this saves perf. The
+    // reduced mode goes down to 1/16 the area, and blurs away the blockiness.)
+    bool reduced = options::groundReflectionMode == GroundReflectionMode::ReducedMirror;
+    unsigned int mirrorDiv = reduced ? 4 : 2;
+    unsigned int mirrorWidth = std::max(1u, sceneWidth / mirrorDiv);
+    unsigned int mirrorHeight = std::max(1u, sceneHeight / mirrorDiv);
     render::engine->setBlendMode(BlendMode::AlphaOver);
     render::engine->setDepthMode(DepthMode::Less);
-    sceneAltFrameBuffer->resize(factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
-    sceneAltFrameBuffer->setViewport(0, 0, factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
-    render::engine->setCurrentPixelScaling(factor / 2.);
+    sceneAltFrameBuffer->resize(mirrorWidth, mirrorHeight);
+    sceneAltFrameBuffer->setViewport(0, 0, mirrorWidth, mirrorHeight);
+    render::engine->setCurrentPixelScaling(factor / mirrorDiv);
 
     sceneAltFrameBuffer->bindForRendering();
     sceneAltFrameBuffer->clearColor = {view::bgColor[0], view::bgColor[1], view::bgColor[2]};
@@ -308,16 +384,61 @@ void GroundPlane::draw(bool isRedraw) {
     // Restore original values
     render::engine->setFrontFaceCCW(!render::engine->getFrontFaceCCW());
     view::viewMat = origViewMat;
+
+    if (reduced) {
+      render::engine->setBlendMode(BlendMode::Disable);
+      for (int i = 0; i < 2; i++) {
+        blurFrameBuffers[i]->resize(mirrorWidth, mirrorHeight);
+        blurFrameBuffers[i]->setViewport(0, 0, mirrorWidth, mirrorHeight);
+      }
+
+      // separable blur passes, the first reads the mirror image, the result ends in the first buffer
+      for (int i = 0; i < reducedReflectionBlurIters; i++) {
+        blurFrameBuffers[1]->bindForRendering();
+        blurProgram->setTextureFromBuffer("t_image", i == 0 ? sceneAltColorTexture.get() : blurColorTextures[0].get());
+        blurProgram->setUniform("u_horizontal", 1);
+        blurProgram->draw();
+
+        blurFrameBuffers[0]->bindForRendering();
+        blurProgram->setTextureFromBuffer("t_image", blurColorTextures[1].get());
+        blurProgram->setUniform("u_horizontal", 0);
+        blurProgram->draw();
+      }
+    }
+  }
+
+  // Copy the scene drawn so far, in which the screen-space reflection is traced
+  if (!isRedraw && !altSceneCached && options::groundPlaneMode == GroundPlaneMode::TileReflection &&
+      options::groundReflectionMode == GroundReflectionMode::ScreenSpace) {
+
+    // (at half resolution, as the mirror image)
+    unsigned int copyWidth = std::max(1u, sceneWidth / 2);
+    unsigned int copyHeight = std::max(1u, sceneHeight / 2);
+    sceneAltFrameBuffer->resize(copyWidth, copyHeight);
+    sceneAltFrameBuffer->setViewport(0, 0, copyWidth, copyHeight);
+    sceneAltFrameBuffer->clear();
+    render::engine->sceneBuffer->blitTo(sceneAltFrameBuffer.get());
+
+    sceneAltFrameBuffer->bindForRendering();
+    render::engine->setBlendMode(BlendMode::Disable);
+    render::engine->setDepthMode(DepthMode::Less);
+    copySceneDepthProgram->setTextureFromBuffer("t_depth", render::engine->sceneDepth.get());
+    copySceneDepthProgram->draw();
   }
 
   // Render the scene to implement the shadow effect
-  if (!isRedraw && options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
+  if (!isRedraw && !altSceneCached && options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
 
     // Prepare the alternate scene buffers
+    // (the shadow is rendered and blurred at half the window resolution regardless of SSAA, it is blurry anyway)
+    int ssaaFactor = render::engine->getSSAAFactor();
+    unsigned int shadowWidth = std::max(1u, sceneWidth / (2 * ssaaFactor));
+    unsigned int shadowHeight = std::max(1u, sceneHeight / (2 * ssaaFactor));
     render::engine->setBlendMode(BlendMode::AlphaOver);
     render::engine->setDepthMode(DepthMode::Less);
-    sceneAltFrameBuffer->resize(factor * view::bufferWidth, factor * view::bufferHeight);
-    sceneAltFrameBuffer->setViewport(0, 0, factor * view::bufferWidth, factor * view::bufferHeight);
+    sceneAltFrameBuffer->resize(shadowWidth, shadowHeight);
+    sceneAltFrameBuffer->setViewport(0, 0, shadowWidth, shadowHeight);
+    render::engine->setCurrentPixelScaling(factor / (2. * ssaaFactor));
 
     sceneAltFrameBuffer->bindForRendering();
     sceneAltFrameBuffer->clearColor = {view::bgColor[0], view::bgColor[1], view::bgColor[2]};
@@ -325,8 +446,8 @@ void GroundPlane::draw(bool isRedraw) {
 
     // Make sure all framebuffers are the right shape
     for (int i = 0; i < 2; i++) {
-      blurFrameBuffers[i]->resize(factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
-      blurFrameBuffers[i]->setViewport(0, 0, factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
+      blurFrameBuffers[i]->resize(shadowWidth, shadowHeight);
+      blurFrameBuffers[i]->setViewport(0, 0, shadowWidth, shadowHeight);
       blurFrameBuffers[i]->clear();
     }
 
@@ -345,16 +466,15 @@ void GroundPlane::draw(bool isRedraw) {
     render::engine->setBlendMode(BlendMode::Disable);
     drawStructures();
 
-    // Copy the depth buffer to a texture (while upsampling)
+    // Copy the depth buffer to a texture
     render::engine->setBlendMode(BlendMode::Disable);
     blurFrameBuffers[0]->bindForRendering();
     copyTexProgram->draw();
 
     // == Blur
 
-    // Do some blur iterations (ends in same buffer it started in)
-    int nBlur = options::shadowBlurIters * render::engine->getSSAAFactor();
-    // int nBlur = 0;
+    // Do some separable blur iterations (ends in same buffer it started in)
+    int nBlur = options::shadowBlurIters;
     for (int i = 0; i < nBlur; i++) {
       // horizontal blur
       blurFrameBuffers[1]->bindForRendering();
@@ -398,6 +518,18 @@ void GroundPlane::buildGui() {
     return "";
   };
 
+  auto reflectionModeName = [](const GroundReflectionMode& m) -> std::string {
+    switch (m) {
+    case GroundReflectionMode::Mirror:
+      return "Mirror";
+    case GroundReflectionMode::ReducedMirror:
+      return "Reduced Mirror";
+    case GroundReflectionMode::ScreenSpace:
+      return "Screen Space";
+    }
+    return "";
+  };
+
   auto heightModeName = [](const GroundPlaneHeightMode& m) -> std::string {
     switch (m) {
     case GroundPlaneHeightMode::Automatic:
@@ -465,6 +597,19 @@ void GroundPlane::buildGui() {
     case GroundPlaneMode::Tile:
       break;
     case GroundPlaneMode::TileReflection:
+      ImGui::PushItemWidth(160);
+      if (ImGui::BeginCombo("Reflection", reflectionModeName(options::groundReflectionMode).c_str())) {
+        for (GroundReflectionMode m :
+             {GroundReflectionMode::Mirror, GroundReflectionMode::ReducedMirror, GroundReflectionMode::ScreenSpace}) {
+          std::string mName = reflectionModeName(m);
+          if (ImGui::Selectable(mName.c_str(), options::groundReflectionMode == m)) {
+            options::groundReflectionMode = m;
+            requestRedraw();
+          }
+        }
+        ImGui::EndCombo();
+      }
+      ImGui::PopItemWidth();
       break;
     case GroundPlaneMode::ShadowOnly:
       if (ImGui::SliderFloat("Shadow Darkness", &options::shadowDarkness, .0, 1.0)) requestRedraw();
@@ -5,6 +5,7 @@
 #include "polyscope/render/engine.h"
 
 #include <string>
+#include <vector>
 
 namespace polyscope {
 namespace render {
@@ -20,6 +21,7 @@ std::string engineBackendName = "";
 namespace backend_openGL3 {
 void initializeRenderEngine_glfw();
 void initializeRenderEngine_egl();
+std::vector<std::string> listDevices_egl();
 } // namespace backend_openGL3
 namespace backend_openGL_mock {
 void initializeRenderEngine();
@@ -96,4 +98,13 @@ void initializeRenderEngine(std::string backend) {
 }
 
 } // namespace render
+
+std::vector<std::string> listEGLDevices() {
+#ifdef POLYSCOPE_BACKEND_OPENGL3_EGL_ENABLED
+  return render::backend_openGL3::listDevices_egl();
+#else
+  return {};
+#endif
+}
+
 } // namespace polyscope
@@ -1,6 +1,7 @@
 // Copyright 2018-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
 
 
+#include <algorithm>
 #include <vector>
 
 #include "polyscope/render/managed_buffer.h"
@@ -10,10 +11,67 @@
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 #include "polyscope/render/templated_buffers.h"
+#include "polyscope/scratch_buffer.h"
+#include "polyscope/trace.h"
 
 namespace polyscope {
 namespace render {
 
+namespace {
+
+void appendTexel(float v, std::vector<float>& out) { out.push_back(v); }
+void appendTexel(double v, std::vector<float>& out) { out.push_back(static_cast<float>(v)); }
+void appendTexel(const glm::vec3& v, std::vector<float>& out) { out.insert(out.end(), {v.x, v.y, v.z}); }
+void appendTexel(const glm::vec4& v, std::vector<float>& out) { out.insert(out.end(), {v.x, v.y, v.z, v.w}); }
+
+template <typename T>
+void packTextureBoxTexels(const std::vector<T>& data, glm::uvec3 size, glm::uvec3 origin, glm::uvec3 extent,
+                          std::vector<float>& out) {
+  out.clear();
+  out.reserve(static_cast<size_t>(textureChannelCount<T>()) * extent.x * extent.y * extent.z);
+  for (uint32_t z = origin.z; z < origin.z + extent.z; z++) {
+    for (uint32_t y = origin.y; y < origin.y + extent.y; y++) {
+      size_t rowStart = (static_cast<size_t>(z) * size.y + y) * size.x;
+      for (uint32_t x = origin.x; x < origin.x + extent.x; x++) {
+        appendTexel(data[rowStart + x], out);
+      }
+    }
+  }
+}
+
+// Copy a box of a 3D texture's data to float texels for TextureBuffer::setDataBox(). Returns false for types it cannot
+// take, which are re-uploaded in full instead.
+template <typename T>
+bool packTextureBox(const std::vector<T>&, glm::uvec3, glm::uvec3, glm::uvec3, std::vector<float>&) {
+  return false;
+}
+template <>
+bool packTextureBox(const std::vector<float>& data, glm::uvec3 size, glm::uvec3 origin, glm::uvec3 extent,
+                    std::vector<float>& out) {
+  packTextureBoxTexels(data, size, origin, extent, out);
+  return true;
+}
+template <>
+bool packTextureBox(const std::vector<double>& data, glm::uvec3 size, glm::uvec3 origin, glm::uvec3 extent,
+                    std::vector<float>& out) {
+  packTextureBoxTexels(data, size, origin, extent, out);
+  return true;
+}
+template <>
+bool packTextureBox(const std::vector<glm::vec3>& data, glm::uvec3 size, glm::uvec3 origin, glm::uvec3 extent,
+                    std::vector<float>& out) {
+  packTextureBoxTexels(data, size, origin, extent, out);
+  return true;
+}
+template <>
+bool packTextureBox(const std::vector<glm::vec4>& data, glm::uvec3 size, glm::uvec3 origin, glm::uvec3 extent,
+                    std::vector<float>& out) {
+  packTextureBoxTexels(data, size, origin, extent, out);
+  return true;
+}
+
+} // namespace
+
 template <typename T>
 ManagedBuffer<T>::ManagedBuffer(ManagedBufferRegistry* registry_, const std::string& name_, std::vector<T>& data_)
     : name(name_), uniqueID(internal::getNextUniqueID()), registry(registry_), data(data_), dataGetsComputed(false),
@@ -67,9 +125,9 @@ void ManagedBuffer<T>::setTextureSize(uint32_t sizeX_, uint32_t sizeY_, uint32_t
 }
 
 template <typename T>
-std::array<uint32_t, 3> ManagedBuffer<T>::getTextureSize() const {
+glm::uvec3 ManagedBuffer<T>::getTextureSize() const {
   if (deviceBufferType == DeviceBufferType::Attribute) exception("managed buffer is not a texture");
-  return std::array<uint32_t, 3>{sizeX, sizeY, sizeZ};
+  return glm::uvec3{sizeX, sizeY, sizeZ};
 }
 
 template <typename T>
@@ -92,21 +150,48 @@ void ManagedBuffer<T>::ensureHostBufferPopulated() {
     if (deviceBufferTypeIsTexture()) {
       if (!renderTextureBuffer) exception("render buffer should be allocated but isn't");
 
+      if (dataGetsComputed) {
+        // recomputing is cheaper than a texture read back (e.g. after the host copy was dropped)
+        computeFunc();
+        break;
+      }
+
       // copy the data back from the renderBuffer
-      // TODO not implemented yet
-      exception("copy-back from texture not implemented yet");
+      data = getTextureBufferData<T>(*renderTextureBuffer);
     } else {
       // sanity check
       if (!renderAttributeBuffer) exception("render buffer should be allocated but isn't");
 
       // copy the data back from the renderBuffer
       data = getAttributeBufferDataRange<T>(*renderAttributeBuffer, 0, renderAttributeBuffer->getDataSize());
+
+      if (hostResidency == HostResidency::DropAfterUpload) {
+        // the host copy was dropped, it is current again until the device buffer is next written directly
+        hostBufferIsPopulated = true;
+        scheduleHostBufferDrop();
+      }
     }
 
+    break;
+
+  case CanonicalDataSource::ExternalView:
+
+    // materialize a host copy, which becomes the canonical data from here on
+    data.assign(externalViewData, externalViewData + externalViewSize);
+    hostBufferIsPopulated = true;
+    clearExternalView();
+
     break;
   };
 }
 
+template <typename T>
+void ManagedBuffer<T>::ensureHostBufferComputed() {
+  if (currentCanonicalDataSource() == CanonicalDataSource::NeedsCompute) {
+    computeFunc();
+  }
+}
+
 template <typename T>
 void ManagedBuffer<T>::ensureHostBufferAllocated() {
   data.resize(size());
@@ -120,7 +205,10 @@ std::vector<T>& ManagedBuffer<T>::getPopulatedHostBufferRef() {
 
 template <typename T>
 void ManagedBuffer<T>::markHostBufferUpdated() {
+  POLYSCOPE_TRACE_SPAN("markHostBufferUpdated", name);
   hostBufferIsPopulated = true;
+  dataVersion++;
+  clearExternalView(); // the host data supersedes any view
 
   // If the data is stored in the device-side buffers, update it as needed
   if (renderAttributeBuffer) {
@@ -137,6 +225,150 @@ void ManagedBuffer<T>::markHostBufferUpdated() {
     updateIndexedViews();
     requestRedraw();
   }
+
+  scheduleHostBufferDrop();
+}
+
+template <typename T>
+void ManagedBuffer<T>::markHostBufferRangeUpdated(size_t begin, size_t count) {
+  markHostBufferRangesUpdated({{begin, count}});
+}
+
+template <typename T>
+void ManagedBuffer<T>::markHostBufferRangesUpdated(std::vector<std::array<size_t, 2>> ranges) {
+
+  if (currentCanonicalDataSource() != CanonicalDataSource::HostData) {
+    exception("ManagedBuffer " + name +
+              " marked range updated, but host buffer is not populated. Call ensureHostBufferPopulated() first.");
+  }
+
+  // Convert to sorted [begin,end) ranges and merge any which overlap or touch
+  std::vector<std::array<size_t, 2>> merged;
+  size_t dirtyCount = 0;
+  {
+    for (std::array<size_t, 2>& r : ranges) {
+      if (r[0] + r[1] > data.size()) {
+        exception("ManagedBuffer " + name + " marked range [" + std::to_string(r[0]) + ", " +
+                  std::to_string(r[0] + r[1]) + ") updated, but buffer has size " + std::to_string(data.size()));
+      }
+      r[1] = r[0] + r[1];
+    }
+    std::sort(ranges.begin(), ranges.end());
+    for (const std::array<size_t, 2>& r : ranges) {
+      if (r[0] == r[1]) continue;
+      if (!merged.empty() && r[0] <= merged.back()[1]) {
+        merged.back()[1] = std::max(merged.back()[1], r[1]);
+      } else {
+        merged.push_back(r);
+      }
+    }
+    for (const std::array<size_t, 2>& r : merged) dirtyCount += r[1] - r[0];
+  }
+
+  if (merged.empty()) return;
+  dataVersion++;
+
+  // If most of the buffer changed (or it changed size), a single full upload is cheaper than many small ones
+  bool sizeChanged = renderAttributeBuffer && static_cast<int64_t>(data.size()) != renderAttributeBuffer->getDataSize();
+  if (sizeChanged || 2 * dirtyCount > data.size()) {
+    markHostBufferUpdated();
+    return;
+  }
+
+  if (renderAttributeBuffer) {
+    for (const std::array<size_t, 2>& r : merged) {
+      renderAttributeBuffer->setDataRange(data, r[0], r[0], r[1] - r[0]);
+    }
+    requestRedraw();
+  }
+
+  // NOTE: textures are always fully re-uploaded, linear ranges do not generally correspond to rectangular regions
+  if (renderTextureBuffer) {
+    renderTextureBuffer->setData(data);
+    requestRedraw();
+  }
+
+  if (deviceBufferType == DeviceBufferType::Attribute) {
+    updateIndexedViewsRanges(merged);
+    requestRedraw();
+  }
+
+  scheduleHostBufferDrop();
+}
+
+template <typename T>
+void ManagedBuffer<T>::markHostBufferBoxUpdated(glm::uvec3 origin, glm::uvec3 extent) {
+  checkDeviceBufferTypeIs(DeviceBufferType::Texture3d);
+
+  if (currentCanonicalDataSource() != CanonicalDataSource::HostData) {
+    exception("ManagedBuffer " + name +
+              " marked box updated, but host buffer is not populated. Call ensureHostBufferPopulated() first.");
+  }
+  glm::uvec3 size{sizeX, sizeY, sizeZ};
+  for (int i = 0; i < 3; i++) {
+    if (origin[i] + extent[i] > size[i]) {
+      exception("ManagedBuffer " + name + " marked box updated which extends past the end of the " +
+                std::to_string(sizeX) + "x" + std::to_string(sizeY) + "x" + std::to_string(sizeZ) + " texture");
+    }
+  }
+  if (extent.x == 0 || extent.y == 0 || extent.z == 0) return;
+  dataVersion++;
+
+  if (renderTextureBuffer) {
+    std::vector<float> texels;
+    if (packTextureBox(data, size, origin, extent, texels)) {
+      renderTextureBuffer->setDataBox(&texels.front(), textureChannelCount<T>(), PixelComponentType::Float32,
+                                      origin.x, origin.y, origin.z, extent.x, extent.y, extent.z);
+    } else {
+      renderTextureBuffer->setData(data);
+    }
+    requestRedraw();
+  }
+
+  scheduleHostBufferDrop();
+}
+
+template <typename T>
+void ManagedBuffer<T>::appendData(const std::vector<T>& newValues) {
+  if (deviceBufferTypeIsTexture() || dataGetsComputed) {
+    exception("ManagedBuffer " + name + " cannot append data, only non-computed attribute buffers can grow");
+  }
+  if (newValues.empty()) return;
+  dataVersion++;
+
+  // Without a host copy (and without indexed views to re-gather on the host), grow the render buffer directly
+  if (currentCanonicalDataSource() == CanonicalDataSource::RenderBuffer && existingIndexedViews.empty()) {
+    size_t oldSize = renderAttributeBuffer->getDataSize();
+    renderAttributeBuffer->resizePreservingData(oldSize + newValues.size());
+    renderAttributeBuffer->setDataRange(newValues, 0, oldSize, newValues.size());
+    requestRedraw();
+    return;
+  }
+
+  ensureHostBufferPopulated();
+  size_t oldSize = data.size();
+  data.insert(data.end(), newValues.begin(), newValues.end());
+  hostBufferIsPopulated = true;
+
+  if (renderAttributeBuffer) {
+    renderAttributeBuffer->resizePreservingData(data.size());
+    renderAttributeBuffer->setDataRange(data, oldSize, oldSize, newValues.size());
+    requestRedraw();
+  }
+
+  updateIndexedViews();
+  scheduleHostBufferDrop();
+}
+
+template <typename T>
+void ManagedBuffer<T>::reserve(size_t capacity) {
+  reservedCapacity = capacity;
+  if (hostResidency == HostResidency::Keep) {
+    data.reserve(capacity);
+  }
+  if (renderAttributeBuffer) {
+    renderAttributeBuffer->reserve(capacity);
+  }
 }
 
 template <typename T>
@@ -173,6 +405,12 @@ T ManagedBuffer<T>::getValue(size_t ind) {
     T val = getAttributeBufferData<T>(*renderAttributeBuffer, ind);
     return val;
     break;
+
+  case CanonicalDataSource::ExternalView:
+    if (ind >= externalViewSize)
+      exception("out of bounds access in ManagedBuffer " + name + " getValue(" + std::to_string(ind) + ")");
+    return externalViewData[ind];
+    break;
   };
 
   return T(); // dummy return
@@ -194,6 +432,74 @@ T ManagedBuffer<T>::getValue(size_t indX, size_t indY, size_t indZ) {
   return getValue(sizeZ * sizeY * indX + sizeZ * indY + indZ);
 }
 
+template <typename T>
+std::vector<T> ManagedBuffer<T>::getValues(const std::vector<size_t>& inds) {
+
+  std::vector<T> values(inds.size());
+  if (inds.empty()) return values;
+
+  size_t minInd = inds[0];
+  size_t maxInd = inds[0];
+  for (size_t ind : inds) {
+    minInd = std::min(minInd, ind);
+    maxInd = std::max(maxInd, ind);
+  }
+  ensureHostBufferComputed();
+  if (maxInd >= size()) {
+    exception("out of bounds access in ManagedBuffer " + name + " getValues(" + std::to_string(maxInd) + ")");
+  }
+
+  // One readback over the span of the indices, rather than one per index
+  std::vector<T> span = getRange(minInd, maxInd - minInd + 1);
+  for (size_t i = 0; i < inds.size(); i++) {
+    values[i] = span[inds[i] - minInd];
+  }
+  return values;
+}
+
+template <typename T>
+std::vector<T> ManagedBuffer<T>::getRange(size_t begin, size_t count) {
+
+  // As in getValue(), textures are always read through a full host copy
+  if (deviceBufferTypeIsTexture()) {
+    ensureHostBufferPopulated();
+  }
+  ensureHostBufferComputed();
+
+  size_t n = size();
+  if (begin > n || count > n - begin) {
+    exception("out of bounds access in ManagedBuffer " + name + " getRange(" + std::to_string(begin) + ", " +
+              std::to_string(count) + ")");
+  }
+  if (count == 0) return std::vector<T>();
+
+  switch (currentCanonicalDataSource()) {
+  case CanonicalDataSource::HostData:
+    return std::vector<T>(data.begin() + begin, data.begin() + begin + count);
+    break;
+
+  case CanonicalDataSource::NeedsCompute:
+    break; // computed above
+
+  case CanonicalDataSource::RenderBuffer:
+    return getAttributeBufferDataRange<T>(*renderAttributeBuffer, begin, count);
+    break;
+
+  case CanonicalDataSource::ExternalView:
+    return std::vector<T>(externalViewData + begin, externalViewData + begin + count);
+    break;
+  };
+
+  return std::vector<T>(); // dummy return
+}
+
+template <typename T>
+void ManagedBuffer<T>::requestHostCopyAsync() {
+  if (currentCanonicalDataSource() != CanonicalDataSource::RenderBuffer) return;
+  if (deviceBufferType != DeviceBufferType::Attribute || !renderAttributeBuffer) return;
+  renderAttributeBuffer->requestDataCopy();
+}
+
 template <typename T>
 size_t ManagedBuffer<T>::size() {
 
@@ -217,6 +523,10 @@ size_t ManagedBuffer<T>::size() {
       return s;
     }
     break;
+
+  case CanonicalDataSource::ExternalView:
+    return externalViewSize;
+    break;
   };
 
   return INVALID_IND;
@@ -226,6 +536,7 @@ template <typename T>
 bool ManagedBuffer<T>::hasData() {
 
   if (hostBufferIsPopulated) return true;
+  if (usingExternalView) return true;
   if (deviceBufferType == DeviceBufferType::Attribute && renderAttributeBuffer) return true;
   if (deviceBufferType == DeviceBufferType::Texture1d && renderTextureBuffer) return true;
   if (deviceBufferType == DeviceBufferType::Texture2d && renderTextureBuffer) return true;
@@ -233,11 +544,226 @@ bool ManagedBuffer<T>::hasData() {
   return false;
 }
 
+template <typename T>
+bool ManagedBuffer<T>::isDeviceResident() {
+  if (renderAttributeBuffer || renderTextureBuffer) return true;
+  if (deviceBufferType != DeviceBufferType::Attribute) return false;
+  removeDeletedIndexedViews();
+  return !existingIndexedViews.empty();
+}
+
+template <typename T>
+bool ManagedBuffer<T>::isCanonicalOnDevice() {
+  return hasData() && currentCanonicalDataSource() == CanonicalDataSource::RenderBuffer;
+}
+
+template <typename T>
+uint64_t ManagedBuffer<T>::getDataVersion() const {
+  return dataVersion;
+}
+
 template <typename T>
 DeviceBufferType ManagedBuffer<T>::getDeviceBufferType() {
   return deviceBufferType;
 }
 
+template <typename T>
+void ManagedBuffer<T>::setUpdateFrequency(BufferUpdateFrequency newFreq) {
+  updateFrequency = newFreq;
+
+  // apply to any render buffers which already exist, it takes effect on their next upload
+  if (renderAttributeBuffer) {
+    renderAttributeBuffer->setUpdateFrequency(updateFrequency);
+  }
+  if (renderTextureBuffer) {
+    renderTextureBuffer->setUpdateFrequency(updateFrequency);
+  }
+  for (std::tuple<render::ManagedBuffer<uint32_t>*, std::weak_ptr<render::AttributeBuffer>>& existingViewTup :
+       existingIndexedViews) {
+    std::shared_ptr<render::AttributeBuffer> viewBufferPtr = std::get<1>(existingViewTup).lock();
+    if (viewBufferPtr) {
+      viewBufferPtr->setUpdateFrequency(updateFrequency);
+    }
+  }
+}
+
+template <typename T>
+BufferUpdateFrequency ManagedBuffer<T>::getUpdateFrequency() const {
+  return updateFrequency;
+}
+
+template <typename T>
+void ManagedBuffer<T>::setHostResidency(HostResidency newResidency) {
+  hostResidency = newResidency;
+  scheduleHostBufferDrop(); // in case it was already uploaded
+}
+
+template <typename T>
+HostResidency ManagedBuffer<T>::getHostResidency() const {
+  return hostResidency;
+}
+
+template <typename T>
+void ManagedBuffer<T>::setDeviceStorageFormat(AttributeStorageFormat newFormat) {
+  checkDeviceBufferTypeIs(DeviceBufferType::Attribute);
+  if (newFormat == deviceStorageFormat) return;
+
+  removeDeletedIndexedViews();
+  if (renderAttributeBuffer || !existingIndexedViews.empty()) {
+    exception("managed buffer " + name + " device storage format must be set before its render buffers are created");
+  }
+  deviceStorageFormat = newFormat;
+}
+
+template <typename T>
+AttributeStorageFormat ManagedBuffer<T>::getDeviceStorageFormat() const {
+  return deviceStorageFormat;
+}
+
+template <typename T>
+void ManagedBuffer<T>::setTextureStorageFormat(TextureFormat newFormat) {
+  checkDeviceBufferTypeIsTexture();
+  if (textureStorageFormatIsSet && newFormat == textureStorageFormat) return;
+
+  if (renderTextureBuffer) {
+    exception("managed buffer " + name + " texture storage format must be set before its texture is created");
+  }
+  if (dimension(newFormat) != textureChannelCount<T>()) {
+    exception("managed buffer " + name + " texture storage format has " + std::to_string(dimension(newFormat)) +
+              " channels, but the buffer data has " + std::to_string(textureChannelCount<T>()));
+  }
+  textureStorageFormat = newFormat;
+  textureStorageFormatIsSet = true;
+}
+
+template <typename T>
+std::shared_ptr<render::AttributeBuffer> ManagedBuffer<T>::generateDeviceAttributeBuffer() {
+  std::shared_ptr<render::AttributeBuffer> newBuffer = generateAttributeBuffer<T>(render::engine);
+  newBuffer->setUpdateFrequency(updateFrequency);
+  newBuffer->setStorageFormat(deviceStorageFormat);
+  return newBuffer;
+}
+
+namespace {
+std::vector<std::function<void()>> scheduledHostBufferDrops;
+}
+
+template <typename T>
+void ManagedBuffer<T>::scheduleHostBufferDrop() {
+  if (hostResidency != HostResidency::DropAfterUpload || hostBufferDropScheduled) return;
+  if (!renderAttributeBuffer && !renderTextureBuffer) return;
+
+  hostBufferDropScheduled = true;
+  WeakHandle<ManagedBuffer<T>> handle = getWeakHandle<ManagedBuffer<T>>(this);
+  scheduledHostBufferDrops.push_back([handle]() {
+    if (handle.isValid()) handle.get().dropHostBufferIfRestorable();
+  });
+}
+
+template <typename T>
+void ManagedBuffer<T>::dropHostBufferIfRestorable() {
+  hostBufferDropScheduled = false;
+  if (hostResidency != HostResidency::DropAfterUpload || !hostBufferIsPopulated) return;
+
+  bool restorable = false;
+  if (deviceBufferTypeIsTexture()) {
+    restorable = renderTextureBuffer && dataGetsComputed;
+  } else if (renderAttributeBuffer) {
+    size_t deviceElementBytes = renderAttributeBuffer->getStorageElementBytes();
+    restorable = sizeof(T) == deviceElementBytes &&
+                 renderAttributeBuffer->getDataSize() == static_cast<int64_t>(data.size());
+  }
+  if (!restorable) return;
+
+  hostBufferIsPopulated = false;
+  std::vector<T>().swap(data); // clear() would keep the allocation
+}
+
+void processHostBufferDrops() {
+  std::vector<std::function<void()>> drops;
+  drops.swap(scheduledHostBufferDrops);
+  for (std::function<void()>& drop : drops) {
+    drop();
+  }
+}
+
+template <typename T>
+void ManagedBuffer<T>::setExternalView(const T* viewData, size_t count, std::shared_ptr<void> lifetimeToken) {
+  if (count > 0 && viewData == nullptr) exception("ManagedBuffer " + name + " given a null external view");
+  dataVersion++;
+
+  usingExternalView = true;
+  externalViewData = viewData;
+  externalViewSize = count;
+  externalViewLifetime = lifetimeToken;
+
+  // release any host copy, the view is the data now
+  hostBufferIsPopulated = false;
+  std::vector<T>().swap(data);
+
+  // Update the device-side buffers, if they exist
+  if (renderAttributeBuffer) {
+    uploadExternalView(*renderAttributeBuffer);
+    updateIndexedViews();
+  }
+  if (renderTextureBuffer) {
+    // textures are always filled from the host
+    ensureHostBufferPopulated();
+    renderTextureBuffer->setData(data);
+  }
+
+  requestRedraw();
+}
+
+template <typename T>
+bool ManagedBuffer<T>::hasExternalView() const {
+  return usingExternalView;
+}
+
+template <typename T>
+const T* ManagedBuffer<T>::getHostDataPointer() {
+  if (usingExternalView) return externalViewData;
+  ensureHostBufferPopulated();
+  return data.data();
+}
+
+template <typename T>
+void ManagedBuffer<T>::clearExternalView() {
+  usingExternalView = false;
+  externalViewData = nullptr;
+  externalViewSize = 0;
+  externalViewLifetime.reset();
+}
+
+template <typename T>
+void ManagedBuffer<T>::uploadExternalView(render::AttributeBuffer& buffer) {
+  size_t deviceElementBytes = sizeInBytes(buffer.getType()) * buffer.getArrayCount();
+  if (sizeof(T) == deviceElementBytes) {
+    buffer.setDataFromPointer(externalViewData, externalViewSize);
+  } else {
+    // the device representation differs (e.g. doubles stored as floats), this needs a converting copy
+    std::vector<T> converted(externalViewData, externalViewData + externalViewSize);
+    buffer.setData(converted);
+  }
+}
+
+template <typename T>
+MemoryUsage ManagedBuffer<T>::getMemoryUsage() {
+  MemoryUsage usage;
+  usage.hostBytes = data.capacity() * sizeof(T);
+  usage.overheadBytes = sizeof(ManagedBuffer<T>) + name.capacity();
+
+  if (renderAttributeBuffer) usage.deviceBytes += renderAttributeBuffer->getDeviceMemoryBytes();
+  if (renderTextureBuffer) usage.deviceBytes += renderTextureBuffer->getDeviceMemoryBytes();
+  for (const std::tuple<render::ManagedBuffer<uint32_t>*, std::weak_ptr<render::AttributeBuffer>>& entry :
+       existingIndexedViews) {
+    std::shared_ptr<render::AttributeBuffer> view = std::get<1>(entry).lock();
+    if (view) usage.deviceBytes += view->getDeviceMemoryBytes();
+  }
+
+  return usage;
+}
+
 template <typename T>
 std::string ManagedBuffer<T>::summaryString() {
 
@@ -255,6 +781,9 @@ std::string ManagedBuffer<T>::summaryString() {
   case CanonicalDataSource::RenderBuffer:
     str += "Renderbuffer";
     break;
+  case CanonicalDataSource::ExternalView:
+    str += "ExternalView";
+    break;
   };
   str += " size: " + std::to_string(size());
   str += " device type: ";
@@ -298,9 +827,19 @@ std::shared_ptr<render::AttributeBuffer> ManagedBuffer<T>::getRenderAttributeBuf
   checkDeviceBufferTypeIs(DeviceBufferType::Attribute);
 
   if (!renderAttributeBuffer) {
-    ensureHostBufferPopulated(); // warning: the order of these matters because of how hostBufferPopulated works
-    renderAttributeBuffer = generateAttributeBuffer<T>(render::engine);
-    renderAttributeBuffer->setData(data);
+    POLYSCOPE_TRACE_SPAN("uploadAttributeBuffer", name);
+    if (currentCanonicalDataSource() == CanonicalDataSource::ExternalView) {
+      // upload straight from the external memory, without a host copy
+      renderAttributeBuffer = generateDeviceAttributeBuffer();
+      if (reservedCapacity > 0) renderAttributeBuffer->reserve(reservedCapacity);
+      uploadExternalView(*renderAttributeBuffer);
+    } else {
+      ensureHostBufferPopulated(); // warning: the order of these matters because of how hostBufferPopulated works
+      renderAttributeBuffer = generateDeviceAttributeBuffer();
+      if (reservedCapacity > 0) renderAttributeBuffer->reserve(reservedCapacity);
+      renderAttributeBuffer->setData(data);
+      scheduleHostBufferDrop();
+    }
   }
   return renderAttributeBuffer;
 }
@@ -310,45 +849,146 @@ std::shared_ptr<render::TextureBuffer> ManagedBuffer<T>::getRenderTextureBuffer(
   checkDeviceBufferTypeIsTexture();
 
   if (!renderTextureBuffer) {
+    POLYSCOPE_TRACE_SPAN("uploadTextureBuffer", name);
     ensureHostBufferPopulated(); // warning: the order of these matters because of how hostBufferPopulated works
+    generateDeviceTextureBuffer();
+    renderTextureBuffer->setData(data);
+    scheduleHostBufferDrop();
+  }
+  return renderTextureBuffer;
+}
 
+template <typename T>
+void ManagedBuffer<T>::generateDeviceTextureBuffer() {
+  if (textureStorageFormatIsSet) {
+    renderTextureBuffer = generateTextureBuffer(deviceBufferType, textureStorageFormat, render::engine);
+  } else {
     renderTextureBuffer = generateTextureBuffer<T>(deviceBufferType, render::engine);
+  }
+  renderTextureBuffer->setUpdateFrequency(updateFrequency);
 
-    // templatize this?
-    switch (deviceBufferType) {
-    case DeviceBufferType::Attribute:
-      exception("bad call");
-      break;
-    case DeviceBufferType::Texture1d:
-      renderTextureBuffer->resize(sizeX);
-      break;
-    case DeviceBufferType::Texture2d:
-      renderTextureBuffer->resize(sizeX, sizeY);
-      break;
-    case DeviceBufferType::Texture3d:
-      renderTextureBuffer->resize(sizeX, sizeY, sizeZ);
-      break;
-    }
-
-    renderTextureBuffer->setData(data);
+  // templatize this?
+  switch (deviceBufferType) {
+  case DeviceBufferType::Attribute:
+    exception("bad call");
+    break;
+  case DeviceBufferType::Texture1d:
+    renderTextureBuffer->resize(sizeX);
+    break;
+  case DeviceBufferType::Texture2d:
+    renderTextureBuffer->resize(sizeX, sizeY);
+    break;
+  case DeviceBufferType::Texture3d:
+    renderTextureBuffer->resize(sizeX, sizeY, sizeZ);
+    break;
   }
-  return renderTextureBuffer;
 }
 
 template <typename T>
 void ManagedBuffer<T>::markRenderAttributeBufferUpdated() {
   checkDeviceBufferTypeIs(DeviceBufferType::Attribute);
+  dataVersion++;
 
   invalidateHostBuffer();
+  clearExternalView();
   updateIndexedViews();
   requestRedraw();
 }
 
+template <typename T>
+void ManagedBuffer<T>::setTextureDataRect(const void* pixels, int nChannels, PixelComponentType componentType,
+                                          uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+  checkDeviceBufferTypeIs(DeviceBufferType::Texture2d);
+
+  if (!renderTextureBuffer && x == 0 && y == 0 && w == sizeX && h == sizeY) {
+    // the whole texture gets overwritten, don't bother uploading (or materializing) the host data first
+    generateDeviceTextureBuffer();
+  }
+  getRenderTextureBuffer()->setDataRect(pixels, nChannels, componentType, x, y, w, h);
+  markRenderTextureBufferUpdated();
+}
+
+template <typename T>
+void ManagedBuffer<T>::setTextureDataFromDeviceBuffer(uint32_t nativeBufferHandle, int nChannels,
+                                                      PixelComponentType componentType) {
+  checkDeviceBufferTypeIs(DeviceBufferType::Texture2d);
+
+  if (!renderTextureBuffer) {
+    generateDeviceTextureBuffer(); // the whole texture gets overwritten, as in setTextureDataRect()
+  }
+  renderTextureBuffer->setDataFromDeviceBuffer(nativeBufferHandle, nChannels, componentType);
+  markRenderTextureBufferUpdated();
+}
+
+template <typename T>
+void ManagedBuffer<T>::setExternalRenderTexture(std::shared_ptr<render::TextureBuffer> texture) {
+  checkDeviceBufferTypeIs(DeviceBufferType::Texture2d);
+
+  if (!texture || texture->getDimension() != 2) {
+    exception("managed buffer " + name + " external render texture must be a 2D texture");
+  }
+  if (texture->getSizeX() != sizeX || texture->getSizeY() != sizeY) {
+    exception("managed buffer " + name + " external render texture is " + std::to_string(texture->getSizeX()) + "x" +
+              std::to_string(texture->getSizeY()) + ", expected " + std::to_string(sizeX) + "x" +
+              std::to_string(sizeY));
+  }
+  if (dimension(texture->getFormat()) < textureChannelCount<T>()) {
+    exception("managed buffer " + name + " external render texture has " +
+              std::to_string(dimension(texture->getFormat())) + " channels, but the buffer data has " +
+              std::to_string(textureChannelCount<T>()));
+  }
+
+  renderTextureBuffer = texture;
+  markRenderTextureBufferUpdated();
+}
+
+template <typename T>
+uint32_t ManagedBuffer<T>::beginDeviceWrite() {
+  if (deviceWriteActive) {
+    exception("managed buffer " + name + " beginDeviceWrite() called twice without endDeviceWrite()");
+  }
+
+  uint32_t nativeID;
+  if (deviceBufferType == DeviceBufferType::Attribute) {
+    if (deviceStorageFormat != AttributeStorageFormat::Float32) {
+      exception("managed buffer " + name + " can only be written on the device with Float32 storage");
+    }
+    nativeID = getRenderAttributeBuffer()->getNativeBufferID();
+  } else {
+    nativeID = getRenderTextureBuffer()->getNativeBufferID();
+  }
+
+  deviceWriteActive = true;
+  return nativeID;
+}
+
+template <typename T>
+void ManagedBuffer<T>::endDeviceWrite() {
+  if (!deviceWriteActive) {
+    exception("managed buffer " + name + " endDeviceWrite() called without beginDeviceWrite()");
+  }
+  deviceWriteActive = false;
+
+  if (deviceBufferType == DeviceBufferType::Attribute) {
+    markRenderAttributeBufferUpdated();
+  } else {
+    markRenderTextureBufferUpdated();
+  }
+}
+
+template <typename T>
+bool ManagedBuffer<T>::isDeviceWriteActive() const {
+  return deviceWriteActive;
+}
+
 template <typename T>
 void ManagedBuffer<T>::markRenderTextureBufferUpdated() {
   checkDeviceBufferTypeIsTexture();
+  dataVersion++;
 
   invalidateHostBuffer();
+  std::vector<T>().swap(data); // the texture is canonical now, release the host allocation too
+  clearExternalView();
   requestRedraw();
 }
 
@@ -376,16 +1016,28 @@ ManagedBuffer<T>::getIndexedRenderAttributeBuffer(ManagedBuffer<uint32_t>& indic
   }
 
   // We don't have it. Create a new one and return that.
-  ensureHostBufferPopulated();
-  std::shared_ptr<render::AttributeBuffer> newBuffer = generateAttributeBuffer<T>(render::engine);
-  indices.ensureHostBufferPopulated();
-  std::vector<T> expandData = gather(data, indices.data);
-  newBuffer->setData(expandData); // initially populate
+  std::shared_ptr<render::AttributeBuffer> newBuffer = generateDeviceAttributeBuffer();
+  populateIndexedView(indices, *newBuffer); // initially populate
   existingIndexedViews.emplace_back(&indices, newBuffer);
 
   return newBuffer;
 }
 
+template <typename T>
+void ManagedBuffer<T>::refreshIndexedViews(ManagedBuffer<uint32_t>& indices) {
+  if (existingIndexedViews.empty()) return;
+
+  for (std::tuple<render::ManagedBuffer<uint32_t>*, std::weak_ptr<render::AttributeBuffer>>& existingViewTup :
+       existingIndexedViews) {
+    std::shared_ptr<render::AttributeBuffer> viewBufferPtr = std::get<1>(existingViewTup).lock();
+    if (!viewBufferPtr) continue;
+    if (std::get<0>(existingViewTup)->uniqueID != indices.uniqueID) continue;
+    populateIndexedView(indices, *viewBufferPtr);
+  }
+
+  requestRedraw();
+}
+
 template <typename T>
 void ManagedBuffer<T>::updateIndexedViews() {
   checkDeviceBufferTypeIs(DeviceBufferType::Attribute);
@@ -404,12 +1056,107 @@ void ManagedBuffer<T>::updateIndexedViews() {
     render::AttributeBuffer& viewBuffer = *viewBufferPtr;
 
     // apply the indexing and set the data
+    populateIndexedView(indices, viewBuffer);
+  }
+
+  requestRedraw();
+}
+
+template <typename T>
+void ManagedBuffer<T>::populateIndexedView(ManagedBuffer<uint32_t>& indices, render::AttributeBuffer& viewBuffer) {
+
+  // If the data already lives on the device, try to expand it there without a round trip through the host
+  if (renderAttributeBuffer && renderAttributeBuffer->isSet()) {
+    std::shared_ptr<render::AttributeBuffer> indexBuffer = indices.getRenderAttributeBuffer();
+    if (render::engine->gatherAttributeBufferOnDevice(*renderAttributeBuffer, *indexBuffer, viewBuffer)) {
+      return;
+    }
+  }
+
+  // Fall back on gathering on the host, reading a view in place if we have one
+  if (currentCanonicalDataSource() == CanonicalDataSource::ExternalView) {
+    indices.ensureHostBufferPopulated();
+    ScratchVector<T> expandData(indices.data.size());
+    for (size_t i = 0; i < indices.data.size(); i++) {
+      if (indices.data[i] >= externalViewSize) exception("index out of bounds in indexed view of " + name);
+      expandData[i] = externalViewData[indices.data[i]];
+    }
+    viewBuffer.setData(*expandData);
+    return;
+  }
+  ensureHostBufferPopulated();
+  indices.ensureHostBufferPopulated();
+  ScratchVector<T> expandData;
+  gather(data, indices.data, *expandData);
+  viewBuffer.setData(*expandData);
+}
+
+template <typename T>
+void ManagedBuffer<T>::updateIndexedViewsRanges(const std::vector<std::array<size_t, 2>>& dirtyRanges) {
+  checkDeviceBufferTypeIs(DeviceBufferType::Attribute);
+
+  removeDeletedIndexedViews(); // periodic filtering
+
+  // view entries which are within this many entries of each other get uploaded as one run, rewriting the
+  // (unchanged) entries in between is cheaper than issuing many tiny transfers
+  const size_t RUN_MERGE_GAP = 32;
+
+  auto isDirty = [&](uint32_t ind) -> bool {
+    // first range whose end is > ind
+    auto it = std::upper_bound(dirtyRanges.begin(), dirtyRanges.end(), static_cast<size_t>(ind),
+                               [](size_t val, const std::array<size_t, 2>& r) { return val < r[1]; });
+    return it != dirtyRanges.end() && (*it)[0] <= ind;
+  };
+
+  for (std::tuple<render::ManagedBuffer<uint32_t>*, std::weak_ptr<render::AttributeBuffer>>& existingViewTup :
+       existingIndexedViews) {
+
+    std::shared_ptr<render::AttributeBuffer> viewBufferPtr = std::get<1>(existingViewTup).lock();
+    if (!viewBufferPtr) continue; // skip if it has been deleted (will be removed eventually)
+
+    // note: index buffer must still be alive here. we can't check it, you will just get memory errors
+    // if it has been deleted
+    render::ManagedBuffer<uint32_t>& indices = *std::get<0>(existingViewTup);
+    render::AttributeBuffer& viewBuffer = *viewBufferPtr;
     indices.ensureHostBufferPopulated();
-    std::vector<T> expandData = gather(data, indices.data);
-    viewBuffer.setData(expandData);
+    const std::vector<uint32_t>& inds = indices.data;
+
+    if (inds.empty()) { // (gather() treats an empty index as the identity)
+      viewBuffer.setData(data);
+      continue;
+    }
+
+    // Find runs of view entries which refer to a dirty entry
+    std::vector<std::array<size_t, 2>> viewRuns;
+    size_t viewDirtyCount = 0;
+    for (size_t i = 0; i < inds.size(); i++) {
+      if (!isDirty(inds[i])) continue;
+      if (!viewRuns.empty() && i <= viewRuns.back()[1] + RUN_MERGE_GAP) {
+        viewDirtyCount += i + 1 - viewRuns.back()[1];
+        viewRuns.back()[1] = i + 1;
+      } else {
+        viewRuns.push_back({i, i + 1});
+        viewDirtyCount++;
+      }
+    }
 
-    // TODO fornow, only CPU-side updating is supported. Add direct GPU-side support using the bufferIndexCopyProgram
-    // below.
+    if (2 * viewDirtyCount > inds.size()) {
+      // most of the view changed, just do a full update
+      ScratchVector<T> expandData;
+      gather(data, inds, *expandData);
+      viewBuffer.setData(*expandData);
+      continue;
+    }
+
+    // Gather and upload each run
+    ScratchVector<T> runData;
+    for (const std::array<size_t, 2>& run : viewRuns) {
+      runData->resize(run[1] - run[0]);
+      for (size_t i = run[0]; i < run[1]; i++) {
+        runData[i - run[0]] = data[inds[i]];
+      }
+      viewBuffer.setDataRange(*runData, 0, run[0], runData->size());
+    }
   }
 
   requestRedraw();
@@ -465,6 +1212,11 @@ typename ManagedBuffer<T>::CanonicalDataSource ManagedBuffer<T>::currentCanonica
     return CanonicalDataSource::HostData;
   }
 
+  // External memory is the next-best source, render buffers are only ever a mirror of it
+  if (usingExternalView) {
+    return CanonicalDataSource::ExternalView;
+  }
+
   // Check if the render buffer contains the canonical data
   if (renderAttributeBuffer || renderTextureBuffer) {
     return CanonicalDataSource::RenderBuffer;
@@ -481,22 +1233,6 @@ typename ManagedBuffer<T>::CanonicalDataSource ManagedBuffer<T>::currentCanonica
 }
 
 
-template <typename T>
-void ManagedBuffer<T>::ensureHaveBufferIndexCopyProgram() {
-  if (bufferIndexCopyProgram) return;
-
-  // sanity check
-  if (!renderAttributeBuffer) exception("ManagedBuffer " + name + " asked to copy indices, but has no buffers");
-
-  // TODO allocate the transform feedback program
-}
-
-template <typename T>
-void ManagedBuffer<T>::invokeBufferIndexCopyProgram() {
-  ensureHaveBufferIndexCopyProgram();
-  bufferIndexCopyProgram->draw();
-}
-
 // === Interact with the buffer registry
 
 std::tuple<bool, ManagedBufferType> ManagedBufferRegistry::hasManagedBufferType(std::string name) {
@@ -526,6 +1262,40 @@ std::tuple<bool, ManagedBufferType> ManagedBufferRegistry::hasManagedBufferType(
   return std::make_tuple(false, ManagedBufferType::Float);
 }
 
+MemoryUsage ManagedBufferRegistry::getManagedBufferMemoryUsage() {
+  MemoryUsage usage;
+  usage += managedBufferMap_float.getMemoryUsage();
+  usage += managedBufferMap_double.getMemoryUsage();
+  usage += managedBufferMap_vec2.getMemoryUsage();
+  usage += managedBufferMap_vec3.getMemoryUsage();
+  usage += managedBufferMap_vec4.getMemoryUsage();
+  usage += managedBufferMap_arr2vec3.getMemoryUsage();
+  usage += managedBufferMap_arr3vec3.getMemoryUsage();
+  usage += managedBufferMap_arr4vec3.getMemoryUsage();
+  usage += managedBufferMap_uint32.getMemoryUsage();
+  usage += managedBufferMap_int32.getMemoryUsage();
+  usage += managedBufferMap_uvec2.getMemoryUsage();
+  usage += managedBufferMap_uvec3.getMemoryUsage();
+  usage += managedBufferMap_uvec4.getMemoryUsage();
+  return usage;
+}
+
+void ManagedBufferRegistry::refreshIndexedViews(ManagedBuffer<uint32_t>& indices) {
+  managedBufferMap_float.refreshIndexedViews(indices);
+  managedBufferMap_double.refreshIndexedViews(indices);
+  managedBufferMap_vec2.refreshIndexedViews(indices);
+  managedBufferMap_vec3.refreshIndexedViews(indices);
+  managedBufferMap_vec4.refreshIndexedViews(indices);
+  managedBufferMap_arr2vec3.refreshIndexedViews(indices);
+  managedBufferMap_arr3vec3.refreshIndexedViews(indices);
+  managedBufferMap_arr4vec3.refreshIndexedViews(indices);
+  managedBufferMap_uint32.refreshIndexedViews(indices);
+  managedBufferMap_int32.refreshIndexedViews(indices);
+  managedBufferMap_uvec2.refreshIndexedViews(indices);
+  managedBufferMap_uvec3.refreshIndexedViews(indices);
+  managedBufferMap_uvec4.refreshIndexedViews(indices);
+}
+
 // === Explicit template instantiation for the supported types
 
 // Attribute versions
@@ -6,6 +6,7 @@
 #include "polyscope/messages.h"
 #include "polyscope/options.h"
 #include "polyscope/polyscope.h"
+#include "polyscope/trace.h"
 #include "polyscope/utilities.h"
 
 #include "polyscope/render/shader_builder.h"
@@ -39,8 +40,14 @@ MockGLEngine* glEngine = nullptr; // alias for engine pointer
 void initializeRenderEngine() {
   glEngine = new MockGLEngine();
   engine = glEngine;
-  glEngine->initialize();
-  engine->allocateGlobalBuffersAndPrograms();
+  {
+    StartupPhase phase("context");
+    glEngine->initialize();
+  }
+  {
+    StartupPhase phase("global buffers");
+    engine->allocateGlobalBuffersAndPrograms();
+  }
 }
 
 // == Map enums to native values
@@ -73,24 +80,34 @@ void GLAttributeBuffer::checkArray(int testArrayCount) {
 }
 
 
-template <typename T>
-void GLAttributeBuffer::setData_helper(const std::vector<T>& data) {
+void GLAttributeBuffer::setDataBytes_helper(const void* bytes, size_t nElements, size_t elementBytes) {
   bind();
+  contentVersion++;
 
   // allocate if needed
-  if (!isSet() || data.size() > bufferSize) {
+  if (!isSet() || nElements > bufferSize) {
     setFlag = true;
-    uint64_t newSize = data.size();
+    uint64_t newSize = nElements;
     newSize = std::max(newSize, 2 * bufferSize); // if we're expanding, at-least double
     bufferSize = newSize;
+    setDeviceMemoryBytes(bufferSize * elementBytes);
   }
 
   // do the actual copy
-  dataSize = data.size();
+  dataSize = nElements;
 
   checkGLError();
 }
 
+template <typename T>
+void GLAttributeBuffer::setData_helper(const std::vector<T>& data) {
+  setDataBytes_helper(data.empty() ? nullptr : &data[0], data.size(), getStorageElementBytes());
+}
+
+void GLAttributeBuffer::setDataFromPointer(const void* data, size_t nElements) {
+  setDataBytes_helper(data, nElements, getStorageElementBytes());
+}
+
 void GLAttributeBuffer::setData(const std::vector<glm::vec2>& data) {
   checkType(RenderDataType::Vector2Float);
   setData_helper(data);
@@ -165,6 +182,110 @@ void GLAttributeBuffer::setData(const std::vector<glm::uvec4>& data) {
   setData_helper(data);
 }
 
+// === set sub-ranges of data values
+
+template <typename T>
+void GLAttributeBuffer::setDataRange_helper(const std::vector<T>& data, size_t dataStart, size_t bufferStart,
+                                            size_t count) {
+  if (!isSet() || bufferStart + count > static_cast<size_t>(getDataSize())) exception("bad setDataRange");
+  if (dataStart + count > data.size()) exception("bad setDataRange, source range out of bounds");
+  if (count == 0) return;
+
+  bind();
+  contentVersion++;
+
+  checkGLError();
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::vec2>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Vector2Float);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::vec3>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Vector3Float);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<std::array<glm::vec3, 2>>& data, size_t dataStart,
+                                     size_t bufferStart, size_t count) {
+  checkType(RenderDataType::Vector3Float);
+  checkArray(2);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<std::array<glm::vec3, 3>>& data, size_t dataStart,
+                                     size_t bufferStart, size_t count) {
+  checkType(RenderDataType::Vector3Float);
+  checkArray(3);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<std::array<glm::vec3, 4>>& data, size_t dataStart,
+                                     size_t bufferStart, size_t count) {
+  checkType(RenderDataType::Vector3Float);
+  checkArray(4);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::vec4>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Vector4Float);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<float>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Float);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<double>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Float);
+  if (dataStart + count > data.size()) exception("bad setDataRange, source range out of bounds");
+
+  // Convert just the updated range of input data to floats
+  std::vector<float> floatData(count);
+  for (size_t i = 0; i < count; i++) {
+    floatData[i] = static_cast<float>(data[dataStart + i]);
+  }
+
+  setDataRange_helper(floatData, 0, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<int32_t>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Int);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<uint32_t>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::UInt);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::uvec2>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Vector2UInt);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::uvec3>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Vector3UInt);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::uvec4>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Vector4UInt);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
 
 // === get single data values
 
@@ -275,6 +396,24 @@ std::vector<glm::uvec4> GLAttributeBuffer::getDataRange_uvec4(size_t start, size
 }
 
 
+void GLAttributeBuffer::resizePreservingData(size_t newSize) {
+  contentVersion++;
+  if (!isSet() || newSize > bufferSize) {
+    uint64_t newCapacity = newSize;
+    newCapacity = std::max(newCapacity, 2 * bufferSize);
+    reserve(newCapacity);
+  }
+  dataSize = newSize;
+}
+
+void GLAttributeBuffer::reserve(size_t capacity) {
+  if (isSet() && capacity <= bufferSize) return;
+  if (!isSet()) dataSize = 0;
+  setFlag = true;
+  bufferSize = capacity;
+  setDeviceMemoryBytes(bufferSize * getStorageElementBytes());
+}
+
 uint32_t GLAttributeBuffer::getNativeBufferID() { return 777; }
 
 // =============================================================
@@ -315,6 +454,17 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, uns
   setFilterMode(FilterMode::Nearest);
 }
 
+GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_,
+                                 ExternalHandle externalHandle)
+    : TextureBuffer(2, format_, sizeX_, sizeY_) {
+
+  external = true;
+  updateDeviceMemoryBytes();
+  checkGLError();
+
+  setFilterMode(FilterMode::Nearest);
+}
+
 // create a 3D texture from data
 GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_, unsigned int sizeZ_,
                                  const unsigned char* data)
@@ -350,6 +500,7 @@ void GLTextureBuffer::resize(unsigned int newLen) {
 
 void GLTextureBuffer::resize(unsigned int newX, unsigned int newY) {
 
+  if (external) exception("OpenGL error: cannot resize an external texture");
   TextureBuffer::resize(newX, newY);
 
   bind();
@@ -461,6 +612,36 @@ void GLTextureBuffer::setData(const std::vector<std::array<glm::vec3, 2>>& data)
 void GLTextureBuffer::setData(const std::vector<std::array<glm::vec3, 3>>& data) { exception("not implemented"); };
 void GLTextureBuffer::setData(const std::vector<std::array<glm::vec3, 4>>& data) { exception("not implemented"); };
 
+void GLTextureBuffer::setDataRect(const void* data, int nChannels, PixelComponentType componentType, unsigned int x,
+                                  unsigned int y, unsigned int w, unsigned int h) {
+  if (dim != 2) exception("OpenGL error: setDataRect() is only for 2D textures");
+  if (x + w > sizeX || y + h > sizeY) {
+    exception("OpenGL error: texture data rectangle is out of bounds.");
+  }
+  if (nChannels < 1 || nChannels > 4) exception("OpenGL error: texture data must have 1-4 channels");
+  bind();
+  checkGLError();
+}
+
+void GLTextureBuffer::setDataBox(const void* data, int nChannels, PixelComponentType componentType, unsigned int x,
+                                 unsigned int y, unsigned int z, unsigned int w, unsigned int h, unsigned int d) {
+  if (dim != 3) exception("OpenGL error: setDataBox() is only for 3D textures");
+  if (x + w > sizeX || y + h > sizeY || z + d > sizeZ) {
+    exception("OpenGL error: texture data box is out of bounds.");
+  }
+  if (nChannels < 1 || nChannels > 4) exception("OpenGL error: texture data must have 1-4 channels");
+  bind();
+  checkGLError();
+}
+
+void GLTextureBuffer::setDataFromDeviceBuffer(uint32_t nativeBufferHandle, int nChannels,
+                                              PixelComponentType componentType) {
+  if (dim != 2) exception("OpenGL error: setDataFromDeviceBuffer() is only for 2D textures");
+  if (nChannels < 1 || nChannels > 4) exception("OpenGL error: texture data must have 1-4 channels");
+  bind();
+  checkGLError();
+}
+
 void GLTextureBuffer::setFilterMode(FilterMode newMode) {
 
   bind();
@@ -514,6 +695,15 @@ std::vector<glm::vec3> GLTextureBuffer::getDataVector3() {
 
   return outData;
 }
+std::vector<glm::vec4> GLTextureBuffer::getDataVector4() {
+  if (dimension(format) != 4) exception("called getDataVector4 on texture which does not have a 4 dimensional format");
+
+  std::vector<glm::vec4> outData;
+  outData.resize(getSizeX() * getSizeY());
+
+  return outData;
+}
+
 void GLTextureBuffer::bind() {
   if (dim == 1) {
   }
@@ -652,12 +842,44 @@ std::array<float, 4> GLFrameBuffer::readFloat4(int xPos, int yPos) {
   return result;
 }
 
+std::vector<float> GLFrameBuffer::readFloat4Region(int xPos, int yPos, int width, int height) {
+  // Read from the buffer
+  std::vector<float> result;
+  for (int i = 0; i < width * height; i++) {
+    std::array<float, 4> pixel = readFloat4(xPos + i % width, yPos + i / width);
+    result.insert(result.end(), pixel.begin(), pixel.end());
+  }
+  return result;
+}
+
+std::array<uint32_t, 2> GLFrameBuffer::readUInt2(int xPos, int yPos) {
+  // Read from the buffer
+  std::array<uint32_t, 2> result = {0, 0};
+
+  return result;
+}
+
+std::vector<uint32_t> GLFrameBuffer::readUInt2Region(int xPos, int yPos, int width, int height) {
+  // Read from the buffer
+  std::vector<uint32_t> result;
+  for (int i = 0; i < width * height; i++) {
+    std::array<uint32_t, 2> pixel = readUInt2(xPos + i % width, yPos + i / width);
+    result.insert(result.end(), pixel.begin(), pixel.end());
+  }
+  return result;
+}
+
 float GLFrameBuffer::readDepth(int xPos, int yPos) {
   // Read from the buffer
   float result = 0.5;
   return result;
 }
 
+std::vector<float> GLFrameBuffer::readDepthBuffer() {
+  // Read from the buffer
+  return std::vector<float>(static_cast<size_t>(getSizeX()) * getSizeY(), 0.5);
+}
+
 std::vector<unsigned char> GLFrameBuffer::readBuffer() {
   bind();
 
@@ -737,11 +959,14 @@ void GLCompiledProgram::addUniqueAttribute(ShaderSpecAttribute newAttribute) {
       // if it occurs twice, confirm that the occurences match
       if (a.type != newAttribute.type)
         exception("attribute " + a.name + " appears twice in program with different types");
+      if (a.perInstance != newAttribute.perInstance)
+        exception("attribute " + a.name + " appears twice in program with different instancing");
 
       return;
     }
   }
-  attributes.push_back(GLShaderAttribute{newAttribute.name, newAttribute.type, newAttribute.arrayCount, nullptr});
+  attributes.push_back(GLShaderAttribute{newAttribute.name, newAttribute.type, newAttribute.arrayCount,
+                                         newAttribute.perInstance, nullptr});
 }
 
 void GLCompiledProgram::addUniqueUniform(ShaderSpecUniform newUniform) {
@@ -814,13 +1039,14 @@ void GLShaderProgram::setAttribute(std::string name, std::shared_ptr<AttributeBu
                                     renderDataTypeName(a.type) + " set with buffer of type " +
                                     renderDataTypeName(externalBuffer->getType()));
 
-      // check multiple-set errors (duplicates in externalBuffers list?)
-      if (a.buff) throw std::invalid_argument("attribute " + name + " is already set");
-
       // cast to the engine type (booooooo)
       std::shared_ptr<GLAttributeBuffer> engineExtBuff = std::dynamic_pointer_cast<GLAttributeBuffer>(externalBuffer);
       if (!engineExtBuff) throw std::invalid_argument("attribute " + name + " external buffer engine type cast failed");
 
+      // Setting the same buffer again does nothing. Setting a different one re-binds the attribute, which lets the
+      // source of a per-element value be swapped without rebuilding the program.
+      if (a.buff == engineExtBuff) return;
+
       a.buff = engineExtBuff;
 
       a.buff->bind();
@@ -897,211 +1123,130 @@ bool GLShaderProgram::hasUniform(std::string name) {
   return false;
 }
 
-// Set an integer
-void GLShaderProgram::setUniform(std::string name, int val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Int) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
+UniformHandle GLShaderProgram::getUniformHandle(std::string name) {
+  for (size_t iU = 0; iU < uniforms.size(); iU++) {
+    if (uniforms[iU].name == name) {
+      UniformHandle handle;
+      handle.index = static_cast<int32_t>(iU);
+      return handle;
     }
   }
   throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
 
+GLShaderUniform& GLShaderProgram::resolveUniform(UniformHandle handle, RenderDataType type) {
+  if (handle.index < 0 || handle.index >= static_cast<int32_t>(uniforms.size())) {
+    throw std::invalid_argument("Tried to set uniform with invalid handle");
+  }
+  GLShaderUniform& u = uniforms[handle.index];
+  if (u.type != type) {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
+  }
+  return u;
+}
+
+// Set an integer
+void GLShaderProgram::setUniform(std::string name, int val) {
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, int val) {
+  resolveUniform(handle, RenderDataType::Int).isSet = true;
+}
+
 // Set an unsigned integer
 void GLShaderProgram::setUniform(std::string name, unsigned int val) {
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::UInt) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, unsigned int val) {
+  resolveUniform(handle, RenderDataType::UInt).isSet = true;
 }
 
 // Set a float
 void GLShaderProgram::setUniform(std::string name, float val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, float val) {
+  resolveUniform(handle, RenderDataType::Float).isSet = true;
 }
 
 // Set a double --- WARNING casts down to float
 void GLShaderProgram::setUniform(std::string name, double val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, double val) {
+  resolveUniform(handle, RenderDataType::Float).isSet = true;
 }
 
 // Set a 4x4 uniform matrix
 void GLShaderProgram::setUniform(std::string name, float* val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Matrix44Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, float* val) {
+  resolveUniform(handle, RenderDataType::Matrix44Float).isSet = true;
 }
 
 // Set a vector2 uniform
 void GLShaderProgram::setUniform(std::string name, glm::vec2 val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector2Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, glm::vec2 val) {
+  resolveUniform(handle, RenderDataType::Vector2Float).isSet = true;
 }
 
 // Set a vector3 uniform
 void GLShaderProgram::setUniform(std::string name, glm::vec3 val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector3Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, glm::vec3 val) {
+  resolveUniform(handle, RenderDataType::Vector3Float).isSet = true;
 }
 
 // Set a vector4 uniform
 void GLShaderProgram::setUniform(std::string name, glm::vec4 val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector4Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, glm::vec4 val) {
+  resolveUniform(handle, RenderDataType::Vector4Float).isSet = true;
 }
 
 // Set a vector3 uniform from a float array
 void GLShaderProgram::setUniform(std::string name, std::array<float, 3> val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector3Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, std::array<float, 3> val) {
+  resolveUniform(handle, RenderDataType::Vector3Float).isSet = true;
 }
 
 // Set a vec4 uniform
 void GLShaderProgram::setUniform(std::string name, float x, float y, float z, float w) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector4Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), x, y, z, w);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, float x, float y, float z, float w) {
+  resolveUniform(handle, RenderDataType::Vector4Float).isSet = true;
 }
 
 // Set a uint vector2 uniform
 void GLShaderProgram::setUniform(std::string name, glm::uvec2 val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector2UInt) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, glm::uvec2 val) {
+  resolveUniform(handle, RenderDataType::Vector2UInt).isSet = true;
 }
 
 // Set a uint vector3 uniform
 void GLShaderProgram::setUniform(std::string name, glm::uvec3 val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector3UInt) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, glm::uvec3 val) {
+  resolveUniform(handle, RenderDataType::Vector3UInt).isSet = true;
 }
 
 // Set a uint vector4 uniform
 void GLShaderProgram::setUniform(std::string name, glm::uvec4 val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector4UInt) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, glm::uvec4 val) {
+  resolveUniform(handle, RenderDataType::Vector4UInt).isSet = true;
 }
 
 bool GLShaderProgram::hasAttribute(std::string name) {
@@ -1345,7 +1490,7 @@ void GLShaderProgram::setTextureFromBuffer(std::string name, TextureBuffer* text
 }
 
 void GLShaderProgram::setTextureFromColormap(std::string name, const std::string& colormapName, bool allowUpdate) {
-  const ValueColorMap& colormap = render::engine->getColorMap(colormapName);
+  int row = engine->getColorMapAtlasRow(colormapName);
 
   // Find the right texture
   for (GLShaderTexture& t : textures) {
@@ -1355,27 +1500,16 @@ void GLShaderProgram::setTextureFromColormap(std::string name, const std::string
       throw std::invalid_argument("Attempted to set texture twice");
     }
 
-    if (t.dim != 1) {
+    if (t.dim != 2) {
       throw std::invalid_argument("Tried to use texture with mismatched dimension " + std::to_string(t.dim));
     }
 
-    // Fill a buffer with the data
-    unsigned int dataLength = colormap.values.size() * 3;
-    std::vector<float> colorBuffer(dataLength);
-    for (unsigned int i = 0; i < colormap.values.size(); i++) {
-      colorBuffer[3 * i + 0] = static_cast<float>(colormap.values[i][0]);
-      colorBuffer[3 * i + 1] = static_cast<float>(colormap.values[i][1]);
-      colorBuffer[3 * i + 2] = static_cast<float>(colormap.values[i][2]);
-    }
-
-    // glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, colormap.values.size(), 0, GL_RGB, GL_FLOAT, &(colorBuffer[0]));
-    t.textureBufferOwned = std::dynamic_pointer_cast<GLTextureBuffer>(
-        engine->generateTextureBuffer(TextureFormat::RGB32F, colormap.values.size(), &(colorBuffer[0])));
-    t.textureBufferOwned->setFilterMode(FilterMode::Linear);
-    t.textureBuffer = t.textureBufferOwned.get();
-
-
+    // all color maps are rows of the shared atlas
+    t.textureBufferOwned.reset();
+    t.textureBuffer = dynamic_cast<GLTextureBuffer*>(&engine->getColorMapAtlas());
     t.isSet = true;
+
+    setUniform(colormapRowUniformName(name), row);
     return;
   }
 
@@ -1438,7 +1572,7 @@ void GLShaderProgram::validateData() {
 
   // Check attributes
   int64_t attributeSize = -1;
-  for (GLShaderAttribute a : attributes) {
+  for (const GLShaderAttribute& a : attributes) {
     if (!a.buff) {
       throw std::invalid_argument("Attribute " + a.name + " has no buffer attached");
     }
@@ -1448,6 +1582,16 @@ void GLShaderProgram::validateData() {
 
     int compatCount = renderDataTypeCountCompatbility(a.type, a.buff->getType());
 
+    // per-instance attributes just need an entry for each instance, they do not set the vertex count
+    if (a.perInstance) {
+      if (instanceCount != INVALID_IND_32 && a.buff->getDataSize() / compatCount < instanceCount) {
+        throw std::invalid_argument("Per-instance attribute " + a.name + " has size " +
+                                    std::to_string(a.buff->getDataSize()) + ", but instance count is " +
+                                    std::to_string(instanceCount));
+      }
+      continue;
+    }
+
     if (attributeSize == -1) { // first one we've seen
       attributeSize = a.buff->getDataSize() / (compatCount);
     } else { // not the first one we've seen
@@ -1551,6 +1695,29 @@ void GLShaderProgram::draw() {
   if (usePrimitiveRestart) {
   }
 
+  countDrawCall(drawDataLength);
+  checkGLError();
+}
+
+void GLShaderProgram::drawSubset(AttributeBuffer& elementOrder, const std::vector<std::array<size_t, 2>>& ranges) {
+  if (drawMode != DrawMode::Triangles && drawMode != DrawMode::IndexedTriangles && drawMode != DrawMode::Points) {
+    throw std::invalid_argument(
+        "drawSubset() is only supported for DrawMode::Triangles, DrawMode::IndexedTriangles and DrawMode::Points");
+  }
+  if (elementOrder.getType() != RenderDataType::UInt) {
+    throw std::invalid_argument("drawSubset() element order buffer should be UInt");
+  }
+
+  validateData();
+  activateTextures();
+
+  for (const std::array<size_t, 2>& range : ranges) {
+    if (range[0] + range[1] > static_cast<size_t>(elementOrder.getDataSize())) {
+      throw std::invalid_argument("drawSubset() range is out of bounds of the element order buffer");
+    }
+    countDrawCall(range[1]);
+  }
+
   checkGLError();
 }
 
@@ -1655,6 +1822,7 @@ void MockGLEngine::ImGuiNewFrame() {
   ImGuiIO& io = ImGui::GetIO();
   io.DisplaySize.x = view::bufferWidth;
   io.DisplaySize.y = view::bufferHeight;
+  if (fixedFrameDeltaTime > 0.f) io.DeltaTime = fixedFrameDeltaTime;
 
   ImGui::NewFrame();
 }
@@ -1724,6 +1892,11 @@ std::shared_ptr<TextureBuffer> MockGLEngine::generateTextureBuffer(TextureFormat
   GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, sizeZ_, data);
   return std::shared_ptr<TextureBuffer>(newT);
 }
+std::shared_ptr<TextureBuffer> MockGLEngine::wrapExternalTexture(TextureFormat format, unsigned int sizeX_,
+                                                                 unsigned int sizeY_, uint32_t nativeHandle) {
+  GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, GLTextureBuffer::ExternalHandle{nativeHandle});
+  return std::shared_ptr<TextureBuffer>(newT);
+}
 
 
 std::shared_ptr<RenderBuffer> MockGLEngine::generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
@@ -1782,6 +1955,14 @@ std::string MockGLEngine::programKeyFromRules(const std::string& programName, co
 }
 
 
+bool MockGLEngine::shaderVariantAvailable(const ShaderProgramRequest& request) {
+  if (registeredShaderPrograms.find(request.programName) == registeredShaderPrograms.end()) return false;
+  for (const std::string& rule : request.customRules) {
+    if (rule != "" && registeredShaderRules.find(rule) == registeredShaderRules.end()) return false;
+  }
+  return true;
+}
+
 std::shared_ptr<GLCompiledProgram> MockGLEngine::getCompiledProgram(const std::string& programName,
                                                                     const std::vector<std::string>& customRules,
                                                                     ShaderReplacementDefaults defaults) {
@@ -1794,6 +1975,7 @@ std::shared_ptr<GLCompiledProgram> MockGLEngine::getCompiledProgram(const std::s
   if (compiledProgamCache.find(progKey) == compiledProgamCache.end()) {
 
     if (polyscope::options::verbosity > 3) polyscope::info("compiling shader program " + progKey);
+    POLYSCOPE_TRACE_SPAN("compileShaderProgram", programName);
 
     // == Compile the program
 
@@ -1859,6 +2041,8 @@ std::shared_ptr<GLCompiledProgram> MockGLEngine::getCompiledProgram(const std::s
 
     // Create a new compiled program (GL work happens in the constructor)
     compiledProgamCache[progKey] = std::shared_ptr<GLCompiledProgram>(new GLCompiledProgram(updatedStages, dm));
+
+    recordShaderVariant(programName, customRules, defaults);
   }
 
   // Now that the cache must contain the compiled program, just return it
@@ -1893,20 +2077,29 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registerShaderProgram("MESH", {FLEX_MESH_VERT_SHADER, FLEX_MESH_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("INDEXED_MESH", {FLEX_MESH_VERT_SHADER, FLEX_MESH_FRAG_SHADER}, DrawMode::IndexedTriangles);
   registerShaderProgram("SIMPLE_MESH", {SIMPLE_MESH_VERT_SHADER, SIMPLE_MESH_FRAG_SHADER}, DrawMode::IndexedTriangles);
+  registerShaderProgram("INSTANCED_MESH", {INSTANCED_MESH_VERT_SHADER, SIMPLE_MESH_FRAG_SHADER}, DrawMode::TrianglesInstanced);
   registerShaderProgram("SLICE_TETS", {SLICE_TETS_VERT_SHADER, SLICE_TETS_GEOM_SHADER, SLICE_TETS_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("RAYCAST_SPHERE", {FLEX_SPHERE_VERT_SHADER, FLEX_SPHERE_GEOM_SHADER, FLEX_SPHERE_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("POINT_QUAD", {FLEX_POINTQUAD_VERT_SHADER, FLEX_POINTQUAD_GEOM_SHADER, FLEX_POINTQUAD_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("POINT_SPLAT", {FLEX_SPLAT_VERT_SHADER, FLEX_SPHERE_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("GRIDCUBE", {FLEX_GRIDCUBE_VERT_SHADER, FLEX_GRIDCUBE_GEOM_SHADER, FLEX_GRIDCUBE_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("GRIDCUBE_PLANE", {FLEX_GRIDCUBE_PLANE_VERT_SHADER, FLEX_GRIDCUBE_PLANE_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("GRID_ISOSURFACE_RAYMARCH", {FLEX_GRID_ISOSURFACE_VERT_SHADER, FLEX_GRID_ISOSURFACE_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("GRID_VOLUME_RAYMARCH", {FLEX_GRID_ISOSURFACE_VERT_SHADER, FLEX_GRID_VOLUME_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("RAYCAST_VECTOR", {FLEX_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("RAYCAST_TANGENT_VECTOR", {FLEX_TANGENT_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("RAYCAST_VECTOR_INSTANCED", {FLEX_VECTOR_INSTANCED_VERT_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::TriangleStripInstanced);
+  registerShaderProgram("RAYCAST_TANGENT_VECTOR_INSTANCED", {FLEX_TANGENT_VECTOR_INSTANCED_VERT_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::TriangleStripInstanced);
   registerShaderProgram("RAYCAST_CYLINDER", {FLEX_CYLINDER_VERT_SHADER, FLEX_CYLINDER_GEOM_SHADER, FLEX_CYLINDER_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("RAYCAST_CYLINDER_STRIP", {FLEX_CYLINDER_STRIP_VERT_SHADER, FLEX_CYLINDER_STRIP_GEOM_SHADER, FLEX_CYLINDER_FRAG_SHADER}, DrawMode::IndexedLineStrip);
+  registerShaderProgram("RAYCAST_CYLINDER_INSTANCED", {FLEX_CYLINDER_INSTANCED_VERT_SHADER, FLEX_CYLINDER_INSTANCED_FRAG_SHADER}, DrawMode::TriangleStripInstanced);
   registerShaderProgram("HISTOGRAM", {HISTOGRAM_VERT_SHADER, HISTOGRAM_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("GROUND_PLANE_TILE", {GROUND_PLANE_VERT_SHADER, GROUND_PLANE_TILE_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("GROUND_PLANE_TILE_REFLECT", {GROUND_PLANE_VERT_SHADER, GROUND_PLANE_TILE_REFLECT_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("GROUND_PLANE_SHADOW", {GROUND_PLANE_VERT_SHADER, GROUND_PLANE_SHADOW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("MAP_LIGHT", {TEXTURE_DRAW_VERT_SHADER, MAP_LIGHT_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("RIBBON", {RIBBON_VERT_SHADER, RIBBON_GEOM_SHADER, RIBBON_FRAG_SHADER}, DrawMode::IndexedLineStripAdjacency);
+  registerShaderProgram("RIBBON_INSTANCED", {RIBBON_INSTANCED_VERT_SHADER, RIBBON_FRAG_SHADER}, DrawMode::TriangleStripInstanced);
   registerShaderProgram("SLICE_PLANE", {SLICE_PLANE_VERT_SHADER, SLICE_PLANE_FRAG_SHADER}, DrawMode::Triangles);
 
   registerShaderProgram("TEXTURE_DRAW_PLAIN", {TEXTURE_DRAW_VERT_SHADER, PLAIN_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
@@ -1915,11 +2108,15 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registerShaderProgram("TEXTURE_DRAW_SPHEREBG", {SPHEREBG_DRAW_VERT_SHADER, SPHEREBG_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("TEXTURE_DRAW_RENDERIMAGE_PLAIN", {TEXTURE_DRAW_VERT_SHADER, PLAIN_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("TEXTURE_DRAW_RAW_RENDERIMAGE_PLAIN", {TEXTURE_DRAW_VERT_SHADER, PLAIN_RAW_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("TEXTURE_DRAW_RENDERIMAGE_COMPOSITE", {TEXTURE_DRAW_VERT_SHADER, COMPOSITE_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("COMPOSITE_PEEL", {TEXTURE_DRAW_VERT_SHADER, COMPOSITE_PEEL}, DrawMode::Triangles);
+  registerShaderProgram("COMPOSITE_WEIGHTED", {TEXTURE_DRAW_VERT_SHADER, COMPOSITE_WEIGHTED}, DrawMode::Triangles);
+  registerShaderProgram("TAA_RESOLVE", {TEXTURE_DRAW_VERT_SHADER, TAA_RESOLVE}, DrawMode::Triangles);
   registerShaderProgram("DEPTH_COPY", {TEXTURE_DRAW_VERT_SHADER, DEPTH_COPY}, DrawMode::Triangles);
   registerShaderProgram("DEPTH_TO_MASK", {TEXTURE_DRAW_VERT_SHADER, DEPTH_TO_MASK}, DrawMode::Triangles);
   registerShaderProgram("SCALAR_TEXTURE_COLORMAP", {TEXTURE_DRAW_VERT_SHADER, SCALAR_TEXTURE_COLORMAP}, DrawMode::Triangles);
   registerShaderProgram("BLUR_RGB", {TEXTURE_DRAW_VERT_SHADER, BLUR_RGB}, DrawMode::Triangles);
+  registerShaderProgram("BLUR_RGBA", {TEXTURE_DRAW_VERT_SHADER, BLUR_RGBA}, DrawMode::Triangles);
   registerShaderProgram("TRANSFORMATION_GIZMO_ROT", {TRANSFORMATION_GIZMO_ROT_VERT, TRANSFORMATION_GIZMO_ROT_FRAG}, DrawMode::Triangles);
 
   // === Load rules
@@ -1931,21 +2128,33 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("DOWNSAMPLE_RESOLVE_2", DOWNSAMPLE_RESOLVE_2);
   registerShaderRule("DOWNSAMPLE_RESOLVE_3", DOWNSAMPLE_RESOLVE_3);
   registerShaderRule("DOWNSAMPLE_RESOLVE_4", DOWNSAMPLE_RESOLVE_4);
+  registerShaderRule("RESOLVE_FXAA", RESOLVE_FXAA);
   
   registerShaderRule("TRANSPARENCY_STRUCTURE", TRANSPARENCY_STRUCTURE);
   registerShaderRule("TRANSPARENCY_RESOLVE_SIMPLE", TRANSPARENCY_RESOLVE_SIMPLE);
   registerShaderRule("TRANSPARENCY_PEEL_STRUCTURE", TRANSPARENCY_PEEL_STRUCTURE);
+  registerShaderRule("TRANSPARENCY_WEIGHTED_STRUCTURE", TRANSPARENCY_WEIGHTED_STRUCTURE);
   registerShaderRule("TRANSPARENCY_PEEL_GROUND", TRANSPARENCY_PEEL_GROUND);
+  registerShaderRule("DEPTH_PREPASS_STRUCTURE", DEPTH_PREPASS_STRUCTURE);
+  registerShaderRule("GROUND_REFLECT_SCREEN_SPACE", GROUND_REFLECT_SCREEN_SPACE);
   
   registerShaderRule("GENERATE_VIEW_POS", GENERATE_VIEW_POS);
   registerShaderRule("COMPUTE_SHADE_NORMAL_FROM_POSITION", COMPUTE_SHADE_NORMAL_FROM_POSITION);
   registerShaderRule("PREMULTIPLY_LIT_COLOR", PREMULTIPLY_LIT_COLOR);
+  registerShaderRule("KEYFRAME_COMMON", KEYFRAME_COMMON);
+  registerShaderRule("KEYFRAME_INDEX", KEYFRAME_INDEX);
+  registerShaderRule("KEYFRAME_POSITION", KEYFRAME_POSITION);
+  registerShaderRule("KEYFRAME_VALUE", KEYFRAME_VALUE);
   registerShaderRule("CULL_POS_FROM_VIEW", CULL_POS_FROM_VIEW);
+  registerShaderRule("SLICE_PLANE_CULL", generateSlicePlaneRule());
+  registerShaderRule("SLICE_PLANE_VOLUMEGRID_CULL", generateVolumeGridSlicePlaneRule());
   registerShaderRule("PROJ_AND_INV_PROJ_MAT", PROJ_AND_INV_PROJ_MAT);
 
   // Lighting and shading things
   registerShaderRule("LIGHT_MATCAP", LIGHT_MATCAP);
+  registerShaderRule("LIGHT_MATCAP_ARRAY", LIGHT_MATCAP_ARRAY);
   registerShaderRule("LIGHT_PASSTHRU", LIGHT_PASSTHRU);
+  registerShaderRule("PICK_OUTPUT_INDEX", PICK_OUTPUT_INDEX);
   registerShaderRule("SHADE_BASECOLOR", SHADE_BASECOLOR);
   registerShaderRule("SHADE_COLOR", SHADE_COLOR);
   registerShaderRule("SHADECOLOR_FROM_UNIFORM", SHADECOLOR_FROM_UNIFORM);
@@ -1970,6 +2179,7 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("TEXTURE_PROPAGATE_VALUE", TEXTURE_PROPAGATE_VALUE);
   registerShaderRule("TEXTURE_PROPAGATE_COLOR", TEXTURE_PROPAGATE_COLOR);
   registerShaderRule("TEXTURE_BILLBOARD_FROM_UNIFORMS", TEXTURE_BILLBOARD_FROM_UNIFORMS);
+  registerShaderRule("TEXTURE_TILE_FROM_UNIFORMS", TEXTURE_TILE_FROM_UNIFORMS);
   registerShaderRule("SHADE_NORMAL_FROM_TEXTURE", SHADE_NORMAL_FROM_TEXTURE);
   registerShaderRule("SHADE_NORMAL_FROM_VIEWPOS_VAR", SHADE_NORMAL_FROM_VIEWPOS_VAR);
 
@@ -1987,14 +2197,25 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("MESH_PROPAGATE_TCOORD", MESH_PROPAGATE_TCOORD);
   registerShaderRule("MESH_PROPAGATE_COLOR", MESH_PROPAGATE_COLOR);
   registerShaderRule("MESH_PROPAGATE_HALFEDGE_VALUE", MESH_PROPAGATE_HALFEDGE_VALUE);
+  registerShaderRule("MESH_FETCH_VALUE", MESH_FETCH_VALUE);
+  registerShaderRule("MESH_FETCH_HALFEDGE_VALUE", MESH_FETCH_HALFEDGE_VALUE);
+  registerShaderRule("MESH_FETCH_COLOR", MESH_FETCH_COLOR);
+  registerShaderRule("MESH_PROPAGATE_SELECTION", MESH_PROPAGATE_SELECTION);
   registerShaderRule("MESH_PROPAGATE_CULLPOS", MESH_PROPAGATE_CULLPOS);
+  registerShaderRule("MESH_KEYFRAME_POSITIONS", MESH_KEYFRAME_POSITIONS);
   registerShaderRule("MESH_PROPAGATE_TYPE_AND_BASECOLOR2_SHADE", MESH_PROPAGATE_TYPE_AND_BASECOLOR2_SHADE);
   registerShaderRule("MESH_PROPAGATE_PICK", MESH_PROPAGATE_PICK);
   registerShaderRule("MESH_PROPAGATE_PICK_SIMPLE", MESH_PROPAGATE_PICK_SIMPLE);
+  registerShaderRule("INSTANCED_MESH_PROPAGATE_COLOR", INSTANCED_MESH_PROPAGATE_COLOR);
+  registerShaderRule("INSTANCED_MESH_PROPAGATE_VALUE", INSTANCED_MESH_PROPAGATE_VALUE);
+  registerShaderRule("INSTANCED_MESH_PROPAGATE_PICK", INSTANCED_MESH_PROPAGATE_PICK);
   
   // volume gridcube things
   registerShaderRule("GRIDCUBE_PROPAGATE_NODE_VALUE", GRIDCUBE_PROPAGATE_NODE_VALUE);
   registerShaderRule("GRIDCUBE_PROPAGATE_CELL_VALUE", GRIDCUBE_PROPAGATE_CELL_VALUE);
+  registerShaderRule("GRIDCUBE_PROPAGATE_SPARSE_NODE_VALUE", GRIDCUBE_PROPAGATE_SPARSE_NODE_VALUE);
+  registerShaderRule("GRIDCUBE_PROPAGATE_SPARSE_CELL_VALUE", GRIDCUBE_PROPAGATE_SPARSE_CELL_VALUE);
+  registerShaderRule("GRIDCUBE_SPARSE_OCCUPANCY", GRIDCUBE_SPARSE_OCCUPANCY);
   registerShaderRule("GRIDCUBE_WIREFRAME", GRIDCUBE_WIREFRAME);
   registerShaderRule("GRIDCUBE_CONSTANT_PICK", GRIDCUBE_CONSTANT_PICK);
   registerShaderRule("GRIDCUBE_CULLPOS_FROM_CENTER", GRIDCUBE_CULLPOS_FROM_CENTER);
@@ -2004,9 +2225,16 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("SPHERE_PROPAGATE_VALUEALPHA", SPHERE_PROPAGATE_VALUEALPHA);
   registerShaderRule("SPHERE_PROPAGATE_VALUE2", SPHERE_PROPAGATE_VALUE2);
   registerShaderRule("SPHERE_PROPAGATE_COLOR", SPHERE_PROPAGATE_COLOR);
+  registerShaderRule("SPHERE_PROPAGATE_SELECTION", SPHERE_PROPAGATE_SELECTION);
   registerShaderRule("SPHERE_CULLPOS_FROM_CENTER", SPHERE_CULLPOS_FROM_CENTER);
   registerShaderRule("SPHERE_CULLPOS_FROM_CENTER_QUAD", SPHERE_CULLPOS_FROM_CENTER_QUAD);
   registerShaderRule("SPHERE_VARIABLE_SIZE", SPHERE_VARIABLE_SIZE);
+  registerShaderRule("SPLAT_PROPAGATE_VALUE", SPLAT_PROPAGATE_VALUE);
+  registerShaderRule("SPLAT_PROPAGATE_VALUEALPHA", SPLAT_PROPAGATE_VALUEALPHA);
+  registerShaderRule("SPLAT_PROPAGATE_VALUE2", SPLAT_PROPAGATE_VALUE2);
+  registerShaderRule("SPLAT_PROPAGATE_COLOR", SPLAT_PROPAGATE_COLOR);
+  registerShaderRule("SPLAT_PROPAGATE_SELECTION", SPLAT_PROPAGATE_SELECTION);
+  registerShaderRule("SPLAT_VARIABLE_SIZE", SPLAT_VARIABLE_SIZE);
 
   // vector things
   registerShaderRule("VECTOR_PROPAGATE_COLOR", VECTOR_PROPAGATE_COLOR);
@@ -2021,6 +2249,14 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("CYLINDER_PROPAGATE_PICK", CYLINDER_PROPAGATE_PICK);
   registerShaderRule("CYLINDER_CULLPOS_FROM_MID", CYLINDER_CULLPOS_FROM_MID);
   registerShaderRule("CYLINDER_VARIABLE_SIZE", CYLINDER_VARIABLE_SIZE);
+  registerShaderRule("CYLINDER_KEYFRAME_POSITIONS", CYLINDER_KEYFRAME_POSITIONS);
+  registerShaderRule("CYLINDER_INSTANCED_PROPAGATE_VALUE", CYLINDER_INSTANCED_PROPAGATE_VALUE);
+  registerShaderRule("CYLINDER_INSTANCED_PROPAGATE_BLEND_VALUE", CYLINDER_INSTANCED_PROPAGATE_BLEND_VALUE);
+  registerShaderRule("CYLINDER_INSTANCED_PROPAGATE_COLOR", CYLINDER_INSTANCED_PROPAGATE_COLOR);
+  registerShaderRule("CYLINDER_INSTANCED_PROPAGATE_BLEND_COLOR", CYLINDER_INSTANCED_PROPAGATE_BLEND_COLOR);
+  registerShaderRule("CYLINDER_INSTANCED_PROPAGATE_PICK", CYLINDER_INSTANCED_PROPAGATE_PICK);
+  registerShaderRule("CYLINDER_INSTANCED_VARIABLE_SIZE", CYLINDER_INSTANCED_VARIABLE_SIZE);
+  registerShaderRule("CYLINDER_INSTANCED_KEYFRAME_POSITIONS", CYLINDER_INSTANCED_KEYFRAME_POSITIONS);
 
   // marching tets things
   registerShaderRule("SLICE_TETS_BASECOLOR_SHADE", SLICE_TETS_BASECOLOR_SHADE);
@@ -2033,13 +2269,6 @@ void MockGLEngine::populateDefaultShadersAndRules() {
 };
 
 
-void MockGLEngine::createSlicePlaneFliterRule(std::string uniquePostfix) {
-  using namespace backend_openGL3;
-  registeredShaderRules.insert({"SLICE_PLANE_CULL_" + uniquePostfix, generateSlicePlaneRule(uniquePostfix)});
-  registeredShaderRules.insert(
-      {"SLICE_PLANE_VOLUMEGRID_CULL_" + uniquePostfix, generateVolumeGridSlicePlaneRule(uniquePostfix)});
-}
-
 } // namespace backend_openGL_mock
 } // namespace render
 } // namespace polyscope
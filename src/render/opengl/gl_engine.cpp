@@ -8,6 +8,8 @@
 #include "polyscope/messages.h"
 #include "polyscope/options.h"
 #include "polyscope/polyscope.h"
+#include "polyscope/scratch_buffer.h"
+#include "polyscope/trace.h"
 #include "polyscope/utilities.h"
 
 #include "polyscope/render/shader_builder.h"
@@ -31,7 +33,33 @@
 #include "stb_image.h"
 
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
 #include <set>
+#include <sstream>
+
+// Enums and calling convention for the optional entry points below, which the bundled 3.3 core glad does not provide
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+#ifdef _WIN32
+#define POLYSCOPE_GL_APIENTRY __stdcall
+#else
+#define POLYSCOPE_GL_APIENTRY
+#endif
 
 namespace polyscope {
 namespace render {
@@ -40,6 +68,71 @@ namespace backend_openGL3 {
 
 GLEngine* glEngine = nullptr; // alias for global engine pointer
 
+// == Optional GL entry points, null if unavailable (see GLEngine::loadOptionalGLFunctions())
+
+namespace {
+
+typedef void(POLYSCOPE_GL_APIENTRY* GetProgramBinaryFunc)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+typedef void(POLYSCOPE_GL_APIENTRY* ProgramBinaryFunc)(GLuint, GLenum, const void*, GLsizei);
+typedef void(POLYSCOPE_GL_APIENTRY* ProgramParameteriFunc)(GLuint, GLenum, GLint);
+typedef void(POLYSCOPE_GL_APIENTRY* MaxShaderCompilerThreadsFunc)(GLuint);
+
+GetProgramBinaryFunc getProgramBinaryFunc = nullptr;
+ProgramBinaryFunc programBinaryFunc = nullptr;
+ProgramParameteriFunc programParameteriFunc = nullptr;
+bool programBinariesSupported = false;
+
+// GL_KHR_parallel_shader_compile, or the equivalent ARB extension. Compiles may then run in the background, and
+// GL_COMPLETION_STATUS_KHR can be polled without blocking.
+MaxShaderCompilerThreadsFunc maxShaderCompilerThreadsFunc = nullptr;
+bool parallelShaderCompileSupported = false;
+
+// Placeholder location for a GLShaderProgram whose compiled program is still linking
+const GLint pendingLocation = -2;
+
+// Vendor, renderer and version, a program binary is only valid for the driver which created it
+std::string glDriverIdentity;
+
+bool hasGLExtension(const std::string& name) {
+  GLint nExt = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &nExt);
+  for (GLint i = 0; i < nExt; i++) {
+    const GLubyte* ext = glGetStringi(GL_EXTENSIONS, i);
+    if (ext != nullptr && name == reinterpret_cast<const char*>(ext)) return true;
+  }
+  return false;
+}
+
+// == On-disk program binary cache
+
+const char programCacheMagic[4] = {'P', 'S', 'P', 'B'};
+
+// Everything a program binary depends on: the driver, the program key, and the final source of each stage
+std::string programCacheIdentity(const std::string& cacheKey, const std::vector<ShaderStageSpecification>& stages) {
+  std::string identity = glDriverIdentity + "\n" + cacheKey + "\n" + shaderCommonSource;
+  for (const ShaderStageSpecification& s : stages) {
+    identity += "\n#stage " + std::to_string(static_cast<int>(s.stage)) + "\n" + s.src;
+  }
+  return identity;
+}
+
+std::string programCachePath(const std::string& cacheIdentity) {
+  // 64-bit FNV-1a
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : cacheIdentity) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  std::ostringstream name;
+  name << "polyscope_program_" << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+
+  std::string dir = options::shaderCacheDirectory;
+  if (dir.back() != '/' && dir.back() != '\\') dir += '/';
+  return dir + name.str();
+}
+
+} // namespace
+
 // == Map enums to native values
 
 // clang-format off
@@ -56,6 +149,10 @@ inline GLenum internalFormat(const TextureFormat& x) {
     case TextureFormat::RGB32F:     return GL_RGBA32F;
     case TextureFormat::RGBA32F:    return GL_RGBA32F;
     case TextureFormat::DEPTH24:    return GL_DEPTH_COMPONENT24;
+    case TextureFormat::RGB9E5:     return GL_RGB9_E5;
+    case TextureFormat::R8:         return GL_R8;
+    case TextureFormat::R16:        return GL_R16;
+    case TextureFormat::RGBA16:     return GL_RGBA16;
   }
   exception("bad enum");
   return GL_RGB8;
@@ -73,6 +170,10 @@ inline GLenum formatF(const TextureFormat& x) {
     case TextureFormat::RGB32F:     return GL_RGB;
     case TextureFormat::RGBA32F:    return GL_RGBA;
     case TextureFormat::DEPTH24:    return GL_DEPTH_COMPONENT;
+    case TextureFormat::RGB9E5:     return GL_RGB;
+    case TextureFormat::R8:         return GL_RED;
+    case TextureFormat::R16:        return GL_RED;
+    case TextureFormat::RGBA16:     return GL_RGBA;
   }
   exception("bad enum");
   return GL_RGB;
@@ -90,6 +191,10 @@ inline GLenum type(const TextureFormat& x) {
     case TextureFormat::RGB32F:     return GL_FLOAT;
     case TextureFormat::RGBA32F:    return GL_FLOAT;
     case TextureFormat::DEPTH24:    return GL_FLOAT;
+    case TextureFormat::RGB9E5:     return GL_FLOAT;
+    case TextureFormat::R8:         return GL_UNSIGNED_BYTE;
+    case TextureFormat::R16:        return GL_UNSIGNED_SHORT;
+    case TextureFormat::RGBA16:     return GL_UNSIGNED_SHORT;
   }
   exception("bad enum");
   return GL_UNSIGNED_BYTE;
@@ -106,12 +211,24 @@ inline GLenum native(const ShaderStageType& x) {
   return GL_VERTEX_SHADER;
 }
 
+inline GLenum native(const AttributeStorageFormat& x) {
+  switch (x) {
+    case AttributeStorageFormat::Float32:   return GL_FLOAT;
+    case AttributeStorageFormat::Float16:   return GL_HALF_FLOAT;
+    case AttributeStorageFormat::UNorm8:    return GL_UNSIGNED_BYTE;
+    case AttributeStorageFormat::SNorm16:   return GL_SHORT;
+  }
+  exception("bad enum");
+  return GL_FLOAT;
+}
+
 inline GLenum native(const RenderBufferType& x) {
   switch (x) {
     case RenderBufferType::ColorAlpha:      return GL_RGBA;
     case RenderBufferType::Color:           return GL_RGB;
     case RenderBufferType::Depth:           return GL_DEPTH_COMPONENT;
     case RenderBufferType::Float4:          return GL_RGBA32F;
+    case RenderBufferType::UInt2:           return GL_RG32UI;
   }
   exception("bad enum");
   return GL_RGBA;
@@ -216,22 +333,185 @@ void printProgramInfoLog(GLuint handle) {
   }
 }
 
+// Track the program which is currently in use, to skip redundant glUseProgram() calls. All program binding in this
+// file should go through useProgram().
+ProgramHandle currentProgramInUse = 0;
+void useProgram(ProgramHandle handle) {
+  if (handle == currentProgramInUse) return;
+  glUseProgram(handle);
+  currentProgramInUse = handle;
+}
+void forgetProgramInUse(ProgramHandle handle) {
+  if (handle == currentProgramInUse) currentProgramInUse = 0;
+}
+
+// Binding point of the per-frame uniform block (see GLEngine::uploadFrameUniforms())
+const GLuint frameUniformBlockBinding = 0;
+
 // =============================================================
 // =================== Attribute buffer ========================
 // =============================================================
 
+namespace {
+
+// Arenas for small attribute buffers, see GLAttributeBuffer. Each arena is one buffer object, carved in to ranges with
+// a first-fit free list. Freed ranges merge with their free neighbors, and an arena is deleted once it is empty.
+struct GLBufferArena {
+  VertexBufferHandle handle;
+  std::map<size_t, size_t> freeRanges; // offset --> size
+  size_t nRanges;                      // allocated ranges
+};
+std::vector<std::unique_ptr<GLBufferArena>> bufferArenas;
+
+const size_t bufferArenaBytes = 4 << 20;
+const size_t maxArenaRangeBytes = 64 << 10; // larger buffers get their own buffer object
+const size_t arenaRangeAlignment = 16;
+
+bool allocateArenaRange(size_t bytes, VertexBufferHandle& handle, size_t& offset) {
+  bytes = (bytes + arenaRangeAlignment - 1) / arenaRangeAlignment * arenaRangeAlignment;
+  if (bytes == 0 || bytes > maxArenaRangeBytes) return false;
+
+  auto takeFrom = [&](GLBufferArena& arena) {
+    for (auto it = arena.freeRanges.begin(); it != arena.freeRanges.end(); it++) {
+      if (it->second < bytes) continue;
+      offset = it->first;
+      size_t rest = it->second - bytes;
+      arena.freeRanges.erase(it);
+      if (rest > 0) arena.freeRanges[offset + bytes] = rest;
+      arena.nRanges++;
+      handle = arena.handle;
+      return true;
+    }
+    return false;
+  };
+
+  for (std::unique_ptr<GLBufferArena>& arena : bufferArenas) {
+    if (takeFrom(*arena)) return true;
+  }
+
+  std::unique_ptr<GLBufferArena> arena(new GLBufferArena());
+  glGenBuffers(1, &arena->handle);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, arena->handle);
+  glBufferData(GL_COPY_WRITE_BUFFER, bufferArenaBytes, NULL, GL_STATIC_DRAW);
+  arena->freeRanges[0] = bufferArenaBytes;
+  arena->nRanges = 0;
+  bufferArenas.push_back(std::move(arena));
+  return takeFrom(*bufferArenas.back());
+}
+
+void freeArenaRange(VertexBufferHandle handle, size_t offset, size_t bytes) {
+  bytes = (bytes + arenaRangeAlignment - 1) / arenaRangeAlignment * arenaRangeAlignment;
+  for (size_t iA = 0; iA < bufferArenas.size(); iA++) {
+    GLBufferArena& arena = *bufferArenas[iA];
+    if (arena.handle != handle) continue;
+
+    arena.nRanges--;
+    if (arena.nRanges == 0) {
+      glDeleteBuffers(1, &arena.handle);
+      bufferArenas.erase(bufferArenas.begin() + iA);
+      return;
+    }
+
+    // merge with the free neighbors
+    auto next = arena.freeRanges.lower_bound(offset);
+    if (next != arena.freeRanges.end() && next->first == offset + bytes) {
+      bytes += next->second;
+      next = arena.freeRanges.erase(next);
+    }
+    if (next != arena.freeRanges.begin()) {
+      auto prev = std::prev(next);
+      if (prev->first + prev->second == offset) {
+        prev->second += bytes;
+        return;
+      }
+    }
+    arena.freeRanges[offset] = bytes;
+    return;
+  }
+}
+
+} // namespace
+
 GLAttributeBuffer::GLAttributeBuffer(RenderDataType dataType_, int arrayCount_)
     : AttributeBuffer(dataType_, arrayCount_) {
   glGenBuffers(1, &VBOLoc);
 }
 
 GLAttributeBuffer::~GLAttributeBuffer() {
-  bind();
-  glDeleteBuffers(1, &VBOLoc);
+  if (arenaBytes > 0) {
+    freeArenaRange(VBOLoc, arenaOffset, arenaBytes);
+  } else {
+    glDeleteBuffers(1, &VBOLoc);
+  }
+  if (readbackFence != nullptr) glDeleteSync(readbackFence);
+  if (readbackBuffer != 0) glDeleteBuffers(1, &readbackBuffer);
 }
 
 void GLAttributeBuffer::bind() { glBindBuffer(getTarget(), VBOLoc); }
 
+VertexBufferHandle GLAttributeBuffer::getHandle() {
+  wholeBufferUse = true;
+  if (arenaBytes > 0) {
+    uint64_t keepBytes = isSet() ? std::max<int64_t>(dataSize, 0) * getStorageElementBytes() : 0;
+    moveToOwnBuffer(std::max<uint64_t>(keepBytes, arenaBytes), true);
+  }
+  return VBOLoc;
+}
+
+bool GLAttributeBuffer::placeStorage(uint64_t bytes, bool preserveData) {
+  uint64_t keepBytes = (preserveData && isSet()) ? std::max<int64_t>(dataSize, 0) * getStorageElementBytes() : 0;
+
+  VertexBufferHandle rangeHandle;
+  size_t rangeOffset;
+  bool small =
+      options::suballocateSmallBuffers && updateFrequency == BufferUpdateFrequency::Static && !wholeBufferUse;
+  if (!small || !allocateArenaRange(bytes, rangeHandle, rangeOffset)) {
+    if (arenaBytes > 0) {
+      moveToOwnBuffer(bytes, preserveData);
+      return true;
+    }
+    return false;
+  }
+
+  if (keepBytes > 0) {
+    glBindBuffer(GL_COPY_READ_BUFFER, VBOLoc);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, rangeHandle);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, arenaOffset, rangeOffset, keepBytes);
+  }
+  if (arenaBytes > 0) {
+    freeArenaRange(VBOLoc, arenaOffset, arenaBytes);
+  } else {
+    glDeleteBuffers(1, &VBOLoc);
+  }
+
+  VBOLoc = rangeHandle;
+  arenaOffset = rangeOffset;
+  arenaBytes = bytes;
+  storageVersion++;
+  return true;
+}
+
+void GLAttributeBuffer::moveToOwnBuffer(uint64_t bytes, bool preserveData) {
+  uint64_t keepBytes = (preserveData && isSet()) ? std::max<int64_t>(dataSize, 0) * getStorageElementBytes() : 0;
+  GLenum usage = updateFrequency == BufferUpdateFrequency::Streaming ? GL_STREAM_DRAW : GL_STATIC_DRAW;
+
+  VertexBufferHandle ownHandle;
+  glGenBuffers(1, &ownHandle);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, ownHandle);
+  glBufferData(GL_COPY_WRITE_BUFFER, bytes, NULL, usage);
+  if (keepBytes > 0) {
+    glBindBuffer(GL_COPY_READ_BUFFER, VBOLoc);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, arenaOffset, 0, keepBytes);
+  }
+  freeArenaRange(VBOLoc, arenaOffset, arenaBytes);
+
+  VBOLoc = ownHandle;
+  arenaOffset = 0;
+  arenaBytes = 0;
+  storageVersion++;
+  checkGLError();
+}
+
 void GLAttributeBuffer::checkType(RenderDataType targetType) {
   if (dataType != targetType) {
     throw std::invalid_argument("Tried to set GLAttributeBuffer with wrong type. Actual type: " +
@@ -249,26 +529,69 @@ void GLAttributeBuffer::checkArray(int testArrayCount) {
 GLenum GLAttributeBuffer::getTarget() { return GL_ARRAY_BUFFER; }
 
 
-template <typename T>
-void GLAttributeBuffer::setData_helper(const std::vector<T>& data) {
-  bind();
+void GLAttributeBuffer::setDataBytes_helper(const void* bytes, size_t nElements, size_t elementBytes) {
+  contentVersion++;
+
+  if (updateFrequency == BufferUpdateFrequency::Streaming) {
+    // Orphan the old storage and write in to a fresh allocation. The driver keeps the old storage alive for any draws
+    // still in flight, so the upload never has to wait on the GPU.
+    if (arenaBytes > 0) moveToOwnBuffer(nElements * elementBytes, false); // orphaning needs a buffer of its own
+    bind();
+    setFlag = true;
+    bufferSize = nElements;
+    dataSize = nElements;
+    glBufferData(getTarget(), dataSize * elementBytes, NULL, GL_STREAM_DRAW);
+    setDeviceMemoryBytes(dataSize * elementBytes);
+    if (dataSize > 0) {
+      void* mapped = glMapBufferRange(getTarget(), 0, dataSize * elementBytes,
+                                      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+      if (mapped) {
+        std::memcpy(mapped, bytes, dataSize * elementBytes);
+        glUnmapBuffer(getTarget());
+      } else {
+        glBufferSubData(getTarget(), 0, dataSize * elementBytes, bytes);
+      }
+    }
+    checkGLError();
+    return;
+  }
 
   // allocate if needed
-  if (!isSet() || data.size() > bufferSize) {
+  if (!isSet() || nElements > bufferSize) {
     setFlag = true;
-    uint64_t newSize = data.size();
+    uint64_t newSize = nElements;
     newSize = std::max(newSize, 2 * bufferSize); // if we're expanding, at-least double
-    glBufferData(getTarget(), newSize * sizeof(T), NULL, GL_STATIC_DRAW);
+    if (!placeStorage(newSize * elementBytes, false)) {
+      bind();
+      glBufferData(getTarget(), newSize * elementBytes, NULL, GL_STATIC_DRAW);
+    }
     bufferSize = newSize;
+    setDeviceMemoryBytes(bufferSize * elementBytes);
   }
 
   // do the actual copy
-  dataSize = data.size();
-  glBufferSubData(getTarget(), 0, dataSize * sizeof(T), &data[0]);
+  bind();
+  dataSize = nElements;
+  if (dataSize > 0) glBufferSubData(getTarget(), arenaOffset, dataSize * elementBytes, bytes);
 
   checkGLError();
 }
 
+template <typename T>
+void GLAttributeBuffer::setData_helper(const std::vector<T>& data) {
+  setDataFromPointer(data.empty() ? nullptr : &data[0], data.size());
+}
+
+void GLAttributeBuffer::setDataFromPointer(const void* data, size_t nElements) {
+  if (storageFormat != AttributeStorageFormat::Float32) {
+    ScratchVector<unsigned char> packed;
+    packAttributeData(dataType, storageFormat, static_cast<const float*>(data), nElements * arrayCount, *packed);
+    setDataBytes_helper(packed->empty() ? nullptr : &packed[0], nElements, getStorageElementBytes());
+    return;
+  }
+  setDataBytes_helper(data, nElements, getStorageElementBytes());
+}
+
 void GLAttributeBuffer::setData(const std::vector<glm::vec2>& data) {
   checkType(RenderDataType::Vector2Float);
   setData_helper(data);
@@ -343,14 +666,126 @@ void GLAttributeBuffer::setData(const std::vector<glm::uvec4>& data) {
   setData_helper(data);
 }
 
+// === set sub-ranges of data values
+
+template <typename T>
+void GLAttributeBuffer::setDataRange_helper(const std::vector<T>& data, size_t dataStart, size_t bufferStart,
+                                            size_t count) {
+  if (!isSet() || bufferStart + count > static_cast<size_t>(getDataSize())) exception("bad setDataRange");
+  if (dataStart + count > data.size()) exception("bad setDataRange, source range out of bounds");
+  if (count == 0) return;
+
+  bind();
+  contentVersion++;
+  if (storageFormat != AttributeStorageFormat::Float32) {
+    ScratchVector<unsigned char> packed;
+    packAttributeData(dataType, storageFormat, reinterpret_cast<const float*>(&data[dataStart]), count * arrayCount,
+                      *packed);
+    glBufferSubData(getTarget(), arenaOffset + bufferStart * getStorageElementBytes(), packed->size(), &packed[0]);
+  } else {
+    glBufferSubData(getTarget(), arenaOffset + bufferStart * sizeof(T), count * sizeof(T), &data[dataStart]);
+  }
+
+  checkGLError();
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::vec2>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Vector2Float);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::vec3>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Vector3Float);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<std::array<glm::vec3, 2>>& data, size_t dataStart,
+                                     size_t bufferStart, size_t count) {
+  checkType(RenderDataType::Vector3Float);
+  checkArray(2);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<std::array<glm::vec3, 3>>& data, size_t dataStart,
+                                     size_t bufferStart, size_t count) {
+  checkType(RenderDataType::Vector3Float);
+  checkArray(3);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<std::array<glm::vec3, 4>>& data, size_t dataStart,
+                                     size_t bufferStart, size_t count) {
+  checkType(RenderDataType::Vector3Float);
+  checkArray(4);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::vec4>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Vector4Float);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<float>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Float);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<double>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Float);
+  if (dataStart + count > data.size()) exception("bad setDataRange, source range out of bounds");
+
+  // Convert just the updated range of input data to floats
+  std::vector<float> floatData(count);
+  for (size_t i = 0; i < count; i++) {
+    floatData[i] = static_cast<float>(data[dataStart + i]);
+  }
+
+  setDataRange_helper(floatData, 0, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<int32_t>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Int);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<uint32_t>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::UInt);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::uvec2>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Vector2UInt);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::uvec3>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Vector3UInt);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::uvec4>& data, size_t dataStart, size_t bufferStart,
+                                     size_t count) {
+  checkType(RenderDataType::Vector4UInt);
+  setDataRange_helper(data, dataStart, bufferStart, count);
+}
+
 // === get single data values
 
 template <typename T>
 T GLAttributeBuffer::getData_helper(size_t ind) {
   if (!isSet() || ind >= static_cast<size_t>(getDataSize() * getArrayCount())) exception("bad getData");
-  bind();
+  if (storageFormat != AttributeStorageFormat::Float32) return getDataRange_helper<T>(ind, 1)[0];
   T readValue;
-  glGetBufferSubData(getTarget(), ind * sizeof(T), sizeof(T), &readValue);
+  readDataBytes(ind * sizeof(T), sizeof(T), &readValue);
   return readValue;
 }
 
@@ -399,12 +834,79 @@ glm::uvec4 GLAttributeBuffer::getData_uvec4(size_t ind) {
 template <typename T>
 std::vector<T> GLAttributeBuffer::getDataRange_helper(size_t start, size_t count) {
   if (!isSet() || start + count > static_cast<size_t>(getDataSize() * getArrayCount())) exception("bad getData");
-  bind();
   std::vector<T> readValues(count);
-  glGetBufferSubData(getTarget(), start * sizeof(T), count * sizeof(T), &readValues.front());
+  if (count == 0) return readValues;
+  if (storageFormat != AttributeStorageFormat::Float32) {
+    // read the compact entries and expand them back to floats
+    size_t entryBytes = storageSizeInBytes(dataType, storageFormat);
+    ScratchVector<unsigned char> packed(count * entryBytes);
+    readDataBytes(start * entryBytes, packed->size(), &packed[0]);
+    unpackAttributeData(dataType, storageFormat, &packed[0], count, reinterpret_cast<float*>(&readValues.front()));
+    return readValues;
+  }
+  readDataBytes(start * sizeof(T), count * sizeof(T), &readValues.front());
   return readValues;
 }
 
+void GLAttributeBuffer::readDataBytes(size_t byteStart, size_t nBytes, void* dst) {
+  if (readFromDataCopy(byteStart, nBytes, dst)) return;
+  bind();
+  glGetBufferSubData(getTarget(), arenaOffset + byteStart, nBytes, dst);
+}
+
+void GLAttributeBuffer::requestDataCopy() {
+  if (!isSet()) return;
+  size_t nBytes = getDataSizeInBytes();
+  if (nBytes == 0) return;
+
+  if (readbackFence != nullptr) {
+    glDeleteSync(readbackFence);
+    readbackFence = nullptr;
+  }
+  if (readbackBuffer == 0) glGenBuffers(1, &readbackBuffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffer);
+  if (readbackCapacity < nBytes) {
+    glBufferData(GL_COPY_WRITE_BUFFER, nBytes, nullptr, GL_STREAM_READ);
+    readbackCapacity = nBytes;
+  }
+
+  // Only enqueues the copy, the fence tells when it has landed
+  glBindBuffer(GL_COPY_READ_BUFFER, VBOLoc);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, arenaOffset, 0, nBytes);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+  checkGLError();
+
+  readbackBytes = nBytes;
+  readbackContentVersion = contentVersion;
+}
+
+bool GLAttributeBuffer::readFromDataCopy(size_t byteStart, size_t nBytes, void* dst) {
+  if (readbackBuffer == 0 || readbackContentVersion != contentVersion) return false;
+  if (byteStart + nBytes > readbackBytes) return false;
+
+  if (readbackFence != nullptr) {
+    GLenum status = glClientWaitSync(readbackFence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (status == GL_TIMEOUT_EXPIRED) {
+      status = glClientWaitSync(readbackFence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms, in ns
+    }
+    glDeleteSync(readbackFence);
+    readbackFence = nullptr;
+    if (status == GL_WAIT_FAILED) {
+      readbackBytes = 0;
+      return false;
+    }
+  }
+
+  glBindBuffer(GL_COPY_READ_BUFFER, readbackBuffer);
+  glGetBufferSubData(GL_COPY_READ_BUFFER, byteStart, nBytes, dst);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  checkGLError();
+  return true;
+}
+
 std::vector<float> GLAttributeBuffer::getDataRange_float(size_t start, size_t count) {
   if (getType() != RenderDataType::Float) exception("bad getData type");
   return getDataRange_helper<float>(start, count);
@@ -454,7 +956,94 @@ std::vector<glm::uvec4> GLAttributeBuffer::getDataRange_uvec4(size_t start, size
 }
 
 
-uint32_t GLAttributeBuffer::getNativeBufferID() { return static_cast<uint32_t>(VBOLoc); }
+void GLAttributeBuffer::resizePreservingData(size_t newSize) {
+  contentVersion++;
+  if (!isSet() || newSize > bufferSize) {
+    uint64_t newCapacity = newSize;
+    newCapacity = std::max(newCapacity, 2 * bufferSize); // if we're expanding, at-least double
+    reallocatePreservingData(newCapacity);
+  }
+  dataSize = newSize;
+}
+
+void GLAttributeBuffer::reserve(size_t capacity) {
+  if (isSet() && capacity <= bufferSize) return;
+  reallocatePreservingData(capacity);
+}
+
+void GLAttributeBuffer::reallocatePreservingData(uint64_t newCapacity) {
+  uint64_t elementBytes = getStorageElementBytes();
+  if (placeStorage(newCapacity * elementBytes, true)) {
+    // moved to a new range of an arena, or out of one
+    if (!isSet()) dataSize = 0;
+    setFlag = true;
+    bufferSize = newCapacity;
+    setDeviceMemoryBytes(bufferSize * elementBytes);
+    checkGLError();
+    return;
+  }
+
+  uint64_t keepBytes = isSet() ? std::max<int64_t>(dataSize, 0) * elementBytes : 0;
+  GLenum usage = updateFrequency == BufferUpdateFrequency::Streaming ? GL_STREAM_DRAW : GL_STATIC_DRAW;
+
+  // Stage the existing contents in a temporary buffer, rather than swapping in a new buffer, so that this buffer keeps
+  // its name and the VAOs which reference it stay valid
+  GLuint staging = 0;
+  bind();
+  if (keepBytes > 0) {
+    glGenBuffers(1, &staging);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, staging);
+    glBufferData(GL_COPY_WRITE_BUFFER, keepBytes, NULL, GL_STREAM_COPY);
+    glCopyBufferSubData(getTarget(), GL_COPY_WRITE_BUFFER, 0, 0, keepBytes);
+  }
+
+  glBufferData(getTarget(), newCapacity * elementBytes, NULL, usage);
+
+  if (staging != 0) {
+    glBindBuffer(GL_COPY_READ_BUFFER, staging);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, getTarget(), 0, 0, keepBytes);
+    glDeleteBuffers(1, &staging);
+  }
+
+  if (!isSet()) dataSize = 0;
+  setFlag = true;
+  bufferSize = newCapacity;
+  setDeviceMemoryBytes(bufferSize * elementBytes);
+  checkGLError();
+}
+
+uint32_t GLAttributeBuffer::getNativeBufferID() { return static_cast<uint32_t>(getHandle()); }
+
+void GLAttributeBuffer::allocateForDeviceWrite(size_t nElements) {
+  uint64_t elementBytes = getStorageElementBytes();
+  wholeBufferUse = true;
+  if (arenaBytes > 0) {
+    // transform feedback writes to a whole buffer
+    moveToOwnBuffer(std::max<uint64_t>(nElements, bufferSize) * elementBytes, false);
+  }
+  bind();
+  contentVersion++; // the caller is about to write the contents on the device
+
+  // allocate if needed
+  if (updateFrequency == BufferUpdateFrequency::Streaming) {
+    // always orphan, as in setData_helper()
+    setFlag = true;
+    glBufferData(getTarget(), nElements * elementBytes, NULL, GL_STREAM_DRAW);
+    bufferSize = nElements;
+    setDeviceMemoryBytes(bufferSize * elementBytes);
+  } else if (!isSet() || nElements > bufferSize) {
+    setFlag = true;
+    uint64_t newSize = nElements;
+    newSize = std::max(newSize, 2 * bufferSize); // if we're expanding, at-least double
+    glBufferData(getTarget(), newSize * elementBytes, NULL, GL_STATIC_DRAW);
+    bufferSize = newSize;
+    setDeviceMemoryBytes(bufferSize * elementBytes);
+  }
+
+  dataSize = nElements;
+
+  checkGLError();
+}
 
 // =============================================================
 // ==================== Texture buffer =========================
@@ -468,7 +1057,7 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int size1D, con
   glEnable(GL_TEXTURE_1D);
 
   glGenTextures(1, &handle);
-  glBindTexture(GL_TEXTURE_1D, handle);
+  bind();
   glTexImage1D(GL_TEXTURE_1D, 0, internalFormat(format), size1D, 0, formatF(format), GL_UNSIGNED_BYTE, data);
   checkGLError();
 
@@ -479,7 +1068,7 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int size1D, con
     : TextureBuffer(1, format_, size1D) {
 
   glGenTextures(1, &handle);
-  glBindTexture(GL_TEXTURE_1D, handle);
+  bind();
   glTexImage1D(GL_TEXTURE_1D, 0, internalFormat(format), size1D, 0, formatF(format), GL_FLOAT, data);
   checkGLError();
 
@@ -492,7 +1081,7 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, uns
     : TextureBuffer(2, format_, sizeX_, sizeY_) {
 
   glGenTextures(1, &handle);
-  glBindTexture(GL_TEXTURE_2D, handle);
+  bind();
   glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(format), sizeX, sizeY, 0, formatF(format), GL_UNSIGNED_BYTE, data);
   checkGLError();
 
@@ -503,20 +1092,45 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, uns
     : TextureBuffer(2, format_, sizeX_, sizeY_) {
 
   glGenTextures(1, &handle);
-  glBindTexture(GL_TEXTURE_2D, handle);
+  bind();
   glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(format), sizeX, sizeY, 0, formatF(format), GL_FLOAT, data);
   checkGLError();
 
   setFilterMode(FilterMode::Nearest);
 }
 
+GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_,
+                                 ExternalHandle externalHandle)
+    : TextureBuffer(2, format_, sizeX_, sizeY_) {
+
+  external = true;
+  updateDeviceMemoryBytes(); // not ours to count
+  handle = externalHandle.handle;
+  if (!glIsTexture(handle)) {
+    exception("OpenGL error: " + std::to_string(handle) + " is not the name of a texture");
+  }
+
+  bind();
+  GLint actualX = 0;
+  GLint actualY = 0;
+  glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &actualX);
+  glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &actualY);
+  checkGLError();
+  if (actualX != static_cast<GLint>(sizeX) || actualY != static_cast<GLint>(sizeY)) {
+    exception("OpenGL error: external texture is " + std::to_string(actualX) + "x" + std::to_string(actualY) +
+              ", expected " + std::to_string(sizeX) + "x" + std::to_string(sizeY));
+  }
+
+  setFilterMode(FilterMode::Nearest);
+}
+
 // create a 3D texture from data
 GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_, unsigned int sizeZ_,
                                  const unsigned char* data)
     : TextureBuffer(3, format_, sizeX_, sizeY_, sizeZ_) {
 
   glGenTextures(1, &handle);
-  glBindTexture(GL_TEXTURE_3D, handle);
+  bind();
   glTexImage3D(GL_TEXTURE_3D, 0, internalFormat(format), sizeX, sizeY, sizeZ, 0, formatF(format), GL_UNSIGNED_BYTE,
                data);
   checkGLError();
@@ -529,14 +1143,18 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, uns
     : TextureBuffer(3, format_, sizeX_, sizeY_, sizeZ_) {
 
   glGenTextures(1, &handle);
-  glBindTexture(GL_TEXTURE_3D, handle);
+  bind();
   glTexImage3D(GL_TEXTURE_3D, 0, internalFormat(format), sizeX, sizeY, sizeZ, 0, formatF(format), GL_FLOAT, data);
   checkGLError();
 
   setFilterMode(FilterMode::Nearest);
 }
 
-GLTextureBuffer::~GLTextureBuffer() { glDeleteTextures(1, &handle); }
+GLTextureBuffer::~GLTextureBuffer() {
+  if (glEngine) glEngine->forgetTextureBindings(handle); // GL reuses the names of deleted textures
+  if (!external) glDeleteTextures(1, &handle);
+  if (uploadPBO != 0) glDeleteBuffers(1, &uploadPBO);
+}
 
 void GLTextureBuffer::resize(unsigned int newLen) {
 
@@ -553,6 +1171,7 @@ void GLTextureBuffer::resize(unsigned int newLen) {
 
 void GLTextureBuffer::resize(unsigned int newX, unsigned int newY) {
 
+  if (external) exception("OpenGL error: cannot resize an external texture");
   TextureBuffer::resize(newX, newY);
 
   bind();
@@ -587,17 +1206,19 @@ void GLTextureBuffer::setData(const std::vector<glm::vec3>& data) {
     exception("OpenGL error: texture buffer data is not the right size.");
   }
 
+  const void* src = beginUpload(&data.front(), data.size() * sizeof(data.front()));
   switch (dim) {
   case 1:
-    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, sizeX, formatF(format), type(format), &data.front().x);
+    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, sizeX, formatF(format), GL_FLOAT, src);
     break;
   case 2:
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sizeX, sizeY, formatF(format), type(format), &data.front().x);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sizeX, sizeY, formatF(format), GL_FLOAT, src);
     break;
   case 3:
-    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, sizeX, sizeY, sizeZ, formatF(format), type(format), &data.front().x);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, sizeX, sizeY, sizeZ, formatF(format), GL_FLOAT, src);
     break;
   }
+  endUpload();
 
   checkGLError();
 };
@@ -610,17 +1231,19 @@ void GLTextureBuffer::setData(const std::vector<glm::vec4>& data) {
     exception("OpenGL error: texture buffer data is not the right size.");
   }
 
+  const void* src = beginUpload(&data.front(), data.size() * sizeof(data.front()));
   switch (dim) {
   case 1:
-    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, sizeX, formatF(format), type(format), &data.front().x);
+    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, sizeX, formatF(format), GL_FLOAT, src);
     break;
   case 2:
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sizeX, sizeY, formatF(format), type(format), &data.front().x);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sizeX, sizeY, formatF(format), GL_FLOAT, src);
     break;
   case 3:
-    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, sizeX, sizeY, sizeZ, formatF(format), type(format), &data.front().x);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, sizeX, sizeY, sizeZ, formatF(format), GL_FLOAT, src);
     break;
   }
+  endUpload();
 
   checkGLError();
 };
@@ -632,17 +1255,19 @@ void GLTextureBuffer::setData(const std::vector<float>& data) {
     exception("OpenGL error: texture buffer data is not the right size.");
   }
 
+  const void* src = beginUpload(&data.front(), data.size() * sizeof(data.front()));
   switch (dim) {
   case 1:
-    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, sizeX, formatF(format), type(format), &data.front());
+    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, sizeX, formatF(format), GL_FLOAT, src);
     break;
   case 2:
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sizeX, sizeY, formatF(format), type(format), &data.front());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sizeX, sizeY, formatF(format), GL_FLOAT, src);
     break;
   case 3:
-    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, sizeX, sizeY, sizeZ, formatF(format), type(format), &data.front());
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, sizeX, sizeY, sizeZ, formatF(format), GL_FLOAT, src);
     break;
   }
+  endUpload();
 
   checkGLError();
 };
@@ -662,17 +1287,19 @@ void GLTextureBuffer::setData(const std::vector<double>& data) {
     exception("OpenGL error: texture buffer data is not the right size.");
   }
 
+  const void* src = beginUpload(&dataFloat.front(), dataFloat.size() * sizeof(dataFloat.front()));
   switch (dim) {
   case 1:
-    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, sizeX, formatF(format), type(format), &dataFloat.front());
+    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, sizeX, formatF(format), GL_FLOAT, src);
     break;
   case 2:
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sizeX, sizeY, formatF(format), type(format), &dataFloat.front());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sizeX, sizeY, formatF(format), GL_FLOAT, src);
     break;
   case 3:
-    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, sizeX, sizeY, sizeZ, formatF(format), type(format), &dataFloat.front());
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, sizeX, sizeY, sizeZ, formatF(format), GL_FLOAT, src);
     break;
   }
+  endUpload();
 
   checkGLError();
 };
@@ -686,6 +1313,128 @@ void GLTextureBuffer::setData(const std::vector<std::array<glm::vec3, 3>>& data)
 void GLTextureBuffer::setData(const std::vector<std::array<glm::vec3, 4>>& data) { exception("not implemented"); };
 
 
+namespace {
+// The format and type arguments of glTexSubImage*() for tightly packed pixels
+void pixelTransferFormat(int nChannels, PixelComponentType componentType, GLenum& srcFormat, GLenum& srcType) {
+  switch (nChannels) {
+  case 1:
+    srcFormat = GL_RED;
+    break;
+  case 2:
+    srcFormat = GL_RG;
+    break;
+  case 3:
+    srcFormat = GL_RGB;
+    break;
+  case 4:
+    srcFormat = GL_RGBA;
+    break;
+  default:
+    exception("OpenGL error: texture data must have 1-4 channels");
+    return;
+  }
+  srcType = GL_FLOAT;
+  switch (componentType) {
+  case PixelComponentType::Float32:
+    srcType = GL_FLOAT;
+    break;
+  case PixelComponentType::UNorm8:
+    srcType = GL_UNSIGNED_BYTE;
+    break;
+  case PixelComponentType::UNorm16:
+    srcType = GL_UNSIGNED_SHORT;
+    break;
+  }
+}
+} // namespace
+
+void GLTextureBuffer::setDataRect(const void* data, int nChannels, PixelComponentType componentType, unsigned int x,
+                                  unsigned int y, unsigned int w, unsigned int h) {
+  if (dim != 2) exception("OpenGL error: setDataRect() is only for 2D textures");
+  if (x + w > sizeX || y + h > sizeY) {
+    exception("OpenGL error: texture data rectangle is out of bounds.");
+  }
+  if (w == 0 || h == 0) return;
+
+  GLenum srcFormat = GL_RED;
+  GLenum srcType = GL_FLOAT;
+  pixelTransferFormat(nChannels, componentType, srcFormat, srcType);
+
+  bind();
+  size_t nBytes = static_cast<size_t>(w) * h * nChannels * sizeInBytes(componentType);
+  const void* src = beginUpload(data, nBytes);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows are tightly packed
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, srcFormat, srcType, src);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  endUpload();
+
+  checkGLError();
+}
+
+void GLTextureBuffer::setDataBox(const void* data, int nChannels, PixelComponentType componentType, unsigned int x,
+                                 unsigned int y, unsigned int z, unsigned int w, unsigned int h, unsigned int d) {
+  if (dim != 3) exception("OpenGL error: setDataBox() is only for 3D textures");
+  if (x + w > sizeX || y + h > sizeY || z + d > sizeZ) {
+    exception("OpenGL error: texture data box is out of bounds.");
+  }
+  if (w == 0 || h == 0 || d == 0) return;
+
+  GLenum srcFormat = GL_RED;
+  GLenum srcType = GL_FLOAT;
+  pixelTransferFormat(nChannels, componentType, srcFormat, srcType);
+
+  bind();
+  size_t nBytes = static_cast<size_t>(w) * h * d * nChannels * sizeInBytes(componentType);
+  const void* src = beginUpload(data, nBytes);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows are tightly packed
+  glTexSubImage3D(GL_TEXTURE_3D, 0, x, y, z, w, h, d, srcFormat, srcType, src);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  endUpload();
+
+  checkGLError();
+}
+
+void GLTextureBuffer::setDataFromDeviceBuffer(uint32_t nativeBufferHandle, int nChannels,
+                                              PixelComponentType componentType) {
+  if (dim != 2) exception("OpenGL error: setDataFromDeviceBuffer() is only for 2D textures");
+  GLenum srcFormat = GL_RED;
+  GLenum srcType = GL_FLOAT;
+  pixelTransferFormat(nChannels, componentType, srcFormat, srcType);
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, nativeBufferHandle);
+  GLint bufferBytes = 0;
+  glGetBufferParameteriv(GL_PIXEL_UNPACK_BUFFER, GL_BUFFER_SIZE, &bufferBytes);
+  size_t nBytes = static_cast<size_t>(sizeX) * sizeY * nChannels * sizeInBytes(componentType);
+  if (bufferBytes < 0 || static_cast<size_t>(bufferBytes) < nBytes) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    exception("OpenGL error: device buffer " + std::to_string(nativeBufferHandle) + " holds " +
+              std::to_string(bufferBytes) + " bytes, but the texture needs " + std::to_string(nBytes));
+  }
+
+  bind();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows are tightly packed
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sizeX, sizeY, srcFormat, srcType, nullptr); // offset 0 in the buffer
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  checkGLError();
+}
+
+const void* GLTextureBuffer::beginUpload(const void* data, size_t nBytes) {
+  if (updateFrequency != BufferUpdateFrequency::Streaming) return data;
+
+  if (uploadPBO == 0) glGenBuffers(1, &uploadPBO);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadPBO);
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, nBytes, nullptr, GL_STREAM_DRAW); // orphan
+  glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, nBytes, data);
+  return nullptr; // offset 0 in the unpack buffer
+}
+
+void GLTextureBuffer::endUpload() {
+  if (updateFrequency != BufferUpdateFrequency::Streaming) return;
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
 void GLTextureBuffer::setFilterMode(FilterMode newMode) {
 
   bind();
@@ -755,6 +1504,19 @@ std::vector<glm::vec3> GLTextureBuffer::getDataVector3() {
   return outData;
 }
 
+std::vector<glm::vec4> GLTextureBuffer::getDataVector4() {
+  if (dimension(format) != 4) exception("called getDataVector4 on texture which does not have a 4 dimensional format");
+
+  std::vector<glm::vec4> outData;
+  outData.resize(getTotalSize());
+
+  bind();
+  glGetTexImage(textureType(), 0, formatF(format), GL_FLOAT, static_cast<void*>(&outData.front()));
+  checkGLError();
+
+  return outData;
+}
+
 GLenum GLTextureBuffer::textureType() {
   if (dim == 1) {
     return GL_TEXTURE_1D;
@@ -769,6 +1531,7 @@ GLenum GLTextureBuffer::textureType() {
 
 void GLTextureBuffer::bind() {
   glBindTexture(textureType(), handle);
+  if (glEngine) glEngine->recordTextureBind(textureType(), handle);
   checkGLError();
 }
 
@@ -817,6 +1580,25 @@ GLFrameBuffer::GLFrameBuffer(unsigned int sizeX_, unsigned int sizeY_, bool isDe
 };
 
 GLFrameBuffer::~GLFrameBuffer() {
+  if (readFence != nullptr) {
+    glDeleteSync(readFence);
+  }
+  if (readPixelBuffer != 0) {
+    glDeleteBuffers(1, &readPixelBuffer);
+  }
+  for (auto& entry : pendingBufferReads) {
+    glDeleteSync(entry.second.fence);
+    glDeleteBuffers(1, &entry.second.pixelBuffer);
+  }
+  for (std::pair<GLuint, size_t>& buff : freeReadPixelBuffers) {
+    glDeleteBuffers(1, &buff.first);
+  }
+  if (readDepthFence != nullptr) {
+    glDeleteSync(readDepthFence);
+  }
+  if (readDepthPixelBuffer != 0) {
+    glDeleteBuffers(1, &readDepthPixelBuffer);
+  }
   if (handle != 0) {
     glDeleteFramebuffers(1, &handle);
   }
@@ -898,12 +1680,12 @@ void GLFrameBuffer::addDepthBuffer(std::shared_ptr<TextureBuffer> textureBufferI
 void GLFrameBuffer::setDrawBuffers() {
   bind();
 
-  std::vector<GLenum> buffs;
+  std::vector<GLenum> buffs(firstDrawBufferLocation, GL_NONE);
   for (int i = 0; i < nColorBuffers; i++) {
     buffs.push_back(GL_COLOR_ATTACHMENT0 + i);
   }
   if (nColorBuffers > 0) {
-    glDrawBuffers(nColorBuffers, &buffs.front());
+    glDrawBuffers(static_cast<GLsizei>(buffs.size()), &buffs.front());
   }
   checkGLError();
 }
@@ -933,6 +1715,14 @@ bool GLFrameBuffer::bindForRendering() {
   render::engine->setCurrentViewport({viewportX, viewportY, viewportSizeX, viewportSizeY});
   checkGLError();
 
+  // The scissor test is global state, so set it on every bind
+  if (scissorSet) {
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(scissorX, scissorY, scissorSizeX, scissorSizeY);
+  } else {
+    glDisable(GL_SCISSOR_TEST);
+  }
+
   // Enable depth testing
   glEnable(GL_DEPTH_TEST);
   glDepthFunc(GL_LESS);
@@ -940,6 +1730,7 @@ bool GLFrameBuffer::bindForRendering() {
   // Enable blending
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glEngine->invalidateDepthBlendStateCache();
 
   checkGLError();
   return true;
@@ -948,9 +1739,23 @@ bool GLFrameBuffer::bindForRendering() {
 void GLFrameBuffer::clear() {
   if (!bindForRendering()) return;
 
+  // Integer color buffers cannot be cleared with glClear(), clear them to zero (which is no index) separately
+  bool hasIntegerBuffer = false;
+  for (size_t i = 0; i < renderBuffersColor.size(); i++) {
+    if (renderBuffersColor[i]->getType() == RenderBufferType::UInt2) {
+      const GLuint zero[4] = {0, 0, 0, 0};
+      glClearBufferuiv(GL_COLOR, static_cast<GLint>(firstDrawBufferLocation + i), zero);
+      hasIntegerBuffer = true;
+    }
+  }
+
   glClearColor(clearColor[0], clearColor[1], clearColor[2], clearAlpha);
   glClearDepth(clearDepth);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+  if (hasIntegerBuffer) {
+    glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+  } else {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+  }
 }
 
 std::array<float, 4> GLFrameBuffer::readFloat4(int xPos, int yPos) {
@@ -970,6 +1775,180 @@ std::array<float, 4> GLFrameBuffer::readFloat4(int xPos, int yPos) {
   return result;
 }
 
+std::vector<float> GLFrameBuffer::readFloat4Region(int xPos, int yPos, int width, int height) {
+
+  glFlush();
+  glFinish();
+  bind();
+
+  // Read from the buffer
+  std::vector<float> result(4 * static_cast<size_t>(width) * height);
+  if (result.empty()) return result;
+  glReadPixels(xPos, yPos, width, height, GL_RGBA, GL_FLOAT, &result.front());
+
+  return result;
+}
+
+std::array<uint32_t, 2> GLFrameBuffer::readUInt2(int xPos, int yPos) {
+
+  glFlush();
+  glFinish();
+  bind();
+
+  // Read from the buffer
+  std::array<uint32_t, 2> result;
+  glReadPixels(xPos, yPos, 1, 1, GL_RG_INTEGER, GL_UNSIGNED_INT, &result);
+
+  return result;
+}
+
+std::vector<uint32_t> GLFrameBuffer::readUInt2Region(int xPos, int yPos, int width, int height) {
+
+  glFlush();
+  glFinish();
+  bind();
+
+  // Read from the buffer
+  std::vector<uint32_t> result(2 * static_cast<size_t>(width) * height);
+  if (result.empty()) return result;
+  glReadPixels(xPos, yPos, width, height, GL_RG_INTEGER, GL_UNSIGNED_INT, &result.front());
+
+  return result;
+}
+
+void GLFrameBuffer::requestReadPixel(int xPos, int yPos, GLenum format, GLenum type) {
+
+  // sized for the largest pixel read, a float4
+  if (readPixelBuffer == 0) {
+    glGenBuffers(1, &readPixelBuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readPixelBuffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, 4 * sizeof(float), nullptr, GL_STREAM_READ);
+  } else {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readPixelBuffer);
+  }
+
+  if (readFence != nullptr) {
+    glDeleteSync(readFence);
+    readFence = nullptr;
+  }
+
+  // With a pack buffer bound, this only enqueues the copy rather than waiting for rendering to finish
+  bind();
+  glReadPixels(xPos, yPos, 1, 1, format, type, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  readFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush(); // make sure the fence eventually gets signaled
+  checkGLError();
+}
+
+bool GLFrameBuffer::pollReadPixel(void* result, size_t nBytes) {
+  if (readFence == nullptr) return false;
+
+  GLenum status = glClientWaitSync(readFence, 0, 0);
+  if (status == GL_TIMEOUT_EXPIRED) return false;
+
+  glDeleteSync(readFence);
+  readFence = nullptr;
+  if (status == GL_WAIT_FAILED) return false;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readPixelBuffer);
+  void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, nBytes, GL_MAP_READ_BIT);
+  bool success = mapped != nullptr;
+  if (success) {
+    std::memcpy(result, mapped, nBytes);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  checkGLError();
+
+  return success;
+}
+
+void GLFrameBuffer::requestReadFloat4(int xPos, int yPos) { requestReadPixel(xPos, yPos, GL_RGBA, GL_FLOAT); }
+
+bool GLFrameBuffer::pollReadFloat4(std::array<float, 4>& result) {
+  return pollReadPixel(result.data(), 4 * sizeof(float));
+}
+
+bool GLFrameBuffer::hasPendingReadFloat4() { return readFence != nullptr; }
+
+void GLFrameBuffer::requestReadUInt2(int xPos, int yPos) {
+  requestReadPixel(xPos, yPos, GL_RG_INTEGER, GL_UNSIGNED_INT);
+}
+
+bool GLFrameBuffer::pollReadUInt2(std::array<uint32_t, 2>& result) {
+  return pollReadPixel(result.data(), 2 * sizeof(uint32_t));
+}
+
+bool GLFrameBuffer::hasPendingReadUInt2() { return readFence != nullptr; }
+
+uint64_t GLFrameBuffer::requestReadBuffer() {
+
+  size_t nBytes = static_cast<size_t>(getSizeX()) * getSizeY() * 4;
+
+  // Reuse a pack buffer of the right size if there is one
+  GLuint pixelBuffer = 0;
+  for (size_t i = 0; i < freeReadPixelBuffers.size(); i++) {
+    if (freeReadPixelBuffers[i].second == nBytes) {
+      pixelBuffer = freeReadPixelBuffers[i].first;
+      freeReadPixelBuffers.erase(freeReadPixelBuffers.begin() + i);
+      break;
+    }
+  }
+  if (pixelBuffer == 0) {
+    glGenBuffers(1, &pixelBuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, nBytes, nullptr, GL_STREAM_READ);
+  } else {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer);
+  }
+
+  // As in requestReadFloat4(), this only enqueues the copy
+  bind();
+  glReadPixels(0, 0, getSizeX(), getSizeY(), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+  checkGLError();
+
+  uint64_t ticket = nextReadBufferTicket++;
+  pendingBufferReads[ticket] = PendingBufferRead{pixelBuffer, fence, nBytes};
+  return ticket;
+}
+
+bool GLFrameBuffer::pollReadBuffer(uint64_t ticket, std::vector<unsigned char>& result, bool wait) {
+  auto it = pendingBufferReads.find(ticket);
+  if (it == pendingBufferReads.end()) return false;
+  PendingBufferRead& read = it->second;
+
+  GLenum status = glClientWaitSync(read.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+  while (wait && status == GL_TIMEOUT_EXPIRED) {
+    status = glClientWaitSync(read.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms, in ns
+  }
+  if (status == GL_TIMEOUT_EXPIRED) return false;
+
+  glDeleteSync(read.fence);
+  bool success = status != GL_WAIT_FAILED;
+  if (success) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, read.pixelBuffer);
+    void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, read.nBytes, GL_MAP_READ_BIT);
+    success = mapped != nullptr;
+    if (success) {
+      result.resize(read.nBytes);
+      std::memcpy(result.data(), mapped, read.nBytes);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
+  checkGLError();
+
+  freeReadPixelBuffers.emplace_back(read.pixelBuffer, read.nBytes);
+  pendingBufferReads.erase(it);
+  return success;
+}
+
 float GLFrameBuffer::readDepth(int xPos, int yPos) {
 
   // TODO does no error checking for the case where no depth buffer is attached
@@ -985,6 +1964,73 @@ float GLFrameBuffer::readDepth(int xPos, int yPos) {
   return result;
 }
 
+std::vector<float> GLFrameBuffer::readDepthBuffer() {
+
+  glFlush();
+  glFinish();
+  bind();
+
+  // Read from the buffer
+  std::vector<float> result(static_cast<size_t>(getSizeX()) * getSizeY());
+  if (result.empty()) return result;
+  glReadPixels(0, 0, getSizeX(), getSizeY(), GL_DEPTH_COMPONENT, GL_FLOAT, &result.front());
+
+  return result;
+}
+
+void GLFrameBuffer::requestReadDepthBuffer(int stride) {
+
+  size_t nBytes = static_cast<size_t>(getSizeX()) * getSizeY() * sizeof(float);
+  if (readDepthPixelBuffer == 0) {
+    glGenBuffers(1, &readDepthPixelBuffer);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readDepthPixelBuffer);
+  if (readDepthPixelBufferBytes != nBytes) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, nBytes, nullptr, GL_STREAM_READ);
+    readDepthPixelBufferBytes = nBytes;
+  }
+
+  if (readDepthFence != nullptr) {
+    glDeleteSync(readDepthFence);
+    readDepthFence = nullptr;
+  }
+
+  // As in requestReadFloat4(), this only enqueues the copy
+  bind();
+  glReadPixels(0, 0, getSizeX(), getSizeY(), GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  readDepthFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+  readDepthSizeX = getSizeX();
+  readDepthSizeY = getSizeY();
+  readDepthStride = stride;
+  checkGLError();
+}
+
+bool GLFrameBuffer::pollReadDepthBuffer(std::vector<float>& result) {
+  if (readDepthFence == nullptr) return false;
+
+  GLenum status = glClientWaitSync(readDepthFence, 0, 0);
+  if (status == GL_TIMEOUT_EXPIRED) return false;
+
+  glDeleteSync(readDepthFence);
+  readDepthFence = nullptr;
+  if (status == GL_WAIT_FAILED) return false;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readDepthPixelBuffer);
+  void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readDepthPixelBufferBytes, GL_MAP_READ_BIT);
+  bool success = mapped != nullptr;
+  if (success) {
+    result = subsampleDepth(static_cast<const float*>(mapped), readDepthSizeX, readDepthSizeY, readDepthStride);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  checkGLError();
+
+  return success;
+}
+
 std::vector<unsigned char> GLFrameBuffer::readBuffer() {
 
   glFlush();
@@ -1025,7 +2071,9 @@ uint32_t GLFrameBuffer::getNativeBufferID() { return handle; }
 // =============================================================
 
 
-GLCompiledProgram::GLCompiledProgram(const std::vector<ShaderStageSpecification>& stages, DrawMode dm) : drawMode(dm) {
+GLCompiledProgram::GLCompiledProgram(const std::vector<ShaderStageSpecification>& stages, DrawMode dm,
+                                     const std::string& cacheKey)
+    : drawMode(dm) {
 
   // Collect attributes and uniforms from all of the shaders
   for (const ShaderStageSpecification& s : stages) {
@@ -1045,25 +2093,96 @@ GLCompiledProgram::GLCompiledProgram(const std::vector<ShaderStageSpecification>
   }
 
   // Perform setup tasks
-  compileGLProgram(stages);
-  checkGLError();
+  bool useDiskCache = !cacheKey.empty() && !options::shaderCacheDirectory.empty() && programBinariesSupported;
+  if (useDiskCache) {
+    pendingCacheIdentity = programCacheIdentity(cacheKey, stages);
+    if (loadCachedGLProgram(pendingCacheIdentity)) {
+      pendingCacheIdentity.clear();
+      setDataLocations();
+      checkGLError();
+      return;
+    }
+  }
 
-  setDataLocations();
+  beginCompileGLProgram(stages, useDiskCache);
   checkGLError();
+
+  // Without a background compile, querying the status below just waits for the driver
+  if (!options::asyncShaderCompilation || !parallelShaderCompileSupported) {
+    waitUntilReady();
+  }
+}
+
+GLCompiledProgram::~GLCompiledProgram() {
+  for (ShaderHandle h : pendingShaders) {
+    glDeleteShader(h);
+  }
+  forgetProgramInUse(programHandle);
+  glDeleteProgram(programHandle);
+}
+
+bool GLCompiledProgram::isReady() {
+  if (!linkPending) return true;
+
+  GLint done = GL_TRUE;
+  if (parallelShaderCompileSupported) {
+    glGetProgramiv(programHandle, GL_COMPLETION_STATUS_KHR, &done);
+  }
+  if (!done) return false;
+
+  waitUntilReady();
+  return true;
 }
 
-GLCompiledProgram::~GLCompiledProgram() { glDeleteProgram(programHandle); }
+void GLCompiledProgram::waitUntilReady() {
+  if (!linkPending) return;
+  linkPending = false;
 
-void GLCompiledProgram::compileGLProgram(const std::vector<ShaderStageSpecification>& stages) {
+  finishCompileGLProgram();
+  checkGLError();
+
+  if (!pendingCacheIdentity.empty()) {
+    saveCachedGLProgram(pendingCacheIdentity);
+    pendingCacheIdentity.clear();
+  }
+
+  setDataLocations();
+  applyUniformValues();
+  checkGLError();
+}
 
+void GLCompiledProgram::beginCompileGLProgram(const std::vector<ShaderStageSpecification>& stages, bool retrievable) {
 
-  // Compile all of the shaders
-  std::vector<ShaderHandle> handles;
+  // Start compiling all of the shaders. Nothing here waits for the driver, errors are checked when the link finishes.
   for (const ShaderStageSpecification& s : stages) {
     ShaderHandle h = glCreateShader(native(s.stage));
     std::array<const char*, 2> srcs = {s.src.c_str(), shaderCommonSource};
     glShaderSource(h, 2, &(srcs[0]), nullptr);
     glCompileShader(h);
+    pendingShaders.push_back(h);
+    pendingShaderSources.push_back(s.src);
+  }
+
+  // Create the program and attach the shaders
+  programHandle = glCreateProgram();
+  for (ShaderHandle h : pendingShaders) {
+    glAttachShader(programHandle, h);
+  }
+
+  // Link the program
+  if (retrievable) {
+    programParameteriFunc(programHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+  glLinkProgram(programHandle);
+  linkPending = true;
+}
+
+void GLCompiledProgram::finishCompileGLProgram() {
+
+  // Check each of the shaders
+  for (size_t iS = 0; iS < pendingShaders.size(); iS++) {
+    ShaderHandle h = pendingShaders[iS];
+    const std::string& src = pendingShaderSources[iS];
 
     // Catch the error here, so we can print shader source before re-throwing
     try {
@@ -1073,7 +2192,7 @@ void GLCompiledProgram::compileGLProgram(const std::vector<ShaderStageSpecificat
       if (!status) {
         printShaderInfoLog(h);
         std::cout << "Program text:" << std::endl;
-        std::cout << s.src.c_str() << std::endl;
+        std::cout << src.c_str() << std::endl;
         exception("[polyscope] GL shader compile failed");
       }
 
@@ -1082,7 +2201,7 @@ void GLCompiledProgram::compileGLProgram(const std::vector<ShaderStageSpecificat
       }
       if (options::verbosity > 100) {
         std::cout << "Program text:" << std::endl;
-        std::cout << s.src.c_str() << std::endl;
+        std::cout << src.c_str() << std::endl;
       }
 
       checkGLError();
@@ -1090,7 +2209,7 @@ void GLCompiledProgram::compileGLProgram(const std::vector<ShaderStageSpecificat
       std::cout << "GLError() after shader compilation! Program text:" << std::endl;
 
       // process shader line-by-line to print line numbers:
-      std::stringstream ss(s.src);
+      std::stringstream ss(src);
       std::string line;
       size_t lineNo = 1;
       while (std::getline(ss, line, '\n')) {
@@ -1099,18 +2218,9 @@ void GLCompiledProgram::compileGLProgram(const std::vector<ShaderStageSpecificat
       }
       throw;
     }
-
-    handles.push_back(h);
-  }
-
-  // Create the program and attach the shaders
-  programHandle = glCreateProgram();
-  for (ShaderHandle h : handles) {
-    glAttachShader(programHandle, h);
   }
 
-  // Link the program
-  glLinkProgram(programHandle);
+  // Check the link
   if (options::verbosity > 2) {
     printProgramInfoLog(programHandle);
   }
@@ -1122,15 +2232,94 @@ void GLCompiledProgram::compileGLProgram(const std::vector<ShaderStageSpecificat
   }
 
   // Delete the shaders we just compiled, they aren't used after link
-  for (ShaderHandle h : handles) {
+  for (ShaderHandle h : pendingShaders) {
     glDeleteShader(h);
   }
+  pendingShaders.clear();
+  pendingShaderSources.clear();
 
   checkGLError();
 }
 
+bool GLCompiledProgram::loadCachedGLProgram(const std::string& cacheIdentity) {
+
+  std::ifstream inFile(programCachePath(cacheIdentity), std::ios::binary);
+  if (!inFile) return false;
+
+  // Header: magic, full identity (guards against hash collisions), binary format and length
+  char magic[4];
+  uint64_t identityLen = 0;
+  inFile.read(magic, 4);
+  inFile.read(reinterpret_cast<char*>(&identityLen), sizeof(identityLen));
+  if (!inFile || std::memcmp(magic, programCacheMagic, 4) != 0 || identityLen != cacheIdentity.size()) return false;
+  std::string fileIdentity(identityLen, '\0');
+  inFile.read(&fileIdentity[0], identityLen);
+  if (!inFile || fileIdentity != cacheIdentity) return false;
+
+  uint32_t binaryFormat = 0;
+  uint64_t binaryLen = 0;
+  inFile.read(reinterpret_cast<char*>(&binaryFormat), sizeof(binaryFormat));
+  inFile.read(reinterpret_cast<char*>(&binaryLen), sizeof(binaryLen));
+  if (!inFile || binaryLen == 0) return false;
+  std::vector<char> binary(binaryLen);
+  inFile.read(binary.data(), binaryLen);
+  if (!inFile) return false;
+
+  // The driver may still reject the binary (e.g. after an update which kept the version string), in which case the
+  // caller compiles from source as usual
+  programHandle = glCreateProgram();
+  programBinaryFunc(programHandle, binaryFormat, binary.data(), static_cast<GLsizei>(binaryLen));
+  GLint status;
+  glGetProgramiv(programHandle, GL_LINK_STATUS, &status);
+  if (!status) {
+    glDeleteProgram(programHandle);
+    while (glGetError() != GL_NO_ERROR) {
+    }
+    if (options::verbosity > 2) polyscope::info("shader cache entry rejected by driver, recompiling");
+    return false;
+  }
+
+  return true;
+}
+
+void GLCompiledProgram::saveCachedGLProgram(const std::string& cacheIdentity) {
+
+  GLint binaryLen = 0;
+  glGetProgramiv(programHandle, GL_PROGRAM_BINARY_LENGTH, &binaryLen);
+  if (binaryLen <= 0) return;
+  std::vector<char> binary(binaryLen);
+  GLenum binaryFormat = 0;
+  getProgramBinaryFunc(programHandle, binaryLen, nullptr, &binaryFormat, binary.data());
+
+  // Write to a temporary file and move it in place, so a concurrent or interrupted run never sees a partial entry
+  std::string path = programCachePath(cacheIdentity);
+  std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream outFile(tmpPath, std::ios::binary | std::ios::trunc);
+    uint64_t identityLen = cacheIdentity.size();
+    uint32_t format = binaryFormat;
+    uint64_t len = static_cast<uint64_t>(binaryLen);
+    outFile.write(programCacheMagic, 4);
+    outFile.write(reinterpret_cast<const char*>(&identityLen), sizeof(identityLen));
+    outFile.write(cacheIdentity.data(), identityLen);
+    outFile.write(reinterpret_cast<const char*>(&format), sizeof(format));
+    outFile.write(reinterpret_cast<const char*>(&len), sizeof(len));
+    outFile.write(binary.data(), binaryLen);
+    if (!outFile) {
+      outFile.close();
+      std::remove(tmpPath.c_str());
+      if (options::verbosity > 2) polyscope::info("could not write shader cache entry " + path);
+      return;
+    }
+  }
+  std::remove(path.c_str()); // rename() does not replace existing files on all platforms
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+  }
+}
+
 void GLCompiledProgram::setDataLocations() {
-  glUseProgram(programHandle);
+  useProgram(programHandle);
 
   // Uniforms
   for (GLShaderUniform& u : uniforms) {
@@ -1152,19 +2341,103 @@ void GLCompiledProgram::setDataLocations() {
     }
   }
 
+  // Per-frame uniform block, if the program reads from it
+  GLuint frameBlockIndex = glGetUniformBlockIndex(programHandle, shaderFrameUniformBlockName);
+  if (frameBlockIndex != GL_INVALID_INDEX) {
+    glUniformBlockBinding(programHandle, frameBlockIndex, frameUniformBlockBinding);
+    usesFrameUniforms = true;
+  }
+
   // Textures
-  for (GLShaderTexture& t : textures) {
+  // Every GLShaderProgram made from this one binds texture i to unit i (see GLShaderProgram::createBuffers()), so the
+  // sampler uniforms are written once here, rather than on each draw.
+  useProgram(programHandle);
+  for (size_t iT = 0; iT < textures.size(); iT++) {
+    GLShaderTexture& t = textures[iT];
     t.location = glGetUniformLocation(programHandle, t.name.c_str());
     if (t.location == -1) {
       if (options::verbosity > 3) {
         info("failed to get location for texture " + t.name);
       }
+      continue;
     }
+    glUniform1i(t.location, static_cast<GLint>(iT));
   }
 
   checkGLError();
 }
 
+bool GLCompiledProgram::updateUniformValue(size_t iUniform, const void* valBytes, size_t nBytes) {
+  if (uniformValues.size() != uniforms.size()) {
+    uniformValues.resize(uniforms.size());
+    uniformValueValid.resize(uniforms.size(), false);
+  }
+  if (nBytes > sizeof(uniformValues[iUniform])) {
+    if (linkPending) exception("uniform value too large to hold while the program links");
+    return true; // too big to cache, always write
+  }
+
+  if (uniformValueValid[iUniform] && std::memcmp(uniformValues[iUniform].data(), valBytes, nBytes) == 0) return false;
+  std::memcpy(uniformValues[iUniform].data(), valBytes, nBytes);
+  uniformValueValid[iUniform] = true;
+
+  // the location is not known yet, the value is written by applyUniformValues() once the link finishes
+  return !linkPending;
+}
+
+namespace {
+
+// Write a uniform value, as held in GLCompiledProgram::uniformValues, to the bound program
+void uploadUniformValue(const GLShaderUniform& u, const void* val) {
+  const GLfloat* valF = static_cast<const GLfloat*>(val);
+  const GLuint* valU = static_cast<const GLuint*>(val);
+  switch (u.type) {
+  case RenderDataType::Int:
+    glUniform1i(u.location, *static_cast<const GLint*>(val));
+    break;
+  case RenderDataType::UInt:
+    glUniform1ui(u.location, valU[0]);
+    break;
+  case RenderDataType::Float:
+    glUniform1f(u.location, valF[0]);
+    break;
+  case RenderDataType::Vector2Float:
+    glUniform2fv(u.location, 1, valF);
+    break;
+  case RenderDataType::Vector3Float:
+    glUniform3fv(u.location, 1, valF);
+    break;
+  case RenderDataType::Vector4Float:
+    glUniform4fv(u.location, 1, valF);
+    break;
+  case RenderDataType::Matrix44Float:
+    glUniformMatrix4fv(u.location, 1, false, valF);
+    break;
+  case RenderDataType::Vector2UInt:
+    glUniform2uiv(u.location, 1, valU);
+    break;
+  case RenderDataType::Vector3UInt:
+    glUniform3uiv(u.location, 1, valU);
+    break;
+  case RenderDataType::Vector4UInt:
+    glUniform4uiv(u.location, 1, valU);
+    break;
+  }
+}
+
+} // namespace
+
+void GLCompiledProgram::applyUniformValues() {
+  if (uniformValues.size() != uniforms.size()) return; // nothing has been set
+
+  useProgram(programHandle);
+  for (size_t iU = 0; iU < uniforms.size(); iU++) {
+    const GLShaderUniform& u = uniforms[iU];
+    if (!uniformValueValid[iU] || u.location == -1) continue;
+    uploadUniformValue(u, uniformValues[iU].data());
+  }
+}
+
 void GLCompiledProgram::addUniqueAttribute(ShaderSpecAttribute newAttribute) {
   for (GLShaderAttribute& a : attributes) {
     if (a.name == newAttribute.name) {
@@ -1172,11 +2445,14 @@ void GLCompiledProgram::addUniqueAttribute(ShaderSpecAttribute newAttribute) {
       // if it occurs twice, confirm that the occurences match
       if (a.type != newAttribute.type)
         exception("attribute " + a.name + " appears twice in program with different types");
+      if (a.perInstance != newAttribute.perInstance)
+        exception("attribute " + a.name + " appears twice in program with different instancing");
 
       return;
     }
   }
-  attributes.push_back(GLShaderAttribute{newAttribute.name, newAttribute.type, newAttribute.arrayCount, -1, nullptr});
+  attributes.push_back(GLShaderAttribute{newAttribute.name, newAttribute.type, newAttribute.arrayCount,
+                                         newAttribute.perInstance, -1, nullptr, 0});
 }
 
 void GLCompiledProgram::addUniqueUniform(ShaderSpecUniform newUniform) {
@@ -1212,6 +2488,18 @@ GLShaderProgram::GLShaderProgram(const std::shared_ptr<GLCompiledProgram>& compi
       attributes(compiledProgram_->getAttributes()), textures(compiledProgram_->getTextures()),
       compiledProgram(compiledProgram_) {
 
+  for (size_t iU = 0; iU < uniforms.size(); iU++) {
+    uniformIndices[uniforms[iU].name] = static_cast<int32_t>(iU);
+  }
+
+  // Until the link finishes, treat everything as present, values are held and applied once it is ready
+  if (!compiledProgram->isReady()) {
+    locationsPending = true;
+    for (GLShaderUniform& u : uniforms) u.location = pendingLocation;
+    for (GLShaderAttribute& a : attributes) a.location = pendingLocation;
+    for (GLShaderTexture& t : textures) t.location = pendingLocation;
+  }
+
   // Create a VAO
   glGenVertexArrays(1, &vaoHandle);
   checkGLError();
@@ -1220,7 +2508,10 @@ GLShaderProgram::GLShaderProgram(const std::shared_ptr<GLCompiledProgram>& compi
   checkGLError();
 }
 
-GLShaderProgram::~GLShaderProgram() { glDeleteVertexArrays(1, &vaoHandle); }
+GLShaderProgram::~GLShaderProgram() {
+  if (interleavedVBO != 0) glDeleteBuffers(1, &interleavedVBO);
+  glDeleteVertexArrays(1, &vaoHandle);
+}
 
 void GLShaderProgram::bindVAO() { glBindVertexArray(vaoHandle); }
 
@@ -1263,13 +2554,14 @@ void GLShaderProgram::setAttribute(std::string name, std::shared_ptr<AttributeBu
                                     renderDataTypeName(a.type) + " set with buffer of type " +
                                     renderDataTypeName(externalBuffer->getType()));
 
-      // check multiple-set errors (duplicates in externalBuffers list?)
-      if (a.buff) throw std::invalid_argument("attribute " + name + " is already set");
-
       // cast to the engine type (booooooo)
       std::shared_ptr<GLAttributeBuffer> engineExtBuff = std::dynamic_pointer_cast<GLAttributeBuffer>(externalBuffer);
       if (!engineExtBuff) throw std::invalid_argument("attribute " + name + " external buffer engine type cast failed");
 
+      // Setting the same buffer again does nothing. Setting a different one re-binds the attribute, which lets the
+      // source of a per-element value be swapped without rebuilding the program.
+      if (a.buff == engineExtBuff) return;
+
       a.buff = engineExtBuff;
       checkGLError();
 
@@ -1285,59 +2577,195 @@ void GLShaderProgram::setAttribute(std::string name, std::shared_ptr<AttributeBu
   throw std::invalid_argument("Tried to set nonexistent attribute with name " + name);
 }
 
-void GLShaderProgram::assignBufferToVAO(GLShaderAttribute& a) {
+void GLShaderProgram::assignBufferToVAO(GLShaderAttribute& a, VertexBufferHandle sourceVBO, size_t stride,
+                                        size_t offset) {
+  if (a.location == pendingLocation) return; // done by ensureProgramReady()
   bindVAO();
-  a.buff->bind();
+  if (sourceVBO != 0) {
+    glBindBuffer(GL_ARRAY_BUFFER, sourceVBO);
+  } else {
+    a.buff->bind();
+    offset += a.buff->getByteOffset();
+  }
+  a.boundStorageVersion = a.buff->getStorageVersion();
   checkGLError();
 
   // Choose the correct type for the buffer
   for (int iArrInd = 0; iArrInd < a.arrayCount; iArrInd++) {
 
     glEnableVertexAttribArray(a.location + iArrInd);
+    glVertexAttribDivisor(a.location + iArrInd, a.perInstance ? 1 : 0);
+
+    AttributeStorageFormat storageFormat = a.buff->getStorageFormat();
+    if (storageFormat != AttributeStorageFormat::Float32) {
+      // compact storage, the fetch converts it back to floats
+      GLint nComp = renderDataTypeCountCompatbility(a.type, RenderDataType::Float);
+      int entryBytes = storageSizeInBytes(a.type, storageFormat);
+      glVertexAttribPointer(a.location + iArrInd, nComp, native(storageFormat),
+                            storageFormat == AttributeStorageFormat::Float16 ? GL_FALSE : GL_TRUE,
+                            stride != 0 ? stride : entryBytes * a.arrayCount,
+                            reinterpret_cast<void*>(offset + entryBytes * iArrInd));
+      continue;
+    }
 
+    GLint nComp;
+    GLenum compType;
     switch (a.type) {
     case RenderDataType::Float:
-      glVertexAttribPointer(a.location + iArrInd, 1, GL_FLOAT, GL_FALSE, sizeof(float) * 1 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(float) * 1 * iArrInd));
+      nComp = 1;
+      compType = GL_FLOAT;
       break;
     case RenderDataType::Int:
-      glVertexAttribPointer(a.location + iArrInd, 1, GL_INT, GL_FALSE, sizeof(int) * 1 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(int) * 1 * iArrInd));
+      nComp = 1;
+      compType = GL_INT;
       break;
     case RenderDataType::UInt:
-      glVertexAttribPointer(a.location + iArrInd, 1, GL_UNSIGNED_INT, GL_FALSE, sizeof(uint32_t) * 1 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(uint32_t) * 1 * iArrInd));
+      nComp = 1;
+      compType = GL_UNSIGNED_INT;
       break;
     case RenderDataType::Vector2Float:
-      glVertexAttribPointer(a.location + iArrInd, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(float) * 2 * iArrInd));
+      nComp = 2;
+      compType = GL_FLOAT;
       break;
     case RenderDataType::Vector3Float:
-      glVertexAttribPointer(a.location + iArrInd, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(float) * 3 * iArrInd));
+      nComp = 3;
+      compType = GL_FLOAT;
       break;
     case RenderDataType::Vector4Float:
-      glVertexAttribPointer(a.location + iArrInd, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 4 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(float) * 4 * iArrInd));
+      nComp = 4;
+      compType = GL_FLOAT;
       break;
     case RenderDataType::Vector2UInt:
-      glVertexAttribPointer(a.location + iArrInd, 2, GL_UNSIGNED_INT, GL_FALSE, sizeof(uint32_t) * 2 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(uint32_t) * 2 * iArrInd));
+      nComp = 2;
+      compType = GL_UNSIGNED_INT;
       break;
     case RenderDataType::Vector3UInt:
-      glVertexAttribPointer(a.location + iArrInd, 3, GL_UNSIGNED_INT, GL_FALSE, sizeof(uint32_t) * 3 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(uint32_t) * 3 * iArrInd));
+      nComp = 3;
+      compType = GL_UNSIGNED_INT;
       break;
     case RenderDataType::Vector4UInt:
-      glVertexAttribPointer(a.location + iArrInd, 4, GL_UNSIGNED_INT, GL_FALSE, sizeof(uint32_t) * 4 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(uint32_t) * 4 * iArrInd));
+      nComp = 4;
+      compType = GL_UNSIGNED_INT;
       break;
     default:
       throw std::invalid_argument("Unrecognized GLShaderAttribute type");
       break;
     }
+
+    // all component types are 4 bytes
+    size_t entryBytes = 4 * nComp;
+    glVertexAttribPointer(a.location + iArrInd, nComp, compType, GL_FALSE,
+                          stride != 0 ? stride : entryBytes * a.arrayCount,
+                          reinterpret_cast<void*>(offset + entryBytes * iArrInd));
+  }
+
+  checkGLError();
+}
+
+void GLShaderProgram::updateAttributeBindings() {
+  for (size_t iA = 0; iA < attributes.size(); iA++) {
+    GLShaderAttribute& a = attributes[iA];
+    if (a.location < 0 || !a.buff || a.buff->getStorageVersion() == a.boundStorageVersion) continue;
+
+    // interleaved attributes read a copy, which is still valid
+    bool interleaved = false;
+    for (const InterleavedAttribute& ia : interleavedAttributes) {
+      if (ia.attributeIndex == iA && ia.buff == a.buff) interleaved = true;
+    }
+    if (interleaved) {
+      a.boundStorageVersion = a.buff->getStorageVersion();
+      continue;
+    }
+
+    assignBufferToVAO(a);
+  }
+}
+
+void GLShaderProgram::updateInterleavedAttributes() {
+  if (!options::interleaveVertexAttributes) {
+    if (interleavedVBO != 0) releaseInterleavedAttributes();
+    interleaveAttempted = false;
+    return;
+  }
+
+  if (interleavedVBO != 0) {
+    // If any source was re-set or written since it was copied, read them all separately from now on. Attributes which
+    // change once are likely to change again, so they are not packed again.
+    for (const InterleavedAttribute& ia : interleavedAttributes) {
+      if (attributes[ia.attributeIndex].buff != ia.buff || ia.buff->getContentVersion() != ia.contentVersion) {
+        releaseInterleavedAttributes();
+        return;
+      }
+    }
+    return;
+  }
+
+  if (!interleaveAttempted) interleaveAttributes();
+}
+
+void GLShaderProgram::interleaveAttributes() {
+  interleaveAttempted = true;
+
+  // Pack the per-vertex attributes which have static, full-precision buffers all of the same length. Per-instance
+  // attributes and compact or streaming buffers keep their own streams.
+  std::vector<size_t> packInds;
+  int64_t nElements = -1;
+  for (size_t iA = 0; iA < attributes.size(); iA++) {
+    GLShaderAttribute& a = attributes[iA];
+    if (a.location < 0 || !a.buff || !a.buff->isSet() || a.perInstance) continue;
+    if (a.buff->getUpdateFrequency() != BufferUpdateFrequency::Static) continue;
+    if (a.buff->getStorageFormat() != AttributeStorageFormat::Float32) continue;
+    if (nElements == -1) nElements = a.buff->getDataSize();
+    if (a.buff->getDataSize() != nElements) continue;
+    packInds.push_back(iA);
+  }
+  if (packInds.size() < 2 || nElements <= 0) return;
+
+  std::vector<size_t> offsets;
+  size_t stride = 0;
+  for (size_t iA : packInds) {
+    offsets.push_back(stride);
+    stride += attributes[iA].buff->getStorageElementBytes();
+  }
+
+  // Copy each attribute in to its slot of every element
+  std::vector<unsigned char> packed(stride * nElements);
+  std::vector<unsigned char> source;
+  for (size_t i = 0; i < packInds.size(); i++) {
+    GLAttributeBuffer& buff = *attributes[packInds[i]].buff;
+    size_t elementBytes = buff.getStorageElementBytes();
+    source.resize(elementBytes * nElements);
+    glBindBuffer(GL_COPY_READ_BUFFER, buff.getStorageHandle());
+    glGetBufferSubData(GL_COPY_READ_BUFFER, buff.getByteOffset(), source.size(), &source.front());
+    for (int64_t iE = 0; iE < nElements; iE++) {
+      std::memcpy(&packed[iE * stride + offsets[i]], &source[iE * elementBytes], elementBytes);
+    }
+  }
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+  glGenBuffers(1, &interleavedVBO);
+  glBindBuffer(GL_ARRAY_BUFFER, interleavedVBO);
+  glBufferData(GL_ARRAY_BUFFER, packed.size(), &packed.front(), GL_STATIC_DRAW);
+  checkGLError();
+
+  for (size_t i = 0; i < packInds.size(); i++) {
+    GLShaderAttribute& a = attributes[packInds[i]];
+    interleavedAttributes.push_back(InterleavedAttribute{packInds[i], a.buff, a.buff->getContentVersion()});
+    assignBufferToVAO(a, interleavedVBO, stride, offsets[i]);
   }
+}
+
+void GLShaderProgram::releaseInterleavedAttributes() {
+  // Point the attributes back at their own buffers (unless they have since been set to some other buffer, which
+  // already did this)
+  for (const InterleavedAttribute& ia : interleavedAttributes) {
+    GLShaderAttribute& a = attributes[ia.attributeIndex];
+    if (a.buff == ia.buff) assignBufferToVAO(a);
+  }
+  interleavedAttributes.clear();
 
+  glDeleteBuffers(1, &interleavedVBO);
+  interleavedVBO = 0;
   checkGLError();
 }
 
@@ -1362,260 +2790,250 @@ void GLShaderProgram::ensureBufferExists(GLShaderAttribute& a) {
 }
 
 bool GLShaderProgram::hasUniform(std::string name) {
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name && u.location != -1) {
+  auto it = uniformIndices.find(name);
+  return it != uniformIndices.end() && uniforms[it->second].location != -1;
+}
+
+UniformHandle GLShaderProgram::getUniformHandle(std::string name) {
+  auto it = uniformIndices.find(name);
+  if (it == uniformIndices.end()) {
+    throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  }
+  UniformHandle handle;
+  handle.index = it->second;
+  return handle;
+}
+
+GLShaderUniform* GLShaderProgram::resolveUniform(UniformHandle handle, RenderDataType type) {
+  if (handle.index < 0 || handle.index >= static_cast<int32_t>(uniforms.size())) {
+    throw std::invalid_argument("Tried to set uniform with invalid handle");
+  }
+  GLShaderUniform& u = uniforms[handle.index];
+  if (u.location == -1) return nullptr;
+  if (u.type != type) {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
+  }
+  return &u;
+}
+
+bool GLShaderProgram::deferUniformValue(int32_t index, const void* val, size_t nBytes) {
+  if (!UniformRecording::isActive()) {
+    // values set directly must not be overwritten by older recorded ones
+    applyRecordedUniforms();
+    return false;
+  }
+  if (nBytes > sizeof(RecordedUniform::value)) return false;
+
+  for (RecordedUniform& r : recordedUniforms) {
+    if (r.index == index) {
+      std::memcpy(r.value.data(), val, nBytes);
       return true;
     }
   }
-  return false;
+  RecordedUniform r;
+  r.index = index;
+  r.nBytes = nBytes;
+  std::memcpy(r.value.data(), val, nBytes);
+  recordedUniforms.push_back(r);
+  return true;
+}
+
+void GLShaderProgram::applyRecordedUniforms() {
+  if (recordedUniforms.empty()) return;
+  std::vector<RecordedUniform> toApply;
+  toApply.swap(recordedUniforms);
+  for (const RecordedUniform& r : toApply) {
+    if (!compiledProgram->updateUniformValue(r.index, r.value.data(), r.nBytes)) continue;
+    useProgram(compiledProgram->getHandle());
+    uploadUniformValue(uniforms[r.index], r.value.data());
+  }
 }
 
 // Set an integer
 void GLShaderProgram::setUniform(std::string name, int val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Int) {
-        glUniform1i(u.location, val);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, int val) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::Int);
+  if (!u) return; // optimized out
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &val, sizeof(val))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &val, sizeof(val))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniform1i(u->location, val);
 }
 
 // Set an unsigned integer
 void GLShaderProgram::setUniform(std::string name, unsigned int val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::UInt) {
-        glUniform1ui(u.location, val);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, unsigned int val) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::UInt);
+  if (!u) return; // optimized out
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &val, sizeof(val))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &val, sizeof(val))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniform1ui(u->location, val);
 }
 
 // Set a float
 void GLShaderProgram::setUniform(std::string name, float val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Float) {
-        glUniform1f(u.location, val);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, float val) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::Float);
+  if (!u) return; // optimized out
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &val, sizeof(val))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &val, sizeof(val))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniform1f(u->location, val);
 }
 
 // Set a double --- WARNING casts down to float
 void GLShaderProgram::setUniform(std::string name, double val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Float) {
-        glUniform1f(u.location, static_cast<float>(val));
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, double val) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::Float);
+  if (!u) return; // optimized out
+  float valF = static_cast<float>(val);
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &valF, sizeof(valF))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &valF, sizeof(valF))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniform1f(u->location, valF);
 }
 
 // Set a 4x4 uniform matrix
 // TODO why do we use a pointer here... makes no sense
 void GLShaderProgram::setUniform(std::string name, float* val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Matrix44Float) {
-        glUniformMatrix4fv(u.location, 1, false, val);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, float* val) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::Matrix44Float);
+  if (!u) return; // optimized out
+  std::array<float, 16> valM;
+  std::copy(val, val + 16, valM.begin());
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &valM, sizeof(valM))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &valM, sizeof(valM))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniformMatrix4fv(u->location, 1, false, val);
 }
 
 // Set a vector2 uniform
 void GLShaderProgram::setUniform(std::string name, glm::vec2 val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector2Float) {
-        glUniform2f(u.location, val.x, val.y);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, glm::vec2 val) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::Vector2Float);
+  if (!u) return; // optimized out
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &val, sizeof(val))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &val, sizeof(val))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniform2f(u->location, val.x, val.y);
 }
 
 // Set a vector3 uniform
 void GLShaderProgram::setUniform(std::string name, glm::vec3 val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector3Float) {
-        glUniform3f(u.location, val.x, val.y, val.z);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, glm::vec3 val) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::Vector3Float);
+  if (!u) return; // optimized out
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &val, sizeof(val))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &val, sizeof(val))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniform3f(u->location, val.x, val.y, val.z);
 }
 
 // Set a vector4 uniform
 void GLShaderProgram::setUniform(std::string name, glm::vec4 val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector4Float) {
-        glUniform4f(u.location, val.x, val.y, val.z, val.w);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, glm::vec4 val) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::Vector4Float);
+  if (!u) return; // optimized out
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &val, sizeof(val))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &val, sizeof(val))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniform4f(u->location, val.x, val.y, val.z, val.w);
 }
 
 // Set a vector3 uniform from a float array
 void GLShaderProgram::setUniform(std::string name, std::array<float, 3> val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector3Float) {
-        glUniform3f(u.location, val[0], val[1], val[2]);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, std::array<float, 3> val) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::Vector3Float);
+  if (!u) return; // optimized out
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &val, sizeof(val))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &val, sizeof(val))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniform3f(u->location, val[0], val[1], val[2]);
 }
 
 // Set a vec4 uniform
 void GLShaderProgram::setUniform(std::string name, float x, float y, float z, float w) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector4Float) {
-        glUniform4f(u.location, x, y, z, w);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), x, y, z, w);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, float x, float y, float z, float w) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::Vector4Float);
+  if (!u) return; // optimized out
+  glm::vec4 val{x, y, z, w};
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &val, sizeof(val))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &val, sizeof(val))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniform4f(u->location, x, y, z, w);
 }
 
 // Set a uint vector2 uniform
 void GLShaderProgram::setUniform(std::string name, glm::uvec2 val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector2UInt) {
-        glUniform2ui(u.location, val.x, val.y);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, glm::uvec2 val) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::Vector2UInt);
+  if (!u) return; // optimized out
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &val, sizeof(val))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &val, sizeof(val))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniform2ui(u->location, val.x, val.y);
 }
 
 // Set a uint vector3 uniform
 void GLShaderProgram::setUniform(std::string name, glm::uvec3 val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector3UInt) {
-        glUniform3ui(u.location, val.x, val.y, val.z);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, glm::uvec3 val) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::Vector3UInt);
+  if (!u) return; // optimized out
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &val, sizeof(val))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &val, sizeof(val))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniform3ui(u->location, val.x, val.y, val.z);
 }
 
 // Set a uint vector4 uniform
 void GLShaderProgram::setUniform(std::string name, glm::uvec4 val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector4UInt) {
-        glUniform4ui(u.location, val.x, val.y, val.z, val.w);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
-  }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  setUniform(getUniformHandle(name), val);
+}
+void GLShaderProgram::setUniform(UniformHandle handle, glm::uvec4 val) {
+  GLShaderUniform* u = resolveUniform(handle, RenderDataType::Vector4UInt);
+  if (!u) return; // optimized out
+  u->isSet = true;
+  if (deferUniformValue(handle.index, &val, sizeof(val))) return;
+  if (!compiledProgram->updateUniformValue(handle.index, &val, sizeof(val))) return;
+  useProgram(compiledProgram->getHandle());
+  glUniform4ui(u->location, val.x, val.y, val.z, val.w);
 }
 
 bool GLShaderProgram::hasAttribute(std::string name) {
@@ -1630,7 +3048,7 @@ bool GLShaderProgram::hasAttribute(std::string name) {
 bool GLShaderProgram::attributeIsSet(std::string name) {
   for (GLShaderAttribute& a : attributes) {
     if (a.name == name && a.location != -1) {
-      return a.buff->isSet();
+      return a.buff && a.buff->isSet();
     }
   }
   return false;
@@ -1851,8 +3269,6 @@ void GLShaderProgram::setTexture2D(std::string name, unsigned char* texData, uns
 }
 
 void GLShaderProgram::setTextureFromBuffer(std::string name, TextureBuffer* textureBuffer) {
-  glUseProgram(compiledProgram->getHandle());
-
   // Find the right texture
   for (GLShaderTexture& t : textures) {
     if (t.name != name || t.location == -1) continue;
@@ -1874,9 +3290,7 @@ void GLShaderProgram::setTextureFromBuffer(std::string name, TextureBuffer* text
 }
 
 void GLShaderProgram::setTextureFromColormap(std::string name, const std::string& colormapName, bool allowUpdate) {
-  const ValueColorMap& colormap = render::engine->getColorMap(colormapName);
-
-  // TODO switch to global shared buffers from colormap
+  int row = engine->getColorMapAtlasRow(colormapName);
 
   // Find the right texture
   for (GLShaderTexture& t : textures) {
@@ -1886,27 +3300,16 @@ void GLShaderProgram::setTextureFromColormap(std::string name, const std::string
       throw std::invalid_argument("Attempted to set texture twice");
     }
 
-    if (t.dim != 1) {
+    if (t.dim != 2) {
       throw std::invalid_argument("Tried to use texture with mismatched dimension " + std::to_string(t.dim));
     }
 
-    // Fill a buffer with the data
-    unsigned int dataLength = colormap.values.size() * 3;
-    std::vector<float> colorBuffer(dataLength);
-    for (unsigned int i = 0; i < colormap.values.size(); i++) {
-      colorBuffer[3 * i + 0] = static_cast<float>(colormap.values[i][0]);
-      colorBuffer[3 * i + 1] = static_cast<float>(colormap.values[i][1]);
-      colorBuffer[3 * i + 2] = static_cast<float>(colormap.values[i][2]);
-    }
-
-    // glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, colormap.values.size(), 0, GL_RGB, GL_FLOAT, &(colorBuffer[0]));
-    t.textureBufferOwned = std::dynamic_pointer_cast<GLTextureBuffer>(
-        engine->generateTextureBuffer(TextureFormat::RGB32F, colormap.values.size(), &(colorBuffer[0])));
-    t.textureBufferOwned->setFilterMode(FilterMode::Linear);
-    t.textureBuffer = t.textureBufferOwned.get();
-
-
+    // all color maps are rows of the shared atlas
+    t.textureBufferOwned.reset();
+    t.textureBuffer = dynamic_cast<GLTextureBuffer*>(&engine->getColorMapAtlas());
     t.isSet = true;
+
+    setUniform(colormapRowUniformName(name), row);
     return;
   }
 
@@ -1964,6 +3367,8 @@ void GLShaderProgram::validateData() {
 
   // WARNING: this function is poorly named, it doesn't just do sanity checks, it also sets important values
 
+  if (!ensureProgramReady()) return; // locations are not known yet
+
   // Check uniforms
   for (GLShaderUniform& u : uniforms) {
     if (u.location == -1) continue;
@@ -1974,7 +3379,7 @@ void GLShaderProgram::validateData() {
 
   // Check attributes
   int64_t attributeSize = -1;
-  for (GLShaderAttribute a : attributes) {
+  for (const GLShaderAttribute& a : attributes) {
     if (a.location == -1) continue;
     if (!a.buff) {
       throw std::invalid_argument("Attribute " + a.name + " has no buffer attached");
@@ -1985,6 +3390,16 @@ void GLShaderProgram::validateData() {
 
     int compatCount = renderDataTypeCountCompatbility(a.type, a.buff->getType());
 
+    // per-instance attributes just need an entry for each instance, they do not set the vertex count
+    if (a.perInstance) {
+      if (instanceCount != INVALID_IND_32 && a.buff->getDataSize() / compatCount < instanceCount) {
+        throw std::invalid_argument("Per-instance attribute " + a.name + " has size " +
+                                    std::to_string(a.buff->getDataSize()) + ", but instance count is " +
+                                    std::to_string(instanceCount));
+      }
+      continue;
+    }
+
     if (attributeSize == -1) { // first one we've seen
       attributeSize = a.buff->getDataSize() / (compatCount);
     } else { // not the first one we've seen
@@ -2038,16 +3453,49 @@ void GLShaderProgram::activateTextures() {
   for (GLShaderTexture& t : textures) {
     if (t.location == -1) continue;
 
-    glActiveTexture(GL_TEXTURE0 + t.index);
-    t.textureBuffer->bind();
-    glUniform1i(t.location, t.index);
+    // the sampler uniform already points at this unit, see setDataLocations()
+    glEngine->bindTextureToUnit(t.index, *t.textureBuffer);
+  }
+}
+
+bool GLShaderProgram::ensureProgramReady() {
+  if (!locationsPending) return true;
+  if (!compiledProgram->isReady()) return false;
+  locationsPending = false;
+
+  std::vector<GLShaderUniform> readyUniforms = compiledProgram->getUniforms();
+  for (size_t i = 0; i < uniforms.size(); i++) {
+    uniforms[i].location = readyUniforms[i].location;
+  }
+
+  std::vector<GLShaderAttribute> readyAttributes = compiledProgram->getAttributes();
+  for (size_t i = 0; i < attributes.size(); i++) {
+    GLShaderAttribute& a = attributes[i];
+    a.location = readyAttributes[i].location;
+    if (a.location != -1 && a.buff) assignBufferToVAO(a);
+  }
+
+  std::vector<GLShaderTexture> readyTextures = compiledProgram->getTextures();
+  for (size_t i = 0; i < textures.size(); i++) {
+    textures[i].location = readyTextures[i].location;
   }
+
+  return true;
 }
 
 void GLShaderProgram::draw() {
+  if (!ensureProgramReady()) return; // still compiling, see options::asyncShaderCompilation
   validateData();
+  applyRecordedUniforms();
+  updateAttributeBindings();
+  updateInterleavedAttributes();
+
+  // make sure the uniform block holds something sensible, in case nothing has filled it yet
+  if (compiledProgram->getUsesFrameUniforms() && !glEngine->frameUniformsAreValid()) {
+    glEngine->updateFrameUniforms();
+  }
 
-  glUseProgram(compiledProgram->getHandle());
+  useProgram(compiledProgram->getHandle());
   glBindVertexArray(vaoHandle);
 
   if (usePrimitiveRestart) {
@@ -2105,11 +3553,91 @@ void GLShaderProgram::draw() {
     glDisable(GL_PRIMITIVE_RESTART);
   }
 
+  countDrawCall(drawDataLength);
+  checkGLError();
+}
+
+void GLShaderProgram::drawSubset(AttributeBuffer& elementOrder, const std::vector<std::array<size_t, 2>>& ranges) {
+  if (drawMode != DrawMode::Triangles && drawMode != DrawMode::IndexedTriangles && drawMode != DrawMode::Points) {
+    throw std::invalid_argument(
+        "drawSubset() is only supported for DrawMode::Triangles, DrawMode::IndexedTriangles and DrawMode::Points");
+  }
+  if (elementOrder.getType() != RenderDataType::UInt) {
+    throw std::invalid_argument("drawSubset() element order buffer should be UInt");
+  }
+  GLAttributeBuffer* glOrder = dynamic_cast<GLAttributeBuffer*>(&elementOrder);
+  if (!glOrder) throw std::invalid_argument("element order buffer engine type cast failed");
+
+  if (!ensureProgramReady()) return; // still compiling, see options::asyncShaderCompilation
+  validateData();
+  applyRecordedUniforms();
+  updateAttributeBindings();
+  updateInterleavedAttributes();
+  if (ranges.empty()) return;
+
+  // make sure the uniform block holds something sensible, in case nothing has filled it yet
+  if (compiledProgram->getUsesFrameUniforms() && !glEngine->frameUniformsAreValid()) {
+    glEngine->updateFrameUniforms();
+  }
+
+  std::vector<GLsizei> counts;
+  std::vector<const GLvoid*> offsets;
+  counts.reserve(ranges.size());
+  offsets.reserve(ranges.size());
+  for (const std::array<size_t, 2>& range : ranges) {
+    if (range[0] + range[1] > static_cast<size_t>(glOrder->getDataSize())) {
+      throw std::invalid_argument("drawSubset() range is out of bounds of the element order buffer");
+    }
+    counts.push_back(static_cast<GLsizei>(range[1]));
+    offsets.push_back(reinterpret_cast<const GLvoid*>(range[0] * sizeof(uint32_t)));
+  }
+
+  useProgram(compiledProgram->getHandle());
+  glBindVertexArray(vaoHandle);
+
+  activateTextures();
+
+  // the element buffer binding is VAO state, so restore it afterwards to leave the program's usual draw() unaffected
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glOrder->getHandle());
+  GLenum primitive = (drawMode == DrawMode::Points) ? GL_POINTS : GL_TRIANGLES;
+  glMultiDrawElements(primitive, &counts.front(), GL_UNSIGNED_INT, &offsets.front(),
+                      static_cast<GLsizei>(counts.size()));
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (useIndex && indexBuffer) ? indexBuffer->getHandle() : 0);
+
+  for (GLsizei count : counts) {
+    countDrawCall(count);
+  }
   checkGLError();
 }
 
 GLEngine::GLEngine() {}
-GLEngine::~GLEngine() {}
+GLEngine::~GLEngine() {
+  for (auto& p : indexGatherPrograms) {
+    forgetProgramInUse(p.second);
+    glDeleteProgram(p.second);
+  }
+  for (ProgramHandle p : {meshFaceNormalProgram, meshVertexNormalProgram}) {
+    if (p != 0) {
+      forgetProgramInUse(p);
+      glDeleteProgram(p);
+    }
+  }
+  for (VertexBufferHandle b : meshNormalScratch) {
+    if (b != 0) glDeleteBuffers(1, &b);
+  }
+  if (frameUniformBuffer != 0) {
+    glDeleteBuffers(1, &frameUniformBuffer);
+  }
+  if (samplesPassedQuery != 0) {
+    glDeleteQueries(1, &samplesPassedQuery);
+  }
+  for (auto& q : pendingTimestampQueries) {
+    glDeleteQueries(1, &q.second);
+  }
+  if (!freeTimestampQueries.empty()) {
+    glDeleteQueries(static_cast<GLsizei>(freeTimestampQueries.size()), &freeTimestampQueries.front());
+  }
+}
 
 void GLEngine::checkError(bool fatal) { checkGLError(fatal); }
 
@@ -2134,7 +3662,75 @@ std::vector<unsigned char> GLEngine::readDisplayBuffer() {
 }
 
 
+namespace {
+// Whether a render state change needs to be issued to GL, i.e. the shadowed value is unknown or different. Records
+// the new value.
+template <typename T>
+bool renderStateNeedsChange(bool& known, T& curr, const T& newVal) {
+  if (known && curr == newVal) {
+    engine->stats.stateChangesSkipped++;
+    return false;
+  }
+  known = true;
+  curr = newVal;
+  engine->stats.stateChanges++;
+  return true;
+}
+} // namespace
+
+void GLEngine::invalidateStateCache() {
+  invalidateDepthBlendStateCache();
+  colorMaskKnown = false;
+  backfaceCullKnown = false;
+  activeTextureUnitKnown = false;
+  boundTextures.clear();
+}
+
+void GLEngine::invalidateDepthBlendStateCache() {
+  depthModeKnown = false;
+  blendModeKnown = false;
+}
+
+void GLEngine::setActiveTextureUnit(uint32_t unit) {
+  if (activeTextureUnitKnown && activeTextureUnit == unit) return;
+  glActiveTexture(GL_TEXTURE0 + unit);
+  activeTextureUnitKnown = true;
+  activeTextureUnit = unit;
+}
+
+void GLEngine::bindTextureToUnit(uint32_t unit, GLTextureBuffer& texture) {
+  std::pair<GLenum, TextureBufferHandle> binding{texture.textureType(), texture.getHandle()};
+  if (unit < boundTextures.size() && boundTextures[unit] == binding) {
+    stats.stateChangesSkipped++;
+    return;
+  }
+  setActiveTextureUnit(unit);
+  texture.bind(); // records the binding
+  stats.stateChanges++;
+}
+
+void GLEngine::recordTextureBind(GLenum target, TextureBufferHandle handle) {
+  if (!activeTextureUnitKnown) {
+    // don't know which unit this went to
+    boundTextures.clear();
+    return;
+  }
+  // a unit holds one binding per target, but only the most recent one is tracked, so any other target on the unit is
+  // conservatively forgotten
+  if (activeTextureUnit >= boundTextures.size()) {
+    boundTextures.resize(activeTextureUnit + 1, std::make_pair(GLenum(0), TextureBufferHandle(0)));
+  }
+  boundTextures[activeTextureUnit] = std::make_pair(target, handle);
+}
+
+void GLEngine::forgetTextureBindings(TextureBufferHandle handle) {
+  for (std::pair<GLenum, TextureBufferHandle>& b : boundTextures) {
+    if (b.second == handle) b = std::make_pair(GLenum(0), TextureBufferHandle(0));
+  }
+}
+
 void GLEngine::setDepthMode(DepthMode newMode) {
+  if (!renderStateNeedsChange(depthModeKnown, currDepthMode, newMode)) return;
   switch (newMode) {
   case DepthMode::Less:
     glEnable(GL_DEPTH_TEST);
@@ -2169,6 +3765,7 @@ void GLEngine::setDepthMode(DepthMode newMode) {
 }
 
 void GLEngine::setBlendMode(BlendMode newMode) {
+  if (!renderStateNeedsChange(blendModeKnown, currBlendMode, newMode)) return;
   switch (newMode) {
   case BlendMode::AlphaOver:
     glEnable(GL_BLEND);
@@ -2205,9 +3802,13 @@ void GLEngine::setBlendMode(BlendMode newMode) {
   }
 }
 
-void GLEngine::setColorMask(std::array<bool, 4> mask) { glColorMask(mask[0], mask[1], mask[2], mask[3]); }
+void GLEngine::setColorMask(std::array<bool, 4> mask) {
+  if (!renderStateNeedsChange(colorMaskKnown, currColorMask, mask)) return;
+  glColorMask(mask[0], mask[1], mask[2], mask[3]);
+}
 
 void GLEngine::setBackfaceCull(bool newVal) {
+  if (!renderStateNeedsChange(backfaceCullKnown, currBackfaceCull, newVal)) return;
   if (newVal) {
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
@@ -2234,6 +3835,17 @@ void GLEngine::applyTransparencySettings() {
     setDepthMode(DepthMode::Less);
     break;
   }
+  case TransparencyMode::WeightedBlended: {
+    if (weightedTransparencyPass) {
+      // accumulate all transparent fragments, testing against (but not writing) the opaque depth
+      setBlendMode(BlendMode::Add);
+      setDepthMode(DepthMode::LEqualReadOnly);
+    } else {
+      setBlendMode(BlendMode::AlphaOver);
+      setDepthMode(DepthMode::Less);
+    }
+    break;
+  }
   }
 }
 
@@ -2289,6 +3901,11 @@ std::shared_ptr<TextureBuffer> GLEngine::generateTextureBuffer(TextureFormat for
   GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, sizeZ_, data);
   return std::shared_ptr<TextureBuffer>(newT);
 }
+std::shared_ptr<TextureBuffer> GLEngine::wrapExternalTexture(TextureFormat format, unsigned int sizeX_,
+                                                             unsigned int sizeY_, uint32_t nativeHandle) {
+  GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, GLTextureBuffer::ExternalHandle{nativeHandle});
+  return std::shared_ptr<TextureBuffer>(newT);
+}
 
 std::shared_ptr<RenderBuffer> GLEngine::generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
                                                              unsigned int sizeY_) {
@@ -2345,6 +3962,56 @@ std::string GLEngine::programKeyFromRules(const std::string& programName, const
   return builder.str();
 }
 
+namespace {
+
+// Uniforms which are sourced from the per-frame uniform block rather than set on each program
+const std::vector<std::string> frameUniformDeclarations = {
+    "uniform mat4 u_projMatrix;",
+    "uniform mat4 u_invProjMatrix;",
+};
+
+// Rewrite any stages which declare the per-frame uniforms to read them from the shared block instead. The uniforms
+// remain in the program's uniform list, but get no location, so setting them is a no-op.
+std::vector<ShaderStageSpecification> useFrameUniformBlock(const std::vector<ShaderStageSpecification>& stages) {
+  std::vector<ShaderStageSpecification> updatedStages;
+  for (const ShaderStageSpecification& stage : stages) {
+    std::string src = stage.src;
+
+    // the block goes right after the version directive
+    std::string versionStr = "#version 330 core";
+    size_t versionPos = src.find(versionStr);
+
+    bool declaresFrameUniform = false;
+    if (versionPos != std::string::npos) {
+      for (const std::string& decl : frameUniformDeclarations) {
+        size_t pos;
+        while ((pos = src.find(decl)) != std::string::npos) {
+          src.erase(pos, decl.size());
+          declaresFrameUniform = true;
+        }
+      }
+    }
+
+    if (declaresFrameUniform) {
+      src.insert(src.find(versionStr) + versionStr.size(), std::string("\n") + shaderFrameUniformBlockSource);
+    }
+
+    updatedStages.push_back(ShaderStageSpecification{stage.stage, stage.uniforms, stage.attributes, stage.textures,
+                                                     declaresFrameUniform ? src : stage.src});
+  }
+  return updatedStages;
+}
+
+} // namespace
+
+bool GLEngine::shaderVariantAvailable(const ShaderProgramRequest& request) {
+  if (registeredShaderPrograms.find(request.programName) == registeredShaderPrograms.end()) return false;
+  for (const std::string& rule : request.customRules) {
+    if (rule != "" && registeredShaderRules.find(rule) == registeredShaderRules.end()) return false;
+  }
+  return true;
+}
+
 std::shared_ptr<GLCompiledProgram> GLEngine::getCompiledProgram(const std::string& programName,
                                                                 const std::vector<std::string>& customRules,
                                                                 ShaderReplacementDefaults defaults) {
@@ -2357,6 +4024,7 @@ std::shared_ptr<GLCompiledProgram> GLEngine::getCompiledProgram(const std::strin
   if (compiledProgamCache.find(progKey) == compiledProgamCache.end()) {
 
     if (polyscope::options::verbosity > 3) polyscope::info("compiling shader program " + progKey);
+    POLYSCOPE_TRACE_SPAN("compileShaderProgram", programName);
 
     // == Compile the program
 
@@ -2418,16 +4086,34 @@ std::shared_ptr<GLCompiledProgram> GLEngine::getCompiledProgram(const std::strin
     }
 
     // Actually apply rule substitutions
-    std::vector<ShaderStageSpecification> updatedStages = applyShaderReplacements(stages, rules);
+    std::vector<ShaderStageSpecification> updatedStages = useFrameUniformBlock(applyShaderReplacements(stages, rules));
 
     // Create a new compiled program (GL work happens in the constructor)
-    compiledProgamCache[progKey] = std::shared_ptr<GLCompiledProgram>(new GLCompiledProgram(updatedStages, dm));
+    compiledProgamCache[progKey] =
+        std::shared_ptr<GLCompiledProgram>(new GLCompiledProgram(updatedStages, dm, progKey));
+
+    recordShaderVariant(programName, customRules, defaults);
   }
 
   // Now that the cache must contain the compiled program, just return it
   return compiledProgamCache[progKey];
 }
 
+void GLEngine::prewarmShaders(const std::vector<ShaderProgramRequest>& programs) {
+  // only the compiled programs are needed, skip the per-request state that requestShader() would create
+  for (const ShaderProgramRequest& p : programs) {
+    getCompiledProgram(p.programName, p.customRules, p.defaults);
+  }
+}
+
+bool GLEngine::shaderCompilesPending() {
+  bool anyPending = false;
+  for (auto& entry : compiledProgamCache) {
+    if (!entry.second->isReady()) anyPending = true;
+  }
+  return anyPending;
+}
+
 std::shared_ptr<ShaderProgram> GLEngine::requestShader(const std::string& programName,
                                                        const std::vector<std::string>& customRules,
                                                        ShaderReplacementDefaults defaults) {
@@ -2436,6 +4122,710 @@ std::shared_ptr<ShaderProgram> GLEngine::requestShader(const std::string& progra
 }
 
 
+ProgramHandle GLEngine::getIndexGatherProgram(int nWords) {
+
+  if (indexGatherPrograms.find(nWords) != indexGatherPrograms.end()) {
+    return indexGatherPrograms[nWords];
+  }
+
+  // The element is split in to chunks of up to 4 words, each of which is passed through as an integer attribute and
+  // captured (interleaved) by transform feedback. This reproduces the exact bytes of any element type.
+  int nChunks = (nWords + 3) / 4;
+  std::vector<std::string> varyingNames;
+  std::stringstream src;
+  src << "#version 330 core\n";
+  for (int iC = 0; iC < nChunks; iC++) {
+    int chunkWords = std::min(4, nWords - 4 * iC);
+    std::string typeStr = chunkWords == 1 ? "uint" : "uvec" + std::to_string(chunkWords);
+    src << "in " << typeStr << " a_w" << iC << ";\n";
+    src << "flat out " << typeStr << " v_w" << iC << ";\n";
+    varyingNames.push_back("v_w" + std::to_string(iC));
+  }
+  src << "void main() {\n";
+  for (int iC = 0; iC < nChunks; iC++) {
+    src << "  v_w" << iC << " = a_w" << iC << ";\n";
+  }
+  src << "}\n";
+  std::string srcStr = src.str();
+
+  ShaderHandle vertHandle = glCreateShader(GL_VERTEX_SHADER);
+  const char* srcPtr = srcStr.c_str();
+  glShaderSource(vertHandle, 1, &srcPtr, nullptr);
+  glCompileShader(vertHandle);
+  GLint status;
+  glGetShaderiv(vertHandle, GL_COMPILE_STATUS, &status);
+  if (!status) {
+    printShaderInfoLog(vertHandle);
+    exception("[polyscope] GL index gather shader compile failed");
+  }
+
+  ProgramHandle progHandle = glCreateProgram();
+  glAttachShader(progHandle, vertHandle);
+  for (int iC = 0; iC < nChunks; iC++) {
+    glBindAttribLocation(progHandle, iC, ("a_w" + std::to_string(iC)).c_str());
+  }
+  std::vector<const char*> varyingPtrs;
+  for (const std::string& n : varyingNames) varyingPtrs.push_back(n.c_str());
+  glTransformFeedbackVaryings(progHandle, nChunks, &varyingPtrs.front(), GL_INTERLEAVED_ATTRIBS);
+  glLinkProgram(progHandle);
+  glGetProgramiv(progHandle, GL_LINK_STATUS, &status);
+  if (!status) {
+    printProgramInfoLog(progHandle);
+    exception("[polyscope] GL index gather program link failed");
+  }
+  glDeleteShader(vertHandle);
+  checkGLError();
+
+  indexGatherPrograms[nWords] = progHandle;
+  return progHandle;
+}
+
+bool GLEngine::gatherAttributeBufferOnDevice(AttributeBuffer& srcIn, AttributeBuffer& indicesIn,
+                                             AttributeBuffer& dstIn) {
+
+  GLAttributeBuffer* src = dynamic_cast<GLAttributeBuffer*>(&srcIn);
+  GLAttributeBuffer* indices = dynamic_cast<GLAttributeBuffer*>(&indicesIn);
+  GLAttributeBuffer* dst = dynamic_cast<GLAttributeBuffer*>(&dstIn);
+  if (!src || !indices || !dst) return false;
+
+  // Check that we can handle this case
+  if (src->getType() != dst->getType() || src->getArrayCount() != dst->getArrayCount()) return false;
+  if (src->getStorageFormat() != dst->getStorageFormat()) return false;
+  if (indices->getType() != RenderDataType::UInt || indices->getArrayCount() != 1) return false;
+  if (!src->isSet() || !indices->isSet()) return false;
+  int elementBytes = static_cast<int>(src->getStorageElementBytes()); // compact formats are copied as raw words
+  if (elementBytes % 4 != 0) return false;
+  int nWords = elementBytes / 4;
+  int nChunks = (nWords + 3) / 4;
+  GLint maxComponents;
+  glGetIntegerv(GL_MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS, &maxComponents);
+  if (nWords > maxComponents) return false;
+
+  size_t nOut = indices->getDataSize();
+  dst->allocateForDeviceWrite(nOut);
+  if (nOut == 0) return true;
+
+  ProgramHandle progHandle = getIndexGatherProgram(nWords);
+
+  // Set up a temporary VAO reading the source, indexed by the index buffer
+  AttributeHandle vao;
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+  src->bind();
+  for (int iC = 0; iC < nChunks; iC++) {
+    int chunkWords = std::min(4, nWords - 4 * iC);
+    glEnableVertexAttribArray(iC);
+    glVertexAttribIPointer(iC, chunkWords, GL_UNSIGNED_INT, elementBytes,
+                           reinterpret_cast<void*>(src->getByteOffset() + sizeof(uint32_t) * 4 * iC));
+  }
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices->getHandle());
+
+  // Run the copy
+  useProgram(progHandle);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, dst->getHandle());
+  glEnable(GL_RASTERIZER_DISCARD);
+  glBeginTransformFeedback(GL_POINTS);
+  glDrawElements(GL_POINTS, static_cast<GLsizei>(nOut), GL_UNSIGNED_INT, 0);
+  glEndTransformFeedback();
+  glDisable(GL_RASTERIZER_DISCARD);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+
+  glBindVertexArray(0);
+  glDeleteVertexArrays(1, &vao);
+  checkGLError();
+
+  return true;
+}
+
+namespace {
+
+// Build a vertex-only program whose outputs are captured by transform feedback, one varying per feedback binding
+ProgramHandle compileFeedbackProgram(const std::string& srcStr, const std::vector<std::string>& attribNames,
+                                     const std::vector<std::string>& varyingNames, const std::string& name) {
+  ShaderHandle vertHandle = glCreateShader(GL_VERTEX_SHADER);
+  const char* srcPtr = srcStr.c_str();
+  glShaderSource(vertHandle, 1, &srcPtr, nullptr);
+  glCompileShader(vertHandle);
+  GLint status;
+  glGetShaderiv(vertHandle, GL_COMPILE_STATUS, &status);
+  if (!status) {
+    printShaderInfoLog(vertHandle);
+    exception("[polyscope] GL " + name + " shader compile failed");
+  }
+
+  ProgramHandle progHandle = glCreateProgram();
+  glAttachShader(progHandle, vertHandle);
+  for (size_t iA = 0; iA < attribNames.size(); iA++) {
+    glBindAttribLocation(progHandle, static_cast<GLuint>(iA), attribNames[iA].c_str());
+  }
+  std::vector<const char*> varyingPtrs;
+  for (const std::string& n : varyingNames) varyingPtrs.push_back(n.c_str());
+  glTransformFeedbackVaryings(progHandle, static_cast<GLsizei>(varyingPtrs.size()), &varyingPtrs.front(),
+                              GL_SEPARATE_ATTRIBS);
+  glLinkProgram(progHandle);
+  glGetProgramiv(progHandle, GL_LINK_STATUS, &status);
+  if (!status) {
+    printProgramInfoLog(progHandle);
+    exception("[polyscope] GL " + name + " program link failed");
+  }
+  glDeleteShader(vertHandle);
+  checkGLError();
+  return progHandle;
+}
+
+// Expose a buffer to shaders as a buffer texture
+TextureBufferHandle makeBufferTexture(GLenum format, GLuint buffer) {
+  TextureBufferHandle tex;
+  glGenTextures(1, &tex);
+  glBindTexture(GL_TEXTURE_BUFFER, tex);
+  glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+  return tex;
+}
+
+} // namespace
+
+void GLEngine::ensureMeshNormalPrograms() {
+  if (meshFaceNormalProgram != 0) return;
+
+  // Positions and normals are read as 3 consecutive R32F texels, since 3.3 has no RGB32F buffer textures. The
+  // formulas match SurfaceMesh::computeGeometryBuffers().
+
+  // One point per face, [a_start, a_end) are the face's corners
+  const std::string faceSrc = R"(
+#version 330 core
+uniform samplerBuffer t_positions;
+uniform usamplerBuffer t_faceVerts;
+in uint a_start;
+in uint a_end;
+out vec3 v_normal;
+out vec3 v_weightedNormal;
+vec3 cornerPos(uint iC) {
+  int i = 3 * int(texelFetch(t_faceVerts, int(iC)).r);
+  return vec3(texelFetch(t_positions, i).r, texelFetch(t_positions, i + 1).r, texelFetch(t_positions, i + 2).r);
+}
+void main() {
+  uint D = a_end - a_start;
+  vec3 fN = vec3(0.);
+  float area = 0.;
+  if (D == 3u) {
+    vec3 pA = cornerPos(a_start);
+    vec3 pB = cornerPos(a_start + 1u);
+    vec3 pC = cornerPos(a_start + 2u);
+    fN = cross(pB - pA, pC - pA);
+    area = 0.5 * length(fN);
+  } else {
+    vec3 pRoot = cornerPos(a_start);
+    for (uint j = 0u; j < D; j++) {
+      vec3 pA = cornerPos(a_start + j);
+      vec3 pB = cornerPos(a_start + (j + 1u) % D);
+      vec3 pC = cornerPos(a_start + (j + 2u) % D);
+      fN += cross(pC - pB, pA - pB);
+      if (j >= 1u && j + 1u < D) area += 0.5 * length(cross(pA - pRoot, pB - pRoot));
+    }
+  }
+  v_normal = normalize(fN);
+  v_weightedNormal = v_normal * area;
+}
+)";
+  meshFaceNormalProgram =
+      compileFeedbackProgram(faceSrc, {"a_start", "a_end"}, {"v_normal", "v_weightedNormal"}, "mesh face normal");
+
+  // One point per vertex, [a_start, a_end) are the entries of its adjacent faces
+  const std::string vertexSrc = R"(
+#version 330 core
+uniform samplerBuffer t_weightedNormals;
+uniform usamplerBuffer t_vertexFaces;
+in uint a_start;
+in uint a_end;
+out vec3 v_normal;
+void main() {
+  vec3 N = vec3(0.);
+  for (uint i = a_start; i < a_end; i++) {
+    int iF = 3 * int(texelFetch(t_vertexFaces, int(i)).r);
+    N += vec3(texelFetch(t_weightedNormals, iF).r, texelFetch(t_weightedNormals, iF + 1).r,
+              texelFetch(t_weightedNormals, iF + 2).r);
+  }
+  v_normal = normalize(N);
+}
+)";
+  meshVertexNormalProgram =
+      compileFeedbackProgram(vertexSrc, {"a_start", "a_end"}, {"v_normal"}, "mesh vertex normal");
+}
+
+bool GLEngine::computeMeshNormalsOnDevice(AttributeBuffer& positionsIn, AttributeBuffer& faceStartIn,
+                                          AttributeBuffer& faceVertsIn, AttributeBuffer& vertexFaceStartIn,
+                                          AttributeBuffer& vertexFacesIn, AttributeBuffer* faceNormalsIn,
+                                          AttributeBuffer* vertexNormalsIn) {
+
+  GLAttributeBuffer* positions = dynamic_cast<GLAttributeBuffer*>(&positionsIn);
+  GLAttributeBuffer* faceStart = dynamic_cast<GLAttributeBuffer*>(&faceStartIn);
+  GLAttributeBuffer* faceVerts = dynamic_cast<GLAttributeBuffer*>(&faceVertsIn);
+  GLAttributeBuffer* vertexFaceStart = dynamic_cast<GLAttributeBuffer*>(&vertexFaceStartIn);
+  GLAttributeBuffer* vertexFaces = dynamic_cast<GLAttributeBuffer*>(&vertexFacesIn);
+  GLAttributeBuffer* faceNormals = dynamic_cast<GLAttributeBuffer*>(faceNormalsIn);
+  GLAttributeBuffer* vertexNormals = dynamic_cast<GLAttributeBuffer*>(vertexNormalsIn);
+  if (!positions || !faceStart || !faceVerts || !vertexFaceStart || !vertexFaces) return false;
+  if (faceNormalsIn && !faceNormals) return false;
+  if (vertexNormalsIn && !vertexNormals) return false;
+
+  // Check that we can handle this case
+  auto isPlainVec3 = [](GLAttributeBuffer* b) {
+    return b->getType() == RenderDataType::Vector3Float && b->getArrayCount() == 1 &&
+           b->getStorageFormat() == AttributeStorageFormat::Float32;
+  };
+  auto isUInt = [](GLAttributeBuffer* b) {
+    return b->isSet() && b->getType() == RenderDataType::UInt && b->getArrayCount() == 1;
+  };
+  if (!positions->isSet() || !isPlainVec3(positions)) return false;
+  if (!isUInt(faceStart) || !isUInt(faceVerts) || !isUInt(vertexFaceStart) || !isUInt(vertexFaces)) return false;
+  if (faceNormals && !isPlainVec3(faceNormals)) return false;
+  if (vertexNormals && !isPlainVec3(vertexNormals)) return false;
+  if (faceStart->getDataSize() < 1) return false;
+  size_t nVerts = positions->getDataSize();
+  size_t nFaces = faceStart->getDataSize() - 1;
+  size_t nCorners = faceVerts->getDataSize();
+  if (vertexFaceStart->getDataSize() != static_cast<int64_t>(nVerts + 1)) return false;
+  GLint maxTexels;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+  if (3 * std::max(nVerts, nFaces) > static_cast<size_t>(maxTexels) || nCorners > static_cast<size_t>(maxTexels)) {
+    return false;
+  }
+
+  ensureMeshNormalPrograms();
+
+  // Scratch outputs: [0] for face normals which were not requested, [1] for the area-weighted face normals
+  auto ensureScratch = [&](int i, size_t bytes) {
+    if (meshNormalScratch[i] == 0) glGenBuffers(1, &meshNormalScratch[i]);
+    if (bytes > meshNormalScratchBytes[i]) {
+      glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, meshNormalScratch[i]);
+      glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, bytes, NULL, GL_DYNAMIC_COPY);
+      meshNormalScratchBytes[i] = bytes;
+    }
+  };
+  size_t faceBytes = std::max<size_t>(nFaces, 1) * sizeof(glm::vec3);
+  ensureScratch(1, faceBytes);
+  GLuint faceNormalTarget;
+  if (faceNormals) {
+    faceNormals->allocateForDeviceWrite(nFaces);
+    faceNormalTarget = faceNormals->getHandle();
+  } else {
+    ensureScratch(0, faceBytes);
+    faceNormalTarget = meshNormalScratch[0];
+  }
+  if (vertexNormals) vertexNormals->allocateForDeviceWrite(nVerts);
+
+  // Run one point-per-element pass of a feedback program, reading [start[i], start[i+1]) as the point's attributes
+  auto runPass = [&](ProgramHandle prog, GLAttributeBuffer* startBuffer, size_t nPoints,
+                     const std::vector<std::pair<std::string, TextureBufferHandle>>& textures,
+                     const std::vector<GLuint>& outputs) {
+    AttributeHandle vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    startBuffer->bind();
+    for (GLuint iA = 0; iA < 2; iA++) {
+      glEnableVertexAttribArray(iA);
+      glVertexAttribIPointer(iA, 1, GL_UNSIGNED_INT, sizeof(uint32_t),
+                             reinterpret_cast<void*>(startBuffer->getByteOffset() + sizeof(uint32_t) * iA));
+    }
+
+    useProgram(prog);
+    for (size_t iT = 0; iT < textures.size(); iT++) {
+      glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(iT));
+      glBindTexture(GL_TEXTURE_BUFFER, textures[iT].second);
+      glUniform1i(glGetUniformLocation(prog, textures[iT].first.c_str()), static_cast<GLint>(iT));
+    }
+    for (size_t iO = 0; iO < outputs.size(); iO++) {
+      glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, static_cast<GLuint>(iO), outputs[iO]);
+    }
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(nPoints));
+    glEndTransformFeedback();
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    for (size_t iO = 0; iO < outputs.size(); iO++) {
+      glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, static_cast<GLuint>(iO), 0);
+    }
+    for (size_t iT = 0; iT < textures.size(); iT++) {
+      glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(iT));
+      glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+  };
+
+  // Face pass, then gather the weighted face normals around each vertex
+  if (nFaces > 0) {
+    TextureBufferHandle positionsTex = makeBufferTexture(GL_R32F, positions->getHandle());
+    TextureBufferHandle faceVertsTex = makeBufferTexture(GL_R32UI, faceVerts->getHandle());
+    runPass(meshFaceNormalProgram, faceStart, nFaces, {{"t_positions", positionsTex}, {"t_faceVerts", faceVertsTex}},
+            {faceNormalTarget, meshNormalScratch[1]});
+    glDeleteTextures(1, &positionsTex);
+    glDeleteTextures(1, &faceVertsTex);
+  }
+  if (vertexNormals && nVerts > 0) {
+    TextureBufferHandle weightedTex = makeBufferTexture(GL_R32F, meshNormalScratch[1]);
+    TextureBufferHandle vertexFacesTex = makeBufferTexture(GL_R32UI, vertexFaces->getHandle());
+    runPass(meshVertexNormalProgram, vertexFaceStart, nVerts,
+            {{"t_weightedNormals", weightedTex}, {"t_vertexFaces", vertexFacesTex}}, {vertexNormals->getHandle()});
+    glDeleteTextures(1, &weightedTex);
+    glDeleteTextures(1, &vertexFacesTex);
+  }
+  checkGLError();
+
+  return true;
+}
+
+ProgramHandle GLEngine::getValueReductionProgram(int sourceDim) {
+
+  if (valueReductionPrograms.find(sourceDim) != valueReductionPrograms.end()) {
+    return valueReductionPrograms[sourceDim];
+  }
+
+  // One point per value. Non-finite values are moved outside the clip volume. For a histogram, the point lands on the
+  // center of its bin's pixel, for the min/max the target is a single pixel.
+  std::stringstream vertSrc;
+  vertSrc << "#version 330 core\n";
+  switch (sourceDim) {
+  case 0:
+    vertSrc << "in float a_value;\n"
+            << "float fetchValue() { return a_value; }\n";
+    break;
+  case 1:
+    vertSrc << "uniform sampler1D t_values;\n"
+            << "float fetchValue() { return texelFetch(t_values, gl_VertexID, 0).r; }\n";
+    break;
+  case 2:
+    vertSrc << "uniform sampler2D t_values;\n"
+            << "uniform int u_sizeX;\n"
+            << "float fetchValue() {\n"
+            << "  return texelFetch(t_values, ivec2(gl_VertexID % u_sizeX, gl_VertexID / u_sizeX), 0).r;\n"
+            << "}\n";
+    break;
+  case 3:
+    vertSrc << "uniform sampler3D t_values;\n"
+            << "uniform int u_sizeX;\n"
+            << "uniform int u_sizeY;\n"
+            << "float fetchValue() {\n"
+            << "  ivec3 ind = ivec3(gl_VertexID % u_sizeX, (gl_VertexID / u_sizeX) % u_sizeY,\n"
+            << "                    gl_VertexID / (u_sizeX * u_sizeY));\n"
+            << "  return texelFetch(t_values, ind, 0).r;\n"
+            << "}\n";
+    break;
+  }
+  vertSrc << R"(
+uniform int u_histogram;
+uniform float u_binLow;
+uniform float u_binScale;
+uniform int u_nBins;
+flat out float v_value;
+void main() {
+  float v = fetchValue();
+  v_value = v;
+  gl_PointSize = 1.;
+  if (isnan(v) || isinf(v)) {
+    gl_Position = vec4(2., 2., 0., 1.);
+    return;
+  }
+  float x = 0.;
+  if (u_histogram != 0) {
+    float iBin = clamp(floor(u_binScale * (v - u_binLow)), 0., float(u_nBins - 1));
+    x = (iBin + 0.5) / float(u_nBins) * 2. - 1.;
+  }
+  gl_Position = vec4(x, 0., 0., 1.);
+}
+)";
+
+  const std::string fragSrc = R"(
+#version 330 core
+uniform int u_histogram;
+flat in float v_value;
+layout(location = 0) out vec4 outValue;
+void main() {
+  if (u_histogram != 0) {
+    outValue = vec4(1., 0., 0., 0.);
+  } else {
+    outValue = vec4(v_value, -v_value, 0., 0.);
+  }
+}
+)";
+
+  std::string vertSrcStr = vertSrc.str();
+  ShaderHandle vertHandle = glCreateShader(GL_VERTEX_SHADER);
+  ShaderHandle fragHandle = glCreateShader(GL_FRAGMENT_SHADER);
+  const char* vertPtr = vertSrcStr.c_str();
+  const char* fragPtr = fragSrc.c_str();
+  glShaderSource(vertHandle, 1, &vertPtr, nullptr);
+  glShaderSource(fragHandle, 1, &fragPtr, nullptr);
+  for (ShaderHandle h : {vertHandle, fragHandle}) {
+    glCompileShader(h);
+    GLint status;
+    glGetShaderiv(h, GL_COMPILE_STATUS, &status);
+    if (!status) {
+      printShaderInfoLog(h);
+      exception("[polyscope] GL value reduction shader compile failed");
+    }
+  }
+
+  ProgramHandle progHandle = glCreateProgram();
+  glAttachShader(progHandle, vertHandle);
+  glAttachShader(progHandle, fragHandle);
+  glBindAttribLocation(progHandle, 0, "a_value");
+  glLinkProgram(progHandle);
+  GLint status;
+  glGetProgramiv(progHandle, GL_LINK_STATUS, &status);
+  if (!status) {
+    printProgramInfoLog(progHandle);
+    exception("[polyscope] GL value reduction program link failed");
+  }
+  glDeleteShader(vertHandle);
+  glDeleteShader(fragHandle);
+  checkGLError();
+
+  valueReductionPrograms[sourceDim] = progHandle;
+  return progHandle;
+}
+
+bool GLEngine::runValueReduction(AttributeBuffer* attributeValuesIn, TextureBuffer* textureValuesIn, bool histogram,
+                                 std::pair<double, double> range, size_t targetWidth, std::vector<float>& result) {
+
+  GLAttributeBuffer* attributeValues = dynamic_cast<GLAttributeBuffer*>(attributeValuesIn);
+  GLTextureBuffer* textureValues = dynamic_cast<GLTextureBuffer*>(textureValuesIn);
+
+  // Check that we can handle this case
+  int sourceDim;
+  size_t nValues;
+  if (attributeValues) {
+    if (!attributeValues->isSet() || attributeValues->getType() != RenderDataType::Float ||
+        attributeValues->getArrayCount() != 1 || attributeValues->getStorageFormat() != AttributeStorageFormat::Float32) {
+      return false;
+    }
+    sourceDim = 0;
+    nValues = attributeValues->getDataSize();
+  } else if (textureValues) {
+    if (dimension(textureValues->getFormat()) != 1) return false;
+    sourceDim = textureValues->getDimension();
+    nValues = textureValues->getTotalSize();
+  } else {
+    return false;
+  }
+  GLint maxTextureSize;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+  if (targetWidth == 0 || targetWidth > static_cast<size_t>(maxTextureSize)) return false;
+  if (nValues > static_cast<size_t>(std::numeric_limits<GLsizei>::max())) return false;
+
+  ProgramHandle progHandle = getValueReductionProgram(sourceDim);
+
+  // Save the state which gets changed below
+  GLint prevDrawFramebuffer, prevReadFramebuffer, prevViewport[4];
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevDrawFramebuffer);
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prevReadFramebuffer);
+  glGetIntegerv(GL_VIEWPORT, prevViewport);
+  GLboolean prevBlend = glIsEnabled(GL_BLEND);
+  GLboolean prevDepthTest = glIsEnabled(GL_DEPTH_TEST);
+  GLboolean prevScissorTest = glIsEnabled(GL_SCISSOR_TEST);
+  GLint prevBlendEqRGB, prevBlendEqAlpha, prevBlendSrcRGB, prevBlendDstRGB, prevBlendSrcAlpha, prevBlendDstAlpha;
+  glGetIntegerv(GL_BLEND_EQUATION_RGB, &prevBlendEqRGB);
+  glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &prevBlendEqAlpha);
+  glGetIntegerv(GL_BLEND_SRC_RGB, &prevBlendSrcRGB);
+  glGetIntegerv(GL_BLEND_DST_RGB, &prevBlendDstRGB);
+  glGetIntegerv(GL_BLEND_SRC_ALPHA, &prevBlendSrcAlpha);
+  glGetIntegerv(GL_BLEND_DST_ALPHA, &prevBlendDstAlpha);
+  GLboolean prevColorMask[4];
+  glGetBooleanv(GL_COLOR_WRITEMASK, prevColorMask);
+  GLfloat prevClearColor[4];
+  glGetFloatv(GL_COLOR_CLEAR_VALUE, prevClearColor);
+
+  // A temporary target, blending in float is fine for RGBA32F on desktop GL
+  TextureBufferHandle targetTex;
+  glGenTextures(1, &targetTex);
+  glBindTexture(GL_TEXTURE_2D, targetTex);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, static_cast<GLsizei>(targetWidth), 1, 0, GL_RGBA, GL_FLOAT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  FrameBufferHandle targetFBO;
+  glGenFramebuffers(1, &targetFBO);
+  glBindFramebuffer(GL_FRAMEBUFFER, targetFBO);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targetTex, 0);
+  bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+  if (complete) {
+    glViewport(0, 0, static_cast<GLsizei>(targetWidth), 1);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_SCISSOR_TEST);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glEnable(GL_BLEND);
+    if (histogram) {
+      glClearColor(0., 0., 0., 0.);
+      glBlendEquation(GL_FUNC_ADD);
+    } else {
+      float lowest = std::numeric_limits<float>::lowest();
+      glClearColor(lowest, lowest, 0., 0.);
+      glBlendEquation(GL_MAX);
+    }
+    glBlendFunc(GL_ONE, GL_ONE);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    useProgram(progHandle);
+    glUniform1i(glGetUniformLocation(progHandle, "u_histogram"), histogram ? 1 : 0);
+    double rangeWidth = range.second - range.first;
+    glUniform1f(glGetUniformLocation(progHandle, "u_binLow"), static_cast<float>(range.first));
+    glUniform1f(glGetUniformLocation(progHandle, "u_binScale"),
+                static_cast<float>(rangeWidth > 0. ? targetWidth / rangeWidth : 0.));
+    glUniform1i(glGetUniformLocation(progHandle, "u_nBins"), static_cast<GLint>(targetWidth));
+
+    AttributeHandle vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    if (attributeValues) {
+      attributeValues->bind();
+      glEnableVertexAttribArray(0);
+      glVertexAttribPointer(0, 1, GL_FLOAT, GL_FALSE, sizeof(float),
+                            reinterpret_cast<void*>(attributeValues->getByteOffset()));
+    } else {
+      setActiveTextureUnit(0);
+      textureValues->bind();
+      glUniform1i(glGetUniformLocation(progHandle, "t_values"), 0);
+      glUniform1i(glGetUniformLocation(progHandle, "u_sizeX"), static_cast<GLint>(textureValues->getSizeX()));
+      glUniform1i(glGetUniformLocation(progHandle, "u_sizeY"), static_cast<GLint>(textureValues->getSizeY()));
+    }
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(nValues));
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+
+    std::vector<float> pixels(4 * targetWidth);
+    glReadPixels(0, 0, static_cast<GLsizei>(targetWidth), 1, GL_RGBA, GL_FLOAT, &pixels.front());
+    result = std::move(pixels);
+  }
+
+  // Restore the state
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, prevDrawFramebuffer);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, prevReadFramebuffer);
+  glDeleteFramebuffers(1, &targetFBO);
+  glDeleteTextures(1, &targetTex);
+  glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
+  if (prevBlend) glEnable(GL_BLEND);
+  else glDisable(GL_BLEND);
+  if (prevDepthTest) glEnable(GL_DEPTH_TEST);
+  else glDisable(GL_DEPTH_TEST);
+  if (prevScissorTest) glEnable(GL_SCISSOR_TEST);
+  else glDisable(GL_SCISSOR_TEST);
+  glBlendEquationSeparate(prevBlendEqRGB, prevBlendEqAlpha);
+  glBlendFuncSeparate(prevBlendSrcRGB, prevBlendDstRGB, prevBlendSrcAlpha, prevBlendDstAlpha);
+  glColorMask(prevColorMask[0], prevColorMask[1], prevColorMask[2], prevColorMask[3]);
+  glClearColor(prevClearColor[0], prevClearColor[1], prevClearColor[2], prevClearColor[3]);
+  invalidateStateCache(); // the target texture was bound behind the cache's back
+  checkGLError();
+
+  return complete;
+}
+
+bool GLEngine::computeFiniteRangeOnDevice(AttributeBuffer& values, std::pair<double, double>& range) {
+  std::vector<float> result;
+  if (!runValueReduction(&values, nullptr, false, {0., 0.}, 1, result)) return false;
+  range = {-result[1], result[0]};
+  if (range.first > range.second) { // no finite values, match finiteMinMax()
+    range = {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+  }
+  return true;
+}
+
+bool GLEngine::computeFiniteRangeOnDevice(TextureBuffer& values, std::pair<double, double>& range) {
+  std::vector<float> result;
+  if (!runValueReduction(nullptr, &values, false, {0., 0.}, 1, result)) return false;
+  range = {-result[1], result[0]};
+  if (range.first > range.second) { // no finite values, match finiteMinMax()
+    range = {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+  }
+  return true;
+}
+
+bool GLEngine::computeHistogramOnDevice(AttributeBuffer& values, std::pair<double, double> range, size_t nBins,
+                                        std::vector<double>& binCounts) {
+  std::vector<float> result;
+  if (!runValueReduction(&values, nullptr, true, range, nBins, result)) return false;
+  binCounts.resize(nBins);
+  for (size_t iBin = 0; iBin < nBins; iBin++) binCounts[iBin] = result[4 * iBin];
+  return true;
+}
+
+bool GLEngine::computeHistogramOnDevice(TextureBuffer& values, std::pair<double, double> range, size_t nBins,
+                                        std::vector<double>& binCounts) {
+  std::vector<float> result;
+  if (!runValueReduction(nullptr, &values, true, range, nBins, result)) return false;
+  binCounts.resize(nBins);
+  for (size_t iBin = 0; iBin < nBins; iBin++) binCounts[iBin] = result[4 * iBin];
+  return true;
+}
+
+uint32_t GLEngine::getMaxTextureSize3D() {
+  GLint maxSize = 0;
+  glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+  checkGLError();
+  return static_cast<uint32_t>(std::max(maxSize, 1));
+}
+
+bool GLEngine::beginSamplesPassedQuery() {
+  if (samplesPassedQuery == 0) {
+    glGenQueries(1, &samplesPassedQuery);
+  }
+  glBeginQuery(GL_SAMPLES_PASSED, samplesPassedQuery);
+  checkGLError();
+  return true;
+}
+
+size_t GLEngine::endSamplesPassedQuery() {
+  glEndQuery(GL_SAMPLES_PASSED);
+  GLuint nSamples = 0;
+  glGetQueryObjectuiv(samplesPassedQuery, GL_QUERY_RESULT, &nSamples);
+  checkGLError();
+  return static_cast<size_t>(nSamples);
+}
+
+uint64_t GLEngine::recordGPUTimestamp() {
+  GLuint query;
+  if (freeTimestampQueries.empty()) {
+    glGenQueries(1, &query);
+  } else {
+    query = freeTimestampQueries.back();
+    freeTimestampQueries.pop_back();
+  }
+  glQueryCounter(query, GL_TIMESTAMP);
+  checkGLError();
+
+  uint64_t ticket = nextTimestampTicket++;
+  pendingTimestampQueries[ticket] = query;
+  return ticket;
+}
+
+bool GLEngine::pollGPUTimestamp(uint64_t ticket, uint64_t& nanoseconds) {
+  auto it = pendingTimestampQueries.find(ticket);
+  if (it == pendingTimestampQueries.end()) return false;
+
+  GLint available = 0;
+  glGetQueryObjectiv(it->second, GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) return false;
+
+  GLuint64 result = 0;
+  glGetQueryObjectui64v(it->second, GL_QUERY_RESULT, &result);
+  checkGLError();
+  nanoseconds = static_cast<uint64_t>(result);
+
+  freeTimestampQueries.push_back(it->second);
+  pendingTimestampQueries.erase(it);
+  return true;
+}
+
+void GLEngine::discardGPUTimestamp(uint64_t ticket) {
+  auto it = pendingTimestampQueries.find(ticket);
+  if (it == pendingTimestampQueries.end()) return;
+  freeTimestampQueries.push_back(it->second);
+  pendingTimestampQueries.erase(it);
+}
+
 void GLEngine::registerShaderProgram(const std::string& name, const std::vector<ShaderStageSpecification>& spec,
                                      const DrawMode& dm) {
   registeredShaderPrograms.insert({name, {spec, dm}});
@@ -2445,6 +4835,50 @@ void GLEngine::registerShaderRule(const std::string& name, const ShaderReplaceme
   registeredShaderRules.insert({name, rule});
 }
 
+void GLEngine::loadOptionalGLFunctions(const std::function<void*(const char*)>& getProcAddress) {
+
+  getProgramBinaryFunc = reinterpret_cast<GetProgramBinaryFunc>(getProcAddress("glGetProgramBinary"));
+  programBinaryFunc = reinterpret_cast<ProgramBinaryFunc>(getProcAddress("glProgramBinary"));
+  programParameteriFunc = reinterpret_cast<ProgramParameteriFunc>(getProcAddress("glProgramParameteri"));
+
+  // Some loaders return non-null pointers for anything, so also check that the context advertises the feature
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  bool hasProgramBinaries = (major > 4 || (major == 4 && minor >= 1)) || hasGLExtension("GL_ARB_get_program_binary");
+  GLint nBinaryFormats = 0;
+  if (hasProgramBinaries) {
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nBinaryFormats);
+  }
+  programBinariesSupported = hasProgramBinaries && nBinaryFormats > 0 && getProgramBinaryFunc != nullptr &&
+                             programBinaryFunc != nullptr && programParameteriFunc != nullptr;
+
+  if (hasGLExtension("GL_KHR_parallel_shader_compile")) {
+    parallelShaderCompileSupported = true;
+    maxShaderCompilerThreadsFunc =
+        reinterpret_cast<MaxShaderCompilerThreadsFunc>(getProcAddress("glMaxShaderCompilerThreadsKHR"));
+  } else if (hasGLExtension("GL_ARB_parallel_shader_compile")) {
+    parallelShaderCompileSupported = true;
+    maxShaderCompilerThreadsFunc =
+        reinterpret_cast<MaxShaderCompilerThreadsFunc>(getProcAddress("glMaxShaderCompilerThreadsARB"));
+  }
+  if (maxShaderCompilerThreadsFunc != nullptr) {
+    maxShaderCompilerThreadsFunc(0xFFFFFFFF); // let the driver choose
+  }
+
+  auto glString = [](GLenum name) -> std::string {
+    const GLubyte* str = glGetString(name);
+    return str == nullptr ? "" : reinterpret_cast<const char*>(str);
+  };
+  glDriverIdentity = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+
+  if (!options::shaderCacheDirectory.empty() && !programBinariesSupported && options::verbosity > 0) {
+    info("shader cache directory is set, but this driver does not support program binaries, cache disabled");
+  }
+
+  checkError();
+}
+
 void GLEngine::populateDefaultShadersAndRules() {
   // clang-format off
 
@@ -2452,20 +4886,29 @@ void GLEngine::populateDefaultShadersAndRules() {
   registerShaderProgram("MESH", {FLEX_MESH_VERT_SHADER, FLEX_MESH_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("INDEXED_MESH", {FLEX_MESH_VERT_SHADER, FLEX_MESH_FRAG_SHADER}, DrawMode::IndexedTriangles);
   registerShaderProgram("SIMPLE_MESH", {SIMPLE_MESH_VERT_SHADER, SIMPLE_MESH_FRAG_SHADER}, DrawMode::IndexedTriangles);
+  registerShaderProgram("INSTANCED_MESH", {INSTANCED_MESH_VERT_SHADER, SIMPLE_MESH_FRAG_SHADER}, DrawMode::TrianglesInstanced);
   registerShaderProgram("SLICE_TETS", {SLICE_TETS_VERT_SHADER, SLICE_TETS_GEOM_SHADER, SLICE_TETS_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("RAYCAST_SPHERE", {FLEX_SPHERE_VERT_SHADER, FLEX_SPHERE_GEOM_SHADER, FLEX_SPHERE_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("POINT_QUAD", {FLEX_POINTQUAD_VERT_SHADER, FLEX_POINTQUAD_GEOM_SHADER, FLEX_POINTQUAD_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("POINT_SPLAT", {FLEX_SPLAT_VERT_SHADER, FLEX_SPHERE_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("GRIDCUBE", {FLEX_GRIDCUBE_VERT_SHADER, FLEX_GRIDCUBE_GEOM_SHADER, FLEX_GRIDCUBE_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("GRIDCUBE_PLANE", {FLEX_GRIDCUBE_PLANE_VERT_SHADER, FLEX_GRIDCUBE_PLANE_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("GRID_ISOSURFACE_RAYMARCH", {FLEX_GRID_ISOSURFACE_VERT_SHADER, FLEX_GRID_ISOSURFACE_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("GRID_VOLUME_RAYMARCH", {FLEX_GRID_ISOSURFACE_VERT_SHADER, FLEX_GRID_VOLUME_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("RAYCAST_VECTOR", {FLEX_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("RAYCAST_TANGENT_VECTOR", {FLEX_TANGENT_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("RAYCAST_VECTOR_INSTANCED", {FLEX_VECTOR_INSTANCED_VERT_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::TriangleStripInstanced);
+  registerShaderProgram("RAYCAST_TANGENT_VECTOR_INSTANCED", {FLEX_TANGENT_VECTOR_INSTANCED_VERT_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::TriangleStripInstanced);
   registerShaderProgram("RAYCAST_CYLINDER", {FLEX_CYLINDER_VERT_SHADER, FLEX_CYLINDER_GEOM_SHADER, FLEX_CYLINDER_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("RAYCAST_CYLINDER_STRIP", {FLEX_CYLINDER_STRIP_VERT_SHADER, FLEX_CYLINDER_STRIP_GEOM_SHADER, FLEX_CYLINDER_FRAG_SHADER}, DrawMode::IndexedLineStrip);
+  registerShaderProgram("RAYCAST_CYLINDER_INSTANCED", {FLEX_CYLINDER_INSTANCED_VERT_SHADER, FLEX_CYLINDER_INSTANCED_FRAG_SHADER}, DrawMode::TriangleStripInstanced);
   registerShaderProgram("HISTOGRAM", {HISTOGRAM_VERT_SHADER, HISTOGRAM_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("GROUND_PLANE_TILE", {GROUND_PLANE_VERT_SHADER, GROUND_PLANE_TILE_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("GROUND_PLANE_TILE_REFLECT", {GROUND_PLANE_VERT_SHADER, GROUND_PLANE_TILE_REFLECT_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("GROUND_PLANE_SHADOW", {GROUND_PLANE_VERT_SHADER, GROUND_PLANE_SHADOW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("MAP_LIGHT", {TEXTURE_DRAW_VERT_SHADER, MAP_LIGHT_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("RIBBON", {RIBBON_VERT_SHADER, RIBBON_GEOM_SHADER, RIBBON_FRAG_SHADER}, DrawMode::IndexedLineStripAdjacency);
+  registerShaderProgram("RIBBON_INSTANCED", {RIBBON_INSTANCED_VERT_SHADER, RIBBON_FRAG_SHADER}, DrawMode::TriangleStripInstanced);
   registerShaderProgram("SLICE_PLANE", {SLICE_PLANE_VERT_SHADER, SLICE_PLANE_FRAG_SHADER}, DrawMode::Triangles);
 
   registerShaderProgram("TEXTURE_DRAW_PLAIN", {TEXTURE_DRAW_VERT_SHADER, PLAIN_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
@@ -2474,11 +4917,15 @@ void GLEngine::populateDefaultShadersAndRules() {
   registerShaderProgram("TEXTURE_DRAW_SPHEREBG", {SPHEREBG_DRAW_VERT_SHADER, SPHEREBG_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("TEXTURE_DRAW_RENDERIMAGE_PLAIN", {TEXTURE_DRAW_VERT_SHADER, PLAIN_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("TEXTURE_DRAW_RAW_RENDERIMAGE_PLAIN", {TEXTURE_DRAW_VERT_SHADER, PLAIN_RAW_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("TEXTURE_DRAW_RENDERIMAGE_COMPOSITE", {TEXTURE_DRAW_VERT_SHADER, COMPOSITE_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("COMPOSITE_PEEL", {TEXTURE_DRAW_VERT_SHADER, COMPOSITE_PEEL}, DrawMode::Triangles);
+  registerShaderProgram("COMPOSITE_WEIGHTED", {TEXTURE_DRAW_VERT_SHADER, COMPOSITE_WEIGHTED}, DrawMode::Triangles);
+  registerShaderProgram("TAA_RESOLVE", {TEXTURE_DRAW_VERT_SHADER, TAA_RESOLVE}, DrawMode::Triangles);
   registerShaderProgram("DEPTH_COPY", {TEXTURE_DRAW_VERT_SHADER, DEPTH_COPY}, DrawMode::Triangles);
   registerShaderProgram("DEPTH_TO_MASK", {TEXTURE_DRAW_VERT_SHADER, DEPTH_TO_MASK}, DrawMode::Triangles);
   registerShaderProgram("SCALAR_TEXTURE_COLORMAP", {TEXTURE_DRAW_VERT_SHADER, SCALAR_TEXTURE_COLORMAP}, DrawMode::Triangles);
   registerShaderProgram("BLUR_RGB", {TEXTURE_DRAW_VERT_SHADER, BLUR_RGB}, DrawMode::Triangles);
+  registerShaderProgram("BLUR_RGBA", {TEXTURE_DRAW_VERT_SHADER, BLUR_RGBA}, DrawMode::Triangles);
   registerShaderProgram("TRANSFORMATION_GIZMO_ROT", {TRANSFORMATION_GIZMO_ROT_VERT, TRANSFORMATION_GIZMO_ROT_FRAG}, DrawMode::Triangles);
 
   // === Load rules
@@ -2490,21 +4937,33 @@ void GLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("DOWNSAMPLE_RESOLVE_2", DOWNSAMPLE_RESOLVE_2);
   registerShaderRule("DOWNSAMPLE_RESOLVE_3", DOWNSAMPLE_RESOLVE_3);
   registerShaderRule("DOWNSAMPLE_RESOLVE_4", DOWNSAMPLE_RESOLVE_4);
+  registerShaderRule("RESOLVE_FXAA", RESOLVE_FXAA);
 
   registerShaderRule("TRANSPARENCY_STRUCTURE", TRANSPARENCY_STRUCTURE);
   registerShaderRule("TRANSPARENCY_RESOLVE_SIMPLE", TRANSPARENCY_RESOLVE_SIMPLE);
   registerShaderRule("TRANSPARENCY_PEEL_STRUCTURE", TRANSPARENCY_PEEL_STRUCTURE);
+  registerShaderRule("TRANSPARENCY_WEIGHTED_STRUCTURE", TRANSPARENCY_WEIGHTED_STRUCTURE);
   registerShaderRule("TRANSPARENCY_PEEL_GROUND", TRANSPARENCY_PEEL_GROUND);
+  registerShaderRule("DEPTH_PREPASS_STRUCTURE", DEPTH_PREPASS_STRUCTURE);
+  registerShaderRule("GROUND_REFLECT_SCREEN_SPACE", GROUND_REFLECT_SCREEN_SPACE);
 
   registerShaderRule("GENERATE_VIEW_POS", GENERATE_VIEW_POS);
   registerShaderRule("COMPUTE_SHADE_NORMAL_FROM_POSITION", COMPUTE_SHADE_NORMAL_FROM_POSITION);
   registerShaderRule("PREMULTIPLY_LIT_COLOR", PREMULTIPLY_LIT_COLOR);
+  registerShaderRule("KEYFRAME_COMMON", KEYFRAME_COMMON);
+  registerShaderRule("KEYFRAME_INDEX", KEYFRAME_INDEX);
+  registerShaderRule("KEYFRAME_POSITION", KEYFRAME_POSITION);
+  registerShaderRule("KEYFRAME_VALUE", KEYFRAME_VALUE);
   registerShaderRule("CULL_POS_FROM_VIEW", CULL_POS_FROM_VIEW);
+  registerShaderRule("SLICE_PLANE_CULL", generateSlicePlaneRule());
+  registerShaderRule("SLICE_PLANE_VOLUMEGRID_CULL", generateVolumeGridSlicePlaneRule());
   registerShaderRule("PROJ_AND_INV_PROJ_MAT", PROJ_AND_INV_PROJ_MAT);
 
   // Lighting and shading things
   registerShaderRule("LIGHT_MATCAP", LIGHT_MATCAP);
+  registerShaderRule("LIGHT_MATCAP_ARRAY", LIGHT_MATCAP_ARRAY);
   registerShaderRule("LIGHT_PASSTHRU", LIGHT_PASSTHRU);
+  registerShaderRule("PICK_OUTPUT_INDEX", PICK_OUTPUT_INDEX);
   registerShaderRule("SHADE_BASECOLOR", SHADE_BASECOLOR);
   registerShaderRule("SHADE_COLOR", SHADE_COLOR);
   registerShaderRule("SHADECOLOR_FROM_UNIFORM", SHADECOLOR_FROM_UNIFORM);
@@ -2529,6 +4988,7 @@ void GLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("TEXTURE_PROPAGATE_VALUE", TEXTURE_PROPAGATE_VALUE);
   registerShaderRule("TEXTURE_PROPAGATE_COLOR", TEXTURE_PROPAGATE_COLOR);
   registerShaderRule("TEXTURE_BILLBOARD_FROM_UNIFORMS", TEXTURE_BILLBOARD_FROM_UNIFORMS);
+  registerShaderRule("TEXTURE_TILE_FROM_UNIFORMS", TEXTURE_TILE_FROM_UNIFORMS);
   registerShaderRule("SHADE_NORMAL_FROM_TEXTURE", SHADE_NORMAL_FROM_TEXTURE);
   registerShaderRule("SHADE_NORMAL_FROM_VIEWPOS_VAR", SHADE_NORMAL_FROM_VIEWPOS_VAR);
 
@@ -2546,14 +5006,25 @@ void GLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("MESH_PROPAGATE_TCOORD", MESH_PROPAGATE_TCOORD);
   registerShaderRule("MESH_PROPAGATE_COLOR", MESH_PROPAGATE_COLOR);
   registerShaderRule("MESH_PROPAGATE_HALFEDGE_VALUE", MESH_PROPAGATE_HALFEDGE_VALUE);
+  registerShaderRule("MESH_FETCH_VALUE", MESH_FETCH_VALUE);
+  registerShaderRule("MESH_FETCH_HALFEDGE_VALUE", MESH_FETCH_HALFEDGE_VALUE);
+  registerShaderRule("MESH_FETCH_COLOR", MESH_FETCH_COLOR);
+  registerShaderRule("MESH_PROPAGATE_SELECTION", MESH_PROPAGATE_SELECTION);
   registerShaderRule("MESH_PROPAGATE_CULLPOS", MESH_PROPAGATE_CULLPOS);
+  registerShaderRule("MESH_KEYFRAME_POSITIONS", MESH_KEYFRAME_POSITIONS);
   registerShaderRule("MESH_PROPAGATE_TYPE_AND_BASECOLOR2_SHADE", MESH_PROPAGATE_TYPE_AND_BASECOLOR2_SHADE);
   registerShaderRule("MESH_PROPAGATE_PICK", MESH_PROPAGATE_PICK);
   registerShaderRule("MESH_PROPAGATE_PICK_SIMPLE", MESH_PROPAGATE_PICK_SIMPLE);
+  registerShaderRule("INSTANCED_MESH_PROPAGATE_COLOR", INSTANCED_MESH_PROPAGATE_COLOR);
+  registerShaderRule("INSTANCED_MESH_PROPAGATE_VALUE", INSTANCED_MESH_PROPAGATE_VALUE);
+  registerShaderRule("INSTANCED_MESH_PROPAGATE_PICK", INSTANCED_MESH_PROPAGATE_PICK);
 
   // volume gridcube things
   registerShaderRule("GRIDCUBE_PROPAGATE_NODE_VALUE", GRIDCUBE_PROPAGATE_NODE_VALUE);
   registerShaderRule("GRIDCUBE_PROPAGATE_CELL_VALUE", GRIDCUBE_PROPAGATE_CELL_VALUE);
+  registerShaderRule("GRIDCUBE_PROPAGATE_SPARSE_NODE_VALUE", GRIDCUBE_PROPAGATE_SPARSE_NODE_VALUE);
+  registerShaderRule("GRIDCUBE_PROPAGATE_SPARSE_CELL_VALUE", GRIDCUBE_PROPAGATE_SPARSE_CELL_VALUE);
+  registerShaderRule("GRIDCUBE_SPARSE_OCCUPANCY", GRIDCUBE_SPARSE_OCCUPANCY);
   registerShaderRule("GRIDCUBE_WIREFRAME", GRIDCUBE_WIREFRAME);
   registerShaderRule("GRIDCUBE_CONSTANT_PICK", GRIDCUBE_CONSTANT_PICK);
   registerShaderRule("GRIDCUBE_CULLPOS_FROM_CENTER", GRIDCUBE_CULLPOS_FROM_CENTER);
@@ -2563,9 +5034,16 @@ void GLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("SPHERE_PROPAGATE_VALUEALPHA", SPHERE_PROPAGATE_VALUEALPHA);
   registerShaderRule("SPHERE_PROPAGATE_VALUE2", SPHERE_PROPAGATE_VALUE2);
   registerShaderRule("SPHERE_PROPAGATE_COLOR", SPHERE_PROPAGATE_COLOR);
+  registerShaderRule("SPHERE_PROPAGATE_SELECTION", SPHERE_PROPAGATE_SELECTION);
   registerShaderRule("SPHERE_CULLPOS_FROM_CENTER", SPHERE_CULLPOS_FROM_CENTER);
   registerShaderRule("SPHERE_CULLPOS_FROM_CENTER_QUAD", SPHERE_CULLPOS_FROM_CENTER_QUAD);
   registerShaderRule("SPHERE_VARIABLE_SIZE", SPHERE_VARIABLE_SIZE);
+  registerShaderRule("SPLAT_PROPAGATE_VALUE", SPLAT_PROPAGATE_VALUE);
+  registerShaderRule("SPLAT_PROPAGATE_VALUEALPHA", SPLAT_PROPAGATE_VALUEALPHA);
+  registerShaderRule("SPLAT_PROPAGATE_VALUE2", SPLAT_PROPAGATE_VALUE2);
+  registerShaderRule("SPLAT_PROPAGATE_COLOR", SPLAT_PROPAGATE_COLOR);
+  registerShaderRule("SPLAT_PROPAGATE_SELECTION", SPLAT_PROPAGATE_SELECTION);
+  registerShaderRule("SPLAT_VARIABLE_SIZE", SPLAT_VARIABLE_SIZE);
 
   // vector things
   registerShaderRule("VECTOR_PROPAGATE_COLOR", VECTOR_PROPAGATE_COLOR);
@@ -2580,6 +5058,14 @@ void GLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("CYLINDER_PROPAGATE_PICK", CYLINDER_PROPAGATE_PICK);
   registerShaderRule("CYLINDER_CULLPOS_FROM_MID", CYLINDER_CULLPOS_FROM_MID);
   registerShaderRule("CYLINDER_VARIABLE_SIZE", CYLINDER_VARIABLE_SIZE);
+  registerShaderRule("CYLINDER_KEYFRAME_POSITIONS", CYLINDER_KEYFRAME_POSITIONS);
+  registerShaderRule("CYLINDER_INSTANCED_PROPAGATE_VALUE", CYLINDER_INSTANCED_PROPAGATE_VALUE);
+  registerShaderRule("CYLINDER_INSTANCED_PROPAGATE_BLEND_VALUE", CYLINDER_INSTANCED_PROPAGATE_BLEND_VALUE);
+  registerShaderRule("CYLINDER_INSTANCED_PROPAGATE_COLOR", CYLINDER_INSTANCED_PROPAGATE_COLOR);
+  registerShaderRule("CYLINDER_INSTANCED_PROPAGATE_BLEND_COLOR", CYLINDER_INSTANCED_PROPAGATE_BLEND_COLOR);
+  registerShaderRule("CYLINDER_INSTANCED_PROPAGATE_PICK", CYLINDER_INSTANCED_PROPAGATE_PICK);
+  registerShaderRule("CYLINDER_INSTANCED_VARIABLE_SIZE", CYLINDER_INSTANCED_VARIABLE_SIZE);
+  registerShaderRule("CYLINDER_INSTANCED_KEYFRAME_POSITIONS", CYLINDER_INSTANCED_KEYFRAME_POSITIONS);
 
   // marching tets things
   registerShaderRule("SLICE_TETS_BASECOLOR_SHADE", SLICE_TETS_BASECOLOR_SHADE);
@@ -2591,10 +5077,18 @@ void GLEngine::populateDefaultShadersAndRules() {
   // clang-format on
 };
 
-void GLEngine::createSlicePlaneFliterRule(std::string uniquePostfix) {
-  registeredShaderRules.insert({"SLICE_PLANE_CULL_" + uniquePostfix, generateSlicePlaneRule(uniquePostfix)});
-  registeredShaderRules.insert(
-      {"SLICE_PLANE_VOLUMEGRID_CULL_" + uniquePostfix, generateVolumeGridSlicePlaneRule(uniquePostfix)});
+void GLEngine::uploadFrameUniforms() {
+  if (frameUniformBuffer == 0) {
+    glGenBuffers(1, &frameUniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformData), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, frameUniformBlockBinding, frameUniformBuffer);
+  }
+
+  glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniformData), &frameUniformData);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  checkGLError();
 }
 
 
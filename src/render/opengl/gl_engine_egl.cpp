@@ -12,6 +12,10 @@
 #include "stb_image.h"
 
 #include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
 #include <set>
 
 namespace polyscope {
@@ -112,8 +116,137 @@ void checkEGLError(bool fatal = true) {
     exception("EGL error occurred. Text: " + errText);
   }
 }
+
+// == Device enumeration (EGL_EXT_device_enumeration and friends)
+// The entry points are looked up at runtime and the enums defined here, so older EGL headers suffice.
+
+typedef void* EGLDeviceHandle;
+typedef EGLBoolean (*QueryDevicesFunc)(EGLint, EGLDeviceHandle*, EGLint*);
+typedef const char* (*QueryDeviceStringFunc)(EGLDeviceHandle, EGLint);
+typedef EGLBoolean (*QueryDeviceBinaryFunc)(EGLDeviceHandle, EGLint, EGLint, void*, EGLint*);
+typedef EGLDisplay (*GetPlatformDisplayFunc)(EGLenum, void*, const EGLint*);
+
+const EGLenum eglPlatformDevice = 0x313F; // EGL_PLATFORM_DEVICE_EXT
+const EGLint eglDRMDeviceFile = 0x3233;   // EGL_DRM_DEVICE_FILE_EXT
+const EGLint eglDeviceUUID = 0x335C;      // EGL_DEVICE_UUID_EXT
+const EGLint eglRendererName = 0x335F;    // EGL_RENDERER_EXT
+
+struct EGLDeviceInfo {
+  EGLDeviceHandle handle;
+  std::string name;
+  std::string uuid;     // formatted as 8-4-4-4-12 lowercase hex digits
+  std::string pciBusId; // formatted as dddd:bb:dd.f
+};
+
+std::string toLower(std::string s) {
+  std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+  return s;
+}
+
+// Bus IDs are written with or without the domain, and with varying widths of it (e.g. "3b:00.0", "00000000:3B:00.0")
+std::string normalizePCIBusId(std::string busId) {
+  busId = toLower(busId);
+  size_t firstColon = busId.find(':');
+  if (firstColon == std::string::npos) return busId;
+  if (busId.find(':', firstColon + 1) == std::string::npos) return "0000:" + busId;
+  unsigned long domain = std::strtoul(busId.substr(0, firstColon).c_str(), nullptr, 16);
+  char domainStr[16];
+  std::snprintf(domainStr, sizeof(domainStr), "%04lx", domain);
+  return domainStr + busId.substr(firstColon);
+}
+
+// The DRM node of a device (e.g. /dev/dri/card1) resolves to its PCI device through sysfs
+std::string pciBusIdOfDRMNode(const std::string& nodePath) {
+  std::string nodeName = nodePath.substr(nodePath.find_last_of('/') + 1);
+  std::string sysPath = "/sys/class/drm/" + nodeName + "/device";
+  char resolved[PATH_MAX];
+  if (realpath(sysPath.c_str(), resolved) == nullptr) return "";
+  std::string devicePath(resolved);
+  return normalizePCIBusId(devicePath.substr(devicePath.find_last_of('/') + 1));
+}
+
+std::vector<EGLDeviceInfo> enumerateEGLDevices() {
+  QueryDevicesFunc queryDevices = reinterpret_cast<QueryDevicesFunc>(eglGetProcAddress("eglQueryDevicesEXT"));
+  QueryDeviceStringFunc queryString =
+      reinterpret_cast<QueryDeviceStringFunc>(eglGetProcAddress("eglQueryDeviceStringEXT"));
+  QueryDeviceBinaryFunc queryBinary =
+      reinterpret_cast<QueryDeviceBinaryFunc>(eglGetProcAddress("eglQueryDeviceBinaryEXT"));
+  if (queryDevices == nullptr) return {};
+
+  EGLint nDevices = 0;
+  if (!queryDevices(0, nullptr, &nDevices) || nDevices <= 0) return {};
+  std::vector<EGLDeviceHandle> handles(nDevices);
+  if (!queryDevices(nDevices, handles.data(), &nDevices)) return {};
+  handles.resize(nDevices);
+
+  std::vector<EGLDeviceInfo> devices;
+  for (EGLDeviceHandle h : handles) {
+    EGLDeviceInfo info{h, "", "", ""};
+
+    // each of these is an optional extension, the queries fail harmlessly without it
+    if (queryString) {
+      const char* name = queryString(h, eglRendererName);
+      if (name) info.name = name;
+      const char* drmNode = queryString(h, eglDRMDeviceFile);
+      if (drmNode) info.pciBusId = pciBusIdOfDRMNode(drmNode);
+    }
+    if (queryBinary) {
+      unsigned char uuid[16];
+      EGLint size = 0;
+      if (queryBinary(h, eglDeviceUUID, sizeof(uuid), uuid, &size) && size == sizeof(uuid)) {
+        char uuidStr[40];
+        std::snprintf(uuidStr, sizeof(uuidStr),
+                      "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x", uuid[0], uuid[1],
+                      uuid[2], uuid[3], uuid[4], uuid[5], uuid[6], uuid[7], uuid[8], uuid[9], uuid[10], uuid[11],
+                      uuid[12], uuid[13], uuid[14], uuid[15]);
+        info.uuid = uuidStr;
+      }
+    }
+    eglGetError(); // clear any error left by an unsupported query
+
+    devices.push_back(info);
+  }
+  return devices;
+}
+
+// Find the device named by options::eglDevice, see there
+EGLDeviceHandle selectEGLDevice(const std::vector<EGLDeviceInfo>& devices, const std::string& selector) {
+  bool isIndex = std::all_of(selector.begin(), selector.end(), [](unsigned char c) { return std::isdigit(c); });
+  if (isIndex) {
+    size_t index = std::stoul(selector);
+    if (index < devices.size()) return devices[index].handle;
+  } else {
+    std::string uuid = toLower(selector);
+    uuid.erase(std::remove(uuid.begin(), uuid.end(), '-'), uuid.end());
+    std::string busId = normalizePCIBusId(selector);
+    for (const EGLDeviceInfo& d : devices) {
+      std::string deviceUUID = d.uuid;
+      deviceUUID.erase(std::remove(deviceUUID.begin(), deviceUUID.end(), '-'), deviceUUID.end());
+      if (!deviceUUID.empty() && deviceUUID == uuid) return d.handle;
+      if (!d.pciBusId.empty() && d.pciBusId == busId) return d.handle;
+    }
+  }
+
+  exception("EGL device [" + selector + "] not found, " + std::to_string(devices.size()) +
+            " devices are available, see polyscope::listEGLDevices()");
+  return nullptr;
+}
+
 } // namespace
 
+std::vector<std::string> listDevices_egl() {
+  std::vector<std::string> result;
+  std::vector<EGLDeviceInfo> devices = enumerateEGLDevices();
+  for (size_t i = 0; i < devices.size(); i++) {
+    std::string line = std::to_string(i) + ":";
+    if (!devices[i].name.empty()) line += " " + devices[i].name;
+    if (!devices[i].uuid.empty()) line += " uuid=" + devices[i].uuid;
+    if (!devices[i].pciBusId.empty()) line += " pci=" + devices[i].pciBusId;
+    result.push_back(line);
+  }
+  return result;
+}
+
 void initializeRenderEngine_egl() {
 
   glEngineEGL = new GLEngineEGL(); // create the new global engine object
@@ -122,8 +255,14 @@ void initializeRenderEngine_egl() {
   glEngine = glEngineEGL;
 
   // initialize
-  glEngineEGL->initialize();
-  engine->allocateGlobalBuffersAndPrograms();
+  {
+    StartupPhase phase("context");
+    glEngineEGL->initialize();
+  }
+  {
+    StartupPhase phase("global buffers");
+    engine->allocateGlobalBuffersAndPrograms();
+  }
   glEngineEGL->applyWindowSize();
 }
 
@@ -136,10 +275,25 @@ void GLEngineEGL::initialize() {
 
   // === Initialize EGL
 
-  // Get the default display
-  eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-  if (eglDisplay == EGL_NO_DISPLAY) {
-    exception("ERROR: Failed to initialize EGL, could not get default display");
+  if (options::eglDevice.empty()) {
+    // Get the default display
+    eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (eglDisplay == EGL_NO_DISPLAY) {
+      exception("ERROR: Failed to initialize EGL, could not get default display");
+    }
+  } else {
+    // Get a display on the requested device
+    GetPlatformDisplayFunc getPlatformDisplay =
+        reinterpret_cast<GetPlatformDisplayFunc>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    std::vector<EGLDeviceInfo> devices = enumerateEGLDevices();
+    if (getPlatformDisplay == nullptr || devices.empty()) {
+      exception("ERROR: options::eglDevice is set, but this EGL implementation cannot enumerate devices");
+    }
+    EGLDeviceHandle device = selectEGLDevice(devices, options::eglDevice);
+    eglDisplay = getPlatformDisplay(eglPlatformDevice, device, nullptr);
+    if (eglDisplay == EGL_NO_DISPLAY) {
+      exception("ERROR: Failed to initialize EGL, could not get a display for device [" + options::eglDevice + "]");
+    }
   }
 
   // Configure
@@ -208,6 +362,7 @@ void GLEngineEGL::initialize() {
               << "Loaded openGL version: " << glGetString(GL_VERSION) << " -- "
               << "EGL version: " << majorVer << "." << minorVer << std::endl;
   }
+  loadOptionalGLFunctions([](const char* name) { return reinterpret_cast<void*>(eglGetProcAddress(name)); });
 
   { // Manually create the screen frame buffer
     // NOTE: important difference here, we manually create both the framebuffer and and its render buffer, since
@@ -225,6 +380,9 @@ void GLEngineEGL::initialize() {
     checkError();
   }
 
+  // point programs without a geometry shader (e.g. POINT_SPLAT) size their points in the vertex shader
+  glEnable(GL_PROGRAM_POINT_SIZE);
+
   populateDefaultShadersAndRules();
   checkError();
 }
@@ -239,7 +397,13 @@ void GLEngineEGL::initializeImGui() {
   configureImGui();
 }
 
-void GLEngineEGL::shutdownImGui() { ImGui::DestroyContext(); }
+void GLEngineEGL::shutdownImGui() {
+#ifdef POLYSCOPE_BACKEND_OPENGL3_GLFW_ENABLED
+  if (imguiRendererInitialized) ImGui_ImplOpenGL3_Shutdown();
+#endif
+  imguiRendererInitialized = false;
+  ImGui::DestroyContext();
+}
 
 void GLEngineEGL::ImGuiNewFrame() {
 
@@ -247,11 +411,29 @@ void GLEngineEGL::ImGuiNewFrame() {
   ImGuiIO& io = ImGui::GetIO();
   io.DisplaySize.x = view::bufferWidth;
   io.DisplaySize.y = view::bufferHeight;
+  if (fixedFrameDeltaTime > 0.f) io.DeltaTime = fixedFrameDeltaTime;
+
+  // the imgui openGL renderer is only built along with the GLFW backend
+#ifdef POLYSCOPE_BACKEND_OPENGL3_GLFW_ENABLED
+  imguiDrawnThisFrame = isRemoteSessionActive();
+  if (imguiDrawnThisFrame) {
+    if (!imguiRendererInitialized) {
+      ImGui_ImplOpenGL3_Init("#version 150");
+      imguiRendererInitialized = true;
+    }
+    ImGui_ImplOpenGL3_NewFrame();
+  }
+#endif
 
   ImGui::NewFrame();
 }
 
-void GLEngineEGL::ImGuiRender() { ImGui::Render(); }
+void GLEngineEGL::ImGuiRender() {
+  ImGui::Render();
+#ifdef POLYSCOPE_BACKEND_OPENGL3_GLFW_ENABLED
+  if (imguiDrawnThisFrame) ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+#endif
+}
 
 
 void GLEngineEGL::swapDisplayBuffers() {
@@ -316,13 +498,18 @@ void GLEngineEGL::pollEvents() {
   // does nothing
 }
 
+// There is no keyboard in headless mode, but keys may arrive through ImGui from a remote viewer
 bool GLEngineEGL::isKeyPressed(char c) {
-  // not defined in headless mode
+  if (c >= '0' && c <= '9') return ImGui::IsKeyPressed(static_cast<ImGuiKey>(ImGuiKey_0 + (c - '0')));
+  if (c >= 'a' && c <= 'z') return ImGui::IsKeyPressed(static_cast<ImGuiKey>(ImGuiKey_A + (c - 'a')));
+  if (c >= 'A' && c <= 'Z') return ImGui::IsKeyPressed(static_cast<ImGuiKey>(ImGuiKey_A + (c - 'A')));
   return false;
 }
 
 int GLEngineEGL::getKeyCode(char c) {
-  // not defined in headless mode
+  if (c >= '0' && c <= '9') return static_cast<int>(ImGuiKey_0) + (c - '0');
+  if (c >= 'a' && c <= 'z') return static_cast<int>(ImGuiKey_A) + (c - 'a');
+  if (c >= 'A' && c <= 'Z') return static_cast<int>(ImGuiKey_A) + (c - 'A');
   return -1;
 }
 
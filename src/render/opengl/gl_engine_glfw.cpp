@@ -28,8 +28,14 @@ void initializeRenderEngine_glfw() {
   glEngine = glEngineGLFW;
 
   // initialize
-  glEngineGLFW->initialize();
-  engine->allocateGlobalBuffersAndPrograms();
+  {
+    StartupPhase phase("window and context");
+    glEngineGLFW->initialize();
+  }
+  {
+    StartupPhase phase("global buffers");
+    engine->allocateGlobalBuffersAndPrograms();
+  }
 }
 
 GLEngineGLFW::GLEngineGLFW() {}
@@ -87,6 +93,7 @@ void GLEngineGLFW::initialize() {
     std::cout << options::printPrefix << "Backend: openGL3_glfw -- "
               << "Loaded openGL version: " << glGetString(GL_VERSION) << std::endl;
   }
+  loadOptionalGLFunctions([](const char* name) { return reinterpret_cast<void*>(glfwGetProcAddress(name)); });
 
 #ifdef __APPLE__
   // Hack to classify the process as interactive
@@ -102,6 +109,9 @@ void GLEngineGLFW::initialize() {
     // glClearDepth(1.);
   }
 
+  // point programs without a geometry shader (e.g. POINT_SPLAT) size their points in the vertex shader
+  glEnable(GL_PROGRAM_POINT_SIZE);
+
   populateDefaultShadersAndRules();
 }
 
@@ -129,12 +139,15 @@ void GLEngineGLFW::shutdownImGui() {
 void GLEngineGLFW::ImGuiNewFrame() {
   ImGui_ImplOpenGL3_NewFrame();
   ImGui_ImplGlfw_NewFrame();
+  if (fixedFrameDeltaTime > 0.f) ImGui::GetIO().DeltaTime = fixedFrameDeltaTime;
   ImGui::NewFrame();
+  invalidateStateCache(); // the backend may have created its font texture
 }
 
 void GLEngineGLFW::ImGuiRender() {
   ImGui::Render();
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  invalidateStateCache();
 }
 
 
@@ -207,6 +220,16 @@ std::tuple<int, int> GLEngineGLFW::getWindowPos() {
   return std::tuple<int, int>{x, y};
 }
 
+double GLEngineGLFW::getDisplayRefreshRate() {
+  // windowed windows have no monitor of their own, assume they are on the primary one
+  GLFWmonitor* monitor = glfwGetWindowMonitor(mainWindow);
+  if (monitor == nullptr) monitor = glfwGetPrimaryMonitor();
+  if (monitor == nullptr) return -1.;
+  const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+  if (mode == nullptr || mode->refreshRate <= 0) return -1.;
+  return mode->refreshRate;
+}
+
 bool GLEngineGLFW::windowRequestsClose() {
   bool shouldClose = glfwWindowShouldClose(mainWindow);
   if (shouldClose) {
@@ -218,6 +241,10 @@ bool GLEngineGLFW::windowRequestsClose() {
 
 void GLEngineGLFW::pollEvents() { glfwPollEvents(); }
 
+void GLEngineGLFW::waitEvents(double timeoutSeconds) { glfwWaitEventsTimeout(timeoutSeconds); }
+
+void GLEngineGLFW::wakeWaitEvents() { glfwPostEmptyEvent(); }
+
 bool GLEngineGLFW::isKeyPressed(char c) {
   if (c >= '0' && c <= '9') return ImGui::IsKeyPressed(static_cast<ImGuiKey>(ImGuiKey_0 + (c - '0')));
   if (c >= 'a' && c <= 'z') return ImGui::IsKeyPressed(static_cast<ImGuiKey>(ImGuiKey_A + (c - 'a')));
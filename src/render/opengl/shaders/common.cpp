@@ -105,6 +105,28 @@ vec3 lightSurfaceMat(vec3 normal, vec3 color, sampler2D t_mat_r, sampler2D t_mat
   return colorCombined;
 }
 
+// As above, for a material in the shared material texture array. matLayers holds the z texture coordinates of the
+// centers of the material's r, g, b and k layers.
+vec3 lightSurfaceMatArray(vec3 normal, vec3 color, sampler3D t_matArray, vec4 matLayers) {
+
+  // ensure color is in range [0,1]
+  color = clamp(color, vec3(0.), vec3(1.));
+
+  normal = normalize(normal);
+  normal.y = -normal.y;
+  normal *= 0.98; // pull slightly inward, to reduce sampling artifacts near edges
+  vec2 matUV = normal.xy/2.0 + vec2(.5, .5);
+  
+  vec3 mat_r = texture(t_matArray, vec3(matUV, matLayers.x)).rgb;
+  vec3 mat_g = texture(t_matArray, vec3(matUV, matLayers.y)).rgb;
+  vec3 mat_b = texture(t_matArray, vec3(matUV, matLayers.z)).rgb;
+  vec3 mat_k = texture(t_matArray, vec3(matUV, matLayers.w)).rgb;
+  vec3 colorCombined = color.r * mat_r + color.g * mat_g + color.b * mat_b + 
+                       (1. - color.r - color.g - color.b) * mat_k;
+
+  return colorCombined;
+}
+
 vec2 sphericalTexCoords(vec3 v) {
   const vec2 invMap = vec2(0.1591, 0.3183);
   vec2 uv = vec2(atan(v.z, v.x), asin(v.y));
@@ -444,6 +466,15 @@ bool rayConeIntersection(vec3 rayStart, vec3 rayDir, vec3 coneBase, vec3 coneTip
 
 )";
 
+// Per-frame camera state, shared by all programs. The layout must match Engine::FrameUniformData.
+const char* shaderFrameUniformBlockName = "PolyscopeFrameUniforms";
+const char* shaderFrameUniformBlockSource = R"(
+layout(std140) uniform PolyscopeFrameUniforms {
+  mat4 u_projMatrix;
+  mat4 u_invProjMatrix;
+};
+)";
+
 }
 } // namespace render
 } // namespace polyscope
@@ -133,6 +133,127 @@ R"(
 };
 
 
+// The strip variant consumes the segments of line strips over the nodes, so each node position is stored once. Per-edge
+// data is read from the tail vertex of each segment.
+const ShaderStageSpecification FLEX_CYLINDER_STRIP_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+    }, 
+
+    // attributes
+    {
+        {"a_position", RenderDataType::Vector3Float},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        in vec3 a_position;
+        uniform mat4 u_modelView;
+        
+        ${ VERT_DECLARATIONS }$
+        
+        void main()
+        {
+            gl_Position = u_modelView * vec4(a_position, 1.0);
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
+const ShaderStageSpecification FLEX_CYLINDER_STRIP_GEOM_SHADER = {
+    
+    ShaderStageType::Geometry,
+    
+    // uniforms
+    {
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_radius", RenderDataType::Float},
+    }, 
+
+    // attributes
+    {
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        layout(lines) in;
+        layout(triangle_strip, max_vertices=14) out;
+        uniform mat4 u_projMatrix;
+        uniform float u_radius;
+        out vec3 tipView;
+        out vec3 tailView;
+
+        ${ GEOM_DECLARATIONS }$
+
+        void buildTangentBasis(vec3 unitNormal, out vec3 basisX, out vec3 basisY);
+
+        void main() {
+            float tipRadius = u_radius;
+            float tailRadius = u_radius;
+            ${ CYLINDER_SET_RADIUS_GEOM }$
+
+            // Build an orthogonal basis
+            vec3 tailViewVal = gl_in[0].gl_Position.xyz / gl_in[0].gl_Position.w;
+            vec3 tipViewVal = gl_in[1].gl_Position.xyz / gl_in[1].gl_Position.w;
+            vec3 cylDir = normalize(tipViewVal - tailViewVal);
+            vec3 basisX; vec3 basisY; buildTangentBasis(cylDir, basisX, basisY);
+  
+            // Compute corners of cube
+            vec4 tailProj = u_projMatrix * gl_in[0].gl_Position;
+            vec4 tipProj = u_projMatrix * gl_in[1].gl_Position;
+            vec4 dxTip = u_projMatrix * vec4(basisX * tipRadius, 0.);
+            vec4 dyTip = u_projMatrix * vec4(basisY * tipRadius, 0.);
+            vec4 dxTail = u_projMatrix * vec4(basisX * tailRadius, 0.);
+            vec4 dyTail = u_projMatrix * vec4(basisY * tailRadius, 0.);
+
+            vec4 p1 = tailProj - dxTail - dyTail;
+            vec4 p2 = tailProj + dxTail - dyTail;
+            vec4 p3 = tailProj - dxTail + dyTail;
+            vec4 p4 = tailProj + dxTail + dyTail;
+            vec4 p5 = tipProj - dxTip - dyTip;
+            vec4 p6 = tipProj + dxTip - dyTip;
+            vec4 p7 = tipProj - dxTip + dyTip;
+            vec4 p8 = tipProj + dxTip + dyTip;
+            
+            // Other data to emit   
+    
+            // Emit the vertices as a triangle strip
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p7; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p8; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p5; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p6; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p2; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p8; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p4; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p7; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p3; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p5; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p1; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p2; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p3; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p4; EmitVertex();
+    
+            EndPrimitive();
+
+        }
+
+)"
+};
+
+
 const ShaderStageSpecification FLEX_CYLINDER_FRAG_SHADER = {
     
     ShaderStageType::Fragment,
@@ -195,6 +316,7 @@ R"(
            
            // Set depth (expensive!)
            gl_FragDepth = depth;
+           ${ DEPTH_PREPASS_EXIT }$
           
            // Shading
            ${ GENERATE_SHADE_VALUE }$
@@ -215,6 +337,205 @@ R"(
 )"
 };
 
+//  The INSTANCED cylinder shaders draw each edge as one instance of a shared 14-vertex triangle strip over its bounding
+//  box, placed by the vertex shader from per-instance endpoints, so no geometry shader is needed. Edges whose projected
+//  radius drops below u_lineLODPixelRadius instead become one-pixel-wide screen-space quads, which the fragment shader
+//  shades as thin lines rather than raycasting a cylinder too thin to hit any pixel centers. The rule variants named
+//  CYLINDER_INSTANCED_ pass values straight from the vertex stage.
+
+const ShaderStageSpecification FLEX_CYLINDER_INSTANCED_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_viewport", RenderDataType::Vector4Float},
+        {"u_radius", RenderDataType::Float},
+        {"u_lineLODPixelRadius", RenderDataType::Float},
+    }, 
+
+    // attributes
+    {
+        {"a_boxCorner", RenderDataType::Vector3Float},
+        {"a_position_tail", RenderDataType::Vector3Float, 1, true},
+        {"a_position_tip", RenderDataType::Vector3Float, 1, true},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        in vec3 a_boxCorner; // x,y in {-1,1} across the cylinder, z in {0,1} from tail to tip
+        in vec3 a_position_tail; // per-instance
+        in vec3 a_position_tip;  // per-instance
+        uniform mat4 u_modelView;
+        uniform mat4 u_projMatrix;
+        uniform vec4 u_viewport;
+        uniform float u_radius;
+        uniform float u_lineLODPixelRadius;
+        out vec3 tipView;
+        out vec3 tailView;
+        flat out float lineMode;
+        
+        ${ VERT_DECLARATIONS }$
+
+        void buildTangentBasis(vec3 unitNormal, out vec3 basisX, out vec3 basisY);
+
+        void main()
+        {
+            float tipRadius = u_radius;
+            float tailRadius = u_radius;
+            ${ CYLINDER_SET_RADIUS_VERT }$
+
+            vec4 tailViewH = u_modelView * vec4(a_position_tail, 1.0);
+            vec4 tipViewH = u_modelView * vec4(a_position_tip, 1.0);
+            vec3 tailViewVal = tailViewH.xyz / tailViewH.w;
+            vec3 tipViewVal = tipViewH.xyz / tipViewH.w;
+            tailView = tailViewVal;
+            tipView = tipViewVal;
+
+            vec4 tailProj = u_projMatrix * vec4(tailViewVal, 1.);
+            vec4 tipProj = u_projMatrix * vec4(tipViewVal, 1.);
+            float pixelScale = u_projMatrix[1][1] * 0.5 * u_viewport.w;
+            float tailPixelRadius = tailRadius * pixelScale / max(tailProj.w, 1e-6);
+            float tipPixelRadius = tipRadius * pixelScale / max(tipProj.w, 1e-6);
+            bool inFront = tailProj.w > 0. && tipProj.w > 0.;
+
+            if(inFront && max(tailPixelRadius, tipPixelRadius) < u_lineLODPixelRadius) {
+
+              // Thin line: the first four strip vertices span a one-pixel-wide quad from tail to tip, the rest
+              // repeat the last one so their triangles are degenerate
+              lineMode = 1.;
+              int iCorner = min(gl_VertexID, 3);
+              vec2 tailPix = tailProj.xy / tailProj.w * u_viewport.zw;
+              vec2 tipPix = tipProj.xy / tipProj.w * u_viewport.zw;
+              vec2 lineDir = tipPix - tailPix;
+              lineDir = dot(lineDir, lineDir) > 0. ? normalize(lineDir) : vec2(1., 0.);
+              vec2 perpNDC = vec2(-lineDir.y, lineDir.x) / u_viewport.zw; // half a pixel, in NDC units
+              vec4 endProj = (iCorner < 2) ? tailProj : tipProj;
+              float side = (iCorner == 0 || iCorner == 2) ? -1. : 1.;
+              gl_Position = endProj + vec4(side * perpNDC * endProj.w, 0., 0.);
+
+            } else {
+
+              // Place this corner of the bounding box around the cylinder, the fragment shader raycasts the actual
+              // shape
+              lineMode = 0.;
+              vec3 cylDir = normalize(tipViewVal - tailViewVal);
+              vec3 basisX; vec3 basisY; buildTangentBasis(cylDir, basisX, basisY);
+              float cornerRadius = mix(tailRadius, tipRadius, a_boxCorner.z);
+              vec3 cornerView = mix(tailViewVal, tipViewVal, a_boxCorner.z) + 
+                                cornerRadius * (a_boxCorner.x * basisX + a_boxCorner.y * basisY);
+              gl_Position = u_projMatrix * vec4(cornerView, 1.0);
+            }
+            
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
+const ShaderStageSpecification FLEX_CYLINDER_INSTANCED_FRAG_SHADER = {
+    
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    {
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_invProjMatrix", RenderDataType::Matrix44Float},
+        {"u_viewport", RenderDataType::Vector4Float},
+        {"u_radius", RenderDataType::Float},
+    }, 
+
+    { }, // attributes
+    
+    // textures 
+    {
+    },
+ 
+    // source
+R"(
+        ${ GLSL_VERSION }$
+        uniform mat4 u_projMatrix; 
+        uniform mat4 u_invProjMatrix;
+        uniform vec4 u_viewport;
+        uniform float u_radius;
+        in vec3 tailView;
+        in vec3 tipView;
+        flat in float lineMode;
+        layout(location = 0) out vec4 outputF;
+
+        float LARGE_FLOAT();
+        vec3 fragmentViewPosition(vec4 viewport, vec2 depthRange, mat4 invProjMat, vec4 fragCoord);
+        bool rayTaperedCylinderIntersection(vec3 rayStart, vec3 rayDir, vec3 cylTail, vec3 cylTip, float cylRadTail, float cylRadTip, out float tHit, out vec3 pHit, out vec3 nHit);
+        float fragDepthFromView(mat4 projMat, vec2 depthRange, vec3 viewPoint);
+        
+        ${ FRAG_DECLARATIONS }$
+
+        void main()
+        {
+           // Build a ray corresponding to this fragment
+           vec2 depthRange = vec2(gl_DepthRange.near, gl_DepthRange.far);
+           vec3 viewRay = fragmentViewPosition(u_viewport, depthRange, u_invProjMatrix, gl_FragCoord);
+
+           float tipRadius = u_radius;
+           float tailRadius = u_radius;
+           ${ CYLINDER_SET_RADIUS_FRAG }$
+
+           float tHit;
+           vec3 pHit;
+           vec3 nHit;
+           if(lineMode > 0.5) {
+             // Thin line: take the point of the axis nearest the ray, with a normal facing the camera
+             vec3 axis = tipView - tailView;
+             float a = dot(viewRay, viewRay);
+             float b = dot(viewRay, axis);
+             float c = dot(axis, axis);
+             float denom = a * c - b * b;
+             float s = denom > 0. ? (b * dot(viewRay, tailView) - a * dot(axis, tailView)) / denom : 0.;
+             pHit = tailView + clamp(s, 0., 1.) * axis;
+             vec3 toCam = -pHit;
+             if(c > 0.) toCam -= dot(toCam, axis) / c * axis;
+             nHit = dot(toCam, toCam) > 0. ? normalize(toCam) : vec3(0., 0., 1.);
+           } else {
+             // Raycast to the cylinder
+             rayTaperedCylinderIntersection(vec3(0., 0., 0), viewRay, tailView, tipView, tailRadius, tipRadius, tHit, pHit, nHit);
+             if(tHit >= LARGE_FLOAT()) {
+                discard;
+             }
+           }
+           float depth = fragDepthFromView(u_projMatrix, depthRange, pHit);
+
+           ${ GLOBAL_FRAGMENT_FILTER_PREP }$
+           ${ GLOBAL_FRAGMENT_FILTER }$
+           
+           // Set depth (expensive!)
+           gl_FragDepth = depth;
+           ${ DEPTH_PREPASS_EXIT }$
+          
+           // Shading
+           ${ GENERATE_SHADE_VALUE }$
+           ${ GENERATE_SHADE_COLOR }$
+
+           // Lighting
+           vec3 shadeNormal = nHit;
+           ${ GENERATE_LIT_COLOR }$
+
+           // Set alpha
+           float alphaOut = 1.0;
+           ${ GENERATE_ALPHA }$
+
+           // Write output
+           litColor *= alphaOut; // premultiplied alpha
+           outputF = vec4(litColor, alphaOut);
+        }
+)"
+};
+
+
 // == Rules
 
 const ShaderReplacementRule CYLINDER_PROPAGATE_VALUE (
@@ -477,6 +798,238 @@ const ShaderReplacementRule CYLINDER_VARIABLE_SIZE (
     /* textures */ {}
 );
 
+const ShaderReplacementRule CYLINDER_KEYFRAME_POSITIONS (
+    /* rule name */ "CYLINDER_KEYFRAME_POSITIONS",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_keyframeInd_tail;
+          in float a_keyframeInd_tip;
+          uniform sampler3D t_keyframePositions;
+          #define a_position_tail keyframeBlend(t_keyframePositions, a_keyframeInd_tail).xyz
+          #define a_position_tip keyframeBlend(t_keyframePositions, a_keyframeInd_tip).xyz
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_keyframeInd_tail", RenderDataType::Float},
+      {"a_keyframeInd_tip", RenderDataType::Float},
+    },
+    /* textures */ {
+      {"t_keyframePositions", 3},
+    }
+);
+
+// == Rules for the INSTANCED shaders, which have no geometry stage
+
+const ShaderReplacementRule CYLINDER_INSTANCED_PROPAGATE_VALUE (
+    /* rule name */ "CYLINDER_INSTANCED_PROPAGATE_VALUE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_value;
+          out float a_valueToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_valueToFrag = a_value;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_valueToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float shadeValue = a_valueToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_value", RenderDataType::Float, 1, true},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_INSTANCED_PROPAGATE_BLEND_VALUE (
+    /* rule name */ "CYLINDER_INSTANCED_PROPAGATE_BLEND_VALUE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_value_tail;
+          in float a_value_tip;
+          out float a_valueTailToFrag;
+          out float a_valueTipToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_valueTailToFrag = a_value_tail;
+          a_valueTipToFrag = a_value_tip;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_valueTailToFrag;
+          in float a_valueTipToFrag;
+          float length2(vec3 x);
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float tEdge = dot(pHit - tailView, tipView - tailView) / length2(tipView - tailView);
+          float shadeValue = mix(a_valueTailToFrag, a_valueTipToFrag, tEdge);
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_value_tail", RenderDataType::Float, 1, true},
+      {"a_value_tip", RenderDataType::Float, 1, true},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_INSTANCED_PROPAGATE_COLOR (
+    /* rule name */ "CYLINDER_INSTANCED_PROPAGATE_COLOR",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_color;
+          out vec3 a_colorToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToFrag = a_color;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_color", RenderDataType::Vector3Float, 1, true},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_INSTANCED_PROPAGATE_BLEND_COLOR (
+    /* rule name */ "CYLINDER_INSTANCED_PROPAGATE_BLEND_COLOR",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_color_tail;
+          in vec3 a_color_tip;
+          out vec3 a_colorTailToFrag;
+          out vec3 a_colorTipToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorTailToFrag = a_color_tail;
+          a_colorTipToFrag = a_color_tip;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec3 a_colorTailToFrag;
+          in vec3 a_colorTipToFrag;
+          float length2(vec3 x);
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float tEdge = dot(pHit - tailView, tipView - tailView) / length2(tipView - tailView);
+          vec3 shadeColor = mix(a_colorTailToFrag, a_colorTipToFrag, tEdge);
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_color_tail", RenderDataType::Vector3Float, 1, true},
+      {"a_color_tip", RenderDataType::Vector3Float, 1, true},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_INSTANCED_PROPAGATE_PICK (
+    /* rule name */ "CYLINDER_INSTANCED_PROPAGATE_PICK",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_color_tail;
+          in vec3 a_color_tip;
+          in vec3 a_color_edge;
+          flat out vec3 a_colorTailToFrag;
+          flat out vec3 a_colorTipToFrag;
+          flat out vec3 a_colorEdgeToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorTailToFrag = a_color_tail;
+          a_colorTipToFrag = a_color_tip;
+          a_colorEdgeToFrag = a_color_edge;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorTailToFrag;
+          flat in vec3 a_colorTipToFrag;
+          flat in vec3 a_colorEdgeToFrag;
+          float length2(vec3 x);
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float tEdge = dot(pHit - tailView, tipView - tailView) / length2(tipView - tailView);
+          float endWidth = 0.2;
+          vec3 shadeColor;
+          if(tEdge < endWidth) {
+            shadeColor = a_colorTailToFrag;
+          } else if (tEdge < (1.0f - endWidth)) {
+            shadeColor = a_colorEdgeToFrag;
+          } else {
+            shadeColor = a_colorTipToFrag;
+          }
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_color_tail", RenderDataType::Vector3Float, 1, true},
+      {"a_color_tip", RenderDataType::Vector3Float, 1, true},
+      {"a_color_edge", RenderDataType::Vector3Float, 1, true},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_INSTANCED_VARIABLE_SIZE (
+    /* rule name */ "CYLINDER_INSTANCED_VARIABLE_SIZE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_tipRadius;
+          in float a_tailRadius;
+          out float a_tipRadiusToFrag;
+          out float a_tailRadiusToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_tipRadiusToFrag = a_tipRadius;
+          a_tailRadiusToFrag = a_tailRadius;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_tipRadiusToFrag;
+          in float a_tailRadiusToFrag;
+        )"},
+      {"CYLINDER_SET_RADIUS_VERT", R"(
+          tipRadius *= a_tipRadius;
+          tailRadius *= a_tailRadius;
+        )"},
+      {"CYLINDER_SET_RADIUS_FRAG", R"(
+          tipRadius *= a_tipRadiusToFrag;
+          tailRadius *= a_tailRadiusToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_tipRadius", RenderDataType::Float, 1, true},
+      {"a_tailRadius", RenderDataType::Float, 1, true},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_INSTANCED_KEYFRAME_POSITIONS (
+    /* rule name */ "CYLINDER_INSTANCED_KEYFRAME_POSITIONS",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_keyframeInd_tail;
+          in float a_keyframeInd_tip;
+          uniform sampler3D t_keyframePositions;
+          #define a_position_tail keyframeBlend(t_keyframePositions, a_keyframeInd_tail).xyz
+          #define a_position_tip keyframeBlend(t_keyframePositions, a_keyframeInd_tip).xyz
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_keyframeInd_tail", RenderDataType::Float, 1, true},
+      {"a_keyframeInd_tip", RenderDataType::Float, 1, true},
+    },
+    /* textures */ {
+      {"t_keyframePositions", 3},
+    }
+);
+
 // clang-format on
 
 } // namespace backend_openGL3
@@ -362,6 +362,357 @@ R"(
 };
 
 
+const ShaderStageSpecification FLEX_GRID_ISOSURFACE_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_boundMin", RenderDataType::Vector3Float},
+        {"u_boundMax", RenderDataType::Vector3Float},
+    }, 
+
+    // attributes
+    {
+        {"a_referencePosition", RenderDataType::Vector3Float},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+        
+        uniform mat4 u_modelView;
+        uniform mat4 u_projMatrix;
+        uniform vec3 u_boundMin;
+        uniform vec3 u_boundMax;
+
+        in vec3 a_referencePosition;
+        
+        ${ VERT_DECLARATIONS }$
+        
+        void main()
+        {
+            vec3 boxPos = mix(u_boundMin, u_boundMax, a_referencePosition);
+            gl_Position = u_projMatrix * u_modelView * vec4(boxPos,1.);
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
+const ShaderStageSpecification FLEX_GRID_ISOSURFACE_FRAG_SHADER = {
+    
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    {
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_invProjMatrix", RenderDataType::Matrix44Float},
+        {"u_viewport", RenderDataType::Vector4Float},
+        {"u_viewToReference", RenderDataType::Matrix44Float},
+        {"u_gridNodeDim", RenderDataType::Vector3Float},
+        {"u_isoLevel", RenderDataType::Float},
+    }, 
+
+    { }, // attributes
+    
+    // textures 
+    {
+        {"t_value", 3},
+    },
+ 
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        uniform mat4 u_projMatrix; 
+        uniform mat4 u_invProjMatrix;
+        uniform vec4 u_viewport;
+        uniform mat4 u_viewToReference;
+        uniform vec3 u_gridNodeDim;
+        uniform float u_isoLevel;
+        uniform sampler3D t_value;
+
+        layout(location = 0) out vec4 outputF;
+
+        vec3 fragmentViewPosition(vec4 viewport, vec2 depthRange, mat4 invProjMat, vec4 fragCoord);
+        float fragDepthFromView(mat4 projMat, vec2 depthRange, vec3 viewPoint);
+
+        ${ FRAG_DECLARATIONS }$
+
+        // field value relative to the level, at a point in [0,1]^3 reference coordinates spanning the grid nodes
+        float isoFieldValue(vec3 pRef) {
+          vec3 texCoord = (0.5 + pRef * (u_gridNodeDim - 1.)) / u_gridNodeDim;
+          return textureLod(t_value, texCoord, 0.).r - u_isoLevel; // explicit lod, this runs in divergent loops
+        }
+
+        void main()
+        {
+           // The box is drawn without culling, each pixel marches once from its back face 
+           if(gl_FrontFacing) {
+             discard;
+           }
+
+           // Build a ray corresponding to this fragment, in view and reference coordinates with the same parameter
+           vec2 depthRange = vec2(gl_DepthRange.near, gl_DepthRange.far);
+           vec3 viewRay = fragmentViewPosition(u_viewport, depthRange, u_invProjMatrix, gl_FragCoord);
+           vec3 rayStartRef = (u_viewToReference * vec4(0., 0., 0., 1.)).xyz;
+           vec3 rayDirRef = (u_viewToReference * vec4(viewRay, 0.)).xyz;
+
+           // Clip the ray to the grid
+           vec3 invDir = 1. / rayDirRef;
+           vec3 tLow = (vec3(0.) - rayStartRef) * invDir;
+           vec3 tHigh = (vec3(1.) - rayStartRef) * invDir;
+           vec3 tMin3 = min(tLow, tHigh);
+           vec3 tMax3 = max(tLow, tHigh);
+           float tEnter = max(max(max(tMin3.x, tMin3.y), tMin3.z), 0.);
+           float tExit = min(min(tMax3.x, tMax3.y), tMax3.z);
+           if(tExit <= tEnter) {
+             discard;
+           }
+
+           // March in steps of about half a cell, looking for a sign change
+           float maxDim = max(max(u_gridNodeDim.x, u_gridNodeDim.y), u_gridNodeDim.z);
+           float tStep = 0.5 / (max(maxDim - 1., 1.) * length(rayDirRef));
+           int nSteps = min(int(ceil((tExit - tEnter) / tStep)), 4096);
+           float tPrev = tEnter;
+           float fPrev = isoFieldValue(rayStartRef + tPrev * rayDirRef);
+           float tHit = -1.;
+           for(int i = 1; i <= nSteps; i++) {
+             float t = min(tEnter + float(i) * tStep, tExit);
+             float f = isoFieldValue(rayStartRef + t * rayDirRef);
+             if((f < 0.) != (fPrev < 0.)) {
+               // refine the crossing by bisection
+               float tA = tPrev; float tB = t; float fA = fPrev;
+               for(int j = 0; j < 6; j++) {
+                 float tMid = 0.5 * (tA + tB);
+                 float fMid = isoFieldValue(rayStartRef + tMid * rayDirRef);
+                 if((fMid < 0.) == (fA < 0.)) {
+                   tA = tMid; fA = fMid;
+                 } else {
+                   tB = tMid;
+                 }
+               }
+               tHit = 0.5 * (tA + tB);
+               break;
+             }
+             tPrev = t;
+             fPrev = f;
+           }
+           if(tHit < 0.) {
+             discard;
+           }
+
+           vec3 pHitRef = rayStartRef + tHit * rayDirRef;
+           vec3 pHitView = tHit * viewRay;
+           float depth = fragDepthFromView(u_projMatrix, depthRange, pHitView);
+
+           ${ GLOBAL_FRAGMENT_FILTER_PREP }$
+           ${ GLOBAL_FRAGMENT_FILTER }$
+           
+           gl_FragDepth = depth;
+
+           // Normal from the field gradient, facing the viewer
+           vec3 h = 1. / u_gridNodeDim;
+           vec3 gradRef = vec3(
+              isoFieldValue(pHitRef + vec3(h.x, 0., 0.)) - isoFieldValue(pHitRef - vec3(h.x, 0., 0.)),
+              isoFieldValue(pHitRef + vec3(0., h.y, 0.)) - isoFieldValue(pHitRef - vec3(0., h.y, 0.)),
+              isoFieldValue(pHitRef + vec3(0., 0., h.z)) - isoFieldValue(pHitRef - vec3(0., 0., h.z))) / (2. * h);
+           vec3 normalView = transpose(mat3(u_viewToReference)) * gradRef;
+           if(dot(normalView, pHitView) > 0.) {
+             normalView = -normalView;
+           }
+          
+           // Shading
+           ${ GENERATE_SHADE_VALUE }$
+           ${ GENERATE_SHADE_COLOR }$
+
+           // Lighting
+           vec3 shadeNormal = normalize(normalView);
+           ${ PERTURB_SHADE_NORMAL }$
+           ${ GENERATE_LIT_COLOR }$
+
+           // Set alpha
+           float alphaOut = 1.0;
+           ${ GENERATE_ALPHA }$
+           
+           ${ PERTURB_LIT_COLOR }$
+
+           // Write output
+           litColor *= alphaOut; // premultiplied alpha
+           outputF = vec4(litColor, alphaOut);
+        }
+)"
+};
+
+const ShaderStageSpecification FLEX_GRID_VOLUME_FRAG_SHADER = {
+    
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    {
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_invProjMatrix", RenderDataType::Matrix44Float},
+        {"u_viewport", RenderDataType::Vector4Float},
+        {"u_viewToReference", RenderDataType::Matrix44Float},
+        {"u_refToTexScale", RenderDataType::Vector3Float},
+        {"u_refToTexOffset", RenderDataType::Vector3Float},
+        {"u_valueDim", RenderDataType::Vector3Float},
+        {"u_brickDim", RenderDataType::Vector3Float},
+        {"u_brickSize", RenderDataType::Float},
+        {"u_rangeLow", RenderDataType::Float},
+        {"u_rangeHigh", RenderDataType::Float},
+        {"u_volumeDensity", RenderDataType::Float},
+        {"u_colormapRow", RenderDataType::Int},
+    }, 
+
+    { }, // attributes
+    
+    // textures 
+    {
+        {"t_value", 3},
+        {"t_brickRange", 3},
+        {"t_colormap", 2},
+    },
+ 
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        uniform mat4 u_projMatrix; 
+        uniform mat4 u_invProjMatrix;
+        uniform vec4 u_viewport;
+        uniform mat4 u_viewToReference;
+        uniform vec3 u_refToTexScale;
+        uniform vec3 u_refToTexOffset;
+        uniform vec3 u_valueDim;
+        uniform vec3 u_brickDim;
+        uniform float u_brickSize;
+        uniform float u_rangeLow;
+        uniform float u_rangeHigh;
+        uniform float u_volumeDensity;
+        uniform sampler3D t_value;
+        uniform sampler3D t_brickRange;
+        uniform sampler2D t_colormap;
+        uniform int u_colormapRow;
+
+        layout(location = 0) out vec4 outputF;
+
+        vec3 fragmentViewPosition(vec4 viewport, vec2 depthRange, mat4 invProjMat, vec4 fragCoord);
+        float fragDepthFromView(mat4 projMat, vec2 depthRange, vec3 viewPoint);
+        float LARGE_FLOAT();
+
+        ${ FRAG_DECLARATIONS }$
+
+        void main()
+        {
+           // The box is drawn without culling, each pixel marches once from its back face 
+           if(gl_FrontFacing) {
+             discard;
+           }
+
+           // Build a ray corresponding to this fragment, in view and reference coordinates with the same parameter
+           vec2 depthRange = vec2(gl_DepthRange.near, gl_DepthRange.far);
+           vec3 viewRay = fragmentViewPosition(u_viewport, depthRange, u_invProjMatrix, gl_FragCoord);
+           vec3 rayStartRef = (u_viewToReference * vec4(0., 0., 0., 1.)).xyz;
+           vec3 rayDirRef = (u_viewToReference * vec4(viewRay, 0.)).xyz;
+
+           // Clip the ray to the grid
+           vec3 invDir = 1. / rayDirRef;
+           vec3 tLow = (vec3(0.) - rayStartRef) * invDir;
+           vec3 tHigh = (vec3(1.) - rayStartRef) * invDir;
+           vec3 tMin3 = min(tLow, tHigh);
+           vec3 tMax3 = max(tLow, tHigh);
+           float tEnter = max(max(max(tMin3.x, tMin3.y), tMin3.z), 0.);
+           float tExit = min(min(tMax3.x, tMax3.y), tMax3.z);
+           if(tExit <= tEnter) {
+             discard;
+           }
+
+           // The same ray in texel coordinates of the value texture, where texel i is centered at i
+           vec3 rayStartTex = (rayStartRef * u_refToTexScale + u_refToTexOffset) * u_valueDim - 0.5;
+           vec3 rayDirTex = rayDirRef * u_refToTexScale * u_valueDim;
+
+           // March in steps of half a texel. Opacity is integrated over the length in reference coordinates, so the
+           // density is the optical depth across the grid at the top of the range, independent of the resolution.
+           float tStep = 0.5 / length(rayDirTex);
+           float stepLengthRef = tStep * length(rayDirRef);
+           float rangeMin = min(u_rangeLow, u_rangeHigh);
+           float rangeMax = max(u_rangeLow, u_rangeHigh);
+           vec3 brickIndMax = u_brickDim - 1.;
+           float cmapRowV = (float(u_colormapRow) + 0.5) / float(textureSize(t_colormap, 0).y);
+
+           vec4 accum = vec4(0.); // premultiplied, front to back
+           float tFirst = -1.;
+           float t = tEnter;
+           for(int i = 0; i < 8192 && t < tExit; i++) {
+             vec3 pTex = rayStartTex + t * rayDirTex;
+
+             // Skip bricks which hold no values in the visible range, jumping to where the ray leaves the brick. The
+             // outermost bricks extend without bound, so the jump always moves forward.
+             vec3 brickInd = clamp(floor(floor(pTex) / u_brickSize), vec3(0.), brickIndMax);
+             vec2 brickRange = texelFetch(t_brickRange, ivec3(brickInd), 0).rg;
+             if(brickRange.y < rangeMin || brickRange.x > rangeMax) {
+               vec3 brickLow = mix(brickInd * u_brickSize, vec3(-LARGE_FLOAT()), equal(brickInd, vec3(0.)));
+               vec3 brickHigh = mix((brickInd + 1.) * u_brickSize, vec3(LARGE_FLOAT()), equal(brickInd, brickIndMax));
+               vec3 tBound = mix(brickLow - pTex, brickHigh - pTex, greaterThan(rayDirTex, vec3(0.))) / rayDirTex;
+               tBound = mix(tBound, vec3(LARGE_FLOAT()), equal(rayDirTex, vec3(0.)));
+               t += max(min(min(tBound.x, tBound.y), tBound.z), 0.) + 0.01 * tStep;
+               continue;
+             }
+
+             // Transfer function: color from the colormap, opacity ramping up over the range
+             // (explicit lod, this runs in divergent loops)
+             float value = textureLod(t_value, (pTex + 0.5) / u_valueDim, 0.).r;
+             float s = (value - u_rangeLow) / (u_rangeHigh - u_rangeLow);
+             if(s > 0. && s <= 1.) {
+
+               // Samples cut away by slice planes contribute nothing (uses the names from the gridcube neighbor filter)
+               vec3 neighCullPos = t * viewRay;
+               bool neighIsVisible = true;
+               ${ GRID_PLANE_NEIGHBOR_FILTER }$
+
+               if(neighIsVisible) {
+                 float alpha = 1. - exp(-u_volumeDensity * s * stepLengthRef);
+                 vec3 color = textureLod(t_colormap, vec2(s, cmapRowV), 0.).rgb;
+                 accum += (1. - accum.a) * alpha * vec4(color, 1.);
+                 if(tFirst < 0.) {
+                   tFirst = t;
+                 }
+
+                 // Early ray termination, nothing behind will show through
+                 if(accum.a > 0.99) {
+                   break;
+                 }
+               }
+             }
+
+             t += tStep;
+           }
+
+           if(accum.a < 1e-3) {
+             discard;
+           }
+
+           // Place the fragment at the first sample which contributed
+           gl_FragDepth = fragDepthFromView(u_projMatrix, depthRange, tFirst * viewRay);
+
+           // Set alpha
+           float alphaOut = accum.a;
+           ${ GENERATE_ALPHA }$
+           
+           // Write output
+           outputF = vec4(accum.rgb * (alphaOut / accum.a), alphaOut); // premultiplied alpha
+        }
+)"
+};
+
+
+
 const ShaderReplacementRule GRIDCUBE_PROPAGATE_NODE_VALUE (
     /* rule name */ "GRIDCUBE_PROPAGATE_NODE_VALUE",
     { /* replacement sources */
@@ -396,6 +747,116 @@ const ShaderReplacementRule GRIDCUBE_PROPAGATE_CELL_VALUE (
     }
 );
 
+const ShaderReplacementRule GRIDCUBE_PROPAGATE_SPARSE_NODE_VALUE (
+    /* rule name */ "GRIDCUBE_PROPAGATE_SPARSE_NODE_VALUE",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform sampler3D t_value;
+          uniform float u_valueScale;
+          uniform float u_valueOffset;
+          float sparseBlockSlot(vec3 cellInd3f);
+          float sparseBlockSize();
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          // each block's values fill a slot of (blockSize + 1)^3 texels in the pool texture, interpolate within it
+          float shadeValue;
+          {
+            float slotSize = sparseBlockSize() + 1.f;
+            vec3 poolDim = vec3(textureSize(t_value, 0)) / slotSize;
+            float slot = sparseBlockSlot(cellInd3f);
+            vec3 slotInd = vec3(mod(slot, poolDim.x), mod(floor(slot / poolDim.x), poolDim.y),
+                                floor(slot / (poolDim.x * poolDim.y)));
+            vec3 blockOrigin = floor(cellInd3f / sparseBlockSize()) * sparseBlockSize();
+            vec3 coordInBlock = clamp(coordUnit - blockOrigin, 0.f, sparseBlockSize());
+            shadeValue = texture(t_value, (slotInd * slotSize + coordInBlock + 0.5f) / (poolDim * slotSize)).r;
+            shadeValue = shadeValue * u_valueScale + u_valueOffset; // compact pools are normalized
+          }
+        )"},
+    },
+    /* uniforms */ {
+      {"u_valueScale", RenderDataType::Float},
+      {"u_valueOffset", RenderDataType::Float},
+    },
+    /* attributes */ { },
+    /* textures */ {
+      {"t_value", 3},
+    }
+);
+
+const ShaderReplacementRule GRIDCUBE_PROPAGATE_SPARSE_CELL_VALUE (
+    /* rule name */ "GRIDCUBE_PROPAGATE_SPARSE_CELL_VALUE",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform sampler3D t_value;
+          uniform float u_valueScale;
+          uniform float u_valueOffset;
+          float sparseBlockSlot(vec3 cellInd3f);
+          float sparseBlockSize();
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          // each block's values fill a slot of blockSize^3 texels in the pool texture
+          float shadeValue;
+          {
+            vec3 poolDim = vec3(textureSize(t_value, 0)) / sparseBlockSize();
+            float slot = sparseBlockSlot(cellInd3f);
+            vec3 slotInd = vec3(mod(slot, poolDim.x), mod(floor(slot / poolDim.x), poolDim.y),
+                                floor(slot / (poolDim.x * poolDim.y)));
+            vec3 blockOrigin = floor(cellInd3f / sparseBlockSize()) * sparseBlockSize();
+            shadeValue = texelFetch(t_value, ivec3(slotInd * sparseBlockSize() + cellInd3f - blockOrigin), 0).r;
+            shadeValue = shadeValue * u_valueScale + u_valueOffset; // compact pools are normalized
+          }
+        )"},
+    },
+    /* uniforms */ {
+      {"u_valueScale", RenderDataType::Float},
+      {"u_valueOffset", RenderDataType::Float},
+    },
+    /* attributes */ { },
+    /* textures */ {
+      {"t_value", 3},
+    }
+);
+
+const ShaderReplacementRule GRIDCUBE_SPARSE_OCCUPANCY (
+    /* rule name */ "GRIDCUBE_SPARSE_OCCUPANCY",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform sampler3D t_sparseBlockSlot;
+          uniform float u_sparseBlockSize;
+
+          // the slot holding the values of the block containing a cell, or -1 if the block is empty
+          float sparseBlockSlot(vec3 cellInd3f) {
+            ivec3 block = ivec3(floor(cellInd3f / u_sparseBlockSize));
+            if(any(lessThan(block, ivec3(0))) || any(greaterThanEqual(block, textureSize(t_sparseBlockSlot, 0)))) {
+              return -1.f;
+            }
+            return texelFetch(t_sparseBlockSlot, block, 0).r;
+          }
+
+          float sparseBlockSize() {
+            return u_sparseBlockSize;
+          }
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER", R"(
+          if(sparseBlockSlot(cellInd3f) < 0.f) {
+            discard;
+          }
+        )"},
+      {"GRID_PLANE_NEIGHBOR_FILTER", R"(
+          if(sparseBlockSlot(cellInd3f + a_refNormalToFrag) < 0.f) {
+            neighIsVisible = false;
+          }
+        )"},
+    },
+    /* uniforms */ {
+      {"u_sparseBlockSize", RenderDataType::Float},
+    },
+    /* attributes */ {},
+    /* textures */ {
+      {"t_sparseBlockSlot", 3},
+    }
+);
+
 const ShaderReplacementRule GRIDCUBE_WIREFRAME (
     /* rule name */ "GRIDCUBE_WIREFRAME",
     {
@@ -196,6 +196,7 @@ R"(
       vec4 sampleMirror() {
         vec2 screenCoords = vec2(gl_FragCoord.x, gl_FragCoord.y);
         vec4 mirrorImage = texture(t_mirrorImage, screenCoords / u_viewportDim) ;
+        ${ GROUND_MIRROR_ADJUST }$
         return mirrorImage;
       }
 
@@ -254,6 +255,85 @@ R"(
 )"
 };
 
+// Rather than a mirrored render of the scene, t_mirrorImage is a copy of the scene itself, and the reflection is found
+// by marching the reflected view ray across the copied scene depth. Geometry which is off screen or hidden is missing
+// from the reflection.
+const ShaderReplacementRule GROUND_REFLECT_SCREEN_SPACE (
+    /* rule name */ "GROUND_REFLECT_SCREEN_SPACE",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform mat4 u_projMatrix;
+          uniform vec3 u_basisZ;
+          uniform sampler2D t_mirrorDepth;
+
+          float viewZFromDepth(float depth) {
+            float ndcZ = 2. * depth - 1.;
+            return (u_projMatrix[3][2] - ndcZ * u_projMatrix[3][3]) / (ndcZ * u_projMatrix[2][3] - u_projMatrix[2][2]);
+          }
+
+          vec4 traceScreenSpaceReflection() {
+            vec4 viewPos4 = u_viewMatrix * PositionWorldHomog;
+            vec3 viewPos = viewPos4.xyz / viewPos4.w;
+            vec3 viewNormal = normalize(mat3(u_viewMatrix) * (u_upSign * u_basisZ));
+            vec3 rayDir = reflect(normalize(viewPos), viewNormal);
+
+            const int nSteps = 48;
+            float stepLen = 4. * u_lengthScale / float(nSteps);
+            float thickness = 2. * stepLen;
+            float tPrev = 0.;
+            for(int i = 1; i <= nSteps; i++) {
+              float t = stepLen * float(i);
+              vec3 rayPos = viewPos + t * rayDir;
+              vec4 rayClip = u_projMatrix * vec4(rayPos, 1.);
+              if(rayClip.w <= 0.) break;
+              vec2 coord = 0.5 * rayClip.xy / rayClip.w + 0.5;
+              if(any(lessThan(coord, vec2(0.))) || any(greaterThan(coord, vec2(1.)))) break;
+
+              float sceneDepth = textureLod(t_mirrorDepth, coord, 0.).r;
+              float behind = viewZFromDepth(sceneDepth) - rayPos.z;
+              if(sceneDepth < 1. && behind > 0. && behind < thickness) {
+
+                // refine the crossing between the last two steps
+                float tLow = tPrev;
+                float tHigh = t;
+                for(int j = 0; j < 4; j++) {
+                  float tMid = 0.5 * (tLow + tHigh);
+                  vec3 midPos = viewPos + tMid * rayDir;
+                  vec4 midClip = u_projMatrix * vec4(midPos, 1.);
+                  vec2 midCoord = 0.5 * midClip.xy / midClip.w + 0.5;
+                  float midBehind = viewZFromDepth(textureLod(t_mirrorDepth, midCoord, 0.).r) - midPos.z;
+                  if(midBehind > 0.) {
+                    tHigh = tMid;
+                    coord = midCoord;
+                  } else {
+                    tLow = tMid;
+                  }
+                }
+
+                // fade out towards the edges of the screen, where the reflected geometry goes missing
+                vec2 edgeDist = min(coord, vec2(1.) - coord);
+                float edgeFade = smoothstep(0., .1, min(edgeDist.x, edgeDist.y));
+                return vec4(textureLod(t_mirrorImage, coord, 0.).rgb, edgeFade);
+              }
+              tPrev = t;
+            }
+            return vec4(0.);
+          }
+        )"},
+      {"GROUND_MIRROR_ADJUST", R"(
+          mirrorImage = traceScreenSpaceReflection();
+        )"}
+    },
+    /* uniforms */ {
+      {"u_projMatrix", RenderDataType::Matrix44Float},
+      {"u_basisZ", RenderDataType::Vector3Float},
+    },
+    /* attributes */ {},
+    /* textures */ {
+      {"t_mirrorDepth", 2},
+    }
+);
+
 const ShaderStageSpecification GROUND_PLANE_SHADOW_FRAG_SHADER = {
     
     ShaderStageType::Fragment,
@@ -45,7 +45,8 @@ const ShaderStageSpecification HISTOGRAM_FRAG_SHADER = {
     // uniforms
     {
       {"u_cmapRangeMin", RenderDataType::Float},
-      {"u_cmapRangeMax", RenderDataType::Float}
+      {"u_cmapRangeMax", RenderDataType::Float},
+      {"u_colormapRow", RenderDataType::Int}
     }, 
 
     // attributes
@@ -54,7 +55,7 @@ const ShaderStageSpecification HISTOGRAM_FRAG_SHADER = {
     
     // textures 
     {
-        {"t_colormap", 1}
+        {"t_colormap", 2}
     },
     
     // source 
@@ -63,7 +64,8 @@ R"(
 
       in float t;
 
-      uniform sampler1D t_colormap;
+      uniform sampler2D t_colormap;
+      uniform int u_colormapRow;
       uniform float u_cmapRangeMin;
       uniform float u_cmapRangeMax;
 
@@ -80,7 +82,8 @@ R"(
           darkFactor = 0.6;
         }
 
-        outputF = vec4(darkFactor*texture(t_colormap, clampMapT).rgb, 1.0);
+        float cmapRowV = (float(u_colormapRow) + 0.5) / float(textureSize(t_colormap, 0).y);
+        outputF = vec4(darkFactor*texture(t_colormap, vec2(clampMapT, cmapRowV)).rgb, 1.0);
       }
 )"
 };
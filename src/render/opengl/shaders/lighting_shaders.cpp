@@ -57,7 +57,7 @@ R"(
           return sampleVal;
       }
 
-      vec4 imageSample() {
+      vec4 imageSample(vec2 tCoord) {
   
         // This function is written like this to hopefully make it as easy as possible to unroll
 
@@ -68,10 +68,11 @@ R"(
         return result / (downsampleFactor * downsampleFactor);
       } 
 
-      void main() {
+      // The whole resolve of one output pixel: downsample, composite, tonemap and gamma correct
+      vec4 resolvePixel(vec2 tCoord) {
 
         // these are defined to be premultiplied
-        vec4 color4 = imageSample();
+        vec4 color4 = imageSample(tCoord);
         vec3 color = color4.rgb;
         float alpha = color4.a;
 
@@ -96,7 +97,18 @@ R"(
         // gamma correction
         color = pow(color, vec3(1.0f/u_gamma));  
        
-        outputVal = vec4(color, alpha);
+        return vec4(color, alpha);
+      }
+
+      void main() {
+
+        vec4 resolved = resolvePixel(tCoord);
+
+        // filters of the output image, which resolve neighboring pixels as needed rather than reading them back from
+        // a separate pass
+        ${ RESOLVE_FILTER }$
+
+        outputVal = resolved;
     }  
 )"
 };
@@ -174,6 +186,42 @@ const ShaderReplacementRule DOWNSAMPLE_RESOLVE_4 (
     /* textures */ {}
 );
 
+const ShaderReplacementRule RESOLVE_FXAA (
+    /* rule name */ "RESOLVE_FXAA",
+    { /* replacement sources */
+      {"RESOLVE_FILTER", R"(
+          // FXAA: blur along the direction of the local luma gradient, on the tonemapped result. Only used without
+          // downsampling, where an output pixel is one texel.
+          const float FXAA_SPAN_MAX = 8.0;
+          const float FXAA_REDUCE_MUL = 1.0 / 8.0;
+          const float FXAA_REDUCE_MIN = 1.0 / 128.0;
+
+          float lumaNW = luminance(resolvePixel(tCoord + vec2(-1., -1.) * u_texelSize).rgb);
+          float lumaNE = luminance(resolvePixel(tCoord + vec2(1., -1.) * u_texelSize).rgb);
+          float lumaSW = luminance(resolvePixel(tCoord + vec2(-1., 1.) * u_texelSize).rgb);
+          float lumaSE = luminance(resolvePixel(tCoord + vec2(1., 1.) * u_texelSize).rgb);
+          float lumaM = luminance(resolved.rgb);
+          float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+          float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+          vec2 fxaaDir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+          float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * FXAA_REDUCE_MUL), FXAA_REDUCE_MIN);
+          float rcpDirMin = 1.0 / (min(abs(fxaaDir.x), abs(fxaaDir.y)) + dirReduce);
+          fxaaDir = clamp(fxaaDir * rcpDirMin, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * u_texelSize;
+
+          vec4 fxaaA = 0.5 * (resolvePixel(tCoord + fxaaDir * (1.0 / 3.0 - 0.5)) +
+                              resolvePixel(tCoord + fxaaDir * (2.0 / 3.0 - 0.5)));
+          vec4 fxaaB = 0.5 * fxaaA + 0.25 * (resolvePixel(tCoord - 0.5 * fxaaDir) +
+                                             resolvePixel(tCoord + 0.5 * fxaaDir));
+          float lumaB = luminance(fxaaB.rgb);
+          resolved = (lumaB < lumaMin || lumaB > lumaMax) ? fxaaA : fxaaB;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {}
+);
+
 const ShaderReplacementRule INVERSE_TONEMAP (
     /* rule name */ "INVERSE_TONEMAP",
     { /* replacement sources */
@@ -279,6 +327,72 @@ const ShaderReplacementRule TRANSPARENCY_PEEL_STRUCTURE (
     }
 );
 
+const ShaderReplacementRule TRANSPARENCY_WEIGHTED_STRUCTURE (
+    /* rule name */ "TRANSPARENCY_WEIGHTED_STRUCTURE",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform float u_transparency;
+          uniform int u_weightedTransparencyPass;
+          layout(location = 1) out vec4 outputRevealage;
+        )"},
+      {"GENERATE_ALPHA", R"(
+          alphaOut *= u_transparency;
+          outputRevealage = vec4(0.);
+          // outside the accumulation pass (e.g. sorted transparent points) the plain alpha is blended over the scene
+          if(u_transparency < 1. && u_weightedTransparencyPass == 1) {
+            // accumulate -log(1 - alpha) additively, the resolve recovers the product of (1 - alpha) via exp()
+            float alphaClamp = clamp(alphaOut, 0., 0.999);
+            outputRevealage.x = -log(1. - alphaClamp);
+
+            // depth-based weight (McGuire & Bavoil 2013), scales both the color and alpha sums
+            float weightZ = 1. - 0.9 * gl_FragCoord.z;
+            float weight = pow(min(1.0, alphaClamp * 10.0) + 0.01, 3.0) * 1e8 * weightZ * weightZ * weightZ;
+            alphaOut *= clamp(weight, 1e-2, 3e3);
+          }
+        )"},
+    },
+    /* uniforms */ {
+        {"u_transparency", RenderDataType::Float},
+        {"u_weightedTransparencyPass", RenderDataType::Int},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+// Depth prepass: stage 1 writes only depth and returns before the shading of the shaders which have a DEPTH_PREPASS_EXIT
+// tag (others shade as usual, with color writes masked). Stage 2 discards fragments behind the prepass depth, so only
+// the visible surface of each pixel is shaded.
+const ShaderReplacementRule DEPTH_PREPASS_STRUCTURE (
+    /* rule name */ "DEPTH_PREPASS_STRUCTURE",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform int u_depthPrepassStage;
+          uniform sampler2D t_prepassDepth;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER", R"(
+          // assumption: "float depth" must be already set 
+          if(u_depthPrepassStage == 2) {
+            float prepassDepth = texelFetch(t_prepassDepth, ivec2(gl_FragCoord.xy), 0).x;
+            if(depth > prepassDepth + 1e-6) {
+              discard;
+            }
+          }
+        )"},
+      {"DEPTH_PREPASS_EXIT", R"(
+          if(u_depthPrepassStage == 1) {
+            return;
+          }
+        )"},
+    },
+    /* uniforms */ {
+        {"u_depthPrepassStage", RenderDataType::Int},
+    },
+    /* attributes */ {},
+    /* textures */ {
+        {"t_prepassDepth", 2},
+    }
+);
+
 const ShaderReplacementRule TRANSPARENCY_PEEL_GROUND (
     /* rule name */ "TRANSPARENCY_PEEL_GROUND",
     { /* replacement sources */
@@ -151,6 +151,85 @@ R"(
 };
 
 
+// Draws the same ribbon as RIBBON_GEOM_SHADER without a geometry shader: one instance per segment, each a strip of 6
+// vertices. The points and normals of the lines are pulled from textures, each line stored with its first and last
+// point repeated so that every segment can read the points before and after it.
+const ShaderStageSpecification RIBBON_INSTANCED_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_ribbonWidth", RenderDataType::Float},
+        {"u_depthOffset", RenderDataType::Float},
+        {"u_ribbonColor", RenderDataType::Vector3Float},
+    },
+
+    // attributes
+    {
+        {"a_stripCorner", RenderDataType::Vector2Float},
+        {"a_segmentStart", RenderDataType::Float, 1, true},
+    },
+
+    // textures
+    {
+        {"t_ribbonPoints", 2},
+        {"t_ribbonNormals", 2},
+    },
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        in vec2 a_stripCorner;   // x in {0,1} from the start to the end of the segment, y in {-1,0,1} across the ribbon
+        in float a_segmentStart; // per-instance, the index of the segment's first point
+        uniform mat4 u_modelView;
+        uniform mat4 u_projMatrix;
+        uniform float u_ribbonWidth;
+        uniform float u_depthOffset;
+        uniform vec3 u_ribbonColor;
+        uniform sampler2D t_ribbonPoints;
+        uniform sampler2D t_ribbonNormals;
+        out vec3 colorToFrag;
+        out vec3 cameraNormalToFrag;
+        out float intensityToFrag;
+
+        ${ VERT_DECLARATIONS }$
+
+        vec3 fetchRibbonData(sampler2D t, int ind) {
+          int w = textureSize(t, 0).x;
+          return texelFetch(t, ivec2(ind % w, ind / w), 0).rgb;
+        }
+
+        void main()
+        {
+            int iStart = int(a_segmentStart);
+            vec3 pos0 = fetchRibbonData(t_ribbonPoints, iStart - 1);
+            vec3 pos1 = fetchRibbonData(t_ribbonPoints, iStart);
+            vec3 pos2 = fetchRibbonData(t_ribbonPoints, iStart + 1);
+            vec3 pos3 = fetchRibbonData(t_ribbonPoints, iStart + 2);
+            vec3 dir = normalize(pos2 - pos1);
+            vec3 prevDir = (pos1 == pos0) ? dir : normalize(pos1 - pos0); // the repeated point at the ends of a line
+            vec3 nextDir = (pos3 == pos2) ? dir : normalize(pos3 - pos2);
+
+            bool atEnd = a_stripCorner.x > 0.5;
+            vec3 pos = atEnd ? pos2 : pos1;
+            vec3 normal = fetchRibbonData(t_ribbonNormals, atEnd ? iStart + 1 : iStart);
+            vec3 sideVec = normalize(cross(normalize(dir + (atEnd ? nextDir : prevDir)), normal));
+
+            gl_Position = u_projMatrix * u_modelView * vec4(pos + a_stripCorner.y * sideVec * u_ribbonWidth, 1.);
+            gl_Position.z -= u_depthOffset;
+            cameraNormalToFrag = mat3(u_modelView) * normal;
+            colorToFrag = u_ribbonColor;
+            intensityToFrag = 1. - abs(a_stripCorner.y);
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
 
 const ShaderStageSpecification RIBBON_FRAG_SHADER = {
     
@@ -175,6 +254,7 @@ R"(
         {
            
            float depth = gl_FragCoord.z;
+           ${ GLOBAL_FRAGMENT_FILTER_PREP }$
            ${ GLOBAL_FRAGMENT_FILTER }$
 
            // Compute a fade factor to set the transparency
@@ -54,6 +54,28 @@ const ShaderReplacementRule LIGHT_MATCAP (
     }
 );
 
+// As LIGHT_MATCAP, for the materials in the shared material texture array. Which material is used is just a uniform.
+const ShaderReplacementRule LIGHT_MATCAP_ARRAY (
+    /* rule name */ "LIGHT_MATCAP_ARRAY",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform sampler3D t_matArray;
+          uniform vec4 u_matLayers;
+          vec3 lightSurfaceMatArray(vec3 normal, vec3 color, sampler3D t_matArray, vec4 matLayers);
+        )"},
+      {"GENERATE_LIT_COLOR", R"(
+          vec3 litColor = lightSurfaceMatArray(shadeNormal, albedoColor, t_matArray, u_matLayers);
+      )"}
+    },
+    /* uniforms */ {
+      {"u_matLayers", RenderDataType::Vector4Float},
+    },
+    /* attributes */ {},
+    /* textures */ {
+      {"t_matArray", 3},
+    }
+);
+
 // "light" by just copying the value 
 // input: vec3 albedoColor;
 // output: vec3 litColor after lighting
@@ -67,6 +89,24 @@ const ShaderReplacementRule LIGHT_PASSTHRU (
     /* textures */ {}
 );
 
+// input: vec3 litColor, holding the pick index as three 22-bit chunks (see pick::indToVec())
+// output: the 64-bit index as two 32-bit words at location 1, written to the integer pick buffer
+const ShaderReplacementRule PICK_OUTPUT_INDEX (
+    /* rule name */ "PICK_OUTPUT_INDEX",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          layout(location = 1) out uvec2 outputPickInd;
+        )"},
+      {"GENERATE_LIT_COLOR", R"(
+          uvec3 pickChunks = uvec3(round(litColor * 4194304.));
+          outputPickInd = uvec2(pickChunks.x | (pickChunks.y << 22), (pickChunks.y >> 10) | (pickChunks.z << 12));
+        )"}
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {}
+);
+
 
 // input: uniform
 // output: vec3 albedoColor
@@ -121,21 +161,24 @@ const ShaderReplacementRule SHADE_COLORMAP_VALUE(
       {"FRAG_DECLARATIONS", R"(
           uniform float u_rangeHigh;
           uniform float u_rangeLow;
-          uniform sampler1D t_colormap;
+          uniform sampler2D t_colormap;
+          uniform int u_colormapRow;
         )"},
       {"GENERATE_SHADE_COLOR", R"(
           float rangeTVal = (shadeValue - u_rangeLow) / (u_rangeHigh - u_rangeLow);
           rangeTVal = clamp(rangeTVal, 0.f, 1.f);
-          vec3 albedoColor = texture(t_colormap, rangeTVal).rgb;
+          float cmapRowV = (float(u_colormapRow) + 0.5) / float(textureSize(t_colormap, 0).y);
+          vec3 albedoColor = texture(t_colormap, vec2(rangeTVal, cmapRowV)).rgb;
       )"}
     },
     /* uniforms */ {
         {"u_rangeLow", RenderDataType::Float},
         {"u_rangeHigh", RenderDataType::Float},
+        {"u_colormapRow", RenderDataType::Int},
     },
     /* attributes */ {},
     /* textures */ {
-        {"t_colormap", 1}
+        {"t_colormap", 2}
     }
 );
 
@@ -146,21 +189,24 @@ const ShaderReplacementRule SHADE_COLORMAP_ANGULAR2(
     { /* replacement sources */
       {"FRAG_DECLARATIONS", R"(
           uniform float u_angle;
-          uniform sampler1D t_colormap;
+          uniform sampler2D t_colormap;
+          uniform int u_colormapRow;
         )"},
       {"GENERATE_SHADE_COLOR", R"(
           float pi = 3.14159265359;
           float angle = atan(shadeValue2.y, shadeValue2.x) / (2. * pi) + 0.5; // in [0,1]
           float shiftedAngle = mod(angle + u_angle/(2. * pi), 1.);
-          vec3 albedoColor = texture(t_colormap, shiftedAngle).rgb;
+          float cmapRowV = (float(u_colormapRow) + 0.5) / float(textureSize(t_colormap, 0).y);
+          vec3 albedoColor = texture(t_colormap, vec2(shiftedAngle, cmapRowV)).rgb;
       )"}
     },
     /* uniforms */ {
         {"u_angle", RenderDataType::Float},
+        {"u_colormapRow", RenderDataType::Int},
     },
     /* attributes */ {},
     /* textures */ {
-        {"t_colormap", 1}
+        {"t_colormap", 2}
     }
 );
 
@@ -231,7 +277,8 @@ const ShaderReplacementRule SHADE_CHECKER_CATEGORY(
       {"FRAG_DECLARATIONS", R"(
           uniform float u_modLen;
           uniform float u_modDarkness;
-          uniform sampler1D t_colormap;
+          uniform sampler2D t_colormap;
+          uniform int u_colormapRow;
 
           float intToDistinctReal(float start, int index);
         )"},
@@ -239,7 +286,8 @@ const ShaderReplacementRule SHADE_CHECKER_CATEGORY(
         // sample the categorical color
         float catVal = intToDistinctReal(0., int(shadeValue));
         float scaleFac = 1.2f; // pump up the brightness a bit, so the modDarkness doesn't make it too dark
-        vec3 catColor = scaleFac * texture(t_colormap, catVal).rgb;
+        float cmapRowV = (float(u_colormapRow) + 0.5) / float(textureSize(t_colormap, 0).y);
+        vec3 catColor = scaleFac * texture(t_colormap, vec2(catVal, cmapRowV)).rgb;
         vec3 catColorDark = catColor * u_modDarkness;
 
         // NOTE checker math shared with other shaders
@@ -258,10 +306,11 @@ const ShaderReplacementRule SHADE_CHECKER_CATEGORY(
     /* uniforms */ {
        {"u_modLen", RenderDataType::Float},
        {"u_modDarkness", RenderDataType::Float},
+       {"u_colormapRow", RenderDataType::Int},
     },
     /* attributes */ {},
     /* textures */ {
-        {"t_colormap", 1}
+        {"t_colormap", 2}
     }
 );
 
@@ -397,6 +446,81 @@ const ShaderReplacementRule PREMULTIPLY_LIT_COLOR(
     /* textures */ {}
 );
 
+// == Keyframes (see polyscope/keyframes.h)
+// All frames of a keyframed attribute live in one 3D texture, one frame per layer. The rules redefine the attribute as
+// a blend of the two current frames, so the shaders which read it keep working unchanged.
+
+const ShaderReplacementRule KEYFRAME_COMMON (
+    /* rule name */ "KEYFRAME_COMMON",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform int u_keyframeA;
+          uniform int u_keyframeB;
+          uniform float u_keyframeT;
+          vec4 keyframeBlend(sampler3D t, float ind) {
+            int i = int(ind + 0.5);
+            int width = textureSize(t, 0).x;
+            ivec2 texel = ivec2(i % width, i / width);
+            vec4 valA = texelFetch(t, ivec3(texel, u_keyframeA), 0);
+            vec4 valB = texelFetch(t, ivec3(texel, u_keyframeB), 0);
+            return mix(valA, valB, u_keyframeT);
+          }
+        )"},
+    },
+    /* uniforms */ {
+      {"u_keyframeA", RenderDataType::Int},
+      {"u_keyframeB", RenderDataType::Int},
+      {"u_keyframeT", RenderDataType::Float},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+// the element each vertex reads from the keyframe textures
+const ShaderReplacementRule KEYFRAME_INDEX (
+    /* rule name */ "KEYFRAME_INDEX",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_keyframeInd;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_keyframeInd", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule KEYFRAME_POSITION (
+    /* rule name */ "KEYFRAME_POSITION",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform sampler3D t_keyframePositions;
+          #define a_position keyframeBlend(t_keyframePositions, a_keyframeInd).xyz
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {
+      {"t_keyframePositions", 3},
+    }
+);
+
+const ShaderReplacementRule KEYFRAME_VALUE (
+    /* rule name */ "KEYFRAME_VALUE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform sampler3D t_keyframeValues;
+          #define a_value keyframeBlend(t_keyframeValues, a_keyframeInd).r
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {
+      {"t_keyframeValues", 3},
+    }
+);
+
 
 // TODO delete me
 const ShaderReplacementRule CULL_POS_FROM_VIEW (
@@ -413,54 +537,53 @@ const ShaderReplacementRule CULL_POS_FROM_VIEW (
 );
 
 
-ShaderReplacementRule generateSlicePlaneRule(std::string uniquePostfix) {
+// Each slice plane is a uniform vec4 u_slicePlane_<i> for i < maxSlicePlanes, holding the view-space normal and the
+// offset dot(center, normal). A fixed number of them is declared so adding or removing planes never changes the
+// programs, planes which are unused or disabled get values which pass every fragment.
+ShaderReplacementRule generateSlicePlaneRule() {
 
-  std::string centerUniformName = "u_slicePlaneCenter_" + uniquePostfix;
-  std::string normalUniformName = "u_slicePlaneNormal_" + uniquePostfix;
+  std::string declarations;
+  std::string filter;
+  std::vector<ShaderSpecUniform> uniforms;
+  for (int i = 0; i < maxSlicePlanes; i++) {
+    std::string planeUniformName = "u_slicePlane_" + std::to_string(i);
+    declarations += "uniform vec4 " + planeUniformName + ";\n";
+    filter += "if(dot(cullPos, " + planeUniformName + ".xyz) < " + planeUniformName + ".w) { discard; }\n";
+    uniforms.push_back({planeUniformName, RenderDataType::Vector4Float});
+  }
 
-  // This takes what is otherwise a simple rule, and substitues uniquely named uniforms so that we can have multiple slice planes
-  ShaderReplacementRule slicePlaneRule (
-      /* rule name */ "SLICE_PLANE_CULL_" + uniquePostfix,
+  return ShaderReplacementRule(
+      /* rule name */ "SLICE_PLANE_CULL",
       { /* replacement sources */
-        {"FRAG_DECLARATIONS", "uniform vec3 " + centerUniformName + "; uniform vec3 " + normalUniformName + ";"},
-        {"GLOBAL_FRAGMENT_FILTER", 
-         "if(dot(cullPos, " + normalUniformName + ") < dot( " + centerUniformName + " , " + normalUniformName + ")) { discard; }"}
-      },
-      /* uniforms */ {
-        {centerUniformName, RenderDataType::Vector3Float},
-        {normalUniformName, RenderDataType::Vector3Float},
+        {"FRAG_DECLARATIONS", declarations},
+        {"GLOBAL_FRAGMENT_FILTER", filter}
       },
+      /* uniforms */ uniforms,
       /* attributes */ {},
       /* textures */ {}
   );
-
-  return slicePlaneRule;
 }
 
-ShaderReplacementRule generateVolumeGridSlicePlaneRule(std::string uniquePostfix) {
+ShaderReplacementRule generateVolumeGridSlicePlaneRule() {
 
-  std::string centerUniformName = "u_slicePlaneCenter_" + uniquePostfix;
-  std::string normalUniformName = "u_slicePlaneNormal_" + uniquePostfix;
+  std::string filter;
+  std::vector<ShaderSpecUniform> uniforms;
+  for (int i = 0; i < maxSlicePlanes; i++) {
+    std::string planeUniformName = "u_slicePlane_" + std::to_string(i);
+    filter += "if(dot(neighCullPos, " + planeUniformName + ".xyz) < " + planeUniformName + ".w) { neighIsVisible = false; }\n";
+    uniforms.push_back({planeUniformName, RenderDataType::Vector4Float});
+  }
 
-  // This takes what is otherwise a simple rule, and substitues uniquely named uniforms so that we can have multiple slice planes
-  ShaderReplacementRule slicePlaneRule (
-      /* rule name */ "SLICE_PLANE_VOLUMEGRID_CULL_" + uniquePostfix,
+  return ShaderReplacementRule(
+      /* rule name */ "SLICE_PLANE_VOLUMEGRID_CULL",
       { /* replacement sources */
         // skip the frag declarations, we will already have them from the other rule
-        // {"FRAG_DECLARATIONS", "uniform vec3 " + centerUniformName + "; uniform vec3 " + normalUniformName + ";"},
-        {"GRID_PLANE_NEIGHBOR_FILTER",
-         "if(dot(neighCullPos, " + normalUniformName + ") < dot( " + centerUniformName + " , " + normalUniformName + ")) { neighIsVisible = false; }"
-        }
-      },
-      /* uniforms */ {
-        {centerUniformName, RenderDataType::Vector3Float},
-        {normalUniformName, RenderDataType::Vector3Float},
+        {"GRID_PLANE_NEIGHBOR_FILTER", filter}
       },
+      /* uniforms */ uniforms,
       /* attributes */ {},
       /* textures */ {}
   );
-
-  return slicePlaneRule;
 }
 
 // clang-format on
@@ -171,6 +171,7 @@ R"(
            
            // Set depth (expensive!)
            gl_FragDepth = depth;
+           ${ DEPTH_PREPASS_EXIT }$
           
            // Shading
            ${ GENERATE_SHADE_VALUE }$
@@ -191,6 +192,66 @@ R"(
 )"
 };
 
+//  The SPLAT vertex shader draws each point as a single GL_POINTS sprite sized to cover the sphere, so no geometry
+//  shader is needed, and is paired with FLEX_SPHERE_FRAG_SHADER to raycast the sphere within the sprite. Sprites are
+//  limited to the maximum point size of the driver, and are clipped whole when their center leaves the view, so this
+//  is best suited to many small points. Rules pass values straight from the vertex to the fragment shader, so the
+//  SPLAT_ variants of the sphere rules are used.
+
+const ShaderStageSpecification FLEX_SPLAT_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_viewport", RenderDataType::Vector4Float},
+        {"u_pointRadius", RenderDataType::Float},
+    }, 
+
+    // attributes
+    {
+        {"a_position", RenderDataType::Vector3Float},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        in vec3 a_position;
+        uniform mat4 u_modelView;
+        uniform mat4 u_projMatrix;
+        uniform vec4 u_viewport;
+        uniform float u_pointRadius;
+        out vec3 sphereCenterView;
+        
+        ${ VERT_DECLARATIONS }$
+        
+        void main()
+        {
+            vec4 centerView = u_modelView * vec4(a_position, 1.0);
+
+            float pointRadius = u_pointRadius;
+            ${ SPLAT_SET_POINT_RADIUS_VERT }$
+
+            // Size the sprite from the depth of the sphere point nearest the camera, like the quad of the geometry
+            // shader version, with some margin for the perspective stretching of spheres away from the view center
+            vec3 dirToCam = normalize(-centerView.xyz);
+            vec4 nearClip = u_projMatrix * (centerView + vec4(dirToCam, 0.) * pointRadius);
+            float pixelRadius = pointRadius * u_projMatrix[1][1] * 0.5 * u_viewport.w / max(nearClip.w, 1e-6);
+            gl_PointSize = 2. * 1.25 * pixelRadius + 2.;
+
+            gl_Position = u_projMatrix * centerView;
+            sphereCenterView = centerView.xyz / centerView.w;
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
 //  These POINTQUAD shaders render a quad at the location of the point. Technically, 
 //  they don't draw spheres, but we group them here because they share a lot of logic 
 //  with the spheres & accept the same rules.
@@ -479,6 +540,46 @@ const ShaderReplacementRule SPHERE_PROPAGATE_COLOR (
     /* textures */ {}
 );
 
+const ShaderReplacementRule SPHERE_PROPAGATE_SELECTION (
+    /* rule name */ "SPHERE_PROPAGATE_SELECTION",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform sampler2D t_selection;
+          out float a_selectedToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          {
+            // a bit per point, packed 24 to a texel, see ElementSelection
+            int selectionTexWidth = textureSize(t_selection, 0).x;
+            int selectionTexel = gl_VertexID / 24;
+            int selectionBits = int(texelFetch(t_selection, ivec2(selectionTexel % selectionTexWidth, selectionTexel / selectionTexWidth), 0).r);
+            a_selectedToGeom = float((selectionBits >> (gl_VertexID % 24)) & 1);
+          }
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in float a_selectedToGeom[];
+          flat out float a_selectedToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_selectedToFrag = a_selectedToGeom[0]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          uniform vec3 u_selectionColor;
+          flat in float a_selectedToFrag;
+        )"},
+      {"GENERATE_SHADE_COLOR", R"(
+          albedoColor = mix(albedoColor, u_selectionColor, 0.75 * a_selectedToFrag);
+        )"},
+    },
+    /* uniforms */ {
+      {"u_selectionColor", RenderDataType::Vector3Float},
+    },
+    /* attributes */ {},
+    /* textures */ {
+      {"t_selection", 2},
+    }
+);
+
 const ShaderReplacementRule SPHERE_CULLPOS_FROM_CENTER(
     /* rule name */ "SPHERE_CULLPOS_FROM_CENTER",
     { /* replacement sources */
@@ -551,6 +652,163 @@ const ShaderReplacementRule SPHERE_VARIABLE_SIZE (
     /* textures */ {}
 );
 
+// == Rules for the SPLAT shaders, which have no geometry stage
+
+const ShaderReplacementRule SPLAT_PROPAGATE_VALUE (
+    /* rule name */ "SPLAT_PROPAGATE_VALUE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_value;
+          out float a_valueToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_valueToFrag = a_value;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_valueToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float shadeValue = a_valueToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_value", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPLAT_PROPAGATE_VALUEALPHA (
+    /* rule name */ "SPLAT_PROPAGATE_VALUEALPHA",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_valueAlpha;
+          out float a_valueAlphaToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_valueAlphaToFrag = a_valueAlpha;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_valueAlphaToFrag;
+        )"},
+      {"GENERATE_ALPHA", R"(
+          alphaOut *= clamp(a_valueAlphaToFrag, 0.f, 1.f);
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_valueAlpha", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPLAT_PROPAGATE_VALUE2 (
+    /* rule name */ "SPLAT_PROPAGATE_VALUE2",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec2 a_value2;
+          out vec2 a_value2ToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_value2ToFrag = a_value2;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec2 a_value2ToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec2 shadeValue2 = a_value2ToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_value2", RenderDataType::Vector2Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPLAT_PROPAGATE_COLOR (
+    /* rule name */ "SPLAT_PROPAGATE_COLOR",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_color;
+          flat out vec3 a_colorToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToFrag = a_color;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_color", RenderDataType::Vector3Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPLAT_PROPAGATE_SELECTION (
+    /* rule name */ "SPLAT_PROPAGATE_SELECTION",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform sampler2D t_selection;
+          flat out float a_selectedToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          {
+            int selectionTexWidth = textureSize(t_selection, 0).x;
+            int selectionTexel = gl_VertexID / 24;
+            int selectionBits = int(texelFetch(t_selection, ivec2(selectionTexel % selectionTexWidth, selectionTexel / selectionTexWidth), 0).r);
+            a_selectedToFrag = float((selectionBits >> (gl_VertexID % 24)) & 1);
+          }
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          uniform vec3 u_selectionColor;
+          flat in float a_selectedToFrag;
+        )"},
+      {"GENERATE_SHADE_COLOR", R"(
+          albedoColor = mix(albedoColor, u_selectionColor, 0.75 * a_selectedToFrag);
+        )"},
+    },
+    /* uniforms */ {
+      {"u_selectionColor", RenderDataType::Vector3Float},
+    },
+    /* attributes */ {},
+    /* textures */ {
+      {"t_selection", 2},
+    }
+);
+
+const ShaderReplacementRule SPLAT_VARIABLE_SIZE (
+    /* rule name */ "SPLAT_VARIABLE_SIZE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_pointRadius;
+          out float a_pointRadiusToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_pointRadiusToFrag = a_pointRadius;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_pointRadiusToFrag;
+        )"},
+      {"SPLAT_SET_POINT_RADIUS_VERT", R"(
+          pointRadius *= a_pointRadius;
+        )"},
+      {"SPHERE_SET_POINT_RADIUS_FRAG", R"(
+          pointRadius *= a_pointRadiusToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_pointRadius", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
 // clang-format on
 
 } // namespace backend_openGL3
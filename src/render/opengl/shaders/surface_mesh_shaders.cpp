@@ -23,7 +23,6 @@ const ShaderStageSpecification FLEX_MESH_VERT_SHADER = {
     {
         {"a_vertexPositions", RenderDataType::Vector3Float},
         {"a_vertexNormals", RenderDataType::Vector3Float},
-        {"a_barycoord", RenderDataType::Vector3Float},
     },
 
     {}, // textures
@@ -39,7 +38,6 @@ R"(
         
         in vec3 a_vertexPositions;
         in vec3 a_vertexNormals;
-        in vec3 a_barycoord;
         out vec3 a_barycoordToFrag;
         out vec3 a_vertexNormalToFrag;
         
@@ -50,7 +48,10 @@ R"(
             gl_Position = u_projMatrix * u_modelView * vec4(a_vertexPositions,1.);
             
             a_vertexNormalToFrag = mat3(u_modelView) * a_vertexNormals;
-            a_barycoordToFrag = a_barycoord;
+            // triangles are drawn as consecutive corners, so the corner is given by the vertex index (this is not
+            // meaningful when drawing indexed, which is only done when nothing needs the barycentric coordinates)
+            a_barycoordToFrag = vec3(0., 0., 0.);
+            a_barycoordToFrag[gl_VertexID % 3] = 1.;
 
             ${ VERT_ASSIGNMENTS }$
         }
@@ -86,6 +87,7 @@ R"(
            float depth = gl_FragCoord.z;
            ${ GLOBAL_FRAGMENT_FILTER_PREP }$
            ${ GLOBAL_FRAGMENT_FILTER }$
+           ${ DEPTH_PREPASS_EXIT }$
           
            // Shading
            vec3 shadeNormal = a_vertexNormalToFrag;
@@ -198,6 +200,47 @@ R"(
 )"
 };
 
+const ShaderStageSpecification INSTANCED_MESH_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+    }, 
+
+    // attributes
+    {
+        {"a_vertexPositions", RenderDataType::Vector3Float},
+        {"a_instanceTransform", RenderDataType::Vector4Float, 4, true},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        uniform mat4 u_modelView;
+        uniform mat4 u_projMatrix;
+        
+        in vec3 a_vertexPositions; // one per face corner
+        in vec4 a_instanceTransform[4]; // per-instance, the columns of the transform
+        
+        ${ VERT_DECLARATIONS }$
+        
+        void main()
+        {
+            mat4 instanceTransform = mat4(a_instanceTransform[0], a_instanceTransform[1], 
+                                          a_instanceTransform[2], a_instanceTransform[3]);
+            gl_Position = u_projMatrix * u_modelView * instanceTransform * vec4(a_vertexPositions,1.);
+            
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
 
 // == Rules
 
@@ -358,6 +401,149 @@ const ShaderReplacementRule MESH_PROPAGATE_COLOR (
     /* textures */ {}
 );
 
+// Per-element data read from a texture holding one texel per element, in rows, rather than expanded to the corners.
+// a_elementInd(s) give the element(s) of each corner, they are uploaded as unsigned ints and read as exact floats.
+const ShaderReplacementRule MESH_FETCH_VALUE (
+    /* rule name */ "MESH_FETCH_VALUE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_elementInd;
+          uniform sampler2D t_elementValues;
+          flat out float a_valueToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          {
+            int elementInd = int(a_elementInd);
+            int elementTexWidth = textureSize(t_elementValues, 0).x;
+            ivec2 elementTexel = ivec2(elementInd % elementTexWidth, elementInd / elementTexWidth);
+            a_valueToFrag = texelFetch(t_elementValues, elementTexel, 0).r;
+          }
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in float a_valueToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float shadeValue = a_valueToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_elementInd", RenderDataType::UInt},
+    },
+    /* textures */ {
+      {"t_elementValues", 2},
+    }
+);
+
+const ShaderReplacementRule MESH_FETCH_HALFEDGE_VALUE (
+    /* rule name */ "MESH_FETCH_HALFEDGE_VALUE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_elementInds;
+          uniform sampler2D t_elementValues;
+          flat out vec3 a_value3ToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          {
+            int elementTexWidth = textureSize(t_elementValues, 0).x;
+            for(int iE = 0; iE < 3; iE++) {
+              int elementInd = int(a_elementInds[iE]);
+              ivec2 elementTexel = ivec2(elementInd % elementTexWidth, elementInd / elementTexWidth);
+              a_value3ToFrag[iE] = texelFetch(t_elementValues, elementTexel, 0).r;
+            }
+          }
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_value3ToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float shadeValue = a_value3ToFrag.y;
+          if(a_barycoordToFrag.y < a_barycoordToFrag.x && a_barycoordToFrag.y < a_barycoordToFrag.z) {
+            shadeValue = a_value3ToFrag.z;
+          }
+          if(a_barycoordToFrag.z < a_barycoordToFrag.x && a_barycoordToFrag.z < a_barycoordToFrag.y) {
+            shadeValue = a_value3ToFrag.x;
+          }
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_elementInds", RenderDataType::Vector3UInt},
+    },
+    /* textures */ {
+      {"t_elementValues", 2},
+    }
+);
+
+const ShaderReplacementRule MESH_FETCH_COLOR (
+    /* rule name */ "MESH_FETCH_COLOR",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_elementInd;
+          uniform sampler2D t_elementColors;
+          flat out vec3 a_colorToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          {
+            int elementInd = int(a_elementInd);
+            int elementTexWidth = textureSize(t_elementColors, 0).x;
+            ivec2 elementTexel = ivec2(elementInd % elementTexWidth, elementInd / elementTexWidth);
+            a_colorToFrag = texelFetch(t_elementColors, elementTexel, 0).rgb;
+          }
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_elementInd", RenderDataType::UInt},
+    },
+    /* textures */ {
+      {"t_elementColors", 2},
+    }
+);
+
+const ShaderReplacementRule MESH_PROPAGATE_SELECTION (
+    /* rule name */ "MESH_PROPAGATE_SELECTION",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_selectionInd;
+          uniform sampler2D t_selection;
+          flat out float a_selectedToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          {
+            // a bit per face, packed 24 to a texel, see ElementSelection
+            int selectionInd = int(a_selectionInd);
+            int selectionTexWidth = textureSize(t_selection, 0).x;
+            int selectionTexel = selectionInd / 24;
+            int selectionBits = int(texelFetch(t_selection, ivec2(selectionTexel % selectionTexWidth, selectionTexel / selectionTexWidth), 0).r);
+            a_selectedToFrag = float((selectionBits >> (selectionInd % 24)) & 1);
+          }
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          uniform vec3 u_selectionColor;
+          flat in float a_selectedToFrag;
+        )"},
+      {"GENERATE_SHADE_COLOR", R"(
+          albedoColor = mix(albedoColor, u_selectionColor, 0.75 * a_selectedToFrag);
+        )"},
+    },
+    /* uniforms */ {
+      {"u_selectionColor", RenderDataType::Vector3Float},
+    },
+    /* attributes */ {
+      {"a_selectionInd", RenderDataType::UInt},
+    },
+    /* textures */ {
+      {"t_selection", 2},
+    }
+);
+
 const ShaderReplacementRule MESH_PROPAGATE_VALUE2 (
     /* rule name */ "MESH_PROPAGATE_VALUE2",
     { /* replacement sources */
@@ -403,6 +589,22 @@ const ShaderReplacementRule MESH_PROPAGATE_TCOORD (
     /* textures */ {}
 );
 
+// keyframed vertex positions, see KEYFRAME_COMMON
+const ShaderReplacementRule MESH_KEYFRAME_POSITIONS (
+    /* rule name */ "MESH_KEYFRAME_POSITIONS",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform sampler3D t_keyframePositions;
+          #define a_vertexPositions keyframeBlend(t_keyframePositions, a_keyframeInd).xyz
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {
+      {"t_keyframePositions", 3},
+    }
+);
+
 const ShaderReplacementRule MESH_PROPAGATE_CULLPOS (
     /* rule name */ "MESH_PROPAGATE_CULLPOS",
     { /* replacement sources */
@@ -431,14 +633,23 @@ const ShaderReplacementRule MESH_WIREFRAME_FROM_BARY(
     /* rule name */ "MESH_WIREFRAME_FROM_BARY",
     { /* replacement sources */
       {"VERT_DECLARATIONS", R"(
-          in vec3 a_edgeIsReal;
-          out vec3 a_edgeIsRealToFrag;
+          uniform sampler2D t_edgeIsReal;
+          flat out vec3 a_edgeIsRealToFrag;
         )"},
       {"VERT_ASSIGNMENTS", R"(
-          a_edgeIsRealToFrag = a_edgeIsReal;
+          {
+            // a 3-bit mask per triangle, packed 8 to a texel, see SurfaceMesh::generateEdgeMaskTexture()
+            // (the clamp is for the single-texel fallback texture)
+            int triInd = gl_VertexID / 3;
+            ivec2 maskTexSize = textureSize(t_edgeIsReal, 0);
+            int texelInd = min(triInd / 8, maskTexSize.x * maskTexSize.y - 1);
+            int packedMasks = int(texelFetch(t_edgeIsReal, ivec2(texelInd % maskTexSize.x, texelInd / maskTexSize.x), 0).r);
+            int mask = (packedMasks >> (3 * (triInd % 8))) & 7;
+            a_edgeIsRealToFrag = vec3(float(mask & 1), float((mask >> 1) & 1), float((mask >> 2) & 1));
+          }
         )"},
       {"FRAG_DECLARATIONS", R"(
-          in vec3 a_edgeIsRealToFrag;
+          flat in vec3 a_edgeIsRealToFrag;
         )"},
       {"APPLY_WIREFRAME", R"(
           vec3 wireframe_UVW = a_barycoordToFrag;
@@ -446,10 +657,10 @@ const ShaderReplacementRule MESH_WIREFRAME_FROM_BARY(
       )"},
     },
     /* uniforms */ { },
-    /* attributes */ {
-      {"a_edgeIsReal", RenderDataType::Vector3Float},
-    },
-    /* textures */ {}
+    /* attributes */ { },
+    /* textures */ {
+      {"t_edgeIsReal", 2},
+    }
 );
 
 const ShaderReplacementRule MESH_WIREFRAME(
@@ -668,6 +879,91 @@ const ShaderReplacementRule MESH_PROPAGATE_PICK_SIMPLE ( // this one does faces
 );
 
 
+const ShaderReplacementRule INSTANCED_MESH_PROPAGATE_COLOR (
+    /* rule name */ "INSTANCED_MESH_PROPAGATE_COLOR",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_instanceColor;
+          flat out vec3 a_instanceColorToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_instanceColorToFrag = a_instanceColor;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_instanceColorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_instanceColorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_instanceColor", RenderDataType::Vector3Float, 1, true},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule INSTANCED_MESH_PROPAGATE_VALUE (
+    /* rule name */ "INSTANCED_MESH_PROPAGATE_VALUE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_instanceValue;
+          flat out float a_instanceValueToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_instanceValueToFrag = a_instanceValue;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in float a_instanceValueToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float shadeValue = a_instanceValueToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_instanceValue", RenderDataType::Float, 1, true},
+    },
+    /* textures */ {}
+);
+
+// The pick index of face f of an instance is the instance's start index plus f. The start index comes packed as in
+// pick::indToVec(), so the face index is added to the low 22-bit component, carrying into the others.
+const ShaderReplacementRule INSTANCED_MESH_PROPAGATE_PICK (
+    /* rule name */ "INSTANCED_MESH_PROPAGATE_PICK",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_instancePickStart;
+          flat out vec3 a_instancePickStartToFrag;
+          flat out float a_faceIndToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_instancePickStartToFrag = a_instancePickStart;
+          a_faceIndToFrag = float(gl_VertexID / 3);
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_instancePickStartToFrag;
+          flat in float a_faceIndToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float pickFactor = 4194304.; // 2^22
+          vec3 pickStart = floor(a_instancePickStartToFrag * pickFactor + 0.5);
+          float pickLow = pickStart.x + a_faceIndToFrag;
+          float pickCarryMed = floor(pickLow / pickFactor);
+          float pickMed = pickStart.y + pickCarryMed;
+          float pickCarryHigh = floor(pickMed / pickFactor);
+          vec3 shadeColor = vec3(pickLow - pickCarryMed * pickFactor, pickMed - pickCarryHigh * pickFactor, 
+                                 pickStart.z + pickCarryHigh) / pickFactor;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_instancePickStart", RenderDataType::Vector3Float, 1, true},
+    },
+    /* textures */ {}
+);
+
+
 // clang-format on
 
 } // namespace backend_openGL3
@@ -287,6 +287,193 @@ R"(
 )"
 };
 
+// Draws up to three opaque render images in one pass. Each pixel takes the nearest of the layers, which are
+// shaded with one material. Unused layers have their textures bound to those of layer 0, and are skipped via
+// u_layerCount.
+const ShaderStageSpecification COMPOSITE_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER = {
+    
+    // stage
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    { 
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_invProjMatrix", RenderDataType::Matrix44Float},
+        {"u_viewport", RenderDataType::Vector4Float},
+        {"u_layerCount", RenderDataType::Int},
+        {"u_layerFlipY0", RenderDataType::Int},
+        {"u_layerHasNormal0", RenderDataType::Int},
+        {"u_layerColorMode0", RenderDataType::Int},
+        {"u_layerBaseColor0", RenderDataType::Vector3Float},
+        {"u_layerRangeLow0", RenderDataType::Float},
+        {"u_layerRangeHigh0", RenderDataType::Float},
+        {"u_layerColormapRow0", RenderDataType::Int},
+        {"u_layerFlipY1", RenderDataType::Int},
+        {"u_layerHasNormal1", RenderDataType::Int},
+        {"u_layerColorMode1", RenderDataType::Int},
+        {"u_layerBaseColor1", RenderDataType::Vector3Float},
+        {"u_layerRangeLow1", RenderDataType::Float},
+        {"u_layerRangeHigh1", RenderDataType::Float},
+        {"u_layerColormapRow1", RenderDataType::Int},
+        {"u_layerFlipY2", RenderDataType::Int},
+        {"u_layerHasNormal2", RenderDataType::Int},
+        {"u_layerColorMode2", RenderDataType::Int},
+        {"u_layerBaseColor2", RenderDataType::Vector3Float},
+        {"u_layerRangeLow2", RenderDataType::Float},
+        {"u_layerRangeHigh2", RenderDataType::Float},
+        {"u_layerColormapRow2", RenderDataType::Int},
+    }, 
+
+    // attributes
+    { },
+    
+    // textures 
+    { 
+      {"t_depth0", 2},
+      {"t_normal0", 2},
+      {"t_color0", 2},
+      {"t_depth1", 2},
+      {"t_normal1", 2},
+      {"t_color1", 2},
+      {"t_depth2", 2},
+      {"t_normal2", 2},
+      {"t_color2", 2},
+      {"t_colormap", 2},
+    },
+    
+    // source 
+R"(
+
+  ${ GLSL_VERSION }$
+  uniform mat4 u_projMatrix; 
+  uniform mat4 u_invProjMatrix;
+  uniform vec4 u_viewport;
+  uniform int u_layerCount;
+  uniform sampler2D t_colormap;
+  uniform sampler2D t_depth0;
+  uniform sampler2D t_normal0;
+  uniform sampler2D t_color0;
+  uniform int u_layerFlipY0;
+  uniform int u_layerHasNormal0;
+  uniform int u_layerColorMode0;
+  uniform vec3 u_layerBaseColor0;
+  uniform float u_layerRangeLow0;
+  uniform float u_layerRangeHigh0;
+  uniform int u_layerColormapRow0;
+  uniform sampler2D t_depth1;
+  uniform sampler2D t_normal1;
+  uniform sampler2D t_color1;
+  uniform int u_layerFlipY1;
+  uniform int u_layerHasNormal1;
+  uniform int u_layerColorMode1;
+  uniform vec3 u_layerBaseColor1;
+  uniform float u_layerRangeLow1;
+  uniform float u_layerRangeHigh1;
+  uniform int u_layerColormapRow1;
+  uniform sampler2D t_depth2;
+  uniform sampler2D t_normal2;
+  uniform sampler2D t_color2;
+  uniform int u_layerFlipY2;
+  uniform int u_layerHasNormal2;
+  uniform int u_layerColorMode2;
+  uniform vec3 u_layerBaseColor2;
+  uniform float u_layerRangeLow2;
+  uniform float u_layerRangeHigh2;
+  uniform int u_layerColormapRow2;
+
+  in vec2 tCoord;
+  layout(location = 0) out vec4 outputF;
+    
+  float LARGE_FLOAT();
+  vec3 fragmentViewPosition(vec4 viewport, vec2 depthRange, mat4 invProjMat, vec4 fragCoord);
+  float fragDepthFromView(mat4 projMat, vec2 depthRange, vec3 viewPoint);
+
+  ${ FRAG_DECLARATIONS }$
+
+  vec2 layerCoord(int flipY) {
+    return flipY != 0 ? vec2(tCoord.x, 1. - tCoord.y) : tCoord;
+  }
+
+  // color modes: 0 color texture, 1 constant color, 2 colormapped scalar texture
+  vec3 layerAlbedo(sampler2D t_color, vec2 coord, int colorMode, vec3 baseColor, float rangeLow, float rangeHigh, int colormapRow) {
+    if(colorMode == 1) return baseColor;
+    vec3 sampled = textureLod(t_color, coord, 0.).rgb;
+    if(colorMode == 0) return sampled;
+    float rangeTVal = clamp((sampled.r - rangeLow) / (rangeHigh - rangeLow), 0.f, 1.f);
+    float cmapRowV = (float(colormapRow) + 0.5) / float(textureSize(t_colormap, 0).y);
+    return textureLod(t_colormap, vec2(rangeTVal, cmapRowV), 0.).rgb;
+  }
+
+  void main() {
+
+    // Resolve the nearest layer
+    vec2 coord0 = layerCoord(u_layerFlipY0);
+    vec2 coord1 = layerCoord(u_layerFlipY1);
+    vec2 coord2 = layerCoord(u_layerFlipY2);
+    int nearest = 0;
+    float depth = texture(t_depth0, coord0).r;
+    if(u_layerCount > 1) {
+      float depth1 = texture(t_depth1, coord1).r;
+      if(depth1 < depth) {
+        nearest = 1;
+        depth = depth1;
+      }
+    }
+    if(u_layerCount > 2) {
+      float depth2 = texture(t_depth2, coord2).r;
+      if(depth2 < depth) {
+        nearest = 2;
+        depth = depth2;
+      }
+    }
+
+    if(depth > LARGE_FLOAT()) {
+      discard;
+    }
+
+    // Set the depth of the fragment from the stored texture data
+    // WARNING this code is duplicated in other shaders
+    vec2 depthRange = vec2(gl_DepthRange.near, gl_DepthRange.far);
+    vec3 viewRay = fragmentViewPosition(u_viewport, depthRange, u_invProjMatrix, gl_FragCoord);
+    viewRay = normalize(viewRay);
+    vec3 viewPos =  viewRay * (-1./viewRay.z*depth);
+    float fragdepth = fragDepthFromView(u_projMatrix, depthRange, viewPos);
+    gl_FragDepth = fragdepth;
+
+    // Shading, from the nearest layer
+    vec3 shadeNormal = normalize(cross(dFdx(viewPos),dFdy(viewPos)));
+    vec3 albedoColor = vec3(0.f, 0.f, 0.f);
+    if(nearest == 0) {
+      albedoColor = layerAlbedo(t_color0, coord0, u_layerColorMode0, u_layerBaseColor0, u_layerRangeLow0,
+                                u_layerRangeHigh0, u_layerColormapRow0);
+      if(u_layerHasNormal0 != 0) shadeNormal = normalize(textureLod(t_normal0, coord0, 0.).rgb);
+    } else if(nearest == 1) {
+      albedoColor = layerAlbedo(t_color1, coord1, u_layerColorMode1, u_layerBaseColor1, u_layerRangeLow1,
+                                u_layerRangeHigh1, u_layerColormapRow1);
+      if(u_layerHasNormal1 != 0) shadeNormal = normalize(textureLod(t_normal1, coord1, 0.).rgb);
+    } else if(nearest == 2) {
+      albedoColor = layerAlbedo(t_color2, coord2, u_layerColorMode2, u_layerBaseColor2, u_layerRangeLow2,
+                                u_layerRangeHigh2, u_layerColormapRow2);
+      if(u_layerHasNormal2 != 0) shadeNormal = normalize(textureLod(t_normal2, coord2, 0.).rgb);
+    }
+
+    // Lighting
+    ${ GENERATE_LIT_COLOR }$
+
+     // Set alpha
+    float alphaOut = 1.;
+    ${ GENERATE_ALPHA }$
+    
+    ${ PERTURB_LIT_COLOR }$
+
+    // Write output
+    litColor *= alphaOut; // premultiplied alpha
+    outputF = vec4(litColor, alphaOut);
+
+  }
+)"
+};
+
 const ShaderStageSpecification DOT3_TEXTURE_DRAW_FRAG_SHADER = {
     
     // stage
@@ -422,6 +609,111 @@ R"(
 )"
 };
 
+const ShaderStageSpecification COMPOSITE_WEIGHTED = {
+    
+    // stage
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    { }, 
+
+    // attributes
+    { },
+    
+    // textures 
+    { {"t_accum", 2}, {"t_revealage", 2} },
+    
+    // source 
+R"(
+      ${ GLSL_VERSION }$
+
+      in vec2 tCoord;
+      uniform sampler2D t_accum;
+      uniform sampler2D t_revealage;
+      layout(location = 0) out vec4 outputF;
+
+      void main()
+      {
+        vec4 accum = texture(t_accum, tCoord);
+        float coverage = 1. - exp(-texture(t_revealage, tCoord).r);
+        if(coverage <= 0.) discard;
+
+        // weighted average color, premultiplied by the total coverage
+        vec3 avgColor = accum.rgb / max(accum.a, 1e-5);
+        outputF = vec4(avgColor * coverage, coverage);
+      }
+)"
+};
+
+const ShaderStageSpecification TAA_RESOLVE = {
+    
+    // stage
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    {
+      {"u_currInvViewProj", RenderDataType::Matrix44Float},
+      {"u_prevViewProj", RenderDataType::Matrix44Float},
+      {"u_texelSize", RenderDataType::Vector2Float},
+      {"u_blend", RenderDataType::Float},
+      {"u_clampHistory", RenderDataType::Int},
+    }, 
+
+    // attributes
+    { },
+    
+    // textures 
+    { {"t_current", 2}, {"t_history", 2}, {"t_depth", 2} },
+    
+    // source 
+R"(
+      ${ GLSL_VERSION }$
+
+      in vec2 tCoord;
+      uniform sampler2D t_current;
+      uniform sampler2D t_history;
+      uniform sampler2D t_depth;
+      uniform mat4 u_currInvViewProj;
+      uniform mat4 u_prevViewProj;
+      uniform vec2 u_texelSize;
+      uniform float u_blend;
+      uniform int u_clampHistory;
+      layout(location = 0) out vec4 outputF;
+
+      void main()
+      {
+        vec4 current = texture(t_current, tCoord);
+
+        // find this pixel in the previous frame
+        float depth = texture(t_depth, tCoord).r;
+        vec4 worldPos = u_currInvViewProj * vec4(2. * tCoord - 1., 2. * depth - 1., 1.);
+        vec4 prevClipPos = u_prevViewProj * (worldPos / worldPos.w);
+        vec2 prevCoord = 0.5 * prevClipPos.xy / prevClipPos.w + 0.5;
+        if(any(lessThan(prevCoord, vec2(0.))) || any(greaterThan(prevCoord, vec2(1.)))) {
+          outputF = current;
+          return;
+        }
+        vec4 history = texture(t_history, prevCoord);
+
+        // reject history outside the range of the new render around this pixel
+        if(u_clampHistory != 0) {
+          vec4 minVal = current;
+          vec4 maxVal = current;
+          for(int i = -1; i <= 1; i++) {
+            for(int j = -1; j <= 1; j++) {
+              vec4 val = texture(t_current, tCoord + vec2(i,j) * u_texelSize);
+              minVal = min(minVal, val);
+              maxVal = max(maxVal, val);
+            }
+          }
+          history = clamp(history, minVal, maxVal);
+        }
+
+        outputF = mix(history, current, u_blend);
+      }
+)"
+};
+
 const ShaderStageSpecification DEPTH_COPY = {
     
     // stage
@@ -582,6 +874,58 @@ R"(
 )"
 };
 
+const ShaderStageSpecification BLUR_RGBA = {
+  // As BLUR_RGB, but the alpha channel is blurred too, rather than set to 1.
+    
+    // stage
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    { 
+      {"u_horizontal", RenderDataType::Int},
+    }, 
+
+    // attributes
+    { },
+    
+    // textures 
+    { 
+      {"t_image", 2},
+    },
+    
+    // source 
+R"(
+      ${ GLSL_VERSION }$
+
+      in vec2 tCoord;
+      uniform sampler2D t_image;
+      uniform int u_horizontal;
+      uniform float weight[5] = float[] (0.227027, 0.1945946, 0.1216216, 0.054054, 0.016216); // gaussian blur weights
+      layout(location = 0) out vec4 outputF;
+
+      void main()
+      {
+        vec2 texScale = 1.0 / textureSize(t_image, 0);
+        vec4 valCenter = texture(t_image, tCoord);
+        vec4 val = valCenter * weight[0];
+        if(u_horizontal == 1) {
+            for(int i = 1; i < 5; ++i) {
+                val += texture(t_image, tCoord + vec2(texScale.x * i, 0.0)) * weight[i];
+                val += texture(t_image, tCoord - vec2(texScale.x * i, 0.0)) * weight[i];
+            }
+        }
+        else {
+            for(int i = 1; i < 5; ++i) {
+                val += texture(t_image, tCoord + vec2(0.0, texScale.y * i)) * weight[i];
+                val += texture(t_image, tCoord - vec2(0.0, texScale.y * i)) * weight[i];
+            }
+        }
+
+        outputF = val;
+      }
+)"
+};
+
 const ShaderReplacementRule TEXTURE_ORIGIN_UPPERLEFT (
     /* rule name */ "TEXTURE_ORIGIN_UPPERLEFT",
     { /* replacement sources */
@@ -758,6 +1102,23 @@ const ShaderReplacementRule TEXTURE_BILLBOARD_FROM_UNIFORMS(
     /* textures */ {}
 );
 
+const ShaderReplacementRule TEXTURE_TILE_FROM_UNIFORMS(
+    /* rule name */ "TEXTURE_TILE_FROM_UNIFORMS",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform vec4 u_tileRect;
+        )" },
+      {"POSITION_ADJUST", R"(
+        position.xy = mix(u_tileRect.xy, u_tileRect.zw, (position.xy + 1.) / 2.);
+      )"}
+    },
+    /* uniforms */ {
+      {"u_tileRect", RenderDataType::Vector4Float},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
+
 const ShaderReplacementRule SHADE_NORMAL_FROM_TEXTURE (
     /* rule name */ "NORMAL_FROM_TEXTURE",
     { /* replacement sources */
@@ -187,6 +187,169 @@ R"(
 };
 
 
+const ShaderStageSpecification FLEX_VECTOR_INSTANCED_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_lengthMult", RenderDataType::Float},
+        {"u_radius", RenderDataType::Float},
+        {"u_keepFraction", RenderDataType::Float},
+    }, 
+
+    // attributes
+    {
+        {"a_boxCorner", RenderDataType::Vector3Float},
+        {"a_position", RenderDataType::Vector3Float, 1, true},
+        {"a_vector", RenderDataType::Vector3Float, 1, true},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        in vec3 a_boxCorner; // x,y in {-1,1} across the arrow, z in {0,1} from tail to tip
+        in vec3 a_position; // per-instance
+        in vec3 a_vector;   // per-instance
+        uniform mat4 u_modelView;
+        uniform mat4 u_projMatrix;
+        uniform float u_lengthMult;
+        uniform float u_radius;
+        uniform float u_keepFraction;
+        out vec3 tipView;
+        out vec3 tailView;
+        
+        ${ VERT_DECLARATIONS }$
+
+        void buildTangentBasis(vec3 unitNormal, out vec3 basisX, out vec3 basisY);
+
+        void main()
+        {
+
+            // Skip a stable pseudo-random subset of instances when decimating. The hash is fixed per instance, so
+            // the set drawn only grows as u_keepFraction increases.
+            uint h = uint(gl_InstanceID);
+            h ^= h >> 16u; h *= 0x7feb352du; h ^= h >> 15u; h *= 0x846ca68bu; h ^= h >> 16u;
+            if(float(h >> 8u) * (1. / 16777216.) >= u_keepFraction) {
+              gl_Position = vec4(2., 2., 2., 1.); // outside the clip volume, nothing is rasterized
+              return;
+            }
+
+            vec3 worldVector = a_vector;
+
+            // Build an orthogonal basis
+            vec4 tailViewH = u_modelView * vec4(a_position, 1.0);
+            vec3 tailViewVal = tailViewH.xyz / tailViewH.w;
+            vec3 vecViewVal = (u_modelView * vec4(worldVector, 0.0)).xyz;
+            vec3 tipViewVal = tailViewVal + vecViewVal * u_lengthMult;
+            vec3 vecDir = normalize(vecViewVal);
+            vec3 basisX; vec3 basisY; buildTangentBasis(vecDir, basisX, basisY);
+
+            // Place this corner of the bounding box around the arrow, the fragment shader raycasts the actual shape
+            vec3 cornerView = mix(tailViewVal, tipViewVal, a_boxCorner.z) + 
+                              u_radius * (a_boxCorner.x * basisX + a_boxCorner.y * basisY);
+            gl_Position = u_projMatrix * vec4(cornerView, 1.0);
+            tailView = tailViewVal;
+            tipView = tipViewVal;
+            
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
+const ShaderStageSpecification FLEX_TANGENT_VECTOR_INSTANCED_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_lengthMult", RenderDataType::Float},
+        {"u_radius", RenderDataType::Float},
+        {"u_keepFraction", RenderDataType::Float},
+        {"u_vectorRotRad", RenderDataType::Float},
+    }, 
+
+    // attributes
+    {
+        {"a_boxCorner", RenderDataType::Vector3Float},
+        {"a_position", RenderDataType::Vector3Float, 1, true},
+        {"a_tangentVector", RenderDataType::Vector2Float, 1, true},
+        {"a_basisVectorX", RenderDataType::Vector3Float, 1, true},
+        {"a_basisVectorY", RenderDataType::Vector3Float, 1, true},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        in vec3 a_boxCorner; // x,y in {-1,1} across the arrow, z in {0,1} from tail to tip
+        in vec3 a_position;      // per-instance
+        in vec2 a_tangentVector; // per-instance
+        in vec3 a_basisVectorX;  // per-instance
+        in vec3 a_basisVectorY;  // per-instance
+        uniform float u_vectorRotRad;
+        uniform mat4 u_modelView;
+        uniform mat4 u_projMatrix;
+        uniform float u_lengthMult;
+        uniform float u_radius;
+        uniform float u_keepFraction;
+        out vec3 tipView;
+        out vec3 tailView;
+        
+        ${ VERT_DECLARATIONS }$
+
+        void buildTangentBasis(vec3 unitNormal, out vec3 basisX, out vec3 basisY);
+
+        void main()
+        {
+
+            // Skip a stable pseudo-random subset of instances when decimating. The hash is fixed per instance, so
+            // the set drawn only grows as u_keepFraction increases.
+            uint h = uint(gl_InstanceID);
+            h ^= h >> 16u; h *= 0x7feb352du; h ^= h >> 15u; h *= 0x846ca68bu; h ^= h >> 16u;
+            if(float(h >> 8u) * (1. / 16777216.) >= u_keepFraction) {
+              gl_Position = vec4(2., 2., 2., 1.); // outside the clip volume, nothing is rasterized
+              return;
+            }
+
+            vec2 rotTangentVector = a_tangentVector;
+            if(u_vectorRotRad != 0.) {
+              float cR = cos(u_vectorRotRad);
+              float sR = sin(u_vectorRotRad);
+              mat2 rotMat = mat2(cR, sR, -sR, cR);
+              rotTangentVector = rotMat * rotTangentVector;
+            }
+            vec3 worldVector = rotTangentVector.x * a_basisVectorX + rotTangentVector.y * a_basisVectorY;
+
+            // Build an orthogonal basis
+            vec4 tailViewH = u_modelView * vec4(a_position, 1.0);
+            vec3 tailViewVal = tailViewH.xyz / tailViewH.w;
+            vec3 vecViewVal = (u_modelView * vec4(worldVector, 0.0)).xyz;
+            vec3 tipViewVal = tailViewVal + vecViewVal * u_lengthMult;
+            vec3 vecDir = normalize(vecViewVal);
+            vec3 basisX; vec3 basisY; buildTangentBasis(vecDir, basisX, basisY);
+
+            // Place this corner of the bounding box around the arrow, the fragment shader raycasts the actual shape
+            vec3 cornerView = mix(tailViewVal, tipViewVal, a_boxCorner.z) + 
+                              u_radius * (a_boxCorner.x * basisX + a_boxCorner.y * basisY);
+            gl_Position = u_projMatrix * vec4(cornerView, 1.0);
+            tailView = tailViewVal;
+            tipView = tipViewVal;
+            
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
 const ShaderStageSpecification FLEX_VECTOR_FRAG_SHADER = {
     
     ShaderStageType::Fragment,
@@ -264,6 +427,7 @@ R"(
 
            // Set depth (expensive!)
            gl_FragDepth = depth;
+           ${ DEPTH_PREPASS_EXIT }$
           
            // Shading
            ${ GENERATE_SHADE_VALUE }$
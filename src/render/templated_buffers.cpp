@@ -354,6 +354,21 @@ std::shared_ptr<TextureBuffer> generateTextureBuffer(DeviceBufferType D, Engine*
   return nullptr;
 }
 
+std::shared_ptr<TextureBuffer> generateTextureBuffer(DeviceBufferType D, TextureFormat format, Engine* engine) {
+  switch (D) {
+  case DeviceBufferType::Attribute:
+    exception("bad call");
+    break;
+  case DeviceBufferType::Texture1d:
+    return engine->generateTextureBuffer(format, 0, (float*)nullptr);
+  case DeviceBufferType::Texture2d:
+    return engine->generateTextureBuffer(format, 0, 0, (float*)nullptr);
+  case DeviceBufferType::Texture3d:
+    return engine->generateTextureBuffer(format, 0, 0, 0, (float*)nullptr);
+  }
+  return nullptr;
+}
+
 // instantiations for the above function
 // clang-format off
 template std::shared_ptr<TextureBuffer> generateTextureBuffer<float     >(DeviceBufferType D, Engine* engine);
@@ -376,5 +391,28 @@ template std::shared_ptr<TextureBuffer> generateTextureBuffer<std::array<glm::ve
 // clang-format on
 
 
+// == Read back texture data
+
+template <>
+std::vector<float> getTextureBufferData<float>(TextureBuffer& buff) {
+  return buff.getDataScalar();
+}
+
+template <>
+std::vector<double> getTextureBufferData<double>(TextureBuffer& buff) {
+  std::vector<float> floatValues = buff.getDataScalar();
+  return std::vector<double>(floatValues.begin(), floatValues.end());
+}
+
+template <>
+std::vector<glm::vec2> getTextureBufferData<glm::vec2>(TextureBuffer& buff) {
+  return buff.getDataVector2();
+}
+
+template <>
+std::vector<glm::vec4> getTextureBufferData<glm::vec4>(TextureBuffer& buff) {
+  return buff.getDataVector4();
+}
+
 } // namespace render
 } // namespace polyscope
@@ -6,8 +6,18 @@
 
 #include "imgui.h"
 
+#include <algorithm>
+#include <map>
+
 namespace polyscope {
 
+namespace {
+// All render images, for compositing
+std::vector<WeakHandle<RenderImageQuantityBase>> existingRenderImages;
+
+// Limited by texture units: three textures per layer, plus the colormap and material textures
+const size_t maxCompositeLayers = 3;
+} // namespace
 
 RenderImageQuantityBase::RenderImageQuantityBase(Structure& parent_, std::string name, size_t dimX_, size_t dimY_,
                                                  const std::vector<float>& depthData_,
@@ -21,6 +31,7 @@ RenderImageQuantityBase::RenderImageQuantityBase(Structure& parent_, std::string
   if (hasNormals) {
     normals.setTextureSize(dimX, dimY);
   }
+  existingRenderImages.emplace_back(this->getWeakHandle<RenderImageQuantityBase>(this));
 }
 
 size_t RenderImageQuantityBase::nPix() { return dimX * dimY; }
@@ -64,7 +75,41 @@ void RenderImageQuantityBase::updateBaseBuffers(const std::vector<float>& newDep
   requestRedraw();
 }
 
-void RenderImageQuantityBase::refresh() { Quantity::refresh(); }
+void RenderImageQuantityBase::setExternalDepthTexture(uint32_t glTextureName, TextureFormat format) {
+  depths.setExternalRenderTexture(render::engine->wrapExternalTexture(format, dimX, dimY, glTextureName));
+  refresh(); // programs hold the old texture
+}
+
+void RenderImageQuantityBase::setExternalNormalTexture(uint32_t glTextureName, TextureFormat format) {
+  if (!hasNormals) {
+    exception("render image " + name + " was created without normals, cannot set a normal texture");
+  }
+  normals.setExternalRenderTexture(render::engine->wrapExternalTexture(format, dimX, dimY, glTextureName));
+  refresh();
+}
+
+void RenderImageQuantityBase::updateDepthsFromDeviceBuffer(uint32_t glBufferName) {
+  depths.setTextureDataFromDeviceBuffer(glBufferName, 1, PixelComponentType::Float32);
+}
+
+void RenderImageQuantityBase::updateNormalsFromDeviceBuffer(uint32_t glBufferName) {
+  if (!hasNormals) {
+    exception("render image " + name + " was created without normals, cannot update them");
+  }
+  normals.setTextureDataFromDeviceBuffer(glBufferName, 3, PixelComponentType::Float32);
+}
+
+void RenderImageQuantityBase::markDeviceDataUpdated() {
+  // only the textures on the device can have been written to
+  if (depths.isDeviceResident()) depths.markRenderTextureBufferUpdated();
+  if (hasNormals && normals.isDeviceResident()) normals.markRenderTextureBufferUpdated();
+  requestRedraw();
+}
+
+void RenderImageQuantityBase::refresh() {
+  compositeProgram = nullptr;
+  Quantity::refresh();
+}
 
 void RenderImageQuantityBase::disableFullscreenDrawing() {
   if (isEnabled()) {
@@ -72,6 +117,57 @@ void RenderImageQuantityBase::disableFullscreenDrawing() {
   }
 }
 
+bool RenderImageQuantityBase::getCompositeLayer(RenderImageCompositeLayer& layer) { return false; }
+
+bool RenderImageQuantityBase::getBaseCompositeLayer(RenderImageCompositeLayer& layer) {
+  // a transparent image blends with whatever is behind it, including the other layers
+  if (transparency.get() < 1.) return false;
+
+  layer.depth = depths.getRenderTextureBuffer().get();
+  layer.normal = hasNormals ? normals.getRenderTextureBuffer().get() : nullptr;
+  layer.flipY = imageOrigin == ImageOrigin::UpperLeft;
+  return true;
+}
+
+void RenderImageQuantityBase::drawComposite(const std::vector<RenderImageCompositeLayer>& layers) {
+
+  if (!compositeProgram) {
+    compositeProgram = render::engine->requestShader("TEXTURE_DRAW_RENDERIMAGE_COMPOSITE",
+                                                     render::engine->addMaterialRules(material.get(), {}),
+                                                     render::ShaderReplacementDefaults::Process);
+    compositeProgram->setAttribute("a_position", render::engine->screenTrianglesCoords());
+    compositeProgram->setTextureFromColormap("t_colormap", "viridis"); // the atlas, each layer has its row
+    render::engine->setMaterial(*compositeProgram, material.get());
+  }
+  render::ShaderProgram& p = *compositeProgram;
+
+  glm::mat4 P = view::getCameraPerspectiveMatrix();
+  glm::mat4 Pinv = glm::inverse(P);
+  p.setUniform("u_projMatrix", glm::value_ptr(P));
+  p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
+  p.setUniform("u_viewport", render::engine->getCurrentViewport());
+  p.setUniform("u_layerCount", static_cast<int>(layers.size()));
+
+  // unused layers repeat the first one, so that every texture is bound
+  for (size_t iLayer = 0; iLayer < maxCompositeLayers; iLayer++) {
+    const RenderImageCompositeLayer& layer = iLayer < layers.size() ? layers[iLayer] : layers.front();
+    std::string s = std::to_string(iLayer);
+    p.setTextureFromBuffer("t_depth" + s, layer.depth);
+    p.setTextureFromBuffer("t_normal" + s, layer.normal ? layer.normal : layer.depth);
+    p.setTextureFromBuffer("t_color" + s, layer.color ? layer.color : layer.depth);
+    p.setUniform("u_layerFlipY" + s, static_cast<int>(layer.flipY));
+    p.setUniform("u_layerHasNormal" + s, static_cast<int>(layer.normal != nullptr));
+    p.setUniform("u_layerColorMode" + s, static_cast<int>(layer.colorMode));
+    p.setUniform("u_layerBaseColor" + s, layer.baseColor);
+    p.setUniform("u_layerRangeLow" + s, layer.rangeLow);
+    p.setUniform("u_layerRangeHigh" + s, layer.rangeHigh);
+    p.setUniform("u_layerColormapRow" + s, layer.colormapRow);
+  }
+  render::engine->setMaterialUniforms(p, material.get());
+
+  p.draw();
+}
+
 RenderImageQuantityBase* RenderImageQuantityBase::setEnabled(bool newEnabled) {
   if (newEnabled == isEnabled()) return this;
   if (newEnabled == true && !allowFullscreenCompositing.get()) {
@@ -79,6 +175,7 @@ RenderImageQuantityBase* RenderImageQuantityBase::setEnabled(bool newEnabled) {
     disableAllFullscreenArtists();
   }
   enabled = newEnabled;
+  parent.markEnabledQuantitiesStale();
   requestRedraw();
   return this;
 }
@@ -113,5 +210,45 @@ RenderImageQuantityBase* RenderImageQuantityBase::setAllowFullscreenCompositing(
 
 bool RenderImageQuantityBase::getAllowFullscreenCompositing() { return allowFullscreenCompositing.get(); }
 
+void drawCompositedRenderImages() {
+
+  // "erase-remove idiom", as in disableAllFullscreenArtists()
+  existingRenderImages.erase(
+      std::remove_if(existingRenderImages.begin(), existingRenderImages.end(),
+                     [](const WeakHandle<RenderImageQuantityBase>& entry) -> bool { return !entry.isValid(); }),
+      existingRenderImages.end());
+
+  // Gather the images which can be composited, grouped by material since each pass is lit with one
+  std::map<std::string, std::vector<RenderImageQuantityBase*>> imagesByMaterial;
+  std::map<std::string, std::vector<RenderImageCompositeLayer>> layersByMaterial;
+  for (WeakHandle<RenderImageQuantityBase>& handle : existingRenderImages) {
+    RenderImageQuantityBase& im = handle.get();
+    im.drawnComposited = false;
+    if (!options::compositeRenderImages) continue;
+    if (!im.isEnabled() || !im.parent.isEnabled() || !im.parent.isInViewFrustum()) continue;
+
+    RenderImageCompositeLayer layer;
+    if (!im.getCompositeLayer(layer)) continue;
+    imagesByMaterial[im.getMaterial()].push_back(&im);
+    layersByMaterial[im.getMaterial()].push_back(layer);
+  }
+
+  for (auto& entry : imagesByMaterial) {
+    std::vector<RenderImageQuantityBase*>& images = entry.second;
+    std::vector<RenderImageCompositeLayer>& layers = layersByMaterial[entry.first];
+
+    for (size_t iStart = 0; iStart < images.size(); iStart += maxCompositeLayers) {
+      size_t iEnd = std::min(iStart + maxCompositeLayers, images.size());
+      if (iEnd - iStart < 2) continue; // a lone image just draws itself
+
+      std::vector<RenderImageCompositeLayer> passLayers(layers.begin() + iStart, layers.begin() + iEnd);
+      images[iStart]->drawComposite(passLayers);
+      for (size_t i = iStart; i < iEnd; i++) {
+        images[i]->drawnComposited = true;
+      }
+    }
+  }
+}
+
 
 } // namespace polyscope
@@ -44,57 +44,57 @@ void ScalarImageQuantity::prepareIntermediateRender() {
   framebufferIntermediate->setViewport(0, 0, dimX, dimY);
 }
 
-void ScalarImageQuantity::prepareFullscreen() {
+void ScalarImageQuantity::prepare() {
 
   // Create the sourceProgram
-  fullscreenProgram = render::engine->requestShader(
-      "SCALAR_TEXTURE_COLORMAP",
-      this->addScalarRules({getImageOriginRule(imageOrigin), "TEXTURE_SET_TRANSPARENCY", "TEXTURE_PREMULTIPLY_OUT"}),
-      render::ShaderReplacementDefaults::Process);
-  fullscreenProgram->setAttribute("a_position", render::engine->screenTrianglesCoords());
-  fullscreenProgram->setTextureFromBuffer("t_scalar", values.getRenderTextureBuffer().get());
-  fullscreenProgram->setTextureFromColormap("t_colormap", this->cMap.get());
-}
-
-void ScalarImageQuantity::prepareBillboard() {
-
-  // Create the sourceProgram
-  billboardProgram = render::engine->requestShader(
+  program = render::engine->requestShader(
       "SCALAR_TEXTURE_COLORMAP",
       this->addScalarRules({getImageOriginRule(imageOrigin), "TEXTURE_SET_TRANSPARENCY", "TEXTURE_PREMULTIPLY_OUT",
                             "TEXTURE_BILLBOARD_FROM_UNIFORMS"}),
       render::ShaderReplacementDefaults::Process);
-  billboardProgram->setAttribute("a_position", render::engine->screenTrianglesCoords());
-  billboardProgram->setTextureFromBuffer("t_scalar", values.getRenderTextureBuffer().get());
-  billboardProgram->setTextureFromColormap("t_colormap", this->cMap.get());
+  program->setAttribute("a_position", render::engine->screenTrianglesCoords());
+  program->setTextureFromBuffer("t_scalar", values.getRenderTextureBuffer().get());
+  program->setTextureFromColormap("t_colormap", this->cMap.get());
+}
+
+void ScalarImageQuantity::setFullscreenUniforms() {
+  // the billboard which covers clip space
+  glm::mat4 identity(1.);
+  program->setUniform("u_modelView", glm::value_ptr(identity));
+  program->setUniform("u_projMatrix", glm::value_ptr(identity));
+  program->setUniform("u_billboardCenter", glm::vec3{0., 0., 0.});
+  program->setUniform("u_billboardUp", glm::vec3{0., 1., 0.});
+  program->setUniform("u_billboardRight", glm::vec3{1., 0., 0.});
 }
 
 void ScalarImageQuantity::showFullscreen() {
 
-  if (!fullscreenProgram) {
-    prepareFullscreen();
+  if (!program) {
+    prepare();
   }
 
   // Set uniforms
-  this->setScalarUniforms(*fullscreenProgram);
-  fullscreenProgram->setUniform("u_transparency", getTransparency());
+  setFullscreenUniforms();
+  this->setScalarUniforms(*program);
+  program->setUniform("u_transparency", getTransparency());
 
-  fullscreenProgram->draw();
+  program->draw();
 
   render::engine->applyTransparencySettings();
 }
 
 void ScalarImageQuantity::renderIntermediate() {
-  if (!fullscreenProgram) prepareFullscreen();
+  if (!program) prepare();
   if (!textureIntermediateRendered) prepareIntermediateRender();
 
   // Set uniforms
-  this->setScalarUniforms(*fullscreenProgram);
-  fullscreenProgram->setUniform("u_transparency", getTransparency());
+  setFullscreenUniforms();
+  this->setScalarUniforms(*program);
+  program->setUniform("u_transparency", getTransparency());
 
   // render to the intermediate texture
   render::engine->pushBindFramebufferForRendering(*framebufferIntermediate);
-  fullscreenProgram->draw();
+  program->draw();
   render::engine->popBindFramebufferForRendering();
   render::engine->applyTransparencySettings();
 }
@@ -122,34 +122,44 @@ void ScalarImageQuantity::showInImGuiWindow() {
 
 void ScalarImageQuantity::showInBillboard(glm::vec3 center, glm::vec3 upVec, glm::vec3 rightVec) {
 
-  if (!billboardProgram) {
-    prepareBillboard();
+  if (!program) {
+    prepare();
   }
 
   // ensure the scale of rightVec matches the aspect ratio of the image
   rightVec = glm::normalize(rightVec) * glm::length(upVec) * ((float)dimX / dimY);
 
   // set uniforms
-  parent.setStructureUniforms(*billboardProgram);
-  billboardProgram->setUniform("u_transparency", getTransparency());
-  billboardProgram->setUniform("u_billboardCenter", center);
-  billboardProgram->setUniform("u_billboardUp", upVec);
-  billboardProgram->setUniform("u_billboardRight", rightVec);
-  this->setScalarUniforms(*billboardProgram);
+  parent.setStructureUniforms(*program);
+  program->setUniform("u_transparency", getTransparency());
+  program->setUniform("u_billboardCenter", center);
+  program->setUniform("u_billboardUp", upVec);
+  program->setUniform("u_billboardRight", rightVec);
+  this->setScalarUniforms(*program);
 
   render::engine->setBackfaceCull(false);
-  billboardProgram->draw();
+  program->draw();
   render::engine->setBackfaceCull(); // return to default setting
 }
 
 void ScalarImageQuantity::refresh() {
-  fullscreenProgram.reset();
-  billboardProgram.reset();
+  program.reset();
   Quantity::refresh();
 }
 
 std::string ScalarImageQuantity::niceName() { return name + " (scalar image)"; }
 
+void ScalarImageQuantity::updatePixels(const void* pixels, PixelComponentType componentType) {
+  updatePixelsRect(pixels, componentType, 0, 0, dimX, dimY);
+}
+
+void ScalarImageQuantity::updatePixelsRect(const void* pixels, PixelComponentType componentType, size_t x, size_t y,
+                                           size_t w, size_t h) {
+  checkPixelRect(x, y, w, h);
+  values.setUpdateFrequency(BufferUpdateFrequency::Streaming);
+  values.setTextureDataRect(pixels, 1, componentType, x, y, w, h);
+}
+
 ScalarImageQuantity* ScalarImageQuantity::setEnabled(bool newEnabled) {
   if (newEnabled == isEnabled()) return this;
   if (newEnabled == true && getShowFullscreen()) {
@@ -157,6 +167,7 @@ ScalarImageQuantity* ScalarImageQuantity::setEnabled(bool newEnabled) {
     disableAllFullscreenArtists();
   }
   enabled = newEnabled;
+  parent.markEnabledQuantitiesStale();
   requestRedraw();
   return this;
 }
@@ -170,4 +181,44 @@ ScalarImageQuantity* createScalarImageQuantity(Structure& parent, std::string na
   return new ScalarImageQuantity(parent, name, dimX, dimY, data, imageOrigin, dataType);
 }
 
+ScalarImageQuantity* createScalarImageQuantityFromPixels(Structure& parent, std::string name, size_t dimX,
+                                                         size_t dimY, const void* pixels,
+                                                         PixelComponentType componentType, ImageOrigin imageOrigin,
+                                                         DataType dataType) {
+
+  // the data range and histogram are computed from a transient float copy, which is released once the pixels are on
+  // the device
+  size_t nPixels = dimX * dimY;
+  std::vector<float> valuesFloat(nPixels);
+  switch (componentType) {
+  case PixelComponentType::Float32:
+    std::copy(static_cast<const float*>(pixels), static_cast<const float*>(pixels) + nPixels, valuesFloat.begin());
+    break;
+  case PixelComponentType::UNorm8: {
+    const uint8_t* src = static_cast<const uint8_t*>(pixels);
+    for (size_t i = 0; i < nPixels; i++) valuesFloat[i] = src[i] / 255.f;
+    break;
+  }
+  case PixelComponentType::UNorm16: {
+    const uint16_t* src = static_cast<const uint16_t*>(pixels);
+    for (size_t i = 0; i < nPixels; i++) valuesFloat[i] = src[i] / 65535.f;
+    break;
+  }
+  }
+
+  ScalarImageQuantity* q = new ScalarImageQuantity(parent, name, dimX, dimY, valuesFloat, imageOrigin, dataType);
+  switch (componentType) {
+  case PixelComponentType::Float32:
+    break;
+  case PixelComponentType::UNorm8:
+    q->values.setTextureStorageFormat(TextureFormat::R8);
+    break;
+  case PixelComponentType::UNorm16:
+    q->values.setTextureStorageFormat(TextureFormat::R16);
+    break;
+  }
+  q->values.setTextureDataRect(pixels, 1, componentType, 0, 0, dimX, dimY);
+  return q;
+}
+
 } // namespace polyscope
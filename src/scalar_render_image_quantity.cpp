@@ -23,7 +23,7 @@ ScalarRenderImageQuantity::ScalarRenderImageQuantity(Structure& parent_, std::st
 void ScalarRenderImageQuantity::draw() {}
 
 void ScalarRenderImageQuantity::drawDelayed() {
-  if (!isEnabled()) return;
+  if (!isEnabled() || drawnComposited) return;
 
   if (!program) prepare();
 
@@ -68,15 +68,25 @@ void ScalarRenderImageQuantity::refresh() {
   RenderImageQuantityBase::refresh();
 }
 
+bool ScalarRenderImageQuantity::getCompositeLayer(RenderImageCompositeLayer& layer) {
+  // isolines and keyframes are only in the image's own program
+  if (isolinesEnabled.get() || valueKeyframes) return false;
+  if (!getBaseCompositeLayer(layer)) return false;
+
+  ensureDataRangeComputed();
+  layer.color = values.getRenderTextureBuffer().get();
+  layer.colorMode = RenderImageCompositeLayer::ColorMode::ColorMap;
+  layer.rangeLow = vizRangeMin.get();
+  layer.rangeHigh = vizRangeMax.get();
+  layer.colormapRow = render::engine->getColorMapAtlasRow(cMap.get());
+  return true;
+}
+
 
 void ScalarRenderImageQuantity::prepare() {
 
   // push the color data to the buffer
   values.ensureHostBufferPopulated();
-  std::vector<float> floatData(values.data.size());
-  for (size_t i = 0; i < values.data.size(); i++) {
-    floatData[i] = static_cast<float>(values.data[i]);
-  }
 
   // Create the sourceProgram
   // clang-format off
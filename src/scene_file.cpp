@@ -0,0 +1,457 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/scene_file.h"
+
+#include "polyscope/mapped_file.h"
+#include "polyscope/messages.h"
+#include "polyscope/persistent_value.h"
+#include "polyscope/point_cloud.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/surface_mesh.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace polyscope {
+
+namespace {
+
+// File layout: the magic bytes and version, the number of records, then one record per structure. Each record holds
+// the structure's name, its persistent values, its geometry arrays and its quantities. Arrays are written as their
+// count and element size followed by the raw entries, starting at a multiple of sceneFileAlignment so that they can be
+// used in place from the mapping.
+const char sceneFileMagic[8] = {'P', 'S', 'S', 'C', 'E', 'N', 'E', '\0'};
+const uint32_t sceneFileVersion = 1;
+const size_t sceneFileAlignment = 16;
+
+enum class SceneRecordType : uint32_t { PointCloud = 0, SurfaceMesh };
+enum class SceneQuantityType : uint32_t { Scalar = 0, Color };
+
+// The types held in the persistent value caches, see persistent_value.h
+enum class PersistentValueType : uint32_t {
+  Double = 0,
+  Float,
+  Bool,
+  String,
+  Vec3,
+  Mat4,
+  ScaledDouble,
+  ScaledFloat,
+  StringVector,
+  ParamVizStyle,
+  BackFacePolicy,
+  MeshShadeStyle
+};
+const uint32_t nPersistentValueTypes = 12;
+
+class SceneWriter {
+public:
+  explicit SceneWriter(const std::string& filename_) : filename(filename_), out(filename_, std::ios::binary) {
+    if (!out) exception("could not open scene file " + filename + " for writing");
+  }
+
+  template <typename T>
+  void writePOD(const T& val) {
+    writeBytes(&val, sizeof(T));
+  }
+
+  void writeString(const std::string& str) {
+    writePOD<uint64_t>(str.size());
+    writeBytes(str.data(), str.size());
+  }
+
+  template <typename T>
+  void writeArray(const std::vector<T>& arr) {
+    writePOD<uint64_t>(arr.size());
+    writePOD<uint64_t>(sizeof(T));
+    pad();
+    if (!arr.empty()) writeBytes(arr.data(), arr.size() * sizeof(T));
+  }
+
+  void finish() {
+    out.flush();
+    if (!out) exception("failed writing scene file " + filename);
+  }
+
+private:
+  std::string filename;
+  std::ofstream out;
+  size_t pos = 0;
+
+  void writeBytes(const void* bytes, size_t count) {
+    out.write(static_cast<const char*>(bytes), count);
+    pos += count;
+  }
+
+  void pad() {
+    static const char zeros[sceneFileAlignment] = {};
+    writeBytes(zeros, (sceneFileAlignment - pos % sceneFileAlignment) % sceneFileAlignment);
+  }
+};
+
+class SceneReader {
+public:
+  SceneReader(std::shared_ptr<MappedFile> file_, const std::string& filename_) : file(file_), filename(filename_) {}
+
+  template <typename T>
+  T readPOD() {
+    T val;
+    std::memcpy(&val, take(sizeof(T)), sizeof(T));
+    return val;
+  }
+
+  std::string readString() {
+    uint64_t len = readPOD<uint64_t>();
+    const unsigned char* bytes = take(len);
+    return std::string(reinterpret_cast<const char*>(bytes), len);
+  }
+
+  // Pointer to the entries in the mapping, valid while the mapping is alive
+  template <typename T>
+  const T* readArray(size_t& count) {
+    uint64_t nEntries = readPOD<uint64_t>();
+    uint64_t entryBytes = readPOD<uint64_t>();
+    if (entryBytes != sizeof(T)) fail();
+    take((sceneFileAlignment - pos % sceneFileAlignment) % sceneFileAlignment);
+    if (nEntries > (file->size - pos) / sizeof(T)) fail();
+    count = nEntries;
+    return reinterpret_cast<const T*>(take(nEntries * sizeof(T)));
+  }
+
+  template <typename T>
+  std::vector<T> readArrayCopy() {
+    size_t count;
+    const T* entries = readArray<T>(count);
+    return std::vector<T>(entries, entries + count);
+  }
+
+  void fail() { exception("scene file " + filename + " is truncated or corrupt"); }
+
+private:
+  std::shared_ptr<MappedFile> file;
+  std::string filename;
+  size_t pos = 0;
+
+  const unsigned char* take(size_t count) {
+    if (count > file->size - pos) fail();
+    const unsigned char* bytes = file->data + pos;
+    pos += count;
+    return bytes;
+  }
+};
+
+// == Persistent values
+
+// clang-format off
+void writeValue(SceneWriter& w, double val)               { w.writePOD(val); }
+void writeValue(SceneWriter& w, float val)                { w.writePOD(val); }
+void writeValue(SceneWriter& w, bool val)                 { w.writePOD<uint8_t>(val); }
+void writeValue(SceneWriter& w, const std::string& val)   { w.writeString(val); }
+void writeValue(SceneWriter& w, const glm::vec3& val)     { w.writePOD(val); }
+void writeValue(SceneWriter& w, const glm::mat4& val)     { w.writePOD(val); }
+void writeValue(SceneWriter& w, ParamVizStyle val)        { w.writePOD<int32_t>(static_cast<int32_t>(val)); }
+void writeValue(SceneWriter& w, BackFacePolicy val)       { w.writePOD<int32_t>(static_cast<int32_t>(val)); }
+void writeValue(SceneWriter& w, MeshShadeStyle val)       { w.writePOD<int32_t>(static_cast<int32_t>(val)); }
+
+void readValue(SceneReader& r, double& val)               { val = r.readPOD<double>(); }
+void readValue(SceneReader& r, float& val)                { val = r.readPOD<float>(); }
+void readValue(SceneReader& r, bool& val)                 { val = r.readPOD<uint8_t>() != 0; }
+void readValue(SceneReader& r, std::string& val)          { val = r.readString(); }
+void readValue(SceneReader& r, glm::vec3& val)            { val = r.readPOD<glm::vec3>(); }
+void readValue(SceneReader& r, glm::mat4& val)            { val = r.readPOD<glm::mat4>(); }
+void readValue(SceneReader& r, ParamVizStyle& val)        { val = static_cast<ParamVizStyle>(r.readPOD<int32_t>()); }
+void readValue(SceneReader& r, BackFacePolicy& val)       { val = static_cast<BackFacePolicy>(r.readPOD<int32_t>()); }
+void readValue(SceneReader& r, MeshShadeStyle& val)       { val = static_cast<MeshShadeStyle>(r.readPOD<int32_t>()); }
+// clang-format on
+
+template <typename T>
+void writeValue(SceneWriter& w, ScaledValue<T> val) {
+  w.writePOD<T>(*val.getValuePtr());
+  w.writePOD<uint8_t>(val.isRelative());
+}
+template <typename T>
+void readValue(SceneReader& r, ScaledValue<T>& val) {
+  T v = r.readPOD<T>();
+  val = ScaledValue<T>(v, r.readPOD<uint8_t>() != 0);
+}
+
+void writeValue(SceneWriter& w, const std::vector<std::string>& val) {
+  w.writePOD<uint64_t>(val.size());
+  for (const std::string& s : val) w.writeString(s);
+}
+void readValue(SceneReader& r, std::vector<std::string>& val) {
+  val.resize(r.readPOD<uint64_t>());
+  for (std::string& s : val) s = r.readString();
+}
+
+// Write the cached values of type T whose names start with prefix, i.e. those of a structure and its quantities
+template <typename T>
+void writePersistentValues(SceneWriter& w, PersistentValueType type, const std::string& prefix) {
+  std::vector<std::pair<std::string, T>> entries;
+  detail::getPersistentCacheRef<T>().forEachValue([&](const std::string& name, const T& val) {
+    if (name.compare(0, prefix.size(), prefix) == 0) entries.emplace_back(name, val);
+  });
+  std::sort(entries.begin(), entries.end(),
+            [](const std::pair<std::string, T>& a, const std::pair<std::string, T>& b) { return a.first < b.first; });
+
+  w.writePOD(type);
+  w.writePOD<uint64_t>(entries.size());
+  for (const std::pair<std::string, T>& entry : entries) {
+    w.writeString(entry.first);
+    writeValue(w, entry.second);
+  }
+}
+
+template <typename T>
+void readPersistentValues(SceneReader& r) {
+  uint64_t nEntries = r.readPOD<uint64_t>();
+  for (uint64_t i = 0; i < nEntries; i++) {
+    std::string name = r.readString();
+    T val;
+    readValue(r, val);
+    detail::getPersistentCacheRef<T>().setValue(name, val);
+  }
+}
+
+void writeAllPersistentValues(SceneWriter& w, const std::string& prefix) {
+  w.writePOD(nPersistentValueTypes);
+  writePersistentValues<double>(w, PersistentValueType::Double, prefix);
+  writePersistentValues<float>(w, PersistentValueType::Float, prefix);
+  writePersistentValues<bool>(w, PersistentValueType::Bool, prefix);
+  writePersistentValues<std::string>(w, PersistentValueType::String, prefix);
+  writePersistentValues<glm::vec3>(w, PersistentValueType::Vec3, prefix);
+  writePersistentValues<glm::mat4>(w, PersistentValueType::Mat4, prefix);
+  writePersistentValues<ScaledValue<double>>(w, PersistentValueType::ScaledDouble, prefix);
+  writePersistentValues<ScaledValue<float>>(w, PersistentValueType::ScaledFloat, prefix);
+  writePersistentValues<std::vector<std::string>>(w, PersistentValueType::StringVector, prefix);
+  writePersistentValues<ParamVizStyle>(w, PersistentValueType::ParamVizStyle, prefix);
+  writePersistentValues<BackFacePolicy>(w, PersistentValueType::BackFacePolicy, prefix);
+  writePersistentValues<MeshShadeStyle>(w, PersistentValueType::MeshShadeStyle, prefix);
+}
+
+// Values are written back in to the caches, so the structure picks them up when it is constructed
+void readAllPersistentValues(SceneReader& r) {
+  uint32_t nTypes = r.readPOD<uint32_t>();
+  for (uint32_t iType = 0; iType < nTypes; iType++) {
+    switch (r.readPOD<PersistentValueType>()) {
+    // clang-format off
+    case PersistentValueType::Double:         readPersistentValues<double>(r); break;
+    case PersistentValueType::Float:          readPersistentValues<float>(r); break;
+    case PersistentValueType::Bool:           readPersistentValues<bool>(r); break;
+    case PersistentValueType::String:         readPersistentValues<std::string>(r); break;
+    case PersistentValueType::Vec3:           readPersistentValues<glm::vec3>(r); break;
+    case PersistentValueType::Mat4:           readPersistentValues<glm::mat4>(r); break;
+    case PersistentValueType::ScaledDouble:   readPersistentValues<ScaledValue<double>>(r); break;
+    case PersistentValueType::ScaledFloat:    readPersistentValues<ScaledValue<float>>(r); break;
+    case PersistentValueType::StringVector:   readPersistentValues<std::vector<std::string>>(r); break;
+    case PersistentValueType::ParamVizStyle:  readPersistentValues<ParamVizStyle>(r); break;
+    case PersistentValueType::BackFacePolicy: readPersistentValues<BackFacePolicy>(r); break;
+    case PersistentValueType::MeshShadeStyle: readPersistentValues<MeshShadeStyle>(r); break;
+    // clang-format on
+    default:
+      r.fail();
+    }
+  }
+}
+
+// == Quantities
+
+template <typename S, typename ScalarQ, typename ColorQ>
+void writeQuantities(SceneWriter& w, S& structure) {
+  std::vector<std::pair<SceneQuantityType, typename S::QuantityType*>> written;
+  for (auto& entry : structure.quantities) {
+    typename S::QuantityType* q = entry.second.get();
+    if (dynamic_cast<ScalarQ*>(q)) {
+      written.emplace_back(SceneQuantityType::Scalar, q);
+    } else if (dynamic_cast<ColorQ*>(q)) {
+      written.emplace_back(SceneQuantityType::Color, q);
+    } else {
+      warning("saveScene() skipping quantity " + q->name + " of " + structure.name + ", its type is not supported");
+    }
+  }
+
+  w.writePOD<uint64_t>(written.size());
+  for (const std::pair<SceneQuantityType, typename S::QuantityType*>& entry : written) {
+    w.writePOD(entry.first);
+    w.writeString(entry.second->name);
+    if (entry.first == SceneQuantityType::Scalar) {
+      ScalarQ* q = dynamic_cast<ScalarQ*>(entry.second);
+      w.writePOD<int32_t>(static_cast<int32_t>(q->getDataType()));
+      w.writeArray(q->values.getPopulatedHostBufferRef());
+    } else {
+      ColorQ* q = dynamic_cast<ColorQ*>(entry.second);
+      w.writeArray(q->colors.getPopulatedHostBufferRef());
+    }
+  }
+}
+
+// `addScalarView` and `addColor` add one quantity to the structure from the file
+template <typename QuantityT, typename AddScalarView, typename AddColor>
+void readQuantities(SceneReader& r, const std::shared_ptr<MappedFile>& file, AddScalarView addScalarView,
+                    AddColor addColor) {
+  uint64_t nQuantities = r.readPOD<uint64_t>();
+  for (uint64_t iQ = 0; iQ < nQuantities; iQ++) {
+    SceneQuantityType type = r.readPOD<SceneQuantityType>();
+    std::string name = r.readString();
+    QuantityT* q = nullptr;
+    switch (type) {
+    case SceneQuantityType::Scalar: {
+      DataType dataType = static_cast<DataType>(r.readPOD<int32_t>());
+      size_t count;
+      const float* values = r.readArray<float>(count);
+      q = addScalarView(name, values, count, file, dataType);
+      break;
+    }
+    case SceneQuantityType::Color:
+      q = addColor(name, r.readArrayCopy<glm::vec3>());
+      break;
+    default:
+      r.fail();
+    }
+
+    // the enabled state came from the persistent cache, apply its side effects (e.g. becoming the dominant quantity)
+    if (q->isEnabled()) q->setEnabled(true);
+  }
+}
+
+// == Structures
+
+void writePointCloud(SceneWriter& w, PointCloud& cloud) {
+  w.writePOD(SceneRecordType::PointCloud);
+  w.writeString(cloud.name);
+  writeAllPersistentValues(w, cloud.uniquePrefix());
+  w.writeArray(cloud.points.getPopulatedHostBufferRef());
+  writeQuantities<PointCloud, PointCloudScalarQuantity, PointCloudColorQuantity>(w, cloud);
+}
+
+void readPointCloud(SceneReader& r, const std::shared_ptr<MappedFile>& file) {
+  std::string name = r.readString();
+  removeStructure(PointCloud::structureTypeName, name, false);
+  readAllPersistentValues(r);
+
+  PointCloud* cloud = new PointCloud(name, r.readArrayCopy<glm::vec3>());
+  if (!registerStructure(cloud)) {
+    safeDelete(cloud);
+    r.fail();
+  }
+
+  readQuantities<PointCloudQuantity>(
+      r, file,
+      [&](std::string qName, const float* values, size_t count, std::shared_ptr<void> token, DataType type) {
+        return cloud->addScalarQuantityView(qName, values, count, token, type);
+      },
+      [&](std::string qName, const std::vector<glm::vec3>& colors) { return cloud->addColorQuantity(qName, colors); });
+}
+
+void writeSurfaceMesh(SceneWriter& w, SurfaceMesh& mesh) {
+  w.writePOD(SceneRecordType::SurfaceMesh);
+  w.writeString(mesh.name);
+  writeAllPersistentValues(w, mesh.uniquePrefix());
+  w.writeArray(mesh.vertexPositions.getPopulatedHostBufferRef());
+  w.writeArray(mesh.faceIndsEntries);
+  w.writeArray(mesh.faceIndsStart);
+  writeQuantities<SurfaceMesh, SurfaceVertexScalarQuantity, SurfaceVertexColorQuantity>(w, mesh);
+}
+
+void readSurfaceMesh(SceneReader& r, const std::shared_ptr<MappedFile>& file) {
+  std::string name = r.readString();
+  removeStructure(SurfaceMesh::structureTypeName, name, false);
+  readAllPersistentValues(r);
+
+  std::vector<glm::vec3> vertexPositions = r.readArrayCopy<glm::vec3>();
+  std::vector<uint32_t> faceIndsEntries = r.readArrayCopy<uint32_t>();
+  std::vector<uint32_t> faceIndsStart = r.readArrayCopy<uint32_t>();
+  for (uint32_t iV : faceIndsEntries) {
+    if (iV >= vertexPositions.size()) r.fail();
+  }
+  if (faceIndsStart.empty() || faceIndsStart.back() != faceIndsEntries.size()) r.fail();
+
+  SurfaceMesh* mesh = new SurfaceMesh(name, vertexPositions, faceIndsEntries, faceIndsStart);
+  if (!registerStructure(mesh)) {
+    safeDelete(mesh);
+    r.fail();
+  }
+
+  readQuantities<SurfaceMeshQuantity>(
+      r, file,
+      [&](std::string qName, const float* values, size_t count, std::shared_ptr<void> token, DataType type) {
+        return mesh->addVertexScalarQuantityView(qName, values, count, token, type);
+      },
+      [&](std::string qName, const std::vector<glm::vec3>& colors) {
+        return mesh->addVertexColorQuantity(qName, colors);
+      });
+}
+
+} // namespace
+
+void saveScene(std::string filename) {
+  checkInitialized();
+
+  std::vector<Structure*> structuresToWrite;
+  for (std::pair<const std::string, std::map<std::string, std::unique_ptr<Structure>>>& cat : state::structures) {
+    for (std::pair<const std::string, std::unique_ptr<Structure>>& entry : cat.second) {
+      Structure* s = entry.second.get();
+      if (dynamic_cast<PointCloud*>(s) || dynamic_cast<SurfaceMesh*>(s)) {
+        structuresToWrite.push_back(s);
+      } else {
+        warning("saveScene() skipping structure " + s->name + ", structures of type " + s->typeName() +
+                " are not supported");
+      }
+    }
+  }
+
+  SceneWriter w(filename);
+  w.writePOD(sceneFileMagic);
+  w.writePOD(sceneFileVersion);
+  w.writePOD<uint64_t>(structuresToWrite.size());
+  for (Structure* s : structuresToWrite) {
+    if (PointCloud* cloud = dynamic_cast<PointCloud*>(s)) {
+      writePointCloud(w, *cloud);
+    } else if (SurfaceMesh* mesh = dynamic_cast<SurfaceMesh*>(s)) {
+      writeSurfaceMesh(w, *mesh);
+    }
+  }
+  w.finish();
+}
+
+void loadScene(std::string filename) {
+  checkInitialized();
+
+  std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(filename);
+  SceneReader r(file, filename);
+
+  std::array<char, sizeof(sceneFileMagic)> magic = r.readPOD<std::array<char, sizeof(sceneFileMagic)>>();
+  if (std::memcmp(magic.data(), sceneFileMagic, sizeof(sceneFileMagic)) != 0) {
+    exception("file " + filename + " is not a polyscope scene file");
+  }
+  uint32_t version = r.readPOD<uint32_t>();
+  if (version != sceneFileVersion) {
+    exception("scene file " + filename + " has version " + std::to_string(version) + ", expected " +
+              std::to_string(sceneFileVersion));
+  }
+
+  uint64_t nRecords = r.readPOD<uint64_t>();
+  for (uint64_t iRecord = 0; iRecord < nRecords; iRecord++) {
+    switch (r.readPOD<SceneRecordType>()) {
+    case SceneRecordType::PointCloud:
+      readPointCloud(r, file);
+      break;
+    case SceneRecordType::SurfaceMesh:
+      readSurfaceMesh(r, file);
+      break;
+    default:
+      r.fail();
+    }
+  }
+
+  requestRedraw();
+}
+
+} // namespace polyscope
@@ -0,0 +1,36 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/scratch_buffer.h"
+
+#include <algorithm>
+
+namespace polyscope {
+
+namespace detail {
+
+namespace {
+
+// Constructed by the first pool of a thread to register, so it outlives all of the thread's pools
+std::vector<ScratchPoolBase*>& threadScratchPools() {
+  static thread_local std::vector<ScratchPoolBase*> pools;
+  return pools;
+}
+
+} // namespace
+
+void registerScratchPool(ScratchPoolBase* pool) { threadScratchPools().push_back(pool); }
+
+void unregisterScratchPool(ScratchPoolBase* pool) {
+  std::vector<ScratchPoolBase*>& pools = threadScratchPools();
+  pools.erase(std::remove(pools.begin(), pools.end(), pool), pools.end());
+}
+
+} // namespace detail
+
+void trimScratchBuffers() {
+  for (detail::ScratchPoolBase* pool : detail::threadScratchPools()) {
+    pool->trim();
+  }
+}
+
+} // namespace polyscope
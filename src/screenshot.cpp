@@ -2,11 +2,19 @@
 
 #include "polyscope/screenshot.h"
 
+#include "polyscope/image_encoders.h"
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
+#include "polyscope/trace.h"
 
 #include "stb_image_write.h"
 
 #include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <memory>
 #include <string>
 
 namespace polyscope {
@@ -18,49 +26,159 @@ size_t screenshotInd = 0;
 
 } // namespace state
 
+namespace internal {
+
+// stb keeps its output settings in globals, which the encoding threads read. They are only ever set here, once, so
+// there is no write for those threads to race with.
+void configureImageWriting() {
+  static bool configured = false;
+  if (configured) return;
+
+  // our buffers are from openGL, so they are flipped
+  stbi_flip_vertically_on_write(1);
+  stbi_write_png_compression_level = 0;
+  configured = true;
+}
+
+} // namespace internal
+
 // Helper functions
 namespace {
 
-bool hasExtension(std::string str, std::string ext) {
+// Write an image in the given format, see saveImage()
+void writeImageFile(const std::string& name, unsigned char* buffer, int w, int h, int channels, ImageFormat format) {
+  POLYSCOPE_TRACE_SPAN("writeImageFile", name);
+
+  std::vector<unsigned char> bytes;
+  switch (resolveImageFormat(name, format)) {
+  case ImageFormat::Auto: // resolved above
+  case ImageFormat::FastPNG:
+    bytes = encodeImageFastPNG(buffer, w, h, channels);
+    break;
+  case ImageFormat::PNG:
+    // stb is slow, but compresses much better than the fast encoder
+    stbi_write_png(name.c_str(), w, h, channels, buffer, channels * w);
+    return;
+  case ImageFormat::QOI:
+    bytes = encodeImageQOI(buffer, w, h, channels);
+    break;
+  case ImageFormat::TGA:
+    bytes = encodeImageTGA(buffer, w, h, channels);
+    break;
+  case ImageFormat::PPM:
+    bytes = encodeImagePPM(buffer, w, h, channels);
+    break;
+  case ImageFormat::JPEG:
+    bytes = encodeImageJPEG(buffer, w, h, channels, 100);
+    break;
+  }
 
-  std::transform(str.begin(), str.end(), str.begin(), ::tolower);
-  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  std::ofstream out(name, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  if (!out) {
+    warning("failed to write image " + name);
+  }
+}
 
-  if (str.length() >= ext.length()) {
-    return (0 == str.compare(str.length() - ext.length(), ext.length(), ext));
-  } else {
-    return false;
+void setOpaqueAlpha(std::vector<unsigned char>& buff) {
+  for (size_t i = 3; i < buff.size(); i += 4) {
+    buff[i] = std::numeric_limits<unsigned char>::max();
   }
 }
 
-} // namespace
+// == Asynchronous image writes
+// Images are read back with the display buffer's asynchronous reads, then encoded and written to file on worker
+// threads. Both stages are bounded: once one is full the oldest entry is waited on, so memory use stays bounded however
+// quickly images are requested.
+
+struct PendingImageRead {
+  uint64_t ticket;
+  std::string filename;
+  int width, height;
+  bool transparentBG;
+  ImageFormat format;
+};
+
+const size_t maxPendingImageReads = 3;
+std::deque<PendingImageRead> pendingImageReads;
+std::deque<std::future<void>> pendingImageWrites;
+
+size_t maxPendingImageWrites() { return 2 * std::max(getNumThreads(), static_cast<size_t>(1)); }
+
+void reapFinishedImageWrites() {
+  while (!pendingImageWrites.empty() &&
+         pendingImageWrites.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    pendingImageWrites.front().get();
+    pendingImageWrites.pop_front();
+  }
+}
 
+void startImageWrite(std::shared_ptr<std::vector<unsigned char>> buff, const PendingImageRead& read) {
+  reapFinishedImageWrites();
+  while (pendingImageWrites.size() >= maxPendingImageWrites()) {
+    pendingImageWrites.front().get();
+    pendingImageWrites.pop_front();
+  }
 
-void saveImage(std::string name, unsigned char* buffer, int w, int h, int channels) {
+  internal::configureImageWriting();
+  std::string filename = read.filename;
+  int w = read.width;
+  int h = read.height;
+  bool transparentBG = read.transparentBG;
+  ImageFormat format = read.format;
+  pendingImageWrites.push_back(std::async(std::launch::async, [buff, filename, w, h, transparentBG, format]() {
+    if (!transparentBG) setOpaqueAlpha(*buff);
+    writeImageFile(filename, &(buff->front()), w, h, 4, format);
+  }));
+}
 
-  // our buffers are from openGL, so they are flipped
-  stbi_flip_vertically_on_write(1);
-  stbi_write_png_compression_level = 0;
+// Hand the oldest read over to the writers. Returns false if there is none, or it is not complete and wait is false.
+bool finishOldestImageRead(bool wait) {
+  if (pendingImageReads.empty()) return false;
 
-  // Auto-detect filename
-  if (hasExtension(name, ".png")) {
-    stbi_write_png(name.c_str(), w, h, channels, buffer, channels * w);
-  } else if (hasExtension(name, ".jpg") || hasExtension(name, "jpeg")) {
-    stbi_write_jpg(name.c_str(), w, h, channels, buffer, 100);
-
-    // TGA seems to display different on different machines: our fault or theirs?
-    // Both BMP and TGA need alpha channel stripped? bmp doesn't seem to work even with this
-    /*
-    } else if (hasExtension(name, ".tga")) {
-     stbi_write_tga(name.c_str(), w, h, channels, buffer);
-    } else if (hasExtension(name, ".bmp")) {
-     stbi_write_bmp(name.c_str(), w, h, channels, buffer);
-    */
-
-  } else {
-    // Fall back on png
-    stbi_write_png(name.c_str(), w, h, channels, buffer, channels * w);
+  std::shared_ptr<std::vector<unsigned char>> buff(new std::vector<unsigned char>());
+  bool success = render::engine->displayBufferAlt->pollReadBuffer(pendingImageReads.front().ticket, *buff, wait);
+  if (!success && !wait) return false;
+
+  PendingImageRead read = pendingImageReads.front();
+  pendingImageReads.pop_front();
+  if (!success || buff->empty()) {
+    warning("failed to read back image for " + read.filename);
+    return true;
+  }
+  startImageWrite(buff, read);
+  return true;
+}
+
+// Start reading back the alt display buffer, which should hold a freshly rendered image
+void queueImageRead(const std::string& filename, bool transparentBG) {
+  if (pendingImageReads.size() >= maxPendingImageReads) {
+    finishOldestImageRead(true);
+  }
+  uint64_t ticket = render::engine->displayBufferAlt->requestReadBuffer();
+  pendingImageReads.push_back(
+      PendingImageRead{ticket, filename, view::bufferWidth, view::bufferHeight, transparentBG, options::screenshotFormat});
+}
+
+std::string nextScreenshotName(bool& transparentBG) {
+  char buff[50];
+  snprintf(buff, 50, "screenshot_%06zu%s", state::screenshotInd, options::screenshotExtension.c_str());
+  state::screenshotInd++;
+
+  // not every format can be written with transparency
+  if (!imageFormatHasAlpha(resolveImageFormat(options::screenshotExtension, options::screenshotFormat))) {
+    transparentBG = false;
   }
+
+  return std::string(buff);
+}
+
+} // namespace
+
+
+void saveImage(std::string name, unsigned char* buffer, int w, int h, int channels, ImageFormat format) {
+  internal::configureImageWriting();
+  writeImageFile(name, buffer, w, h, channels, format);
 }
 
 void screenshot(std::string filename, bool transparentBG) {
@@ -77,6 +195,11 @@ void screenshot(std::string filename, bool transparentBG) {
 
   draw(false, false);
 
+  // With TAA, let the still image converge before capturing it
+  while (render::engine->temporalAntiAliasingPending()) {
+    draw(false, false);
+  }
+
   if (requestedAlready) {
     requestRedraw();
   }
@@ -97,26 +220,60 @@ void screenshot(std::string filename, bool transparentBG) {
   }
 
   // Save to file
-  saveImage(filename, &(buff.front()), w, h, 4);
+  saveImage(filename, &(buff.front()), w, h, 4, options::screenshotFormat);
 
   render::engine->useAltDisplayBuffer = false;
   if (transparentBG) render::engine->lightCopy = false;
 }
 
 void screenshot(bool transparentBG) {
+  std::string defaultName = nextScreenshotName(transparentBG);
+  screenshot(defaultName, transparentBG);
+}
 
-  char buff[50];
-  snprintf(buff, 50, "screenshot_%06zu%s", state::screenshotInd, options::screenshotExtension.c_str());
-  std::string defaultName(buff);
+void screenshotAsync(std::string filename, bool transparentBG) {
 
-  // only pngs can be written with transparency
-  if (!hasExtension(options::screenshotExtension, ".png")) {
-    transparentBG = false;
+  render::engine->useAltDisplayBuffer = true;
+  if (transparentBG) render::engine->lightCopy = true; // copy directly in to buffer without blending
+
+  // == Make sure we render first
+  processLazyProperties();
+
+  // save the redraw requested bit and restore it below
+  bool requestedAlready = redrawRequested();
+  requestRedraw();
+
+  draw(false, false);
+
+  if (requestedAlready) {
+    requestRedraw();
   }
 
-  screenshot(defaultName, transparentBG);
+  queueImageRead(filename, transparentBG);
 
-  state::screenshotInd++;
+  render::engine->useAltDisplayBuffer = false;
+  if (transparentBG) render::engine->lightCopy = false;
+}
+
+void screenshotAsync(bool transparentBG) {
+  std::string defaultName = nextScreenshotName(transparentBG);
+  screenshotAsync(defaultName, transparentBG);
+}
+
+void processAsyncScreenshots() {
+  while (finishOldestImageRead(false)) {
+  }
+  reapFinishedImageWrites();
+}
+
+void flushScreenshots() {
+  while (!pendingImageReads.empty()) {
+    finishOldestImageRead(true);
+  }
+  while (!pendingImageWrites.empty()) {
+    pendingImageWrites.front().get();
+    pendingImageWrites.pop_front();
+  }
 }
 
 void resetScreenshotIndex() { state::screenshotInd = 0; }
@@ -136,6 +293,11 @@ std::vector<unsigned char> screenshotToBuffer(bool transparentBG) {
 
   draw(false, false);
 
+  // With TAA, let the still image converge before capturing it
+  while (render::engine->temporalAntiAliasingPending()) {
+    draw(false, false);
+  }
+
   if (requestedAlready) {
     requestRedraw();
   }
@@ -161,4 +323,81 @@ std::vector<unsigned char> screenshotToBuffer(bool transparentBG) {
   return buff;
 }
 
+void renderToExternalTexture(uint32_t glTextureName, int width, int height, bool transparentBG) {
+  if (!isInitialized()) {
+    exception("must initialize Polyscope with polyscope::init() before rendering");
+  }
+  if (width <= 0 || height <= 0) {
+    exception("external texture must have a positive size");
+  }
+
+  render::engine->makeContextCurrent();
+
+  // Keep the framebuffer around the texture, so rendering to the same one every frame does not create one each time
+  std::shared_ptr<render::FrameBuffer>& target = render::engine->externalTargetBuffer;
+  if (!target || render::engine->externalTargetTextureName != glTextureName ||
+      target->getSizeX() != static_cast<unsigned int>(width) ||
+      target->getSizeY() != static_cast<unsigned int>(height)) {
+    std::shared_ptr<render::TextureBuffer> texture =
+        render::engine->wrapExternalTexture(TextureFormat::RGBA8, width, height, glTextureName);
+    target = render::engine->generateFrameBuffer(width, height);
+    target->addColorBuffer(texture);
+    target->setDrawBuffers();
+    render::engine->externalTargetTextureName = glTextureName;
+  }
+
+  processLazyProperties();
+
+  render::engine->useAltDisplayBuffer = true;
+  if (transparentBG) render::engine->lightCopy = true; // copy directly in to buffer without blending
+
+  internal::renderSceneToDisplay(transparentBG ? 0. : 1.);
+  render::engine->displayBufferAlt->blitTo(target.get());
+
+  render::engine->useAltDisplayBuffer = false;
+  if (transparentBG) render::engine->lightCopy = false;
+
+  // the display buffers hold this view now
+  requestRedraw();
+}
+
+void renderBatch(const std::vector<BatchRenderView>& views, bool transparentBG) {
+  if (views.empty()) return;
+
+  CameraParameters initialView = view::getCameraParametersForCurrentView();
+
+  render::engine->useAltDisplayBuffer = true;
+  if (transparentBG) render::engine->lightCopy = true; // copy directly in to buffer without blending
+
+  // Reading back each image overlaps with rendering the next ones, see queueImageRead()
+  for (const BatchRenderView& v : views) {
+    view::setViewToCamera(v.camera);
+    requestRedraw();
+    draw(false, false);
+    queueImageRead(v.filename, transparentBG);
+  }
+  flushScreenshots();
+
+  render::engine->useAltDisplayBuffer = false;
+  if (transparentBG) render::engine->lightCopy = false;
+
+  // the scene buffers hold the last batch view now
+  view::setViewToCamera(initialView);
+  requestRedraw();
+}
+
+void renderBatchShard(const std::vector<BatchRenderView>& views, size_t shardIndex, size_t shardCount,
+                      bool transparentBG) {
+  if (shardIndex >= shardCount) {
+    exception("batch render shard index " + std::to_string(shardIndex) + " is out of range for " +
+              std::to_string(shardCount) + " shards");
+  }
+
+  std::vector<BatchRenderView> shardViews;
+  for (size_t i = shardIndex; i < views.size(); i += shardCount) {
+    shardViews.push_back(views[i]);
+  }
+  renderBatch(shardViews, transparentBG);
+}
+
 } // namespace polyscope
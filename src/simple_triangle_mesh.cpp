@@ -6,6 +6,7 @@
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 
+#include "glm/gtc/matrix_transform.hpp"
 #include "imgui.h"
 
 #include <fstream>
@@ -23,15 +24,18 @@ SimpleTriangleMesh::SimpleTriangleMesh(std::string name, std::vector<glm::vec3>
       QuantityStructure<SimpleTriangleMesh>(name, structureTypeName),
       vertices(this, uniquePrefix() + "vertices", verticesData), 
       faces(this, uniquePrefix() + "faces", facesData), 
+      compactVertices(this, uniquePrefix() + "compactVertices", compactVerticesData, std::bind(&SimpleTriangleMesh::computeCompactVertices, this)),
       verticesData(std::move(vertices_)),
       facesData(std::move(faces_)),
       surfaceColor(uniquePrefix() + "surfaceColor", getNextUniqueColor()),
       material(uniquePrefix() + "material", "clay"),
       backFacePolicy(uniquePrefix() + "backFacePolicy", BackFacePolicy::Different),
-      backFaceColor(uniquePrefix() + "backFaceColor", glm::vec3(1.f - surfaceColor.get().r, 1.f - surfaceColor.get().g, 1.f - surfaceColor.get().b))
+      backFaceColor(uniquePrefix() + "backFaceColor", glm::vec3(1.f - surfaceColor.get().r, 1.f - surfaceColor.get().g, 1.f - surfaceColor.get().b)),
+      compactVertexPositions(uniquePrefix() + "compactVertexPositions", false)
 // clang-format on
 {
   cullWholeElements.setPassive(false);
+  compactVertices.setDeviceStorageFormat(AttributeStorageFormat::SNorm16);
   updateObjectSpaceBounds();
 }
 
@@ -74,6 +78,9 @@ void SimpleTriangleMesh::buildCustomOptionsUI() {
       setBackFacePolicy(BackFacePolicy::Cull);
     ImGui::EndMenu();
   }
+
+  if (ImGui::MenuItem("Compact positions", NULL, compactVertexPositions.get()))
+    setCompactVertexPositions(!compactVertexPositions.get());
 }
 
 void SimpleTriangleMesh::buildPickUI(size_t localPickID) {
@@ -105,11 +112,11 @@ void SimpleTriangleMesh::draw() {
   }
 
   // Draw the quantities
-  for (auto& x : quantities) {
-    x.second->draw();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->draw();
   }
-  for (auto& x : floatingQuantities) {
-    x.second->draw();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->draw();
   }
 }
 
@@ -118,11 +125,11 @@ void SimpleTriangleMesh::drawDelayed() {
     return;
   }
 
-  for (auto& x : quantities) {
-    x.second->drawDelayed();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->drawDelayed();
   }
-  for (auto& x : floatingQuantities) {
-    x.second->drawDelayed();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->drawDelayed();
   }
 }
 
@@ -147,6 +154,14 @@ void SimpleTriangleMesh::drawPick() {
 
 void SimpleTriangleMesh::setSimpleTriangleMeshUniforms(render::ShaderProgram& p, bool withSurfaceShade) {
 
+  if (compactVertexPositions.get()) {
+    // map the normalized positions back to the bounding box (overrides the value from setStructureUniforms())
+    compactVertices.ensureHostBufferPopulated();
+    glm::mat4 M = getModelView() * glm::translate(glm::mat4(1.), compactVertexCenter) *
+                  glm::scale(glm::mat4(1.), compactVertexHalfExtent);
+    p.setUniform("u_modelView", glm::value_ptr(M));
+  }
+
   // for the tri-flat shading
   glm::mat4 P = view::getCameraPerspectiveMatrix();
   glm::mat4 Pinv = glm::inverse(P);
@@ -238,10 +253,59 @@ std::vector<std::string> SimpleTriangleMesh::addSimpleTriangleMeshRules(std::vec
 }
 
 void SimpleTriangleMesh::setSimpleTriangleMeshProgramGeometryAttributes(render::ShaderProgram& p) {
-  p.setAttribute("a_vertexPositions", vertices.getRenderAttributeBuffer());
+  if (compactVertexPositions.get()) {
+    p.setAttribute("a_vertexPositions", compactVertices.getRenderAttributeBuffer());
+  } else {
+    p.setAttribute("a_vertexPositions", vertices.getRenderAttributeBuffer());
+  }
   p.setIndex(faces.getRenderAttributeBuffer());
 }
 
+void SimpleTriangleMesh::computeCompactVertices() {
+  vertices.ensureHostBufferPopulated();
+
+  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (const glm::vec3& p : vertices.data) {
+    min = componentwiseMin(min, p);
+    max = componentwiseMax(max, p);
+  }
+  if (vertices.data.empty()) {
+    min = glm::vec3{0., 0., 0.};
+    max = glm::vec3{0., 0., 0.};
+  }
+
+  compactVertexCenter = 0.5f * (min + max);
+  compactVertexHalfExtent = 0.5f * (max - min);
+  for (int i = 0; i < 3; i++) {
+    if (!(compactVertexHalfExtent[i] > 0.f)) compactVertexHalfExtent[i] = 1.f; // flat along this axis
+  }
+
+  compactVertices.data.resize(vertices.data.size());
+  for (size_t i = 0; i < vertices.data.size(); i++) {
+    compactVertices.data[i] = (vertices.data[i] - compactVertexCenter) / compactVertexHalfExtent;
+  }
+}
+
+SimpleTriangleMeshVertexScalarQuantity*
+SimpleTriangleMesh::addVertexScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type) {
+  checkForQuantityWithNameAndDeleteOrError(name);
+  SimpleTriangleMeshVertexScalarQuantity* q = new SimpleTriangleMeshVertexScalarQuantity(name, data, *this, type);
+  addQuantity(q);
+  return q;
+}
+
+SimpleTriangleMeshVertexColorQuantity*
+SimpleTriangleMesh::addVertexColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors) {
+  checkForQuantityWithNameAndDeleteOrError(name);
+  SimpleTriangleMeshVertexColorQuantity* q = new SimpleTriangleMeshVertexColorQuantity(name, colors, *this);
+  addQuantity(q);
+  return q;
+}
+
+SimpleTriangleMeshQuantity::SimpleTriangleMeshQuantity(std::string name_, SimpleTriangleMesh& mesh_, bool dominates_)
+    : QuantityS<SimpleTriangleMesh>(name_, mesh_, dominates_) {}
+
 
 void SimpleTriangleMesh::refresh() {
   program.reset();
@@ -285,8 +349,9 @@ SimpleTriangleMesh* SimpleTriangleMesh::setSurfaceColor(glm::vec3 val) {
 glm::vec3 SimpleTriangleMesh::getSurfaceColor() { return surfaceColor.get(); }
 
 SimpleTriangleMesh* SimpleTriangleMesh::setMaterial(std::string m) {
+  bool needsRefresh = render::engine->materialChangeNeedsRefresh(material.get(), m);
   material = m;
-  refresh();
+  if (needsRefresh) refresh();
   requestRedraw();
   return this;
 }
@@ -308,5 +373,13 @@ SimpleTriangleMesh* SimpleTriangleMesh::setBackFaceColor(glm::vec3 val) {
 
 glm::vec3 SimpleTriangleMesh::getBackFaceColor() { return backFaceColor.get(); }
 
+SimpleTriangleMesh* SimpleTriangleMesh::setCompactVertexPositions(bool newVal) {
+  compactVertexPositions = newVal;
+  refresh();
+  requestRedraw();
+  return this;
+}
+bool SimpleTriangleMesh::getCompactVertexPositions() { return compactVertexPositions.get(); }
+
 
 } // namespace polyscope
@@ -0,0 +1,63 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/simple_triangle_mesh_color_quantity.h"
+
+#include "polyscope/polyscope.h"
+
+#include "imgui.h"
+
+namespace polyscope {
+
+
+SimpleTriangleMeshVertexColorQuantity::SimpleTriangleMeshVertexColorQuantity(std::string name,
+                                                                             const std::vector<glm::vec3>& values_,
+                                                                             SimpleTriangleMesh& mesh_)
+    : SimpleTriangleMeshQuantity(name, mesh_, true), ColorQuantity(*this, values_) {}
+
+void SimpleTriangleMeshVertexColorQuantity::draw() {
+  if (!isEnabled()) return;
+
+  // Make the program if we don't have one already
+  if (program == nullptr) {
+    createProgram();
+  }
+
+  parent.setStructureUniforms(*program);
+  parent.setSimpleTriangleMeshUniforms(*program);
+  setColorUniforms(*program);
+  render::engine->setMaterialUniforms(*program, parent.getMaterial());
+
+  program->draw();
+}
+
+std::string SimpleTriangleMeshVertexColorQuantity::niceName() { return name + " (vertex color)"; }
+
+void SimpleTriangleMeshVertexColorQuantity::createProgram() {
+
+  // Create the program to draw this quantity
+  // clang-format off
+  program = render::engine->requestShader("SIMPLE_MESH", 
+    render::engine->addMaterialRules(parent.getMaterial(),
+      parent.addSimpleTriangleMeshRules(
+        addColorRules(
+          {"MESH_PROPAGATE_COLOR", "SHADE_COLOR", "COMPUTE_SHADE_NORMAL_FROM_POSITION", "PROJ_AND_INV_PROJ_MAT"}
+        )
+      )
+    )
+  );
+  // clang-format on
+
+  parent.setSimpleTriangleMeshProgramGeometryAttributes(*program);
+  program->setAttribute("a_color", colors.getRenderAttributeBuffer());
+
+  // Fill buffers
+  render::engine->setMaterial(*program, parent.getMaterial());
+}
+
+
+void SimpleTriangleMeshVertexColorQuantity::refresh() {
+  program.reset();
+  Quantity::refresh();
+}
+
+} // namespace polyscope
@@ -0,0 +1,86 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/simple_triangle_mesh_scalar_quantity.h"
+
+#include "polyscope/polyscope.h"
+
+#include "imgui.h"
+
+namespace polyscope {
+
+
+SimpleTriangleMeshVertexScalarQuantity::SimpleTriangleMeshVertexScalarQuantity(std::string name,
+                                                                               const std::vector<float>& values_,
+                                                                               SimpleTriangleMesh& mesh_,
+                                                                               DataType dataType_)
+    : SimpleTriangleMeshQuantity(name, mesh_, true), ScalarQuantity(*this, values_, dataType_) {}
+
+void SimpleTriangleMeshVertexScalarQuantity::draw() {
+  if (!isEnabled()) return;
+
+  // Make the program if we don't have one already
+  if (program == nullptr) {
+    createProgram();
+  }
+
+  // Set uniforms
+  parent.setStructureUniforms(*program);
+  parent.setSimpleTriangleMeshUniforms(*program);
+  setScalarUniforms(*program);
+  render::engine->setMaterialUniforms(*program, parent.getMaterial());
+
+  program->draw();
+}
+
+
+void SimpleTriangleMeshVertexScalarQuantity::buildCustomUI() {
+  ImGui::SameLine();
+
+  // == Options popup
+  if (ImGui::Button("Options")) {
+    ImGui::OpenPopup("OptionsPopup");
+  }
+  if (ImGui::BeginPopup("OptionsPopup")) {
+
+    buildScalarOptionsUI();
+
+    ImGui::EndPopup();
+  }
+
+  buildScalarUI();
+}
+
+
+void SimpleTriangleMeshVertexScalarQuantity::createProgram() {
+
+  // Create the program to draw this quantity
+  // clang-format off
+  program = render::engine->requestShader("SIMPLE_MESH", 
+    render::engine->addMaterialRules(parent.getMaterial(),
+      parent.addSimpleTriangleMeshRules(
+        addScalarRules(
+          {"MESH_PROPAGATE_VALUE", "COMPUTE_SHADE_NORMAL_FROM_POSITION", "PROJ_AND_INV_PROJ_MAT"}
+        )
+      )
+    )
+  );
+  // clang-format on
+
+  parent.setSimpleTriangleMeshProgramGeometryAttributes(*program);
+  program->setAttribute("a_value", values.getRenderAttributeBuffer());
+
+  // Fill buffers
+  program->setTextureFromColormap("t_colormap", cMap.get());
+  render::engine->setMaterial(*program, parent.getMaterial());
+}
+
+
+void SimpleTriangleMeshVertexScalarQuantity::refresh() {
+  program.reset();
+  Quantity::refresh();
+}
+
+
+std::string SimpleTriangleMeshVertexScalarQuantity::niceName() { return name + " (vertex scalar)"; }
+
+} // namespace polyscope
@@ -7,14 +7,24 @@
 
 namespace polyscope {
 
-// NOTE: Unfortunately, the logic here and in the engine depends on the names constructed from the postfix being
-// identical.
+// NOTE: The uniform names constructed from the postfix here must match those declared by the SLICE_PLANE_CULL rule, so
+// the postfix is the index of the plane.
 
 // Storage for global options
 bool openSlicePlaneMenu = false;
 
+namespace {
+
+// A plane which no position is behind, for the slice plane uniforms of planes which are unused or disabled
+glm::vec4 slicePlanePassUniform() { return glm::vec4{-1., 0., 0., -std::numeric_limits<float>::infinity()}; }
+
+} // namespace
+
 SlicePlane* addSceneSlicePlane(bool initiallyVisible) {
   size_t nPlanes = state::slicePlanes.size();
+  if (nPlanes >= static_cast<size_t>(render::maxSlicePlanes)) {
+    exception("at most " + std::to_string(render::maxSlicePlanes) + " slice planes are supported");
+  }
   std::string newName = "Scene Slice Plane " + std::to_string(nPlanes);
   state::slicePlanes.emplace_back(std::unique_ptr<SlicePlane>(new SlicePlane(newName)));
   nPlanes++;
@@ -46,7 +56,7 @@ void buildSlicePlaneGUI() {
     openSlicePlaneMenu = false;
   }
   if (ImGui::TreeNode("Slice Planes")) {
-    if (ImGui::Button("Add plane")) {
+    if (ImGui::Button("Add plane") && state::slicePlanes.size() < static_cast<size_t>(render::maxSlicePlanes)) {
       addSceneSlicePlane(true);
     }
     ImGui::SameLine();
@@ -75,7 +85,7 @@ SlicePlane::SlicePlane(std::string name_)
                       {nullptr, uniquePrefix() + "#slice4", sliceBufferDataArr[3]}}}
 
 {
-  render::engine->addSlicePlane(postfix);
+  render::engine->addSlicePlane();
   transformGizmo.enabled = true;
   prepare();
 }
@@ -83,7 +93,7 @@ SlicePlane::SlicePlane(std::string name_)
 SlicePlane::~SlicePlane() {
   ensureVolumeInspectValid();
   setVolumeMeshToInspect(""); // disable any slicing
-  render::engine->removeSlicePlane(postfix);
+  render::engine->removeSlicePlane();
 }
 
 std::string SlicePlane::uniquePrefix() { return "SlicePlane#" + name + "#"; }
@@ -226,7 +236,7 @@ void SlicePlane::drawGeometry() {
       vMesh->setVolumeMeshUniforms(*volumeInspectProgram);
       volumeInspectProgram->setUniform("u_baseColor1", vMesh->getColor());
       render::engine->setMaterialUniforms(*volumeInspectProgram, vMesh->getMaterial());
-      volumeInspectProgram->draw();
+      vMesh->drawSliceProgram(*volumeInspectProgram, this);
     }
 
     for (auto it = vMesh->quantities.begin(); it != vMesh->quantities.end(); it++) {
@@ -329,23 +339,29 @@ void SlicePlane::buildGUI() {
 }
 
 void SlicePlane::setSceneObjectUniforms(render::ShaderProgram& p, bool alwaysPass) {
-  if (!p.hasUniform("u_slicePlaneNormal_" + postfix)) {
+  std::string planeUniformName = "u_slicePlane_" + postfix;
+  if (!p.hasUniform(planeUniformName)) {
     return;
   }
 
-  glm::vec3 normal, center;
-
-  if (alwaysPass) {
-    normal = glm::vec3{-1., 0., 0.};
-    center = glm::vec3{std::numeric_limits<float>::infinity(), 0., 0.};
-  } else {
-    glm::mat4 viewMat = view::getCameraViewMatrix();
-    normal = glm::vec3(viewMat * glm::vec4(getNormal(), 0.));
-    center = glm::vec3(viewMat * glm::vec4(getCenter(), 1.));
+  if (alwaysPass || !active.get()) {
+    p.setUniform(planeUniformName, slicePlanePassUniform());
+    return;
   }
 
-  p.setUniform("u_slicePlaneNormal_" + postfix, normal);
-  p.setUniform("u_slicePlaneCenter_" + postfix, center);
+  glm::mat4 viewMat = view::getCameraViewMatrix();
+  glm::vec3 normal = glm::vec3(viewMat * glm::vec4(getNormal(), 0.));
+  glm::vec3 center = glm::vec3(viewMat * glm::vec4(getCenter(), 1.));
+  p.setUniform(planeUniformName, glm::vec4(normal, glm::dot(center, normal)));
+}
+
+void setUnusedSlicePlaneUniforms(render::ShaderProgram& p) {
+  // planes are only ever removed from the back, so their postfixes are the indices in state::slicePlanes
+  for (int i = static_cast<int>(state::slicePlanes.size()); i < render::maxSlicePlanes; i++) {
+    std::string planeUniformName = "u_slicePlane_" + std::to_string(i);
+    if (!p.hasUniform(planeUniformName)) return;
+    p.setUniform(planeUniformName, slicePlanePassUniform());
+  }
 }
 
 glm::vec3 SlicePlane::getCenter() {
@@ -2,23 +2,37 @@
 
 #include "polyscope/structure.h"
 
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
+#include "polyscope/utilities.h"
 
 #include "imgui.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
 namespace polyscope {
 
 Structure::Structure(std::string name_, std::string subtypeName)
     : name(name_), enabled(subtypeName + "#" + name + "#enabled", true),
       objectTransform(subtypeName + "#" + name + "#object_transform", glm::mat4(1.0)),
       transparency(subtypeName + "#" + name + "#transparency", 1.0),
-      transformGizmo(subtypeName + "#" + name + "#transform_gizmo", objectTransform.get(), &objectTransform),
       cullWholeElements(subtypeName + "#" + name + "#cullWholeElements", false),
       ignoredSlicePlaneNames(subtypeName + "#" + name + "#ignored_slice_planes", {}),
       objectSpaceBoundingBox(
           std::tuple<glm::vec3, glm::vec3>{glm::vec3{-777, -777, -777}, glm::vec3{-777, -777, -777}}),
       objectSpaceLengthScale(-777) {
   validateName(name);
+
+  // only create the gizmo up front if it was left showing, e.g. by a structure of the same name which was replaced
+  // (typeName() cannot be called yet, but it is the subtype name, see uniquePrefix())
+  std::string gizmoName = subtypeName + "#" + name + "#transform_gizmo";
+  const bool* gizmoShown = detail::getPersistentCacheRef<bool>().findValue(gizmoName + "#name");
+  if (gizmoShown != nullptr && *gizmoShown) {
+    transformGizmo.reset(new TransformationGizmo(gizmoName, objectTransform.get(), &objectTransform));
+  }
 }
 
 Structure::~Structure(){};
@@ -26,6 +40,7 @@ Structure::~Structure(){};
 Structure* Structure::setEnabled(bool newEnabled) {
   if (newEnabled == isEnabled()) return this;
   enabled = newEnabled;
+  internal::invalidateStructureDrawList();
   requestRedraw();
   return this;
 };
@@ -72,8 +87,8 @@ void Structure::buildUI() {
         if (ImGui::MenuItem("Center")) centerBoundingBox();
         if (ImGui::MenuItem("Unit Scale")) rescaleToUnit();
         if (ImGui::MenuItem("Reset")) resetTransform();
-        if (ImGui::MenuItem("Show Gizmo", NULL, &transformGizmo.enabled.get()))
-          transformGizmo.enabled.manuallyChanged();
+        bool showGizmo = getTransformGizmoEnabled();
+        if (ImGui::MenuItem("Show Gizmo", NULL, &showGizmo)) setTransformGizmoEnabled(showGizmo);
         ImGui::EndMenu();
       }
 
@@ -120,6 +135,14 @@ void Structure::buildUI() {
       }
 
 
+      if (nKeyframes() > 0 && ImGui::BeginMenu("Keyframes")) {
+        if (ImGui::SliderFloat("Frames per second", &keyframePlaybackSpeed, 1., 120., "%.1f",
+                               ImGuiSliderFlags_Logarithmic)) {
+          setKeyframePlaybackSpeed(keyframePlaybackSpeed);
+        }
+        ImGui::EndMenu();
+      }
+
       // Selection
       if (ImGui::BeginMenu("Structure Selection")) {
         if (ImGui::MenuItem("Enable all of type")) setEnabledAllOfType(true);
@@ -139,6 +162,10 @@ void Structure::buildUI() {
     // Do any structure-specific stuff here
     this->buildCustomUI();
 
+    if (nKeyframes() > 0) {
+      buildKeyframeUI();
+    }
+
     // Build quantities list, in the common case of a QuantityStructure
     this->buildQuantitiesUI();
 
@@ -148,6 +175,18 @@ void Structure::buildUI() {
 }
 
 
+void Structure::buildKeyframeUI() {
+  ImGui::PushItemWidth(150);
+  if (ImGui::SliderFloat("Keyframe", &keyframeTime, 0., static_cast<float>(nKeyframes() - 1), "%.2f")) {
+    setKeyframeTime(keyframeTime);
+  }
+  ImGui::PopItemWidth();
+  ImGui::SameLine();
+  if (ImGui::Button(getKeyframesPlaying() ? "Pause" : "Play")) {
+    setKeyframesPlaying(!getKeyframesPlaying());
+  }
+}
+
 void Structure::buildQuantitiesUI() {}
 
 void Structure::buildSharedStructureUI() {}
@@ -161,12 +200,26 @@ void Structure::refresh() {
   requestRedraw();
 }
 
+void Structure::refreshShaderPrograms() { refresh(); }
+
+void Structure::markEnabledQuantitiesStale() {}
+
 std::tuple<glm::vec3, glm::vec3> Structure::boundingBox() {
-  const glm::mat4x4& T = objectTransform.get();
-  glm::vec4 lh = T * glm::vec4(std::get<0>(objectSpaceBoundingBox), 1.);
-  glm::vec3 l = glm::vec3(lh) / lh.w;
-  glm::vec4 uh = T * glm::vec4(std::get<1>(objectSpaceBoundingBox), 1.);
-  glm::vec3 u = glm::vec3(uh) / uh.w;
+  // Transform the cached object-space box rather than the data, so this costs the same for any structure size. All
+  // corners are needed to bound the box under rotations.
+  glm::dmat4 T = getModelMatrix();
+  glm::vec3 bMin = std::get<0>(objectSpaceBoundingBox);
+  glm::vec3 bMax = std::get<1>(objectSpaceBoundingBox);
+  if (!isFinite(bMin) || !isFinite(bMax)) return objectSpaceBoundingBox; // empty, nothing to transform
+  glm::vec3 l = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  glm::vec3 u = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (int iC = 0; iC < 8; iC++) {
+    glm::vec3 corner{(iC & 1) ? bMax.x : bMin.x, (iC & 2) ? bMax.y : bMin.y, (iC & 4) ? bMax.z : bMin.z};
+    glm::dvec4 ph = T * glm::dvec4(corner, 1.);
+    glm::vec3 p = glm::vec3(glm::dvec3(ph) / ph.w);
+    l = componentwiseMin(l, p);
+    u = componentwiseMax(u, p);
+  }
   return std::tuple<glm::vec3, glm::vec3>{l, u};
 }
 
@@ -200,6 +253,34 @@ glm::vec3 Structure::getPosition() {
   return glm::vec3{objectTransform.get()[3][0], objectTransform.get()[3][1], objectTransform.get()[3][2]};
 }
 
+void Structure::setPositionOrigin(glm::dvec3 newOrigin) {
+  positionOrigin = newOrigin;
+  updateStructureExtents();
+  requestRedraw();
+}
+
+glm::dvec3 Structure::getPositionOrigin() { return positionOrigin; }
+
+glm::dmat4 Structure::getModelMatrix() {
+  return glm::translate(glm::dmat4(objectTransform.get()), positionOrigin);
+}
+
+void Structure::setTransformGizmoEnabled(bool newVal) {
+  if (!newVal && !transformGizmo) return; // nothing to hide
+  getTransformGizmo().enabled = newVal;
+  requestRedraw();
+}
+
+bool Structure::getTransformGizmoEnabled() { return transformGizmo && transformGizmo->enabled.get(); }
+
+TransformationGizmo& Structure::getTransformGizmo() {
+  if (!transformGizmo) {
+    transformGizmo.reset(
+        new TransformationGizmo(uniquePrefix() + "transform_gizmo", objectTransform.get(), &objectTransform));
+  }
+  return *transformGizmo;
+}
+
 void Structure::resetTransform() {
   objectTransform = glm::mat4(1.0);
   updateStructureExtents();
@@ -223,7 +304,184 @@ void Structure::rescaleToUnit() {
 
 bool Structure::hasExtents() { return true; }
 
-glm::mat4 Structure::getModelView() { return view::getCameraViewMatrix() * objectTransform.get(); }
+bool Structure::isInViewFrustum() {
+  if (!options::frustumCulling || !allowFrustumCulling()) return true;
+  float padding = getDrawBoundsPadding();
+  return objectSpaceBoxInViewFrustum(objectSpaceBoundingBox, padding) &&
+         !objectSpaceBoxSlicedAway(objectSpaceBoundingBox, padding) &&
+         !objectSpaceBoxOccluded(objectSpaceBoundingBox, padding);
+}
+
+bool Structure::isOccluded() {
+  if (!options::frustumCulling || !allowFrustumCulling()) return false;
+  return objectSpaceBoxOccluded(objectSpaceBoundingBox, getDrawBoundsPadding());
+}
+
+bool Structure::allowFrustumCulling() { return hasExtents(); }
+
+bool Structure::drawsSortedTransparency() { return false; }
+
+render::MemoryUsage Structure::getMemoryUsage() {
+  render::MemoryUsage usage = getManagedBufferMemoryUsage();
+  usage.overheadBytes += sizeof(Structure);
+  if (transformGizmo) usage.overheadBytes += sizeof(TransformationGizmo);
+  if (pickBVH) usage.hostBytes += pickBVH->getMemoryBytes();
+  return usage;
+}
+
+double Structure::screenPixelArea() { return objectSpaceBoxPixelArea(objectSpaceBoundingBox); }
+
+double Structure::objectSpaceBoxPixelArea(const std::tuple<glm::vec3, glm::vec3>& box) {
+  glm::vec4 viewport = render::engine->getCurrentViewport();
+  double pixelArea = static_cast<double>(viewport.z) * viewport.w;
+  const glm::vec3& bMin = std::get<0>(box);
+  const glm::vec3& bMax = std::get<1>(box);
+  glm::mat4 viewProj = view::getCameraPerspectiveMatrix() * getModelView();
+  glm::vec2 ndcMin{1., 1.};
+  glm::vec2 ndcMax{-1., -1.};
+  for (int iC = 0; iC < 8; iC++) {
+    glm::vec3 corner{(iC & 1) ? bMax.x : bMin.x, (iC & 2) ? bMax.y : bMin.y, (iC & 4) ? bMax.z : bMin.z};
+    glm::vec4 c = viewProj * glm::vec4(corner, 1.);
+    if (!(c.w > 0.)) return pixelArea;
+    glm::vec2 ndc = glm::clamp(glm::vec2(c) / c.w, -1.f, 1.f);
+    ndcMin = glm::min(ndcMin, ndc);
+    ndcMax = glm::max(ndcMax, ndc);
+  }
+  return pixelArea * 0.25 * std::max(ndcMax.x - ndcMin.x, 0.f) * std::max(ndcMax.y - ndcMin.y, 0.f);
+}
+
+float Structure::getDrawBoundsPadding() { return 0.; }
+
+bool Structure::supportsRayCastPicking() { return false; }
+
+bool Structure::rayCastPick(glm::dvec3 rayStart, glm::vec3 rayDir, float& tHit, size_t& localPickInd) { return false; }
+
+void Structure::ensurePickBVH(size_t nPrims, const std::function<void(std::vector<BVH::Box>&)>& computeBoxes) {
+  if (!pickBVH) pickBVH.reset(new BVH());
+  bool sameTopology = pickBVH->isBuilt() && pickBVH->nPrimitives() == nPrims;
+  if (sameTopology && !pickBVHNeedsRefit) return;
+
+  std::vector<BVH::Box> boxes(nPrims);
+  computeBoxes(boxes);
+  if (sameTopology) {
+    pickBVH->refit(boxes);
+  } else {
+    pickBVH->build(boxes);
+  }
+  pickBVHNeedsRefit = false;
+}
+
+glm::vec3 Structure::worldRayToObjectSpace(glm::dvec3 rayStart, glm::vec3& rayDir) {
+  glm::dmat4 invTransform = glm::inverse(getModelMatrix());
+  rayDir = glm::vec3(invTransform * glm::dvec4(rayDir, 0.));
+  return glm::vec3(invTransform * glm::dvec4(rayStart, 1.));
+}
+
+bool Structure::objectSpaceBoxInViewFrustum(const std::tuple<glm::vec3, glm::vec3>& box, float padding) {
+  const glm::vec3& bMin = std::get<0>(box);
+  const glm::vec3& bMax = std::get<1>(box);
+  for (int i = 0; i < 3; i++) {
+    // empty or invalid bounds, don't try to cull
+    if (!std::isfinite(bMin[i]) || !std::isfinite(bMax[i]) || bMin[i] > bMax[i]) return true;
+  }
+  if (!std::isfinite(padding)) return true;
+
+  auto boxCorner = [](const glm::vec3& low, const glm::vec3& high, int iC) {
+    return glm::vec3{(iC & 1) ? high.x : low.x, (iC & 2) ? high.y : low.y, (iC & 4) ? high.z : low.z};
+  };
+
+  glm::vec3 viewMin, viewMax;
+  objectSpaceBoxToViewSpace(box, padding, viewMin, viewMax);
+
+  // The box is outside if all of its corners are on the outside of the same clip plane. Testing in homogeneous clip
+  // coordinates keeps this correct for corners behind the camera.
+  glm::mat4 projMat = view::getCameraPerspectiveMatrix();
+  int outsideAll = 0x3F;
+  for (int iC = 0; iC < 8; iC++) {
+    glm::vec4 c = projMat * glm::vec4(boxCorner(viewMin, viewMax, iC), 1.);
+    int outside = 0;
+    if (c.x < -c.w) outside |= 0x01;
+    if (c.x > c.w) outside |= 0x02;
+    if (c.y < -c.w) outside |= 0x04;
+    if (c.y > c.w) outside |= 0x08;
+    if (c.z < -c.w) outside |= 0x10;
+    if (c.z > c.w) outside |= 0x20;
+    outsideAll &= outside;
+    if (outsideAll == 0) return true;
+  }
+  return false;
+}
+
+void Structure::objectSpaceBoxToViewSpace(const std::tuple<glm::vec3, glm::vec3>& box, float padding,
+                                          glm::vec3& viewMin, glm::vec3& viewMax) {
+  const glm::vec3& bMin = std::get<0>(box);
+  const glm::vec3& bMax = std::get<1>(box);
+
+  // Bound the box in view space, where the padding is applied (the view matrix is rigid, so world units are preserved)
+  glm::mat4 modelView = getModelView();
+  viewMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  viewMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (int iC = 0; iC < 8; iC++) {
+    glm::vec3 corner{(iC & 1) ? bMax.x : bMin.x, (iC & 2) ? bMax.y : bMin.y, (iC & 4) ? bMax.z : bMin.z};
+    glm::vec4 p = modelView * glm::vec4(corner, 1.);
+    glm::vec3 p3 = glm::vec3(p) / p.w;
+    viewMin = componentwiseMin(viewMin, p3);
+    viewMax = componentwiseMax(viewMax, p3);
+  }
+  viewMin -= glm::vec3{padding, padding, padding};
+  viewMax += glm::vec3{padding, padding, padding};
+}
+
+bool Structure::objectSpaceBoxOccluded(const std::tuple<glm::vec3, glm::vec3>& box, float padding) {
+  if (!options::occlusionCulling) return false;
+  const glm::vec3& bMin = std::get<0>(box);
+  const glm::vec3& bMax = std::get<1>(box);
+  for (int i = 0; i < 3; i++) {
+    // empty or invalid bounds, don't try to cull
+    if (!std::isfinite(bMin[i]) || !std::isfinite(bMax[i]) || bMin[i] > bMax[i]) return false;
+  }
+  if (!std::isfinite(padding)) return false;
+
+  glm::vec3 viewMin, viewMax;
+  objectSpaceBoxToViewSpace(box, padding, viewMin, viewMax);
+  return view::viewSpaceBoxOccluded(viewMin, viewMax);
+}
+
+bool Structure::objectSpaceBoxSlicedAway(const std::tuple<glm::vec3, glm::vec3>& box, float padding) {
+  const glm::vec3& bMin = std::get<0>(box);
+  const glm::vec3& bMax = std::get<1>(box);
+  for (int i = 0; i < 3; i++) {
+    // empty or invalid bounds, don't try to cull
+    if (!std::isfinite(bMin[i]) || !std::isfinite(bMax[i]) || bMin[i] > bMax[i]) return false;
+  }
+  if (!std::isfinite(padding)) return false;
+
+  glm::dmat4 T = getModelMatrix();
+  for (std::unique_ptr<SlicePlane>& plane : state::slicePlanes) {
+    if (!plane->getActive() || getIgnoreSlicePlane(plane->name)) continue;
+
+    // Like the fragment test, positions p with dot(p - center, normal) < 0 are sliced away
+    glm::vec3 normal = plane->getNormal();
+    float normalLen = glm::length(normal);
+    if (!(normalLen > 0.)) continue;
+    normal /= normalLen;
+    float offset = glm::dot(plane->getCenter(), normal) - padding;
+
+    bool allSliced = true;
+    for (int iC = 0; iC < 8 && allSliced; iC++) {
+      glm::vec3 corner{(iC & 1) ? bMax.x : bMin.x, (iC & 2) ? bMax.y : bMin.y, (iC & 4) ? bMax.z : bMin.z};
+      glm::dvec3 worldCorner = glm::dvec3(T * glm::dvec4(corner, 1.));
+      if (glm::dot(worldCorner, glm::dvec3(normal)) >= offset) allSliced = false;
+    }
+    if (allSliced) return true;
+  }
+  return false;
+}
+
+glm::mat4 Structure::getModelView() {
+  // composed in double precision, so that a large origin cancels against the camera translation before rounding
+  return glm::mat4(glm::dmat4(view::getCameraViewMatrix()) * getModelMatrix());
+}
 
 std::vector<std::string> Structure::addStructureRules(std::vector<std::string> initRules) {
   if (render::engine->slicePlanesEnabled()) {
@@ -236,10 +494,171 @@ std::vector<std::string> Structure::addStructureRules(std::vector<std::string> i
   return initRules;
 }
 
+Structure* Structure::setKeyframeTime(float newTime) {
+  keyframeTime = newTime;
+  requestRedraw();
+  return this;
+}
+float Structure::getKeyframeTime() { return keyframeTime; }
+
+Structure* Structure::setKeyframesPlaying(bool newVal) {
+  keyframesPlaying = newVal;
+  lastKeyframeUpdate = std::chrono::steady_clock::now();
+  requestRedraw();
+  return this;
+}
+bool Structure::getKeyframesPlaying() { return keyframesPlaying; }
+
+Structure* Structure::setKeyframePlaybackSpeed(float framesPerSecond) {
+  keyframePlaybackSpeed = framesPerSecond;
+  return this;
+}
+float Structure::getKeyframePlaybackSpeed() { return keyframePlaybackSpeed; }
+
+size_t Structure::nKeyframes() { return keyframeCount; }
+
+bool Structure::hasPositionKeyframes() { return positionKeyframes != nullptr; }
+
+void Structure::clearPositionKeyframes() {
+  positionKeyframes.reset();
+  updateObjectSpaceBounds();
+  refresh();
+}
+
+void Structure::registerKeyframeCount(size_t nFrames) {
+  if (keyframeCount != 0 && nFrames != keyframeCount) {
+    exception("Structure [" + name + "] has keyframes with " + std::to_string(keyframeCount) +
+              " frames, all of its keyframed data must have the same number of frames but got " +
+              std::to_string(nFrames));
+  }
+  keyframeCount = nFrames;
+}
+
+void Structure::updateKeyframePlayback() {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (keyframesPlaying && nKeyframes() > 1) {
+    float elapsed = std::chrono::duration<float>(now - lastKeyframeUpdate).count();
+    float span = static_cast<float>(nKeyframes() - 1);
+    keyframeTime = std::fmod(keyframeTime + elapsed * keyframePlaybackSpeed, span);
+    if (keyframeTime < 0.) keyframeTime += span;
+    requestRedraw();
+  }
+  lastKeyframeUpdate = now;
+}
+
+void Structure::setPositionKeyframeData(const std::vector<std::vector<glm::vec3>>& frames, size_t nElements) {
+  for (size_t iFrame = 0; iFrame < frames.size(); iFrame++) {
+    if (frames[iFrame].size() != nElements) {
+      exception("Structure [" + name + "] position keyframe " + std::to_string(iFrame) + " has " +
+                std::to_string(frames[iFrame].size()) + " positions, but there are " + std::to_string(nElements) +
+                " elements");
+    }
+  }
+  registerKeyframeCount(frames.size());
+  positionKeyframes.reset(new KeyframeSeries(uniquePrefix() + "positionKeyframes", frames));
+  updateObjectSpaceBounds();
+  refresh();
+}
+
+void Structure::includeKeyframesInBounds() {
+  if (!positionKeyframes) return;
+  std::tuple<glm::vec3, glm::vec3> frameBox = positionKeyframes->boundingBox();
+  std::get<0>(objectSpaceBoundingBox) = componentwiseMin(std::get<0>(objectSpaceBoundingBox), std::get<0>(frameBox));
+  std::get<1>(objectSpaceBoundingBox) = componentwiseMax(std::get<1>(objectSpaceBoundingBox), std::get<1>(frameBox));
+}
+
+std::tuple<glm::vec3, glm::vec3> Structure::computePointBounds(const glm::vec3* points, size_t count) {
+  typedef std::tuple<glm::vec3, glm::vec3> Box;
+  const float inf = std::numeric_limits<float>::infinity();
+  const float maxFinite = std::numeric_limits<float>::max();
+
+  auto chunkBounds = [&](size_t begin, size_t end) {
+    glm::vec3 min{inf, inf, inf};
+    glm::vec3 max{-inf, -inf, -inf};
+    // branch-free so the loop vectorizes, NaN and +-inf fail the comparisons and are skipped
+    for (size_t i = begin; i < end; i++) {
+      for (int c = 0; c < 3; c++) {
+        float x = points[i][c];
+        bool isFinite = std::abs(x) <= maxFinite;
+        min[c] = (isFinite && x < min[c]) ? x : min[c];
+        max[c] = (isFinite && x > max[c]) ? x : max[c];
+      }
+    }
+    return Box{min, max};
+  };
+  auto combine = [](const Box& a, const Box& b) {
+    return Box{componentwiseMin(std::get<0>(a), std::get<0>(b)), componentwiseMax(std::get<1>(a), std::get<1>(b))};
+  };
+  return parallelReduce(0, count, Box{glm::vec3{inf, inf, inf}, glm::vec3{-inf, -inf, -inf}}, chunkBounds, combine,
+                        1 << 16);
+}
+
+void Structure::setObjectSpaceBoundsFromPoints(const std::vector<glm::vec3>& points) {
+
+  // bounding box
+  objectSpaceBoundingBox = computePointBounds(points.data(), points.size());
+
+  // length scale, as twice the radius from the center of the bounding box
+  glm::vec3 center = 0.5f * (std::get<0>(objectSpaceBoundingBox) + std::get<1>(objectSpaceBoundingBox));
+  auto chunkMaxDist2 = [&](size_t begin, size_t end) {
+    float maxDist2 = 0.f;
+    for (size_t i = begin; i < end; i++) {
+      float dist2 = glm::length2(points[i] - center);
+      maxDist2 = (dist2 > maxDist2) ? dist2 : maxDist2;
+    }
+    return maxDist2;
+  };
+  auto combine = [](float a, float b) { return std::max(a, b); };
+  float lengthScale2 = parallelReduce(0, points.size(), 0.f, chunkMaxDist2, combine, 1 << 16);
+  objectSpaceLengthScale = 2 * std::sqrt(lengthScale2);
+}
+
+void Structure::refitObjectSpaceBounds(std::tuple<glm::vec3, glm::vec3> updatedBounds, bool coversAll) {
+  glm::vec3 oldMin = std::get<0>(objectSpaceBoundingBox);
+  glm::vec3 oldMax = std::get<1>(objectSpaceBoundingBox);
+  glm::vec3 newMin = std::get<0>(updatedBounds);
+  glm::vec3 newMax = std::get<1>(updatedBounds);
+
+  // Shrinking moves the scene extents, only do it if they follow the geometry. The keyframes are not in the updated
+  // positions, so the box must keep covering them.
+  bool shrink = coversAll && options::automaticallyComputeSceneExtents && !hasPositionKeyframes();
+  if (!shrink) {
+    newMin = componentwiseMin(oldMin, newMin);
+    newMax = componentwiseMax(oldMax, newMax);
+  }
+  if (newMin == oldMin && newMax == oldMax) return;
+
+  objectSpaceBoundingBox = std::make_tuple(newMin, newMax);
+  updateStructureExtents();
+}
+
+void Structure::refitObjectSpaceBounds(const std::vector<glm::vec3>& points) {
+  refitObjectSpaceBounds(computePointBounds(points.data(), points.size()), true);
+}
+
+void Structure::prepareDraw() {}
+
+bool Structure::hasPendingHostData() { return false; }
+
+void Structure::prepareHostData() {}
+
 void Structure::setStructureUniforms(render::ShaderProgram& p) {
   glm::mat4 viewMat = getModelView();
   p.setUniform("u_modelView", glm::value_ptr(viewMat));
 
+  // Keyframed data, the texture only gets attached once
+  if (p.hasUniform("u_keyframeT")) {
+    int frameA, frameB;
+    float weight;
+    keyframeInterval(keyframeTime, nKeyframes(), frameA, frameB, weight);
+    p.setUniform("u_keyframeA", frameA);
+    p.setUniform("u_keyframeB", frameB);
+    p.setUniform("u_keyframeT", weight);
+  }
+  if (positionKeyframes && p.hasTexture("t_keyframePositions") && !p.textureIsSet("t_keyframePositions")) {
+    p.setTextureFromBuffer("t_keyframePositions", positionKeyframes->getTexture().get());
+  }
+
   if (p.hasUniform("u_projMatrix")) {
     glm::mat4 projMat = view::getCameraPerspectiveMatrix();
     p.setUniform("u_projMatrix", glm::value_ptr(projMat));
@@ -264,11 +683,25 @@ void Structure::setStructureUniforms(render::ShaderProgram& p) {
     }
   }
 
+  // Whether transparent fragments are being accumulated for weighted blended transparency, or blended directly
+  if (p.hasUniform("u_weightedTransparencyPass")) {
+    p.setUniform("u_weightedTransparencyPass", static_cast<int>(render::engine->weightedTransparencyPass));
+  }
+
+  // Which stage of the depth prepass is being drawn, and the depth it wrote (see Engine::setDepthPrepass())
+  if (p.hasUniform("u_depthPrepassStage")) {
+    p.setUniform("u_depthPrepassStage", render::engine->depthPrepassStage);
+  }
+  if (p.hasTexture("t_prepassDepth") && !p.textureIsSet("t_prepassDepth")) {
+    p.setTextureFromBuffer("t_prepassDepth", render::engine->sceneDepthPrepass.get());
+  }
+
   // Respect any slice planes
   for (std::unique_ptr<SlicePlane>& s : state::slicePlanes) {
     bool ignoreThisPlane = getIgnoreSlicePlane(s->name);
     s->setSceneObjectUniforms(p, ignoreThisPlane);
   }
+  setUnusedSlicePlaneUniforms(p);
 
   // TODO this chain if "if"s is not great. Set up some system in the render engine to conditionally set these? Maybe
   // a list of lambdas? Ugh.
@@ -304,7 +737,7 @@ float Structure::getTransparency() { return transparency.get(); }
 
 Structure* Structure::setCullWholeElements(bool newVal) {
   cullWholeElements = newVal;
-  refresh();
+  refreshShaderPrograms(); // changes the rules of the programs
   requestRedraw();
   return this;
 }
@@ -315,7 +748,6 @@ Structure* Structure::setIgnoreSlicePlane(std::string name, bool newValue) {
   if (getIgnoreSlicePlane(name) == newValue) {
     // no change
     ignoredSlicePlaneNames.manuallyChanged();
-    refresh();
     requestRedraw();
     return this;
   }
@@ -329,8 +761,7 @@ Structure* Structure::setIgnoreSlicePlane(std::string name, bool newValue) {
     names.erase(std::remove(names.begin(), names.end(), name), names.end());
   }
   ignoredSlicePlaneNames.manuallyChanged();
-  refresh();
-  requestRedraw();
+  requestRedraw(); // only the slice plane uniforms change
   return this;
 }
 
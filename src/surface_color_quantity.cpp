@@ -9,8 +9,8 @@
 namespace polyscope {
 
 SurfaceColorQuantity::SurfaceColorQuantity(std::string name, SurfaceMesh& mesh_, std::string definedOn_,
-                                           const std::vector<glm::vec3>& colorValues_)
-    : SurfaceMeshQuantity(name, mesh_, true), ColorQuantity(*this, colorValues_), definedOn(definedOn_) {}
+                                           std::vector<glm::vec3> colorValues_)
+    : SurfaceMeshQuantity(name, mesh_, true), ColorQuantity(*this, std::move(colorValues_)), definedOn(definedOn_) {}
 
 void SurfaceColorQuantity::draw() {
   if (!isEnabled()) return;
@@ -19,12 +19,17 @@ void SurfaceColorQuantity::draw() {
     createProgram();
   }
 
+  if (elementTexture && elementTextureDataVersion != colors.getDataVersion()) {
+    SurfaceMesh::updateElementTexture(*elementTexture, colors.getPopulatedHostBufferRef());
+    elementTextureDataVersion = colors.getDataVersion();
+  }
+
   // Set uniforms
   parent.setStructureUniforms(*program);
   parent.setSurfaceMeshUniforms(*program);
   render::engine->setMaterialUniforms(*program, parent.getMaterial());
 
-  program->draw();
+  parent.drawMeshProgram(*program);
 }
 
 // ========================================================
@@ -33,14 +38,14 @@ void SurfaceColorQuantity::draw() {
 
 SurfaceVertexColorQuantity::SurfaceVertexColorQuantity(std::string name, SurfaceMesh& mesh_,
                                                        std::vector<glm::vec3> colorValues_)
-    : SurfaceColorQuantity(name, mesh_, "vertex", colorValues_)
+    : SurfaceColorQuantity(name, mesh_, "vertex", std::move(colorValues_))
 
 {}
 
 void SurfaceVertexColorQuantity::createProgram() {
   // Create the program to draw this quantity
   // clang-format off
-  program = render::engine->requestShader("MESH", 
+  program = render::engine->requestShader(parent.getVertexMeshProgramName(),
       render::engine->addMaterialRules(parent.getMaterial(),
         addColorRules(
           parent.addSurfaceMeshRules(
@@ -52,7 +57,7 @@ void SurfaceVertexColorQuantity::createProgram() {
   // clang-format on
 
   parent.setMeshGeometryAttributes(*program);
-  program->setAttribute("a_color", colors.getIndexedRenderAttributeBuffer(parent.triangleVertexInds));
+  program->setAttribute("a_color", parent.getVertexAttributeBuffer(*program, colors));
   render::engine->setMaterial(*program, parent.getMaterial());
 }
 
@@ -72,6 +77,7 @@ std::string SurfaceColorQuantity::niceName() { return name + " (" + definedOn +
 
 void SurfaceColorQuantity::refresh() {
   program.reset();
+  elementTexture.reset();
   Quantity::refresh();
 }
 
@@ -81,18 +87,23 @@ void SurfaceColorQuantity::refresh() {
 
 SurfaceFaceColorQuantity::SurfaceFaceColorQuantity(std::string name, SurfaceMesh& mesh_,
                                                    std::vector<glm::vec3> colorValues_)
-    : SurfaceColorQuantity(name, mesh_, "face", colorValues_)
+    : SurfaceColorQuantity(name, mesh_, "face", std::move(colorValues_))
 
 {}
 
 void SurfaceFaceColorQuantity::createProgram() {
   // Create the program to draw this quantity
+
+  // the colors are read at their own size from a texture, unless there are too many for one
+  elementTexture = SurfaceMesh::generateElementTexture(colors.getPopulatedHostBufferRef());
+  elementTextureDataVersion = colors.getDataVersion();
+
   // clang-format off
-  program = render::engine->requestShader("MESH", 
+  program = render::engine->requestShader("MESH",
       render::engine->addMaterialRules(parent.getMaterial(),
         addColorRules(
           parent.addSurfaceMeshRules(
-            {"MESH_PROPAGATE_COLOR", "SHADE_COLOR"}
+            {elementTexture ? "MESH_FETCH_COLOR" : "MESH_PROPAGATE_COLOR", "SHADE_COLOR"}
           )
         )
       )
@@ -100,7 +111,12 @@ void SurfaceFaceColorQuantity::createProgram() {
   // clang-format on
 
   parent.setMeshGeometryAttributes(*program);
-  program->setAttribute("a_color", colors.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+  if (elementTexture) {
+    program->setAttribute("a_elementInd", parent.triangleFaceInds.getRenderAttributeBuffer());
+    program->setTextureFromBuffer("t_elementColors", elementTexture.get());
+  } else {
+    program->setAttribute("a_color", colors.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+  }
   render::engine->setMaterial(*program, parent.getMaterial());
 }
 
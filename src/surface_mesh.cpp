@@ -4,14 +4,22 @@
 
 #include "glm/fwd.hpp"
 #include "polyscope/combining_hash_functions.h"
+#include "polyscope/derived_data_cache.h"
+#include "polyscope/key_indexing.h"
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
+#include "polyscope/trace.h"
 
 #include "imgui.h"
 #include "polyscope/types.h"
 #include "polyscope/utilities.h"
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 
@@ -40,8 +48,11 @@ triangleAllHalfedgeInds(   this, uniquePrefix() + "triangleHalfedgeInds",     tr
 triangleAllCornerInds(     this, uniquePrefix() + "triangleAllCornerInds",    triangleAllCornerIndsData,      std::bind(&SurfaceMesh::computeTriangleAllCornerInds, this)),
 
 // internal triangle data for rendering
-baryCoord(              this, uniquePrefix() + "baryCoord",           baryCoordData),
 edgeIsReal(             this, uniquePrefix() + "edgeIsReal",          edgeIsRealData),
+chunkCornerOrder(       this, uniquePrefix() + "chunkCornerOrder",    chunkCornerOrderData,   std::bind(&SurfaceMesh::computeChunkCornerOrder, this)),
+cacheOrderedVertexInds( this, uniquePrefix() + "cacheOrderedVertexInds", cacheOrderedVertexIndsData, std::bind(&SurfaceMesh::computeCacheOrderedVertexInds, this)),
+keyframeInds(           this, uniquePrefix() + "keyframeInds",        keyframeIndsData,       std::bind(&SurfaceMesh::computeKeyframeInds, this)),
+lodTriangleVertexInds(  this, uniquePrefix() + "lodTriangleVertexInds", lodTriangleVertexIndsData),
 
 // other internally-computed geometry
 faceNormals(            this, uniquePrefix() + "faceNormals",         faceNormalsData,        std::bind(&SurfaceMesh::computeFaceNormals, this)),
@@ -63,108 +74,147 @@ backFaceColor(          uniquePrefix() + "backFaceColor",   glm::vec3(1.f - surf
 shadeStyle(             uniquePrefix() + "shadeStyle",      MeshShadeStyle::Flat)
 
 // clang-format on
-{}
+{
+  lodTriangleVertexInds.setHostResidency(HostResidency::DropAfterUpload);
+}
 
-SurfaceMesh::SurfaceMesh(std::string name_, const std::vector<glm::vec3>& vertexPositions_,
-                         const std::vector<uint32_t>& faceIndsEntries_, const std::vector<uint32_t>& faceIndsStart_)
+SurfaceMesh::SurfaceMesh(std::string name_, std::vector<glm::vec3> vertexPositions_,
+                         std::vector<uint32_t> faceIndsEntries_, std::vector<uint32_t> faceIndsStart_)
     : SurfaceMesh(name_) {
 
-  vertexPositionsData = vertexPositions_;
-  faceIndsEntries = faceIndsEntries_;
-  faceIndsStart = faceIndsStart_;
+  vertexPositionsData = std::move(vertexPositions_);
+  faceIndsEntries = std::move(faceIndsEntries_);
+  faceIndsStart = std::move(faceIndsStart_);
 
   computeConnectivityData();
   updateObjectSpaceBounds();
 }
 
-SurfaceMesh::SurfaceMesh(std::string name_, const std::vector<glm::vec3>& vertexPositions_,
+SurfaceMesh::SurfaceMesh(std::string name_, std::vector<glm::vec3> vertexPositions_,
                          const std::vector<std::vector<size_t>>& facesIn)
     : SurfaceMesh(name_) {
 
-  vertexPositionsData = vertexPositions_;
+  vertexPositionsData = std::move(vertexPositions_);
   nestedFacesToFlat(facesIn);
 
   computeConnectivityData();
   updateObjectSpaceBounds();
 }
 
+SurfaceMesh::~SurfaceMesh() { cancelLODBuild(); }
+
 void SurfaceMesh::nestedFacesToFlat(const std::vector<std::vector<size_t>>& nestedInds) {
 
-  faceIndsStart.clear();
-  faceIndsEntries.clear();
-  faceIndsStart.push_back(0);
+  // size the flat arrays up front, then fill them in place
+  faceIndsStart.resize(nestedInds.size() + 1);
+  faceIndsStart[0] = 0;
+  for (size_t iF = 0; iF < nestedInds.size(); iF++) {
+    faceIndsStart[iF + 1] = faceIndsStart[iF] + nestedInds[iF].size();
+  }
 
-  for (const std::vector<size_t>& face : nestedInds) {
-    for (size_t iV : face) {
-      faceIndsEntries.push_back(iV);
-    }
-    faceIndsStart.push_back(faceIndsEntries.size());
+  faceIndsEntries.resize(faceIndsStart.back());
+  for (size_t iF = 0; iF < nestedInds.size(); iF++) {
+    std::copy(nestedInds[iF].begin(), nestedInds[iF].end(), faceIndsEntries.begin() + faceIndsStart[iF]);
   }
 }
 
 void SurfaceMesh::computeConnectivityData() {
+  POLYSCOPE_TRACE_SPAN("computeConnectivityData", name);
 
   // some number-of-elements arithmetic
   size_t numFaces = faceIndsStart.size() - 1;
   nCornersCount = faceIndsEntries.size();
   nFacesTriangulationCount = nCornersCount - 2 * numFaces;
 
+  // rebuilt lazily against the new connectivity
+  vertexFaceAdjStart.clear();
+  vertexFaceAdjEntries.clear();
+  deviceFaceStart.reset();
+  deviceFaceVerts.reset();
+  deviceVertexFaceStart.reset();
+  deviceVertexFaces.reset();
+
   // fill out these buffers as we construct the triangulation
   triangleVertexIndsData.clear();
   triangleVertexIndsData.resize(3 * nFacesTriangulationCount);
   triangleFaceIndsData.clear();
   triangleFaceIndsData.resize(3 * nFacesTriangulationCount);
-  baryCoordData.clear();
-  baryCoordData.resize(3 * nFacesTriangulationCount);
   edgeIsRealData.clear();
   edgeIsRealData.resize(3 * nFacesTriangulationCount);
 
   // validate the face-vertex indices
-  for (size_t iV : faceIndsEntries) {
-    if (iV >= vertexPositions.size())
-      exception("SurfaceMesh " + name + " has face vertex index " + std::to_string(iV) +
-                " out of bounds for number of vertices " + std::to_string(vertexPositions.size()));
+  // (each chunk records its first bad index, the earliest one is reported on this thread)
+  size_t nVerts = vertexPositions.size();
+  size_t nEntryChunks = parallelChunkCount(faceIndsEntries.size());
+  std::vector<size_t> firstBadEntry(nEntryChunks, INVALID_IND);
+  parallelForChunks(0, faceIndsEntries.size(), nEntryChunks, [&](size_t iChunk, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (faceIndsEntries[i] >= nVerts) {
+        firstBadEntry[iChunk] = i;
+        return;
+      }
+    }
+  });
+  for (size_t iBad : firstBadEntry) {
+    if (iBad != INVALID_IND) {
+      exception("SurfaceMesh " + name + " has face vertex index " + std::to_string(faceIndsEntries[iBad]) +
+                " out of bounds for number of vertices " + std::to_string(nVerts));
+    }
   }
 
-  // construct the triangualted draw list and all other related data
-  size_t iTriFace = 0;
-  for (size_t iF = 0; iF < numFaces; iF++) {
+  // compute the offset of each face's first triangle as a prefix sum over the per-face triangle counts, one partial
+  // sum per chunk of faces, so each face can then be triangulated independently
+  auto faceTriCount = [&](size_t iF) {
     size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
+    return D < 2 ? 0 : D - 2;
+  };
+  size_t nFaceChunks = parallelChunkCount(numFaces);
+  std::vector<size_t> chunkTriStart(nFaceChunks + 1, 0);
+  parallelForChunks(0, numFaces, nFaceChunks, [&](size_t iChunk, size_t begin, size_t end) {
+    size_t sum = 0;
+    for (size_t iF = begin; iF < end; iF++) sum += faceTriCount(iF);
+    chunkTriStart[iChunk + 1] = sum;
+  });
+  for (size_t iChunk = 0; iChunk < nFaceChunks; iChunk++) {
+    chunkTriStart[iChunk + 1] += chunkTriStart[iChunk];
+  }
 
-    size_t iStart = faceIndsStart[iF];
-    uint32_t vRoot = faceIndsEntries[iStart];
+  // construct the triangualted draw list and all other related data
+  parallelForChunks(0, numFaces, nFaceChunks, [&](size_t iChunk, size_t begin, size_t end) {
+    size_t iTriFace = chunkTriStart[iChunk];
+    for (size_t iF = begin; iF < end; iF++) {
+      size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
+
+      size_t iStart = faceIndsStart[iF];
+      uint32_t vRoot = faceIndsEntries[iStart];
+
+      // implicitly triangulate from root
+      for (size_t j = 1; (j + 1) < D; j++) {
+        uint32_t vB = faceIndsEntries[iStart + j];
+        uint32_t vC = faceIndsEntries[iStart + ((j + 1) % D)];
+
+        // triangle vertex indices
+        triangleVertexIndsData[3 * iTriFace + 0] = vRoot;
+        triangleVertexIndsData[3 * iTriFace + 1] = vB;
+        triangleVertexIndsData[3 * iTriFace + 2] = vC;
+
+        // triangle face indices
+        for (size_t k = 0; k < 3; k++) triangleFaceIndsData[3 * iTriFace + k] = iF;
+
+        // internal edges for triangulated polygons
+        glm::vec3 edgeRealV{0., 1., 0.};
+        if (j == 1) {
+          edgeRealV.x = 1.;
+        }
+        if (j + 2 == D) {
+          edgeRealV.z = 1.;
+        }
+        for (size_t k = 0; k < 3; k++) edgeIsRealData[3 * iTriFace + k] = edgeRealV;
 
-    // implicitly triangulate from root
-    for (size_t j = 1; (j + 1) < D; j++) {
-      uint32_t vB = faceIndsEntries[iStart + j];
-      uint32_t vC = faceIndsEntries[iStart + ((j + 1) % D)];
-
-      // triangle vertex indices
-      triangleVertexIndsData[3 * iTriFace + 0] = vRoot;
-      triangleVertexIndsData[3 * iTriFace + 1] = vB;
-      triangleVertexIndsData[3 * iTriFace + 2] = vC;
-
-      // triangle face indices
-      for (size_t k = 0; k < 3; k++) triangleFaceIndsData[3 * iTriFace + k] = iF;
-
-      // barycentric coordinates
-      baryCoordData[3 * iTriFace + 0] = glm::vec3{1., 0., 0.};
-      baryCoordData[3 * iTriFace + 1] = glm::vec3{0., 1., 0.};
-      baryCoordData[3 * iTriFace + 2] = glm::vec3{0., 0., 1.};
-
-      // internal edges for triangulated polygons
-      glm::vec3 edgeRealV{0., 1., 0.};
-      if (j == 1) {
-        edgeRealV.x = 1.;
-      }
-      if (j + 2 == D) {
-        edgeRealV.z = 1.;
+        iTriFace++;
       }
-      for (size_t k = 0; k < 3; k++) edgeIsRealData[3 * iTriFace + k] = edgeRealV;
-
-      iTriFace++;
     }
-  }
+  });
 
   vertexDataSize = nVertices();
   faceDataSize = nFaces();
@@ -174,123 +224,102 @@ void SurfaceMesh::computeConnectivityData() {
 
   triangleVertexInds.markHostBufferUpdated();
   triangleFaceInds.markHostBufferUpdated();
-  baryCoord.markHostBufferUpdated();
   edgeIsReal.markHostBufferUpdated();
+  edgeMaskTexture.reset();
 }
 
 // =================================================
 // =====    Lazily-Populated Connectivity   ========
 // =================================================
 
-void SurfaceMesh::computeTriangleAllEdgeInds() {
-
-  // WARNING: logic duplicated in countEdges()
+size_t SurfaceMesh::computeHalfedgeEdgeIndexing(std::vector<size_t>& halfedgeEdgeInd, std::string errorContext) {
 
-  if (edgePerm.empty())
-    exception("SurfaceMesh " + name +
-              " performed an operation which requires edge indices to be specified, but none have been set. "
-              "Call setEdgePermutation().");
-
-  triangleVertexInds.ensureHostBufferPopulated();
-  triangleAllEdgeInds.data.resize(3 * 3 * nFacesTriangulation());
-  halfedgeEdgeCorrespondence.resize(nHalfedges());
-
-  // used to loop over edges
-  std::unordered_map<std::pair<size_t, size_t>, size_t, polyscope::hash_combine::hash<std::pair<size_t, size_t>>>
-      seenEdgeInds;
-
-  auto createEdgeKey = [&](size_t a, size_t b) -> std::pair<size_t, size_t> {
-    return std::make_pair(std::min(a, b), std::max(a, b));
-  };
-
-  size_t psEdgeInd = 0; // polyscope's edge index, iterated according to Polyscope's canonical ordering
   for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t start = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - start;
+    size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
 
     // TODO why can't we use edges on non triangular meshes? Implement it.
 
     if (D != 3) {
-      exception("SurfaceMesh " + name +
-                " attempted to access triangle-edge indices, but it has non-triangular faces. These indices are "
-                "only well-defined on a pure-triangular mesh.");
+      exception("SurfaceMesh " + name + " " + errorContext);
     }
+  }
 
-    glm::uvec3 thisTriInds{0, 0, 0};
-    for (size_t j = 0; j < 3; j++) {
-      size_t vA = triangleVertexInds.data[3 * iF + j];
-      size_t vB = triangleVertexInds.data[3 * iF + ((j + 1) % 3)];
-
-      std::pair<size_t, size_t> key = createEdgeKey(vA, vB);
-
-      size_t thisEdgeInd;
-      if (seenEdgeInds.find(key) == seenEdgeInds.end()) {
-        // process a new edge in the canonical ordering
-        if (psEdgeInd >= edgePerm.size()) {
-          exception("SurfaceMesh " + name +
-                    " edge indexing out of bounds. Did you pass an edge ordering that is too short?");
-        }
-        thisEdgeInd = edgePerm[psEdgeInd];
-        seenEdgeInds[key] = thisEdgeInd;
-        psEdgeInd++;
-      } else {
-        // we've processed this edge before, retrieve its assigned index
-        thisEdgeInd = seenEdgeInds[key];
-      }
+  // key each halfedge by its sorted pair of endpoints, then number the distinct keys in Polyscope's canonical order
+  triangleVertexInds.ensureHostBufferPopulated();
 
-      halfedgeEdgeCorrespondence[start + j] = thisEdgeInd;
-      thisTriInds[j] = thisEdgeInd;
+  // the indexing only depends on the triangles, reuse it from an earlier session if possible
+  const char* cacheKind = "SurfaceMesh.halfedgeEdgeIndexing";
+  uint64_t inputHash = 0;
+  if (derivedDataCacheEnabled()) {
+    inputHash = ContentHash().add(triangleVertexInds.data).get();
+    if (loadDerivedData(cacheKind, inputHash, halfedgeEdgeInd)) {
+      size_t nEdgesFound = 0;
+      for (size_t iE : halfedgeEdgeInd) nEdgesFound = std::max(nEdgesFound, iE + 1);
+      return nEdgesFound;
     }
+  }
 
-    for (size_t j = 0; j < 3; j++) {
-      for (size_t k = 0; k < 3; k++) {
-        triangleAllEdgeInds.data[9 * iF + 3 * j + k] = thisTriInds[k];
+  std::vector<uint64_t> halfedgeKeys(nHalfedges());
+  parallelFor(0, nFaces(), [&](size_t begin, size_t end) {
+    for (size_t iF = begin; iF < end; iF++) {
+      for (size_t j = 0; j < 3; j++) {
+        uint64_t vA = triangleVertexInds.data[3 * iF + j];
+        uint64_t vB = triangleVertexInds.data[3 * iF + ((j + 1) % 3)];
+        halfedgeKeys[3 * iF + j] = (std::min(vA, vB) << 32) | std::max(vA, vB);
       }
     }
-  }
+  });
 
-  nEdgesCount = psEdgeInd;
-  triangleAllEdgeInds.markHostBufferUpdated();
+  size_t nEdgesFound = indexUniqueKeys(halfedgeKeys, halfedgeEdgeInd);
+  storeDerivedData(cacheKind, inputHash, halfedgeEdgeInd);
+  return nEdgesFound;
 }
 
-void SurfaceMesh::countEdges() {
-
-  // WARNING: logic duplicated in computeTriangleAllEdgeInds()
-
-  // used to loop over edges
-  std::unordered_map<std::pair<size_t, size_t>, size_t, polyscope::hash_combine::hash<std::pair<size_t, size_t>>>
-      seenEdgeInds;
+void SurfaceMesh::computeTriangleAllEdgeInds() {
 
-  auto createEdgeKey = [&](size_t a, size_t b) -> std::pair<size_t, size_t> {
-    return std::make_pair(std::min(a, b), std::max(a, b));
-  };
+  if (edgePerm.empty())
+    exception("SurfaceMesh " + name +
+              " performed an operation which requires edge indices to be specified, but none have been set. "
+              "Call setEdgePermutation().");
 
-  size_t psEdgeInd = 0; // polyscope's edge index, iterated according to Polyscope's canonical ordering
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t start = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - start;
+  std::vector<size_t> psEdgeInds; // polyscope's edge index, according to Polyscope's canonical ordering
+  size_t nEdgesFound = computeHalfedgeEdgeIndexing(
+      psEdgeInds, "attempted to access triangle-edge indices, but it has non-triangular faces. These indices are "
+                  "only well-defined on a pure-triangular mesh.");
 
-    if (D != 3) {
-      exception("SurfaceMesh " + name +
-                " attempted to count edges, but mesh has non-triangular faces. Edge functions are only implemented on "
-                "a pure-triangular mesh.");
-    }
+  if (nEdgesFound > edgePerm.size()) {
+    exception("SurfaceMesh " + name + " edge indexing out of bounds. Did you pass an edge ordering that is too short?");
+  }
 
-    for (size_t j = 0; j < 3; j++) {
-      size_t vA = triangleVertexInds.data[3 * iF + j];
-      size_t vB = triangleVertexInds.data[3 * iF + ((j + 1) % 3)];
+  triangleAllEdgeInds.data.resize(3 * 3 * nFacesTriangulation());
+  halfedgeEdgeCorrespondence.resize(nHalfedges());
 
-      std::pair<size_t, size_t> key = createEdgeKey(vA, vB);
+  parallelFor(0, nFaces(), [&](size_t begin, size_t end) {
+    for (size_t iF = begin; iF < end; iF++) {
+      glm::uvec3 thisTriInds{0, 0, 0};
+      for (size_t j = 0; j < 3; j++) {
+        size_t thisEdgeInd = edgePerm[psEdgeInds[3 * iF + j]];
+        halfedgeEdgeCorrespondence[faceIndsStart[iF] + j] = thisEdgeInd;
+        thisTriInds[j] = thisEdgeInd;
+      }
 
-      if (seenEdgeInds.find(key) == seenEdgeInds.end()) {
-        size_t thisEdgeInd = psEdgeInd;
-        seenEdgeInds[key] = thisEdgeInd;
-        psEdgeInd++;
+      for (size_t j = 0; j < 3; j++) {
+        for (size_t k = 0; k < 3; k++) {
+          triangleAllEdgeInds.data[9 * iF + 3 * j + k] = thisTriInds[k];
+        }
       }
     }
-  }
+  });
 
-  nEdgesCount = psEdgeInd;
+  nEdgesCount = nEdgesFound;
+  triangleAllEdgeInds.markHostBufferUpdated();
+}
+
+void SurfaceMesh::countEdges() {
+  std::vector<size_t> halfedgeEdgeInd;
+  nEdgesCount = computeHalfedgeEdgeIndexing(
+      halfedgeEdgeInd, "attempted to count edges, but mesh has non-triangular faces. Edge functions are only "
+                       "implemented on a pure-triangular mesh.");
 }
 
 size_t SurfaceMesh::nEdges() {
@@ -397,211 +426,371 @@ void SurfaceMesh::computeTriangleAllCornerInds() {
   triangleAllCornerInds.markHostBufferUpdated();
 }
 
+void SurfaceMesh::computeCacheOrderedVertexInds() {
 
-// =================================================
-// ========    Geometric Quantities      ==========
-// =================================================
-
-
-size_t SurfaceMesh::nVertices() { return vertexPositions.size(); }
-
-void SurfaceMesh::computeFaceNormals() {
-
-  vertexPositions.ensureHostBufferPopulated();
-
-  faceNormals.data.resize(nFaces());
-
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t iStart = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - iStart;
-
-    glm::vec3 fN{0., 0., 0.};
-    if (D == 3) {
-      glm::vec3 pA = vertexPositions.data[faceIndsEntries[iStart + 0]];
-      glm::vec3 pB = vertexPositions.data[faceIndsEntries[iStart + 1]];
-      glm::vec3 pC = vertexPositions.data[faceIndsEntries[iStart + 2]];
-      fN = glm::cross(pB - pA, pC - pA);
-    } else {
-      for (size_t j = 0; j < D; j++) {
-        glm::vec3 pA = vertexPositions.data[faceIndsEntries[iStart + j]];
-        glm::vec3 pB = vertexPositions.data[faceIndsEntries[iStart + (j + 1) % D]];
-        glm::vec3 pC = vertexPositions.data[faceIndsEntries[iStart + (j + 2) % D]];
-        fN += glm::cross(pC - pB, pA - pB);
-      }
+  triangleVertexInds.ensureHostBufferPopulated();
+  const std::vector<uint32_t>& triVerts = triangleVertexInds.data;
+  std::vector<uint32_t> triOrder = vertexCacheTriangleOrder(triVerts, nVertices());
+
+  cacheOrderedVertexInds.data.resize(triVerts.size());
+  for (size_t i = 0; i < triOrder.size(); i++) {
+    uint32_t iT = triOrder[i];
+    for (uint32_t k = 0; k < 3; k++) {
+      cacheOrderedVertexInds.data[3 * i + k] = triVerts[3 * iT + k];
     }
-    fN = glm::normalize(fN);
-    faceNormals.data[iF] = fN;
   }
 
-  faceNormals.markHostBufferUpdated();
+  cacheOrderedVertexInds.markHostBufferUpdated();
 }
 
-void SurfaceMesh::computeFaceCenters() {
-
-  vertexPositions.ensureHostBufferPopulated();
-
-  faceCenters.data.resize(nFaces());
-
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t start = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - start;
-    glm::vec3 faceCenter{0., 0., 0.};
-    for (size_t j = 0; j < D; j++) {
-      glm::vec3 pA = vertexPositions.data[faceIndsEntries[start + j]];
-      faceCenter += pA;
-    }
-    faceCenter /= D;
-    faceCenters.data[iF] = faceCenter;
+void SurfaceMesh::computeKeyframeInds() {
+  keyframeInds.data.resize(nVertices());
+  for (size_t i = 0; i < nVertices(); i++) {
+    keyframeInds.data[i] = static_cast<float>(i);
   }
-
-  faceCenters.markHostBufferUpdated();
+  keyframeInds.markHostBufferUpdated();
 }
 
-void SurfaceMesh::computeFaceAreas() {
+void SurfaceMesh::computeChunkCornerOrder() {
 
   vertexPositions.ensureHostBufferPopulated();
-
-  faceAreas.data.resize(nFaces());
-
-  // Loop over faces to compute face-valued quantities
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t start = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - start;
-
-    // Compute a face normal
-    double fA;
-    if (D == 3) {
-      glm::vec3 pA = vertexPositions.data[faceIndsEntries[start + 0]];
-      glm::vec3 pB = vertexPositions.data[faceIndsEntries[start + 1]];
-      glm::vec3 pC = vertexPositions.data[faceIndsEntries[start + 2]];
-      glm::vec3 fN = glm::cross(pB - pA, pC - pA);
-      fA = 0.5 * glm::length(fN);
-    } else {
-      fA = 0;
-      glm::vec3 pRoot = vertexPositions.data[faceIndsEntries[start]];
-      for (size_t j = 1; j + 1 < D; j++) {
-        glm::vec3 pA = vertexPositions.data[faceIndsEntries[start + j]];
-        glm::vec3 pB = vertexPositions.data[faceIndsEntries[start + j + 1]];
-        fA += 0.5 * glm::length(glm::cross(pA - pRoot, pB - pRoot));
-      }
+  triangleVertexInds.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  const std::vector<uint32_t>& triVerts = triangleVertexInds.data;
+  size_t nTri = nFacesTriangulation();
+
+  // Sort the triangles along a Morton curve through their centroids. Consecutive runs of the sorted triangles are
+  // spatially coherent for any run length, so the order does not depend on the chunk size.
+  std::vector<glm::vec3> centroids(nTri);
+  parallelFor(0, nTri, [&](size_t begin, size_t end) {
+    for (size_t iT = begin; iT < end; iT++) {
+      centroids[iT] = (pos[triVerts[3 * iT]] + pos[triVerts[3 * iT + 1]] + pos[triVerts[3 * iT + 2]]) / 3.f;
+    }
+  });
+  std::vector<uint32_t> triOrder = mortonOrder(centroids);
+
+  chunkCornerOrder.data.resize(3 * nTri);
+  for (size_t i = 0; i < nTri; i++) {
+    uint32_t iT = triOrder[i];
+    for (uint32_t k = 0; k < 3; k++) {
+      chunkCornerOrder.data[3 * i + k] = 3 * iT + k;
     }
-
-    faceAreas.data[iF] = fA;
   }
 
-  faceAreas.markHostBufferUpdated();
+  chunkCornerOrder.markHostBufferUpdated();
+
+  computeChunkBounds();
 }
 
+void SurfaceMesh::computeChunkBounds() {
 
-void SurfaceMesh::computeVertexNormals() {
+  chunks.clear();
+  if (trianglesPerChunk == 0) return;
 
-  faceNormals.ensureHostBufferPopulated();
-  faceAreas.ensureHostBufferPopulated();
+  chunkCornerOrder.ensureHostBufferPopulated();
+  vertexPositions.ensureHostBufferPopulated();
+  triangleVertexInds.ensureHostBufferPopulated();
 
-  vertexNormals.data.resize(nVertices());
+  size_t nTri = chunkCornerOrder.data.size() / 3;
+  for (size_t start = 0; start < nTri; start += trianglesPerChunk) {
+    TriangleChunk chunk;
+    chunk.triangleStart = start;
+    chunk.triangleCount = std::min(trianglesPerChunk, nTri - start);
+    chunks.push_back(chunk);
+  }
 
-  const glm::vec3 zero{0., 0., 0.};
+  parallelFor(
+      0, chunks.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t iChunk = begin; iChunk < end; iChunk++) {
+          TriangleChunk& chunk = chunks[iChunk];
+          glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+          glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+          for (size_t iC = 3 * chunk.triangleStart; iC < 3 * (chunk.triangleStart + chunk.triangleCount); iC++) {
+            const glm::vec3& p = vertexPositions.data[triangleVertexInds.data[chunkCornerOrder.data[iC]]];
+            min = componentwiseMin(min, p);
+            max = componentwiseMax(max, p);
+          }
+          chunk.objectSpaceBoundingBox = std::make_tuple(min, max);
+
+          // bounding sphere around the box center
+          glm::vec3 center = 0.5f * (min + max);
+          float radius2 = 0.;
+          for (size_t iC = 3 * chunk.triangleStart; iC < 3 * (chunk.triangleStart + chunk.triangleCount); iC++) {
+            const glm::vec3& p = vertexPositions.data[triangleVertexInds.data[chunkCornerOrder.data[iC]]];
+            radius2 = std::max(radius2, glm::dot(p - center, p - center));
+          }
+          chunk.boundingSphereCenter = center;
+          chunk.boundingSphereRadius = std::sqrt(radius2);
+
+          // normal cone, around the average face normal. Degenerate faces produce no fragments and are ignored.
+          std::vector<glm::vec3> faceNormals;
+          faceNormals.reserve(chunk.triangleCount);
+          glm::vec3 normalSum{0., 0., 0.};
+          for (size_t iT = chunk.triangleStart; iT < chunk.triangleStart + chunk.triangleCount; iT++) {
+            const glm::vec3& pA = vertexPositions.data[triangleVertexInds.data[chunkCornerOrder.data[3 * iT + 0]]];
+            const glm::vec3& pB = vertexPositions.data[triangleVertexInds.data[chunkCornerOrder.data[3 * iT + 1]]];
+            const glm::vec3& pC = vertexPositions.data[triangleVertexInds.data[chunkCornerOrder.data[3 * iT + 2]]];
+            glm::vec3 n = glm::cross(pB - pA, pC - pA);
+            float len = glm::length(n);
+            if (!(len > 0.)) continue;
+            faceNormals.push_back(n / len);
+            normalSum += faceNormals.back();
+          }
+          chunk.hasNormalCone = false;
+          float sumLen = glm::length(normalSum);
+          if (!faceNormals.empty() && sumLen > 0.) {
+            glm::vec3 axis = normalSum / sumLen;
+            float minDot = 1.;
+            for (const glm::vec3& n : faceNormals) {
+              minDot = std::min(minDot, glm::dot(axis, n));
+            }
+            // a cone of half-angle >= 90 degrees always contains a normal facing the camera
+            if (minDot > 0.) {
+              chunk.hasNormalCone = true;
+              chunk.normalConeAxis = axis;
+              chunk.normalConeCutoff = std::sqrt(std::max(0.f, 1.f - minDot * minDot));
+            }
+          }
+        }
+      },
+      1);
+}
 
-  std::fill(vertexNormals.data.begin(), vertexNormals.data.end(), zero);
+bool SurfaceMesh::chunkIsBackfacing(const TriangleChunk& chunk, bool perspective, glm::vec3 objectSpaceEye,
+                                    glm::vec3 objectSpaceLookDir, bool flipFacing) {
+  if (!chunk.hasNormalCone) return false;
+  glm::vec3 axis = flipFacing ? -chunk.normalConeAxis : chunk.normalConeAxis;
 
-  // Accumulate quantities from each face
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t start = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - start;
-    for (size_t j = 0; j < D; j++) {
-      size_t iV = faceIndsEntries[start + j];
-      vertexNormals.data[iV] += faceNormals.data[iF] * static_cast<float>(faceAreas.data[iF]);
-    }
+  if (perspective) {
+    // every point of the bounding sphere sees every normal of the cone from behind
+    glm::vec3 toChunk = chunk.boundingSphereCenter - objectSpaceEye;
+    return glm::dot(toChunk, axis) >= chunk.normalConeCutoff * glm::length(toChunk) + chunk.boundingSphereRadius;
+  } else {
+    return glm::dot(objectSpaceLookDir, axis) > chunk.normalConeCutoff;
   }
+}
 
-  // Normalize
-  for (size_t iV = 0; iV < nVertices(); iV++) {
-    vertexNormals.data[iV] = glm::normalize(vertexNormals.data[iV]);
-  }
 
-  vertexNormals.markHostBufferUpdated();
-}
+// =================================================
+// ========    Geometric Quantities      ==========
+// =================================================
 
-void SurfaceMesh::computeVertexAreas() {
 
-  faceAreas.ensureHostBufferPopulated();
+size_t SurfaceMesh::nVertices() { return vertexPositions.size(); }
 
-  vertexAreas.data.resize(nVertices());
-  std::fill(vertexAreas.data.begin(), vertexAreas.data.end(), 0.);
+void SurfaceMesh::computeGeometryBuffers(GeometryBufferSet set) {
 
-  // Accumulate quantities from each face
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
-    size_t start = faceIndsStart[iF];
-    for (size_t j = 0; j < D; j++) {
-      size_t iV = faceIndsEntries[start + j];
-      vertexAreas.data[iV] += faceAreas.data[iF] / D;
-    }
+  // vertex quantities are gathered from the face quantities, and the tangent basis is built from the face normal, so
+  // those face buffers get filled along the way (as they would have been by ensureHostBufferPopulated())
+  if (set.vertexNormals) {
+    set.faceNormals = true;
+    set.faceAreas = true;
   }
+  if (set.vertexAreas) set.faceAreas = true;
+  if (set.faceTangentBasis) set.faceNormals = true;
 
-  vertexAreas.markHostBufferUpdated();
-}
+  vertexPositions.ensureHostBufferPopulated();
 
-void SurfaceMesh::computeDefaultFaceTangentBasisX() {
+  if (set.faceTangentBasis) {
+    for (size_t iF = 0; iF < nFaces(); iF++) {
+      size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
+      if (D != 3) exception("Default face tangent spaces only available for pure-triangular meshes");
+    }
+  }
 
-  // NOTE: this function is weirdly duplicated into an 'X' and 'Y' paradigm to fit the compute-function-per-buffer
-  // paradigm
+  if (set.faceNormals) faceNormals.data.resize(nFaces());
+  if (set.faceCenters) faceCenters.data.resize(nFaces());
+  if (set.faceAreas) faceAreas.data.resize(nFaces());
+  if (set.faceTangentBasis) {
+    defaultFaceTangentBasisX.data.resize(nFaces());
+    defaultFaceTangentBasisY.data.resize(nFaces());
+  }
 
-  vertexPositions.ensureHostBufferPopulated();
-  faceNormals.ensureHostBufferPopulated();
+  // one pass over the faces computes every requested face quantity while the face's positions are at hand
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  parallelFor(0, nFaces(), [&](size_t begin, size_t end) {
+    for (size_t iF = begin; iF < end; iF++) {
+      size_t start = faceIndsStart[iF];
+      size_t D = faceIndsStart[iF + 1] - start;
+
+      if (set.faceNormals) {
+        glm::vec3 fN{0., 0., 0.};
+        if (D == 3) {
+          glm::vec3 pA = pos[faceIndsEntries[start + 0]];
+          glm::vec3 pB = pos[faceIndsEntries[start + 1]];
+          glm::vec3 pC = pos[faceIndsEntries[start + 2]];
+          fN = glm::cross(pB - pA, pC - pA);
+        } else {
+          for (size_t j = 0; j < D; j++) {
+            glm::vec3 pA = pos[faceIndsEntries[start + j]];
+            glm::vec3 pB = pos[faceIndsEntries[start + (j + 1) % D]];
+            glm::vec3 pC = pos[faceIndsEntries[start + (j + 2) % D]];
+            fN += glm::cross(pC - pB, pA - pB);
+          }
+        }
+        faceNormals.data[iF] = glm::normalize(fN);
+      }
 
-  defaultFaceTangentBasisX.data.resize(nFaces());
+      if (set.faceCenters) {
+        glm::vec3 faceCenter{0., 0., 0.};
+        for (size_t j = 0; j < D; j++) {
+          faceCenter += pos[faceIndsEntries[start + j]];
+        }
+        faceCenter /= D;
+        faceCenters.data[iF] = faceCenter;
+      }
 
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
-    if (D != 3) exception("Default face tangent spaces only available for pure-triangular meshes");
+      if (set.faceAreas) {
+        double fA;
+        if (D == 3) {
+          glm::vec3 pA = pos[faceIndsEntries[start + 0]];
+          glm::vec3 pB = pos[faceIndsEntries[start + 1]];
+          glm::vec3 pC = pos[faceIndsEntries[start + 2]];
+          fA = 0.5 * glm::length(glm::cross(pB - pA, pC - pA));
+        } else {
+          fA = 0;
+          glm::vec3 pRoot = pos[faceIndsEntries[start]];
+          for (size_t j = 1; j + 1 < D; j++) {
+            glm::vec3 pA = pos[faceIndsEntries[start + j]];
+            glm::vec3 pB = pos[faceIndsEntries[start + j + 1]];
+            fA += 0.5 * glm::length(glm::cross(pA - pRoot, pB - pRoot));
+          }
+        }
+        faceAreas.data[iF] = fA;
+      }
 
-    size_t start = faceIndsStart[iF];
+      if (set.faceTangentBasis) {
+        glm::vec3 pA = pos[faceIndsEntries[start + 0]];
+        glm::vec3 pB = pos[faceIndsEntries[start + 1]];
+        glm::vec3 N = faceNormals.data[iF];
 
-    glm::vec3 pA = vertexPositions.data[faceIndsEntries[start + 0]];
-    glm::vec3 pB = vertexPositions.data[faceIndsEntries[start + 1]];
-    glm::vec3 N = faceNormals.data[iF];
+        glm::vec3 basisX = pB - pA;
+        basisX = glm::normalize(basisX - N * glm::dot(N, basisX));
+        glm::vec3 basisY = glm::normalize(-glm::cross(basisX, N));
 
-    glm::vec3 basisX = pB - pA;
-    basisX = glm::normalize(basisX - N * glm::dot(N, basisX));
+        defaultFaceTangentBasisX.data[iF] = basisX;
+        defaultFaceTangentBasisY.data[iF] = basisY;
+      }
+    }
+  });
+
+  // vertex quantities gather from the adjacent faces, which are visited in face order so the sums come out the same
+  // as accumulating face-by-face
+  if (set.vertexNormals || set.vertexAreas) {
+    ensureHaveVertexFaceAdjacency();
+    if (set.vertexNormals) vertexNormals.data.resize(nVertices());
+    if (set.vertexAreas) vertexAreas.data.resize(nVertices());
+
+    parallelFor(0, nVertices(), [&](size_t begin, size_t end) {
+      for (size_t iV = begin; iV < end; iV++) {
+        glm::vec3 vN{0., 0., 0.};
+        float vA = 0.;
+        for (size_t i = vertexFaceAdjStart[iV]; i < vertexFaceAdjStart[iV + 1]; i++) {
+          size_t iF = vertexFaceAdjEntries[i];
+          if (set.vertexNormals) vN += faceNormals.data[iF] * faceAreas.data[iF];
+          if (set.vertexAreas) vA += faceAreas.data[iF] / (faceIndsStart[iF + 1] - faceIndsStart[iF]);
+        }
+        if (set.vertexNormals) vertexNormals.data[iV] = glm::normalize(vN);
+        if (set.vertexAreas) vertexAreas.data[iV] = vA;
+      }
+    });
+  }
 
-    glm::vec3 basisY = glm::normalize(-glm::cross(basisX, N));
+  if (set.faceNormals) faceNormals.markHostBufferUpdated();
+  if (set.faceCenters) faceCenters.markHostBufferUpdated();
+  if (set.faceAreas) faceAreas.markHostBufferUpdated();
+  if (set.faceTangentBasis) {
+    defaultFaceTangentBasisX.markHostBufferUpdated();
+    defaultFaceTangentBasisY.markHostBufferUpdated();
+  }
+  if (set.vertexNormals) vertexNormals.markHostBufferUpdated();
+  if (set.vertexAreas) vertexAreas.markHostBufferUpdated();
+}
+
+SurfaceMesh::GeometryBufferSet SurfaceMesh::recomputeNormalsOnDevice() {
+  GeometryBufferSet onDevice;
+
+  // Only normals which are populated and already mirrored to the device for drawing are worth doing there. Face normals
+  // are left to the host if a host computation needs them anyway (the tangent basis, or host-side vertex normals).
+  bool vertexNormalsOnHost = vertexNormals.hasData() && !vertexNormals.isDeviceResident();
+  bool tangentBasisOnHost = defaultFaceTangentBasisX.hasData() || defaultFaceTangentBasisY.hasData();
+  onDevice.vertexNormals = vertexNormals.hasData() && vertexNormals.isDeviceResident();
+  onDevice.faceNormals =
+      faceNormals.hasData() && faceNormals.isDeviceResident() && !vertexNormalsOnHost && !tangentBasisOnHost;
+  if (!onDevice.vertexNormals && !onDevice.faceNormals) return GeometryBufferSet();
+
+  if (!deviceFaceStart) {
+    ensureHaveVertexFaceAdjacency();
+    deviceFaceStart = render::engine->generateAttributeBuffer(RenderDataType::UInt);
+    deviceFaceStart->setData(faceIndsStart);
+    deviceFaceVerts = render::engine->generateAttributeBuffer(RenderDataType::UInt);
+    deviceFaceVerts->setData(faceIndsEntries);
+    deviceVertexFaceStart = render::engine->generateAttributeBuffer(RenderDataType::UInt);
+    deviceVertexFaceStart->setData(vertexFaceAdjStart);
+    deviceVertexFaces = render::engine->generateAttributeBuffer(RenderDataType::UInt);
+    deviceVertexFaces->setData(vertexFaceAdjEntries);
+  }
 
-    defaultFaceTangentBasisX.data[iF] = basisX;
+  std::shared_ptr<render::AttributeBuffer> positionsBuff = vertexPositions.getRenderAttributeBuffer();
+  std::shared_ptr<render::AttributeBuffer> faceNormalsBuff =
+      onDevice.faceNormals ? faceNormals.getRenderAttributeBuffer() : nullptr;
+  std::shared_ptr<render::AttributeBuffer> vertexNormalsBuff =
+      onDevice.vertexNormals ? vertexNormals.getRenderAttributeBuffer() : nullptr;
+  if (!render::engine->computeMeshNormalsOnDevice(*positionsBuff, *deviceFaceStart, *deviceFaceVerts,
+                                                  *deviceVertexFaceStart, *deviceVertexFaces, faceNormalsBuff.get(),
+                                                  vertexNormalsBuff.get())) {
+    return GeometryBufferSet();
   }
 
-  defaultFaceTangentBasisX.markHostBufferUpdated();
+  if (onDevice.faceNormals) faceNormals.markRenderAttributeBufferUpdated();
+  if (onDevice.vertexNormals) vertexNormals.markRenderAttributeBufferUpdated();
+  return onDevice;
 }
 
-void SurfaceMesh::computeDefaultFaceTangentBasisY() {
-
-  // NOTE: this function is weirdly duplicated into an 'X' and 'Y' paradigm to fit the compute-function-per-buffer
-  // paradigm
-
-  vertexPositions.ensureHostBufferPopulated();
-  faceNormals.ensureHostBufferPopulated();
-
-  defaultFaceTangentBasisY.data.resize(nFaces());
+void SurfaceMesh::computeFaceNormals() {
+  GeometryBufferSet set;
+  set.faceNormals = true;
+  computeGeometryBuffers(set);
+}
 
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
-    if (D != 3) exception("Default face tangent spaces only available for pure-triangular meshes");
+void SurfaceMesh::computeFaceCenters() {
+  GeometryBufferSet set;
+  set.faceCenters = true;
+  computeGeometryBuffers(set);
+}
 
-    size_t start = faceIndsStart[iF];
+void SurfaceMesh::computeFaceAreas() {
+  GeometryBufferSet set;
+  set.faceAreas = true;
+  computeGeometryBuffers(set);
+}
 
-    glm::vec3 pA = vertexPositions.data[faceIndsEntries[start + 0]];
-    glm::vec3 pB = vertexPositions.data[faceIndsEntries[start + 1]];
-    glm::vec3 N = faceNormals.data[iF];
+void SurfaceMesh::computeVertexNormals() {
+  GeometryBufferSet set;
+  set.vertexNormals = true;
+  computeGeometryBuffers(set);
+}
 
-    glm::vec3 basisX = pB - pA;
-    basisX = glm::normalize(basisX - N * glm::dot(N, basisX));
+void SurfaceMesh::computeVertexAreas() {
+  GeometryBufferSet set;
+  set.vertexAreas = true;
+  computeGeometryBuffers(set);
+}
 
-    glm::vec3 basisY = glm::normalize(-glm::cross(basisX, N));
+// NOTE: the tangent basis is split into an 'X' and 'Y' buffer to fit the compute-function-per-buffer paradigm, but
+// both halves are always filled together
 
-    defaultFaceTangentBasisY.data[iF] = basisY;
-  }
+void SurfaceMesh::computeDefaultFaceTangentBasisX() {
+  GeometryBufferSet set;
+  set.faceTangentBasis = true;
+  computeGeometryBuffers(set);
+}
 
-  defaultFaceTangentBasisY.markHostBufferUpdated();
+void SurfaceMesh::computeDefaultFaceTangentBasisY() {
+  GeometryBufferSet set;
+  set.faceTangentBasis = true;
+  computeGeometryBuffers(set);
 }
 
 // === Edge Lengths ===
@@ -634,6 +823,28 @@ void SurfaceMesh::checkTriangular() {
   }
 }
 
+void SurfaceMesh::ensureHaveVertexFaceAdjacency() {
+  if (!vertexFaceAdjStart.empty()) return; // already populated
+
+  // count the corners at each vertex, then bucket the faces by walking them in order, so each vertex's faces end up
+  // sorted by index
+  vertexFaceAdjStart.assign(nVertices() + 1, 0);
+  for (uint32_t iV : faceIndsEntries) {
+    vertexFaceAdjStart[iV + 1]++;
+  }
+  for (size_t iV = 0; iV < nVertices(); iV++) {
+    vertexFaceAdjStart[iV + 1] += vertexFaceAdjStart[iV];
+  }
+
+  vertexFaceAdjEntries.resize(faceIndsEntries.size());
+  std::vector<uint32_t> fillPos(vertexFaceAdjStart.begin(), vertexFaceAdjStart.end() - 1);
+  for (size_t iF = 0; iF < nFaces(); iF++) {
+    for (size_t i = faceIndsStart[iF]; i < faceIndsStart[iF + 1]; i++) {
+      vertexFaceAdjEntries[fillPos[faceIndsEntries[i]]++] = static_cast<uint32_t>(iF);
+    }
+  }
+}
+
 void SurfaceMesh::ensureHaveManifoldConnectivity() {
   if (!twinHalfedge.empty()) return; // already populated
 
@@ -696,8 +907,14 @@ void SurfaceMesh::draw() {
     return;
   }
 
+  bool prepared = drawPrepared;
+  drawPrepared = false;
+
   render::engine->setBackfaceCull(backFacePolicy.get() == BackFacePolicy::Cull);
 
+  updateVisibleChunks();
+  updateLODLevel();
+
   // If no quantity is drawing the surface, we should draw it
   if (dominantQuantity == nullptr) {
 
@@ -710,26 +927,37 @@ void SurfaceMesh::draw() {
     }
 
     // Set uniforms
-    setStructureUniforms(*program);
-    setSurfaceMeshUniforms(*program);
-    program->setUniform("u_baseColor", getSurfaceColor());
-    render::engine->setMaterialUniforms(*program, getMaterial());
+    if (!prepared) setSurfaceMeshProgramUniforms();
 
-    program->draw();
+    drawMeshProgram(*program);
   }
 
   // Draw the quantities
-  for (auto& x : quantities) {
-    x.second->draw();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->draw();
   }
 
   render::engine->setBackfaceCull(); // return to default setting
 
-  for (auto& x : floatingQuantities) {
-    x.second->draw();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->draw();
   }
 }
 
+void SurfaceMesh::prepareDraw() {
+  // the visible chunks and level of detail may touch buffers, draw() still updates those
+  if (!isEnabled() || dominantQuantity != nullptr || program == nullptr || positionKeyframes) return;
+  setSurfaceMeshProgramUniforms();
+  drawPrepared = true;
+}
+
+void SurfaceMesh::setSurfaceMeshProgramUniforms() {
+  setStructureUniforms(*program);
+  setSurfaceMeshUniforms(*program);
+  program->setUniform("u_baseColor", getSurfaceColor());
+  render::engine->setMaterialUniforms(*program, getMaterial());
+}
+
 void SurfaceMesh::drawDelayed() {
   if (!isEnabled()) {
     return;
@@ -737,14 +965,14 @@ void SurfaceMesh::drawDelayed() {
 
   render::engine->setBackfaceCull(backFacePolicy.get() == BackFacePolicy::Cull);
 
-  for (auto& x : quantities) {
-    x.second->drawDelayed();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->drawDelayed();
   }
 
   render::engine->setBackfaceCull(); // return to default setting
 
-  for (auto& x : floatingQuantities) {
-    x.second->drawDelayed();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->drawDelayed();
   }
 }
 
@@ -762,14 +990,15 @@ void SurfaceMesh::drawPick() {
   // Set uniforms
   setStructureUniforms(*pickProgram);
 
-  pickProgram->draw();
+  updateVisibleChunks();
+  drawMeshProgram(*pickProgram);
 
   render::engine->setBackfaceCull(); // return to default setting
 }
 
 void SurfaceMesh::prepare() {
   // clang-format off
-  program = render::engine->requestShader( "MESH", 
+  program = render::engine->requestShader(getVertexMeshProgramName(),
       render::engine->addMaterialRules(getMaterial(),
         addSurfaceMeshRules({"SHADE_BASECOLOR"})
       )
@@ -781,6 +1010,28 @@ void SurfaceMesh::prepare() {
   render::engine->setMaterial(*program, getMaterial());
 }
 
+bool SurfaceMesh::hasPendingHostData() {
+  // the mesh itself is about to be prepared, with its positions on the host to compute from
+  return isEnabled() && dominantQuantity == nullptr && program == nullptr && !vertexPositions.isCanonicalOnDevice() &&
+         !triangleVertexInds.isCanonicalOnDevice();
+}
+
+void SurfaceMesh::prepareHostData() {
+  // the buffers setMeshGeometryAttributes() will upload for the program prepare() requests
+  bool indexed = canDrawIndexed();
+  if (getShadeStyle() == MeshShadeStyle::Smooth) {
+    vertexNormals.ensureHostBufferComputed();
+  } else if (!indexed) {
+    faceNormals.ensureHostBufferComputed();
+  }
+  if (indexed && vertexCacheOrder) {
+    cacheOrderedVertexInds.ensureHostBufferComputed();
+  }
+  if (wantsCullPosition()) {
+    faceCenters.ensureHostBufferComputed();
+  }
+}
+
 void SurfaceMesh::preparePick() {
 
 
@@ -801,6 +1052,27 @@ void SurfaceMesh::preparePick() {
 }
 
 void SurfaceMesh::setMeshGeometryAttributes(render::ShaderProgram& p) {
+  if (p.hasAttribute("a_keyframeInd")) {
+    p.setAttribute("a_keyframeInd", getVertexAttributeBuffer(p, keyframeInds));
+  }
+
+  if (p.getDrawMode() == DrawMode::IndexedTriangles) {
+    // one entry per vertex, expanded to the corners by the index buffer (see canDrawIndexed())
+    std::shared_ptr<render::AttributeBuffer> positionsBuff = vertexPositions.getRenderAttributeBuffer();
+    p.setIndex(vertexCacheOrder ? cacheOrderedVertexInds.getRenderAttributeBuffer()
+                                : triangleVertexInds.getRenderAttributeBuffer());
+    if (p.hasAttribute("a_vertexPositions")) {
+      p.setAttribute("a_vertexPositions", positionsBuff);
+    }
+    if (p.hasAttribute("a_vertexNormals")) {
+      // as below, unused unless smooth shading but the shader still wants something
+      p.setAttribute("a_vertexNormals", getShadeStyle() == MeshShadeStyle::Smooth
+                                            ? vertexNormals.getRenderAttributeBuffer()
+                                            : positionsBuff);
+    }
+    return;
+  }
+
   if (p.hasAttribute("a_vertexPositions")) {
     p.setAttribute("a_vertexPositions", vertexPositions.getIndexedRenderAttributeBuffer(triangleVertexInds));
   }
@@ -817,15 +1089,18 @@ void SurfaceMesh::setMeshGeometryAttributes(render::ShaderProgram& p) {
   if (p.hasAttribute("a_normal")) {
     p.setAttribute("a_normal", faceNormals.getIndexedRenderAttributeBuffer(triangleFaceInds));
   }
-  if (p.hasAttribute("a_barycoord")) {
-    p.setAttribute("a_barycoord", baryCoord.getRenderAttributeBuffer());
-  }
-  if (p.hasAttribute("a_edgeIsReal")) {
-    p.setAttribute("a_edgeIsReal", edgeIsReal.getRenderAttributeBuffer());
+  if (p.hasTexture("t_edgeIsReal")) {
+    if (!edgeMaskTexture) {
+      edgeMaskTexture = generateEdgeMaskTexture(edgeIsReal.getPopulatedHostBufferRef());
+    }
+    p.setTextureFromBuffer("t_edgeIsReal", edgeMaskTexture.get());
   }
   if (wantsCullPosition()) {
     p.setAttribute("a_cullPos", faceCenters.getIndexedRenderAttributeBuffer(triangleFaceInds));
   }
+  if (p.hasAttribute("a_selectionInd")) {
+    p.setAttribute("a_selectionInd", triangleFaceInds.getRenderAttributeBuffer());
+  }
 
   if (transparencyQuantityName != "") {
     SurfaceScalarQuantity& transparencyQ = resolveTransparencyQuantity();
@@ -1000,7 +1275,8 @@ std::vector<std::string> SurfaceMesh::addSurfaceMeshRules(std::vector<std::strin
         initRules.push_back("MESH_WIREFRAME");
       }
 
-      if (shadeStyle.get() == MeshShadeStyle::TriFlat) {
+      // the normals computed on the host do not follow keyframed positions
+      if (shadeStyle.get() == MeshShadeStyle::TriFlat || hasPositionKeyframes()) {
         initRules.push_back("COMPUTE_SHADE_NORMAL_FROM_POSITION");
         initRules.push_back("PROJ_AND_INV_PROJ_MAT");
       }
@@ -1011,6 +1287,10 @@ std::vector<std::string> SurfaceMesh::addSurfaceMeshRules(std::vector<std::strin
       if (backFacePolicy.get() == BackFacePolicy::Custom) {
         initRules.push_back("MESH_BACKFACE_DIFFERENT");
       }
+
+      if (faceSelection) {
+        initRules.push_back("MESH_PROPAGATE_SELECTION");
+      }
     }
 
     if (backFacePolicy.get() == BackFacePolicy::Identical) {
@@ -1033,6 +1313,9 @@ std::vector<std::string> SurfaceMesh::addSurfaceMeshRules(std::vector<std::strin
       initRules.push_back("MESH_PROPAGATE_VALUEALPHA");
     }
   }
+  if (hasPositionKeyframes()) {
+    addKeyframeRule(initRules, "MESH_KEYFRAME_POSITIONS");
+  }
   return initRules;
 }
 
@@ -1044,7 +1327,11 @@ void SurfaceMesh::setSurfaceMeshUniforms(render::ShaderProgram& p) {
   if (backFacePolicy.get() == BackFacePolicy::Custom) {
     p.setUniform("u_backfaceColor", getBackFaceColor());
   }
-  if (shadeStyle.get() == MeshShadeStyle::TriFlat) {
+  if (faceSelection && p.hasTexture("t_selection")) {
+    p.setTextureFromBuffer("t_selection", faceSelection->getTexture());
+    p.setUniform("u_selectionColor", faceSelection->getColor());
+  }
+  if (p.hasUniform("u_invProjMatrix")) {
     glm::mat4 P = view::getCameraPerspectiveMatrix();
     glm::mat4 Pinv = glm::inverse(P);
     p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
@@ -1052,6 +1339,332 @@ void SurfaceMesh::setSurfaceMeshUniforms(render::ShaderProgram& p) {
   }
 }
 
+void SurfaceMesh::updateVisibleChunks() {
+  visibleChunkRanges.clear();
+  nVisibleChunksCount = 0;
+  if (trianglesPerChunk == 0) return;
+
+  chunkCornerOrder.ensureHostBufferPopulated();
+
+  // Chunks which are entirely backfacing can be skipped when backfaces are culled anyway. The test happens in object
+  // space, where facing is the same as in world space up to the handedness of the transform, which flips the winding.
+  bool cullBackfacingChunks =
+      options::frustumCulling && !hasPositionKeyframes() && backFacePolicy.get() == BackFacePolicy::Cull;
+  bool perspective = view::projectionMode == ProjectionMode::Perspective;
+  glm::vec3 objectSpaceEye{0., 0., 0.};
+  glm::vec3 objectSpaceLookDir{0., 0., 1.};
+  bool flipFacing = false;
+  if (cullBackfacingChunks) {
+    glm::dmat4 T = getModelMatrix();
+    glm::dmat4 Tinv = glm::inverse(T);
+    objectSpaceEye = glm::vec3(Tinv * glm::dvec4(view::getCameraWorldPositionDouble(), 1.));
+    glm::vec3 lookDir, upDir, rightDir;
+    view::getCameraFrame(lookDir, upDir, rightDir);
+    objectSpaceLookDir = glm::normalize(glm::mat3(Tinv) * lookDir);
+    flipFacing = (glm::determinant(glm::mat3(T)) < 0.) != !render::engine->getFrontFaceCCW();
+  }
+
+  for (const TriangleChunk& chunk : chunks) {
+    // the chunk bounds are those of the host positions, which keyframed positions can leave
+    if (options::frustumCulling && !hasPositionKeyframes() &&
+        (!objectSpaceBoxInViewFrustum(chunk.objectSpaceBoundingBox, 0.) ||
+         objectSpaceBoxSlicedAway(chunk.objectSpaceBoundingBox, 0.) ||
+         objectSpaceBoxOccluded(chunk.objectSpaceBoundingBox, 0.))) {
+      continue;
+    }
+    if (cullBackfacingChunks && chunkIsBackfacing(chunk, perspective, objectSpaceEye, objectSpaceLookDir, flipFacing)) {
+      continue;
+    }
+    nVisibleChunksCount++;
+
+    // merge with the previous range when they are adjacent, to keep the number of draw ranges small
+    size_t first = 3 * chunk.triangleStart;
+    size_t count = 3 * chunk.triangleCount;
+    if (!visibleChunkRanges.empty() && visibleChunkRanges.back()[0] + visibleChunkRanges.back()[1] == first) {
+      visibleChunkRanges.back()[1] += count;
+    } else {
+      visibleChunkRanges.push_back({{first, count}});
+    }
+  }
+}
+
+bool SurfaceMesh::canDrawIndexed() {
+  MeshShadeStyle style = getShadeStyle();
+  if (style != MeshShadeStyle::Smooth && style != MeshShadeStyle::TriFlat) return false;
+  return getEdgeWidth() <= 0 && !wantsCullPosition() && transparencyQuantityName == "" && trianglesPerChunk == 0 &&
+         !faceSelection;
+}
+
+std::string SurfaceMesh::getVertexMeshProgramName() { return canDrawIndexed() ? "INDEXED_MESH" : "MESH"; }
+
+namespace {
+
+// Element textures are laid out in rows of this many texels. Element indices reach the shader as floats, which are
+// exact up to 2^24, and as many rows hold that many elements.
+const size_t elementTextureWidth = 4096;
+
+std::shared_ptr<render::TextureBuffer> generateElementTextureFrom(const float* data, size_t nElements, int nComponents,
+                                                                  TextureFormat format) {
+  if (nElements == 0 || nElements > elementTextureWidth * elementTextureWidth) return nullptr;
+
+  size_t width = std::min(nElements, elementTextureWidth);
+  size_t height = (nElements + width - 1) / width;
+  std::vector<float> padded(width * height * nComponents, 0.);
+  std::copy(data, data + nElements * nComponents, padded.begin());
+  return render::engine->generateTextureBuffer(format, static_cast<unsigned int>(width),
+                                               static_cast<unsigned int>(height), &padded[0]);
+}
+
+void updateElementTextureFrom(render::TextureBuffer& texture, const float* data, size_t nElements, int nComponents) {
+  unsigned int width = texture.getSizeX();
+  unsigned int nFullRows = static_cast<unsigned int>(nElements / width);
+  unsigned int nLastRow = static_cast<unsigned int>(nElements % width);
+  if (nFullRows > 0) {
+    texture.setDataRect(data, nComponents, PixelComponentType::Float32, 0, 0, width, nFullRows);
+  }
+  if (nLastRow > 0) {
+    texture.setDataRect(data + static_cast<size_t>(nFullRows) * width * nComponents, nComponents,
+                        PixelComponentType::Float32, 0, nFullRows, nLastRow, 1);
+  }
+}
+
+} // namespace
+
+std::shared_ptr<render::TextureBuffer> SurfaceMesh::generateElementTexture(const std::vector<float>& data) {
+  return generateElementTextureFrom(data.data(), data.size(), 1, TextureFormat::R32F);
+}
+
+std::shared_ptr<render::TextureBuffer> SurfaceMesh::generateElementTexture(const float* data, size_t nElements) {
+  return generateElementTextureFrom(data, nElements, 1, TextureFormat::R32F);
+}
+
+std::shared_ptr<render::TextureBuffer> SurfaceMesh::generateElementTexture(const std::vector<glm::vec3>& data) {
+  return generateElementTextureFrom(reinterpret_cast<const float*>(data.data()), data.size(), 3,
+                                    TextureFormat::RGB32F);
+}
+
+void SurfaceMesh::updateElementTexture(render::TextureBuffer& texture, const std::vector<float>& data) {
+  updateElementTextureFrom(texture, data.data(), data.size(), 1);
+}
+
+void SurfaceMesh::updateElementTexture(render::TextureBuffer& texture, const float* data, size_t nElements) {
+  updateElementTextureFrom(texture, data, nElements, 1);
+}
+
+void SurfaceMesh::updateElementTexture(render::TextureBuffer& texture, const std::vector<glm::vec3>& data) {
+  updateElementTextureFrom(texture, reinterpret_cast<const float*>(data.data()), data.size(), 3);
+}
+
+std::shared_ptr<render::TextureBuffer> SurfaceMesh::generateEdgeMaskTexture(const std::vector<glm::vec3>& edgeIsReal) {
+  // 8 masks of 3 bits fit in the 24 bits a float holds exactly
+  size_t nTri = edgeIsReal.size() / 3;
+  std::vector<float> packed((nTri + 7) / 8);
+  parallelFor(0, packed.size(), [&](size_t begin, size_t end) {
+    for (size_t iTexel = begin; iTexel < end; iTexel++) {
+      uint32_t bits = 0;
+      for (size_t j = 0; j < 8 && 8 * iTexel + j < nTri; j++) {
+        const glm::vec3& real = edgeIsReal[3 * (8 * iTexel + j)];
+        uint32_t mask = (real.x != 0.f ? 1u : 0u) | (real.y != 0.f ? 2u : 0u) | (real.z != 0.f ? 4u : 0u);
+        bits |= mask << (3 * j);
+      }
+      packed[iTexel] = static_cast<float>(bits);
+    }
+  });
+
+  std::shared_ptr<render::TextureBuffer> texture = generateElementTexture(packed);
+  if (!texture) {
+    // empty or too large, a single texel with every edge real
+    texture = generateElementTexture(std::vector<float>{static_cast<float>(0xFFFFFF)});
+  }
+  return texture;
+}
+
+void SurfaceMesh::drawMeshProgram(render::ShaderProgram& p) {
+  if (lodLevelDrawn > 0 && p.getDrawMode() == DrawMode::IndexedTriangles) {
+    const LODLevel& level = lodLevels[lodLevelDrawn - 1];
+    std::vector<std::array<size_t, 2>> ranges;
+    ranges.push_back({{level.cornerStart, level.cornerCount}});
+    p.drawSubset(*lodTriangleVertexInds.getRenderAttributeBuffer(), ranges);
+    return;
+  }
+
+  if (trianglesPerChunk == 0) {
+    p.draw();
+    return;
+  }
+
+  p.drawSubset(*chunkCornerOrder.getRenderAttributeBuffer(), visibleChunkRanges);
+}
+
+SurfaceMesh::LODChain SurfaceMesh::computeLODChain(const std::vector<glm::vec3>& positions,
+                                                   const std::vector<uint32_t>& triangleVertexInds,
+                                                   std::shared_ptr<std::atomic<bool>> cancel) {
+  LODChain chain;
+
+  glm::vec3 bMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  glm::vec3 bMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (const glm::vec3& p : positions) {
+    bMin = componentwiseMin(bMin, p);
+    bMax = componentwiseMax(bMax, p);
+  }
+  float diag = glm::length(bMax - bMin);
+  if (!(diag > 0.f) || !std::isfinite(diag)) return chain;
+
+  // Start from cells somewhat larger than the typical vertex spacing of a surface, and double them for each level. Each
+  // level simplifies the previous one, so the work shrinks along with the triangle count.
+  const size_t maxLevels = 16;
+  const size_t minTriangles = 64;
+  float cellSize = 2.f * diag / std::sqrt(static_cast<float>(positions.size()));
+  const std::vector<uint32_t>* prev = &triangleVertexInds;
+  std::vector<uint32_t> current;
+  for (int iter = 0; iter < 32 && chain.levels.size() < maxLevels && prev->size() / 3 > minTriangles; iter++) {
+    if (cancel->load()) return LODChain();
+
+    std::vector<uint32_t> next = clusterSimplifyTriangles(positions, *prev, cellSize);
+    if (next.empty()) break;
+
+    // only keep levels which save a meaningful number of triangles
+    if (next.size() < 9 * prev->size() / 10) {
+      chain.levels.push_back(LODLevel{chain.triangleVertexInds.size(), next.size(), cellSize});
+      chain.triangleVertexInds.insert(chain.triangleVertexInds.end(), next.begin(), next.end());
+    }
+    current = std::move(next);
+    prev = &current;
+    cellSize *= 2.f;
+  }
+
+  return chain;
+}
+
+void SurfaceMesh::startLODBuild() {
+  cancelLODBuild();
+  lodChainStale = false;
+
+  // the build works on its own copy of the data, so the mesh can change (or be deleted) while it runs
+  vertexPositions.ensureHostBufferPopulated();
+  triangleVertexInds.ensureHostBufferPopulated();
+  lodBuildCancel = std::make_shared<std::atomic<bool>>(false);
+  std::packaged_task<LODChain()> task(std::bind(&SurfaceMesh::computeLODChain, vertexPositions.data,
+                                                triangleVertexInds.data, lodBuildCancel));
+  lodBuild = task.get_future();
+  std::thread(std::move(task)).detach();
+}
+
+void SurfaceMesh::cancelLODBuild() {
+  if (lodBuildCancel) lodBuildCancel->store(true);
+  lodBuildCancel.reset();
+  lodBuild = std::future<LODChain>(); // does not wait for the thread, it finishes on its own
+}
+
+void SurfaceMesh::installLODChain(bool waitForBuild) {
+  if (!lodBuild.valid()) return;
+  if (!waitForBuild && lodBuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+  LODChain chain = lodBuild.get();
+  lodBuildCancel.reset();
+  lodLevels = chain.levels;
+  lodTriangleVertexInds.data = std::move(chain.triangleVertexInds);
+  lodTriangleVertexInds.markHostBufferUpdated();
+  requestRedraw();
+}
+
+void SurfaceMesh::updateLODLevel() {
+  lodLevelDrawn = 0;
+  if (!lodEnabled) return;
+
+  // Take a finished build, and start the next one if the positions changed since. Until then the previous chain is
+  // drawn, it indexes the same vertices so it follows the new positions, if only approximately.
+  installLODChain(false);
+  if (lodChainStale && !lodBuild.valid()) startLODBuild();
+
+  if (lodLevels.empty() || !canDrawIndexed() || hasPositionKeyframes()) return;
+
+  const glm::vec3& bMin = std::get<0>(objectSpaceBoundingBox);
+  const glm::vec3& bMax = std::get<1>(objectSpaceBoundingBox);
+  glm::mat4 modelView = getModelView();
+  glm::vec3 viewMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  glm::vec3 viewMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (int iC = 0; iC < 8; iC++) {
+    glm::vec3 corner{(iC & 1) ? bMax.x : bMin.x, (iC & 2) ? bMax.y : bMin.y, (iC & 4) ? bMax.z : bMin.z};
+    glm::vec3 p = glm::vec3(modelView * glm::vec4(corner, 1.));
+    viewMin = componentwiseMin(viewMin, p);
+    viewMax = componentwiseMax(viewMax, p);
+  }
+
+  // pixels per object space unit, where the bounding box comes nearest to the camera
+  glm::mat4 P = view::getCameraPerspectiveMatrix();
+  float pixelsPerUnit = 0.5f * render::engine->getCurrentViewport().w * P[1][1];
+  if (view::projectionMode == ProjectionMode::Perspective) {
+    float dist = glm::length(glm::clamp(glm::vec3{0., 0., 0.}, viewMin, viewMax));
+    if (!(dist > 0.f)) return; // the camera is within the bounds, draw everything
+    pixelsPerUnit /= dist;
+  }
+  pixelsPerUnit *= std::cbrt(std::abs(glm::determinant(glm::mat3(modelView))));
+  if (!std::isfinite(pixelsPerUnit)) return;
+
+  for (size_t i = 0; i < lodLevels.size(); i++) {
+    if (lodLevels[i].cellSize * pixelsPerUnit > lodPixelError) break;
+    lodLevelDrawn = i + 1;
+  }
+}
+
+
+bool SurfaceMesh::supportsRayCastPicking() {
+  // Only the simple pick mode, with just vertices and faces, is reproduced by the ray cast
+  bool simplePick = !(edgesHaveBeenUsed || halfedgesHaveBeenUsed || cornersHaveBeenUsed);
+  return simplePick && !hasPositionKeyframes() && getBackFacePolicy() != BackFacePolicy::Cull;
+}
+
+bool SurfaceMesh::rayCastPick(glm::dvec3 worldRayStart, glm::vec3 rayDir, float& tHit, size_t& localPickInd) {
+  vertexPositions.ensureHostBufferPopulated();
+  triangleVertexInds.ensureHostBufferPopulated();
+  triangleFaceInds.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  const std::vector<uint32_t>& triVerts = triangleVertexInds.data;
+  size_t nTris = triVerts.size() / 3;
+  ensurePickBVH(nTris, [&](std::vector<BVH::Box>& boxes) {
+    parallelFor(0, nTris, [&](size_t chunkBegin, size_t chunkEnd) {
+      for (size_t iT = chunkBegin; iT < chunkEnd; iT++) {
+        glm::vec3 pA = pos[triVerts[3 * iT + 0]];
+        glm::vec3 pB = pos[triVerts[3 * iT + 1]];
+        glm::vec3 pC = pos[triVerts[3 * iT + 2]];
+        boxes[iT] = BVH::Box{glm::min(pA, glm::min(pB, pC)), glm::max(pA, glm::max(pB, pC))};
+      }
+    });
+  });
+
+  glm::vec3 rayStart = worldRayToObjectSpace(worldRayStart, rayDir);
+  size_t hitTri = 0;
+  glm::vec3 hitBary;
+  bool hit = pickBVH->rayCast(rayStart, rayDir, tHit, [&](size_t iT, float& tMax) {
+    float t;
+    glm::vec3 bary;
+    if (!rayTriangleIntersection(rayStart, rayDir, pos[triVerts[3 * iT + 0]], pos[triVerts[3 * iT + 1]],
+                                 pos[triVerts[3 * iT + 2]], t, bary) ||
+        t >= tMax) {
+      return false;
+    }
+    tMax = t;
+    hitTri = iT;
+    hitBary = bary;
+    return true;
+  });
+  if (!hit) return false;
+
+  // Same local indexing as the simple pick buffer, the pick buffer may not have been rendered yet to set it
+  facePickIndStart = nVertices();
+  edgePickIndStart = facePickIndStart + nFaces();
+  halfedgePickIndStart = edgePickIndStart;
+  cornerPickIndStart = halfedgePickIndStart + nHalfedges();
+
+  // Like MESH_PROPAGATE_PICK_SIMPLE, vertices are picked near the corners and the face elsewhere
+  const float vertRadius = 0.2;
+  localPickInd = facePickIndStart + triangleFaceInds.data[3 * hitTri];
+  for (int j = 0; j < 3; j++) {
+    if (hitBary[j] > 1. - vertRadius) localPickInd = triVerts[3 * hitTri + j];
+  }
+  return true;
+}
 
 void SurfaceMesh::buildPickUI(size_t localPickID) {
 
@@ -1209,6 +1822,10 @@ void SurfaceMesh::buildCustomUI() {
   long long int nVertsL = static_cast<long long int>(nVertices());
   long long int nFacesL = static_cast<long long int>(nFaces());
   ImGui::Text("#verts: %lld  #faces: %lld", nVertsL, nFacesL);
+  if (lodLevelDrawn > 0) {
+    ImGui::SameLine();
+    ImGui::TextDisabled("(drawing %s tris)", prettyPrintCount(lodLevels[lodLevelDrawn - 1].cornerCount / 3).c_str());
+  }
 
   { // Colors
     if (ImGui::ColorEdit3("Color", &surfaceColor.get()[0], ImGuiColorEditFlags_NoInputs))
@@ -1310,6 +1927,8 @@ void SurfaceMesh::buildCustomOptionsUI() {
     ImGui::EndMenu();
   }
 
+  if (ImGui::MenuItem("Level of Detail", NULL, lodEnabled)) setLODEnabled(!lodEnabled);
+
   // transparency quantity
   if (ImGui::BeginMenu("Per-Element Transparency")) {
 
@@ -1332,12 +1951,24 @@ void SurfaceMesh::buildCustomOptionsUI() {
 }
 
 void SurfaceMesh::recomputeGeometryIfPopulated() {
-  faceNormals.recomputeIfPopulated();
-  faceCenters.recomputeIfPopulated();
-  faceAreas.recomputeIfPopulated();
-  vertexNormals.recomputeIfPopulated();
-  vertexAreas.recomputeIfPopulated();
+  // recompute everything that is populated in one fused pass, rather than one pass per buffer, except the normals
+  // which can be recomputed where they are drawn
+  GeometryBufferSet onDevice = recomputeNormalsOnDevice();
+  GeometryBufferSet set;
+  set.faceNormals = faceNormals.hasData() && !onDevice.faceNormals;
+  set.faceCenters = faceCenters.hasData();
+  set.faceAreas = faceAreas.hasData();
+  set.vertexNormals = vertexNormals.hasData() && !onDevice.vertexNormals;
+  set.vertexAreas = vertexAreas.hasData();
+  set.faceTangentBasis = defaultFaceTangentBasisX.hasData() || defaultFaceTangentBasisY.hasData();
+  if (set.faceNormals || set.faceCenters || set.faceAreas || set.vertexNormals || set.vertexAreas ||
+      set.faceTangentBasis) {
+    computeGeometryBuffers(set);
+  }
   // edgeLengths.recomputeIfPopulated();
+
+  // the chunk ordering is kept as-is, so the order buffer need not be re-uploaded, but the bounds follow the vertices
+  if (chunkCornerOrder.hasData()) computeChunkBounds();
 }
 
 void SurfaceMesh::refresh() {
@@ -1349,26 +1980,32 @@ void SurfaceMesh::refresh() {
   QuantityStructure<SurfaceMesh>::refresh(); // call base class version, which refreshes quantities
 }
 
-void SurfaceMesh::updateObjectSpaceBounds() {
+ElementSelection& SurfaceMesh::getFaceSelection() {
+  if (!faceSelection) {
+    faceSelection.reset(new ElementSelection(nFaces()));
+    refreshShaderPrograms(); // the programs gain the selection rule, and stop drawing indexed
+  }
+  return *faceSelection;
+}
 
-  vertexPositions.ensureHostBufferPopulated();
+bool SurfaceMesh::hasFaceSelection() { return faceSelection != nullptr; }
 
-  // bounding box
-  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  for (const glm::vec3& p : vertexPositions.data) {
-    min = componentwiseMin(min, p);
-    max = componentwiseMax(max, p);
-  }
-  objectSpaceBoundingBox = std::make_tuple(min, max);
+void SurfaceMesh::removeFaceSelection() {
+  if (!faceSelection) return;
+  faceSelection.reset();
+  refreshShaderPrograms();
+}
 
-  // length scale, as twice the radius from the center of the bounding box
-  glm::vec3 center = 0.5f * (min + max);
-  float lengthScale = 0.0;
-  for (const glm::vec3& p : vertexPositions.data) {
-    lengthScale = std::max(lengthScale, glm::length2(p - center));
-  }
-  objectSpaceLengthScale = 2 * std::sqrt(lengthScale);
+void SurfaceMesh::refreshShaderPrograms() {
+  program.reset();
+  pickProgram.reset();
+  refreshQuantityShaderPrograms();
+}
+
+void SurfaceMesh::updateObjectSpaceBounds() {
+  vertexPositions.ensureHostBufferPopulated();
+  setObjectSpaceBoundsFromPoints(vertexPositions.data);
+  includeKeyframesInBounds();
 }
 
 std::string SurfaceMesh::typeName() { return structureTypeName; }
@@ -1540,8 +2177,9 @@ SurfaceMesh* SurfaceMesh::setEdgeColor(glm::vec3 val) {
 glm::vec3 SurfaceMesh::getEdgeColor() { return edgeColor.get(); }
 
 SurfaceMesh* SurfaceMesh::setMaterial(std::string m) {
+  bool needsRefresh = render::engine->materialChangeNeedsRefresh(material.get(), m);
   material = m;
-  refresh(); // (serves the purpose of re-initializing everything, though this is a bit overkill)
+  if (needsRefresh) refresh();
   requestRedraw();
   return this;
 }
@@ -1571,21 +2209,77 @@ SurfaceMesh* SurfaceMesh::setShadeStyle(MeshShadeStyle newStyle) {
 }
 MeshShadeStyle SurfaceMesh::getShadeStyle() { return shadeStyle.get(); }
 
+SurfaceMesh* SurfaceMesh::setChunkSize(size_t newTrianglesPerChunk) {
+  bool wasIndexed = canDrawIndexed();
+  trianglesPerChunk = newTrianglesPerChunk;
+  if (chunkCornerOrder.hasData()) computeChunkBounds();
+  if (canDrawIndexed() != wasIndexed) refresh(); // chunked drawing needs the expanded programs
+  requestRedraw();
+  return this;
+}
+size_t SurfaceMesh::getChunkSize() { return trianglesPerChunk; }
+
+SurfaceMesh* SurfaceMesh::setVertexCacheOrder(bool newVal) {
+  vertexCacheOrder = newVal;
+  refresh();
+  requestRedraw();
+  return this;
+}
+bool SurfaceMesh::getVertexCacheOrder() { return vertexCacheOrder; }
+
+size_t SurfaceMesh::nChunks() {
+  if (trianglesPerChunk == 0) return 0;
+  chunkCornerOrder.ensureHostBufferPopulated();
+  return chunks.size();
+}
+size_t SurfaceMesh::nVisibleChunks() { return nVisibleChunksCount; }
+
+SurfaceMesh* SurfaceMesh::setLODEnabled(bool newVal) {
+  if (newVal == lodEnabled) return this;
+  lodEnabled = newVal;
+  if (lodEnabled) {
+    startLODBuild();
+  } else {
+    cancelLODBuild();
+    lodLevels.clear();
+    lodLevelDrawn = 0;
+    lodTriangleVertexInds.data.clear();
+    lodTriangleVertexInds.markHostBufferUpdated();
+  }
+  requestRedraw();
+  return this;
+}
+bool SurfaceMesh::getLODEnabled() { return lodEnabled; }
+
+SurfaceMesh* SurfaceMesh::setLODPixelError(float newVal) {
+  lodPixelError = newVal;
+  requestRedraw();
+  return this;
+}
+float SurfaceMesh::getLODPixelError() { return lodPixelError; }
+
+size_t SurfaceMesh::nLODLevels() { return lodLevels.size(); }
+size_t SurfaceMesh::getLODLevelDrawn() { return lodLevelDrawn; }
+
+void SurfaceMesh::waitForLODBuild() {
+  if (!lodEnabled) return;
+  if (lodChainStale && !lodBuild.valid()) startLODBuild();
+  installLODChain(true);
+}
+
 // === Quantity adders
 
 
-SurfaceVertexColorQuantity* SurfaceMesh::addVertexColorQuantityImpl(std::string name,
-                                                                    const std::vector<glm::vec3>& colors) {
+SurfaceVertexColorQuantity* SurfaceMesh::addVertexColorQuantityImpl(std::string name, std::vector<glm::vec3> colors) {
   checkForQuantityWithNameAndDeleteOrError(name);
-  SurfaceVertexColorQuantity* q = new SurfaceVertexColorQuantity(name, *this, colors);
+  SurfaceVertexColorQuantity* q = new SurfaceVertexColorQuantity(name, *this, std::move(colors));
   addQuantity(q);
   return q;
 }
 
-SurfaceFaceColorQuantity* SurfaceMesh::addFaceColorQuantityImpl(std::string name,
-                                                                const std::vector<glm::vec3>& colors) {
+SurfaceFaceColorQuantity* SurfaceMesh::addFaceColorQuantityImpl(std::string name, std::vector<glm::vec3> colors) {
   checkForQuantityWithNameAndDeleteOrError(name);
-  SurfaceFaceColorQuantity* q = new SurfaceFaceColorQuantity(name, *this, colors);
+  SurfaceFaceColorQuantity* q = new SurfaceFaceColorQuantity(name, *this, std::move(colors));
   addQuantity(q);
   return q;
 }
@@ -1656,18 +2350,79 @@ SurfaceMesh::addLocalParameterizationQuantityImpl(std::string name, const std::v
   return q;
 }
 
-SurfaceVertexScalarQuantity* SurfaceMesh::addVertexScalarQuantityImpl(std::string name, const std::vector<float>& data,
+SurfaceVertexScalarQuantity* SurfaceMesh::addVertexScalarQuantityImpl(std::string name, std::vector<float> data,
+                                                                      DataType type) {
+  checkForQuantityWithNameAndDeleteOrError(name);
+  SurfaceVertexScalarQuantity* q = new SurfaceVertexScalarQuantity(name, std::move(data), *this, type);
+  addQuantity(q);
+  return q;
+}
+
+SurfaceVertexScalarQuantity* SurfaceMesh::addVertexScalarQuantity(std::string name, std::vector<float>&& data,
+                                                                  DataType type) {
+  validateSize(data, vertexDataSize, "vertex scalar quantity " + name);
+  return addVertexScalarQuantityImpl(name, std::move(data), type);
+}
+
+SurfaceFaceScalarQuantity* SurfaceMesh::addFaceScalarQuantity(std::string name, std::vector<float>&& data,
+                                                              DataType type) {
+  validateSize(data, faceDataSize, "face scalar quantity " + name);
+  return addFaceScalarQuantityImpl(name, std::move(data), type);
+}
+
+SurfaceVertexColorQuantity* SurfaceMesh::addVertexColorQuantity(std::string name, std::vector<glm::vec3>&& colors) {
+  validateSize(colors, vertexDataSize, "vertex color quantity " + name);
+  return addVertexColorQuantityImpl(name, std::move(colors));
+}
+
+SurfaceFaceColorQuantity* SurfaceMesh::addFaceColorQuantity(std::string name, std::vector<glm::vec3>&& colors) {
+  validateSize(colors, faceDataSize, "face color quantity " + name);
+  return addFaceColorQuantityImpl(name, std::move(colors));
+}
+
+SurfaceVertexVectorQuantity* SurfaceMesh::addVertexVectorQuantity(std::string name, std::vector<glm::vec3>&& vectors,
+                                                                  VectorType vectorType) {
+  validateSize(vectors, vertexDataSize, "vertex vector quantity " + name);
+  return addVertexVectorQuantityImpl(name, std::move(vectors), vectorType);
+}
+
+SurfaceFaceVectorQuantity* SurfaceMesh::addFaceVectorQuantity(std::string name, std::vector<glm::vec3>&& vectors,
+                                                              VectorType vectorType) {
+  validateSize(vectors, faceDataSize, "face vector quantity " + name);
+  return addFaceVectorQuantityImpl(name, std::move(vectors), vectorType);
+}
+
+SurfaceVertexScalarQuantity* SurfaceMesh::addVertexScalarQuantityView(std::string name, const float* values,
+                                                                      size_t count, std::shared_ptr<void> lifetimeToken,
                                                                       DataType type) {
+  if (count != nVertices()) {
+    exception("surface mesh vertex scalar quantity " + name + " view has size " + std::to_string(count) +
+              ", expected " + std::to_string(nVertices()));
+  }
+  checkForQuantityWithNameAndDeleteOrError(name);
+  SurfaceVertexScalarQuantity* q = new SurfaceVertexScalarQuantity(name, std::vector<float>(), *this, type);
+  q->setValuesView(values, count, lifetimeToken);
+  addQuantity(q);
+  return q;
+}
+
+SurfaceFaceScalarQuantity* SurfaceMesh::addFaceScalarQuantityView(std::string name, const float* values, size_t count,
+                                                                  std::shared_ptr<void> lifetimeToken, DataType type) {
+  if (count != nFaces()) {
+    exception("surface mesh face scalar quantity " + name + " view has size " + std::to_string(count) +
+              ", expected " + std::to_string(nFaces()));
+  }
   checkForQuantityWithNameAndDeleteOrError(name);
-  SurfaceVertexScalarQuantity* q = new SurfaceVertexScalarQuantity(name, data, *this, type);
+  SurfaceFaceScalarQuantity* q = new SurfaceFaceScalarQuantity(name, std::vector<float>(), *this, type);
+  q->setValuesView(values, count, lifetimeToken);
   addQuantity(q);
   return q;
 }
 
-SurfaceFaceScalarQuantity* SurfaceMesh::addFaceScalarQuantityImpl(std::string name, const std::vector<float>& data,
+SurfaceFaceScalarQuantity* SurfaceMesh::addFaceScalarQuantityImpl(std::string name, std::vector<float> data,
                                                                   DataType type) {
   checkForQuantityWithNameAndDeleteOrError(name);
-  SurfaceFaceScalarQuantity* q = new SurfaceFaceScalarQuantity(name, data, *this, type);
+  SurfaceFaceScalarQuantity* q = new SurfaceFaceScalarQuantity(name, std::move(data), *this, type);
   addQuantity(q);
   return q;
 }
@@ -1713,20 +2468,19 @@ SurfaceTextureScalarQuantity* SurfaceMesh::addTextureScalarQuantityImpl(std::str
   return q;
 }
 
-SurfaceVertexVectorQuantity* SurfaceMesh::addVertexVectorQuantityImpl(std::string name,
-                                                                      const std::vector<glm::vec3>& vectors,
+SurfaceVertexVectorQuantity* SurfaceMesh::addVertexVectorQuantityImpl(std::string name, std::vector<glm::vec3> vectors,
                                                                       VectorType vectorType) {
   checkForQuantityWithNameAndDeleteOrError(name);
-  SurfaceVertexVectorQuantity* q = new SurfaceVertexVectorQuantity(name, vectors, *this, vectorType);
+  SurfaceVertexVectorQuantity* q = new SurfaceVertexVectorQuantity(name, std::move(vectors), *this, vectorType);
   addQuantity(q);
   return q;
 }
 
 SurfaceFaceVectorQuantity*
-SurfaceMesh::addFaceVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors, VectorType vectorType) {
+SurfaceMesh::addFaceVectorQuantityImpl(std::string name, std::vector<glm::vec3> vectors, VectorType vectorType) {
 
   checkForQuantityWithNameAndDeleteOrError(name);
-  SurfaceFaceVectorQuantity* q = new SurfaceFaceVectorQuantity(name, vectors, *this, vectorType);
+  SurfaceFaceVectorQuantity* q = new SurfaceFaceVectorQuantity(name, std::move(vectors), *this, vectorType);
   addQuantity(q);
   return q;
 }
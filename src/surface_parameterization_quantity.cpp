@@ -6,7 +6,9 @@
 #include <set>
 
 #include "polyscope/curve_network.h"
+#include "polyscope/disjoint_sets.h"
 #include "polyscope/file_helpers.h"
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 
@@ -45,7 +47,7 @@ void SurfaceParameterizationQuantity::draw() {
   parent.setSurfaceMeshUniforms(*program);
   render::engine->setMaterialUniforms(*program, parent.getMaterial());
 
-  program->draw();
+  parent.drawMeshProgram(*program);
 }
 
 void SurfaceParameterizationQuantity::createProgram() {
@@ -94,6 +96,10 @@ void SurfaceParameterizationQuantity::buildCustomUI() {
     buildParameterizationOptionsUI();
     
     if (ImGui::MenuItem("Create curve network from seams")) createCurveNetworkFromSeams();
+    if (ImGui::MenuItem("Compute island labels")) {
+      computeIslandLabels();
+      setStyle(ParamVizStyle::CHECKER_ISLANDS);
+    }
 
     ImGui::EndPopup();
   }
@@ -200,6 +206,87 @@ CurveNetwork* SurfaceParameterizationQuantity::createCurveNetworkFromSeams(std::
   return registerCurveNetwork(structureName, seamEdgeNodes, seamEdgeInds);
 }
 
+void SurfaceParameterizationQuantity::computeIslandLabels() {
+
+  coords.ensureHostBufferPopulated();
+  parent.ensureHaveVertexFaceAdjacency();
+
+  const std::vector<uint32_t>& faceStart = parent.faceIndsStart;
+  const std::vector<uint32_t>& faceVerts = parent.faceIndsEntries;
+
+  // the coordinate at a corner, whether they are stored per-corner or per-vertex
+  auto cornerCoord = [&](size_t iC) -> glm::vec2 {
+    if (definedOn == MeshElement::CORNER) {
+      return coords.data[parent.cornerPerm.empty() ? iC : parent.cornerPerm[iC]];
+    }
+    return coords.data[faceVerts[iC]];
+  };
+
+  // Join each pair of faces across an edge where the coordinates match. The faces sharing an edge are found from the
+  // faces around its tail vertex, so no global edge map is needed and the faces can be processed independently.
+  ConcurrentDisjointSets islands(nFaces());
+  parallelFor(0, nFaces(), [&](size_t begin, size_t end) {
+    for (size_t iF = begin; iF < end; iF++) {
+      size_t D = faceStart[iF + 1] - faceStart[iF];
+      for (size_t j = 0; j < D; j++) {
+        size_t iC_tail = faceStart[iF] + j;
+        size_t iC_tip = faceStart[iF] + (j + 1) % D;
+        uint32_t iV_tail = faceVerts[iC_tail];
+        uint32_t iV_tip = faceVerts[iC_tip];
+
+        // find the other faces containing this edge, in either orientation
+        size_t nOther = 0;
+        size_t otherF = INVALID_IND;
+        size_t otherC_tail = INVALID_IND;
+        size_t otherC_tip = INVALID_IND;
+        for (size_t i = parent.vertexFaceAdjStart[iV_tail]; i < parent.vertexFaceAdjStart[iV_tail + 1]; i++) {
+          size_t iG = parent.vertexFaceAdjEntries[i];
+          if (iG == iF) continue;
+          size_t DG = faceStart[iG + 1] - faceStart[iG];
+          for (size_t k = 0; k < DG; k++) {
+            size_t iC = faceStart[iG] + k;
+            size_t iCNext = faceStart[iG] + (k + 1) % DG;
+            if (faceVerts[iC] == iV_tip && faceVerts[iCNext] == iV_tail) {
+              nOther++;
+              otherF = iG;
+              otherC_tail = iCNext;
+              otherC_tip = iC;
+            } else if (faceVerts[iC] == iV_tail && faceVerts[iCNext] == iV_tip) {
+              nOther++;
+              otherF = iG;
+              otherC_tail = iC;
+              otherC_tip = iCNext;
+            }
+          }
+        }
+
+        // boundary and nonmanifold edges are always seams, and each interior edge is checked from one side only
+        if (nOther != 1 || otherF < iF) continue;
+
+        if (cornerCoord(iC_tail) == cornerCoord(otherC_tail) && cornerCoord(iC_tip) == cornerCoord(otherC_tip)) {
+          islands.merge(iF, otherF);
+        }
+      }
+    }
+  });
+
+  // Densely number the islands, in order of their first face
+  std::vector<uint32_t> islandInd(nFaces(), 0);
+  uint32_t nIslands = 0;
+  for (size_t iF = 0; iF < nFaces(); iF++) {
+    if (islands.find(iF) == iF) islandInd[iF] = nIslands++;
+  }
+
+  islandLabels.data.resize(nFaces());
+  parallelFor(0, nFaces(), [&](size_t begin, size_t end) {
+    for (size_t iF = begin; iF < end; iF++) {
+      islandLabels.data[iF] = static_cast<float>(islandInd[islands.find(iF)]);
+    }
+  });
+  islandLabels.markHostBufferUpdated();
+  islandLabelsPopulated = true;
+}
+
 size_t SurfaceParameterizationQuantity::nFaces() {
   return parent.nFaces();
 }
@@ -2,17 +2,24 @@
 
 #include "polyscope/surface_scalar_quantity.h"
 
+#include "polyscope/curve_network.h"
 #include "polyscope/file_helpers.h"
+#include "polyscope/key_indexing.h"
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 
 #include "imgui.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace polyscope {
 
 SurfaceScalarQuantity::SurfaceScalarQuantity(std::string name, SurfaceMesh& mesh_, std::string definedOn_,
-                                             const std::vector<float>& values_, DataType dataType_)
-    : SurfaceMeshQuantity(name, mesh_, true), ScalarQuantity(*this, values_, dataType_), definedOn(definedOn_) {}
+                                             std::vector<float> values_, DataType dataType_)
+    : SurfaceMeshQuantity(name, mesh_, true), ScalarQuantity(*this, std::move(values_), dataType_),
+      definedOn(definedOn_) {}
 
 void SurfaceScalarQuantity::draw() {
   if (!isEnabled()) return;
@@ -21,13 +28,20 @@ void SurfaceScalarQuantity::draw() {
     createProgram();
   }
 
+  if (elementTexture && elementTextureDataVersion != values.getDataVersion()) {
+    // read in place, face values may be an external view (see SurfaceMesh::addFaceScalarQuantityView())
+    const float* valueData = values.getHostDataPointer();
+    SurfaceMesh::updateElementTexture(*elementTexture, valueData, values.size());
+    elementTextureDataVersion = values.getDataVersion();
+  }
+
   // Set uniforms
   parent.setStructureUniforms(*program);
   parent.setSurfaceMeshUniforms(*program);
   setScalarUniforms(*program);
   render::engine->setMaterialUniforms(*program, parent.getMaterial());
 
-  program->draw();
+  parent.drawMeshProgram(*program);
 }
 
 
@@ -50,6 +64,7 @@ void SurfaceScalarQuantity::buildCustomUI() {
 
 void SurfaceScalarQuantity::refresh() {
   program.reset();
+  elementTexture.reset();
   Quantity::refresh();
 }
 
@@ -59,20 +74,19 @@ std::string SurfaceScalarQuantity::niceName() { return name + " (" + definedOn +
 // ==========           Vertex Scalar            ==========
 // ========================================================
 
-SurfaceVertexScalarQuantity::SurfaceVertexScalarQuantity(std::string name, const std::vector<float>& values_,
+SurfaceVertexScalarQuantity::SurfaceVertexScalarQuantity(std::string name, std::vector<float> values_,
                                                          SurfaceMesh& mesh_, DataType dataType_)
-    : SurfaceScalarQuantity(name, mesh_, "vertex", values_, dataType_)
+    : SurfaceScalarQuantity(name, mesh_, "vertex", std::move(values_), dataType_)
 
 {
   values.ensureHostBufferPopulated();
-  hist.buildHistogram(values.data);
 }
 
 void SurfaceVertexScalarQuantity::createProgram() {
   // Create the program to draw this quantity
 
   // clang-format off
-  program = render::engine->requestShader("MESH",
+  program = render::engine->requestShader(parent.getVertexMeshProgramName(),
       render::engine->addMaterialRules(parent.getMaterial(),
         parent.addSurfaceMeshRules(
           addScalarRules(
@@ -83,7 +97,7 @@ void SurfaceVertexScalarQuantity::createProgram() {
     );
   // clang-format on
 
-  program->setAttribute("a_value", values.getIndexedRenderAttributeBuffer(parent.triangleVertexInds));
+  program->setAttribute("a_value", parent.getVertexAttributeBuffer(*program, values));
   parent.setMeshGeometryAttributes(*program);
   render::engine->setMaterial(*program, parent.getMaterial());
   program->setTextureFromColormap("t_colormap", cMap.get());
@@ -100,36 +114,176 @@ void SurfaceVertexScalarQuantity::buildVertexInfoGUI(size_t vInd) {
   ImGui::NextColumn();
 }
 
+void SurfaceVertexScalarQuantity::buildScalarOptionsUI() {
+  ScalarQuantity::buildScalarOptionsUI();
+
+  // contours at the boundaries of the isoline bands
+  if (isolinesEnabled.get() && ImGui::MenuItem("Create curve network from isolines")) {
+    ensureDataRangeComputed();
+    double spacing = getIsolineWidth();
+    std::vector<float> levels;
+    if (spacing > 0.) {
+      double first = std::ceil(dataFiniteRange.first / spacing);
+      double last = std::floor(dataFiniteRange.second / spacing);
+      for (double k = first; k <= last && levels.size() < 10000; k++) {
+        levels.push_back(static_cast<float>(k * spacing));
+      }
+    }
+    createCurveNetworkFromIsolines(levels);
+  }
+}
+
+SurfaceVertexScalarQuantity::Isolines
+SurfaceVertexScalarQuantity::extractIsolines(SurfaceMesh& mesh, const std::vector<float>& vertexValues,
+                                             const std::vector<float>& levels) {
+  const std::vector<glm::vec3>& positions = mesh.vertexPositions.getPopulatedHostBufferRef();
+  const std::vector<uint32_t>& triVerts = mesh.triangleVertexInds.getPopulatedHostBufferRef();
+  size_t nTri = triVerts.size() / 3;
+
+  if (vertexValues.size() != positions.size()) {
+    exception("isoline values have size " + std::to_string(vertexValues.size()) + ", but the mesh has " +
+              std::to_string(positions.size()) + " vertices");
+  }
+
+  std::vector<float> sortedLevels;
+  for (float level : levels) {
+    if (std::isfinite(level)) sortedLevels.push_back(level);
+  }
+  std::sort(sortedLevels.begin(), sortedLevels.end());
+  sortedLevels.erase(std::unique(sortedLevels.begin(), sortedLevels.end()), sortedLevels.end());
+
+  Isolines lines;
+  if (nTri == 0 || sortedLevels.empty()) return lines;
+
+  // A vertex is above a level if its value is >= the level, and each triangle with vertices on both sides crosses it
+  // along exactly two edges. Each crossing is keyed by {level, lower vertex, higher vertex}, and written as one pair of
+  // keys per segment into a buffer for each chunk of triangles.
+  typedef std::array<uint32_t, 3> CrossingKey;
+  size_t nChunks = parallelChunkCount(nTri);
+  std::vector<std::vector<CrossingKey>> chunkKeys(nChunks);
+  parallelForChunks(0, nTri, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+    std::vector<CrossingKey>& keys = chunkKeys[iChunk];
+    for (size_t iT = begin; iT < end; iT++) {
+      uint32_t v[3] = {triVerts[3 * iT], triVerts[3 * iT + 1], triVerts[3 * iT + 2]};
+      float val[3] = {vertexValues[v[0]], vertexValues[v[1]], vertexValues[v[2]]};
+      if (!std::isfinite(val[0]) || !std::isfinite(val[1]) || !std::isfinite(val[2])) continue;
+
+      // the levels in (min, max] are the ones crossed
+      float minVal = std::min(val[0], std::min(val[1], val[2]));
+      float maxVal = std::max(val[0], std::max(val[1], val[2]));
+      size_t levelBegin = std::upper_bound(sortedLevels.begin(), sortedLevels.end(), minVal) - sortedLevels.begin();
+      size_t levelEnd = std::upper_bound(sortedLevels.begin(), sortedLevels.end(), maxVal) - sortedLevels.begin();
+
+      for (size_t iL = levelBegin; iL < levelEnd; iL++) {
+        float level = sortedLevels[iL];
+        for (size_t k = 0; k < 3; k++) {
+          size_t kNext = (k + 1) % 3;
+          if ((val[k] >= level) == (val[kNext] >= level)) continue;
+          keys.push_back({static_cast<uint32_t>(iL), std::min(v[k], v[kNext]), std::max(v[k], v[kNext])});
+        }
+      }
+    }
+  });
+
+  // Gather the chunk buffers in order
+  std::vector<size_t> chunkStart(nChunks + 1, 0);
+  for (size_t iChunk = 0; iChunk < nChunks; iChunk++) {
+    chunkStart[iChunk + 1] = chunkStart[iChunk] + chunkKeys[iChunk].size();
+  }
+  std::vector<CrossingKey> keys(chunkStart[nChunks]);
+  parallelForChunks(0, nChunks, nChunks, [&](size_t iChunk, size_t, size_t) {
+    std::copy(chunkKeys[iChunk].begin(), chunkKeys[iChunk].end(), keys.begin() + chunkStart[iChunk]);
+    std::vector<CrossingKey>().swap(chunkKeys[iChunk]);
+  });
+  if (keys.empty()) return lines;
+
+  // Merge the crossings of shared edges into one node each
+  std::vector<size_t> keyNode;
+  size_t nNodes = indexUniqueKeys(keys, keyNode);
+
+  // nodes are numbered in order of first appearance, so the first key of each is found in one pass
+  std::vector<size_t> nodeFirstKey(nNodes);
+  for (size_t i = 0, iNode = 0; i < keys.size() && iNode < nNodes; i++) {
+    if (keyNode[i] == iNode) nodeFirstKey[iNode++] = i;
+  }
+
+  lines.nodes.resize(nNodes);
+  lines.nodeLevels.resize(nNodes);
+  parallelFor(0, nNodes, [&](size_t begin, size_t end) {
+    for (size_t iNode = begin; iNode < end; iNode++) {
+      const CrossingKey& key = keys[nodeFirstKey[iNode]];
+      float level = sortedLevels[key[0]];
+      float valA = vertexValues[key[1]];
+      float valB = vertexValues[key[2]];
+      float t = (level - valA) / (valB - valA);
+      lines.nodes[iNode] = (1.f - t) * positions[key[1]] + t * positions[key[2]];
+      lines.nodeLevels[iNode] = level;
+    }
+  });
+
+  lines.edges.resize(keys.size() / 2);
+  parallelFor(0, lines.edges.size(), [&](size_t begin, size_t end) {
+    for (size_t iE = begin; iE < end; iE++) {
+      lines.edges[iE] = {keyNode[2 * iE], keyNode[2 * iE + 1]};
+    }
+  });
+
+  return lines;
+}
+
+CurveNetwork* SurfaceVertexScalarQuantity::createCurveNetworkFromIsolines(const std::vector<float>& levels,
+                                                                          std::string structureName) {
+
+  // set the name to default
+  if (structureName == "") {
+    structureName = parent.name + " - " + name + " - isolines";
+  }
+
+  Isolines lines = extractIsolines(parent, values.getPopulatedHostBufferRef(), levels);
+
+  CurveNetwork* curves = registerCurveNetwork(structureName, lines.nodes, lines.edges);
+  curves->addNodeScalarQuantity("level", lines.nodeLevels);
+  return curves;
+}
+
 // ========================================================
 // ==========            Face Scalar             ==========
 // ========================================================
 
-SurfaceFaceScalarQuantity::SurfaceFaceScalarQuantity(std::string name, const std::vector<float>& values_,
+SurfaceFaceScalarQuantity::SurfaceFaceScalarQuantity(std::string name, std::vector<float> values_,
                                                      SurfaceMesh& mesh_, DataType dataType_)
-    : SurfaceScalarQuantity(name, mesh_, "face", values_, dataType_)
+    : SurfaceScalarQuantity(name, mesh_, "face", std::move(values_), dataType_)
 
 {
   values.ensureHostBufferPopulated();
-  parent.faceAreas.ensureHostBufferPopulated();
-  hist.buildHistogram(values.data);
 }
 
 void SurfaceFaceScalarQuantity::createProgram() {
   // Create the program to draw this quantity
 
+  // the values are read at their own size from a texture, unless there are too many for one
+  const float* valueData = values.getHostDataPointer();
+  elementTexture = SurfaceMesh::generateElementTexture(valueData, values.size());
+  elementTextureDataVersion = values.getDataVersion();
+
   // clang-format off
   program = render::engine->requestShader("MESH",
       render::engine->addMaterialRules(parent.getMaterial(),
         parent.addSurfaceMeshRules(
           addScalarRules(
-            {"MESH_PROPAGATE_VALUE"}
+            {elementTexture ? "MESH_FETCH_VALUE" : "MESH_PROPAGATE_VALUE"}
           )
         )
       )
     );
   // clang-format on
 
-  program->setAttribute("a_value", values.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+  if (elementTexture) {
+    program->setAttribute("a_elementInd", parent.triangleFaceInds.getRenderAttributeBuffer());
+    program->setTextureFromBuffer("t_elementValues", elementTexture.get());
+  } else {
+    program->setAttribute("a_value", values.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+  }
   parent.setMeshGeometryAttributes(*program);
   render::engine->setMaterial(*program, parent.getMaterial());
   program->setTextureFromColormap("t_colormap", cMap.get());
@@ -160,25 +314,33 @@ SurfaceEdgeScalarQuantity::SurfaceEdgeScalarQuantity(std::string name, const std
 
 {
   values.ensureHostBufferPopulated();
-  hist.buildHistogram(values.data);
 }
 
 void SurfaceEdgeScalarQuantity::createProgram() {
   // Create the program to draw this quantity
 
+  // the values are read at their own size from a texture, unless there are too many for one
+  elementTexture = SurfaceMesh::generateElementTexture(values.getPopulatedHostBufferRef());
+  elementTextureDataVersion = values.getDataVersion();
+
   // clang-format off
   program = render::engine->requestShader("MESH",
       render::engine->addMaterialRules(parent.getMaterial(),
         parent.addSurfaceMeshRules(
           addScalarRules(
-            {"MESH_PROPAGATE_HALFEDGE_VALUE"}
+            {elementTexture ? "MESH_FETCH_HALFEDGE_VALUE" : "MESH_PROPAGATE_HALFEDGE_VALUE"}
           )
         )
       )
     );
   // clang-format on
 
-  program->setAttribute("a_value3", values.getIndexedRenderAttributeBuffer(parent.triangleAllEdgeInds));
+  if (elementTexture) {
+    program->setAttribute("a_elementInds", parent.triangleAllEdgeInds.getRenderAttributeBuffer());
+    program->setTextureFromBuffer("t_elementValues", elementTexture.get());
+  } else {
+    program->setAttribute("a_value3", values.getIndexedRenderAttributeBuffer(parent.triangleAllEdgeInds));
+  }
   parent.setMeshGeometryAttributes(*program);
   render::engine->setMaterial(*program, parent.getMaterial());
   program->setTextureFromColormap("t_colormap", cMap.get());
@@ -205,25 +367,33 @@ SurfaceHalfedgeScalarQuantity::SurfaceHalfedgeScalarQuantity(std::string name, c
 
 {
   values.ensureHostBufferPopulated();
-  hist.buildHistogram(values.data);
 }
 
 void SurfaceHalfedgeScalarQuantity::createProgram() {
   // Create the program to draw this quantity
 
+  // the values are read at their own size from a texture, unless there are too many for one
+  elementTexture = SurfaceMesh::generateElementTexture(values.getPopulatedHostBufferRef());
+  elementTextureDataVersion = values.getDataVersion();
+
   // clang-format off
   program = render::engine->requestShader("MESH",
       render::engine->addMaterialRules(parent.getMaterial(),
         parent.addSurfaceMeshRules(
           addScalarRules(
-            {"MESH_PROPAGATE_HALFEDGE_VALUE"}
+            {elementTexture ? "MESH_FETCH_HALFEDGE_VALUE" : "MESH_PROPAGATE_HALFEDGE_VALUE"}
           )
         )
       )
     );
   // clang-format on
 
-  program->setAttribute("a_value3", values.getIndexedRenderAttributeBuffer(parent.triangleAllHalfedgeInds));
+  if (elementTexture) {
+    program->setAttribute("a_elementInds", parent.triangleAllHalfedgeInds.getRenderAttributeBuffer());
+    program->setTextureFromBuffer("t_elementValues", elementTexture.get());
+  } else {
+    program->setAttribute("a_value3", values.getIndexedRenderAttributeBuffer(parent.triangleAllHalfedgeInds));
+  }
   parent.setMeshGeometryAttributes(*program);
   render::engine->setMaterial(*program, parent.getMaterial());
   program->setTextureFromColormap("t_colormap", cMap.get());
@@ -250,7 +420,6 @@ SurfaceCornerScalarQuantity::SurfaceCornerScalarQuantity(std::string name, const
 
 {
   values.ensureHostBufferPopulated();
-  hist.buildHistogram(values.data);
 }
 
 void SurfaceCornerScalarQuantity::createProgram() {
@@ -297,7 +466,6 @@ SurfaceTextureScalarQuantity::SurfaceTextureScalarQuantity(std::string name, Sur
       imageOrigin(origin_) {
   values.setTextureSize(dimX, dimY);
   values.ensureHostBufferPopulated();
-  hist.buildHistogram(values.data);
 }
 
 void SurfaceTextureScalarQuantity::createProgram() {
@@ -3,19 +3,329 @@
 #include "polyscope/surface_vector_quantity.h"
 
 #include "polyscope/file_helpers.h"
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 
 #include "imgui.h"
 
+#include <algorithm>
+#include <cmath>
 #include <complex>
 #include <fstream>
 #include <iostream>
+#include <limits>
 
 namespace polyscope {
 
 SurfaceVectorQuantity::SurfaceVectorQuantity(std::string name, SurfaceMesh& mesh_, MeshElement definedOn_)
-    : SurfaceMeshQuantity(name, mesh_) {}
+    : SurfaceMeshQuantity(name, mesh_), definedOn(definedOn_), ribbonEnabled(uniquePrefix() + "ribbonEnabled", false),
+      ribbonWidth(uniquePrefix() + "ribbonWidth", relativeValue(0.001)),
+      ribbonCount(uniquePrefix() + "ribbonCount", 1000) {}
+
+bool SurfaceVectorQuantity::drawsWithinStructureBounds() { return false; }
+
+void SurfaceVectorQuantity::refresh() {
+  ribbonProgram.reset();
+  Quantity::refresh();
+}
+
+int SurfaceVectorQuantity::ribbonSymmetry() { return 1; }
+
+namespace {
+
+// the rotation of d about n by a multiple of 2pi/nSym which is closest to target
+glm::vec3 closestSymmetricRotation(glm::vec3 d, glm::vec3 n, int nSym, glm::vec3 target) {
+  glm::vec3 best = d;
+  float bestDot = glm::dot(d, target);
+  for (int iSym = 1; iSym < nSym; iSym++) {
+    float theta = static_cast<float>((iSym * 2. * PI) / nSym);
+    glm::vec3 rotated = std::cos(theta) * d + std::sin(theta) * glm::cross(n, d);
+    float rotatedDot = glm::dot(rotated, target);
+    if (rotatedDot > bestDot) {
+      best = rotated;
+      bestDot = rotatedDot;
+    }
+  }
+  return best;
+}
+
+} // namespace
+
+SurfaceVectorQuantity::Streamlines
+SurfaceVectorQuantity::traceStreamlines(SurfaceMesh& mesh, const std::vector<glm::vec3>& triangleDirections, int nSym,
+                                        size_t nSeeds, float maxLength) {
+  const std::vector<glm::vec3>& positions = mesh.vertexPositions.getPopulatedHostBufferRef();
+  const std::vector<uint32_t>& triVerts = mesh.triangleVertexInds.getPopulatedHostBufferRef();
+  size_t nTri = triVerts.size() / 3;
+
+  Streamlines lines;
+  if (nTri == 0 || nSeeds == 0) return lines;
+  nSeeds = std::min(nSeeds, nTri);
+
+  // The triangle across the edge from corner k to corner k+1 of each triangle, found by sorting the edges. Edges with
+  // more than two triangles are treated as boundary.
+  std::vector<std::pair<uint64_t, size_t>> edgeCorners(3 * nTri);
+  parallelFor(0, nTri, [&](size_t begin, size_t end) {
+    for (size_t iT = begin; iT < end; iT++) {
+      for (size_t k = 0; k < 3; k++) {
+        uint64_t vA = triVerts[3 * iT + k];
+        uint64_t vB = triVerts[3 * iT + (k + 1) % 3];
+        edgeCorners[3 * iT + k] = std::make_pair((std::min(vA, vB) << 32) | std::max(vA, vB), 3 * iT + k);
+      }
+    }
+  });
+  std::sort(edgeCorners.begin(), edgeCorners.end());
+  std::vector<size_t> neighborCorner(3 * nTri, INVALID_IND); // the matching corner of the other triangle
+  for (size_t i = 0; i < edgeCorners.size();) {
+    size_t j = i;
+    while (j < edgeCorners.size() && edgeCorners[j].first == edgeCorners[i].first) j++;
+    if (j - i == 2) {
+      neighborCorner[edgeCorners[i].second] = edgeCorners[i + 1].second;
+      neighborCorner[edgeCorners[i + 1].second] = edgeCorners[i].second;
+    }
+    i = j;
+  }
+
+  auto triPos = [&](size_t iT, size_t k) { return positions[triVerts[3 * iT + k]]; };
+  auto triNormal = [&](size_t iT) -> glm::vec3 {
+    glm::vec3 n = glm::cross(triPos(iT, 1) - triPos(iT, 0), triPos(iT, 2) - triPos(iT, 0));
+    float len = glm::length(n);
+    return len > 0. ? n / len : glm::vec3{0., 0., 0.};
+  };
+  auto inwardNormal = [&](size_t iT, size_t k, glm::vec3 n) {
+    return glm::cross(n, triPos(iT, (k + 1) % 3) - triPos(iT, k));
+  };
+
+  // the unit direction to follow in a triangle, or zero if there is none
+  auto followDirection = [&](size_t iT, glm::vec3 n, float sign, glm::vec3 prevDir) -> glm::vec3 {
+    glm::vec3 d = sign * triangleDirections[iT];
+    d -= glm::dot(d, n) * n;
+    float len = glm::length(d);
+    if (!(len > 0.) || !std::isfinite(len)) return glm::vec3{0., 0., 0.};
+    d /= len;
+    if (nSym > 1 && prevDir != glm::vec3{0., 0., 0.}) d = closestSymmetricRotation(d, n, nSym, prevDir);
+    return d;
+  };
+
+  const size_t maxSteps = 10000; // guards against lines which stall at a vertex
+  auto traceOneWay = [&](size_t iT, glm::vec3 x, float sign, std::vector<glm::vec3>& points,
+                         std::vector<glm::vec3>& normals) {
+    glm::vec3 prevDir{0., 0., 0.};
+    size_t enteredEdge = INVALID_IND;
+    float length = 0.;
+    for (size_t iStep = 0; iStep < maxSteps; iStep++) {
+      glm::vec3 n = triNormal(iT);
+      glm::vec3 d = followDirection(iT, n, sign, prevDir);
+      if (d == glm::vec3{0., 0., 0.}) return;
+
+      // where the line leaves the triangle
+      float tExit = std::numeric_limits<float>::infinity();
+      size_t kExit = INVALID_IND;
+      for (size_t k = 0; k < 3; k++) {
+        if (k == enteredEdge) continue;
+        glm::vec3 inward = inwardNormal(iT, k, n);
+        float rate = glm::dot(d, inward);
+        if (!(rate < 0.)) continue;
+        float dist = std::max(glm::dot(x - triPos(iT, k), inward), 0.f);
+        float t = dist / -rate;
+        if (t < tExit) {
+          tExit = t;
+          kExit = k;
+        }
+      }
+      if (kExit == INVALID_IND) return;
+
+      if (length + tExit >= maxLength) {
+        points.push_back(x + (maxLength - length) * d);
+        normals.push_back(n);
+        return;
+      }
+      x += tExit * d;
+      length += tExit;
+      points.push_back(x);
+      normals.push_back(n);
+
+      // continue in to the neighboring triangle, unless the field there turns back across the edge
+      size_t nextCorner = neighborCorner[3 * iT + kExit];
+      if (nextCorner == INVALID_IND) return;
+      size_t iTNext = nextCorner / 3;
+      size_t kNext = nextCorner % 3;
+      glm::vec3 nNext = triNormal(iTNext);
+      glm::vec3 dNext = followDirection(iTNext, nNext, sign, d);
+      if (!(glm::dot(dNext, inwardNormal(iTNext, kNext, nNext)) > 0.)) return;
+
+      iT = iTNext;
+      enteredEdge = kNext;
+      prevDir = d;
+    }
+  };
+
+  // trace from each seed in parallel, both ways
+  std::vector<std::vector<glm::vec3>> seedPoints(nSeeds), seedNormals(nSeeds);
+  parallelFor(0, nSeeds, [&](size_t begin, size_t end) {
+    std::vector<glm::vec3> backPoints, backNormals;
+    for (size_t iSeed = begin; iSeed < end; iSeed++) {
+      size_t iT = iSeed * nTri / nSeeds;
+      glm::vec3 center = (triPos(iT, 0) + triPos(iT, 1) + triPos(iT, 2)) / 3.f;
+
+      backPoints.clear();
+      backNormals.clear();
+      traceOneWay(iT, center, -1., backPoints, backNormals);
+
+      std::vector<glm::vec3>& points = seedPoints[iSeed];
+      std::vector<glm::vec3>& normals = seedNormals[iSeed];
+      points.assign(backPoints.rbegin(), backPoints.rend());
+      normals.assign(backNormals.rbegin(), backNormals.rend());
+      points.push_back(center);
+      normals.push_back(triNormal(iT));
+      traceOneWay(iT, center, 1., points, normals);
+    }
+  });
+
+  // concatenate, repeating the ends of each line
+  for (size_t iSeed = 0; iSeed < nSeeds; iSeed++) {
+    const std::vector<glm::vec3>& points = seedPoints[iSeed];
+    const std::vector<glm::vec3>& normals = seedNormals[iSeed];
+    if (points.size() < 2) continue;
+    size_t start = lines.points.size() + 1;
+    lines.points.push_back(points.front());
+    lines.points.insert(lines.points.end(), points.begin(), points.end());
+    lines.points.push_back(points.back());
+    lines.normals.push_back(normals.front());
+    lines.normals.insert(lines.normals.end(), normals.begin(), normals.end());
+    lines.normals.push_back(normals.back());
+    for (size_t j = 0; j + 1 < points.size(); j++) {
+      lines.segmentStarts.push_back(static_cast<float>(start + j));
+    }
+  }
+
+  return lines;
+}
+
+std::vector<glm::vec3>
+SurfaceVectorQuantity::vertexDirectionsToTriangles(const std::vector<glm::vec3>& vertexDirections, int nSym) {
+  const std::vector<glm::vec3>& positions = parent.vertexPositions.getPopulatedHostBufferRef();
+  const std::vector<uint32_t>& triVerts = parent.triangleVertexInds.getPopulatedHostBufferRef();
+  std::vector<glm::vec3> triangleDirections(triVerts.size() / 3);
+  parallelFor(0, triangleDirections.size(), [&](size_t begin, size_t end) {
+    for (size_t iT = begin; iT < end; iT++) {
+      glm::vec3 d0 = vertexDirections[triVerts[3 * iT]];
+      glm::vec3 sum = d0;
+      glm::vec3 n = glm::cross(positions[triVerts[3 * iT + 1]] - positions[triVerts[3 * iT]],
+                               positions[triVerts[3 * iT + 2]] - positions[triVerts[3 * iT]]);
+      float nLen = glm::length(n);
+      if (nLen > 0.) n /= nLen;
+      for (size_t k = 1; k < 3; k++) {
+        glm::vec3 d = vertexDirections[triVerts[3 * iT + k]];
+        sum += nSym > 1 ? closestSymmetricRotation(d, n, nSym, d0) : d;
+      }
+      triangleDirections[iT] = sum / 3.f;
+    }
+  });
+  return triangleDirections;
+}
+
+void SurfaceVectorQuantity::traceRibbons() {
+  Streamlines lines = traceStreamlines(parent, ribbonTriangleDirections(), ribbonSymmetry(),
+                                       static_cast<size_t>(std::max(ribbonCount.get(), 0)), 0.5 * parent.lengthScale());
+
+  ribbonSegmentStarts = std::move(lines.segmentStarts);
+  ribbonPointsTexture = SurfaceMesh::generateElementTexture(lines.points);
+  ribbonNormalsTexture = SurfaceMesh::generateElementTexture(lines.normals);
+  if (!ribbonSegmentStarts.empty() && !ribbonPointsTexture) {
+    warning("too many streamline points to draw ribbons of " + name + ", reduce the ribbon count");
+    ribbonSegmentStarts.clear();
+  }
+
+  ribbonTracedDataVersion = ribbonDataVersion();
+  ribbonTracedPositionsVersion = parent.vertexPositions.getDataVersion();
+  ribbonTracedCount = ribbonCount.get();
+  ribbonProgram.reset();
+}
+
+void SurfaceVectorQuantity::createRibbonProgram(const std::string& material) {
+  // clang-format off
+  ribbonProgram = render::engine->requestShader("RIBBON_INSTANCED",
+      render::engine->addMaterialRules(material,
+        parent.addStructureRules({})
+      )
+  );
+  // clang-format on
+  ribbonProgramMaterial = material;
+
+  // the strip the geometry shader of RIBBON emits for each segment, from right to left across the ribbon
+  std::vector<glm::vec2> stripCorners = {{0., -1.}, {1., -1.}, {0., 0.}, {1., 0.}, {0., 1.}, {1., 1.}};
+  ribbonProgram->setAttribute("a_stripCorner", stripCorners);
+  ribbonProgram->setAttribute("a_segmentStart", ribbonSegmentStarts);
+  ribbonProgram->setTextureFromBuffer("t_ribbonPoints", ribbonPointsTexture.get());
+  ribbonProgram->setTextureFromBuffer("t_ribbonNormals", ribbonNormalsTexture.get());
+
+  render::engine->setMaterial(*ribbonProgram, material);
+}
+
+void SurfaceVectorQuantity::drawRibbons(glm::vec3 color, const std::string& material) {
+  if (!isRibbonEnabled()) return;
+
+  if (ribbonTracedCount != ribbonCount.get() || ribbonTracedDataVersion != ribbonDataVersion() ||
+      ribbonTracedPositionsVersion != parent.vertexPositions.getDataVersion()) {
+    traceRibbons();
+  }
+  if (ribbonSegmentStarts.empty()) return;
+
+  if (!ribbonProgram || ribbonProgramMaterial != material) {
+    createRibbonProgram(material);
+  }
+
+  parent.setStructureUniforms(*ribbonProgram);
+  ribbonProgram->setUniform("u_ribbonWidth", ribbonWidth.get().asAbsolute());
+  ribbonProgram->setUniform("u_depthOffset", 1e-4);
+  ribbonProgram->setUniform("u_ribbonColor", color);
+  render::engine->setMaterialUniforms(*ribbonProgram, material);
+  ribbonProgram->setInstanceCount(static_cast<uint32_t>(ribbonSegmentStarts.size()));
+
+  ribbonProgram->draw();
+}
+
+void SurfaceVectorQuantity::buildRibbonUI() {
+  if (ImGui::Checkbox("Ribbon", &ribbonEnabled.get())) setRibbonEnabled(isRibbonEnabled());
+
+  if (isRibbonEnabled()) {
+    ImGui::SameLine();
+    ImGui::PushItemWidth(100);
+    if (ImGui::SliderFloat("Width", ribbonWidth.get().getValuePtr(), 0.0, .01, "%.5f",
+                           ImGuiSliderFlags_Logarithmic | ImGuiSliderFlags_NoRoundToFormat)) {
+      ribbonWidth.manuallyChanged();
+      requestRedraw();
+    }
+    int count = ribbonCount.get();
+    if (ImGui::InputInt("Lines", &count, 100, 1000)) {
+      setRibbonCount(static_cast<size_t>(std::max(count, 0)));
+    }
+    ImGui::PopItemWidth();
+  }
+}
+
+SurfaceVectorQuantity* SurfaceVectorQuantity::setRibbonEnabled(bool newVal) {
+  ribbonEnabled = newVal;
+  requestRedraw();
+  return this;
+}
+bool SurfaceVectorQuantity::isRibbonEnabled() { return ribbonEnabled.get(); }
+
+SurfaceVectorQuantity* SurfaceVectorQuantity::setRibbonWidth(double newVal, bool isRelative) {
+  ribbonWidth = ScaledValue<float>(newVal, isRelative);
+  requestRedraw();
+  return this;
+}
+double SurfaceVectorQuantity::getRibbonWidth() { return ribbonWidth.get().asAbsolute(); }
+
+SurfaceVectorQuantity* SurfaceVectorQuantity::setRibbonCount(size_t newVal) {
+  ribbonCount = static_cast<int>(newVal);
+  requestRedraw();
+  return this;
+}
+size_t SurfaceVectorQuantity::getRibbonCount() { return static_cast<size_t>(ribbonCount.get()); }
 
 
 // ========================================================
@@ -25,19 +335,23 @@ SurfaceVectorQuantity::SurfaceVectorQuantity(std::string name, SurfaceMesh& mesh
 SurfaceVertexVectorQuantity::SurfaceVertexVectorQuantity(std::string name, std::vector<glm::vec3> vectors_,
                                                          SurfaceMesh& mesh_, VectorType vectorType_)
     : SurfaceVectorQuantity(name, mesh_, MeshElement::VERTEX),
-      VectorQuantity<SurfaceVertexVectorQuantity>(*this, vectors_, parent.vertexPositions, vectorType_) {}
+      VectorQuantity<SurfaceVertexVectorQuantity>(*this, std::move(vectors_), parent.vertexPositions, vectorType_) {}
 
 void SurfaceVertexVectorQuantity::refresh() {
   refreshVectors();
-  Quantity::refresh();
+  SurfaceVectorQuantity::refresh();
 }
 
 void SurfaceVertexVectorQuantity::draw() {
   if (!isEnabled()) return;
   drawVectors();
+  drawRibbons(getVectorColor(), getMaterial());
 }
 
-void SurfaceVertexVectorQuantity::buildCustomUI() { buildVectorUI(); }
+void SurfaceVertexVectorQuantity::buildCustomUI() {
+  buildVectorUI();
+  buildRibbonUI();
+}
 
 
 void SurfaceVertexVectorQuantity::buildVertexInfoGUI(size_t iV) {
@@ -58,6 +372,12 @@ void SurfaceVertexVectorQuantity::buildVertexInfoGUI(size_t iV) {
 
 std::string SurfaceVertexVectorQuantity::niceName() { return name + " (vertex vector)"; }
 
+std::vector<glm::vec3> SurfaceVertexVectorQuantity::ribbonTriangleDirections() {
+  return vertexDirectionsToTriangles(vectors.getPopulatedHostBufferRef(), 1);
+}
+
+uint64_t SurfaceVertexVectorQuantity::ribbonDataVersion() { return vectors.getDataVersion(); }
+
 // ========================================================
 // ==========            Face Vector             ==========
 // ========================================================
@@ -65,19 +385,23 @@ std::string SurfaceVertexVectorQuantity::niceName() { return name + " (vertex ve
 SurfaceFaceVectorQuantity::SurfaceFaceVectorQuantity(std::string name, std::vector<glm::vec3> vectors_,
                                                      SurfaceMesh& mesh_, VectorType vectorType_)
     : SurfaceVectorQuantity(name, mesh_, MeshElement::FACE),
-      VectorQuantity<SurfaceFaceVectorQuantity>(*this, vectors_, parent.faceCenters, vectorType_) {}
+      VectorQuantity<SurfaceFaceVectorQuantity>(*this, std::move(vectors_), parent.faceCenters, vectorType_) {}
 
 void SurfaceFaceVectorQuantity::refresh() {
   refreshVectors();
-  Quantity::refresh();
+  SurfaceVectorQuantity::refresh();
 }
 
 void SurfaceFaceVectorQuantity::draw() {
   if (!isEnabled()) return;
   drawVectors();
+  drawRibbons(getVectorColor(), getMaterial());
 }
 
-void SurfaceFaceVectorQuantity::buildCustomUI() { buildVectorUI(); }
+void SurfaceFaceVectorQuantity::buildCustomUI() {
+  buildVectorUI();
+  buildRibbonUI();
+}
 
 void SurfaceFaceVectorQuantity::buildFaceInfoGUI(size_t iF) {
   ImGui::TextUnformatted(name.c_str());
@@ -97,6 +421,18 @@ void SurfaceFaceVectorQuantity::buildFaceInfoGUI(size_t iF) {
 
 std::string SurfaceFaceVectorQuantity::niceName() { return name + " (face vector)"; }
 
+std::vector<glm::vec3> SurfaceFaceVectorQuantity::ribbonTriangleDirections() {
+  const std::vector<glm::vec3>& faceVectors = vectors.getPopulatedHostBufferRef();
+  const std::vector<uint32_t>& triFaces = parent.triangleFaceInds.getPopulatedHostBufferRef();
+  std::vector<glm::vec3> triangleDirections(triFaces.size() / 3);
+  for (size_t iT = 0; iT < triangleDirections.size(); iT++) {
+    triangleDirections[iT] = faceVectors[triFaces[3 * iT]];
+  }
+  return triangleDirections;
+}
+
+uint64_t SurfaceFaceVectorQuantity::ribbonDataVersion() { return vectors.getDataVersion(); }
+
 
 // ========================================================
 // ==========        Tangent Face Vector       ==========
@@ -113,15 +449,19 @@ SurfaceFaceTangentVectorQuantity::SurfaceFaceTangentVectorQuantity(std::string n
 
 void SurfaceFaceTangentVectorQuantity::refresh() {
   refreshVectors();
-  Quantity::refresh();
+  SurfaceVectorQuantity::refresh();
 }
 
 void SurfaceFaceTangentVectorQuantity::draw() {
   if (!isEnabled()) return;
   drawVectors();
+  drawRibbons(getVectorColor(), getMaterial());
 }
 
-void SurfaceFaceTangentVectorQuantity::buildCustomUI() { buildVectorUI(); }
+void SurfaceFaceTangentVectorQuantity::buildCustomUI() {
+  buildVectorUI();
+  buildRibbonUI();
+}
 
 void SurfaceFaceTangentVectorQuantity::buildFaceInfoGUI(size_t iF) {
   ImGui::TextUnformatted(name.c_str());
@@ -147,6 +487,23 @@ std::string SurfaceFaceTangentVectorQuantity::niceName() {
   }
 }
 
+std::vector<glm::vec3> SurfaceFaceTangentVectorQuantity::ribbonTriangleDirections() {
+  const std::vector<glm::vec2>& faceVectors = tangentVectors.getPopulatedHostBufferRef();
+  const std::vector<glm::vec3>& basisX = tangentBasisX.getPopulatedHostBufferRef();
+  const std::vector<glm::vec3>& basisY = tangentBasisY.getPopulatedHostBufferRef();
+  const std::vector<uint32_t>& triFaces = parent.triangleFaceInds.getPopulatedHostBufferRef();
+  std::vector<glm::vec3> triangleDirections(triFaces.size() / 3);
+  for (size_t iT = 0; iT < triangleDirections.size(); iT++) {
+    size_t iF = triFaces[3 * iT];
+    triangleDirections[iT] = faceVectors[iF].x * basisX[iF] + faceVectors[iF].y * basisY[iF];
+  }
+  return triangleDirections;
+}
+
+int SurfaceFaceTangentVectorQuantity::ribbonSymmetry() { return nSym; }
+
+uint64_t SurfaceFaceTangentVectorQuantity::ribbonDataVersion() { return tangentVectors.getDataVersion(); }
+
 // ========================================================
 // ==========       Tangent Vertex Vector      ==========
 // ========================================================
@@ -161,15 +518,19 @@ SurfaceVertexTangentVectorQuantity::SurfaceVertexTangentVectorQuantity(
 
 void SurfaceVertexTangentVectorQuantity::refresh() {
   refreshVectors();
-  Quantity::refresh();
+  SurfaceVectorQuantity::refresh();
 }
 
 void SurfaceVertexTangentVectorQuantity::draw() {
   if (!isEnabled()) return;
   drawVectors();
+  drawRibbons(getVectorColor(), getMaterial());
 }
 
-void SurfaceVertexTangentVectorQuantity::buildCustomUI() { buildVectorUI(); }
+void SurfaceVertexTangentVectorQuantity::buildCustomUI() {
+  buildVectorUI();
+  buildRibbonUI();
+}
 
 
 void SurfaceVertexTangentVectorQuantity::buildVertexInfoGUI(size_t iV) {
@@ -196,6 +557,21 @@ std::string SurfaceVertexTangentVectorQuantity::niceName() {
   }
 }
 
+std::vector<glm::vec3> SurfaceVertexTangentVectorQuantity::ribbonTriangleDirections() {
+  const std::vector<glm::vec2>& vertexVectors = tangentVectors.getPopulatedHostBufferRef();
+  const std::vector<glm::vec3>& basisX = tangentBasisX.getPopulatedHostBufferRef();
+  const std::vector<glm::vec3>& basisY = tangentBasisY.getPopulatedHostBufferRef();
+  std::vector<glm::vec3> worldVectors(vertexVectors.size());
+  for (size_t iV = 0; iV < vertexVectors.size(); iV++) {
+    worldVectors[iV] = vertexVectors[iV].x * basisX[iV] + vertexVectors[iV].y * basisY[iV];
+  }
+  return vertexDirectionsToTriangles(worldVectors, nSym);
+}
+
+int SurfaceVertexTangentVectorQuantity::ribbonSymmetry() { return nSym; }
+
+uint64_t SurfaceVertexTangentVectorQuantity::ribbonDataVersion() { return tangentVectors.getDataVersion(); }
+
 // ========================================================
 // ==========        Tangent One Form          ============
 // ========================================================
@@ -262,15 +638,19 @@ SurfaceOneFormTangentVectorQuantity::SurfaceOneFormTangentVectorQuantity(std::st
 
 void SurfaceOneFormTangentVectorQuantity::refresh() {
   refreshVectors();
-  Quantity::refresh();
+  SurfaceVectorQuantity::refresh();
 }
 
 void SurfaceOneFormTangentVectorQuantity::draw() {
   if (!isEnabled()) return;
   drawVectors();
+  drawRibbons(getVectorColor(), getMaterial());
 }
 
-void SurfaceOneFormTangentVectorQuantity::buildCustomUI() { buildVectorUI(); }
+void SurfaceOneFormTangentVectorQuantity::buildCustomUI() {
+  buildVectorUI();
+  buildRibbonUI();
+}
 
 void SurfaceOneFormTangentVectorQuantity::buildEdgeInfoGUI(size_t iE) {
   ImGui::TextUnformatted(name.c_str());
@@ -281,4 +661,19 @@ void SurfaceOneFormTangentVectorQuantity::buildEdgeInfoGUI(size_t iE) {
 
 std::string SurfaceOneFormTangentVectorQuantity::niceName() { return name + " (1-form tangent vector)"; }
 
+std::vector<glm::vec3> SurfaceOneFormTangentVectorQuantity::ribbonTriangleDirections() {
+  const std::vector<glm::vec2>& faceVectors = tangentVectors.getPopulatedHostBufferRef();
+  const std::vector<glm::vec3>& basisX = tangentBasisX.getPopulatedHostBufferRef();
+  const std::vector<glm::vec3>& basisY = tangentBasisY.getPopulatedHostBufferRef();
+  const std::vector<uint32_t>& triFaces = parent.triangleFaceInds.getPopulatedHostBufferRef();
+  std::vector<glm::vec3> triangleDirections(triFaces.size() / 3);
+  for (size_t iT = 0; iT < triangleDirections.size(); iT++) {
+    size_t iF = triFaces[3 * iT];
+    triangleDirections[iT] = faceVectors[iF].x * basisX[iF] + faceVectors[iF].y * basisY[iF];
+  }
+  return triangleDirections;
+}
+
+uint64_t SurfaceOneFormTangentVectorQuantity::ribbonDataVersion() { return tangentVectors.getDataVersion(); }
+
 } // namespace polyscope
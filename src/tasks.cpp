@@ -0,0 +1,241 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/tasks.h"
+
+#include "polyscope/parallel.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace polyscope {
+namespace tasks {
+
+namespace {
+
+struct Batch {
+  const std::function<void(size_t)>* job;
+  std::atomic<size_t> nRemaining;
+  std::vector<std::exception_ptr> errors;
+};
+
+struct Job {
+  Batch* batch;
+  size_t iJob;
+};
+
+struct JobQueue {
+  std::mutex mutex;
+  std::deque<Job> jobs;
+};
+
+void runJob(const Job& j) {
+  try {
+    (*j.batch->job)(j.iJob);
+  } catch (...) {
+    j.batch->errors[j.iJob] = std::current_exception();
+  }
+  j.batch->nRemaining.fetch_sub(1, std::memory_order_acq_rel); // the batch may be gone after this
+}
+
+void rethrowFirst(const std::vector<std::exception_ptr>& errors) {
+  for (const std::exception_ptr& e : errors) {
+    if (e) std::rethrow_exception(e);
+  }
+}
+
+// Queue 0 is shared by all threads which are not workers (e.g. the main thread), queue i > 0 belongs to worker i.
+// Workers are only started and stopped while no batch is running, so the queues do not change while jobs use them.
+struct WorkerPool {
+  std::mutex mutex; // guards the members below, and starting or stopping the workers
+  size_t nBatchesRunning = 0;
+  ExternalScheduler externalScheduler;
+
+  std::vector<std::unique_ptr<JobQueue>> queues;
+  std::vector<std::thread> workers;
+  std::atomic<size_t> nQueued{0};
+
+  // idle workers wait here
+  std::mutex sleepMutex;
+  std::condition_variable wake;
+  bool stopping = false;
+
+  ~WorkerPool() { stop(); }
+
+  void start(size_t nWorkers);
+  void stop();
+  void workerLoop(size_t iQueue);
+
+  // Own queue newest-first (the jobs most likely to still be in cache), others oldest-first
+  bool takeJob(size_t iQueue, Job& job);
+};
+
+WorkerPool& pool() {
+  static WorkerPool p;
+  return p;
+}
+
+thread_local size_t thisQueue = 0;
+
+void WorkerPool::start(size_t nWorkers) {
+  for (size_t i = 0; i <= nWorkers; i++) {
+    queues.emplace_back(new JobQueue());
+  }
+  for (size_t i = 1; i <= nWorkers; i++) {
+    workers.emplace_back([this, i]() { workerLoop(i); });
+  }
+}
+
+void WorkerPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread& t : workers) {
+    t.join();
+  }
+  workers.clear();
+  queues.clear();
+  stopping = false;
+}
+
+void WorkerPool::workerLoop(size_t iQueue) {
+  thisQueue = iQueue;
+  while (true) {
+    Job job;
+    if (takeJob(iQueue, job)) {
+      runJob(job);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    wake.wait(lock, [&]() { return stopping || nQueued.load() > 0; });
+    if (stopping) return;
+  }
+}
+
+bool WorkerPool::takeJob(size_t iQueue, Job& job) {
+  size_t nQueues = queues.size();
+  for (size_t k = 0; k < nQueues; k++) {
+    JobQueue& q = *queues[(iQueue + k) % nQueues];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.jobs.empty()) continue;
+    if (k == 0) {
+      job = q.jobs.back();
+      q.jobs.pop_back();
+    } else {
+      job = q.jobs.front();
+      q.jobs.pop_front();
+    }
+    nQueued--;
+    return true;
+  }
+  return false;
+}
+
+} // namespace
+
+void runJobs(size_t nJobs, const std::function<void(size_t iJob)>& job) {
+  if (nJobs == 0) return;
+
+  Batch batch;
+  batch.job = &job;
+  batch.nRemaining = nJobs;
+  batch.errors.resize(nJobs);
+
+  WorkerPool& p = pool();
+  size_t nThreads = getNumThreads();
+  bool useWorkers = false;
+  ExternalScheduler external;
+  if (nJobs > 1 && nThreads > 1) {
+    std::lock_guard<std::mutex> lock(p.mutex);
+    if (p.externalScheduler) {
+      external = p.externalScheduler;
+    } else {
+      if (p.nBatchesRunning == 0 && p.workers.size() != nThreads - 1) {
+        p.stop();
+        p.start(nThreads - 1);
+      }
+      useWorkers = !p.workers.empty();
+      if (useWorkers) p.nBatchesRunning++;
+    }
+  }
+
+  if (external) {
+    external(nJobs, [&](size_t iJob) { runJob(Job{&batch, iJob}); });
+    rethrowFirst(batch.errors);
+    return;
+  }
+
+  if (!useWorkers) {
+    for (size_t iJob = 0; iJob < nJobs; iJob++) {
+      runJob(Job{&batch, iJob});
+    }
+    rethrowFirst(batch.errors);
+    return;
+  }
+
+  // Queue all but the first job, in reverse so that this thread takes them in order and other threads steal from the
+  // far end
+  {
+    JobQueue& q = *p.queues[thisQueue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    for (size_t iJob = nJobs - 1; iJob > 0; iJob--) {
+      q.jobs.push_back(Job{&batch, iJob});
+    }
+    p.nQueued += nJobs - 1;
+  }
+  {
+    std::lock_guard<std::mutex> lock(p.sleepMutex);
+  }
+  p.wake.notify_all();
+
+  // Work until the batch is done, running jobs from any batch
+  runJob(Job{&batch, 0});
+  while (batch.nRemaining.load(std::memory_order_acquire) > 0) {
+    Job other;
+    if (p.takeJob(thisQueue, other)) {
+      runJob(other);
+    } else {
+      std::this_thread::yield(); // the remaining jobs are running on other threads
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(p.mutex);
+    p.nBatchesRunning--;
+  }
+  rethrowFirst(batch.errors);
+}
+
+void setExternalScheduler(ExternalScheduler scheduler) {
+  WorkerPool& p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  p.externalScheduler = scheduler;
+  if (p.externalScheduler && p.nBatchesRunning == 0) {
+    p.stop();
+  }
+}
+
+void stopWorkers() {
+  WorkerPool& p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  if (p.nBatchesRunning == 0) {
+    p.stop();
+  }
+}
+
+size_t nRunningWorkers() {
+  WorkerPool& p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  return p.workers.size();
+}
+
+} // namespace tasks
+} // namespace polyscope
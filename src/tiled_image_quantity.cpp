@@ -0,0 +1,568 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+
+#include "polyscope/polyscope.h"
+
+#include "polyscope/tiled_image_quantity.h"
+
+#include "polyscope/mapped_file.h"
+
+#include "imgui.h"
+#include "polyscope/render/engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <tuple>
+
+namespace polyscope {
+
+namespace {
+// Uploads per frame, so that a burst of loaded tiles does not stall the frame. The rest wait for the next frame.
+const size_t maxTileUploadsPerFrame = 16;
+
+// Requests beyond this many are dropped, oldest first. They are re-requested if they are still visible.
+const size_t maxQueuedTileRequests = 512;
+
+// Resolution of the ImGui window and billboard renders
+const size_t intermediateMaxDim = 1024;
+} // namespace
+
+TiledImageQuantity::TiledImageQuantity(Structure& parent_, std::string name, size_t dimX, size_t dimY,
+                                       TiledImageLoader loader_, size_t tileSize_, ImageOrigin imageOrigin_)
+    : ImageQuantity(parent_, name, dimX, dimY, imageOrigin_), loader(loader_), tileSize(tileSize_) {
+
+  if (!loader) exception("tiled image quantity " + name + " needs a tile loader");
+  if (tileSize == 0) exception("tiled image quantity " + name + " tile size must be positive");
+  if (dimX == 0 || dimY == 0) exception("tiled image quantity " + name + " must not be empty");
+
+  levelCount = 1;
+  while (levelDimX(levelCount - 1) > tileSize || levelDimY(levelCount - 1) > tileSize) {
+    levelCount++;
+  }
+  resetView();
+
+  loaderThread = std::thread([this]() { loaderLoop(); });
+}
+
+TiledImageQuantity::~TiledImageQuantity() {
+  {
+    std::lock_guard<std::mutex> lock(loadMutex);
+    stopLoading = true;
+  }
+  loadCond.notify_all();
+  loaderThread.join();
+}
+
+// === Pyramid
+
+size_t TiledImageQuantity::nLevels() const { return levelCount; }
+size_t TiledImageQuantity::levelDimX(size_t level) const { return (dimX + (size_t(1) << level) - 1) >> level; }
+size_t TiledImageQuantity::levelDimY(size_t level) const { return (dimY + (size_t(1) << level) - 1) >> level; }
+size_t TiledImageQuantity::getTileSize() const { return tileSize; }
+
+uint64_t TiledImageQuantity::tileKey(size_t level, size_t tileX, size_t tileY) {
+  return (static_cast<uint64_t>(level) << 56) | (static_cast<uint64_t>(tileX) << 28) | static_cast<uint64_t>(tileY);
+}
+
+void TiledImageQuantity::unpackTileKey(uint64_t key, size_t& level, size_t& tileX, size_t& tileY) {
+  const uint64_t mask = (uint64_t(1) << 28) - 1;
+  level = static_cast<size_t>(key >> 56);
+  tileX = static_cast<size_t>((key >> 28) & mask);
+  tileY = static_cast<size_t>(key & mask);
+}
+
+std::array<size_t, 4> TiledImageQuantity::tilePixelRect(size_t level, size_t tileX, size_t tileY) const {
+  size_t x = tileX * tileSize;
+  size_t y = tileY * tileSize;
+  return {x, y, std::min(tileSize, levelDimX(level) - x), std::min(tileSize, levelDimY(level) - y)};
+}
+
+// === View
+
+void TiledImageQuantity::setViewWindow(double x0, double y0, double x1, double y1) {
+  if (!(x1 > x0) || !(y1 > y0)) {
+    exception("tiled image quantity " + name + " view window must have positive size");
+  }
+  viewWindow = {x0, y0, x1, y1};
+  requestRedraw();
+}
+
+std::array<double, 4> TiledImageQuantity::getViewWindow() const { return viewWindow; }
+
+void TiledImageQuantity::resetView() {
+  viewWindow = {0., 0., static_cast<double>(dimX), static_cast<double>(dimY)};
+  requestRedraw();
+}
+
+// === Tile cache
+
+void TiledImageQuantity::setTileCacheSize(size_t nTiles) {
+  if (nTiles == 0) exception("tiled image quantity " + name + " tile cache must hold at least one tile");
+  tileCacheSize = nTiles;
+  evictTiles();
+}
+
+size_t TiledImageQuantity::getTileCacheSize() const { return tileCacheSize; }
+
+size_t TiledImageQuantity::nCachedTiles() const { return tileCache.size(); }
+
+TiledImageQuantity::CachedTile* TiledImageQuantity::useCachedTile(uint64_t key) {
+  auto it = tileCache.find(key);
+  if (it == tileCache.end()) return nullptr;
+  tileLRU.splice(tileLRU.begin(), tileLRU, it->second.lruPosition);
+  return &it->second;
+}
+
+void TiledImageQuantity::evictTiles() {
+  while (tileCache.size() > tileCacheSize) {
+    tileCache.erase(tileLRU.back());
+    tileLRU.pop_back();
+  }
+}
+
+void TiledImageQuantity::clearTileCache() {
+  tileCache.clear();
+  tileLRU.clear();
+  failedTiles.clear();
+
+  {
+    // tiles which are loading right now are discarded when they arrive
+    std::lock_guard<std::mutex> lock(loadMutex);
+    for (uint64_t key : requestQueue) requestedTiles.erase(key);
+    for (LoadedTile& tile : loadedTiles) requestedTiles.erase(tile.key);
+    requestQueue.clear();
+    loadedTiles.clear();
+    loadGeneration++;
+  }
+  requestRedraw();
+}
+
+// === Loading
+
+void TiledImageQuantity::loaderLoop() {
+  while (true) {
+    LoadedTile tile;
+    {
+      std::unique_lock<std::mutex> lock(loadMutex);
+      loadCond.wait(lock, [&]() { return stopLoading || !requestQueue.empty(); });
+      if (stopLoading) return;
+      tile.key = requestQueue.front();
+      tile.generation = loadGeneration;
+      requestQueue.pop_front();
+      nLoading++;
+    }
+
+    size_t level, tileX, tileY;
+    unpackTileKey(tile.key, level, tileX, tileY);
+    std::array<size_t, 4> rect = tilePixelRect(level, tileX, tileY);
+    tile.pixels.resize(4 * rect[2] * rect[3]);
+    try {
+      loader(level, rect[0], rect[1], rect[2], rect[3], &tile.pixels.front());
+    } catch (const std::exception& e) {
+      tile.error = e.what();
+      if (tile.error.empty()) tile.error = "unknown error";
+    } catch (...) {
+      tile.error = "unknown error";
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(loadMutex);
+      loadedTiles.push_back(std::move(tile));
+      nLoading--;
+    }
+    loadCond.notify_all();
+  }
+}
+
+void TiledImageQuantity::requestTiles(const std::vector<uint64_t>& keys) {
+  {
+    std::lock_guard<std::mutex> lock(loadMutex);
+    for (uint64_t key : keys) {
+      if (requestedTiles.find(key) != requestedTiles.end()) {
+        // already queued: move it to the front. Otherwise it is loading already.
+        std::deque<uint64_t>::iterator it = std::find(requestQueue.begin(), requestQueue.end(), key);
+        if (it == requestQueue.end()) continue;
+        requestQueue.erase(it);
+      } else {
+        requestedTiles.insert(key);
+      }
+      requestQueue.push_front(key);
+    }
+
+    while (requestQueue.size() > maxQueuedTileRequests) {
+      requestedTiles.erase(requestQueue.back());
+      requestQueue.pop_back();
+    }
+  }
+  loadCond.notify_all();
+}
+
+void TiledImageQuantity::uploadLoadedTiles(size_t maxUploads) {
+  std::vector<LoadedTile> batch;
+  {
+    std::lock_guard<std::mutex> lock(loadMutex);
+    if (loadedTiles.empty()) return;
+    size_t nTake = std::min(maxUploads, loadedTiles.size());
+    batch.insert(batch.end(), std::make_move_iterator(loadedTiles.begin()),
+                 std::make_move_iterator(loadedTiles.begin() + nTake));
+    loadedTiles.erase(loadedTiles.begin(), loadedTiles.begin() + nTake);
+    for (LoadedTile& tile : batch) {
+      requestedTiles.erase(tile.key);
+    }
+  }
+
+  for (LoadedTile& tile : batch) {
+    if (tile.generation != loadGeneration) continue; // from before clearTileCache()
+
+    if (!tile.error.empty()) {
+      failedTiles.insert(tile.key);
+      warning("tiled image quantity " + name + " could not load a tile", tile.error);
+      continue;
+    }
+
+    size_t level, tileX, tileY;
+    unpackTileKey(tile.key, level, tileX, tileY);
+    std::array<size_t, 4> rect = tilePixelRect(level, tileX, tileY);
+    std::shared_ptr<render::TextureBuffer> texture =
+        render::engine->generateTextureBuffer(TextureFormat::RGBA8, rect[2], rect[3], &tile.pixels.front());
+
+    CachedTile* existing = useCachedTile(tile.key);
+    if (existing) {
+      existing->texture = texture;
+    } else {
+      tileLRU.push_front(tile.key);
+      tileCache[tile.key] = CachedTile{texture, tileLRU.begin()};
+    }
+  }
+  evictTiles();
+}
+
+void TiledImageQuantity::waitForPendingTiles() {
+  {
+    std::unique_lock<std::mutex> lock(loadMutex);
+    loadCond.wait(lock, [&]() { return requestQueue.empty() && nLoading == 0; });
+  }
+  uploadLoadedTiles(std::numeric_limits<size_t>::max());
+}
+
+// === Drawing
+
+void TiledImageQuantity::drawTiles(render::ShaderProgram& program, size_t targetW, size_t targetH,
+                                   const std::array<double, 4>& window) {
+  uploadLoadedTiles(maxTileUploadsPerFrame);
+
+  double windowW = window[2] - window[0];
+  double windowH = window[3] - window[1];
+  if (targetW == 0 || targetH == 0) return;
+
+  // the coarsest level which still has at least one image pixel per target pixel
+  double pixelsPerTarget = std::max(windowW / targetW, windowH / targetH);
+  size_t level = 0;
+  while (level + 1 < levelCount && static_cast<double>(size_t(1) << (level + 1)) <= pixelsPerTarget) {
+    level++;
+  }
+
+  // the tiles of that level which intersect the window
+  double scale = static_cast<double>(size_t(1) << level);
+  size_t nTilesX = (levelDimX(level) + tileSize - 1) / tileSize;
+  size_t nTilesY = (levelDimY(level) + tileSize - 1) / tileSize;
+  double tileExtent = scale * tileSize;
+  size_t tileX0 = static_cast<size_t>(std::max(0., std::floor(window[0] / tileExtent)));
+  size_t tileY0 = static_cast<size_t>(std::max(0., std::floor(window[1] / tileExtent)));
+  size_t tileX1 = static_cast<size_t>(std::max(0., std::ceil(window[2] / tileExtent)));
+  size_t tileY1 = static_cast<size_t>(std::max(0., std::ceil(window[3] / tileExtent)));
+  tileX1 = std::min(tileX1, nTilesX);
+  tileY1 = std::min(tileY1, nTilesY);
+
+  // Split them in to cached tiles, and missing tiles which get requested and stand in with their nearest cached
+  // ancestor. The ancestor of tile (x, y) k levels up is (x >> k, y >> k).
+  std::vector<std::tuple<size_t, uint64_t, CachedTile*>> drawList; // (level, key, tile)
+  std::unordered_set<uint64_t> fallbackKeys;
+  std::vector<uint64_t> missing;
+  for (size_t tileY = tileY0; tileY < tileY1; tileY++) {
+    for (size_t tileX = tileX0; tileX < tileX1; tileX++) {
+      uint64_t key = tileKey(level, tileX, tileY);
+      CachedTile* tile = useCachedTile(key);
+      if (tile) {
+        drawList.emplace_back(level, key, tile);
+        continue;
+      }
+
+      if (failedTiles.find(key) == failedTiles.end()) missing.push_back(key);
+      for (size_t k = 1; level + k < levelCount; k++) {
+        uint64_t ancestorKey = tileKey(level + k, tileX >> k, tileY >> k);
+        CachedTile* ancestor = useCachedTile(ancestorKey);
+        if (!ancestor) continue;
+        if (fallbackKeys.insert(ancestorKey).second) drawList.emplace_back(level + k, ancestorKey, ancestor);
+        break;
+      }
+    }
+  }
+
+  // the single tile of the top level always loads first, so there is always something to show
+  uint64_t rootKey = tileKey(levelCount - 1, 0, 0);
+  if (level + 1 < levelCount && !useCachedTile(rootKey) && failedTiles.find(rootKey) == failedTiles.end()) {
+    missing.push_back(rootKey);
+  }
+  if (!missing.empty()) requestTiles(missing);
+
+  // coarse stand-ins first, so the finer tiles land on top
+  std::stable_sort(drawList.begin(), drawList.end(),
+                   [](const std::tuple<size_t, uint64_t, CachedTile*>& a,
+                      const std::tuple<size_t, uint64_t, CachedTile*>& b) { return std::get<0>(a) > std::get<0>(b); });
+
+  for (const std::tuple<size_t, uint64_t, CachedTile*>& entry : drawList) {
+    size_t tileLevel, tileX, tileY;
+    unpackTileKey(std::get<1>(entry), tileLevel, tileX, tileY);
+    std::array<size_t, 4> rect = tilePixelRect(tileLevel, tileX, tileY);
+
+    // the tile in full resolution pixels, then as a fraction of the window
+    double tileScale = static_cast<double>(size_t(1) << tileLevel);
+    double x0 = (rect[0] * tileScale - window[0]) / windowW;
+    double x1 = (std::min((rect[0] + rect[2]) * tileScale, static_cast<double>(dimX)) - window[0]) / windowW;
+    double y0 = (rect[1] * tileScale - window[1]) / windowH;
+    double y1 = (std::min((rect[1] + rect[3]) * tileScale, static_cast<double>(dimY)) - window[1]) / windowH;
+
+    // to the clip space rectangle, where the first image row goes to the top for ImageOrigin::UpperLeft
+    glm::vec4 tileRect;
+    if (imageOrigin == ImageOrigin::UpperLeft) {
+      tileRect = glm::vec4{2. * x0 - 1., 1. - 2. * y1, 2. * x1 - 1., 1. - 2. * y0};
+    } else {
+      tileRect = glm::vec4{2. * x0 - 1., 2. * y0 - 1., 2. * x1 - 1., 2. * y1 - 1.};
+    }
+
+    program.setUniform("u_tileRect", tileRect);
+    program.setTextureFromBuffer("t_image", std::get<2>(entry)->texture.get());
+    program.draw();
+  }
+
+  // keep drawing frames until the requested tiles have arrived
+  bool loading;
+  {
+    std::lock_guard<std::mutex> lock(loadMutex);
+    loading = !requestedTiles.empty();
+  }
+  if (loading) requestRedraw();
+}
+
+std::shared_ptr<render::ShaderProgram> TiledImageQuantity::requestTileProgram(bool billboard) {
+  std::vector<std::string> rules{getImageOriginRule(imageOrigin), "TEXTURE_SET_TRANSPARENCY",
+                                 "TEXTURE_TILE_FROM_UNIFORMS"};
+  if (billboard) rules.push_back("TEXTURE_BILLBOARD_FROM_UNIFORMS");
+  rules.push_back("INVERSE_TONEMAP");
+  rules.push_back("TEXTURE_PREMULTIPLY_OUT");
+
+  std::shared_ptr<render::ShaderProgram> program =
+      render::engine->requestShader("TEXTURE_DRAW_PLAIN", rules, render::ShaderReplacementDefaults::Process);
+  program->setAttribute("a_position", render::engine->screenTrianglesCoords());
+  return program;
+}
+
+void TiledImageQuantity::prepareIntermediateRender() {
+  // the image at up to intermediateMaxDim across, same as it is shown in the window
+  size_t w = std::min(dimX, intermediateMaxDim);
+  size_t h = std::max<size_t>(1, w * dimY / dimX);
+  framebufferIntermediate = render::engine->generateFrameBuffer(w, h);
+  textureIntermediateRendered = render::engine->generateTextureBuffer(TextureFormat::RGB16F, w, h);
+  framebufferIntermediate->addColorBuffer(textureIntermediateRendered);
+  framebufferIntermediate->setViewport(0, 0, w, h);
+  framebufferIntermediate->clearColor = glm::vec3{0., 0., 0.};
+}
+
+void TiledImageQuantity::showFullscreen() {
+
+  if (!fullscreenProgram) {
+    fullscreenProgram = requestTileProgram(false);
+  }
+
+  render::engine->setBlendMode(BlendMode::AlphaOver);
+
+  // Set uniforms
+  fullscreenProgram->setUniform("u_transparency", getTransparency());
+  render::engine->setTonemapUniforms(*fullscreenProgram);
+
+  drawTiles(*fullscreenProgram, static_cast<size_t>(view::bufferWidth), static_cast<size_t>(view::bufferHeight),
+            viewWindow);
+
+  render::engine->applyTransparencySettings();
+}
+
+void TiledImageQuantity::renderIntermediate() {
+  if (!fullscreenProgram) fullscreenProgram = requestTileProgram(false);
+  if (!textureIntermediateRendered) prepareIntermediateRender();
+
+  // Set uniforms
+  fullscreenProgram->setUniform("u_transparency", getTransparency());
+  render::engine->setTonemapUniforms(*fullscreenProgram);
+
+  // render to the intermediate texture
+  render::engine->pushBindFramebufferForRendering(*framebufferIntermediate);
+  framebufferIntermediate->clear(); // the view may not cover all of it
+  render::engine->setBlendMode(BlendMode::AlphaOver);
+  drawTiles(*fullscreenProgram, textureIntermediateRendered->getSizeX(), textureIntermediateRendered->getSizeY(),
+            viewWindow);
+  render::engine->popBindFramebufferForRendering();
+  render::engine->applyTransparencySettings();
+}
+
+void TiledImageQuantity::showInImGuiWindow() {
+  // it's important to do this here, so the image is available this frame
+  renderIntermediate();
+
+  ImGui::Begin(name.c_str(), nullptr, ImGuiWindowFlags_NoScrollbar);
+
+  double windowW = viewWindow[2] - viewWindow[0];
+  double windowH = viewWindow[3] - viewWindow[1];
+  float w = ImGui::GetWindowWidth();
+  float h = static_cast<float>(w * windowH / windowW);
+
+  ImGui::Text("Dimensions: %zux%zu, %zu levels, %zu tiles cached", dimX, dimY, levelCount, tileCache.size());
+
+  // the texture is in openGL order after the intermediate render pass
+  ImVec2 imageMin = ImGui::GetCursorScreenPos();
+  ImGui::Image(textureIntermediateRendered->getNativeHandle(), ImVec2(w, h), ImVec2(0, 1), ImVec2(1, 0));
+
+  // an invisible button on top of the image takes the mouse, so dragging pans rather than moving the window
+  if (w > 0 && h > 0) {
+    ImGui::SetCursorScreenPos(imageMin);
+    ImGui::InvisibleButton("##tiledImageView", ImVec2(w, h));
+    ImGuiIO& io = ImGui::GetIO();
+    double flipY = imageOrigin == ImageOrigin::UpperLeft ? 1. : -1.; // image rows run down the screen
+
+    if (ImGui::IsItemActive() && ImGui::IsMouseDragging(0)) {
+      double dx = -io.MouseDelta.x / w * windowW;
+      double dy = -flipY * io.MouseDelta.y / h * windowH;
+      setViewWindow(viewWindow[0] + dx, viewWindow[1] + dy, viewWindow[2] + dx, viewWindow[3] + dy);
+    }
+
+    if (ImGui::IsItemHovered() && io.MouseWheel != 0.) {
+      // zoom about the point under the mouse
+      double fx = (io.MousePos.x - imageMin.x) / w;
+      double fy = (io.MousePos.y - imageMin.y) / h;
+      if (flipY < 0) fy = 1. - fy;
+      double px = viewWindow[0] + fx * windowW;
+      double py = viewWindow[1] + fy * windowH;
+      double factor = std::pow(0.8, io.MouseWheel);
+      setViewWindow(px - fx * windowW * factor, py - fy * windowH * factor, px + (1. - fx) * windowW * factor,
+                    py + (1. - fy) * windowH * factor);
+    }
+  }
+
+  ImGui::End();
+}
+
+void TiledImageQuantity::showInBillboard(glm::vec3 center, glm::vec3 upVec, glm::vec3 rightVec) {
+
+  if (!billboardProgram) {
+    billboardProgram = requestTileProgram(true);
+  }
+
+  // ensure the scale of rightVec matches the aspect ratio of the image
+  rightVec = glm::normalize(rightVec) * glm::length(upVec) * ((float)dimX / dimY);
+
+  // set uniforms
+  parent.setStructureUniforms(*billboardProgram);
+  billboardProgram->setUniform("u_transparency", getTransparency());
+  billboardProgram->setUniform("u_billboardCenter", center);
+  billboardProgram->setUniform("u_billboardUp", upVec);
+  billboardProgram->setUniform("u_billboardRight", rightVec);
+  render::engine->setTonemapUniforms(*billboardProgram);
+
+  render::engine->setBackfaceCull(false);
+  render::engine->setBlendMode(BlendMode::AlphaOver);
+
+  // the billboard always shows the whole image
+  size_t w = std::min(dimX, intermediateMaxDim);
+  size_t h = std::max<size_t>(1, w * dimY / dimX);
+  std::array<double, 4> wholeImage{0., 0., static_cast<double>(dimX), static_cast<double>(dimY)};
+  drawTiles(*billboardProgram, w, h, wholeImage);
+
+  render::engine->setBackfaceCull(); // return to default setting
+  render::engine->applyTransparencySettings();
+}
+
+// === UI and settings
+
+void TiledImageQuantity::buildCustomUI() {
+  ImGui::SameLine();
+
+  // == Options popup
+  if (ImGui::Button("Options")) {
+    ImGui::OpenPopup("OptionsPopup");
+  }
+  if (ImGui::BeginPopup("OptionsPopup")) {
+
+    buildImageOptionsUI();
+
+    if (ImGui::MenuItem("Reset view")) resetView();
+    if (ImGui::MenuItem("Clear tile cache")) clearTileCache();
+
+    ImGui::EndPopup();
+  }
+
+  buildImageUI();
+}
+
+void TiledImageQuantity::refresh() {
+  fullscreenProgram.reset();
+  billboardProgram.reset();
+  Quantity::refresh();
+}
+
+std::string TiledImageQuantity::niceName() { return name + " (tiled image)"; }
+
+TiledImageQuantity* TiledImageQuantity::setEnabled(bool newEnabled) {
+  if (newEnabled == isEnabled()) return this;
+  if (newEnabled == true && getShowFullscreen()) {
+    // if drawing fullscreen, disable anything else which was already drawing fullscreen
+    disableAllFullscreenArtists();
+  }
+  enabled = newEnabled;
+  parent.markEnabledQuantitiesStale();
+  requestRedraw();
+  return this;
+}
+
+// === Loaders
+
+TiledImageLoader tiledImageLoaderFromRawFile(std::string filename, size_t dimX, size_t dimY, int nChannels) {
+  if (nChannels != 3 && nChannels != 4) {
+    exception("tiled image file " + filename + " must have 3 or 4 channels");
+  }
+  std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(filename);
+  size_t rowBytes = dimX * nChannels;
+  if (file->size < rowBytes * dimY) {
+    exception("tiled image file " + filename + " is too small for a " + std::to_string(dimX) + "x" +
+              std::to_string(dimY) + " image with " + std::to_string(nChannels) + " channels");
+  }
+
+  return [file, dimX, dimY, nChannels, rowBytes](size_t level, size_t x, size_t y, size_t w, size_t h,
+                                                  unsigned char* pixelsRGBA) {
+    // coarser levels take the pixel at the center of each 2^level block, which only touches the pages it needs
+    size_t step = size_t(1) << level;
+    for (size_t j = 0; j < h; j++) {
+      size_t srcY = std::min((y + j) * step + step / 2, dimY - 1);
+      const unsigned char* srcRow = file->data + srcY * rowBytes;
+      unsigned char* dst = pixelsRGBA + 4 * j * w;
+      for (size_t i = 0; i < w; i++) {
+        size_t srcX = std::min((x + i) * step + step / 2, dimX - 1);
+        const unsigned char* src = srcRow + srcX * nChannels;
+        dst[4 * i + 0] = src[0];
+        dst[4 * i + 1] = src[1];
+        dst[4 * i + 2] = src[2];
+        dst[4 * i + 3] = nChannels == 4 ? src[3] : 255;
+      }
+    }
+  };
+}
+
+// Instantiate a construction helper which is used to avoid header dependencies. See forward declaration and note in
+// structure.ipp.
+TiledImageQuantity* createTiledImageQuantity(Structure& parent, std::string name, size_t dimX, size_t dimY,
+                                             TiledImageLoader loader, size_t tileSize, ImageOrigin imageOrigin) {
+  return new TiledImageQuantity(parent, name, dimX, dimY, loader, tileSize, imageOrigin);
+}
+
+} // namespace polyscope
@@ -0,0 +1,120 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/trace.h"
+
+#include "polyscope/messages.h"
+
+#include "nlohmann/json.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace polyscope {
+
+namespace detail {
+std::atomic<bool> traceEnabled{false};
+} // namespace detail
+
+namespace {
+
+struct TraceSpanRecord {
+  const char* name;
+  std::string detail;
+  int64_t startUs;
+  int64_t durationUs;
+  uint32_t threadId;
+};
+
+// Beyond this the spans are dropped (and counted), so a forgotten trace does not grow without bound
+const size_t maxTraceSpans = 1 << 20;
+
+std::mutex traceMutex;
+std::vector<TraceSpanRecord> traceSpans;
+size_t traceSpansDropped = 0;
+
+// Small consecutive ids read better in trace viewers than hashed native thread ids
+std::atomic<uint32_t> nextTraceThreadId{1};
+uint32_t traceThreadId() {
+  static thread_local uint32_t id = nextTraceThreadId.fetch_add(1);
+  return id;
+}
+
+} // namespace
+
+namespace detail {
+
+int64_t traceNowMicroseconds() {
+  // the steady clock is the monotonic clock on the usual platforms, so spans line up with other in-process tracers
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void recordTraceSpan(const char* name, const std::string& detail, int64_t startUs) {
+  int64_t endUs = traceNowMicroseconds();
+  uint32_t threadId = traceThreadId();
+
+  std::lock_guard<std::mutex> lock(traceMutex);
+  if (traceSpans.size() >= maxTraceSpans) {
+    traceSpansDropped++;
+    return;
+  }
+  traceSpans.push_back(TraceSpanRecord{name, detail, startUs, endUs - startUs, threadId});
+}
+
+} // namespace detail
+
+void startTrace() {
+#ifndef POLYSCOPE_ENABLE_TRACING
+  warning("Polyscope was built without POLYSCOPE_ENABLE_TRACING, no spans will be recorded");
+#endif
+  {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    traceSpans.clear();
+    traceSpansDropped = 0;
+  }
+  detail::traceEnabled = true;
+}
+
+void stopTrace() { detail::traceEnabled = false; }
+
+bool isTracing() { return detail::traceEnabled; }
+
+size_t getTraceSpanCount() {
+  std::lock_guard<std::mutex> lock(traceMutex);
+  return traceSpans.size();
+}
+
+std::string getTraceJSON() {
+  json events = json::array();
+  size_t dropped;
+  {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    for (const TraceSpanRecord& s : traceSpans) {
+      // "X" is a complete event, with a start and a duration
+      json e = {{"name", s.name}, {"cat", "polyscope"}, {"ph", "X"},       {"ts", s.startUs},
+                {"dur", s.durationUs}, {"pid", 1},      {"tid", s.threadId}};
+      if (!s.detail.empty()) e["args"] = {{"detail", s.detail}};
+      events.push_back(e);
+    }
+    dropped = traceSpansDropped;
+  }
+
+  json trace = {{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+  if (dropped > 0) trace["otherData"] = {{"droppedSpans", std::to_string(dropped)}};
+
+  return trace.dump();
+}
+
+void writeTraceJSON(std::string filename) {
+  std::ofstream outFile(filename);
+  if (!outFile) {
+    exception("could not open trace file " + filename);
+  }
+  outFile << getTraceJSON();
+}
+
+} // namespace polyscope
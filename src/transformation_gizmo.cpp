@@ -20,6 +20,7 @@ void TransformationGizmo::markUpdated() {
   if (Tpers != nullptr) {
     Tpers->manuallyChanged();
   }
+  transformChangedInDrag = true;
 }
 
 void TransformationGizmo::prepare() {
@@ -77,8 +78,7 @@ void TransformationGizmo::prepare() {
     sphereProgram = render::engine->requestShader("RAYCAST_SPHERE", 
         render::engine->addMaterialRules(material,
           {
-            "SHADE_BASECOLOR", 
-            "LIGHT_MATCAP"
+            "SHADE_BASECOLOR"
           }
         ),
       render::ShaderReplacementDefaults::Process);
@@ -168,6 +168,13 @@ bool TransformationGizmo::interact() {
   bool draggingAtStart = currentlyDragging;
   if (currentlyDragging && (!ImGui::IsMouseDown(0) || !ImGui::IsMousePosValid())) {
     currentlyDragging = false;
+
+    // While dragging only the transform uniform changes. The scene extents catch up once, here, which also keeps the
+    // ground plane and the gizmo size (from the length scale) steady during the drag.
+    if (transformChangedInDrag) {
+      transformChangedInDrag = false;
+      updateStructureExtents();
+    }
   }
 
   // Get the mouse ray in world space
@@ -0,0 +1,181 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/update_queue.h"
+
+#include "polyscope/internal.h"
+#include "polyscope/messages.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace polyscope {
+
+namespace {
+
+struct QueuedUpdate {
+  std::string key; // "" for updates which are never replaced
+  std::function<void()> update;
+};
+
+struct UpdateQueueState {
+  // guarded by the mutex
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::vector<QueuedUpdate> pending;
+  uint64_t nQueued = 0;  // updates queued since startup, replaced ones included
+  uint64_t nApplied = 0; // of those, the ones which have run (or been replaced)
+  bool stopRequested = false;
+
+  // the thread which runs the updates, i.e. the one driving the main loop
+  std::thread::id renderThread = std::this_thread::get_id();
+
+  // background callback, only touched by the render thread
+  std::thread background;
+  bool backgroundRunning = false;
+};
+
+UpdateQueueState updates;
+
+// see releaseStagingPools(), guarded by their own mutex since pools register from any thread
+std::mutex stagingPoolsMutex;
+std::vector<void (*)()> stagingPoolClears;
+
+void pushUpdate(std::string key, std::function<void()> update) {
+  {
+    std::lock_guard<std::mutex> lock(updates.mutex);
+    updates.nQueued++;
+    if (!key.empty()) {
+      for (QueuedUpdate& u : updates.pending) {
+        if (u.key == key) {
+          u.update = std::move(update);
+          return;
+        }
+      }
+    }
+    updates.pending.push_back(QueuedUpdate{std::move(key), std::move(update)});
+  }
+  internal::wakeIdleMainLoop();
+}
+
+} // namespace
+
+void queueUpdate(std::function<void()> update) { pushUpdate("", std::move(update)); }
+
+void queueUpdate(std::string key, std::function<void()> update) { pushUpdate(std::move(key), std::move(update)); }
+
+void waitForQueuedUpdates() {
+  if (std::this_thread::get_id() == updates.renderThread) {
+    processQueuedUpdates();
+    return;
+  }
+
+  // also released when the background callback is being stopped, since the render thread is then busy joining it
+  std::unique_lock<std::mutex> lock(updates.mutex);
+  uint64_t target = updates.nQueued;
+  updates.cond.wait(lock, [&]() { return updates.nApplied >= target || updates.stopRequested; });
+}
+
+bool hasQueuedUpdates() {
+  std::lock_guard<std::mutex> lock(updates.mutex);
+  return !updates.pending.empty();
+}
+
+void processQueuedUpdates() {
+  updates.renderThread = std::this_thread::get_id();
+
+  std::vector<QueuedUpdate> batch;
+  uint64_t batchEnd;
+  {
+    std::lock_guard<std::mutex> lock(updates.mutex);
+    if (updates.pending.empty()) return;
+    batch.swap(updates.pending);
+    batchEnd = updates.nQueued;
+  }
+
+  auto markApplied = [&]() {
+    {
+      std::lock_guard<std::mutex> lock(updates.mutex);
+      updates.nApplied = batchEnd;
+    }
+    updates.cond.notify_all();
+  };
+
+  // updates queued while these run wait for the next sync point
+  try {
+    for (QueuedUpdate& u : batch) {
+      u.update();
+    }
+  } catch (...) {
+    markApplied();
+    throw;
+  }
+  markApplied();
+}
+
+void startBackgroundCallback(std::function<void()> work) {
+  if (updates.backgroundRunning) {
+    exception("a background callback is already running, call stopBackgroundCallback() first");
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(updates.mutex);
+    updates.stopRequested = false;
+  }
+  updates.backgroundRunning = true;
+  updates.background = std::thread([work]() {
+    // always runs at least once, even if stopped right away
+    while (true) {
+      try {
+        work();
+      } catch (const std::exception& e) {
+        std::string message = e.what();
+        queueUpdate([message]() { exception("background callback failed: " + message); });
+        break;
+      }
+      std::lock_guard<std::mutex> lock(updates.mutex);
+      if (updates.stopRequested) break;
+    }
+  });
+}
+
+void stopBackgroundCallback() {
+  if (!updates.backgroundRunning) return;
+
+  {
+    std::lock_guard<std::mutex> lock(updates.mutex);
+    updates.stopRequested = true;
+  }
+  updates.cond.notify_all();
+  updates.background.join();
+  updates.backgroundRunning = false;
+
+  processQueuedUpdates();
+  releaseStagingPools();
+}
+
+bool isBackgroundCallbackRunning() { return updates.backgroundRunning; }
+
+namespace detail {
+void registerStagingPool(void (*clearPool)()) {
+  std::lock_guard<std::mutex> lock(stagingPoolsMutex);
+  stagingPoolClears.push_back(clearPool);
+}
+} // namespace detail
+
+void releaseStagingPools() {
+  // the pools are cleared outside of the lock, they take their own lock and may be registering meanwhile
+  std::vector<void (*)()> clears;
+  {
+    std::lock_guard<std::mutex> lock(stagingPoolsMutex);
+    clears = stagingPoolClears;
+  }
+  for (void (*clearPool)() : clears) {
+    clearPool();
+  }
+}
+
+} // namespace polyscope
@@ -3,12 +3,17 @@
 #include "polyscope/utilities.h"
 
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <limits>
+#include <unordered_map>
 #include <vector>
 
 #include "imgui.h"
 
 #include "polyscope/messages.h"
+#include "polyscope/parallel.h"
 
 
 namespace polyscope {
@@ -121,6 +126,457 @@ std::string prettyPrintCount(size_t count) {
   }
 }
 
+namespace {
+
+// The stable order which sorts keys of (at most) nBits bits, by a parallel least-significant-digit radix sort. Each
+// pass counts the digits per chunk of the input, then every chunk scatters its items to its own range of each bucket.
+std::vector<uint32_t> radixSortOrder(std::vector<uint32_t> keys, int nBits) {
+  const int digitBits = 10;
+  const size_t nBuckets = static_cast<size_t>(1) << digitBits;
+  size_t n = keys.size();
+
+  std::vector<uint32_t> order(n);
+  for (size_t i = 0; i < n; i++) order[i] = static_cast<uint32_t>(i);
+  std::vector<uint32_t> keysOut(n);
+  std::vector<uint32_t> orderOut(n);
+
+  size_t nChunks = parallelChunkCount(n);
+  std::vector<size_t> offsets(nChunks * nBuckets);
+  for (int shift = 0; shift < nBits; shift += digitBits) {
+    auto digit = [&](uint32_t key) { return (key >> shift) & (nBuckets - 1); };
+
+    std::fill(offsets.begin(), offsets.end(), 0);
+    parallelForChunks(0, n, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+      size_t* chunkCounts = &offsets[iChunk * nBuckets];
+      for (size_t i = begin; i < end; i++) chunkCounts[digit(keys[i])]++;
+    });
+
+    // where each chunk starts writing in each bucket: buckets in order, and chunks in order within a bucket
+    size_t sum = 0;
+    for (size_t iB = 0; iB < nBuckets; iB++) {
+      for (size_t iChunk = 0; iChunk < nChunks; iChunk++) {
+        size_t count = offsets[iChunk * nBuckets + iB];
+        offsets[iChunk * nBuckets + iB] = sum;
+        sum += count;
+      }
+    }
+
+    parallelForChunks(0, n, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+      size_t* chunkOffsets = &offsets[iChunk * nBuckets];
+      for (size_t i = begin; i < end; i++) {
+        size_t dst = chunkOffsets[digit(keys[i])]++;
+        keysOut[dst] = keys[i];
+        orderOut[dst] = order[i];
+      }
+    });
+
+    keys.swap(keysOut);
+    order.swap(orderOut);
+  }
+
+  return order;
+}
+
+} // namespace
+
+std::vector<uint32_t> mortonOrder(const std::vector<glm::vec3>& points) {
+  size_t n = points.size();
+
+  // quantize to 10 bits per axis within the bounding box
+  glm::vec3 bMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  glm::vec3 bMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (const glm::vec3& p : points) {
+    bMin = componentwiseMin(bMin, p);
+    bMax = componentwiseMax(bMax, p);
+  }
+  glm::vec3 scale;
+  for (int j = 0; j < 3; j++) {
+    scale[j] = (bMax[j] > bMin[j]) ? 1023.f / (bMax[j] - bMin[j]) : 0.f;
+  }
+
+  // spread the low 10 bits of x so there are two zero bits between each
+  auto spreadBits = [](uint32_t x) {
+    x &= 0x3ff;
+    x = (x | (x << 16)) & 0x030000FF;
+    x = (x | (x << 8)) & 0x0300F00F;
+    x = (x | (x << 4)) & 0x030C30C3;
+    x = (x | (x << 2)) & 0x09249249;
+    return x;
+  };
+
+  std::vector<uint32_t> codes(n);
+  parallelFor(0, n, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      glm::vec3 q = glm::clamp((points[i] - bMin) * scale, 0.f, 1023.f);
+      if (!isFinite(q)) q = glm::vec3{0., 0., 0.};
+      codes[i] = spreadBits(static_cast<uint32_t>(q.x)) | (spreadBits(static_cast<uint32_t>(q.y)) << 1) |
+                 (spreadBits(static_cast<uint32_t>(q.z)) << 2);
+    }
+  });
+
+  // the sort is stable, so ties are kept in index order and the result is deterministic
+  return radixSortOrder(std::move(codes), 30);
+}
+
+std::vector<uint32_t> backToFrontOrder(const std::vector<glm::vec3>& points, const glm::mat4& modelView) {
+  size_t n = points.size();
+
+  // view space depth is -z, quantize it to 30 bits within the range of the points, farthest first
+  std::vector<float> depths(n);
+  parallelFor(0, n, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      float d = -(modelView * glm::vec4(points[i], 1.f)).z;
+      depths[i] = std::isfinite(d) ? d : 0.f;
+    }
+  });
+  float dMin = std::numeric_limits<float>::infinity();
+  float dMax = -std::numeric_limits<float>::infinity();
+  for (float d : depths) {
+    dMin = std::min(dMin, d);
+    dMax = std::max(dMax, d);
+  }
+  const double maxKey = static_cast<double>((1u << 30) - 1);
+  double scale = (dMax > dMin) ? maxKey / (static_cast<double>(dMax) - dMin) : 0.;
+
+  std::vector<uint32_t> keys(n);
+  parallelFor(0, n, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      double q = std::min(maxKey, std::max(0., (static_cast<double>(dMax) - depths[i]) * scale));
+      keys[i] = static_cast<uint32_t>(q);
+    }
+  });
+
+  return radixSortOrder(std::move(keys), 30);
+}
+
+std::vector<uint32_t> multiResolutionOrder(const std::vector<glm::vec3>& points) {
+  std::vector<uint32_t> sorted = mortonOrder(points);
+  size_t n = sorted.size();
+
+  int nBits = 0;
+  while ((static_cast<size_t>(1) << nBits) < n) nBits++;
+
+  // Visiting 0, 1/2, 1/4, 3/4, ... of the way along the curve means each power-of-two prefix is evenly spread over it
+  std::vector<uint32_t> order;
+  order.reserve(n);
+  for (size_t j = 0; j < (static_cast<size_t>(1) << nBits); j++) {
+    size_t r = 0;
+    for (int b = 0; b < nBits; b++) {
+      if (j & (static_cast<size_t>(1) << b)) r |= static_cast<size_t>(1) << (nBits - 1 - b);
+    }
+    if (r < n) order.push_back(sorted[r]);
+  }
+  return order;
+}
+
+namespace {
+
+const size_t vertexCacheSize = 32;
+
+// Forsyth's score for a vertex: favor vertices which are in the cache, and those with few triangles left to draw
+float vertexCacheScore(int cachePos, uint32_t nRemainingTris) {
+  if (nRemainingTris == 0) return -1.f;
+
+  float score = 0.f;
+  if (cachePos >= 0) {
+    if (cachePos < 3) {
+      // used by the last triangle, a fixed score so the next one is not always chosen from the same fan
+      score = 0.75f;
+    } else {
+      score = std::pow(1.f - static_cast<float>(cachePos - 3) / (vertexCacheSize - 3), 1.5f);
+    }
+  }
+  score += 2.f * std::pow(static_cast<float>(nRemainingTris), -0.5f);
+  return score;
+}
+
+} // namespace
+
+std::vector<uint32_t> vertexCacheTriangleOrder(const std::vector<uint32_t>& triangleVertexInds, size_t nVertices) {
+  const std::vector<uint32_t>& inds = triangleVertexInds;
+  size_t nTri = inds.size() / 3;
+
+  // The triangles around each vertex, in compressed rows. The first nRemaining[v] entries of each row are the
+  // triangles which have not been emitted yet.
+  std::vector<uint32_t> adjStart(nVertices + 1, 0);
+  for (size_t i = 0; i < 3 * nTri; i++) {
+    adjStart[inds[i] + 1]++;
+  }
+  for (size_t v = 0; v < nVertices; v++) {
+    adjStart[v + 1] += adjStart[v];
+  }
+  std::vector<uint32_t> adjTris(3 * nTri);
+  std::vector<uint32_t> nRemaining(nVertices, 0);
+  for (size_t i = 0; i < 3 * nTri; i++) {
+    uint32_t v = inds[i];
+    adjTris[adjStart[v] + nRemaining[v]] = static_cast<uint32_t>(i / 3);
+    nRemaining[v]++;
+  }
+
+  std::vector<int> cachePos(nVertices, -1);
+  std::vector<float> vertScore(nVertices);
+  for (size_t v = 0; v < nVertices; v++) {
+    vertScore[v] = vertexCacheScore(-1, nRemaining[v]);
+  }
+  std::vector<float> triScore(nTri);
+  std::vector<char> triEmitted(nTri, false);
+  int64_t bestTri = -1;
+  for (size_t iT = 0; iT < nTri; iT++) {
+    triScore[iT] = vertScore[inds[3 * iT]] + vertScore[inds[3 * iT + 1]] + vertScore[inds[3 * iT + 2]];
+    if (bestTri < 0 || triScore[iT] > triScore[bestTri]) bestTri = iT;
+  }
+
+  std::vector<uint32_t> order;
+  order.reserve(nTri);
+  std::vector<uint32_t> cache, newCache;
+  size_t scanStart = 0;
+  while (order.size() < nTri) {
+
+    // nothing useful in the cache, start again from the first triangle not yet emitted
+    if (bestTri < 0) {
+      while (triEmitted[scanStart]) scanStart++;
+      bestTri = scanStart;
+    }
+
+    uint32_t iT = static_cast<uint32_t>(bestTri);
+    triEmitted[iT] = true;
+    order.push_back(iT);
+
+    // remove it from the rows of its vertices, and move them to the front of the cache
+    newCache.clear();
+    for (uint32_t k = 0; k < 3; k++) {
+      uint32_t v = inds[3 * iT + k];
+      uint32_t* row = &adjTris[adjStart[v]];
+      for (uint32_t j = 0; j < nRemaining[v]; j++) {
+        if (row[j] == iT) {
+          std::swap(row[j], row[nRemaining[v] - 1]);
+          nRemaining[v]--;
+          break;
+        }
+      }
+      if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) newCache.push_back(v);
+    }
+    size_t nFront = newCache.size(); // fewer than 3 for degenerate triangles
+    for (uint32_t v : cache) {
+      if (std::find(newCache.begin(), newCache.begin() + nFront, v) == newCache.begin() + nFront) newCache.push_back(v);
+    }
+
+    // update the scores of everything which was in the cache, including the vertices pushed out of it
+    for (size_t i = 0; i < newCache.size(); i++) {
+      uint32_t v = newCache[i];
+      cachePos[v] = (i < vertexCacheSize) ? static_cast<int>(i) : -1;
+      vertScore[v] = vertexCacheScore(cachePos[v], nRemaining[v]);
+    }
+    bestTri = -1;
+    for (size_t i = 0; i < newCache.size(); i++) {
+      uint32_t v = newCache[i];
+      for (uint32_t j = 0; j < nRemaining[v]; j++) {
+        uint32_t iAdj = adjTris[adjStart[v] + j];
+        triScore[iAdj] = vertScore[inds[3 * iAdj]] + vertScore[inds[3 * iAdj + 1]] + vertScore[inds[3 * iAdj + 2]];
+        if (i < vertexCacheSize && (bestTri < 0 || triScore[iAdj] > triScore[bestTri])) bestTri = iAdj;
+      }
+    }
+
+    if (newCache.size() > vertexCacheSize) newCache.resize(vertexCacheSize);
+    cache.swap(newCache);
+  }
+
+  return order;
+}
+
+float averageCacheMissRatio(const std::vector<uint32_t>& triangleVertexInds, size_t cacheSize) {
+  size_t nTri = triangleVertexInds.size() / 3;
+  if (nTri == 0 || cacheSize == 0) return 0.f;
+
+  // simulate the FIFO by the time each vertex entered it, it is still cached until cacheSize more have entered
+  size_t nInserted = 0;
+  std::vector<size_t> insertTime;
+  size_t nMisses = 0;
+  for (uint32_t v : triangleVertexInds) {
+    if (v >= insertTime.size()) insertTime.resize(v + 1, std::numeric_limits<size_t>::max());
+    bool inCache = insertTime[v] != std::numeric_limits<size_t>::max() && nInserted - insertTime[v] < cacheSize;
+    if (inCache) continue;
+    nMisses++;
+    insertTime[v] = ++nInserted;
+  }
+
+  return static_cast<float>(nMisses) / nTri;
+}
+
+std::vector<uint32_t> clusterSimplifyTriangles(const std::vector<glm::vec3>& positions,
+                                               const std::vector<uint32_t>& triangleVertexInds, float cellSize) {
+  const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+  size_t nTri = triangleVertexInds.size() / 3;
+  if (nTri == 0 || !(cellSize > 0.f)) return triangleVertexInds;
+
+  // bounds of the vertices which are used
+  std::vector<char> isUsed(positions.size(), false);
+  glm::vec3 bMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (uint32_t v : triangleVertexInds) {
+    if (isUsed[v]) continue;
+    isUsed[v] = true;
+    bMin = componentwiseMin(bMin, positions[v]);
+  }
+
+  // bin the vertices, giving each occupied cell a cluster index
+  const uint64_t cellMax = (1u << 21) - 1; // 21 bits per axis
+  std::unordered_map<uint64_t, uint32_t> cellCluster;
+  std::vector<uint32_t> vertexCluster(positions.size(), NONE);
+  std::vector<glm::dvec3> clusterSum;
+  std::vector<uint32_t> clusterCount;
+  for (size_t v = 0; v < positions.size(); v++) {
+    if (!isUsed[v]) continue;
+    glm::vec3 cellCoord = (positions[v] - bMin) / cellSize;
+    uint64_t key = 0;
+    for (int j = 0; j < 3; j++) {
+      uint64_t c = static_cast<uint64_t>(std::max(cellCoord[j], 0.f));
+      key = (key << 21) | std::min(c, cellMax);
+    }
+    auto it = cellCluster.find(key);
+    uint32_t iC;
+    if (it == cellCluster.end()) {
+      iC = static_cast<uint32_t>(clusterSum.size());
+      cellCluster.emplace(key, iC);
+      clusterSum.push_back(glm::dvec3{0., 0., 0.});
+      clusterCount.push_back(0);
+    } else {
+      iC = it->second;
+    }
+    vertexCluster[v] = iC;
+    clusterSum[iC] += glm::dvec3(positions[v]);
+    clusterCount[iC]++;
+  }
+
+  // the representative of each cluster is its vertex nearest to the mean
+  std::vector<uint32_t> clusterRep(clusterSum.size(), NONE);
+  std::vector<double> clusterRepDist(clusterSum.size(), std::numeric_limits<double>::infinity());
+  for (size_t v = 0; v < positions.size(); v++) {
+    uint32_t iC = vertexCluster[v];
+    if (iC == NONE) continue;
+    glm::dvec3 mean = clusterSum[iC] / static_cast<double>(clusterCount[iC]);
+    glm::dvec3 diff = glm::dvec3(positions[v]) - mean;
+    double dist = glm::dot(diff, diff);
+    if (dist < clusterRepDist[iC]) {
+      clusterRepDist[iC] = dist;
+      clusterRep[iC] = static_cast<uint32_t>(v);
+    }
+  }
+
+  // re-point the triangles, in parallel chunks, keeping those which do not collapse. Each triangle is rotated to start
+  // at its smallest index (which keeps its orientation), so that duplicates compare equal below.
+  size_t nChunks = parallelChunkCount(nTri);
+  std::vector<std::vector<std::array<uint32_t, 3>>> chunkTris(nChunks);
+  parallelForChunks(0, nTri, nChunks, [&](size_t iChunk, size_t chunkBegin, size_t chunkEnd) {
+    std::vector<std::array<uint32_t, 3>>& tris = chunkTris[iChunk];
+    for (size_t iT = chunkBegin; iT < chunkEnd; iT++) {
+      std::array<uint32_t, 3> t;
+      for (size_t k = 0; k < 3; k++) {
+        t[k] = clusterRep[vertexCluster[triangleVertexInds[3 * iT + k]]];
+      }
+      if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0]) continue;
+      while (t[0] > t[1] || t[0] > t[2]) {
+        std::rotate(t.begin(), t.begin() + 1, t.end());
+      }
+      tris.push_back(t);
+    }
+  });
+
+  std::vector<std::array<uint32_t, 3>> allTris;
+  for (std::vector<std::array<uint32_t, 3>>& tris : chunkTris) {
+    allTris.insert(allTris.end(), tris.begin(), tris.end());
+    std::vector<std::array<uint32_t, 3>>().swap(tris);
+  }
+  std::sort(allTris.begin(), allTris.end());
+  allTris.erase(std::unique(allTris.begin(), allTris.end()), allTris.end());
+
+  std::vector<uint32_t> result;
+  result.reserve(3 * allTris.size());
+  for (const std::array<uint32_t, 3>& t : allTris) {
+    result.insert(result.end(), t.begin(), t.end());
+  }
+  return result;
+}
+
+VoxelGrid voxelGridDownsample(const std::vector<glm::vec3>& points, float cellSize) {
+  VoxelGrid grid;
+  size_t n = points.size();
+  grid.cellPointStart.push_back(0);
+  if (n == 0 || !(cellSize > 0.f)) return grid;
+
+  glm::vec3 bMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (glm::vec3 p : points) {
+    if (isFinite(p)) bMin = componentwiseMin(bMin, p);
+  }
+
+  // spread the low 21 bits of x so there are two zero bits between each
+  auto spreadBits = [](uint64_t x) {
+    x &= 0x1fffff;
+    x = (x | (x << 32)) & 0x001f00000000ffffull;
+    x = (x | (x << 16)) & 0x001f0000ff0000ffull;
+    x = (x | (x << 8)) & 0x100f00f00f00f00full;
+    x = (x | (x << 4)) & 0x10c30c30c30c30c3ull;
+    x = (x | (x << 2)) & 0x1249249249249249ull;
+    return x;
+  };
+
+  // the 63 bit Morton code of each point's cell, split in halves for the 32 bit radix sort
+  const float cellMax = static_cast<float>((1u << 21) - 1);
+  std::vector<uint32_t> codesLow(n);
+  std::vector<uint32_t> codesHigh(n);
+  parallelFor(0, n, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      glm::vec3 q = glm::clamp((points[i] - bMin) / cellSize, 0.f, cellMax);
+      if (!isFinite(q)) q = glm::vec3{0., 0., 0.};
+      uint64_t code = spreadBits(static_cast<uint64_t>(q.x)) | (spreadBits(static_cast<uint64_t>(q.y)) << 1) |
+                      (spreadBits(static_cast<uint64_t>(q.z)) << 2);
+      codesLow[i] = static_cast<uint32_t>(code);
+      codesHigh[i] = static_cast<uint32_t>(code >> 32);
+    }
+  });
+
+  // sort by the low half, then stably by the high half
+  std::vector<uint32_t> lowOrder = radixSortOrder(codesLow, 32);
+  std::vector<uint32_t> highOrder = radixSortOrder(gather(codesHigh, lowOrder), 31);
+  grid.cellPoints = gather(lowOrder, highOrder);
+
+  // cells start wherever the code changes along the sorted points
+  for (size_t i = 1; i < n; i++) {
+    uint32_t a = grid.cellPoints[i - 1];
+    uint32_t b = grid.cellPoints[i];
+    if (codesLow[a] != codesLow[b] || codesHigh[a] != codesHigh[b]) {
+      grid.cellPointStart.push_back(static_cast<uint32_t>(i));
+    }
+  }
+  grid.cellPointStart.push_back(static_cast<uint32_t>(n));
+
+  // the representative of each cell is its point nearest to the mean
+  size_t nCells = grid.cellPointStart.size() - 1;
+  grid.cellRepresentative.resize(nCells);
+  parallelFor(0, nCells, [&](size_t begin, size_t end) {
+    for (size_t iC = begin; iC < end; iC++) {
+      const uint32_t* cellBegin = &grid.cellPoints[grid.cellPointStart[iC]];
+      const uint32_t* cellEnd = &grid.cellPoints[0] + grid.cellPointStart[iC + 1];
+      glm::dvec3 sum{0., 0., 0.};
+      for (const uint32_t* p = cellBegin; p != cellEnd; p++) sum += glm::dvec3(points[*p]);
+      glm::dvec3 mean = sum / static_cast<double>(cellEnd - cellBegin);
+
+      uint32_t rep = *cellBegin;
+      double repDist = std::numeric_limits<double>::infinity();
+      for (const uint32_t* p = cellBegin; p != cellEnd; p++) {
+        glm::dvec3 diff = glm::dvec3(points[*p]) - mean;
+        double dist = glm::dot(diff, diff);
+        if (dist < repDist) {
+          repDist = dist;
+          rep = *p;
+        }
+      }
+      grid.cellRepresentative[iC] = rep;
+    }
+  });
+
+  return grid;
+}
+
 void ImGuiHelperMarker(const char* text) {
   ImGui::TextDisabled("(?)");
   if (ImGui::IsItemHovered()) {
@@ -132,4 +588,29 @@ void ImGuiHelperMarker(const char* text) {
   }
 }
 
+bool ImGuiTreeNodeIsOpen(const char* label) { return ImGui::GetStateStorage()->GetInt(ImGui::GetID(label), 0) != 0; }
+
+void ImGuiClippedTreeList(size_t count, const std::function<bool(size_t)>& isOpen,
+                          const std::function<void(size_t)>& build) {
+  size_t i = 0;
+  while (i < count) {
+    if (isOpen(i)) {
+      build(i);
+      i++;
+      continue;
+    }
+
+    size_t runEnd = i + 1;
+    while (runEnd < count && !isOpen(runEnd)) runEnd++;
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(runEnd - i));
+    while (clipper.Step()) {
+      for (int j = clipper.DisplayStart; j < clipper.DisplayEnd; j++) {
+        build(i + j);
+      }
+    }
+    i = runEnd;
+  }
+}
+
 } // namespace polyscope
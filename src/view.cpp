@@ -2,6 +2,9 @@
 
 #include "polyscope/view.h"
 
+#include "polyscope/adaptive_quality.h"
+#include "polyscope/parallel.h"
+#include "polyscope/pick.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/utilities.h"
 
@@ -10,6 +13,11 @@
 #include "nlohmann/json.hpp"
 using json = nlohmann::json;
 
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
 namespace polyscope {
 namespace view {
 
@@ -32,6 +40,7 @@ std::array<float, 4>& bgColor = state::globalContext.bgColor;
 glm::mat4x4& viewMat = state::globalContext.viewMat;
 double& fov = state::globalContext.fov;
 ProjectionMode& projectionMode = state::globalContext.projectionMode;
+glm::vec2& projectionJitter = state::globalContext.projectionJitter;
 bool& midflight = state::globalContext.midflight;
 float& flightStartTime = state::globalContext.flightStartTime;
 float& flightEndTime = state::globalContext.flightEndTime;
@@ -43,6 +52,174 @@ float& flightTargetFov = state::globalContext.flightTargetFov;
 float& flightInitialFov = state::globalContext.flightInitialFov;
 
 
+// Extra viewports, see addViewport(). While one of them is drawn or navigated its camera is swapped in to the global
+// view state, and the main view's camera is kept aside.
+namespace {
+struct Viewport {
+  std::string name;
+  glm::vec4 region;
+  glm::mat4 viewMat;
+  double fov;
+  ProjectionMode projectionMode;
+};
+std::vector<Viewport> viewports;
+glm::vec4 mainViewportRegion{0., 0., 1., 1.};
+int currentViewport = -1; // -1 for the main view
+
+glm::mat4 mainViewMat;
+double mainFov;
+ProjectionMode mainProjectionMode;
+
+void checkViewportRegion(glm::vec4 region) {
+  bool valid = region.x >= 0. && region.y >= 0. && region.z > 0. && region.w > 0. && region.x + region.z <= 1. &&
+               region.y + region.w <= 1.;
+  if (!valid) {
+    exception("viewport region must lie within [0,1] and have a positive size");
+  }
+}
+
+Viewport& getViewport(std::string name) {
+  for (Viewport& v : viewports) {
+    if (v.name == name) return v;
+  }
+  exception("no viewport named " + name);
+  return viewports.front(); // unreachable
+}
+} // namespace
+
+// CPU copy of the scene depth (see options::sceneDepthCache). Each copy remembers the camera it was rendered with, so
+// positions are reconstructed consistently even if the view has moved on since.
+namespace {
+struct SceneDepthSnapshot {
+  std::vector<float> depth;
+  int stride = 1;
+  int width = 0; // of the scene framebuffer
+  int height = 0;
+  int viewBufferWidth = 0; // view::bufferWidth/Height at the time, which buffer indices refer to
+  int viewBufferHeight = 0;
+  glm::mat4 viewMat;
+  glm::mat4 projMat;
+  glm::mat4 unjitteredProjMat; // without the temporal antialiasing offset, to recognize an unchanged camera
+
+  // For occlusion culling: coarser levels of the depth, each holding the max of 2x2 texels of the one before. The full
+  // resolution depth is level 0 and not repeated here.
+  std::vector<std::vector<float>> maxDepthLevels;
+
+  // View space boxes which were culled as occluded while rendering the frame of this copy
+  std::vector<std::array<glm::vec3, 2>> occludedBoxes;
+};
+SceneDepthSnapshot sceneDepth;        // the latest finished copy
+SceneDepthSnapshot sceneDepthPending; // the copy in flight (without depth values)
+bool sceneDepthValid = false;
+bool sceneDepthInFlight = false;
+std::vector<std::array<glm::vec3, 2>> occludedBoxesSinceRequest;
+
+glm::mat4 unjitteredPerspectiveMatrix() {
+  glm::vec2 jitter = projectionJitter;
+  projectionJitter = glm::vec2{0., 0.};
+  glm::mat4 projMat = getCameraPerspectiveMatrix();
+  projectionJitter = jitter;
+  return projMat;
+}
+
+void buildMaxDepthLevels(SceneDepthSnapshot& snapshot) {
+  snapshot.maxDepthLevels.clear();
+  int w = snapshot.width;
+  int h = snapshot.height;
+  while (w > 1 || h > 1) {
+    const std::vector<float>& prev = snapshot.maxDepthLevels.empty() ? snapshot.depth : snapshot.maxDepthLevels.back();
+    int wNext = (w + 1) / 2;
+    int hNext = (h + 1) / 2;
+    std::vector<float> next(static_cast<size_t>(wNext) * hNext);
+    parallelFor(0, hNext, [&](size_t begin, size_t end) {
+      for (size_t y = begin; y < end; y++) {
+        for (int x = 0; x < wNext; x++) {
+          float maxDepth = 0.;
+          for (int dy = 0; dy < 2 && 2 * static_cast<int>(y) + dy < h; dy++) {
+            for (int dx = 0; dx < 2 && 2 * x + dx < w; dx++) {
+              maxDepth = std::max(maxDepth, prev[static_cast<size_t>(2 * y + dy) * w + 2 * x + dx]);
+            }
+          }
+          next[y * wNext + x] = maxDepth;
+        }
+      }
+    });
+    snapshot.maxDepthLevels.push_back(std::move(next));
+    w = wNext;
+    h = hNext;
+  }
+}
+
+// True if the view space box is entirely behind the depth of the snapshot, which must have been rendered with the
+// same view matrix
+bool boxOccludedInSnapshot(const SceneDepthSnapshot& snapshot, glm::vec3 viewMin, glm::vec3 viewMax) {
+  if (snapshot.stride != 1 || snapshot.width <= 0 || snapshot.height <= 0) return false;
+  if (snapshot.depth.size() != static_cast<size_t>(snapshot.width) * snapshot.height) return false;
+
+  // Project the box, finding its screen rectangle and its nearest depth
+  glm::vec2 ndcMin{1., 1.};
+  glm::vec2 ndcMax{-1., -1.};
+  float boxMinDepth = 1.;
+  for (int iC = 0; iC < 8; iC++) {
+    glm::vec3 corner{(iC & 1) ? viewMax.x : viewMin.x, (iC & 2) ? viewMax.y : viewMin.y,
+                     (iC & 4) ? viewMax.z : viewMin.z};
+    glm::vec4 c = snapshot.unjitteredProjMat * glm::vec4(corner, 1.);
+    if (!(c.w > 0.)) return false; // reaches behind the camera
+    glm::vec3 ndc = glm::vec3(c) / c.w;
+    ndcMin = glm::min(ndcMin, glm::clamp(glm::vec2(ndc), -1.f, 1.f));
+    ndcMax = glm::max(ndcMax, glm::clamp(glm::vec2(ndc), -1.f, 1.f));
+    boxMinDepth = std::min(boxMinDepth, 0.5f * ndc.z + 0.5f);
+  }
+  if (!(boxMinDepth > 0.) || ndcMin.x > ndcMax.x || ndcMin.y > ndcMax.y) return false;
+
+  // Texel rectangle at full resolution, grown by a texel to cover the antialiasing jitter and rounding
+  int w = snapshot.width;
+  int h = snapshot.height;
+  int x0 = glm::clamp(static_cast<int>(std::floor((0.5f * ndcMin.x + 0.5f) * w)) - 1, 0, w - 1);
+  int x1 = glm::clamp(static_cast<int>(std::floor((0.5f * ndcMax.x + 0.5f) * w)) + 1, 0, w - 1);
+  int y0 = glm::clamp(static_cast<int>(std::floor((0.5f * ndcMin.y + 0.5f) * h)) - 1, 0, h - 1);
+  int y1 = glm::clamp(static_cast<int>(std::floor((0.5f * ndcMax.y + 0.5f) * h)) + 1, 0, h - 1);
+
+  // Go to the level where the rectangle covers a few texels in each direction
+  size_t level = 0;
+  while (level < snapshot.maxDepthLevels.size() && std::max(x1 - x0, y1 - y0) >> level > 4) {
+    level++;
+  }
+  const std::vector<float>& levelDepth = level == 0 ? snapshot.depth : snapshot.maxDepthLevels[level - 1];
+  int levelWidth = w;
+  for (size_t i = 0; i < level; i++) levelWidth = (levelWidth + 1) / 2;
+
+  for (int y = y0 >> level; y <= y1 >> level; y++) {
+    for (int x = x0 >> level; x <= x1 >> level; x++) {
+      if (levelDepth[static_cast<size_t>(y) * levelWidth + x] >= boxMinDepth) return false;
+    }
+  }
+  return true;
+}
+
+// Look up the depth of a buffer pixel in the CPU copy, along with the matrices it was rendered with. False if there is
+// no usable copy.
+bool lookupSceneDepth(int xInd, int yInd, float& depth, glm::mat4& viewMat, glm::mat4& projMat) {
+  if (!options::sceneDepthCache || !sceneDepthValid || currentViewport >= 0) return false;
+  if (sceneDepth.viewBufferWidth != bufferWidth || sceneDepth.viewBufferHeight != bufferHeight) return false;
+
+  int wOut = (sceneDepth.width + sceneDepth.stride - 1) / sceneDepth.stride;
+  int hOut = (sceneDepth.height + sceneDepth.stride - 1) / sceneDepth.stride;
+  if (wOut <= 0 || hOut <= 0 || sceneDepth.depth.size() != static_cast<size_t>(wOut) * hOut) return false;
+
+  // The scene framebuffer may be larger than the view buffer (e.g. with SSAA), and its rows start at the bottom
+  float fx = (xInd + 0.5f) / bufferWidth * sceneDepth.width;
+  float fy = (bufferHeight - yInd - 0.5f) / bufferHeight * sceneDepth.height;
+  int cx = glm::clamp(static_cast<int>(fx) / sceneDepth.stride, 0, wOut - 1);
+  int cy = glm::clamp(static_cast<int>(fy) / sceneDepth.stride, 0, hOut - 1);
+
+  depth = sceneDepth.depth[static_cast<size_t>(cy) * wOut + cx];
+  viewMat = sceneDepth.viewMat;
+  projMat = sceneDepth.projMat;
+  return true;
+}
+} // namespace
+
 // Default values
 const double defaultNearClipRatio = 0.005;
 const double defaultFarClipRatio = 20.0;
@@ -90,8 +267,10 @@ std::string to_string(NavigateStyle style) {
 
 std::tuple<int, int> screenCoordsToBufferInds(glm::vec2 screenCoords) {
 
-  int xPos = (screenCoords.x * view::bufferWidth) / view::windowWidth;
-  int yPos = (screenCoords.y * view::bufferHeight) / view::windowHeight;
+  // The current view is rendered to the whole buffer, and shown in its region of the window
+  glm::vec4 rect = getCurrentViewportScreenRect();
+  int xPos = ((screenCoords.x - rect.x) * view::bufferWidth) / rect.z;
+  int yPos = ((screenCoords.y - (view::windowHeight - rect.y - rect.w)) * view::bufferHeight) / rect.w;
 
   // clamp to lie in [0,width),[0,height)
   xPos = std::max(std::min(xPos, view::bufferWidth - 1), 0);
@@ -214,6 +393,7 @@ void processRotate(glm::vec2 startP, glm::vec2 endP) {
   }
 
   requestRedraw();
+  markCameraInteraction();
   immediatelyEndFlight();
 }
 
@@ -230,6 +410,7 @@ void processTranslate(glm::vec2 delta) {
   viewMat = camSpaceT * viewMat;
 
   requestRedraw();
+  markCameraInteraction();
   immediatelyEndFlight();
 }
 
@@ -238,6 +419,7 @@ void processClipPlaneShift(double amount) {
   // Adjust the near clipping plane
   nearClipRatio += .03 * amount * nearClipRatio;
   requestRedraw();
+  markCameraInteraction();
 }
 
 void processZoom(double amount) {
@@ -266,6 +448,7 @@ void processZoom(double amount) {
 
   immediatelyEndFlight();
   requestRedraw();
+  markCameraInteraction();
 }
 
 void processKeyboardNavigation(ImGuiIO& io) {
@@ -314,6 +497,7 @@ void processKeyboardNavigation(ImGuiIO& io) {
   if (hasMovement) {
     immediatelyEndFlight();
     requestRedraw();
+    markCameraInteraction();
   }
 }
 
@@ -443,7 +627,7 @@ void setViewToCamera(const CameraParameters& p) {
 CameraParameters getCameraParametersForCurrentView() {
   ensureViewValid();
 
-  double aspectRatio = (float)bufferWidth / bufferHeight;
+  double aspectRatio = getCurrentViewportAspect();
   return CameraParameters(CameraIntrinsics::fromFoVDegVerticalAndAspect(fov, aspectRatio),
                           CameraExtrinsics::fromMatrix(viewMat));
 }
@@ -456,20 +640,27 @@ glm::mat4 getCameraPerspectiveMatrix() {
   double farClip = farClipRatio * state::lengthScale;
   double nearClip = nearClipRatio * state::lengthScale;
   double fovRad = glm::radians(fov);
-  double aspectRatio = (float)bufferWidth / bufferHeight;
+  double aspectRatio = getCurrentViewportAspect();
+  glm::mat4 projMat(1.0f);
   switch (projectionMode) {
   case ProjectionMode::Perspective: {
-    return glm::perspective(fovRad, aspectRatio, nearClip, farClip);
+    projMat = glm::perspective(fovRad, aspectRatio, nearClip, farClip);
     break;
   }
   case ProjectionMode::Orthographic: {
     double vert = tan(fovRad / 2.) * state::lengthScale * 2.;
     double horiz = vert * aspectRatio;
-    return glm::ortho(-horiz, horiz, -vert, vert, nearClip, farClip);
+    projMat = glm::ortho(-horiz, horiz, -vert, vert, nearClip, farClip);
     break;
   }
   }
-  return glm::mat4(1.0f); // unreachable
+
+  // Shift the image in NDC, for either projection
+  if (projectionJitter != glm::vec2{0., 0.}) {
+    projMat = glm::translate(glm::mat4(1.0f), glm::vec3{projectionJitter, 0.}) * projMat;
+  }
+
+  return projMat;
 }
 
 
@@ -479,6 +670,11 @@ glm::vec3 getCameraWorldPosition() {
   return glm::vec3{invViewMat[3][0], invViewMat[3][1], invViewMat[3][2]};
 }
 
+glm::dvec3 getCameraWorldPositionDouble() {
+  glm::dmat4 invViewMat = inverse(glm::dmat4(getCameraViewMatrix()));
+  return glm::dvec3{invViewMat[3][0], invViewMat[3][1], invViewMat[3][2]};
+}
+
 void getCameraFrame(glm::vec3& lookDir, glm::vec3& upDir, glm::vec3& rightDir) {
   glm::mat3x3 R;
   for (int i = 0; i < 3; i++) {
@@ -497,7 +693,7 @@ glm::vec3 screenCoordsToWorldRay(glm::vec2 screenCoords) {
 
   glm::mat4 view = getCameraViewMatrix();
   glm::mat4 proj = getCameraPerspectiveMatrix();
-  glm::vec4 viewport = {0., 0., view::windowWidth, view::windowHeight};
+  glm::vec4 viewport = getCurrentViewportScreenRect();
 
   glm::vec3 screenPos3{screenCoords.x, view::windowHeight - screenCoords.y, 0.};
   glm::vec3 worldPos = glm::unProject(screenPos3, view, proj, viewport);
@@ -521,37 +717,277 @@ glm::vec3 bufferCoordsToWorldRay(glm::vec2 bufferCoords) {
 
 
 glm::vec3 screenCoordsToWorldPosition(glm::vec2 screenCoords) {
+  return glm::vec3(screenCoordsToWorldPositionDouble(screenCoords));
+}
+
+glm::dvec3 screenCoordsToWorldPositionDouble(glm::vec2 screenCoords) {
 
   int xInd, yInd;
   std::tie(xInd, yInd) = screenCoordsToBufferInds(screenCoords);
 
-  glm::mat4 view = getCameraViewMatrix();
-  glm::mat4 viewInv = glm::inverse(view);
-  glm::mat4 proj = getCameraPerspectiveMatrix();
+  // get the depth from the CPU copy if possible, otherwise query the depth buffer
+  glm::mat4 view, proj;
+  float depth;
+  processSceneDepthDownload();
+  if (!lookupSceneDepth(xInd, yInd, depth, view, proj)) {
+    view = getCameraViewMatrix();
+    proj = getCameraPerspectiveMatrix();
+    if (currentViewport >= 0) {
+      // the scene buffers hold the main view, an extra viewport gets its depth from a pick render with its own camera
+      pick::renderPickBufferAround(xInd, yInd);
+      depth = render::engine->pickFramebuffer->readDepth(xInd, view::bufferHeight - yInd);
+    } else {
+      render::FrameBuffer* sceneFramebuffer = render::engine->sceneBuffer.get();
+      depth = sceneFramebuffer->readDepth(xInd, view::bufferHeight - yInd);
+    }
+  }
+  // the view space position is small, only the step to world space needs double precision
+  glm::dmat4 viewInv = glm::inverse(glm::dmat4(view));
   glm::mat4 projInv = glm::inverse(proj);
   // glm::vec2 depthRange = {0., 1.}; // no support for nonstandard depth range, currently
 
-  // query the depth buffer to get depth
-  render::FrameBuffer* sceneFramebuffer = render::engine->sceneBuffer.get();
-  float depth = sceneFramebuffer->readDepth(xInd, view::bufferHeight - yInd);
   if (depth == 1.) {
     // if we didn't hit anything in the depth buffer, just return infinity
-    float inf = std::numeric_limits<float>::infinity();
-    return glm::vec3{inf, inf, inf};
+    double inf = std::numeric_limits<double>::infinity();
+    return glm::dvec3{inf, inf, inf};
   }
 
   // convert depth to world units
-  glm::vec2 screenPos{screenCoords.x / static_cast<float>(view::windowWidth),
-                      1.f - screenCoords.y / static_cast<float>(view::windowHeight)};
+  glm::vec4 rect = getCurrentViewportScreenRect();
+  glm::vec2 screenPos{(screenCoords.x - rect.x) / rect.z, (view::windowHeight - screenCoords.y - rect.y) / rect.w};
   float z = depth * 2.0f - 1.0f;
   glm::vec4 clipPos = glm::vec4(screenPos * 2.0f - 1.0f, z, 1.0f);
   glm::vec4 viewPos = projInv * clipPos;
   viewPos /= viewPos.w;
 
-  glm::vec4 worldPos = viewInv * viewPos;
+  glm::dvec4 worldPos = viewInv * glm::dvec4(viewPos);
   worldPos /= worldPos.w;
 
-  return glm::vec3(worldPos);
+  return glm::dvec3(worldPos);
+}
+
+void requestSceneDepthDownload() {
+  if (!options::sceneDepthCache) {
+    sceneDepthValid = false;
+    occludedBoxesSinceRequest.clear();
+    return;
+  }
+
+  // occlusion culling needs every pixel to be conservative
+  render::FrameBuffer* sceneFramebuffer = render::engine->sceneBuffer.get();
+  sceneDepthPending.stride = options::occlusionCulling ? 1 : std::max(options::sceneDepthCacheStride, 1);
+  sceneDepthPending.width = sceneFramebuffer->getSizeX();
+  sceneDepthPending.height = sceneFramebuffer->getSizeY();
+  sceneDepthPending.viewBufferWidth = bufferWidth;
+  sceneDepthPending.viewBufferHeight = bufferHeight;
+  sceneDepthPending.viewMat = getCameraViewMatrix();
+  sceneDepthPending.projMat = getCameraPerspectiveMatrix();
+  sceneDepthPending.unjitteredProjMat = unjitteredPerspectiveMatrix();
+  sceneDepthPending.occludedBoxes = std::move(occludedBoxesSinceRequest);
+  occludedBoxesSinceRequest.clear();
+  sceneFramebuffer->requestReadDepthBuffer(sceneDepthPending.stride);
+  sceneDepthInFlight = true;
+}
+
+void processSceneDepthDownload() {
+  if (!sceneDepthInFlight) return;
+
+  std::vector<float> depth;
+  if (!render::engine->sceneBuffer->pollReadDepthBuffer(depth)) return;
+  sceneDepthInFlight = false;
+
+  std::swap(sceneDepth, sceneDepthPending);
+  sceneDepth.depth.swap(depth);
+  sceneDepthValid = true;
+
+  sceneDepth.maxDepthLevels.clear();
+  if (options::occlusionCulling && sceneDepth.stride == 1) {
+    buildMaxDepthLevels(sceneDepth);
+  }
+
+  // The boxes culled while rendering this frame were tested against an older depth. If one of them is not hidden in the
+  // depth of this frame after all, it should have been drawn, so draw the scene again.
+  bool anyRevealed = false;
+  for (const std::array<glm::vec3, 2>& box : sceneDepth.occludedBoxes) {
+    if (!boxOccludedInSnapshot(sceneDepth, box[0], box[1])) {
+      anyRevealed = true;
+      break;
+    }
+  }
+  sceneDepth.occludedBoxes.clear();
+  if (anyRevealed) requestRedraw();
+}
+
+bool viewSpaceBoxOccluded(glm::vec3 viewMin, glm::vec3 viewMax) {
+  if (!options::occlusionCulling || !options::sceneDepthCache || !sceneDepthValid) return false;
+  if (options::transparencyMode != TransparencyMode::None) return false;
+
+  // the depth is only meaningful for the camera it was rendered with
+  if (sceneDepth.viewMat != getCameraViewMatrix() || sceneDepth.unjitteredProjMat != unjitteredPerspectiveMatrix()) {
+    return false;
+  }
+  if (sceneDepth.viewBufferWidth != bufferWidth || sceneDepth.viewBufferHeight != bufferHeight) return false;
+
+  if (!boxOccludedInSnapshot(sceneDepth, viewMin, viewMax)) return false;
+  occludedBoxesSinceRequest.push_back({{viewMin, viewMax}});
+  return true;
+}
+
+void addViewport(std::string name, glm::vec4 region, const CameraParameters& camera, ProjectionMode mode) {
+  if (hasViewport(name)) {
+    exception("a viewport named " + name + " already exists");
+  }
+  if (currentViewport >= 0) {
+    exception("viewports cannot be added while one is being drawn");
+  }
+  checkViewportRegion(region);
+  viewports.push_back(Viewport{name, region, camera.getE(), camera.getFoVVerticalDegrees(), mode});
+  requestRedraw();
+}
+
+void removeViewport(std::string name) {
+  if (currentViewport >= 0) {
+    exception("viewports cannot be removed while one is being drawn");
+  }
+  viewports.erase(std::remove_if(viewports.begin(), viewports.end(), [&](const Viewport& v) { return v.name == name; }),
+                  viewports.end());
+  requestRedraw();
+}
+
+void removeAllViewports() {
+  if (currentViewport >= 0) {
+    exception("viewports cannot be removed while one is being drawn");
+  }
+  viewports.clear();
+  mainViewportRegion = glm::vec4{0., 0., 1., 1.};
+  requestRedraw();
+}
+
+bool hasViewport(std::string name) {
+  for (const Viewport& v : viewports) {
+    if (v.name == name) return true;
+  }
+  return false;
+}
+
+void setViewportCamera(std::string name, const CameraParameters& camera) {
+  Viewport& v = getViewport(name);
+  v.viewMat = camera.getE();
+  v.fov = camera.getFoVVerticalDegrees();
+  requestRedraw();
+}
+
+CameraParameters getViewportCamera(std::string name) {
+  Viewport& v = getViewport(name);
+  double aspectRatio = (bufferWidth * v.region.z) / (bufferHeight * v.region.w);
+  return CameraParameters(CameraIntrinsics::fromFoVDegVerticalAndAspect(v.fov, aspectRatio),
+                          CameraExtrinsics::fromMatrix(v.viewMat));
+}
+
+void setViewportProjectionMode(std::string name, ProjectionMode mode) {
+  getViewport(name).projectionMode = mode;
+  requestRedraw();
+}
+
+void setViewportRegion(std::string name, glm::vec4 region) {
+  checkViewportRegion(region);
+  getViewport(name).region = region;
+  requestRedraw();
+}
+
+glm::vec4 getViewportRegion(std::string name) { return getViewport(name).region; }
+
+void setMainViewportRegion(glm::vec4 region) {
+  checkViewportRegion(region);
+  mainViewportRegion = region;
+  requestRedraw();
+}
+
+glm::vec4 getMainViewportRegion() { return mainViewportRegion; }
+
+void setQuadViewLayout() {
+  ensureViewValid();
+  for (std::string name : {"top", "front", "side"}) {
+    removeViewport(name);
+  }
+
+  glm::vec3 center = state::center();
+  glm::vec3 up = getUpVec();
+  glm::vec3 front = getFrontVec();
+  if (std::fabs(glm::dot(up, front)) > 0.01) {
+    front = circularPermuteEntries(front); // as in computeHomeView()
+  }
+  glm::vec3 right = glm::normalize(glm::cross(up, front));
+  float dist = 2.f * state::lengthScale;
+
+  auto orthoCamera = [&](glm::vec3 dir, glm::vec3 screenUp) {
+    glm::mat4 E = glm::lookAt(center + dist * dir, center, screenUp);
+    return CameraParameters(CameraIntrinsics::fromFoVDegVerticalAndAspect(defaultFov, 1.),
+                            CameraExtrinsics::fromMatrix(E));
+  };
+
+  // The main view in the top right, the orthographic views in the others
+  setMainViewportRegion(glm::vec4{0.5, 0.5, 0.5, 0.5});
+  addViewport("top", glm::vec4{0., 0.5, 0.5, 0.5}, orthoCamera(up, -front), ProjectionMode::Orthographic);
+  addViewport("front", glm::vec4{0., 0., 0.5, 0.5}, orthoCamera(front, up), ProjectionMode::Orthographic);
+  addViewport("side", glm::vec4{0.5, 0., 0.5, 0.5}, orthoCamera(right, up), ProjectionMode::Orthographic);
+}
+
+size_t getViewportCount() { return viewports.size(); }
+
+void beginViewport(size_t iViewport) {
+  if (currentViewport >= 0) endViewport();
+  if (iViewport >= viewports.size()) {
+    exception("viewport index out of range");
+  }
+
+  mainViewMat = viewMat;
+  mainFov = fov;
+  mainProjectionMode = projectionMode;
+
+  const Viewport& v = viewports[iViewport];
+  viewMat = v.viewMat;
+  fov = v.fov;
+  projectionMode = v.projectionMode;
+  currentViewport = static_cast<int>(iViewport);
+}
+
+void endViewport() {
+  if (currentViewport < 0) return;
+
+  // keep any navigation which happened in the viewport
+  Viewport& v = viewports[currentViewport];
+  v.viewMat = viewMat;
+  v.fov = fov;
+  v.projectionMode = projectionMode;
+
+  viewMat = mainViewMat;
+  fov = mainFov;
+  projectionMode = mainProjectionMode;
+  currentViewport = -1;
+}
+
+int getViewportAtScreenCoords(glm::vec2 screenCoords) {
+  glm::vec2 p{screenCoords.x / windowWidth, 1.f - screenCoords.y / windowHeight};
+  for (size_t i = viewports.size(); i > 0; i--) { // later viewports are on top
+    const glm::vec4& r = viewports[i - 1].region;
+    if (p.x >= r.x && p.x < r.x + r.z && p.y >= r.y && p.y < r.y + r.w) return static_cast<int>(i - 1);
+  }
+  return -1;
+}
+
+glm::vec4 getCurrentViewportRegion() {
+  return currentViewport >= 0 ? viewports[currentViewport].region : mainViewportRegion;
+}
+
+glm::vec4 getCurrentViewportScreenRect() {
+  glm::vec4 region = getCurrentViewportRegion();
+  return glm::vec4{region.x * windowWidth, region.y * windowHeight, region.z * windowWidth, region.w * windowHeight};
+}
+
+double getCurrentViewportAspect() {
+  glm::vec4 region = getCurrentViewportRegion();
+  return (bufferWidth * region.z) / (bufferHeight * region.w);
 }
 
 void startFlightTo(const CameraParameters& p, float flightLengthInSeconds) {
@@ -2,14 +2,20 @@
 
 #include "polyscope/volume_grid.h"
 
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
+#include "polyscope/slice_plane.h"
 
 #include "imgui.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace polyscope {
 
 // Initialize statics
 const std::string VolumeGrid::structureTypeName = "Volume Grid";
+const uint32_t VolumeGrid::sparseBlockSize = 8;
 
 VolumeGrid::VolumeGrid(std::string name, glm::uvec3 gridNodeDim_, glm::vec3 boundMin_, glm::vec3 boundMax_)
     : QuantityStructure<VolumeGrid>(name, typeName()),
@@ -32,12 +38,49 @@ VolumeGrid::VolumeGrid(std::string name, glm::uvec3 gridNodeDim_, glm::vec3 boun
 {
   cullWholeElements.setPassive(true);
   updateObjectSpaceBounds();
+
+  uint32_t maxTextureSize = render::engine->getMaxTextureSize3D();
+  exceedsTextureSizeLimit =
+      gridNodeDim.x > maxTextureSize || gridNodeDim.y > maxTextureSize || gridNodeDim.z > maxTextureSize;
+}
+
+VolumeGrid::VolumeGrid(std::string name, glm::uvec3 gridNodeDim_, glm::vec3 boundMin_, glm::vec3 boundMax_,
+                       const std::vector<glm::uvec3>& occupiedBlocks_)
+    : VolumeGrid(name, gridNodeDim_, boundMin_, boundMax_) {
+
+  sparse = true;
+  sparseBlockDim = (gridCellDim + sparseBlockSize - 1u) / sparseBlockSize;
+  occupiedBlocks = occupiedBlocks_;
+
+  size_t nBlocks = static_cast<size_t>(sparseBlockDim.x) * sparseBlockDim.y * sparseBlockDim.z;
+  sparseBlockSlots.assign(nBlocks, -1);
+  for (size_t iSlot = 0; iSlot < occupiedBlocks.size(); iSlot++) {
+    glm::uvec3 block = occupiedBlocks[iSlot];
+    if (block.x >= sparseBlockDim.x || block.y >= sparseBlockDim.y || block.z >= sparseBlockDim.z) {
+      exception("sparse volume grid " + name + " has an occupied block outside of the grid");
+    }
+    int32_t& slot = sparseBlockSlots[(static_cast<size_t>(block.z) * sparseBlockDim.y + block.y) * sparseBlockDim.x +
+                                     block.x];
+    if (slot != -1) {
+      exception("sparse volume grid " + name + " lists an occupied block more than once");
+    }
+    slot = static_cast<int32_t>(iSlot);
+  }
 }
 
 
 void VolumeGrid::buildCustomUI() {
   ImGui::Text("node dim (%lld, %lld, %lld)", static_cast<long long int>(gridNodeDim.x),
               static_cast<long long int>(gridNodeDim.y), static_cast<long long int>(gridNodeDim.z));
+  if (isSparse()) {
+    ImGui::Text("sparse, %lld occupied blocks", static_cast<long long int>(nOccupiedBlocks()));
+  } else if (isBricked()) {
+    size_t nResident = 0;
+    for (int64_t b : residentSlotBricks) {
+      if (b >= 0) nResident++;
+    }
+    ImGui::Text("bricked, %lld resident bricks", static_cast<long long int>(nResident));
+  }
 
   // these all take up too much space
   // ImGui::TextUnformatted(("min: " + to_string_short(boundMin)).c_str());
@@ -108,6 +151,8 @@ void VolumeGrid::draw() {
     setCullWholeElements(true);
   }
 
+  updateGridPlaneCulling();
+
   // If there is no dominant quantity, then this class is responsible for the grid
   if (dominantQuantity == nullptr) {
 
@@ -126,11 +171,11 @@ void VolumeGrid::draw() {
   }
 
   // Draw the quantities
-  for (auto& x : quantities) {
-    x.second->draw();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->draw();
   }
-  for (auto& x : floatingQuantities) {
-    x.second->draw();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->draw();
   }
 }
 
@@ -139,11 +184,11 @@ void VolumeGrid::drawDelayed() {
   if (!enabled.get()) return;
 
   // Draw the quantities
-  for (auto& x : quantities) {
-    x.second->drawDelayed();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->drawDelayed();
   }
-  for (auto& x : floatingQuantities) {
-    x.second->drawDelayed();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->drawDelayed();
   }
 }
 
@@ -160,6 +205,7 @@ void VolumeGrid::drawPick() {
     }
   }
 
+  updateGridPlaneCulling();
   ensureGridCubePickProgramPrepared();
 
   // Set program uniforms
@@ -187,6 +233,10 @@ std::vector<std::string> VolumeGrid::addGridCubeRules(std::vector<std::string> i
     initRules.push_back("GRIDCUBE_CULLPOS_FROM_CENTER");
   }
 
+  if (isBricked()) {
+    initRules.push_back("GRIDCUBE_SPARSE_OCCUPANCY");
+  }
+
   return initRules;
 }
 
@@ -197,6 +247,21 @@ void VolumeGrid::setGridCubeUniforms(render::ShaderProgram& p, bool withShade) {
   p.setUniform("u_cubeSizeFactor", 1.f - cubeSizeFactor.get());
   p.setUniform("u_gridSpacingReference", gridSpacingReference());
 
+  if (isBricked()) {
+    if (!sparseBlockSlotTexture) {
+      glm::uvec3 brickDim = (gridCellDim + sparseBlockSize - 1u) / sparseBlockSize;
+      const std::vector<int32_t>& slots = isSparse() ? sparseBlockSlots : residentBrickSlots;
+      std::vector<float> slotData(static_cast<size_t>(brickDim.x) * brickDim.y * brickDim.z, -1.f);
+      std::copy(slots.begin(), slots.begin() + std::min(slots.size(), slotData.size()), slotData.begin());
+      sparseBlockSlotTexture = render::engine->generateTextureBuffer(TextureFormat::R32F, brickDim.x, brickDim.y,
+                                                                     brickDim.z, &slotData.front());
+    }
+    if (!p.textureIsSet("t_sparseBlockSlot")) {
+      p.setTextureFromBuffer("t_sparseBlockSlot", sparseBlockSlotTexture.get());
+    }
+    p.setUniform("u_sparseBlockSize", static_cast<float>(sparseBlockSize));
+  }
+
   if (withShade) {
 
     if (getEdgeWidth() > 0) {
@@ -279,8 +344,181 @@ void VolumeGrid::refresh() {
   pickProgram.reset();
 }
 
+void VolumeGrid::refreshShaderPrograms() {
+  refreshQuantityShaderPrograms();
+
+  program.reset();
+  pickProgram.reset();
+}
+
 void VolumeGrid::setVolumeGridUniforms(render::ShaderProgram& p) {}
 
+int64_t VolumeGrid::sparseBlockSlot(glm::uvec3 block) const {
+  if (block.x >= sparseBlockDim.x || block.y >= sparseBlockDim.y || block.z >= sparseBlockDim.z) return -1;
+  return sparseBlockSlots[(static_cast<size_t>(block.z) * sparseBlockDim.y + block.y) * sparseBlockDim.x + block.x];
+}
+
+int64_t VolumeGrid::sparseNodeDataIndex(glm::uvec3 inds) const {
+  // A node on the faces between blocks is stored in each of them, find any occupied one
+  int64_t blockNodes = sparseBlockSize + 1;
+  for (uint32_t iCorner = 0; iCorner < 8; iCorner++) {
+    glm::uvec3 block = inds / sparseBlockSize;
+    bool valid = true;
+    for (int d = 0; d < 3; d++) {
+      if ((iCorner >> d) & 1) {
+        if (inds[d] % sparseBlockSize != 0 || block[d] == 0) valid = false;
+        block[d]--;
+      }
+    }
+    if (!valid) continue;
+    int64_t slot = sparseBlockSlot(block);
+    if (slot < 0) continue;
+    glm::uvec3 local = inds - block * sparseBlockSize;
+    return ((slot * blockNodes + local.z) * blockNodes + local.y) * blockNodes + local.x;
+  }
+  return -1;
+}
+
+int64_t VolumeGrid::sparseCellDataIndex(glm::uvec3 inds) const {
+  int64_t blockCells = sparseBlockSize;
+  glm::uvec3 block = inds / sparseBlockSize;
+  int64_t slot = sparseBlockSlot(block);
+  if (slot < 0) return -1;
+  glm::uvec3 local = inds - block * sparseBlockSize;
+  return ((slot * blockCells + local.z) * blockCells + local.y) * blockCells + local.x;
+}
+
+
+void VolumeGrid::updateGridPlaneCulling() {
+
+  // Gather everything which determines the culling, and skip the update if none of it changed
+  glm::mat4 T(getModelMatrix());
+  std::vector<float> newState(&T[0][0], &T[0][0] + 16);
+  std::vector<glm::vec4> objectPlanes; // {normal, offset}: object-space points p with dot(p, normal) < offset are cut
+  for (std::unique_ptr<SlicePlane>& s : state::slicePlanes) {
+    if (!s->getActive() || getIgnoreSlicePlane(s->name)) continue;
+    glm::vec3 center = s->getCenter();
+    glm::vec3 normal = s->getNormal();
+    newState.insert(newState.end(), {center.x, center.y, center.z, normal.x, normal.y, normal.z});
+
+    // the world-space test dot(T * p, normal) < dot(center, normal), rewritten for object-space p
+    glm::vec3 normalObject = glm::transpose(glm::mat3(T)) * normal;
+    float offsetObject = glm::dot(center - glm::vec3(T[3]), normal);
+    objectPlanes.push_back(glm::vec4(normalObject, offsetObject));
+  }
+  if (newState == gridPlaneCullState) return;
+  gridPlaneCullState = newState;
+
+  std::array<std::vector<glm::uvec4>, 3> newRects;
+  if (!objectPlanes.empty() || isBricked()) {
+    glm::uvec3 brickDim = (gridCellDim + sparseBlockSize - 1u) / sparseBlockSize;
+    size_t nBricks = static_cast<size_t>(brickDim.x) * brickDim.y * brickDim.z;
+    glm::vec3 spacing = gridSpacing();
+
+    // A brick is culled if it is empty, or if a single slice plane cuts away all of its cell centers. The shaders test
+    // a point a sixth of a cell past the center (see GRIDCUBE_CULLPOS_FROM_CENTER), the margin of half a cell keeps
+    // bricks whose cells sit right at the plane.
+    std::vector<char> brickVisible(nBricks);
+    parallelFor(
+        0, nBricks,
+        [&](size_t begin, size_t end) {
+          for (size_t iBrick = begin; iBrick < end; iBrick++) {
+            glm::uvec3 brick{static_cast<uint32_t>(iBrick % brickDim.x),
+                             static_cast<uint32_t>((iBrick / brickDim.x) % brickDim.y),
+                             static_cast<uint32_t>(iBrick / (static_cast<size_t>(brickDim.x) * brickDim.y))};
+            glm::uvec3 cellLow = brick * sparseBlockSize;
+            glm::uvec3 cellHigh = glm::min(cellLow + sparseBlockSize, gridCellDim) - 1u;
+            glm::vec3 centersLow = boundMin + (glm::vec3(cellLow) + 0.5f) * spacing;
+            glm::vec3 centersHigh = boundMin + (glm::vec3(cellHigh) + 0.5f) * spacing;
+            glm::vec3 boxCenter = 0.5f * (centersLow + centersHigh);
+            glm::vec3 boxHalfExtent = 0.5f * (centersHigh - centersLow);
+
+            bool visible = !isSparse() || sparseBlockSlots[iBrick] >= 0;
+            for (const glm::vec4& plane : objectPlanes) {
+              if (!visible) break;
+              glm::vec3 normalAbs = glm::abs(glm::vec3(plane));
+              float maxDot = glm::dot(boxCenter, glm::vec3(plane)) + glm::dot(boxHalfExtent, normalAbs);
+              if (maxDot + 0.5f * glm::dot(spacing, normalAbs) < plane.w) {
+                visible = false;
+                break;
+              }
+            }
+            brickVisible[iBrick] = visible;
+          }
+        },
+        256);
+
+    // Bricked dense grids keep exactly the visible bricks resident
+    if (isBricked() && !isSparse()) {
+      updateResidentBricks(brickVisible);
+    }
+
+    // Bound the visible bricks of each slab
+    for (int d = 0; d < 3; d++) {
+      uint32_t none = std::numeric_limits<uint32_t>::max();
+      newRects[d].assign(brickDim[d], glm::uvec4{none, none, 0, 0});
+    }
+    for (size_t iBrick = 0; iBrick < nBricks; iBrick++) {
+      if (!brickVisible[iBrick]) continue;
+      glm::uvec3 brick{static_cast<uint32_t>(iBrick % brickDim.x),
+                       static_cast<uint32_t>((iBrick / brickDim.x) % brickDim.y),
+                       static_cast<uint32_t>(iBrick / (static_cast<size_t>(brickDim.x) * brickDim.y))};
+      glm::uvec3 cellLow = brick * sparseBlockSize;
+      glm::uvec3 cellHigh = glm::min(cellLow + sparseBlockSize, gridCellDim);
+      for (int d = 0; d < 3; d++) {
+        int d1 = (d + 1) % 3;
+        int d2 = (d + 2) % 3;
+        glm::uvec4& rect = newRects[d][brick[d]];
+        rect.x = std::min(rect.x, cellLow[d1]);
+        rect.y = std::min(rect.y, cellLow[d2]);
+        rect.z = std::max(rect.z, cellHigh[d1]);
+        rect.w = std::max(rect.w, cellHigh[d2]);
+      }
+    }
+  }
+
+  // Only regenerate the geometry if the clipping actually changed
+  if (newRects == gridPlaneCullRects) return;
+  gridPlaneCullRects = newRects;
+  computeGridPlaneReferenceGeometry();
+}
+
+void VolumeGrid::updateResidentBricks(const std::vector<char>& brickNeeded) {
+  if (residentBrickSlots.size() != brickNeeded.size()) {
+    residentBrickSlots.assign(brickNeeded.size(), -1);
+    residentSlotBricks.clear();
+  }
+  bool changed = false;
+
+  // Evict the bricks which are no longer needed, leaving their slots free
+  for (size_t iSlot = 0; iSlot < residentSlotBricks.size(); iSlot++) {
+    int64_t iBrick = residentSlotBricks[iSlot];
+    if (iBrick >= 0 && !brickNeeded[iBrick]) {
+      residentBrickSlots[iBrick] = -1;
+      residentSlotBricks[iSlot] = -1;
+      changed = true;
+    }
+  }
+
+  // Place newly needed bricks in the lowest free slots, growing the pool only when it is full. Bricks which stay
+  // resident keep their slot, so quantities only upload the bricks which moved in.
+  size_t nextFree = 0;
+  for (size_t iBrick = 0; iBrick < brickNeeded.size(); iBrick++) {
+    if (!brickNeeded[iBrick] || residentBrickSlots[iBrick] >= 0) continue;
+    while (nextFree < residentSlotBricks.size() && residentSlotBricks[nextFree] >= 0) nextFree++;
+    if (nextFree == residentSlotBricks.size()) residentSlotBricks.push_back(-1);
+    residentSlotBricks[nextFree] = static_cast<int64_t>(iBrick);
+    residentBrickSlots[iBrick] = static_cast<int32_t>(nextFree);
+    changed = true;
+  }
+
+  if (!changed) return;
+  brickResidencyVersion++;
+  if (sparseBlockSlotTexture) {
+    sparseBlockSlotTexture->setData(std::vector<float>(residentBrickSlots.begin(), residentBrickSlots.end()));
+  }
+  requestRedraw();
+}
 
 void VolumeGrid::computeGridPlaneReferenceGeometry() {
 
@@ -310,6 +548,22 @@ void VolumeGrid::computeGridPlaneReferenceGeometry() {
     for (int32_t j = 0; j < 3; j++) gridPlaneAxisInds.data.push_back(axInd);
   };
 
+  // Each plane only spans the bricks of cells next to it which are not culled, see updateGridPlaneCulling()
+  glm::vec2 low, high;
+  auto clipPlane = [&](uint32_t d, uint32_t i) {
+    if (gridPlaneCullRects[d].empty()) {
+      low = glm::vec2{0.f, 0.f};
+      high = glm::vec2{1.f, 1.f};
+      return true;
+    }
+    const glm::uvec4& rect = gridPlaneCullRects[d][i / sparseBlockSize];
+    if (rect.x >= rect.z) return false; // the whole slab is culled
+    glm::vec2 planeCellDim(gridCellDim[(d + 1) % 3], gridCellDim[(d + 2) % 3]);
+    low = glm::vec2(rect.x, rect.y) / planeCellDim;
+    high = glm::vec2(rect.z, rect.w) / planeCellDim;
+    return true;
+  };
+
   // The planes are intentionally added in order such that the outermost planes come first, and we don't massively
   // overshade from back to front. Note that fthe first look runs backwards.
 
@@ -317,13 +571,14 @@ void VolumeGrid::computeGridPlaneReferenceGeometry() {
   for (uint32_t d = 0; d < 3; d++) { // x/y/z dimension (plane is perpendicular)
     for (int32_t i = (int32_t)gridCellDim[d] - 1; i >= 0; i--) {
 
+      if (!clipPlane(d, i)) continue;
       float t = (static_cast<float>(i) + 1) / (gridCellDim[d]);
 
       // clang-format off
-      glm::vec3 ll{0.f, 0.f, 0.f}; ll[(d+1)%3] = 0.f; ll[(d+2)%3] = 0.f; ll[d] = t;
-      glm::vec3 lu{0.f, 0.f, 0.f}; lu[(d+1)%3] = 1.f; lu[(d+2)%3] = 0.f; lu[d] = t;
-      glm::vec3 ul{0.f, 0.f, 0.f}; ul[(d+1)%3] = 0.f; ul[(d+2)%3] = 1.f; ul[d] = t;
-      glm::vec3 uu{0.f, 0.f, 0.f}; uu[(d+1)%3] = 1.f; uu[(d+2)%3] = 1.f; uu[d] = t;
+      glm::vec3 ll{0.f, 0.f, 0.f}; ll[(d+1)%3] = low.x;  ll[(d+2)%3] = low.y;  ll[d] = t;
+      glm::vec3 lu{0.f, 0.f, 0.f}; lu[(d+1)%3] = high.x; lu[(d+2)%3] = low.y;  lu[d] = t;
+      glm::vec3 ul{0.f, 0.f, 0.f}; ul[(d+1)%3] = low.x;  ul[(d+2)%3] = high.y; ul[d] = t;
+      glm::vec3 uu{0.f, 0.f, 0.f}; uu[(d+1)%3] = high.x; uu[(d+2)%3] = high.y; uu[d] = t;
 
       glm::vec3 n{0.f, 0.f, 0.f}; n[d] = 1.f;
       // clang-format on
@@ -336,13 +591,14 @@ void VolumeGrid::computeGridPlaneReferenceGeometry() {
   for (uint32_t d = 0; d < 3; d++) { // x/y/z dimension (plane is perpendicular)
     for (int32_t i = 0; i < (int32_t)gridCellDim[d]; i++) {
 
+      if (!clipPlane(d, i)) continue;
       float t = (static_cast<float>(i)) / (gridCellDim[d]);
 
       // clang-format off
-      glm::vec3 ll{0.f, 0.f, 0.f}; ll[(d+1)%3] = 0.f; ll[(d+2)%3] = 0.f; ll[d] = t;
-      glm::vec3 lu{0.f, 0.f, 0.f}; lu[(d+1)%3] = 1.f; lu[(d+2)%3] = 0.f; lu[d] = t;
-      glm::vec3 ul{0.f, 0.f, 0.f}; ul[(d+1)%3] = 0.f; ul[(d+2)%3] = 1.f; ul[d] = t;
-      glm::vec3 uu{0.f, 0.f, 0.f}; uu[(d+1)%3] = 1.f; uu[(d+2)%3] = 1.f; uu[d] = t;
+      glm::vec3 ll{0.f, 0.f, 0.f}; ll[(d+1)%3] = low.x;  ll[(d+2)%3] = low.y;  ll[d] = t;
+      glm::vec3 lu{0.f, 0.f, 0.f}; lu[(d+1)%3] = high.x; lu[(d+2)%3] = low.y;  lu[d] = t;
+      glm::vec3 ul{0.f, 0.f, 0.f}; ul[(d+1)%3] = low.x;  ul[(d+2)%3] = high.y; ul[d] = t;
+      glm::vec3 uu{0.f, 0.f, 0.f}; uu[(d+1)%3] = high.x; uu[(d+2)%3] = high.y; uu[d] = t;
 
       glm::vec3 n{0.f, 0.f, 0.f}; n[d] = -1.f;
       // clang-format on
@@ -396,6 +652,20 @@ VolumeGrid* VolumeGrid::setCubeSizeFactor(double newVal) {
 }
 double VolumeGrid::getCubeSizeFactor() { return cubeSizeFactor.get(); }
 
+VolumeGrid* VolumeGrid::setBrickedStorage(bool newVal) {
+  if (newVal == brickedStorage) return this;
+  brickedStorage = newVal;
+  residentBrickSlots.clear();
+  residentSlotBricks.clear();
+  brickResidencyVersion++;
+  sparseBlockSlotTexture.reset();
+  gridPlaneCullState.clear(); // recompute the residency
+  refresh();                  // the programs read values differently
+  requestRedraw();
+  return this;
+}
+bool VolumeGrid::getBrickedStorage() { return brickedStorage; }
+
 // === Register functions
 
 
@@ -423,6 +693,86 @@ VolumeGridCellScalarQuantity* VolumeGrid::addCellScalarQuantityImpl(std::string
   return q;
 }
 
+VolumeGridNodeScalarQuantity* VolumeGrid::addNodeScalarQuantityFromSource(std::string name,
+                                                                          std::shared_ptr<VolumeGridDataSource> source,
+                                                                          std::pair<double, double> valueRange,
+                                                                          DataType dataType_) {
+  if (isSparse()) {
+    exception("data sources are not supported on sparse volume grids");
+  }
+
+  checkForQuantityWithNameAndDeleteOrError(name);
+  setBrickedStorage(true);
+  VolumeGridNodeScalarQuantity* q = new VolumeGridNodeScalarQuantity(name, *this, source, valueRange, dataType_);
+  addQuantity(q);
+  markNodesAsUsed();
+  return q;
+}
+
+VolumeGridCellScalarQuantity* VolumeGrid::addCellScalarQuantityFromSource(std::string name,
+                                                                          std::shared_ptr<VolumeGridDataSource> source,
+                                                                          std::pair<double, double> valueRange,
+                                                                          DataType dataType_) {
+  if (isSparse()) {
+    exception("data sources are not supported on sparse volume grids");
+  }
+
+  checkForQuantityWithNameAndDeleteOrError(name);
+  setBrickedStorage(true);
+  VolumeGridCellScalarQuantity* q = new VolumeGridCellScalarQuantity(name, *this, source, valueRange, dataType_);
+  addQuantity(q);
+  markCellsAsUsed();
+  return q;
+}
+
+VolumeGridNodeScalarQuantity* VolumeGrid::addNodeScalarQuantityNative(std::string name,
+                                                                      std::vector<unsigned char> bytes,
+                                                                      RawValueType valueType, DataType dataType_) {
+  if (bytes.size() != nNodes() * rawValueTypeSize(valueType)) {
+    exception("node scalar quantity " + name + " has " + std::to_string(bytes.size() / rawValueTypeSize(valueType)) +
+              " values, but the grid has " + std::to_string(nNodes()) + " nodes");
+  }
+  std::shared_ptr<ArrayVolumeGridDataSource> source(
+      new ArrayVolumeGridDataSource(std::move(bytes), gridNodeDim, valueType));
+  return addNodeScalarQuantityFromSource(name, source, source->computeValueRange(), dataType_);
+}
+
+VolumeGridCellScalarQuantity* VolumeGrid::addCellScalarQuantityNative(std::string name,
+                                                                      std::vector<unsigned char> bytes,
+                                                                      RawValueType valueType, DataType dataType_) {
+  if (bytes.size() != nCells() * rawValueTypeSize(valueType)) {
+    exception("cell scalar quantity " + name + " has " + std::to_string(bytes.size() / rawValueTypeSize(valueType)) +
+              " values, but the grid has " + std::to_string(nCells()) + " cells");
+  }
+  std::shared_ptr<ArrayVolumeGridDataSource> source(
+      new ArrayVolumeGridDataSource(std::move(bytes), gridCellDim, valueType));
+  return addCellScalarQuantityFromSource(name, source, source->computeValueRange(), dataType_);
+}
+
+VolumeGridNodeScalarQuantity* VolumeGrid::addNodeScalarQuantityView(std::string name, const float* values, size_t count,
+                                                                    std::shared_ptr<void> lifetimeToken,
+                                                                    DataType dataType_) {
+  if (count != nNodes()) {
+    exception("node scalar quantity " + name + " view has " + std::to_string(count) + " values, but the grid has " +
+              std::to_string(nNodes()) + " nodes");
+  }
+  std::shared_ptr<ArrayVolumeGridDataSource> source(
+      new ArrayVolumeGridDataSource(values, gridNodeDim, RawValueType::Float32, lifetimeToken));
+  return addNodeScalarQuantityFromSource(name, source, source->computeValueRange(), dataType_);
+}
+
+VolumeGridCellScalarQuantity* VolumeGrid::addCellScalarQuantityView(std::string name, const float* values, size_t count,
+                                                                    std::shared_ptr<void> lifetimeToken,
+                                                                    DataType dataType_) {
+  if (count != nCells()) {
+    exception("cell scalar quantity " + name + " view has " + std::to_string(count) + " values, but the grid has " +
+              std::to_string(nCells()) + " cells");
+  }
+  std::shared_ptr<ArrayVolumeGridDataSource> source(
+      new ArrayVolumeGridDataSource(values, gridCellDim, RawValueType::Float32, lifetimeToken));
+  return addCellScalarQuantityFromSource(name, source, source->computeValueRange(), dataType_);
+}
+
 void VolumeGrid::markNodesAsUsed() { nodesHaveBeenUsed = true; }
 
 void VolumeGrid::markCellsAsUsed() { cellsHaveBeenUsed = true; }
@@ -437,7 +787,8 @@ void VolumeGrid::buildPickUI(size_t localPickID) {
 
   ImGuiIO& io = ImGui::GetIO();
   glm::vec2 screenCoords{io.MousePos.x, io.MousePos.y};
-  glm::vec3 pickPos = view::screenCoordsToWorldPosition(screenCoords);
+  glm::vec3 pickPos =
+      glm::vec3(glm::inverse(getModelMatrix()) * glm::dvec4(view::screenCoordsToWorldPositionDouble(screenCoords), 1.));
   glm::vec3 localPickPos = (pickPos - boundMin) / (boundMax - boundMin);
   localPickPos = clamp(localPickPos, glm::vec3(0.), glm::vec3(1.)); // on [0,1.]
 
@@ -549,6 +900,16 @@ VolumeGrid* registerVolumeGrid(std::string name, uint64_t gridNodeDim, glm::vec3
   return registerVolumeGrid(name, {gridNodeDim, gridNodeDim, gridNodeDim}, boundMin, boundMax);
 }
 
+VolumeGrid* registerSparseVolumeGrid(std::string name, glm::uvec3 gridNodeDim, glm::vec3 boundMin, glm::vec3 boundMax,
+                                     const std::vector<glm::uvec3>& occupiedBlocks) {
+  VolumeGrid* s = new VolumeGrid(name, gridNodeDim, boundMin, boundMax, occupiedBlocks);
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
 
 // Default implementations
 void VolumeGridQuantity::buildNodeInfoGUI(size_t vInd) {}
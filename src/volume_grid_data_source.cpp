@@ -0,0 +1,268 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/volume_grid_data_source.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/parallel.h"
+#include "polyscope/volume_grid.h"
+
+#include "glm/gtc/packing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace polyscope {
+
+namespace {
+
+// Convert `count` tightly packed values of a raw type to floats
+void rawValuesToFloat(const unsigned char* src, RawValueType valueType, size_t count, float* out) {
+  for (size_t i = 0; i < count; i++) {
+    switch (valueType) {
+    case RawValueType::UInt8:
+      out[i] = src[i];
+      break;
+    case RawValueType::UInt16: {
+      uint16_t v;
+      std::memcpy(&v, src + 2 * i, 2);
+      out[i] = v;
+    } break;
+    case RawValueType::Int16: {
+      int16_t v;
+      std::memcpy(&v, src + 2 * i, 2);
+      out[i] = v;
+    } break;
+    case RawValueType::Float16: {
+      uint16_t v;
+      std::memcpy(&v, src + 2 * i, 2);
+      out[i] = glm::unpackHalf1x16(v);
+    } break;
+    case RawValueType::Float32:
+      std::memcpy(&out[i], src + 4 * i, 4);
+      break;
+    }
+  }
+}
+
+} // namespace
+
+size_t rawValueTypeSize(RawValueType valueType) {
+  switch (valueType) {
+  case RawValueType::UInt8:
+    return 1;
+  case RawValueType::UInt16:
+  case RawValueType::Int16:
+  case RawValueType::Float16:
+    return 2;
+  case RawValueType::Float32:
+    return 4;
+  }
+  return 4;
+}
+
+// === Callback
+
+CallbackVolumeGridDataSource::CallbackVolumeGridDataSource(
+    std::function<void(glm::uvec3 origin, glm::uvec3 extent, float* out)> readFunc_)
+    : readFunc(readFunc_) {}
+
+void CallbackVolumeGridDataSource::readBox(glm::uvec3 origin, glm::uvec3 extent, float* out) {
+  readFunc(origin, extent, out);
+}
+
+// === Raw file
+
+RawFileVolumeGridDataSource::RawFileVolumeGridDataSource(std::string filename_, glm::uvec3 dim_,
+                                                         RawValueType valueType_, size_t headerBytes_)
+    : filename(filename_), file(filename_, std::ios::binary), dim(dim_), valueType(valueType_),
+      headerBytes(headerBytes_) {
+  if (!file) {
+    exception("could not open volume data file " + filename);
+  }
+
+  size_t valueBytes = rawValueTypeSize(valueType);
+  size_t expectedBytes = headerBytes + valueBytes * dim.x * dim.y * dim.z;
+  file.seekg(0, std::ios::end);
+  size_t fileBytes = static_cast<size_t>(file.tellg());
+  if (fileBytes < expectedBytes) {
+    exception("volume data file " + filename + " has " + std::to_string(fileBytes) + " bytes, expected " +
+              std::to_string(expectedBytes));
+  }
+}
+
+void RawFileVolumeGridDataSource::readBox(glm::uvec3 origin, glm::uvec3 extent, float* out) {
+  size_t valueBytes = rawValueTypeSize(valueType);
+  rowBuffer.resize(valueBytes * extent.x);
+
+  // one contiguous read per row of the box
+  for (uint32_t z = 0; z < extent.z; z++) {
+    for (uint32_t y = 0; y < extent.y; y++) {
+      size_t fileInd =
+          (static_cast<size_t>(origin.z + z) * dim.y + origin.y + y) * static_cast<size_t>(dim.x) + origin.x;
+      file.seekg(static_cast<std::streamoff>(headerBytes + valueBytes * fileInd));
+      file.read(rowBuffer.data(), static_cast<std::streamsize>(rowBuffer.size()));
+      if (!file) {
+        file.clear();
+        exception("failed to read volume data file " + filename);
+      }
+
+      rawValuesToFloat(reinterpret_cast<const unsigned char*>(rowBuffer.data()), valueType, extent.x,
+                       out + (static_cast<size_t>(z) * extent.y + y) * extent.x);
+    }
+  }
+}
+
+RawValueType RawFileVolumeGridDataSource::getValueType() const { return valueType; }
+
+// === Array
+
+ArrayVolumeGridDataSource::ArrayVolumeGridDataSource(std::vector<unsigned char> bytes_, glm::uvec3 dim_,
+                                                     RawValueType valueType_)
+    : bytes(std::move(bytes_)), data(bytes.data()), nBytes(bytes.size()), dim(dim_), valueType(valueType_) {
+  size_t expectedBytes = rawValueTypeSize(valueType) * dim.x * dim.y * dim.z;
+  if (bytes.size() != expectedBytes) {
+    exception("volume data has " + std::to_string(bytes.size()) + " bytes, expected " + std::to_string(expectedBytes));
+  }
+}
+
+ArrayVolumeGridDataSource::ArrayVolumeGridDataSource(const void* viewData, glm::uvec3 dim_, RawValueType valueType_,
+                                                     std::shared_ptr<void> lifetimeToken_)
+    : data(static_cast<const unsigned char*>(viewData)),
+      nBytes(rawValueTypeSize(valueType_) * dim_.x * dim_.y * dim_.z), lifetimeToken(lifetimeToken_), dim(dim_),
+      valueType(valueType_) {}
+
+void ArrayVolumeGridDataSource::readBox(glm::uvec3 origin, glm::uvec3 extent, float* out) {
+  size_t valueBytes = rawValueTypeSize(valueType);
+  for (uint32_t z = 0; z < extent.z; z++) {
+    for (uint32_t y = 0; y < extent.y; y++) {
+      size_t ind = (static_cast<size_t>(origin.z + z) * dim.y + origin.y + y) * static_cast<size_t>(dim.x) + origin.x;
+      rawValuesToFloat(data + valueBytes * ind, valueType, extent.x,
+                       out + (static_cast<size_t>(z) * extent.y + y) * extent.x);
+    }
+  }
+}
+
+RawValueType ArrayVolumeGridDataSource::getValueType() const { return valueType; }
+
+std::pair<double, double> ArrayVolumeGridDataSource::computeValueRange() const {
+  size_t valueBytes = rawValueTypeSize(valueType);
+  size_t count = nBytes / valueBytes;
+  size_t nChunks = parallelChunkCount(count, 1 << 16);
+  std::vector<std::pair<float, float>> chunkRanges(nChunks, std::make_pair(std::numeric_limits<float>::infinity(),
+                                                                           -std::numeric_limits<float>::infinity()));
+  parallelForChunks(0, count, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+    float buffer[256];
+    for (size_t i = begin; i < end; i += 256) {
+      size_t n = std::min<size_t>(256, end - i);
+      rawValuesToFloat(data + valueBytes * i, valueType, n, buffer);
+      for (size_t j = 0; j < n; j++) {
+        if (!std::isfinite(buffer[j])) continue;
+        chunkRanges[iChunk].first = std::min(chunkRanges[iChunk].first, buffer[j]);
+        chunkRanges[iChunk].second = std::max(chunkRanges[iChunk].second, buffer[j]);
+      }
+    }
+  });
+
+  std::pair<double, double> range(std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity());
+  for (const std::pair<float, float>& r : chunkRanges) {
+    range.first = std::min<double>(range.first, r.first);
+    range.second = std::max<double>(range.second, r.second);
+  }
+  if (range.first > range.second) range = std::make_pair(0., 0.); // no finite values
+  return range;
+}
+
+// === Brick cache
+
+const size_t VolumeGridBrickCache::defaultBudget = 256 << 20;
+
+VolumeGridBrickCache::VolumeGridBrickCache(std::shared_ptr<VolumeGridDataSource> source_, glm::uvec3 valueDim_,
+                                           glm::uvec3 brickDim_, uint32_t slotSize_)
+    : source(source_), valueDim(valueDim_), brickDim(brickDim_), slotSize(slotSize_), budget(defaultBudget) {}
+
+const std::vector<float>& VolumeGridBrickCache::fetchBrick(int64_t iBrick) {
+  auto it = bricks.find(iBrick);
+  if (it != bricks.end()) {
+    recentBricks.splice(recentBricks.begin(), recentBricks, it->second.second);
+    return it->second.first;
+  }
+
+  // Read the part of the brick inside the grid, then pad it to the slot by clamping
+  glm::uvec3 origin = VolumeGrid::sparseBlockSize *
+                      glm::uvec3{static_cast<uint32_t>(iBrick % brickDim.x),
+                                 static_cast<uint32_t>((iBrick / brickDim.x) % brickDim.y),
+                                 static_cast<uint32_t>(iBrick / (static_cast<int64_t>(brickDim.x) * brickDim.y))};
+  glm::uvec3 extent = glm::min(origin + slotSize, valueDim) - origin;
+  std::vector<float> boxValues(static_cast<size_t>(extent.x) * extent.y * extent.z);
+  source->readBox(origin, extent, boxValues.data());
+  readCount++;
+
+  std::vector<float> brickValues(static_cast<size_t>(slotSize) * slotSize * slotSize);
+  size_t iOut = 0;
+  for (uint32_t z = 0; z < slotSize; z++) {
+    for (uint32_t y = 0; y < slotSize; y++) {
+      for (uint32_t x = 0; x < slotSize; x++) {
+        glm::uvec3 ind = glm::min(glm::uvec3{x, y, z}, extent - 1u);
+        brickValues[iOut++] = boxValues[(static_cast<size_t>(ind.z) * extent.y + ind.y) * extent.x + ind.x];
+      }
+    }
+  }
+
+  evictToBudget(1);
+  recentBricks.push_front(iBrick);
+  auto inserted = bricks.emplace(iBrick, std::make_pair(std::move(brickValues), recentBricks.begin()));
+  return inserted.first->second.first;
+}
+
+void VolumeGridBrickCache::evictToBudget(size_t keep) {
+  size_t brickBytes = sizeof(float) * slotSize * slotSize * slotSize;
+  size_t maxBricks = std::max<size_t>(budget / brickBytes, 1);
+  while (bricks.size() + keep > maxBricks && !recentBricks.empty()) {
+    bricks.erase(recentBricks.back());
+    recentBricks.pop_back();
+  }
+}
+
+void VolumeGridBrickCache::readBrick(int64_t iBrick, float* out) {
+  std::lock_guard<std::mutex> lock(mutex);
+  const std::vector<float>& brickValues = fetchBrick(iBrick);
+  std::copy(brickValues.begin(), brickValues.end(), out);
+}
+
+float VolumeGridBrickCache::readValue(glm::uvec3 ind) {
+  // nodes on the faces between bricks are in both, use the lower one
+  glm::uvec3 brick = glm::min(ind / VolumeGrid::sparseBlockSize, brickDim - 1u);
+  glm::uvec3 local = ind - brick * VolumeGrid::sparseBlockSize;
+  int64_t iBrick = (static_cast<int64_t>(brick.z) * brickDim.y + brick.y) * brickDim.x + brick.x;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  const std::vector<float>& brickValues = fetchBrick(iBrick);
+  return brickValues[(static_cast<size_t>(local.z) * slotSize + local.y) * slotSize + local.x];
+}
+
+void VolumeGridBrickCache::setBudget(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+  budget = bytes;
+  evictToBudget(0);
+}
+
+size_t VolumeGridBrickCache::getBudget() const { return budget; }
+
+size_t VolumeGridBrickCache::nCachedBricks() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return bricks.size();
+}
+
+uint64_t VolumeGridBrickCache::getReadCount() const { return readCount; }
+
+void VolumeGridBrickCache::gatherCachedValues(std::vector<float>& out) {
+  std::lock_guard<std::mutex> lock(mutex);
+  out.clear();
+  for (const auto& entry : bricks) {
+    out.insert(out.end(), entry.second.first.begin(), entry.second.first.end());
+  }
+}
+
+} // namespace polyscope
@@ -2,10 +2,357 @@
 
 #include "polyscope/volume_grid_scalar_quantity.h"
 
-#include "MarchingCube/MC.h"
+#include "polyscope/derived_data_cache.h"
+#include "polyscope/marching_cubes.h"
+#include "polyscope/parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
 
 namespace polyscope {
 
+namespace {
+
+// The triangles of the grid's bounding box in reference coordinates, wound outwards. The raymarching fragment shaders
+// march from the back faces.
+std::vector<glm::vec3> gridBoxReferenceTriangles() {
+  std::vector<glm::vec3> boxTriangles;
+  for (int axis = 0; axis < 3; axis++) {
+    glm::vec3 eU{0., 0., 0.};
+    glm::vec3 eV{0., 0., 0.};
+    eU[(axis + 1) % 3] = 1.;
+    eV[(axis + 2) % 3] = 1.;
+    for (int side = 0; side < 2; side++) {
+      glm::vec3 base{0., 0., 0.};
+      base[axis] = side;
+      std::array<glm::vec3, 4> c{base, base + eU, base + eU + eV, base + eV};
+      if (side == 1) {
+        boxTriangles.insert(boxTriangles.end(), {c[0], c[1], c[2], c[0], c[2], c[3]});
+      } else {
+        boxTriangles.insert(boxTriangles.end(), {c[0], c[2], c[1], c[0], c[3], c[2]});
+      }
+    }
+  }
+  return boxTriangles;
+}
+
+// Maps view coordinates to [0,1]^3 across the grid's bounds
+glm::mat4 gridViewToReference(VolumeGrid& grid) {
+  glm::vec3 boundMin = grid.getBoundMin();
+  glm::vec3 boundExtent = grid.getBoundMax() - boundMin;
+  glm::mat4 worldToReference =
+      glm::scale(glm::mat4(1.), 1.f / boundExtent) * glm::translate(glm::mat4(1.), -boundMin);
+  return worldToReference * glm::inverse(grid.getModelView());
+}
+
+// Volume rendering skips over bricks of samples whose values all lie outside the colormap range. Along each axis,
+// brick b covers samples [b * VOLUME_BRICK_SIZE, (b + 1) * VOLUME_BRICK_SIZE] inclusive, so its range bounds any value
+// interpolated from its samples.
+const uint32_t VOLUME_BRICK_SIZE = 8;
+
+glm::uvec3 volumeBrickDim(glm::uvec3 valueDim) {
+  glm::uvec3 brickDim;
+  for (int i = 0; i < 3; i++) {
+    uint32_t nIntervals = std::max(valueDim[i], 2u) - 1;
+    brickDim[i] = (nIntervals + VOLUME_BRICK_SIZE - 1) / VOLUME_BRICK_SIZE;
+  }
+  return brickDim;
+}
+
+// The min and max value of each brick, in the first two channels of a 3D texture
+std::shared_ptr<render::TextureBuffer> generateVolumeBrickTexture(const std::vector<float>& values,
+                                                                  glm::uvec3 valueDim) {
+  glm::uvec3 brickDim = volumeBrickDim(valueDim);
+  size_t nBricks = static_cast<size_t>(brickDim.x) * brickDim.y * brickDim.z;
+  std::vector<float> brickRanges(3 * nBricks, 0.f);
+
+  parallelFor(
+      0, nBricks,
+      [&](size_t begin, size_t end) {
+        for (size_t iBrick = begin; iBrick < end; iBrick++) {
+          glm::uvec3 brick{static_cast<uint32_t>(iBrick % brickDim.x),
+                           static_cast<uint32_t>((iBrick / brickDim.x) % brickDim.y),
+                           static_cast<uint32_t>(iBrick / (static_cast<size_t>(brickDim.x) * brickDim.y))};
+          glm::uvec3 low = brick * VOLUME_BRICK_SIZE;
+          glm::uvec3 high = glm::min(low + VOLUME_BRICK_SIZE, valueDim - 1u);
+
+          float vMin = std::numeric_limits<float>::infinity();
+          float vMax = -std::numeric_limits<float>::infinity();
+          for (uint32_t z = low.z; z <= high.z; z++) {
+            for (uint32_t y = low.y; y <= high.y; y++) {
+              size_t rowStart = (static_cast<size_t>(z) * valueDim.y + y) * valueDim.x;
+              for (uint32_t x = low.x; x <= high.x; x++) {
+                float v = values[rowStart + x];
+                vMin = std::min(vMin, v);
+                vMax = std::max(vMax, v);
+              }
+            }
+          }
+          brickRanges[3 * iBrick + 0] = vMin;
+          brickRanges[3 * iBrick + 1] = vMax;
+        }
+      },
+      16);
+
+  return render::engine->generateTextureBuffer(TextureFormat::RGB32F, brickDim.x, brickDim.y, brickDim.z,
+                                               &brickRanges.front());
+}
+
+// Create a direct volume rendering program for values stored in a 3D texture of dimension valueDim
+std::shared_ptr<render::ShaderProgram> createGridVolumeProgram(VolumeGrid& grid, render::ManagedBuffer<float>& values,
+                                                               glm::uvec3 valueDim, const std::string& cmap,
+                                                               std::shared_ptr<render::TextureBuffer>& brickTexture) {
+
+  std::shared_ptr<render::ShaderProgram> program = render::engine->requestShader(
+      "GRID_VOLUME_RAYMARCH", grid.addStructureRules({}), render::ShaderReplacementDefaults::SceneObject);
+
+  program->setAttribute("a_referencePosition", gridBoxReferenceTriangles());
+
+  program->setTextureFromBuffer("t_value", values.getRenderTextureBuffer().get());
+  values.getRenderTextureBuffer().get()->setFilterMode(FilterMode::Linear);
+
+  brickTexture = generateVolumeBrickTexture(values.getPopulatedHostBufferRef(), valueDim);
+  program->setTextureFromBuffer("t_brickRange", brickTexture.get());
+
+  program->setTextureFromColormap("t_colormap", cmap);
+
+  return program;
+}
+
+// Set the uniforms for the program above and draw it. Node values sit on the corners of the grid while cell values
+// sit at cell centers, which changes how reference coordinates map to texture coordinates.
+void drawGridVolumeProgram(render::ShaderProgram& program, VolumeGrid& grid, glm::uvec3 valueDim, bool nodeCentered,
+                           std::pair<double, double> range, float density) {
+  grid.setStructureUniforms(program);
+  program.setUniform("u_boundMin", grid.getBoundMin());
+  program.setUniform("u_boundMax", grid.getBoundMax());
+
+  glm::mat4 P = view::getCameraPerspectiveMatrix();
+  glm::mat4 Pinv = glm::inverse(P);
+  program.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
+  program.setUniform("u_viewport", render::engine->getCurrentViewport());
+  program.setUniform("u_viewToReference", glm::value_ptr(gridViewToReference(grid)));
+
+  glm::vec3 dim(valueDim);
+  if (nodeCentered) {
+    program.setUniform("u_refToTexScale", (dim - 1.f) / dim);
+    program.setUniform("u_refToTexOffset", 0.5f / dim);
+  } else {
+    program.setUniform("u_refToTexScale", glm::vec3{1., 1., 1.});
+    program.setUniform("u_refToTexOffset", glm::vec3{0., 0., 0.});
+  }
+  program.setUniform("u_valueDim", dim);
+  program.setUniform("u_brickDim", glm::vec3(volumeBrickDim(valueDim)));
+  program.setUniform("u_brickSize", static_cast<float>(VOLUME_BRICK_SIZE));
+  program.setUniform("u_rangeLow", static_cast<float>(range.first));
+  program.setUniform("u_rangeHigh", static_cast<float>(range.second));
+  program.setUniform("u_volumeDensity", density);
+
+  render::engine->setBackfaceCull(false);
+  program.draw();
+}
+
+// On sparse grids, the gridcube programs read values from a pool texture in which each occupied block fills a slot of
+// slotSize^3 texels. Slot k sits at (k % poolDim.x, (k / poolDim.x) % poolDim.y, k / (poolDim.x * poolDim.y)), with
+// the slots arranged in a roughly cubical pool to stay within the texture size limits.
+glm::uvec3 sparsePoolDim(size_t nBlocks) {
+  nBlocks = std::max<size_t>(nBlocks, 1);
+  size_t px = static_cast<size_t>(std::ceil(std::cbrt(static_cast<double>(nBlocks))));
+  size_t py = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>((nBlocks + px - 1) / px))));
+  size_t pz = (nBlocks + px * py - 1) / (px * py);
+  return glm::uvec3{static_cast<uint32_t>(px), static_cast<uint32_t>(py), static_cast<uint32_t>(pz)};
+}
+
+std::shared_ptr<render::TextureBuffer> generateSparsePoolTexture(const std::vector<float>& values, size_t nBlocks,
+                                                                 uint32_t slotSize,
+                                                                 TextureFormat format = TextureFormat::R32F) {
+  glm::uvec3 poolDim = sparsePoolDim(nBlocks);
+  glm::uvec3 texDim = poolDim * slotSize;
+  size_t perSlot = static_cast<size_t>(slotSize) * slotSize * slotSize;
+  std::vector<float> poolData(static_cast<size_t>(texDim.x) * texDim.y * texDim.z, 0.f);
+
+  parallelFor(
+      0, nBlocks,
+      [&](size_t begin, size_t end) {
+        for (size_t iBlock = begin; iBlock < end; iBlock++) {
+          glm::uvec3 slotOrigin = slotSize * glm::uvec3{static_cast<uint32_t>(iBlock % poolDim.x),
+                                                        static_cast<uint32_t>((iBlock / poolDim.x) % poolDim.y),
+                                                        static_cast<uint32_t>(iBlock / (poolDim.x * poolDim.y))};
+          for (uint32_t z = 0; z < slotSize; z++) {
+            for (uint32_t y = 0; y < slotSize; y++) {
+              size_t src = iBlock * perSlot + (static_cast<size_t>(z) * slotSize + y) * slotSize;
+              size_t dst =
+                  (static_cast<size_t>(slotOrigin.z + z) * texDim.y + slotOrigin.y + y) * texDim.x + slotOrigin.x;
+              std::copy(values.begin() + src, values.begin() + src + slotSize, poolData.begin() + dst);
+            }
+          }
+        }
+      },
+      16);
+
+  return render::engine->generateTextureBuffer(format, texDim.x, texDim.y, texDim.z, &poolData.front());
+}
+
+// Values from data sources with a compact type keep that precision in the pool texture. Integer types are stored
+// normalized, the shaders map texels t back to values as t * scale + offset.
+void compactPoolEncoding(RawValueType valueType, TextureFormat& format, float& scale, float& offset) {
+  format = TextureFormat::R32F;
+  scale = 1.f;
+  offset = 0.f;
+  switch (valueType) {
+  case RawValueType::UInt8:
+    format = TextureFormat::R8;
+    scale = 255.f;
+    break;
+  case RawValueType::UInt16:
+    format = TextureFormat::R16;
+    scale = 65535.f;
+    break;
+  case RawValueType::Int16:
+    format = TextureFormat::R16;
+    scale = 65535.f;
+    offset = -32768.f;
+    break;
+  case RawValueType::Float16:
+    format = TextureFormat::R16F;
+    break;
+  case RawValueType::Float32:
+    break;
+  }
+}
+
+// On dense bricked grids, the pool holds only the bricks which are resident in the grid (see
+// VolumeGrid::getResidentSlotBricks()). A gatherer writes the slotSize^3 values of a brick, with values past the end of
+// the grid clamped, from the dense values or from a data source.
+typedef std::function<void(int64_t iBrick, float* out)> BrickGatherer;
+
+BrickGatherer denseBrickGatherer(VolumeGrid& grid, VolumeGridBrickCache* sourceCache,
+                                 render::ManagedBuffer<float>& values, glm::uvec3 valueDim, uint32_t slotSize,
+                                 float scale = 1.f, float offset = 0.f) {
+  if (sourceCache) {
+    size_t perSlot = static_cast<size_t>(slotSize) * slotSize * slotSize;
+    return [=](int64_t iBrick, float* out) {
+      sourceCache->readBrick(iBrick, out);
+      if (scale == 1.f && offset == 0.f) return;
+      for (size_t i = 0; i < perSlot; i++) {
+        out[i] = (out[i] - offset) / scale; // see compactPoolEncoding()
+      }
+    };
+  }
+
+  const std::vector<float>* valuesPtr = &values.getPopulatedHostBufferRef();
+  glm::uvec3 brickDim = (grid.getGridCellDim() + VolumeGrid::sparseBlockSize - 1u) / VolumeGrid::sparseBlockSize;
+  return [=](int64_t iBrick, float* out) {
+    glm::uvec3 origin = VolumeGrid::sparseBlockSize *
+                        glm::uvec3{static_cast<uint32_t>(iBrick % brickDim.x),
+                                   static_cast<uint32_t>((iBrick / brickDim.x) % brickDim.y),
+                                   static_cast<uint32_t>(iBrick / (static_cast<int64_t>(brickDim.x) * brickDim.y))};
+    for (uint32_t z = 0; z < slotSize; z++) {
+      for (uint32_t y = 0; y < slotSize; y++) {
+        for (uint32_t x = 0; x < slotSize; x++) {
+          glm::uvec3 ind = glm::min(origin + glm::uvec3{x, y, z}, valueDim - 1u);
+          *(out++) = (*valuesPtr)[(static_cast<size_t>(ind.z) * valueDim.y + ind.y) * valueDim.x + ind.x];
+        }
+      }
+    }
+  };
+}
+
+std::shared_ptr<render::TextureBuffer> generateDenseBrickPoolTexture(VolumeGrid& grid, const BrickGatherer& gather,
+                                                                     uint32_t slotSize, TextureFormat format,
+                                                                     std::vector<int64_t>& poolSlotBricks) {
+  poolSlotBricks = grid.getResidentSlotBricks();
+  size_t perSlot = static_cast<size_t>(slotSize) * slotSize * slotSize;
+
+  // leave room to page in more bricks before the pool needs to be reallocated
+  size_t nSlots = poolSlotBricks.size() + poolSlotBricks.size() / 2 + 1;
+  std::vector<float> slotValues(nSlots * perSlot, 0.f);
+  parallelFor(
+      0, poolSlotBricks.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t iSlot = begin; iSlot < end; iSlot++) {
+          if (poolSlotBricks[iSlot] < 0) continue;
+          gather(poolSlotBricks[iSlot], &slotValues[iSlot * perSlot]);
+        }
+      },
+      16);
+
+  return generateSparsePoolTexture(slotValues, nSlots, slotSize, format);
+}
+
+// Write the values of slot iSlot of a pool texture
+void uploadPoolSlot(render::TextureBuffer& pool, uint32_t slotSize, size_t iSlot, const std::vector<float>& slotValues) {
+  glm::uvec3 poolDim{pool.getSizeX() / slotSize, pool.getSizeY() / slotSize, pool.getSizeZ() / slotSize};
+  glm::uvec3 slotOrigin = slotSize * glm::uvec3{static_cast<uint32_t>(iSlot % poolDim.x),
+                                                static_cast<uint32_t>((iSlot / poolDim.x) % poolDim.y),
+                                                static_cast<uint32_t>(iSlot / (poolDim.x * poolDim.y))};
+  pool.setDataBox(&slotValues.front(), 1, PixelComponentType::Float32, slotOrigin.x, slotOrigin.y, slotOrigin.z,
+                  slotSize, slotSize, slotSize);
+}
+
+// Upload the bricks which became resident since the pool was last synced, into their slots. Returns false if the pool
+// has too few slots, and needs to be generated again.
+bool updateDenseBrickPoolTexture(VolumeGrid& grid, const BrickGatherer& gather, uint32_t slotSize,
+                                 render::TextureBuffer& pool, std::vector<int64_t>& poolSlotBricks) {
+  const std::vector<int64_t>& resident = grid.getResidentSlotBricks();
+  glm::uvec3 poolDim{pool.getSizeX() / slotSize, pool.getSizeY() / slotSize, pool.getSizeZ() / slotSize};
+  if (resident.size() > static_cast<size_t>(poolDim.x) * poolDim.y * poolDim.z) return false;
+
+  std::vector<float> slotValues(static_cast<size_t>(slotSize) * slotSize * slotSize);
+  poolSlotBricks.resize(resident.size(), -1);
+  for (size_t iSlot = 0; iSlot < resident.size(); iSlot++) {
+    if (resident[iSlot] == poolSlotBricks[iSlot]) continue;
+    poolSlotBricks[iSlot] = resident[iSlot];
+    if (resident[iSlot] < 0) continue; // evicted, the stale values are never read
+    gather(resident[iSlot], &slotValues.front());
+    uploadPoolSlot(pool, slotSize, iSlot, slotValues);
+  }
+  return true;
+}
+
+// Upload the bricks in the pool whose values changed, those with brick coordinates in [brickLow, brickHigh]
+void refreshDenseBrickPoolTexture(VolumeGrid& grid, const BrickGatherer& gather, uint32_t slotSize,
+                                  render::TextureBuffer& pool, const std::vector<int64_t>& poolSlotBricks,
+                                  glm::uvec3 brickLow, glm::uvec3 brickHigh) {
+  glm::uvec3 brickDim = (grid.getGridCellDim() + VolumeGrid::sparseBlockSize - 1u) / VolumeGrid::sparseBlockSize;
+  std::vector<float> slotValues(static_cast<size_t>(slotSize) * slotSize * slotSize);
+  for (size_t iSlot = 0; iSlot < poolSlotBricks.size(); iSlot++) {
+    int64_t iBrick = poolSlotBricks[iSlot];
+    if (iBrick < 0) continue;
+    glm::uvec3 brick{static_cast<uint32_t>(iBrick % brickDim.x),
+                     static_cast<uint32_t>((iBrick / brickDim.x) % brickDim.y),
+                     static_cast<uint32_t>(iBrick / (static_cast<int64_t>(brickDim.x) * brickDim.y))};
+    if (glm::any(glm::lessThan(brick, brickLow)) || glm::any(glm::greaterThan(brick, brickHigh))) continue;
+    gather(iBrick, &slotValues.front());
+    uploadPoolSlot(pool, slotSize, iSlot, slotValues);
+  }
+}
+
+// Region updates (see VolumeGridNodeScalarQuantity::updateNodeScalarRegion()) replace a box of values on a dense grid
+void checkValueRegion(VolumeGrid& grid, const std::string& quantityName, bool hasDataSource, glm::uvec3 valueDim,
+                      glm::uvec3 offset, glm::uvec3 extent, size_t nValues) {
+  if (grid.isSparse()) {
+    exception("volume grid quantity " + quantityName + " region updates are not supported on sparse volume grids");
+  }
+  if (hasDataSource) {
+    exception("volume grid quantity " + quantityName + " reads its values from a data source, they cannot be updated");
+  }
+  for (int i = 0; i < 3; i++) {
+    if (offset[i] + extent[i] > valueDim[i]) {
+      exception("volume grid quantity " + quantityName + " region update extends past the end of the grid");
+    }
+  }
+  size_t expected = static_cast<size_t>(extent.x) * extent.y * extent.z;
+  if (nValues != expected) {
+    exception("volume grid quantity " + quantityName + " region update has " + std::to_string(nValues) +
+              " values, expected " + std::to_string(expected));
+  }
+}
+
+} // namespace
+
 // ========================================================
 // ==========            Node Scalar             ==========
 // ========================================================
@@ -17,9 +364,31 @@ VolumeGridNodeScalarQuantity::VolumeGridNodeScalarQuantity(std::string name, Vol
       isosurfaceVizEnabled(uniquePrefix() + "isosurfaceVizEnabled", false),
       isosurfaceLevel(uniquePrefix() + "isosurfaceLevel", 0.f),
       isosurfaceColor(uniquePrefix() + "isosurfaceColor", getNextUniqueColor()),
-      slicePlanesAffectIsosurface(uniquePrefix() + "slicePlanesAffectIsosurface", false) {
+      slicePlanesAffectIsosurface(uniquePrefix() + "slicePlanesAffectIsosurface", false),
+      isosurfaceRaymarched(uniquePrefix() + "isosurfaceRaymarched", false),
+      volumeVizEnabled(uniquePrefix() + "volumeVizEnabled", false),
+      volumeDensity(uniquePrefix() + "volumeDensity", 10.f) {
+
+  // sparse values are drawn from a pool texture instead, see createGridcubeProgram()
+  if (!parent.isSparse()) {
+    values.setTextureSize(parent.getGridNodeDim().x, parent.getGridNodeDim().y, parent.getGridNodeDim().z);
+  }
+}
 
-  values.setTextureSize(parent.getGridNodeDim().x, parent.getGridNodeDim().y, parent.getGridNodeDim().z);
+VolumeGridNodeScalarQuantity::VolumeGridNodeScalarQuantity(std::string name, VolumeGrid& grid_,
+                                                           std::shared_ptr<VolumeGridDataSource> source,
+                                                           std::pair<double, double> valueRange, DataType dataType_)
+    : VolumeGridNodeScalarQuantity(name, grid_, std::vector<float>(), dataType_) {
+  glm::uvec3 brickDim = (parent.getGridCellDim() + VolumeGrid::sparseBlockSize - 1u) / VolumeGrid::sparseBlockSize;
+  dataSourceCache.reset(
+      new VolumeGridBrickCache(source, parent.getGridNodeDim(), brickDim, VolumeGrid::sparseBlockSize + 1));
+
+  // computing the range would read every value
+  dataFiniteRange = valueRange;
+  dataRange = robustRange(valueRange, 1e-5);
+  dataRangeComputed = true;
+  setDefaultsFromDataRange();
+  compactPoolEncoding(source->getValueType(), poolFormat, poolValueScale, poolValueOffset);
 }
 
 
@@ -36,6 +405,9 @@ void VolumeGridNodeScalarQuantity::buildCustomUI() {
     if (ImGui::MenuItem("Gridcube", NULL, &gridcubeVizEnabled.get())) setGridcubeVizEnabled(getGridcubeVizEnabled());
     if (ImGui::MenuItem("Isosurface", NULL, &isosurfaceVizEnabled.get()))
       setIsosurfaceVizEnabled(getIsosurfaceVizEnabled());
+    if (!parent.isBricked()) {
+      if (ImGui::MenuItem("Volume", NULL, &volumeVizEnabled.get())) setVolumeVizEnabled(getVolumeVizEnabled());
+    }
     // ImGui::Indent(-20);
     ImGui::EndPopup();
   }
@@ -52,15 +424,32 @@ void VolumeGridNodeScalarQuantity::buildCustomUI() {
     if (ImGui::MenuItem("Slice plane affects isosurface", NULL, &slicePlanesAffectIsosurface.get()))
       setSlicePlanesAffectIsosurface(getSlicePlanesAffectIsosurface());
 
+    if (!parent.isBricked()) {
+      if (ImGui::MenuItem("Raymarch isosurface on GPU", NULL, &isosurfaceRaymarched.get()))
+        setIsosurfaceRaymarched(getIsosurfaceRaymarched());
+    }
+
     if (ImGui::MenuItem("Register isosurface as mesh")) registerIsosurfaceAsMesh();
 
     ImGui::EndPopup();
   }
 
-  if (gridcubeVizEnabled.get()) {
+  if (gridcubeVizEnabled.get() || volumeVizEnabled.get()) {
+    if (dataSourceCache) ensureSourceHistogramBuilt();
     buildScalarUI();
   }
 
+  if (volumeVizEnabled.get()) {
+    ImGui::TextUnformatted("Volume:");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(120);
+    if (ImGui::SliderFloat("density", &volumeDensity.get(), 0.1, 1000., "%.2f",
+                           ImGuiSliderFlags_Logarithmic | ImGuiSliderFlags_NoRoundToFormat)) {
+      setVolumeDensity(getVolumeDensity());
+    }
+    ImGui::PopItemWidth();
+  }
+
   if (isosurfaceVizEnabled.get()) {
     ImGui::TextUnformatted("Isosurface:");
     // Color picker
@@ -73,9 +462,12 @@ void VolumeGridNodeScalarQuantity::buildCustomUI() {
     ImGui::PushItemWidth(120);
     if (ImGui::SliderFloat("##Radius", &isosurfaceLevel.get(), vizRangeMin.get(), vizRangeMax.get(), "%.4e")) {
       // Note: we intentionally do this rather than calling setIsosurfaceLevel(), because that function immediately
-      // recomputes the levelset mesh, which is too expensive during user interaction
+      // recomputes the levelset mesh, which is too expensive during user interaction. It is updated on release.
       isosurfaceLevel.manuallyChanged();
     }
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+      setIsosurfaceLevel(getIsosurfaceLevel());
+    }
     ImGui::PopItemWidth();
     ImGui::SameLine();
     if (ImGui::Button("Refresh")) {
@@ -91,6 +483,22 @@ bool VolumeGridNodeScalarQuantity::isDrawingGridcubes() { return isEnabled() &&
 void VolumeGridNodeScalarQuantity::refresh() {
   gridcubeProgram.reset();
   isosurfaceProgram.reset();
+  isosurfaceRaymarchProgram.reset();
+  isosurfaceMeshValid = false;
+  isosurfaceSlabs.invalidate();
+  volumeProgram.reset();
+  volumeBrickTexture.reset();
+  sparseValueTexture.reset();
+}
+
+void VolumeGridNodeScalarQuantity::refreshShaderPrograms() {
+  // the textures are regenerated along with the programs, the isosurface mesh does not depend on them
+  gridcubeProgram.reset();
+  isosurfaceProgram.reset();
+  isosurfaceRaymarchProgram.reset();
+  volumeProgram.reset();
+  volumeBrickTexture.reset();
+  sparseValueTexture.reset();
 }
 
 void VolumeGridNodeScalarQuantity::draw() {
@@ -98,6 +506,21 @@ void VolumeGridNodeScalarQuantity::draw() {
 
   // Draw the point viz
   if (gridcubeVizEnabled.get()) {
+    if (gridcubeProgram && sparseValueTexture && sparseValueTextureDataVersion != values.getDataVersion()) {
+      gridcubeProgram.reset(); // the values were updated, and need to be copied to the pool texture again
+    }
+    if (gridcubeProgram && sparseValueTexture && !parent.isSparse() &&
+        brickPoolResidencyVersion != parent.getBrickResidencyVersion()) {
+      // page in the bricks which the slice planes uncovered
+      uint32_t slotSize = VolumeGrid::sparseBlockSize + 1;
+      BrickGatherer gather =
+          denseBrickGatherer(parent, dataSourceCache.get(), values, parent.getGridNodeDim(), slotSize, poolValueScale,
+                             poolValueOffset);
+      if (!updateDenseBrickPoolTexture(parent, gather, slotSize, *sparseValueTexture, brickPoolSlotBricks)) {
+        gridcubeProgram.reset();
+      }
+      brickPoolResidencyVersion = parent.getBrickResidencyVersion();
+    }
     if (gridcubeProgram == nullptr) {
       createGridcubeProgram();
     }
@@ -106,6 +529,10 @@ void VolumeGridNodeScalarQuantity::draw() {
     parent.setStructureUniforms(*gridcubeProgram);
     parent.setGridCubeUniforms(*gridcubeProgram);
     setScalarUniforms(*gridcubeProgram);
+    if (parent.isBricked()) {
+      gridcubeProgram->setUniform("u_valueScale", poolValueScale);
+      gridcubeProgram->setUniform("u_valueOffset", poolValueOffset);
+    }
     render::engine->setMaterialUniforms(*gridcubeProgram, parent.getMaterial());
 
     // Draw the actual grid
@@ -114,7 +541,13 @@ void VolumeGridNodeScalarQuantity::draw() {
   }
 
   // Draw the isosurface program
-  if (isosurfaceVizEnabled.get()) {
+  if (isosurfaceVizEnabled.get() && getIsosurfaceRaymarched()) {
+    drawIsosurfaceRaymarched();
+  } else if (isosurfaceVizEnabled.get()) {
+    bool bricksChanged = dataSourceCache && isosurfaceMeshResidencyVersion != parent.getBrickResidencyVersion();
+    if (isosurfaceProgram && (isosurfaceMeshDataVersion != values.getDataVersion() || bricksChanged)) {
+      isosurfaceProgram.reset(); // the values were updated, or the slice planes uncovered other bricks
+    }
     if (isosurfaceProgram == nullptr) {
       createIsosurfaceProgram();
     }
@@ -133,6 +566,22 @@ void VolumeGridNodeScalarQuantity::draw() {
   }
 }
 
+void VolumeGridNodeScalarQuantity::drawDelayed() {
+  if (!isEnabled()) return;
+
+  // The volume is translucent, so it is composited over everything drawn in the main phase
+  if (volumeVizEnabled.get()) {
+    if (volumeProgram && volumeProgramDataVersion != values.getDataVersion()) {
+      volumeProgram.reset(); // the values were updated
+    }
+    if (volumeProgram == nullptr) {
+      createVolumeProgram();
+    }
+    setColorMapUniforms(*volumeProgram);
+    drawGridVolumeProgram(*volumeProgram, parent, parent.getGridNodeDim(), true, getMapRange(), getVolumeDensity());
+  }
+}
+
 void VolumeGridNodeScalarQuantity::createGridcubeProgram() {
 
 
@@ -141,7 +590,7 @@ void VolumeGridNodeScalarQuantity::createGridcubeProgram() {
       render::engine->addMaterialRules(parent.getMaterial(),
         parent.addGridCubeRules(
           addScalarRules(
-            {"GRIDCUBE_PROPAGATE_NODE_VALUE"}
+            {parent.isBricked() ? "GRIDCUBE_PROPAGATE_SPARSE_NODE_VALUE" : "GRIDCUBE_PROPAGATE_NODE_VALUE"}
           ), 
         true)
       )
@@ -155,41 +604,225 @@ void VolumeGridNodeScalarQuantity::createGridcubeProgram() {
   gridcubeProgram->setTextureFromColormap("t_colormap", cMap.get());
   render::engine->setMaterial(*gridcubeProgram, parent.getMaterial());
 
-  gridcubeProgram->setTextureFromBuffer("t_value", values.getRenderTextureBuffer().get());
-  values.getRenderTextureBuffer().get()->setFilterMode(FilterMode::Linear);
+  if (parent.isBricked()) {
+    if (parent.isSparse()) {
+      sparseValueTexture = generateSparsePoolTexture(values.getPopulatedHostBufferRef(), parent.nOccupiedBlocks(),
+                                                     VolumeGrid::sparseBlockSize + 1);
+    } else {
+      uint32_t slotSize = VolumeGrid::sparseBlockSize + 1;
+      BrickGatherer gather =
+          denseBrickGatherer(parent, dataSourceCache.get(), values, parent.getGridNodeDim(), slotSize, poolValueScale,
+                             poolValueOffset);
+      sparseValueTexture = generateDenseBrickPoolTexture(parent, gather, slotSize, poolFormat, brickPoolSlotBricks);
+      brickPoolResidencyVersion = parent.getBrickResidencyVersion();
+    }
+    sparseValueTextureDataVersion = values.getDataVersion();
+    gridcubeProgram->setTextureFromBuffer("t_value", sparseValueTexture.get());
+    sparseValueTexture->setFilterMode(FilterMode::Linear);
+  } else {
+    gridcubeProgram->setTextureFromBuffer("t_value", values.getRenderTextureBuffer().get());
+    values.getRenderTextureBuffer().get()->setFilterMode(FilterMode::Linear);
+  }
 }
 
-void VolumeGridNodeScalarQuantity::createIsosurfaceProgram() {
-
-  values.ensureHostBufferPopulated();
+void VolumeGridNodeScalarQuantity::ensureIsosurfaceMeshExtracted() {
+  if (dataSourceCache) {
+    parent.getResidentSlotBricks(); // brings the residency up to date with the slice planes
+  }
+  if (isosurfaceMeshValid && isosurfaceMeshLevel == isosurfaceLevel.get() &&
+      isosurfaceMeshDataVersion == values.getDataVersion() &&
+      (!dataSourceCache || isosurfaceMeshResidencyVersion == parent.getBrickResidencyVersion())) {
+    return;
+  }
 
   // Extract the isosurface from the level set of the scalar field
-  MC::mcMesh isosurfaceMesh;
-  MC::marching_cube(&values.data.front(), isosurfaceLevel.get(), parent.getGridNodeDim().x, parent.getGridNodeDim().y,
-                    parent.getGridNodeDim().z, isosurfaceMesh);
-
-  // Transform the result to be aligned with our volume's spatial layout
+  std::vector<float>& fieldData = values.getPopulatedHostBufferRef();
   glm::vec3 scale = parent.gridSpacing();
-  for (auto& p : isosurfaceMesh.vertices) {
-    // swizzle to account for change of coordinate/buffer ordering in the MC lib
-    p = glm::vec3{p.z, p.y, p.x} * scale + parent.getBoundMin();
+  glm::vec3 boundMin = parent.getBoundMin();
+
+  if (parent.isSparse() || dataSourceCache) {
+    // Extract each occupied block on its own, and concatenate the results. Vertices on the faces between blocks are
+    // not shared, and the surface ends where it leaves the occupied blocks. With a data source, the blocks are the
+    // bricks which the slice planes leave, read through the cache.
+    glm::uvec3 cellDim = parent.getGridCellDim();
+    glm::uvec3 brickDim = (cellDim + VolumeGrid::sparseBlockSize - 1u) / VolumeGrid::sparseBlockSize;
+    uint32_t blockNodes = VolumeGrid::sparseBlockSize + 1;
+    size_t perBlock = static_cast<size_t>(blockNodes) * blockNodes * blockNodes;
+    std::vector<glm::uvec3> blocks;
+    if (dataSourceCache) {
+      for (int64_t iBrick : parent.getResidentSlotBricks()) {
+        if (iBrick < 0) continue;
+        blocks.push_back(glm::uvec3{static_cast<uint32_t>(iBrick % brickDim.x),
+                                    static_cast<uint32_t>((iBrick / brickDim.x) % brickDim.y),
+                                    static_cast<uint32_t>(iBrick / (static_cast<int64_t>(brickDim.x) * brickDim.y))});
+      }
+    } else {
+      blocks = parent.getOccupiedBlocks();
+    }
+
+    size_t nChunks = parallelChunkCount(blocks.size(), 16);
+    std::vector<std::vector<glm::vec3>> chunkVertices(nChunks);
+    std::vector<std::vector<uint32_t>> chunkIndices(nChunks);
+    parallelForChunks(0, blocks.size(), nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+      std::vector<float> blockField;
+      std::vector<float> sourceBlock(dataSourceCache ? perBlock : 0);
+      std::vector<glm::vec3> blockVertices;
+      std::vector<uint32_t> blockIndices;
+      for (size_t iBlock = begin; iBlock < end; iBlock++) {
+        const float* blockValues;
+        if (dataSourceCache) {
+          glm::uvec3 b = blocks[iBlock];
+          dataSourceCache->readBrick((static_cast<int64_t>(b.z) * brickDim.y + b.y) * brickDim.x + b.x,
+                                     sourceBlock.data());
+          blockValues = sourceBlock.data();
+        } else {
+          blockValues = &fieldData[iBlock * perBlock];
+        }
+
+        // crop blocks which extend past the grid
+        glm::uvec3 origin = blocks[iBlock] * VolumeGrid::sparseBlockSize;
+        glm::uvec3 extent = glm::min(origin + VolumeGrid::sparseBlockSize, cellDim) - origin + 1u;
+        blockField.resize(static_cast<size_t>(extent.x) * extent.y * extent.z);
+        for (uint32_t z = 0; z < extent.z; z++) {
+          for (uint32_t y = 0; y < extent.y; y++) {
+            for (uint32_t x = 0; x < extent.x; x++) {
+              blockField[(static_cast<size_t>(z) * extent.y + y) * extent.x + x] =
+                  blockValues[(static_cast<size_t>(z) * blockNodes + y) * blockNodes + x];
+            }
+          }
+        }
+
+        // the MC lib indexes z-fastest, so the dimensions are passed reversed and the vertices swizzled back
+        marchingCubes(blockField.data(), isosurfaceLevel.get(), extent.z, extent.y, extent.x, blockVertices,
+                      blockIndices);
+        uint32_t indexOffset = static_cast<uint32_t>(chunkVertices[iChunk].size());
+        for (const glm::vec3& p : blockVertices) {
+          chunkVertices[iChunk].push_back((glm::vec3{p.z, p.y, p.x} + glm::vec3(origin)) * scale + boundMin);
+        }
+        for (uint32_t i : blockIndices) {
+          chunkIndices[iChunk].push_back(i + indexOffset);
+        }
+      }
+    });
+
+    isosurfaceMeshVertices.clear();
+    isosurfaceMeshIndices.clear();
+    for (size_t iChunk = 0; iChunk < nChunks; iChunk++) {
+      uint32_t indexOffset = static_cast<uint32_t>(isosurfaceMeshVertices.size());
+      isosurfaceMeshVertices.insert(isosurfaceMeshVertices.end(), chunkVertices[iChunk].begin(),
+                                    chunkVertices[iChunk].end());
+      for (uint32_t i : chunkIndices[iChunk]) {
+        isosurfaceMeshIndices.push_back(i + indexOffset);
+      }
+    }
+
+  } else {
+    // the MC lib indexes z-fastest, so the dimensions are passed reversed. Its slabs along our z are kept, and region
+    // updates only invalidate the slabs they touch.
+    glm::uvec3 dim = parent.getGridNodeDim();
+
+    // unless only a few slabs are being patched after a region update, the whole surface may be in the disk cache
+    const char* vertexCacheKind = "VolumeGrid.isosurfaceVertices";
+    const char* indexCacheKind = "VolumeGrid.isosurfaceIndices";
+    bool wholeSurface = isosurfaceMeshDataVersion != values.getDataVersion() ||
+                        isosurfaceMeshLevel != isosurfaceLevel.get() || isosurfaceMeshVertices.empty();
+    uint64_t inputHash = 0;
+    if (wholeSurface && derivedDataCacheEnabled()) {
+      inputHash = ContentHash()
+                      .add(fieldData)
+                      .addValue(dim)
+                      .addValue(isosurfaceLevel.get())
+                      .addValue(scale)
+                      .addValue(boundMin)
+                      .get();
+      if (loadDerivedData(vertexCacheKind, inputHash, isosurfaceMeshVertices) &&
+          loadDerivedData(indexCacheKind, inputHash, isosurfaceMeshIndices)) {
+        isosurfaceSlabs.invalidate(); // they do not match the loaded surface, later patches extract everything again
+        isosurfaceMeshValid = true;
+        isosurfaceMeshLevel = isosurfaceLevel.get();
+        isosurfaceMeshDataVersion = values.getDataVersion();
+        isosurfaceMeshResidencyVersion = parent.getBrickResidencyVersion();
+        return;
+      }
+    }
+
+    if (isosurfaceMeshDataVersion != values.getDataVersion()) {
+      isosurfaceSlabs.invalidate();
+    }
+    isosurfaceSlabs.extract(fieldData.data(), isosurfaceLevel.get(), dim.z, dim.y, dim.x, isosurfaceMeshVertices,
+                            isosurfaceMeshIndices);
+
+    // Transform the result to be aligned with our volume's spatial layout
+    parallelFor(0, isosurfaceMeshVertices.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        // swizzle to account for change of coordinate/buffer ordering in the MC lib
+        glm::vec3& p = isosurfaceMeshVertices[i];
+        p = glm::vec3{p.z, p.y, p.x} * scale + boundMin;
+      }
+    });
+
+    if (wholeSurface) {
+      storeDerivedData(vertexCacheKind, inputHash, isosurfaceMeshVertices);
+      storeDerivedData(indexCacheKind, inputHash, isosurfaceMeshIndices);
+    }
   }
 
-  std::vector<std::string> isoProgramRules{"SHADE_BASECOLOR", "PROJ_AND_INV_PROJ_MAT",
-                                           "COMPUTE_SHADE_NORMAL_FROM_POSITION"};
+  isosurfaceMeshValid = true;
+  isosurfaceMeshLevel = isosurfaceLevel.get();
+  isosurfaceMeshDataVersion = values.getDataVersion();
+  isosurfaceMeshResidencyVersion = parent.getBrickResidencyVersion();
+}
+
+void VolumeGridNodeScalarQuantity::updateRegion(glm::uvec3 offset, glm::uvec3 extent,
+                                                const std::vector<float>& newValues) {
+  glm::uvec3 nodeDim = parent.getGridNodeDim();
+  checkValueRegion(parent, name, hasDataSource(), nodeDim, offset, extent, newValues.size());
+  if (newValues.empty()) return;
+
+  // the pool and isosurface are patched if they were current, rather than rebuilt
+  uint64_t oldDataVersion = values.getDataVersion();
+  bool poolCurrent = sparseValueTexture && sparseValueTextureDataVersion == oldDataVersion;
+  bool isosurfaceCurrent = isosurfaceMeshDataVersion == oldDataVersion;
+
+  updateDataBox(nodeDim, offset, extent, newValues);
+
+  if (poolCurrent) {
+    // nodes on the faces between bricks are in both
+    uint32_t slotSize = VolumeGrid::sparseBlockSize + 1;
+    glm::uvec3 brickDim = (parent.getGridCellDim() + VolumeGrid::sparseBlockSize - 1u) / VolumeGrid::sparseBlockSize;
+    glm::uvec3 brickLow = (glm::max(offset, 1u) - 1u) / VolumeGrid::sparseBlockSize;
+    glm::uvec3 brickHigh = glm::min((offset + extent - 1u) / VolumeGrid::sparseBlockSize, brickDim - 1u);
+    BrickGatherer gather = denseBrickGatherer(parent, nullptr, values, nodeDim, slotSize);
+    refreshDenseBrickPoolTexture(parent, gather, slotSize, *sparseValueTexture, brickPoolSlotBricks, brickLow,
+                                 brickHigh);
+    sparseValueTextureDataVersion = values.getDataVersion();
+  }
+
+  if (isosurfaceCurrent) {
+    isosurfaceSlabs.invalidateNodePlanes(offset.z, offset.z + extent.z);
+    isosurfaceMeshDataVersion = values.getDataVersion();
+    isosurfaceMeshValid = false;
+    isosurfaceProgram.reset();
+  }
+}
+
+std::vector<std::string> VolumeGridNodeScalarQuantity::addIsosurfaceRules(std::vector<std::string> initRules) {
+  initRules.insert(initRules.begin(), "SHADE_BASECOLOR");
   if (getSlicePlanesAffectIsosurface() && render::engine->slicePlanesEnabled()) {
-    isoProgramRules.push_back("GENERATE_VIEW_POS");
-    isoProgramRules.push_back("CULL_POS_FROM_VIEW");
+    initRules.push_back("GENERATE_VIEW_POS");
+    initRules.push_back("CULL_POS_FROM_VIEW");
   }
+  return render::engine->addMaterialRules(parent.getMaterial(), parent.addStructureRules(initRules));
+}
+
+void VolumeGridNodeScalarQuantity::createIsosurfaceProgram() {
+
+  ensureIsosurfaceMeshExtracted();
 
   // Create a render program to draw it
   // clang-format off
   isosurfaceProgram = render::engine->requestShader("SIMPLE_MESH",
-      render::engine->addMaterialRules(parent.getMaterial(), 
-        parent.addStructureRules(
-          isoProgramRules
-        )
-      ),
+      addIsosurfaceRules({"PROJ_AND_INV_PROJ_MAT", "COMPUTE_SHADE_NORMAL_FROM_POSITION"}),
     getSlicePlanesAffectIsosurface() ? 
      render::ShaderReplacementDefaults::SceneObject :
      render::ShaderReplacementDefaults::SceneObjectNoSlice
@@ -197,15 +830,62 @@ void VolumeGridNodeScalarQuantity::createIsosurfaceProgram() {
   // clang-format on
 
   // Populate the program buffers with the extracted mesh
-  isosurfaceProgram->setAttribute("a_vertexPositions", isosurfaceMesh.vertices);
+  isosurfaceProgram->setAttribute("a_vertexPositions", isosurfaceMeshVertices);
   std::shared_ptr<render::AttributeBuffer> indexBuff = render::engine->generateAttributeBuffer(RenderDataType::UInt);
-  indexBuff->setData(isosurfaceMesh.indices);
+  indexBuff->setData(isosurfaceMeshIndices);
   isosurfaceProgram->setIndex(indexBuff);
 
 
   render::engine->setMaterial(*isosurfaceProgram, parent.getMaterial());
 }
 
+void VolumeGridNodeScalarQuantity::createIsosurfaceRaymarchProgram() {
+
+  // clang-format off
+  isosurfaceRaymarchProgram = render::engine->requestShader("GRID_ISOSURFACE_RAYMARCH",
+      addIsosurfaceRules({}),
+    getSlicePlanesAffectIsosurface() ? 
+     render::ShaderReplacementDefaults::SceneObject :
+     render::ShaderReplacementDefaults::SceneObjectNoSlice
+    );
+  // clang-format on
+
+  isosurfaceRaymarchProgram->setAttribute("a_referencePosition", gridBoxReferenceTriangles());
+
+  isosurfaceRaymarchProgram->setTextureFromBuffer("t_value", values.getRenderTextureBuffer().get());
+  values.getRenderTextureBuffer().get()->setFilterMode(FilterMode::Linear);
+  render::engine->setMaterial(*isosurfaceRaymarchProgram, parent.getMaterial());
+}
+
+void VolumeGridNodeScalarQuantity::drawIsosurfaceRaymarched() {
+  if (isosurfaceRaymarchProgram == nullptr) {
+    createIsosurfaceRaymarchProgram();
+  }
+
+  parent.setStructureUniforms(*isosurfaceRaymarchProgram);
+  render::engine->setMaterialUniforms(*isosurfaceRaymarchProgram, parent.getMaterial());
+  isosurfaceRaymarchProgram->setUniform("u_baseColor", getIsosurfaceColor());
+  isosurfaceRaymarchProgram->setUniform("u_boundMin", parent.getBoundMin());
+  isosurfaceRaymarchProgram->setUniform("u_boundMax", parent.getBoundMax());
+  isosurfaceRaymarchProgram->setUniform("u_gridNodeDim", glm::vec3(parent.getGridNodeDim()));
+  isosurfaceRaymarchProgram->setUniform("u_isoLevel", isosurfaceLevel.get());
+
+  glm::mat4 P = view::getCameraPerspectiveMatrix();
+  glm::mat4 Pinv = glm::inverse(P);
+  isosurfaceRaymarchProgram->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
+  isosurfaceRaymarchProgram->setUniform("u_viewport", render::engine->getCurrentViewport());
+
+  isosurfaceRaymarchProgram->setUniform("u_viewToReference", glm::value_ptr(gridViewToReference(parent)));
+
+  render::engine->setBackfaceCull(false);
+  isosurfaceRaymarchProgram->draw();
+}
+
+void VolumeGridNodeScalarQuantity::createVolumeProgram() {
+  volumeProgram = createGridVolumeProgram(parent, values, parent.getGridNodeDim(), cMap.get(), volumeBrickTexture);
+  volumeProgramDataVersion = values.getDataVersion();
+}
+
 SurfaceMesh* VolumeGridNodeScalarQuantity::registerIsosurfaceAsMesh(std::string structureName) {
 
   // set the name to default
@@ -213,24 +893,46 @@ SurfaceMesh* VolumeGridNodeScalarQuantity::registerIsosurfaceAsMesh(std::string
     structureName = parent.name + " - " + name + " - isosurface";
   }
 
-  // extract the mesh
-  MC::mcMesh isosurfaceMesh;
-  MC::marching_cube(&values.data.front(), isosurfaceLevel.get(), parent.getGridNodeDim().x, parent.getGridNodeDim().y,
-                    parent.getGridNodeDim().z, isosurfaceMesh);
-  glm::vec3 scale = parent.gridSpacing();
-  for (auto& p : isosurfaceMesh.vertices) {
-    // swizzle to account for change of coordinate/buffer ordering in the MC lib
-    p = glm::vec3{p.z, p.y, p.x} * scale + parent.getBoundMin();
-  }
+  checkInitialized();
+  ensureIsosurfaceMeshExtracted();
 
-  return registerSurfaceMesh(structureName, isosurfaceMesh.vertices,
-                             std::make_tuple(isosurfaceMesh.indices.data(), isosurfaceMesh.indices.size() / 3, 3));
+  // The cached mesh is moved in to the new mesh, which stores the same flat triangle indices. The isosurface program
+  // keeps drawing from its own buffers, and the mesh is only extracted again if the program has to be rebuilt.
+  size_t nTri = isosurfaceMeshIndices.size() / 3;
+  std::vector<uint32_t> faceIndsStart(nTri + 1);
+  parallelFor(0, faceIndsStart.size(), [&](size_t begin, size_t end) {
+    for (size_t iF = begin; iF < end; iF++) {
+      faceIndsStart[iF] = static_cast<uint32_t>(3 * iF);
+    }
+  });
+  SurfaceMesh* s = new SurfaceMesh(structureName, std::move(isosurfaceMeshVertices), std::move(isosurfaceMeshIndices),
+                                   std::move(faceIndsStart));
+  isosurfaceMeshVertices.clear();
+  isosurfaceMeshIndices.clear();
+  isosurfaceMeshValid = false;
+
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
 }
 
 void VolumeGridNodeScalarQuantity::buildNodeInfoGUI(size_t ind) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
-  ImGui::Text("%g", values.getValue(ind));
+  if (parent.isSparse()) {
+    int64_t dataInd = parent.sparseNodeDataIndex(parent.unflattenNodeIndex(ind));
+    if (dataInd < 0) {
+      ImGui::TextUnformatted("(empty)");
+    } else {
+      ImGui::Text("%g", values.getValue(dataInd));
+    }
+  } else if (dataSourceCache) {
+    ImGui::Text("%g", dataSourceCache->readValue(parent.unflattenNodeIndex(ind)));
+  } else {
+    ImGui::Text("%g", values.getValue(ind));
+  }
   ImGui::NextColumn();
 }
 
@@ -268,11 +970,72 @@ glm::vec3 VolumeGridNodeScalarQuantity::getIsosurfaceColor() { return isosurface
 VolumeGridNodeScalarQuantity* VolumeGridNodeScalarQuantity::setSlicePlanesAffectIsosurface(bool val) {
   slicePlanesAffectIsosurface = val;
   isosurfaceProgram.reset(); // delete the program so it gets recreated with the new value
+  isosurfaceRaymarchProgram.reset();
   requestRedraw();
   return this;
 }
 bool VolumeGridNodeScalarQuantity::getSlicePlanesAffectIsosurface() { return slicePlanesAffectIsosurface.get(); }
 
+VolumeGridNodeScalarQuantity* VolumeGridNodeScalarQuantity::setIsosurfaceRaymarched(bool val) {
+  if (val && parent.isBricked()) {
+    exception("isosurface raymarching is not supported on sparse or bricked volume grids");
+  }
+  isosurfaceRaymarched = val;
+  requestRedraw();
+  return this;
+}
+bool VolumeGridNodeScalarQuantity::getIsosurfaceRaymarched() { return isosurfaceRaymarched.get(); }
+
+VolumeGridNodeScalarQuantity* VolumeGridNodeScalarQuantity::setVolumeVizEnabled(bool val) {
+  if (val && parent.isBricked()) {
+    exception("volume rendering is not supported on sparse or bricked volume grids");
+  }
+  volumeVizEnabled = val;
+  requestRedraw();
+  return this;
+}
+bool VolumeGridNodeScalarQuantity::getVolumeVizEnabled() { return volumeVizEnabled.get(); }
+
+VolumeGridNodeScalarQuantity* VolumeGridNodeScalarQuantity::setVolumeDensity(float val) {
+  volumeDensity = val;
+  requestRedraw();
+  return this;
+}
+float VolumeGridNodeScalarQuantity::getVolumeDensity() { return volumeDensity.get(); }
+
+bool VolumeGridNodeScalarQuantity::hasDataSource() const { return dataSourceCache != nullptr; }
+
+VolumeGridNodeScalarQuantity* VolumeGridNodeScalarQuantity::setDataCacheBudget(size_t bytes) {
+  if (!dataSourceCache) {
+    exception("quantity " + name + " does not have a data source");
+  }
+  dataSourceCache->setBudget(bytes);
+  return this;
+}
+size_t VolumeGridNodeScalarQuantity::getDataCacheBudget() {
+  return dataSourceCache ? dataSourceCache->getBudget() : VolumeGridBrickCache::defaultBudget;
+}
+
+void VolumeGridNodeScalarQuantity::ensureSourceHistogramBuilt() {
+  histogramStale = false; // buildScalarUI() would count the empty values
+
+  // rebuilt from the bricks cached so far, when more have been read
+  uint64_t readCount = dataSourceCache->getReadCount();
+  bool built = lastHistogramBuild > -1e30;
+  if (built && readCount == histogramReadCount) return;
+  if (built && ImGui::GetTime() - lastHistogramBuild < options::histogramRebuildPeriod) return;
+
+  std::vector<float> cachedValues;
+  dataSourceCache->gatherCachedValues(cachedValues);
+  if (cachedValues.empty()) {
+    hist.buildHistogramFromCounts(std::vector<double>(hist.getBinCount(), 1.), dataFiniteRange);
+  } else {
+    hist.buildHistogram(cachedValues.data(), cachedValues.size(), dataFiniteRange);
+  }
+  histogramReadCount = readCount;
+  lastHistogramBuild = ImGui::GetTime();
+}
+
 // ========================================================
 // ==========            Cell Scalar             ==========
 // ========================================================
@@ -280,9 +1043,30 @@ bool VolumeGridNodeScalarQuantity::getSlicePlanesAffectIsosurface() { return sli
 VolumeGridCellScalarQuantity::VolumeGridCellScalarQuantity(std::string name, VolumeGrid& grid_,
                                                            const std::vector<float>& values_, DataType dataType_)
     : VolumeGridQuantity(name, grid_, true), ScalarQuantity(*this, values_, dataType_),
-      gridcubeVizEnabled(parent.uniquePrefix() + "#" + name + "#gridcubeVizEnabled", true) {
+      gridcubeVizEnabled(parent.uniquePrefix() + "#" + name + "#gridcubeVizEnabled", true),
+      volumeVizEnabled(parent.uniquePrefix() + "#" + name + "#volumeVizEnabled", false),
+      volumeDensity(parent.uniquePrefix() + "#" + name + "#volumeDensity", 10.f) {
+
+  // sparse values are drawn from a pool texture instead, see createGridcubeProgram()
+  if (!parent.isSparse()) {
+    values.setTextureSize(parent.getGridCellDim().x, parent.getGridCellDim().y, parent.getGridCellDim().z);
+  }
+}
 
-  values.setTextureSize(parent.getGridCellDim().x, parent.getGridCellDim().y, parent.getGridCellDim().z);
+VolumeGridCellScalarQuantity::VolumeGridCellScalarQuantity(std::string name, VolumeGrid& grid_,
+                                                           std::shared_ptr<VolumeGridDataSource> source,
+                                                           std::pair<double, double> valueRange, DataType dataType_)
+    : VolumeGridCellScalarQuantity(name, grid_, std::vector<float>(), dataType_) {
+  glm::uvec3 brickDim = (parent.getGridCellDim() + VolumeGrid::sparseBlockSize - 1u) / VolumeGrid::sparseBlockSize;
+  dataSourceCache.reset(
+      new VolumeGridBrickCache(source, parent.getGridCellDim(), brickDim, VolumeGrid::sparseBlockSize));
+
+  // computing the range would read every value
+  dataFiniteRange = valueRange;
+  dataRange = robustRange(valueRange, 1e-5);
+  dataRangeComputed = true;
+  setDefaultsFromDataRange();
+  compactPoolEncoding(source->getValueType(), poolFormat, poolValueScale, poolValueOffset);
 }
 
 
@@ -297,6 +1081,9 @@ void VolumeGridCellScalarQuantity::buildCustomUI() {
     // show toggles for each
     // ImGui::Indent(20);
     if (ImGui::MenuItem("Gridcube", NULL, &gridcubeVizEnabled.get())) setGridcubeVizEnabled(getGridcubeVizEnabled());
+    if (!parent.isBricked()) {
+      if (ImGui::MenuItem("Volume", NULL, &volumeVizEnabled.get())) setVolumeVizEnabled(getVolumeVizEnabled());
+    }
     // ImGui::Indent(-20);
     ImGui::EndPopup();
   }
@@ -312,22 +1099,54 @@ void VolumeGridCellScalarQuantity::buildCustomUI() {
     ImGui::EndPopup();
   }
 
-  if (gridcubeVizEnabled.get()) {
+  if (gridcubeVizEnabled.get() || volumeVizEnabled.get()) {
+    if (dataSourceCache) ensureSourceHistogramBuilt();
     buildScalarUI();
   }
+
+  if (volumeVizEnabled.get()) {
+    ImGui::TextUnformatted("Volume:");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(120);
+    if (ImGui::SliderFloat("density", &volumeDensity.get(), 0.1, 1000., "%.2f",
+                           ImGuiSliderFlags_Logarithmic | ImGuiSliderFlags_NoRoundToFormat)) {
+      setVolumeDensity(getVolumeDensity());
+    }
+    ImGui::PopItemWidth();
+  }
 }
 
 std::string VolumeGridCellScalarQuantity::niceName() { return name + " (cell scalar)"; }
 
 bool VolumeGridCellScalarQuantity::isDrawingGridcubes() { return isEnabled() && getGridcubeVizEnabled(); }
 
-void VolumeGridCellScalarQuantity::refresh() { gridcubeProgram.reset(); }
+void VolumeGridCellScalarQuantity::refresh() {
+  gridcubeProgram.reset();
+  volumeProgram.reset();
+  volumeBrickTexture.reset();
+  sparseValueTexture.reset();
+}
 
 void VolumeGridCellScalarQuantity::draw() {
   if (!isEnabled()) return;
 
   // Draw the point viz
   if (gridcubeVizEnabled.get()) {
+    if (gridcubeProgram && sparseValueTexture && sparseValueTextureDataVersion != values.getDataVersion()) {
+      gridcubeProgram.reset(); // the values were updated, and need to be copied to the pool texture again
+    }
+    if (gridcubeProgram && sparseValueTexture && !parent.isSparse() &&
+        brickPoolResidencyVersion != parent.getBrickResidencyVersion()) {
+      // page in the bricks which the slice planes uncovered
+      uint32_t slotSize = VolumeGrid::sparseBlockSize;
+      BrickGatherer gather =
+          denseBrickGatherer(parent, dataSourceCache.get(), values, parent.getGridCellDim(), slotSize, poolValueScale,
+                             poolValueOffset);
+      if (!updateDenseBrickPoolTexture(parent, gather, slotSize, *sparseValueTexture, brickPoolSlotBricks)) {
+        gridcubeProgram.reset();
+      }
+      brickPoolResidencyVersion = parent.getBrickResidencyVersion();
+    }
     if (gridcubeProgram == nullptr) {
       createGridcubeProgram();
     }
@@ -336,6 +1155,10 @@ void VolumeGridCellScalarQuantity::draw() {
     parent.setStructureUniforms(*gridcubeProgram);
     parent.setGridCubeUniforms(*gridcubeProgram);
     setScalarUniforms(*gridcubeProgram);
+    if (parent.isBricked()) {
+      gridcubeProgram->setUniform("u_valueScale", poolValueScale);
+      gridcubeProgram->setUniform("u_valueOffset", poolValueOffset);
+    }
     render::engine->setMaterialUniforms(*gridcubeProgram, parent.getMaterial());
 
     // Draw the actual grid
@@ -344,6 +1167,22 @@ void VolumeGridCellScalarQuantity::draw() {
   }
 }
 
+void VolumeGridCellScalarQuantity::drawDelayed() {
+  if (!isEnabled()) return;
+
+  // The volume is translucent, so it is composited over everything drawn in the main phase
+  if (volumeVizEnabled.get()) {
+    if (volumeProgram && volumeProgramDataVersion != values.getDataVersion()) {
+      volumeProgram.reset(); // the values were updated
+    }
+    if (volumeProgram == nullptr) {
+      createVolumeProgram();
+    }
+    setColorMapUniforms(*volumeProgram);
+    drawGridVolumeProgram(*volumeProgram, parent, parent.getGridCellDim(), false, getMapRange(), getVolumeDensity());
+  }
+}
+
 void VolumeGridCellScalarQuantity::createGridcubeProgram() {
 
 
@@ -352,7 +1191,7 @@ void VolumeGridCellScalarQuantity::createGridcubeProgram() {
       render::engine->addMaterialRules(parent.getMaterial(),
         parent.addGridCubeRules(
           addScalarRules(
-            {"GRIDCUBE_PROPAGATE_CELL_VALUE"}
+            {parent.isBricked() ? "GRIDCUBE_PROPAGATE_SPARSE_CELL_VALUE" : "GRIDCUBE_PROPAGATE_CELL_VALUE"}
           ), 
         true)
       )
@@ -366,14 +1205,67 @@ void VolumeGridCellScalarQuantity::createGridcubeProgram() {
   gridcubeProgram->setTextureFromColormap("t_colormap", cMap.get());
   render::engine->setMaterial(*gridcubeProgram, parent.getMaterial());
 
-  gridcubeProgram->setTextureFromBuffer("t_value", values.getRenderTextureBuffer().get());
-  values.getRenderTextureBuffer().get()->setFilterMode(FilterMode::Linear);
+  if (parent.isBricked()) {
+    if (parent.isSparse()) {
+      sparseValueTexture = generateSparsePoolTexture(values.getPopulatedHostBufferRef(), parent.nOccupiedBlocks(),
+                                                     VolumeGrid::sparseBlockSize);
+    } else {
+      uint32_t slotSize = VolumeGrid::sparseBlockSize;
+      BrickGatherer gather =
+          denseBrickGatherer(parent, dataSourceCache.get(), values, parent.getGridCellDim(), slotSize, poolValueScale,
+                             poolValueOffset);
+      sparseValueTexture = generateDenseBrickPoolTexture(parent, gather, slotSize, poolFormat, brickPoolSlotBricks);
+      brickPoolResidencyVersion = parent.getBrickResidencyVersion();
+    }
+    sparseValueTextureDataVersion = values.getDataVersion();
+    gridcubeProgram->setTextureFromBuffer("t_value", sparseValueTexture.get());
+  } else {
+    gridcubeProgram->setTextureFromBuffer("t_value", values.getRenderTextureBuffer().get());
+    values.getRenderTextureBuffer().get()->setFilterMode(FilterMode::Linear);
+  }
+}
+
+void VolumeGridCellScalarQuantity::updateRegion(glm::uvec3 offset, glm::uvec3 extent,
+                                                const std::vector<float>& newValues) {
+  glm::uvec3 cellDim = parent.getGridCellDim();
+  checkValueRegion(parent, name, hasDataSource(), cellDim, offset, extent, newValues.size());
+  if (newValues.empty()) return;
+
+  bool poolCurrent = sparseValueTexture && sparseValueTextureDataVersion == values.getDataVersion();
+
+  updateDataBox(cellDim, offset, extent, newValues);
+
+  if (poolCurrent) {
+    uint32_t slotSize = VolumeGrid::sparseBlockSize;
+    glm::uvec3 brickLow = offset / VolumeGrid::sparseBlockSize;
+    glm::uvec3 brickHigh = (offset + extent - 1u) / VolumeGrid::sparseBlockSize;
+    BrickGatherer gather = denseBrickGatherer(parent, nullptr, values, cellDim, slotSize);
+    refreshDenseBrickPoolTexture(parent, gather, slotSize, *sparseValueTexture, brickPoolSlotBricks, brickLow,
+                                 brickHigh);
+    sparseValueTextureDataVersion = values.getDataVersion();
+  }
+}
+
+void VolumeGridCellScalarQuantity::createVolumeProgram() {
+  volumeProgram = createGridVolumeProgram(parent, values, parent.getGridCellDim(), cMap.get(), volumeBrickTexture);
+  volumeProgramDataVersion = values.getDataVersion();
 }
 
 void VolumeGridCellScalarQuantity::buildCellInfoGUI(size_t ind) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
-  ImGui::Text("%g", values.getValue(ind));
+  if (parent.isSparse()) {
+    int64_t dataInd = parent.sparseCellDataIndex(parent.unflattenCellIndex(ind));
+    if (dataInd < 0) {
+      ImGui::TextUnformatted("(empty)");
+    } else {
+      ImGui::Text("%g", values.getValue(dataInd));
+    }
+  } else if (dataSourceCache) {
+    ImGui::Text("%g", dataSourceCache->readValue(parent.unflattenCellIndex(ind)));
+  } else {
+    ImGui::Text("%g", values.getValue(ind));
+  }
   ImGui::NextColumn();
 }
 
@@ -386,5 +1278,55 @@ VolumeGridCellScalarQuantity* VolumeGridCellScalarQuantity::setGridcubeVizEnable
 }
 bool VolumeGridCellScalarQuantity::getGridcubeVizEnabled() { return gridcubeVizEnabled.get(); }
 
+VolumeGridCellScalarQuantity* VolumeGridCellScalarQuantity::setVolumeVizEnabled(bool val) {
+  if (val && parent.isBricked()) {
+    exception("volume rendering is not supported on sparse or bricked volume grids");
+  }
+  volumeVizEnabled = val;
+  requestRedraw();
+  return this;
+}
+bool VolumeGridCellScalarQuantity::getVolumeVizEnabled() { return volumeVizEnabled.get(); }
+
+VolumeGridCellScalarQuantity* VolumeGridCellScalarQuantity::setVolumeDensity(float val) {
+  volumeDensity = val;
+  requestRedraw();
+  return this;
+}
+float VolumeGridCellScalarQuantity::getVolumeDensity() { return volumeDensity.get(); }
+
+bool VolumeGridCellScalarQuantity::hasDataSource() const { return dataSourceCache != nullptr; }
+
+VolumeGridCellScalarQuantity* VolumeGridCellScalarQuantity::setDataCacheBudget(size_t bytes) {
+  if (!dataSourceCache) {
+    exception("quantity " + name + " does not have a data source");
+  }
+  dataSourceCache->setBudget(bytes);
+  return this;
+}
+size_t VolumeGridCellScalarQuantity::getDataCacheBudget() {
+  return dataSourceCache ? dataSourceCache->getBudget() : VolumeGridBrickCache::defaultBudget;
+}
+
+void VolumeGridCellScalarQuantity::ensureSourceHistogramBuilt() {
+  histogramStale = false; // buildScalarUI() would count the empty values
+
+  // rebuilt from the bricks cached so far, when more have been read
+  uint64_t readCount = dataSourceCache->getReadCount();
+  bool built = lastHistogramBuild > -1e30;
+  if (built && readCount == histogramReadCount) return;
+  if (built && ImGui::GetTime() - lastHistogramBuild < options::histogramRebuildPeriod) return;
+
+  std::vector<float> cachedValues;
+  dataSourceCache->gatherCachedValues(cachedValues);
+  if (cachedValues.empty()) {
+    hist.buildHistogramFromCounts(std::vector<double>(hist.getBinCount(), 1.), dataFiniteRange);
+  } else {
+    hist.buildHistogram(cachedValues.data(), cachedValues.size(), dataFiniteRange);
+  }
+  histogramReadCount = readCount;
+  lastHistogramBuild = ImGui::GetTime();
+}
+
 
 } // namespace polyscope
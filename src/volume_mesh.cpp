@@ -3,24 +3,93 @@
 #include "polyscope/volume_mesh.h"
 
 #include "polyscope/color_management.h"
-#include "polyscope/combining_hash_functions.h"
+#include "polyscope/derived_data_cache.h"
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
+#include "polyscope/slice_plane.h"
+#include "polyscope/surface_mesh.h"
+#include "polyscope/trace.h"
 #include "polyscope/utilities.h"
 #include "polyscope/volume_mesh_quantity.h"
 
 #include "imgui.h"
 
 #include <algorithm>
+#include <limits>
 #include <numeric>
-#include <unordered_map>
 #include <utility>
 
 namespace polyscope {
 
+namespace {
+
+// Faces are matched by the sorted list of their distinct vertex indices. Each index is stored plus one, so the unused
+// last entry of a triangular face is 0 and never equals a vertex.
+typedef std::array<uint32_t, 4> FaceKey;
+
+// Sort face keys, and the face indices alongside them, by a parallel least-significant-digit radix sort. Only the low
+// nBits bits of each entry may be set. Passes in which every key has the same digit are skipped, e.g. the last entry
+// of a tet mesh's faces. The scratch buffers are allocated once and swapped between passes.
+void radixSortFaceKeys(std::vector<FaceKey>& keys, std::vector<size_t>& faces, int nBits) {
+  const int maxDigitBits = 11;
+  size_t n = keys.size();
+  if (n == 0 || nBits == 0) return;
+
+  int nDigits = (nBits + maxDigitBits - 1) / maxDigitBits;
+  int digitBits = (nBits + nDigits - 1) / nDigits;
+  const size_t nBuckets = static_cast<size_t>(1) << digitBits;
+
+  std::vector<FaceKey> keysOut(n);
+  std::vector<size_t> facesOut(n);
+  size_t nChunks = parallelChunkCount(n);
+  std::vector<size_t> offsets(nChunks * nBuckets);
+
+  for (int iEntry = 3; iEntry >= 0; iEntry--) {
+    for (int shift = 0; shift < nBits; shift += digitBits) {
+      auto digit = [&](const FaceKey& key) { return (key[iEntry] >> shift) & (nBuckets - 1); };
+
+      std::fill(offsets.begin(), offsets.end(), 0);
+      parallelForChunks(0, n, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+        size_t* chunkCounts = &offsets[iChunk * nBuckets];
+        for (size_t i = begin; i < end; i++) chunkCounts[digit(keys[i])]++;
+      });
+
+      // where each chunk starts writing in each bucket: buckets in order, and chunks in order within a bucket
+      size_t sum = 0;
+      bool singleBucket = false;
+      for (size_t iB = 0; iB < nBuckets; iB++) {
+        size_t bucketStart = sum;
+        for (size_t iChunk = 0; iChunk < nChunks; iChunk++) {
+          size_t count = offsets[iChunk * nBuckets + iB];
+          offsets[iChunk * nBuckets + iB] = sum;
+          sum += count;
+        }
+        if (sum - bucketStart == n) singleBucket = true;
+      }
+      if (singleBucket) continue;
+
+      parallelForChunks(0, n, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+        size_t* chunkOffsets = &offsets[iChunk * nBuckets];
+        for (size_t i = begin; i < end; i++) {
+          size_t dst = chunkOffsets[digit(keys[i])]++;
+          keysOut[dst] = keys[i];
+          facesOut[dst] = faces[i];
+        }
+      });
+
+      keys.swap(keysOut);
+      faces.swap(facesOut);
+    }
+  }
+}
+
+} // namespace
+
 // Initialize statics
 const std::string VolumeMesh::structureTypeName = "Volume Mesh";
+const size_t VolumeMesh::tetsPerChunk = 1024;
 
 // clang-format off
 const std::vector<std::vector<std::array<size_t, 3>>> VolumeMesh::stencilTet = 
@@ -111,7 +180,6 @@ triangleFaceInds(       this, uniquePrefix() + "triangleFaceInds",    triangleFa
 triangleCellInds(       this, uniquePrefix() + "triangleCellInds",    triangleCellIndsData),
 
 // internal triangle data for rendering
-baryCoord(              this, uniquePrefix() + "baryCoord",           baryCoordData),
 edgeIsReal(             this, uniquePrefix() + "edgeIsReal",          edgeIsRealData),
 faceType(               this, uniquePrefix() + "faceType",            faceTypeData),
 
@@ -130,6 +198,7 @@ interiorColor(uniquePrefix() + "interiorColor", color.get()),
 edgeColor(uniquePrefix() + "edgeColor", glm::vec3{0., 0., 0.}), 
 material(uniquePrefix() + "material", "clay"),
 edgeWidth(uniquePrefix() + "edgeWidth", 0.), 
+exteriorOnly(uniquePrefix() + "exteriorOnly", false),
 
 // == misc values
 activeLevelSetQuantity(nullptr) 
@@ -148,200 +217,320 @@ activeLevelSetQuantity(nullptr)
   updateObjectSpaceBounds();
 }
 
+void VolumeMesh::computeCellFaceStarts(std::vector<size_t>& cellFaceStart, std::vector<size_t>& cellTriStart) const {
+
+  auto triCount = [](const std::vector<std::vector<std::array<size_t, 3>>>& stencil) {
+    size_t count = 0;
+    for (const std::vector<std::array<size_t, 3>>& face : stencil) count += face.size();
+    return count;
+  };
+  const size_t tetTris = triCount(stencilTet);
+  const size_t hexTris = triCount(stencilHex);
+
+  size_t N = cells.size();
+  cellFaceStart.resize(N + 1);
+  cellTriStart.resize(N + 1);
+  cellFaceStart[0] = 0;
+  cellTriStart[0] = 0;
+  for (size_t iC = 0; iC < N; iC++) {
+    bool isHex = cellType(iC) == VolumeCellType::HEX;
+    cellFaceStart[iC + 1] = cellFaceStart[iC] + (isHex ? stencilHex.size() : stencilTet.size());
+    cellTriStart[iC + 1] = cellTriStart[iC] + (isHex ? hexTris : tetTris);
+  }
+}
+
 void VolumeMesh::computeCounts() {
 
   // == Populate counts
-  nFacesCount = 0;
-  nFacesTriangulationCount = 0;
+  std::vector<size_t> cellFaceStart, cellTriStart;
+  computeCellFaceStarts(cellFaceStart, cellTriStart);
+  nFacesCount = cellFaceStart.back();
+  nFacesTriangulationCount = cellTriStart.back();
 
   // == Populate interior/exterior faces
-  for (size_t iC = 0; iC < nCells(); iC++) {
-    const std::array<uint32_t, 8>& cell = cells[iC];
-    VolumeCellType cellT = cellType(iC);
-    // Iterate over faces
-    for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellT)) {
-      nFacesCount++;
-      nFacesTriangulationCount += face.size();
-    }
-  }
-
-  // == Step 1: count occurences of each face
-  std::unordered_map<std::array<uint32_t, 4>, int, polyscope::hash_combine::hash<std::array<uint32_t, 4>>> faceCounts;
-
-  std::set<size_t> faceInds; // Scratch map
 
-  // Build a sorted list of the indices of this face
+  // which only depends on the cells, reuse it from an earlier session if possible
+  const char* cacheKind = "VolumeMesh.faceIsInterior";
+  uint64_t inputHash = 0;
+  if (derivedDataCacheEnabled()) {
+    inputHash = ContentHash().add(cells).get();
+    if (loadDerivedData(cacheKind, inputHash, faceIsInterior) && faceIsInterior.size() == nFacesCount) return;
+  }
 
-  // Helper to build a sorted-index array for a face
-  auto generateSortedFace = [&](const std::array<uint32_t, 8>& cell, const std::vector<std::array<size_t, 3>>& face) {
-    faceInds.clear();
-    for (const std::array<size_t, 3>& tri : face) {
-      for (int j = 0; j < 3; j++) {
-        faceInds.insert(cell[tri[j]]);
+  // == Step 1: gather a key for each face, in parallel over cells
+  std::vector<FaceKey> faceKeys(nFacesCount);
+  size_t nCellChunks = parallelChunkCount(nCells());
+  std::vector<uint32_t> chunkMaxEntry(nCellChunks, 0);
+  parallelForChunks(0, nCells(), nCellChunks, [&](size_t iChunk, size_t cellBegin, size_t cellEnd) {
+    uint32_t maxEntry = 0;
+    for (size_t iC = cellBegin; iC < cellEnd; iC++) {
+      const std::array<uint32_t, 8>& cell = cells[iC];
+      size_t iF = cellFaceStart[iC];
+
+      // Iterate over faces, building a sorted list of the distinct indices of each
+      for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellType(iC))) {
+        std::array<uint32_t, 6> faceInds;
+        size_t nInds = 0;
+        for (const std::array<size_t, 3>& tri : face) {
+          for (int j = 0; j < 3; j++) {
+            faceInds[nInds++] = cell[tri[j]];
+          }
+        }
+        std::sort(faceInds.begin(), faceInds.begin() + nInds);
+        nInds = std::unique(faceInds.begin(), faceInds.begin() + nInds) - faceInds.begin();
+
+        FaceKey key{0, 0, 0, 0};
+        for (size_t k = 0; k < nInds; k++) key[k] = faceInds[k] + 1;
+        maxEntry = std::max(maxEntry, key[nInds - 1]);
+        faceKeys[iF] = key;
+        iF++;
       }
     }
-    std::array<uint32_t, 4> sortedFace{7777, 7777, 7777, 7777};
-    int j = 0;
-    for (size_t ind : faceInds) {
-      sortedFace[j] = ind;
-      j++;
+    chunkMaxEntry[iChunk] = maxEntry;
+  });
+
+  // == Step 2: sort the keys, so matching faces are adjacent
+  uint32_t maxEntry = 0;
+  for (uint32_t m : chunkMaxEntry) maxEntry = std::max(maxEntry, m);
+  int nBits = 0;
+  while (nBits < 32 && (maxEntry >> nBits) != 0) nBits++;
+
+  std::vector<size_t> faceOrder(nFacesCount);
+  std::iota(faceOrder.begin(), faceOrder.end(), 0);
+  radixSortFaceKeys(faceKeys, faceOrder, nBits);
+
+  // == Step 3: all faces which appear more than once are interior
+  faceIsInterior.resize(nFacesCount);
+  parallelFor(0, nFacesCount, [&](size_t faceBegin, size_t faceEnd) {
+    for (size_t s = faceBegin; s < faceEnd; s++) {
+      bool matched = (s > 0 && faceKeys[s - 1] == faceKeys[s]) ||
+                     (s + 1 < nFacesCount && faceKeys[s + 1] == faceKeys[s]);
+      faceIsInterior[faceOrder[s]] = matched;
     }
-    return sortedFace;
-  };
+  });
 
-  // Iterate over cells
-  for (size_t iC = 0; iC < nCells(); iC++) {
-    const std::array<uint32_t, 8>& cell = cells[iC];
-    VolumeCellType cellT = cellType(iC);
+  storeDerivedData(cacheKind, inputHash, faceIsInterior);
+}
 
-    // Iterate over faces
-    for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellT)) {
-      std::array<uint32_t, 4> sortedFace = generateSortedFace(cell, face);
-      // Add to the count
-      if (faceCounts.find(sortedFace) == faceCounts.end()) {
-        faceCounts[sortedFace] = 0;
-      }
-      faceCounts[sortedFace]++;
-    }
+size_t VolumeMesh::computeHexTets(size_t iC, std::array<std::array<uint32_t, 4>, 6>& hexTets) const {
+  // Algorithm from
+  // https://www.researchgate.net/profile/Julien-Dompierre/publication/221561839_How_to_Subdivide_Pyramids_Prisms_and_Hexahedra_into_Tetrahedra/links/0912f509c0b7294059000000/How-to-Subdivide-Pyramids-Prisms-and-Hexahedra-into-Tetrahedra.pdf?origin=publication_detail
+  // It's a bit hard to look at but it works
+  // Uses vertex numberings to ensure consistent diagonals between faces, and keeps tet counts to 5 or 6 per hex
+  std::array<size_t, 8> sortedNumbering;
+  std::iota(sortedNumbering.begin(), sortedNumbering.end(), 0);
+  std::sort(sortedNumbering.begin(), sortedNumbering.end(),
+            [this, iC](size_t a, size_t b) -> bool { return cells[iC][a] < cells[iC][b]; });
+  std::array<size_t, 8> rotatedNumbering;
+  std::copy(rotationMap[sortedNumbering[0]].begin(), rotationMap[sortedNumbering[0]].end(), rotatedNumbering.begin());
+  size_t n = 0;
+  size_t diagCount = 0;
+  // Diagonal exists on the pair of vertices which contain the minimum vertex number
+  auto checkDiagonal = [this, &rotatedNumbering, iC](size_t a1, size_t a2, size_t b1, size_t b2) {
+    return (cells[iC][rotatedNumbering[a1]] < cells[iC][rotatedNumbering[b1]] &&
+            cells[iC][rotatedNumbering[a1]] < cells[iC][rotatedNumbering[b2]]) ||
+           (cells[iC][rotatedNumbering[a2]] < cells[iC][rotatedNumbering[b1]] &&
+            cells[iC][rotatedNumbering[a2]] < cells[iC][rotatedNumbering[b2]]);
+  };
+  // Minimum vertex will always have 3 diagonals, check other three faces
+  if (checkDiagonal(1, 7, 2, 5)) {
+    n += 4;
+    diagCount++;
+  }
+  if (checkDiagonal(3, 7, 2, 6)) {
+    n += 2;
+    diagCount++;
+  }
+  if (checkDiagonal(4, 7, 5, 6)) {
+    n += 1;
+    diagCount++;
+  }
+  // Rotate by 120 or 240 degrees depending on diagonal positions
+  if (n == 1 || n == 6) {
+    size_t temp = rotatedNumbering[1];
+    rotatedNumbering[1] = rotatedNumbering[4];
+    rotatedNumbering[4] = rotatedNumbering[3];
+    rotatedNumbering[3] = temp;
+    temp = rotatedNumbering[5];
+    rotatedNumbering[5] = rotatedNumbering[6];
+    rotatedNumbering[6] = rotatedNumbering[2];
+    rotatedNumbering[2] = temp;
+  } else if (n == 2 || n == 5) {
+    size_t temp = rotatedNumbering[1];
+    rotatedNumbering[1] = rotatedNumbering[3];
+    rotatedNumbering[3] = rotatedNumbering[4];
+    rotatedNumbering[4] = temp;
+    temp = rotatedNumbering[5];
+    rotatedNumbering[5] = rotatedNumbering[2];
+    rotatedNumbering[2] = rotatedNumbering[6];
+    rotatedNumbering[6] = temp;
   }
 
-  // Iterate a second time; all faces which were seen more than once are inteior
-  faceIsInterior.clear();
-  for (size_t iC = 0; iC < nCells(); iC++) {
-    const std::array<uint32_t, 8>& cell = cells[iC];
-    VolumeCellType cellT = cellType(iC);
-
-    // Iterate over faces
-    for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellT)) {
-      std::array<uint32_t, 4> sortedFace = generateSortedFace(cell, face);
-      faceIsInterior.push_back(faceCounts[sortedFace] > 1);
+  // Map final tets according to diagonalMap and the number of diagonals not incident to V_0
+  const std::array<std::array<size_t, 4>, 6>& tetMap = diagonalMap[diagCount];
+  size_t tetCount = diagCount == 0 ? 5 : 6;
+  for (size_t k = 0; k < tetCount; k++) {
+    for (size_t i = 0; i < 4; i++) {
+      hexTets[k][i] = cells[iC][rotatedNumbering[tetMap[k][i]]];
     }
   }
+  return tetCount;
 }
 
-
 void VolumeMesh::computeTets() {
-  // Algorithm from
-  // https://www.researchgate.net/profile/Julien-Dompierre/publication/221561839_How_to_Subdivide_Pyramids_Prisms_and_Hexahedra_into_Tetrahedra/links/0912f509c0b7294059000000/How-to-Subdivide-Pyramids-Prisms-and-Hexahedra-into-Tetrahedra.pdf?origin=publication_detail
-  // It's a bit hard to look at but it works
-  // Uses vertex numberings to ensure consistent diagonals between faces, and keeps tet counts to 5 or 6 per hex
-  size_t tetCount = 0;
-  // Get number of tets first
-  for (size_t iC = 0; iC < nCells(); iC++) {
-    switch (cellType(iC)) {
-    case VolumeCellType::HEX: {
-      std::array<size_t, 8> sortedNumbering;
-      std::iota(sortedNumbering.begin(), sortedNumbering.end(), 0);
-      std::sort(sortedNumbering.begin(), sortedNumbering.end(),
-                [this, iC](size_t a, size_t b) -> bool { return cells[iC][a] < cells[iC][b]; });
-      std::array<size_t, 8> rotatedNumbering;
-      std::copy(rotationMap[sortedNumbering[0]].begin(), rotationMap[sortedNumbering[0]].end(),
-                rotatedNumbering.begin());
-      size_t diagCount = 0;
-      auto checkDiagonal = [this, rotatedNumbering, iC](size_t a1, size_t a2, size_t b1, size_t b2) {
-        return (cells[iC][rotatedNumbering[a1]] < cells[iC][rotatedNumbering[b1]] &&
-                cells[iC][rotatedNumbering[a1]] < cells[iC][rotatedNumbering[b2]]) ||
-               (cells[iC][rotatedNumbering[a2]] < cells[iC][rotatedNumbering[b1]] &&
-                cells[iC][rotatedNumbering[a2]] < cells[iC][rotatedNumbering[b2]]);
-      };
-      if (checkDiagonal(1, 7, 2, 5)) {
-        diagCount++;
-      }
-      if (checkDiagonal(3, 7, 2, 6)) {
-        diagCount++;
-      }
-      if (checkDiagonal(4, 7, 5, 6)) {
-        diagCount++;
-      }
-      if (diagCount == 0) {
-        tetCount += 5;
-      } else {
-        tetCount += 6;
-      }
-      break;
+
+  // the tets depend on the positions too, through the ordering below
+  const char* cacheKind = "VolumeMesh.tets";
+  uint64_t inputHash = 0;
+  if (derivedDataCacheEnabled()) {
+    vertexPositions.ensureHostBufferPopulated();
+    inputHash = ContentHash().add(cells).add(vertexPositions.data).get();
+    if (loadDerivedData(cacheKind, inputHash, tets)) {
+      invalidateTetChunks();
+      return;
     }
-    case VolumeCellType::TET:
-      tetCount += 1;
-      break;
+  }
+
+  // Count the tets of each cell, then fill them in parallel at offsets given by a prefix sum of the counts
+  size_t N = nCells();
+  std::vector<size_t> cellTetStart(N + 1, 0);
+  parallelFor(0, N, [&](size_t cellBegin, size_t cellEnd) {
+    std::array<std::array<uint32_t, 4>, 6> hexTets;
+    for (size_t iC = cellBegin; iC < cellEnd; iC++) {
+      cellTetStart[iC + 1] = cellType(iC) == VolumeCellType::HEX ? computeHexTets(iC, hexTets) : 1;
     }
+  });
+  for (size_t iC = 0; iC < N; iC++) {
+    cellTetStart[iC + 1] += cellTetStart[iC];
   }
-  // Mark each edge as real or not (in the original mesh)
-  std::vector<std::array<bool, 6>> realEdges;
-  // Each hex can make up to 6 tets
-  tets.resize(tetCount);
-  realEdges.resize(tetCount);
-  size_t tetIdx = 0;
-  for (size_t iC = 0; iC < nCells(); iC++) {
-    switch (cellType(iC)) {
-    case VolumeCellType::HEX: {
-      std::array<size_t, 8> sortedNumbering;
-      std::iota(sortedNumbering.begin(), sortedNumbering.end(), 0);
-      std::sort(sortedNumbering.begin(), sortedNumbering.end(),
-                [this, iC](size_t a, size_t b) -> bool { return cells[iC][a] < cells[iC][b]; });
-      std::array<size_t, 8> rotatedNumbering;
-      std::copy(rotationMap[sortedNumbering[0]].begin(), rotationMap[sortedNumbering[0]].end(),
-                rotatedNumbering.begin());
-      size_t n = 0;
-      size_t diagCount = 0;
-      // Diagonal exists on the pair of vertices which contain the minimum vertex number
-      auto checkDiagonal = [this, rotatedNumbering, iC](size_t a1, size_t a2, size_t b1, size_t b2) {
-        return (cells[iC][rotatedNumbering[a1]] < cells[iC][rotatedNumbering[b1]] &&
-                cells[iC][rotatedNumbering[a1]] < cells[iC][rotatedNumbering[b2]]) ||
-               (cells[iC][rotatedNumbering[a2]] < cells[iC][rotatedNumbering[b1]] &&
-                cells[iC][rotatedNumbering[a2]] < cells[iC][rotatedNumbering[b2]]);
-      };
-      // Minimum vertex will always have 3 diagonals, check other three faces
-      if (checkDiagonal(1, 7, 2, 5)) {
-        n += 4;
-        diagCount++;
-      }
-      if (checkDiagonal(3, 7, 2, 6)) {
-        n += 2;
-        diagCount++;
-      }
-      if (checkDiagonal(4, 7, 5, 6)) {
-        n += 1;
-        diagCount++;
-      }
-      // Rotate by 120 or 240 degrees depending on diagonal positions
-      if (n == 1 || n == 6) {
-        size_t temp = rotatedNumbering[1];
-        rotatedNumbering[1] = rotatedNumbering[4];
-        rotatedNumbering[4] = rotatedNumbering[3];
-        rotatedNumbering[3] = temp;
-        temp = rotatedNumbering[5];
-        rotatedNumbering[5] = rotatedNumbering[6];
-        rotatedNumbering[6] = rotatedNumbering[2];
-        rotatedNumbering[2] = temp;
-      } else if (n == 2 || n == 5) {
-        size_t temp = rotatedNumbering[1];
-        rotatedNumbering[1] = rotatedNumbering[3];
-        rotatedNumbering[3] = rotatedNumbering[4];
-        rotatedNumbering[4] = temp;
-        temp = rotatedNumbering[5];
-        rotatedNumbering[5] = rotatedNumbering[2];
-        rotatedNumbering[2] = rotatedNumbering[6];
-        rotatedNumbering[6] = temp;
-      }
 
-      // Map final tets according to diagonalMap and the number of diagonals not incident to V_0
-      std::array<std::array<size_t, 4>, 6> tetMap = diagonalMap[diagCount];
-      for (size_t k = 0; k < (diagCount == 0 ? 5 : 6); k++) {
+  tets.resize(cellTetStart[N]);
+  parallelFor(0, N, [&](size_t cellBegin, size_t cellEnd) {
+    std::array<std::array<uint32_t, 4>, 6> hexTets;
+    for (size_t iC = cellBegin; iC < cellEnd; iC++) {
+      size_t tetIdx = cellTetStart[iC];
+      switch (cellType(iC)) {
+      case VolumeCellType::HEX: {
+        size_t tetCount = computeHexTets(iC, hexTets);
+        for (size_t k = 0; k < tetCount; k++) {
+          tets[tetIdx + k] = hexTets[k];
+        }
+        break;
+      }
+      case VolumeCellType::TET:
         for (size_t i = 0; i < 4; i++) {
-          tets[tetIdx][i] = cells[iC][rotatedNumbering[tetMap[k][i]]];
+          tets[tetIdx][i] = cells[iC][i];
         }
-        tetIdx++;
+        break;
       }
-      break;
     }
-    case VolumeCellType::TET:
-      for (size_t i = 0; i < 4; i++) {
-        tets[tetIdx][i] = cells[iC][i];
+  });
+
+  // Store the tets along a Morton curve through their centroids, so runs of consecutive tets are spatially coherent
+  // and can be culled together by slice planes
+  vertexPositions.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  std::vector<glm::vec3> centroids(tets.size());
+  parallelFor(0, tets.size(), [&](size_t begin, size_t end) {
+    for (size_t iT = begin; iT < end; iT++) {
+      const std::array<uint32_t, 4>& tet = tets[iT];
+      centroids[iT] = (pos[tet[0]] + pos[tet[1]] + pos[tet[2]] + pos[tet[3]]) / 4.f;
+    }
+  });
+  std::vector<uint32_t> tetOrder = mortonOrder(centroids);
+  std::vector<std::array<uint32_t, 4>> sortedTets(tets.size());
+  parallelFor(0, tets.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      sortedTets[i] = tets[tetOrder[i]];
+    }
+  });
+  tets.swap(sortedTets);
+  storeDerivedData(cacheKind, inputHash, tets);
+
+  invalidateTetChunks();
+}
+
+void VolumeMesh::computeTetChunks() {
+
+  vertexPositions.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+
+  tetChunks.clear();
+  size_t nTet = tets.size();
+  for (size_t start = 0; start < nTet; start += tetsPerChunk) {
+    TetChunk chunk;
+    chunk.tetStart = start;
+    chunk.tetCount = std::min(tetsPerChunk, nTet - start);
+    tetChunks.push_back(chunk);
+  }
+
+  parallelFor(
+      0, tetChunks.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t iChunk = begin; iChunk < end; iChunk++) {
+          TetChunk& chunk = tetChunks[iChunk];
+          glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+          glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+          for (size_t iT = chunk.tetStart; iT < chunk.tetStart + chunk.tetCount; iT++) {
+            for (uint32_t iV : tets[iT]) {
+              min = componentwiseMin(min, pos[iV]);
+              max = componentwiseMax(max, pos[iV]);
+            }
+          }
+          chunk.objectSpaceBoundingBox = std::make_tuple(min, max);
+        }
+      },
+      1);
+
+  // The tets are drawn straight from the per-tet attributes, so the draw order is just the identity
+  if (!tetDrawOrder || static_cast<size_t>(tetDrawOrder->getDataSize()) != nTet) {
+    std::vector<uint32_t> order(nTet);
+    std::iota(order.begin(), order.end(), 0);
+    tetDrawOrder = render::engine->generateAttributeBuffer(RenderDataType::UInt);
+    tetDrawOrder->setData(order);
+  }
+}
+
+void VolumeMesh::invalidateTetChunks() {
+  tetChunks.clear();
+  sliceTetQueries.clear();
+}
+
+void VolumeMesh::drawSliceProgram(render::ShaderProgram& p, polyscope::SlicePlane* sp) {
+  ensureHaveTets();
+  if (tets.empty()) return;
+  if (tetChunks.empty()) computeTetChunks();
+
+  // Only re-query the chunks when the plane has moved (these are the same values setSliceGeomUniforms() uses)
+  glm::vec3 sliceVector = sp->getNormal();
+  float slicePoint = glm::dot(sp->getCenter(), sliceVector);
+  SliceTetQuery& query = sliceTetQueries[sp];
+  if (!query.isValid || query.sliceVector != sliceVector || query.slicePoint != slicePoint) {
+    query.isValid = true;
+    query.sliceVector = sliceVector;
+    query.slicePoint = slicePoint;
+    query.tetRanges.clear();
+
+    glm::vec3 absVector = glm::abs(sliceVector);
+    for (const TetChunk& chunk : tetChunks) {
+
+      // The plane crosses the box if the distance to its center is at most the box's extent along the normal
+      glm::vec3 boxMin = std::get<0>(chunk.objectSpaceBoundingBox);
+      glm::vec3 boxMax = std::get<1>(chunk.objectSpaceBoundingBox);
+      float centerDist = glm::dot(sliceVector, 0.5f * (boxMin + boxMax)) - slicePoint;
+      float extent = glm::dot(absVector, 0.5f * (boxMax - boxMin));
+      if (!(std::abs(centerDist) <= extent)) continue;
+
+      // merge with the previous range when they are adjacent, to keep the number of draw ranges small
+      if (!query.tetRanges.empty() && query.tetRanges.back()[0] + query.tetRanges.back()[1] == chunk.tetStart) {
+        query.tetRanges.back()[1] += chunk.tetCount;
+      } else {
+        query.tetRanges.push_back({{chunk.tetStart, chunk.tetCount}});
       }
-      tetIdx++;
-      break;
     }
   }
+
+  p.drawSubset(*tetDrawOrder, query.tetRanges);
 }
 
 void VolumeMesh::ensureHaveTets() {
@@ -364,6 +553,7 @@ void VolumeMesh::removeSlicePlaneListener(polyscope::SlicePlane* sp) {
       break;
     }
   }
+  sliceTetQueries.erase(sp);
 }
 
 void VolumeMesh::fillSliceGeometryBuffers(render::ShaderProgram& program) {
@@ -417,6 +607,8 @@ void VolumeMesh::draw() {
     return;
   }
 
+  ensureTriangleBuffersCurrent();
+
   render::engine->setBackfaceCull();
 
   // If no quantity is drawing the volume, we should draw it
@@ -449,11 +641,11 @@ void VolumeMesh::draw() {
   }
 
   // Draw the quantities
-  for (auto& x : quantities) {
-    x.second->draw();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->draw();
   }
-  for (auto& x : floatingQuantities) {
-    x.second->draw();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->draw();
   }
 }
 
@@ -463,11 +655,11 @@ void VolumeMesh::drawDelayed() {
   }
 
   // Draw the quantities
-  for (auto& x : quantities) {
-    x.second->drawDelayed();
+  for (QuantityType* q : getEnabledQuantities()) {
+    q->drawDelayed();
   }
-  for (auto& x : floatingQuantities) {
-    x.second->drawDelayed();
+  for (FloatingQuantity* q : getEnabledFloatingQuantities()) {
+    q->drawDelayed();
   }
 }
 
@@ -476,6 +668,8 @@ void VolumeMesh::drawPick() {
     return;
   }
 
+  ensureTriangleBuffersCurrent();
+
   if (pickProgram == nullptr) {
     preparePick();
   }
@@ -502,6 +696,18 @@ void VolumeMesh::prepare() {
   render::engine->setMaterial(*program, getMaterial());
 }
 
+bool VolumeMesh::hasPendingHostData() {
+  return isEnabled() && program == nullptr && !vertexPositions.isCanonicalOnDevice();
+}
+
+void VolumeMesh::prepareHostData() {
+  // the buffers fillGeometryBuffers() will upload for the program prepare() requests
+  faceNormals.ensureHostBufferComputed();
+  if (wantsCullPosition()) {
+    cellCenters.ensureHostBufferComputed();
+  }
+}
+
 void VolumeMesh::preparePick() {
 
   // Create a new program
@@ -530,14 +736,14 @@ void VolumeMesh::preparePick() {
   std::vector<glm::vec3> faceColor;
 
   // Reserve space
-  vertexColors.resize(3 * nFacesTriangulation());
-  edgeColors.resize(3 * nFacesTriangulation());
-  halfedgeColors.resize(3 * nFacesTriangulation());
-  cornerColors.resize(3 * nFacesTriangulation());
-  faceColor.resize(3 * nFacesTriangulation());
+  vertexColors.resize(3 * nTrianglesBuilt);
+  edgeColors.resize(3 * nTrianglesBuilt);
+  halfedgeColors.resize(3 * nTrianglesBuilt);
+  cornerColors.resize(3 * nTrianglesBuilt);
+  faceColor.resize(3 * nTrianglesBuilt);
 
   size_t iFront = 0;
-  size_t iBack = nFacesTriangulation() - 1;
+  size_t iBack = nTrianglesBuilt - 1;
   size_t iF = 0;
   for (size_t iC = 0; iC < nCells(); iC++) {
     const std::array<uint32_t, 8>& cell = cells[iC];
@@ -547,6 +753,10 @@ void VolumeMesh::preparePick() {
     std::array<glm::vec3, 3> cellColorArr{cellColor, cellColor, cellColor};
 
     for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellT)) {
+      if (faceIsInterior[iF] && !triangleBuffersHaveInterior) {
+        iF++;
+        continue;
+      }
 
       // Emit the actual face in the triangulation
       for (size_t j = 0; j < face.size(); j++) {
@@ -625,16 +835,15 @@ void VolumeMesh::fillGeometryBuffers(render::ShaderProgram& p) {
 
   p.setAttribute("a_vertexNormals", faceNormals.getIndexedRenderAttributeBuffer(triangleFaceInds));
 
-  bool wantsBary = p.hasAttribute("a_barycoord");
-  bool wantsEdge = (getEdgeWidth() > 0);
+  bool wantsEdge = p.hasTexture("t_edgeIsReal");
   bool wantsAttrCullPosition = wantsCullPosition();
   bool wantsFaceType = p.hasAttribute("a_faceColorType");
 
-  if (wantsBary) {
-    p.setAttribute("a_barycoord", baryCoord.getRenderAttributeBuffer());
-  }
   if (wantsEdge) {
-    p.setAttribute("a_edgeIsReal", edgeIsReal.getRenderAttributeBuffer());
+    if (!edgeMaskTexture) {
+      edgeMaskTexture = SurfaceMesh::generateEdgeMaskTexture(edgeIsReal.getPopulatedHostBufferRef());
+    }
+    p.setTextureFromBuffer("t_edgeIsReal", edgeMaskTexture.get());
   }
   if (wantsAttrCullPosition) {
     p.setAttribute("a_cullPos", cellCenters.getIndexedRenderAttributeBuffer(triangleCellInds));
@@ -645,6 +854,7 @@ void VolumeMesh::fillGeometryBuffers(render::ShaderProgram& p) {
 }
 
 void VolumeMesh::computeConnectivityData() {
+  POLYSCOPE_TRACE_SPAN("computeConnectivityData", name);
 
   // NOTE: If we were to fill buffers naively via a loop over cells, we get pretty bad z-fighting artifacts where
   // interior edges ever-so-slightly show through the exterior boundary (more generally, any place 3 faces meet at an
@@ -653,80 +863,113 @@ void VolumeMesh::computeConnectivityData() {
   // To mitigate this issue, we fill the buffer such that all exterior faces come first, then all interior faces, so
   // that exterior faces always win depth ties. This doesn't totally eliminate the problem, but greatly improves the
   // most egregious cases.
+  //
+  // In exterior-only mode, the interior faces are left out entirely unless a slice plane might expose them.
+
+  // Each cell's triangles go to a range at the front for exterior triangles, and one at the back for interior ones.
+  // Count the exterior triangles of each cell to find where those ranges start, then fill all cells in parallel.
+  size_t N = nCells();
+  std::vector<size_t> cellFaceStart, cellTriStart;
+  computeCellFaceStarts(cellFaceStart, cellTriStart);
+  std::vector<size_t> cellExteriorTriStart(N + 1, 0);
+  parallelFor(0, N, [&](size_t cellBegin, size_t cellEnd) {
+    for (size_t iC = cellBegin; iC < cellEnd; iC++) {
+      size_t iF = cellFaceStart[iC];
+      size_t count = 0;
+      for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellType(iC))) {
+        if (!faceIsInterior[iF]) count += face.size();
+        iF++;
+      }
+      cellExteriorTriStart[iC + 1] = count;
+    }
+  });
+  for (size_t iC = 0; iC < N; iC++) {
+    cellExteriorTriStart[iC + 1] += cellExteriorTriStart[iC];
+  }
+  triangleBuffersHaveInterior = wantsInteriorFaces();
+  nTrianglesBuilt = triangleBuffersHaveInterior ? nFacesTriangulation() : cellExteriorTriStart[N];
 
   // == Allocate buffers
   triangleVertexInds.data.clear();
-  triangleVertexInds.data.resize(3 * nFacesTriangulation());
+  triangleVertexInds.data.resize(3 * nTrianglesBuilt);
   triangleFaceInds.data.clear();
-  triangleFaceInds.data.resize(3 * nFacesTriangulation());
-  triangleCellInds.data.clear();
-  triangleCellInds.data.resize(3 * nFacesTriangulation());
+  triangleFaceInds.data.resize(3 * nTrianglesBuilt);
   triangleCellInds.data.clear();
-  triangleCellInds.data.resize(3 * nFacesTriangulation());
-  baryCoord.data.clear();
-  baryCoord.data.resize(3 * nFacesTriangulation());
+  triangleCellInds.data.resize(3 * nTrianglesBuilt);
   edgeIsReal.data.clear();
-  edgeIsReal.data.resize(3 * nFacesTriangulation());
+  edgeIsReal.data.resize(3 * nTrianglesBuilt);
   faceType.data.clear();
   faceType.data.resize(nFaces());
 
-  size_t iF = 0;
-  size_t iFront = 0;
-  size_t iBack = nFacesTriangulation() - 1;
-  for (size_t iC = 0; iC < nCells(); iC++) {
-    const std::array<uint32_t, 8>& cell = cells[iC];
-    VolumeCellType cellT = cellType(iC);
-
-    // Loop over all faces of the cell
-    for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellT)) {
-
-      // Loop over the face's triangulation
-      for (size_t j = 0; j < face.size(); j++) {
-        const std::array<size_t, 3>& tri = face[j];
-
-        // Enumerate exterior faces in the front of the draw buffer, and interior faces in the back.
-        // (see note above)
-        size_t iData;
-        if (faceIsInterior[iF]) {
-          iData = iBack;
-          iBack--;
-        } else {
-          iData = iFront;
-          iFront++;
+  parallelFor(0, N, [&](size_t cellBegin, size_t cellEnd) {
+    for (size_t iC = cellBegin; iC < cellEnd; iC++) {
+      const std::array<uint32_t, 8>& cell = cells[iC];
+      VolumeCellType cellT = cellType(iC);
+      size_t iF = cellFaceStart[iC];
+      size_t iFront = cellExteriorTriStart[iC];
+      size_t iBack = nTrianglesBuilt - 1 - (cellTriStart[iC] - cellExteriorTriStart[iC]);
+
+      // Loop over all faces of the cell
+      for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellT)) {
+        bool skipFace = faceIsInterior[iF] && !triangleBuffersHaveInterior;
+
+        // Loop over the face's triangulation
+        for (size_t j = 0; j < face.size() && !skipFace; j++) {
+          const std::array<size_t, 3>& tri = face[j];
+
+          // Enumerate exterior faces in the front of the draw buffer, and interior faces in the back.
+          // (see note above)
+          size_t iData;
+          if (faceIsInterior[iF]) {
+            iData = iBack;
+            iBack--;
+          } else {
+            iData = iFront;
+            iFront++;
+          }
+
+          for (size_t k = 0; k < 3; k++) {
+            triangleVertexInds.data[3 * iData + k] = cell[tri[k]];
+          }
+          for (size_t k = 0; k < 3; k++) triangleFaceInds.data[3 * iData + k] = iF;
+          for (size_t k = 0; k < 3; k++) triangleCellInds.data[3 * iData + k] = iC;
+
+          glm::vec3 edgeRealV{0., 1., 0.};
+          if (j == 0) edgeRealV.x = 1.;
+          if (j + 1 == face.size()) edgeRealV.z = 1.;
+          for (int k = 0; k < 3; k++) edgeIsReal.data[3 * iData + k] = edgeRealV;
         }
 
-        for (size_t k = 0; k < 3; k++) {
-          triangleVertexInds.data[3 * iData + k] = cell[tri[k]];
-        }
-        for (size_t k = 0; k < 3; k++) triangleFaceInds.data[3 * iData + k] = iF;
-        for (size_t k = 0; k < 3; k++) triangleCellInds.data[3 * iData + k] = iC;
-
-        baryCoord.data[3 * iData + 0] = glm::vec3{1., 0., 0.};
-        baryCoord.data[3 * iData + 1] = glm::vec3{0., 1., 0.};
-        baryCoord.data[3 * iData + 2] = glm::vec3{0., 0., 1.};
+        float faceTypeFloat = faceIsInterior[iF] ? 1. : 0.;
+        for (int k = 0; k < 3; k++) faceType.data[iF] = faceTypeFloat;
 
-        glm::vec3 edgeRealV{0., 1., 0.};
-        if (j == 0) edgeRealV.x = 1.;
-        if (j + 1 == face.size()) edgeRealV.z = 1.;
-        for (int k = 0; k < 3; k++) edgeIsReal.data[3 * iData + k] = edgeRealV;
+        iF++;
       }
-
-      float faceTypeFloat = faceIsInterior[iF] ? 1. : 0.;
-      for (int k = 0; k < 3; k++) faceType.data[iF] = faceTypeFloat;
-
-      iF++;
     }
-  }
+  });
 
   triangleVertexInds.markHostBufferUpdated();
   triangleFaceInds.markHostBufferUpdated();
   triangleCellInds.markHostBufferUpdated();
-  triangleCellInds.markHostBufferUpdated();
-  baryCoord.markHostBufferUpdated();
   edgeIsReal.markHostBufferUpdated();
+  edgeMaskTexture.reset();
   faceType.markHostBufferUpdated();
 }
 
+bool VolumeMesh::wantsInteriorFaces() {
+  if (!getExteriorOnly()) return true;
+  for (std::unique_ptr<SlicePlane>& plane : state::slicePlanes) {
+    if (plane->getActive() && !getIgnoreSlicePlane(plane->name)) return true;
+  }
+  return false;
+}
+
+void VolumeMesh::ensureTriangleBuffersCurrent() {
+  if (wantsInteriorFaces() == triangleBuffersHaveInterior) return;
+  computeConnectivityData();
+  refresh(); // the programs and the indexed views they hold are built from the old triangles
+}
+
 const std::vector<std::vector<std::array<size_t, 3>>>& VolumeMesh::cellStencil(VolumeCellType type) {
   switch (type) {
   case VolumeCellType::TET:
@@ -909,6 +1152,7 @@ void VolumeMesh::buildCustomOptionsUI() {
     material.manuallyChanged();
     setMaterial(material.get()); // trigger the other updates that happen on set()
   }
+  if (ImGui::MenuItem("Exterior faces only", NULL, exteriorOnly.get())) setExteriorOnly(!exteriorOnly.get());
 }
 
 
@@ -927,6 +1171,7 @@ void VolumeMesh::refresh() {
 }
 
 void VolumeMesh::geometryChanged() {
+  invalidateTetChunks();
   recomputeGeometryIfPopulated();
   requestRedraw();
   QuantityStructure<VolumeMesh>::refresh(); // TODO fixme unneeded, right?
@@ -947,25 +1192,8 @@ VolumeCellType VolumeMesh::cellType(size_t i) const {
 };
 
 void VolumeMesh::updateObjectSpaceBounds() {
-
   vertexPositions.ensureHostBufferPopulated();
-
-  // bounding box
-  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  for (const glm::vec3& p : vertexPositions.data) {
-    min = componentwiseMin(min, p);
-    max = componentwiseMax(max, p);
-  }
-  objectSpaceBoundingBox = std::make_tuple(min, max);
-
-  // length scale, as twice the radius from the center of the bounding box
-  glm::vec3 center = 0.5f * (min + max);
-  float lengthScale = 0.0;
-  for (const glm::vec3& p : vertexPositions.data) {
-    lengthScale = std::max(lengthScale, glm::length2(p - center));
-  }
-  objectSpaceLengthScale = 2 * std::sqrt(lengthScale);
+  setObjectSpaceBoundsFromPoints(vertexPositions.data);
 }
 
 std::string VolumeMesh::typeName() { return structureTypeName; }
@@ -1011,6 +1239,14 @@ VolumeMesh* VolumeMesh::setEdgeWidth(double newVal) {
 }
 double VolumeMesh::getEdgeWidth() { return edgeWidth.get(); }
 
+VolumeMesh* VolumeMesh::setExteriorOnly(bool newVal) {
+  exteriorOnly = newVal;
+  ensureTriangleBuffersCurrent();
+  requestRedraw();
+  return this;
+}
+bool VolumeMesh::getExteriorOnly() { return exteriorOnly.get(); }
+
 
 // === Quantity adder}
 
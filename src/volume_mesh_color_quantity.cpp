@@ -51,7 +51,7 @@ void VolumeMeshVertexColorQuantity::drawSlice(polyscope::SlicePlane* sp) {
   sp->setSceneObjectUniforms(*sliceProgram, true);
   sp->setSliceGeomUniforms(*sliceProgram);
   parent.setVolumeMeshUniforms(*sliceProgram);
-  sliceProgram->draw();
+  parent.drawSliceProgram(*sliceProgram, sp);
 }
 
 std::shared_ptr<render::ShaderProgram> VolumeMeshVertexColorQuantity::createSliceProgram() {
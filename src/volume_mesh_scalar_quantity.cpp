@@ -2,11 +2,18 @@
 
 #include "polyscope/volume_mesh_scalar_quantity.h"
 
+#include "polyscope/key_indexing.h"
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 
 #include "imgui.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
 namespace polyscope {
 
 VolumeMeshScalarQuantity::VolumeMeshScalarQuantity(std::string name, VolumeMesh& mesh_, std::string definedOn_,
@@ -62,7 +69,7 @@ std::string VolumeMeshScalarQuantity::niceName() { return name + " (" + definedO
 VolumeMeshVertexScalarQuantity::VolumeMeshVertexScalarQuantity(std::string name, const std::vector<float>& values_,
                                                                VolumeMesh& mesh_, DataType dataType_)
     : VolumeMeshScalarQuantity(name, mesh_, "vertex", values_, dataType_), levelSetValue(0), isDrawingLevelSet(false),
-      showQuantity(this)
+      showQuantity(this), levelSetCached(uniquePrefix() + "levelSetCached", false)
 
 {
   parent.refreshVolumeMeshListeners(); // just in case this quantity is being drawn
@@ -119,6 +126,11 @@ void VolumeMeshVertexScalarQuantity::setLevelSetUniforms(render::ShaderProgram&
 void VolumeMeshVertexScalarQuantity::draw() {
   if (!isEnabled()) return;
 
+  if (isDrawingLevelSet && levelSetCached.get()) {
+    drawCachedLevelSet();
+    return;
+  }
+
   auto programToDraw = program;
   if (isDrawingLevelSet) {
     if (levelSetProgram == nullptr) {
@@ -167,7 +179,7 @@ void VolumeMeshVertexScalarQuantity::drawSlice(polyscope::SlicePlane* sp) {
   parent.setVolumeMeshUniforms(*sliceProgram);
   setScalarUniforms(*sliceProgram);
   render::engine->setMaterialUniforms(*sliceProgram, parent.getMaterial());
-  sliceProgram->draw();
+  parent.drawSliceProgram(*sliceProgram, sp);
 }
 
 void VolumeMeshVertexScalarQuantity::setLevelSetVisibleQuantity(std::string name) {
@@ -210,6 +222,9 @@ void VolumeMeshVertexScalarQuantity::buildScalarOptionsUI() {
   if (ImGui::Checkbox("Level Set", &isDrawingLevelSet)) {
     setEnabledLevelSet(isDrawingLevelSet);
   }
+  if (isDrawingLevelSet) {
+    if (ImGui::MenuItem("Cache level set mesh", NULL, levelSetCached.get())) setLevelSetCached(!levelSetCached.get());
+  }
 }
 
 void VolumeMeshVertexScalarQuantity::buildCustomUI() {
@@ -220,7 +235,7 @@ void VolumeMeshVertexScalarQuantity::buildCustomUI() {
     ImGui::DragFloat("##value", &levelSetValue, 0.01f, (float)hist.colormapRange.first,
                      (float)hist.colormapRange.second);
     if (ImGui::BeginMenu("Show Quantity")) {
-      std::map<std::string, std::unique_ptr<polyscope::VolumeMeshQuantity>>::iterator it;
+      QuantityList<VolumeMeshQuantity>::iterator it;
       for (it = parent.quantities.begin(); it != parent.quantities.end(); it++) {
         std::string quantityName = it->first;
         VolumeMeshQuantity* vmq = it->second.get();
@@ -237,6 +252,250 @@ void VolumeMeshVertexScalarQuantity::buildCustomUI() {
 void VolumeMeshVertexScalarQuantity::refresh() {
   VolumeMeshScalarQuantity::refresh();
   levelSetProgram.reset();
+  cachedLevelSetProgram.reset();
+}
+
+struct VolumeMeshVertexScalarQuantity::LevelSetSnapshot {
+  std::vector<glm::vec3> positions;
+  std::vector<std::array<uint32_t, 4>> tets;
+  std::vector<float> fieldValues;
+  std::vector<float> colorValues;
+
+  // what the copies were taken from
+  uint64_t positionsVersion;
+  uint64_t fieldVersion;
+  uint64_t colorVersion;
+  const VolumeMeshVertexScalarQuantity* colorQuantity;
+};
+
+VolumeMeshVertexScalarQuantity::LevelSetMesh
+VolumeMeshVertexScalarQuantity::extractLevelSet(const std::vector<glm::vec3>& positions,
+                                                const std::vector<std::array<uint32_t, 4>>& tets,
+                                                const std::vector<float>& fieldValues,
+                                                const std::vector<float>& colorValues, float level) {
+  LevelSetMesh mesh;
+  size_t nTets = tets.size();
+  if (nTets == 0 || !std::isfinite(level)) return mesh;
+
+  // Each crossed tet edge is keyed by its (lower, higher) vertex indices, and each triangle written as three keys in to
+  // a buffer for each chunk of tets. A vertex is above the level if its value is >= the level.
+  auto edgeKey = [](uint32_t vA, uint32_t vB) -> uint64_t {
+    return (static_cast<uint64_t>(std::min(vA, vB)) << 32) | std::max(vA, vB);
+  };
+  auto crossing = [&](uint64_t key) -> float {
+    uint32_t vA = static_cast<uint32_t>(key >> 32);
+    uint32_t vB = static_cast<uint32_t>(key & 0xFFFFFFFF);
+    return (level - fieldValues[vA]) / (fieldValues[vB] - fieldValues[vA]);
+  };
+  auto crossingPosition = [&](uint64_t key) -> glm::vec3 {
+    float t = crossing(key);
+    return (1.f - t) * positions[key >> 32] + t * positions[key & 0xFFFFFFFF];
+  };
+
+  size_t nChunks = parallelChunkCount(nTets);
+  std::vector<std::vector<uint64_t>> chunkKeys(nChunks);
+  parallelForChunks(0, nTets, nChunks, [&](size_t iChunk, size_t begin, size_t end) {
+    std::vector<uint64_t>& keys = chunkKeys[iChunk];
+    for (size_t iT = begin; iT < end; iT++) {
+      const std::array<uint32_t, 4>& tet = tets[iT];
+      bool finite = true;
+      uint32_t above[4], below[4];
+      size_t nAbove = 0, nBelow = 0;
+      for (uint32_t v : tet) {
+        float val = fieldValues[v];
+        if (!std::isfinite(val)) finite = false;
+        if (val >= level) {
+          above[nAbove++] = v;
+        } else {
+          below[nBelow++] = v;
+        }
+      }
+      if (!finite || nAbove == 0 || nBelow == 0) continue;
+
+      // the crossed edges, in order around the section
+      uint64_t ring[4];
+      size_t nRing;
+      if (nAbove == 1 || nBelow == 1) {
+        uint32_t lone = nAbove == 1 ? above[0] : below[0];
+        const uint32_t* others = nAbove == 1 ? below : above;
+        for (size_t k = 0; k < 3; k++) ring[k] = edgeKey(lone, others[k]);
+        nRing = 3;
+      } else {
+        ring[0] = edgeKey(above[0], below[0]);
+        ring[1] = edgeKey(above[0], below[1]);
+        ring[2] = edgeKey(above[1], below[1]);
+        ring[3] = edgeKey(above[1], below[0]);
+        nRing = 4;
+      }
+
+      // face towards the vertices above
+      glm::vec3 aboveCenter{0., 0., 0.}, belowCenter{0., 0., 0.};
+      for (size_t k = 0; k < nAbove; k++) aboveCenter += positions[above[k]] / static_cast<float>(nAbove);
+      for (size_t k = 0; k < nBelow; k++) belowCenter += positions[below[k]] / static_cast<float>(nBelow);
+      glm::vec3 p0 = crossingPosition(ring[0]);
+      glm::vec3 normal = glm::cross(crossingPosition(ring[1]) - p0, crossingPosition(ring[2]) - p0);
+      if (glm::dot(normal, aboveCenter - belowCenter) < 0.) std::reverse(ring, ring + nRing);
+
+      for (size_t k = 1; k + 1 < nRing; k++) {
+        keys.push_back(ring[0]);
+        keys.push_back(ring[k]);
+        keys.push_back(ring[k + 1]);
+      }
+    }
+  });
+
+  // Gather the chunk buffers in order
+  std::vector<size_t> chunkStart(nChunks + 1, 0);
+  for (size_t iChunk = 0; iChunk < nChunks; iChunk++) {
+    chunkStart[iChunk + 1] = chunkStart[iChunk] + chunkKeys[iChunk].size();
+  }
+  std::vector<uint64_t> keys(chunkStart[nChunks]);
+  parallelForChunks(0, nChunks, nChunks, [&](size_t iChunk, size_t, size_t) {
+    std::copy(chunkKeys[iChunk].begin(), chunkKeys[iChunk].end(), keys.begin() + chunkStart[iChunk]);
+    std::vector<uint64_t>().swap(chunkKeys[iChunk]);
+  });
+  if (keys.empty()) return mesh;
+
+  // Share the vertices on each crossed edge, numbered in order of first appearance
+  std::vector<size_t> keyVertex;
+  size_t nVertices = indexUniqueKeys(keys, keyVertex);
+  std::vector<size_t> vertexFirstKey(nVertices);
+  for (size_t i = 0, iV = 0; i < keys.size() && iV < nVertices; i++) {
+    if (keyVertex[i] == iV) vertexFirstKey[iV++] = i;
+  }
+
+  mesh.vertices.resize(nVertices);
+  mesh.values.resize(nVertices);
+  parallelFor(0, nVertices, [&](size_t begin, size_t end) {
+    for (size_t iV = begin; iV < end; iV++) {
+      uint64_t key = keys[vertexFirstKey[iV]];
+      float t = crossing(key);
+      mesh.vertices[iV] = crossingPosition(key);
+      mesh.values[iV] = (1.f - t) * colorValues[key >> 32] + t * colorValues[key & 0xFFFFFFFF];
+    }
+  });
+
+  mesh.indices.resize(keys.size());
+  parallelFor(0, keys.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      mesh.indices[i] = static_cast<uint32_t>(keyVertex[i]);
+    }
+  });
+
+  return mesh;
+}
+
+VolumeMeshVertexScalarQuantity* VolumeMeshVertexScalarQuantity::setLevelSetCached(bool newVal) {
+  levelSetCached = newVal;
+  if (!newVal) {
+    // does not wait for a running extraction, it finishes on its own
+    levelSetExtraction = std::future<LevelSetMesh>();
+    levelSetExtractionSnapshot.reset();
+    levelSetSnapshot.reset();
+    cachedLevelSetSnapshot.reset();
+    cachedLevelSetMesh = LevelSetMesh();
+    cachedLevelSetProgram.reset();
+  }
+  requestRedraw();
+  return this;
+}
+bool VolumeMeshVertexScalarQuantity::getLevelSetCached() { return levelSetCached.get(); }
+
+void VolumeMeshVertexScalarQuantity::ensureLevelSetSnapshotCurrent() {
+  VolumeMeshVertexScalarQuantity* colorQ = showQuantity != nullptr ? showQuantity : this;
+  if (levelSetSnapshot && levelSetSnapshot->positionsVersion == parent.vertexPositions.getDataVersion() &&
+      levelSetSnapshot->fieldVersion == values.getDataVersion() && levelSetSnapshot->colorQuantity == colorQ &&
+      levelSetSnapshot->colorVersion == colorQ->values.getDataVersion()) {
+    return;
+  }
+
+  parent.ensureHaveTets();
+  std::shared_ptr<LevelSetSnapshot> snapshot = std::make_shared<LevelSetSnapshot>();
+  snapshot->positions = parent.vertexPositions.getPopulatedHostBufferRef();
+  snapshot->tets = parent.tets;
+  snapshot->fieldValues = values.getPopulatedHostBufferRef();
+  snapshot->colorValues = colorQ->values.getPopulatedHostBufferRef();
+  snapshot->positionsVersion = parent.vertexPositions.getDataVersion();
+  snapshot->fieldVersion = values.getDataVersion();
+  snapshot->colorVersion = colorQ->values.getDataVersion();
+  snapshot->colorQuantity = colorQ;
+  levelSetSnapshot = snapshot;
+}
+
+void VolumeMeshVertexScalarQuantity::drawCachedLevelSet() {
+  if (showQuantity == nullptr) showQuantity = this;
+  ensureLevelSetSnapshotCurrent();
+
+  auto installExtraction = [&]() {
+    cachedLevelSetMesh = levelSetExtraction.get();
+    cachedLevelSetSnapshot = levelSetExtractionSnapshot;
+    cachedLevelSetValue = levelSetExtractionValue;
+    levelSetExtractionSnapshot.reset();
+    cachedLevelSetProgram.reset();
+  };
+
+  // Take a finished extraction, and start the next one if the level or the data changed since. While one runs, the
+  // previous mesh is drawn.
+  if (levelSetExtraction.valid() &&
+      levelSetExtraction.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    installExtraction();
+  }
+  bool cacheCurrent = cachedLevelSetSnapshot == levelSetSnapshot && cachedLevelSetValue == levelSetValue;
+  if (!cacheCurrent && !levelSetExtraction.valid()) {
+    std::shared_ptr<const LevelSetSnapshot> snapshot = levelSetSnapshot;
+    float level = levelSetValue;
+    std::packaged_task<LevelSetMesh()> task([snapshot, level]() {
+      return extractLevelSet(snapshot->positions, snapshot->tets, snapshot->fieldValues, snapshot->colorValues,
+                             level);
+    });
+    levelSetExtraction = task.get_future();
+    levelSetExtractionSnapshot = snapshot;
+    levelSetExtractionValue = level;
+    std::thread(std::move(task)).detach();
+  }
+
+  // There is nothing to draw until the first extraction is done, so wait for that one
+  if (!cachedLevelSetSnapshot && levelSetExtraction.valid()) installExtraction();
+
+  // come back for the result, the idle loop would not otherwise draw another frame
+  if (levelSetExtraction.valid()) requestRedraw();
+
+  if (cachedLevelSetMesh.indices.empty()) return;
+
+  if (cachedLevelSetProgram == nullptr) {
+    // clang-format off
+    cachedLevelSetProgram = render::engine->requestShader("SIMPLE_MESH",
+        render::engine->addMaterialRules(parent.getMaterial(),
+          parent.addStructureRules(
+            showQuantity->addScalarRules(
+              {"MESH_PROPAGATE_VALUE", "COMPUTE_SHADE_NORMAL_FROM_POSITION", "PROJ_AND_INV_PROJ_MAT",
+               "MESH_BACKFACE_NORMAL_FLIP"}
+            )
+          )
+        )
+      );
+    // clang-format on
+
+    cachedLevelSetProgram->setAttribute("a_vertexPositions", cachedLevelSetMesh.vertices);
+    cachedLevelSetProgram->setAttribute("a_value", cachedLevelSetMesh.values);
+    std::shared_ptr<render::AttributeBuffer> indexBuff =
+        render::engine->generateAttributeBuffer(RenderDataType::UInt);
+    indexBuff->setData(cachedLevelSetMesh.indices);
+    cachedLevelSetProgram->setIndex(indexBuff);
+    cachedLevelSetProgram->setTextureFromColormap("t_colormap", showQuantity->cMap.get());
+    render::engine->setMaterial(*cachedLevelSetProgram, parent.getMaterial());
+  }
+
+  parent.setStructureUniforms(*cachedLevelSetProgram);
+  showQuantity->setScalarUniforms(*cachedLevelSetProgram);
+  render::engine->setMaterialUniforms(*cachedLevelSetProgram, parent.getMaterial());
+  glm::mat4 P = view::getCameraPerspectiveMatrix();
+  glm::mat4 Pinv = glm::inverse(P);
+  cachedLevelSetProgram->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
+  cachedLevelSetProgram->setUniform("u_viewport", render::engine->getCurrentViewport());
+
+  render::engine->setBackfaceCull(false);
+  cachedLevelSetProgram->draw();
 }
 
 void VolumeMeshVertexScalarQuantity::createProgram() {
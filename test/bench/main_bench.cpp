@@ -0,0 +1,262 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+// Timings for the hot paths of registering and rendering data, to catch performance regressions.
+//
+// Usage: polyscope-bench [backend=openGL_mock] [maxSize=1000000] [maxStructures=1000] [filter=substring] [minTime=0.2]
+//
+// Each benchmark runs at sizes 1K, 10K, ... up to maxSize elements (use maxSize=100000000 for the largest runs, which
+// need tens of GB of memory). The CPU overhead benchmarks instead run on 10, 100, ... up to maxStructures small
+// structures, where the per-structure and per-quantity bookkeeping dominates; the mock backend isolates them from any
+// GPU work. Results are printed to stdout as one JSON object per line.
+
+#include "polyscope/affine_remapper.h"
+#include "polyscope/marching_cubes.h"
+#include "polyscope/persistent_value.h"
+#include "polyscope/pick.h"
+#include "polyscope/point_cloud.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/surface_mesh.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string backend = "openGL_mock";
+size_t maxSize = 1000000;
+size_t maxStructures = 1000;
+std::string filter = "";
+double minTime = 0.2; // seconds spent repeating each benchmark, at least
+const int minReps = 3;
+const int maxReps = 1000;
+
+// A regular grid of quads, split in to triangles, with about n vertices
+struct GridMesh {
+  std::vector<std::array<float, 3>> vertices;
+  std::vector<std::array<uint32_t, 3>> faces;
+};
+
+GridMesh makeGridMesh(size_t n) {
+  size_t side = std::max<size_t>(2, static_cast<size_t>(std::sqrt(static_cast<double>(n))));
+  GridMesh mesh;
+  mesh.vertices.reserve(side * side);
+  for (size_t i = 0; i < side; i++) {
+    for (size_t j = 0; j < side; j++) {
+      float x = static_cast<float>(i) / (side - 1);
+      float y = static_cast<float>(j) / (side - 1);
+      mesh.vertices.push_back({{x, y, 0.1f * std::sin(10.f * x) * std::cos(10.f * y)}});
+    }
+  }
+  mesh.faces.reserve(2 * (side - 1) * (side - 1));
+  for (size_t i = 0; i + 1 < side; i++) {
+    for (size_t j = 0; j + 1 < side; j++) {
+      uint32_t v00 = static_cast<uint32_t>(i * side + j);
+      uint32_t v01 = v00 + 1;
+      uint32_t v10 = static_cast<uint32_t>(v00 + side);
+      uint32_t v11 = v10 + 1;
+      mesh.faces.push_back({{v00, v10, v11}});
+      mesh.faces.push_back({{v00, v11, v01}});
+    }
+  }
+  return mesh;
+}
+
+std::vector<float> randomValues(size_t n, unsigned int seed) {
+  std::mt19937 gen(seed);
+  std::normal_distribution<float> dist;
+  std::vector<float> vals(n);
+  for (float& v : vals) v = dist(gen);
+  return vals;
+}
+
+// Time body() repeatedly, setup() runs before each repetition and is not timed
+void runBenchmark(const std::string& name, size_t n, std::function<void()> body,
+                  std::function<void()> setup = std::function<void()>()) {
+  if (!filter.empty() && name.find(filter) == std::string::npos) return;
+
+  std::vector<double> timesMs;
+  double totalSec = 0.;
+  while (static_cast<int>(timesMs.size()) < maxReps &&
+         (static_cast<int>(timesMs.size()) < minReps || totalSec < minTime)) {
+    if (setup) setup();
+    auto start = std::chrono::steady_clock::now();
+    body();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    timesMs.push_back(1000. * sec);
+    totalSec += sec;
+  }
+
+  std::sort(timesMs.begin(), timesMs.end());
+  double meanMs = 1000. * totalSec / timesMs.size();
+  std::printf("{\"benchmark\": \"%s\", \"backend\": \"%s\", \"n\": %zu, \"reps\": %zu, \"min_ms\": %.6f, "
+              "\"median_ms\": %.6f, \"mean_ms\": %.6f}\n",
+              name.c_str(), backend.c_str(), n, timesMs.size(), timesMs.front(), timesMs[timesMs.size() / 2],
+              meanMs);
+  std::fflush(stdout);
+}
+
+void benchmarkSize(size_t n) {
+  GridMesh mesh = makeGridMesh(n);
+  std::vector<float> values = randomValues(mesh.vertices.size(), 1);
+  std::vector<float> values2 = randomValues(mesh.vertices.size(), 2);
+
+  // == Registration and data
+  runBenchmark("registerSurfaceMesh", n,
+               [&]() { polyscope::registerSurfaceMesh("bench mesh", mesh.vertices, mesh.faces); });
+
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("bench mesh", mesh.vertices, mesh.faces);
+  runBenchmark("computeConnectivityData", n, [&]() { psMesh->computeConnectivityData(); });
+
+  runBenchmark("addVertexScalarQuantity", n, [&]() { psMesh->addVertexScalarQuantity("bench scalar", values); });
+
+  polyscope::SurfaceVertexScalarQuantity* q = psMesh->addVertexScalarQuantity("bench scalar", values);
+  q->setEnabled(true);
+  bool flip = false;
+  runBenchmark("updateVertexScalarQuantity", n, [&]() {
+    q->updateData(flip ? values : values2);
+    flip = !flip;
+  });
+
+  runBenchmark("robustMinMax", n, [&]() { polyscope::robustMinMax(values); });
+
+  // == Rendering
+  polyscope::view::resetCameraToHomeView();
+  runBenchmark("renderFrame", n, [&]() { polyscope::screenshotToBuffer(); }, []() { polyscope::requestRedraw(); });
+
+  runBenchmark("pick", n, [&]() {
+    polyscope::pick::evaluatePickQuery(polyscope::view::bufferWidth / 2, polyscope::view::bufferHeight / 2);
+  }, []() { polyscope::requestRedraw(); });
+
+  polyscope::removeAllStructures();
+
+  // == Marching cubes, on a grid of about n nodes
+  uint32_t side = std::max<uint32_t>(2, static_cast<uint32_t>(std::cbrt(static_cast<double>(n))));
+  std::vector<float> field(static_cast<size_t>(side) * side * side);
+  for (uint32_t x = 0; x < side; x++) {
+    for (uint32_t y = 0; y < side; y++) {
+      for (uint32_t z = 0; z < side; z++) {
+        float fx = 2.f * x / (side - 1) - 1.f;
+        float fy = 2.f * y / (side - 1) - 1.f;
+        float fz = 2.f * z / (side - 1) - 1.f;
+        field[(static_cast<size_t>(x) * side + y) * side + z] = std::sqrt(fx * fx + fy * fy + fz * fz) - 0.7f;
+      }
+    }
+  }
+  std::vector<glm::vec3> mcVertices;
+  std::vector<uint32_t> mcIndices;
+  runBenchmark("marchingCubes", n,
+               [&]() { polyscope::marchingCubes(field.data(), 0.f, side, side, side, mcVertices, mcIndices); });
+}
+
+// CPU overhead of many small structures, n is the number of structures
+void benchmarkOverhead(size_t n) {
+  const size_t nPoints = 100;
+  std::vector<float> values = randomValues(nPoints, 3);
+  std::vector<float> values2 = randomValues(nPoints, 4);
+  std::vector<std::array<float, 3>> points(nPoints);
+  for (size_t i = 0; i < nPoints; i++) {
+    points[i] = {{values[i], values2[i], static_cast<float>(i) / nPoints}};
+  }
+  std::vector<std::string> names(n);
+  for (size_t i = 0; i < n; i++) {
+    names[i] = "bench cloud " + std::to_string(i);
+  }
+  auto registerAll = [&]() {
+    for (const std::string& name : names) polyscope::registerPointCloud(name, points);
+  };
+
+  // == Registry operations
+  runBenchmark("registerSmallStructures", n, registerAll, []() { polyscope::removeAllStructures(); });
+
+  runBenchmark("getStructure", n, [&]() {
+    for (const std::string& name : names) polyscope::getPointCloud(name);
+  });
+
+  runBenchmark("removeAllStructures", n, []() { polyscope::removeAllStructures(); }, registerAll);
+
+  // == Quantity creation
+  registerAll();
+  runBenchmark("addSmallScalarQuantities", n, [&]() {
+    for (const std::string& name : names) polyscope::getPointCloud(name)->addScalarQuantity("bench scalar", values);
+  });
+  for (const std::string& name : names) {
+    polyscope::getPointCloud(name)->addScalarQuantity("bench scalar", values)->setEnabled(true);
+  }
+
+  // == Draw submission: uniforms, state changes and draw calls for each structure
+  polyscope::view::resetCameraToHomeView();
+  polyscope::screenshotToBuffer(); // create the programs and buffers
+  runBenchmark("drawSubmission", n, [&]() { polyscope::screenshotToBuffer(); }, []() { polyscope::requestRedraw(); });
+
+  // == Program rule assembly and variant cache lookups, along with a draw to request the programs again
+  runBenchmark("refreshShaderPrograms", n, [&]() {
+    polyscope::refreshShaderPrograms();
+    polyscope::screenshotToBuffer();
+  });
+
+  polyscope::removeAllStructures();
+
+  // == Persistent value lookups, as each structure and quantity does for its options
+  std::vector<std::string> valueNames(n);
+  for (size_t i = 0; i < n; i++) {
+    valueNames[i] = "bench#value#" + std::to_string(i);
+  }
+  runBenchmark("persistentValueLookup", n, [&]() {
+    for (const std::string& name : valueNames) {
+      polyscope::PersistentValue<float> value(name, 1.f);
+      value.set(2.f);
+    }
+  });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    auto parseArg = [&](const std::string& prefix, std::string& val) {
+      if (arg.rfind(prefix, 0) != 0) return false;
+      val = arg.substr(prefix.size(), std::string::npos);
+      return true;
+    };
+
+    std::string val;
+    if (parseArg("backend=", val)) {
+      backend = val;
+    } else if (parseArg("maxSize=", val)) {
+      maxSize = static_cast<size_t>(std::stod(val));
+    } else if (parseArg("maxStructures=", val)) {
+      maxStructures = static_cast<size_t>(std::stod(val));
+    } else if (parseArg("filter=", val)) {
+      filter = val;
+    } else if (parseArg("minTime=", val)) {
+      minTime = std::stod(val);
+    } else {
+      throw std::runtime_error("unrecognized argument " + arg);
+    }
+  }
+
+  polyscope::options::verbosity = 0;
+  polyscope::options::usePrefsFile = false;
+  polyscope::options::errorsThrowExceptions = true;
+  polyscope::init(backend);
+
+  for (size_t n = 1000; n <= maxSize; n *= 10) {
+    benchmarkSize(n);
+  }
+  for (size_t n = 10; n <= maxStructures; n *= 10) {
+    benchmarkOverhead(n);
+  }
+
+  polyscope::shutdown();
+  return 0;
+}
@@ -158,6 +158,33 @@ struct FakeMatrix {
 };
 FakeMatrix fakeMatrix_int{{{1, 2, 3}, {4, 5, 6}}};
 
+// A wannabe Eigen matrix exposing its strided storage, with 2 rows and 3 columns
+template <class S, bool RowMajor>
+struct FakeStridedMatrix {
+  static const bool IsRowMajor = RowMajor;
+  std::vector<S> myData;
+  long long int stride;
+  long long int rows() const { return 2; }
+  long long int cols() const { return 3; }
+  long long int innerStride() const { return 1; }
+  long long int outerStride() const { return stride; }
+  const S* data() const { return myData.data(); }
+  S operator()(int i, int j) const { return RowMajor ? myData[stride * i + j] : myData[stride * j + i]; }
+};
+FakeStridedMatrix<double, true> fakeStridedMatrix_rowMajor{{1., 2., 3., -1., 4., 5., 6., -1.}, 4};
+FakeStridedMatrix<double, false> fakeStridedMatrix_colMajor{{1., 4., 2., 5., 3., 6.}, 2};
+FakeStridedMatrix<float, true> fakeStridedMatrix_packedFloat{{1., 2., 3., 4., 5., 6.}, 3};
+
+// A wannabe Eigen vector, every other entry of its storage
+struct FakeStridedVector {
+  std::vector<float> myData;
+  size_t size() const { return myData.size() / 2; }
+  long long int innerStride() const { return 2; }
+  const float* data() const { return myData.data(); }
+  float operator[](size_t i) const { return myData[2 * i]; }
+};
+FakeStridedVector fakeStridedVector{{0.1, -1., 0.2, -1., 0.3, -1.}};
+
 
 // Nested list access with paren-vector
 struct UserArrayParenBracketCustom {
@@ -349,6 +376,34 @@ TEST(ArrayAdaptorTests, adaptor_array_vectors) {
 }
 
 
+// Test that the direct reads of .data() storage match element access
+TEST(ArrayAdaptorTests, adaptor_contiguous_storage) {
+
+  // scalar arrays, with and without conversion
+  EXPECT_EQ(polyscope::standardizeArray<double>(arr_vecdouble)[4], .5);
+  EXPECT_EQ(polyscope::standardizeArray<float>(arr_vecdouble)[4], .5f);
+  EXPECT_EQ(polyscope::standardizeArray<uint32_t>(arr_vecint)[2], 3u);
+  EXPECT_EQ(polyscope::standardizeArray<double>(std::vector<double>{}).size(), 0u);
+  std::vector<float> stridedVals = polyscope::standardizeArray<float>(fakeStridedVector);
+  ASSERT_EQ(stridedVals.size(), 3u);
+  EXPECT_EQ(stridedVals[2], 0.3f);
+
+  // arrays of the output type
+  std::vector<glm::vec3> vec3s{{0.1, 0.2, 0.3}, {0.4, 0.5, 0.6}};
+  EXPECT_EQ((polyscope::standardizeVectorArray<glm::vec3, 3>(vec3s))[1], vec3s[1]);
+
+  // strided matrices in either order
+  for (const std::vector<glm::vec3>& vals :
+       {polyscope::standardizeVectorArray<glm::vec3, 3>(fakeStridedMatrix_rowMajor),
+        polyscope::standardizeVectorArray<glm::vec3, 3>(fakeStridedMatrix_colMajor)}) {
+    ASSERT_EQ(vals.size(), 2u);
+    EXPECT_EQ(vals[0], glm::vec3(1., 2., 3.));
+    EXPECT_EQ(vals[1], glm::vec3(4., 5., 6.));
+  }
+  EXPECT_EQ((polyscope::standardizeVectorArray<glm::vec3, 3>(fakeStridedMatrix_packedFloat))[1], glm::vec3(4., 5., 6.));
+}
+
+
 // Test that nested access works
 TEST(ArrayAdaptorTests, adaptor_nested_array) {
 
@@ -390,3 +445,25 @@ TEST(ArrayAdaptorTests, adaptor_nested_array) {
   EXPECT_EQ(dataEntries[6], 7);
   EXPECT_EQ(dataStarts[2], 7);
 }
+
+// Test that large ragged inputs, which are converted in parallel chunks, are laid out in order
+TEST(ArrayAdaptorTests, adaptor_nested_array_large) {
+  size_t N = 100000;
+  std::vector<std::vector<int>> ragged(N);
+  for (size_t i = 0; i < N; i++) {
+    for (size_t j = 0; j < 3 + i % 3; j++) ragged[i].push_back(static_cast<int>(i + j));
+  }
+
+  std::tuple<std::vector<uint32_t>, std::vector<uint32_t>> nestedListTup =
+      polyscope::standardizeNestedList<uint32_t, uint32_t>(ragged);
+  std::vector<uint32_t>& dataEntries = std::get<0>(nestedListTup);
+  std::vector<uint32_t>& dataStarts = std::get<1>(nestedListTup);
+  ASSERT_EQ(dataStarts.size(), N + 1);
+  EXPECT_EQ(dataStarts[0], 0u);
+  EXPECT_EQ(dataStarts[N], dataEntries.size());
+  for (size_t i = 0; i < N; i++) {
+    ASSERT_EQ(dataStarts[i + 1] - dataStarts[i], ragged[i].size());
+    EXPECT_EQ(dataEntries[dataStarts[i]], i);
+    EXPECT_EQ(dataEntries[dataStarts[i + 1] - 1], i + ragged[i].size() - 1);
+  }
+}
@@ -2,7 +2,9 @@
 
 #include "polyscope_test.h"
 
+#include "polyscope/adaptive_quality.h"
 #include "polyscope/curve_network.h"
+#include "polyscope/image_encoders.h"
 #include "polyscope/pick.h"
 #include "polyscope/point_cloud.h"
 #include "polyscope/polyscope.h"
@@ -13,9 +15,14 @@
 #include "gtest/gtest.h"
 
 #include <array>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <list>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 
@@ -109,6 +116,659 @@ TEST_F(PolyscopeTest, ScreenshotBuffer) {
   EXPECT_EQ(buff2.size(), polyscope::view::bufferWidth * polyscope::view::bufferHeight * 4);
 }
 
+TEST_F(PolyscopeTest, RenderToExternalTexture) {
+  auto psMesh = registerTriangleMesh();
+
+  // rendering to the same texture again reuses its framebuffer
+  polyscope::renderToExternalTexture(7, 64, 48);
+  auto target = polyscope::render::engine->externalTargetBuffer;
+  polyscope::renderToExternalTexture(7, 64, 48, false);
+  EXPECT_EQ(polyscope::render::engine->externalTargetBuffer, target);
+  polyscope::renderToExternalTexture(8, 64, 48);
+  EXPECT_NE(polyscope::render::engine->externalTargetBuffer, target);
+  EXPECT_EQ(polyscope::render::engine->externalTargetBuffer->getSizeX(), 64u);
+
+  EXPECT_THROW(polyscope::renderToExternalTexture(8, 0, 48), std::runtime_error);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ScreenshotAsync) {
+  polyscope::screenshotAsync("test_screeshot_async.png");
+  polyscope::screenshotAsync("test_screeshot_async.jpg", false);
+  for (int i = 0; i < 10; i++) {
+    polyscope::screenshotAsync();
+    polyscope::show(1);
+  }
+  polyscope::flushScreenshots();
+  polyscope::flushScreenshots();
+}
+
+TEST_F(PolyscopeTest, ScreenshotFormats) {
+  for (std::string ext : {".png", ".qoi", ".tga", ".ppm", ".jpg"}) {
+    polyscope::screenshot("test_screeshot_format" + ext);
+  }
+  polyscope::options::screenshotFormat = polyscope::ImageFormat::PNG;
+  polyscope::screenshotAsync("test_screeshot_format_stb.png");
+  polyscope::options::screenshotFormat = polyscope::ImageFormat::QOI;
+  polyscope::screenshotAsync("test_screeshot_format_explicit.img");
+  polyscope::flushScreenshots();
+  polyscope::options::screenshotFormat = polyscope::ImageFormat::Auto;
+
+  EXPECT_EQ(polyscope::resolveImageFormat("a.JPEG"), polyscope::ImageFormat::JPEG);
+  EXPECT_EQ(polyscope::resolveImageFormat("a.png"), polyscope::ImageFormat::FastPNG);
+  EXPECT_EQ(polyscope::resolveImageFormat("a.png", polyscope::ImageFormat::TGA), polyscope::ImageFormat::TGA);
+
+  // a 2x2 gray image, bottom row first
+  std::vector<unsigned char> pixels = {10, 20, 30, 40};
+  std::vector<unsigned char> ppm = polyscope::encodeImagePPM(pixels.data(), 2, 2, 1);
+  std::vector<unsigned char> expected = {'P', '5', '\n', '2', ' ', '2', '\n', '2', '5', '5', '\n', 30, 40, 10, 20};
+  EXPECT_EQ(ppm, expected);
+
+  std::vector<unsigned char> png = polyscope::encodeImageFastPNG(pixels.data(), 2, 2, 1);
+  ASSERT_GT(png.size(), 8u);
+  EXPECT_EQ(png[1], 'P');
+  std::vector<unsigned char> qoi = polyscope::encodeImageQOI(pixels.data(), 2, 2, 1);
+  EXPECT_EQ(qoi[0], 'q');
+}
+
+TEST_F(PolyscopeTest, FrameStats) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::options::collectFrameStats = true;
+  polyscope::options::alwaysRedraw = true;
+  polyscope::show(3);
+
+  polyscope::FrameStats stats = polyscope::getFrameStats();
+  EXPECT_GT(stats.frameIndex, 0u);
+  EXPECT_GE(stats.cpuMs, 0.);
+  bool foundMesh = false;
+  for (const polyscope::FrameSectionStats& section : stats.sections) {
+    if (section.name.find(psMesh->name) != std::string::npos) foundMesh = true;
+  }
+  EXPECT_TRUE(foundMesh);
+  EXPECT_GT(stats.drawCalls, 0u);
+
+  polyscope::options::collectFrameStats = false;
+  polyscope::options::alwaysRedraw = false;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, FramePacing) {
+  polyscope::options::maxFPS = 200;
+  polyscope::show(5);
+
+  // frames are paced to the target, and the distribution is kept without collectFrameStats
+  polyscope::FrameTimeDistribution frameTimes = polyscope::getFrameStats().frameTimes;
+  EXPECT_GT(frameTimes.nFrames, 0u);
+  EXPECT_GE(frameTimes.minMs, 0.);
+  EXPECT_LE(frameTimes.minMs, frameTimes.medianMs);
+  EXPECT_LE(frameTimes.medianMs, frameTimes.p95Ms);
+  EXPECT_LE(frameTimes.p99Ms, frameTimes.maxMs);
+  EXPECT_GE(frameTimes.medianMs, 4.);
+  EXPECT_GT(polyscope::getPredictedFrameWorkMs(), 0.);
+
+  // the mock backend has no display rate, so late polling falls back to the grid
+  polyscope::options::latePollEvents = true;
+  polyscope::options::maxFPS = -1;
+  polyscope::show(3);
+  polyscope::options::latePollEvents = false;
+  polyscope::options::maxFPS = 60;
+}
+
+TEST_F(PolyscopeTest, IdleWhenUnchanged) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::options::idleWhenUnchanged = true;
+
+  // the mock backend has no events to wait on, so idle frames return right away
+  polyscope::show(10);
+
+  // requests from other threads and queued updates wake the loop
+  std::thread other([&]() {
+    polyscope::requestRedraw();
+    polyscope::queueUpdate([&]() { psMesh->setSurfaceColor(glm::vec3{1., 0., 0.}); });
+  });
+  other.join();
+  polyscope::show(10);
+  EXPECT_EQ(psMesh->getSurfaceColor(), glm::vec3(1., 0., 0.));
+
+  polyscope::options::idleWhenUnchanged = false;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SceneLayerReuse) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::show(3);
+
+  // frames without changes reuse the scene of the previous frame
+  size_t reusesBefore = polyscope::render::engine->stats.sceneReuses;
+  polyscope::show(3);
+  EXPECT_GT(polyscope::render::engine->stats.sceneReuses, reusesBefore);
+
+  // a change renders it again
+  size_t rendersBefore = polyscope::render::engine->stats.sceneRenders;
+  psMesh->setSurfaceColor(glm::vec3{1., 0., 0.});
+  polyscope::show(3);
+  EXPECT_GT(polyscope::render::engine->stats.sceneRenders, rendersBefore);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SceneDepthCache) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::view::lookAt(glm::vec3{0., 0., 5.}, glm::vec3{0., 0., 0.});
+  polyscope::show(3);
+
+  // queries use the depth copied after the last render, along with the camera it was rendered with
+  glm::vec2 center{polyscope::view::windowWidth / 2., polyscope::view::windowHeight / 2.};
+  glm::vec3 cachedPos = polyscope::view::screenCoordsToWorldPosition(center);
+  polyscope::view::lookAt(glm::vec3{0., 0., 8.}, glm::vec3{0., 0., 0.});
+  EXPECT_EQ(polyscope::view::screenCoordsToWorldPosition(center), cachedPos);
+
+  // without the cache the depth buffer is read directly, with the current camera
+  polyscope::options::sceneDepthCache = false;
+  EXPECT_NE(polyscope::view::screenCoordsToWorldPosition(center), cachedPos);
+  polyscope::show(3);
+  polyscope::options::sceneDepthCache = true;
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, OcclusionCulling) {
+  // the mock engine reports a depth of 0.5 everywhere, which is in front of anything not right at the near plane
+  auto psPoints = registerPointCloud("points");
+  polyscope::view::lookAt(glm::vec3{0., 0., 5.}, glm::vec3{0., 0., 0.});
+  polyscope::options::occlusionCulling = true;
+  polyscope::show(3);
+  polyscope::requestRedraw();
+  polyscope::show(3);
+  EXPECT_TRUE(psPoints->isOccluded());
+  EXPECT_FALSE(psPoints->isInViewFrustum());
+  EXPECT_EQ(polyscope::render::engine->stats.structuresCulled, 1u);
+  EXPECT_EQ(polyscope::render::engine->stats.structuresOccluded, 1u);
+
+  // the depth is not used once the camera moves
+  polyscope::view::lookAt(glm::vec3{0., 0., 6.}, glm::vec3{0., 0., 0.});
+  EXPECT_FALSE(psPoints->isOccluded());
+  EXPECT_TRUE(psPoints->isInViewFrustum());
+
+  polyscope::options::occlusionCulling = false;
+  polyscope::show(3);
+  EXPECT_FALSE(psPoints->isOccluded());
+  EXPECT_EQ(polyscope::render::engine->stats.structuresOccluded, 0u);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, Viewports) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::view::lookAt(glm::vec3{0., 0., 5.}, glm::vec3{0., 0., 0.});
+  glm::mat4 mainView = polyscope::view::getCameraViewMatrix();
+
+  polyscope::view::setQuadViewLayout();
+  EXPECT_EQ(polyscope::view::getViewportCount(), 3u);
+  EXPECT_TRUE(polyscope::view::hasViewport("top"));
+  EXPECT_EQ(polyscope::view::getMainViewportRegion(), glm::vec4(0.5, 0.5, 0.5, 0.5));
+  polyscope::show(3);
+
+  // the bottom left quarter is the front view
+  glm::vec2 frontCenter{polyscope::view::windowWidth / 4., 3. * polyscope::view::windowHeight / 4.};
+  EXPECT_EQ(polyscope::view::getViewportAtScreenCoords(frontCenter), 1);
+  polyscope::view::beginViewport(1);
+  polyscope::pick::pickAtScreenCoords(frontCenter);
+  polyscope::view::screenCoordsToWorldPosition(frontCenter);
+  polyscope::view::processZoom(1.);
+  polyscope::view::endViewport();
+
+  // navigating a viewport leaves the main view alone
+  EXPECT_EQ(polyscope::view::getCameraViewMatrix(), mainView);
+  polyscope::show(3);
+
+  polyscope::view::removeAllViewports();
+  EXPECT_EQ(polyscope::view::getViewportCount(), 0u);
+  EXPECT_EQ(polyscope::view::getMainViewportRegion(), glm::vec4(0., 0., 1., 1.));
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, StructureHandles) {
+  auto psMesh = registerTriangleMesh("mesh");
+  auto psPoints = registerPointCloud("points");
+  polyscope::StructureHandle meshHandle = psMesh->getHandle();
+  EXPECT_NE(meshHandle, polyscope::INVALID_STRUCTURE_HANDLE);
+  EXPECT_NE(meshHandle, psPoints->getHandle());
+  EXPECT_EQ(polyscope::getStructure(meshHandle), psMesh);
+  EXPECT_EQ(polyscope::getStructure("Point Cloud", "points"), psPoints);
+  EXPECT_TRUE(polyscope::hasStructure("Surface Mesh", "mesh"));
+  EXPECT_FALSE(polyscope::hasStructure("Surface Mesh", "points"));
+
+  // disabled structures are left out of the draw list, and come back when enabled
+  psPoints->setEnabled(false);
+  polyscope::show(3);
+  psPoints->setEnabled(true);
+  polyscope::show(3);
+
+  // a removed structure's handle stays invalid, even once its slot is reused
+  polyscope::removeStructure("mesh");
+  EXPECT_EQ(polyscope::getStructure(meshHandle), nullptr);
+  psMesh = registerTriangleMesh("mesh2");
+  EXPECT_EQ(polyscope::getStructure(meshHandle), nullptr);
+  EXPECT_EQ(polyscope::getStructure(psMesh->getHandle()), psMesh);
+  EXPECT_EQ(polyscope::getStructure(polyscope::INVALID_STRUCTURE_HANDLE), nullptr);
+  polyscope::show(3);
+
+  polyscope::StructureHandle mesh2Handle = psMesh->getHandle();
+  polyscope::removeAllStructures();
+  EXPECT_EQ(polyscope::getStructure(mesh2Handle), nullptr);
+}
+
+TEST_F(PolyscopeTest, TransformedBoundingBox) {
+  auto psMesh = registerTriangleMesh();
+  glm::mat4 T = glm::rotate(glm::mat4(1.), 0.7f, glm::vec3{0., 0., 1.});
+  psMesh->setTransform(T);
+
+  // the box of the rotated structure holds all of its transformed vertices
+  glm::vec3 bMin, bMax;
+  std::tie(bMin, bMax) = psMesh->boundingBox();
+  for (glm::vec3 p : std::get<0>(getTriangleMesh())) {
+    glm::vec3 pT = glm::vec3(T * glm::vec4(p, 1.));
+    for (int i = 0; i < 3; i++) {
+      EXPECT_LE(bMin[i], pT[i] + 1e-5);
+      EXPECT_GE(bMax[i], pT[i] - 1e-5);
+    }
+  }
+  EXPECT_EQ(std::get<0>(polyscope::state::boundingBox), bMin);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, AdaptiveQuality) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::options::adaptiveQuality = true;
+  polyscope::options::adaptiveQualityTargetFrameMs = 0.; // every frame is too slow
+  polyscope::options::adaptiveQualityRestoreDelay = 100.;
+
+  // camera interaction steps the quality down
+  polyscope::markCameraInteraction();
+  polyscope::show(10);
+  EXPECT_TRUE(polyscope::adaptiveQualityIsReduced());
+  EXPECT_LE(polyscope::adaptiveQualityRenderPasses(), 1);
+  EXPECT_LT(polyscope::render::engine->getSceneResolutionScale(), 1.);
+
+  // full quality is restored once the camera is still
+  polyscope::options::adaptiveQualityRestoreDelay = 0.;
+  polyscope::show(3);
+  EXPECT_FALSE(polyscope::adaptiveQualityIsReduced());
+  EXPECT_EQ(polyscope::render::engine->getSceneResolutionScale(), 1.);
+
+  polyscope::options::adaptiveQuality = false;
+  polyscope::options::adaptiveQualityTargetFrameMs = 33.;
+  polyscope::options::adaptiveQualityRestoreDelay = 0.25;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, TemporalAntiAliasing) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::options::temporalAntiAliasing = true;
+  polyscope::show(3);
+  EXPECT_TRUE(polyscope::render::engine->getTemporalAntiAliasing());
+
+  // a still scene is rendered until all jitter positions are accumulated, then reused
+  polyscope::show(polyscope::options::temporalAntiAliasingSamples + 2);
+  EXPECT_FALSE(polyscope::render::engine->temporalAntiAliasingPending());
+  size_t rendersBefore = polyscope::render::engine->stats.sceneRenders;
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::render::engine->stats.sceneRenders, rendersBefore);
+
+  // a change starts a new accumulation, which screenshots wait for
+  psMesh->setSurfaceColor(glm::vec3{1., 0., 0.});
+  polyscope::show(1);
+  EXPECT_TRUE(polyscope::render::engine->temporalAntiAliasingPending());
+  polyscope::screenshot("test_screeshot_taa.png");
+  EXPECT_FALSE(polyscope::render::engine->temporalAntiAliasingPending());
+
+  polyscope::options::temporalAntiAliasing = false;
+  polyscope::show(1);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, FXAA) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::options::fxaa = true;
+  polyscope::show(3);
+  EXPECT_TRUE(polyscope::render::engine->getFXAA());
+  polyscope::screenshot("test_screeshot_fxaa.png");
+
+  // along with transparency and SSAA, which skips it
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Simple;
+  polyscope::show(3);
+  polyscope::options::ssaaFactor = 2;
+  polyscope::show(3);
+
+  polyscope::options::ssaaFactor = 1;
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+  polyscope::options::fxaa = false;
+  polyscope::show(1);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, Recorder) {
+  polyscope::startRecording("test_recording.y4m", 24.);
+  EXPECT_TRUE(polyscope::isRecording());
+  polyscope::show(3);
+  polyscope::stopRecording();
+  EXPECT_FALSE(polyscope::isRecording());
+
+  // restarting stops the previous recording
+  polyscope::startRecording("test_recording.rgba", 30., polyscope::RecordingFormat::Raw);
+  polyscope::show(3);
+  polyscope::startRecording("test_recording2.rgba", 30., polyscope::RecordingFormat::Raw);
+  polyscope::show(3);
+  polyscope::stopRecording();
+  polyscope::stopRecording();
+
+  EXPECT_THROW(polyscope::startRecording("test_recording.y4m", 0.), std::runtime_error);
+  EXPECT_FALSE(polyscope::isRecording());
+}
+
+TEST_F(PolyscopeTest, RemoteSession) {
+  std::mutex messagesMutex;
+  std::vector<std::vector<unsigned char>> messages;
+  polyscope::startRemoteSession([&](const std::vector<unsigned char>& message) {
+    std::lock_guard<std::mutex> lock(messagesMutex);
+    messages.push_back(message);
+  });
+  EXPECT_TRUE(polyscope::isRemoteSessionActive());
+  polyscope::show(3);
+
+  // acknowledge the first frame and send some input
+  unsigned char ack[] = {'P', 'S', 'R', 'I', 0, 1, 0, 0, 0};
+  EXPECT_TRUE(polyscope::receiveRemoteMessage(ack, sizeof(ack)));
+  unsigned char button[] = {'P', 'S', 'R', 'I', 2, 0, 1};
+  EXPECT_TRUE(polyscope::receiveRemoteMessage(button, sizeof(button)));
+  unsigned char truncated[] = {'P', 'S', 'R', 'I', 1, 0};
+  EXPECT_FALSE(polyscope::receiveRemoteMessage(truncated, sizeof(truncated)));
+  polyscope::RemoteInputEvent move;
+  move.type = polyscope::RemoteInputType::MouseMove;
+  move.x = 0.5f;
+  move.y = 0.5f;
+  polyscope::pushRemoteInputEvent(move);
+  polyscope::requestRemoteKeyframe();
+  polyscope::show(3);
+  polyscope::stopRemoteSession();
+  EXPECT_FALSE(polyscope::isRemoteSessionActive());
+
+  // the first frame holds every tile
+  ASSERT_FALSE(messages.empty());
+  const std::vector<unsigned char>& first = messages.front();
+  ASSERT_GE(first.size(), 20u);
+  EXPECT_EQ(std::string(first.begin(), first.begin() + 4), "PSRF");
+  size_t encodedWidth = first[12] | (first[13] << 8);
+  size_t encodedHeight = first[14] | (first[15] << 8);
+  size_t tileSize = first[16] | (first[17] << 8);
+  size_t nTiles = first[18] | (first[19] << 8);
+  EXPECT_EQ(nTiles, ((encodedWidth + tileSize - 1) / tileSize) * ((encodedHeight + tileSize - 1) / tileSize));
+
+  polyscope::RemoteSessionStats stats = polyscope::getRemoteSessionStats();
+  EXPECT_EQ(stats.framesSent, messages.size());
+  EXPECT_GT(stats.framesSent + stats.framesUnchanged + stats.framesSkipped, 0u);
+  polyscope::stopRemoteSession();
+}
+
+TEST_F(PolyscopeTest, UpdateQueue) {
+  auto psPoints = registerPointCloud();
+  std::vector<glm::vec3> moved = getPoints();
+  for (glm::vec3& p : moved) p = 2.f * p;
+
+  // keyed updates replace each other until the sync point
+  int nRun = 0;
+  polyscope::queueUpdate("positions", [&]() { nRun += 10; });
+  polyscope::queueUpdate("positions", [&]() {
+    nRun++;
+    psPoints->updatePointPositions(moved);
+  });
+  polyscope::queueUpdate([&]() { nRun++; });
+  EXPECT_EQ(nRun, 0);
+  polyscope::show(1);
+  EXPECT_EQ(nRun, 2);
+  EXPECT_EQ(psPoints->points.getValue(0), moved[0]);
+
+  // a background thread which hands its results over and waits for them to be applied
+  std::atomic<int> nSteps{0};
+  int nApplied = 0;
+  polyscope::startBackgroundCallback([&]() {
+    nSteps++;
+    polyscope::queueUpdate("step", [&]() { nApplied++; });
+    polyscope::waitForQueuedUpdates();
+  });
+  EXPECT_TRUE(polyscope::isBackgroundCallbackRunning());
+  EXPECT_THROW(polyscope::startBackgroundCallback([]() {}), std::runtime_error);
+  for (int i = 0; i < 1000 && nApplied == 0; i++) {
+    polyscope::frameTick();
+  }
+  polyscope::stopBackgroundCallback();
+  EXPECT_FALSE(polyscope::isBackgroundCallbackRunning());
+  EXPECT_GT(nApplied, 0);
+  EXPECT_LE(nApplied, nSteps.load());
+
+  // errors in the background surface on the render thread, here when the remaining updates run on stopping
+  polyscope::startBackgroundCallback([]() { throw std::runtime_error("solver diverged"); });
+  EXPECT_THROW(polyscope::stopBackgroundCallback(), std::runtime_error);
+  EXPECT_FALSE(polyscope::isBackgroundCallbackRunning());
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, RenderBatch) {
+  auto psMesh = registerTriangleMesh();
+
+  std::vector<polyscope::BatchRenderView> views;
+  for (int i = 0; i < 5; i++) {
+    polyscope::view::lookAt(glm::vec3{2.f, 1.f, 1.f + i}, glm::vec3{0.f, 0.f, 0.f});
+    views.push_back({polyscope::view::getCameraParametersForCurrentView(),
+                     "test_batch_" + std::to_string(i) + (i % 2 == 0 ? ".png" : ".jpg")});
+  }
+  polyscope::renderBatch(views);
+  polyscope::renderBatch(views, false);
+  polyscope::renderBatch({});
+
+  // shards cover the views between them
+  for (size_t iShard = 0; iShard < 3; iShard++) {
+    polyscope::renderBatchShard(views, iShard, 3);
+  }
+  polyscope::renderBatchShard(views, 7, 8);
+  EXPECT_THROW(polyscope::renderBatchShard(views, 3, 3), std::runtime_error);
+  EXPECT_THROW(polyscope::renderBatchShard(views, 0, 0), std::runtime_error);
+
+  // devices can be listed whatever the backend, even if there are none
+  EXPECT_NO_THROW(polyscope::listEGLDevices());
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, MultiviewRender) {
+  auto psMesh = registerTriangleMesh();
+  int bufferWidth = polyscope::view::bufferWidth;
+  int bufferHeight = polyscope::view::bufferHeight;
+  glm::mat4 viewMat = polyscope::view::getCameraViewMatrix();
+
+  polyscope::CubemapImages cubemap = polyscope::renderCubemap(glm::vec3{0., 0., 3.}, 64);
+  EXPECT_EQ(cubemap.faceSize, 64);
+  for (const std::vector<unsigned char>& face : cubemap.faces) {
+    EXPECT_EQ(face.size(), 64u * 64u * 4u);
+  }
+
+  polyscope::StereoImages stereo = polyscope::renderStereoPair(0.1, 2., false);
+  EXPECT_EQ(stereo.left.size(), static_cast<size_t>(stereo.width) * stereo.height * 4);
+  EXPECT_EQ(stereo.right.size(), stereo.left.size());
+
+  // the view is left as it was
+  EXPECT_EQ(polyscope::view::bufferWidth, bufferWidth);
+  EXPECT_EQ(polyscope::view::bufferHeight, bufferHeight);
+  EXPECT_EQ(polyscope::view::getCameraViewMatrix(), viewMat);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, DepthPrepass) {
+  auto psMesh = registerTriangleMesh();
+  auto psPoints = registerPointCloud();
+  psPoints->addScalarQuantity("vals", std::vector<double>(psPoints->nPoints(), 0.5))->setEnabled(true);
+
+  polyscope::options::depthPrepass = true;
+  polyscope::show(3);
+  EXPECT_TRUE(polyscope::render::engine->getDepthPrepass());
+  EXPECT_EQ(polyscope::render::engine->depthPrepassStage, 0);
+
+  // transparent structures are left out of the prepass
+  psMesh->setTransparency(0.5);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Simple;
+  polyscope::show(3);
+
+  // the multi-pass transparency modes do not use it
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Pretty;
+  polyscope::show(3);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+  psMesh->setTransparency(1.);
+
+  polyscope::options::depthPrepass = false;
+  polyscope::show(3);
+  EXPECT_FALSE(polyscope::render::engine->getDepthPrepass());
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, RenderTargetBudget) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Simple;
+  polyscope::show(3);
+  size_t fullBytes = polyscope::render::getDeviceMemoryUsage().totalBytes();
+
+  // the final buffer shares storage with the scene buffer
+  polyscope::options::renderTargetBudget = true;
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::render::engine->sceneBufferFinal, polyscope::render::engine->sceneBuffer);
+  EXPECT_LT(polyscope::render::getDeviceMemoryUsage().totalBytes(), fullBytes);
+
+  // depth peeling needs a separate one again
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Pretty;
+  polyscope::show(3);
+  EXPECT_NE(polyscope::render::engine->sceneBufferFinal, polyscope::render::engine->sceneBuffer);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::WeightedBlended;
+  polyscope::show(3);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+  polyscope::show(3);
+
+  polyscope::options::renderTargetBudget = false;
+  polyscope::show(3);
+  EXPECT_NE(polyscope::render::engine->sceneBufferFinal, polyscope::render::engine->sceneBuffer);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PrewarmShaders) {
+  using polyscope::render::ShaderProgramRequest;
+  polyscope::options::asyncShaderCompilation = true;
+
+  polyscope::render::engine->prewarmShaders({ShaderProgramRequest("MESH", {"SHADE_BASECOLOR"}),
+                                             ShaderProgramRequest("RAYCAST_SPHERE", {"SHADE_BASECOLOR"})});
+  EXPECT_THROW(polyscope::render::engine->prewarmShaders({ShaderProgramRequest("NOT_A_PROGRAM")}), std::runtime_error);
+
+  // Draws with programs which are still compiling are skipped, the mock compiles synchronously
+  auto psMesh = registerTriangleMesh();
+  polyscope::show(3);
+  EXPECT_FALSE(polyscope::render::engine->shaderCompilesPending());
+
+  polyscope::options::asyncShaderCompilation = false;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, InterleaveVertexAttributes) {
+  polyscope::options::interleaveVertexAttributes = true;
+
+  // every write to an attribute buffer changes its content version, which is how interleaved copies go stale
+  std::shared_ptr<polyscope::render::AttributeBuffer> buff =
+      polyscope::render::engine->generateAttributeBuffer(polyscope::RenderDataType::Float);
+  uint64_t v0 = buff->getContentVersion();
+  buff->setData(std::vector<float>{1., 2., 3.});
+  uint64_t v1 = buff->getContentVersion();
+  EXPECT_NE(v0, v1);
+  buff->setDataRange(std::vector<float>{4.}, 0, 1, 1);
+  EXPECT_NE(buff->getContentVersion(), v1);
+
+  // draw, then write some attributes and draw again
+  auto psMesh = registerTriangleMesh();
+  auto psPoints = registerPointCloud();
+  polyscope::show(3);
+  std::vector<glm::vec3> newPositions(psMesh->nVertices(), glm::vec3{0.5, 0.5, 0.5});
+  psMesh->updateVertexPositions(newPositions);
+  polyscope::show(3);
+
+  polyscope::options::interleaveVertexAttributes = false;
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ShaderVariantTable) {
+  using polyscope::render::ShaderProgramRequest;
+  polyscope::options::shaderCacheDirectory = ::testing::TempDir();
+  std::string tablePath = polyscope::options::shaderCacheDirectory;
+  if (tablePath.back() != '/' && tablePath.back() != '\\') tablePath += '/';
+  tablePath += "polyscope_shader_variants.txt";
+  std::remove(tablePath.c_str());
+
+  // Newly compiled variants are recorded, once each
+  polyscope::render::engine->prewarmShaders({ShaderProgramRequest("MESH", {"SHADE_BASECOLOR", "", "SHADE_BASECOLOR"}),
+                                             ShaderProgramRequest("MESH", {"SHADE_BASECOLOR", "", "SHADE_BASECOLOR"})});
+  std::vector<ShaderProgramRequest> variants = polyscope::render::engine->loadShaderVariantTable();
+  ASSERT_EQ(variants.size(), 1u);
+  EXPECT_EQ(variants[0].programName, "MESH");
+  EXPECT_EQ(variants[0].customRules, std::vector<std::string>({"SHADE_BASECOLOR", "", "SHADE_BASECOLOR"}));
+  EXPECT_EQ(variants[0].defaults, polyscope::render::ShaderReplacementDefaults::SceneObject);
+
+  // Entries which can't be compiled in this run are skipped
+  {
+    std::ofstream outFile(tablePath, std::ios::app);
+    outFile << "0\tMESH\tNOT_A_RULE\n";
+    outFile << "garbage\n";
+  }
+  EXPECT_EQ(polyscope::render::engine->loadShaderVariantTable().size(), 2u);
+  polyscope::render::engine->prewarmShaderVariantTable();
+
+  std::remove(tablePath.c_str());
+  polyscope::options::shaderCacheDirectory = "";
+}
+
+TEST_F(PolyscopeTest, DefaultMaterials) {
+  // Built-in material textures are loaded as each one is first used
+  auto psMesh = registerTriangleMesh();
+  for (std::string mat : {"clay", "wax", "candy", "flat", "mud", "ceramic", "jade", "normal"}) {
+    psMesh->setMaterial(mat);
+    polyscope::show(3);
+  }
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, MaterialArraySwitch) {
+  // The matcaps share a texture array, switching between them does not rebuild programs
+  EXPECT_FALSE(polyscope::render::engine->materialChangeNeedsRefresh("clay", "wax"));
+  EXPECT_FALSE(polyscope::render::engine->materialChangeNeedsRefresh("candy", "jade"));
+  EXPECT_TRUE(polyscope::render::engine->materialChangeNeedsRefresh("clay", "flat"));
+
+  auto psPoints = registerPointCloud();
+  auto psMesh = registerTriangleMesh();
+  psMesh->addVertexScalarQuantity("vals", std::vector<double>(psMesh->nVertices(), 0.5))->setEnabled(true);
+  for (std::string mat : {"wax", "mud", "flat", "normal", "clay"}) {
+    psPoints->setMaterial(mat);
+    psMesh->setMaterial(mat);
+    polyscope::show(3);
+  }
+  polyscope::removeAllStructures();
+}
+
 // ============================================================
 // =============== Ground plane tests
 // ============================================================
@@ -130,10 +790,24 @@ TEST_F(PolyscopeTest, GroundPlaneTest) {
   polyscope::refresh();
   polyscope::show(3);
 
+  for (polyscope::GroundReflectionMode m : {polyscope::GroundReflectionMode::ReducedMirror,
+                                            polyscope::GroundReflectionMode::ScreenSpace,
+                                            polyscope::GroundReflectionMode::Mirror}) {
+    polyscope::options::groundReflectionMode = m;
+    polyscope::show(3);
+  }
+
   polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::ShadowOnly;
   polyscope::refresh();
   polyscope::show(3);
 
+  // repeated renders of an unchanged scene reuse the shadow, also with SSAA
+  polyscope::options::alwaysRedraw = true;
+  polyscope::options::ssaaFactor = 2;
+  polyscope::show(3);
+  polyscope::options::ssaaFactor = 1;
+  polyscope::options::alwaysRedraw = false;
+
   polyscope::options::groundPlaneHeightMode = polyscope::GroundPlaneHeightMode::Manual;
   polyscope::options::groundPlaneHeight = -0.3;
   polyscope::show(3);
@@ -143,3 +817,86 @@ TEST_F(PolyscopeTest, GroundPlaneTest) {
 
   polyscope::removeAllStructures();
 }
+
+TEST_F(PolyscopeTest, LongStructureList) {
+  // long lists of structures and quantities only build the rows in view
+  for (int i = 0; i < 200; i++) {
+    registerPointCloud("points" + std::to_string(i));
+  }
+  polyscope::PointCloud* psPoints = polyscope::getPointCloud("points0");
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  for (int i = 0; i < 20; i++) {
+    psPoints->addScalarQuantity("vScalar" + std::to_string(i), vScalar);
+  }
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, LazyStructureSubsystems) {
+  // the transform gizmo is only created when it is shown
+  size_t nWidgets = polyscope::state::widgets.size();
+  for (int i = 0; i < 100; i++) {
+    registerPointCloud("points" + std::to_string(i));
+  }
+  EXPECT_EQ(polyscope::state::widgets.size(), nWidgets);
+  polyscope::PointCloud* psPoints = polyscope::getPointCloud("points0");
+  EXPECT_FALSE(psPoints->getTransformGizmoEnabled());
+  size_t overhead = psPoints->getMemoryUsage().overheadBytes;
+  EXPECT_GT(overhead, 0u);
+
+  psPoints->setTransformGizmoEnabled(true);
+  EXPECT_TRUE(psPoints->getTransformGizmoEnabled());
+  EXPECT_EQ(polyscope::state::widgets.size(), nWidgets + 1);
+  EXPECT_GT(psPoints->getMemoryUsage().overheadBytes, overhead);
+  polyscope::show(3);
+
+  psPoints->setTransformGizmoEnabled(false);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, StructureBatch) {
+  registerPointCloud("points");
+  float lengthScale = polyscope::state::lengthScale;
+
+  // the extents are only updated when the outermost batch ends
+  std::vector<glm::vec3> farPoints = {{100., 100., 100.}, {-100., -100., -100.}};
+  polyscope::beginStructureBatch();
+  polyscope::beginStructureBatch();
+  for (int i = 0; i < 10; i++) {
+    polyscope::registerPointCloud("far" + std::to_string(i), farPoints);
+  }
+  polyscope::endStructureBatch();
+  EXPECT_EQ(polyscope::state::lengthScale, lengthScale);
+  polyscope::endStructureBatch();
+  EXPECT_GT(polyscope::state::lengthScale, lengthScale);
+  polyscope::show(3);
+
+  EXPECT_THROW(polyscope::endStructureBatch(), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, RemoveAllStructuresAndReload) {
+  for (int i = 0; i < 50; i++) {
+    registerPointCloud("points" + std::to_string(i));
+  }
+  registerTriangleMesh("mesh");
+  polyscope::StructureHandle meshHandle = polyscope::getStructure("Surface Mesh", "mesh")->getHandle();
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+  EXPECT_EQ(polyscope::getStructure(meshHandle), nullptr);
+  EXPECT_FALSE(polyscope::hasStructure("Point Cloud", "points0"));
+
+  // everything works again after reloading
+  for (int i = 0; i < 50; i++) {
+    registerPointCloud("points" + std::to_string(i));
+  }
+  polyscope::show(3);
+  polyscope::pick::pickAtScreenCoords(glm::vec2{0.5, 0.5});
+
+  polyscope::removeAllStructures();
+}
@@ -1,6 +1,8 @@
 // Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
 
 #include "polyscope/camera_parameters.h"
+#include "polyscope/camera_path.h"
+#include "polyscope/camera_view_set.h"
 #include "polyscope/color_image_quantity.h"
 #include "polyscope_test.h"
 
@@ -174,3 +176,83 @@ TEST_F(PolyscopeTest, AddCameraViewScalarImage) {
 
   polyscope::removeAllStructures();
 }
+
+TEST_F(PolyscopeTest, CameraPath) {
+  auto psMesh = registerTriangleMesh();
+
+  polyscope::CameraPath path;
+  std::vector<glm::vec3> positions{{2., 1., 1.}, {0., 1., 3.}, {-2., 2., 1.}, {0., 3., -2.}};
+  for (size_t i = 0; i < positions.size(); i++) {
+    polyscope::CameraParameters c(polyscope::CameraIntrinsics::fromFoVDegVerticalAndAspect(45. + 5. * i, 1.5),
+                                  polyscope::CameraExtrinsics::fromVectors(positions[i], -positions[i],
+                                                                           glm::vec3{0., 1., 0.}));
+    path.addKeyframe(0.5f * i, c);
+  }
+  EXPECT_EQ(path.getKeyframeCount(), 4);
+  EXPECT_FLOAT_EQ(path.getDuration(), 1.5f);
+  EXPECT_THROW(path.addKeyframe(1.f, polyscope::view::getCameraParametersForCurrentView()), std::runtime_error);
+
+  // the path passes through its keyframes
+  for (size_t i = 0; i < positions.size(); i++) {
+    polyscope::CameraParameters c = path.evaluate(0.5f * i);
+    EXPECT_NEAR(glm::length(c.getPosition() - positions[i]), 0., 1e-4);
+    EXPECT_NEAR(glm::dot(c.getLookDir(), glm::normalize(-positions[i])), 1., 1e-4);
+    EXPECT_NEAR(c.getFoVVerticalDegrees(), 45. + 5. * i, 1e-4);
+  }
+
+  // frames are stepped by index, from the first keyframe to the last
+  EXPECT_EQ(path.getFrameCount(10.f), 16);
+  EXPECT_NEAR(glm::length(path.evaluateFrame(15, 10.f).getPosition() - positions.back()), 0., 1e-4);
+  polyscope::view::setViewToCamera(path.evaluateFrame(7, 10.f));
+  polyscope::show(3);
+
+  polyscope::renderCameraPath(path, 4.f, "test_camera_path_");
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, CameraViewSet) {
+
+  // a ring of cameras looking at the origin
+  auto ringOfCameras = [](size_t n, float radius) {
+    std::vector<polyscope::CameraParameters> params;
+    for (size_t i = 0; i < n; i++) {
+      float t = 2.f * glm::pi<float>() * i / n;
+      glm::vec3 pos{radius * std::cos(t), 1., radius * std::sin(t)};
+      params.emplace_back(polyscope::CameraIntrinsics::fromFoVDegVerticalAndAspect(60, 1.5),
+                          polyscope::CameraExtrinsics::fromVectors(pos, -pos, glm::vec3{0., 1., 0.}));
+    }
+    return params;
+  };
+
+  polyscope::CameraViewSet* cams = polyscope::registerCameraViewSet("cams", ringOfCameras(100, 3.));
+  EXPECT_TRUE(polyscope::hasCameraViewSet("cams"));
+  EXPECT_TRUE(polyscope::getCameraViewSet("cams") != nullptr);
+  EXPECT_EQ(cams->nCameras(), 100);
+  EXPECT_EQ(cams->nodePositions.size(), 100 * polyscope::CameraViewSet::nodesPerCamera);
+  EXPECT_EQ(cams->edgeTailPositions.size(), 100 * polyscope::CameraViewSet::edgesPerCamera);
+
+  // the first node of each camera is its root
+  EXPECT_NEAR(glm::length(cams->nodePositions.getValue(polyscope::CameraViewSet::nodesPerCamera * 7) -
+                          cams->getCameraParameters(7).getPosition()),
+              0., 1e-5);
+  EXPECT_THROW(cams->getCameraParameters(100), std::runtime_error);
+
+  cams->setWidgetFocalLength(0.5, false);
+  cams->setWidgetThickness(0.1);
+  cams->setWidgetColor(glm::vec3{0.25, 0.25, 0.25});
+  polyscope::show(3);
+
+  polyscope::pick::pickAtScreenCoords(glm::vec2{0.3, 0.8});
+  cams->setViewToCamera(3);
+  polyscope::show(3);
+
+  // same count, then a different count
+  cams->updateCameraParameters(ringOfCameras(100, 4.));
+  polyscope::show(3);
+  cams->updateCameraParameters(ringOfCameras(20, 2.));
+  EXPECT_EQ(cams->edgeTipPositions.size(), 20 * polyscope::CameraViewSet::edgesPerCamera);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
@@ -35,6 +35,10 @@ TEST_F(PolyscopeTest, RefreshMultiTest) {
   polyscope::refresh();
   polyscope::show(3);
 
+  // Only the programs, as when global rules change
+  polyscope::refreshShaderPrograms();
+  polyscope::show(3);
+
   polyscope::removeAllStructures();
 }
 
@@ -144,6 +148,27 @@ TEST_F(PolyscopeTest, SlicePlaneTest) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SlicePlaneCapacity) {
+  auto psMesh = registerTriangleMesh();
+
+  // All planes share the programs of the first, up to the capacity
+  for (int i = 0; i < polyscope::render::maxSlicePlanes; i++) {
+    polyscope::SlicePlane* p = polyscope::addSceneSlicePlane();
+    p->setTransform(glm::translate(p->getTransform(), glm::vec3{-0.1 * i, 0., 0.}));
+    if (i % 2 == 1) p->setActive(false);
+    polyscope::show(3);
+  }
+  EXPECT_THROW(polyscope::addSceneSlicePlane(), std::runtime_error);
+  EXPECT_EQ(polyscope::state::slicePlanes.size(), static_cast<size_t>(polyscope::render::maxSlicePlanes));
+
+  while (!polyscope::state::slicePlanes.empty()) {
+    polyscope::removeLastSceneSlicePlane();
+    polyscope::show(3);
+  }
+
+  polyscope::removeAllStructures();
+}
+
 // Register a handful of quantities / structures, then call refresh
 TEST_F(PolyscopeTest, OrthoViewTest) {
 
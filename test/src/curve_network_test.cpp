@@ -39,6 +39,45 @@ TEST_F(PolyscopeTest, CurveNetworkPick) {
 }
 
 
+TEST_F(PolyscopeTest, CurveNetworkReplaceNodesAndEdges) {
+  auto psCurve = registerCurveNetwork();
+  psCurve->addNodeScalarQuantity("vals", std::vector<float>(psCurve->nNodes(), 1.))->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // same nodes, fewer edges, the node quantity is still drawn
+  std::vector<glm::vec3> nodes = std::get<0>(getCurveNetwork());
+  std::vector<std::array<size_t, 2>> edges{{0, 1}, {1, 2}};
+  psCurve->replaceNodesAndEdges(nodes, edges);
+  polyscope::show(3);
+  EXPECT_EQ(psCurve->nEdges(), 2u);
+
+  // a longer line
+  nodes.clear();
+  edges.clear();
+  for (size_t i = 0; i < 50; i++) {
+    nodes.push_back(glm::vec3{i, i % 2, 0.});
+    if (i > 0) edges.push_back({i - 1, i});
+  }
+  psCurve->replaceNodesAndEdges(nodes, edges);
+  psCurve->addNodeScalarQuantity("vals", std::vector<float>(nodes.size(), 2.))->setEnabled(true);
+  psCurve->addEdgeScalarQuantity("edgeVals", std::vector<float>(edges.size(), 3.))->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+  EXPECT_EQ(psCurve->nNodes(), 50u);
+  EXPECT_EQ(psCurve->nEdges(), 49u);
+  EXPECT_EQ(psCurve->nodeDegrees[1], 2u);
+
+  psCurve->setRenderMode(polyscope::CurveNetworkRenderMode::Instanced);
+  polyscope::show(3);
+
+  // bad indices are rejected
+  edges.push_back({0, 50});
+  EXPECT_THROW(psCurve->replaceNodesAndEdges(nodes, edges), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, CurveNetworkColorNode) {
   auto psCurve = registerCurveNetwork();
   std::vector<glm::vec3> vColors(psCurve->nNodes(), glm::vec3{.2, .3, .4});
@@ -106,6 +145,80 @@ TEST_F(PolyscopeTest, CurveNetworkScalarRadius) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, CurveNetworkInstanced) {
+  auto psCurve = registerCurveNetwork();
+  psCurve->setRenderMode(polyscope::CurveNetworkRenderMode::Instanced);
+  EXPECT_EQ(psCurve->getRenderMode(), polyscope::CurveNetworkRenderMode::Instanced);
+  polyscope::show(3);
+
+  // quantities and variable radii use the instanced programs too
+  std::vector<double> vScalar(psCurve->nNodes(), 0.5);
+  std::vector<glm::vec3> eColors(psCurve->nEdges(), glm::vec3{.2, .3, .4});
+  auto q1 = psCurve->addNodeScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  psCurve->setNodeRadiusQuantity(q1);
+  polyscope::show(3);
+  psCurve->addEdgeColorQuantity("eColor", eColors)->setEnabled(true);
+  polyscope::show(3);
+
+  // thin line level of detail, then disabled
+  psCurve->setLineLODPixelRadius(1000.);
+  polyscope::show(3);
+  psCurve->setLineLODPixelRadius(0.);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psCurve->setRenderMode(polyscope::CurveNetworkRenderMode::Cylinder);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, CurveNetworkPolylines) {
+  // two polylines, of 4 and 3 nodes
+  std::vector<glm::vec3> nodes;
+  for (int i = 0; i < 7; i++) {
+    nodes.push_back(glm::vec3{i, i % 2, 0.});
+  }
+  std::vector<uint32_t> offsets = {0, 4, 7};
+  auto psCurve = polyscope::registerCurveNetworkPolylines("polylines", nodes, offsets);
+  EXPECT_TRUE(psCurve->hasPolylineStorage());
+  EXPECT_EQ(psCurve->nPolylines(), 2);
+  EXPECT_EQ(psCurve->nEdges(), 5);
+  EXPECT_EQ(psCurve->edgeTailInds.getValue(3), 4);
+  EXPECT_EQ(psCurve->edgeTipInds.getValue(3), 5);
+  EXPECT_EQ(psCurve->nodeDegrees[3], 1);
+  polyscope::show(3);
+
+  // node and edge quantities, variable radii and picking all go through the strip program
+  std::vector<double> vScalar(psCurve->nNodes(), 0.5);
+  std::vector<double> eScalar(psCurve->nEdges(), 2.);
+  std::vector<glm::vec3> vColors(psCurve->nNodes(), glm::vec3{.2, .3, .4});
+  std::vector<glm::vec3> eColors(psCurve->nEdges(), glm::vec3{.2, .3, .4});
+  auto q1 = psCurve->addNodeScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  psCurve->setNodeRadiusQuantity(q1);
+  polyscope::show(3);
+  psCurve->addEdgeScalarQuantity("eScalar", eScalar)->setEnabled(true);
+  polyscope::show(3);
+  psCurve->addNodeColorQuantity("vColor", vColors)->setEnabled(true);
+  polyscope::show(3);
+  psCurve->addEdgeColorQuantity("eColor", eColors)->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // the instanced mode expands the edges as usual
+  psCurve->setRenderMode(polyscope::CurveNetworkRenderMode::Instanced);
+  polyscope::show(3);
+
+  // offsets must cover the nodes, with at least two per polyline
+  std::vector<uint32_t> badEnd = {0, 4, 6};
+  EXPECT_THROW(polyscope::registerCurveNetworkPolylines("bad", nodes, badEnd), std::runtime_error);
+  std::vector<uint32_t> shortLine = {0, 6, 7};
+  EXPECT_THROW(polyscope::registerCurveNetworkPolylines("bad", nodes, shortLine), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, CurveNetworkVertexVector) {
   auto psCurve = registerCurveNetwork();
   std::vector<glm::vec3> vals(psCurve->nNodes(), {1., 2., 3.});
@@ -123,3 +236,33 @@ TEST_F(PolyscopeTest, CurveNetworkFaceVector) {
   polyscope::show(3);
   polyscope::removeAllStructures();
 }
+
+TEST_F(PolyscopeTest, CurveNetworkKeyframes) {
+  auto psCurve = registerCurveNetwork();
+  std::vector<std::vector<glm::vec3>> frames;
+  for (int i = 0; i < 3; i++) {
+    std::vector<glm::vec3> frame = std::get<0>(getCurveNetwork());
+    for (glm::vec3& p : frame) p += glm::vec3{i, 0., 0.};
+    frames.push_back(frame);
+  }
+  psCurve->setNodePositionKeyframes(frames);
+  EXPECT_EQ(psCurve->nKeyframes(), 3);
+  psCurve->setKeyframeTime(0.5);
+  polyscope::show(3);
+
+  psCurve->setRenderMode(polyscope::CurveNetworkRenderMode::Instanced);
+  polyscope::show(3);
+
+  // polylines draw the keyframed nodes as strips
+  std::vector<glm::vec3> nodes;
+  for (int i = 0; i < 5; i++) {
+    nodes.push_back(glm::vec3{i, i % 2, 0.});
+  }
+  auto psPolylines = polyscope::registerCurveNetworkPolylines("polylines", nodes, std::vector<uint32_t>{0, 2, 5});
+  std::vector<std::vector<glm::vec3>> polylineFrames(2, nodes);
+  psPolylines->setNodePositionKeyframes(polylineFrames);
+  psPolylines->setKeyframesPlaying(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
@@ -4,6 +4,10 @@
 
 #include "polyscope/floating_quantities.h"
 
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+
 // ============================================================
 // =============== Floating image
 // ============================================================
@@ -71,6 +75,217 @@ TEST_F(PolyscopeTest, FloatingImageTest) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, FloatingImageColormapSwitchTest) {
+
+  size_t dimX = 30;
+  size_t dimY = 20;
+
+  // many images, all drawn through the same program and colormap atlas
+  std::vector<polyscope::ScalarImageQuantity*> ims;
+  for (size_t iIm = 0; iIm < 20; iIm++) {
+    std::vector<float> vals(dimX * dimY);
+    for (size_t i = 0; i < vals.size(); i++) vals[i] = static_cast<float>(i % dimX) / dimX;
+    ims.push_back(polyscope::addScalarImageQuantity("im scalar " + std::to_string(iIm), dimX, dimY, vals,
+                                                    polyscope::ImageOrigin::UpperLeft));
+  }
+  ims.front()->setShowFullscreen(true);
+  polyscope::show(3);
+
+  std::vector<std::string> cmaps = {"turbo", "reds", "coolwarm", "viridis"};
+  for (size_t iIter = 0; iIter < cmaps.size(); iIter++) {
+    for (polyscope::ScalarImageQuantity* im : ims) {
+      im->setColorMap(cmaps[iIter]);
+      im->setMapRange({0.1 * iIter, 1.0});
+    }
+    polyscope::show(3);
+  }
+  EXPECT_EQ(ims.back()->getColorMap(), "viridis");
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, FloatingImageStreamingTest) {
+  size_t dimX = 64;
+  size_t dimY = 32;
+
+  { // 8-bit RGB frames, whole and sub-rectangle
+    std::vector<std::array<float, 3>> valsRGB(dimX * dimY, std::array<float, 3>{0.44, 0.55, 0.66});
+    polyscope::ColorImageQuantity* im =
+        polyscope::addColorImageQuantity("im color", dimX, dimY, valsRGB, polyscope::ImageOrigin::UpperLeft);
+    im->setShowFullscreen(true);
+    polyscope::show(3);
+
+    std::vector<uint8_t> frame(3 * dimX * dimY, 200);
+    im->updatePixels(frame.data(), 3, polyscope::PixelComponentType::UNorm8);
+    polyscope::show(3);
+    std::vector<uint8_t> patch(3 * 8 * 4, 20);
+    im->updatePixelsRect(patch.data(), 3, polyscope::PixelComponentType::UNorm8, 10, 5, 8, 4);
+    polyscope::show(3);
+
+    // the host copy was skipped, it is restored from the device on demand
+    EXPECT_TRUE(im->colors.data.empty());
+    EXPECT_EQ(im->colors.size(), dimX * dimY);
+
+    EXPECT_THROW(im->updatePixelsRect(patch.data(), 3, polyscope::PixelComponentType::UNorm8, dimX - 4, 0, 8, 4),
+                 std::runtime_error);
+    EXPECT_THROW(im->updatePixels(frame.data(), 2, polyscope::PixelComponentType::UNorm8), std::runtime_error);
+  }
+
+  { // 16-bit scalar frames
+    std::vector<float> vals(dimX * dimY, 0.44);
+    polyscope::ScalarImageQuantity* im =
+        polyscope::addScalarImageQuantity("im scalar", dimX, dimY, vals, polyscope::ImageOrigin::UpperLeft);
+    im->setShowFullscreen(true);
+    polyscope::show(3);
+
+    std::vector<uint16_t> frame(dimX * dimY, 30000);
+    im->updatePixels(frame.data(), polyscope::PixelComponentType::UNorm16);
+    polyscope::show(3);
+  }
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, FloatingImageCompactStorageTest) {
+  size_t dimX = 64;
+  size_t dimY = 32;
+
+  { // 8-bit RGB, stored as RGBA8
+    std::vector<uint8_t> pixels(3 * dimX * dimY, 200);
+    polyscope::ColorImageQuantity* im = polyscope::addColorImageQuantityFromPixels(
+        "im color", dimX, dimY, pixels.data(), 3, polyscope::PixelComponentType::UNorm8,
+        polyscope::ImageOrigin::UpperLeft);
+    im->setShowFullscreen(true);
+    polyscope::show(3);
+    EXPECT_EQ(im->colors.getRenderTextureBuffer()->getFormat(), polyscope::TextureFormat::RGBA8);
+    EXPECT_TRUE(im->colors.data.empty());
+    EXPECT_EQ(im->colors.size(), dimX * dimY);
+
+    // streaming updates go to the same compact texture
+    im->updatePixels(pixels.data(), 3, polyscope::PixelComponentType::UNorm8);
+    polyscope::show(3);
+
+    EXPECT_THROW(polyscope::addColorImageQuantityFromPixels("im bad", dimX, dimY, pixels.data(), 2,
+                                                            polyscope::PixelComponentType::UNorm8,
+                                                            polyscope::ImageOrigin::UpperLeft),
+                 std::runtime_error);
+  }
+
+  { // 16-bit scalars, stored as R16, with the range computed from the normalized values
+    std::vector<uint16_t> pixels(dimX * dimY, 0);
+    pixels[1] = 65535;
+    polyscope::ScalarImageQuantity* im = polyscope::addScalarImageQuantityFromPixels(
+        "im scalar", dimX, dimY, pixels.data(), polyscope::PixelComponentType::UNorm16,
+        polyscope::ImageOrigin::UpperLeft);
+    im->setShowFullscreen(true);
+    polyscope::show(3);
+    EXPECT_EQ(im->values.getRenderTextureBuffer()->getFormat(), polyscope::TextureFormat::R16);
+    EXPECT_TRUE(im->values.data.empty());
+    EXPECT_FLOAT_EQ(im->getDataRange().first, 0.);
+    EXPECT_FLOAT_EQ(im->getDataRange().second, 1.);
+  }
+
+  { // half-float storage for ordinary float images
+    std::vector<float> vals(dimX * dimY, 0.44);
+    polyscope::ScalarImageQuantity* im =
+        polyscope::addScalarImageQuantity("im half", dimX, dimY, vals, polyscope::ImageOrigin::UpperLeft);
+    im->values.setTextureStorageFormat(polyscope::TextureFormat::R16F);
+    EXPECT_THROW(im->values.setTextureStorageFormat(polyscope::TextureFormat::RGBA8), std::runtime_error);
+    im->setShowFullscreen(true);
+    polyscope::show(3);
+    EXPECT_EQ(im->values.getRenderTextureBuffer()->getFormat(), polyscope::TextureFormat::R16F);
+    EXPECT_THROW(im->values.setTextureStorageFormat(polyscope::TextureFormat::R8), std::runtime_error);
+  }
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, FloatingTiledImageTest) {
+  size_t dimX = 3000;
+  size_t dimY = 2000;
+
+  // a gradient, generated at whatever level and rectangle is asked for
+  std::atomic<int> nLoads{0};
+  polyscope::TiledImageLoader loader = [&](size_t level, size_t x, size_t y, size_t w, size_t h,
+                                           unsigned char* pixelsRGBA) {
+    nLoads++;
+    for (size_t j = 0; j < h; j++) {
+      for (size_t i = 0; i < w; i++) {
+        unsigned char* p = pixelsRGBA + 4 * (j * w + i);
+        p[0] = static_cast<unsigned char>((x + i) % 256);
+        p[1] = static_cast<unsigned char>((y + j) % 256);
+        p[2] = static_cast<unsigned char>(40 * level);
+        p[3] = 255;
+      }
+    }
+  };
+
+  polyscope::TiledImageQuantity* im = polyscope::addTiledImageQuantity("tiled", dimX, dimY, loader, 256);
+  EXPECT_EQ(im->nLevels(), 5u); // 3000 -> 1500 -> 750 -> 375 -> 188
+  EXPECT_EQ(im->levelDimX(4), 188u);
+
+  // the ImGui window is shown by default
+  polyscope::show(3);
+  im->waitForPendingTiles();
+  EXPECT_GT(im->nCachedTiles(), 0u);
+
+  // zoomed in to full resolution, only the tiles under the view load
+  im->setShowFullscreen(true);
+  im->setViewWindow(1000, 500, 1200, 600);
+  polyscope::show(3);
+  im->waitForPendingTiles();
+  int loadsAfterZoom = nLoads;
+  EXPECT_LT(loadsAfterZoom, 60);
+
+  // cached tiles are not loaded again
+  polyscope::show(3);
+  im->waitForPendingTiles();
+  EXPECT_EQ(nLoads, loadsAfterZoom);
+
+  // the cache is bounded
+  im->setTileCacheSize(4);
+  EXPECT_LE(im->nCachedTiles(), 4u);
+  im->resetView();
+  polyscope::show(3);
+  im->waitForPendingTiles();
+  EXPECT_LE(im->nCachedTiles(), 4u);
+
+  EXPECT_THROW(im->setViewWindow(10, 10, 5, 20), std::runtime_error);
+
+  // failing loaders are reported, not thrown
+  polyscope::TiledImageQuantity* imBad = polyscope::addTiledImageQuantity(
+      "tiled bad", dimX, dimY,
+      [](size_t, size_t, size_t, size_t, size_t, unsigned char*) { throw std::runtime_error("no tile"); });
+  imBad->setShowFullscreen(true);
+  polyscope::show(3);
+  imBad->waitForPendingTiles();
+  polyscope::show(3);
+  EXPECT_EQ(imBad->nCachedTiles(), 0u);
+
+  // raw files are mapped
+  {
+    size_t fileDimX = 600;
+    size_t fileDimY = 300;
+    std::vector<unsigned char> raw(3 * fileDimX * fileDimY, 120);
+    {
+      std::ofstream out("test_tiled_image.raw", std::ios::binary);
+      out.write(reinterpret_cast<const char*>(raw.data()), raw.size());
+    }
+    polyscope::TiledImageQuantity* imFile = polyscope::addTiledImageQuantity(
+        "tiled file", fileDimX, fileDimY,
+        polyscope::tiledImageLoaderFromRawFile("test_tiled_image.raw", fileDimX, fileDimY, 3), 128);
+    imFile->setShowFullscreen(true);
+    polyscope::show(3);
+    imFile->waitForPendingTiles();
+    EXPECT_GT(imFile->nCachedTiles(), 0u);
+    EXPECT_THROW(polyscope::tiledImageLoaderFromRawFile("test_tiled_image.raw", 2 * fileDimX, fileDimY, 3),
+                 std::runtime_error);
+  }
+
+  polyscope::removeAllStructures();
+  std::remove("test_tiled_image.raw");
+}
+
 TEST_F(PolyscopeTest, FloatingRenderImageTest) {
 
 
@@ -164,6 +379,106 @@ TEST_F(PolyscopeTest, FloatingRenderImageTest) {
 }
 
 
+TEST_F(PolyscopeTest, FloatingRenderImageCompositingTest) {
+
+  size_t dimX = 300;
+  size_t dimY = 200;
+
+  std::vector<float> depthVals(dimX * dimY, 0.44);
+  std::vector<float> depthValsNear(dimX * dimY, 0.33);
+  std::vector<std::array<float, 3>> normalVals(dimX * dimY, std::array<float, 3>{0.44, 0.55, 0.66});
+  std::vector<std::array<float, 3>> normalValsEmpty;
+  std::vector<std::array<float, 3>> colorVals(dimX * dimY, std::array<float, 3>{0.44, 0.55, 0.66});
+  std::vector<float> scalarVals(dimX * dimY, 0.44);
+
+  std::vector<polyscope::RenderImageQuantityBase*> ims;
+  ims.push_back(polyscope::addDepthRenderImageQuantity("render im depth", dimX, dimY, depthVals, normalVals,
+                                                       polyscope::ImageOrigin::UpperLeft));
+  ims.push_back(polyscope::addColorRenderImageQuantity("render im color", dimX, dimY, depthValsNear, normalValsEmpty,
+                                                       colorVals, polyscope::ImageOrigin::LowerLeft));
+  ims.push_back(polyscope::addScalarRenderImageQuantity("render im scalar", dimX, dimY, depthVals, normalVals,
+                                                        scalarVals, polyscope::ImageOrigin::UpperLeft));
+  ims.push_back(polyscope::addDepthRenderImageQuantity("render im depth 2", dimX, dimY, depthValsNear,
+                                                       normalValsEmpty, polyscope::ImageOrigin::UpperLeft));
+  for (polyscope::RenderImageQuantityBase* im : ims) {
+    im->setAllowFullscreenCompositing(true);
+    im->setEnabled(true);
+  }
+  for (polyscope::RenderImageQuantityBase* im : ims) {
+    EXPECT_TRUE(im->isEnabled());
+  }
+  polyscope::show(3);
+
+  // a transparent image and a different material each leave the shared pass
+  ims[1]->setTransparency(0.5);
+  polyscope::show(3);
+  ims[2]->setMaterial("flat");
+  polyscope::show(3);
+
+  // scalar images with isolines draw themselves
+  polyscope::ScalarRenderImageQuantity* scalarIm = dynamic_cast<polyscope::ScalarRenderImageQuantity*>(ims[2]);
+  scalarIm->setMaterial("clay");
+  scalarIm->setIsolinesEnabled(true);
+  polyscope::show(3);
+
+  polyscope::options::compositeRenderImages = false;
+  polyscope::show(3);
+  polyscope::options::compositeRenderImages = true;
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, FloatingRenderImageExternalTextureTest) {
+
+  size_t dimX = 300;
+  size_t dimY = 200;
+
+  std::vector<float> depthVals(dimX * dimY, 0.44);
+  std::vector<std::array<float, 3>> normalVals(dimX * dimY, std::array<float, 3>{0.44, 0.55, 0.66});
+  std::vector<std::array<float, 3>> normalValsEmpty;
+  std::vector<std::array<float, 3>> colorVals(dimX * dimY, std::array<float, 3>{0.44, 0.55, 0.66});
+
+  { // draw from external textures
+    polyscope::ColorRenderImageQuantity* im = polyscope::addColorRenderImageQuantity(
+        "render im external", dimX, dimY, depthVals, normalVals, colorVals, polyscope::ImageOrigin::UpperLeft);
+    im->setEnabled(true);
+    polyscope::show(3);
+
+    im->setExternalDepthTexture(1);
+    im->setExternalNormalTexture(2);
+    im->setExternalColorTexture(3);
+    EXPECT_TRUE(im->depths.getRenderTextureBuffer()->isExternal());
+    EXPECT_EQ(im->depths.getRenderTextureBuffer()->getDeviceMemoryBytes(), 0u);
+    EXPECT_TRUE(im->colors.data.empty()); // not copied to the host
+    polyscope::show(3);
+
+    im->markDeviceDataUpdated();
+    polyscope::show(3);
+
+    // wrong size or channels
+    EXPECT_THROW(im->colors.setExternalRenderTexture(
+                     polyscope::render::engine->wrapExternalTexture(polyscope::TextureFormat::RGB32F, 10, 10, 4)),
+                 std::runtime_error);
+    EXPECT_THROW(im->setExternalColorTexture(4, polyscope::TextureFormat::R32F), std::runtime_error);
+  }
+
+  { // copy from device buffers
+    polyscope::DepthRenderImageQuantity* im = polyscope::addDepthRenderImageQuantity(
+        "render im device buffer", dimX, dimY, depthVals, normalValsEmpty, polyscope::ImageOrigin::UpperLeft);
+    im->setEnabled(true);
+    im->updateDepthsFromDeviceBuffer(5);
+    EXPECT_TRUE(im->depths.data.empty());
+    polyscope::show(3);
+
+    // this one has no normals
+    EXPECT_THROW(im->setExternalNormalTexture(6), std::runtime_error);
+    EXPECT_THROW(im->updateNormalsFromDeviceBuffer(6), std::runtime_error);
+  }
+
+  polyscope::removeAllStructures();
+}
+
+
 // ============================================================
 // =============== Implicit tests
 // ============================================================
@@ -228,3 +543,121 @@ TEST_F(PolyscopeTest, ImplicitSurfaceRenderImageQuantityTest) {
 
   polyscope::removeAllStructures();
 }
+
+TEST_F(PolyscopeTest, ImplicitSurfaceTiledEvaluationTest) {
+
+  auto sphereSDF = [](glm::vec3 p) { return glm::length(p) - 1.f; };
+  auto colorFunc = [](glm::vec3 p) { return glm::abs(p); };
+
+  polyscope::ImplicitRenderOpts opts;
+  polyscope::ImplicitRenderMode mode = polyscope::ImplicitRenderMode::SphereMarch;
+  opts.subsampleFactor = 16;
+
+  // small tiles on several threads, the results match a single batch
+  polyscope::ImplicitRenderOpts tiledOpts = opts;
+  tiledOpts.batchTileSize = 64;
+  tiledOpts.batchThreads = 4;
+
+  std::vector<float> serialDepth, tiledDepth;
+  std::vector<glm::vec3> pos, normal;
+  polyscope::resolveImplicitRenderOpts(polyscope::getGlobalFloatingQuantityStructure(), opts);
+  polyscope::resolveImplicitRenderOpts(polyscope::getGlobalFloatingQuantityStructure(), tiledOpts);
+  auto batchSDF = [&](const float* pos_ptr, float* result_ptr, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      result_ptr[i] = sphereSDF(glm::vec3{pos_ptr[3 * i + 0], pos_ptr[3 * i + 1], pos_ptr[3 * i + 2]});
+    }
+  };
+  std::tie(serialDepth, pos, normal) = polyscope::renderImplicitSurfaceTracer(batchSDF, mode, opts);
+  std::tie(tiledDepth, pos, normal) = polyscope::renderImplicitSurfaceTracer(batchSDF, mode, tiledOpts);
+  EXPECT_EQ(serialDepth, tiledDepth);
+
+  polyscope::renderImplicitSurfaceColor("sphere color", sphereSDF, colorFunc, mode, tiledOpts);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ImplicitSurfaceNormalModesTest) {
+
+  auto sphereSDF = [](glm::vec3 p) { return glm::length(p) - 1.f; };
+
+  polyscope::ImplicitRenderOpts opts;
+  polyscope::ImplicitRenderMode mode = polyscope::ImplicitRenderMode::SphereMarch;
+  opts.subsampleFactor = 16;
+  polyscope::resolveImplicitRenderOpts(polyscope::getGlobalFloatingQuantityStructure(), opts);
+
+  auto batchSDF = [&](const float* pos_ptr, float* result_ptr, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      result_ptr[i] = sphereSDF(glm::vec3{pos_ptr[3 * i + 0], pos_ptr[3 * i + 1], pos_ptr[3 * i + 2]});
+    }
+  };
+
+  std::vector<float> depth;
+  std::vector<glm::vec3> pos, fdNormal, gradNormal, screenNormal;
+  std::tie(depth, pos, fdNormal) = polyscope::renderImplicitSurfaceTracer(batchSDF, mode, opts);
+
+  // analytic gradient
+  polyscope::ImplicitRenderOpts gradOpts = opts;
+  gradOpts.gradientFuncBatch = [](const float* pos_ptr, float* result_ptr, size_t size) {
+    for (size_t i = 0; i < 3 * size; i++) {
+      result_ptr[i] = pos_ptr[i];
+    }
+  };
+  std::tie(depth, pos, gradNormal) = polyscope::renderImplicitSurfaceTracer(batchSDF, mode, gradOpts);
+
+  // screen space
+  polyscope::ImplicitRenderOpts screenOpts = opts;
+  screenOpts.normalMode = polyscope::ImplicitNormalMode::ScreenSpace;
+  std::tie(depth, pos, screenNormal) = polyscope::renderImplicitSurfaceTracer(batchSDF, mode, screenOpts);
+
+  // all agree on hits, misses get zero normals
+  ASSERT_EQ(fdNormal.size(), depth.size());
+  for (size_t iP = 0; iP < depth.size(); iP++) {
+    if (depth[iP] == std::numeric_limits<float>::infinity()) {
+      EXPECT_EQ(gradNormal[iP], glm::vec3(0.f));
+      EXPECT_EQ(screenNormal[iP], glm::vec3(0.f));
+    } else {
+      EXPECT_GT(glm::dot(fdNormal[iP], gradNormal[iP]), 0.99f);
+      EXPECT_GT(glm::dot(fdNormal[iP], screenNormal[iP]), 0.f);
+    }
+  }
+
+  polyscope::renderImplicitSurface("sphere screen space normals", sphereSDF, mode, screenOpts);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ImplicitSurfaceProgressiveTest) {
+
+  auto sphereSDF = [](glm::vec3 p) { return glm::length(p) - 1.f; };
+
+  polyscope::ImplicitRenderOpts opts;
+  polyscope::ImplicitRenderMode mode = polyscope::ImplicitRenderMode::SphereMarch;
+  opts.subsampleFactor = 16;
+  opts.progressiveCoarseFactor = 4;
+  opts.progressiveTileSize = 8;
+  opts.progressiveFrameBudgetMs = 0.; // one tile per frame
+
+  polyscope::DepthRenderImageQuantity* img =
+      polyscope::renderImplicitSurfaceProgressive("sphere progressive", sphereSDF, mode, opts);
+  EXPECT_TRUE(polyscope::progressiveImplicitRendersPending());
+
+  // refine until converged, then it matches a regular render
+  for (size_t iFrame = 0; iFrame < 10000 && polyscope::progressiveImplicitRendersPending(); iFrame++) {
+    polyscope::show(1);
+  }
+  EXPECT_FALSE(polyscope::progressiveImplicitRendersPending());
+
+  polyscope::DepthRenderImageQuantity* imgFull = polyscope::renderImplicitSurface("sphere", sphereSDF, mode, opts);
+  img->depths.ensureHostBufferPopulated();
+  imgFull->depths.ensureHostBufferPopulated();
+  EXPECT_EQ(img->depths.data, imgFull->depths.data);
+
+  // removing the quantity mid-render stops the refinement
+  polyscope::renderImplicitSurfaceProgressive("sphere progressive", sphereSDF, mode, opts);
+  EXPECT_TRUE(polyscope::progressiveImplicitRendersPending());
+  polyscope::removeAllStructures();
+  polyscope::show(1);
+  EXPECT_FALSE(polyscope::progressiveImplicitRendersPending());
+}
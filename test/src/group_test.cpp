@@ -261,3 +261,26 @@ TEST_F(PolyscopeTest, TestGroupCycleError) {
   // this should throw an error (but not segfault)
   test_child_group->addChildGroup(*test_group);
 }
+
+TEST_F(PolyscopeTest, GroupEnabledCacheTest) {
+  auto psCloud = registerPointCloud("cloud");
+  auto psMesh = registerTriangleMesh("mesh");
+  polyscope::Group* parent = polyscope::createGroup("parent");
+  polyscope::Group* child = polyscope::createGroup("child");
+  parent->addChildGroup(*child);
+  child->addChildStructure(*psCloud);
+  EXPECT_EQ(parent->isEnabled(), 1);
+
+  // the cached state follows structure and hierarchy changes
+  psCloud->setEnabled(false);
+  EXPECT_EQ(parent->isEnabled(), 0);
+  parent->addChildStructure(*psMesh);
+  EXPECT_EQ(parent->isEnabled(), -1);
+  polyscope::removeStructure("cloud");
+  EXPECT_EQ(child->isEnabled(), -2);
+  EXPECT_EQ(parent->isEnabled(), 1);
+  polyscope::show(3);
+
+  polyscope::removeAllGroups();
+  polyscope::removeAllStructures();
+}
@@ -2,6 +2,14 @@
 
 #include "polyscope_test.h"
 
+#include "polyscope/ply_loader.h"
+#include "polyscope/scene_file.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
 
 // ============================================================
 // =============== Managed Buffer Access
@@ -33,3 +41,313 @@ TEST_F(PolyscopeTest, ManagedBufferAccess) {
 
   polyscope::removeAllStructures();
 }
+
+TEST_F(PolyscopeTest, ManagedBufferRangeUpdate) {
+
+  // a per-vertex quantity on a mesh, which gets drawn through an indexed view
+  auto psMesh = registerTriangleMesh();
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::render::ManagedBuffer<glm::vec3>& bufferPos = psMesh->vertexPositions;
+  bufferPos.ensureHostBufferPopulated();
+  bufferPos.data[0] = glm::vec3{0.5, 0.5, 0.5};
+  bufferPos.markHostBufferRangeUpdated(0, 1);
+  polyscope::show(3);
+
+  polyscope::render::ManagedBuffer<float>& bufferScalar = q1->getManagedBuffer<float>("values");
+  bufferScalar.ensureHostBufferPopulated();
+  bufferScalar.data[1] = 3.;
+  bufferScalar.data[2] = 4.;
+  bufferScalar.markHostBufferRangesUpdated({{1, 1}, {2, 1}, {0, 0}});
+  polyscope::show(3);
+
+  // out-of-bounds ranges are an error
+  EXPECT_THROW(bufferScalar.markHostBufferRangeUpdated(psMesh->nVertices(), 1), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ManagedBufferStreamingUpdates) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::show(3);
+
+  psMesh->vertexPositions.setUpdateFrequency(polyscope::BufferUpdateFrequency::Streaming);
+  EXPECT_EQ(psMesh->vertexPositions.getUpdateFrequency(), polyscope::BufferUpdateFrequency::Streaming);
+
+  // replace the positions a few times, as in playback of an animation
+  std::vector<glm::vec3> positions = std::get<0>(getTriangleMesh());
+  for (int iFrame = 0; iFrame < 3; iFrame++) {
+    for (glm::vec3& p : positions) p *= 1.1f;
+    psMesh->updateVertexPositions(positions);
+    polyscope::show(1);
+  }
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ManagedBufferHostResidency) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<float> vScalar(psMesh->nVertices(), 7.);
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+
+  polyscope::render::ManagedBuffer<glm::vec3>& bufferPos = psMesh->vertexPositions;
+  polyscope::render::ManagedBuffer<float>& bufferScalar = q1->getManagedBuffer<float>("values");
+  bufferPos.setHostResidency(polyscope::HostResidency::DropAfterUpload);
+  bufferScalar.setHostResidency(polyscope::HostResidency::DropAfterUpload);
+  EXPECT_EQ(bufferPos.getHostResidency(), polyscope::HostResidency::DropAfterUpload);
+  polyscope::show(3);
+
+  // the host copy is restored on demand
+  EXPECT_EQ(bufferScalar.size(), psMesh->nVertices());
+  bufferScalar.ensureHostBufferPopulated();
+  EXPECT_EQ(bufferScalar.data.size(), psMesh->nVertices());
+
+  // updates still work, and are dropped again afterwards
+  bufferPos.ensureHostBufferPopulated();
+  bufferPos.data[0] = glm::vec3{0.5, 0.5, 0.5};
+  bufferPos.markHostBufferUpdated();
+  polyscope::show(3);
+  EXPECT_EQ(bufferPos.size(), psMesh->nVertices());
+
+  bufferPos.setHostResidency(polyscope::HostResidency::Keep);
+  bufferPos.ensureHostBufferPopulated();
+  polyscope::show(3);
+  EXPECT_EQ(bufferPos.data.size(), psMesh->nVertices());
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ManagedBufferBatchedReads) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<float> vScalar(psMesh->nVertices());
+  for (size_t i = 0; i < vScalar.size(); i++) vScalar[i] = static_cast<float>(i);
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+
+  // from the host
+  polyscope::render::ManagedBuffer<float>& bufferScalar = q1->getManagedBuffer<float>("values");
+  std::vector<size_t> inds{2, 0, 2};
+  std::vector<float> vals = bufferScalar.getValues(inds);
+  ASSERT_EQ(vals.size(), 3);
+  EXPECT_EQ(vals[0], 2.f);
+  EXPECT_EQ(vals[1], 0.f);
+  EXPECT_EQ(vals[2], 2.f);
+
+  // from the render buffer, once the host copy is dropped
+  bufferScalar.setHostResidency(polyscope::HostResidency::DropAfterUpload);
+  polyscope::show(3);
+  bufferScalar.requestHostCopyAsync();
+  vals = bufferScalar.getValues(inds);
+  EXPECT_EQ(vals[0], 2.f);
+  EXPECT_EQ(vals[1], 0.f);
+  std::vector<float> range = bufferScalar.getRange(1, 2);
+  ASSERT_EQ(range.size(), 2);
+  EXPECT_EQ(range[0], 1.f);
+  EXPECT_EQ(range[1], 2.f);
+  EXPECT_TRUE(bufferScalar.getRange(0, 0).empty());
+
+  EXPECT_THROW(bufferScalar.getRange(1, psMesh->nVertices()), std::runtime_error);
+  std::vector<size_t> badInds{0, psMesh->nVertices()};
+  EXPECT_THROW(bufferScalar.getValues(badInds), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, AttributeStorageFormats) {
+
+  // conversion round trips, within the precision of each format
+  std::vector<glm::vec3> vals{{0.f, 0.25f, 1.f}, {-1.f, 0.5f, 0.75f}};
+  std::vector<unsigned char> bytes;
+  std::vector<glm::vec3> valsOut(vals.size());
+  polyscope::packAttributeData(polyscope::RenderDataType::Vector3Float, polyscope::AttributeStorageFormat::SNorm16,
+                               &vals[0].x, vals.size(), bytes);
+  EXPECT_EQ(bytes.size(), 2 * 8);
+  polyscope::unpackAttributeData(polyscope::RenderDataType::Vector3Float, polyscope::AttributeStorageFormat::SNorm16,
+                                 &bytes[0], vals.size(), &valsOut[0].x);
+  EXPECT_NEAR(valsOut[1].x, -1.f, 1e-4);
+  EXPECT_NEAR(valsOut[1].y, 0.5f, 1e-4);
+  EXPECT_EQ(polyscope::storageSizeInBytes(polyscope::RenderDataType::Vector3Float,
+                                          polyscope::AttributeStorageFormat::UNorm8),
+            4);
+
+  auto psMesh = registerTriangleMesh();
+  std::vector<glm::vec3> vColors(psMesh->nVertices(), glm::vec3{0.2, 0.4, 0.6});
+  auto q1 = psMesh->addVertexColorQuantity("vColors", vColors);
+  q1->setEnabled(true);
+  q1->colors.setDeviceStorageFormat(polyscope::AttributeStorageFormat::UNorm8);
+  psMesh->vertexNormals.setDeviceStorageFormat(polyscope::AttributeStorageFormat::SNorm16);
+  psMesh->setSmoothShade(true);
+  polyscope::show(3);
+
+  // ints cannot be stored compactly, and the format cannot change once the buffers exist
+  std::shared_ptr<polyscope::render::AttributeBuffer> intBuffer =
+      polyscope::render::engine->generateAttributeBuffer(polyscope::RenderDataType::Int);
+  EXPECT_ANY_THROW(intBuffer->setStorageFormat(polyscope::AttributeStorageFormat::Float16));
+  EXPECT_ANY_THROW(q1->colors.setDeviceStorageFormat(polyscope::AttributeStorageFormat::Float16));
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PersistentValueCache) {
+  polyscope::detail::PersistentCache<float>& cache = polyscope::detail::getPersistentCacheRef<float>();
+
+  {
+    polyscope::PersistentValue<float> val("test#persistent#a", 1.f);
+    EXPECT_TRUE(val.holdsDefaultValue());
+    val = 2.f;
+    EXPECT_EQ(val.getName(), "test#persistent#a");
+  }
+
+  // the value is remembered after the variable is gone
+  {
+    polyscope::PersistentValue<float> val("test#persistent#a", 1.f);
+    EXPECT_FALSE(val.holdsDefaultValue());
+    EXPECT_EQ(val.get(), 2.f);
+  }
+
+  // until it is cleared by prefix, which also frees the name
+  size_t nNames = cache.nNames();
+  polyscope::detail::clearPersistentCaches("test#persistent#");
+  EXPECT_EQ(cache.nNames(), nNames - 1);
+  {
+    polyscope::PersistentValue<float> val("test#persistent#a", 1.f);
+    EXPECT_TRUE(val.holdsDefaultValue());
+    EXPECT_EQ(val.get(), 1.f);
+  }
+  polyscope::detail::clearPersistentCaches("test#persistent#");
+
+  // several prefixes can be cleared at once
+  {
+    polyscope::PersistentValue<float> valA("test#persistentA#a", 1.f);
+    polyscope::PersistentValue<float> valB("test#persistentB#b", 1.f);
+    polyscope::PersistentValue<float> valC("test#persistentC#c", 1.f);
+    valA = 2.f;
+    valB = 2.f;
+    valC = 2.f;
+  }
+  polyscope::detail::clearPersistentCaches(
+      std::unordered_set<std::string>{"test#persistentA#", "test#persistentB#"});
+  {
+    polyscope::PersistentValue<float> valA("test#persistentA#a", 1.f);
+    polyscope::PersistentValue<float> valB("test#persistentB#b", 1.f);
+    polyscope::PersistentValue<float> valC("test#persistentC#c", 1.f);
+    EXPECT_TRUE(valA.holdsDefaultValue());
+    EXPECT_TRUE(valB.holdsDefaultValue());
+    EXPECT_FALSE(valC.holdsDefaultValue());
+  }
+  polyscope::detail::clearPersistentCaches("test#persistentC#");
+
+  // settings of removed structures can be forgotten
+  auto psPoints = registerPointCloud("forgotten");
+  psPoints->setPointRadius(0.123, false);
+  polyscope::options::rememberRemovedStructureSettings = false;
+  polyscope::removeAllStructures();
+  polyscope::options::rememberRemovedStructureSettings = true;
+  psPoints = registerPointCloud("forgotten");
+  EXPECT_NE(psPoints->getPointRadius(), 0.123);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SceneFileRoundTrip) {
+  auto psPoints = registerPointCloud("scene points");
+  std::vector<float> vScalar(psPoints->nPoints(), 7.);
+  vScalar.back() = 3.;
+  psPoints->addScalarQuantity("vScalar", vScalar, polyscope::DataType::SYMMETRIC)->setEnabled(true);
+  psPoints->setPointColor(glm::vec3{0.1, 0.2, 0.3});
+
+  auto psMesh = registerTriangleMesh("scene mesh");
+  std::vector<glm::vec3> vColors(psMesh->nVertices(), glm::vec3{0.2, 0.4, 0.6});
+  psMesh->addVertexColorQuantity("vColors", vColors)->setEnabled(true);
+  psMesh->addVertexScalarQuantity("vScalar", std::vector<float>(psMesh->nVertices(), 1.));
+  size_t nFaces = psMesh->nFaces();
+  polyscope::show(3);
+
+  polyscope::saveScene("test_scene.psscene");
+  polyscope::removeAllStructures();
+  polyscope::loadScene("test_scene.psscene");
+
+  ASSERT_TRUE(polyscope::hasPointCloud("scene points"));
+  ASSERT_TRUE(polyscope::hasSurfaceMesh("scene mesh"));
+  psPoints = polyscope::getPointCloud("scene points");
+  psMesh = polyscope::getSurfaceMesh("scene mesh");
+  EXPECT_EQ(psPoints->nPoints(), vScalar.size());
+  EXPECT_EQ(psPoints->getPointColor(), glm::vec3(0.1, 0.2, 0.3));
+  EXPECT_EQ(psMesh->nFaces(), nFaces);
+
+  // scalar values are read in place from the mapping, their settings come back from the persistent values
+  polyscope::PointCloudScalarQuantity* q1 =
+      dynamic_cast<polyscope::PointCloudScalarQuantity*>(psPoints->getQuantity("vScalar"));
+  ASSERT_NE(q1, nullptr);
+  EXPECT_TRUE(q1->values.hasExternalView());
+  EXPECT_EQ(q1->values.getValue(vScalar.size() - 1), 3.);
+  EXPECT_EQ(q1->getDataType(), polyscope::DataType::SYMMETRIC);
+  EXPECT_TRUE(q1->isEnabled());
+  EXPECT_TRUE(psMesh->getQuantity("vColors")->isEnabled());
+  EXPECT_NE(psMesh->getQuantity("vScalar"), nullptr);
+  polyscope::show(3);
+
+  // loading again replaces the structures
+  polyscope::loadScene("test_scene.psscene");
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+  EXPECT_ANY_THROW(polyscope::loadScene("test_scene_missing.psscene"));
+  std::remove("test_scene.psscene");
+}
+
+TEST_F(PolyscopeTest, LoadPLYBinary) {
+
+  // a quad and a triangle, with uchar colors, a face property before the index list, and an element to skip
+  {
+    std::ofstream out("test_mesh.ply", std::ios::binary);
+    out << "ply\nformat binary_little_endian 1.0\ncomment test\n"
+        << "element vertex 5\nproperty float x\nproperty float y\nproperty float z\n"
+        << "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+        << "element face 2\nproperty uchar flags\nproperty list uchar int vertex_indices\n"
+        << "element edge 1\nproperty int vertex1\nproperty int vertex2\nend_header\n";
+    auto writeLE = [&](uint32_t bits, int nBytes) {
+      for (int i = 0; i < nBytes; i++) out.put(static_cast<char>((bits >> (8 * i)) & 0xFF));
+    };
+    for (int iV = 0; iV < 5; iV++) {
+      float pos[3] = {static_cast<float>(iV), 1.f, 2.f};
+      for (float c : pos) {
+        uint32_t bits;
+        std::memcpy(&bits, &c, 4);
+        writeLE(bits, 4);
+      }
+      for (int c = 0; c < 3; c++) writeLE(255, 1);
+    }
+    writeLE(0, 1);
+    writeLE(4, 1);
+    for (uint32_t iV : {0, 1, 2, 3}) writeLE(iV, 4);
+    writeLE(0, 1);
+    writeLE(3, 1);
+    for (uint32_t iV : {2, 3, 4}) writeLE(iV, 4);
+    writeLE(0, 4);
+    writeLE(1, 4);
+  }
+
+  polyscope::PLYMesh ply = polyscope::loadPLY("test_mesh.ply");
+  EXPECT_EQ(ply.vertexPositions.size(), 5u);
+  EXPECT_EQ(ply.vertexPositions[4], glm::vec3(4., 1., 2.));
+  ASSERT_EQ(ply.vertexColors.size(), 5u);
+  EXPECT_EQ(ply.vertexColors[0], glm::vec3(1., 1., 1.));
+  EXPECT_EQ(ply.faceIndsStart, std::vector<uint32_t>({0, 4, 7}));
+  EXPECT_EQ(ply.faceIndsEntries, std::vector<uint32_t>({0, 1, 2, 3, 2, 3, 4}));
+
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMeshPLY("ply mesh", "test_mesh.ply");
+  EXPECT_EQ(psMesh->nFaces(), 2u);
+  EXPECT_NE(psMesh->getQuantity("color"), nullptr);
+  polyscope::PointCloud* psCloud = polyscope::registerPointCloudPLY("ply cloud", "test_mesh.ply");
+  EXPECT_EQ(psCloud->nPoints(), 5u);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+  EXPECT_ANY_THROW(polyscope::loadPLY("test_mesh_missing.ply"));
+  std::remove("test_mesh.ply");
+}
@@ -2,6 +2,11 @@
 
 #include "polyscope_test.h"
 
+#include "polyscope/parallel.h"
+#include "polyscope/scratch_buffer.h"
+#include "polyscope/tasks.h"
+#include "polyscope/trace.h"
+
 // ============================================================
 // =============== Scalar Quantity Tests
 // ============================================================
@@ -41,3 +46,157 @@ TEST_F(PolyscopeTest, FlatMaterialTest) {
 
   polyscope::removeAllStructures();
 }
+
+// ============================================================
+// =============== Shader program tests
+// ============================================================
+
+TEST_F(PolyscopeTest, ShaderUniformHandles) {
+  std::shared_ptr<polyscope::render::ShaderProgram> program =
+      polyscope::render::engine->requestShader("RAYCAST_SPHERE", {});
+
+  polyscope::render::UniformHandle h = program->getUniformHandle("u_pointRadius");
+  program->setUniform(h, 0.5f);
+  program->setUniform(h, 0.5f); // redundant writes are allowed
+  program->setUniform("u_pointRadius", 0.25f);
+
+  EXPECT_THROW(program->setUniform(h, glm::vec3{1., 2., 3.}), std::invalid_argument);
+  EXPECT_THROW(program->getUniformHandle("u_notAUniform"), std::invalid_argument);
+}
+
+// ============================================================
+// =============== Scratch buffer tests
+// ============================================================
+
+TEST_F(PolyscopeTest, ScratchVectorReuse) {
+  // start from empty pools
+  polyscope::trimScratchBuffers();
+  polyscope::trimScratchBuffers();
+
+  {
+    polyscope::ScratchVector<double> a(1000, 1.);
+    EXPECT_EQ(a->size(), 1000);
+    EXPECT_EQ(a[999], 1.);
+  }
+
+  {
+    // the vector comes back empty, but keeps its memory, and vectors in use at once are distinct
+    polyscope::ScratchVector<double> b;
+    polyscope::ScratchVector<double> c;
+    EXPECT_TRUE(b->empty());
+    EXPECT_GE(b->capacity(), 1000);
+    EXPECT_EQ(c->capacity(), 0);
+  }
+
+  // vectors unused for a whole frame are freed
+  polyscope::trimScratchBuffers();
+  polyscope::trimScratchBuffers();
+  polyscope::ScratchVector<double> d;
+  EXPECT_EQ(d->capacity(), 0);
+}
+
+// ============================================================
+// =============== Task scheduler tests
+// ============================================================
+
+TEST_F(PolyscopeTest, TaskSchedulerLoops) {
+  int oldNumThreads = polyscope::options::numThreads;
+  polyscope::options::numThreads = 4;
+
+  // nested loops, with the inner ones running on the workers
+  std::vector<size_t> vals(100 * 5000, 0);
+  polyscope::parallelFor(
+      0, 100,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          polyscope::parallelFor(0, 5000, [&](size_t jBegin, size_t jEnd) {
+            for (size_t j = jBegin; j < jEnd; j++) vals[i * 5000 + j] = i + j;
+          }, 500);
+        }
+      },
+      1);
+  EXPECT_EQ(polyscope::tasks::nRunningWorkers(), 3);
+  for (size_t i = 0; i < 100; i++) {
+    EXPECT_EQ(vals[i * 5000 + 4999], i + 4999);
+  }
+
+  size_t sum = polyscope::parallelReduce(
+      0, vals.size(), static_cast<size_t>(0),
+      [&](size_t begin, size_t end) {
+        size_t s = 0;
+        for (size_t i = begin; i < end; i++) s += vals[i];
+        return s;
+      },
+      [](size_t a, size_t b) { return a + b; });
+  size_t expected = 0;
+  for (size_t v : vals) expected += v;
+  EXPECT_EQ(sum, expected);
+
+  // the earliest error gets reported
+  EXPECT_THROW(polyscope::tasks::runJobs(8,
+                                         [](size_t iJob) {
+                                           if (iJob == 2) throw std::runtime_error("two");
+                                           if (iJob == 5) throw std::logic_error("five");
+                                         }),
+               std::runtime_error);
+
+  // the pool follows the option
+  polyscope::options::numThreads = 2;
+  polyscope::parallelFor(0, vals.size(), [&](size_t, size_t) {});
+  EXPECT_EQ(polyscope::tasks::nRunningWorkers(), 1);
+
+  // handing the jobs to another scheduler
+  size_t nExternal = 0;
+  polyscope::tasks::setExternalScheduler([&](size_t nJobs, const std::function<void(size_t)>& job) {
+    for (size_t i = 0; i < nJobs; i++) job(i);
+    nExternal += nJobs;
+  });
+  EXPECT_EQ(polyscope::tasks::nRunningWorkers(), 0);
+  polyscope::parallelFor(0, vals.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) vals[i] = 1;
+  });
+  EXPECT_EQ(nExternal, 2);
+  EXPECT_EQ(vals.back(), 1);
+  polyscope::tasks::setExternalScheduler(nullptr);
+
+  polyscope::options::numThreads = oldNumThreads;
+}
+
+TEST_F(PolyscopeTest, TraceSpans) {
+  auto psMesh = registerTriangleMesh();
+
+  polyscope::startTrace();
+  EXPECT_TRUE(polyscope::isTracing());
+  polyscope::show(3);
+  polyscope::stopTrace();
+  EXPECT_FALSE(polyscope::isTracing());
+
+#ifdef POLYSCOPE_ENABLE_TRACING
+  size_t count = polyscope::getTraceSpanCount();
+  EXPECT_GT(count, 0);
+
+  // nothing more is recorded once stopped
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::getTraceSpanCount(), count);
+#endif
+
+  std::string trace = polyscope::getTraceJSON();
+  EXPECT_NE(trace.find("traceEvents"), std::string::npos);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, StartupStats) {
+  polyscope::show(3);
+
+  std::vector<polyscope::FrameSectionStats> phases = polyscope::getStartupStats();
+  bool sawBuffers = false;
+  bool sawFonts = false;
+  for (const polyscope::FrameSectionStats& p : phases) {
+    EXPECT_GE(p.cpuMs, 0.);
+    if (p.name == "global buffers") sawBuffers = true;
+    if (p.name == "GUI fonts") sawFonts = true;
+  }
+  EXPECT_TRUE(sawBuffers);
+  EXPECT_TRUE(sawFonts); // prepared for the first frame with a GUI
+}
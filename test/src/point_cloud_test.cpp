@@ -12,10 +12,14 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "polyscope_test.h"
@@ -44,6 +48,57 @@ TEST_F(PolyscopeTest, PointCloudUpdateGeometry) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, PointCloudManySmall) {
+  // many small clouds, whose buffers share arenas
+  auto cloudPoints = [](int i, size_t count) {
+    std::vector<glm::vec3> points(count);
+    for (size_t j = 0; j < count; j++) points[j] = glm::vec3{static_cast<float>(i), static_cast<float>(j), 0.};
+    return points;
+  };
+  std::vector<polyscope::PointCloud*> clouds;
+  std::vector<std::vector<glm::vec3>> expected;
+  for (int i = 0; i < 50; i++) {
+    expected.push_back(cloudPoints(i, 10 + i));
+    clouds.push_back(polyscope::registerPointCloud("small" + std::to_string(i), expected.back()));
+  }
+  polyscope::show(3);
+
+  // grow some past their ranges, into new ranges or out to buffers of their own, and remove others in between
+  for (int i = 0; i < 50; i += 2) {
+    size_t newCount = 1000 * i + 10 + i;
+    std::vector<glm::vec3> allPoints = cloudPoints(i, newCount);
+    clouds[i]->appendPoints(std::vector<glm::vec3>(allPoints.begin() + expected[i].size(), allPoints.end()));
+    clouds[i]->finalizePoints();
+    expected[i] = allPoints;
+  }
+  for (int i = 1; i < 50; i += 4) {
+    polyscope::removePointCloud("small" + std::to_string(i));
+    clouds[i] = nullptr;
+  }
+  polyscope::show(3);
+
+  // the moved buffers kept their contents, and neither the moves nor the frees disturbed their neighbors (the mock
+  // backend keeps no buffer contents, so there only the sizes can be checked)
+  bool readBack = testBackend != "openGL_mock";
+  for (int i = 0; i < 50; i++) {
+    if (clouds[i] == nullptr) continue;
+    ASSERT_EQ(clouds[i]->nPoints(), expected[i].size());
+    std::shared_ptr<polyscope::render::AttributeBuffer> buff = clouds[i]->points.getRenderAttributeBuffer();
+    ASSERT_EQ(static_cast<size_t>(buff->getDataSize()), expected[i].size());
+    if (readBack) EXPECT_EQ(buff->getDataRange_vec3(0, expected[i].size()), expected[i]);
+  }
+
+  polyscope::options::suballocateSmallBuffers = false;
+  polyscope::PointCloud* ownBuffers = polyscope::registerPointCloud("own buffers", cloudPoints(100, 10));
+  polyscope::show(3);
+  if (readBack) {
+    EXPECT_EQ(ownBuffers->points.getRenderAttributeBuffer()->getData_vec3(9), glm::vec3(100., 9., 0.));
+  }
+  polyscope::options::suballocateSmallBuffers = true;
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, PointCloudAppearance) {
   auto psPoints = registerPointCloud();
 
@@ -59,6 +114,34 @@ TEST_F(PolyscopeTest, PointCloudAppearance) {
   psPoints->setPointRenderMode(polyscope::PointRenderMode::Quad);
   polyscope::show(3);
 
+  psPoints->setPointRenderMode(polyscope::PointRenderMode::Splat);
+  EXPECT_EQ(psPoints->getPointRenderMode(), polyscope::PointRenderMode::Splat);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudSplat) {
+  auto psPoints = registerPointCloud();
+  psPoints->setPointRenderMode(polyscope::PointRenderMode::Splat);
+
+  // quantities, variable radius and per-point transparency all use the splat variants of the rules
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  std::vector<glm::vec3> vColors(psPoints->nPoints(), glm::vec3{.2, .3, .4});
+  std::vector<glm::vec2> vParam(psPoints->nPoints(), glm::vec2{.2, .3});
+  auto qScalar = psPoints->addScalarQuantity("vScalar", vScalar);
+  qScalar->setEnabled(true);
+  polyscope::show(3);
+  psPoints->addColorQuantity("vColor", vColors)->setEnabled(true);
+  polyscope::show(3);
+  psPoints->addParameterizationQuantity("vParam", vParam)->setEnabled(true);
+  polyscope::show(3);
+
+  psPoints->setPointRadiusQuantity(qScalar);
+  psPoints->setTransparencyQuantity(qScalar);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
   polyscope::removeAllStructures();
 }
 
@@ -74,6 +157,389 @@ TEST_F(PolyscopeTest, PointCloudPick) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, PointCloudPickCached) {
+  auto psPoints = registerPointCloud();
+
+  // Repeated queries reuse the cached pick buffer
+  polyscope::pick::evaluatePickQuery(77, 88);
+  uint64_t generation = polyscope::getSceneGeneration();
+  polyscope::pick::evaluatePickQuery(78, 88);
+  polyscope::pick::evaluatePickQuery(79, 88);
+  EXPECT_EQ(polyscope::getSceneGeneration(), generation);
+
+  // Changes bump the generation, which causes a re-render on the next query
+  psPoints->setPointRadius(0.02);
+  EXPECT_GT(polyscope::getSceneGeneration(), generation);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::pick::invalidatePickBuffer();
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudPickRegionOfInterest) {
+  auto psPoints = registerPointCloud();
+
+  // Queries render a tile around the pixel, nearby queries reuse it, and wider queries render more
+  polyscope::pick::evaluatePickQuery(77, 88);
+  polyscope::pick::evaluatePickQuery(80, 90);
+  polyscope::pick::evaluatePickQuery(0, 0);
+  polyscope::pick::pickRegion(10, 10, 100, 60);
+  polyscope::pick::requestPickAtBufferCoordsAsync(77, 88);
+  polyscope::show(3);
+
+  // Always render the whole buffer
+  polyscope::options::pickRegionOfInterestSize = 0;
+  polyscope::pick::evaluatePickQuery(77, 88);
+  polyscope::pick::evaluatePickQuery(80, 90);
+  polyscope::options::pickRegionOfInterestSize = 32;
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudPickRangeReuse) {
+  auto psPoints1 = registerPointCloud("cloud1");
+  auto psPoints2 = registerPointCloud("cloud2");
+  polyscope::pick::evaluatePickQuery(77, 88); // draws the pick pass, which allocates ranges
+
+  size_t start1 = polyscope::pick::localIndexToGlobal({psPoints1, 0});
+  size_t start2 = polyscope::pick::localIndexToGlobal({psPoints2, 0});
+  std::pair<polyscope::Structure*, size_t> local = polyscope::pick::globalIndexToLocal(start2 + 2);
+  EXPECT_EQ(local.first, psPoints2);
+  EXPECT_EQ(local.second, 2u);
+  EXPECT_EQ(polyscope::pick::globalIndexToLocal(0).first, nullptr);
+
+  // a new structure of the same size gets the range of a removed one
+  polyscope::removeStructure(psPoints1);
+  auto psPoints3 = registerPointCloud("cloud3");
+  polyscope::pick::evaluatePickQuery(77, 88);
+  EXPECT_EQ(polyscope::pick::localIndexToGlobal({psPoints3, 0}), start1);
+  EXPECT_EQ(polyscope::pick::globalIndexToLocal(start1).first, psPoints3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudRayCastPick) {
+  std::vector<glm::vec3> points;
+  for (int i = 0; i < 10; i++) {
+    points.push_back(glm::vec3{i, 0., 0.});
+  }
+  polyscope::PointCloud* psPoints = polyscope::registerPointCloud("ray cast points", points);
+  psPoints->setPointRadius(0.1, false);
+  EXPECT_TRUE(psPoints->supportsRayCastPicking());
+
+  float tHit = std::numeric_limits<float>::infinity();
+  size_t pickInd;
+  EXPECT_TRUE(psPoints->rayCastPick(glm::vec3{3., 0., 5.}, glm::vec3{0., 0., -1.}, tHit, pickInd));
+  EXPECT_EQ(pickInd, 3u);
+  EXPECT_NEAR(tHit, 4.9, 1e-4);
+
+  // misses between the points
+  tHit = std::numeric_limits<float>::infinity();
+  EXPECT_FALSE(psPoints->rayCastPick(glm::vec3{3.5, 0., 5.}, glm::vec3{0., 0., -1.}, tHit, pickInd));
+
+  // the hierarchy follows updated positions
+  for (glm::vec3& p : points) p.y += 2.;
+  psPoints->updatePointPositions(points);
+  tHit = std::numeric_limits<float>::infinity();
+  EXPECT_TRUE(psPoints->rayCastPick(glm::vec3{7., 2., 5.}, glm::vec3{0., 0., -1.}, tHit, pickInd));
+  EXPECT_EQ(pickInd, 7u);
+
+  // and the structure transform
+  psPoints->setPosition(glm::vec3{0., 0., -1.});
+  tHit = std::numeric_limits<float>::infinity();
+  EXPECT_TRUE(psPoints->rayCastPick(glm::vec3{7., 2., 5.}, glm::vec3{0., 0., -1.}, tHit, pickInd));
+  EXPECT_NEAR(tHit, 5.9, 1e-4);
+
+  // screen picks go through the ray cast when enabled
+  polyscope::view::lookAt(glm::vec3{7., 2., 5.}, glm::vec3{7., 2., 0.});
+  glm::vec2 center{polyscope::view::windowWidth / 2., polyscope::view::windowHeight / 2.};
+  polyscope::options::rayCastPicking = true;
+  std::pair<polyscope::Structure*, size_t> pick = polyscope::pick::pickAtScreenCoords(center);
+  EXPECT_EQ(pick.first, psPoints);
+  EXPECT_EQ(pick.second, 7u);
+  polyscope::options::rayCastPicking = false;
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudPositionOrigin) {
+  // points 1cm apart, far enough from the origin that floats cannot tell them apart
+  glm::dvec3 origin{1e7, -2e7, 3e7};
+  std::vector<glm::dvec3> points;
+  for (int i = 0; i < 10; i++) {
+    points.push_back(origin + glm::dvec3{0.01 * i, 0., 0.});
+  }
+  polyscope::PointCloud* psPoints = polyscope::registerPointCloud(
+      "large coordinate points", polyscope::standardizePositionsRelativeTo(points, origin));
+  psPoints->setPositionOrigin(origin);
+  psPoints->setPointRadius(0.001, false);
+  EXPECT_EQ(psPoints->getPositionOrigin(), origin);
+
+  glm::vec3 bboxMin, bboxMax;
+  std::tie(bboxMin, bboxMax) = psPoints->boundingBox();
+  EXPECT_NEAR(bboxMin.y, origin.y, 2.);
+  EXPECT_NEAR(bboxMax.z, origin.z, 2.);
+
+  // the ray start is in double precision, so neighboring points are still distinguished
+  float tHit = std::numeric_limits<float>::infinity();
+  size_t pickInd;
+  EXPECT_TRUE(psPoints->rayCastPick(points[6] + glm::dvec3{0., 0., 1.}, glm::vec3{0., 0., -1.}, tHit, pickInd));
+  EXPECT_EQ(pickInd, 6u);
+  EXPECT_NEAR(tHit, 0.999, 1e-4);
+
+  polyscope::view::lookAt(glm::vec3(origin) + glm::vec3{0., 0., 1.}, glm::vec3(origin));
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudFrustumCulling) {
+  auto psPointsFront = registerPointCloud("front");
+  auto psPointsBehind = registerPointCloud("behind");
+  psPointsBehind->setPosition(glm::vec3{0., 0., 100.});
+  polyscope::view::lookAt(glm::vec3{0., 0., 5.}, glm::vec3{0., 0., 0.});
+  polyscope::show(3);
+
+  EXPECT_EQ(polyscope::render::engine->stats.structuresDrawn, 1u);
+  EXPECT_EQ(polyscope::render::engine->stats.structuresCulled, 1u);
+  EXPECT_TRUE(psPointsFront->isInViewFrustum());
+  EXPECT_FALSE(psPointsBehind->isInViewFrustum());
+
+  // vectors may reach into view, so they disable culling
+  std::vector<glm::vec3> vecs(psPointsBehind->nPoints(), glm::vec3{0., 0., -1.});
+  auto q = psPointsBehind->addVectorQuantity("vecs", vecs);
+  q->setEnabled(true);
+  EXPECT_TRUE(psPointsBehind->isInViewFrustum());
+  q->setEnabled(false);
+
+  polyscope::options::frustumCulling = false;
+  EXPECT_TRUE(psPointsBehind->isInViewFrustum());
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::render::engine->stats.structuresCulled, 0u);
+  polyscope::options::frustumCulling = true;
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudLOD) {
+  auto psPoints = registerPointCloud();
+  psPoints->setLODPointBudget(2);
+  polyscope::show(3);
+  EXPECT_GE(psPoints->nLODPointsDrawn(), 1u);
+  EXPECT_LE(psPoints->nLODPointsDrawn(), 2u);
+
+  // the order is a permutation of the points
+  std::vector<uint32_t> order = psPoints->lodPointOrder.getPopulatedHostBufferRef();
+  std::sort(order.begin(), order.end());
+  ASSERT_EQ(order.size(), psPoints->nPoints());
+  for (size_t i = 0; i < order.size(); i++) {
+    EXPECT_EQ(order[i], i);
+  }
+
+  // quantities and picking draw the same subset
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  psPoints->addScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::pickAtScreenCoords(glm::vec2{0.5, 0.5});
+
+  psPoints->setLODPointBudget(0);
+  polyscope::show(3);
+  EXPECT_EQ(psPoints->nLODPointsDrawn(), psPoints->nPoints());
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudVoxelPreview) {
+  // a 20^3 lattice, binned in cubes of 2^3 points (exact binary spacings, so no point lies on a cube face)
+  std::vector<glm::vec3> points;
+  for (int i = 0; i < 20; i++) {
+    for (int j = 0; j < 20; j++) {
+      for (int k = 0; k < 20; k++) points.push_back(glm::vec3{i, j, k} * 0.125f);
+    }
+  }
+  polyscope::VoxelGrid grid = polyscope::voxelGridDownsample(points, 0.25);
+  ASSERT_EQ(grid.cellRepresentative.size(), 1000u);
+  ASSERT_EQ(grid.cellPointStart.size(), 1001u);
+  std::vector<uint32_t> allPoints = grid.cellPoints;
+  std::sort(allPoints.begin(), allPoints.end());
+  for (size_t i = 0; i < allPoints.size(); i++) EXPECT_EQ(allPoints[i], i);
+  for (size_t iC = 0; iC < 1000; iC++) EXPECT_EQ(grid.cellPointStart[iC + 1] - grid.cellPointStart[iC], 8u);
+
+  polyscope::PointCloud* psPoints = polyscope::registerPointCloud("lattice", points);
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  psPoints->addScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  psPoints->setVoxelPreviewSize(0.25);
+  EXPECT_EQ(psPoints->nVoxelPreviewVoxels(), 1000u);
+
+  // from far away only the representatives are drawn, the quantity and picking draw the same subset
+  psPoints->setVoxelPreviewRefinePixels(1e6);
+  polyscope::show(3);
+  EXPECT_GT(psPoints->nVoxelPreviewPointsDrawn(), 0u);
+  EXPECT_LE(psPoints->nVoxelPreviewPointsDrawn(), 1000u);
+  polyscope::pick::pickAtScreenCoords(glm::vec2{0.5, 0.5});
+
+  // refining everywhere draws all of the points in view
+  psPoints->setVoxelPreviewRefinePixels(0.);
+  polyscope::show(3);
+  EXPECT_GT(psPoints->nVoxelPreviewPointsDrawn(), 1000u);
+
+  psPoints->setVoxelPreviewSize(0.);
+  EXPECT_EQ(psPoints->nVoxelPreviewVoxels(), 0u);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudSpatialDrawOrder) {
+  // points on a line, given in a scrambled order
+  std::vector<glm::vec3> points;
+  for (int i = 0; i < 1000; i++) {
+    points.push_back(glm::vec3{static_cast<float>((i * 617) % 1000), 0., 0.});
+  }
+  polyscope::PointCloud* psPoints = polyscope::registerPointCloud("scrambled", points);
+  psPoints->setSpatialDrawOrder(true);
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  psPoints->addScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  polyscope::show(3);
+
+  // the points are drawn sorted along the line, ties broken by input index
+  std::vector<uint32_t> order = psPoints->spatialPointOrder.getPopulatedHostBufferRef();
+  ASSERT_EQ(order.size(), psPoints->nPoints());
+  for (size_t i = 1; i < order.size(); i++) {
+    EXPECT_LE(points[order[i - 1]].x, points[order[i]].x);
+  }
+  polyscope::pick::pickAtScreenCoords(glm::vec2{0.5, 0.5});
+
+  psPoints->setSpatialDrawOrder(false);
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudTransparencySorting) {
+  // points along the view direction, given in a scrambled order
+  std::vector<glm::vec3> points;
+  for (int i = 0; i < 1000; i++) {
+    points.push_back(glm::vec3{0., 0., -0.01f * static_cast<float>((i * 617) % 1000)});
+  }
+  polyscope::PointCloud* psPoints = polyscope::registerPointCloud("sorted", points);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::WeightedBlended;
+  psPoints->setTransparency(0.5);
+  psPoints->setTransparencySorting(true);
+  polyscope::view::lookAt(glm::vec3{0., 0., 5.}, glm::vec3{0., 0., 0.});
+  polyscope::show(3);
+  EXPECT_TRUE(psPoints->drawsSortedTransparency());
+
+  // farthest from the camera first
+  std::vector<uint32_t> order = psPoints->depthPointOrder.getPopulatedHostBufferRef();
+  ASSERT_EQ(order.size(), psPoints->nPoints());
+  for (size_t i = 1; i < order.size(); i++) {
+    EXPECT_LE(points[order[i - 1]].z, points[order[i]].z);
+  }
+
+  // looking from the other side, the order is re-sorted in the background
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  psPoints->addScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  polyscope::view::lookAt(glm::vec3{0., 0., -15.}, glm::vec3{0., 0., 0.});
+  polyscope::show(3);
+
+  psPoints->setTransparencySorting(false);
+  EXPECT_FALSE(psPoints->drawsSortedTransparency());
+  polyscope::show(3);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudPickBatch) {
+  auto psPoints = registerPointCloud();
+
+  std::vector<glm::ivec2> coords = {{77, 88}, {0, 0}, {-5, 3}, {12, 40}};
+  std::vector<std::pair<polyscope::Structure*, size_t>> results = polyscope::pick::pickAtBufferCoordsBatch(coords);
+  EXPECT_EQ(results.size(), coords.size());
+  EXPECT_EQ(results[2].first, nullptr); // out of bounds
+
+  // regions partially outside the buffer still give one result per pixel
+  results = polyscope::pick::pickRegion(-2, 10, 8, 5);
+  EXPECT_EQ(results.size(), 8u * 5u);
+  EXPECT_EQ(results[0].first, nullptr);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudPickElementsInRegion) {
+  auto psPoints = registerPointCloud();
+  auto psMesh = registerTriangleMesh();
+
+  // each element is listed once, and belongs to a structure
+  for (bool includeOccluded : {false, true}) {
+    std::vector<std::pair<polyscope::Structure*, size_t>> results =
+        polyscope::pick::pickElementsInRect(-10, -10, 200, 150, includeOccluded);
+    for (size_t i = 0; i < results.size(); i++) {
+      EXPECT_TRUE(results[i].first == psPoints || results[i].first == psMesh);
+      if (i > 0) EXPECT_NE(results[i], results[i - 1]);
+    }
+
+    std::vector<glm::vec2> lasso = {{10., 10.}, {150., 20.}, {80., 120.}, {-20., 60.}};
+    results = polyscope::pick::pickElementsInLasso(lasso, includeOccluded);
+    for (const std::pair<polyscope::Structure*, size_t>& r : results) {
+      EXPECT_NE(r.first, nullptr);
+    }
+  }
+
+  // regions outside the buffer, and degenerate lassos, select nothing
+  EXPECT_TRUE(polyscope::pick::pickElementsInRect(-50, -50, 20, 20).empty());
+  EXPECT_TRUE(polyscope::pick::pickElementsInLasso({{0., 0.}, {10., 10.}}).empty());
+
+  // the usual pick pass is drawn again afterwards
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudPickAsync) {
+  auto psPoints = registerPointCloud();
+
+  // The result arrives on a later frame
+  std::pair<polyscope::Structure*, size_t> result;
+  polyscope::pick::requestPickAtBufferCoordsAsync(77, 88);
+  EXPECT_FALSE(polyscope::pick::pollAsyncPickResult(result));
+  polyscope::show(3);
+  EXPECT_TRUE(polyscope::pick::pollAsyncPickResult(result));
+  EXPECT_FALSE(polyscope::pick::pollAsyncPickResult(result));
+
+  // Out of bounds requests give an empty result
+  polyscope::pick::requestPickAtBufferCoordsAsync(-10, 88);
+  polyscope::show(3);
+  EXPECT_TRUE(polyscope::pick::pollAsyncPickResult(result));
+  EXPECT_EQ(result.first, nullptr);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudPickIndexPacking) {
+  auto psPoints = registerPointCloud();
+
+  // The pick shaders turn the packed attribute colors into the two words of the integer pick buffer, which must give
+  // back the exact index, also above 2^32
+  std::vector<uint64_t> inds = {0, 1, 12345, (1ull << 22) - 1, 1ull << 22, (1ull << 44) + 77, 0xFFFFFFFFFFFFull};
+  for (uint64_t ind : inds) {
+    glm::vec3 color = polyscope::pick::indToVec(ind);
+    uint32_t chunks[3];
+    for (int i = 0; i < 3; i++) chunks[i] = static_cast<uint32_t>(std::round(color[i] * 4194304.));
+    uint32_t low = chunks[0] | (chunks[1] << 22);
+    uint32_t high = (chunks[1] >> 10) | (chunks[2] << 12);
+    EXPECT_EQ(polyscope::pick::uint2ToInd(low, high), ind);
+  }
+
+  // The debug view draws the pick pass to the display buffer
+  polyscope::options::debugDrawPickBuffer = true;
+  polyscope::show(3);
+  polyscope::options::debugDrawPickBuffer = false;
+
+  polyscope::removeAllStructures();
+}
+
 
 TEST_F(PolyscopeTest, PointCloudColor) {
   auto psPoints = registerPointCloud();
@@ -112,6 +578,209 @@ TEST_F(PolyscopeTest, PointCloudScalar) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, PointCloudManyQuantities) {
+  auto psPoints = registerPointCloud();
+
+  // added out of order, iterated in name order
+  std::vector<glm::vec3> vals(psPoints->nPoints(), glm::vec3{1., 2., 3.});
+  for (int i = 19; i >= 0; i--) {
+    psPoints->addVectorQuantity("vec" + std::to_string(100 + i), vals);
+  }
+  EXPECT_EQ(psPoints->quantities.size(), 20);
+  EXPECT_EQ(psPoints->quantities.begin()->first, "vec100");
+  EXPECT_TRUE(psPoints->getEnabledQuantities().empty());
+
+  psPoints->getQuantity("vec103")->setEnabled(true);
+  psPoints->getQuantity("vec117")->setEnabled(true);
+  psPoints->getQuantity("vec110")->setEnabled(true);
+  ASSERT_EQ(psPoints->getEnabledQuantities().size(), 3);
+  EXPECT_EQ(psPoints->getEnabledQuantities()[1]->name, "vec110");
+  polyscope::show(3);
+
+  psPoints->getQuantity("vec117")->setEnabled(false);
+  EXPECT_EQ(psPoints->getEnabledQuantities().size(), 2);
+  psPoints->removeQuantity("vec103");
+  EXPECT_EQ(psPoints->getEnabledQuantities().size(), 1);
+  EXPECT_EQ(psPoints->getQuantity("vec103"), nullptr);
+  EXPECT_NE(psPoints->getQuantity("vec104"), nullptr);
+  EXPECT_EQ(psPoints->quantities.size(), 19);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudMoveIn) {
+  std::vector<glm::vec3> points = getPoints();
+  polyscope::PointCloud* psPoints = polyscope::registerPointCloud("test1", std::move(points));
+  EXPECT_EQ(psPoints->nPoints(), 4);
+
+  std::vector<float> vScalar(psPoints->nPoints(), 7.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", std::move(vScalar));
+  EXPECT_EQ(q1->values.data.size(), psPoints->nPoints());
+  EXPECT_EQ(q1->values.data[0], 7.);
+
+  std::vector<glm::vec3> vColor(psPoints->nPoints(), glm::vec3{.2, .3, .4});
+  auto q2 = psPoints->addColorQuantity("vColor", std::move(vColor));
+  EXPECT_EQ(q2->colors.data.size(), psPoints->nPoints());
+
+  std::vector<glm::vec3> vVec(psPoints->nPoints(), glm::vec3{1., 0., 0.});
+  auto q3 = psPoints->addVectorQuantity("vVec", std::move(vVec));
+  EXPECT_EQ(q3->vectors.data.size(), psPoints->nPoints());
+
+  // sizes are still checked
+  std::vector<float> badScalar(psPoints->nPoints() + 1);
+  EXPECT_THROW(psPoints->addScalarQuantity("bad", std::move(badScalar)), std::runtime_error);
+
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudScalarSubsetUpdate) {
+  auto psPoints = registerPointCloud();
+
+  std::vector<double> vScalar(psPoints->nPoints());
+  for (size_t i = 0; i < vScalar.size(); i++) vScalar[i] = static_cast<double>(i);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // inside the data range, the histogram is updated in place
+  q1->updateDataSubset(1, std::vector<double>{0., 0.});
+  EXPECT_EQ(q1->values.getValue(1), 0.f);
+  EXPECT_EQ(q1->values.getValue(2), 0.f);
+  polyscope::show(3);
+
+  // outside of it, the histogram gets rebuilt
+  q1->updateDataSubset(0, std::vector<double>{1000.});
+  EXPECT_EQ(q1->values.getValue(0), 1000.f);
+  polyscope::show(3);
+
+  EXPECT_THROW(q1->updateDataSubset(psPoints->nPoints(), std::vector<double>{0.}), std::runtime_error);
+
+  // whole updates are rebuilt lazily
+  q1->updateData(vScalar);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudScalarManyHistograms) {
+  auto psPoints = registerPointCloud();
+
+  // more histograms than fit on one atlas page
+  std::vector<double> vScalar(psPoints->nPoints());
+  for (size_t i = 0; i < vScalar.size(); i++) vScalar[i] = static_cast<double>(i);
+  for (int i = 0; i < 20; i++) {
+    auto q = psPoints->addScalarQuantity("vScalar" + std::to_string(i), vScalar);
+    q->setEnabled(true);
+  }
+  polyscope::show(3);
+
+  // freed slots get reused
+  psPoints->removeQuantity("vScalar3");
+  psPoints->getQuantity("vScalar5")->setEnabled(false);
+  psPoints->addScalarQuantity("vScalarNew", vScalar)->setColorMap("blues");
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudScalarColorMapAtlas) {
+  auto psPoints = registerPointCloud();
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  auto q2 = psPoints->addScalarQuantity("vScalar2", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // all color maps are rows of one shared texture, switching between them only changes a uniform
+  polyscope::render::TextureBuffer& atlas = polyscope::render::engine->getColorMapAtlas();
+  EXPECT_EQ(atlas.getSizeY(), polyscope::render::engine->colorMaps.size());
+  for (std::string cmap : {"blues", "turbo", "viridis"}) {
+    q1->setColorMap(cmap);
+    polyscope::show(3);
+  }
+  q2->setColorMap("reds");
+  q2->setEnabled(true);
+  polyscope::show(3);
+  EXPECT_EQ(&atlas, &polyscope::render::engine->getColorMapAtlas());
+
+  EXPECT_THROW(polyscope::render::engine->getColorMapAtlasRow("not a colormap"), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudScalarRangeLarge) {
+  // enough values that the data range and histogram are computed in parallel
+  size_t N = 200000;
+  std::vector<glm::vec3> points(N);
+  std::vector<double> vScalar(N);
+  for (size_t i = 0; i < N; i++) {
+    points[i] = glm::vec3{i, 0., 0.};
+    vScalar[i] = i;
+  }
+  vScalar[17] = std::numeric_limits<double>::quiet_NaN();
+  vScalar[N / 2] = std::numeric_limits<double>::infinity();
+  vScalar[N - 1] = -std::numeric_limits<double>::infinity();
+
+  int oldNumThreads = polyscope::options::numThreads;
+  polyscope::options::numThreads = 4;
+  auto psPoints = polyscope::registerPointCloud("big cloud", points);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  polyscope::options::numThreads = oldNumThreads;
+
+  std::pair<double, double> range = q1->getDataRange();
+  EXPECT_EQ(range.first, 0.);
+  EXPECT_EQ(range.second, N - 2.);
+
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudUpdateDataInPlace) {
+  auto psPoints = registerPointCloud();
+  size_t n = psPoints->nPoints();
+
+  std::vector<float> vScalar(n, 7.);
+  vScalar[0] = 1.;
+  auto qScalar = psPoints->addScalarQuantity("vScalar", vScalar);
+  qScalar->setEnabled(true);
+  std::pair<double, double> mapRange = qScalar->getMapRange();
+  polyscope::show(3);
+
+  // the values are replaced in place, and the map range stays fixed
+  std::vector<float> newScalar(n, 20.);
+  qScalar->updateData(newScalar.data(), newScalar.size());
+  EXPECT_EQ(qScalar->values.getValue(0), 20.);
+  EXPECT_EQ(qScalar->getMapRange(), mapRange);
+  polyscope::show(3);
+  EXPECT_THROW(qScalar->updateData(newScalar.data(), n - 1), std::runtime_error);
+
+  std::vector<glm::vec3> vColors(n, glm::vec3{0.2, 0.3, 0.4});
+  auto qColor = psPoints->addColorQuantity("vColor", vColors);
+  qColor->setEnabled(true);
+  polyscope::show(3);
+  vColors[1] = glm::vec3{1., 0., 0.};
+  qColor->updateData(vColors.data(), vColors.size());
+  EXPECT_EQ(qColor->colors.getValue(1), glm::vec3(1., 0., 0.));
+  polyscope::show(3);
+
+  std::vector<glm::vec3> vVecs(n, glm::vec3{0., 3., 4.});
+  auto qVector = psPoints->addVectorQuantity("vVecs", vVecs);
+  qVector->setEnabled(true);
+  polyscope::show(3);
+  vVecs[2] = glm::vec3{0., 0., 10.};
+  qVector->updateData(vVecs.data(), vVecs.size());
+  EXPECT_FLOAT_EQ(qVector->getVectorLengthRange(), 10.);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, PointCloudVector) {
   auto psPoints = registerPointCloud();
 
@@ -126,6 +795,29 @@ TEST_F(PolyscopeTest, PointCloudVector) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, PointCloudVectorLengthRange) {
+  auto psPoints = registerPointCloud();
+
+  std::vector<glm::vec3> vals(psPoints->nPoints(), {0., 3., 4.});
+  vals[1] = glm::vec3{std::numeric_limits<float>::quiet_NaN(), 0., 0.}; // non-finite vectors are ignored
+  auto q1 = psPoints->addVectorQuantity("vals", vals);
+  q1->setEnabled(true);
+  EXPECT_FLOAT_EQ(q1->getVectorLengthRange(), 5.);
+  polyscope::show(3);
+
+  vals[0] = glm::vec3{0., 0., 10.};
+  q1->updateData(vals);
+  EXPECT_FLOAT_EQ(q1->getVectorLengthRange(), 10.);
+
+  // a manual range is kept across updates
+  q1->setVectorLengthRange(2.);
+  q1->updateData(vals);
+  polyscope::show(3);
+  EXPECT_FLOAT_EQ(q1->getVectorLengthRange(), 2.);
+
+  polyscope::removeAllStructures();
+}
+
 
 TEST_F(PolyscopeTest, PointCloudParam) {
   auto psPoints = registerPointCloud();
@@ -153,6 +845,135 @@ TEST_F(PolyscopeTest, PointCloudParam) {
 }
 
 
+TEST_F(PolyscopeTest, PointCloudScalarView) {
+  auto psPoints = registerPointCloud();
+
+  std::shared_ptr<std::vector<float>> vScalar = std::make_shared<std::vector<float>>(psPoints->nPoints(), 7.);
+  vScalar->back() = 3.;
+  auto q1 = psPoints->addScalarQuantityView("vScalar", vScalar->data(), vScalar->size(), vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // the quantity reads the external memory in place
+  EXPECT_TRUE(q1->values.hasExternalView());
+  EXPECT_EQ(q1->values.getValue(psPoints->nPoints() - 1), 3.);
+
+  // accessing the host data materializes a copy
+  q1->values.ensureHostBufferPopulated();
+  EXPECT_FALSE(q1->values.hasExternalView());
+  EXPECT_EQ(q1->values.data.size(), psPoints->nPoints());
+  polyscope::show(3);
+
+  // wrong size is an error
+  EXPECT_THROW(psPoints->addScalarQuantityView("bad", vScalar->data(), 2, vScalar), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudIncrementalLoading) {
+  polyscope::PointCloud* psPoints = polyscope::beginPointCloud("loading", 300);
+  EXPECT_EQ(psPoints->nPoints(), 0u);
+
+  auto chunk = [](size_t begin, size_t count, std::vector<glm::vec3>& points, std::vector<float>& vals) {
+    points.resize(count);
+    vals.resize(count);
+    for (size_t i = 0; i < count; i++) {
+      points[i] = glm::vec3{begin + i, 0., 0.};
+      vals[i] = begin + i;
+    }
+  };
+  std::vector<glm::vec3> points;
+  std::vector<float> vals;
+
+  chunk(0, 100, points, vals);
+  psPoints->appendPoints(points);
+  auto q1 = psPoints->addScalarQuantity("vals", vals);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // drawn while loading continues, only the new points are uploaded
+  chunk(100, 100, points, vals);
+  psPoints->appendPoints(points);
+  q1->appendValues(vals);
+  polyscope::show(3);
+  EXPECT_EQ(psPoints->nPoints(), 200u);
+  EXPECT_EQ(q1->getDataRange().second, 199.);
+  EXPECT_EQ(std::get<1>(psPoints->boundingBox()).x, 199.);
+
+  // appending without a host copy goes straight to the render buffer
+  psPoints->points.setHostResidency(polyscope::HostResidency::DropAfterUpload);
+  chunk(200, 100, points, vals);
+  psPoints->appendPoints(points);
+  q1->appendValues(vals);
+  polyscope::show(3);
+  EXPECT_EQ(psPoints->nPoints(), 300u);
+
+  psPoints->finalizePoints();
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudReplacePoints) {
+  auto psPoints = registerPointCloud();
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // grow, quantities are re-added at the new size
+  std::vector<glm::vec3> points;
+  for (int i = 0; i < 100; i++) points.push_back(glm::vec3{i, 0., 0.});
+  psPoints->replacePoints(points);
+  psPoints->addScalarQuantity("vals", std::vector<float>(points.size(), 1.))->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+  EXPECT_EQ(psPoints->nPoints(), 100u);
+  EXPECT_EQ(std::get<1>(psPoints->boundingBox()).x, 99.);
+
+  // shrink
+  points.resize(10);
+  psPoints->replacePoints(points);
+  psPoints->addScalarQuantity("vals", std::vector<float>(points.size(), 2.))->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+  EXPECT_EQ(psPoints->nPoints(), 10u);
+  EXPECT_EQ(std::get<1>(psPoints->boundingBox()).x, 9.);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudBoundsFollowUpdates) {
+  std::vector<glm::vec3> points;
+  for (int i = 0; i < 10; i++) points.push_back(glm::vec3{i, 0., 0.});
+  auto psPoints = polyscope::registerPointCloud("bounds", points);
+  float lengthScale = psPoints->lengthScale();
+
+  // growing moves the box, but not the length scale
+  points[3].x = 20.;
+  psPoints->updatePointPositions(points);
+  EXPECT_EQ(std::get<1>(psPoints->boundingBox()).x, 20.);
+  EXPECT_EQ(psPoints->lengthScale(), lengthScale);
+  EXPECT_EQ(std::get<1>(polyscope::state::boundingBox).x, 20.);
+
+  // a subset inside the box leaves it as is, moving the extreme point back shrinks it
+  psPoints->updatePointPositionsSubset(1, std::vector<glm::vec3>{{5., 0., 0.}});
+  EXPECT_EQ(std::get<1>(psPoints->boundingBox()).x, 20.);
+  psPoints->updatePointPositionsSubset(3, std::vector<glm::vec3>{{3., 0., 0.}});
+  EXPECT_EQ(std::get<1>(psPoints->boundingBox()).x, 9.);
+  polyscope::show(3);
+
+  // without automatic scene extents, the box only grows
+  polyscope::options::automaticallyComputeSceneExtents = false;
+  psPoints->updatePointPositionsSubset(9, std::vector<glm::vec3>{{0., 0., 0.}});
+  EXPECT_EQ(std::get<1>(psPoints->boundingBox()).x, 9.);
+  psPoints->updatePointPositionsSubset(9, std::vector<glm::vec3>{{0., 30., 0.}});
+  EXPECT_EQ(std::get<1>(psPoints->boundingBox()).y, 30.);
+  polyscope::options::automaticallyComputeSceneExtents = true;
+
+  EXPECT_THROW(psPoints->updatePointPositionsSubset(9, std::vector<glm::vec3>(2)), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, PointCloudScalarRadius) {
   auto psPoints = registerPointCloud();
   std::vector<double> vScalar(psPoints->nPoints(), 7.);
@@ -182,6 +1003,31 @@ TEST_F(PolyscopeTest, PointCloudScalarRadius) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, PointCloudSwapRadiusAndTransparency) {
+  auto psPoints = registerPointCloud();
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  std::vector<double> vScalar2(psPoints->nPoints(), 3.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  auto q2 = psPoints->addScalarQuantity("vScalar2", vScalar2);
+  psPoints->setPointRadiusQuantity(q1);
+  psPoints->setTransparencyQuantity(q1);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // swapping the sources re-binds the values on the existing programs, including those of enabled quantities
+  q2->setEnabled(true);
+  polyscope::show(3);
+  psPoints->setPointRadiusQuantity(q2);
+  psPoints->setTransparencyQuantity(q2);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psPoints->setPointRadiusQuantity(q1, false);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, PointCloudScalarTransparency) {
   auto psPoints = registerPointCloud();
   std::vector<double> vScalar(psPoints->nPoints(), 7.);
@@ -218,3 +1064,196 @@ TEST_F(PolyscopeTest, PointCloudScalarTransparency) {
 
   polyscope::removeAllStructures();
 }
+
+TEST_F(PolyscopeTest, PointCloudKeyframes) {
+  auto psPoints = registerPointCloud();
+  std::vector<std::vector<glm::vec3>> frames;
+  for (int i = 0; i < 3; i++) {
+    std::vector<glm::vec3> frame = getPoints();
+    for (glm::vec3& p : frame) p += glm::vec3{0., i, 0.};
+    frames.push_back(frame);
+  }
+  psPoints->setPointPositionKeyframes(frames);
+  EXPECT_TRUE(psPoints->hasPositionKeyframes());
+  EXPECT_EQ(psPoints->nKeyframes(), 3);
+  polyscope::show(3);
+
+  psPoints->setKeyframeTime(1.5);
+  polyscope::show(3);
+  psPoints->setKeyframesPlaying(true);
+  polyscope::show(3);
+  psPoints->setKeyframesPlaying(false);
+
+  // scalar keyframes share the timeline
+  std::vector<std::vector<double>> valFrames(3, std::vector<double>(psPoints->nPoints(), 0.));
+  valFrames[2][0] = 7.;
+  auto q1 = psPoints->addScalarKeyframes("vals", valFrames);
+  q1->setEnabled(true);
+  EXPECT_TRUE(q1->hasValueKeyframes());
+  EXPECT_EQ(q1->getDataRange().second, 7.);
+  polyscope::show(3);
+
+  // other render modes
+  psPoints->setPointRenderMode(polyscope::PointRenderMode::Quad);
+  polyscope::show(3);
+
+  // all keyframed data must have the same number of frames
+  valFrames.pop_back();
+  EXPECT_THROW(psPoints->addScalarKeyframes("vals2", valFrames), std::runtime_error);
+
+  psPoints->clearPositionKeyframes();
+  EXPECT_FALSE(psPoints->hasPositionKeyframes());
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudDeviceWrite) {
+  auto psPoints = registerPointCloud();
+  polyscope::show(3);
+
+  uint64_t version = psPoints->points.getDataVersion();
+  uint32_t bufferID = psPoints->points.beginDeviceWrite();
+  EXPECT_NE(bufferID, 0u);
+  EXPECT_TRUE(psPoints->points.isDeviceWriteActive());
+  EXPECT_THROW(psPoints->points.beginDeviceWrite(), std::runtime_error);
+  psPoints->points.endDeviceWrite();
+  EXPECT_FALSE(psPoints->points.isDeviceWriteActive());
+  EXPECT_GT(psPoints->points.getDataVersion(), version);
+  polyscope::show(3);
+
+  EXPECT_THROW(psPoints->points.endDeviceWrite(), std::runtime_error);
+
+  // scalar ranges follow values written on the device
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+  q1->values.beginDeviceWrite();
+  q1->values.endDeviceWrite();
+  EXPECT_TRUE(q1->values.isCanonicalOnDevice());
+  q1->refreshDataRange();
+  std::pair<double, double> range = q1->getDataRange();
+  EXPECT_LE(range.first, range.second);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudStagedUpdates) {
+  auto psPoints = registerPointCloud();
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // stage from worker threads, the last staged data wins
+  std::vector<glm::vec3> moved = getPoints();
+  for (glm::vec3& p : moved) p += glm::vec3{1., 0., 0.};
+  std::thread worker([&]() {
+    psPoints->stagePointPositions(getPoints());
+    psPoints->stagePointPositions(moved);
+    q1->stageData(std::vector<double>(psPoints->nPoints(), 3.));
+  });
+  worker.join();
+  EXPECT_NE(psPoints->points.getValue(0), moved[0]);
+  polyscope::show(1);
+  EXPECT_EQ(psPoints->points.getValue(0), moved[0]);
+  EXPECT_EQ(q1->values.getValue(0), 3.);
+  polyscope::show(3);
+
+  // the positions swapped out by a staged update are converted into by the next one
+  polyscope::releaseStagingPools();
+  const glm::vec3* swappedOut = psPoints->points.data.data();
+  psPoints->stagePointPositions(getPoints());
+  polyscope::show(1);
+  EXPECT_NE(psPoints->points.data.data(), swappedOut);
+  std::thread secondWorker([&]() { psPoints->stagePointPositions(moved); });
+  secondWorker.join();
+  polyscope::show(1);
+  EXPECT_EQ(psPoints->points.data.data(), swappedOut);
+  EXPECT_EQ(psPoints->points.getValue(0), moved[0]);
+
+  // and the pools can be emptied
+  polyscope::releaseStagingPools();
+  EXPECT_EQ(polyscope::acquireStagingBuffer<glm::vec3>().capacity(), 0u);
+
+  // wrong sizes are caught at the sync point
+  psPoints->stagePointPositions(std::vector<glm::vec3>(3));
+  EXPECT_THROW(polyscope::processQueuedUpdates(), std::runtime_error);
+
+  // updates to deleted structures are dropped
+  psPoints->stagePointPositions(moved);
+  polyscope::removeAllStructures();
+  polyscope::show(1);
+
+  // staging buffers come back from the pool empty
+  std::vector<float> buffer(100);
+  polyscope::releaseStagingBuffer(std::move(buffer));
+  EXPECT_TRUE(polyscope::acquireStagingBuffer<float>().empty());
+}
+
+TEST_F(PolyscopeTest, PointCloudManyStructuresPreparedDraws) {
+  // enough structures that their uniforms are set on several threads
+  int oldNumThreads = polyscope::options::numThreads;
+  polyscope::options::numThreads = 4;
+  std::vector<polyscope::PointCloud*> clouds;
+  for (int i = 0; i < 80; i++) {
+    clouds.push_back(registerPointCloud("cloud" + std::to_string(i)));
+  }
+  polyscope::show(3);
+
+  // some drawn by a quantity, some transparent
+  std::vector<double> vScalar(clouds[0]->nPoints(), 7.);
+  clouds[3]->addScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  clouds[5]->setTransparency(0.5);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Simple;
+  polyscope::show(3);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+
+  polyscope::options::numThreads = oldNumThreads;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudSelection) {
+  std::vector<glm::vec3> points;
+  for (int i = 0; i < 100; i++) points.push_back(glm::vec3{i, 0., 0.});
+  auto psPoints = polyscope::registerPointCloud("selected", points);
+  psPoints->addScalarQuantity("vals", std::vector<float>(points.size(), 1.));
+
+  // ranges which straddle the packed words
+  polyscope::ElementSelection& selection = psPoints->getPointSelection();
+  EXPECT_TRUE(psPoints->hasPointSelection());
+  selection.set(20, 10);
+  selection.toggle(25, 10);
+  selection.clear(std::vector<size_t>{21});
+  EXPECT_EQ(selection.nSelected(), 9u);
+  EXPECT_TRUE(selection.isSelected(20));
+  EXPECT_FALSE(selection.isSelected(21));
+  EXPECT_FALSE(selection.isSelected(27));
+  EXPECT_TRUE(selection.isSelected(34));
+  EXPECT_EQ(selection.getSelected().front(), 20u);
+  EXPECT_THROW(selection.set(95, 10), std::runtime_error);
+
+  // drawn in each mode, and with a quantity
+  for (polyscope::PointRenderMode mode :
+       {polyscope::PointRenderMode::Sphere, polyscope::PointRenderMode::Quad, polyscope::PointRenderMode::Splat}) {
+    psPoints->setPointRenderMode(mode);
+    polyscope::show(3);
+  }
+  psPoints->getQuantity("vals")->setEnabled(true);
+  selection.toggle(0, 100);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // follows the size of the cloud
+  points.resize(10);
+  psPoints->replacePoints(points);
+  EXPECT_EQ(psPoints->getPointSelection().size(), 10u);
+  EXPECT_EQ(psPoints->getPointSelection().nSelected(), 10u);
+  psPoints->removePointSelection();
+  EXPECT_FALSE(psPoints->hasPointSelection());
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
@@ -80,6 +80,208 @@ TEST_F(PolyscopeTest, SurfaceMeshPolygon) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshPolygonParallel) {
+  // a mesh large enough that connectivity is built in parallel, with mixed face degrees
+  size_t N = 120;
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  for (size_t i = 0; i <= N; i++) {
+    for (size_t j = 0; j <= N; j++) {
+      points.push_back(glm::vec3{i, j, 0.});
+    }
+  }
+  for (size_t i = 0; i < N; i++) {
+    for (size_t j = 0; j < N; j++) {
+      size_t v0 = i * (N + 1) + j;
+      if ((i + j) % 2 == 0) {
+        faces.push_back({v0, v0 + N + 1, v0 + N + 2, v0 + 1});
+      } else {
+        faces.push_back({v0, v0 + N + 1, v0 + N + 2});
+        faces.push_back({v0, v0 + N + 2, v0 + 1});
+      }
+    }
+  }
+
+  int oldNumThreads = polyscope::options::numThreads;
+  polyscope::options::numThreads = 1;
+  polyscope::SurfaceMesh* psSerial = polyscope::registerSurfaceMesh("mesh serial", points, faces);
+  polyscope::options::numThreads = 4;
+  polyscope::SurfaceMesh* psParallel = polyscope::registerSurfaceMesh("mesh parallel", points, faces);
+  polyscope::options::numThreads = oldNumThreads;
+
+  ASSERT_EQ(psSerial->triangleVertexInds.size(), psParallel->triangleVertexInds.size());
+  for (size_t i = 0; i < psSerial->triangleVertexInds.size(); i++) {
+    EXPECT_EQ(psSerial->triangleVertexInds.getValue(i), psParallel->triangleVertexInds.getValue(i));
+  }
+
+  polyscope::show(3);
+
+  // out-of-bounds indices are still reported
+  faces.back().back() = points.size();
+  EXPECT_THROW(polyscope::registerSurfaceMesh("mesh bad", points, faces), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshGeometryBuffers) {
+  // derived geometry is computed by a fused parallel kernel, it should not depend on the thread count
+  size_t N = 120;
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  for (size_t i = 0; i <= N; i++) {
+    for (size_t j = 0; j <= N; j++) {
+      points.push_back(glm::vec3{i, j, 0.});
+    }
+  }
+  for (size_t i = 0; i < N; i++) {
+    for (size_t j = 0; j < N; j++) {
+      size_t v0 = i * (N + 1) + j;
+      if ((i + j) % 2 == 0) {
+        faces.push_back({v0, v0 + N + 1, v0 + N + 2, v0 + 1});
+      } else {
+        faces.push_back({v0, v0 + N + 1, v0 + N + 2});
+        faces.push_back({v0, v0 + N + 2, v0 + 1});
+      }
+    }
+  }
+
+  int oldNumThreads = polyscope::options::numThreads;
+  polyscope::options::numThreads = 1;
+  polyscope::SurfaceMesh* psSerial = polyscope::registerSurfaceMesh("mesh serial", points, faces);
+  psSerial->vertexAreas.ensureHostBufferPopulated();
+  polyscope::options::numThreads = 4;
+  polyscope::SurfaceMesh* psParallel = polyscope::registerSurfaceMesh("mesh parallel", points, faces);
+  psParallel->vertexAreas.ensureHostBufferPopulated();
+  psParallel->vertexNormals.ensureHostBufferPopulated();
+  psParallel->faceCenters.ensureHostBufferPopulated();
+
+  double totalArea = 0.;
+  for (size_t iV = 0; iV < points.size(); iV++) {
+    EXPECT_EQ(psSerial->vertexAreas.getValue(iV), psParallel->vertexAreas.getValue(iV));
+    EXPECT_NEAR(psParallel->vertexNormals.getValue(iV).z, 1., 1e-5);
+    totalArea += psParallel->vertexAreas.getValue(iV);
+  }
+  EXPECT_NEAR(totalArea, N * N, 1e-2);
+  EXPECT_NEAR(psParallel->faceCenters.getValue(0).x, 0.5, 1e-5);
+
+  // moving the vertices recomputes everything that was populated
+  for (glm::vec3& p : points) p *= 2.;
+  psParallel->updateVertexPositions(points);
+  polyscope::options::numThreads = oldNumThreads;
+  psParallel->vertexAreas.ensureHostBufferPopulated();
+  psParallel->faceCenters.ensureHostBufferPopulated();
+  for (size_t iV = 0; iV < points.size(); iV++) {
+    EXPECT_NEAR(psParallel->vertexAreas.getValue(iV), 4. * psSerial->vertexAreas.getValue(iV), 1e-4);
+  }
+  EXPECT_NEAR(psParallel->faceCenters.getValue(0).x, 1., 1e-5);
+
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshNormalsAfterUpdate) {
+  // normals which are being drawn may be recomputed on the device, they must still read back correctly
+  std::vector<glm::vec3> points = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}};
+  std::vector<std::vector<size_t>> faces = {{0, 1, 2}, {0, 2, 3}};
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("mesh", points, faces);
+  polyscope::show(3);
+  psMesh->setShadeStyle(polyscope::MeshShadeStyle::Smooth);
+  polyscope::show(3);
+
+  // flip the mesh over
+  for (glm::vec3& p : points) p.y = -p.y;
+  psMesh->updateVertexPositions(points);
+  polyscope::show(3);
+
+  EXPECT_NEAR(psMesh->faceNormals.getValue(1).z, -1., 1e-5);
+  EXPECT_NEAR(psMesh->vertexNormals.getValue(2).z, -1., 1e-5);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshPrepareHostData) {
+  // the derived data of many meshes registered at once is computed concurrently before their first draw
+  std::vector<glm::vec3> points = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}};
+  std::vector<std::vector<size_t>> faces = {{0, 1, 2}, {0, 2, 3}};
+  std::vector<polyscope::SurfaceMesh*> meshes;
+  for (int i = 0; i < 50; i++) {
+    polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("mesh " + std::to_string(i), points, faces);
+    psMesh->setEdgeWidth(1.); // drawn without the index buffer, so it needs the face normals
+    if (i % 2 == 0) psMesh->setShadeStyle(polyscope::MeshShadeStyle::Smooth);
+    EXPECT_TRUE(psMesh->hasPendingHostData());
+    meshes.push_back(psMesh);
+  }
+  meshes.back()->setEnabled(false);
+  EXPECT_FALSE(meshes.back()->hasPendingHostData());
+
+  polyscope::show(3);
+
+  for (size_t i = 0; i + 1 < meshes.size(); i++) {
+    EXPECT_FALSE(meshes[i]->hasPendingHostData());
+    EXPECT_NEAR(meshes[i]->faceNormals.getValue(1).z, 1., 1e-5);
+    if (i % 2 == 0) EXPECT_NEAR(meshes[i]->vertexNormals.getValue(2).z, 1., 1e-5);
+  }
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshCSR) {
+  std::vector<glm::vec3> points = {{1, 0, 0}, {0, 1, 0}, {0, 0, 0}, {1, 1, 0}, {2, 0, 0}};
+
+  // a quad and a triangle
+  std::vector<uint32_t> offsets = {0, 4, 7};
+  std::vector<uint32_t> indices = {2, 0, 3, 1, 0, 4, 3};
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMeshCSR("mesh csr", points, offsets, indices);
+  EXPECT_EQ(psMesh->nFaces(), 2u);
+  EXPECT_EQ(psMesh->nCorners(), 7u);
+
+  std::vector<uint64_t> offsets64(offsets.begin(), offsets.end());
+  std::vector<uint64_t> indices64(indices.begin(), indices.end());
+  psMesh = polyscope::registerSurfaceMeshCSR("mesh csr64", points, offsets64, indices64);
+  EXPECT_EQ(psMesh->nFaces(), 2u);
+  polyscope::show(3);
+
+  // malformed offsets and out-of-range indices are reported
+  offsets64.back() = 6;
+  EXPECT_THROW(polyscope::registerSurfaceMeshCSR("mesh bad", points, offsets64, indices64), std::runtime_error);
+  offsets64.back() = 7;
+  indices64.back() = uint64_t(1) << 40;
+  EXPECT_THROW(polyscope::registerSurfaceMeshCSR("mesh bad", points, offsets64, indices64), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshMoveIn) {
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  std::tie(points, faces) = getTriangleMesh();
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("test1", std::move(points), faces);
+  EXPECT_EQ(psMesh->nVertices(), 4);
+  EXPECT_EQ(psMesh->nFaces(), 4);
+
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", std::vector<float>(psMesh->nVertices(), 1.));
+  EXPECT_EQ(q1->values.data.size(), psMesh->nVertices());
+  auto q2 = psMesh->addFaceScalarQuantity("fScalar", std::vector<float>(psMesh->nFaces(), 2.));
+  EXPECT_EQ(q2->values.data.size(), psMesh->nFaces());
+  auto q3 = psMesh->addVertexColorQuantity("vColor", std::vector<glm::vec3>(psMesh->nVertices()));
+  EXPECT_EQ(q3->colors.data.size(), psMesh->nVertices());
+  auto q4 = psMesh->addFaceColorQuantity("fColor", std::vector<glm::vec3>(psMesh->nFaces()));
+  EXPECT_EQ(q4->colors.data.size(), psMesh->nFaces());
+  std::vector<glm::vec3> vVec(psMesh->nVertices(), glm::vec3{1., 0., 0.});
+  auto q5 = psMesh->addVertexVectorQuantity("vVec", std::move(vVec));
+  EXPECT_EQ(q5->vectors.data.size(), psMesh->nVertices());
+  auto q6 = psMesh->addFaceVectorQuantity("fVec", std::vector<glm::vec3>(psMesh->nFaces(), glm::vec3{1., 0., 0.}));
+  EXPECT_EQ(q6->vectors.data.size(), psMesh->nFaces());
+
+  EXPECT_THROW(psMesh->addFaceScalarQuantity("bad", std::vector<float>(psMesh->nFaces() + 1)), std::runtime_error);
+
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshAppearance) {
   auto psMesh = registerTriangleMesh();
 
@@ -219,6 +421,120 @@ TEST_F(PolyscopeTest, SurfaceMeshScalarVertex) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshScalarVertexIsolines) {
+  auto psMesh = registerTriangleMesh();
+
+  // the height of each vertex, only vertex 2 is above z = 0
+  std::vector<float> vScalar{0., 0., 1., 0.};
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+
+  // one loop around vertex 2, through the midpoints of its three edges; the other levels cross nothing
+  polyscope::SurfaceVertexScalarQuantity::Isolines lines =
+      polyscope::SurfaceVertexScalarQuantity::extractIsolines(*psMesh, vScalar, {0.5, 0., 2.});
+  ASSERT_EQ(lines.nodes.size(), 3u);
+  ASSERT_EQ(lines.edges.size(), 3u);
+  std::vector<int> degree(lines.nodes.size(), 0);
+  for (const std::array<size_t, 2>& e : lines.edges) {
+    EXPECT_NE(e[0], e[1]);
+    degree[e[0]]++;
+    degree[e[1]]++;
+  }
+  for (size_t i = 0; i < lines.nodes.size(); i++) {
+    EXPECT_EQ(degree[i], 2);
+    EXPECT_NEAR(lines.nodes[i].z, 0.5, 1e-5);
+    EXPECT_EQ(lines.nodeLevels[i], 0.5);
+  }
+
+  polyscope::CurveNetwork* psCurve = q1->createCurveNetworkFromIsolines({0.25, 0.75});
+  EXPECT_EQ(psCurve->nNodes(), 6u);
+  EXPECT_EQ(psCurve->nEdges(), 6u);
+  EXPECT_NE(psCurve->getQuantity("level"), nullptr);
+
+  q1->setEnabled(true);
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshScalarLazyRange) {
+  auto psMesh = registerTriangleMesh();
+
+  // many quantities, only one of which is ever shown
+  std::vector<double> vScalar(psMesh->nVertices());
+  for (size_t i = 0; i < vScalar.size(); i++) vScalar[i] = static_cast<double>(i);
+  for (int i = 0; i < 20; i++) {
+    psMesh->addVertexScalarQuantity("vScalar" + std::to_string(i), vScalar);
+  }
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setMapRange({1., 2.});
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // the data range is computed when asked for, and does not override the map range which was set
+  EXPECT_NEAR(q1->getDataRange().first, 0., 1e-3);
+  EXPECT_NEAR(q1->getDataRange().second, static_cast<double>(vScalar.size() - 1), 1e-3);
+  EXPECT_EQ(q1->getMapRange().first, 1.);
+  EXPECT_EQ(q1->getMapRange().second, 2.);
+
+  auto q2 = psMesh->getQuantity("vScalar3");
+  ASSERT_NE(q2, nullptr);
+  q2->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshMemoryUsage) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::show(3);
+  polyscope::render::MemoryUsage meshUsage = psMesh->getMemoryUsage();
+  EXPECT_GT(meshUsage.hostBytes, 0u);
+  EXPECT_GT(meshUsage.deviceBytes, 0u);
+
+  // quantities are included once drawn
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+  polyscope::render::MemoryUsage withQuantity = psMesh->getMemoryUsage();
+  EXPECT_GT(withQuantity.hostBytes, meshUsage.hostBytes);
+  EXPECT_GT(withQuantity.deviceBytes, meshUsage.deviceBytes);
+  EXPECT_GE(polyscope::render::getDeviceMemoryUsage().totalBytes(), withQuantity.deviceBytes);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshIndexedDrawing) {
+  auto psMesh = registerTriangleMesh();
+  psMesh->setShadeStyle(polyscope::MeshShadeStyle::Smooth);
+  EXPECT_TRUE(psMesh->canDrawIndexed());
+  polyscope::show(3);
+
+  // vertex quantities share the per-vertex buffers
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+  std::vector<glm::vec3> vColors(psMesh->nVertices(), glm::vec3{.2, .3, .4});
+  auto q2 = psMesh->addVertexColorQuantity("vColors", vColors);
+  q2->setEnabled(true);
+  polyscope::show(3);
+
+  // per-corner data falls back to the expanded buffers
+  psMesh->setEdgeWidth(1.);
+  EXPECT_FALSE(psMesh->canDrawIndexed());
+  polyscope::show(3);
+  psMesh->setEdgeWidth(0.);
+  psMesh->setShadeStyle(polyscope::MeshShadeStyle::TriFlat);
+  psMesh->setChunkSize(2);
+  EXPECT_FALSE(psMesh->canDrawIndexed());
+  polyscope::show(3);
+  psMesh->setChunkSize(0);
+  EXPECT_TRUE(psMesh->canDrawIndexed());
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshScalarFace) {
   auto psMesh = registerTriangleMesh();
   std::vector<double> fScalar(psMesh->nFaces(), 8.);
@@ -228,6 +544,63 @@ TEST_F(PolyscopeTest, SurfaceMeshScalarFace) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshScalarView) {
+  auto psMesh = registerTriangleMesh();
+
+  std::shared_ptr<std::vector<float>> vScalar = std::make_shared<std::vector<float>>(psMesh->nVertices(), 7.);
+  auto q1 = psMesh->addVertexScalarQuantityView("vScalar", vScalar->data(), vScalar->size(), vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+  EXPECT_TRUE(q1->values.hasExternalView());
+
+  // face values are read in place by the element texture too
+  std::shared_ptr<std::vector<float>> fScalar = std::make_shared<std::vector<float>>(psMesh->nFaces(), 8.);
+  fScalar->back() = 2.;
+  auto q2 = psMesh->addFaceScalarQuantityView("fScalar", fScalar->data(), fScalar->size(), fScalar);
+  q2->setEnabled(true);
+  polyscope::show(3);
+  EXPECT_TRUE(q2->values.hasExternalView());
+  EXPECT_EQ(q2->values.getValue(psMesh->nFaces() - 1), 2.);
+  EXPECT_EQ(q2->getDataRange().first, 2.);
+
+  EXPECT_THROW(psMesh->addFaceScalarQuantityView("bad", fScalar->data(), 1, fScalar), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshElementValuesUpdate) {
+  // face and edge values are read from a texture by element index, which is updated along with the data
+  auto psMesh = registerTriangleMesh();
+  std::vector<double> fScalar(psMesh->nFaces(), 8.);
+  auto qScalar = psMesh->addFaceScalarQuantity("fScalar", fScalar);
+  qScalar->setEnabled(true);
+  polyscope::show(3);
+  fScalar[0] = 2.;
+  qScalar->updateData(fScalar);
+  polyscope::show(3);
+
+  std::vector<glm::vec3> fColor(psMesh->nFaces(), glm::vec3{0.2, 0.3, 0.4});
+  auto qColor = psMesh->addFaceColorQuantity("fColor", fColor);
+  qColor->setEnabled(true);
+  polyscope::show(3);
+  fColor[1] = glm::vec3{1., 0., 0.};
+  qColor->updateData(fColor);
+  polyscope::show(3);
+
+  std::vector<double> eScalar(6, 9.);
+  auto qEdge = psMesh->addEdgeScalarQuantity("eScalar", eScalar);
+  qEdge->setEnabled(true);
+  polyscope::show(3);
+
+  // chunked drawing, and the face values as transparency, which still reads them per corner
+  psMesh->setChunkSize(1);
+  psMesh->setTransparencyQuantity(qScalar);
+  qScalar->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshScalarEdge) {
   auto psMesh = registerTriangleMesh();
   size_t nEdges = 6;
@@ -240,6 +613,42 @@ TEST_F(PolyscopeTest, SurfaceMeshScalarEdge) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshEdgeCountLarge) {
+  // a triangulated grid large enough that edges are indexed in parallel
+  size_t N = 100;
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  for (size_t i = 0; i <= N; i++) {
+    for (size_t j = 0; j <= N; j++) {
+      points.push_back(glm::vec3{i, j, 0.});
+    }
+  }
+  for (size_t i = 0; i < N; i++) {
+    for (size_t j = 0; j < N; j++) {
+      size_t v0 = i * (N + 1) + j;
+      faces.push_back({v0, v0 + N + 1, v0 + N + 2});
+      faces.push_back({v0, v0 + N + 2, v0 + 1});
+    }
+  }
+
+  int oldNumThreads = polyscope::options::numThreads;
+  polyscope::options::numThreads = 4;
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("grid", points, faces);
+  size_t nEdges = psMesh->nEdges();
+  EXPECT_EQ(nEdges, 3 * N * N + 2 * N);
+
+  std::vector<size_t> ePerm(nEdges);
+  for (size_t i = 0; i < nEdges; i++) ePerm[i] = nEdges - 1 - i;
+  psMesh->setEdgePermutation(ePerm);
+  std::vector<double> eScalar(nEdges, 9.);
+  auto q = psMesh->addEdgeScalarQuantity("eScalar", eScalar);
+  q->setEnabled(true);
+  polyscope::show(3);
+  polyscope::options::numThreads = oldNumThreads;
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshScalarHalfedge) {
   auto psMesh = registerTriangleMesh();
   std::vector<double> heScalar(psMesh->nHalfedges(), 10.);
@@ -347,6 +756,247 @@ TEST_F(PolyscopeTest, SurfaceMeshScalarTransparency) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshPeelPassCount) {
+  auto psMesh = registerTriangleMesh();
+  psMesh->setTransparency(0.5);
+
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Pretty;
+  polyscope::options::transparencyRenderPasses = 5;
+  polyscope::show(3);
+
+  // the mock backend has no occlusion queries, so peeling never stops early
+  EXPECT_EQ(polyscope::render::engine->stats.transparencyRenderPassesUsed, 5);
+
+  polyscope::options::transparencyRenderPasses = 8;
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshWeightedTransparency) {
+  auto psMeshOpaque = registerTriangleMesh("opaque");
+  auto psMeshTransparent = registerTriangleMesh("transparent");
+  psMeshTransparent->setTransparency(0.5);
+
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::WeightedBlended;
+  polyscope::show(3);
+
+  // quantities on the transparent mesh are accumulated too
+  std::vector<double> vScalar(psMeshTransparent->nVertices(), 7.);
+  psMeshTransparent->addVertexScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshChunks) {
+  // two clusters of 4 triangles each, one in front of the camera and one far behind it
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  for (float z : {0.f, 100.f}) {
+    for (int i = 0; i < 4; i++) {
+      size_t iV = points.size();
+      points.push_back(glm::vec3{i, 0., z});
+      points.push_back(glm::vec3{i + 1, 0., z});
+      points.push_back(glm::vec3{i, 1., z});
+      faces.push_back({iV, iV + 1, iV + 2});
+    }
+  }
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("chunked", points, faces, 4);
+  EXPECT_EQ(psMesh->getChunkSize(), 4u);
+  EXPECT_EQ(psMesh->nChunks(), 2u);
+
+  polyscope::view::lookAt(glm::vec3{0., 0., 5.}, glm::vec3{0., 0., 0.});
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->nVisibleChunks(), 1u);
+
+  // quantities and picking draw through the chunks too
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  psMesh->addVertexScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::pickAtScreenCoords(glm::vec2{0.5, 0.5});
+
+  // moving the vertices moves the chunk bounds, bring the second cluster in to view
+  for (glm::vec3& p : points) {
+    p.z *= 0.01;
+  }
+  psMesh->updateVertexPositions(points);
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->nVisibleChunks(), 2u);
+
+  psMesh->setChunkSize(0);
+  EXPECT_EQ(psMesh->nChunks(), 0u);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshSlicePlaneCulling) {
+  // two clusters of 4 triangles each, both in view, on either side of a slice plane
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  for (float z : {0.f, 1.f}) {
+    for (int i = 0; i < 4; i++) {
+      size_t iV = points.size();
+      points.push_back(glm::vec3{i, 0., z});
+      points.push_back(glm::vec3{i + 1, 0., z});
+      points.push_back(glm::vec3{i, 1., z});
+      faces.push_back({iV, iV + 1, iV + 2});
+    }
+  }
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("sliced", points, faces, 4);
+  polyscope::view::lookAt(glm::vec3{2., 0.5, 10.}, glm::vec3{2., 0.5, 0.});
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->nVisibleChunks(), 2u);
+
+  // chunks entirely on the sliced away side are skipped
+  polyscope::SlicePlane* plane = polyscope::addSceneSlicePlane();
+  plane->setActive(true);
+  plane->setPose(glm::vec3{0., 0., 0.5}, glm::vec3{0., 0., 1.});
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->nVisibleChunks(), 1u);
+  EXPECT_TRUE(psMesh->isInViewFrustum());
+
+  // unless the structure ignores the plane
+  psMesh->setIgnoreSlicePlane(plane->name, true);
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->nVisibleChunks(), 2u);
+  psMesh->setIgnoreSlicePlane(plane->name, false);
+
+  // a structure which is sliced away entirely is not drawn at all
+  plane->setPose(glm::vec3{0., 0., 2.}, glm::vec3{0., 0., 1.});
+  polyscope::show(3);
+  EXPECT_FALSE(psMesh->isInViewFrustum());
+
+  polyscope::removeLastSceneSlicePlane();
+  EXPECT_TRUE(psMesh->isInViewFrustum());
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshVertexCacheOrder) {
+  // a grid, with the triangles in a scrambled order
+  size_t n = 30;
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      points.push_back(glm::vec3{i, j, 0.});
+    }
+  }
+  for (size_t i = 0; i + 1 < n; i++) {
+    for (size_t j = 0; j + 1 < n; j++) {
+      size_t v = i * n + j;
+      faces.push_back({v, v + n, v + 1});
+      faces.push_back({v + 1, v + n, v + n + 1});
+    }
+  }
+  for (size_t i = 0; i < faces.size(); i++) {
+    std::swap(faces[i], faces[(i * 7919) % faces.size()]);
+  }
+  std::vector<uint32_t> triVerts;
+  for (const std::array<size_t, 3>& f : faces) {
+    for (size_t v : f) triVerts.push_back(static_cast<uint32_t>(v));
+  }
+
+  std::vector<uint32_t> order = polyscope::vertexCacheTriangleOrder(triVerts, points.size());
+  ASSERT_EQ(order.size(), faces.size());
+  std::vector<uint32_t> sortedOrder = order;
+  std::sort(sortedOrder.begin(), sortedOrder.end());
+  for (size_t i = 0; i < sortedOrder.size(); i++) {
+    EXPECT_EQ(sortedOrder[i], i);
+  }
+  std::vector<uint32_t> orderedVerts;
+  for (uint32_t iT : order) {
+    for (uint32_t k = 0; k < 3; k++) orderedVerts.push_back(triVerts[3 * iT + k]);
+  }
+  EXPECT_LT(polyscope::averageCacheMissRatio(orderedVerts), 0.5 * polyscope::averageCacheMissRatio(triVerts));
+
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("grid", points, faces);
+  psMesh->setShadeStyle(polyscope::MeshShadeStyle::Smooth);
+  psMesh->setVertexCacheOrder(true);
+  EXPECT_TRUE(psMesh->getVertexCacheOrder());
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  psMesh->addVertexScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::pickAtScreenCoords(glm::vec2{0.5, 0.5});
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshLOD) {
+  // a fine grid on the unit square
+  size_t n = 100;
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      points.push_back(glm::vec3{i / (n - 1.), j / (n - 1.), 0.});
+    }
+  }
+  for (size_t i = 0; i + 1 < n; i++) {
+    for (size_t j = 0; j + 1 < n; j++) {
+      size_t v = i * n + j;
+      faces.push_back({v, v + n, v + 1});
+      faces.push_back({v + 1, v + n, v + n + 1});
+    }
+  }
+  std::vector<uint32_t> triVerts;
+  for (const std::array<size_t, 3>& f : faces) {
+    for (size_t v : f) triVerts.push_back(static_cast<uint32_t>(v));
+  }
+
+  // the simplified triangles index the same vertices
+  std::vector<uint32_t> simplified = polyscope::clusterSimplifyTriangles(points, triVerts, 0.05);
+  EXPECT_GT(simplified.size(), 0u);
+  EXPECT_LT(simplified.size(), triVerts.size() / 4);
+  EXPECT_EQ(simplified.size() % 3, 0u);
+  for (uint32_t v : simplified) {
+    EXPECT_LT(v, points.size());
+  }
+
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("grid", points, faces);
+  psMesh->setShadeStyle(polyscope::MeshShadeStyle::Smooth);
+  psMesh->setLODEnabled(true);
+  EXPECT_TRUE(psMesh->getLODEnabled());
+  psMesh->waitForLODBuild();
+  EXPECT_GT(psMesh->nLODLevels(), 0u);
+
+  // from far away a simplified level is drawn, for vertex quantities too
+  polyscope::view::lookAt(glm::vec3{0.5, 0.5, 1000.}, glm::vec3{0.5, 0.5, 0.});
+  polyscope::show(3);
+  EXPECT_GT(psMesh->getLODLevelDrawn(), 0u);
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  psMesh->addVertexScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::pickAtScreenCoords(glm::vec2{0.5, 0.5});
+
+  // up close the full mesh is drawn
+  polyscope::view::lookAt(glm::vec3{0.5, 0.5, 0.01}, glm::vec3{0.5, 0.5, 0.});
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->getLODLevelDrawn(), 0u);
+
+  // moving the vertices rebuilds the chain
+  for (glm::vec3& p : points) {
+    p *= 2.;
+  }
+  psMesh->updateVertexPositions(points);
+  psMesh->waitForLODBuild();
+  EXPECT_GT(psMesh->nLODLevels(), 0u);
+  polyscope::show(3);
+
+  psMesh->setLODEnabled(false);
+  EXPECT_EQ(psMesh->nLODLevels(), 0u);
+  polyscope::show(3);
+
+  // removing the mesh while a build is running is fine
+  psMesh->setLODEnabled(true);
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshDistance) {
   auto psMesh = registerTriangleMesh();
   std::vector<double> vScalar(psMesh->nVertices(), 7.);
@@ -397,6 +1047,28 @@ TEST_F(PolyscopeTest, SurfaceMeshCornerParam) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshParamIslandLabels) {
+  auto psMesh = registerTriangleMesh();
+
+  // the last face gets its own coordinates, splitting it off as a second island
+  std::vector<glm::vec2> vals(psMesh->nCorners(), {1., 2.});
+  for (size_t iC = psMesh->faceIndsStart[3]; iC < psMesh->faceIndsStart[4]; iC++) vals[iC] = {5., 5.};
+  auto q1 = psMesh->addParameterizationQuantity("param", vals);
+  q1->computeIslandLabels();
+  EXPECT_EQ(q1->islandLabels.data, std::vector<float>({0., 0., 0., 1.}));
+  q1->setStyle(polyscope::ParamVizStyle::CHECKER_ISLANDS);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // vertex coordinates have no seams, only the connected components are islands
+  std::vector<glm::vec2> vertVals(psMesh->nVertices(), {1., 2.});
+  auto q2 = psMesh->addVertexParameterizationQuantity("vparam", vertVals);
+  q2->computeIslandLabels();
+  EXPECT_EQ(q2->islandLabels.data, std::vector<float>(4, 0.));
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshVertexParam) {
   auto psMesh = registerTriangleMesh();
   std::vector<glm::vec2> vals(psMesh->nVertices(), {1., 2.});
@@ -446,6 +1118,92 @@ TEST_F(PolyscopeTest, SurfaceMeshFaceVector) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshVectorInstanced) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<glm::vec3> vals(psMesh->nVertices(), {1., 2., 3.});
+  auto q1 = psMesh->addVertexVectorQuantity("vecs", vals);
+  q1->setEnabled(true);
+  std::vector<glm::vec3> basisX(psMesh->nVertices(), {1., 2., 3.});
+  std::vector<glm::vec3> basisY(psMesh->nVertices(), {1., 2., 3.});
+  std::vector<glm::vec2> tangentVals(psMesh->nVertices(), {1., 2.});
+  auto q2 = psMesh->addVertexTangentVectorQuantity("sym vecs", tangentVals, basisX, basisY, 4);
+  q2->setEnabled(true);
+  polyscope::show(3);
+
+  // switching paths rebuilds the programs
+  polyscope::options::instancedVectors = true;
+  polyscope::show(3);
+
+  // decimation
+  q1->setVectorMinPixelSpacing(10.);
+  q2->setVectorMinPixelSpacing(10.);
+  EXPECT_EQ(q1->getVectorMinPixelSpacing(), 10.);
+  polyscope::show(3);
+
+  polyscope::options::instancedVectors = false;
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshVectorRibbons) {
+  // a flat 4x4 grid of squares, split in to triangles
+  size_t n = 4;
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  for (size_t j = 0; j <= n; j++) {
+    for (size_t i = 0; i <= n; i++) points.emplace_back(i, j, 0.);
+  }
+  for (size_t j = 0; j < n; j++) {
+    for (size_t i = 0; i < n; i++) {
+      size_t v = j * (n + 1) + i;
+      faces.push_back({v, v + 1, v + n + 2});
+      faces.push_back({v, v + n + 2, v + n + 1});
+    }
+  }
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("grid", points, faces);
+
+  // a constant field traces one straight line across the grid, from the center of the first triangle
+  std::vector<glm::vec3> dirs(psMesh->nFaces(), glm::vec3{1., 0., 0.});
+  polyscope::SurfaceVectorQuantity::Streamlines lines =
+      polyscope::SurfaceVectorQuantity::traceStreamlines(*psMesh, dirs, 1, 1, 100.);
+  ASSERT_GE(lines.points.size(), 4u);
+  EXPECT_EQ(lines.points.size(), lines.normals.size());
+  EXPECT_EQ(lines.segmentStarts.size(), lines.points.size() - 3);
+  EXPECT_EQ(lines.points.front(), lines.points[1]); // the ends are repeated
+  EXPECT_EQ(lines.points.back(), lines.points[lines.points.size() - 2]);
+  EXPECT_NEAR(lines.points.front().x, 0., 1e-5);
+  EXPECT_NEAR(lines.points.back().x, 4., 1e-5);
+  for (const glm::vec3& p : lines.points) EXPECT_NEAR(p.y, 1. / 3., 1e-5);
+
+  // no seeds, or a field with nothing to follow
+  EXPECT_TRUE(polyscope::SurfaceVectorQuantity::traceStreamlines(*psMesh, dirs, 1, 0, 100.).points.empty());
+  std::vector<glm::vec3> zeros(psMesh->nFaces(), glm::vec3{0., 0., 0.});
+  EXPECT_TRUE(polyscope::SurfaceVectorQuantity::traceStreamlines(*psMesh, zeros, 1, 10, 100.).points.empty());
+
+  // drawn for each kind of vector quantity
+  auto q1 = psMesh->addFaceVectorQuantity("vecs", dirs);
+  q1->setEnabled(true);
+  q1->setRibbonEnabled(true);
+  EXPECT_TRUE(q1->isRibbonEnabled());
+  q1->setRibbonCount(5);
+  EXPECT_EQ(q1->getRibbonCount(), 5u);
+  polyscope::show(3);
+  std::vector<glm::vec3> diagonal(psMesh->nFaces(), glm::vec3{1., 1., 0.});
+  q1->updateData(diagonal); // traced again
+  polyscope::show(3);
+
+  std::vector<glm::vec3> basisX(psMesh->nVertices(), {1., 0., 0.});
+  std::vector<glm::vec3> basisY(psMesh->nVertices(), {0., 1., 0.});
+  std::vector<glm::vec2> tangentVals(psMesh->nVertices(), {1., 2.});
+  auto q2 = psMesh->addVertexTangentVectorQuantity("sym vecs", tangentVals, basisX, basisY, 4);
+  q2->setEnabled(true);
+  q2->setRibbonEnabled(true);
+  q2->setRibbonWidth(0.01);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshVertexTangent) {
   auto psMesh = registerTriangleMesh();
   std::vector<glm::vec3> basisX(psMesh->nVertices(), {1., 2., 3.});
@@ -578,3 +1336,239 @@ TEST_F(PolyscopeTest, SimpleTriangleMesUpdate) {
 
   polyscope::removeAllStructures();
 }
+
+TEST_F(PolyscopeTest, SimpleTriangleMeshQuantities) {
+  auto psMesh = registerSimpleTriangleMesh();
+  size_t nV = psMesh->vertices.size();
+
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", std::vector<double>(nV, 0.5));
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  auto q2 = psMesh->addVertexColorQuantity("vColor", std::vector<glm::vec3>(nV, glm::vec3(0.2, 0.4, 0.6)));
+  q2->setEnabled(true);
+  polyscope::show(3);
+
+  // changing options rebuilds the quantity programs
+  psMesh->setBackFacePolicy(polyscope::BackFacePolicy::Custom);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SimpleTriangleMeshCompactPositions) {
+  auto psMesh = registerSimpleTriangleMesh();
+  size_t nV = psMesh->vertices.size();
+
+  psMesh->setCompactVertexPositions(true);
+  EXPECT_TRUE(psMesh->getCompactVertexPositions());
+  polyscope::show(3);
+
+  // positions are normalized to the bounding box
+  for (size_t i = 0; i < nV; i++) {
+    glm::vec3 p = psMesh->compactVertices.getValue(i);
+    for (int j = 0; j < 3; j++) {
+      EXPECT_LE(std::abs(p[j]), 1.f);
+    }
+  }
+
+  // quantities and picking draw with the compact positions too
+  psMesh->addVertexScalarQuantity("vScalar", std::vector<double>(nV, 0.5))->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // updating the positions recomputes them
+  std::vector<glm::vec3> newPos(nV, glm::vec3(10., 0., 0.));
+  newPos[0] = glm::vec3(12., 0., 0.);
+  psMesh->updateVertices(newPos);
+  EXPECT_EQ(psMesh->compactVertices.getValue(0), glm::vec3(1., 0., 0.));
+  polyscope::show(3);
+
+  psMesh->setCompactVertexPositions(false);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, InstancedMesh) {
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  std::tie(points, faces) = getTriangleMesh();
+  std::vector<glm::mat4> transforms;
+  for (int i = 0; i < 10; i++) {
+    transforms.push_back(glm::translate(glm::mat4(1.f), glm::vec3(3.f * i, 0.f, 0.f)));
+  }
+  polyscope::InstancedMesh* psMesh = polyscope::registerInstancedMesh("instances", points, faces, transforms);
+  EXPECT_TRUE(polyscope::hasInstancedMesh("instances"));
+  EXPECT_EQ(psMesh->nInstances(), 10u);
+  polyscope::show(3);
+
+  // pick indices cover each face of each instance
+  size_t nFaces = psMesh->nFaces();
+  EXPECT_EQ(psMesh->pickIndexToInstanceFace(3 * nFaces + 1), std::make_pair(size_t(3), size_t(1)));
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // per-instance colors and scalars
+  psMesh->setInstanceColors(std::vector<glm::vec3>(10, glm::vec3(0.2, 0.3, 0.4)));
+  polyscope::show(3);
+  std::vector<float> values(10);
+  for (int i = 0; i < 10; i++) values[i] = i;
+  psMesh->setInstanceScalars(values);
+  psMesh->setColorMap("blues");
+  EXPECT_EQ(psMesh->getColorMap(), "blues");
+  polyscope::show(3);
+  EXPECT_THROW(psMesh->setInstanceScalars(std::vector<float>(3)), std::runtime_error);
+
+  // changing the number of instances goes back to a single color
+  transforms.resize(4);
+  psMesh->updateInstanceTransforms(transforms);
+  EXPECT_EQ(psMesh->nInstances(), 4u);
+  psMesh->setBackFacePolicy(polyscope::BackFacePolicy::Cull);
+  polyscope::show(3);
+
+  // instance an existing mesh
+  auto psSimple = registerSimpleTriangleMesh();
+  polyscope::InstancedMesh* psCopies = polyscope::registerInstancedMesh("copies", *psSimple, transforms);
+  EXPECT_EQ(psCopies->nFaces(), psSimple->faces.size());
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+  EXPECT_FALSE(polyscope::hasInstancedMesh("instances"));
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshKeyframes) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<std::vector<glm::vec3>> frames;
+  for (int i = 0; i < 4; i++) {
+    std::vector<glm::vec3> frame = std::get<0>(getTriangleMesh());
+    for (glm::vec3& p : frame) p *= 1. + i;
+    frames.push_back(frame);
+  }
+  psMesh->setVertexPositionKeyframes(frames);
+  EXPECT_EQ(psMesh->nKeyframes(), 4);
+  polyscope::show(3);
+
+  psMesh->setKeyframeTime(2.25);
+  polyscope::show(3);
+  psMesh->setKeyframesPlaying(true);
+  polyscope::show(3);
+  psMesh->setKeyframesPlaying(false);
+
+  std::vector<std::vector<double>> valFrames(4, std::vector<double>(psMesh->nVertices(), 1.));
+  auto q1 = psMesh->addVertexScalarKeyframes("vals", valFrames);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // the per-corner path, with a wireframe
+  psMesh->setEdgeWidth(1.);
+  polyscope::show(3);
+
+  // wrong number of positions
+  frames[1].pop_back();
+  EXPECT_THROW(psMesh->setVertexPositionKeyframes(frames), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshBackfacingChunkCulling) {
+  // two flat patches of 4 triangles each, one facing +z and one facing -z
+  std::vector<glm::vec3> points;
+  std::vector<std::vector<size_t>> faces;
+  for (int side = 0; side < 2; side++) {
+    for (int i = 0; i < 4; i++) {
+      size_t iV = points.size();
+      points.push_back(glm::vec3{i, 0., 0.});
+      points.push_back(glm::vec3{i + 1, 0., 0.});
+      points.push_back(glm::vec3{i, 1., 0.});
+      if (side == 0) {
+        faces.push_back({iV, iV + 1, iV + 2});
+      } else {
+        faces.push_back({iV, iV + 2, iV + 1});
+      }
+    }
+  }
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("two sided", points, faces, 4);
+  polyscope::view::lookAt(glm::vec3{2., 0.5, 10.}, glm::vec3{2., 0.5, 0.});
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->nVisibleChunks(), 2u);
+
+  // with backface culling, the chunk facing away from the camera is skipped
+  psMesh->setBackFacePolicy(polyscope::BackFacePolicy::Cull);
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->nVisibleChunks(), 1u);
+
+  // from the other side, the other one
+  polyscope::view::lookAt(glm::vec3{2., 0.5, -10.}, glm::vec3{2., 0.5, 0.});
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->nVisibleChunks(), 1u);
+
+  // a mirroring transform flips which side is front facing, but still culls one chunk
+  psMesh->setTransform(glm::scale(glm::mat4(1.), glm::vec3{1., 1., -1.}));
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->nVisibleChunks(), 1u);
+
+  // orthographic views cull too
+  polyscope::view::projectionMode = polyscope::ProjectionMode::Orthographic;
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->nVisibleChunks(), 1u);
+  polyscope::view::projectionMode = polyscope::ProjectionMode::Perspective;
+
+  psMesh->setBackFacePolicy(polyscope::BackFacePolicy::Different);
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->nVisibleChunks(), 2u);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshEdgeMaskTexture) {
+  // a quad and a triangle, the quad's diagonal is not a real edge
+  std::vector<glm::vec3> points = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {2, 0, 0}};
+  std::vector<std::vector<size_t>> faces = {{0, 1, 2, 3}, {1, 4, 2}};
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("polygons", points, faces);
+
+  std::vector<glm::vec3>& edgeIsReal = psMesh->edgeIsReal.getPopulatedHostBufferRef();
+  ASSERT_EQ(edgeIsReal.size(), 9u);
+  EXPECT_EQ(edgeIsReal[0], glm::vec3(1., 1., 0.));
+  EXPECT_EQ(edgeIsReal[3], glm::vec3(0., 1., 1.));
+  EXPECT_EQ(edgeIsReal[6], glm::vec3(1., 1., 1.));
+
+  // 8 triangles to a texel
+  std::vector<glm::vec3> manyTriangles(3 * 17, glm::vec3(1., 0., 1.));
+  std::shared_ptr<polyscope::render::TextureBuffer> tex =
+      polyscope::SurfaceMesh::generateEdgeMaskTexture(manyTriangles);
+  EXPECT_EQ(tex->getSizeX() * tex->getSizeY(), 3u);
+  tex = polyscope::SurfaceMesh::generateEdgeMaskTexture(std::vector<glm::vec3>());
+  EXPECT_EQ(tex->getSizeX() * tex->getSizeY(), 1u);
+
+  // the wireframe, drawn whole and by chunks
+  psMesh->setEdgeWidth(1.);
+  polyscope::show(3);
+  psMesh->setChunkSize(1);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshFaceSelection) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<float> vScalar(psMesh->nVertices(), 7.);
+  psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  psMesh->setShadeStyle(polyscope::MeshShadeStyle::Smooth);
+  EXPECT_TRUE(psMesh->canDrawIndexed());
+
+  polyscope::ElementSelection& selection = psMesh->getFaceSelection();
+  EXPECT_EQ(selection.size(), psMesh->nFaces());
+  EXPECT_FALSE(psMesh->canDrawIndexed());
+  selection.set(0, 1);
+  polyscope::show(3);
+  psMesh->getQuantity("vScalar")->setEnabled(true);
+  selection.setColor(glm::vec3{0., 1., 0.});
+  selection.toggle(0, psMesh->nFaces());
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psMesh->removeFaceSelection();
+  EXPECT_TRUE(psMesh->canDrawIndexed());
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
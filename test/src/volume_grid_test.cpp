@@ -3,6 +3,11 @@
 #include "polyscope/slice_plane.h"
 #include "polyscope_test.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
 
 // ============================================================
 // =============== Volume grid tests
@@ -81,6 +86,33 @@ TEST_F(PolyscopeTest, VolumeGridSlicePlane) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, VolumeGridSlicePlaneBrickCulling) {
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {40, 40, 40}, glm::vec3{-3., -3., -3.}, glm::vec3{3., 3., 3.});
+  polyscope::show(3);
+  size_t nFullVerts = psGrid->gridPlaneReferencePositions.size();
+  EXPECT_GT(nFullVerts, 0u);
+
+  // planes through bricks which are entirely sliced away are clipped or dropped
+  polyscope::SlicePlane* p = polyscope::addSceneSlicePlane();
+  p->setPose(glm::vec3{1.5, 0., 0.}, glm::vec3{1., 0., 0.});
+  polyscope::show(3);
+  size_t nCulledVerts = psGrid->gridPlaneReferencePositions.size();
+  EXPECT_LT(nCulledVerts, nFullVerts);
+
+  // also with a quantity drawing the gridcubes
+  psGrid->addNodeScalarQuantityFromCallable("x", [](glm::vec3 x) { return x.x; })->setEnabled(true);
+  polyscope::show(3);
+
+  // everything comes back when the plane moves away
+  p->setPose(glm::vec3{-10., 0., 0.}, glm::vec3{1., 0., 0.});
+  polyscope::show(3);
+  EXPECT_EQ(psGrid->gridPlaneReferencePositions.size(), nFullVerts);
+
+  polyscope::removeLastSceneSlicePlane();
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, VolumeGridScalar) {
   
   // these are node dim
@@ -130,6 +162,31 @@ TEST_F(PolyscopeTest, VolumeGridScalar) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, VolumeGridScalarTiledBatchCallable) {
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {20, 24, 28}, glm::vec3{-3., -3., -3.}, glm::vec3{3., 3., 3.});
+  auto batchFunc = [](const float* pos_ptr, float* result_ptr, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      result_ptr[i] = pos_ptr[3 * i + 0] + 2.f * pos_ptr[3 * i + 1] + 3.f * pos_ptr[3 * i + 2];
+    }
+  };
+
+  polyscope::VolumeGridNodeScalarQuantity* qSerial =
+      psGrid->addNodeScalarQuantityFromBatchCallable("serial", batchFunc);
+
+  polyscope::ImplicitRenderOpts opts;
+  opts.batchTileSize = 100;
+  opts.batchThreads = 3;
+  polyscope::VolumeGridNodeScalarQuantity* qTiled =
+      psGrid->addNodeScalarQuantityFromBatchCallable("tiled", batchFunc, opts);
+  EXPECT_EQ(qSerial->values.data, qTiled->values.data);
+
+  psGrid->addCellScalarQuantityFromBatchCallable("tiled cells", batchFunc, opts)->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, VolumeGridScalarIsosurfaceAndOpts) {
   
   // these are node dim
@@ -171,6 +228,15 @@ TEST_F(PolyscopeTest, VolumeGridScalarIsosurfaceAndOpts) {
 
   q->registerIsosurfaceAsMesh();
 
+  q->setIsosurfaceRaymarched(true);
+  EXPECT_TRUE(q->getIsosurfaceRaymarched());
+  polyscope::show(3);
+  q->setIsosurfaceLevel(0.1);
+  polyscope::show(3);
+  q->setSlicePlanesAffectIsosurface(false);
+  polyscope::show(3);
+  q->setIsosurfaceRaymarched(false);
+
   // this setting should mean we get no isosurface, make sure nothing crashes
   q->setIsosurfaceLevel(10000.);
   polyscope::show(3);
@@ -180,3 +246,408 @@ TEST_F(PolyscopeTest, VolumeGridScalarIsosurfaceAndOpts) {
   polyscope::removeLastSceneSlicePlane();
   polyscope::removeAllStructures();
 }
+
+TEST_F(PolyscopeTest, VolumeGridIsosurfaceMesh) {
+  // large enough to be extracted in several slabs
+  uint32_t dim = 64;
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {dim, dim, dim}, glm::vec3{-3., -3., -3.}, glm::vec3{3., 3., 3.});
+  auto sphereSDF = [](glm::vec3 p) { return glm::length(p - glm::vec3{0.2, 0.1, 0.}) - 1.5f; };
+  polyscope::VolumeGridNodeScalarQuantity* q = psGrid->addNodeScalarQuantityFromCallable("sdf", sphereSDF);
+  q->setEnabled(true);
+  q->setIsosurfaceVizEnabled(true);
+
+  int oldNumThreads = polyscope::options::numThreads;
+  polyscope::options::numThreads = 4;
+  polyscope::show(3);
+
+  // a closed genus-0 surface, so vertices must be shared across slab seams: V - E + F = 2, with E = 3F/2
+  polyscope::SurfaceMesh* m = q->registerIsosurfaceAsMesh("iso");
+  EXPECT_GT(m->nFaces(), 0u);
+  EXPECT_EQ(m->nVertices(), 2 + m->nFaces() / 2);
+
+  // the first mesh took the cached buffers, the displayed surface is unaffected and a second one is the same
+  polyscope::show(3);
+  polyscope::SurfaceMesh* mAgain = q->registerIsosurfaceAsMesh("iso again");
+  EXPECT_EQ(mAgain->nFaces(), m->nFaces());
+  EXPECT_EQ(mAgain->nVertices(), m->nVertices());
+
+  // updating the values invalidates the cached extraction
+  q->updateData(std::vector<float>(psGrid->nNodes(), 1.));
+  polyscope::show(3);
+  m = q->registerIsosurfaceAsMesh("iso after update");
+  EXPECT_EQ(m->nFaces(), 0u);
+
+  polyscope::options::numThreads = oldNumThreads;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGridRegionUpdate) {
+  // not cubic, and large enough to be extracted in several slabs
+  glm::uvec3 dim{40, 48, 64};
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", dim, glm::vec3{-3., -3., -3.}, glm::vec3{3., 3., 3.});
+  auto sphereSDF = [](glm::vec3 p) { return glm::length(p) - 1.5f; };
+  polyscope::VolumeGridNodeScalarQuantity* q = psGrid->addNodeScalarQuantityFromCallable("sdf", sphereSDF);
+  q->setEnabled(true);
+  q->setIsosurfaceVizEnabled(true);
+  polyscope::show(3);
+
+  // carve a second sphere into a box of nodes near one end
+  glm::uvec3 offset{4, 6, 48};
+  glm::uvec3 extent{20, 20, 14};
+  std::vector<float> boxValues;
+  std::vector<float> allValues(psGrid->nNodes());
+  for (uint32_t z = 0; z < dim.z; z++) {
+    for (uint32_t y = 0; y < dim.y; y++) {
+      for (uint32_t x = 0; x < dim.x; x++) {
+        glm::vec3 p = psGrid->positionOfNodeIndex(glm::uvec3{x, y, z});
+        glm::uvec3 ind{x, y, z};
+        bool inBox = glm::all(glm::greaterThanEqual(ind, offset)) && glm::all(glm::lessThan(ind, offset + extent));
+        float v = inBox ? std::min(sphereSDF(p), glm::length(p - glm::vec3{-1.5, -1.2, 2.}) - 0.5f) : sphereSDF(p);
+        if (inBox) boxValues.push_back(v);
+        allValues[psGrid->flattenNodeIndex(ind)] = v;
+      }
+    }
+  }
+  q->updateNodeScalarRegion(offset, extent, boxValues);
+  polyscope::show(3);
+  polyscope::SurfaceMesh* mRegion = q->registerIsosurfaceAsMesh("iso region");
+
+  // the same as extracting the updated values from scratch
+  polyscope::VolumeGridNodeScalarQuantity* qFull = psGrid->addNodeScalarQuantity("full", allValues);
+  polyscope::SurfaceMesh* mFull = qFull->registerIsosurfaceAsMesh("iso full");
+  EXPECT_GT(mRegion->nFaces(), 0u);
+  EXPECT_EQ(mRegion->nFaces(), mFull->nFaces());
+  EXPECT_EQ(mRegion->nVertices(), mFull->nVertices());
+
+  // only the slabs touching the changed node planes are extracted again
+  polyscope::MarchingCubesSlabCache cache;
+  std::vector<glm::vec3> vertices;
+  std::vector<uint32_t> indices;
+  cache.extract(allValues.data(), 0.f, dim.z, dim.y, dim.x, vertices, indices);
+  size_t nSlabs = cache.getLastExtractedSlabCount();
+  EXPECT_GT(nSlabs, 1u);
+  cache.invalidateNodePlanes(offset.z, offset.z + extent.z);
+  cache.extract(allValues.data(), 0.f, dim.z, dim.y, dim.x, vertices, indices);
+  EXPECT_LT(cache.getLastExtractedSlabCount(), nSlabs);
+  EXPECT_EQ(indices.size(), 3 * mFull->nFaces());
+
+  // regions must lie in the grid and match the size of the data
+  EXPECT_THROW(q->updateNodeScalarRegion(glm::uvec3{30, 0, 0}, glm::uvec3{20, 1, 1}, std::vector<float>(20)),
+               std::runtime_error);
+  EXPECT_THROW(q->updateNodeScalarRegion(offset, extent, std::vector<float>(10)), std::runtime_error);
+
+  // cell values, with the bricks in the pool patched
+  psGrid->setBrickedStorage(true);
+  polyscope::VolumeGridCellScalarQuantity* qCell = psGrid->addCellScalarQuantityFromCallable("cell sdf", sphereSDF);
+  qCell->setEnabled(true);
+  polyscope::show(3);
+  qCell->updateCellScalarRegion(glm::uvec3{7, 7, 7}, glm::uvec3{3, 3, 3}, std::vector<float>(27, -2.));
+  q->updateNodeScalarRegion(glm::uvec3{8, 8, 8}, glm::uvec3{1, 1, 1}, std::vector<float>{-3.});
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGridScalarVolumeRender) {
+  // spans several bricks for empty space skipping
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {20, 24, 28}, glm::vec3{-3., -3., -3.}, glm::vec3{3., 3., 3.});
+  auto sphereSDF = [](glm::vec3 p) { return glm::length(p) - 1.5f; };
+
+  polyscope::VolumeGridNodeScalarQuantity* qNode = psGrid->addNodeScalarQuantityFromCallable("node sdf", sphereSDF);
+  qNode->setEnabled(true);
+  qNode->setGridcubeVizEnabled(false);
+  qNode->setVolumeVizEnabled(true);
+  polyscope::show(3);
+
+  qNode->setVolumeDensity(50.);
+  EXPECT_EQ(qNode->getVolumeDensity(), 50.);
+  qNode->setMapRange({-1., 0.});
+  polyscope::show(3);
+
+  // alongside other modes
+  qNode->setGridcubeVizEnabled(true);
+  qNode->setIsosurfaceVizEnabled(true);
+  polyscope::show(3);
+
+  // updating the values rebuilds the brick ranges
+  qNode->updateData(std::vector<float>(psGrid->nNodes(), 1.));
+  polyscope::show(3);
+
+  polyscope::VolumeGridCellScalarQuantity* qCell = psGrid->addCellScalarQuantityFromCallable("cell sdf", sphereSDF);
+  qCell->setEnabled(true);
+  qCell->setVolumeVizEnabled(true);
+  EXPECT_TRUE(qCell->getVolumeVizEnabled());
+  polyscope::show(3);
+
+  // respects slice planes
+  polyscope::addSceneSlicePlane();
+  polyscope::show(3);
+  polyscope::removeLastSceneSlicePlane();
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGridSparse) {
+  // a thin diagonal band of blocks, the last one cropped by the grid boundary
+  std::vector<glm::uvec3> blocks{{0, 0, 0}, {1, 1, 1}, {2, 2, 2}, {1, 2, 2}};
+  polyscope::VolumeGrid* psGrid = polyscope::registerSparseVolumeGrid(
+      "test grid", {21, 21, 21}, glm::vec3{-3., -3., -3.}, glm::vec3{3., 3., 3.}, blocks);
+  EXPECT_TRUE(psGrid->isSparse());
+  EXPECT_EQ(psGrid->nOccupiedBlocks(), 4u);
+  EXPECT_EQ(psGrid->nSparseNodes(), 4u * 9 * 9 * 9);
+  EXPECT_EQ(psGrid->nSparseCells(), 4u * 8 * 8 * 8);
+  polyscope::show(3);
+
+  // indexing in to the packed values
+  EXPECT_EQ(psGrid->sparseCellDataIndex({0, 0, 0}), 0);
+  EXPECT_EQ(psGrid->sparseCellDataIndex({9, 8, 8}), 8 * 8 * 8 + 1);
+  EXPECT_EQ(psGrid->sparseCellDataIndex({12, 0, 0}), -1);
+  EXPECT_GE(psGrid->sparseNodeDataIndex({8, 8, 8}), 0); // shared between blocks
+  EXPECT_EQ(psGrid->sparseNodeDataIndex({20, 0, 0}), -1);
+
+  auto sphereSDF = [](glm::vec3 p) { return glm::length(p) - 1.5f; };
+  polyscope::VolumeGridNodeScalarQuantity* qNode = psGrid->addNodeScalarQuantityFromCallable("node sdf", sphereSDF);
+  qNode->setEnabled(true);
+  polyscope::show(3);
+
+  qNode->setIsosurfaceVizEnabled(true);
+  qNode->setIsosurfaceLevel(0.);
+  polyscope::show(3);
+  polyscope::SurfaceMesh* isoMesh = qNode->registerIsosurfaceAsMesh("iso");
+  EXPECT_GT(isoMesh->nVertices(), 0u);
+
+  qNode->updateData(std::vector<float>(psGrid->nSparseNodes(), 1.));
+  polyscope::show(3);
+
+  polyscope::VolumeGridCellScalarQuantity* qCell = psGrid->addCellScalarQuantityFromCallable("cell sdf", sphereSDF);
+  qCell->setEnabled(true);
+  polyscope::show(3);
+
+  // values must match the occupied blocks
+  EXPECT_THROW(psGrid->addCellScalarQuantity("wrong size", std::vector<float>(psGrid->nCells(), 0.)),
+               std::runtime_error);
+
+  // not available on sparse grids
+  EXPECT_THROW(qCell->setVolumeVizEnabled(true), std::runtime_error);
+
+  // also with slice planes
+  polyscope::addSceneSlicePlane();
+  polyscope::show(3);
+  polyscope::removeLastSceneSlicePlane();
+
+  // blocks must be inside the grid
+  EXPECT_THROW(polyscope::registerSparseVolumeGrid("bad grid", {21, 21, 21}, glm::vec3{-3., -3., -3.},
+                                                   glm::vec3{3., 3., 3.}, {{3, 0, 0}}),
+               std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGridDataSource) {
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {40, 40, 40}, glm::vec3{-3., -3., -3.}, glm::vec3{3., 3., 3.});
+
+  // a sphere SDF over the node indices, read a box at a time
+  size_t nBoxReads = 0;
+  auto readSDF = [&](glm::uvec3 origin, glm::uvec3 extent, float* out) {
+    nBoxReads++;
+    for (uint32_t z = 0; z < extent.z; z++)
+      for (uint32_t y = 0; y < extent.y; y++)
+        for (uint32_t x = 0; x < extent.x; x++) {
+          glm::vec3 p = glm::vec3(origin + glm::uvec3{x, y, z}) * (6.f / 39.f) - 3.f;
+          *(out++) = glm::length(p) - 1.5f;
+        }
+  };
+  std::shared_ptr<polyscope::VolumeGridDataSource> source(new polyscope::CallbackVolumeGridDataSource(readSDF));
+  polyscope::VolumeGridNodeScalarQuantity* qNode =
+      psGrid->addNodeScalarQuantityFromSource("node sdf", source, {-1.5, 3.7});
+  EXPECT_TRUE(qNode->hasDataSource());
+  EXPECT_TRUE(psGrid->isBricked());
+  qNode->setEnabled(true);
+  polyscope::show(3);
+  EXPECT_GT(nBoxReads, 0u);
+
+  // a slice plane only needs some of the bricks, which are then cached
+  polyscope::SlicePlane* p = polyscope::addSceneSlicePlane();
+  p->setPose(glm::vec3{1.5, 0., 0.}, glm::vec3{1., 0., 0.});
+  qNode->setDataCacheBudget(1 << 30);
+  polyscope::show(3);
+  size_t nReadsBefore = nBoxReads;
+  p->setPose(glm::vec3{1.6, 0., 0.}, glm::vec3{1., 0., 0.});
+  polyscope::show(3);
+  EXPECT_EQ(nBoxReads, nReadsBefore);
+
+  // isosurfaces are extracted from the bricks the slice plane leaves
+  p->setPose(glm::vec3{0., 0., 0.}, glm::vec3{1., 0., 0.});
+  qNode->setIsosurfaceVizEnabled(true);
+  qNode->setIsosurfaceLevel(0.);
+  polyscope::show(3);
+  polyscope::SurfaceMesh* isoMesh = qNode->registerIsosurfaceAsMesh("iso");
+  EXPECT_GT(isoMesh->nVertices(), 0u);
+  for (size_t i = 0; i < isoMesh->nVertices(); i++) {
+    EXPECT_GT(isoMesh->vertexPositions.getValue(i).x, -1.f);
+  }
+
+  // a tiny budget still draws, just reading more
+  qNode->setDataCacheBudget(1);
+  polyscope::show(3);
+  polyscope::removeLastSceneSlicePlane();
+
+  // cell values from a raw file
+  std::string filename = "test_volume_cells.raw";
+  {
+    std::vector<uint16_t> cellValues(39 * 39 * 39);
+    for (size_t i = 0; i < cellValues.size(); i++) cellValues[i] = static_cast<uint16_t>(i % 1000);
+    std::ofstream out(filename, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(cellValues.data()), cellValues.size() * sizeof(uint16_t));
+  }
+  std::shared_ptr<polyscope::VolumeGridDataSource> rawSource(
+      new polyscope::RawFileVolumeGridDataSource(filename, {39, 39, 39}, polyscope::RawValueType::UInt16));
+  polyscope::VolumeGridCellScalarQuantity* qCell =
+      psGrid->addCellScalarQuantityFromSource("cell raw", rawSource, {0., 999.});
+  qCell->setEnabled(true);
+  polyscope::show(3);
+
+  // the file must hold the whole grid
+  EXPECT_THROW(polyscope::RawFileVolumeGridDataSource(filename, {40, 40, 40}, polyscope::RawValueType::UInt16),
+               std::runtime_error);
+
+  polyscope::removeAllStructures();
+  std::remove(filename.c_str());
+}
+
+TEST_F(PolyscopeTest, VolumeGridNativeTypes) {
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {20, 20, 20}, glm::vec3{-3., -3., -3.}, glm::vec3{3., 3., 3.});
+
+  // a uint8 mask on the cells
+  std::vector<uint8_t> mask(psGrid->nCells());
+  for (size_t i = 0; i < mask.size(); i++) mask[i] = (i % 7 == 0) ? 255 : 3;
+  polyscope::VolumeGridCellScalarQuantity* qMask = psGrid->addCellScalarQuantityNative("mask", mask);
+  EXPECT_TRUE(qMask->hasDataSource());
+  EXPECT_EQ(qMask->getDataRange().first, 3.);
+  EXPECT_EQ(qMask->getDataRange().second, 255.);
+  qMask->setEnabled(true);
+  polyscope::show(3);
+
+  // int16 values on the nodes, with an isosurface
+  std::vector<int16_t> ct(psGrid->nNodes());
+  for (size_t i = 0; i < ct.size(); i++) {
+    glm::uvec3 ind = psGrid->unflattenNodeIndex(i);
+    ct[i] = static_cast<int16_t>(static_cast<int>(ind.x) * 100 - 1000);
+  }
+  polyscope::VolumeGridNodeScalarQuantity* qCT = psGrid->addNodeScalarQuantityNative("ct", ct);
+  EXPECT_EQ(qCT->getDataRange().first, -1000.);
+  qCT->setEnabled(true);
+  qCT->setIsosurfaceVizEnabled(true);
+  qCT->setIsosurfaceLevel(0.);
+  polyscope::show(3);
+  EXPECT_GT(qCT->registerIsosurfaceAsMesh("iso")->nVertices(), 0u);
+
+  // half floats as raw bytes (0x3C00 is 1.0)
+  std::vector<uint16_t> halfBits(psGrid->nNodes(), 0x3C00);
+  std::vector<unsigned char> halfBytes(halfBits.size() * 2);
+  std::memcpy(halfBytes.data(), halfBits.data(), halfBytes.size());
+  polyscope::VolumeGridNodeScalarQuantity* qHalf =
+      psGrid->addNodeScalarQuantityNative("half", halfBytes, polyscope::RawValueType::Float16);
+  EXPECT_NEAR(qHalf->getDataRange().second, 1., 1e-4);
+  qHalf->setEnabled(true);
+  polyscope::show(3);
+
+  // sizes must match
+  EXPECT_THROW(psGrid->addNodeScalarQuantityNative("wrong", std::vector<uint16_t>(10)), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGridScalarView) {
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {20, 20, 20}, glm::vec3{-3., -3., -3.}, glm::vec3{3., 3., 3.});
+
+  // node values read in place through a data source, which holds the lifetime token
+  std::shared_ptr<std::vector<float>> nodeVals = std::make_shared<std::vector<float>>(psGrid->nNodes());
+  for (size_t i = 0; i < nodeVals->size(); i++) {
+    (*nodeVals)[i] = static_cast<float>(psGrid->unflattenNodeIndex(i).x) - 5.f;
+  }
+  polyscope::VolumeGridNodeScalarQuantity* qNode =
+      psGrid->addNodeScalarQuantityView("node view", nodeVals->data(), nodeVals->size(), nodeVals);
+  std::weak_ptr<std::vector<float>> nodeValsAlive = nodeVals;
+  nodeVals.reset();
+  EXPECT_FALSE(nodeValsAlive.expired());
+  EXPECT_TRUE(qNode->hasDataSource());
+  EXPECT_EQ(qNode->getDataRange().first, -5.);
+  EXPECT_EQ(qNode->getDataRange().second, 14.);
+  qNode->setEnabled(true);
+  qNode->setIsosurfaceVizEnabled(true);
+  qNode->setIsosurfaceLevel(0.5);
+  polyscope::show(3);
+  EXPECT_GT(qNode->registerIsosurfaceAsMesh("iso")->nVertices(), 0u);
+
+  std::vector<float> cellVals(psGrid->nCells(), 2.);
+  polyscope::VolumeGridCellScalarQuantity* qCell =
+      psGrid->addCellScalarQuantityView("cell view", cellVals.data(), cellVals.size());
+  qCell->setEnabled(true);
+  polyscope::show(3);
+
+  // sizes must match
+  EXPECT_THROW(psGrid->addCellScalarQuantityView("wrong", cellVals.data(), 10), std::runtime_error);
+
+  polyscope::removeAllStructures();
+  EXPECT_TRUE(nodeValsAlive.expired());
+}
+
+TEST_F(PolyscopeTest, VolumeGridBricked) {
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {40, 40, 40}, glm::vec3{-3., -3., -3.}, glm::vec3{3., 3., 3.});
+  EXPECT_FALSE(psGrid->isBricked());
+  psGrid->setBrickedStorage(true);
+  EXPECT_TRUE(psGrid->isBricked());
+  EXPECT_FALSE(psGrid->isSparse());
+
+  auto countResident = [&]() {
+    size_t n = 0;
+    for (int64_t b : psGrid->getResidentSlotBricks()) {
+      if (b >= 0) n++;
+    }
+    return n;
+  };
+
+  auto sphereSDF = [](glm::vec3 p) { return glm::length(p) - 1.5f; };
+  polyscope::VolumeGridNodeScalarQuantity* qNode = psGrid->addNodeScalarQuantityFromCallable("node sdf", sphereSDF);
+  qNode->setEnabled(true);
+  polyscope::show(3);
+  EXPECT_EQ(countResident(), 5u * 5 * 5); // everything is visible
+
+  // only the bricks the slice plane leaves are resident
+  polyscope::SlicePlane* p = polyscope::addSceneSlicePlane();
+  p->setPose(glm::vec3{1.5, 0., 0.}, glm::vec3{1., 0., 0.});
+  polyscope::show(3);
+  size_t nSliced = countResident();
+  EXPECT_GT(nSliced, 0u);
+  EXPECT_LT(nSliced, 5u * 5 * 5);
+
+  // bricks are paged back in as the plane moves
+  uint64_t version = psGrid->getBrickResidencyVersion();
+  p->setPose(glm::vec3{-1.5, 0., 0.}, glm::vec3{1., 0., 0.});
+  polyscope::show(3);
+  EXPECT_GT(psGrid->getBrickResidencyVersion(), version);
+  EXPECT_GT(countResident(), nSliced);
+
+  polyscope::VolumeGridCellScalarQuantity* qCell = psGrid->addCellScalarQuantityFromCallable("cell sdf", sphereSDF);
+  qCell->setEnabled(true);
+  polyscope::show(3);
+  p->setPose(glm::vec3{0., 0., 0.}, glm::vec3{0., -1., 0.});
+  polyscope::show(3);
+
+  // not available on bricked grids
+  EXPECT_THROW(qCell->setVolumeVizEnabled(true), std::runtime_error);
+
+  polyscope::removeLastSceneSlicePlane();
+  psGrid->setBrickedStorage(false);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
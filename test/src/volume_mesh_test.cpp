@@ -2,6 +2,8 @@
 
 #include "polyscope_test.h"
 
+#include "polyscope/derived_data_cache.h"
+
 // ============================================================
 // =============== Volume mesh tests
 // ============================================================
@@ -63,6 +65,97 @@ TEST_F(PolyscopeTest, ShowVolumeMesh) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, VolumeMeshInteriorFaces) {
+  // clang-format off
+  std::vector<glm::vec3> verts = {
+    {0, 0, 0},
+    {1, 0, 0},
+    {0, 1, 0},
+    {0, 0, 1},
+    {1, 1, 1},
+    {0, 0, 2},
+  };
+  // consecutive tets share a face, {1,2,3} and then {2,3,4}
+  std::vector<std::array<size_t, 4>> cells = {
+    {0, 1, 2, 3},
+    {1, 2, 3, 4},
+    {2, 3, 4, 5},
+  };
+  // clang-format on
+  polyscope::VolumeMesh* psVol = polyscope::registerTetMesh("vol", verts, cells);
+
+  ASSERT_EQ(psVol->nFaces(), 12);
+  size_t nInterior = 0;
+  for (size_t iF = 0; iF < psVol->nFaces(); iF++) {
+    if (psVol->faceIsInterior[iF]) nInterior++;
+  }
+  EXPECT_EQ(nInterior, 4);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeMeshExteriorOnly) {
+  std::vector<glm::vec3> verts = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 1, 1}, {0, 0, 2}};
+  std::vector<std::array<size_t, 4>> cells = {{0, 1, 2, 3}, {1, 2, 3, 4}, {2, 3, 4, 5}};
+  polyscope::VolumeMesh* psVol = polyscope::registerTetMesh("vol", verts, cells);
+  EXPECT_EQ(psVol->triangleVertexInds.size(), 3 * 12);
+
+  std::vector<float> vals(verts.size(), 0.5);
+  auto q1 = psVol->addVertexScalarQuantity("vals", vals);
+  q1->setEnabled(true);
+
+  // only the 8 exterior faces are built
+  psVol->setExteriorOnly(true);
+  EXPECT_TRUE(psVol->getExteriorOnly());
+  EXPECT_EQ(psVol->triangleVertexInds.size(), 3 * 8);
+  polyscope::show(3);
+
+  // a slice plane might expose the interior
+  polyscope::addSceneSlicePlane();
+  polyscope::show(3);
+  EXPECT_EQ(psVol->triangleVertexInds.size(), 3 * 12);
+
+  psVol->setIgnoreSlicePlane(polyscope::state::slicePlanes[0]->name, true);
+  polyscope::show(3);
+  EXPECT_EQ(psVol->triangleVertexInds.size(), 3 * 8);
+
+  polyscope::removeLastSceneSlicePlane();
+  psVol->setExteriorOnly(false);
+  EXPECT_EQ(psVol->triangleVertexInds.size(), 3 * 12);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeMeshDerivedDataCache) {
+  std::vector<glm::vec3> verts;
+  std::vector<std::array<int, 8>> cells;
+  std::tie(verts, cells) = getVolumeMeshData();
+
+  // the first mesh derives the data and stores it, the second loads it
+  polyscope::options::derivedDataCacheDirectory = ::testing::TempDir();
+  polyscope::VolumeMesh* psDerived = polyscope::registerVolumeMesh("vol derived", verts, cells);
+  psDerived->ensureHaveTets();
+  polyscope::VolumeMesh* psLoaded = polyscope::registerVolumeMesh("vol loaded", verts, cells);
+  psLoaded->ensureHaveTets();
+  polyscope::options::derivedDataCacheDirectory = "";
+  polyscope::VolumeMesh* psUncached = polyscope::registerVolumeMesh("vol uncached", verts, cells);
+  psUncached->ensureHaveTets();
+
+  EXPECT_EQ(psLoaded->faceIsInterior, psUncached->faceIsInterior);
+  EXPECT_EQ(psDerived->faceIsInterior, psUncached->faceIsInterior);
+  EXPECT_EQ(psLoaded->tets, psUncached->tets);
+  polyscope::show(3);
+
+  // different inputs hash differently
+  std::vector<glm::vec3> moved = verts;
+  moved[0].x += 1.;
+  EXPECT_NE(polyscope::ContentHash().add(verts).get(), polyscope::ContentHash().add(moved).get());
+  EXPECT_EQ(polyscope::ContentHash().add(verts).get(), polyscope::ContentHash().add(verts).get());
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, VolumeMeshUpdatePositions) {
   std::vector<glm::vec3> verts;
   std::vector<std::array<int, 8>> cells;
@@ -169,6 +262,63 @@ TEST_F(PolyscopeTest, VolumeMeshScalarVertex) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, VolumeMeshLevelSetExtraction) {
+  std::vector<glm::vec3> verts = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+  std::vector<std::array<uint32_t, 4>> tets = {{0, 1, 2, 3}};
+
+  // one vertex above the level cuts a triangle, facing it
+  std::vector<float> height = {0., 0., 0., 1.};
+  polyscope::VolumeMeshVertexScalarQuantity::LevelSetMesh tri =
+      polyscope::VolumeMeshVertexScalarQuantity::extractLevelSet(verts, tets, height, height, 0.5);
+  ASSERT_EQ(tri.vertices.size(), 3u);
+  ASSERT_EQ(tri.indices.size(), 3u);
+  for (size_t i = 0; i < 3; i++) {
+    EXPECT_NEAR(tri.vertices[i].z, 0.5, 1e-5);
+    EXPECT_NEAR(tri.values[i], 0.5, 1e-5);
+  }
+  glm::vec3 normal = glm::cross(tri.vertices[tri.indices[1]] - tri.vertices[tri.indices[0]],
+                                tri.vertices[tri.indices[2]] - tri.vertices[tri.indices[0]]);
+  EXPECT_GT(normal.z, 0.);
+
+  // two vertices above cut a quad
+  std::vector<float> vals = {0., 1., 0., 1.};
+  polyscope::VolumeMeshVertexScalarQuantity::LevelSetMesh quad =
+      polyscope::VolumeMeshVertexScalarQuantity::extractLevelSet(verts, tets, vals, height, 0.5);
+  EXPECT_EQ(quad.vertices.size(), 4u);
+  EXPECT_EQ(quad.indices.size(), 6u);
+
+  // nothing outside the range
+  EXPECT_TRUE(polyscope::VolumeMeshVertexScalarQuantity::extractLevelSet(verts, tets, vals, vals, 2.).indices.empty());
+}
+
+TEST_F(PolyscopeTest, VolumeMeshScalarVertexLevelSetCached) {
+  std::vector<glm::vec3> verts;
+  std::vector<std::array<int, 8>> cells;
+  std::tie(verts, cells) = getVolumeMeshData();
+  polyscope::VolumeMesh* psVol = polyscope::registerVolumeMesh("vol", verts, cells);
+
+  std::vector<float> vals(verts.size());
+  for (size_t i = 0; i < verts.size(); i++) vals[i] = verts[i].x;
+  auto q1 = psVol->addVertexScalarQuantity("vals", vals);
+  psVol->addVertexScalarQuantity("vals2", vals);
+  q1->setEnabled(true);
+  q1->setEnabledLevelSet(true);
+  q1->setLevelSetValue(0.5 * (q1->getDataRange().first + q1->getDataRange().second));
+  q1->setLevelSetCached(true);
+  EXPECT_TRUE(q1->getLevelSetCached());
+  polyscope::show(3);
+
+  // extracted again for a new level, or a different shown quantity
+  q1->setLevelSetValue(q1->getDataRange().first + 0.25 * (q1->getDataRange().second - q1->getDataRange().first));
+  polyscope::show(3);
+  q1->setLevelSetVisibleQuantity("vals2");
+  polyscope::show(3);
+
+  q1->setLevelSetCached(false);
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, VolumeMeshScalarCell) {
   std::vector<glm::vec3> verts;
   std::vector<std::array<int, 8>> cells;
@@ -224,6 +374,12 @@ TEST_F(PolyscopeTest, VolumeMeshInspect) {
   auto q1 = psVol->addVertexScalarQuantity("vals", vals);
   q1->setEnabled(true);
   polyscope::show(3);
+
+  // moving the plane re-queries the tets it cuts, including when it cuts none of them
+  p->setPose(glm::vec3{0.2, 0.1, 0.3}, glm::vec3{1., 1., 0.});
+  polyscope::show(3);
+  p->setPose(glm::vec3{1000., 0., 0.}, glm::vec3{1., 0., 0.});
+  polyscope::show(3);
   polyscope::removeAllStructures();
 
   polyscope::removeLastSceneSlicePlane();